@@ -0,0 +1,465 @@
+/*
+ * AbrController.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "AbrController.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace mcnl;
+using namespace dash::mpd;
+
+ThroughputEstimator::ThroughputEstimator    () :
+                     fast                   (0),
+                     slow                   (0),
+                     fastWeight             (0),
+                     slowWeight             (0),
+                     samples                (0)
+{
+}
+void    ThroughputEstimator::AddSample      (double throughput, double seconds)
+{
+    if (throughput <= 0)
+        return;
+
+    if (seconds <= 0)
+        seconds = 1e-3;
+
+    double fastAlpha = pow(0.5, seconds / ABR_FAST_HALF_LIFE);
+    double slowAlpha = pow(0.5, seconds / ABR_SLOW_HALF_LIFE);
+
+    this->fast       = fastAlpha * this->fast + (1 - fastAlpha) * throughput;
+    this->slow       = slowAlpha * this->slow + (1 - slowAlpha) * throughput;
+    this->fastWeight = fastAlpha * this->fastWeight + (1 - fastAlpha);
+    this->slowWeight = slowAlpha * this->slowWeight + (1 - slowAlpha);
+
+    this->recent.push_back(throughput);
+    if (this->recent.size() > ABR_HARMONIC_SAMPLES)
+        this->recent.pop_front();
+
+    this->samples++;
+}
+double  ThroughputEstimator::Ewma           () const
+{
+    if (this->samples == 0)
+        return 0;
+
+    return std::min(this->fast / this->fastWeight, this->slow / this->slowWeight);
+}
+double  ThroughputEstimator::HarmonicMean   () const
+{
+    if (this->recent.empty())
+        return 0;
+
+    double sum = 0;
+    for (size_t i = 0; i < this->recent.size(); i++)
+        sum += 1.0 / this->recent.at(i);
+
+    return this->recent.size() / sum;
+}
+double  ThroughputEstimator::Estimate       () const
+{
+    return std::min(this->Ewma(), this->HarmonicMean());
+}
+size_t  ThroughputEstimator::Samples        () const
+{
+    return this->samples;
+}
+
+DecodeCostModel::DecodeCostModel            () :
+                 secondsPerPoint            (0)
+{
+}
+void    DecodeCostModel::AddSample          (size_t representation, double seconds, uint64_t points)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (points > 0)
+        this->secondsPerPoint = this->secondsPerPoint == 0 ? seconds / points :
+                                ABR_DECODE_ALPHA * seconds / points + (1 - ABR_DECODE_ALPHA) * this->secondsPerPoint;
+
+    std::map<size_t, double>::iterator it = this->seconds.find(representation);
+
+    if (it == this->seconds.end())
+        this->seconds[representation] = seconds;
+    else
+        it->second = ABR_DECODE_ALPHA * seconds + (1 - ABR_DECODE_ALPHA) * it->second;
+}
+bool    DecodeCostModel::Estimate           (size_t representation, double &seconds) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::map<size_t, double>::const_iterator it = this->seconds.find(representation);
+
+    if (it != this->seconds.end())
+    {
+        seconds = it->second;
+        return true;
+    }
+
+    std::map<size_t, uint64_t>::const_iterator next = this->next.find(representation);
+
+    if (next == this->next.end() || next->second == 0 || this->secondsPerPoint == 0)
+        return false;
+
+    seconds = this->secondsPerPoint * next->second;
+    return true;
+}
+void    DecodeCostModel::SetNext            (size_t representation, uint64_t points)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->next[representation] = points;
+}
+bool    DecodeCostModel::Predict            (uint64_t points, double &seconds) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (points == 0 || this->secondsPerPoint == 0)
+        return false;
+
+    seconds = this->secondsPerPoint * points;
+    return true;
+}
+
+size_t  ThroughputPolicy::Select            (const AbrContext &context)
+{
+    double budget = context.available * ABR_SAFETY_FACTOR;
+    size_t choice = 0;
+
+    for (size_t i = 0; i < context.bitrates->size(); i++)
+        if (context.bitrates->at(i) <= budget)
+            choice = i;
+
+    return choice;
+}
+
+size_t  BolaPolicy::Select                  (const AbrContext &context)
+{
+    const std::vector<uint32_t> &bitrates = *context.bitrates;
+
+    if (bitrates.size() < 2 || bitrates.at(0) == 0)
+        return 0;
+
+    /* BOLA-BASIC with the dash.js parameterisation: utilities ln(b/b0)+1,
+     * gp and Vp chosen so the lowest quality wins below minBuffer and the
+     * highest above bufferTime */
+    double minBuffer  = std::max(2 * context.segmentDuration, context.bufferTarget / 4);
+    double bufferTime = std::max(context.bufferTarget, minBuffer + context.segmentDuration);
+    double maxUtility = log((double) bitrates.back() / bitrates.at(0)) + 1;
+    double gp         = (maxUtility - 1) / (bufferTime / minBuffer - 1);
+    double Vp         = minBuffer / gp;
+
+    size_t choice = 0;
+    double best   = 0;
+
+    for (size_t i = 0; i < bitrates.size(); i++)
+    {
+        double utility = log((double) bitrates.at(i) / bitrates.at(0)) + 1;
+        double score   = (Vp * (utility + gp) - context.bufferLevel) / bitrates.at(i);
+
+        if (i == 0 || score >= best)
+        {
+            best   = score;
+            choice = i;
+        }
+    }
+
+    return choice;
+}
+
+HybridPolicy::HybridPolicy                  () :
+              useBola                       (false)
+{
+}
+size_t  HybridPolicy::Select                (const AbrContext &context)
+{
+    /* hysteresis so the two rules do not take turns every segment */
+    if (!this->useBola && context.bufferLevel >= context.bufferTarget / 2)
+        this->useBola = true;
+    else if (this->useBola && context.bufferLevel < context.bufferTarget / 4)
+        this->useBola = false;
+
+    if (this->useBola)
+        return this->bola.Select(context);
+
+    return this->throughput.Select(context);
+}
+
+AbrPolicy*      mcnl::CreateAbrPolicy       (AbrPolicyType type)
+{
+    switch (type)
+    {
+        case ABR_THROUGHPUT:    return new ThroughputPolicy();
+        case ABR_BOLA:          return new BolaPolicy();
+        case ABR_HYBRID:
+        default:                return new HybridPolicy();
+    }
+}
+AbrPolicyType   mcnl::ParseAbrPolicy        (const std::string &name)
+{
+    if (name == "throughput")
+        return ABR_THROUGHPUT;
+    if (name == "bola")
+        return ABR_BOLA;
+
+    return ABR_HYBRID;
+}
+
+static std::vector<uint32_t>    Bandwidths  (const IAdaptationSet *adaptationSet)
+{
+    std::vector<uint32_t> bandwidths;
+
+    if (adaptationSet != NULL)
+        for (size_t i = 0; i < adaptationSet->GetRepresentation().size(); i++)
+            bandwidths.push_back(adaptationSet->GetRepresentation().at(i)->GetBandwidth());
+
+    return bandwidths;
+}
+
+AbrController::AbrController                (const IAdaptationSet *adaptationSet, AbrPolicyType type, double bufferTarget) :
+               AbrController                (Bandwidths(adaptationSet), type, bufferTarget)
+{
+}
+AbrController::AbrController                (const std::vector<uint32_t> &bandwidths, AbrPolicyType type, double bufferTarget) :
+               policy                       (CreateAbrPolicy(type)),
+               decodeCost                   (NULL),
+               bufferTarget                 (bufferTarget),
+               bandwidth                    (0),
+               startupBuffer                (0),
+               started                      (false),
+               last                         (0)
+{
+    std::vector<std::pair<uint32_t, size_t> > reps;
+
+    for (size_t i = 0; i < bandwidths.size(); i++)
+        reps.push_back(std::make_pair(bandwidths.at(i), i));
+
+    std::sort(reps.begin(), reps.end());
+
+    for (size_t i = 0; i < reps.size(); i++)
+    {
+        this->bitrates.push_back(reps.at(i).first);
+        this->order.push_back(reps.at(i).second);
+    }
+    this->frameRates.assign(this->bitrates.size(), 0);
+    this->Rebuild();
+}
+AbrController::~AbrController               ()
+{
+}
+void                        AbrController::OnDownload   (const SegmentInfo &info)
+{
+    double rate = info.throughput;
+
+    if (info.seconds < ABR_SLOW_START_SECONDS && info.deliveryRate > rate)
+        rate = info.deliveryRate;
+    this->throughput.AddSample(rate, info.seconds);
+}
+size_t                      AbrController::Select       (double bufferLevel, double segmentDuration)
+{
+    if (this->ladder.empty())
+        return 0;
+
+    AbrContext context;
+
+    context.bitrates        = &this->ladder;
+    context.throughput      = &this->throughput;
+    context.available       = this->Available();
+    context.bufferLevel     = bufferLevel;
+    context.bufferTarget    = this->bufferTarget;
+    context.segmentDuration = segmentDuration;
+    context.last            = this->last;
+
+    if (this->startupBuffer > 0 ? bufferLevel >= this->startupBuffer : bufferLevel > 0)
+        this->started = true;
+
+    /* nothing measured yet, or still filling the buffer: start low */
+    if (!this->started && (this->startupBuffer > 0 || this->throughput.Samples() == 0))
+        this->last = 0;
+    else
+        this->last = std::min(this->policy->Select(context), this->ladder.size() - 1);
+
+    size_t choice = this->rungs.at(this->last);
+
+    if (!this->Sustainable(choice, segmentDuration))
+        choice = this->Fallback(choice, segmentDuration);
+
+    /* the policy goes on from the full frame rate at or below what was chosen */
+    while (this->last > 0 && this->rungs.at(this->last) > choice)
+        this->last--;
+
+    return this->order.at(choice);
+}
+size_t                      AbrController::Lowest       () const
+{
+    return this->rungs.empty() ? 0 : this->order.at(this->rungs.at(0));
+}
+bool                        AbrController::Exclude      (size_t representation)
+{
+    for (size_t i = 0; i < this->order.size(); i++)
+    {
+        if (this->order.at(i) != representation)
+            continue;
+
+        this->bitrates.erase(this->bitrates.begin() + i);
+        this->order.erase(this->order.begin() + i);
+        this->frameRates.erase(this->frameRates.begin() + i);
+        this->Rebuild();
+        this->last = 0;
+        break;
+    }
+
+    return !this->order.empty();
+}
+void                        AbrController::SetDecodeCost    (const DecodeCostModel *decodeCost)
+{
+    this->decodeCost = decodeCost;
+}
+void                        AbrController::SetFrameRates    (const std::vector<double> &frameRates)
+{
+    double full = 0;
+
+    for (size_t i = 0; i < frameRates.size(); i++)
+        full = std::max(full, frameRates.at(i));
+
+    for (size_t i = 0; i < this->order.size(); i++)
+    {
+        double frameRate = this->order.at(i) < frameRates.size() ? frameRates.at(this->order.at(i)) : 0;
+
+        this->frameRates.at(i) = frameRate > 0 ? frameRate : full;
+    }
+    this->Rebuild();
+    this->last = 0;
+}
+void                        AbrController::SetBandwidth     (double bandwidth)
+{
+    this->bandwidth = bandwidth;
+}
+size_t                      AbrController::Abandon      (size_t representation, const DownloadProgress &progress,
+                                                         double bufferLevel, double segmentDuration)
+{
+    double  seconds  = progress.Seconds();
+    int64_t length   = progress.Length();
+    size_t  index    = this->order.size();
+
+    for (size_t i = 0; i < this->order.size(); i++)
+        if (this->order.at(i) == representation)
+            index = i;
+
+    /* nothing lower, or too early to tell */
+    if (index == 0 || index == this->order.size() || seconds < ABR_ABANDON_MIN_SECONDS)
+        return representation;
+
+    double received  = (double) progress.Received();
+    double rate      = progress.DeliveryRate() > 0 ? progress.DeliveryRate() : received * 8 / seconds;
+    double bits      = length > 0 ? (length - received) * 8 : this->bitrates.at(index) * segmentDuration - received * 8;
+    double remaining = rate > 0 ? bits / rate : HUGE_VAL;
+
+    if (remaining <= bufferLevel)
+        return representation;
+
+    /* the highest lower one that makes it in time at the same rate; if
+     * none does, the one done soonest, the lowest */
+    size_t replacement = 0;
+
+    for (size_t i = index; i-- > 1;)
+    {
+        if (rate > 0 && this->bitrates.at(i) * segmentDuration / rate <= bufferLevel)
+        {
+            replacement = i;
+            break;
+        }
+    }
+    if (rate > 0 && this->bitrates.at(replacement) * segmentDuration / rate >= remaining)
+        return representation;
+
+    /* what this download saw is the best estimate there is now */
+    this->throughput.AddSample(rate, seconds);
+    while (this->last > 0 && this->rungs.at(this->last) > replacement)
+        this->last--;
+
+    return this->order.at(replacement);
+}
+void                        AbrController::SetStartupBuffer (double seconds)
+{
+    this->startupBuffer = seconds;
+}
+bool                        AbrController::Sustainable      (size_t index, double segmentDuration) const
+{
+    /* download and decode overlap (prefetching), so each stage on its own
+     * has to keep up with playback */
+    double estimate = this->Available();
+
+    if (estimate > 0 && this->bitrates.at(index) * segmentDuration / estimate > segmentDuration)
+        return false;
+
+    double decodeTime = 0;
+
+    if (this->decodeCost != NULL && this->decodeCost->Estimate(this->order.at(index), decodeTime))
+        return decodeTime <= segmentDuration;
+
+    /* never decoded: allow it once so it gets measured, unless a lower
+     * quality is already too slow to decode */
+    for (size_t i = index; i-- > 0;)
+        if (this->decodeCost != NULL && this->decodeCost->Estimate(this->order.at(i), decodeTime))
+            return decodeTime <= segmentDuration;
+
+    return true;
+}
+double                      AbrController::Available        () const
+{
+    return this->bandwidth > 0 ? this->bandwidth : this->throughput.Estimate();
+}
+size_t                      AbrController::Fallback         (size_t index, double segmentDuration) const
+{
+    size_t best     = 0;
+    double bestBits = -1;
+
+    /* bits per frame stand for the geometry quality; of equal ones the
+     * higher frame rate wins, and of equal frame rates the higher bitrate */
+    for (size_t i = 0; i < index; i++)
+    {
+        if (!this->Sustainable(i, segmentDuration))
+            continue;
+
+        double bits = this->bitrates.at(i) / (this->frameRates.at(i) > 0 ? this->frameRates.at(i) : 1.0);
+
+        if (bits > bestBits || (bits == bestBits && this->frameRates.at(i) >= this->frameRates.at(best)))
+        {
+            best     = i;
+            bestBits = bits;
+        }
+    }
+
+    return best;
+}
+void                        AbrController::Rebuild          ()
+{
+    double full = 0;
+
+    for (size_t i = 0; i < this->frameRates.size(); i++)
+        full = std::max(full, this->frameRates.at(i));
+
+    this->ladder.clear();
+    this->rungs.clear();
+    for (size_t i = 0; i < this->bitrates.size(); i++)
+    {
+        if (this->frameRates.at(i) < full)
+            continue;
+
+        this->ladder.push_back(this->bitrates.at(i));
+        this->rungs.push_back(i);
+    }
+}
+const ThroughputEstimator&  AbrController::Throughput   () const
+{
+    return this->throughput;
+}
+const AbrPolicy&            AbrController::Policy       () const
+{
+    return *this->policy;
+}
@@ -0,0 +1,221 @@
+/*
+ * AbrController.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Representation selection. Throughput is smoothed (EWMA and harmonic mean
+ * over recent downloads) instead of trusting a single sample, and the
+ * policy is pluggable: throughput-based, buffer-based (BOLA) or a hybrid
+ * that uses throughput while the buffer is low and BOLA once it has filled.
+ * The policy's choice is then capped to what the network can download and
+ * the V-PCC decoder can decode within one segment duration.
+ *
+ * With representations at several frame rates (a ladder of qualities at 30,
+ * 15 and 10 fps, say), the policy chooses among those at the full frame
+ * rate. Only if its choice cannot be sustained does a lower frame rate come
+ * in: the cap then takes the sustainable representation of the most bits
+ * per frame, so a client short of decode time plays the same geometry
+ * quality at half the frame rate, which takes about half the decode time,
+ * before a coarser one at the full rate.
+ *****************************************************************************/
+
+#ifndef ABRCONTROLLER_H_
+#define ABRCONTROLLER_H_
+
+#include "IAdaptationSet.h"
+#include "SegmentFetcher.h"
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#define ABR_SAFETY_FACTOR       0.9     /* use 90% of the estimated throughput */
+#define ABR_HARMONIC_SAMPLES    5
+#define ABR_FAST_HALF_LIFE      3.0     /* seconds of download time */
+#define ABR_SLOW_HALF_LIFE      8.0
+#define ABR_DECODE_ALPHA        0.3     /* EWMA weight of the newest decode time */
+#define ABR_ABANDON_MIN_SECONDS 0.5     /* a download is given this long before its rate counts */
+#define ABR_SLOW_START_SECONDS  1.0     /* shorter downloads are sampled at TCP's delivery rate, see OnDownload */
+
+namespace mcnl
+{
+    enum AbrPolicyType
+    {
+        ABR_THROUGHPUT,
+        ABR_BOLA,
+        ABR_HYBRID
+    };
+
+    class ThroughputEstimator
+    {
+        public:
+            ThroughputEstimator             ();
+
+            void    AddSample               (double throughput, double seconds);
+
+            double  Ewma                    () const;   /* min of fast and slow EWMA */
+            double  HarmonicMean            () const;
+            double  Estimate                () const;   /* conservative: min of both */
+            size_t  Samples                 () const;
+
+        private:
+            double              fast;
+            double              slow;
+            double              fastWeight; /* for zero-bias correction */
+            double              slowWeight;
+            size_t              samples;
+            std::deque<double>  recent;
+    };
+
+    /* Measured wall time of the decode stage per representation. Written by
+     * the decoder thread, read by the fetch thread. When the MPD tells the
+     * points a segment decodes to (SegmentComplexity), a representation that
+     * has not been decoded yet is predicted from the points of its next
+     * segment at the time per point measured on the others. */
+    class DecodeCostModel
+    {
+        public:
+            DecodeCostModel             ();
+
+            /* points of the segment decoded, 0 if unknown */
+            void    AddSample           (size_t representation, double seconds, uint64_t points = 0);
+            /* points of the next segment of representation, from the MPD */
+            void    SetNext             (size_t representation, uint64_t points);
+            /* false if this representation has not been decoded yet and cannot be predicted */
+            bool    Estimate            (size_t representation, double &seconds) const;
+            /* seconds to decode a segment of `points` points; false before a
+             * sample with points, or if points is 0 */
+            bool    Predict             (uint64_t points, double &seconds) const;
+
+        private:
+            mutable std::mutex          mutex;
+            std::map<size_t, double>    seconds;
+            std::map<size_t, uint64_t>  next;
+            double                      secondsPerPoint;    /* 0 until a sample with points */
+    };
+
+    /* what a policy gets to look at; representations are sorted by bandwidth, lowest first */
+    struct AbrContext
+    {
+        const std::vector<uint32_t>     *bitrates;
+        const ThroughputEstimator       *throughput;
+        double                          available;          /* bps this stream may use, see SetBandwidth */
+        double                          bufferLevel;        /* seconds */
+        double                          bufferTarget;       /* seconds */
+        double                          segmentDuration;    /* seconds */
+        size_t                          last;               /* last choice, index into bitrates */
+    };
+
+    class AbrPolicy
+    {
+        public:
+            virtual ~AbrPolicy      () {}
+
+            /* index into context.bitrates */
+            virtual size_t  Select  (const AbrContext &context) = 0;
+            virtual const char* Name() const = 0;
+    };
+
+    class ThroughputPolicy : public AbrPolicy
+    {
+        public:
+            virtual size_t      Select  (const AbrContext &context);
+            virtual const char* Name    () const { return "throughput"; }
+    };
+
+    class BolaPolicy : public AbrPolicy
+    {
+        public:
+            virtual size_t      Select  (const AbrContext &context);
+            virtual const char* Name    () const { return "bola"; }
+    };
+
+    class HybridPolicy : public AbrPolicy
+    {
+        public:
+            HybridPolicy                ();
+
+            virtual size_t      Select  (const AbrContext &context);
+            virtual const char* Name    () const { return "hybrid"; }
+
+        private:
+            ThroughputPolicy    throughput;
+            BolaPolicy          bola;
+            bool                useBola;
+    };
+
+    AbrPolicy*      CreateAbrPolicy     (AbrPolicyType type);
+    AbrPolicyType   ParseAbrPolicy      (const std::string &name);
+
+    class AbrController
+    {
+        public:
+            AbrController           (const dash::mpd::IAdaptationSet *adaptationSet, AbrPolicyType type, double bufferTarget);
+            /* bandwidths[i] is representation i, e.g. from a cached SegmentIndex */
+            AbrController           (const std::vector<uint32_t> &bandwidths, AbrPolicyType type, double bufferTarget);
+            virtual ~AbrController  ();
+
+            /* a download shorter than ABR_SLOW_START_SECONDS spent much of its time in the
+             * request's round trip and slow start: its average understates the link, so the
+             * delivery rate TCP measured by its end counts if higher */
+            void        OnDownload          (const SegmentInfo &info);
+            /* representation index as listed in the adaptation set */
+            size_t      Select              (double bufferLevel, double segmentDuration);
+            size_t      Lowest              () const;
+            /* never selects representation, e.g. one the decoder cannot decode;
+             * false once no representation is left */
+            bool        Exclude             (size_t representation);
+
+            /* optional: also require the choice to decode within a segment duration */
+            void        SetDecodeCost       (const DecodeCostModel *decodeCost);
+            /* frameRates[i] is that of representation i, 0 if unknown (taken
+             * as the full frame rate); see above */
+            void        SetFrameRates       (const std::vector<double> &frameRates);
+            /* bps this stream may use when several share the link, in place of
+             * its own throughput estimate; 0 = the estimate */
+            void        SetBandwidth        (double bandwidth);
+            /* for a download under way at representation: the representation
+             * to fetch the segment at instead, or representation to go on.
+             * It is abandoned when, at its own rate so far, it would not
+             * finish before the bufferLevel seconds buffered have played
+             * and a lower representation would; see SegmentPrefetcher. Its
+             * rate is TCP's current delivery rate where the progress has one */
+            size_t      Abandon             (size_t representation, const DownloadProgress &progress,
+                                             double bufferLevel, double segmentDuration);
+            /* fast start: the lowest representation until the buffer has
+             * reached this many seconds once, so that playback starts on the
+             * smallest segments; 0 = only until the first download */
+            void        SetStartupBuffer    (double seconds);
+
+            const ThroughputEstimator&  Throughput  () const;
+            const AbrPolicy&            Policy      () const;
+
+        private:
+            bool        Sustainable         (size_t index, double segmentDuration) const;
+            double      Available           () const;
+            /* the sustainable index below index of the most bits per frame, 0 if none */
+            size_t      Fallback            (size_t index, double segmentDuration) const;
+            /* ladder and rungs from bitrates and frameRates */
+            void        Rebuild             ();
+
+            std::unique_ptr<AbrPolicy>  policy;
+            const DecodeCostModel       *decodeCost;
+            ThroughputEstimator         throughput;
+            std::vector<uint32_t>       bitrates;   /* sorted, lowest first */
+            std::vector<size_t>         order;      /* bitrates[i] is representation order[i] */
+            std::vector<double>         frameRates; /* of bitrates[i], the full frame rate for unknown ones */
+            std::vector<uint32_t>       ladder;     /* the bitrates at the full frame rate, what the policy sees */
+            std::vector<size_t>         rungs;      /* ladder[i] is bitrates[rungs[i]] */
+            double                      bufferTarget;
+            double                      bandwidth;
+            double                      startupBuffer;
+            bool                        started;    /* the buffer has reached startupBuffer */
+            size_t                      last;       /* index into ladder */
+    };
+}
+
+#endif /* ABRCONTROLLER_H_ */
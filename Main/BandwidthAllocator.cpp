@@ -0,0 +1,107 @@
+/*
+ * BandwidthAllocator.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "BandwidthAllocator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace mcnl;
+
+BandwidthAllocator::BandwidthAllocator  (size_t objects) :
+                    tanHalfFov          (0),
+                    viewportHeight      (0),
+                    hasView             (false)
+{
+    Object object = {{0, 0, 0}, -1, 0};
+
+    this->objects.assign(objects, object);
+    this->eye[0] = this->eye[1] = this->eye[2] = 0;
+}
+BandwidthAllocator::~BandwidthAllocator ()
+{
+}
+
+void    BandwidthAllocator::SetView         (const float eye[3], double fieldOfView, double viewportHeight)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::copy(eye, eye + 3, this->eye);
+    this->tanHalfFov     = std::tan(fieldOfView * M_PI / 360);
+    this->viewportHeight = viewportHeight;
+    this->hasView        = this->tanHalfFov > 0 && viewportHeight > 0;
+}
+void    BandwidthAllocator::SetBounds       (size_t object, const double center[3], double radius)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::copy(center, center + 3, this->objects.at(object).center);
+    this->objects.at(object).radius = radius;
+}
+void    BandwidthAllocator::SetThroughput   (size_t object, double throughput)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->objects.at(object).throughput = throughput;
+}
+double  BandwidthAllocator::Share           (size_t object) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::vector<double> importance;
+    double              largest = 0;
+
+    for (size_t i = 0; i < this->objects.size(); i++)
+    {
+        importance.push_back(this->Importance(this->objects.at(i)));
+        largest = std::max(largest, importance.back());
+    }
+
+    /* no view or no bounds yet */
+    if (largest <= 0)
+        return 1.0 / this->objects.size();
+
+    double sum = 0;
+
+    for (size_t i = 0; i < importance.size(); i++)
+    {
+        importance.at(i) = std::max(importance.at(i), largest * BANDWIDTH_MIN_IMPORTANCE);
+        sum             += importance.at(i);
+    }
+    return importance.at(object) / sum;
+}
+double  BandwidthAllocator::Bandwidth       (size_t object) const
+{
+    double link = 0;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        for (size_t i = 0; i < this->objects.size(); i++)
+        {
+            if (this->objects.at(i).throughput <= 0)
+                return 0;
+            link += this->objects.at(i).throughput;
+        }
+    }
+    return link * this->Share(object);
+}
+double  BandwidthAllocator::Importance      (const Object &object) const
+{
+    if (!this->hasView || object.radius < 0)
+        return 0;
+
+    double dx       = object.center[0] - this->eye[0];
+    double dy       = object.center[1] - this->eye[1];
+    double dz       = object.center[2] - this->eye[2];
+    double distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+    /* projected radius in pixels, the whole viewport once the camera is inside */
+    double pixels = distance > object.radius ?
+                    object.radius / (distance * this->tanHalfFov) * this->viewportHeight / 2 : this->viewportHeight;
+
+    pixels = std::min(pixels, this->viewportHeight);
+    return M_PI * pixels * pixels;
+}
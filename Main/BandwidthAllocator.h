@@ -0,0 +1,67 @@
+/*
+ * BandwidthAllocator.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Splits the link between the objects of a scene by how much of the screen
+ * each one covers. Every object still measures its own downloads, which
+ * under contention see about an even share of the link; their estimates
+ * add up to what the link carries, and that sum is handed back out in
+ * proportion to the projected area of each object's bounding sphere at the
+ * current camera. An object that covers little of the screen, or none of
+ * it, keeps BANDWIDTH_MIN_IMPORTANCE of the weight of the largest one, so
+ * it is still fetched. Until the camera and the bounds are known, every
+ * object gets the same share.
+ *****************************************************************************/
+
+#ifndef BANDWIDTHALLOCATOR_H_
+#define BANDWIDTHALLOCATOR_H_
+
+#include <mutex>
+#include <vector>
+#include <stddef.h>
+
+#define BANDWIDTH_MIN_IMPORTANCE    0.05
+
+namespace mcnl
+{
+    class BandwidthAllocator
+    {
+        public:
+            BandwidthAllocator          (size_t objects);
+            virtual ~BandwidthAllocator ();
+
+            /* UI thread: camera position, vertical field of view in degrees,
+             * viewport height in pixels */
+            void    SetView             (const float eye[3], double fieldOfView, double viewportHeight);
+            /* where object is in the scene, from its last frame */
+            void    SetBounds           (size_t object, const double center[3], double radius);
+            /* fetch thread of object: its own throughput estimate, bps */
+            void    SetThroughput       (size_t object, double throughput);
+
+            /* fraction of the link object gets */
+            double  Share               (size_t object) const;
+            /* bps object may use, 0 until every object has measured its downloads */
+            double  Bandwidth           (size_t object) const;
+
+        private:
+            struct Object
+            {
+                double  center[3];
+                double  radius;         /* < 0 before the first frame */
+                double  throughput;     /* 0 before the first download */
+            };
+
+            mutable std::mutex  mutex;
+            std::vector<Object> objects;
+            float               eye[3];
+            double              tanHalfFov;
+            double              viewportHeight;
+            bool                hasView;
+
+            /* with the lock held */
+            double  Importance          (const Object &object) const;
+    };
+}
+
+#endif /* BANDWIDTHALLOCATOR_H_ */
@@ -0,0 +1,181 @@
+/*
+ * CloudBuffer.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "CloudBuffer.h"
+#include "FrameConverter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace mcnl;
+using namespace open3d;
+using namespace open3d::visualization;
+
+CloudBuffer::CloudBuffer    (const std::string &name) :
+             name           (name),
+             capacity       (0),
+             front          (-1),
+             uploaded       (false),
+             issued         (0),
+             completed      (0)
+{
+    this->allocated[0] = 0;
+    this->allocated[1] = 0;
+}
+CloudBuffer::~CloudBuffer   ()
+{
+}
+
+StagedCloud CloudBuffer::Stage      (const PackedCloud &frame, const uint32_t *order, size_t count, double deadline)
+{
+    if (count == 0)
+        return StagedCloud();
+
+    std::shared_ptr<t::geometry::PointCloud> staging = this->Acquire(count);
+
+    ToStaging(frame, order, count, staging->GetPointPositions().GetDataPtr<float>(),
+              staging->GetPointColors().GetDataPtr<float>(), deadline);
+    Pad(*staging, count);
+    return staging;
+}
+StagedCloud CloudBuffer::Stage      (const t::geometry::PointCloud &cloud)
+{
+    const size_t count = cloud.HasPointPositions() ? cloud.GetPointPositions().GetLength() : 0;
+
+    if (count == 0)
+        return StagedCloud();
+
+    std::shared_ptr<t::geometry::PointCloud> staging = this->Acquire(count);
+
+    /* views of the staging tensors, assigned in place */
+    staging->GetPointPositions().Slice(0, 0, count) =
+        cloud.GetPointPositions().To(core::Device("CPU:0"), core::Float32);
+
+    if (cloud.HasPointColors())
+        staging->GetPointColors().Slice(0, 0, count) = cloud.GetPointColors().To(core::Device("CPU:0"), core::Float32);
+    else
+        staging->GetPointColors().Slice(0, 0, count).Fill(1.0f);
+
+    Pad(*staging, count);
+    return staging;
+}
+uint64_t    CloudBuffer::Issue      ()
+{
+    std::lock_guard<std::mutex> lock(this->fenceMutex);
+
+    return ++this->issued;
+}
+bool        CloudBuffer::Wait       (uint64_t ticket, double seconds)
+{
+    std::unique_lock<std::mutex> lock(this->fenceMutex);
+
+    return this->fenceSignal.wait_for(lock, std::chrono::duration<double>(seconds),
+                                      [this, ticket]() { return this->completed >= ticket; });
+}
+void        CloudBuffer::Upload     (rendering::Open3DScene *scene, const StagedCloud &staged,
+                                     const rendering::MaterialRecord &material)
+{
+    if (scene == NULL || !staged)
+        return;
+
+    int     back     = this->front == 0 ? 1 : 0;
+    size_t  capacity = staged->GetPointPositions().GetLength();
+
+    if (this->allocated[back] != capacity)
+    {
+        if (this->allocated[back] > 0)
+            scene->RemoveGeometry(this->Name(back));
+
+        /* no downsampled copy, it would not follow the in-place updates */
+        scene->AddGeometry(this->Name(back), staged.get(), material, false);
+        this->allocated[back] = capacity;
+    }
+    else
+    {
+        scene->GetScene()->UpdateGeometry(this->Name(back), *staged,
+                                          rendering::Scene::kUpdatePointsFlag | rendering::Scene::kUpdateColorsFlag);
+    }
+
+    /* a new renderable is shown as it is added */
+    scene->ShowGeometry(this->Name(back), false);
+    this->uploaded = true;
+}
+void        CloudBuffer::Swap       (rendering::Open3DScene *scene, uint64_t ticket)
+{
+    if (scene != NULL && this->uploaded)
+    {
+        int back = this->front == 0 ? 1 : 0;
+
+        scene->ShowGeometry(this->Name(back), true);
+        if (this->front >= 0)
+            scene->ShowGeometry(this->Name(this->front), false);
+        this->front     = back;
+        this->uploaded  = false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->fenceMutex);
+
+    this->completed = std::max(this->completed, ticket);
+    this->fenceSignal.notify_all();
+}
+void        CloudBuffer::Clear      (rendering::Open3DScene *scene)
+{
+    for (int buffer = 0; buffer < 2; buffer++)
+    {
+        if (scene && this->allocated[buffer] > 0)
+            scene->RemoveGeometry(this->Name(buffer));
+        this->allocated[buffer] = 0;
+    }
+    this->front     = -1;
+    this->uploaded  = false;
+}
+std::shared_ptr<t::geometry::PointCloud>    CloudBuffer::Acquire    (size_t points)
+{
+    if (points > this->capacity)
+        this->capacity = std::max(points, (size_t) (this->capacity * CLOUD_BUFFER_GROWTH));
+
+    std::shared_ptr<t::geometry::PointCloud> staging;
+
+    /* the only owner is the pool once the UI thread has presented it and a
+     * newer frame has been published; nobody can take a new reference then */
+    for (size_t i = 0; i < this->pool.size() && !staging; i++)
+        if (this->pool.at(i).use_count() == 1)
+            staging = this->pool.at(i);
+
+    if (!staging)
+    {
+        staging = std::make_shared<t::geometry::PointCloud>(core::Device("CPU:0"));
+        this->pool.push_back(staging);
+    }
+
+    if (!staging->HasPointPositions() || (size_t) staging->GetPointPositions().GetLength() != this->capacity)
+    {
+        core::Device cpu("CPU:0");
+
+        /* the renderables are recreated with the new size on their next Present */
+        staging->SetPointPositions(core::Tensor::Empty({(int64_t) this->capacity, 3}, core::Float32, cpu));
+        staging->SetPointColors(core::Tensor::Empty({(int64_t) this->capacity, 3}, core::Float32, cpu));
+    }
+    return staging;
+}
+void        CloudBuffer::Pad        (t::geometry::PointCloud &staging, size_t count)
+{
+    float   *positions = staging.GetPointPositions().GetDataPtr<float>();
+    float   *colors    = staging.GetPointColors().GetDataPtr<float>();
+    size_t  capacity   = staging.GetPointPositions().GetLength();
+
+    /* the whole buffer is uploaded, so the tail must not hold older frames */
+    for (size_t i = count; i < capacity; i++)
+    {
+        memcpy(positions + 3 * i, positions, 3 * sizeof(float));
+        memcpy(colors + 3 * i, colors, 3 * sizeof(float));
+    }
+}
+std::string CloudBuffer::Name       (int buffer) const
+{
+    return this->name + "#" + std::to_string(buffer);
+}
@@ -0,0 +1,100 @@
+/*
+ * CloudBuffer.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Persistent GPU geometry for the decoded clouds. RemoveGeometry and
+ * AddGeometry per frame tear down and recreate the Filament renderable,
+ * its vertex buffers and material instance every time; instead two point
+ * cloud renderables are created once, sized for the largest frame so far,
+ * and each new frame is written in place (Scene::UpdateGeometry) into the
+ * one that is not shown, which then replaces the other on screen.
+ *
+ * Frames smaller than the buffers are padded with copies of their first
+ * point, so nothing of an older frame is drawn. The buffers are only
+ * recreated when a frame outgrows them, with CLOUD_BUFFER_GROWTH headroom.
+ *
+ * The render thread stages each frame into a host buffer of its own,
+ * taken from a pool of those no other thread holds any more; a staged
+ * frame is never written again until it is back in the pool, so staging
+ * and presenting need no lock between them. A decoded frame is converted
+ * straight into its staging buffer (see ToStaging), ahead of its
+ * presentation time.
+ *
+ * The copy to the GPU is split from the swap: Upload writes a frame into
+ * the hidden renderable as soon as it is staged, while the previous one
+ * is still shown, and Swap, at the frame's presentation time, only
+ * exchanges which of the two is visible. Filament then transfers the
+ * vertex data on its driver thread. The render thread takes a ticket for
+ * each upload it posts and waits on it (a fence) before posting the next
+ * one, so uploads never queue up on the UI thread nor overwrite the
+ * renderable on screen.
+ *****************************************************************************/
+
+#ifndef CLOUDBUFFER_H_
+#define CLOUDBUFFER_H_
+
+#include "open3d/Open3D.h"
+#include "PackedCloud.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+#define CLOUD_BUFFER_GROWTH     1.25
+
+namespace mcnl
+{
+    /* CPU:0, Float32 positions and colors, padded to the buffer capacity */
+    typedef std::shared_ptr<const open3d::t::geometry::PointCloud>  StagedCloud;
+
+    class CloudBuffer
+    {
+        public:
+            CloudBuffer             (const std::string &name);
+            virtual ~CloudBuffer    ();
+
+            /* render thread: the positions and colors of a frame, NULL if it has none; the points
+             * order[0] .. order[count - 1] of a decoded one, or its first count without an order */
+            StagedCloud Stage       (const PackedCloud &frame, const uint32_t *order, size_t count, double deadline);
+            StagedCloud Stage       (const open3d::t::geometry::PointCloud &cloud);
+
+            /* render thread: the ticket of the next upload, to post along with it */
+            uint64_t    Issue       ();
+            /* render thread: waits up to `seconds` for the swap of ticket; false on time out */
+            bool        Wait        (uint64_t ticket, double seconds);
+
+            /* UI thread: writes a staged frame into the hidden buffer, which stays hidden */
+            void    Upload          (open3d::visualization::rendering::Open3DScene *scene, const StagedCloud &staged,
+                                     const open3d::visualization::rendering::MaterialRecord &material);
+            /* UI thread: shows the buffer uploaded last, if it is not shown yet, and signals ticket */
+            void    Swap            (open3d::visualization::rendering::Open3DScene *scene, uint64_t ticket);
+            /* UI thread: removes both buffers from the scene */
+            void    Clear           (open3d::visualization::rendering::Open3DScene *scene);
+
+        private:
+            std::string         name;
+            /* render thread */
+            std::vector<std::shared_ptr<open3d::t::geometry::PointCloud>>   pool;
+            size_t              capacity;
+            /* UI thread */
+            size_t              allocated[2];   /* capacity of each renderable, 0 if none */
+            int                 front;          /* shown renderable, -1 before the first */
+            bool                uploaded;       /* the hidden one holds a frame not shown yet */
+            /* the fence between the two */
+            std::mutex              fenceMutex;
+            std::condition_variable fenceSignal;
+            uint64_t            issued;
+            uint64_t            completed;
+
+            /* a pooled buffer of capacity >= points that nobody else holds */
+            std::shared_ptr<open3d::t::geometry::PointCloud>    Acquire (size_t points);
+            static void     Pad     (open3d::t::geometry::PointCloud &staging, size_t count);
+            std::string     Name    (int buffer) const;
+    };
+}
+
+#endif /* CLOUDBUFFER_H_ */
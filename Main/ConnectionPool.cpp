@@ -0,0 +1,189 @@
+/*
+ * ConnectionPool.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "ConnectionPool.h"
+#include "TestChunk.h"
+
+#include <sstream>
+
+using namespace mcnl;
+using namespace libdashtest;
+using namespace dash::network;
+
+ConnectionPool::ConnectionPool  (size_t maxPerHost) :
+                maxPerHost      (maxPerHost > 0 ? maxPerHost : 1),
+                metrics         (NULL)
+{
+}
+ConnectionPool::~ConnectionPool ()
+{
+    std::map<std::string, std::vector<Entry> >::iterator it;
+
+    for (it = this->hosts.begin(); it != this->hosts.end(); ++it)
+        for (size_t i = 0; i < it->second.size(); i++)
+        {
+            it->second.at(i).connection->CloseSocket();
+            this->Collect(it->second.at(i).connection);
+            delete it->second.at(i).connection;
+        }
+}
+
+PersistentHTTPConnection*   ConnectionPool::Schedule    (IChunk *chunk, bool &fresh, const std::string &headers)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::vector<Entry> &entries = this->hosts[this->Key(chunk)];
+
+    this->Prune(entries);
+
+    /* an idle connection, else a new one, else pipeline on the least loaded */
+    Entry *best = NULL;
+    for (size_t i = 0; i < entries.size(); i++)
+        if (!entries.at(i).connection->IsBroken() && (best == NULL || entries.at(i).users < best->users))
+            best = &entries.at(i);
+
+    fresh = false;
+    if (best == NULL || (best->users > 0 && entries.size() < this->maxPerHost))
+    {
+        PersistentHTTPConnection *connection = new PersistentHTTPConnection();
+
+        if (!connection->Init(chunk))
+        {
+            delete connection;
+            return NULL;
+        }
+
+        Entry entry;
+        entry.connection = connection;
+        entry.users      = 0;
+        entries.push_back(entry);
+
+        best  = &entries.back();
+        fresh = true;
+    }
+
+    if (!best->connection->Schedule(chunk, headers))
+        return NULL;
+
+    best->users++;
+    return best->connection;
+}
+void                        ConnectionPool::Release     (PersistentHTTPConnection *connection)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::map<std::string, std::vector<Entry> >::iterator it;
+
+    for (it = this->hosts.begin(); it != this->hosts.end(); ++it)
+    {
+        for (size_t i = 0; i < it->second.size(); i++)
+        {
+            if (it->second.at(i).connection == connection)
+            {
+                this->Collect(connection);
+                it->second.at(i).users--;
+                this->Prune(it->second);
+                return;
+            }
+        }
+    }
+}
+void                        ConnectionPool::Prewarm     (const std::string &host, size_t port)
+{
+    libdashtest::TestChunk  chunk(host, port, "/", 0, 0, false);
+    size_t                  missing = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        std::vector<Entry> &entries = this->hosts[this->Key(&chunk)];
+
+        if (entries.size() < this->maxPerHost)
+            missing = this->maxPerHost - entries.size();
+    }
+
+    for (size_t i = 0; i < missing; i++)
+    {
+        PersistentHTTPConnection *connection = new PersistentHTTPConnection();
+
+        if (!connection->Init(&chunk))
+        {
+            delete connection;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        std::vector<Entry> &entries = this->hosts[this->Key(&chunk)];
+
+        /* Schedule may have opened some meanwhile */
+        if (entries.size() >= this->maxPerHost)
+        {
+            connection->CloseSocket();
+            this->Collect(connection);
+            delete connection;
+            return;
+        }
+
+        Entry entry;
+        entry.connection = connection;
+        entry.users      = 0;
+        entries.push_back(entry);
+    }
+}
+size_t                      ConnectionPool::Connections ()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    size_t count = 0;
+    std::map<std::string, std::vector<Entry> >::iterator it;
+
+    for (it = this->hosts.begin(); it != this->hosts.end(); ++it)
+        count += it->second.size();
+
+    return count;
+}
+void                        ConnectionPool::MaxPerHost  (size_t maxPerHost)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->maxPerHost = maxPerHost > 0 ? maxPerHost : 1;
+}
+std::string                 ConnectionPool::Key         (IChunk *chunk) const
+{
+    std::stringstream key;
+    key << chunk->Host() << ":" << chunk->Port();
+    return key.str();
+}
+void                        ConnectionPool::Prune       (std::vector<Entry> &entries)
+{
+    /* broken connections are closed once nobody is reading from them */
+    for (size_t i = entries.size(); i-- > 0;)
+    {
+        if (entries.at(i).users == 0 && entries.at(i).connection->IsBroken())
+        {
+            entries.at(i).connection->CloseSocket();
+            this->Collect(entries.at(i).connection);
+            delete entries.at(i).connection;
+            entries.erase(entries.begin() + i);
+        }
+    }
+}
+void                        ConnectionPool::SetMetrics  (MetricsLog *metrics)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->metrics = metrics;
+}
+void                        ConnectionPool::Collect     (PersistentHTTPConnection *connection)
+{
+    if (this->metrics == NULL)
+        return;
+
+    std::vector<dash::metrics::IHTTPTransaction *>  transactions;
+    std::vector<dash::metrics::ITCPConnection *>    connections;
+
+    connection->TakeMetrics(transactions, connections);
+    this->metrics->Add(transactions, connections);
+}
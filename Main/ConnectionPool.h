@@ -0,0 +1,68 @@
+/*
+ * ConnectionPool.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Keep-alive HTTP/1.1 connections per host:port, shared by the MPD and all
+ * segment downloads. Up to maxPerHost connections are opened; beyond that,
+ * requests are pipelined on the least loaded one. Prewarm opens them ahead
+ * of the first requests, so those do not wait for the connect. With SetMetrics, the
+ * DASH metrics of every request go to a MetricsLog as it is released.
+ *****************************************************************************/
+
+#ifndef CONNECTIONPOOL_H_
+#define CONNECTIONPOOL_H_
+
+#include "PersistentHTTPConnection.h"
+#include "MetricsLog.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define POOL_MAX_PER_HOST 2
+
+namespace mcnl
+{
+    class ConnectionPool
+    {
+        public:
+            ConnectionPool          (size_t maxPerHost = POOL_MAX_PER_HOST);
+            virtual ~ConnectionPool ();
+
+            /* Connection with the request for chunk already scheduled, or NULL.
+             * fresh is set if the connection was opened for this request.
+             * headers are extra request header lines, each ending in \r\n */
+            libdashtest::PersistentHTTPConnection*  Schedule    (dash::network::IChunk *chunk, bool &fresh,
+                                                                 const std::string &headers = "");
+            /* call once the response for a scheduled chunk has been read */
+            void                                    Release     (libdashtest::PersistentHTTPConnection *connection);
+            /* opens idle connections to host:port up to maxPerHost; blocks while
+             * connecting, without holding up Schedule meanwhile */
+            void                                    Prewarm     (const std::string &host, size_t port);
+
+            size_t  Connections     ();
+            void    MaxPerHost      (size_t maxPerHost);
+            /* must outlive the pool; NULL drops the metrics */
+            void    SetMetrics      (MetricsLog *metrics);
+
+        private:
+            struct Entry
+            {
+                libdashtest::PersistentHTTPConnection   *connection;
+                size_t                                  users;      /* requests handed out, not yet released */
+            };
+
+            std::string             Key     (dash::network::IChunk *chunk) const;
+            void                    Prune   (std::vector<Entry> &entries);
+            void                    Collect (libdashtest::PersistentHTTPConnection *connection);
+
+            size_t                                      maxPerHost;
+            std::mutex                                  mutex;
+            std::map<std::string, std::vector<Entry> >  hosts;
+            MetricsLog                                  *metrics;
+    };
+}
+
+#endif /* CONNECTIONPOOL_H_ */
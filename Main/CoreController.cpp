@@ -0,0 +1,86 @@
+/*
+ * CoreController.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "CoreController.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace mcnl;
+
+CoreSample::CoreSample  () :
+            slack       (0),
+            fill        (0),
+            decodeLoad  (0),
+            renderLoad  (0)
+{
+}
+
+CoreController::CoreController  (double low, double high, size_t hold) :
+                low             (low),
+                high            (high),
+                hold            (hold),
+                concurrency     (0),
+                held            (hold),
+                changes         (0)
+{
+}
+CoreController::~CoreController ()
+{
+}
+
+size_t  CoreController::Next        (const CoreSample &sample, size_t threads)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    size_t least = std::min<size_t>(2, threads);
+
+    /* the arena may have been started, or resized, since the last tick */
+    if (this->concurrency == 0 || this->concurrency > threads)
+        this->concurrency = threads;
+    this->concurrency = std::max(this->concurrency, least);
+
+    size_t next = this->concurrency;
+
+    if (this->held >= this->hold)
+    {
+        bool starving   = sample.slack < this->low || sample.decodeLoad > CORE_CONTROL_DECODE_HIGH;
+        bool full       = sample.fill >= CORE_CONTROL_FULL;
+        bool renderer   = sample.renderLoad > CORE_CONTROL_RENDER_HIGH && sample.slack >= this->low;
+        bool idle       = sample.slack > this->high && sample.decodeLoad < CORE_CONTROL_DECODE_LOW;
+
+        /* a full queue holds the decoders back whatever their load, the decode load is of the segments before */
+        if (starving && !full && next < threads)
+            next++;
+        else if ((full || renderer || idle) && next > least)
+            next--;
+    }
+
+    if (next != this->concurrency)
+    {
+        std::cout << "CoreController: slack " << sample.slack << " s, fill " << sample.fill << ", decode load " <<
+                     sample.decodeLoad << ", render load " << sample.renderLoad << ", decode threads " <<
+                     this->concurrency << " -> " << next << std::endl;
+        this->concurrency = next;
+        this->held        = 0;
+        this->changes++;
+    }
+    this->held++;
+
+    return this->concurrency;
+}
+size_t  CoreController::Concurrency () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->concurrency;
+}
+size_t  CoreController::Changes     () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->changes;
+}
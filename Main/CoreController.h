@@ -0,0 +1,77 @@
+/*
+ * CoreController.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * How many threads of the TaskRuntime decode, see SetConcurrency: as few
+ * as keep the frames coming in time, so the other cores go to the renderer
+ * or sleep, which saves power on a headset. Every tick it is fed the state
+ * of the pipeline since the tick before, from the same instrumentation as
+ * the metrics:
+ *
+ *  - slack, the seconds the frames queued for the renderer play for;
+ *  - fill, how full that queue is, of its frames or of its bytes;
+ *  - decodeLoad, the wall time of the segments decoded over their
+ *    duration, above 1 when decoding falls behind;
+ *  - renderLoad, the time the renderer spent on a frame over the frame
+ *    period.
+ *
+ * One more thread decodes while the slack is under `low` or the decode
+ * load high; one less once the queue is full, the renderer is short of
+ * time while the slack holds, or the slack is over `high` with the decode
+ * load low. After a change, it is held for `hold` ticks, for the decode
+ * times to show its effect.
+ *****************************************************************************/
+
+#ifndef CORECONTROLLER_H_
+#define CORECONTROLLER_H_
+
+#include <mutex>
+#include <stddef.h>
+
+#define CORE_CONTROL_LOW_SLACK      0.5     /* seconds */
+#define CORE_CONTROL_HIGH_SLACK     1.5     /* seconds */
+#define CORE_CONTROL_HOLD           4       /* ticks */
+#define CORE_CONTROL_DECODE_HIGH    0.8     /* decode load at which a thread is added */
+#define CORE_CONTROL_DECODE_LOW     0.5     /* and below which one may be taken away */
+#define CORE_CONTROL_RENDER_HIGH    0.7     /* render load at which the renderer is short of time */
+#define CORE_CONTROL_FULL           0.9     /* fill of a full queue */
+
+namespace mcnl
+{
+    struct CoreSample
+    {
+        double  slack;          /* seconds */
+        double  fill;           /* 0..1 */
+        double  decodeLoad;     /* 0 without a segment decoded since the last tick */
+        double  renderLoad;     /* 0 without a frame shown since the last tick */
+
+        CoreSample  ();
+    };
+
+    class CoreController
+    {
+        public:
+            CoreController          (double low = CORE_CONTROL_LOW_SLACK, double high = CORE_CONTROL_HIGH_SLACK,
+                                     size_t hold = CORE_CONTROL_HOLD);
+            virtual ~CoreController ();
+
+            /* the decode threads for the next tick, from 2 to threads, the size of the arena;
+             * all of them until the first tick */
+            size_t  Next            (const CoreSample &sample, size_t threads);
+            size_t  Concurrency     () const;
+            /* changes so far, up and down */
+            size_t  Changes         () const;
+
+        private:
+            mutable std::mutex      mutex;
+            double                  low;
+            double                  high;
+            size_t                  hold;
+            size_t                  concurrency;    /* 0 before the first tick */
+            size_t                  held;           /* ticks since the last change */
+            size_t                  changes;
+    };
+}
+
+#endif /* CORECONTROLLER_H_ */
@@ -0,0 +1,53 @@
+/*
+ * DecodePool.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "DecodePool.h"
+#include "TaskRuntime.h"
+
+#include "PCCExecutionContext.h"
+
+using namespace mcnl;
+
+DecodePool::DecodePool      (size_t slots) :
+            slots           (slots > 0 ? slots : 1),
+            busy            (0),
+            executionContext(TaskRuntime::Instance().ExecutionContext())
+{
+}
+DecodePool::~DecodePool     ()
+{
+}
+
+void    DecodePool::Acquire     (double deadline)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    std::multiset<double>::iterator entry = this->waiting.insert(deadline);
+
+    /* equal deadlines may go in either order */
+    this->released.wait(lock, [this, deadline]() {
+        return this->busy < this->slots && *this->waiting.begin() >= deadline;
+    });
+    this->waiting.erase(entry);
+    this->busy++;
+    /* the next earliest may fit in a slot that is still free */
+    this->released.notify_all();
+}
+void    DecodePool::Release     ()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->busy--;
+    this->released.notify_all();
+}
+size_t  DecodePool::Slots       () const
+{
+    return this->slots;
+}
+std::shared_ptr<pcc::PCCExecutionContext>   DecodePool::ExecutionContext    () const
+{
+    return this->executionContext;
+}
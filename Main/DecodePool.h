@@ -0,0 +1,55 @@
+/*
+ * DecodePool.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Decode capacity shared by the DecodeSchedulers of all objects of a
+ * scene. Their decoders run in the arena of the TaskRuntime, and at most
+ * `slots` segments are decoded at a time, whichever object they belong
+ * to. A free slot goes to the waiting segment with the earliest deadline,
+ * i.e. the one whose first frame is due first, so a far-ahead object never
+ * holds up one that is about to stall. A scheduler gives up its slot while its worker waits
+ * for memory (see DecodeScheduler), so waiting decodes cannot lock out the
+ * ones they wait for.
+ *****************************************************************************/
+
+#ifndef DECODEPOOL_H_
+#define DECODEPOOL_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stddef.h>
+
+namespace pcc
+{
+    class PCCExecutionContext;
+}
+
+namespace mcnl
+{
+    class DecodePool
+    {
+        public:
+            DecodePool              (size_t slots);
+            virtual ~DecodePool     ();
+
+            /* waits for a slot; deadline in seconds of presentation time, earliest first */
+            void    Acquire         (double deadline);
+            void    Release         ();
+
+            size_t  Slots           () const;
+            std::shared_ptr<pcc::PCCExecutionContext>   ExecutionContext    () const;
+
+        private:
+            std::mutex                  mutex;
+            std::condition_variable     released;
+            std::multiset<double>       waiting;
+            size_t                      slots;
+            size_t                      busy;
+            std::shared_ptr<pcc::PCCExecutionContext>   executionContext;
+    };
+}
+
+#endif /* DECODEPOOL_H_ */
@@ -0,0 +1,233 @@
+/*
+ * DecodeScheduler.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "DecodeScheduler.h"
+#include "TaskRuntime.h"
+#include "Tracer.h"
+
+#include "PCCExecutionContext.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace mcnl;
+
+DecodeScheduler::DecodeScheduler    (size_t workers, size_t memoryBudget, const std::vector<std::string> &options,
+                                     DecodeJob job, OrderedFrameSink output, SegmentDone done,
+                                     DecodePool *pool) :
+                 job                (job),
+                 output             (output),
+                 done               (done),
+                 memoryBudget       (memoryBudget),
+                 pool               (pool),
+                 started            (0),
+                 heldBytes          (0),
+                 closed             (false)
+{
+    if (workers == 0)
+        workers = 1;
+    this->executionContext = pool != NULL ? pool->ExecutionContext() : TaskRuntime::Instance().ExecutionContext();
+
+    for (size_t i = 0; i < workers; i++)
+    {
+        std::unique_ptr<VpccDecoder> decoder(new VpccDecoder());
+
+        decoder->SetOptions(options);
+        decoder->SetFrameIds(i, workers);
+        decoder->SetExecutionContext(this->executionContext);
+        this->decoders.push_back(std::move(decoder));
+    }
+    /* --nbThread and --threadAffinity of the first scheduler size the arena of the whole client */
+    TaskRuntime::Instance().Start(this->decoders.front()->Parameters().nbThread_,
+                                  this->decoders.front()->Parameters().threadAffinity_);
+    for (size_t i = 0; i < workers; i++)
+        this->threads.push_back(std::thread(&DecodeScheduler::Work, this, std::ref(*this->decoders.at(i))));
+    this->outputThread = std::thread(&DecodeScheduler::HandOn, this);
+}
+DecodeScheduler::~DecodeScheduler   ()
+{
+    this->Finish();
+}
+
+void        DecodeScheduler::Submit         (std::unique_ptr<SegmentInfo> segment, double deadline)
+{
+    std::shared_ptr<Task> task(new Task());
+
+    task->segment       = std::move(segment);
+    task->deadline      = deadline;
+    task->handed        = 0;
+    task->done          = false;
+    task->ret           = 0;
+    task->seconds       = 0;
+    task->busySeconds   = 0;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    this->changed.wait(lock, [this]() { return this->tasks.size() == this->started; });
+    this->tasks.push_back(task);
+    this->changed.notify_all();
+}
+void        DecodeScheduler::Finish         ()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (this->closed)
+            return;
+        this->closed = true;
+        this->changed.notify_all();
+    }
+
+    for (size_t i = 0; i < this->threads.size(); i++)
+        this->threads.at(i).join();
+    this->outputThread.join();
+}
+void        DecodeScheduler::SetHeadroom    (Headroom headroom)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->headroom = headroom;
+}
+size_t      DecodeScheduler::Workers        () const
+{
+    return this->decoders.size();
+}
+
+void        DecodeScheduler::Work           (VpccDecoder &decoder)
+{
+    Tracer::Instance().NameThread("decode");
+
+    while (true)
+    {
+        std::shared_ptr<Task> task;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+
+            /* the oldest segment is started regardless of the budget, its frames go straight on */
+            this->changed.wait(lock, [this]() {
+                return (this->started < this->tasks.size() &&
+                        (this->started == 0 || this->heldBytes <= this->Budget())) ||
+                       (this->closed && this->started == this->tasks.size());
+            });
+            if (this->started == this->tasks.size())
+                return;
+
+            task = this->tasks.at(this->started++);
+        }
+
+        if (this->pool != NULL)
+            this->pool->Acquire(task->deadline);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        int ret = this->job(decoder, *task->segment, [this, &task](std::unique_ptr<DecodedFrame> frame) {
+            this->Hold(task, std::move(frame));
+        });
+
+        std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+
+        if (this->pool != NULL)
+            this->pool->Release();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        task->ret           = ret;
+        task->seconds       = sec.count();
+        task->busySeconds   = decoder.BusySeconds();
+        task->done          = true;
+        this->changed.notify_all();
+    }
+}
+void        DecodeScheduler::Hold           (const std::shared_ptr<Task> &task, std::unique_ptr<DecodedFrame> frame)
+{
+    size_t bytes = FrameBytes(*frame);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    task->frames.push_back(std::make_pair(bytes, std::move(frame)));
+    this->heldBytes += bytes;
+    this->changed.notify_all();
+
+    /* a later segment must not run away with the memory; the oldest one releases it */
+    auto ready = [this, &task]() {
+        return this->heldBytes <= this->Budget() || this->IsOldest(task);
+    };
+
+    if (ready())
+        return;
+
+    /* the slot goes to other segments meanwhile, the oldest one may need it */
+    if (this->pool != NULL)
+    {
+        lock.unlock();
+        this->pool->Release();
+        lock.lock();
+    }
+
+    this->changed.wait(lock, ready);
+
+    if (this->pool != NULL)
+    {
+        lock.unlock();
+        this->pool->Acquire(task->deadline);
+    }
+}
+void        DecodeScheduler::HandOn         ()
+{
+    Tracer::Instance().NameThread("decode output");
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (true)
+    {
+        this->changed.wait(lock, [this]() {
+            return (!this->tasks.empty() && (!this->tasks.front()->frames.empty() || this->tasks.front()->done)) ||
+                   (this->closed && this->tasks.empty());
+        });
+        if (this->tasks.empty())
+            return;
+
+        std::shared_ptr<Task> task = this->tasks.front();
+
+        if (!task->frames.empty())
+        {
+            std::unique_ptr<DecodedFrame> frame = std::move(task->frames.front().second);
+            size_t                        index = task->handed++;
+
+            this->heldBytes -= task->frames.front().first;
+            task->frames.pop_front();
+            this->changed.notify_all();
+
+            /* the sink may wait for the renderer */
+            lock.unlock();
+            this->output(*task->segment, index, std::move(frame));
+            lock.lock();
+            continue;
+        }
+
+        this->tasks.pop_front();
+        this->started--;
+        this->changed.notify_all();
+
+        lock.unlock();
+        this->done(*task->segment, task->ret, task->seconds, task->busySeconds);
+        lock.lock();
+    }
+}
+bool        DecodeScheduler::IsOldest       (const std::shared_ptr<Task> &task) const
+{
+    return !this->tasks.empty() && this->tasks.front() == task;
+}
+size_t      DecodeScheduler::Budget         () const
+{
+    /* the headroom is read again whenever a frame is held or handed on */
+    return this->headroom ? std::min(this->memoryBudget, this->headroom()) : this->memoryBudget;
+}
+size_t      DecodeScheduler::FrameBytes     (const DecodedFrame &frame)
+{
+    /* what the renderer gets: positions and colors */
+    return frame.points.Bytes();
+}
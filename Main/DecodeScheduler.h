@@ -0,0 +1,131 @@
+/*
+ * DecodeScheduler.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Decodes up to `workers` segments side by side and hands their frames on
+ * in segment order. Every segment of the content starts with an IRAP GOF,
+ * so each worker runs its own VpccDecoder; they share the TBB arena of the
+ * TaskRuntime, so the cores are split between the segments and the rest of
+ * the pipeline instead of oversubscribed. A segment only waits for a
+ * worker, so more than one runs at a time only while the client has
+ * several buffered, i.e. when it is behind.
+ *
+ * The frames of a segment that finishes ahead of the ones before it are
+ * held until it is its turn. Once they add up to more than `memoryBudget`
+ * bytes, the workers of those segments stop at their next frame and no
+ * further segment is started; the oldest one always goes on, so the held
+ * frames drain. A headroom, if set, lowers the budget to what the frames
+ * can still take on their way to the renderer, so fewer segments decode
+ * ahead while the frame queue is full. Only the points on the host are
+ * counted, not the clouds reconstructed on the device, and each worker
+ * keeps its own video frames and video decoders besides.
+ *
+ * The schedulers of the objects of a scene share a DecodePool besides: a
+ * segment only decodes while it holds one of the pool's slots, given out
+ * by deadline.
+ *****************************************************************************/
+
+#ifndef DECODESCHEDULER_H_
+#define DECODESCHEDULER_H_
+
+#include "DecodePool.h"
+#include "SegmentFetcher.h"
+#include "VpccDecoder.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pcc
+{
+    class PCCExecutionContext;
+}
+
+namespace mcnl
+{
+    class DecodeScheduler
+    {
+        public:
+            typedef std::function<void(std::unique_ptr<DecodedFrame> frame)> FrameSink;
+            /* runs on a worker: decodes segment with decoder and hands each frame to emit, in
+             * presentation order; returns the Decode result */
+            typedef std::function<int(VpccDecoder &decoder, SegmentInfo &segment, const FrameSink &emit)> DecodeJob;
+            /* run on the output thread, in segment order: each frame of a segment with its
+             * index in it, then the end of the segment with the result of the DecodeJob */
+            typedef std::function<void(SegmentInfo &segment, size_t index, std::unique_ptr<DecodedFrame> frame)>
+                OrderedFrameSink;
+            typedef std::function<void(SegmentInfo &segment, int ret, double seconds, double busySeconds)>
+                SegmentDone;
+            /* bytes the frames can still take downstream, e.g. the room left in the frame queue */
+            typedef std::function<size_t()> Headroom;
+
+            /* options as for VpccDecoder::SetOptions, applied to the decoder of every worker;
+             * pool, if any, must outlive the scheduler */
+            DecodeScheduler             (size_t workers, size_t memoryBudget, const std::vector<std::string> &options,
+                                         DecodeJob job, OrderedFrameSink output, SegmentDone done,
+                                         DecodePool *pool = NULL);
+            virtual ~DecodeScheduler    ();
+
+            /* waits while every worker is busy and another segment is waiting already;
+             * deadline orders the segment in the DecodePool, see there */
+            void    Submit              (std::unique_ptr<SegmentInfo> segment, double deadline = 0);
+            /* waits until every segment submitted has been handed on */
+            void    Finish              ();
+            /* before the first Submit */
+            void    SetHeadroom         (Headroom headroom);
+
+            size_t  Workers             () const;
+            /* what a frame holds against the budgets: its points on the host */
+            static size_t   FrameBytes  (const DecodedFrame &frame);
+
+        private:
+            struct Task
+            {
+                std::unique_ptr<SegmentInfo>    segment;
+                /* decoded, not handed on yet, with the bytes they hold */
+                std::deque<std::pair<size_t, std::unique_ptr<DecodedFrame>>> frames;
+                double                          deadline;
+                size_t                          handed;     /* frames handed on so far */
+                bool                            done;
+                int                             ret;
+                double                          seconds;
+                double                          busySeconds;
+            };
+
+            DecodeJob                   job;
+            OrderedFrameSink            output;
+            SegmentDone                 done;
+            size_t                      memoryBudget;
+            Headroom                    headroom;
+            DecodePool                  *pool;
+            std::shared_ptr<pcc::PCCExecutionContext> executionContext;
+            std::vector<std::unique_ptr<VpccDecoder>> decoders;
+            std::vector<std::thread>    threads;
+            std::thread                 outputThread;
+
+            std::mutex                  mutex;
+            std::condition_variable     changed;
+            /* submitted and not handed on yet, in segment order; the front one is the oldest */
+            std::deque<std::shared_ptr<Task>> tasks;
+            size_t                      started;    /* tasks taken by a worker, counted from the front */
+            size_t                      heldBytes;
+            bool                        closed;
+
+            void    Work                (VpccDecoder &decoder);
+            void    Hold                (const std::shared_ptr<Task> &task, std::unique_ptr<DecodedFrame> frame);
+            void    HandOn              ();
+            bool    IsOldest            (const std::shared_ptr<Task> &task) const;
+            /* bytes the held frames may add up to now */
+            size_t  Budget              () const;
+    };
+}
+
+#endif /* DECODESCHEDULER_H_ */
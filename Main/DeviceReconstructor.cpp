@@ -0,0 +1,195 @@
+/*
+ * DeviceReconstructor.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "DeviceReconstructor.h"
+
+#include "open3d/core/CUDAUtils.h"
+#include "open3d/core/MemoryManager.h"
+#include "PCCFrameContext.h"
+#include "PCCImage.h"
+#include "PCCPatch.h"
+
+#include <limits>
+#include <vector>
+
+using namespace mcnl;
+using namespace open3d;
+
+#define PATCH_COLUMNS   14
+#define COLUMN_S        0
+#define COLUMN_D1       1
+#define COLUMN_AX       2
+#define COLUMN_AY       5
+#define COLUMN_P0       8
+#define COLUMN_N        11
+
+DeviceReconstructor::DeviceReconstructor    (const std::string &device) :
+                     device                 (device != "auto" ? device : core::cuda::IsAvailable() ? "CUDA:0" : "CPU:0")
+{
+}
+DeviceReconstructor::~DeviceReconstructor   ()
+{
+}
+
+const core::Device&                         DeviceReconstructor::Device         () const
+{
+    return this->device;
+}
+std::shared_ptr<t::geometry::PointCloud>    DeviceReconstructor::Reconstruct    (const pcc::PCCDecodedTextures &textures)
+{
+    std::shared_ptr<t::geometry::PointCloud> cloud = std::make_shared<t::geometry::PointCloud>(this->device);
+    core::Tensor pixels, patches;
+
+    this->Occupied(textures, pixels, patches);
+    if (pixels.NumElements() == 0)
+        return cloud;
+
+    const int64_t   width   = textures.tile->getWidth();
+    const float     maximum = std::numeric_limits<float>::max();
+    core::Tensor    table   = this->PatchTable(*textures.tile).IndexGet({patches});
+    core::Tensor    s       = table.Slice(1, COLUMN_S, COLUMN_S + 1);
+    core::Tensor    d1      = table.Slice(1, COLUMN_D1, COLUMN_D1 + 1);
+    core::Tensor    normal  = table.Slice(1, COLUMN_N, COLUMN_N + 3);
+    core::Tensor    y       = pixels / width;
+    core::Tensor    x       = pixels - y * width;
+
+    /* the position of the pixel with its normal coordinate left at 0 */
+    core::Tensor    base    = table.Slice(1, COLUMN_P0, COLUMN_P0 + 3) +
+                              table.Slice(1, COLUMN_AX, COLUMN_AX + 3) * x.To(core::Float32).Reshape({-1, 1}) +
+                              table.Slice(1, COLUMN_AY, COLUMN_AY + 3) * y.To(core::Float32).Reshape({-1, 1});
+
+    std::vector<core::Tensor> depths;
+    for (size_t map = 0; map < textures.geometry.size(); map++)
+    {
+        const pcc::PCCImageGeometry &geometry = *textures.geometry[map];
+        depths.push_back(this->Upload(geometry.getChannel(0).data(), {(int64_t) geometry.getChannel(0).size()},
+                                      core::UInt16).IndexGet({pixels}).To(core::Float32).Reshape({-1, 1}));
+    }
+
+    core::Tensor    first     = (s * depths[0] + d1).Clip(0.0f, maximum);
+    core::Tensor    positions = base + normal * first;
+    core::Tensor    colors;
+    if (!textures.attributes.empty())
+        colors = this->Colors(*textures.attributes[0], pixels, textures.attributesRGB);
+
+    if (depths.size() > 1)
+    {
+        /* the second map is absolute, or a distance from the first one along the normal */
+        core::Tensor second = textures.absoluteD1 ? (s * depths[1] + d1).Clip(0.0f, maximum) : first + s * depths[1];
+        core::Tensor kept   = textures.removeDuplicatePoints ? second.Ne(first).Reshape({-1}) :
+                              core::Tensor::Ones({second.GetLength()}, core::Bool, this->device);
+
+        positions = core::Concatenate({positions, (base + normal * second).IndexGet({kept})}, 0);
+        if (colors.NumElements() > 0)
+            colors = core::Concatenate({colors, this->Colors(*textures.attributes[1], pixels.IndexGet({kept}),
+                                                             textures.attributesRGB)}, 0);
+    }
+
+    cloud->SetPointPositions(positions);
+    if (colors.NumElements() > 0)
+        cloud->SetPointColors(colors);
+
+    return cloud;
+}
+template <typename T>
+core::Tensor                                DeviceReconstructor::Upload         (const T *data, const core::SizeVector &shape,
+                                                                                 core::Dtype dtype) const
+{
+    core::Tensor tensor = core::Tensor::Empty(shape, dtype, this->device);
+
+    if (tensor.NumElements() > 0)
+        core::MemoryManager::MemcpyFromHost(tensor.GetDataPtr(), this->device, data, tensor.NumElements() * sizeof(T));
+
+    return tensor;
+}
+core::Tensor                                DeviceReconstructor::PatchTable     (pcc::PCCFrameContext &tile) const
+{
+    std::vector<pcc::PCCPatch>  &patches = tile.getPatches();
+    std::vector<float>          table(patches.size() * PATCH_COLUMNS, 0.0f);
+
+    for (size_t i = 0; i < patches.size(); i++)
+    {
+        const pcc::PCCPatch &patch = patches[i];
+        float               *row   = table.data() + i * PATCH_COLUMNS;
+        const pcc::PCCPatchCanvasTransform  transform = patch.getCanvasTransform();
+
+        /* u = ux * x + uy * y + cu, and v alike: the transpose of the patch to canvas map, as in PCCPatch::canvasTo3D() */
+        const double    ux = transform.xu_, uy = transform.yu_, cu = -(ux * transform.x0_ + uy * transform.y0_);
+        const double    vx = transform.xv_, vy = transform.yv_, cv = -(vx * transform.x0_ + vy * transform.y0_);
+
+        const double    lodX      = patch.getLodScaleX();
+        const double    lodY      = patch.getLodScaleY();
+        const size_t    tangent   = patch.getTangentAxis();
+        const size_t    bitangent = patch.getBitangentAxis();
+
+        row[COLUMN_S]                 = patch.getProjectionMode() == 0 ? 1.0f : -1.0f;
+        row[COLUMN_D1]                = (float) patch.getD1();
+        row[COLUMN_AX + tangent]      = (float) (lodX * ux);
+        row[COLUMN_AY + tangent]      = (float) (lodX * uy);
+        row[COLUMN_P0 + tangent]      = (float) (lodX * cu + patch.getU1());
+        row[COLUMN_AX + bitangent]    = (float) (lodY * vx);
+        row[COLUMN_AY + bitangent]    = (float) (lodY * vy);
+        row[COLUMN_P0 + bitangent]    = (float) (lodY * cv + patch.getV1());
+        row[COLUMN_N + patch.getNormalAxis()] = 1.0f;
+    }
+
+    return core::Tensor(table, {(int64_t) patches.size(), PATCH_COLUMNS}, core::Float32, this->device);
+}
+void                                        DeviceReconstructor::Occupied       (const pcc::PCCDecodedTextures &textures,
+                                                                                 core::Tensor &pixels, core::Tensor &patches) const
+{
+    pcc::PCCFrameContext                &tile         = *textures.tile;
+    const pcc::PCCImageOccupancyMap     &occupancy    = *textures.occupancy;
+    std::vector<size_t>                 &blockToPatch = tile.getBlockToPatch();
+    const int64_t                       precision     = textures.occupancyPrecision;
+    const int64_t                       resolution    = textures.occupancyResolution;
+    const int64_t                       width         = tile.getWidth();
+
+    /* each occupied pixel of the occupancy map covers precision x precision pixels of the canvas */
+    core::Tensor occupied = this->Upload(occupancy.getChannel(0).data(),
+                                         {(int64_t) occupancy.getHeight(), (int64_t) occupancy.getWidth()},
+                                         core::UInt8).NonZero();
+
+    std::vector<int64_t> dy(precision * precision), dx(precision * precision);
+    for (int64_t i = 0; i < precision * precision; i++)
+    {
+        dy[i] = i / precision;
+        dx[i] = i % precision;
+    }
+
+    core::Tensor y = (occupied[0].Reshape({-1, 1}) * precision +
+                      core::Tensor(dy, {1, precision * precision}, core::Int64, this->device)).Reshape({-1});
+    core::Tensor x = (occupied[1].Reshape({-1, 1}) * precision +
+                      core::Tensor(dx, {1, precision * precision}, core::Int64, this->device)).Reshape({-1});
+
+    /* blockToPatch holds the patch index + 1 of each block, 0 where no patch is */
+    core::Tensor owner = this->Upload(blockToPatch.data(), {(int64_t) blockToPatch.size()}, core::UInt64)
+                             .IndexGet({(y / resolution) * (width / resolution) + x / resolution}).To(core::Int64);
+    core::Tensor used  = owner.Gt(0);
+
+    pixels  = (y * width + x).IndexGet({used});
+    patches = owner.IndexGet({used}) - 1;
+}
+core::Tensor                                DeviceReconstructor::Colors         (const pcc::PCCImage<uint16_t, 3> &image,
+                                                                                 const core::Tensor &pixels, bool rgb) const
+{
+    core::Tensor planes[3];
+    for (size_t c = 0; c < 3; c++)
+        planes[c] = this->Upload(image.getChannel(c).data(), {(int64_t) image.getChannel(c).size()}, core::UInt16)
+                        .IndexGet({pixels}).To(core::Float32).Reshape({-1, 1});
+
+    /* as PCCPointSet3::copyRGB16ToRGB8() and convertYUV16ToRGB8() (BT.709), then scaled to [0, 1] */
+    if (rgb)
+        return core::Concatenate({planes[0], planes[1], planes[2]}, 1).Clip(0.0f, 255.0f) / 255.0f;
+
+    core::Tensor luma = (planes[0] / 65535.0f).Clip(0.0f, 1.0f);
+    core::Tensor cb   = ((planes[1] - 32768.0f) / 65535.0f).Clip(-0.5f, 0.5f);
+    core::Tensor cr   = ((planes[2] - 32768.0f) / 65535.0f).Clip(-0.5f, 0.5f);
+    core::Tensor rgb8 = core::Concatenate({luma + cr * 1.57480f, luma - cb * 0.18733f - cr * 0.46813f,
+                                           luma + cb * 1.85563f}, 1);
+
+    return (rgb8 * 255.0f).Round().Clip(0.0f, 255.0f) / 255.0f;
+}
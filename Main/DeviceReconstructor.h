@@ -0,0 +1,60 @@
+/*
+ * DeviceReconstructor.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Turns the decoded occupancy, geometry and attribute images of a frame
+ * (PCCDecoderTexturesCallback) into an Open3D tensor point cloud on a
+ * compute device, CUDA:0 when Open3D is built with CUDA: the images and a
+ * small per-patch table are uploaded once, and the per-pixel
+ * reconstruction runs as tensor kernels on the device. The point cloud
+ * stays there, so no PCCPointSet3 and no legacy point cloud are built on
+ * the host for it.
+ *
+ * Each patch maps the canvas linearly to 3D except along its normal axis:
+ * with s = +1 (projection mode 0) or -1 and D1 the patch depth offset,
+ *   position = p0 + ax * x + ay * y + n * max(D1 + s * depth, 0)
+ * where p0, ax and ay fold the orientation, the LoD scales and the U1, V1
+ * offsets of canvasTo3D(), and n is the unit normal axis.
+ *****************************************************************************/
+
+#ifndef DEVICERECONSTRUCTOR_H_
+#define DEVICERECONSTRUCTOR_H_
+
+#include "open3d/Open3D.h"
+#include "PCCDecoder.h"
+
+#include <memory>
+#include <string>
+
+namespace mcnl
+{
+    class DeviceReconstructor
+    {
+        public:
+            /* "auto": CUDA:0 if Open3D has a CUDA device, CPU:0 otherwise */
+            DeviceReconstructor             (const std::string &device = "auto");
+            virtual ~DeviceReconstructor    ();
+
+            const open3d::core::Device& Device  () const;
+
+            std::shared_ptr<open3d::t::geometry::PointCloud>    Reconstruct (const pcc::PCCDecodedTextures &textures);
+
+        private:
+            open3d::core::Device    device;
+
+            template <typename T>
+            open3d::core::Tensor    Upload      (const T *data, const open3d::core::SizeVector &shape,
+                                                 open3d::core::Dtype dtype) const;
+            /* one row per patch: s, D1, ax, ay, p0, n */
+            open3d::core::Tensor    PatchTable  (pcc::PCCFrameContext &tile) const;
+            /* (y * width + x) of the occupied pixels, with their patch index */
+            void                    Occupied    (const pcc::PCCDecodedTextures &textures, open3d::core::Tensor &pixels,
+                                                 open3d::core::Tensor &patches) const;
+            /* colors of the pixels in [0, 1], from a 16-bit YUV or 8-bit RGB 4:4:4 image */
+            open3d::core::Tensor    Colors      (const pcc::PCCImage<uint16_t, 3> &image, const open3d::core::Tensor &pixels,
+                                                 bool rgb) const;
+    };
+}
+
+#endif /* DEVICERECONSTRUCTOR_H_ */
@@ -0,0 +1,54 @@
+/*
+ * FrameConverter.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "FrameConverter.h"
+#include "TaskRuntime.h"
+
+#define CONVERT_GRAIN   (16 << 10)  /* points of a chunk at least, smaller frames convert on the caller */
+
+using namespace mcnl;
+
+static void     Convert     (const PackedCloud &frame, const uint32_t *order, size_t begin, size_t end,
+                             float *positions, float *colors)
+{
+    const bool                      hasColors = frame.HasColors();
+    const int32_t                   *low      = frame.Low();
+
+    for (size_t i = begin; i < end; i++)
+    {
+        const uint32_t k = order != NULL ? order[i] : (uint32_t) i;
+        uint32_t       offset[3];
+
+        frame.Offset(k, offset);
+        positions[3 * i]     = (float) (low[0] + (int32_t) offset[0]);
+        positions[3 * i + 1] = (float) (low[1] + (int32_t) offset[1]);
+        positions[3 * i + 2] = (float) (low[2] + (int32_t) offset[2]);
+
+        if (hasColors)
+        {
+            const uint8_t *color = frame.Color(k);
+
+            colors[3 * i]     = color[0] * (1.0f / 255.0f);
+            colors[3 * i + 1] = color[1] * (1.0f / 255.0f);
+            colors[3 * i + 2] = color[2] * (1.0f / 255.0f);
+        }
+        else
+        {
+            colors[3 * i]     = 1.0f;
+            colors[3 * i + 1] = 1.0f;
+            colors[3 * i + 2] = 1.0f;
+        }
+    }
+}
+
+void    mcnl::ToStaging     (const PackedCloud &frame, const uint32_t *order, size_t count,
+                             float *positions, float *colors, double deadline)
+{
+    TaskRuntime::Instance().ParallelFor(deadline, count, CONVERT_GRAIN,
+                                        [&frame, order, positions, colors](size_t begin, size_t end) {
+        Convert(frame, order, begin, end, positions, colors);
+    });
+}
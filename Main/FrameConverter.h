@@ -0,0 +1,26 @@
+/*
+ * FrameConverter.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Converts decoded V-PCC frames straight into the float32 rows the GPU
+ * takes, so the renderer no longer round-trips every frame through a PLY
+ * file nor through an intermediate Open3D cloud of doubles. The queued
+ * frames are expanded from their PackedCloud form only here, in chunks
+ * on the TaskRuntime; deadline is the pts of the frame.
+ *****************************************************************************/
+
+#ifndef FRAMECONVERTER_H_
+#define FRAMECONVERTER_H_
+
+#include "PackedCloud.h"
+
+namespace mcnl
+{
+    /* the points order[0] .. order[count - 1] of frame, see PointBudget, or its first count
+     * without an order: xyz to positions, rgb in 0..1 to colors, white without colors */
+    void ToStaging      (const PackedCloud &frame, const uint32_t *order, size_t count,
+                         float *positions, float *colors, double deadline = 0);
+}
+
+#endif /* FRAMECONVERTER_H_ */
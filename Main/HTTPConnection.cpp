@@ -10,28 +10,52 @@
  *****************************************************************************/
 
 #include "HTTPConnection.h"
+#include "HostResolver.h"
+
+#include <atomic>
+#if defined(__linux__)
+#include <linux/tcp.h>  /* the glibc tcp_info predates tcpi_delivery_rate */
+#include <stddef.h>
+#endif
 
 using namespace libdashtest;
 using namespace dash::network;
 using namespace dash::metrics;
+using namespace dash::helpers;
+
+static std::atomic<uint32_t> nextTCPId(1);
 
 HTTPConnection::HTTPConnection  () :
-                peekBufferLen   (0),
+                httpSocket      (-1),
+                recvBufferPos   (0),
+                recvBufferLen   (0),
                 contentLength   (0),
+                resourceLength  (-1),
+                isChunked       (false),
+                tcpConnection   (NULL),
                 isInit          (false),
                 isScheduled     (false)
 {
-    this->peekBuffer = new uint8_t[PEEKBUFFER];
+    this->recvBuffer      = new uint8_t[RECVBUFFER];
+    this->response.status = 0;
 }
 HTTPConnection::~HTTPConnection ()
 {
-    delete[] this->peekBuffer;
+    delete[] this->recvBuffer;
     this->CloseSocket();
+
+    for(size_t i = 0; i < this->tcpConnections.size(); i++)
+        delete this->tcpConnections.at(i);
+    for(size_t i = 0; i < this->httpTransactions.size(); i++)
+        delete this->httpTransactions.at(i);
 }
 
 int             HTTPConnection::Read            (uint8_t *data, size_t len, IChunk *chunk)
 {
-    if(this->peekBufferLen == 0)
+    size_t buffered = this->recvBufferLen - this->recvBufferPos;
+
+    /* large reads of an empty buffer go straight to the caller's memory */
+    if(buffered == 0 && len >= RECVBUFFER)
     {
         int size = recv(this->httpSocket, (char *)data, len, 0);
 
@@ -41,19 +65,44 @@ int             HTTPConnection::Read            (uint8_t *data, size_t len, IChu
         return size;
     }
 
-    memcpy(data, this->peekBuffer, this->peekBufferLen);
-    int ret = this->peekBufferLen;
-    this->peekBufferLen = 0;
-    return ret;
+    if(buffered == 0)
+    {
+        if(this->FillBuffer() <= 0)
+            return 0;
+
+        buffered = this->recvBufferLen;
+    }
+
+    /* never hand out more than asked for: on a keep-alive connection the
+     * remaining buffered bytes may already belong to the next response */
+    size_t size = len > buffered ? buffered : len;
+
+    memcpy(data, this->recvBuffer + this->recvBufferPos, size);
+    this->recvBufferPos += size;
+    return size;
 }
 int             HTTPConnection::Peek            (uint8_t *data, size_t len, IChunk *chunk)
 {
-    if(this->peekBufferLen == 0)
-        this->peekBufferLen = this->Read(this->peekBuffer, PEEKBUFFER, chunk);
+    if(this->recvBufferPos == this->recvBufferLen && this->FillBuffer() <= 0)
+        return 0;
 
-    int size = len > this->peekBufferLen ? this->peekBufferLen : len;
+    size_t buffered = this->recvBufferLen - this->recvBufferPos;
+    size_t size     = len > buffered ? buffered : len;
+
+    memcpy(data, this->recvBuffer + this->recvBufferPos, size);
+    return size;
+}
+int             HTTPConnection::FillBuffer      ()
+{
+    /* only called once everything buffered has been consumed */
+    this->recvBufferPos = 0;
+    this->recvBufferLen = 0;
+
+    int size = recv(this->httpSocket, (char *)this->recvBuffer, RECVBUFFER, 0);
+
+    if(size > 0)
+        this->recvBufferLen = size;
 
-    memcpy(data, this->peekBuffer, size);
     return size;
 }
 std::string     HTTPConnection::PrepareRequest  (IChunk *chunk)
@@ -92,16 +141,46 @@ bool            HTTPConnection::Init            (IChunk *chunk)
 }
 bool            HTTPConnection::ParseHeader     ()
 {
+    this->contentLength  = 0;
+    this->resourceLength = -1;
+    this->isChunked      = false;
+
+    this->response.status = 0;
+    this->response.etag.clear();
+    this->response.lastModified.clear();
+    this->response.contentEncoding.clear();
+
     std::string line = this->ReadLine();
     
     if(line.size() == 0)
         return false;
 
+    /* HTTP/1.1 <status> <reason> */
+    if(!line.compare(0, 5, "HTTP/") && line.find(' ') != std::string::npos)
+        this->response.status = atoi(line.substr(line.find(' ') + 1).c_str());
+
     while(line.compare("\r\n"))
     {
         if(!line.compare(0, 14, "Content-Length"))
             this->contentLength = atoi(line.substr(15,line.size()).c_str());
 
+        /* Content-Range: bytes <first>-<last>/<complete length> */
+        if(!line.compare(0, 13, "Content-Range") && line.find('/') != std::string::npos)
+            this->resourceLength = atoll(line.substr(line.find('/') + 1).c_str());
+
+        if(!line.compare(0, 17, "Transfer-Encoding") && line.find("chunked") != std::string::npos)
+            this->isChunked = true;
+
+        /* validators, kept verbatim for If-None-Match / If-Modified-Since */
+        if(!line.compare(0, 5, "ETag:"))
+            this->response.etag = this->HeaderValue(line, 5);
+
+        if(!line.compare(0, 14, "Last-Modified:"))
+            this->response.lastModified = this->HeaderValue(line, 14);
+
+        if(!line.compare(0, 17, "Content-Encoding:"))
+            this->response.contentEncoding = this->HeaderValue(line, 17);
+
         line = this->ReadLine();
 
         if(line.size() == 0)
@@ -110,25 +189,70 @@ bool            HTTPConnection::ParseHeader     ()
 
     return true;
 }
-std::string     HTTPConnection::ReadLine        ()
+std::string     HTTPConnection::HeaderValue     (const std::string &line, size_t nameLength)
 {
-    std::stringstream ss;
-    char c[1];
-    int size = recv(this->httpSocket, c, 1, 0);
+    size_t first = line.find_first_not_of(" \t", nameLength);
+    size_t last  = line.find_last_not_of(" \t\r\n");
 
-    while(size > 0)
-    {
-        ss << c[0];
-        if(c[0] == '\n')
-            break;
+    if(first == std::string::npos || last == std::string::npos || last < first)
+        return "";
 
-        size = recv(this->httpSocket, c, 1, 0);
-    }
+    return line.substr(first, last - first + 1);
+}
+const HTTPResponseInfo& HTTPConnection::LastResponse    () const
+{
+    return this->response;
+}
+bool            HTTPConnection::SampleTCP       (TCPInfoSample &sample)
+{
+#if defined(__linux__)
+    struct tcp_info info;
+    socklen_t       size = sizeof(info);
 
-    if(size > 0)
-        return ss.str();
+    memset(&info, 0, sizeof(info));
+    if(this->httpSocket == -1 || getsockopt(this->httpSocket, IPPROTO_TCP, TCP_INFO, &info, &size) != 0)
+        return false;
 
-    return "";
+    sample.rtt              = info.tcpi_rtt / 1e6;
+    sample.rttVariance      = info.tcpi_rttvar / 1e6;
+    sample.congestionWindow = info.tcpi_snd_cwnd;
+    sample.retransmits      = info.tcpi_total_retrans;
+    /* Linux 4.9 on; an older kernel returns a shorter structure */
+    sample.deliveryRate     = size >= offsetof(struct tcp_info, tcpi_delivery_rate) + sizeof(info.tcpi_delivery_rate) ?
+                              info.tcpi_delivery_rate * 8.0 : 0;
+
+    if(this->tcpConnection != NULL)
+        this->tcpConnection->SetTCPInfo(info.tcpi_rtt, info.tcpi_rttvar, info.tcpi_snd_cwnd, info.tcpi_total_retrans,
+                                        (uint64_t) sample.deliveryRate);
+    return true;
+#else
+    (void) sample;
+    return false;
+#endif
+}
+std::string     HTTPConnection::ReadLine        ()
+{
+    std::string line;
+
+    for(;;)
+    {
+        if(this->recvBufferPos == this->recvBufferLen && this->FillBuffer() <= 0)
+            return "";
+
+        uint8_t *begin = this->recvBuffer + this->recvBufferPos;
+        uint8_t *end   = this->recvBuffer + this->recvBufferLen;
+        uint8_t *eol   = (uint8_t *) memchr(begin, '\n', end - begin);
+
+        if(eol != NULL)
+        {
+            line.append((char *) begin, eol + 1 - begin);
+            this->recvBufferPos += eol + 1 - begin;
+            return line;
+        }
+
+        line.append((char *) begin, end - begin);
+        this->recvBufferPos = this->recvBufferLen;
+    }
 }
 bool            HTTPConnection::SendData        (std::string data)
 {
@@ -143,34 +267,77 @@ bool            HTTPConnection::SendData        (std::string data)
 }
 void            HTTPConnection::CloseSocket     ()
 {
+    if(this->httpSocket == -1)
+        return;
+
+    /* the record keeps how the connection ended */
+    TCPInfoSample last;
+    this->SampleTCP(last);
+
     closesocket(this->httpSocket);
     WSACleanup();
+    this->httpSocket = -1;
+
+    if(this->tcpConnection != NULL)
+        this->tcpConnection->SetConnectionClosedTime(Time::GetUTCTimeStr(Time::GetCurrentUTCTimeInMs()));
+
+    this->tcpConnection = NULL;
 }
 bool            HTTPConnection::ConnectToHost   (std::string host, int port)
 {
     WSADATA info;
 
+    /* whatever was buffered belonged to the previous socket */
+    this->CloseSocket();
+    this->recvBufferPos = 0;
+    this->recvBufferLen = 0;
+
     if(WSAStartup(MAKEWORD(2,0), &info))
       return false;
 
-    this->httpSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    /* cached, see HostResolver; the first connect to a host may wait for its lookup */
+    std::vector<ResolvedAddress> addresses = HostResolver::Instance().Resolve(host, port);
 
-    memset(&this->addr, 0, sizeof(this->addr));
+    uint64_t opened         = Time::GetCurrentUTCTimeInMs();
+    size_t   next           = 0;
 
-    this->hostent           = gethostbyname(host.c_str());
-    this->addr.sin_family   = AF_INET;
-    this->addr.sin_port     = htons(port);
-    int result              = 0;
-    char **p                = this->hostent->h_addr_list;
-    do
+    for(; next < addresses.size(); next++)
     {
-        if(*p == NULL)
-            return false;
+        const ResolvedAddress &address = addresses.at(next);
+
+        this->httpSocket = socket(address.family, SOCK_STREAM, IPPROTO_TCP);
+        if(this->httpSocket == -1)
+            continue;
 
-        addr.sin_addr.s_addr    = *reinterpret_cast<unsigned long*>(*p);
-        result                  = connect(this->httpSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        if(connect(this->httpSocket, reinterpret_cast<const sockaddr*>(&address.address), address.length) == 0)
+            break;
 
-    }while(result == 1);
+        closesocket(this->httpSocket);
+        this->httpSocket = -1;
+    }
+
+    if(this->httpSocket == -1)
+    {
+        WSACleanup();
+        return false;
+    }
+
+    char numericHost[NI_MAXHOST] = "";
+    getnameinfo(reinterpret_cast<const sockaddr*>(&addresses.at(next).address), addresses.at(next).length,
+                numericHost, sizeof(numericHost), NULL, 0, NI_NUMERICHOST);
+
+    std::stringstream destination;
+    if(addresses.at(next).family == AF_INET6)
+        destination << "[" << numericHost << "]:" << port;
+    else
+        destination << numericHost << ":" << port;
+
+    this->tcpConnection = new TCPConnection();
+    this->tcpConnection->SetTCPId(nextTCPId++);
+    this->tcpConnection->SetDestinationAddress(destination.str());
+    this->tcpConnection->SetConnectionOpenedTime(Time::GetUTCTimeStr(opened));
+    this->tcpConnection->SetConnectionTime(Time::GetCurrentUTCTimeInMs() - opened);
+    this->tcpConnections.push_back(this->tcpConnection);
 
     return true;
 }
@@ -0,0 +1,75 @@
+/*
+ * HostResolver.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Host name lookups for every HTTPConnection, in place of a blocking,
+ * thread-unsafe gethostbyname per socket. Lookups run with getaddrinfo on
+ * one resolver thread and their addresses (IPv4 and IPv6) are cached for
+ * HOST_RESOLVER_TTL seconds. Prefetch() starts a lookup without waiting,
+ * e.g. for the MPD host at start; Resolve() waits only for a host that was
+ * never resolved. An expired entry is still handed out while it is looked
+ * up again, so after the first lookup no connect waits for the DNS.
+ *****************************************************************************/
+
+#ifndef HOSTRESOLVER_H_
+#define HOSTRESOLVER_H_
+
+#include "../libdash/source/portable/Networking.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#define HOST_RESOLVER_TTL   60  /* seconds an answer is used without looking it up again */
+
+namespace libdashtest
+{
+    struct ResolvedAddress
+    {
+        sockaddr_storage    address;
+        socklen_t           length;
+        int                 family;
+    };
+
+    class HostResolver
+    {
+        public:
+            static HostResolver&    Instance    ();
+
+            void        Prefetch    (const std::string &host, int port);
+            /* in the order getaddrinfo gave them; empty if the host is unknown */
+            std::vector<ResolvedAddress>    Resolve (const std::string &host, int port);
+
+        private:
+            struct Entry
+            {
+                std::vector<ResolvedAddress>    addresses;
+                uint64_t                        resolvedAt;     /* ms, 0 before the first answer */
+                bool                            pending;        /* queued or being looked up */
+                bool                            failed;         /* the last lookup found nothing */
+            };
+
+            std::mutex                      mutex;
+            std::condition_variable         queued;
+            std::condition_variable         answered;
+            std::map<std::string, Entry>    entries;    /* by host:port */
+            std::deque<std::string>         queue;
+            bool                            stopping;
+            std::thread                     thread;
+
+            HostResolver            ();
+            virtual ~HostResolver   ();
+
+            void        Work        ();
+            /* with the lock held; queues the lookup unless one is under way */
+            Entry&      Lookup      (const std::string &key);
+    };
+}
+
+#endif /* HOSTRESOLVER_H_ */
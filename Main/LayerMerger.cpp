@@ -0,0 +1,156 @@
+/*
+ * LayerMerger.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "LayerMerger.h"
+
+using namespace mcnl;
+
+#define V3C_UNIT_HEADER_SIZE    4
+#define NAL_SIZE_PRECISION      4
+
+namespace
+{
+    struct LayerNal
+    {
+        uint32_t        position;
+        uint32_t        size;
+        const uint8_t   *data;
+    };
+    struct LayerRecord
+    {
+        uint32_t                unit;
+        std::vector<LayerNal>   nals;
+    };
+
+    uint64_t    ReadSize    (const uint8_t *data, size_t bytes)
+    {
+        uint64_t size = 0;
+
+        for (size_t i = 0; i < bytes; i++)
+            size = (size << 8) | data[i];
+        return size;
+    }
+    void        WriteSize   (std::vector<uint8_t> &out, uint64_t size, size_t bytes)
+    {
+        for (size_t i = bytes; i > 0; i--)
+            out.push_back((uint8_t) (size >> (8 * (i - 1))));
+    }
+    bool        ReadRecords (const std::vector<uint8_t> &layer, std::vector<LayerRecord> &records)
+    {
+        size_t pos = 0;
+
+        while (pos < layer.size())
+        {
+            if (layer.size() - pos < 8)
+                return false;
+
+            LayerRecord record;
+            uint32_t    count = (uint32_t) ReadSize(layer.data() + pos + 4, 4);
+
+            record.unit = (uint32_t) ReadSize(layer.data() + pos, 4);
+            pos += 8;
+            if (!records.empty() && record.unit <= records.back().unit)
+                return false;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                LayerNal nal;
+
+                if (layer.size() - pos < 8)
+                    return false;
+                nal.position = (uint32_t) ReadSize(layer.data() + pos, 4);
+                nal.size     = (uint32_t) ReadSize(layer.data() + pos + 4, 4);
+                nal.data     = layer.data() + pos + 8;
+                pos += 8;
+                if (layer.size() - pos < nal.size || (!record.nals.empty() && nal.position < record.nals.back().position))
+                    return false;
+                pos += nal.size;
+                record.nals.push_back(nal);
+            }
+            records.push_back(record);
+        }
+
+        return true;
+    }
+}
+
+bool    mcnl::MergeLayer        (std::vector<uint8_t> &segment, const std::vector<uint8_t> &layer)
+{
+    std::vector<LayerRecord> records;
+
+    if (segment.empty() || !ReadRecords(layer, records))
+        return false;
+    if (records.empty())
+        return true;
+
+    size_t                  precision = (segment[0] >> 5) + 1;
+    uint64_t                maxSize   = precision >= 8 ? UINT64_MAX : (1ull << (8 * precision)) - 1;
+    size_t                  pos       = 1;
+    size_t                  next      = 0;
+    std::vector<uint8_t>    merged;
+
+    merged.reserve(segment.size() + layer.size());
+    merged.push_back(segment[0]);
+
+    for (uint32_t index = 0; pos < segment.size(); index++)
+    {
+        if (segment.size() - pos < precision)
+            return false;
+
+        uint64_t size = ReadSize(segment.data() + pos, precision);
+
+        pos += precision;
+        if (segment.size() - pos < size)
+            return false;
+
+        const uint8_t *unit = segment.data() + pos;
+
+        pos += size;
+        if (next == records.size() || records.at(next).unit != index)
+        {
+            WriteSize(merged, size, precision);
+            merged.insert(merged.end(), unit, unit + size);
+            continue;
+        }
+
+        /* vuh_unit_type: V3C_OVD, V3C_GVD, V3C_AVD */
+        if (size < V3C_UNIT_HEADER_SIZE || (unit[0] >> 3) < 2 || (unit[0] >> 3) > 4)
+            return false;
+
+        const std::vector<LayerNal> &nals = records.at(next++).nals;
+        std::vector<uint8_t>        video(unit, unit + V3C_UNIT_HEADER_SIZE);
+        size_t                      inserted = 0;
+        uint32_t                    count    = 0;
+
+        for (size_t at = V3C_UNIT_HEADER_SIZE; at <= size; count++)
+        {
+            for (; inserted < nals.size() && nals.at(inserted).position == count; inserted++)
+            {
+                WriteSize(video, nals.at(inserted).size, NAL_SIZE_PRECISION);
+                video.insert(video.end(), nals.at(inserted).data, nals.at(inserted).data + nals.at(inserted).size);
+            }
+            if (at == size)
+                break;
+            if (size - at < NAL_SIZE_PRECISION || size - at - NAL_SIZE_PRECISION < ReadSize(unit + at, NAL_SIZE_PRECISION))
+                return false;
+
+            size_t end = at + NAL_SIZE_PRECISION + ReadSize(unit + at, NAL_SIZE_PRECISION);
+
+            video.insert(video.end(), unit + at, unit + end);
+            at = end;
+        }
+        if (inserted < nals.size() || video.size() > maxSize)
+            return false;
+
+        WriteSize(merged, video.size(), precision);
+        merged.insert(merged.end(), video.begin(), video.end());
+    }
+    if (next < records.size())
+        return false;
+
+    segment.swap(merged);
+    return true;
+}
@@ -0,0 +1,27 @@
+/*
+ * LayerMerger.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Puts the SHVC enhancement layers of a layered content (see
+ * packager/LayerSplitter.h for the format) back into the video units of
+ * the segment of its base layer. Each NAL unit goes back to the position it
+ * had in the encoder's segment, so the merged segment decodes as if the
+ * layers above the last one merged had never been there.
+ *****************************************************************************/
+
+#ifndef LAYERMERGER_H_
+#define LAYERMERGER_H_
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mcnl
+{
+    /* segment holds the base and layers 1..k-1 already, layer is layer k;
+     * false, with segment left as it was, if they do not fit together */
+    bool    MergeLayer  (std::vector<uint8_t> &segment, const std::vector<uint8_t> &layer);
+}
+
+#endif /* LAYERMERGER_H_ */
@@ -6,22 +6,46 @@
 #include <atomic>
 #include <chrono>
 #include <mutex>
-#include <random>
 #include <thread>
 #include <vector>
 #include <experimental/filesystem>
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <deque>
+#include <functional>
 #include "open3d/Open3D.h"
 #include "libdash.h"
 #include "TestChunk.h"
 #include "PersistentHTTPConnection.h"
+#include "SegmentFetcher.h"
+#include "SegmentPrefetcher.h"
+#include "LayerMerger.h"
+#include "AbrController.h"
+#include "VpccDecoder.h"
+#include "DecodeScheduler.h"
+#include "DecodePool.h"
+#include "BandwidthAllocator.h"
+#include "PostProcessingGovernor.h"
+#include "CoreController.h"
+#include "PresentationClock.h"
+#include "SpscRing.h"
+#include "Tracer.h"
+#include "SegmentTelemetry.h"
+#include "TileSelector.h"
+#include "PointBudget.h"
+#include "CloudBuffer.h"
+#include "NetworkProfile.h"
+#include "TestServer.h"
+#include "StreamingReport.h"
+#include "MetricsRegistry.h"
+#include "MetricsServer.h"
+#include "TaskRuntime.h"
+#include "ThreadPlacement.h"
 
 #include <fstream>
 #include <pthread.h>
 #include <cstring>
-#include <semaphore.h>
 #include <cstdlib>
 #include <sys/wait.h>
 #include <sys/stat.h>
@@ -34,7 +58,6 @@
 #include "IMPD.h"
 #include "INode.h"
 
-#define BUF_SIZE 10
 using namespace open3d;
 using namespace open3d::visualization;
 using namespace std;
@@ -42,80 +65,240 @@ using namespace dash;
 using namespace dash::network;
 using namespace libdashtest;
 using namespace dash::mpd;
+using namespace mcnl;
 
-string PATH;
+string PATH; // --path, asked for on stdin otherwise
+string mpd_host = "203.252.121.219"; // --origin host[:port], or the --serve test server
+size_t mpd_port = 80;
+string base_url; // --baseURL, e.g. a LAN edge cache; the MPD's own BaseURL otherwise
+const char *MPD_PATH = "/video/loot.mpd";
 const int WIDTH = 1024;
 const int HEIGHT = 1024;
 const int PLY_COUNT_PER_BIN = 10; // 10 15 30 = frame
 const int PLY_PER_DIRECTORY = 5; // 10 or 15
-const int BIN_COUNT = 10; // 10 Fix
+const int BIN_COUNT = 10; // 10 Fix, static MPDs only; live ones run until the MPD ends
 
 const Eigen::Vector3f CENTER_OFFSET(0.0f, 0.0f, -3.0f);
 const std::string CLOUD_NAME = "points";
 void error_handling(char* message);
 
-typedef struct {
-	sem_t filled;
-	sem_t empty;
-	pthread_mutex_t lock;
-	char ** elem;
-	int capacity;
-	int num;
-	int front;
-	int rear;
-} bounded_buffer;
-
-bounded_buffer * buf1 = 0x0;
-bounded_buffer * buf2 = 0x0;
-
-void bounded_buffer_init(bounded_buffer * buf, int capacity) {
-	sem_init(&(buf->filled), 0, 0);
-	sem_init(&(buf->empty), 0, capacity);
-	pthread_mutex_init(&(buf->lock), 0x0);
-	buf->capacity = capacity;
-	buf->elem = (char **) calloc(sizeof(char *), capacity);
-	buf->num = 0;
-	buf->front = 0;
-	buf->rear = 0;
+const size_t SEGMENT_QUEUE_SIZE = 128;
+size_t prefetch_window = 2; // downloads in flight ahead of the decoder, argv[2]
+const size_t MAX_BUFFERED_SEGMENTS = 4; // queued for decode + in flight
+AbrPolicyType abr_policy = ABR_HYBRID; // throughput | bola | hybrid, argv[3]
+const size_t RANGE_PARTS = 3; // large segments are fetched as parallel byte ranges, 1 = off
+const bool TEE_SEGMENTS = false; // also write downloaded segments to disk, for debugging
+HTTPVersion http_transport = HTTP_VERSION_1_1; // --transport; HTTP_VERSION_2 multiplexes MPD and segments on one connection, HTTP_VERSION_3 over QUIC
+const char *INDEX_CACHE = "./mcnl.index"; // segment index of static MPDs, revalidated in the background; "" = off
+const char *FAST_START_FILE = "./mcnl.start"; // first segment of the last session, fetched along with the MPD when there is no index to start from; "" = off
+const char *SEGMENT_CACHE_DIR = "./mcnl.segments"; // segments of static MPDs kept for the next session, revalidated by ETag; "" = this session only
+const size_t SEGMENT_CACHE_DISK_BYTES = (size_t) 1 << 30; // of segments in SEGMENT_CACHE_DIR, least recently used dropped first
+const size_t SEGMENT_CACHE_MEMORY_BYTES = 128 << 20; // of segments held in memory for replays; 0 with no SEGMENT_CACHE_DIR = off
+const double FAST_START_BUFFER = 1.0; // seconds buffered on the lowest representation before ABR may raise the quality; 0 = from the first download
+const char *METRICS_FILE = "./timeLog/metrics.txt"; // per-request DASH metrics (TTFB, throughput trace)
+const double METRICS_DUMP_INTERVAL = 5.0; // seconds between appends to METRICS_FILE
+const bool TRACE_ENABLE = true; // record fetch/decode/render stages per segment and frame
+const char *TRACE_FILE = "./timeLog/trace.json"; // Chrome trace JSON, open in ui.perfetto.dev or chrome://tracing
+const char *TELEMETRY_FILE = ""; // per-segment bytes, decode time, points and peak memory, CSV or .json; "" = off
+const size_t TELEMETRY_QUALITY_EVERY = 0; // compare every n-th segment with TELEMETRY_REFERENCE, 0 = off
+const char *TELEMETRY_REFERENCE = ""; // source PLY by frame number, e.g. "/data/loot/loot_vox10_%04d.ply", or a PccAppIngest frame cache
+const size_t TELEMETRY_FIRST_FRAME = 1000; // number of the first source PLY
+const bool PROGRESSIVE_DECODE = true; // decode each GOF while the rest of its segment is still downloading
+const size_t DECODE_WORKERS = 2; // segments decoded side by side while several are buffered; 1 = one at a time, forced by TELEMETRY_FILE
+const size_t DECODE_MEMORY_BUDGET = 512 << 20; // bytes of decoded frames held for the segments ahead of theirs
+const size_t SEGMENT_BUFFER_BYTES = 64 << 20; // per object: segments downloading or queued for decode, as their bandwidth says; 0 = counted in segments only
+const size_t FRAME_BUFFER_BYTES = 256 << 20; // decoded frames queued for the renderer, shared by the objects of a scene; 0 = counted in frames only
+const bool ADAPTIVE_POST_PROCESSING = true; // smoothing and occupancy synthesis step down while frames risk being late; false = as signalled
+const bool ADAPTIVE_CORES = true; // as few TaskRuntime threads decode as keep the frame queue from running dry, see CoreController; false = all of --nbThread
+const double CORE_CONTROL_INTERVAL = 0.5; // seconds between two ticks of the CoreController
+const bool VIEW_DEPENDENT = true; // tiled MPDs: fetch only the tiles in view, nearer ones at higher quality; false = all tiles
+const int32_t SCENE_OBJECT_SPACING = 1024; // points between the --object clouds placed without a position, along x
+const size_t FRAME_QUEUE_SIZE = 128;
+const bool LEVEL_OF_DETAIL = true; // draw no more points than the cloud covers on screen and the frame time allows
+const double RENDER_FRAME_TARGET = 1.0 / 72; // seconds of geometry upload per frame the point budget aims at; 0 = no limit
+bool headless = false; // --headless: frames are paced and converted but not drawn, no Open3D window
+const char *BENCHMARK_REPORT = "./timeLog/benchmark.txt"; // written by --headless runs, --report overrides
+StreamingReport streaming_report; // startup delay, stalls, quality and stage latencies of the session
+const size_t METRICS_PORT = 0; // GET /metrics in the Prometheus text format, --metrics PORT; 0 = off
+// cores and priority per stage, see ThreadPlacement.h; unset = where and as the OS schedules them
+ThreadPlacement render_placement; // --renderThread, the UI/render thread and the ones it starts
+ThreadPlacement network_placement; // --networkThreads, the fetch threads and their downloads
+ThreadPlacement decode_placement; // --decodeThreads, the decode threads and the workers of the TaskRuntime
+
+// live view of the pipeline, for --metrics; the queues' depths and waits are read when scraped
+struct PipelineMetrics {
+	MetricGauge &bufferLevel = Gauge("mcnl_buffer_level_seconds", "Media buffered ahead of the renderer when the last segment arrived");
+	MetricGauge &representation = Gauge("mcnl_representation", "Representation, or quality level of the tiles, of the next request");
+	MetricGauge &throughput = Gauge("mcnl_download_throughput_bps", "Throughput of the last downloaded segment");
+	MetricGauge &abrEstimate = Gauge("mcnl_abr_throughput_estimate_bps", "Throughput the ABR controller expects");
+	MetricCounter &downloadedBytes = Counter("mcnl_downloaded_bytes_total", "Bytes of the downloaded segments");
+	MetricCounter &segments = Counter("mcnl_downloaded_segments_total", "Downloaded segments, or tiles of one");
+	MetricHistogram &downloadSeconds = MetricsRegistry::Instance().Histogram("mcnl_download_seconds",
+		"Download time of a segment", {0.05, 0.1, 0.25, 0.5, 1, 2, 5, 10});
+	MetricHistogram &decodeSeconds = MetricsRegistry::Instance().Histogram("mcnl_decode_seconds",
+		"Wall time of the decode of a segment", {0.05, 0.1, 0.25, 0.5, 1, 2, 5, 10});
+	MetricCounter &decodeErrors = Counter("mcnl_decode_errors_total", "Segments the decoder failed on");
+	MetricCounter &presented = Counter("mcnl_frames_presented_total", "Frames shown");
+	MetricCounter &dropped = Counter("mcnl_frames_dropped_total", "Frames dropped late by the presentation clock");
+	MetricGauge &renderFps = Gauge("mcnl_render_fps", "Frames shown over the last second");
+	MetricGauge &postProcessing = Gauge("mcnl_post_processing_level", "Post-processing of the last decoded frame: 0 full, 1 reduced, 2 none");
+	MetricGauge &decodeThreads = Gauge("mcnl_decode_threads", "Threads of the task runtime left to decode by the core controller");
+	MetricHistogram &convertSeconds = MetricsRegistry::Instance().Histogram("mcnl_render_convert_seconds",
+		"Conversion and staging of a frame for the renderer", {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25});
+
+	// render thread only
+	void OnPresent() {
+		presented.Add();
+		fpsFrames++;
+		auto now = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(now - fpsStart).count();
+		if(seconds >= 1) {
+			renderFps.Set(fpsFrames / seconds);
+			fpsFrames = 0;
+			fpsStart = now;
+		}
+	}
+
+private:
+	static MetricGauge &Gauge(const char *name, const char *help) { return MetricsRegistry::Instance().Gauge(name, help); }
+	static MetricCounter &Counter(const char *name, const char *help) { return MetricsRegistry::Instance().Counter(name, help); }
+	size_t fpsFrames = 0;
+	std::chrono::steady_clock::time_point fpsStart = std::chrono::steady_clock::now();
+};
+PipelineMetrics pipeline_metrics;
+
+// decode -> render, one producer and one consumer; with several objects the compositor is the producer
+SpscRing<std::unique_ptr<DecodedFrame>> buf2(FRAME_QUEUE_SIZE);
+
+// one streamed object of the scene, with its own MPD, ABR and decode state
+struct ObjectStream {
+	size_t index = 0;
+	string mpdPath;
+	int32_t offset[3] = {0, 0, 0}; // placement in the scene, in points
+	// fetch -> decode, one producer and one consumer
+	SpscRing<std::unique_ptr<SegmentInfo>> segments{SEGMENT_QUEUE_SIZE};
+	// decode -> compositor; buf2 itself when the scene is this one object
+	SpscRing<std::unique_ptr<DecodedFrame>> *frames = &buf2;
+	std::unique_ptr<SpscRing<std::unique_ptr<DecodedFrame>>> ownFrames;
+	PostProcessingGovernor postProcessing; // slack of the frame queue, post-processing level for the decoder
+	DecodeCostModel decodeCost; // decode time per representation, fed back to ABR
+	TileSelector tiles; // camera from the renderer, tiles of the next segment for the fetcher
+	std::atomic<double> segmentDuration{0}; // seconds, set by the fetch thread before its first segment
+	std::atomic<double> decodedFrameRate{0}; // of the last segment decoded, lower for a lower frame rate representation
+
+	// decoded and not shown yet
+	size_t QueuedFrames() const { return frames->Size() + (frames != &buf2 ? buf2.Size() : 0); }
+	// seconds the queued frames play for, at the frame rate of the last segment decoded or else frameRate
+	double QueuedSeconds(double frameRate) const {
+		double rate = decodedFrameRate.load();
+		return QueuedFrames() / (rate > 0 ? rate : frameRate);
+	}
+};
+// the positional MPD first, then every --object; fixed once the threads start
+std::vector<std::unique_ptr<ObjectStream>> scene;
+// shared by the objects of a scene of several: decode slots by deadline (all CPU work shares the TaskRuntime), the split of the link,
+// and the HTTP/1.1 connections with the DASH metrics of their requests
+std::unique_ptr<DecodePool> decode_pool;
+std::unique_ptr<BandwidthAllocator> bandwidth_allocator;
+MetricsLog scene_metrics; // before scene_connections, which reports to it
+std::shared_ptr<ConnectionPool> scene_connections;
+std::shared_ptr<SegmentCache> segment_cache; // shared by every object, NULL if off
+
+// frames of a segment at frameRate: PLY_COUNT_PER_BIN at the full frame rate, fewer in a representation of a lower
+// one (temporal scalability), whose segments last as long
+size_t frames_per_segment(double frameRate, double segmentDuration) {
+	if(frameRate <= 0 || segmentDuration <= 0)
+		return PLY_COUNT_PER_BIN;
+	return std::max(1L, lround(frameRate * segmentDuration));
 }
 
-void bounded_buffer_queue(bounded_buffer * buf, char * msg) {
-	sem_wait(&(buf->empty));
-	pthread_mutex_lock(&(buf->lock));
-		buf->elem[buf->rear] = msg;
-		buf->rear = (buf->rear + 1) % buf->capacity;
-		buf->num += 1;
-	pthread_mutex_unlock(&(buf->lock));
-	sem_post(&(buf->filled));
+// path with ".suffix" ahead of its extension, e.g. the log of another object
+string suffixed_path(const string &path, const string &suffix) {
+	if(path.empty())
+		return path;
+	size_t dot = path.rfind('.');
+	size_t slash = path.rfind('/');
+	if(dot == string::npos || (slash != string::npos && dot < slash))
+		return path + "." + suffix;
+	return path.substr(0, dot) + "." + suffix + path.substr(dot);
+}
+// the file of the first object is named as without a scene
+string object_path(const string &path, const ObjectStream &object) {
+	return object.index == 0 ? path : suffixed_path(path, to_string(object.index));
 }
 
-char * bounded_buffer_dequeue(bounded_buffer * buf) {
-	char * r = 0x0;
-	
-	sem_wait(&(buf->filled));
-	pthread_mutex_lock(&(buf->lock));
-		r = buf->elem[buf->front];
-		buf->front = (buf->front + 1) % buf->capacity;
-		buf->num -= 1;
-	pthread_mutex_unlock(&(buf->lock));
-	sem_post(&(buf->empty));
-	return r;
+// depth and back-pressure of one queue, set when the registry is scraped
+void collect_ring_metrics(const string &name, std::function<RingStats ()> stats, std::function<size_t ()> size) {
+	MetricsRegistry &registry = MetricsRegistry::Instance();
+	string prefix = "mcnl_" + name;
+	MetricGauge &depth = registry.Gauge(prefix + "_depth", string("Entries in the ") + name);
+	MetricGauge &highWater = registry.Gauge(prefix + "_high_water", string("Most entries seen in the ") + name);
+	MetricGauge &bytes = registry.Gauge(prefix + "_bytes", string("Bytes of the entries in the ") + name);
+	MetricCounter &producerWaits = registry.Counter(prefix + "_producer_waits_total", string("Pushes that found the ") + name + " full");
+	MetricCounter &consumerWaits = registry.Counter(prefix + "_consumer_waits_total", string("Pops that found the ") + name + " empty");
+	registry.OnCollect([=, &depth, &highWater, &bytes, &producerWaits, &consumerWaits]() {
+		RingStats now = stats();
+		depth.Set(size());
+		highWater.Set(now.highWater);
+		bytes.Set(now.bytes);
+		producerWaits.Add(now.producerWaits - producerWaits.Value());
+		consumerWaits.Add(now.consumerWaits - consumerWaits.Value());
+	});
 }
 
-void download(IConnection *connection, IChunk *chunk, ofstream *file)
-{
-	int len = 32768;
-	uint8_t *p_data = new uint8_t[32768];
+void log_ring_stats(std::ofstream &writeFile, const char *name, const RingStats &stats) {
+	writeFile << name << " pushed " << stats.pushed << " popped " << stats.popped << " high-water " << stats.highWater
+		<< " high-water-bytes " << stats.highWaterBytes << " producer-waits " << stats.producerWaits
+		<< " consumer-waits " << stats.consumerWaits << "\n";
+}
 
-	int ret = 0;
-	do
-	{
-		ret = connection->Read(p_data, len, chunk);
-		if(ret > 0)
-			file->write((char *)p_data, ret);
-	}while(ret > 0);
+// into a frame queue, which waits while the frames queued hold its byte budget
+bool push_frame(SpscRing<std::unique_ptr<DecodedFrame>> &frames, std::unique_ptr<DecodedFrame> frame) {
+	size_t bytes = DecodeScheduler::FrameBytes(*frame);
+	return frames.Push(std::move(frame), bytes);
 }
 
+// the points of decoded join merged, which keeps its timing
+void merge_frame(DecodedFrame &merged, std::unique_ptr<DecodedFrame> decoded) {
+	if(merged.deviceCloud && decoded->deviceCloud)
+		merged.deviceCloud = std::make_shared<t::geometry::PointCloud>(merged.deviceCloud->Append(*decoded->deviceCloud));
+	else if(!merged.deviceCloud && !decoded->deviceCloud)
+		merged.points.Append(decoded->points);
+	// a cloud reconstructed on the device does not join one reconstructed on the host, it is left out of this frame
+}
+
+// frame index of one tile's segment joins the same frame of the tiles decoded before it
+void merge_tile_frame(std::vector<std::unique_ptr<DecodedFrame>> &frames, size_t index, std::unique_ptr<DecodedFrame> decoded) {
+	if(index >= frames.size()) {
+		frames.push_back(std::move(decoded));
+		return;
+	}
+	merge_frame(*frames[index], std::move(decoded));
+}
+
+// moves a frame of object to its place in the scene, and tells the bandwidth split where it is
+void place_object_frame(const ObjectStream &object, DecodedFrame &frame) {
+	double center[3], radius;
+	if(frame.deviceCloud) {
+		if(object.offset[0] != 0 || object.offset[1] != 0 || object.offset[2] != 0) {
+			// the decoder may still hold the cloud it handed on
+			auto placed = std::make_shared<t::geometry::PointCloud>(frame.deviceCloud->Clone());
+			placed->Translate(core::Tensor::Init<float>({(float) object.offset[0], (float) object.offset[1],
+					(float) object.offset[2]}, placed->GetDevice()));
+			frame.deviceCloud = placed;
+		}
+		geometry::AxisAlignedBoundingBox box = frame.deviceCloud->GetAxisAlignedBoundingBox().ToLegacy();
+		Eigen::Vector3d boxCenter = box.GetCenter();
+		std::copy(boxCenter.data(), boxCenter.data() + 3, center);
+		radius = box.GetExtent().norm() / 2;
+	}
+	else {
+		frame.points.Translate(object.offset);
+		BoundingSphere(frame.points, center, radius);
+	}
+	if(bandwidth_allocator)
+		bandwidth_allocator->SetBounds(object.index, center, radius);
+}
 
 class MultipleWindowsApp {
 	public:
@@ -153,14 +336,18 @@ class MultipleWindowsApp {
 					HEIGHT);
 
 			geometry::AxisAlignedBoundingBox bounds;
-			{
-				std::lock_guard<std::mutex> lock(cloud_lock_);
+			std::shared_ptr<const RenderFrame> shown = presented_;
+			if (shown && shown->staged) {
 				auto mat = rendering::MaterialRecord();
 				mat.shader = "defaultUnlit";
+				// a copy of the points shown, without the padding of the staging buffer, which is reused
+				auto cloud = std::make_shared<t::geometry::PointCloud>(
+						shown->staged->GetPointPositions().Slice(0, 0, shown->points).Clone());
+				cloud->SetPointColors(shown->staged->GetPointColors().Slice(0, 0, shown->points).Clone());
 				new_vis->AddGeometry(
-						CLOUD_NAME + " #" + std::to_string(n_snapshots_), cloud_,
+						CLOUD_NAME + " #" + std::to_string(n_snapshots_), cloud,
 						&mat);
-				bounds = cloud_->GetAxisAlignedBoundingBox();
+				bounds = cloud->GetAxisAlignedBoundingBox().ToLegacy();
 			}
 
 			new_vis->ResetCameraToDefault();
@@ -177,6 +364,8 @@ class MultipleWindowsApp {
 			// Ensure object is free so Filament can clean up without crashing.
 			// Also signals to the "reading" thread that it is finished.
 			main_vis_.reset();
+			// and wakes it if it waits for a frame
+			buf2.Close();
 			return true;  // false would cancel the close
 		}
 
@@ -184,83 +373,156 @@ class MultipleWindowsApp {
 		void ReadThreadMain() {
 			// This is NOT the UI thread, need to call PostToMainThread() to
 			// update the scene or any part of the UI.
-			geometry::AxisAlignedBoundingBox bounds;
-			char * msg;	
+			Tracer::Instance().NameThread("render");
+			std::unique_ptr<DecodedFrame> frame;
+			PresentationClock presentation;
 			int cnt = 0;
+			uint64_t ticket = 0; // of the last upload posted
 			std::ofstream writeFile;
 			writeFile.open("./timeLog/open3d.txt");
 			
-			while (main_vis_) {
-				msg = bounded_buffer_dequeue(buf2);
-				std::string full_path = string(msg);
-				std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-				
-				Eigen::Vector3d extent;
-				{
-					std::lock_guard<std::mutex> lock(cloud_lock_);
-					cloud_ = std::make_shared<geometry::PointCloud>();
-					io::ReadPointCloudFromPLY(full_path, *cloud_, {"auto",false,false,false,{}});
-					bounds = cloud_->GetAxisAlignedBoundingBox();
-					extent = bounds.GetExtent();
+			while (main_vis_ && buf2.Pop(frame)) {
+				cnt++;
+
+				// late frames are skipped and the previous cloud stays on screen
+				if (presentation.Admit(frame->pts, frame->frameRate) == DROP_FRAME) {
+					frame.reset();
+					pipeline_metrics.dropped.Add();
+					writeFile << "OPEN-3D drop frame " << cnt << "\n";
 				}
+				else {
+					std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+					int64_t segmentNumber = frame->segmentNumber;
+					int64_t frameId = frame->frameId;
+					double pts = frame->pts;
 
-				
-				auto mat = rendering::MaterialRecord();
-				mat.shader = "defaultUnlit";
+					// staged ahead of its presentation time, while the frame before is still shown; built here,
+					// then handed to the UI thread whole, no other thread writes to it
+					std::shared_ptr<RenderFrame> next = std::make_shared<RenderFrame>();
+					{
+						TraceScope trace("convert", "render", segmentNumber, frameId);
+						if (frame->deviceCloud) {
+							// reconstructed on the device, shown as it is
+							next->staged = cloud_buffer_.Stage(*frame->deviceCloud);
+							next->points = frame->deviceCloud->HasPointPositions() ?
+								frame->deviceCloud->GetPointPositions().GetLength() : 0;
+						}
+						else {
+							size_t count = frame->points.Size();
+							size_t budget = count;
+							if (LEVEL_OF_DETAIL) {
+								double center[3], radius;
+								BoundingSphere(frame->points, center, radius);
+								budget = point_budget_.Budget(center, radius, count);
+							}
+							// only a uniform subsample of the points is uploaded
+							next->staged = cloud_buffer_.Stage(frame->points,
+									budget < count ? morton_.Compute(frame->points).data() : NULL, budget, pts);
+							next->points = budget;
+							next->budgeted = true;
+						}
+					}
+					pipeline_metrics.convertSeconds.Observe(std::chrono::duration<double>(
+							std::chrono::system_clock::now() - start).count());
+					frame.reset();
+
+					auto mat = rendering::MaterialRecord();
+					mat.shader = "defaultUnlit";
 
-				gui::Application::GetInstance().PostToMainThread(
-						main_vis_.get(), [this, bounds, mat]() {
-						std::lock_guard<std::mutex> lock(cloud_lock_);
-						main_vis_->RemoveGeometry(CLOUD_NAME);
-						main_vis_->AddGeometry(CLOUD_NAME, cloud_, &mat);
-							
-						//main_vis_->ResetCameraToDefault();
-						//Eigen::Vector3f center = bounds.GetCenter().cast<float>();
-						//main_vis_->SetupCamera(60, center, center + CENTER_OFFSET,
-						//		{0.0f, -1.0f, 0.0f});
-						});
-
-				Eigen::Vector3d magnitude = 0.005 * extent;
-				auto seed = std::random_device()();
-				std::mt19937 gen_algo(seed);
-				std::uniform_real_distribution<> random(-0.5, 0.5);
-
-				std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-
-				// Perturb the cloud with a random walk to simulate an actual read
-				{
-					std::lock_guard<std::mutex> lock(cloud_lock_);
-					for (size_t i = 0; i < cloud_->points_.size(); ++i) {
-						Eigen::Vector3d perturb(magnitude[0] * random(gen_algo),
-								magnitude[1] * random(gen_algo),
-								magnitude[2] * random(gen_algo));
-						cloud_->points_[i] = perturb;
+					// the fence: the frame before is on screen, so its upload no longer holds the hidden renderable
+					// and the UI thread has no upload queued
+					while (ticket > 0 && main_vis_ && !cloud_buffer_.Wait(ticket, 0.1)) {
 					}
+					ticket = cloud_buffer_.Issue();
+					gui::Application::GetInstance().PostToMainThread(
+							main_vis_.get(), [this, next, mat, segmentNumber, frameId]() {
+							TraceScope trace("upload", "render", segmentNumber, frameId);
+							auto uploadStart = std::chrono::steady_clock::now();
+							// written in place into the hidden one of the persistent buffers, no renderable is recreated
+							cloud_buffer_.Upload(main_vis_->GetScene(), next->staged, mat);
+							if (next->budgeted)
+								point_budget_.OnPresent(next->points, std::chrono::duration<double>(
+										std::chrono::steady_clock::now() - uploadStart).count());
+							});
+
+					// the UI thread then only swaps which renderable is visible
+					std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+					presentation.Wait(pts);
+					streaming_report.OnPresent();
+					pipeline_metrics.OnPresent();
+					uint64_t submitStart = Tracer::Instance().Now();
+					gui::Application::GetInstance().PostToMainThread(
+							main_vis_.get(), [this, next, ticket, segmentNumber, frameId]() {
+							TraceScope trace("present", "render", segmentNumber, frameId);
+							cloud_buffer_.Swap(main_vis_->GetScene(), ticket);
+							presented_ = next;
+
+							auto camera = main_vis_->GetScene()->GetCamera();
+							Eigen::Vector3f eye = camera->GetPosition();
+							// the camera of this frame sets the point budget of the next one
+							if (LEVEL_OF_DETAIL)
+								point_budget_.SetView(eye.data(), camera->GetFieldOfView(), main_vis_->GetOSFrame().height);
+							// and picks the tiles of the segments still to be requested, in each object's own coordinates
+							Eigen::Matrix4f projection = camera->GetProjectionMatrix().matrix();
+							Eigen::Matrix4f view = camera->GetViewMatrix().matrix();
+							for (auto &object : scene) {
+								if (!VIEW_DEPENDENT || object->tiles.Tiles() == 0)
+									continue;
+								Eigen::Vector3f offset(object->offset[0], object->offset[1], object->offset[2]);
+								Eigen::Matrix4f model = Eigen::Matrix4f::Identity();
+								model.block<3, 1>(0, 3) = offset;
+								Eigen::Matrix4f objectView = view * model;
+								object->tiles.SetView(projection.data(), objectView.data());
+							}
+							// and splits the link between the objects by how much of the screen each covers
+							if (bandwidth_allocator)
+								bandwidth_allocator->SetView(eye.data(), camera->GetFieldOfView(),
+										main_vis_->GetOSFrame().height);
+								
+							//main_vis_->ResetCameraToDefault();
+							//Eigen::Vector3f center = bounds.GetCenter().cast<float>();
+							//main_vis_->SetupCamera(60, center, center + CENTER_OFFSET,
+							//		{0.0f, -1.0f, 0.0f});
+							});
+					Tracer::Instance().Complete("render submit", "render", submitStart, Tracer::Instance().Now(),
+							segmentNumber, frameId);
+
+					cout << "In Open3D, CNT=" << cnt << endl;
+					cout << "OPEN-3D Time(sec) : " << sec.count() <<"seconds" <<'\n';
+					writeFile << "OPEN-3D Time(sec) : " << sec.count() << "seconds\n";
 				}
 				
-				cnt++;
-				cout << "In Open3D, CNT=" << cnt << endl;
-				std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
-				cout << "OPEN-3D Time(sec) : " << sec.count() <<"seconds" <<'\n';
-				writeFile << "OPEN-3D Time(sec) : " << sec.count() << "seconds\n";
-				
 				if(cnt == 1) main_vis_->ResetCameraToDefault(); 
-				else if(cnt == PLY_COUNT_PER_BIN * BIN_COUNT - 1) {
-					main_vis_->Close();
-					writeFile.close();
-					break;
-				}
 				
 				if (!main_vis_) {  // might have changed while sleeping
 					break;
 				}
 			}
+
+			// decoder closed the frame queue: end of stream; or the window was closed, and the decoder's pushes
+			// now fail instead of waiting for a renderer that is gone
+			buf2.Close();
+			streaming_report.OnPlaybackEnd(presentation);
+			writeFile << "OPEN-3D presented " << presentation.Presented() << " dropped " << presentation.Dropped()
+				<< " rebuffers " << presentation.Rebuffers() << "\n";
+			log_ring_stats(writeFile, "frame queue", buf2.Stats());
+			writeFile.close();
+			if (main_vis_) {
+				main_vis_->Close();
+			}
 		}
 
 	private:
-		std::mutex cloud_lock_;
-		std::shared_ptr<geometry::PointCloud> cloud_;
+		// one displayed frame, immutable once handed to the UI thread
+		struct RenderFrame {
+			StagedCloud staged;
+			size_t points = 0;
+			bool budgeted = false; // decoded on the host, its points were set by point_budget_
+		};
+		std::shared_ptr<const RenderFrame> presented_; // UI thread only
+		CloudBuffer cloud_buffer_{CLOUD_NAME}; // staged by the render thread, presented by the UI thread
+		PointBudget point_budget_{RENDER_FRAME_TARGET};
+		MortonOrder morton_; // render thread only
 
 		std::atomic<bool> is_done_;
 		std::shared_ptr<visualizer::O3DVisualizer> main_vis_;
@@ -274,64 +536,256 @@ void *
 libdash_thread(void *ptr)
 {
 	cout << "Hello, Lib-dash Thread\n";
-	pthread_t tid;
-	char msg[256], command[1024], filepath[1024];
-	vector<string> binaryFile;
-	char highfile[128], midfile[128], lowfile[128];	
-	int serv_sock;
-	char ret[BUF_SIZE] = "Low";
-	int str_len;
-	socklen_t clnt_adr_sz;
-	struct sockaddr_in serv_adr, clnt_adr;
-	int port = *((int*)ptr);
-	
-	serv_sock = socket(PF_INET, SOCK_DGRAM, 0);
-	if(serv_sock == -1)
-		error_handling("UDP socket creation error");
-	
-	memset(&serv_adr, 0, sizeof(serv_adr));
-	serv_adr.sin_family = AF_INET;
-	serv_adr.sin_addr.s_addr = htonl(INADDR_ANY);
-	//strcpy(port, (char*)ptr);
-	cout << "PORT: " << port <<"\n";
-	serv_adr.sin_port = htons(port);
+	Tracer::Instance().NameThread("fetch");
+	PlaceThread(network_placement, "network");
+	ObjectStream &stream = *((ObjectStream*)ptr);
+	string mpdPath = stream.mpdPath;
+	auto &buf1 = stream.segments; // fetch -> decode
 
-	if(bind(serv_sock, (struct sockaddr*)&serv_adr, sizeof(serv_adr)) == -1)
-		error_handling("bind() error");
+	// MPD is downloaded and parsed once; segments are fetched in-process.
+	SegmentFetcher fetcher(mpd_host, mpd_port, mpdPath, scene_connections);
+	fetcher.SetHTTPVersion(http_transport);
+	fetcher.TeeSegments(TEE_SEGMENTS);
+	fetcher.CacheIndex(object_path(INDEX_CACHE, stream));
+	fetcher.FastStart(object_path(FAST_START_FILE, stream));
+	fetcher.SetBaseURL(base_url);
+	fetcher.UseCache(segment_cache);
+	if(!fetcher.Open())
+		error_handling("MPD download error");
+
+	// the full frame rate; representations may have lower ones, with fewer frames per segment
+	double frameRate = 0;
+	for(size_t i = 0; i < fetcher.RepresentationCount(); i++)
+		frameRate = std::max(frameRate, fetcher.FrameRate(i));
+	if(frameRate <= 0)
+		frameRate = DEFAULT_FRAME_RATE;
+	double segmentDuration = PLY_COUNT_PER_BIN / frameRate;
+	stream.segmentDuration.store(segmentDuration);
+	// from the index, the MPD itself is not loaded when the cached index is used
+	std::vector<uint32_t> bandwidths;
+	for(size_t i = 0; i < fetcher.RepresentationCount(); i++)
+		bandwidths.push_back(fetcher.Bandwidth(i));
+	// tiled: ABR picks a quality level for all tiles, representation is that level then
+	bool tiled = fetcher.TileCount() > 0;
+	if(tiled) {
+		std::vector<TileRegion> tiles;
+		for(size_t i = 0; i < fetcher.TileCount(); i++)
+			tiles.push_back(fetcher.Tile(i));
+		stream.tiles.SetTiles(tiles, bandwidths);
+		bandwidths = stream.tiles.LevelBandwidths();
+		cout << "Tiles: " << tiles.size() << ", levels: " << bandwidths.size() << "\n";
+	}
+	// layered (SHVC) content: a representation is fetched after the ones it depends on, base layer first, and
+	// their segments are merged before decoding, so an upgrade costs only the enhancement bytes. The
+	// merge needs whole segments, they are not decoded progressively then
+	size_t layers = 1;
+	for(size_t i = 0; !tiled && i < fetcher.RepresentationCount(); i++)
+		layers = std::max(layers, fetcher.Dependencies(i).size() + 1);
+	bool progressive = PROGRESSIVE_DECODE && layers == 1;
+	// buffer limits count segments, the tiles of one segment are requested together
+	size_t tiles_per_segment = tiled ? fetcher.TileCount() : 1;
+	size_t requests_per_segment = tiles_per_segment * layers;
+	AbrController abr(bandwidths, abr_policy, MAX_BUFFERED_SEGMENTS * segmentDuration);
+	// decode times are per tile representation, not per level of all tiles
+	abr.SetDecodeCost(tiled ? NULL : &stream.decodeCost);
+	// time to the first frame: playback starts on the smallest segments, quality goes up once some are buffered
+	abr.SetStartupBuffer(FAST_START_BUFFER);
+	// the representations below the full frame rate are for when those at it cannot be decoded or downloaded in time
+	if(!tiled) {
+		std::vector<double> frameRates;
+		for(size_t i = 0; i < fetcher.RepresentationCount(); i++)
+			frameRates.push_back(fetcher.FrameRate(i));
+		abr.SetFrameRates(frameRates);
+	}
+	// representations may differ in video codec (@codecs v3c1,hev1 or v3c1,vvi1); the decoder takes the codec from
+	// each segment, but one this build has no decoder for (VVC without the VTM library) is never requested
+	for(size_t i = 0; !tiled && i < fetcher.RepresentationCount(); i++) {
+		if(VpccDecoder::Decodes(fetcher.Codecs(i)))
+			continue;
+		cout << "Representation " << i << ": no video decoder for its codecs, skipped\n";
+		if(!abr.Exclude(i))
+			error_handling("no decodable representation");
+	}
+	fetcher.ParallelRanges(RANGE_PARTS);
+	size_t representation = abr.Lowest();
+	cout << "ABR policy: " << abr.Policy().Name() << "\n";
+	cout << "Representations: " << fetcher.RepresentationCount() << ", segments: " << fetcher.SegmentCount() << "\n";
 
 	std::ofstream writeFile;
-	writeFile.open("./timeLog/libdash.txt");
+	writeFile.open(object_path("./timeLog/libdash.txt", stream));
+	std::ofstream metricsFile(object_path(METRICS_FILE, stream));
+	auto lastDump = std::chrono::steady_clock::now();
 
-	for(int frame=0;frame<BIN_COUNT;frame++){
-		std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-		
-		sprintf(command, "./libdash_mcnl_test %d %s %d", frame, ret, port);
-		system(command);
-		clnt_adr_sz = sizeof(clnt_adr);
-		str_len = recvfrom(serv_sock, ret, BUF_SIZE, 0, (struct sockaddr*)&clnt_adr, &clnt_adr_sz);
-		ret[str_len] = 0;
-		cout << "RET: " << ret << endl;
-		string buildbinpath = PATH + "/AR-streaming-with-MPEG-DASH/build/bin";
-		for(auto& p : std::experimental::filesystem::directory_iterator(buildbinpath)) {
-			string Filename = p.path().string();
-			cout << Filename << endl;
-			Filename = Filename.substr(Filename.find("/bin/") + 5);
-
-			sprintf(highfile ,"high_s%d", frame);
-			sprintf(midfile ,"mid_s%d", frame);
-			sprintf(lowfile ,"low_s%d", frame);
-			if(Filename.find(highfile) != string::npos || Filename.find(midfile) != string::npos || Filename.find(lowfile) != string::npos) {
-				snprintf(msg, 256, "%s", Filename.c_str());
-				bounded_buffer_queue(buf1, strdup(msg));
-				cout << Filename << endl;
+	// live: join behind the live edge and request each segment once it is available
+	bool live = fetcher.IsDynamic();
+	size_t count = live ? fetcher.SegmentCount() : std::min((size_t)BIN_COUNT, fetcher.SegmentCount());
+	size_t next = live ? fetcher.LiveStart() : 0;
+	SegmentPrefetcher prefetcher(fetcher, prefetch_window * requests_per_segment);
+	std::deque<std::pair<size_t, size_t>> tile_tags; // tile and tiles of each request in flight
+	std::deque<size_t> layer_tags; // layers of the same segment requested after each one in flight
+	std::deque<size_t> byte_tags; // bytes expected of each one in flight, not in buf1 yet
+	size_t requested_bytes = 0; // their sum
+	std::unique_ptr<SegmentInfo> layered_segment; // the layers of a segment that arrived so far, merged
+
+	while(next < count || prefetcher.InFlight() > 0) {
+		if(live && fetcher.RefreshIn() <= 0) {
+			if(!fetcher.Refresh())
+				cerr << "MPD refresh failed\n";
+			// the last update of a live presentation turns it static
+			live = fetcher.IsDynamic();
+			count = fetcher.SegmentCount();
+		}
+
+		// keep the window full unless the decoder is already far behind;
+		// at least one download is always outstanding
+		// progressive: segments enter the decode queue when their download
+		// starts, so in-flight ones are in buf1 already
+		while(next < count && prefetcher.CanRequest() && (prefetcher.InFlight() == 0 ||
+				(progressive ? std::max(buf1.Size(), prefetcher.InFlight()) :
+				buf1.Size() + prefetcher.InFlight()) < MAX_BUFFERED_SEGMENTS * requests_per_segment) &&
+				(!live || fetcher.AvailableIn(next) <= 0)) {
+			std::vector<TileChoice> choices;
+			if(tiled) {
+				// the segment plays once those buffered and in flight have: its tiles are those of the view
+				// predicted for its middle
+				size_t ahead = progressive ? std::max(buf1.Size(), prefetcher.InFlight()) : buf1.Size() + prefetcher.InFlight();
+				double seconds = (double) ahead / requests_per_segment * segmentDuration + stream.QueuedSeconds(frameRate) +
+					segmentDuration / 2;
+				choices = stream.tiles.Select(representation, seconds);
+			}
+			else {
+				for(size_t dependency : fetcher.Dependencies(representation))
+					choices.push_back(TileChoice{0, dependency, 0});
+				choices.push_back(TileChoice{0, representation, 0});
 			}
+			if(prefetcher.Window() - prefetcher.InFlight() < choices.size())
+				break;
+			// nor while the segments queued and downloading would outgrow SEGMENT_BUFFER_BYTES; their sizes
+			// are told by the bandwidth of their representations until they arrive
+			std::vector<size_t> bytes;
+			size_t segment_bytes = 0;
+			for(const TileChoice &choice : choices) {
+				bytes.push_back((size_t)(fetcher.Bandwidth(choice.representation) * segmentDuration / 8));
+				segment_bytes += bytes.back();
+			}
+			if(SEGMENT_BUFFER_BYTES > 0 && prefetcher.InFlight() > 0 &&
+					buf1.Bytes() + requested_bytes + segment_bytes > SEGMENT_BUFFER_BYTES)
+				break;
+			for(size_t k = 0; k < choices.size(); k++) {
+				std::shared_ptr<SegmentStream> stream;
+				if(progressive) {
+					std::unique_ptr<SegmentInfo> early(new SegmentInfo);
+					stream = std::make_shared<SegmentStream>();
+					fetcher.Describe(next, choices[k].representation, *early);
+					early->tile = k;
+					early->tiles = choices.size();
+					early->stream = stream;
+					buf1.Push(std::move(early), bytes[k]);
+				}
+				prefetcher.Request(next, choices[k].representation, stream);
+				// progressive ones are counted in buf1 already
+				byte_tags.push_back(progressive ? 0 : bytes[k]);
+				requested_bytes += byte_tags.back();
+				tile_tags.push_back(tiled ? std::make_pair(k, choices.size()) : std::make_pair((size_t)0, (size_t)1));
+				layer_tags.push_back(tiled ? 0 : choices.size() - 1 - k);
+			}
+			next++;
+		}
+
+		// at the live edge with nothing in flight: wait for the next segment
+		// or the next MPD update, whichever comes first
+		if(prefetcher.InFlight() == 0) {
+			if(next < count) {
+				double wait = fetcher.AvailableIn(next);
+				double refresh = fetcher.RefreshIn();
+				if(refresh >= 0)
+					wait = std::min(wait, refresh);
+				std::this_thread::sleep_for(std::chrono::duration<double>(std::max(wait, 0.01)));
+			}
+			continue;
+		}
+
+		// a download that would not finish before the buffer runs dry is abandoned for the same segment at a lower
+		// representation; not of tiles or layers, which ABR does not choose one by one
+		SegmentPrefetcher::Watchdog watchdog;
+		if(!tiled && layers == 1)
+			watchdog = [&abr, &buf1, &stream, frameRate, segmentDuration](size_t segmentNumber, size_t fetching,
+					const DownloadProgress &progress) {
+				double bufferLevel = buf1.Size() * segmentDuration + stream.QueuedSeconds(frameRate);
+				size_t replacement = abr.Abandon(fetching, progress, bufferLevel, segmentDuration);
+				if(replacement != fetching)
+					cout << "Segment " << segmentNumber << ": representation " << fetching << " abandoned for "
+						<< replacement << ", " << bufferLevel << "s buffered\n";
+				return replacement;
+			};
+		std::unique_ptr<SegmentInfo> info(new SegmentInfo);
+		if(!prefetcher.Next(*info, watchdog))
+			error_handling("segment download error");
+		info->tile = tile_tags.front().first;
+		info->tiles = tile_tags.front().second;
+		tile_tags.pop_front();
+		size_t layers_after = layer_tags.front();
+		layer_tags.pop_front();
+		requested_bytes -= byte_tags.front();
+		byte_tags.pop_front();
+		cout << "Time : " << info->seconds << " file_size/time: " << info->throughput << endl;
+		abr.OnDownload(*info);
+		// several objects: this one's share of what all of them download
+		if(bandwidth_allocator) {
+			bandwidth_allocator->SetThroughput(stream.index, abr.Throughput().Estimate());
+			abr.SetBandwidth(bandwidth_allocator->Bandwidth(stream.index));
+		}
+		streaming_report.OnSegment(*info, fetcher.Bandwidth(info->representation));
+		pipeline_metrics.downloadedBytes.Add(info->bytes);
+		pipeline_metrics.segments.Add();
+		pipeline_metrics.downloadSeconds.Observe(info->seconds);
+		if(!info->cached)
+			pipeline_metrics.throughput.Set(info->throughput);
+		double seconds = info->seconds;
+		if(layered_segment) {
+			if(!MergeLayer(layered_segment->data, info->data))
+				error_handling("layer merge error");
+			layered_segment->representation = info->representation;
+			layered_segment->layer = info->layer;
+			layered_segment->bytes += info->bytes;
+			layered_segment->seconds += info->seconds;
+			info = std::move(layered_segment);
+		}
+		if(layers_after > 0)
+			layered_segment = std::move(info);
+		else if(!progressive) {
+			size_t bytes = info->data.size();
+			buf1.Push(std::move(info), bytes);
+		}
+
+		// applies to the next request, the ones in flight keep theirs
+		size_t downloaded = progressive ? buf1.Size() - std::min(buf1.Size(), prefetcher.InFlight()) : buf1.Size();
+		double bufferLevel = (double) downloaded / tiles_per_segment * segmentDuration + stream.QueuedSeconds(frameRate);
+		// the points the next segment decodes to in each representation, if the MPD says, predict the decode
+		// time of the ones not decoded yet
+		for(size_t r = 0; r < fetcher.RepresentationCount(); r++) {
+			SegmentComplexity complexity;
+			if(fetcher.Complexity(next, r, complexity))
+				stream.decodeCost.SetNext(r, complexity.points);
+		}
+		representation = abr.Select(bufferLevel, segmentDuration);
+		pipeline_metrics.bufferLevel.Set(bufferLevel);
+		pipeline_metrics.representation.Set(representation);
+		pipeline_metrics.abrEstimate.Set(abr.Throughput().Estimate());
+		writeFile << "ABR estimate " << abr.Throughput().Estimate() << " bps, buffer " << bufferLevel << "s\n";
+		cout << "RET: " << representation << endl;
+
+		writeFile << "Lib-Dash Time(sec) : " << seconds << "seconds, in flight " << prefetcher.InFlight()
+			<< ", buffered " << buf1.Size() << "\n";
+
+		if(std::chrono::duration<double>(std::chrono::steady_clock::now() - lastDump).count() >= METRICS_DUMP_INTERVAL) {
+			fetcher.Metrics().Dump(metricsFile);
+			lastDump = std::chrono::steady_clock::now();
 		}
-		std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
-		writeFile << "Lib-Dash Time(sec) : " << sec.count() << "seconds\n";
-		//cout << "Lib-DASH Time(sec) : " << sec.count() <<"seconds" <<'\n';
 	}
+	buf1.Close();
+	fetcher.Metrics().Dump(metricsFile);
 	writeFile.close();
-	close(serv_sock);
 
 	return 0x0;
 }
@@ -341,10 +795,13 @@ void *
 mpeg_vpcc_thread(void *ptr)
 {
 	cout << "Hello, MPEG-VPCC Thraed\n";
-	pthread_t tid;
-	tid = pthread_self();
+	Tracer::Instance().NameThread("decode");
+	PlaceThread(decode_placement, "decode");
+	ObjectStream &stream = *((ObjectStream*)ptr);
+	auto &buf1 = stream.segments; // fetch -> decode
+	auto &frames = *stream.frames;
 	
-	char * msg;
+	std::unique_ptr<SegmentInfo> segment;
 	char line[1024] = {0, };
 	vector<string> opt;
 	string decOptpath = PATH + "/AR-streaming-with-MPEG-DASH/Main/decOpt.txt";
@@ -355,90 +812,227 @@ mpeg_vpcc_thread(void *ptr)
 	while(f1.getline(line, 1001)) {
 		opt.push_back(line);
 	}
+
 	std::ofstream writeFile;
-	writeFile.open("./timeLog/mpeg-vpcc.txt");
-	
-	for(int i = 0 ; i < BIN_COUNT ; i++) {  /// To do
-		msg = bounded_buffer_dequeue(buf1);
-		if(msg != 0x0) {
-			std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-
-			printf("MPEG-VPCC Thread [%ld] read %s\n", (unsigned long) tid, msg);
-			char path[1024], comprename[1024], reconname[1024];
-			sprintf(path, "../../bin/%s", "PccAppDecoder");
-			
-			msg[strlen(msg)-4] = 0x0;
-			char dir_path[1024];
-			sprintf(dir_path, "./../../dec_test/%s",msg);
-			cout << "dir_path : " << dir_path << endl;
-			
-			pid_t pid, waitpid;
-			int status;
-			pid = fork();
-			if(pid == 0) {
-				mkdir(dir_path, 0755);
-				sprintf(comprename,"--compressedStreamPath=%s.bin", msg);	
-				sprintf(reconname,"--reconstructedDataPath=./../../dec_test/%s/%s_dec_%%04d.ply", msg ,msg);				
-				execl(path, "PccAppDecoder", comprename, opt[0].c_str(), opt[1].c_str(), opt[2].c_str(), reconname, opt[3].c_str(), NULL);
-			}else {
-				char ply_count[101];
-				char dir[256];
-				int cnt = 0;
-				char command[1024];
-				char ply_path[1024];
-				
-				string decTestpath = PATH + "/AR-streaming-with-MPEG-DASH/dec_test";
-				sprintf(ply_path, "ls -l %s/%s/*.ply | wc -l", decTestpath.c_str(), msg);
-				while(1) {
-					FILE *fp = popen(ply_path, "r");
-					if(fgets(ply_count, 10, fp) == NULL) break;
-					cout << "cnt :" << ply_count << " msg : " << msg <<  " " << atoi(ply_count) << endl;
-					if(atoi(ply_count) == PLY_PER_DIRECTORY) { // 10
-						sprintf(dir, "%s/%s/ply%02d", decTestpath.c_str(), msg, cnt++);
-						mkdir(dir, 0755);
-						sprintf(command, "mv %s/*.ply %s", dir_path,dir);
-						//cout << "Command :" << command << endl;
-						system(command);
-						
-						string directory_path;
-						directory_path = string(dir); 
-						
-						vector<string> files;
-						for(auto & p : std::experimental::filesystem::directory_iterator(directory_path)) 
-						{
-							string filepath = string(dir) + "/" + p.path().filename().string();
-							files.push_back(filepath);
-						}
-						sort(files.begin(), files.end());
-						
-						for(int i = 0 ; i < files.size() ; i++) {
-							string filepath = files[i];
-							//cout << "PUSH: " << filepath << endl;
-							bounded_buffer_queue(buf2, strdup(filepath.c_str()));
-						}
-					}
-					pclose(fp);
-					if(cnt == (PLY_COUNT_PER_BIN / PLY_PER_DIRECTORY)) {
-						sprintf(command, "rm -rf %s.bin *.ofl *.opcl *.trc *.txt *.otl", msg);
-						system(command);
-						break;
-					}
-					printf("cnt : %d, WEXITSTATUS: %d\n", cnt, WEXITSTATUS(status));
-				}
-				
-				waitpid = wait(&status);
-				free(msg);
-				kill(pid, SIGKILL);
-			}
+	writeFile.open(object_path("./timeLog/mpeg-vpcc.txt", stream));
+
+	bool telemetryOn = strlen(TELEMETRY_FILE) > 0;
+	SegmentTelemetry telemetry;
+	telemetry.SetReference(TELEMETRY_REFERENCE, TELEMETRY_FIRST_FRAME);
+	telemetry.SetSampling(TELEMETRY_QUALITY_EVERY);
+	// frames of the tiles of one segment, presented together once its last tile is decoded
+	std::vector<std::unique_ptr<DecodedFrame>> tile_frames;
+
+	// PccLibDecoder runs in-process, on the workers of the scheduler; every segment starts with an IRAP GOF,
+	// so several can be decoded at once. Their frames go on to the renderer queue in segment order.
+	DecodeScheduler::DecodeJob decode = [&telemetry, telemetryOn, &stream](VpccDecoder &decoder, SegmentInfo &segment,
+			const DecodeScheduler::FrameSink &emit) {
+		std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+		const char * msg = segment.fileName.c_str();
 
-			std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
-			writeFile << "MPEG-VPCC Time(sec) : " << sec.count() << "seconds\n";
-			cout << "MPEG-VPCC Time(sec) : " << sec.count() <<"seconds" <<'\n';
+		printf("MPEG-VPCC Thread [%ld] read %s\n", (unsigned long) pthread_self(), msg);
+		int cnt = 0;
+		size_t frames = frames_per_segment(segment.frameRate, stream.segmentDuration.load());
+		auto queue = [&cnt, &segment, &emit, &stream, frames](std::unique_ptr<DecodedFrame> decoded, uint64_t frameId) {
+			decoded->frameRate = segment.frameRate;
+			decoded->frameId = frameId;
+			decoded->segmentNumber = segment.segmentNumber;
+			decoded->pts = PresentationClock::Timestamp(segment.segmentNumber, cnt, frames, segment.frameRate);
+			stream.decodedFrameRate.store(segment.frameRate);
+			emit(std::move(decoded));
+			cnt++;
+		};
+		// telemetry keeps one segment at a time, it runs with a single worker; a frame of a lower frame rate is
+		// compared with the source frame it was sampled from
+		FrameCallback present = [&cnt, &segment, &telemetry, &queue, frames](pcc::PCCPointSet3 &frame, uint64_t frameId) {
+			telemetry.OnFrame(frame, segment.segmentNumber * PLY_COUNT_PER_BIN + cnt * PLY_COUNT_PER_BIN / frames);
+			std::unique_ptr<DecodedFrame> decoded(new DecodedFrame);
+			/* the renderer only reads the positions and colors of the queued frames, kept packed until it converts them */
+			decoded->points.Pack(frame);
+			queue(std::move(decoded), frameId);
+		};
+		// --deviceReconstruction in decOpt.txt: these frames stay on the device, without point telemetry
+		decoder.SetDeviceFrameCallback([&queue](std::shared_ptr<t::geometry::PointCloud> &cloud, uint64_t frameId) {
+			std::unique_ptr<DecodedFrame> decoded(new DecodedFrame);
+			decoded->deviceCloud = cloud;
+			queue(std::move(decoded), frameId);
+		});
+		// slack of a frame: the queued frames play before it. Nothing is late before playback starts
+		if(ADAPTIVE_POST_PROCESSING)
+			decoder.SetPostProcessingCallback([&segment, &stream](size_t) {
+				if(pipeline_metrics.presented.Value() == 0)
+					return pcc::POST_PROCESSING_FULL;
+				double frameRate = segment.frameRate > 0 ? segment.frameRate : DEFAULT_FRAME_RATE;
+				pcc::PCCPostProcessing level = stream.postProcessing.Next(stream.QueuedSeconds(frameRate));
+				pipeline_metrics.postProcessing.Set(level);
+				return level;
+			});
+		// a layered segment decodes up to the top layer fetched, upsampled to the full size below that
+		if(segment.layer != SIZE_MAX)
+			decoder.Parameters().shvcLayerIndex_ = segment.layer;
+		// progressive segments are decoded GOF by GOF while they download
+		decoder.TraceSegment(segment.segmentNumber);
+		// Decode takes over the data; progressive segments are counted by their stream afterwards
+		size_t bytes = segment.data.size();
+		if(telemetryOn)
+			telemetry.Begin(segment.segmentNumber, segment.representation);
+		uint64_t traceStart = Tracer::Instance().Now();
+		int ret = segment.stream ? decoder.Decode(*segment.stream, segment.fileName, present) :
+			decoder.Decode(segment.data, segment.fileName, present);
+		Tracer::Instance().Complete("segment decode", "decode", traceStart, Tracer::Instance().Now(), segment.segmentNumber);
+		cout << "cnt : " << cnt << " msg : " << msg << endl;
+
+		std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+		if(telemetryOn)
+			telemetry.End(segment.stream ? segment.stream->Received() : bytes, sec.count(), decoder.BusySeconds());
+		return ret;
+	};
+	DecodeScheduler::OrderedFrameSink output = [&tile_frames, &frames](SegmentInfo &segment, size_t index,
+			std::unique_ptr<DecodedFrame> frame) {
+		if(segment.tiles <= 1) {
+			push_frame(frames, std::move(frame));
+			return;
+		}
+		if(segment.tile == 0 && index == 0) {
+			for(auto &merged : tile_frames)
+				push_frame(frames, std::move(merged));
+			tile_frames.clear();
+		}
+		merge_tile_frame(tile_frames, index, std::move(frame));
+	};
+	DecodeScheduler::SegmentDone done = [&tile_frames, &frames, &stream, &writeFile](SegmentInfo &segment, int ret, double seconds,
+			double busySeconds) {
+		if(ret != 0) {
+			cerr << "decode error(" << ret << "): " << segment.fileName << endl;
+			pipeline_metrics.decodeErrors.Add();
+		}
+		if(segment.tile + 1 == segment.tiles) {
+			for(auto &frame : tile_frames)
+				push_frame(frames, std::move(frame));
+			tile_frames.clear();
 		}
+		pipeline_metrics.decodeSeconds.Observe(seconds);
+		if(ret == 0)
+			stream.decodeCost.AddSample(segment.representation, busySeconds, segment.complexity.points);
+		writeFile << "MPEG-VPCC Time(sec) : " << seconds << "seconds\n";
+		cout << "MPEG-VPCC Time(sec) : " << seconds <<"seconds" <<'\n';
+	};
+	{
+		DecodeScheduler scheduler(telemetryOn ? 1 : DECODE_WORKERS, DECODE_MEMORY_BUDGET, opt, decode, output, done,
+				decode_pool.get());
+		// segments ahead of the oldest only decode while their frames fit into what is left of the frame queue
+		scheduler.SetHeadroom([&frames]() { return frames.BytesLeft(); });
 
+		// in a scene, the segment that has to start first decodes first, whichever object it is of: the time its
+		// first frame is due, less its decode time predicted from the MPD
+		while(buf1.Pop(segment)) {
+			double deadline = segment->segmentNumber * stream.segmentDuration.load();
+			double decodeSeconds = 0;
+			if(stream.decodeCost.Predict(segment->complexity.points, decodeSeconds))
+				deadline -= decodeSeconds;
+			scheduler.Submit(std::move(segment), deadline);
+		}
+		scheduler.Finish();
 	}
+	for(auto &frame : tile_frames)
+		push_frame(frames, std::move(frame));
+	frames.Close();
 
+	log_ring_stats(writeFile, "segment queue", buf1.Stats());
+	writeFile << "frames with reduced post-processing : " << stream.postProcessing.Reduced() << "\n";
 	writeFile.close();
+	string telemetryPath = object_path(TELEMETRY_FILE, stream);
+	if(telemetryOn && !telemetry.Write(telemetryPath))
+		cerr << "telemetry write error: " << telemetryPath << endl;
+	return 0x0;
+}
+
+// count and sum of the observations of histogram since the last call, which keeps them in count and sum
+void histogram_delta(const MetricHistogram &histogram, uint64_t &count, double &sum, uint64_t &newCount, double &newSum) {
+	std::vector<uint64_t> counts;
+	double total;
+	histogram.Snapshot(counts, total);
+	newCount = counts.back() - count;
+	newSum = total - sum;
+	count = counts.back();
+	sum = total;
+}
+
+// the decode threads of the TaskRuntime follow the frame queue and the decode and render times, from the metrics of
+// the pipeline; all of them until playback starts. Ends with running
+void core_control_thread(const std::atomic<bool> &running) {
+	Tracer::Instance().NameThread("core control");
+	CoreController controller;
+	uint64_t decodeCount = 0, convertCount = 0;
+	double decodeSum = 0, convertSum = 0;
+	while(running.load()) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(CORE_CONTROL_INTERVAL));
+		uint64_t decoded, converted;
+		double decodeSeconds, convertSeconds;
+		histogram_delta(pipeline_metrics.decodeSeconds, decodeCount, decodeSum, decoded, decodeSeconds);
+		histogram_delta(pipeline_metrics.convertSeconds, convertCount, convertSum, converted, convertSeconds);
+		size_t threads = TaskRuntime::Instance().Threads();
+		if(threads == 0 || pipeline_metrics.presented.Value() == 0)
+			continue;
+
+		double frameRate = scene.front()->decodedFrameRate.load();
+		if(frameRate <= 0)
+			frameRate = DEFAULT_FRAME_RATE;
+		double segmentDuration = scene.front()->segmentDuration.load();
+		CoreSample sample;
+		sample.slack = scene.front()->QueuedSeconds(frameRate);
+		for(auto &object : scene)
+			sample.slack = std::min(sample.slack, object->QueuedSeconds(frameRate));
+		sample.fill = (double) buf2.Size() / buf2.Capacity();
+		if(buf2.ByteBudget() > 0)
+			sample.fill = std::max(sample.fill, 1 - (double) buf2.BytesLeft() / buf2.ByteBudget());
+		if(decoded > 0 && segmentDuration > 0)
+			sample.decodeLoad = decodeSeconds / decoded / segmentDuration;
+		if(converted > 0)
+			sample.renderLoad = convertSeconds / converted * frameRate;
+		size_t concurrency = controller.Next(sample, threads);
+		TaskRuntime::Instance().SetConcurrency(concurrency);
+		pipeline_metrics.decodeThreads.Set(concurrency);
+	}
+	if(controller.Changes() > 0)
+		cout << "CoreController: " << controller.Changes() << " changes, " << controller.Concurrency()
+			<< " decode threads at the end\n";
+}
+
+// several objects: the same frame of every object, each moved to its place, is shown as one frame of the scene
+void *
+compositor_thread(void *ptr)
+{
+	cout << "Hello, Compositor Thread\n";
+	Tracer::Instance().NameThread("compose");
+	std::vector<ObjectStream *> playing;
+	for(auto &object : scene)
+		playing.push_back(object.get());
+
+	while(!playing.empty()) {
+		std::unique_ptr<DecodedFrame> composed;
+		for(size_t i = 0; i < playing.size();) {
+			std::unique_ptr<DecodedFrame> frame;
+			// the stream of this object has ended, the others play on
+			if(!playing[i]->frames->Pop(frame)) {
+				playing.erase(playing.begin() + i);
+				continue;
+			}
+			place_object_frame(*playing[i], *frame);
+			if(composed)
+				merge_frame(*composed, std::move(frame));
+			else
+				composed = std::move(frame);
+			i++;
+		}
+		// the renderer has gone: the decoders of the objects stop waiting too
+		if(composed && !push_frame(buf2, std::move(composed))) {
+			for(auto object : playing)
+				object->frames->Close();
+			break;
+		}
+	}
+	buf2.Close();
 	return 0x0;
 }
 
@@ -450,35 +1044,225 @@ open3d_thread(void *ptr)
 	char * msg;
 
 	tid = pthread_self();
+	Tracer::Instance().NameThread("ui");
+	PlaceThread(render_placement, "render");
 	MultipleWindowsApp().Run();
 	cout << "Bye, Open3d Thread\n";
 	return 0x0;
 }
 
+// the renderer's pacing and conversion of every frame, for benchmark runs without a display
+void *
+headless_thread(void *ptr)
+{
+	cout << "Hello, Headless Thread\n";
+	Tracer::Instance().NameThread("render");
+	PlaceThread(render_placement, "render");
+	std::unique_ptr<DecodedFrame> frame;
+	PresentationClock presentation;
+	CloudBuffer staging(CLOUD_NAME); // staged as for the window, never uploaded
+
+	while(buf2.Pop(frame)) {
+		if(presentation.Admit(frame->pts, frame->frameRate) == DROP_FRAME) {
+			frame.reset();
+			pipeline_metrics.dropped.Add();
+			continue;
+		}
+		if(!frame->deviceCloud) {
+			TraceScope trace("convert", "render", frame->segmentNumber, frame->frameId);
+			auto start = std::chrono::steady_clock::now();
+			staging.Stage(frame->points, NULL, frame->points.Size(), frame->pts);
+			pipeline_metrics.convertSeconds.Observe(std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - start).count());
+		}
+		presentation.Wait(frame->pts);
+		streaming_report.OnPresent();
+		pipeline_metrics.OnPresent();
+		frame.reset();
+	}
+	streaming_report.OnPlaybackEnd(presentation);
+	return 0x0;
+}
+
 int main(int argc, char *argv[]) {
-	
-	cout << "Your Git directory Path: (ex)/home/mcnl/mcnl/project/mcnl/YourGitDirName : ";
-	cin >> PATH;
-	pthread_t thread1;
-	pthread_t thread2;
-	pthread_t thread3;
-
-	buf1 = (bounded_buffer *)malloc(sizeof(bounded_buffer));
-	bounded_buffer_init(buf1, 100);
-	
-	buf2 = (bounded_buffer *)malloc(sizeof(bounded_buffer));
-	bounded_buffer_init(buf2, 100);
-		
-	int port = atoi(argv[1]);
-	pthread_create(&thread1, 0x0, libdash_thread, (void*)&port);
-	pthread_create(&thread2, 0x0, mpeg_vpcc_thread, 0x0);
-	pthread_create(&thread3, 0x0, open3d_thread, 0x0);
+	// options first, then what is left is positional: [mpd path] [prefetch window] [abr policy]
+	//   --path DIR         git directory, instead of the prompt
+	//   --origin HOST[:PORT]
+	//   --transport 1.1|2|3  HTTP version; 3 is QUIC for lossy Wi-Fi, the origin must serve https and HTTP/3
+	//   --baseURL URL      segments from there instead of the MPD's BaseURL, e.g. http://EDGE:PORT/video/NAME/
+	//   --serve DIR        in-process test server on 127.0.0.1 for the files below DIR (createContent.sh STREAM_PATH's parent)
+	//   --network FILE     bandwidth/RTT/loss trace the test server shapes its sends to, see NetworkProfile.h
+	//   --headless         no window; the session report goes to --report FILE or BENCHMARK_REPORT
+	//   --metrics PORT     live metrics at http://HOST:PORT/metrics, Prometheus text format
+	//   --object MPD[@X,Y,Z]  another object of the scene, streamed alongside the positional MPD and placed at X,Y,Z
+	//                      (in points); without a position, SCENE_OBJECT_SPACING along x after the one before
+	//   --renderThread CORES[/fifo:N|/nice:N]    cores and priority of the render thread, e.g. 6-7/fifo:10
+	//   --networkThreads CORES[/fifo:N|/nice:N]  of the fetch threads, e.g. 5
+	//   --decodeThreads CORES[/fifo:N|/nice:N]   of the decode threads and TBB workers, e.g. 0-4/nice:5; with
+	//                      ADAPTIVE_CORES, fewer of those workers may run, see CoreController
+	vector<string> args, objects;
+	string serveRoot, networkTrace, reportPath;
+	bool pathGiven = false;
+	size_t metricsPort = METRICS_PORT;
+	for(int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if(arg == "--headless")
+			headless = true;
+		else if(arg == "--path" && hasValue) {
+			PATH = argv[++i];
+			pathGiven = true;
+		}
+		else if(arg == "--origin" && hasValue) {
+			string origin = argv[++i];
+			size_t colon = origin.rfind(':');
+			mpd_host = origin.substr(0, colon);
+			if(colon != string::npos)
+				mpd_port = atoi(origin.c_str() + colon + 1);
+		}
+		else if(arg == "--transport" && hasValue) {
+			string version = argv[++i];
+			http_transport = version == "3" ? HTTP_VERSION_3 : version == "2" ? HTTP_VERSION_2 : HTTP_VERSION_1_1;
+			if(http_transport == HTTP_VERSION_3 && mpd_port == 80)
+				mpd_port = 443;
+		}
+		else if(arg == "--baseURL" && hasValue)
+			base_url = argv[++i];
+		else if(arg == "--serve" && hasValue)
+			serveRoot = argv[++i];
+		else if(arg == "--network" && hasValue)
+			networkTrace = argv[++i];
+		else if(arg == "--report" && hasValue)
+			reportPath = argv[++i];
+		else if(arg == "--metrics" && hasValue)
+			metricsPort = atoi(argv[++i]);
+		else if(arg == "--object" && hasValue)
+			objects.push_back(argv[++i]);
+		else if((arg == "--renderThread" || arg == "--networkThreads" || arg == "--decodeThreads") && hasValue) {
+			ThreadPlacement &placement = arg == "--renderThread" ? render_placement :
+				arg == "--networkThreads" ? network_placement : decode_placement;
+			if(!ThreadPlacement::Parse(argv[++i], placement))
+				error_handling("thread placement error");
+		}
+		else
+			args.push_back(arg);
+	}
+	if(!pathGiven) {
+		cout << "Your Git directory Path: (ex)/home/mcnl/mcnl/project/mcnl/YourGitDirName : ";
+		cin >> PATH;
+	}
+	objects.insert(objects.begin(), args.size() > 0 ? args[0] : MPD_PATH);
+	for(size_t i = 0; i < objects.size(); i++) {
+		std::unique_ptr<ObjectStream> object(new ObjectStream);
+		object->index = i;
+		size_t at = objects[i].rfind('@');
+		object->mpdPath = objects[i].substr(0, at);
+		if(at == string::npos || sscanf(objects[i].c_str() + at + 1, "%d,%d,%d", &object->offset[0], &object->offset[1],
+				&object->offset[2]) != 3)
+			object->offset[0] = i > 0 ? scene.back()->offset[0] + SCENE_OBJECT_SPACING : 0;
+		object->segments.SetByteBudget(SEGMENT_BUFFER_BYTES);
+		scene.push_back(std::move(object));
+	}
+	buf2.SetByteBudget(FRAME_BUFFER_BYTES);
+	// one object decodes into buf2 itself, as before; several share the decoders, the link and the connections
+	if(scene.size() > 1) {
+		for(auto &object : scene) {
+			object->ownFrames.reset(new SpscRing<std::unique_ptr<DecodedFrame>>(FRAME_QUEUE_SIZE));
+			object->frames = object->ownFrames.get();
+			// half of the frame budget is for the objects' own queues, the other half for the composed frames
+			object->frames->SetByteBudget(FRAME_BUFFER_BYTES / 2 / scene.size());
+		}
+		buf2.SetByteBudget(FRAME_BUFFER_BYTES / 2);
+		decode_pool.reset(new DecodePool(DECODE_WORKERS));
+		bandwidth_allocator.reset(new BandwidthAllocator(scene.size()));
+		if(http_transport == HTTP_VERSION_1_1) {
+			scene_connections = std::make_shared<ConnectionPool>();
+			scene_connections->SetMetrics(&scene_metrics);
+		}
+		cout << "Scene: " << scene.size() << " objects\n";
+	}
+	if(SEGMENT_CACHE_MEMORY_BYTES > 0 || *SEGMENT_CACHE_DIR != '\0')
+		segment_cache = std::make_shared<SegmentCache>(SEGMENT_CACHE_MEMORY_BYTES, SEGMENT_CACHE_DIR, SEGMENT_CACHE_DISK_BYTES);
+	if(args.size() > 1)
+		prefetch_window = atoi(args[1].c_str());
+	if(args.size() > 2)
+		abr_policy = ParseAbrPolicy(args[2]);
+
+	NetworkProfile profile;
+	if(!networkTrace.empty() && !profile.Load(networkTrace))
+		error_handling("network trace error");
+	if(!networkTrace.empty() && serveRoot.empty())
+		cerr << "--network only shapes the --serve test server, ignored\n";
+	TestServer server(serveRoot, profile);
+	if(!serveRoot.empty()) {
+		if(!server.Start())
+			error_handling("test server error");
+		mpd_host = "127.0.0.1";
+		mpd_port = server.Port();
+		cout << "Test server: http://" << mpd_host << ":" << mpd_port << " serving " << serveRoot << "\n";
+	}
+
+	for(auto &object : scene) {
+		ObjectStream *stream = object.get();
+		string suffix = stream->index == 0 ? "" : "_" + to_string(stream->index);
+		collect_ring_metrics("segment_queue" + suffix, [stream]() { return stream->segments.Stats(); },
+				[stream]() { return stream->segments.Size(); });
+	}
+	collect_ring_metrics("frame_queue", []() { return buf2.Stats(); }, []() { return buf2.Size(); });
+	MetricsServer metricsServer(MetricsRegistry::Instance());
+	if(metricsPort > 0) {
+		if(!metricsServer.Start(metricsPort))
+			error_handling("metrics server error");
+		cout << "Metrics: http://0.0.0.0:" << metricsServer.Port() << "/metrics\n";
+	}
+
+	Tracer::Instance().Enable(TRACE_ENABLE);
+	TaskRuntime::Instance().Place(decode_placement);
+	streaming_report.Start();
+	// a fetch and a decode thread per object, the compositor with several, one renderer; they mostly wait, their CPU
+	// work runs on the workers of the TaskRuntime
+	vector<pthread_t> threads;
+	for(auto &object : scene) {
+		pthread_t fetch, decode;
+		pthread_create(&fetch, 0x0, libdash_thread, (void*)object.get());
+		pthread_create(&decode, 0x0, mpeg_vpcc_thread, (void*)object.get());
+		threads.push_back(fetch);
+		threads.push_back(decode);
+	}
+	if(scene.size() > 1) {
+		pthread_t compose;
+		pthread_create(&compose, 0x0, compositor_thread, 0x0);
+		threads.push_back(compose);
+	}
+	pthread_t render;
+	pthread_create(&render, 0x0, headless ? headless_thread : open3d_thread, 0x0);
+	threads.push_back(render);
+	std::atomic<bool> coreControl{ADAPTIVE_CORES};
+	std::thread coreControlThread;
+	if(ADAPTIVE_CORES)
+		coreControlThread = std::thread(core_control_thread, std::cref(coreControl));
 	
 	cout << "CHECK" << endl;
 	
-	pthread_join(thread1, 0x0);
-	pthread_join(thread2, 0x0);
-	pthread_join(thread3, 0x0);
+	for(pthread_t thread : threads)
+		pthread_join(thread, 0x0);
+	coreControl.store(false);
+	if(coreControlThread.joinable())
+		coreControlThread.join();
+	if(scene_connections) {
+		std::ofstream metricsFile(suffixed_path(METRICS_FILE, "scene"), std::ios::app);
+		scene_metrics.Dump(metricsFile);
+	}
+	server.Stop();
+	metricsServer.Stop();
+	if(TRACE_ENABLE && !Tracer::Instance().Write(TRACE_FILE))
+		cerr << "trace write error: " << TRACE_FILE << endl;
+	if(headless || !reportPath.empty()) {
+		string path = reportPath.empty() ? BENCHMARK_REPORT : reportPath;
+		streaming_report.Write(cout);
+		if(!streaming_report.Write(path))
+			cerr << "report write error: " << path << endl;
+	}
 	cout << "END\n";
 
 	return 0;
@@ -0,0 +1,134 @@
+/*
+ * MetricsLog.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "MetricsLog.h"
+#include "../libdash/source/metrics/HTTPTransaction.h"
+
+#include <algorithm>
+
+using namespace mcnl;
+using namespace dash::metrics;
+
+MetricsLog::MetricsLog          () :
+            dumpedTransactions  (0),
+            dumpedConnections   (0)
+{
+}
+MetricsLog::~MetricsLog         ()
+{
+    for (size_t i = 0; i < this->transactions.size(); i++)
+        delete this->transactions.at(i);
+    for (size_t i = 0; i < this->connections.size(); i++)
+        delete this->connections.at(i);
+}
+
+void    MetricsLog::Add             (std::vector<IHTTPTransaction *> &transactions, std::vector<ITCPConnection *> &connections)
+{
+    if (transactions.empty() && connections.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->transactions.insert(this->transactions.end(), transactions.begin(), transactions.end());
+    this->connections.insert(this->connections.end(), connections.begin(), connections.end());
+    transactions.clear();
+    connections.clear();
+
+    this->Trim();
+}
+void    MetricsLog::Add             (const IHTTPTransaction &transaction)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->transactions.push_back(new HTTPTransaction(transaction));
+    this->Trim();
+}
+void    MetricsLog::Dump            (std::ostream &out)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    for (size_t i = this->dumpedTransactions; i < this->transactions.size(); i++)
+    {
+        const IHTTPTransaction  *t     = this->transactions.at(i);
+        uint64_t                bytes  = 0;
+
+        for (size_t k = 0; k < t->ThroughputTrace().size(); k++)
+            for (size_t n = 0; n < t->ThroughputTrace().at(k)->ReceivedBytesPerTrace().size(); n++)
+                bytes += t->ThroughputTrace().at(k)->ReceivedBytesPerTrace().at(n);
+
+        /* ttfb and done are ms after the request was sent, -1 if it never got there */
+        int64_t ttfb = t->ResponseReceivedTimeMs() > 0 ? (int64_t) (t->ResponseReceivedTimeMs() - t->RequestSentTimeMs()) : -1;
+        int64_t done = t->ResponseFinishedTimeMs() > 0 ? (int64_t) (t->ResponseFinishedTimeMs() - t->RequestSentTimeMs()) : -1;
+
+        out << "http tcp=" << t->TCPId() << " type=" << t->Type() << " code=" << t->ResponseCode() <<
+               " url=" << t->OriginalUrl() << " range=" << (t->Range().empty() ? "-" : t->Range()) <<
+               " sent=" << t->RequestSentTime() << " ttfb=" << ttfb << "ms done=" << done << "ms bytes=" << bytes << "\n";
+
+        for (size_t k = 0; k < t->ThroughputTrace().size(); k++)
+        {
+            const IThroughputMeasurement    *m      = t->ThroughputTrace().at(k);
+            uint64_t                        period  = 0;
+
+            for (size_t n = 0; n < m->ReceivedBytesPerTrace().size(); n++)
+                period += m->ReceivedBytesPerTrace().at(n);
+
+            out << "  trace s=" << m->StartOfPeriod() << " d=" << m->DurationOfPeriod() << "ms b=" << period << "\n";
+        }
+    }
+    for (size_t i = this->dumpedConnections; i < this->connections.size(); i++)
+    {
+        const ITCPConnection *c = this->connections.at(i);
+
+        out << "tcp id=" << c->TCPId() << " dest=" << c->DestinationAddress() << " opened=" << c->ConnectionOpenedTime() <<
+               " closed=" << c->ConnectionClosedTime() << " connect=" << c->ConnectionTime() << "ms rtt=" << c->RTT() <<
+               "us rttvar=" << c->RTTVariance() << "us cwnd=" << c->CongestionWindow() << " retrans=" <<
+               c->Retransmits() << " delivery=" << c->DeliveryRate() << "bps\n";
+    }
+    out.flush();
+
+    this->dumpedTransactions = this->transactions.size();
+    this->dumpedConnections  = this->connections.size();
+
+    this->Trim();
+}
+size_t  MetricsLog::Transactions    () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->transactions.size();
+}
+void    MetricsLog::Trim            ()
+{
+    /* called with mutex held; records are only dropped after being dumped */
+    if (this->transactions.size() > METRICS_MAX_TRANSACTIONS)
+    {
+        size_t drop = std::min(this->dumpedTransactions, this->transactions.size() - METRICS_MAX_TRANSACTIONS);
+
+        for (size_t i = 0; i < drop; i++)
+            delete this->transactions.at(i);
+
+        this->transactions.erase(this->transactions.begin(), this->transactions.begin() + drop);
+        this->dumpedTransactions -= drop;
+    }
+    if (this->connections.size() > METRICS_MAX_TRANSACTIONS)
+    {
+        size_t drop = std::min(this->dumpedConnections, this->connections.size() - METRICS_MAX_TRANSACTIONS);
+
+        for (size_t i = 0; i < drop; i++)
+            delete this->connections.at(i);
+
+        this->connections.erase(this->connections.begin(), this->connections.begin() + drop);
+        this->dumpedConnections -= drop;
+    }
+}
+
+const std::vector<ITCPConnection *>&    MetricsLog::GetTCPConnectionList    () const
+{
+    return this->connections;
+}
+const std::vector<IHTTPTransaction *>&  MetricsLog::GetHTTPTransactionList  () const
+{
+    return this->transactions;
+}
@@ -0,0 +1,61 @@
+/*
+ * MetricsLog.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * DASH metrics (ISO/IEC 23009-1 Annex D) of every request the client made:
+ * the HTTP transactions with request, first byte and completion times and
+ * their throughput trace, and the TCP connections they ran on. Connections
+ * hand their records over once a request completes; Dump() appends what
+ * arrived since the previous dump to a text log.
+ *****************************************************************************/
+
+#ifndef METRICSLOG_H_
+#define METRICSLOG_H_
+
+#include "IDASHMetrics.h"
+
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <stddef.h>
+
+#define METRICS_MAX_TRANSACTIONS    4096    /* older records are dropped once dumped */
+
+namespace mcnl
+{
+    class MetricsLog : public dash::metrics::IDASHMetrics
+    {
+        public:
+            MetricsLog              ();
+            virtual ~MetricsLog     ();
+
+            /* takes ownership and clears both vectors */
+            void    Add     (std::vector<dash::metrics::IHTTPTransaction *> &transactions,
+                             std::vector<dash::metrics::ITCPConnection *> &connections);
+            /* copies, for records that stay with their owner (libdash chunks) */
+            void    Add     (const dash::metrics::IHTTPTransaction &transaction);
+            /* writes the records added since the previous Dump */
+            void    Dump    (std::ostream &out);
+
+            size_t  Transactions        () const;
+
+            /*
+             *  IDASHMetrics: not synchronized, only valid while nothing is
+             *  downloading
+             */
+            const std::vector<dash::metrics::ITCPConnection *>&     GetTCPConnectionList    () const;
+            const std::vector<dash::metrics::IHTTPTransaction *>&   GetHTTPTransactionList  () const;
+
+        private:
+            mutable std::mutex                              mutex;
+            std::vector<dash::metrics::IHTTPTransaction *>  transactions;
+            std::vector<dash::metrics::ITCPConnection *>    connections;
+            size_t                                          dumpedTransactions;
+            size_t                                          dumpedConnections;
+
+            void    Trim    ();
+    };
+}
+
+#endif /* METRICSLOG_H_ */
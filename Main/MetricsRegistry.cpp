@@ -0,0 +1,214 @@
+/*
+ * MetricsRegistry.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "MetricsRegistry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <sstream>
+
+using namespace mcnl;
+
+/* Prometheus writes +Inf, -Inf and NaN; 15 digits keep bounds like 0.05 readable */
+static std::string  FormatValue (double value)
+{
+    if (std::isnan(value))
+        return "NaN";
+    if (std::isinf(value))
+        return value > 0 ? "+Inf" : "-Inf";
+
+    std::ostringstream text;
+    text.precision(15);
+    text << value;
+    return text.str();
+}
+/* backslashes and line feeds are escaped in HELP lines */
+static std::string  EscapeHelp  (const std::string &help)
+{
+    std::string escaped;
+
+    for (size_t i = 0; i < help.size(); i++)
+    {
+        if (help.at(i) == '\\')
+            escaped += "\\\\";
+        else if (help.at(i) == '\n')
+            escaped += "\\n";
+        else
+            escaped += help.at(i);
+    }
+    return escaped;
+}
+
+MetricCounter::MetricCounter    () :
+               value            (0)
+{
+}
+void        MetricCounter::Add          (double value)
+{
+    /* std::atomic<double> has no fetch_add before C++20 */
+    double current = this->value.load(std::memory_order_relaxed);
+    while (!this->value.compare_exchange_weak(current, current + value, std::memory_order_relaxed))
+        ;
+}
+double      MetricCounter::Value        () const
+{
+    return this->value.load(std::memory_order_relaxed);
+}
+
+MetricGauge::MetricGauge        () :
+             value              (0)
+{
+}
+void        MetricGauge::Set            (double value)
+{
+    this->value.store(value, std::memory_order_relaxed);
+}
+double      MetricGauge::Value          () const
+{
+    return this->value.load(std::memory_order_relaxed);
+}
+
+MetricHistogram::MetricHistogram    (const std::vector<double> &bounds) :
+                 bounds             (bounds),
+                 counts             (bounds.size() + 1, 0),
+                 sum                (0)
+{
+    assert(std::is_sorted(bounds.begin(), bounds.end()));
+}
+void        MetricHistogram::Observe    (double value)
+{
+    /* the first bucket whose upper bound is not below the value, le is inclusive */
+    size_t bucket = std::lower_bound(this->bounds.begin(), this->bounds.end(), value) - this->bounds.begin();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->counts.at(bucket)++;
+    this->sum += value;
+}
+void        MetricHistogram::Snapshot   (std::vector<uint64_t> &counts, double &sum) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    counts.resize(this->counts.size());
+    uint64_t total = 0;
+    for (size_t i = 0; i < this->counts.size(); i++)
+    {
+        total += this->counts.at(i);
+        counts.at(i) = total;
+    }
+    sum = this->sum;
+}
+const std::vector<double>&  MetricHistogram::Bounds () const
+{
+    return this->bounds;
+}
+
+MetricsRegistry::MetricsRegistry    ()
+{
+}
+MetricsRegistry::~MetricsRegistry   ()
+{
+}
+
+MetricsRegistry&    MetricsRegistry::Instance   ()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+MetricCounter&      MetricsRegistry::Counter    (const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    Entry &entry = this->Find(name, METRIC_COUNTER, help);
+    if (!entry.counter)
+        entry.counter.reset(new MetricCounter);
+    return *entry.counter;
+}
+MetricGauge&        MetricsRegistry::Gauge      (const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    Entry &entry = this->Find(name, METRIC_GAUGE, help);
+    if (!entry.gauge)
+        entry.gauge.reset(new MetricGauge);
+    return *entry.gauge;
+}
+MetricHistogram&    MetricsRegistry::Histogram  (const std::string &name, const std::string &help,
+                                                 const std::vector<double> &bounds)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    Entry &entry = this->Find(name, METRIC_HISTOGRAM, help);
+    if (!entry.histogram)
+        entry.histogram.reset(new MetricHistogram(bounds));
+    return *entry.histogram;
+}
+void                MetricsRegistry::OnCollect  (const std::function<void ()> &collector)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->collectors.push_back(collector);
+}
+void                MetricsRegistry::Write      (std::ostream &out)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    for (size_t i = 0; i < this->collectors.size(); i++)
+        this->collectors.at(i)();
+
+    std::map<std::string, Entry>::const_iterator it;
+    for (it = this->entries.begin(); it != this->entries.end(); ++it)
+    {
+        const std::string   &name   = it->first;
+        const Entry         &entry  = it->second;
+
+        out << "# HELP " << name << " " << EscapeHelp(entry.help) << "\n";
+        switch (entry.type)
+        {
+            case METRIC_COUNTER:
+                out << "# TYPE " << name << " counter\n";
+                out << name << " " << FormatValue(entry.counter->Value()) << "\n";
+                break;
+            case METRIC_GAUGE:
+                out << "# TYPE " << name << " gauge\n";
+                out << name << " " << FormatValue(entry.gauge->Value()) << "\n";
+                break;
+            case METRIC_HISTOGRAM:
+            {
+                std::vector<uint64_t>       counts;
+                double                      sum;
+                const std::vector<double>   &bounds = entry.histogram->Bounds();
+
+                entry.histogram->Snapshot(counts, sum);
+                out << "# TYPE " << name << " histogram\n";
+                for (size_t k = 0; k < bounds.size(); k++)
+                    out << name << "_bucket{le=\"" << FormatValue(bounds.at(k)) << "\"} " << counts.at(k) << "\n";
+                out << name << "_bucket{le=\"+Inf\"} " << counts.back() << "\n";
+                out << name << "_sum " << FormatValue(sum) << "\n";
+                out << name << "_count " << counts.back() << "\n";
+                break;
+            }
+        }
+    }
+    out.flush();
+}
+
+MetricsRegistry::Entry& MetricsRegistry::Find   (const std::string &name, Type type, const std::string &help)
+{
+    /* called with mutex held */
+    std::map<std::string, Entry>::iterator it = this->entries.find(name);
+    if (it != this->entries.end())
+    {
+        assert(it->second.type == type);
+        return it->second;
+    }
+
+    Entry &entry = this->entries[name];
+    entry.type = type;
+    entry.help = help;
+    return entry;
+}
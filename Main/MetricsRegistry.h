@@ -0,0 +1,115 @@
+/*
+ * MetricsRegistry.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Live counters, gauges and histograms of the streaming pipeline, written
+ * in the Prometheus text exposition format (version 0.0.4) so that a
+ * scraper, or curl, can watch the queues fill and drain during a session.
+ * The metrics are registered once, before the pipeline threads start, and
+ * then updated lock-free from any thread; only histograms take a short
+ * lock. Values that are cheaper to read than to keep up to date, like the
+ * depth of the queues, are set by collectors that run before every Write.
+ *****************************************************************************/
+
+#ifndef METRICSREGISTRY_H_
+#define METRICSREGISTRY_H_
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace mcnl
+{
+    /* only goes up, resets with the process */
+    class MetricCounter
+    {
+        public:
+            MetricCounter           ();
+
+            void        Add         (double value = 1);
+            double      Value       () const;
+
+        private:
+            std::atomic<double>     value;
+    };
+
+    class MetricGauge
+    {
+        public:
+            MetricGauge             ();
+
+            void        Set         (double value);
+            double      Value       () const;
+
+        private:
+            std::atomic<double>     value;
+    };
+
+    class MetricHistogram
+    {
+        public:
+            /* upper bounds of the buckets, ascending; +Inf is implied */
+            MetricHistogram         (const std::vector<double> &bounds);
+
+            void        Observe     (double value);
+            /* cumulative counts per bound and +Inf, as Prometheus expects them */
+            void        Snapshot    (std::vector<uint64_t> &counts, double &sum) const;
+            const std::vector<double>&  Bounds  () const;
+
+        private:
+            mutable std::mutex      mutex;
+            std::vector<double>     bounds;
+            std::vector<uint64_t>   counts;     /* per bucket, the last one is +Inf */
+            double                  sum;
+    };
+
+    class MetricsRegistry
+    {
+        public:
+            MetricsRegistry             ();
+            virtual ~MetricsRegistry    ();
+
+            /* names follow [a-zA-Z_:][a-zA-Z0-9_:]*; registering a name again returns the first one */
+            MetricCounter&      Counter     (const std::string &name, const std::string &help);
+            MetricGauge&        Gauge       (const std::string &name, const std::string &help);
+            MetricHistogram&    Histogram   (const std::string &name, const std::string &help,
+                                             const std::vector<double> &bounds);
+            /* runs on the scraping thread before every Write */
+            void                OnCollect   (const std::function<void ()> &collector);
+
+            void                Write       (std::ostream &out);
+
+            static MetricsRegistry& Instance    ();
+
+        private:
+            enum Type
+            {
+                METRIC_COUNTER,
+                METRIC_GAUGE,
+                METRIC_HISTOGRAM
+            };
+            struct Entry
+            {
+                Type                                type;
+                std::string                         help;
+                std::unique_ptr<MetricCounter>      counter;
+                std::unique_ptr<MetricGauge>        gauge;
+                std::unique_ptr<MetricHistogram>    histogram;
+            };
+
+            std::mutex                              mutex;      /* the maps, not the values */
+            std::map<std::string, Entry>            entries;    /* by name, written in this order */
+            std::vector<std::function<void ()>>     collectors;
+
+            Entry&  Find    (const std::string &name, Type type, const std::string &help);
+    };
+}
+
+#endif /* METRICSREGISTRY_H_ */
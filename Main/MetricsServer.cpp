@@ -0,0 +1,150 @@
+/*
+ * MetricsServer.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "MetricsServer.h"
+
+#include <cstring>
+#include <sstream>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace mcnl;
+
+#define METRICS_MAX_REQUEST (8 << 10)   /* longer request headers are not answered */
+
+MetricsServer::MetricsServer    (MetricsRegistry &registry) :
+               registry         (registry),
+               listener         (-1),
+               port             (0),
+               running          (false)
+{
+}
+MetricsServer::~MetricsServer   ()
+{
+    this->Stop();
+}
+
+bool        MetricsServer::Start        (size_t port)
+{
+    this->listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (this->listener < 0)
+        return false;
+
+    int reuse = 1;
+    setsockopt(this->listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port        = htons((uint16_t) port);
+
+    socklen_t length = sizeof(addr);
+    if (bind(this->listener, (sockaddr *) &addr, sizeof(addr)) != 0 || listen(this->listener, SOMAXCONN) != 0 ||
+        getsockname(this->listener, (sockaddr *) &addr, &length) != 0)
+    {
+        close(this->listener);
+        this->listener = -1;
+        return false;
+    }
+
+    this->port = ntohs(addr.sin_port);
+    this->running.store(true);
+    this->acceptor = std::thread(&MetricsServer::AcceptLoop, this);
+    return true;
+}
+void        MetricsServer::Stop         ()
+{
+    if (!this->running.exchange(false))
+        return;
+
+    /* wakes the blocked accept */
+    shutdown(this->listener, SHUT_RDWR);
+    close(this->listener);
+    this->listener = -1;
+    this->acceptor.join();
+}
+size_t      MetricsServer::Port         () const
+{
+    return this->port;
+}
+
+void        MetricsServer::AcceptLoop   ()
+{
+    while (this->running.load())
+    {
+        int client = accept(this->listener, NULL, NULL);
+        if (client < 0)
+            continue;
+
+        timeval timeout;
+        timeout.tv_sec  = METRICS_SERVER_TIMEOUT;
+        timeout.tv_usec = 0;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        this->Serve(client);
+        close(client);
+    }
+}
+void        MetricsServer::Serve        (int socket)
+{
+    std::string buffer;
+
+    while (buffer.find("\r\n\r\n") == std::string::npos && buffer.find("\n\n") == std::string::npos)
+    {
+        if (buffer.size() > METRICS_MAX_REQUEST)
+            return;
+
+        char    data[1024];
+        ssize_t received = recv(socket, data, sizeof(data), 0);
+        if (received <= 0)
+            return;
+        buffer.append(data, received);
+    }
+
+    std::istringstream  requestLine(buffer.substr(0, buffer.find('\n')));
+    std::string         method, path;
+    requestLine >> method >> path;
+    path = path.substr(0, path.find('?'));
+
+    std::string         body;
+    std::ostringstream  header;
+
+    if (method != "GET" && method != "HEAD")
+        header << "HTTP/1.0 501 Not Implemented\r\n";
+    else if (path != "/metrics")
+        header << "HTTP/1.0 404 Not Found\r\n";
+    else
+    {
+        std::ostringstream text;
+        this->registry.Write(text);
+        body = text.str();
+        header << "HTTP/1.0 200 OK\r\n";
+        header << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+    }
+    header << "Content-Length: " << body.size() << "\r\n";
+    header << "Connection: close\r\n\r\n";
+
+    if (this->SendAll(socket, header.str()) && method == "GET")
+        this->SendAll(socket, body);
+}
+bool        MetricsServer::SendAll      (int socket, const std::string &data)
+{
+    size_t sent = 0;
+
+    while (sent < data.size())
+    {
+        ssize_t n = send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+/*
+ * MetricsServer.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Minimal HTTP/1.0 endpoint of a MetricsRegistry: GET /metrics answers
+ * with the registry in the Prometheus text format, one request per
+ * connection. Scrapes are rare and small, so a single thread accepts and
+ * answers them in turn; a client that does not send its request within
+ * METRICS_SERVER_TIMEOUT is dropped so that it cannot hold up the next.
+ *****************************************************************************/
+
+#ifndef METRICSSERVER_H_
+#define METRICSSERVER_H_
+
+#include "MetricsRegistry.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <stddef.h>
+
+#define METRICS_SERVER_TIMEOUT  2   /* seconds to receive a request */
+
+namespace mcnl
+{
+    class MetricsServer
+    {
+        public:
+            MetricsServer           (MetricsRegistry &registry);
+            virtual ~MetricsServer  ();
+
+            /* listens on all interfaces, for scrapes from another host during field trials; port 0 picks a free one */
+            bool        Start       (size_t port);
+            void        Stop        ();
+
+            size_t      Port        () const;
+
+        private:
+            MetricsRegistry             &registry;
+            int                         listener;
+            size_t                      port;
+            std::atomic<bool>           running;
+            std::thread                 acceptor;
+
+            void        AcceptLoop  ();
+            void        Serve       (int socket);
+            bool        SendAll     (int socket, const std::string &data);
+    };
+}
+
+#endif /* METRICSSERVER_H_ */
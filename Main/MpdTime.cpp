@@ -0,0 +1,94 @@
+/*
+ * MpdTime.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "MpdTime.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <time.h>
+
+using namespace mcnl;
+
+double  mcnl::ParseDuration     (const std::string &value)
+{
+    /* PnYnMnDTnHnMnS; years and months are taken as 365 and 30 days */
+    const char  *p      = value.c_str();
+    double      seconds = 0;
+    bool        time    = false;
+
+    if (*p == '-')
+        return 0;
+    if (*p++ != 'P')
+        return 0;
+
+    while (*p)
+    {
+        if (*p == 'T')
+        {
+            time = true;
+            p++;
+            continue;
+        }
+
+        char    *end = NULL;
+        double  n    = strtod(p, &end);
+
+        if (end == p)
+            return 0;
+
+        switch (*end)
+        {
+            case 'Y': seconds += n * 365 * 86400;              break;
+            case 'M': seconds += time ? n * 60 : n * 30 * 86400; break;
+            case 'W': seconds += n * 7 * 86400;                break;
+            case 'D': seconds += n * 86400;                    break;
+            case 'H': seconds += n * 3600;                     break;
+            case 'S': seconds += n;                            break;
+            default:  return 0;
+        }
+        p = end + 1;
+    }
+    return seconds;
+}
+double  mcnl::ParseDateTime     (const std::string &value)
+{
+    int     year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    double  second = 0;
+    int     used   = 0;
+
+    if (sscanf(value.c_str(), "%d-%d-%dT%d:%d:%lf%n", &year, &month, &day, &hour, &minute, &second, &used) < 6)
+        return 0;
+
+    /* days since the epoch in the proleptic Gregorian calendar */
+    int         y    = month <= 2 ? year - 1 : year;
+    int         era  = (y >= 0 ? y : y - 399) / 400;
+    int         yoe  = y - era * 400;
+    int         doy  = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int         doe  = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long long   days = (long long) era * 146097 + doe - 719468;
+
+    double      epoch = days * 86400.0 + hour * 3600 + minute * 60 + second;
+
+    /* Z or no suffix is UTC, otherwise +hh:mm / -hh:mm */
+    const char *zone = value.c_str() + used;
+
+    if (*zone == '+' || *zone == '-')
+    {
+        int offsetHour = 0, offsetMinute = 0;
+
+        sscanf(zone + 1, "%d:%d", &offsetHour, &offsetMinute);
+
+        double offset = offsetHour * 3600 + offsetMinute * 60;
+        epoch += *zone == '+' ? -offset : offset;
+    }
+    return epoch;
+}
+double  mcnl::WallClock         ()
+{
+    std::chrono::duration<double> now = std::chrono::system_clock::now().time_since_epoch();
+    return now.count();
+}
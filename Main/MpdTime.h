@@ -0,0 +1,26 @@
+/*
+ * MpdTime.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Converts the time attributes of an MPD, which libdash hands out as the
+ * raw strings: xs:duration (e.g. "PT2.5S") and xs:dateTime (e.g.
+ * "2021-06-01T12:00:00Z").
+ *****************************************************************************/
+
+#ifndef MPDTIME_H_
+#define MPDTIME_H_
+
+#include <string>
+
+namespace mcnl
+{
+    /* seconds, 0 if empty or malformed */
+    double  ParseDuration   (const std::string &value);
+    /* seconds since the Unix epoch (UTC), 0 if empty or malformed */
+    double  ParseDateTime   (const std::string &value);
+    /* wall clock in seconds since the Unix epoch */
+    double  WallClock       ();
+}
+
+#endif /* MPDTIME_H_ */
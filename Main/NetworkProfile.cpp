@@ -0,0 +1,148 @@
+/*
+ * NetworkProfile.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "NetworkProfile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace mcnl;
+
+#define OUTAGE_POLL     0.01    /* seconds between checks whether an outage is over */
+
+NetworkProfile::NetworkProfile  ()
+{
+}
+NetworkProfile::~NetworkProfile ()
+{
+}
+
+bool        NetworkProfile::Load        (const std::string &path)
+{
+    std::ifstream in(path.c_str());
+
+    if (!in)
+        return false;
+
+    std::vector<NetworkStep>    steps;
+    std::string                 line;
+
+    while (std::getline(in, line))
+    {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        std::istringstream  fields(line);
+        NetworkStep         step;
+        double              kbps, rttMs, lossPercent;
+
+        if (!(fields >> step.start >> kbps >> rttMs >> lossPercent))
+            return false;
+        if (!steps.empty() && step.start < steps.back().start)
+            return false;
+
+        step.bandwidth = std::max(kbps, 0.0) * 1000;
+        step.rtt       = std::max(rttMs, 0.0) / 1000;
+        step.loss      = std::min(std::max(lossPercent, 0.0), 100.0) / 100;
+        steps.push_back(step);
+    }
+    if (steps.empty())
+        return false;
+
+    this->steps = steps;
+    return true;
+}
+void        NetworkProfile::SetConstant (double bandwidth, double rtt, double loss)
+{
+    NetworkStep step = { 0, bandwidth, rtt, loss };
+
+    this->steps.assign(1, step);
+}
+bool        NetworkProfile::Shaped      () const
+{
+    return !this->steps.empty();
+}
+NetworkStep NetworkProfile::At          (double seconds) const
+{
+    if (this->steps.empty())
+    {
+        NetworkStep unshaped = { 0, 0, 0, 0 };
+        return unshaped;
+    }
+
+    /* the last step starting at or before `seconds`, the first one before it starts */
+    size_t i = 0;
+    while (i + 1 < this->steps.size() && this->steps.at(i + 1).start <= seconds)
+        i++;
+
+    return this->steps.at(i);
+}
+
+TokenBucket::TokenBucket    (const NetworkProfile &profile, size_t burst) :
+             profile        (profile),
+             burst          ((double) burst)
+{
+    this->Reset();
+}
+TokenBucket::~TokenBucket   ()
+{
+}
+
+void        TokenBucket::Reset      ()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->origin = clock::now();
+    this->last   = this->origin;
+    this->tokens = this->burst;
+}
+double      TokenBucket::Elapsed    () const
+{
+    return std::chrono::duration<double>(clock::now() - this->origin).count();
+}
+void        TokenBucket::Send       (size_t bytes)
+{
+    if (!this->profile.Shaped())
+        return;
+
+    for (;;)
+    {
+        clock::time_point   until;
+        bool                outage;
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+
+            clock::time_point   now  = clock::now();
+            /* over a step change the refill uses the rate now in effect */
+            double              rate = this->profile.At(std::chrono::duration<double>(now - this->origin).count()).bandwidth / 8;
+
+            outage = rate <= 0;
+            if (outage)
+            {
+                this->last = now;
+                until      = now + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(OUTAGE_POLL));
+            }
+            else
+            {
+                this->tokens  = std::min(this->burst, this->tokens + rate * std::chrono::duration<double>(now - this->last).count());
+                this->last    = now;
+                this->tokens -= bytes;
+                /* in debt: wait until the refill has paid for these bytes and
+                 * everything queued before them */
+                until = now + std::chrono::duration_cast<clock::duration>(
+                        std::chrono::duration<double>(std::max(-this->tokens, 0.0) / rate));
+            }
+        }
+
+        std::this_thread::sleep_until(until);
+        if (!outage)
+            return;
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * NetworkProfile.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Scripted network conditions for the TestServer: a trace of steps, each
+ * giving the bandwidth, round-trip time and packet loss from its start
+ * time on, and the token bucket that shapes the server's sends to the
+ * bandwidth of the step in effect. A trace file has one step per line,
+ *
+ *     <start s> <bandwidth kbit/s> <rtt ms> <loss %>
+ *
+ * in increasing start order, '#' starts a comment. The last step holds
+ * until the end of the run; a bandwidth of 0 is an outage.
+ *****************************************************************************/
+
+#ifndef NETWORKPROFILE_H_
+#define NETWORKPROFILE_H_
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+#define SHAPING_BURST_BYTES     (64 << 10)  /* token bucket depth */
+#define SHAPING_PACKET_BYTES    1448        /* TCP payload the loss rate applies to */
+
+namespace mcnl
+{
+    struct NetworkStep
+    {
+        double  start;          /* seconds since the run started */
+        double  bandwidth;      /* bits per second, 0 = outage */
+        double  rtt;            /* seconds */
+        double  loss;           /* probability that a packet is lost */
+    };
+
+    class NetworkProfile
+    {
+        public:
+            /* unshaped: no bandwidth limit, delay or loss */
+            NetworkProfile          ();
+            virtual ~NetworkProfile ();
+
+            bool        Load        (const std::string &path);
+            void        SetConstant (double bandwidth, double rtt, double loss);
+            /* bandwidth limited at all */
+            bool        Shaped      () const;
+
+            /* the step in effect `seconds` into the run */
+            NetworkStep At          (double seconds) const;
+
+        private:
+            std::vector<NetworkStep>    steps;
+    };
+
+    /* shared by all connections of a server, like one bottleneck link */
+    class TokenBucket
+    {
+        public:
+            TokenBucket             (const NetworkProfile &profile, size_t burst = SHAPING_BURST_BYTES);
+            virtual ~TokenBucket    ();
+
+            /* restarts the trace */
+            void    Reset           ();
+            double  Elapsed         () const;
+            /* takes the tokens of `bytes` and blocks until the link has
+             * carried them; waits out outages */
+            void    Send            (size_t bytes);
+
+        private:
+            typedef std::chrono::steady_clock clock;
+
+            const NetworkProfile    &profile;
+            double                  burst;
+            std::mutex              mutex;
+            clock::time_point       origin;
+            clock::time_point       last;
+            double                  tokens;     /* bytes, negative while sends are queued behind each other */
+    };
+}
+
+#endif /* NETWORKPROFILE_H_ */
@@ -0,0 +1,145 @@
+/*
+ * PackedCloud.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "PackedCloud.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace mcnl;
+
+PackedCloud::PackedCloud    () :
+             count          (0)
+{
+    memset(this->low, 0, sizeof(this->low));
+    memset(this->high, 0, sizeof(this->high));
+}
+PackedCloud::~PackedCloud   ()
+{
+}
+
+void    PackedCloud::Pack       (const pcc::PCCPointSet3 &frame)
+{
+    const size_t            count  = frame.getPointCount();
+    const pcc::PCCPoint3D   *points = count ? frame.getPositions().data() : NULL;
+    int32_t                 low[3]  = { 0, 0, 0 };
+    int32_t                 high[3] = { 0, 0, 0 };
+
+    for (size_t i = 0; i < count; i++)
+        for (int axis = 0; axis < 3; axis++)
+        {
+            low[axis]  = i ? std::min(low[axis], (int32_t) points[i][axis]) : points[i][axis];
+            high[axis] = i ? std::max(high[axis], (int32_t) points[i][axis]) : points[i][axis];
+        }
+
+    this->Reset(count, low, high);
+
+    for (size_t i = 0; i < count; i++)
+        this->Put(i, points[i][0], points[i][1], points[i][2]);
+
+    if (frame.hasColors() && count > 0)
+        this->colors.assign((const uint8_t *) frame.getColors().data(),
+                            (const uint8_t *) frame.getColors().data() + 3 * count);
+    else
+        this->colors.clear();
+}
+void    PackedCloud::Append     (const PackedCloud &other)
+{
+    if (other.count == 0)
+        return;
+    if (this->count == 0)
+    {
+        *this = other;
+        return;
+    }
+
+    /* both are unpacked into the box around both; a tile appended to
+     * another usually widens it */
+    PackedCloud first = std::move(*this);
+    int32_t     low[3], high[3];
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        low[axis]  = std::min(first.low[axis], other.low[axis]);
+        high[axis] = std::max(first.high[axis], other.high[axis]);
+    }
+
+    this->Reset(first.count + other.count, low, high);
+
+    const PackedCloud   *parts[2] = { &first, &other };
+    size_t              index     = 0;
+
+    for (const PackedCloud *part : parts)
+        for (size_t i = 0; i < part->count; i++, index++)
+        {
+            uint32_t offset[3];
+
+            part->Offset(i, offset);
+            this->Put(index, part->low[0] + offset[0], part->low[1] + offset[1], part->low[2] + offset[2]);
+        }
+
+    /* colors are kept only if both have them, so there is one per point */
+    if (first.HasColors() && other.HasColors())
+    {
+        this->colors = std::move(first.colors);
+        this->colors.insert(this->colors.end(), other.colors.begin(), other.colors.end());
+    }
+    else
+        this->colors.clear();
+}
+void    PackedCloud::Translate  (const int32_t offset[3])
+{
+    /* the points are stored relative to low */
+    for (int axis = 0; axis < 3; axis++)
+    {
+        this->low[axis]  += offset[axis];
+        this->high[axis] += offset[axis];
+    }
+}
+size_t  PackedCloud::Bytes      () const
+{
+    return this->narrow.capacity() * sizeof(uint32_t) + this->wide.capacity() * sizeof(uint16_t) +
+           this->colors.capacity();
+}
+void    PackedCloud::Reset      (size_t count, const int32_t low[3], const int32_t high[3])
+{
+    bool fits = true;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        this->low[axis]  = low[axis];
+        this->high[axis] = high[axis];
+        fits            &= high[axis] - low[axis] < PACKED_CLOUD_NARROW_SPAN;
+    }
+
+    this->count = count;
+
+    if (fits)
+    {
+        this->narrow.resize(count);
+        std::vector<uint16_t>().swap(this->wide);
+    }
+    else
+    {
+        this->wide.resize(3 * count);
+        std::vector<uint32_t>().swap(this->narrow);
+    }
+}
+void    PackedCloud::Put        (size_t i, int32_t x, int32_t y, int32_t z)
+{
+    const uint32_t dx = (uint32_t) (x - this->low[0]);
+    const uint32_t dy = (uint32_t) (y - this->low[1]);
+    const uint32_t dz = (uint32_t) (z - this->low[2]);
+
+    if (this->wide.empty())
+        this->narrow[i] = dx | dy << 10 | dz << 20;
+    else
+    {
+        this->wide[3 * i]     = (uint16_t) dx;
+        this->wide[3 * i + 1] = (uint16_t) dy;
+        this->wide[3 * i + 2] = (uint16_t) dz;
+    }
+}
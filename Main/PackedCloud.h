@@ -0,0 +1,84 @@
+/*
+ * PackedCloud.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Positions and colors of a decoded frame while it waits in the frame
+ * queue. The geometry is integer and at most a few bits wider than the
+ * geometry bit depth, so each position is kept relative to the smallest
+ * corner of the frame: three 10-bit offsets in 32 bits when every axis
+ * spans less than PACKED_CLOUD_NARROW_SPAN, three 16-bit offsets
+ * otherwise; colors are RGB8. A frame of 10-bit geometry takes 7 bytes a
+ * point, so the queue holds more frames in the same memory; it is
+ * expanded only where the renderer converts it for upload.
+ *****************************************************************************/
+
+#ifndef PACKEDCLOUD_H_
+#define PACKEDCLOUD_H_
+
+#include "PCCPointSet.h"
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#define PACKED_CLOUD_NARROW_SPAN    1024
+
+namespace mcnl
+{
+    class PackedCloud
+    {
+        public:
+            PackedCloud             ();
+            virtual ~PackedCloud    ();
+
+            /* replaces the contents with the positions and colors of frame */
+            void        Pack        (const pcc::PCCPointSet3 &frame);
+            /* adds the points of other, e.g. another tile of the same frame */
+            void        Append      (const PackedCloud &other);
+            /* moves every point by offset, e.g. to its place in a scene */
+            void        Translate   (const int32_t offset[3]);
+
+            size_t      Size        () const { return this->count; }
+            bool        HasColors   () const { return !this->colors.empty(); }
+            /* smallest and largest coordinates, equal to 0 when empty */
+            const int32_t*  Low     () const { return this->low; }
+            const int32_t*  High    () const { return this->high; }
+            /* offset of point i from Low() */
+            void        Offset      (size_t i, uint32_t offset[3]) const
+            {
+                if (!this->wide.empty())
+                {
+                    offset[0] = this->wide[3 * i];
+                    offset[1] = this->wide[3 * i + 1];
+                    offset[2] = this->wide[3 * i + 2];
+                }
+                else
+                {
+                    uint32_t packed = this->narrow[i];
+
+                    offset[0] = packed & 0x3ff;
+                    offset[1] = (packed >> 10) & 0x3ff;
+                    offset[2] = packed >> 20;
+                }
+            }
+            /* RGB8 of point i, with HasColors() */
+            const uint8_t*  Color   (size_t i) const { return &this->colors[3 * i]; }
+            /* heap bytes held */
+            size_t      Bytes       () const;
+
+        private:
+            size_t                  count;
+            int32_t                 low[3];
+            int32_t                 high[3];
+            std::vector<uint32_t>   narrow;     /* x | y << 10 | z << 20, when every span fits */
+            std::vector<uint16_t>   wide;       /* x, y, z otherwise */
+            std::vector<uint8_t>    colors;     /* r, g, b, empty without colors */
+
+            /* sizes the position storage for count points within the box low .. high */
+            void        Reset       (size_t count, const int32_t low[3], const int32_t high[3]);
+            void        Put         (size_t i, int32_t x, int32_t y, int32_t z);
+    };
+}
+
+#endif /* PACKEDCLOUD_H_ */
@@ -13,109 +13,289 @@
 
 using namespace libdashtest;
 using namespace dash::network;
+using namespace dash::metrics;
 
 PersistentHTTPConnection::PersistentHTTPConnection  () :
-                          HTTPConnection            ()
+                          HTTPConnection            (),
+                          isBroken                  (false)
 {
     InitializeConditionVariable (&this->chunkFinished);
     InitializeCriticalSection   (&this->monitorMutex);
+    InitializeCriticalSection   (&this->socketMutex);
+    InitializeCriticalSection   (&this->metricsMutex);
 }
 PersistentHTTPConnection::~PersistentHTTPConnection ()
 {
+    while(!this->chunkQueue.empty())
+    {
+        delete(this->chunkQueue.front());
+        this->chunkQueue.pop();
+    }
+
     DeleteConditionVariable(&this->chunkFinished);
     DeleteCriticalSection(&this->monitorMutex);
+    DeleteCriticalSection(&this->socketMutex);
+    DeleteCriticalSection(&this->metricsMutex);
 }
 
 int                 PersistentHTTPConnection::Peek              (uint8_t *data, size_t len, IChunk *chunk)
 {
-    EnterCriticalSection(&this->monitorMutex);
-
-    while(this->chunkQueue.front()->Chunk() != chunk && this->chunkQueue.size() > 0)
-        SleepConditionVariableCS(&this->chunkFinished, &this->monitorMutex, INFINITE);
-
-    HTTPChunk *front = this->chunkQueue.front();
+    HTTPChunk *front = this->AwaitTurn(chunk);
 
-    if(this->chunkQueue.size() == 0)
-    {
-        LeaveCriticalSection(&this->monitorMutex);
+    if(front == NULL)
         return -1;
-    }
-    if(front->BytesLeft() == 0)
+
+    if(front->HeaderParsed() == false && !this->ReadHeader(front))
+        return this->Fail();
+    if(front->BytesLeft() == 0 && !front->Finished() && !this->NextChunk(front))
+        return this->Fail();
+    if(front->Finished())
     {
-        LeaveCriticalSection(&this->monitorMutex);
+        LeaveCriticalSection(&this->socketMutex);
         return 0;
     }
-    if(front->HeaderParsed() == false)
-    {
-        this->ParseHeader();
-        front->HeaderParsed(true);
-        front->ContentLength(this->contentLength);
-    }
 
     if(len > front->BytesLeft())
         len = (size_t) front->BytesLeft();
 
-    size_t ret = HTTPConnection::Peek(data, len, chunk);
+    int ret = HTTPConnection::Peek(data, len, chunk);
 
-    LeaveCriticalSection(&this->monitorMutex);
+    if(ret <= 0)
+        return this->Fail();
+
+    LeaveCriticalSection(&this->socketMutex);
 
     return ret;
 }
 int                 PersistentHTTPConnection::Read              (uint8_t *data, size_t len, IChunk *chunk)
 {
-    EnterCriticalSection(&this->monitorMutex);
-
-    while(this->chunkQueue.front()->Chunk() != chunk && this->chunkQueue.size() > 0)
-        SleepConditionVariableCS(&this->chunkFinished, &this->monitorMutex, INFINITE);
+    HTTPChunk *front = this->AwaitTurn(chunk);
 
-    HTTPChunk *front = this->chunkQueue.front();
-
-    if(this->chunkQueue.size() == 0)
-    {
-        LeaveCriticalSection(&this->monitorMutex);
+    if(front == NULL)
         return -1;
-    }
-    if(front->HeaderParsed() == false)
-    {
-        this->ParseHeader();
-        front->HeaderParsed(true);
-        front->ContentLength(this->contentLength);
-    }
-    if(front->BytesLeft() == 0)
+
+    if(front->HeaderParsed() == false && !this->ReadHeader(front))
+        return this->Fail();
+    if(front->BytesLeft() == 0 && !front->Finished() && !this->NextChunk(front))
+        return this->Fail();
+    if(front->Finished())
     {
-        LeaveCriticalSection(&this->monitorMutex);
+        EnterCriticalSection(&this->monitorMutex);
+
+        /* a failed Schedule has released the transactions meanwhile */
+        if(this->isBroken)
+        {
+            LeaveCriticalSection(&this->monitorMutex);
+            LeaveCriticalSection(&this->socketMutex);
+            return -1;
+        }
+
+        EnterCriticalSection(&this->metricsMutex);
+        front->Transaction()->ResponseFinished();
+        this->httpTransactions.push_back(front->ReleaseTransaction());
+        LeaveCriticalSection(&this->metricsMutex);
+
         delete(front);
         this->chunkQueue.pop();
         WakeAllConditionVariable(&this->chunkFinished);
+        LeaveCriticalSection(&this->monitorMutex);
+        LeaveCriticalSection(&this->socketMutex);
         return 0;
     }
 
     if(len > front->BytesLeft())
         len = (size_t) front->BytesLeft();
 
-    size_t ret = HTTPConnection::Read(data, len, chunk);
+    int ret = HTTPConnection::Read(data, len, chunk);
 
-    if(ret > 0)
-        front->AddBytesRead(ret);
+    /* the body is not complete yet, so 0 means the peer went away */
+    if(ret <= 0)
+        return this->Fail();
 
-    LeaveCriticalSection(&this->monitorMutex);
+    front->AddBytesRead(ret);
+
+    EnterCriticalSection(&this->metricsMutex);
+    if(front->Transaction() != NULL)
+        front->Transaction()->AddReceivedBytes(ret);
+    LeaveCriticalSection(&this->metricsMutex);
+
+    LeaveCriticalSection(&this->socketMutex);
 
     return ret;
 }
+int64_t             PersistentHTTPConnection::ResponseLength    (IChunk *chunk, int64_t *resourceLength)
+{
+    HTTPChunk *front = this->AwaitTurn(chunk);
+
+    if(front == NULL)
+        return -1;
+
+    if(front->HeaderParsed() == false && !this->ReadHeader(front))
+        return this->Fail();
+
+    int64_t length = front->ContentLength();
+
+    if(resourceLength != NULL)
+        *resourceLength = front->ResourceLength();
+
+    LeaveCriticalSection(&this->socketMutex);
+
+    return length;
+}
+HTTPChunk*          PersistentHTTPConnection::AwaitTurn         (IChunk *chunk)
+{
+    EnterCriticalSection(&this->monitorMutex);
+
+    while(!this->isBroken && this->chunkQueue.size() > 0 && this->chunkQueue.front()->Chunk() != chunk)
+        SleepConditionVariableCS(&this->chunkFinished, &this->monitorMutex, INFINITE);
+
+    HTTPChunk *front = NULL;
+
+    if(!this->isBroken && this->chunkQueue.size() > 0)
+        front = this->chunkQueue.front();
+
+    LeaveCriticalSection(&this->monitorMutex);
+
+    /* the front only leaves the queue through its own reader, so it is still
+     * there; Schedule and Pending go on while the socket is read */
+    if(front != NULL)
+        EnterCriticalSection(&this->socketMutex);
+
+    return front;
+}
+bool                PersistentHTTPConnection::NextChunk         (HTTPChunk *front)
+{
+    /* called with socketMutex held: <hex size>[;ext]\r\n <data>\r\n ... 0\r\n <trailers>\r\n */
+    if(front->BytesRead() > 0 && this->ReadLine().compare("\r\n"))
+        return false;
+
+    std::string line = this->ReadLine();
+
+    if(line.size() == 0)
+        return false;
+
+    uint64_t size = strtoull(line.c_str(), NULL, 16);
+
+    front->NextChunk(size);
+
+    if(size > 0)
+        return true;
+
+    do
+    {
+        line = this->ReadLine();
+        if(line.size() == 0)
+            return false;
+    }while(line.compare("\r\n"));
+
+    return true;
+}
+bool                PersistentHTTPConnection::ReadHeader        (HTTPChunk *front)
+{
+    /* called with socketMutex held */
+    if(!this->ParseHeader())
+        return false;
+
+    front->HeaderParsed(true);
+    front->ContentLength(this->contentLength);
+    front->ResourceLength(this->resourceLength);
+    front->Chunked(this->isChunked);
+
+    EnterCriticalSection(&this->metricsMutex);
+    if(front->Transaction() != NULL)
+        front->Transaction()->ResponseReceived(this->response.status);
+    LeaveCriticalSection(&this->metricsMutex);
+
+    return true;
+}
+int                 PersistentHTTPConnection::Fail              ()
+{
+    /* called with socketMutex held, which it releases */
+    EnterCriticalSection(&this->monitorMutex);
+    this->Broken();
+    WakeAllConditionVariable(&this->chunkFinished);
+    LeaveCriticalSection(&this->monitorMutex);
+    LeaveCriticalSection(&this->socketMutex);
+    return -1;
+}
+void                PersistentHTTPConnection::Broken            ()
+{
+    /* called with monitorMutex held; every pending request fails, their
+     * metrics are kept without a completion time */
+    if(this->isBroken)
+        return;
+
+    std::queue<HTTPChunk *> pending = this->chunkQueue;
+
+    EnterCriticalSection(&this->metricsMutex);
+    for(; !pending.empty(); pending.pop())
+        this->httpTransactions.push_back(pending.front()->ReleaseTransaction());
+    LeaveCriticalSection(&this->metricsMutex);
+
+    this->isBroken = true;
+}
+size_t              PersistentHTTPConnection::Pending           ()
+{
+    EnterCriticalSection(&this->monitorMutex);
+    size_t pending = this->chunkQueue.size();
+    LeaveCriticalSection(&this->monitorMutex);
+
+    return pending;
+}
+bool                PersistentHTTPConnection::IsBroken          ()
+{
+    EnterCriticalSection(&this->monitorMutex);
+    bool broken = this->isBroken;
+    LeaveCriticalSection(&this->monitorMutex);
+
+    return broken;
+}
+void                PersistentHTTPConnection::Abort             ()
+{
+    EnterCriticalSection(&this->monitorMutex);
+    this->Broken();
+    WakeAllConditionVariable(&this->chunkFinished);
+    LeaveCriticalSection(&this->monitorMutex);
+
+    /* not closed here, the reader still uses the descriptor */
+    shutdown(this->httpSocket, SHUT_RDWR);
+}
+void                PersistentHTTPConnection::TakeMetrics       (std::vector<dash::metrics::IHTTPTransaction *> &transactions,
+                                                                 std::vector<dash::metrics::ITCPConnection *> &connections)
+{
+    /* sockets are only opened and closed while nobody else uses the
+     * connection, so the TCP records need no lock of their own */
+    EnterCriticalSection(&this->metricsMutex);
+
+    transactions.insert(transactions.end(), this->httpTransactions.begin(), this->httpTransactions.end());
+    this->httpTransactions.clear();
+
+    /* the open socket's record is still being written */
+    for(size_t i = 0; i < this->tcpConnections.size(); i++)
+        if(this->tcpConnections.at(i) != this->tcpConnection)
+            connections.push_back(this->tcpConnections.at(i));
+
+    this->tcpConnections.clear();
+    if(this->tcpConnection != NULL)
+        this->tcpConnections.push_back(this->tcpConnection);
+
+    LeaveCriticalSection(&this->metricsMutex);
+}
 std::string         PersistentHTTPConnection::PrepareRequest    (IChunk *chunk)
 {
     std::string request;
     if(!chunk->HasByteRange())
     {
         request = "GET "    + chunk->Path() + " HTTP/1.1" + "\r\n" +
-                  "Host: "  + chunk->Host() + "\r\n\r\n";
+                  "Host: "  + chunk->Host() + "\r\n" + this->requestHeaders + "\r\n";
     }
     else
     {
         std::stringstream req;
         req << "GET " << chunk->Path() << " HTTP/1.1\r\n" <<
                "Host: " << chunk->Host() << "\r\n" <<
-               "Range: bytes=" << chunk->StartByte() << "-" << chunk->EndByte() << "\r\n\r\n";
+               "Range: bytes=" << chunk->StartByte() << "-" << chunk->EndByte() << "\r\n" <<
+               this->requestHeaders << "\r\n";
 
         request = req.str();
     }
@@ -138,6 +318,10 @@ bool                PersistentHTTPConnection::Init              (IChunk *chunk)
     return this->isInit;
 }
 bool                PersistentHTTPConnection::Schedule          (IChunk *chunk)
+{
+    return this->Schedule(chunk, "");
+}
+bool                PersistentHTTPConnection::Schedule          (IChunk *chunk, const std::string &headers)
 {
     if(chunk->Host() != this->hostname)
         return false;
@@ -145,13 +329,45 @@ bool                PersistentHTTPConnection::Schedule          (IChunk *chunk)
     if(!this->isInit)
         return false;
 
-    if(this->SendData(this->PrepareRequest(chunk)))
+    /* requests are pipelined: the response order is the queue order */
+    EnterCriticalSection(&this->monitorMutex);
+
+    this->requestHeaders = headers;
+
+    HTTPChunk       *entry       = new HTTPChunk(chunk);
+    HTTPTransaction *transaction = entry->Transaction();
+    std::stringstream url;
+
+    url << "http://" << chunk->Host() << ":" << chunk->Port() << chunk->Path();
+
+    transaction->SetTCPId(this->tcpConnection != NULL ? this->tcpConnection->TCPId() : 0);
+    transaction->SetType(chunk->GetType());
+    transaction->SetOriginalUrl(url.str());
+    transaction->SetActualUrl(url.str());
+    if(chunk->HasByteRange())
     {
-        this->chunkQueue.push(new HTTPChunk(chunk));
-        return true;
+        std::stringstream range;
+        range << chunk->StartByte() << "-" << chunk->EndByte();
+        transaction->SetRange(range.str());
     }
+    transaction->RequestSent();
 
-    return false;
+    bool sent = !this->isBroken && this->SendData(this->PrepareRequest(chunk));
+
+    /* a reconnect resends a plain request */
+    this->requestHeaders.clear();
+
+    if(sent)
+        this->chunkQueue.push(entry);
+    else
+    {
+        delete entry;
+        this->Broken();
+    }
+
+    LeaveCriticalSection(&this->monitorMutex);
+
+    return sent;
 }
 bool                PersistentHTTPConnection::InitChunk         (IChunk *chunk)
 {
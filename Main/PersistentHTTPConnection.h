@@ -32,13 +32,47 @@ namespace libdashtest
             virtual int     Read        (uint8_t *data, size_t len, dash::network::IChunk *chunk);
             virtual bool    Init        (dash::network::IChunk *chunk);
             virtual bool    Schedule    (dash::network::IChunk *chunk);
+            /* headers are extra request header lines, each ending in \r\n */
+            bool            Schedule    (dash::network::IChunk *chunk, const std::string &headers);
+
+            /* Content-Length of the response to chunk (waits for its turn and
+             * parses the header), 0 for a chunked body, -1 if the connection
+             * failed. resourceLength
+             * receives the complete length from Content-Range, -1 if absent. */
+            int64_t         ResponseLength  (dash::network::IChunk *chunk, int64_t *resourceLength = NULL);
+            /* requests sent but not yet read to the end */
+            size_t          Pending     ();
+            /* the peer closed or reset the connection; pending requests fail */
+            bool            IsBroken    ();
+            /* from another thread: shuts the socket down, so that a read
+             * blocked on it returns; the connection is broken from then on
+             * and the pool closes it once released */
+            void            Abort       ();
+            /* moves the metrics of completed requests and closed sockets to
+             * the caller, who owns them from then on */
+            void            TakeMetrics (std::vector<dash::metrics::IHTTPTransaction *> &transactions,
+                                         std::vector<dash::metrics::ITCPConnection *> &connections);
 
         private:
             std::queue<HTTPChunk *> chunkQueue;
             std::string             hostname;
-            CRITICAL_SECTION        monitorMutex;
+            CRITICAL_SECTION        monitorMutex;       /* chunkQueue and isBroken; never held while reading the socket */
             CONDITION_VARIABLE      chunkFinished;
+            CRITICAL_SECTION        socketMutex;        /* the receiving side and the header state, held by the front's reader */
+            CRITICAL_SECTION        metricsMutex;       /* httpTransactions; never waits on the socket */
             uint64_t                bytesDownloadedChunk;
+            bool                    isBroken;
+            std::string             requestHeaders;     /* for the request being sent */
+
+            /* waits until the response to chunk is next; on success returns its
+             * entry with socketMutex held, NULL if the connection failed */
+            HTTPChunk*      AwaitTurn   (dash::network::IChunk *chunk);
+            int             Fail        ();
+            void            Broken      ();
+            /* parses the response header of front */
+            bool            ReadHeader  (HTTPChunk *front);
+            /* reads the next chunk size line of a chunked body */
+            bool            NextChunk   (HTTPChunk *front);
 
         protected:
             virtual std::string PrepareRequest  (dash::network::IChunk *chunk);
@@ -0,0 +1,174 @@
+/*
+ * PointBudget.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "PointBudget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace mcnl;
+
+namespace
+{
+    /* every bit of x moved to bit 3 * i, for 21-bit x */
+    uint64_t    SpreadBits  (uint64_t x)
+    {
+        x &= 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffffULL;
+        x = (x | x << 16) & 0x1f0000ff0000ffULL;
+        x = (x | x << 8)  & 0x100f00f00f00f00fULL;
+        x = (x | x << 4)  & 0x10c30c30c30c30c3ULL;
+        x = (x | x << 2)  & 0x1249249249249249ULL;
+        return x;
+    }
+    uint32_t    ReverseBits (uint32_t x, int bits)
+    {
+        uint32_t r = 0;
+
+        for (int i = 0; i < bits; i++, x >>= 1)
+            r = (r << 1) | (x & 1);
+        return r;
+    }
+}
+
+PointBudget::PointBudget    (double frameTarget) :
+             frameTarget    (frameTarget),
+             secondsPerPoint(0),
+             tanHalfFov     (0),
+             viewportHeight (0),
+             hasView        (false)
+{
+    memset(this->eye, 0, sizeof(this->eye));
+}
+PointBudget::~PointBudget   ()
+{
+}
+
+void    PointBudget::SetView        (const float eye[3], double fieldOfView, double viewportHeight)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    memcpy(this->eye, eye, sizeof(this->eye));
+    this->tanHalfFov     = std::tan(fieldOfView * M_PI / 360.0);
+    this->viewportHeight = viewportHeight;
+    this->hasView        = this->tanHalfFov > 0 && viewportHeight > 0;
+}
+void    PointBudget::OnPresent      (size_t points, double seconds)
+{
+    if (points == 0 || seconds <= 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    double sample = seconds / points;
+
+    this->secondsPerPoint = this->secondsPerPoint > 0 ?
+                            LOD_COST_ALPHA * sample + (1 - LOD_COST_ALPHA) * this->secondsPerPoint : sample;
+}
+size_t  PointBudget::Budget         (const double center[3], double radius, size_t count) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    double budget = (double) count;
+
+    if (this->hasView)
+    {
+        double distance = 0;
+
+        for (int axis = 0; axis < 3; axis++)
+            distance += (center[axis] - this->eye[axis]) * (center[axis] - this->eye[axis]);
+        distance = std::sqrt(distance) - radius;
+
+        /* inside the sphere the object fills the view */
+        if (distance > 0)
+        {
+            double pixels = radius / (distance * this->tanHalfFov) * this->viewportHeight / 2;
+
+            budget = std::min(budget, M_PI * pixels * pixels * LOD_POINTS_PER_PIXEL);
+        }
+    }
+    if (this->frameTarget > 0 && this->secondsPerPoint > 0)
+        budget = std::min(budget, this->frameTarget / this->secondsPerPoint);
+
+    budget = std::max(budget, (double) LOD_MIN_POINTS);
+    return std::min(count, (size_t) budget);
+}
+
+void    mcnl::BoundingSphere    (const PackedCloud &frame, double center[3], double &radius)
+{
+    /* the box the frame was packed in */
+    const int32_t   *low  = frame.Low();
+    const int32_t   *high = frame.High();
+    double          sum   = 0;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        double span = high[axis] - low[axis];
+
+        center[axis] = (low[axis] + high[axis]) / 2.0;
+        sum         += span * span;
+    }
+    radius = std::sqrt(sum) / 2;
+}
+const std::vector<uint32_t>&    MortonOrder::Compute    (const PackedCloud &frame)
+{
+    const size_t            count  = frame.Size();
+
+    this->codes.resize(count);
+    this->sorted.resize(count);
+    this->scratch.resize(count);
+    this->order.clear();
+
+    if (count == 0)
+        return this->order;
+
+    /* the packed offsets are relative to the smallest positions, so negative ones work too */
+    uint64_t highest = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t offset[3];
+
+        frame.Offset(i, offset);
+        this->codes[i] = SpreadBits(offset[0]) | SpreadBits(offset[1]) << 1 | SpreadBits(offset[2]) << 2;
+        this->sorted[i] = (uint32_t) i;
+        highest |= this->codes[i];
+    }
+
+    /* LSD radix sort of the indices by code, one byte per pass, only the
+     * bytes the codes use; stable, so equal codes keep the decoder's order */
+    for (int shift = 0; shift < 64 && (highest >> shift) != 0; shift += 8)
+    {
+        size_t counts[257] = { 0 };
+
+        for (size_t i = 0; i < count; i++)
+            counts[((this->codes[this->sorted[i]] >> shift) & 0xff) + 1]++;
+        for (int digit = 0; digit < 256; digit++)
+            counts[digit + 1] += counts[digit];
+        for (size_t i = 0; i < count; i++)
+            this->scratch[counts[(this->codes[this->sorted[i]] >> shift) & 0xff]++] = this->sorted[i];
+
+        this->sorted.swap(this->scratch);
+    }
+
+    /* ranks in bit-reversed order: 0, n/2, n/4, 3n/4, ... */
+    int bits = 0;
+
+    while (((size_t) 1 << bits) < count)
+        bits++;
+
+    this->order.reserve(count);
+
+    for (uint64_t rank = 0; rank < ((uint64_t) 1 << bits); rank++)
+    {
+        uint32_t reversed = ReverseBits((uint32_t) rank, bits);
+
+        if (reversed < count)
+            this->order.push_back(this->sorted[reversed]);
+    }
+    return this->order;
+}
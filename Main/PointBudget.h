@@ -0,0 +1,80 @@
+/*
+ * PointBudget.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Render-side level of detail. Uploading and drawing every point of every
+ * frame costs the same whether the object fills the view or is a few
+ * pixels tall, so the renderer only hands a budget of points to Open3D:
+ * no more than the object covers on screen at the current camera
+ * distance, and no more than the measured upload + draw time per point
+ * allows within the frame time target.
+ *
+ * The points are decimated by taking a prefix of a Morton order whose
+ * ranks are visited in bit-reversed order: any prefix is spread evenly
+ * along the Z-curve and so is a spatially uniform subsample, and a new
+ * budget only changes how much of the same order is used.
+ *****************************************************************************/
+
+#ifndef POINTBUDGET_H_
+#define POINTBUDGET_H_
+
+#include "PackedCloud.h"
+
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#define LOD_POINTS_PER_PIXEL    2.0     /* of the projected bounding sphere; about half the surface faces away */
+#define LOD_MIN_POINTS          20000
+#define LOD_COST_ALPHA          0.2     /* EWMA weight of the newest present time */
+
+namespace mcnl
+{
+    class PointBudget
+    {
+        public:
+            /* seconds of upload + draw per frame, 0 = no time limit */
+            PointBudget             (double frameTarget);
+            virtual ~PointBudget    ();
+
+            /* camera from the UI thread: position, vertical field of view in
+             * degrees, viewport height in pixels */
+            void    SetView         (const float eye[3], double fieldOfView, double viewportHeight);
+            /* time it took the UI thread to upload and draw a frame of points */
+            void    OnPresent       (size_t points, double seconds);
+            /* points worth drawing of count points inside the sphere; count
+             * until the first SetView */
+            size_t  Budget          (const double center[3], double radius, size_t count) const;
+
+        private:
+            mutable std::mutex  mutex;
+            double              frameTarget;
+            double              secondsPerPoint;    /* 0 until measured */
+            float               eye[3];
+            double              tanHalfFov;
+            double              viewportHeight;
+            bool                hasView;
+    };
+
+    /* smallest box around the positions, as a sphere */
+    void    BoundingSphere  (const PackedCloud &frame, double center[3], double &radius);
+
+    /* Morton order of the points of a frame, see above. The buffers are
+     * kept, so a frame of the same size costs no allocation */
+    class MortonOrder
+    {
+        public:
+            /* order[i] is the i-th point to draw */
+            const std::vector<uint32_t>&    Compute (const PackedCloud &frame);
+
+        private:
+            std::vector<uint64_t>   codes;
+            std::vector<uint32_t>   sorted;
+            std::vector<uint32_t>   scratch;
+            std::vector<uint32_t>   order;
+    };
+}
+
+#endif /* POINTBUDGET_H_ */
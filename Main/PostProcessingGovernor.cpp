@@ -0,0 +1,64 @@
+/*
+ * PostProcessingGovernor.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "PostProcessingGovernor.h"
+
+#include <iostream>
+
+using namespace mcnl;
+
+PostProcessingGovernor::PostProcessingGovernor  (double low, double high, size_t hold) :
+                        low                     (low),
+                        high                    (high),
+                        hold                    (hold),
+                        level                   (pcc::POST_PROCESSING_FULL),
+                        held                    (hold),
+                        reduced                 (0)
+{
+}
+PostProcessingGovernor::~PostProcessingGovernor ()
+{
+}
+
+pcc::PCCPostProcessing  PostProcessingGovernor::Next    (double slack)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    pcc::PCCPostProcessing next = this->level;
+
+    if (this->held >= this->hold)
+    {
+        if (slack < this->low && this->level != pcc::POST_PROCESSING_NONE)
+            next = (pcc::PCCPostProcessing) (this->level + 1);
+        else if (slack > this->high && this->level != pcc::POST_PROCESSING_FULL)
+            next = (pcc::PCCPostProcessing) (this->level - 1);
+    }
+
+    if (next != this->level)
+    {
+        std::cout << "PostProcessingGovernor: slack " << slack << " s, post-processing level " << this->level <<
+                     " -> " << next << std::endl;
+        this->level = next;
+        this->held  = 0;
+    }
+    this->held++;
+    if (this->level != pcc::POST_PROCESSING_FULL)
+        this->reduced++;
+
+    return this->level;
+}
+pcc::PCCPostProcessing  PostProcessingGovernor::Level   () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->level;
+}
+size_t                  PostProcessingGovernor::Reduced () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->reduced;
+}
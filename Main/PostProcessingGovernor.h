@@ -0,0 +1,55 @@
+/*
+ * PostProcessingGovernor.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Graceful degradation of the decoder post-processing (geometry smoothing,
+ * colour transfer, attribute smoothing, occupancy synthesis). Each frame
+ * gets a level from its slack, the time the frames already queued for the
+ * renderer take to play: with less than `low` seconds it risks missing its
+ * display time and the level steps down, full to reduced to none (see
+ * pcc::PCCPostProcessing); with more than `high` it steps back up. A level
+ * is kept for at least `hold` frames, so a single slow frame or a burst of
+ * fast ones does not make it flap.
+ *****************************************************************************/
+
+#ifndef POSTPROCESSINGGOVERNOR_H_
+#define POSTPROCESSINGGOVERNOR_H_
+
+#include "PCCDecoderParameters.h"
+
+#include <mutex>
+#include <stddef.h>
+
+#define POST_PROCESSING_LOW_SLACK   0.25    /* seconds */
+#define POST_PROCESSING_HIGH_SLACK  1.0     /* seconds */
+#define POST_PROCESSING_HOLD        15      /* frames */
+
+namespace mcnl
+{
+    class PostProcessingGovernor
+    {
+        public:
+            PostProcessingGovernor          (double low = POST_PROCESSING_LOW_SLACK,
+                                             double high = POST_PROCESSING_HIGH_SLACK,
+                                             size_t hold = POST_PROCESSING_HOLD);
+            virtual ~PostProcessingGovernor ();
+
+            /* level of the next frame, slack in seconds; from any decoder thread */
+            pcc::PCCPostProcessing  Next    (double slack);
+            pcc::PCCPostProcessing  Level   () const;
+            /* frames that got less than the full post-processing */
+            size_t                  Reduced () const;
+
+        private:
+            mutable std::mutex      mutex;
+            double                  low;
+            double                  high;
+            size_t                  hold;
+            pcc::PCCPostProcessing  level;
+            size_t                  held;       /* frames since the last change */
+            size_t                  reduced;
+    };
+}
+
+#endif /* POSTPROCESSINGGOVERNOR_H_ */
@@ -0,0 +1,102 @@
+/*
+ * PresentationClock.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "PresentationClock.h"
+
+#include <thread>
+
+using namespace mcnl;
+
+PresentationClock::PresentationClock    (double rebufferThreshold) :
+                   rebufferThreshold    (rebufferThreshold),
+                   started              (false),
+                   presented            (0),
+                   dropped              (0),
+                   rebuffers            (0),
+                   stalled              (0)
+{
+}
+PresentationClock::~PresentationClock   ()
+{
+}
+
+double          PresentationClock::Timestamp    (size_t segment, size_t frame, size_t framesPerSegment, double frameRate)
+{
+    if (frameRate <= 0)
+        frameRate = DEFAULT_FRAME_RATE;
+
+    return (segment * framesPerSegment + frame) / frameRate;
+}
+PresentAction   PresentationClock::Schedule     (double pts, double frameRate)
+{
+    PresentAction action = this->Admit(pts, frameRate);
+
+    if (action == PRESENT_FRAME)
+        this->Wait(pts);
+    return action;
+}
+PresentAction   PresentationClock::Admit        (double pts, double frameRate)
+{
+    if (frameRate <= 0)
+        frameRate = DEFAULT_FRAME_RATE;
+
+    clock::time_point now = clock::now();
+
+    if (!this->started)
+    {
+        this->origin  = now - std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(pts));
+        this->started = true;
+    }
+
+    clock::time_point due  = this->origin + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(pts));
+    double            late = std::chrono::duration<double>(now - due).count();
+
+    if (late > this->rebufferThreshold)
+    {
+        /* stalled: the last frame was repeated meanwhile, restart from here */
+        this->origin += std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(late));
+        this->rebuffers++;
+        this->stalled += late;
+        this->presented++;
+        return PRESENT_FRAME;
+    }
+
+    if (late > 1.0 / frameRate)
+    {
+        this->dropped++;
+        return DROP_FRAME;
+    }
+
+    this->presented++;
+    return PRESENT_FRAME;
+}
+void            PresentationClock::Wait         (double pts) const
+{
+    clock::time_point due = this->origin + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(pts));
+
+    if (due > clock::now())
+        std::this_thread::sleep_until(due);
+}
+void            PresentationClock::Reset        ()
+{
+    this->started = false;
+}
+size_t          PresentationClock::Presented    () const
+{
+    return this->presented;
+}
+size_t          PresentationClock::Dropped      () const
+{
+    return this->dropped;
+}
+size_t          PresentationClock::Rebuffers    () const
+{
+    return this->rebuffers;
+}
+double          PresentationClock::StallSeconds () const
+{
+    return this->stalled;
+}
@@ -0,0 +1,67 @@
+/*
+ * PresentationClock.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Paces rendered frames against their presentation timestamps. Frames that
+ * are more than one frame period late are dropped; after a stall (nothing
+ * to show for longer than the rebuffer threshold) the clock is rebased so
+ * playback resumes instead of dropping everything that was queued. While
+ * waiting for the next frame the renderer keeps showing (repeats) the last.
+ *****************************************************************************/
+
+#ifndef PRESENTATIONCLOCK_H_
+#define PRESENTATIONCLOCK_H_
+
+#include <chrono>
+#include <stddef.h>
+
+#define DEFAULT_FRAME_RATE      30.0
+#define REBUFFER_THRESHOLD      0.5     /* seconds */
+
+namespace mcnl
+{
+    enum PresentAction
+    {
+        PRESENT_FRAME,
+        DROP_FRAME
+    };
+
+    class PresentationClock
+    {
+        public:
+            PresentationClock           (double rebufferThreshold = REBUFFER_THRESHOLD);
+            virtual ~PresentationClock  ();
+
+            /* presentation time in seconds of frame `frame` of segment `segment` */
+            static double   Timestamp   (size_t segment, size_t frame, size_t framesPerSegment, double frameRate);
+
+            /* Blocks until pts is due and returns PRESENT_FRAME, or returns
+             * DROP_FRAME immediately if the frame is already too late. */
+            PresentAction   Schedule    (double pts, double frameRate);
+            /* Schedule in two steps, for a frame prepared in between: Admit
+             * decides without waiting, Wait then blocks until pts is due. */
+            PresentAction   Admit       (double pts, double frameRate);
+            void            Wait        (double pts) const;
+            void            Reset       ();
+
+            size_t          Presented   () const;
+            size_t          Dropped     () const;
+            size_t          Rebuffers   () const;
+            /* seconds the last frame was repeated for during rebuffers */
+            double          StallSeconds() const;
+
+        private:
+            typedef std::chrono::steady_clock clock;
+
+            double              rebufferThreshold;
+            bool                started;
+            clock::time_point   origin;         /* wall time of pts 0 */
+            size_t              presented;
+            size_t              dropped;
+            size_t              rebuffers;
+            double              stalled;
+    };
+}
+
+#endif /* PRESENTATIONCLOCK_H_ */
@@ -0,0 +1,98 @@
+/*
+ * SampleStreamParser.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "SampleStreamParser.h"
+
+#include <string.h>
+
+using namespace mcnl;
+using namespace pcc;
+
+SampleStreamParser::SampleStreamParser  (SampleStreamV3CUnit &ssvu) :
+                    ssvu                (ssvu),
+                    pos                 (0),
+                    haveHeader          (false),
+                    precision           (0),
+                    headerBytes         (0)
+{
+}
+SampleStreamParser::~SampleStreamParser ()
+{
+}
+
+size_t  SampleStreamParser::Feed        (const uint8_t *data, size_t len)
+{
+    /* drop what was parsed already before the buffer grows again */
+    if (this->pos > 0 && this->pos * 2 >= this->buffer.size())
+    {
+        this->buffer.erase(this->buffer.begin(), this->buffer.begin() + this->pos);
+        this->pos = 0;
+    }
+    this->buffer.insert(this->buffer.end(), data, data + len);
+
+    if (!this->haveHeader)
+    {
+        if (this->buffer.size() - this->pos < 1)
+            return 0;
+
+        /* ssvh_unit_size_precision_bytes_minus1 u(3), reserved u(5) */
+        uint8_t header = this->buffer[this->pos++];
+
+        this->ssvu.setSsvhUnitSizePrecisionBytesMinus1(header >> 5);
+        this->precision    = (header >> 5) + 1;
+        this->haveHeader   = true;
+        this->headerBytes += 1;
+    }
+
+    size_t units = 0;
+
+    while (this->buffer.size() - this->pos >= this->precision)
+    {
+        const uint8_t   *p   = this->buffer.data() + this->pos;
+        size_t          size = 0;
+
+        for (size_t i = 0; i < this->precision; i++)
+            size = (size << 8) | p[i];
+
+        if (this->buffer.size() - this->pos - this->precision < size)
+            break;
+
+        p += this->precision;
+
+        V3CUnit &unit = this->ssvu.addV3CUnit();
+        unit.setSize(size);
+        unit.allocate();
+        /* vuh_unit_type is the first 5 bits of the unit */
+        unit.setType(size > 0 ? static_cast<V3CUnitType>(p[0] >> 3) : V3C_RSVD_05);
+        if (size > 0)
+            memcpy(unit.getBitstream().buffer(), p, size);
+
+        this->pos         += this->precision + size;
+        this->headerBytes += this->precision;
+        units++;
+    }
+
+    return units;
+}
+size_t  SampleStreamParser::HeaderBytes () const
+{
+    return this->headerBytes;
+}
+size_t  SampleStreamParser::Buffered    () const
+{
+    return this->buffer.size() - this->pos;
+}
+
+bool    mcnl::HasCompleteGof            (SampleStreamV3CUnit &ssvu)
+{
+    std::vector<V3CUnit> &units = ssvu.getV3CUnit();
+
+    for (size_t i = 1; i < units.size(); i++)
+        if (units[i].getType() == V3C_VPS)
+            return true;
+
+    return false;
+}
@@ -0,0 +1,50 @@
+/*
+ * SampleStreamParser.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Incremental reader for the V3C sample stream format (ISO/IEC 23090-5
+ * Annex C): bytes can be fed in pieces of any size, and every V3C unit is
+ * appended to the SampleStreamV3CUnit as soon as its last byte arrived.
+ *****************************************************************************/
+
+#ifndef SAMPLESTREAMPARSER_H_
+#define SAMPLESTREAMPARSER_H_
+
+#include "PCCCommon.h"
+#include "PCCSampleStreamV3CUnit.h"
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace mcnl
+{
+    class SampleStreamParser
+    {
+        public:
+            SampleStreamParser          (pcc::SampleStreamV3CUnit &ssvu);
+            virtual ~SampleStreamParser ();
+
+            /* returns the number of complete units added to ssvu */
+            size_t  Feed                (const uint8_t *data, size_t len);
+
+            /* bytes of the sample stream header and the unit size fields */
+            size_t  HeaderBytes         () const;
+            /* bytes of a unit that has not fully arrived yet */
+            size_t  Buffered            () const;
+
+        private:
+            pcc::SampleStreamV3CUnit    &ssvu;
+            std::vector<uint8_t>        buffer;
+            size_t                      pos;
+            bool                        haveHeader;
+            size_t                      precision;      /* bytes per unit size field */
+            size_t                      headerBytes;
+    };
+
+    /* true once the front GOF is complete, i.e. another VPS follows it */
+    bool    HasCompleteGof  (pcc::SampleStreamV3CUnit &ssvu);
+}
+
+#endif /* SAMPLESTREAMPARSER_H_ */
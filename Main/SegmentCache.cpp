@@ -0,0 +1,335 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "SegmentCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#define SEGMENT_CACHE_MAGIC     "MCNLSEG1"
+#define SEGMENT_CACHE_SUFFIX    ".seg"
+
+using namespace mcnl;
+
+namespace
+{
+    /* a line of a file header; false at the end of the file */
+    bool    ReadLine    (FILE *file, std::string &line)
+    {
+        int c;
+
+        line.clear();
+        while ((c = fgetc(file)) != EOF && c != '\n')
+            line.push_back((char) c);
+        return c == '\n';
+    }
+    /* magic, key and validators; size is what is left for the segment */
+    bool    ReadHeader  (FILE *file, std::string &key, std::string &etag, std::string &lastModified, size_t &size)
+    {
+        std::string magic;
+        struct stat info;
+
+        if (!ReadLine(file, magic) || magic != SEGMENT_CACHE_MAGIC || !ReadLine(file, key) ||
+            !ReadLine(file, etag) || !ReadLine(file, lastModified) || fstat(fileno(file), &info) != 0)
+            return false;
+
+        long header = ftell(file);
+
+        if (header < 0 || info.st_size < header)
+            return false;
+        size = (size_t) (info.st_size - header);
+        return true;
+    }
+}
+
+SegmentCache::SegmentCache  (size_t memoryBytes, const std::string &directory, size_t diskBytes) :
+              directory     (directory),
+              memoryBytes   (memoryBytes),
+              diskBytes     (directory.empty() ? 0 : diskBytes),
+              memoryUsed    (0),
+              diskUsed      (0),
+              clock         (0)
+{
+    if (this->diskBytes == 0)
+        return;
+
+    mkdir(this->directory.c_str(), 0755);
+    this->Scan();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->Evict();
+}
+SegmentCache::~SegmentCache ()
+{
+}
+
+bool    SegmentCache::Lookup        (const std::string &key, std::vector<uint8_t> &data, bool &fresh,
+                                     std::string &etag, std::string &lastModified)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::map<std::string, Entry>::iterator entry = this->entries.find(key);
+
+    if (entry == this->entries.end())
+        return false;
+
+    if (!entry->second.data)
+    {
+        if (!this->ReadFile(key, entry->second))
+        {
+            this->DropDisk(entry);
+            return false;
+        }
+        this->memoryUsed += entry->second.bytes;
+    }
+    if (entry->second.onDisk)
+        utime(this->Path(key).c_str(), NULL);
+
+    entry->second.used  = ++this->clock;
+    data                = *entry->second.data;
+    fresh               = entry->second.fresh;
+    etag                = entry->second.etag;
+    lastModified        = entry->second.lastModified;
+
+    /* the entry just read may push out an older one */
+    this->Evict();
+    return true;
+}
+void    SegmentCache::Confirm       (const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::map<std::string, Entry>::iterator entry = this->entries.find(key);
+
+    if (entry == this->entries.end())
+        return;
+
+    entry->second.fresh = true;
+    entry->second.used  = ++this->clock;
+    if (entry->second.onDisk)
+        utime(this->Path(key).c_str(), NULL);
+}
+void    SegmentCache::Store         (const std::string &key, const std::vector<uint8_t> &data,
+                                     const std::string &etag, const std::string &lastModified)
+{
+    /* a segment larger than the whole budget would only push out everything else */
+    if (data.size() > std::max(this->memoryBytes, this->diskBytes) || key.find('\n') != std::string::npos ||
+        etag.find('\n') != std::string::npos || lastModified.find('\n') != std::string::npos)
+        return;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::map<std::string, Entry>::iterator entry = this->entries.find(key);
+
+    if (entry != this->entries.end())
+    {
+        if (entry->second.data)
+            this->memoryUsed -= entry->second.bytes;
+        if (entry->second.onDisk)
+            this->diskUsed -= entry->second.bytes;
+    }
+    else
+        entry = this->entries.insert(std::make_pair(key, Entry())).first;
+
+    Entry &stored = entry->second;
+
+    stored.etag         = etag;
+    stored.lastModified = lastModified;
+    stored.bytes        = data.size();
+    stored.data         = std::make_shared<std::vector<uint8_t> >(data);
+    stored.fresh        = true;
+    stored.used         = ++this->clock;
+    stored.onDisk       = data.size() <= this->diskBytes && this->WriteFile(key, stored);
+
+    this->memoryUsed += stored.bytes;
+    if (stored.onDisk)
+        this->diskUsed += stored.bytes;
+    else if (this->diskBytes > 0)
+        remove(this->Path(key).c_str());
+
+    this->Evict();
+}
+void    SegmentCache::Remove        (const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::map<std::string, Entry>::iterator entry = this->entries.find(key);
+
+    if (entry == this->entries.end())
+        return;
+
+    if (entry->second.data)
+    {
+        this->memoryUsed -= entry->second.bytes;
+        entry->second.data.reset();
+    }
+    this->DropDisk(entry);
+}
+
+std::string SegmentCache::Path      (const std::string &key) const
+{
+    /* FNV-1a: the key itself, a URL, is no file name */
+    uint64_t    hash = 0xcbf29ce484222325ULL;
+    char        name[17];
+
+    for (size_t i = 0; i < key.size(); i++)
+        hash = (hash ^ (uint8_t) key[i]) * 0x100000001b3ULL;
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long) hash);
+    return this->directory + "/" + name + SEGMENT_CACHE_SUFFIX;
+}
+void    SegmentCache::Scan          ()
+{
+    DIR *dir = opendir(this->directory.c_str());
+
+    if (dir == NULL)
+        return;
+
+    std::vector<std::pair<time_t, std::string> >    found;
+    struct dirent                                   *item;
+    size_t                                          suffix = strlen(SEGMENT_CACHE_SUFFIX);
+
+    while ((item = readdir(dir)) != NULL)
+    {
+        std::string name = item->d_name;
+
+        if (name.size() <= suffix || name.compare(name.size() - suffix, suffix, SEGMENT_CACHE_SUFFIX) != 0)
+            continue;
+
+        std::string path = this->directory + "/" + name;
+        FILE        *file = fopen(path.c_str(), "rb");
+        struct stat info;
+        std::string key;
+        Entry       entry;
+
+        if (file == NULL)
+            continue;
+
+        bool ok = ReadHeader(file, key, entry.etag, entry.lastModified, entry.bytes) &&
+                  fstat(fileno(file), &info) == 0 && this->Path(key) == path && this->entries.count(key) == 0;
+
+        fclose(file);
+        if (!ok)
+        {
+            remove(path.c_str());
+            continue;
+        }
+
+        entry.onDisk    = true;
+        entry.fresh     = false;
+        entry.used      = 0;
+        this->entries.insert(std::make_pair(key, entry));
+        this->diskUsed += entry.bytes;
+        found.push_back(std::make_pair(info.st_mtime, key));
+    }
+    closedir(dir);
+
+    /* the last session's order of use, from the modification times Lookup and Confirm touch */
+    std::sort(found.begin(), found.end());
+    for (size_t i = 0; i < found.size(); i++)
+        this->entries[found[i].second].used = ++this->clock;
+}
+bool    SegmentCache::ReadFile      (const std::string &key, Entry &entry)
+{
+    FILE *file = fopen(this->Path(key).c_str(), "rb");
+
+    if (file == NULL)
+        return false;
+
+    std::string stored;
+    std::string etag;
+    std::string lastModified;
+    size_t      size;
+    bool        ok = ReadHeader(file, stored, etag, lastModified, size) && stored == key && size == entry.bytes;
+
+    std::shared_ptr<std::vector<uint8_t> > data;
+
+    if (ok)
+    {
+        data = std::make_shared<std::vector<uint8_t> >(size);
+        ok   = size == 0 || fread(data->data(), 1, size, file) == size;
+    }
+    fclose(file);
+
+    if (!ok)
+        return false;
+
+    entry.data = data;
+    return true;
+}
+bool    SegmentCache::WriteFile     (const std::string &key, const Entry &entry)
+{
+    std::string path      = this->Path(key);
+    std::string temporary = path + ".tmp";
+    FILE        *file     = fopen(temporary.c_str(), "wb");
+
+    if (file == NULL)
+        return false;
+
+    std::string header = std::string(SEGMENT_CACHE_MAGIC) + "\n" + key + "\n" + entry.etag + "\n" +
+                         entry.lastModified + "\n";
+    bool        ok     = fwrite(header.data(), 1, header.size(), file) == header.size() &&
+                         (entry.bytes == 0 || fwrite(entry.data->data(), 1, entry.bytes, file) == entry.bytes);
+
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+void    SegmentCache::DropMemory    (std::map<std::string, Entry>::iterator entry)
+{
+    if (entry->second.data)
+    {
+        this->memoryUsed -= entry->second.bytes;
+        entry->second.data.reset();
+    }
+    if (!entry->second.onDisk)
+        this->entries.erase(entry);
+}
+void    SegmentCache::DropDisk      (std::map<std::string, Entry>::iterator entry)
+{
+    if (entry->second.onDisk)
+    {
+        remove(this->Path(entry->first).c_str());
+        this->diskUsed -= entry->second.bytes;
+        entry->second.onDisk = false;
+    }
+    if (!entry->second.data)
+        this->entries.erase(entry);
+}
+void    SegmentCache::Evict         ()
+{
+    /* a linear scan per eviction: the cache holds segments by the thousand, not the million */
+    while (this->memoryUsed > this->memoryBytes || this->diskUsed > this->diskBytes)
+    {
+        bool                                    memory = this->memoryUsed > this->memoryBytes;
+        std::map<std::string, Entry>::iterator  oldest = this->entries.end();
+
+        for (std::map<std::string, Entry>::iterator entry = this->entries.begin(); entry != this->entries.end();
+             ++entry)
+        {
+            if ((memory ? !entry->second.data : !entry->second.onDisk))
+                continue;
+            if (oldest == this->entries.end() || entry->second.used < oldest->second.used)
+                oldest = entry;
+        }
+        if (oldest == this->entries.end())
+            break;
+
+        if (memory)
+            this->DropMemory(oldest);
+        else
+            this->DropDisk(oldest);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * SegmentCache.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Downloaded segments kept by URL, for installations that play the same
+ * clips session after session: a size-bounded set in memory and, with a
+ * directory, a larger one on disk that outlives the process. Both drop the
+ * least recently used segments first.
+ *
+ * A segment stored or confirmed by this process is used as it is. One kept
+ * by an earlier session is revalidated first with a conditional GET on its
+ * ETag (or Last-Modified), see SegmentFetcher::UseCache: a 304 costs a
+ * round trip but none of the segment's bytes. One without validators, e.g.
+ * fetched over HTTP/2, whose engine does not report them, is downloaded
+ * again.
+ *
+ * A disk entry is one file per segment, named after a hash of its key:
+ *
+ *   MCNLSEG1\n<key>\n<etag>\n<last-modified>\n<segment bytes>
+ *
+ * written under a temporary name and renamed, so a crashed session leaves
+ * no partial segment behind.
+ *****************************************************************************/
+
+#ifndef SEGMENTCACHE_H_
+#define SEGMENTCACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mcnl
+{
+    class SegmentCache
+    {
+        public:
+            /* memoryBytes of segments held in memory; with a directory, which is created if
+             * missing, up to diskBytes of them are also kept there from one session to the next */
+            SegmentCache            (size_t memoryBytes, const std::string &directory = "", size_t diskBytes = 0);
+            virtual ~SegmentCache   ();
+
+            /* the segment stored at key, false if there is none; fresh if it may be used as is,
+             * otherwise it is to be revalidated with etag or lastModified first, see Confirm */
+            bool    Lookup          (const std::string &key, std::vector<uint8_t> &data, bool &fresh,
+                                     std::string &etag, std::string &lastModified);
+            /* the server says the segment at key has not changed */
+            void    Confirm         (const std::string &key);
+            void    Store           (const std::string &key, const std::vector<uint8_t> &data,
+                                     const std::string &etag, const std::string &lastModified);
+            void    Remove          (const std::string &key);
+
+        private:
+            struct Entry
+            {
+                std::string                             etag;
+                std::string                             lastModified;
+                size_t                                  bytes;
+                std::shared_ptr<std::vector<uint8_t> >  data;       /* NULL while only on disk */
+                bool                                    onDisk;
+                bool                                    fresh;      /* stored or confirmed by this process */
+                uint64_t                                used;       /* clock of the last use, for LRU */
+            };
+
+            std::mutex                      mutex;
+            std::map<std::string, Entry>    entries;
+            std::string                     directory;
+            size_t                          memoryBytes;
+            size_t                          diskBytes;
+            size_t                          memoryUsed;
+            size_t                          diskUsed;
+            uint64_t                        clock;
+
+            std::string     Path            (const std::string &key) const;
+            /* the entries left on disk by earlier sessions, oldest use first */
+            void            Scan            ();
+            bool            ReadFile        (const std::string &key, Entry &entry);
+            bool            WriteFile       (const std::string &key, const Entry &entry);
+            /* drop the copy in memory or on disk, and the entry once it is held nowhere */
+            void            DropMemory      (std::map<std::string, Entry>::iterator entry);
+            void            DropDisk        (std::map<std::string, Entry>::iterator entry);
+            void            Evict           ();
+    };
+}
+
+#endif /* SEGMENTCACHE_H_ */
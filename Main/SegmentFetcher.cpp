@@ -0,0 +1,1019 @@
+/*
+ * SegmentFetcher.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "SegmentFetcher.h"
+#include "Tracer.h"
+#include "HostResolver.h"
+
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <zlib.h>
+
+#define MPD_FILE        "mcnl.mpd"
+#define MPD_ENCODINGS   "Accept-Encoding: gzip, deflate\r\n"
+
+using namespace mcnl;
+using namespace dash;
+using namespace dash::mpd;
+using namespace dash::network;
+using namespace libdashtest;
+
+/* a gzip or deflate body to its plain bytes; "deflate" is meant to be zlib-wrapped
+ * but some servers send it raw, so both are accepted */
+static bool     Inflate     (std::vector<uint8_t> &data)
+{
+    for (int windowBits : { MAX_WBITS + 32, -MAX_WBITS })
+    {
+        std::vector<uint8_t>    plain(data.size() * 4 + 4096);
+        z_stream                stream;
+        int                     ret;
+
+        memset(&stream, 0, sizeof(stream));
+        if (inflateInit2(&stream, windowBits) != Z_OK)
+            return false;
+
+        stream.next_in  = data.data();
+        stream.avail_in = (uInt) data.size();
+        do
+        {
+            if (stream.total_out == plain.size())
+                plain.resize(plain.size() * 2);
+            stream.next_out  = plain.data() + stream.total_out;
+            stream.avail_out = (uInt) (plain.size() - stream.total_out);
+            ret = inflate(&stream, Z_NO_FLUSH);
+        } while (ret == Z_OK);
+
+        plain.resize(stream.total_out);
+        inflateEnd(&stream);
+
+        if (ret == Z_STREAM_END)
+        {
+            data.swap(plain);
+            return true;
+        }
+    }
+    return false;
+}
+
+SegmentFetcher::SegmentFetcher  (std::string host, size_t port, std::string mpdPath,
+                                 std::shared_ptr<ConnectionPool> pool) :
+                host            (host),
+                port            (port),
+                mpdPath         (mpdPath),
+                manager         (NULL),
+                mpd             (NULL),
+                adaptationSet   (NULL),
+                teeSegments     (false),
+                rangeParts      (1),
+                httpVersion     (HTTP_VERSION_1_1),
+                fetchedAt       (0),
+                startSaved      (false),
+                speculatedOk    (false),
+                speculatedSeconds (0)
+{
+    this->manager = CreateDashManager();
+
+    if (pool)
+        this->pool = pool;
+    else
+    {
+        this->pool = std::make_shared<ConnectionPool>();
+        this->pool->SetMetrics(&this->metrics);
+    }
+
+    HostResolver::Instance().Prefetch(this->host, (int) this->port);
+}
+SegmentFetcher::~SegmentFetcher ()
+{
+    if (this->revalidation.joinable())
+        this->revalidation.join();
+    if (this->speculation.joinable())
+        this->speculation.join();
+    for (size_t i = 0; i < this->prewarming.size(); i++)
+        this->prewarming.at(i).join();
+
+    delete this->mpd;
+    delete this->manager;
+}
+
+bool            SegmentFetcher::Open                ()
+{
+    std::string     url   = this->URL(this->host, this->port, this->mpdPath);
+    bool            cache = !this->cachePath.empty() && this->httpVersion == HTTP_VERSION_1_1;
+    IndexValidators validators;
+    SegmentEntry    first;
+
+    this->Prewarm(this->host, this->port);
+
+    /* the cached index is good to start with; the MPD is checked meanwhile */
+    if (cache && this->index.Load(this->cachePath, validators) && validators.mpdURL == url &&
+        validators.baseURL == this->baseURL)
+    {
+        if (this->index.Lookup(0, 0, first))
+            this->Prewarm(first.host, first.port);
+        this->fetchedAt    = WallClock();
+        this->revalidation = std::thread(&SegmentFetcher::Revalidate, this, validators);
+        return true;
+    }
+
+    /* nothing to start from: the last session's first segment comes along with the MPD */
+    this->Speculate(url);
+
+    HTTPResponseInfo    response;
+    IMPD                *mpd = this->Load(this->host, this->port, this->mpdPath, "", &response);
+
+    if (mpd == NULL)
+        return false;
+
+    this->Adopt(mpd, url);
+
+    if (this->index.Lookup(0, 0, first))
+        this->Prewarm(first.host, first.port);
+
+    if (cache)
+        this->SaveIndex(url, response);
+
+    return true;
+}
+void            SegmentFetcher::Revalidate          (IndexValidators validators)
+{
+    std::string headers;
+
+    if (!validators.etag.empty())
+        headers += "If-None-Match: " + validators.etag + "\r\n";
+    if (!validators.lastModified.empty())
+        headers += "If-Modified-Since: " + validators.lastModified + "\r\n";
+
+    HTTPResponseInfo    response;
+    IMPD                *mpd = this->Load(this->host, this->port, this->mpdPath, headers, &response);
+
+    if (mpd == NULL)
+    {
+        if (response.status != 304)
+            std::cerr << "SegmentFetcher: cannot revalidate " << validators.mpdURL << ", using the cached index" << std::endl;
+        return;
+    }
+
+    this->Adopt(mpd, validators.mpdURL);
+    this->SaveIndex(validators.mpdURL, response);
+}
+void            SegmentFetcher::Speculate           (const std::string &mpdURL)
+{
+    std::ifstream   in(this->startPath.c_str());
+    std::string     savedMPD;
+    std::string     savedBase;
+    std::string     port;
+
+    if (this->startPath.empty() || !in)
+        return;
+
+    /* see SaveStart */
+    if (!std::getline(in, savedMPD) || !std::getline(in, savedBase) || !std::getline(in, this->speculated.url) ||
+        !std::getline(in, this->speculated.host) || !std::getline(in, port) ||
+        !std::getline(in, this->speculated.path) || !std::getline(in, this->speculated.range) ||
+        savedMPD != mpdURL || savedBase != this->baseURL || this->speculated.url.empty())
+        return;
+
+    this->speculated.port = (size_t) strtoul(port.c_str(), NULL, 10);
+    this->Prewarm(this->speculated.host, this->speculated.port);
+    this->speculation = std::thread([this]() {
+        std::chrono::steady_clock::time_point start      = std::chrono::steady_clock::now();
+        uint64_t                              traceStart = Tracer::Instance().Now();
+        SegmentSink                           sink(this->speculatedData);
+
+        if (this->httpVersion != HTTP_VERSION_1_1)
+            this->speculatedOk = this->FetchChunk(this->speculated.url, sink, STREAM_WEIGHT_NEXT, this->speculated.range);
+        else
+            this->speculatedOk = this->Fetch(this->speculated.host, this->speculated.port, this->speculated.path, sink,
+                                             this->speculated.range);
+        this->speculatedData.resize(this->speculatedOk ? sink.Size() : 0);
+        this->speculatedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        Tracer::Instance().Complete("speculative download", "fetch", traceStart, Tracer::Instance().Now());
+    });
+}
+bool            SegmentFetcher::TakeSpeculated      (const SegmentEntry &entry, SegmentInfo &info)
+{
+    std::thread fetch;
+
+    {
+        std::lock_guard<std::mutex> lock(this->speculationLock);
+
+        if (!this->speculation.joinable() || entry.url != this->speculated.url || entry.range != this->speculated.range)
+            return false;
+        fetch.swap(this->speculation);
+    }
+    fetch.join();
+
+    if (!this->speculatedOk)
+        return false;
+
+    this->Deliver(this->speculatedData, info);
+    std::vector<uint8_t>().swap(this->speculatedData);
+
+    info.bytes      = info.data.size();
+    info.seconds    = this->speculatedSeconds;
+    info.throughput = info.seconds > 0 ? (info.bytes * 8) / info.seconds : 0;
+
+    return true;
+}
+bool            SegmentFetcher::TakeCached          (const SegmentEntry &entry, const std::string &key, SegmentInfo &info)
+{
+    std::vector<uint8_t>    data;
+    bool                    fresh;
+    std::string             etag;
+    std::string             lastModified;
+
+    if (!this->cache->Lookup(key, data, fresh, etag, lastModified))
+        return false;
+
+    double seconds = 0;
+
+    if (!fresh)
+    {
+        /* the HTTP/2 engine neither sends the conditional headers nor reports validators */
+        if (this->httpVersion != HTTP_VERSION_1_1 || (etag.empty() && lastModified.empty()))
+            return false;
+
+        std::string headers;
+
+        if (!etag.empty())
+            headers += "If-None-Match: " + etag + "\r\n";
+        if (!lastModified.empty())
+            headers += "If-Modified-Since: " + lastModified + "\r\n";
+
+        std::chrono::steady_clock::time_point start      = std::chrono::steady_clock::now();
+        uint64_t                              traceStart = Tracer::Instance().Now();
+        std::vector<uint8_t>                  body;
+        SegmentSink                           sink(body);
+        HTTPResponseInfo                      response;
+
+        sink.Watch(info.progress.get());
+
+        bool ok = this->Fetch(entry.host, entry.port, entry.path, sink, entry.range, headers, &response);
+
+        Tracer::Instance().Complete(ok ? "revalidation" : "revalidation failed", "fetch", traceStart,
+                                    Tracer::Instance().Now(), info.segmentNumber);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (!ok)
+            return false;
+
+        /* changed on the server: the new segment came with the answer */
+        if (response.status != 304)
+        {
+            this->cache->Store(key, body, response.etag, response.lastModified);
+            this->Deliver(body, info);
+
+            info.bytes      = info.data.size();
+            info.seconds    = seconds;
+            info.throughput = seconds > 0 ? (info.bytes * 8) / seconds : 0;
+            return true;
+        }
+        this->cache->Confirm(key);
+    }
+
+    this->Deliver(data, info);
+
+    info.cached     = true;
+    info.bytes      = 0;
+    info.seconds    = seconds;
+    info.throughput = 0;
+
+    return true;
+}
+void            SegmentFetcher::Deliver             (const std::vector<uint8_t> &data, SegmentInfo &info)
+{
+    SegmentSink sink(info.data, this->teeSegments ? info.fileName : "");
+    size_t      bytes = data.size();
+
+    if (info.stream)
+        sink.Forward(info.stream.get());
+    sink.Begin((int64_t) bytes);
+    if (bytes > 0)
+        memcpy(sink.At(0), data.data(), bytes);
+    sink.Filled(bytes);
+    sink.Finish();
+    if (info.stream)
+        info.stream->Close(true);
+}
+void            SegmentFetcher::SaveStart           (const SegmentEntry &entry)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->speculationLock);
+
+        if (this->startPath.empty() || this->startSaved)
+            return;
+        this->startSaved = true;
+    }
+
+    /* a live session starts elsewhere every time */
+    if (this->IsDynamic())
+        return;
+
+    std::ofstream out(this->startPath.c_str(), std::ios::trunc);
+
+    out << this->URL(this->host, this->port, this->mpdPath) << "\n" << this->baseURL << "\n" << entry.url << "\n" <<
+           entry.host << "\n" << entry.port << "\n" << entry.path << "\n" << entry.range << "\n";
+}
+void            SegmentFetcher::SaveIndex           (const std::string &url, const HTTPResponseInfo &response)
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    IndexValidators validators;
+
+    validators.mpdURL       = url;
+    validators.baseURL      = this->baseURL;
+    validators.etag         = response.etag;
+    validators.lastModified = response.lastModified;
+
+    /* dynamic MPDs have open-ended indexes, Save refuses those */
+    if (!this->IsDynamic())
+        this->index.Save(this->cachePath, validators);
+}
+bool            SegmentFetcher::Refresh             ()
+{
+    std::string host;
+    size_t      port;
+    std::string path;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+        host = this->host;
+        port = this->port;
+        path = this->mpdPath;
+
+        if (this->mpd && !this->mpd->GetLocations().empty())
+            SplitURL(this->mpd->GetLocations().at(0), host, port, path);
+    }
+
+    std::string headers;
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+        if (!this->mpdETag.empty())
+            headers += "If-None-Match: " + this->mpdETag + "\r\n";
+        if (!this->mpdLastModified.empty())
+            headers += "If-Modified-Since: " + this->mpdLastModified + "\r\n";
+    }
+
+    /* parsed outside the lock, downloads keep using the old MPD meanwhile */
+    HTTPResponseInfo    response;
+    IMPD                *mpd = this->Load(host, port, path, headers, &response);
+
+    if (mpd == NULL && response.status == 304)
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+        this->fetchedAt = WallClock();
+        return true;
+    }
+    if (mpd == NULL)
+        return false;
+
+    this->Adopt(mpd, this->URL(host, port, path));
+    return true;
+}
+IMPD*           SegmentFetcher::Load                (const std::string &host, size_t port, const std::string &path,
+                                                     const std::string &headers, HTTPResponseInfo *response)
+{
+    /* parsed straight from memory; a copy goes to MPD_FILE when segments are teed */
+    std::vector<uint8_t>    mpdData;
+    SegmentSink             sink(mpdData);
+    std::string             url = this->URL(host, port, path);
+    HTTPResponseInfo        own;
+
+    if (response == NULL)
+        response = &own;
+    response->status = 0;
+    response->contentEncoding.clear();
+
+    /* a long SegmentTimeline is mostly repetition, a fraction of it goes over the link */
+    bool ok = this->httpVersion == HTTP_VERSION_1_1 ?
+              this->Fetch(host, port, path, sink, "", MPD_ENCODINGS + headers, response) :
+              this->FetchChunk(url, sink, STREAM_WEIGHT_NEXT);
+
+    if (!ok || sink.Size() == 0)
+        return NULL;
+
+    if (!response->contentEncoding.empty() && response->contentEncoding != "identity" && !Inflate(mpdData))
+    {
+        std::cerr << "SegmentFetcher: cannot decode " << response->contentEncoding << " " << url << std::endl;
+        return NULL;
+    }
+    if (this->teeSegments)
+        std::ofstream(MPD_FILE, std::ios::binary).write((const char *) mpdData.data(), mpdData.size());
+
+    IMPD *mpd = this->manager->Open((const char *) mpdData.data(), mpdData.size(), url);
+
+    if (mpd == NULL || mpd->GetPeriods().empty() ||
+        mpd->GetPeriods().at(0)->GetAdaptationSets().empty())
+    {
+        std::cerr << "SegmentFetcher: cannot parse " << url << std::endl;
+        delete mpd;
+        return NULL;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    this->mpdETag           = response->etag;
+    this->mpdLastModified   = response->lastModified;
+    return mpd;
+}
+void            SegmentFetcher::Adopt               (IMPD *mpd, const std::string &url)
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    delete this->mpd;
+
+    this->mpd           = mpd;
+    this->adaptationSet = mpd->GetPeriods().at(0)->GetAdaptationSets().at(0);
+    this->fetchedAt     = WallClock();
+
+    /* URLs, ranges and timing are resolved here once, not per request */
+    this->index.Build(mpd, url);
+}
+bool            SegmentFetcher::Download            (size_t segmentNumber, size_t representation, SegmentInfo &info,
+                                                     uint32_t weight)
+{
+    SegmentEntry entry;
+    bool         found = false;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+        found = this->index.Lookup(representation, segmentNumber, entry) &&
+                this->Describe(segmentNumber, representation, info);
+    }
+
+    if (!found)
+    {
+        if (info.stream)
+            info.stream->Close(false);
+        return false;
+    }
+
+    this->SaveStart(entry);
+    info.cached       = false;
+    info.deliveryRate = 0;
+
+    /* a live presentation never comes back to a segment */
+    std::string key;
+
+    if (this->cache && !this->IsDynamic())
+    {
+        key = entry.range.empty() ? entry.url : entry.url + "#" + entry.range;
+        if (this->TakeCached(entry, key, info))
+            return true;
+    }
+
+    if (this->TakeSpeculated(entry, info))
+    {
+        if (!key.empty())
+            this->cache->Store(key, info.data, "", "");
+        return true;
+    }
+
+    std::chrono::steady_clock::time_point start      = std::chrono::steady_clock::now();
+    uint64_t                              traceStart = Tracer::Instance().Now();
+
+    SegmentSink         sink(info.data, this->teeSegments ? info.fileName : "");
+    HTTPResponseInfo    response;
+    bool                ok = false;
+
+    if (info.stream)
+        sink.Forward(info.stream.get());
+    sink.Watch(info.progress.get());
+
+    if (this->httpVersion != HTTP_VERSION_1_1)
+        ok = this->FetchChunk(entry.url, sink, weight, entry.range);
+    else if (this->rangeParts > 1 && !info.stream && entry.range.empty())
+        /* ranges arrive out of order, a stream needs them in order */
+        ok = this->FetchRanged(entry.host, entry.port, entry.path, sink);
+    else
+        ok = this->Fetch(entry.host, entry.port, entry.path, sink, entry.range, "", &response);
+
+    if (info.stream)
+        info.stream->Close(ok);
+
+    Tracer::Instance().Complete(ok ? "download" : sink.Aborted() ? "download aborted" : "download failed", "fetch",
+                                traceStart, Tracer::Instance().Now(), segmentNumber);
+
+    if (!ok)
+        return false;
+
+    /* only the plain HTTP/1.1 request reports validators; without them the segment
+     * is only used as is by this session */
+    if (!key.empty())
+        this->cache->Store(key, info.data, response.etag, response.lastModified);
+
+    info.bytes        = sink.Size();
+    info.deliveryRate = sink.DeliveryRate();
+
+    std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+
+    info.seconds    = sec.count();
+    info.throughput = info.seconds > 0 ? (info.bytes * 8) / info.seconds : 0;
+
+    return true;
+}
+bool            SegmentFetcher::Describe            (size_t segmentNumber, size_t representation, SegmentInfo &info) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    std::string uri = this->MediaURI(representation, segmentNumber);
+
+    if (uri.empty())
+        return false;
+
+    info.fileName       = uri.substr(uri.find_last_of('/') + 1);
+    info.segmentNumber  = segmentNumber;
+    info.representation = representation;
+    info.tile           = 0;
+    info.tiles          = 1;
+    info.layer          = this->index.Layer(representation);
+    info.frameRate      = this->FrameRate(representation);
+
+    if (!this->index.Complexity(representation, segmentNumber, info.complexity))
+        info.complexity = SegmentComplexity();
+
+    return true;
+}
+bool            SegmentFetcher::IsDynamic           () const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->mpd && this->mpd->GetType() == "dynamic";
+}
+double          SegmentFetcher::SegmentDuration     (size_t representation) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->index.Duration(representation);
+}
+size_t          SegmentFetcher::LiveStart           () const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    double duration = this->SegmentDuration(0);
+
+    if (!this->IsDynamic() || duration <= 0)
+        return 0;
+
+    IPeriod *period = this->mpd->GetPeriods().at(0);
+    double  point   = WallClock() - ParseDateTime(this->mpd->GetAvailabilityStarttime()) -
+                      ParseDuration(period->GetStart()) - this->PresentationDelay();
+
+    if (point < duration)
+        return 0;
+
+    /* the last segment that ended before the join point; timelines may
+     * deviate from the nominal duration, walk back until it is listed */
+    size_t          segment = (size_t) (point / duration) - 1;
+    size_t          count   = this->index.Count(0);
+    SegmentEntry    entry;
+
+    if (count != SIZE_MAX && segment >= count)
+        segment = count > 0 ? count - 1 : 0;
+
+    while (segment > 0 && (!this->index.Lookup(0, segment, entry) || entry.start + entry.duration > point))
+        segment--;
+
+    return segment;
+}
+double          SegmentFetcher::AvailableIn         (size_t segmentNumber) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    if (!this->IsDynamic())
+        return 0;
+
+    SegmentEntry entry;
+
+    if (!this->index.Lookup(0, segmentNumber, entry))
+    {
+        /* not in this MPD yet, look again after the next refresh */
+        double refresh = this->RefreshIn();
+        return refresh > 0 ? refresh : this->SegmentDuration(0);
+    }
+
+    IPeriod *period = this->mpd->GetPeriods().at(0);
+
+    /* a segment can be requested once it has been completely produced */
+    return ParseDateTime(this->mpd->GetAvailabilityStarttime()) + ParseDuration(period->GetStart()) +
+           entry.start + entry.duration - entry.availabilityOffset - WallClock();
+}
+double          SegmentFetcher::RefreshIn           () const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    if (!this->IsDynamic() || this->mpd->GetMinimumUpdatePeriod().empty())
+        return -1;
+
+    return this->fetchedAt + ParseDuration(this->mpd->GetMinimumUpdatePeriod()) - WallClock();
+}
+size_t          SegmentFetcher::SegmentCount        () const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    /* a live presentation goes on until an update turns it static */
+    return this->index.Count(0);
+}
+size_t          SegmentFetcher::RepresentationCount () const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->index.Representations();
+}
+uint32_t        SegmentFetcher::Bandwidth           (size_t representation) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->index.Bandwidth(representation);
+}
+double          SegmentFetcher::FrameRate           (size_t representation) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->index.FrameRate(representation);
+}
+std::vector<std::string> SegmentFetcher::Codecs     (size_t representation) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->index.Codecs(representation);
+}
+std::vector<size_t> SegmentFetcher::Dependencies    (size_t representation) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->index.Dependencies(representation);
+}
+size_t          SegmentFetcher::TileCount           () const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->index.Tiles();
+}
+TileRegion      SegmentFetcher::Tile                (size_t tile) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->index.Tile(tile);
+}
+std::string     SegmentFetcher::MediaURI            (size_t representation, size_t segmentNumber) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    SegmentEntry entry;
+
+    return this->index.Lookup(representation, segmentNumber, entry) ? entry.url : "";
+}
+bool            SegmentFetcher::Complexity          (size_t segmentNumber, size_t representation,
+                                                     SegmentComplexity &complexity) const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+
+    return this->index.Complexity(representation, segmentNumber, complexity);
+}
+void            SegmentFetcher::Prewarm             (const std::string &host, size_t port)
+{
+    std::string key = this->URL(host, port, "/");
+
+    if (this->httpVersion != HTTP_VERSION_1_1 ||
+        std::find(this->prewarmed.begin(), this->prewarmed.end(), key) != this->prewarmed.end())
+        return;
+
+    this->prewarmed.push_back(key);
+    this->prewarming.push_back(std::thread(&ConnectionPool::Prewarm, this->pool.get(), host, port));
+}
+double          SegmentFetcher::PresentationDelay   () const
+{
+    double delay = ParseDuration(this->mpd->GetSuggestedPresentationDelay());
+
+    return delay > 0 ? delay : ParseDuration(this->mpd->GetMinBufferTime());
+}
+void            SegmentFetcher::TeeSegments         (bool enable)
+{
+    this->teeSegments = enable;
+}
+void            SegmentFetcher::ParallelRanges      (size_t parts)
+{
+    this->rangeParts = parts > 0 ? parts : 1;
+    /* one extra for the probe range */
+    this->pool->MaxPerHost(this->rangeParts > 1 ? this->rangeParts + 1 : POOL_MAX_PER_HOST);
+}
+void            SegmentFetcher::CacheIndex          (const std::string &path)
+{
+    this->cachePath = path;
+}
+void            SegmentFetcher::FastStart           (const std::string &path)
+{
+    this->startPath = path;
+}
+void            SegmentFetcher::UseCache            (std::shared_ptr<SegmentCache> cache)
+{
+    this->cache = cache;
+}
+void            SegmentFetcher::SetBaseURL          (const std::string &url)
+{
+    this->baseURL = url;
+    this->index.SetBaseURL(url);
+}
+void            SegmentFetcher::SetHTTPVersion      (HTTPVersion version)
+{
+    this->httpVersion = version;
+    this->manager->SetHTTPVersion(version);
+}
+MetricsLog&     SegmentFetcher::Metrics             ()
+{
+    return this->metrics;
+}
+IMPD*           SegmentFetcher::MPD                 () const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+    return this->mpd;
+}
+IAdaptationSet* SegmentFetcher::AdaptationSet       () const
+{
+    std::lock_guard<std::recursive_mutex> lock(this->mpdLock);
+    return this->adaptationSet;
+}
+std::string     SegmentFetcher::URL                 (const std::string &host, size_t port, const std::string &path) const
+{
+    return "http://" + host + ":" + std::to_string(port) + path;
+}
+bool            SegmentFetcher::Fetch               (const std::string &host, size_t port, const std::string &path,
+                                                     SegmentSink &sink, const std::string &range,
+                                                     const std::string &headers, HTTPResponseInfo *response)
+{
+    size_t first  = 0;
+    size_t last   = 0;
+    bool   ranged = !range.empty() && sscanf(range.c_str(), "%zu-%zu", &first, &last) == 2;
+
+    TestChunk chunk(host, port, path, first, last, ranged);
+
+    /* a reused keep-alive connection may have been closed by the server in
+     * the meantime; in that case try once more on a fresh one */
+    for (int attempt = 0; attempt < 2 && !sink.Aborted(); attempt++)
+    {
+        bool                        fresh      = false;
+        PersistentHTTPConnection    *connection = this->pool->Schedule(&chunk, fresh, headers);
+
+        if (connection == NULL)
+            continue;
+
+        uint64_t cancel = this->Attach(sink, connection);
+
+        int64_t length = connection->ResponseLength(&chunk);
+        int     ret    = length < 0 ? -1 : 0;
+
+        if (ret == 0 && response != NULL)
+            *response = connection->LastResponse();
+
+        if (ret == 0)
+        {
+            std::chrono::steady_clock::time_point   sampled = std::chrono::steady_clock::now();
+            TCPInfoSample                           tcp;
+
+            sink.Begin(length);
+            do
+            {
+                size_t  available = 0;
+                uint8_t *target   = sink.WritePointer(available);
+
+                ret = connection->Read(target, available, &chunk);
+                if (ret > 0)
+                    sink.Commit(ret);
+
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+                /* what the ABR looks at while the download is under way, and its last word at the end */
+                if ((ret <= 0 || std::chrono::duration<double>(now - sampled).count() >= TCP_SAMPLE_INTERVAL) &&
+                    connection->SampleTCP(tcp))
+                {
+                    sink.SampledTCP(tcp.rtt, tcp.deliveryRate);
+                    sampled = now;
+                }
+            }while(ret > 0);
+            sink.Finish();
+        }
+
+        if (sink.Progress() != NULL)
+            sink.Progress()->Detach(cancel);
+        this->pool->Release(connection);
+
+        if (ret == 0 && !sink.Aborted() && (sink.Size() > 0 || (response != NULL && response->status == 304)))
+            return true;
+
+        if (fresh)
+            break;
+    }
+
+    if (!sink.Aborted())
+        std::cerr << "SegmentFetcher: request failed for " << path << std::endl;
+    return false;
+}
+uint64_t        SegmentFetcher::Attach              (SegmentSink &sink, PersistentHTTPConnection *connection)
+{
+    if (sink.Progress() == NULL)
+        return 0;
+
+    return sink.Progress()->Attach([connection]() { connection->Abort(); });
+}
+bool            SegmentFetcher::FetchChunk          (const std::string &url, SegmentSink &sink, uint32_t weight,
+                                                     const std::string &range)
+{
+    /* QUIC only runs over TLS */
+    bool        secure = this->httpVersion == HTTP_VERSION_3 && url.compare(0, 7, "http://") == 0;
+    ISegment    *chunk = this->manager->CreateChunk(secure ? "https://" + url.substr(7) : url, range);
+
+    if (chunk == NULL)
+        return false;
+
+    chunk->Priority(weight);
+
+    if (!chunk->StartDownload())
+    {
+        delete chunk;
+        std::cerr << "SegmentFetcher: cannot start " << url << std::endl;
+        return false;
+    }
+
+    int         ret    = 0;
+    uint64_t    cancel = 0;
+
+    /* resets the stream, the connection goes on with the others */
+    if (sink.Progress() != NULL)
+        cancel = sink.Progress()->Attach([chunk]() { chunk->AbortDownload(); });
+
+    sink.Begin(-1);
+    do
+    {
+        size_t  available = 0;
+        uint8_t *target   = sink.WritePointer(available);
+
+        ret = chunk->Read(target, available);
+        if (ret > 0)
+            sink.Commit(ret);
+    }while(ret > 0);
+    sink.Finish();
+
+    if (sink.Progress() != NULL)
+        sink.Progress()->Detach(cancel);
+
+    /* the end of the data is also where a reset stream or a dropped connection leaves it */
+    bool completed = chunk->WaitForDownload() == COMPLETED;
+
+    for (size_t i = 0; i < chunk->GetHTTPTransactionList().size(); i++)
+        this->metrics.Add(*chunk->GetHTTPTransactionList().at(i));
+
+    delete chunk;
+
+    if (sink.Aborted())
+        return false;
+    /* FAILONERROR: an HTTP error ends the chunk as a failed transfer */
+    if (completed)
+        return true;
+
+    std::cerr << "SegmentFetcher: request failed for " << url << std::endl;
+    return false;
+}
+bool            SegmentFetcher::FetchRanged         (const std::string &host, size_t port, const std::string &path,
+                                                     SegmentSink &sink)
+{
+    /* the first range doubles as a size probe (Content-Range) */
+    TestChunk                   probe(host, port, path, 0, RANGE_PROBE_SIZE - 1, true);
+    bool                        fresh      = false;
+    PersistentHTTPConnection    *connection = this->pool->Schedule(&probe, fresh);
+
+    if (connection == NULL)
+        return this->Fetch(host, port, path, sink);
+
+    uint64_t cancel = this->Attach(sink, connection);
+    int64_t  total  = -1;
+    int64_t length = connection->ResponseLength(&probe, &total);
+
+    if (length <= 0 || total <= 0 || total < RANGE_MIN_SIZE || length >= total)
+    {
+        /* small segment, or the server ignored the Range header */
+        bool ok = false;
+
+        if (length > 0 && (total <= 0 || length >= total))
+        {
+            sink.Begin(length);
+            ok = this->ReadBody(connection, &probe, sink.At(0), length);
+            if (ok)
+                sink.Filled(length);
+            sink.Finish();
+        }
+        else if (length >= 0)
+        {
+            /* drain the probe so the connection stays usable; chunked
+             * responses report a length of 0 */
+            uint8_t skip[4096];
+            while (connection->Read(skip, sizeof(skip), &probe) > 0);
+        }
+        if (sink.Progress() != NULL)
+            sink.Progress()->Detach(cancel);
+        this->pool->Release(connection);
+
+        return ok && !sink.Aborted() ? true : this->Fetch(host, port, path, sink);
+    }
+
+    sink.Begin(total);
+
+    /* the rest is split evenly; part 0 is the probe itself */
+    size_t                  parts  = this->rangeParts;
+    size_t                  rest   = total - length;
+    size_t                  step   = (rest + parts - 1) / parts;
+    std::vector<std::thread> workers;
+    std::vector<char>       results(parts, 0);
+
+    for (size_t i = 0; i < parts; i++)
+    {
+        size_t first = length + i * step;
+        size_t last  = std::min(first + step, (size_t) total) - 1;
+
+        if (first > last || first >= (size_t) total)
+        {
+            results.at(i) = 1;
+            continue;
+        }
+
+        uint8_t *target = sink.At(first);
+        char    *result = &results.at(i);
+
+        workers.push_back(std::thread([this, host, port, path, first, last, target, result, &sink]() {
+            TestChunk                   range(host, port, path, first, last, true);
+            bool                        fresh      = false;
+            PersistentHTTPConnection    *connection = this->pool->Schedule(&range, fresh);
+
+            if (connection == NULL)
+                return;
+
+            uint64_t cancel = this->Attach(sink, connection);
+
+            if (connection->ResponseLength(&range) == (int64_t) (last - first + 1))
+                *result = this->ReadBody(connection, &range, target, last - first + 1);
+
+            if (sink.Progress() != NULL)
+                sink.Progress()->Detach(cancel);
+            this->pool->Release(connection);
+        }));
+    }
+
+    bool ok = this->ReadBody(connection, &probe, sink.At(0), length);
+    if (sink.Progress() != NULL)
+        sink.Progress()->Detach(cancel);
+    this->pool->Release(connection);
+
+    for (size_t i = 0; i < workers.size(); i++)
+        workers.at(i).join();
+
+    for (size_t i = 0; i < parts; i++)
+        ok = ok && results.at(i);
+
+    if (!ok && sink.Aborted())
+    {
+        sink.Finish();
+        return false;
+    }
+    if (!ok)
+    {
+        sink.Finish();
+        std::cerr << "SegmentFetcher: ranged download failed, retrying " << path << std::endl;
+        return this->Fetch(host, port, path, sink);
+    }
+
+    sink.Filled(total);
+    sink.Finish();
+    return true;
+}
+bool            SegmentFetcher::ReadBody            (PersistentHTTPConnection *connection, IChunk *chunk,
+                                                     uint8_t *target, size_t length)
+{
+    size_t  done = 0;
+    int     ret  = 0;
+
+    while (done < length)
+    {
+        ret = connection->Read(target + done, length - done, chunk);
+        if (ret <= 0)
+            return false;
+        done += ret;
+    }
+
+    /* the final zero-length read retires the request on the connection */
+    return connection->Read(target, 0, chunk) == 0;
+}
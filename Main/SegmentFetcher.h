@@ -0,0 +1,247 @@
+/*
+ * SegmentFetcher.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * In-process replacement for the per-segment libdash_mcnl_test process:
+ * the MPD is downloaded and parsed once, segments are fetched on demand
+ * over keep-alive connections shared through a ConnectionPool straight
+ * into memory. With HTTP/2 the MPD and all segments instead go through
+ * libdash's download engine, multiplexed over one connection. HTTP/3 goes
+ * the same way over QUIC, for lossy wireless links: http URLs are then
+ * requested as https, which QUIC requires.
+ *
+ * Segments are addressed by SegmentList or by SegmentTemplate ($Number$ or
+ * $Time$, with or without a SegmentTimeline), through a SegmentIndex that is
+ * rebuilt with every MPD load. For type="dynamic" MPDs the
+ * fetcher tells when each segment becomes available and refreshes the MPD
+ * after minimumUpdatePeriod; the old MPD is swapped out under a lock, so
+ * pointers from MPD() and AdaptationSet() are only valid until Refresh().
+ *
+ * With CacheIndex() a static MPD's index is kept on disk: Open() then starts
+ * from the cached index right away and revalidates the MPD in the
+ * background with a conditional GET, MPD() stays NULL unless it changed.
+ * Over HTTP/1.1 the MPD is asked for gzip or deflate compressed, and
+ * Refresh() of a live MPD is a conditional GET as well: a 304 only restarts
+ * minimumUpdatePeriod.
+ *
+ * Over HTTP/1.1 the MPD host is looked up as soon as the fetcher is made,
+ * and the pool's connections to it, and to the segment host once the
+ * index says which, are opened while the MPD downloads and parses.
+ *
+ * With FastStart() the first segment a session requests is remembered by
+ * its URL. When the next session has no cached index to start from (the
+ * first run with HTTP/2, say), Open() fetches that segment again while the
+ * MPD downloads and parses, and Download() hands it over once the MPD
+ * lists it under the same URL; a different one is downloaded as usual.
+ *
+ * SetBaseURL() sends the segment requests elsewhere than the MPD says, e.g.
+ * to a LAN edge cache shared by the viewers of a session.
+ *
+ * With UseCache() the segments of static MPDs are kept in a SegmentCache,
+ * so a replay, or the next session of an installation looping the same
+ * content, takes them from memory or disk. One kept by an earlier session
+ * is revalidated with a conditional GET over HTTP/1.1 first; a cached
+ * segment comes with no bytes downloaded and no throughput, so the ABR
+ * estimate only follows the network.
+ *****************************************************************************/
+
+#ifndef SEGMENTFETCHER_H_
+#define SEGMENTFETCHER_H_
+
+#include "libdash.h"
+#include "ConnectionPool.h"
+#include "TestChunk.h"
+#include "SegmentSink.h"
+#include "MpdTime.h"
+#include "SegmentIndex.h"
+#include "MetricsLog.h"
+#include "SegmentCache.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#define RANGE_MIN_SIZE      (1 << 20)   /* smaller segments are fetched in one request */
+#define RANGE_PROBE_SIZE    (64 << 10)  /* first range, also tells the segment size */
+#define STREAM_WEIGHT_NEXT  256         /* HTTP/2 weight of the segment needed next */
+#define TCP_SAMPLE_INTERVAL 0.05        /* seconds between TCP_INFO samples of an HTTP/1.1 download */
+
+namespace mcnl
+{
+    struct SegmentInfo
+    {
+        std::string     fileName;       /* file name on the server, e.g. high_s3.bin */
+        std::vector<uint8_t> data;      /* the segment itself */
+        std::shared_ptr<SegmentStream> stream;  /* if set, receives the bytes while they arrive */
+        std::shared_ptr<DownloadProgress> progress; /* if set, follows the download, which it can abort */
+        size_t          segmentNumber;
+        size_t          representation;
+        size_t          tile;           /* of a tiled content: position among the tiles fetched for segmentNumber */
+        size_t          tiles;          /* tiles fetched for segmentNumber, 1 if untiled */
+        size_t          layer;          /* of a layered content, see SegmentIndex::Layer; SIZE_MAX if not */
+        double          frameRate;      /* frames per second, 0 if the MPD does not say */
+        SegmentComplexity complexity;   /* what it takes to decode, from the MPD; points is 0 if it does not say */
+        size_t          bytes;
+        double          seconds;        /* wall time from request to last byte */
+        double          throughput;     /* bits per second */
+        bool            cached;         /* from the SegmentCache: bytes and throughput are 0 */
+        double          deliveryRate;   /* bits per second TCP delivered as the download ended, 0 if unknown */
+    };
+
+    class SegmentFetcher
+    {
+        public:
+            /* pool: HTTP/1.1 connections shared with other fetchers, e.g. those of the
+             * other objects of a scene; NULL = a pool of its own, which reports to Metrics() */
+            SegmentFetcher          (std::string host, size_t port, std::string mpdPath,
+                                     std::shared_ptr<ConnectionPool> pool = NULL);
+            virtual ~SegmentFetcher ();
+
+            bool        Open                ();
+            /* weight only matters with HTTP/2, see STREAM_WEIGHT_NEXT */
+            bool        Download            (size_t segmentNumber, size_t representation, SegmentInfo &info,
+                                             uint32_t weight = STREAM_WEIGHT_NEXT);
+            /* fills in everything but the data and the download figures */
+            bool        Describe            (size_t segmentNumber, size_t representation, SegmentInfo &info) const;
+            /* HTTP/1.1 (default) uses the ConnectionPool; HTTP/2 and HTTP/3 multiplex
+             * every request, ranged downloads are not used then. Set before Open */
+            void        SetHTTPVersion      (dash::network::HTTPVersion version);
+            /* also write every segment to fileName in the working directory */
+            void        TeeSegments         (bool enable);
+            /* split segments of at least RANGE_MIN_SIZE bytes into `parts`
+             * byte ranges fetched concurrently on separate connections */
+            void        ParallelRanges      (size_t parts);
+            /* keep the segment index of static MPDs in this file; HTTP/1.1
+             * only, the HTTP/2 engine does not report validators. Set before Open */
+            void        CacheIndex          (const std::string &path);
+            /* replaces the MPD's BaseURL, relative to the MPD URL; empty keeps
+             * it. Set before Open */
+            void        SetBaseURL          (const std::string &url);
+            /* remember the first segment of static MPDs in this file, see
+             * above. Set before Open */
+            void        FastStart           (const std::string &path);
+            /* keep the segments of static MPDs in cache, which may be shared
+             * with other fetchers. Set before Open */
+            void        UseCache            (std::shared_ptr<SegmentCache> cache);
+
+            /* live presentation (type="dynamic"), SegmentCount() is unbounded then */
+            bool        IsDynamic           () const;
+            /* seconds, 0 if the MPD does not say */
+            double      SegmentDuration     (size_t representation) const;
+            /* segment to start with when joining a live presentation,
+             * suggestedPresentationDelay behind the live edge */
+            size_t      LiveStart           () const;
+            /* seconds until the segment can be requested, <= 0 once it is
+             * available; always 0 for static MPDs */
+            double      AvailableIn         (size_t segmentNumber) const;
+            /* seconds until minimumUpdatePeriod has passed since the MPD was
+             * fetched, < 0 if it is never updated */
+            double      RefreshIn           () const;
+            /* fetches the MPD again (from its Location, if any) and swaps it in; true
+             * as well if the server says it has not changed */
+            bool        Refresh             ();
+
+            size_t      SegmentCount        () const;
+            size_t      RepresentationCount () const;
+            uint32_t    Bandwidth           (size_t representation) const;
+            double      FrameRate           (size_t representation) const;
+            /* @codecs, e.g. v3c1,vvi1; empty if the MPD does not say */
+            std::vector<std::string> Codecs     (size_t representation) const;
+            /* complementary representations to fetch first, see SegmentIndex */
+            std::vector<size_t> Dependencies    (size_t representation) const;
+            /* tiles of a tiled content (see SegmentIndex), 0 if untiled */
+            size_t      TileCount           () const;
+            TileRegion  Tile                (size_t tile) const;
+            /* decode complexity of the segment, false if the MPD does not say */
+            bool        Complexity          (size_t segmentNumber, size_t representation,
+                                             SegmentComplexity &complexity) const;
+            /* absolute URL of the segment, empty if there is none */
+            std::string MediaURI            (size_t representation, size_t segmentNumber) const;
+
+            /* DASH metrics of every request, HTTP/1.1 and HTTP/2 */
+            MetricsLog&                 Metrics         ();
+
+            dash::mpd::IMPD*            MPD             () const;
+            dash::mpd::IAdaptationSet*  AdaptationSet   () const;
+
+        private:
+            std::string                     host;
+            size_t                          port;
+            std::string                     mpdPath;
+            dash::IDASHManager              *manager;
+            dash::mpd::IMPD                 *mpd;
+            dash::mpd::IAdaptationSet       *adaptationSet;
+            MetricsLog                      metrics;        /* before pool, which reports to it */
+            std::shared_ptr<ConnectionPool> pool;
+            bool                            teeSegments;
+            size_t                          rangeParts;
+            dash::network::HTTPVersion      httpVersion;
+            /* recursive: the public accessors call each other */
+            mutable std::recursive_mutex    mpdLock;
+            double                          fetchedAt;      /* wall clock of the last MPD fetch */
+            std::string                     mpdETag;        /* validators of the MPD in use, for Refresh */
+            std::string                     mpdLastModified;
+            SegmentIndex                    index;
+            std::string                     cachePath;
+            std::string                     baseURL;
+            std::thread                     revalidation;
+            std::vector<std::thread>        prewarming;
+            std::vector<std::string>        prewarmed;      /* host:port, one thread each */
+            std::string                     startPath;
+            bool                            startSaved;
+            /* the first segment of the last session, fetched while the MPD
+             * downloads; the data and figures belong to the thread until it
+             * is joined */
+            std::mutex                      speculationLock;
+            std::thread                     speculation;
+            SegmentEntry                    speculated;
+            std::vector<uint8_t>            speculatedData;
+            bool                            speculatedOk;
+            double                          speculatedSeconds;
+            std::shared_ptr<SegmentCache>   cache;
+
+            /* range is "first-last" or empty for the whole resource; headers
+             * are extra request lines. A 304 counts as success when the
+             * caller asked for the response */
+            bool        Fetch               (const std::string &host, size_t port, const std::string &path,
+                                             SegmentSink &sink, const std::string &range = "",
+                                             const std::string &headers = "", libdashtest::HTTPResponseInfo *response = NULL);
+            bool        FetchChunk          (const std::string &url, SegmentSink &sink, uint32_t weight,
+                                             const std::string &range = "");
+            bool        FetchRanged         (const std::string &host, size_t port, const std::string &path,
+                                             SegmentSink &sink);
+            /* lets the sink's progress abort the transfer on connection; the id to detach it, 0 without progress */
+            uint64_t    Attach              (SegmentSink &sink, libdashtest::PersistentHTTPConnection *connection);
+            /* reads the body of an already scheduled chunk into target */
+            bool        ReadBody            (libdashtest::PersistentHTTPConnection *connection, dash::network::IChunk *chunk,
+                                             uint8_t *target, size_t length);
+            /* downloads, decompresses and parses the MPD, NULL on failure or if not modified */
+            dash::mpd::IMPD*    Load        (const std::string &host, size_t port, const std::string &path,
+                                             const std::string &headers = "", libdashtest::HTTPResponseInfo *response = NULL);
+            void        Adopt               (dash::mpd::IMPD *mpd, const std::string &url);
+            /* conditional GET of the MPD a cached index came from */
+            void        Revalidate          (IndexValidators validators);
+            void        SaveIndex           (const std::string &url, const libdashtest::HTTPResponseInfo &response);
+            /* starts the fetch of the segment in startPath if it was saved for mpdURL */
+            void        Speculate           (const std::string &mpdURL);
+            /* true if entry is the speculated segment and it arrived, then in info */
+            bool        TakeSpeculated      (const SegmentEntry &entry, SegmentInfo &info);
+            /* the segment entry is cached at, served from cache if it is there and still
+             * valid, see UseCache; false if it is to be downloaded */
+            bool        TakeCached          (const SegmentEntry &entry, const std::string &key, SegmentInfo &info);
+            /* hands data over to info.data and info.stream as if it had just arrived */
+            void        Deliver             (const std::vector<uint8_t> &data, SegmentInfo &info);
+            /* once per session, for static MPDs */
+            void        SaveStart           (const SegmentEntry &entry);
+            double      PresentationDelay   () const;
+            /* fills the pool's connections to host:port in the background */
+            void        Prewarm             (const std::string &host, size_t port);
+            std::string URL                 (const std::string &host, size_t port, const std::string &path) const;
+    };
+}
+
+#endif /* SEGMENTFETCHER_H_ */
@@ -0,0 +1,910 @@
+/*
+ * SegmentIndex.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "SegmentIndex.h"
+#include "MpdTime.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INDEX_CACHE_MAGIC       0x58495343  /* "CSIX" */
+#define INDEX_CACHE_VERSION     6   /* 2: tiles, 3: dependencyId, 4: codecs, 5: BaseURL override, 6: complexity */
+
+using namespace mcnl;
+using namespace dash::mpd;
+
+/* cache file: header, tiles, tracks, entries, complexities, then all strings; the records have
+ * fixed sizes so the file is usable straight from a read-only mapping */
+namespace
+{
+    struct CacheString
+    {
+        uint32_t    offset;
+        uint32_t    length;
+    };
+    struct CacheHeader
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        uint32_t    tiles;
+        uint32_t    tracks;
+        uint32_t    entries;
+        uint32_t    complexities;
+        uint64_t    stringBytes;
+        CacheString mpdURL;
+        CacheString baseURL;
+        CacheString etag;
+        CacheString lastModified;
+    };
+    struct CacheTile
+    {
+        float       min[3];
+        float       max[3];
+        uint64_t    firstRepresentation;
+        uint64_t    representations;
+    };
+    struct CacheTrack
+    {
+        CacheString id;
+        CacheString dependencyId;   /* space separated */
+        CacheString codecs;         /* comma separated */
+        uint32_t    bandwidth;
+        uint32_t    templated;
+        uint64_t    first;
+        uint64_t    entries;
+        uint64_t    complexities;
+        double      duration;
+        double      frameRate;
+    };
+    struct CacheEntry
+    {
+        CacheString url;
+        CacheString range;
+        uint64_t    time;
+        uint32_t    number;
+        uint32_t    reserved;
+        double      start;
+        double      duration;
+        double      availabilityOffset;
+    };
+    /* SegmentComplexity, with a fixed layout */
+    struct CacheComplexity
+    {
+        uint64_t    points;
+        uint64_t    patches;
+        uint32_t    atlasWidth;
+        uint32_t    atlasHeight;
+        uint64_t    occupancyBytes;
+        uint64_t    geometryBytes;
+        uint64_t    attributeBytes;
+    };
+
+    CacheString AddString   (std::string &strings, const std::string &value)
+    {
+        CacheString ref;
+
+        ref.offset = (uint32_t) strings.size();
+        ref.length = (uint32_t) value.size();
+        strings.append(value);
+        return ref;
+    }
+    bool        GetString   (const char *strings, uint64_t size, const CacheString &ref, std::string &value)
+    {
+        if ((uint64_t) ref.offset + ref.length > size)
+            return false;
+
+        value.assign(strings + ref.offset, ref.length);
+        return true;
+    }
+    void        SplitString (const std::string &value, char separator, std::vector<std::string> &parts)
+    {
+        for (size_t start = 0; start < value.size();)
+        {
+            size_t end = value.find(separator, start);
+
+            if (end == std::string::npos)
+                end = value.size();
+            parts.push_back(value.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+}
+
+bool            mcnl::SplitURL                  (const std::string &url, std::string &host, size_t &port, std::string &path)
+{
+    size_t pos = url.find("://");
+
+    if (pos == std::string::npos)
+        return false;
+
+    std::string rest     = url.substr(pos + 3);
+    size_t      slash    = rest.find('/');
+    std::string hostPort = rest.substr(0, slash);
+    size_t      colon    = hostPort.find(':');
+
+    host = hostPort.substr(0, colon);
+    port = colon == std::string::npos ? 80 : atoi(hostPort.substr(colon + 1).c_str());
+    path = slash == std::string::npos ? "/" : rest.substr(slash);
+    return true;
+}
+std::string     mcnl::ResolveURL                (const std::string &base, const std::string &url)
+{
+    if (url.empty())
+        return base;
+    if (url.find("://") != std::string::npos)
+        return url;
+
+    size_t scheme = base.find("://");
+    size_t root   = scheme == std::string::npos ? std::string::npos : base.find('/', scheme + 3);
+
+    if (url[0] == '/')
+        return (root == std::string::npos ? base : base.substr(0, root)) + url;
+
+    size_t slash = base.find_last_of('/');
+
+    if (slash == std::string::npos || (root == std::string::npos && scheme != std::string::npos))
+        return base + "/" + url;
+
+    return base.substr(0, slash + 1) + url;
+}
+
+SegmentIndex::SegmentIndex  () :
+              numbered      (false),
+              firstNumber   (0)
+{
+}
+SegmentIndex::~SegmentIndex ()
+{
+}
+
+void            SegmentIndex::Build             (IMPD *mpd, const std::string &mpdURL)
+{
+    this->tracks.clear();
+    this->tiles.clear();
+
+    if (mpd == NULL || mpd->GetPeriods().empty() || mpd->GetPeriods().at(0)->GetAdaptationSets().empty())
+        return;
+
+    IPeriod                                 *period         = mpd->GetPeriods().at(0);
+    const std::vector<IAdaptationSet *>     &adaptationSets = period->GetAdaptationSets();
+    TileRegion                              tile;
+
+    if (!ParseTile(adaptationSets.at(0), tile))
+    {
+        this->AddAdaptationSet(mpd, period, adaptationSets.at(0), mpdURL);
+        this->Link(0, this->tracks.size());
+        return;
+    }
+
+    for (size_t i = 0; i < adaptationSets.size(); i++)
+    {
+        if (!ParseTile(adaptationSets.at(i), tile))
+            continue;
+
+        tile.firstRepresentation = this->tracks.size();
+        this->AddAdaptationSet(mpd, period, adaptationSets.at(i), mpdURL);
+        tile.representations     = this->tracks.size() - tile.firstRepresentation;
+        this->Link(tile.firstRepresentation, this->tracks.size());
+
+        if (tile.representations > 0)
+            this->tiles.push_back(tile);
+    }
+}
+void            SegmentIndex::SetBaseURL        (const std::string &url)
+{
+    this->baseURL = url;
+}
+void            SegmentIndex::AddAdaptationSet  (IMPD *mpd, IPeriod *period, IAdaptationSet *adaptationSet,
+                                                 const std::string &mpdURL)
+{
+    std::string     base = mpdURL;
+
+    /* only the first BaseURL of each level, alternatives are not used */
+    if (!this->baseURL.empty())
+        base = ResolveURL(base, this->baseURL);
+    else if (!mpd->GetBaseUrls().empty())
+        base = ResolveURL(base, mpd->GetBaseUrls().at(0)->GetUrl());
+    if (!period->GetBaseURLs().empty())
+        base = ResolveURL(base, period->GetBaseURLs().at(0)->GetUrl());
+    if (!adaptationSet->GetBaseURLs().empty())
+        base = ResolveURL(base, adaptationSet->GetBaseURLs().at(0)->GetUrl());
+
+    double total = mpd->GetType() == "dynamic" ? 0 : ParseDuration(mpd->GetMediaPresentationDuration());
+
+    for (size_t i = 0; i < adaptationSet->GetRepresentation().size(); i++)
+    {
+        IRepresentation *representation = adaptationSet->GetRepresentation().at(i);
+        std::string     repBase         = base;
+
+        if (!representation->GetBaseURLs().empty())
+            repBase = ResolveURL(repBase, representation->GetBaseURLs().at(0)->GetUrl());
+
+        Track track;
+
+        track.first           = 0;
+        track.duration        = 0;
+        track.templated       = false;
+        track.segmentTemplate = NULL;
+        track.bandwidth       = representation->GetBandwidth();
+        track.frameRate       = ParseFrameRate(representation, adaptationSet);
+        track.id              = representation->GetId();
+        track.codecs          = representation->GetCodecs().empty() ? adaptationSet->GetCodecs() :
+                                                                      representation->GetCodecs();
+        track.dependencyIds   = representation->GetDependencyId();
+        track.complexity      = ParseComplexity(representation);
+        track.layered         = false;
+        track.tailCount       = 0;
+        track.tailNumber      = 0;
+        track.tailTime        = 0;
+        track.tailDuration    = 0;
+        track.offset          = 0;
+        track.timescale       = 1;
+        track.availabilityOffset = 0;
+
+        /* the innermost element wins */
+        ISegmentList        *list            = representation->GetSegmentList();
+        ISegmentTemplate    *segmentTemplate = representation->GetSegmentTemplate();
+
+        if (list == NULL && segmentTemplate == NULL)
+        {
+            list            = adaptationSet->GetSegmentList();
+            segmentTemplate = adaptationSet->GetSegmentTemplate();
+        }
+        if (list == NULL && segmentTemplate == NULL)
+        {
+            list            = period->GetSegmentList();
+            segmentTemplate = period->GetSegmentTemplate();
+        }
+
+        if (list)
+            this->AddList(track, list, repBase);
+        else if (segmentTemplate)
+        {
+            if (!this->numbered)
+            {
+                this->firstNumber = segmentTemplate->GetStartNumber();
+                this->numbered    = true;
+            }
+            this->AddTemplate(track, segmentTemplate, representation, repBase);
+
+            /* a static presentation ends with its duration */
+            if (track.tailCount == SIZE_MAX && total > 0 && track.tailDuration > 0)
+            {
+                double tailStart = ((double) track.tailTime - (double) track.offset) / track.timescale;
+                double remaining = total - tailStart;
+
+                track.tailCount = remaining > 0 ? (size_t) ceil(remaining * track.timescale / track.tailDuration - 1e-9) : 0;
+            }
+        }
+
+        this->tracks.push_back(track);
+    }
+}
+void            SegmentIndex::Link              (size_t first, size_t end)
+{
+    for (size_t i = first; i < end; i++)
+    {
+        Track &track = this->tracks.at(i);
+
+        track.dependencies.clear();
+        for (size_t k = 0; k < track.dependencyIds.size(); k++)
+            for (size_t j = first; j < end; j++)
+                if (j != i && this->tracks.at(j).id == track.dependencyIds.at(k))
+                {
+                    track.dependencies.push_back(j);
+                    this->tracks.at(j).layered = true;
+                }
+        if (!track.dependencies.empty())
+            track.layered = true;
+    }
+}
+bool            SegmentIndex::Lookup            (size_t representation, size_t segmentNumber, SegmentEntry &entry) const
+{
+    if (representation >= this->tracks.size())
+        return false;
+
+    const Track &track = this->tracks.at(representation);
+
+    if (segmentNumber < track.first)
+        return false;
+
+    size_t position = segmentNumber - track.first;
+
+    if (position < track.entries.size())
+    {
+        entry = track.entries.at(position);
+        return true;
+    }
+
+    position -= track.entries.size();
+
+    if (track.segmentTemplate == NULL || position >= track.tailCount)
+        return false;
+
+    entry.number             = track.tailNumber + (uint32_t) position;
+    entry.time               = track.tailTime + position * track.tailDuration;
+    entry.start              = (double) ((int64_t) (entry.time - track.offset)) / track.timescale;
+    entry.duration           = track.tailDuration / track.timescale;
+    entry.availabilityOffset = track.availabilityOffset;
+    entry.range.clear();
+
+    this->Fill(entry, ResolveURL(track.base, track.segmentTemplate->GetMediaURI(track.id, track.bandwidth, entry.number, entry.time)));
+    return true;
+}
+bool            SegmentIndex::Complexity        (size_t representation, size_t segmentNumber,
+                                                 SegmentComplexity &complexity) const
+{
+    if (representation >= this->tracks.size())
+        return false;
+
+    const Track &track = this->tracks.at(representation);
+
+    if (segmentNumber < track.first || segmentNumber - track.first >= track.complexity.size())
+        return false;
+
+    complexity = track.complexity.at(segmentNumber - track.first);
+    return true;
+}
+size_t          SegmentIndex::Count             (size_t representation) const
+{
+    if (representation >= this->tracks.size())
+        return 0;
+
+    const Track &track = this->tracks.at(representation);
+
+    if (track.tailCount == SIZE_MAX)
+        return SIZE_MAX;
+
+    return track.first + track.entries.size() + track.tailCount;
+}
+double          SegmentIndex::Duration          (size_t representation) const
+{
+    return representation < this->tracks.size() ? this->tracks.at(representation).duration : 0;
+}
+bool            SegmentIndex::Templated         (size_t representation) const
+{
+    return representation < this->tracks.size() && this->tracks.at(representation).templated;
+}
+size_t          SegmentIndex::Representations   () const
+{
+    return this->tracks.size();
+}
+uint32_t        SegmentIndex::Bandwidth         (size_t representation) const
+{
+    return representation < this->tracks.size() ? this->tracks.at(representation).bandwidth : 0;
+}
+double          SegmentIndex::FrameRate         (size_t representation) const
+{
+    return representation < this->tracks.size() ? this->tracks.at(representation).frameRate : 0;
+}
+const std::vector<std::string>&     SegmentIndex::Codecs    (size_t representation) const
+{
+    static const std::vector<std::string> none;
+
+    return representation < this->tracks.size() ? this->tracks.at(representation).codecs : none;
+}
+const std::vector<size_t>&  SegmentIndex::Dependencies  (size_t representation) const
+{
+    static const std::vector<size_t> none;
+
+    return representation < this->tracks.size() ? this->tracks.at(representation).dependencies : none;
+}
+size_t          SegmentIndex::Layer             (size_t representation) const
+{
+    if (representation >= this->tracks.size() || !this->tracks.at(representation).layered)
+        return SIZE_MAX;
+
+    return this->tracks.at(representation).dependencies.size();
+}
+size_t          SegmentIndex::Tiles             () const
+{
+    return this->tiles.size();
+}
+const TileRegion&   SegmentIndex::Tile          (size_t tile) const
+{
+    return this->tiles.at(tile);
+}
+bool            SegmentIndex::Save              (const std::string &path, const IndexValidators &validators) const
+{
+    std::vector<CacheTile>          tiles;
+    std::vector<CacheTrack>         tracks;
+    std::vector<CacheEntry>         entries;
+    std::vector<CacheComplexity>    complexities;
+    std::string                     strings;
+
+    for (size_t i = 0; i < this->tiles.size(); i++)
+    {
+        const TileRegion    &tile = this->tiles.at(i);
+        CacheTile           record;
+
+        memset(&record, 0, sizeof(record));
+        memcpy(record.min, tile.min, sizeof(record.min));
+        memcpy(record.max, tile.max, sizeof(record.max));
+        record.firstRepresentation = tile.firstRepresentation;
+        record.representations     = tile.representations;
+        tiles.push_back(record);
+    }
+
+    for (size_t i = 0; i < this->tracks.size(); i++)
+    {
+        const Track &track = this->tracks.at(i);
+        size_t      count  = this->Count(i);
+
+        /* live tails have no end to write down */
+        if (count == SIZE_MAX)
+            return false;
+
+        CacheTrack  record;
+        std::string dependencyId;
+        std::string codecs;
+
+        for (size_t k = 0; k < track.dependencyIds.size(); k++)
+            dependencyId += (k > 0 ? " " : "") + track.dependencyIds.at(k);
+        for (size_t k = 0; k < track.codecs.size(); k++)
+            codecs += (k > 0 ? "," : "") + track.codecs.at(k);
+
+        memset(&record, 0, sizeof(record));
+        record.id           = AddString(strings, track.id);
+        record.dependencyId = AddString(strings, dependencyId);
+        record.codecs       = AddString(strings, codecs);
+        record.bandwidth    = track.bandwidth;
+        record.templated    = track.templated;
+        record.first        = track.first;
+        record.entries      = count - track.first;
+        record.complexities = track.complexity.size();
+        record.duration     = track.duration;
+        record.frameRate    = track.frameRate;
+        tracks.push_back(record);
+
+        for (size_t segment = track.first; segment < count; segment++)
+        {
+            SegmentEntry    entry;
+            CacheEntry      out;
+
+            if (!this->Lookup(i, segment, entry))
+                return false;
+
+            memset(&out, 0, sizeof(out));
+            out.url                = AddString(strings, entry.url);
+            out.range              = AddString(strings, entry.range);
+            out.time               = entry.time;
+            out.number             = entry.number;
+            out.start              = entry.start;
+            out.duration           = entry.duration;
+            out.availabilityOffset = entry.availabilityOffset;
+            entries.push_back(out);
+        }
+
+        for (size_t k = 0; k < track.complexity.size(); k++)
+        {
+            const SegmentComplexity &complexity = track.complexity.at(k);
+            CacheComplexity         out;
+
+            memset(&out, 0, sizeof(out));
+            out.points         = complexity.points;
+            out.patches        = complexity.patches;
+            out.atlasWidth     = complexity.atlasWidth;
+            out.atlasHeight    = complexity.atlasHeight;
+            out.occupancyBytes = complexity.occupancyBytes;
+            out.geometryBytes  = complexity.geometryBytes;
+            out.attributeBytes = complexity.attributeBytes;
+            complexities.push_back(out);
+        }
+    }
+
+    CacheHeader header;
+
+    memset(&header, 0, sizeof(header));
+    header.magic        = INDEX_CACHE_MAGIC;
+    header.version      = INDEX_CACHE_VERSION;
+    header.tiles        = (uint32_t) tiles.size();
+    header.tracks       = (uint32_t) tracks.size();
+    header.entries      = (uint32_t) entries.size();
+    header.complexities = (uint32_t) complexities.size();
+    header.mpdURL       = AddString(strings, validators.mpdURL);
+    header.baseURL      = AddString(strings, validators.baseURL);
+    header.etag         = AddString(strings, validators.etag);
+    header.lastModified = AddString(strings, validators.lastModified);
+    header.stringBytes  = strings.size();
+
+    std::string temporary = path + ".tmp";
+    FILE        *file     = fopen(temporary.c_str(), "wb");
+
+    if (file == NULL)
+        return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (tiles.empty() || fwrite(tiles.data(), sizeof(CacheTile), tiles.size(), file) == tiles.size()) &&
+              (tracks.empty() || fwrite(tracks.data(), sizeof(CacheTrack), tracks.size(), file) == tracks.size()) &&
+              (entries.empty() || fwrite(entries.data(), sizeof(CacheEntry), entries.size(), file) == entries.size()) &&
+              (complexities.empty() || fwrite(complexities.data(), sizeof(CacheComplexity), complexities.size(), file) ==
+                                       complexities.size()) &&
+              (strings.empty() || fwrite(strings.data(), 1, strings.size(), file) == strings.size());
+
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+bool            SegmentIndex::Load              (const std::string &path, IndexValidators &validators)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(CacheHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t  size = info.st_size;
+    void    *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return false;
+
+    const char          *base   = (const char *) map;
+    const CacheHeader   *header = (const CacheHeader *) base;
+    bool                ok      = header->magic == INDEX_CACHE_MAGIC && header->version == INDEX_CACHE_VERSION;
+    uint64_t            records = sizeof(CacheHeader) + (uint64_t) header->tiles * sizeof(CacheTile) +
+                                  (uint64_t) header->tracks * sizeof(CacheTrack) +
+                                  (uint64_t) header->entries * sizeof(CacheEntry) +
+                                  (uint64_t) header->complexities * sizeof(CacheComplexity);
+
+    ok = ok && records + header->stringBytes == size;
+
+    std::vector<Track>      tracks;
+    std::vector<TileRegion> tiles;
+
+    if (ok)
+    {
+        const CacheTile         *cacheTiles        = (const CacheTile *) (base + sizeof(CacheHeader));
+        const CacheTrack        *cacheTracks       = (const CacheTrack *) (cacheTiles + header->tiles);
+        const CacheEntry        *cacheEntries      = (const CacheEntry *) (cacheTracks + header->tracks);
+        const CacheComplexity   *cacheComplexities = (const CacheComplexity *) (cacheEntries + header->entries);
+        const char              *strings           = base + records;
+        uint64_t                next               = 0;
+        uint64_t                nextComplexity     = 0;
+
+        ok = GetString(strings, header->stringBytes, header->mpdURL, validators.mpdURL) &&
+             GetString(strings, header->stringBytes, header->baseURL, validators.baseURL) &&
+             GetString(strings, header->stringBytes, header->etag, validators.etag) &&
+             GetString(strings, header->stringBytes, header->lastModified, validators.lastModified);
+
+        for (uint32_t i = 0; ok && i < header->tiles; i++)
+        {
+            const CacheTile &record = cacheTiles[i];
+            TileRegion      tile;
+
+            memcpy(tile.min, record.min, sizeof(tile.min));
+            memcpy(tile.max, record.max, sizeof(tile.max));
+            tile.firstRepresentation = record.firstRepresentation;
+            tile.representations     = record.representations;
+
+            ok = record.firstRepresentation + record.representations <= header->tracks;
+            tiles.push_back(tile);
+        }
+
+        for (uint32_t i = 0; ok && i < header->tracks; i++)
+        {
+            const CacheTrack    &record = cacheTracks[i];
+            Track               track;
+            std::string         dependencyId;
+            std::string         codecs;
+
+            track.first           = record.first;
+            track.duration        = record.duration;
+            track.templated       = record.templated != 0;
+            track.bandwidth       = record.bandwidth;
+            track.frameRate       = record.frameRate;
+            track.layered         = false;
+            track.segmentTemplate = NULL;
+            track.tailCount       = 0;
+            track.tailNumber      = 0;
+            track.tailTime        = 0;
+            track.tailDuration    = 0;
+            track.offset          = 0;
+            track.timescale       = 1;
+            track.availabilityOffset = 0;
+
+            ok = GetString(strings, header->stringBytes, record.id, track.id) &&
+                 GetString(strings, header->stringBytes, record.dependencyId, dependencyId) &&
+                 GetString(strings, header->stringBytes, record.codecs, codecs) &&
+                 next + record.entries <= header->entries &&
+                 nextComplexity + record.complexities <= header->complexities;
+
+            SplitString(dependencyId, ' ', track.dependencyIds);
+            SplitString(codecs, ',', track.codecs);
+
+            if (ok)
+                track.entries.resize(record.entries);
+
+            for (uint64_t k = 0; ok && k < record.entries; k++)
+            {
+                const CacheEntry    &in    = cacheEntries[next + k];
+                SegmentEntry        &entry = track.entries.at(k);
+                std::string         url;
+
+                ok = GetString(strings, header->stringBytes, in.url, url) &&
+                     GetString(strings, header->stringBytes, in.range, entry.range);
+
+                entry.time               = in.time;
+                entry.number             = in.number;
+                entry.start              = in.start;
+                entry.duration           = in.duration;
+                entry.availabilityOffset = in.availabilityOffset;
+
+                this->Fill(entry, url);
+            }
+
+            for (uint64_t k = 0; ok && k < record.complexities; k++)
+            {
+                const CacheComplexity   &in = cacheComplexities[nextComplexity + k];
+                SegmentComplexity       complexity;
+
+                complexity.points         = in.points;
+                complexity.patches        = in.patches;
+                complexity.atlasWidth     = in.atlasWidth;
+                complexity.atlasHeight    = in.atlasHeight;
+                complexity.occupancyBytes = in.occupancyBytes;
+                complexity.geometryBytes  = in.geometryBytes;
+                complexity.attributeBytes = in.attributeBytes;
+                track.complexity.push_back(complexity);
+            }
+
+            next           += record.entries;
+            nextComplexity += record.complexities;
+            tracks.push_back(track);
+        }
+    }
+
+    munmap(map, size);
+
+    if (!ok)
+        return false;
+
+    this->tracks.swap(tracks);
+    this->tiles.swap(tiles);
+
+    if (this->tiles.empty())
+        this->Link(0, this->tracks.size());
+    for (size_t i = 0; i < this->tiles.size(); i++)
+        this->Link(this->tiles.at(i).firstRepresentation,
+                   this->tiles.at(i).firstRepresentation + this->tiles.at(i).representations);
+    return true;
+}
+void            SegmentIndex::AddList           (Track &track, ISegmentList *list, const std::string &base) const
+{
+    double timescale = list->GetTimescale() > 0 ? list->GetTimescale() : 1;
+
+    track.duration = list->GetDuration() / timescale;
+    track.entries.resize(list->GetSegmentURLCount());
+
+    /* straight from the list's table, no ISegmentURL is created */
+    for (size_t i = 0; i < track.entries.size(); i++)
+    {
+        SegmentEntry    &entry      = track.entries.at(i);
+
+        entry.range              = list->GetSegmentMediaRange(i);
+        entry.number             = (uint32_t) i;
+        entry.time               = 0;
+        entry.start              = i * track.duration;
+        entry.duration           = track.duration;
+        entry.availabilityOffset = list->GetAvailabilityTimeOffset();
+
+        this->Fill(entry, ResolveURL(base, list->GetSegmentMediaURI(i)));
+    }
+}
+void            SegmentIndex::AddTemplate       (Track &track, ISegmentTemplate *segmentTemplate,
+                                                 IRepresentation *representation, const std::string &base) const
+{
+    track.templated          = true;
+    track.segmentTemplate    = segmentTemplate;
+    track.base               = base;
+    track.id                 = representation->GetId();
+    track.timescale          = segmentTemplate->GetTimescale() > 0 ? segmentTemplate->GetTimescale() : 1;
+    track.offset             = segmentTemplate->GetPresentationTimeOffset();
+    track.availabilityOffset = segmentTemplate->GetAvailabilityTimeOffset();
+
+    uint32_t startNumber = segmentTemplate->GetStartNumber();
+
+    /* segments before startNumber have left the timeline */
+    track.first = startNumber >= this->firstNumber ? startNumber - this->firstNumber : 0;
+
+    const ISegmentTimeline *timeline = segmentTemplate->GetSegmentTimeline();
+
+    if (timeline == NULL || timeline->GetTimelines().empty())
+    {
+        if (segmentTemplate->GetDuration() == 0)
+            return;
+
+        track.duration     = segmentTemplate->GetDuration() / track.timescale;
+        track.tailCount    = SIZE_MAX;
+        track.tailNumber   = startNumber;
+        track.tailTime     = track.offset;
+        track.tailDuration = segmentTemplate->GetDuration();
+        return;
+    }
+
+    /* S@t, S@d and S@r; a negative r (read back as 0xffffffff) repeats up
+     * to the next S, or without end for the last one, which becomes the tail */
+    std::vector<ITimeline *>    &timelines = timeline->GetTimelines();
+    uint64_t                    t          = 0;
+    uint32_t                    number     = startNumber;
+
+    track.duration = timelines.at(0)->GetDuration() / track.timescale;
+
+    for (size_t i = 0; i < timelines.size(); i++)
+    {
+        ITimeline   *s = timelines.at(i);
+        uint64_t    d  = s->GetDuration();
+
+        if (s->GetStartTime() > t)
+            t = s->GetStartTime();
+
+        if (d == 0)
+            return;
+
+        uint64_t count = (uint64_t) s->GetRepeatCount() + 1;
+
+        if (s->GetRepeatCount() == UINT32_MAX)
+        {
+            if (i + 1 == timelines.size() || timelines.at(i + 1)->GetStartTime() <= t)
+            {
+                track.tailCount    = SIZE_MAX;
+                track.tailNumber   = number;
+                track.tailTime     = t;
+                track.tailDuration = d;
+                return;
+            }
+            count = (timelines.at(i + 1)->GetStartTime() - t + d - 1) / d;
+        }
+
+        for (uint64_t k = 0; k < count; k++)
+        {
+            SegmentEntry entry;
+
+            entry.number             = number++;
+            entry.time               = t;
+            entry.start              = (double) ((int64_t) (t - track.offset)) / track.timescale;
+            entry.duration           = d / track.timescale;
+            entry.availabilityOffset = track.availabilityOffset;
+
+            this->Fill(entry, ResolveURL(base, segmentTemplate->GetMediaURI(track.id, track.bandwidth, entry.number, entry.time)));
+            track.entries.push_back(entry);
+
+            t += d;
+        }
+    }
+}
+void            SegmentIndex::Fill              (SegmentEntry &entry, const std::string &url) const
+{
+    entry.url  = url;
+    entry.port = 80;
+
+    if (!SplitURL(url, entry.host, entry.port, entry.path))
+    {
+        entry.host.clear();
+        entry.path = url;
+    }
+}
+double          SegmentIndex::ParseFrameRate    (IRepresentation *representation, IAdaptationSet *adaptationSet)
+{
+    std::string value = representation->GetFrameRate();
+
+    /* createContent.sh writes the attribute as "framRate" */
+    if (value.empty())
+    {
+        std::map<std::string, std::string> attributes = representation->GetRawAttributes();
+        if (attributes.find("framRate") != attributes.end())
+            value = attributes["framRate"];
+    }
+
+    if (value.empty())
+        value = adaptationSet->GetFrameRate();
+
+    /* frameRate is either an integer or "num/den" */
+    double num   = atof(value.c_str());
+    size_t slash = value.find('/');
+
+    if (slash != std::string::npos)
+    {
+        double den = atof(value.substr(slash + 1).c_str());
+        return den > 0 ? num / den : 0;
+    }
+    return num;
+}
+std::vector<SegmentComplexity>  SegmentIndex::ParseComplexity   (IRepresentation *representation)
+{
+    const std::vector<IDescriptor *>    &properties = representation->GetSupplementalProperties();
+    std::vector<SegmentComplexity>      segments;
+
+    for (size_t i = 0; i < properties.size(); i++)
+    {
+        if (properties.at(i)->GetSchemeIdUri() != COMPLEXITY_SCHEME_ID)
+            continue;
+
+        /* space separated "points,patches,atlasWidth,atlasHeight,occupancyBytes,geometryBytes,attributeBytes" */
+        const std::string   &value = properties.at(i)->GetValue();
+        const char          *next  = value.c_str();
+
+        while (*next != '\0')
+        {
+            unsigned long long  record[7];
+            int                 length = 0;
+
+            if (sscanf(next, " %llu,%llu,%llu,%llu,%llu,%llu,%llu%n", &record[0], &record[1], &record[2],
+                       &record[3], &record[4], &record[5], &record[6], &length) != 7 || length == 0)
+            {
+                segments.clear();
+                break;
+            }
+
+            SegmentComplexity complexity;
+
+            complexity.points         = record[0];
+            complexity.patches        = record[1];
+            complexity.atlasWidth     = (uint32_t) record[2];
+            complexity.atlasHeight    = (uint32_t) record[3];
+            complexity.occupancyBytes = record[4];
+            complexity.geometryBytes  = record[5];
+            complexity.attributeBytes = record[6];
+            segments.push_back(complexity);
+
+            next += length;
+            while (*next == ' ')
+                next++;
+        }
+        return segments;
+    }
+    return segments;
+}
+bool            SegmentIndex::ParseTile         (IAdaptationSet *adaptationSet, TileRegion &tile)
+{
+    const std::vector<IDescriptor *> &properties = adaptationSet->GetSupplementalProperties();
+
+    for (size_t i = 0; i < properties.size(); i++)
+    {
+        if (properties.at(i)->GetSchemeIdUri() != TILE_SCHEME_ID)
+            continue;
+
+        /* "minX,minY,minZ,maxX,maxY,maxZ" */
+        float   box[6];
+        char    tail;
+
+        if (sscanf(properties.at(i)->GetValue().c_str(), "%f,%f,%f,%f,%f,%f%c",
+                   &box[0], &box[1], &box[2], &box[3], &box[4], &box[5], &tail) != 6)
+            continue;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            tile.min[axis] = std::min(box[axis], box[axis + 3]);
+            tile.max[axis] = std::max(box[axis], box[axis + 3]);
+        }
+        tile.firstRepresentation = 0;
+        tile.representations     = 0;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,204 @@
+/*
+ * SegmentIndex.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Everything needed to request a segment, resolved once per MPD load: the
+ * absolute URL (MPD, Period, AdaptationSet and Representation BaseURLs
+ * applied), host, port and path, the byte range and the timing. Lookups by
+ * (representation, segment number) are O(1), so switching quality costs
+ * nothing. SegmentList and SegmentTimeline entries are stored as they are;
+ * a SegmentTemplate without a timeline, or an open-ended last S, continues
+ * as an arithmetic tail whose URLs are formatted on lookup.
+ *
+ * SetBaseURL() takes the place of the MPD's own BaseURL, e.g. to fetch the
+ * segments through a LAN edge cache (origin/EdgeFetcher); the lower level
+ * BaseURLs still apply on top of it.
+ *
+ * A fully listed index (static MPDs) can be saved to a compact binary file
+ * together with the HTTP validators of its MPD and loaded without the MPD.
+ *
+ * A tiled content has one AdaptationSet per spatial tile, each an
+ * independently encoded V-PCC stream of the points inside a box:
+ *
+ *   <SupplementalProperty schemeIdUri="urn:mcnl:vpcc:tile:2022"
+ *                         value="minX,minY,minZ,maxX,maxY,maxZ"/>
+ *
+ * in the coordinates of the decoded points. If the first AdaptationSet
+ * carries it, every AdaptationSet that does is indexed and their
+ * representations are numbered one tile after the other; otherwise only
+ * the first AdaptationSet is, as one untiled object.
+ *
+ * A dependent Representation (@dependencyId, e.g. an SHVC enhancement
+ * layer) is decoded together with its complementary ones from the same
+ * AdaptationSet; the index keeps them as a chain, lowest layer first.
+ *
+ * A Representation may tell what each of its listed segments takes to
+ * decode (packager/MpdPackager), one record per segment in order:
+ *
+ *   <SupplementalProperty schemeIdUri="urn:mcnl:vpcc:complexity:2022"
+ *       value="points,patches,atlasWidth,atlasHeight,occupancyBytes,geometryBytes,attributeBytes ..."/>
+ *****************************************************************************/
+
+#ifndef SEGMENTINDEX_H_
+#define SEGMENTINDEX_H_
+
+#include "libdash.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace mcnl
+{
+    struct SegmentEntry
+    {
+        std::string     url;            /* absolute */
+        std::string     host;
+        size_t          port;
+        std::string     path;
+        std::string     range;          /* "first-last", empty for the whole resource */
+        uint32_t        number;         /* $Number$ */
+        uint64_t        time;           /* $Time$ */
+        double          start;          /* seconds of period time */
+        double          duration;       /* seconds, 0 if the MPD does not say */
+        double          availabilityOffset; /* availabilityTimeOffset, seconds */
+    };
+
+    /* axis-aligned box of a tile and its representations in the index */
+    struct TileRegion
+    {
+        float           min[3];
+        float           max[3];
+        size_t          firstRepresentation;
+        size_t          representations;
+    };
+
+    #define TILE_SCHEME_ID  "urn:mcnl:vpcc:tile:2022"
+
+    /* decode complexity of a segment, see above: of all its frames, the
+     * largest atlas and the bytes of its video bitstreams */
+    struct SegmentComplexity
+    {
+        uint64_t        points;         /* 0 if the MPD does not say */
+        uint64_t        patches;
+        uint32_t        atlasWidth;
+        uint32_t        atlasHeight;
+        uint64_t        occupancyBytes;
+        uint64_t        geometryBytes;
+        uint64_t        attributeBytes;
+    };
+
+    #define COMPLEXITY_SCHEME_ID    "urn:mcnl:vpcc:complexity:2022"
+
+    /* HTTP validators of the MPD an index was built from */
+    struct IndexValidators
+    {
+        std::string     mpdURL;
+        std::string     baseURL;        /* the override it was built with */
+        std::string     etag;
+        std::string     lastModified;
+    };
+
+    /* "http://host:port/path"; false if url is not absolute */
+    bool        SplitURL    (const std::string &url, std::string &host, size_t &port, std::string &path);
+    /* RFC 3986 style: absolute urls replace base, "/x" replaces its path,
+     * anything else is relative to base's directory */
+    std::string ResolveURL  (const std::string &base, const std::string &url);
+
+    class SegmentIndex
+    {
+        public:
+            SegmentIndex            ();
+            virtual ~SegmentIndex   ();
+
+            /* indexes the first Period, see above. Segment 0 is the first template
+             * segment of the first build; later builds keep that numbering
+             * while startNumber moves on */
+            void    Build               (dash::mpd::IMPD *mpd, const std::string &mpdURL);
+            /* resolved against the MPD URL by Build; empty keeps the MPD's BaseURL */
+            void    SetBaseURL          (const std::string &url);
+
+            bool    Lookup              (size_t representation, size_t segmentNumber, SegmentEntry &entry) const;
+            /* false if the MPD does not tell the complexity of this segment */
+            bool    Complexity          (size_t representation, size_t segmentNumber, SegmentComplexity &complexity) const;
+            /* segments up to the last one listed, SIZE_MAX if open-ended */
+            size_t  Count               (size_t representation) const;
+            /* nominal segment duration in seconds, 0 if unknown */
+            double  Duration            (size_t representation) const;
+            bool    Templated           (size_t representation) const;
+            size_t  Representations     () const;
+            uint32_t    Bandwidth       (size_t representation) const;
+            /* frames per second, 0 if the MPD does not say */
+            double      FrameRate       (size_t representation) const;
+            /* @codecs of the Representation, or of its AdaptationSet; empty if neither says */
+            const std::vector<std::string>& Codecs  (size_t representation) const;
+            /* the complementary representations of a dependent one, lowest layer first */
+            const std::vector<size_t>&  Dependencies    (size_t representation) const;
+            /* of a layered content: complementary representations it has, 0 for a base
+             * layer others depend on; SIZE_MAX for a representation that is neither */
+            size_t      Layer           (size_t representation) const;
+            /* 0 for an untiled content */
+            size_t      Tiles           () const;
+            const TileRegion&   Tile    (size_t tile) const;
+
+            /* only an index without open-ended tails can be cached; the file
+             * is written to a temporary name and renamed into place */
+            bool    Save                (const std::string &path, const IndexValidators &validators) const;
+            /* replaces the index; false if the file is missing or unusable */
+            bool    Load                (const std::string &path, IndexValidators &validators);
+
+        private:
+            struct Track
+            {
+                std::vector<SegmentEntry>       entries;
+                size_t                          first;          /* segment number of entries[0] */
+                /* from segment number first on, also for the first segments of a template tail */
+                std::vector<SegmentComplexity>  complexity;
+                double                          duration;
+                bool                            templated;
+                uint32_t                        bandwidth;
+                double                          frameRate;
+                std::vector<std::string>        codecs;
+                std::vector<std::string>        dependencyIds;  /* @dependencyId */
+                std::vector<size_t>             dependencies;   /* resolved by Link */
+                bool                            layered;
+
+                /* template tail, segments from first + entries.size() on */
+                dash::mpd::ISegmentTemplate     *segmentTemplate;
+                std::string                     base;
+                std::string                     id;
+                size_t                          tailCount;      /* SIZE_MAX if open, 0 if none */
+                uint32_t                        tailNumber;
+                uint64_t                        tailTime;
+                uint64_t                        tailDuration;
+                uint64_t                        offset;         /* presentationTimeOffset */
+                double                          timescale;
+                double                          availabilityOffset;
+            };
+
+            std::vector<Track>      tracks;
+            std::vector<TileRegion> tiles;
+            bool                    numbered;
+            uint32_t                firstNumber;
+            std::string             baseURL;
+
+            void    AddList             (Track &track, dash::mpd::ISegmentList *list, const std::string &base) const;
+            void    AddTemplate         (Track &track, dash::mpd::ISegmentTemplate *segmentTemplate,
+                                         dash::mpd::IRepresentation *representation, const std::string &base) const;
+            void    Fill                (SegmentEntry &entry, const std::string &url) const;
+            static double   ParseFrameRate  (dash::mpd::IRepresentation *representation, dash::mpd::IAdaptationSet *adaptationSet);
+            /* false if the AdaptationSet has no tile property */
+            static bool     ParseTile       (dash::mpd::IAdaptationSet *adaptationSet, TileRegion &tile);
+            /* empty if the Representation has no complexity property or it does not parse */
+            static std::vector<SegmentComplexity>   ParseComplexity (dash::mpd::IRepresentation *representation);
+            void    AddAdaptationSet    (dash::mpd::IMPD *mpd, dash::mpd::IPeriod *period,
+                                         dash::mpd::IAdaptationSet *adaptationSet, const std::string &mpdURL);
+            /* resolves the dependencyIds of tracks [first, end) among themselves, the
+             * representations of one AdaptationSet */
+            void    Link                (size_t first, size_t end);
+    };
+}
+
+#endif /* SEGMENTINDEX_H_ */
@@ -0,0 +1,100 @@
+/*
+ * SegmentPrefetcher.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "SegmentPrefetcher.h"
+#include "Tracer.h"
+
+#include <algorithm>
+
+using namespace mcnl;
+
+SegmentPrefetcher::SegmentPrefetcher    (SegmentFetcher &fetcher, size_t window) :
+                   fetcher              (fetcher),
+                   window               (window > 0 ? window : 1)
+{
+}
+SegmentPrefetcher::~SegmentPrefetcher   ()
+{
+    /* futures from std::async join in their destructors */
+    this->pending.clear();
+}
+
+bool    SegmentPrefetcher::Request      (size_t segmentNumber, size_t representation,
+                                         std::shared_ptr<SegmentStream> stream)
+{
+    if (!this->CanRequest())
+        return false;
+
+    /* the oldest request is the one the decoder waits for; each later one
+     * gets half the HTTP/2 weight of its predecessor */
+    uint32_t weight = STREAM_WEIGHT_NEXT >> std::min(this->pending.size(), (size_t) 7);
+
+    this->pending.push_back(this->Launch(segmentNumber, representation, stream, weight));
+    return true;
+}
+bool    SegmentPrefetcher::Next         (SegmentInfo &info, const Watchdog &watchdog)
+{
+    if (this->pending.empty())
+        return false;
+
+    Pending request = std::move(this->pending.front());
+    this->pending.pop_front();
+
+    while (watchdog && !request.info->stream &&
+           request.done.wait_for(std::chrono::duration<double>(PREFETCH_WATCH_INTERVAL)) != std::future_status::ready)
+    {
+        size_t representation = watchdog(request.segmentNumber, request.representation, *request.info->progress);
+
+        if (representation == request.representation)
+            continue;
+
+        uint64_t traceStart = Tracer::Instance().Now();
+
+        request.info->progress->Abort();
+        request.done.wait();
+        Tracer::Instance().Complete("download abandoned", "fetch", traceStart, Tracer::Instance().Now(),
+                                    request.segmentNumber);
+        request = this->Launch(request.segmentNumber, representation, NULL, STREAM_WEIGHT_NEXT);
+    }
+
+    bool ok = request.done.get();
+    if (ok)
+        info = std::move(*request.info);
+
+    return ok;
+}
+SegmentPrefetcher::Pending   SegmentPrefetcher::Launch   (size_t segmentNumber, size_t representation,
+                                                         std::shared_ptr<SegmentStream> stream, uint32_t weight)
+{
+    Pending                         request;
+    std::shared_ptr<SegmentInfo>    info(new SegmentInfo());
+    SegmentFetcher                  *fetcher = &this->fetcher;
+
+    /* every Download uses its own connection, so requests can overlap */
+    info->stream            = stream;
+    info->progress          = std::make_shared<DownloadProgress>();
+    request.info            = info;
+    request.segmentNumber   = segmentNumber;
+    request.representation  = representation;
+    request.done            = std::async(std::launch::async, [fetcher, info, segmentNumber, representation, weight]() {
+        Tracer::Instance().NameThread("download");
+        return fetcher->Download(segmentNumber, representation, *info, weight);
+    });
+
+    return request;
+}
+size_t  SegmentPrefetcher::InFlight     () const
+{
+    return this->pending.size();
+}
+size_t  SegmentPrefetcher::Window       () const
+{
+    return this->window;
+}
+bool    SegmentPrefetcher::CanRequest   () const
+{
+    return this->pending.size() < this->window;
+}
@@ -0,0 +1,73 @@
+/*
+ * SegmentPrefetcher.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Keeps up to `window` segment downloads in flight ahead of the decoder so
+ * network time overlaps decode time. Results are returned in request order.
+ *
+ * While Next waits for the oldest download, a watchdog can look at its
+ * progress every PREFETCH_WATCH_INTERVAL and have it abandoned, e.g. when
+ * the throughput collapsed and it would not finish before the buffer runs
+ * dry: the download is aborted and the same segment requested again in
+ * its place, at the representation the watchdog says. A download that
+ * streams to the decoder is never abandoned, the decoder has its first
+ * bytes already.
+ *****************************************************************************/
+
+#ifndef SEGMENTPREFETCHER_H_
+#define SEGMENTPREFETCHER_H_
+
+#include "SegmentFetcher.h"
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+
+#define PREFETCH_WATCH_INTERVAL 0.1     /* seconds */
+
+namespace mcnl
+{
+    class SegmentPrefetcher
+    {
+        public:
+            /* the representation to fetch the segment at instead, or the
+             * one it is being fetched at to go on */
+            typedef std::function<size_t (size_t segmentNumber, size_t representation,
+                                          const DownloadProgress &progress)> Watchdog;
+
+            SegmentPrefetcher           (SegmentFetcher &fetcher, size_t window);
+            virtual ~SegmentPrefetcher  ();
+
+            /* false if the window is already full; a stream gets the bytes
+             * while they arrive, see SegmentInfo::stream */
+            bool    Request             (size_t segmentNumber, size_t representation,
+                                         std::shared_ptr<SegmentStream> stream = std::shared_ptr<SegmentStream>());
+            /* waits for the oldest request; false if nothing is pending or it
+             * failed. watchdog may replace it meanwhile, see above */
+            bool    Next                (SegmentInfo &info, const Watchdog &watchdog = Watchdog());
+
+            size_t  InFlight            () const;
+            size_t  Window              () const;
+            bool    CanRequest          () const;
+
+        private:
+            struct Pending
+            {
+                std::future<bool>           done;
+                std::shared_ptr<SegmentInfo> info;
+                size_t                      segmentNumber;
+                size_t                      representation;
+            };
+
+            Pending Launch              (size_t segmentNumber, size_t representation,
+                                         std::shared_ptr<SegmentStream> stream, uint32_t weight);
+
+            SegmentFetcher              &fetcher;
+            size_t                      window;
+            std::deque<Pending>         pending;
+    };
+}
+
+#endif /* SEGMENTPREFETCHER_H_ */
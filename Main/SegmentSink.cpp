@@ -0,0 +1,190 @@
+/*
+ * SegmentSink.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "SegmentSink.h"
+
+using namespace mcnl;
+
+DownloadProgress::DownloadProgress  () :
+                  nextId            (0),
+                  received          (0),
+                  length            (-1),
+                  aborted           (false),
+                  rtt               (0),
+                  deliveryRate      (0),
+                  start             (std::chrono::steady_clock::now())
+{
+}
+uint64_t    DownloadProgress::Received  () const
+{
+    return this->received.load();
+}
+int64_t     DownloadProgress::Length    () const
+{
+    return this->length.load();
+}
+double      DownloadProgress::Seconds   () const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+}
+double      DownloadProgress::RTT       () const
+{
+    return this->rtt.load();
+}
+double      DownloadProgress::DeliveryRate  () const
+{
+    return this->deliveryRate.load();
+}
+bool        DownloadProgress::Aborted   () const
+{
+    return this->aborted.load();
+}
+void        DownloadProgress::Abort     ()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::map<uint64_t, std::function<void ()> >::iterator it;
+
+    this->aborted.store(true);
+    for (it = this->cancels.begin(); it != this->cancels.end(); ++it)
+        it->second();
+}
+uint64_t    DownloadProgress::Attach    (std::function<void ()> cancel)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->aborted.load())
+        cancel();
+    this->cancels[this->nextId] = cancel;
+
+    return this->nextId++;
+}
+void        DownloadProgress::Detach    (uint64_t id)
+{
+    /* waits for an Abort under way, the transfer is still there for it */
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->cancels.erase(id);
+}
+void        DownloadProgress::Update    (uint64_t received, int64_t length)
+{
+    this->received.store(received);
+    this->length.store(length);
+}
+void        DownloadProgress::UpdateTCP (double rtt, double deliveryRate)
+{
+    this->rtt.store(rtt);
+    this->deliveryRate.store(deliveryRate);
+}
+
+SegmentSink::SegmentSink    (std::vector<uint8_t> &data, const std::string &teePath) :
+             data           (data),
+             teePath        (teePath),
+             size           (0),
+             stream         (NULL),
+             forwarded      (0),
+             progress       (NULL),
+             length         (-1),
+             deliveryRate   (0)
+{
+}
+SegmentSink::~SegmentSink   ()
+{
+    if (this->tee.is_open())
+        this->tee.close();
+}
+
+void        SegmentSink::Begin          (int64_t length)
+{
+    this->size   = 0;
+    this->length = length > 0 ? length : -1;
+    this->data.resize(length > 0 ? (size_t) length : SINK_GROW_SIZE);
+    if (this->progress != NULL)
+        this->progress->Update(0, this->length);
+
+    if (this->tee.is_open())
+        this->tee.close();
+    if (!this->teePath.empty())
+        this->tee.open(this->teePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+}
+uint8_t*    SegmentSink::WritePointer   (size_t &available)
+{
+    /* only happens without (or with a wrong) Content-Length */
+    if (this->size == this->data.size())
+        this->data.resize(this->data.size() * 2 + SINK_GROW_SIZE);
+
+    available = this->data.size() - this->size;
+    return this->data.data() + this->size;
+}
+void        SegmentSink::Commit         (size_t bytes)
+{
+    if (this->tee.is_open())
+        this->tee.write((const char *) this->data.data() + this->size, bytes);
+
+    this->size += bytes;
+    this->ForwardUpTo(this->size);
+    if (this->progress != NULL)
+        this->progress->Update(this->size, this->length);
+}
+uint8_t*    SegmentSink::At             (size_t offset)
+{
+    return this->data.data() + offset;
+}
+void        SegmentSink::Filled         (size_t bytes)
+{
+    if (this->tee.is_open())
+        this->tee.write((const char *) this->data.data(), bytes);
+
+    this->size = bytes;
+    this->ForwardUpTo(this->size);
+    if (this->progress != NULL)
+        this->progress->Update(this->size, this->length);
+}
+void        SegmentSink::Finish         ()
+{
+    this->data.resize(this->size);
+
+    if (this->tee.is_open())
+        this->tee.close();
+}
+size_t      SegmentSink::Size           () const
+{
+    return this->size;
+}
+void        SegmentSink::Forward        (SegmentStream *stream)
+{
+    this->stream = stream;
+}
+void        SegmentSink::Watch          (DownloadProgress *progress)
+{
+    this->progress = progress;
+}
+DownloadProgress*   SegmentSink::Progress   () const
+{
+    return this->progress;
+}
+bool        SegmentSink::Aborted        () const
+{
+    return this->progress != NULL && this->progress->Aborted();
+}
+void        SegmentSink::SampledTCP     (double rtt, double deliveryRate)
+{
+    this->deliveryRate = deliveryRate;
+    if (this->progress != NULL)
+        this->progress->UpdateTCP(rtt, deliveryRate);
+}
+double      SegmentSink::DeliveryRate   () const
+{
+    return this->deliveryRate;
+}
+void        SegmentSink::ForwardUpTo    (size_t end)
+{
+    if (this->stream == NULL || end <= this->forwarded)
+        return;
+
+    this->stream->Write(this->data.data() + this->forwarded, end - this->forwarded);
+    this->forwarded = end;
+}
@@ -0,0 +1,121 @@
+/*
+ * SegmentSink.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Destination of a download. Received bytes go straight into a vector that
+ * is sized from Content-Length up front (and later handed to PCCBitstream
+ * without a copy); optionally the same bytes are teed to a file for
+ * debugging. A DownloadProgress follows what arrives, for whoever may
+ * abandon the download meanwhile.
+ *****************************************************************************/
+
+#ifndef SEGMENTSINK_H_
+#define SEGMENTSINK_H_
+
+#include "SegmentStream.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#define SINK_GROW_SIZE 32768
+
+namespace mcnl
+{
+    /* Bytes of one download so far, read by another thread, which can also
+     * abort it: the transfer under way is cut off (the HTTP/1.1 socket shut
+     * down, the HTTP/2 stream reset) and the download fails. Over HTTP/1.1 on
+     * Linux it also carries what TCP_INFO says of the connection, which is
+     * timely where bytes over wall time still include the request's round
+     * trip and slow start. */
+    class DownloadProgress
+    {
+        public:
+            DownloadProgress            ();
+
+            uint64_t    Received        () const;
+            /* of the whole response, -1 until its header tells */
+            int64_t     Length          () const;
+            /* since the download was made */
+            double      Seconds         () const;
+            /* of the connection, from its last TCP_INFO sample; 0 until sampled */
+            double      RTT             () const;   /* seconds */
+            double      DeliveryRate    () const;   /* bits per second */
+            bool        Aborted         () const;
+            void        Abort           ();
+
+            /* the download's side: cancel cuts off one transfer from another
+             * thread, at once if already aborted; detached before the
+             * transfer goes away */
+            uint64_t    Attach          (std::function<void ()> cancel);
+            void        Detach          (uint64_t id);
+            void        Update          (uint64_t received, int64_t length);
+            void        UpdateTCP       (double rtt, double deliveryRate);
+
+        private:
+            mutable std::mutex                          mutex;
+            std::map<uint64_t, std::function<void ()> > cancels;
+            uint64_t                                    nextId;
+            std::atomic<uint64_t>                       received;
+            std::atomic<int64_t>                        length;
+            std::atomic<bool>                           aborted;
+            std::atomic<double>                         rtt;
+            std::atomic<double>                         deliveryRate;
+            std::chrono::steady_clock::time_point       start;
+    };
+
+    class SegmentSink
+    {
+        public:
+            SegmentSink             (std::vector<uint8_t> &data, const std::string &teePath = "");
+            virtual ~SegmentSink    ();
+
+            /* drops anything written so far; length < 0 if unknown */
+            void        Begin           (int64_t length);
+            /* room for at least one more read at the end of the data */
+            uint8_t*    WritePointer    (size_t &available);
+            void        Commit          (size_t bytes);
+            /* ranged downloads: after Begin(length), parts are written in place
+             * at their offsets and Filled() marks the whole buffer as received */
+            uint8_t*    At              (size_t offset);
+            void        Filled          (size_t bytes);
+            /* trims the vector to what was received and closes the tee */
+            void        Finish          ();
+
+            size_t      Size            () const;
+            /* also pass received bytes on to stream as they are committed;
+             * after a retry (Begin again) only bytes beyond what was already
+             * passed on are forwarded */
+            void        Forward         (SegmentStream *stream);
+            /* also report to progress; NULL = none */
+            void        Watch           (DownloadProgress *progress);
+            DownloadProgress*   Progress    () const;
+            bool        Aborted         () const;
+            /* a TCP_INFO sample of the connection, passed on to the progress */
+            void        SampledTCP      (double rtt, double deliveryRate);
+            /* bits per second, of the last sample; 0 if there was none */
+            double      DeliveryRate    () const;
+
+        private:
+            std::vector<uint8_t>    &data;
+            std::string             teePath;
+            std::ofstream           tee;
+            size_t                  size;
+            SegmentStream           *stream;
+            size_t                  forwarded;
+            DownloadProgress        *progress;
+            int64_t                 length;
+            double                  deliveryRate;
+
+            void        ForwardUpTo     (size_t end);
+    };
+}
+
+#endif /* SEGMENTSINK_H_ */
@@ -0,0 +1,62 @@
+/*
+ * SegmentStream.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "SegmentStream.h"
+
+using namespace mcnl;
+
+SegmentStream::SegmentStream    () :
+               received         (0),
+               closed           (false),
+               complete         (false)
+{
+}
+SegmentStream::~SegmentStream   ()
+{
+}
+
+void    SegmentStream::Write        (const uint8_t *data, size_t len)
+{
+    if (len == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->pieces.push_back(std::vector<uint8_t>(data, data + len));
+    this->received += len;
+    this->cond.notify_all();
+}
+void    SegmentStream::Close        (bool complete)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->closed   = true;
+    this->complete = complete;
+    this->cond.notify_all();
+}
+bool    SegmentStream::Read         (std::vector<uint8_t> &piece)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    this->cond.wait(lock, [this] { return !this->pieces.empty() || this->closed; });
+
+    if (this->pieces.empty())
+        return false;
+
+    piece.swap(this->pieces.front());
+    this->pieces.pop_front();
+    return true;
+}
+bool    SegmentStream::Complete     () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->closed && this->complete;
+}
+size_t  SegmentStream::Received     () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->received;
+}
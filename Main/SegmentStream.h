@@ -0,0 +1,49 @@
+/*
+ * SegmentStream.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Bytes of a segment that is still downloading, handed from the fetch
+ * thread to the decoder thread piece by piece as they are received.
+ *****************************************************************************/
+
+#ifndef SEGMENTSTREAM_H_
+#define SEGMENTSTREAM_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace mcnl
+{
+    class SegmentStream
+    {
+        public:
+            SegmentStream           ();
+            virtual ~SegmentStream  ();
+
+            /* writer side */
+            void    Write           (const uint8_t *data, size_t len);
+            /* end of the download; complete is false if it failed */
+            void    Close           (bool complete);
+
+            /* blocks for the next piece; false once closed and drained */
+            bool    Read            (std::vector<uint8_t> &piece);
+            /* valid after Read returned false */
+            bool    Complete        () const;
+            size_t  Received        () const;
+
+        private:
+            mutable std::mutex                  mutex;
+            std::condition_variable             cond;
+            std::deque<std::vector<uint8_t> >   pieces;
+            size_t                              received;
+            bool                                closed;
+            bool                                complete;
+    };
+}
+
+#endif /* SEGMENTSTREAM_H_ */
@@ -0,0 +1,213 @@
+/*
+ * SegmentTelemetry.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "SegmentTelemetry.h"
+#include "PCCMemory.h"
+#include "PCCMetrics.h"
+#include "PCCMetricsParameters.h"
+
+#include <cmath>
+#include <fstream>
+#include <stdio.h>
+
+using namespace mcnl;
+using namespace pcc;
+
+/* PSNRs are infinite for lossless frames, JSON has no number for that */
+static void     WriteJsonNumber (std::ostream &out, double value)
+{
+    if (std::isfinite(value))
+        out << value;
+    else
+        out << "null";
+}
+
+SegmentTelemetry::SegmentTelemetry  () :
+                  referenceCached   (false),
+                  firstFrame        (0),
+                  peak              (TELEMETRY_DEFAULT_PEAK),
+                  every             (0),
+                  current           (),
+                  active            (false),
+                  haveSampled       (false)
+{
+}
+SegmentTelemetry::~SegmentTelemetry ()
+{
+}
+
+void    SegmentTelemetry::SetReference  (const std::string &pattern, size_t firstFrame, float peak)
+{
+    this->referencePattern  = pattern;
+    this->firstFrame        = firstFrame;
+    this->peak              = peak;
+    this->referenceCached   = PCCFrameCache::isFrameCache(pattern) && this->referenceCache.open(pattern);
+}
+void    SegmentTelemetry::SetSampling   (size_t every)
+{
+    this->every = every;
+}
+void    SegmentTelemetry::Begin         (size_t segmentNumber, size_t representation)
+{
+    this->current                   = SegmentSample();
+    this->current.segmentNumber     = segmentNumber;
+    this->current.representation    = representation;
+    this->active                    = true;
+    this->haveSampled               = false;
+}
+void    SegmentTelemetry::OnFrame       (const PCCPointSet3 &frame, size_t streamFrame)
+{
+    if (!this->active)
+        return;
+
+    this->current.frames++;
+    this->current.points += frame.getPointCount();
+
+    if (this->haveSampled || this->every == 0 || this->referencePattern.empty() ||
+        this->current.segmentNumber % this->every != 0)
+        return;
+
+    /* copied before the renderer takes the frame, compared in End */
+    this->sampled.clear();
+    this->sampled.getPositions() = frame.getPositions();
+    if (frame.hasColors())
+    {
+        this->sampled.addColors();
+        this->sampled.getColors() = frame.getColors();
+    }
+    this->current.referenceFrame = this->firstFrame + streamFrame;
+    this->haveSampled = true;
+}
+void    SegmentTelemetry::End           (size_t bytes, double decodeSeconds, double busySeconds)
+{
+    if (!this->active)
+        return;
+
+    this->current.bytes         = bytes;
+    this->current.decodeSeconds = decodeSeconds;
+    this->current.busySeconds   = busySeconds;
+    this->current.peakMemory    = getPeakMemory();
+
+    if (this->haveSampled)
+        this->current.measured = this->Measure(this->current);
+
+    this->samples.push_back(this->current);
+    this->active        = false;
+    this->haveSampled   = false;
+    this->sampled.clear();
+}
+
+const std::vector<SegmentSample>&   SegmentTelemetry::Samples   () const
+{
+    return this->samples;
+}
+bool    SegmentTelemetry::Write         (const std::string &path) const
+{
+    std::ofstream out(path.c_str());
+
+    if (!out)
+        return false;
+
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+    return json ? this->WriteJson(out) : this->WriteCsv(out);
+}
+
+bool    SegmentTelemetry::Measure       (SegmentSample &sample)
+{
+    PCCPointSet3 reference;
+
+    if (this->referenceCached)
+    {
+        if (!this->referenceCache.read(sample.referenceFrame, reference))
+            return false;
+    }
+    else
+    {
+        char name[1024];
+
+        snprintf(name, sizeof(name), this->referencePattern.c_str(), (int) sample.referenceFrame);
+        if (!reference.read(name))
+            return false;
+    }
+
+    /* symmetric D1 and color, the decoded frames carry no normals for D2 */
+    PCCMetricsParameters params;
+    params.computeC2c_      = true;
+    params.computeC2p_      = false;
+    params.computeColor_    = reference.hasColors() && this->sampled.hasColors();
+    params.resolution_      = this->peak;
+    params.neighborsProc_   = 1;
+
+    QualityMetrics  forward;
+    QualityMetrics  backward;
+
+    forward.setParameters(params);
+    backward.setParameters(params);
+    forward.compute(reference, this->sampled);
+    backward.compute(this->sampled, reference);
+
+    QualityMetrics symmetric = forward + backward;
+
+    sample.d1Mse  = symmetric.getC2cMse();
+    sample.d1Psnr = symmetric.getC2cPsnr();
+    for (size_t c = 0; c < 3; c++)
+        sample.colorPsnr[c] = params.computeColor_ ? symmetric.getColorPsnr(c) : 0.0f;
+
+    return true;
+}
+bool    SegmentTelemetry::WriteCsv      (std::ostream &out) const
+{
+    out << "segment,representation,bytes,decode_s,busy_s,frames,points,peak_kb,"
+           "reference_frame,d1_mse,d1_psnr,y_psnr,u_psnr,v_psnr\n";
+
+    for (size_t i = 0; i < this->samples.size(); i++)
+    {
+        const SegmentSample &s = this->samples.at(i);
+
+        out << s.segmentNumber << "," << s.representation << "," << s.bytes << "," << s.decodeSeconds << "," <<
+               s.busySeconds << "," << s.frames << "," << s.points << "," << s.peakMemory;
+        /* empty columns for the segments without a quality check */
+        if (s.measured)
+            out << "," << s.referenceFrame << "," << s.d1Mse << "," << s.d1Psnr << "," << s.colorPsnr[0] << "," <<
+                   s.colorPsnr[1] << "," << s.colorPsnr[2] << "\n";
+        else
+            out << ",,,,,,\n";
+    }
+
+    return out.good();
+}
+bool    SegmentTelemetry::WriteJson     (std::ostream &out) const
+{
+    out << "[\n";
+
+    for (size_t i = 0; i < this->samples.size(); i++)
+    {
+        const SegmentSample &s = this->samples.at(i);
+
+        out << (i == 0 ? "" : ",\n") << "{\"segment\":" << s.segmentNumber << ",\"representation\":" <<
+               s.representation << ",\"bytes\":" << s.bytes << ",\"decodeSeconds\":" << s.decodeSeconds <<
+               ",\"busySeconds\":" << s.busySeconds << ",\"frames\":" << s.frames << ",\"points\":" << s.points <<
+               ",\"peakMemoryKB\":" << s.peakMemory;
+        if (s.measured)
+        {
+            out << ",\"quality\":{\"referenceFrame\":" << s.referenceFrame << ",\"d1Mse\":" << s.d1Mse <<
+                   ",\"d1Psnr\":";
+            WriteJsonNumber(out, s.d1Psnr);
+            out << ",\"yPsnr\":";
+            WriteJsonNumber(out, s.colorPsnr[0]);
+            out << ",\"uPsnr\":";
+            WriteJsonNumber(out, s.colorPsnr[1]);
+            out << ",\"vPsnr\":";
+            WriteJsonNumber(out, s.colorPsnr[2]);
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n]\n";
+
+    return out.good();
+}
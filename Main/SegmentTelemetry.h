@@ -0,0 +1,95 @@
+/*
+ * SegmentTelemetry.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Decode cost against quality, per decoded segment: the bytes, the decode
+ * wall and busy time, the reconstructed frames and points and the peak
+ * memory of the process. With a reference set, the first frame of every
+ * n-th segment is kept and compared against the source PLY of that frame
+ * (symmetric D1 and Y/U/V PSNR, as in PCCMetrics) after the segment was
+ * decoded, so the comparison does not count as decode time. The records
+ * are written as CSV, or as JSON if the file name ends in ".json", to tune
+ * the representation ladder (cfg/rate/) for decode cost and not only
+ * bitrate. Used from the decode thread only.
+ *****************************************************************************/
+
+#ifndef SEGMENTTELEMETRY_H_
+#define SEGMENTTELEMETRY_H_
+
+#include "PCCCommon.h"
+#include "PCCPointSet.h"
+#include "PCCFrameCache.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_DEFAULT_PEAK  1023.0f     /* 10 bit geometry, the PSNR peak of D1 */
+
+namespace mcnl
+{
+    struct SegmentSample
+    {
+        size_t      segmentNumber;
+        size_t      representation;
+        size_t      bytes;
+        double      decodeSeconds;      /* wall time of the Decode call */
+        double      busySeconds;        /* see VpccDecoder::BusySeconds */
+        size_t      frames;
+        size_t      points;             /* over all frames of the segment */
+        uint64_t    peakMemory;         /* KB, VmPeak of the process after the decode */
+        /* quality, only if the segment was sampled and its reference read */
+        bool        measured;
+        size_t      referenceFrame;
+        float       d1Mse;
+        float       d1Psnr;
+        float       colorPsnr[3];       /* Y, U, V */
+    };
+
+    class SegmentTelemetry
+    {
+        public:
+            SegmentTelemetry            ();
+            virtual ~SegmentTelemetry   ();
+
+            /* printf pattern of the source PLYs, formatted with firstFrame
+             * plus the frame number in the stream, or a frame cache (see
+             * PccAppIngest) holding those frame numbers; "" = no quality check */
+            void    SetReference        (const std::string &pattern, size_t firstFrame,
+                                         float peak = TELEMETRY_DEFAULT_PEAK);
+            /* compare every n-th segment with the reference, 0 = never */
+            void    SetSampling         (size_t every);
+
+            void    Begin               (size_t segmentNumber, size_t representation);
+            /* streamFrame: frame number from the start of the stream */
+            void    OnFrame             (const pcc::PCCPointSet3 &frame, size_t streamFrame);
+            /* runs the quality check, if any, and keeps the record */
+            void    End                 (size_t bytes, double decodeSeconds, double busySeconds);
+
+            const std::vector<SegmentSample>&   Samples () const;
+            bool    Write               (const std::string &path) const;
+
+        private:
+            std::string                 referencePattern;
+            pcc::PCCFrameCache          referenceCache;     /* open if referencePattern is one */
+            bool                        referenceCached;
+            size_t                      firstFrame;
+            float                       peak;
+            size_t                      every;
+            SegmentSample               current;
+            bool                        active;
+            /* the frame to compare, positions and colors only */
+            pcc::PCCPointSet3           sampled;
+            bool                        haveSampled;
+            std::vector<SegmentSample>  samples;
+
+            bool    Measure             (SegmentSample &sample);
+            bool    WriteCsv            (std::ostream &out) const;
+            bool    WriteJson           (std::ostream &out) const;
+    };
+}
+
+#endif /* SEGMENTTELEMETRY_H_ */
@@ -0,0 +1,292 @@
+/*
+ * SpscRing.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Lock-free single-producer/single-consumer ring used between the pipeline
+ * stages (fetch -> decode -> render). Payloads are moved in and out, so the
+ * ring can carry std::unique_ptr and nothing is leaked or copied.
+ *
+ * The fast path is two atomics per item. When the ring is full/empty the
+ * waiting side either spins with backoff (WAIT_BACKOFF) or, after a short
+ * spin, sleeps on a condition variable that the other side only touches
+ * when someone is actually sleeping (WAIT_BLOCK).
+ *
+ * With a byte budget the ring is also full once its items hold that many
+ * bytes, as told by the producer with each one, so a queue of segments or
+ * frames of any size stays within the memory meant for it. An item that
+ * is larger than the whole budget still goes into an empty ring.
+ *****************************************************************************/
+
+#ifndef SPSCRING_H_
+#define SPSCRING_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPSC_CACHE_LINE     64
+#define SPSC_SPIN_COUNT     128
+
+namespace mcnl
+{
+    enum WaitPolicy
+    {
+        WAIT_BACKOFF,       /* spin, yield, then sleep with growing intervals */
+        WAIT_BLOCK          /* spin briefly, then sleep until notified */
+    };
+
+    struct RingStats
+    {
+        size_t  pushed;
+        size_t  popped;
+        size_t  highWater;          /* largest occupancy seen by the producer */
+        size_t  bytes;              /* queued now */
+        size_t  highWaterBytes;     /* most bytes queued at once */
+        size_t  producerWaits;      /* pushes that found the ring full */
+        size_t  consumerWaits;      /* pops that found the ring empty */
+    };
+
+    template <typename T>
+    class SpscRing
+    {
+        public:
+            /* capacity is rounded up to a power of two */
+            SpscRing                (size_t capacity, WaitPolicy policy = WAIT_BLOCK) :
+                policy              (policy),
+                head                (0),
+                tail                (0),
+                closed              (false),
+                bytes               (0),
+                byteBudget          (0),
+                sleepers            (0),
+                producerWaits       (0),
+                consumerWaits       (0),
+                highWater           (0),
+                highWaterBytes      (0)
+            {
+                size_t size = 2;
+                while (size < capacity)
+                    size <<= 1;
+
+                this->slots.resize(size);
+                this->slotBytes.resize(size);
+                this->mask = size - 1;
+            }
+            virtual ~SpscRing       ()
+            {
+            }
+
+            /* 0 = items are only counted; the producer may change it between pushes */
+            void    SetByteBudget   (size_t budget)
+            {
+                this->byteBudget.store(budget, std::memory_order_relaxed);
+            }
+
+            /* producer side; itemBytes counts against the byte budget until the item is popped */
+            bool    TryPush         (T &item, size_t itemBytes = 0)
+            {
+                size_t tail = this->tail.load(std::memory_order_relaxed);
+                size_t head = this->head.load(std::memory_order_acquire);
+
+                if (tail - head > this->mask || !this->HasRoom(tail - head, itemBytes))
+                    return false;
+
+                this->slots[tail & this->mask]      = std::move(item);
+                this->slotBytes[tail & this->mask]  = itemBytes;
+                size_t queued = this->bytes.fetch_add(itemBytes, std::memory_order_relaxed) + itemBytes;
+                this->tail.store(tail + 1, std::memory_order_release);
+
+                if (tail + 1 - head > this->highWater.load(std::memory_order_relaxed))
+                    this->highWater.store(tail + 1 - head, std::memory_order_relaxed);
+                if (queued > this->highWaterBytes.load(std::memory_order_relaxed))
+                    this->highWaterBytes.store(queued, std::memory_order_relaxed);
+
+                this->Notify();
+                return true;
+            }
+            /* blocks while full; returns false once closed, and the item is dropped with the argument */
+            bool    Push            (T item, size_t itemBytes = 0)
+            {
+                if (this->TryPush(item, itemBytes))
+                    return true;
+
+                this->producerWaits.fetch_add(1, std::memory_order_relaxed);
+                while (!this->closed.load(std::memory_order_acquire))
+                {
+                    if (this->Wait([this, itemBytes] {
+                            size_t size = this->Size();
+                            return (size <= this->mask && this->HasRoom(size, itemBytes)) || this->IsClosed();
+                        }) &&
+                        this->TryPush(item, itemBytes))
+                        return true;
+                }
+                return false;
+            }
+
+            /* consumer side */
+            bool    TryPop          (T &item)
+            {
+                size_t head = this->head.load(std::memory_order_relaxed);
+                size_t tail = this->tail.load(std::memory_order_acquire);
+
+                if (head == tail)
+                    return false;
+
+                item = std::move(this->slots[head & this->mask]);
+                this->bytes.fetch_sub(this->slotBytes[head & this->mask], std::memory_order_relaxed);
+                this->head.store(head + 1, std::memory_order_release);
+
+                this->Notify();
+                return true;
+            }
+            /* blocks while empty; returns false once closed and drained */
+            bool    Pop             (T &item)
+            {
+                if (this->TryPop(item))
+                    return true;
+
+                this->consumerWaits.fetch_add(1, std::memory_order_relaxed);
+                for (;;)
+                {
+                    this->Wait([this] { return this->Size() > 0 || this->IsClosed(); });
+
+                    if (this->TryPop(item))
+                        return true;
+                    if (this->IsClosed() && this->Size() == 0)
+                        return false;
+                }
+            }
+
+            /* end of stream: wakes both sides, Pop drains what is left */
+            void    Close           ()
+            {
+                this->closed.store(true, std::memory_order_seq_cst);
+
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->cond.notify_all();
+            }
+            bool    IsClosed        () const
+            {
+                return this->closed.load(std::memory_order_acquire);
+            }
+
+            size_t  Size            () const
+            {
+                return this->tail.load(std::memory_order_acquire) - this->head.load(std::memory_order_acquire);
+            }
+            size_t  Capacity        () const
+            {
+                return this->mask + 1;
+            }
+            /* bytes of the items queued, as pushed */
+            size_t  Bytes           () const
+            {
+                return this->bytes.load(std::memory_order_relaxed);
+            }
+            size_t  ByteBudget      () const
+            {
+                return this->byteBudget.load(std::memory_order_relaxed);
+            }
+            /* bytes that can still be pushed without waiting; SIZE_MAX without a budget */
+            size_t  BytesLeft       () const
+            {
+                size_t budget = this->ByteBudget();
+                size_t queued = this->Bytes();
+
+                if (budget == 0)
+                    return SIZE_MAX;
+                return queued < budget ? budget - queued : 0;
+            }
+            RingStats Stats         () const
+            {
+                RingStats stats;
+
+                stats.pushed            = this->tail.load(std::memory_order_relaxed);
+                stats.popped            = this->head.load(std::memory_order_relaxed);
+                stats.highWater         = this->highWater.load(std::memory_order_relaxed);
+                stats.bytes             = this->Bytes();
+                stats.highWaterBytes    = this->highWaterBytes.load(std::memory_order_relaxed);
+                stats.producerWaits     = this->producerWaits.load(std::memory_order_relaxed);
+                stats.consumerWaits     = this->consumerWaits.load(std::memory_order_relaxed);
+                return stats;
+            }
+
+        private:
+            SpscRing                (const SpscRing &);
+            SpscRing& operator=     (const SpscRing &);
+
+            /* an empty ring takes any item, so one larger than the budget cannot block for good */
+            bool    HasRoom         (size_t size, size_t itemBytes) const
+            {
+                size_t budget = this->ByteBudget();
+
+                return budget == 0 || size == 0 || this->Bytes() + itemBytes <= budget;
+            }
+
+            template <typename Predicate>
+            bool    Wait            (Predicate ready)
+            {
+                for (size_t i = 0; i < SPSC_SPIN_COUNT; i++)
+                {
+                    if (ready())
+                        return true;
+                    std::this_thread::yield();
+                }
+
+                if (this->policy == WAIT_BACKOFF)
+                {
+                    std::chrono::microseconds interval(50);
+                    while (!ready())
+                    {
+                        std::this_thread::sleep_for(interval);
+                        if (interval < std::chrono::microseconds(2000))
+                            interval *= 2;
+                    }
+                    return true;
+                }
+
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->sleepers.fetch_add(1, std::memory_order_seq_cst);
+                this->cond.wait(lock, ready);
+                this->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+                return true;
+            }
+            void    Notify          ()
+            {
+                /* pairs with the seq_cst increment in Wait: either the sleeper
+                 * sees the new index or we see the sleeper */
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (this->sleepers.load(std::memory_order_seq_cst) == 0)
+                    return;
+
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->cond.notify_all();
+            }
+
+            std::vector<T>                          slots;
+            std::vector<size_t>                     slotBytes;
+            size_t                                  mask;
+            WaitPolicy                              policy;
+            alignas(SPSC_CACHE_LINE) std::atomic<size_t>    head;       /* next slot to pop, written by consumer */
+            alignas(SPSC_CACHE_LINE) std::atomic<size_t>    tail;       /* next slot to push, written by producer */
+            alignas(SPSC_CACHE_LINE) std::atomic<bool>      closed;
+            std::atomic<size_t>                     bytes;
+            std::atomic<size_t>                     byteBudget;
+            std::atomic<int>                        sleepers;
+            std::atomic<size_t>                     producerWaits;
+            std::atomic<size_t>                     consumerWaits;
+            std::atomic<size_t>                     highWater;
+            std::atomic<size_t>                     highWaterBytes;
+            std::mutex                              mutex;
+            std::condition_variable                 cond;
+    };
+}
+
+#endif /* SPSCRING_H_ */
@@ -0,0 +1,105 @@
+/*
+ * StreamingReport.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "StreamingReport.h"
+#include "Tracer.h"
+
+#include <fstream>
+#include <iomanip>
+
+using namespace mcnl;
+
+StreamingReport::StreamingReport    () :
+                 startup            (-1),
+                 session            (0),
+                 segments           (0),
+                 bytes              (0),
+                 downloadSeconds    (0),
+                 bandwidthSum       (0),
+                 representationSum  (0),
+                 switches           (0),
+                 presented          (0),
+                 dropped            (0),
+                 stalls             (0),
+                 stallSeconds       (0)
+{
+    this->Start();
+}
+StreamingReport::~StreamingReport   ()
+{
+}
+
+void    StreamingReport::Start          ()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->start = clock::now();
+}
+void    StreamingReport::OnSegment      (const SegmentInfo &info, uint32_t bandwidth)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->segments++;
+    this->bytes             += info.bytes;
+    this->downloadSeconds   += info.seconds;
+    this->bandwidthSum      += bandwidth;
+    this->representationSum += info.representation;
+
+    std::map<size_t, size_t>::iterator last = this->lastRepresentation.find(info.tile);
+    if (last != this->lastRepresentation.end() && last->second != info.representation)
+        this->switches++;
+    this->lastRepresentation[info.tile] = info.representation;
+}
+void    StreamingReport::OnPresent      ()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->startup < 0)
+        this->startup = std::chrono::duration<double>(clock::now() - this->start).count();
+}
+void    StreamingReport::OnPlaybackEnd  (const PresentationClock &presentation)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->session      = std::chrono::duration<double>(clock::now() - this->start).count();
+    this->presented    = presentation.Presented();
+    this->dropped      = presentation.Dropped();
+    this->stalls       = presentation.Rebuffers();
+    this->stallSeconds = presentation.StallSeconds();
+}
+void    StreamingReport::Write          (std::ostream &out) const
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        double                      n = this->segments > 0 ? (double) this->segments : 1;
+
+        out << std::fixed << std::setprecision(3);
+        out << "session seconds         " << this->session << "\n";
+        out << "startup delay seconds   " << this->startup << "\n";
+        out << "stalls                  " << this->stalls << "\n";
+        out << "stall seconds           " << this->stallSeconds << "\n";
+        out << "frames presented        " << this->presented << "\n";
+        out << "frames dropped          " << this->dropped << "\n";
+        out << "segments                " << this->segments << "\n";
+        out << "bytes                   " << this->bytes << "\n";
+        out << "download throughput bps " << (this->downloadSeconds > 0 ? this->bytes * 8 / this->downloadSeconds : 0) << "\n";
+        out << "average bandwidth bps   " << this->bandwidthSum / n << "\n";
+        out << "average representation  " << this->representationSum / n << "\n";
+        out << "quality switches        " << this->switches << "\n";
+        out << "\n";
+    }
+    Tracer::Instance().Summarize(out);
+}
+bool    StreamingReport::Write          (const std::string &path) const
+{
+    std::ofstream out(path.c_str());
+
+    if (!out)
+        return false;
+
+    this->Write(out);
+    return out.good();
+}
@@ -0,0 +1,67 @@
+/*
+ * StreamingReport.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Quality of experience of one streaming session, to compare ABR and
+ * pipeline changes over repeated runs: the startup delay until the first
+ * frame is shown, the stalls and dropped frames of the presentation clock,
+ * the average quality and switches of the fetched segments, and the
+ * latency distribution of every traced stage (see Tracer::Summarize).
+ * Segments are reported by the fetch thread, frames by the render thread.
+ *****************************************************************************/
+
+#ifndef STREAMINGREPORT_H_
+#define STREAMINGREPORT_H_
+
+#include "SegmentFetcher.h"
+#include "PresentationClock.h"
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <stdint.h>
+
+namespace mcnl
+{
+    class StreamingReport
+    {
+        public:
+            StreamingReport             ();
+            virtual ~StreamingReport    ();
+
+            /* the session starts now, the startup delay counts from here */
+            void    Start           ();
+            /* a downloaded segment, or tile of one, of `bandwidth` bits per second */
+            void    OnSegment       (const SegmentInfo &info, uint32_t bandwidth);
+            void    OnPresent       ();
+            /* the presentation clock once the last frame was shown */
+            void    OnPlaybackEnd   (const PresentationClock &presentation);
+
+            void    Write           (std::ostream &out) const;
+            bool    Write           (const std::string &path) const;
+
+        private:
+            typedef std::chrono::steady_clock clock;
+
+            mutable std::mutex          mutex;
+            clock::time_point           start;
+            double                      startup;        /* seconds, < 0 until the first frame */
+            double                      session;        /* seconds from Start to the end of playback */
+            size_t                      segments;
+            uint64_t                    bytes;
+            double                      downloadSeconds;
+            double                      bandwidthSum;   /* of the representations fetched */
+            double                      representationSum;
+            size_t                      switches;
+            std::map<size_t, size_t>    lastRepresentation; /* by tile */
+            size_t                      presented;
+            size_t                      dropped;
+            size_t                      stalls;
+            double                      stallSeconds;
+    };
+}
+
+#endif /* STREAMINGREPORT_H_ */
@@ -0,0 +1,184 @@
+/*
+ * TaskRuntime.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "TaskRuntime.h"
+
+#include "PCCExecutionContext.h"
+
+#include <algorithm>
+#include <thread>
+
+#define TASK_CHUNKS_PER_THREAD  4   /* chunks of a ParallelFor per worker, for the load to even out */
+
+using namespace mcnl;
+
+TaskRuntime&    TaskRuntime::Instance   ()
+{
+    /* kept for the lifetime of the process: chunks queued on the arena refer to it */
+    static TaskRuntime *runtime = new TaskRuntime();
+    return *runtime;
+}
+
+TaskRuntime::TaskRuntime    () :
+             executionContext(new pcc::PCCExecutionContext()),
+             queued         (0),
+             threads        (0),
+             parking        (0),
+             parked         (0)
+{
+}
+TaskRuntime::~TaskRuntime   ()
+{
+}
+
+void    TaskRuntime::Place          (const ThreadPlacement &placement)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->placement = placement;
+}
+void    TaskRuntime::Start          (size_t nbThread, const std::string &affinity)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->threads > 0)
+        return;
+
+    ThreadPlacement placement = this->placement;
+
+    if (placement.fifo != 0 || placement.nice != 0)
+        this->executionContext->setWorkerSetup([placement]() { PrioritizeThread(placement, "decode worker"); });
+
+    /* held for good: the decoders entering and leaving it never recreate the arena under a running chunk,
+     * and their scratch blocks stay with the workers from one segment to the next */
+    this->executionContext->enter(nbThread, placement.cores.empty() ? affinity : placement.cores);
+    this->threads = nbThread > 0 ? nbThread : std::max(1u, std::thread::hardware_concurrency());
+}
+std::shared_ptr<pcc::PCCExecutionContext>   TaskRuntime::ExecutionContext   () const
+{
+    return this->executionContext;
+}
+size_t  TaskRuntime::Threads        () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->threads;
+}
+void    TaskRuntime::SetConcurrency (size_t concurrency)
+{
+    size_t more = 0;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (this->threads < 2)
+            return;
+
+        size_t parking = this->threads - std::min(std::max<size_t>(concurrency, 2), this->threads);
+
+        if (parking > this->parking)
+            more = parking - this->parking;
+        this->parking = parking;
+    }
+    /* parking tasks queued before and not run yet may be enough already; the ones too many return at once */
+    for (size_t i = 0; i < more; i++)
+        this->executionContext->enqueue([this]() { this->Park(); }, tbb::priority_high);
+    this->unparked.notify_all();
+}
+size_t  TaskRuntime::Concurrency    () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->threads - this->parking;
+}
+void    TaskRuntime::ParallelFor    (double deadline, size_t count, size_t grain, const RangeBody &body)
+{
+    if (count == 0)
+        return;
+
+    size_t threads;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        threads = this->threads - this->parking;
+    }
+
+    size_t size = std::max(std::max<size_t>(grain, 1), count / (TASK_CHUNKS_PER_THREAD * (threads + 1)) + 1);
+
+    if (threads == 0 || size >= count)
+    {
+        body(0, count);
+        return;
+    }
+
+    std::shared_ptr<Batch> batch(new Batch());
+
+    batch->left = (count + size - 1) / size;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        for (size_t begin = 0; begin < count; begin += size)
+        {
+            Chunk chunk;
+
+            chunk.deadline  = deadline;
+            chunk.order     = this->queued++;
+            chunk.begin     = begin;
+            chunk.end       = std::min(begin + size, count);
+            chunk.body      = &body;
+            chunk.batch     = batch;
+            this->chunks.push(chunk);
+        }
+    }
+
+    /* one arena task per chunk; each runs whichever chunk is due first, so a task may find none left */
+    for (size_t i = 0; i < batch->left; i++)
+        this->executionContext->enqueue([this]() { this->RunNext(); }, tbb::priority_high);
+
+    /* the caller helps until the queue is empty, then waits for the chunks still running */
+    while (this->RunNext())
+    {
+        std::lock_guard<std::mutex> lock(batch->mutex);
+
+        if (batch->left == 0)
+            return;
+    }
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+
+    batch->finished.wait(lock, [&batch]() { return batch->left == 0; });
+}
+
+bool    TaskRuntime::RunNext        ()
+{
+    Chunk chunk;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (this->chunks.empty())
+            return false;
+        chunk = this->chunks.top();
+        this->chunks.pop();
+    }
+
+    (*chunk.body)(chunk.begin, chunk.end);
+
+    std::lock_guard<std::mutex> lock(chunk.batch->mutex);
+
+    if (--chunk.batch->left == 0)
+        chunk.batch->finished.notify_all();
+    return true;
+}
+void    TaskRuntime::Park           ()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    if (this->parked >= this->parking)
+        return;
+
+    this->parked++;
+    this->unparked.wait(lock, [this]() { return this->parked > this->parking; });
+    this->parked--;
+}
@@ -0,0 +1,121 @@
+/*
+ * TaskRuntime.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * The one TBB arena of the client. The decoders of every object run their
+ * stages in it (see DecodeScheduler), and the other CPU work of the
+ * pipeline, e.g. the conversion of a frame for the renderer, is split into
+ * tasks on the same workers instead of threads of its own. That way the
+ * cores are neither oversubscribed while a segment decodes nor idle in
+ * between.
+ *
+ * The tasks carry deadlines, in seconds of presentation time like the
+ * DecodePool's: queued chunks run earliest deadline first and ahead of the
+ * decoder's own tasks, as their caller waits for them. The caller runs
+ * chunks too, so a task is never stuck behind a long decode stage.
+ *
+ * The threads that mostly wait stay threads: the fetchers on the network,
+ * the decode workers on their segments and on memory, and the renderer,
+ * which owns the GL context. The workers take the decode placement, see
+ * Place().
+ *
+ * The arena is sized once, but fewer of its workers may run at a time, see
+ * SetConcurrency: the others are parked, each asleep in a task of its own,
+ * so their cores go to the renderer or idle. At least one worker stays
+ * active, which the decode threads that cannot join the arena need to get
+ * their stages run.
+ *****************************************************************************/
+
+#ifndef TASKRUNTIME_H_
+#define TASKRUNTIME_H_
+
+#include "ThreadPlacement.h"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pcc
+{
+    class PCCExecutionContext;
+}
+
+namespace mcnl
+{
+    class TaskRuntime
+    {
+        public:
+            typedef std::function<void(size_t begin, size_t end)> RangeBody;
+
+            static TaskRuntime&     Instance    ();
+
+            /* before Start: the workers are pinned to the cores of placement, in place of the
+             * decoder's --threadAffinity, and run at its priority */
+            void    Place           (const ThreadPlacement &placement);
+            /* nbThread and affinity as for PCCExecutionContext::enter; only the first call
+             * sets them, as the first decoder in did before */
+            void    Start           (size_t nbThread, const std::string &affinity);
+            std::shared_ptr<pcc::PCCExecutionContext>   ExecutionContext    () const;
+            /* threads of the arena, the caller's slot included; 0 before Start */
+            size_t  Threads         () const;
+            /* of those, the ones left to run tasks, from 2 to Threads; the others are parked
+             * as soon as they finish the task they run. From any thread, ignored before Start */
+            void    SetConcurrency  (size_t concurrency);
+            size_t  Concurrency     () const;
+
+            /* runs body over [0, count) in chunks of at least grain indices and returns once all
+             * are done; runs it on the calling thread alone before Start */
+            void    ParallelFor     (double deadline, size_t count, size_t grain, const RangeBody &body);
+
+        private:
+            struct Batch
+            {
+                std::mutex                  mutex;
+                std::condition_variable     finished;
+                size_t                      left;
+            };
+            struct Chunk
+            {
+                double                      deadline;
+                uint64_t                    order;      /* equal deadlines first come first */
+                size_t                      begin;
+                size_t                      end;
+                const RangeBody             *body;
+                std::shared_ptr<Batch>      batch;
+            };
+            struct Later
+            {
+                bool operator() (const Chunk &a, const Chunk &b) const
+                {
+                    return a.deadline != b.deadline ? a.deadline > b.deadline : a.order > b.order;
+                }
+            };
+
+            std::shared_ptr<pcc::PCCExecutionContext>   executionContext;
+            ThreadPlacement                             placement;
+            mutable std::mutex                          mutex;
+            std::condition_variable                     unparked;
+            std::priority_queue<Chunk, std::vector<Chunk>, Later> chunks;
+            uint64_t                                    queued;
+            size_t                                      threads;    /* 0 before Start */
+            size_t                                      parking;    /* workers to park */
+            size_t                                      parked;     /* asleep in Park */
+
+            TaskRuntime             ();
+            virtual ~TaskRuntime    ();
+
+            /* runs the chunk with the earliest deadline, whoever queued it; false if none is left */
+            bool    RunNext         ();
+            /* the task of a parked worker: sleeps while more workers are to be parked than are */
+            void    Park            ();
+    };
+}
+
+#endif /* TASKRUNTIME_H_ */
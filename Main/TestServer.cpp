@@ -0,0 +1,383 @@
+/*
+ * TestServer.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "TestServer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mcnl;
+
+#define REQUEST_MAX_HEADER  (16 << 10)  /* longer request headers close the connection */
+
+static std::string  Lower       (std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+static std::string  Trim        (const std::string &text)
+{
+    size_t first = text.find_first_not_of(" \t\r\n");
+    size_t last  = text.find_last_not_of(" \t\r\n");
+
+    return first == std::string::npos ? "" : text.substr(first, last - first + 1);
+}
+
+TestServer::TestServer  (const std::string &root, const NetworkProfile &profile) :
+            root        (root),
+            bucket      (profile),
+            profile     (profile),
+            listener    (-1),
+            port        (0),
+            running     (false),
+            random      (1),
+            requests    (0),
+            bytesSent   (0)
+{
+}
+TestServer::~TestServer ()
+{
+    this->Stop();
+}
+
+bool        TestServer::Start       (size_t port)
+{
+    this->listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (this->listener < 0)
+        return false;
+
+    int reuse = 1;
+    setsockopt(this->listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons((uint16_t) port);
+
+    socklen_t length = sizeof(addr);
+    if (bind(this->listener, (sockaddr *) &addr, sizeof(addr)) != 0 || listen(this->listener, SOMAXCONN) != 0 ||
+        getsockname(this->listener, (sockaddr *) &addr, &length) != 0)
+    {
+        close(this->listener);
+        this->listener = -1;
+        return false;
+    }
+
+    this->port = ntohs(addr.sin_port);
+    this->bucket.Reset();
+    this->running.store(true);
+    this->acceptor = std::thread(&TestServer::AcceptLoop, this);
+    return true;
+}
+void        TestServer::Stop        ()
+{
+    if (!this->running.exchange(false))
+        return;
+
+    /* wakes the blocked accept */
+    shutdown(this->listener, SHUT_RDWR);
+    close(this->listener);
+    this->listener = -1;
+    this->acceptor.join();
+
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        std::map<int, std::thread>::iterator it;
+        for (it = this->connections.begin(); it != this->connections.end(); ++it)
+        {
+            shutdown(it->first, SHUT_RDWR);
+            threads.push_back(std::move(it->second));
+        }
+        this->connections.clear();
+        for (size_t i = 0; i < this->finished.size(); i++)
+            threads.push_back(std::move(this->finished.at(i)));
+        this->finished.clear();
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+        threads.at(i).join();
+}
+size_t      TestServer::Port        () const
+{
+    return this->port;
+}
+uint64_t    TestServer::Requests    () const
+{
+    return this->requests.load();
+}
+uint64_t    TestServer::BytesSent   () const
+{
+    return this->bytesSent.load();
+}
+
+void        TestServer::AcceptLoop  ()
+{
+    while (this->running.load())
+    {
+        int client = accept(this->listener, NULL, NULL);
+        if (client < 0)
+            continue;
+
+        std::vector<std::thread> done;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+
+            if (!this->running.load())
+            {
+                close(client);
+                break;
+            }
+            /* Serve removes its own entry, which it can only do once this lock is released */
+            this->connections[client] = std::thread(&TestServer::Serve, this, client);
+            done.swap(this->finished);
+        }
+        for (size_t i = 0; i < done.size(); i++)
+            done.at(i).join();
+    }
+}
+void        TestServer::Serve       (int socket)
+{
+    /* the handshake */
+    this->Delay(this->profile.At(this->bucket.Elapsed()).rtt);
+
+    std::string buffer;
+    Request     request;
+
+    while (this->running.load() && this->ReadRequest(socket, buffer, request))
+    {
+        this->requests++;
+        if (!this->Respond(socket, request) || request.close)
+            break;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    /* Stop may have taken the thread already */
+    std::map<int, std::thread>::iterator it = this->connections.find(socket);
+    if (it != this->connections.end())
+    {
+        this->finished.push_back(std::move(it->second));
+        this->connections.erase(it);
+    }
+    /* closed only now, so that accept cannot hand out the same number meanwhile */
+    close(socket);
+}
+bool        TestServer::ReadRequest (int socket, std::string &buffer, Request &request)
+{
+    size_t end;
+
+    while ((end = buffer.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (buffer.size() > REQUEST_MAX_HEADER)
+            return false;
+
+        char    data[4096];
+        ssize_t received = recv(socket, data, sizeof(data), 0);
+        if (received <= 0)
+            return false;
+        buffer.append(data, received);
+    }
+
+    std::istringstream  lines(buffer.substr(0, end + 2));
+    std::string         line, version;
+
+    /* pipelined requests stay in the buffer */
+    buffer.erase(0, end + 4);
+
+    std::getline(lines, line);
+    std::istringstream requestLine(line);
+    if (!(requestLine >> request.method >> request.path >> version))
+        return false;
+
+    request.range.clear();
+    request.ifNoneMatch.clear();
+    request.close = version == "HTTP/1.0";
+
+    while (std::getline(lines, line))
+    {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+
+        std::string name  = Lower(Trim(line.substr(0, colon)));
+        std::string value = Trim(line.substr(colon + 1));
+
+        if (name == "range")
+            request.range = value;
+        else if (name == "if-none-match")
+            request.ifNoneMatch = value;
+        else if (name == "connection")
+            request.close = Lower(value) == "close";
+    }
+    return true;
+}
+bool        TestServer::Respond     (int socket, const Request &request)
+{
+    std::string body, etag;
+    std::string path = request.path.substr(0, request.path.find('?'));
+    bool        head = request.method == "HEAD";
+
+    std::ostringstream header;
+    header << "HTTP/1.1 ";
+
+    size_t first = 0, last = 0;
+    int    status;
+
+    if (request.method != "GET" && !head)
+        status = 501;
+    else if (path.empty() || path.at(0) != '/' || path.find("..") != std::string::npos ||
+             !this->Load(path, body, etag))
+        status = 404;
+    else if (!request.ifNoneMatch.empty() && request.ifNoneMatch == etag)
+        status = 304;
+    else if (request.range.compare(0, 6, "bytes=") == 0)
+    {
+        /* one range: first-last, first- or -suffix */
+        std::string spec  = request.range.substr(6);
+        size_t      dash  = spec.find('-');
+        bool        valid = dash != std::string::npos && spec.find(',') == std::string::npos && !body.empty();
+
+        if (valid && dash == 0)
+        {
+            size_t suffix = strtoull(spec.c_str() + 1, NULL, 10);
+            valid = suffix > 0;
+            first = body.size() - std::min(suffix, body.size());
+            last  = body.size() - 1;
+        }
+        else if (valid)
+        {
+            first = strtoull(spec.c_str(), NULL, 10);
+            last  = dash + 1 < spec.size() ? strtoull(spec.c_str() + dash + 1, NULL, 10) : body.size() - 1;
+            last  = std::min(last, body.size() - 1);
+            valid = first <= last;
+        }
+        status = valid ? 206 : 416;
+    }
+    else
+    {
+        status = 200;
+        last   = body.size() - 1;
+    }
+
+    size_t length = status == 200 || status == 206 ? (body.empty() ? 0 : last - first + 1) : 0;
+
+    switch (status)
+    {
+        case 200: header << "200 OK\r\n";                       break;
+        case 206: header << "206 Partial Content\r\n";          break;
+        case 304: header << "304 Not Modified\r\n";             break;
+        case 404: header << "404 Not Found\r\n";                break;
+        case 416: header << "416 Range Not Satisfiable\r\n";    break;
+        default:  header << "501 Not Implemented\r\n";          break;
+    }
+    if (status == 206)
+        header << "Content-Range: bytes " << first << "-" << last << "/" << body.size() << "\r\n";
+    if (status == 416)
+        header << "Content-Range: bytes */" << body.size() << "\r\n";
+    if (!etag.empty())
+        header << "ETag: " << etag << "\r\n";
+    header << "Accept-Ranges: bytes\r\n";
+    header << "Content-Length: " << length << "\r\n";
+    header << "Connection: " << (request.close ? "close" : "keep-alive") << "\r\n\r\n";
+
+    /* the request travels to the server and the first byte back */
+    this->Delay(this->profile.At(this->bucket.Elapsed()).rtt);
+
+    std::string response = header.str();
+    if (!this->Send(socket, response.data(), response.size()))
+        return false;
+
+    return head || length == 0 || this->Send(socket, body.data() + first, length);
+}
+bool        TestServer::Load        (const std::string &path, std::string &body, std::string &etag)
+{
+    std::string file = this->root + path;
+    struct stat info;
+
+    if (stat(file.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+        return false;
+
+    std::ifstream in(file.c_str(), std::ios::binary);
+    if (!in)
+        return false;
+
+    body.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    if (path.size() >= 4 && Lower(path.substr(path.size() - 4)) == ".mpd")
+    {
+        /* point the absolute URLs of the production origin at this server */
+        std::string origin = "http://127.0.0.1:" + std::to_string(this->port);
+        size_t      at     = 0;
+
+        while ((at = body.find("http://", at)) != std::string::npos)
+        {
+            size_t end = body.find_first_of("/\"<", at + 7);
+            if (end == std::string::npos)
+                break;
+            body.replace(at, end - at, origin);
+            at += origin.size();
+        }
+    }
+
+    std::ostringstream tag;
+    tag << "\"" << std::hex << (uint64_t) info.st_size << "-" << (uint64_t) info.st_mtime << "\"";
+    etag = tag.str();
+    return true;
+}
+bool        TestServer::Send        (int socket, const char *data, size_t length)
+{
+    size_t sent = 0;
+
+    while (sent < length)
+    {
+        size_t      part = std::min(length - sent, (size_t) TEST_SERVER_CHUNK);
+        NetworkStep step = this->profile.At(this->bucket.Elapsed());
+
+        if (this->Lost(part, step.loss))
+            this->Delay(step.rtt);
+        this->bucket.Send(part);
+
+        size_t done = 0;
+        while (done < part)
+        {
+            ssize_t n = send(socket, data + sent + done, part - done, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            done += n;
+        }
+        sent += part;
+        this->bytesSent += part;
+    }
+    return true;
+}
+void        TestServer::Delay       (double seconds)
+{
+    if (seconds > 0)
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+bool        TestServer::Lost        (size_t bytes, double loss)
+{
+    if (loss <= 0)
+        return false;
+
+    /* at least one of the chunk's packets */
+    double packets = std::ceil((double) bytes / SHAPING_PACKET_BYTES);
+    double chance  = 1 - std::pow(1 - loss, packets);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return std::uniform_real_distribution<double>(0, 1)(this->random) < chance;
+}
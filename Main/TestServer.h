@@ -0,0 +1,90 @@
+/*
+ * TestServer.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * In-process HTTP/1.1 origin for repeatable benchmark runs: serves the
+ * files below a root directory (the STREAM_PATH that createContent.sh
+ * fills, e.g. root/video/loot.mpd) on the loopback interface, with
+ * keep-alive, byte ranges and ETag revalidation as the client uses them.
+ * Absolute http:// URLs in served MPDs are rewritten to this server, so
+ * BaseURLs of the production origin resolve here.
+ *
+ * Every send passes one TokenBucket shared by all connections, like a
+ * single bottleneck link following the NetworkProfile. Each response
+ * waits one round-trip time before its header and a new connection one
+ * more for its handshake; a lost packet stalls its connection one further
+ * round trip, as a fast retransmit would.
+ *****************************************************************************/
+
+#ifndef TESTSERVER_H_
+#define TESTSERVER_H_
+
+#include "NetworkProfile.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#define TEST_SERVER_CHUNK   (16 << 10)  /* bytes per shaped send */
+
+namespace mcnl
+{
+    class TestServer
+    {
+        public:
+            TestServer              (const std::string &root, const NetworkProfile &profile);
+            virtual ~TestServer     ();
+
+            /* listens on 127.0.0.1:port, port 0 picks a free one */
+            bool        Start       (size_t port = 0);
+            /* closes the listening socket and every connection */
+            void        Stop        ();
+
+            size_t      Port        () const;
+            uint64_t    Requests    () const;
+            uint64_t    BytesSent   () const;
+
+        private:
+            struct Request
+            {
+                std::string method;
+                std::string path;
+                std::string range;          /* value of the Range header */
+                std::string ifNoneMatch;
+                bool        close;
+            };
+
+            std::string                 root;
+            TokenBucket                 bucket;
+            const NetworkProfile        &profile;
+            int                         listener;
+            size_t                      port;
+            std::atomic<bool>           running;
+            std::thread                 acceptor;
+            std::mutex                  mutex;          /* connections and random */
+            std::map<int, std::thread>  connections;    /* by socket */
+            std::vector<std::thread>    finished;       /* joined by the acceptor or Stop */
+            std::mt19937                random;
+            std::atomic<uint64_t>       requests;
+            std::atomic<uint64_t>       bytesSent;
+
+            void        AcceptLoop  ();
+            void        Serve       (int socket);
+            bool        ReadRequest (int socket, std::string &buffer, Request &request);
+            bool        Respond     (int socket, const Request &request);
+            /* body of the file at path, MPDs rewritten; false if there is none */
+            bool        Load        (const std::string &path, std::string &body, std::string &etag);
+            /* shaped and delayed as the profile says */
+            bool        Send        (int socket, const char *data, size_t length);
+            void        Delay       (double seconds);
+            bool        Lost        (size_t bytes, double loss);
+    };
+}
+
+#endif /* TESTSERVER_H_ */
@@ -0,0 +1,145 @@
+/*
+ * ThreadPlacement.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "ThreadPlacement.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace mcnl;
+
+/* "0-3,6" to its cores; false if malformed */
+static bool     ParseCores      (const std::string &text, std::vector<int> &cores)
+{
+    std::stringstream   list(text);
+    std::string         range;
+
+    while (std::getline(list, range, ','))
+    {
+        char *end;
+        long first = strtol(range.c_str(), &end, 10);
+        long last  = first;
+
+        if (end == range.c_str() || first < 0)
+            return false;
+        if (*end == '-')
+        {
+            const char *from = end + 1;
+
+            last = strtol(from, &end, 10);
+            if (end == from || last < first)
+                return false;
+        }
+        if (*end != '\0')
+            return false;
+        for (long core = first; core <= last; core++)
+            cores.push_back((int) core);
+    }
+    return true;
+}
+static bool     Refused         (const char *stage, const char *what)
+{
+    std::cerr << "thread placement of " << stage << ": " << what << " refused (" << strerror(errno) << ")"
+              << std::endl;
+    return false;
+}
+
+ThreadPlacement::ThreadPlacement    () :
+                 fifo               (0),
+                 nice               (0)
+{
+}
+bool    ThreadPlacement::IsSet      () const
+{
+    return !this->cores.empty() || this->fifo != 0 || this->nice != 0;
+}
+bool    ThreadPlacement::Parse      (const std::string &text, ThreadPlacement &placement)
+{
+    ThreadPlacement     parsed;
+    size_t              slash = text.find('/');
+    std::vector<int>    cores;
+
+    parsed.cores = text.substr(0, slash);
+    if (!ParseCores(parsed.cores, cores))
+        return false;
+
+    if (slash != std::string::npos)
+    {
+        std::string priority = text.substr(slash + 1);
+        char        *end;
+
+        if (priority.compare(0, 5, "fifo:") == 0)
+        {
+            parsed.fifo = (int) strtol(priority.c_str() + 5, &end, 10);
+            if (*end != '\0' || parsed.fifo < 1 || parsed.fifo > 99)
+                return false;
+        }
+        else if (priority.compare(0, 5, "nice:") == 0)
+        {
+            parsed.nice = (int) strtol(priority.c_str() + 5, &end, 10);
+            if (*end != '\0' || parsed.nice < -20 || parsed.nice > 19)
+                return false;
+        }
+        else
+            return false;
+    }
+
+    placement = parsed;
+    return true;
+}
+
+bool    mcnl::PlaceThread       (const ThreadPlacement &placement, const char *stage)
+{
+    bool placed = true;
+
+#if defined(__linux__)
+    std::vector<int> cores;
+
+    if (ParseCores(placement.cores, cores) && !cores.empty())
+    {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        for (size_t i = 0; i < cores.size(); i++)
+            CPU_SET(cores.at(i), &set);
+        if ((errno = pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) != 0)
+            placed = Refused(stage, "core mask");
+    }
+#endif
+
+    return PrioritizeThread(placement, stage) && placed;
+}
+bool    mcnl::PrioritizeThread  (const ThreadPlacement &placement, const char *stage)
+{
+    if (placement.fifo > 0)
+    {
+        sched_param param;
+
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = placement.fifo;
+        if ((errno = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) != 0)
+            return Refused(stage, "SCHED_FIFO");
+        return true;
+    }
+
+#if defined(__linux__)
+    /* the nice level of a Linux thread is its own, set by its thread id */
+    if (placement.nice != 0 && setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), placement.nice) != 0)
+        return Refused(stage, "nice level");
+#endif
+    return true;
+}
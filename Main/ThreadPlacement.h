@@ -0,0 +1,43 @@
+/*
+ * ThreadPlacement.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Cores and scheduling priority of a stage of the client, so decode work
+ * cannot preempt the render thread: e.g. the renderer on cores 6-7 under
+ * SCHED_FIFO, the network threads on core 5 and the decoders, TBB workers
+ * included, on cores 0-4 at a lower nice level. A thread is placed as it
+ * starts; the threads it starts later inherit its cores and priority, so
+ * placing the fetch thread places its downloads too.
+ *****************************************************************************/
+
+#ifndef THREADPLACEMENT_H_
+#define THREADPLACEMENT_H_
+
+#include <string>
+
+namespace mcnl
+{
+    struct ThreadPlacement
+    {
+        std::string     cores;      /* e.g. "0-3,6"; empty leaves every core */
+        int             fifo;       /* SCHED_FIFO priority 1..99; 0 keeps SCHED_OTHER at nice */
+        int             nice;       /* -20..19, 0 leaves it */
+
+        ThreadPlacement     ();
+
+        bool    IsSet       () const;
+
+        /* "CORES[/fifo:N|/nice:N]", e.g. "6-7/fifo:10", "0-4/nice:5" or "/nice:-5";
+         * false, leaving placement as it was, if malformed */
+        static bool Parse   (const std::string &text, ThreadPlacement &placement);
+    };
+
+    /* places the calling thread; false, with a message naming stage, if the OS refused
+     * part of it, e.g. SCHED_FIFO or a negative nice without CAP_SYS_NICE */
+    bool    PlaceThread     (const ThreadPlacement &placement, const char *stage);
+    /* only the priority, e.g. for a TBB worker the arena pins itself */
+    bool    PrioritizeThread(const ThreadPlacement &placement, const char *stage);
+}
+
+#endif /* THREADPLACEMENT_H_ */
@@ -0,0 +1,234 @@
+/*
+ * TileSelector.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "TileSelector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace mcnl;
+
+TileSelector::TileSelector  ()
+{
+    memset(this->projection, 0, sizeof(this->projection));
+}
+TileSelector::~TileSelector ()
+{
+}
+
+void                    TileSelector::SetTiles          (const std::vector<TileRegion> &tiles,
+                                                         const std::vector<uint32_t> &bandwidths)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->tiles.clear();
+    this->levelBandwidths.clear();
+
+    size_t levels = SIZE_MAX;
+
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+        Tile tile;
+
+        tile.region = tiles.at(i);
+
+        for (size_t r = 0; r < tile.region.representations; r++)
+            tile.ranked.push_back(tile.region.firstRepresentation + r);
+
+        std::stable_sort(tile.ranked.begin(), tile.ranked.end(), [&bandwidths](size_t a, size_t b) {
+            return (a < bandwidths.size() ? bandwidths.at(a) : 0) < (b < bandwidths.size() ? bandwidths.at(b) : 0);
+        });
+
+        levels = std::min(levels, tile.ranked.size());
+        this->tiles.push_back(tile);
+    }
+
+    if (this->tiles.empty())
+        return;
+
+    /* tiles with more representations than others lose their top ones */
+    for (size_t level = 0; level < levels; level++)
+    {
+        uint64_t sum = 0;
+
+        for (size_t i = 0; i < this->tiles.size(); i++)
+        {
+            size_t representation = this->tiles.at(i).ranked.at(level);
+            sum += representation < bandwidths.size() ? bandwidths.at(representation) : 0;
+        }
+        this->levelBandwidths.push_back((uint32_t) std::min(sum, (uint64_t) UINT32_MAX));
+    }
+    for (size_t i = 0; i < this->tiles.size(); i++)
+        this->tiles.at(i).ranked.resize(levels);
+}
+size_t                  TileSelector::Tiles             () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->tiles.size();
+}
+std::vector<uint32_t>   TileSelector::LevelBandwidths   () const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->levelBandwidths;
+}
+void                    TileSelector::SetView           (const float projection[16], const float view[16])
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    memcpy(this->projection, projection, sizeof(this->projection));
+    this->predictor.Update(view);
+}
+std::vector<TileChoice> TileSelector::Select            (size_t level, double ahead) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::vector<TileChoice> choices;
+
+    if (this->levelBandwidths.empty())
+        return choices;
+
+    bool    hasView = this->predictor.HasView();
+    float   planes[6][4];
+    float   eye[3];
+
+    if (hasView)
+    {
+        float view[16];
+        float m[16];
+
+        this->predictor.Predict(ahead, view, eye);
+        for (int col = 0; col < 4; col++)
+            for (int row = 0; row < 4; row++)
+            {
+                m[col * 4 + row] = 0;
+                for (int k = 0; k < 4; k++)
+                    m[col * 4 + row] += this->projection[k * 4 + row] * view[col * 4 + k];
+            }
+
+        /* Gribb/Hartmann: row 3 plus or minus rows 0, 1 and 2 of projection * view */
+        for (int i = 0; i < 6; i++)
+        {
+            int     row  = i / 2;
+            float   sign = i % 2 ? -1.0f : 1.0f;
+
+            for (int col = 0; col < 4; col++)
+                planes[i][col] = m[col * 4 + 3] + sign * m[col * 4 + row];
+        }
+    }
+
+    level = std::min(level, this->levelBandwidths.size() - 1);
+
+    TileChoice  fallback;
+
+    fallback.tile     = SIZE_MAX;
+    fallback.distance = 0;
+
+    for (size_t i = 0; i < this->tiles.size(); i++)
+    {
+        const TileRegion &region = this->tiles.at(i).region;
+
+        if (hasView && !this->Visible(region, planes))
+        {
+            double distance = this->Distance(region, eye);
+
+            if (fallback.tile == SIZE_MAX || distance < fallback.distance)
+            {
+                fallback.tile           = i;
+                fallback.representation = this->tiles.at(i).ranked.at(0);
+                fallback.distance       = distance;
+            }
+            continue;
+        }
+
+        TileChoice choice;
+
+        choice.tile           = i;
+        choice.representation = this->tiles.at(i).ranked.at(level);
+        choice.distance       = hasView ? this->Distance(region, eye) : 0;
+        choices.push_back(choice);
+    }
+
+    std::sort(choices.begin(), choices.end(), [](const TileChoice &a, const TileChoice &b) {
+        return a.distance < b.distance;
+    });
+
+    /* looking away from everything: the nearest tile at the lowest level
+     * keeps the segments, and with them the presentation, going */
+    if (choices.empty())
+    {
+        if (fallback.tile != SIZE_MAX)
+            choices.push_back(fallback);
+        return choices;
+    }
+
+    /* distances below the size of the smallest tile count as that size,
+     * so the tiles around the camera all keep the full level */
+    double unit = 0;
+
+    for (size_t i = 0; i < this->tiles.size(); i++)
+    {
+        const TileRegion    &region = this->tiles.at(i).region;
+        double              size    = std::max(region.max[0] - region.min[0],
+                                      std::max(region.max[1] - region.min[1], region.max[2] - region.min[2]));
+
+        unit = i == 0 ? size : std::min(unit, size);
+    }
+    unit = std::max(unit, 1e-6);
+
+    double nearest = std::max(choices.front().distance, unit);
+
+    for (size_t i = 0; i < choices.size(); i++)
+    {
+        TileChoice  &choice = choices.at(i);
+        size_t      drop    = (size_t) std::floor(std::log2(std::max(choice.distance, unit) / nearest));
+
+        choice.representation = this->tiles.at(choice.tile).ranked.at(level - std::min(drop, level));
+    }
+    return choices;
+}
+bool                    TileSelector::Visible           (const TileRegion &region, const float planes[6][4]) const
+{
+    float min[3];
+    float max[3];
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float margin = (region.max[axis] - region.min[axis]) * (float) TILE_VIEW_MARGIN;
+
+        min[axis] = region.min[axis] - margin;
+        max[axis] = region.max[axis] + margin;
+    }
+
+    /* outside if even the corner farthest along a plane's normal is behind it */
+    for (int i = 0; i < 6; i++)
+    {
+        const float *plane = planes[i];
+        float       d      = plane[3];
+
+        for (int axis = 0; axis < 3; axis++)
+            d += plane[axis] * (plane[axis] >= 0 ? max[axis] : min[axis]);
+
+        if (d < 0)
+            return false;
+    }
+    return true;
+}
+double                  TileSelector::Distance          (const TileRegion &region, const float eye[3]) const
+{
+    double sum = 0;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        double d = std::max((double) region.min[axis] - eye[axis],
+                   std::max(0.0, (double) eye[axis] - region.max[axis]));
+
+        sum += d * d;
+    }
+    return std::sqrt(sum);
+}
@@ -0,0 +1,84 @@
+/*
+ * TileSelector.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * View-dependent streaming of a tiled content (see SegmentIndex): only the
+ * tiles whose box is inside the camera frustum are fetched and decoded,
+ * and the farther a tile is from the camera the lower its quality. The
+ * renderer hands in the camera after every frame, the fetch thread asks
+ * for the tiles of the next segment.
+ *
+ * Quality levels are ranks by bandwidth within each tile, lowest first, so
+ * level i of every tile together form the ladder that ABR chooses from.
+ * The nearest visible tile gets the level ABR picked, each doubling of the
+ * distance beyond it one level less.
+ *
+ * A segment requested now plays a buffer later, by when the camera may
+ * have turned: the tiles are chosen for the view a ViewPredictor expects
+ * then, so tiles coming into view are fetched ahead and those leaving it
+ * are no longer requested.
+ *****************************************************************************/
+
+#ifndef TILESELECTOR_H_
+#define TILESELECTOR_H_
+
+#include "SegmentIndex.h"
+#include "ViewPredictor.h"
+
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#define TILE_VIEW_MARGIN    0.1     /* boxes grow by this part of their size, for camera motion */
+
+namespace mcnl
+{
+    struct TileChoice
+    {
+        size_t      tile;
+        size_t      representation;     /* in the SegmentIndex */
+        double      distance;           /* camera to the nearest point of the box */
+    };
+
+    class TileSelector
+    {
+        public:
+            TileSelector            ();
+            virtual ~TileSelector   ();
+
+            /* bandwidths[r] is representation r of the index the tiles come from */
+            void    SetTiles        (const std::vector<TileRegion> &tiles, const std::vector<uint32_t> &bandwidths);
+            size_t  Tiles           () const;
+            /* levels every tile has, and their summed bandwidth, lowest first */
+            std::vector<uint32_t>   LevelBandwidths () const;
+
+            /* column-major projection and view matrix (OpenGL) of the frame
+             * presented now, the view in the coordinates of the tile boxes */
+            void    SetView         (const float projection[16], const float view[16]);
+            /* tiles visible in the view predicted ahead seconds from now, nearest
+             * first; every tile at level until the first SetView. If none is
+             * visible, the nearest at level 0 */
+            std::vector<TileChoice> Select  (size_t level, double ahead = 0) const;
+
+        private:
+            struct Tile
+            {
+                TileRegion          region;
+                std::vector<size_t> ranked;     /* representations, lowest bandwidth first */
+            };
+
+            mutable std::mutex      mutex;
+            std::vector<Tile>       tiles;
+            std::vector<uint32_t>   levelBandwidths;
+            float                   projection[16];
+            ViewPredictor           predictor;
+
+            /* planes: a*x + b*y + c*z + d >= 0 inside */
+            bool    Visible         (const TileRegion &region, const float planes[6][4]) const;
+            double  Distance        (const TileRegion &region, const float eye[3]) const;
+    };
+}
+
+#endif /* TILESELECTOR_H_ */
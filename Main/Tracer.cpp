@@ -0,0 +1,177 @@
+/*
+ * Tracer.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "Tracer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+using namespace mcnl;
+
+Tracer::Tracer      () :
+        epoch       (std::chrono::steady_clock::now()),
+        enabled     (false),
+        nextThread  (1),
+        lost        (0)
+{
+}
+
+Tracer&     Tracer::Instance    ()
+{
+    static Tracer tracer;
+    return tracer;
+}
+void        Tracer::Enable      (bool enable)
+{
+    this->enabled.store(enable);
+}
+bool        Tracer::Enabled     () const
+{
+    return this->enabled.load(std::memory_order_relaxed);
+}
+uint64_t    Tracer::Now         () const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->epoch).count();
+}
+void        Tracer::Complete    (const char *name, const char *category, uint64_t start, uint64_t end,
+                                 int64_t segment, int64_t frame)
+{
+    if (!this->Enabled())
+        return;
+
+    Event event;
+
+    event.name     = name;
+    event.category = category;
+    event.start    = start;
+    event.duration = end > start ? end - start : 0;
+    event.segment  = segment;
+    event.frame    = frame;
+    event.thread   = this->ThreadId();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->events.size() >= TRACE_MAX_EVENTS)
+    {
+        this->lost++;
+        return;
+    }
+    this->events.push_back(event);
+}
+void        Tracer::NameThread  (const std::string &name)
+{
+    if (!this->Enabled())
+        return;
+
+    uint32_t thread = this->ThreadId();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->threadNames[thread] = name;
+}
+bool        Tracer::Write       (const std::string &path) const
+{
+    std::ofstream out(path.c_str());
+
+    if (!out)
+        return false;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    /* Chrome trace event format, "X" events with microsecond timestamps */
+    out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"lostEvents\":" << this->lost << "},\"traceEvents\":[\n";
+
+    bool first = true;
+    std::map<uint32_t, std::string>::const_iterator it;
+
+    for (it = this->threadNames.begin(); it != this->threadNames.end(); ++it)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << it->first <<
+               ",\"args\":{\"name\":\"" << it->second << "\"}}";
+        first = false;
+    }
+    for (size_t i = 0; i < this->events.size(); i++)
+    {
+        const Event &event = this->events.at(i);
+
+        out << (first ? "" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category <<
+               "\",\"ph\":\"X\",\"ts\":" << event.start << ",\"dur\":" << event.duration <<
+               ",\"pid\":1,\"tid\":" << event.thread << ",\"args\":{";
+        if (event.segment != TRACE_NO_ID)
+            out << "\"segment\":" << event.segment << (event.frame != TRACE_NO_ID ? "," : "");
+        if (event.frame != TRACE_NO_ID)
+            out << "\"frame\":" << event.frame;
+        out << "}}";
+        first = false;
+    }
+    out << "\n]}\n";
+
+    return out.good();
+}
+void        Tracer::Summarize   (std::ostream &out) const
+{
+    std::map<std::string, std::vector<uint64_t>> stages;
+    size_t lost;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        lost = this->lost;
+        for (size_t i = 0; i < this->events.size(); i++)
+            stages[this->events.at(i).name].push_back(this->events.at(i).duration);
+    }
+
+    out << std::left << std::setw(24) << "stage" << std::right << std::setw(8) << "count" << std::setw(10) << "mean" <<
+           std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    out << std::fixed << std::setprecision(2);
+
+    std::map<std::string, std::vector<uint64_t>>::iterator it;
+
+    for (it = stages.begin(); it != stages.end(); ++it)
+    {
+        std::vector<uint64_t> &durations = it->second;
+        std::sort(durations.begin(), durations.end());
+
+        double sum = 0;
+        for (size_t i = 0; i < durations.size(); i++)
+            sum += durations.at(i);
+
+        /* rank rounded down */
+        size_t last = durations.size() - 1;
+        out << std::left << std::setw(24) << it->first << std::right << std::setw(8) << durations.size() <<
+               std::setw(10) << sum / durations.size() / 1000.0 <<
+               std::setw(10) << durations.at(last * 50 / 100) / 1000.0 <<
+               std::setw(10) << durations.at(last * 90 / 100) / 1000.0 <<
+               std::setw(10) << durations.at(last * 99 / 100) / 1000.0 <<
+               std::setw(10) << durations.at(last) / 1000.0 << "\n";
+    }
+    if (lost > 0)
+        out << lost << " events lost, see TRACE_MAX_EVENTS\n";
+}
+uint32_t    Tracer::ThreadId    ()
+{
+    /* small stable numbers read better in the viewer than native ids */
+    thread_local uint32_t id = 0;
+
+    if (id == 0)
+        id = this->nextThread.fetch_add(1);
+
+    return id;
+}
+
+TraceScope::TraceScope  (const char *name, const char *category, int64_t segment, int64_t frame) :
+            name        (name),
+            category    (category),
+            segment     (segment),
+            frame       (frame),
+            start       (Tracer::Instance().Now())
+{
+}
+TraceScope::~TraceScope ()
+{
+    Tracer::Instance().Complete(this->name, this->category, this->start, Tracer::Instance().Now(),
+                                this->segment, this->frame);
+}
@@ -0,0 +1,95 @@
+/*
+ * Tracer.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Glass-to-glass timeline of the client: every stage a segment or frame
+ * passes through (download, bitstream parse, video sub-stream decode,
+ * reconstruction, smoothing, conversion, render submit) is recorded with
+ * the segment number and a frame ID that counts every decoded frame, and
+ * exported as Chrome trace JSON for chrome://tracing or ui.perfetto.dev.
+ * Recording is off until Enable(); disabled calls cost one atomic load.
+ * Summarize() condenses the same events into a latency distribution per
+ * stage.
+ *****************************************************************************/
+
+#ifndef TRACER_H_
+#define TRACER_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#define TRACE_MAX_EVENTS    (1 << 20)   /* later events are counted, not kept */
+#define TRACE_NO_ID         (-1)
+
+namespace mcnl
+{
+    class Tracer
+    {
+        public:
+            static Tracer&  Instance    ();
+
+            void        Enable          (bool enable);
+            bool        Enabled         () const;
+            /* microseconds since the tracer was created */
+            uint64_t    Now             () const;
+
+            /* name and category must be string literals, they are not copied */
+            void        Complete        (const char *name, const char *category, uint64_t start, uint64_t end,
+                                         int64_t segment = TRACE_NO_ID, int64_t frame = TRACE_NO_ID);
+            /* label of the calling thread's track */
+            void        NameThread      (const std::string &name);
+
+            bool        Write           (const std::string &path) const;
+            /* count, mean and percentiles of the duration of every event name, in milliseconds */
+            void        Summarize       (std::ostream &out) const;
+
+        private:
+            struct Event
+            {
+                const char  *name;
+                const char  *category;
+                uint64_t    start;
+                uint64_t    duration;
+                int64_t     segment;
+                int64_t     frame;
+                uint32_t    thread;
+            };
+
+            Tracer                      ();
+
+            uint32_t    ThreadId        ();
+
+            std::chrono::steady_clock::time_point   epoch;
+            std::atomic<bool>                       enabled;
+            std::atomic<uint32_t>                   nextThread;
+            mutable std::mutex                      mutex;
+            std::vector<Event>                      events;
+            std::map<uint32_t, std::string>         threadNames;
+            size_t                                  lost;
+    };
+
+    /* records the lifetime of the object as one event */
+    class TraceScope
+    {
+        public:
+            TraceScope              (const char *name, const char *category,
+                                     int64_t segment = TRACE_NO_ID, int64_t frame = TRACE_NO_ID);
+            virtual ~TraceScope     ();
+
+        private:
+            const char  *name;
+            const char  *category;
+            int64_t     segment;
+            int64_t     frame;
+            uint64_t    start;
+    };
+}
+
+#endif /* TRACER_H_ */
@@ -0,0 +1,189 @@
+/*
+ * ViewPredictor.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "ViewPredictor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace mcnl;
+
+/* camera to world rotation and camera position of a rigid column-major view matrix */
+static void     Decompose       (const float view[16], double orientation[3][3], double eye[3])
+{
+    for (int row = 0; row < 3; row++)
+        for (int col = 0; col < 3; col++)
+            orientation[row][col] = view[row * 4 + col];    /* transposed */
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        eye[axis] = 0;
+        for (int k = 0; k < 3; k++)
+            eye[axis] -= orientation[axis][k] * view[12 + k];
+    }
+}
+/* axis times angle of a rotation matrix; rotations per frame are far from a half turn */
+static void     AxisAngle       (const double m[3][3], double w[3])
+{
+    double cosine = std::max(-1.0, std::min(1.0, (m[0][0] + m[1][1] + m[2][2] - 1) / 2));
+    double angle  = std::acos(cosine);
+    double sine   = std::sin(angle);
+
+    if (sine < 1e-9)
+    {
+        w[0] = w[1] = w[2] = 0;
+        return;
+    }
+    w[0] = (m[2][1] - m[1][2]) / (2 * sine) * angle;
+    w[1] = (m[0][2] - m[2][0]) / (2 * sine) * angle;
+    w[2] = (m[1][0] - m[0][1]) / (2 * sine) * angle;
+}
+/* Rodrigues: the rotation by |w| radians about w */
+static void     Rotation        (const double w[3], double m[3][3])
+{
+    double angle = std::sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    double k[3]  = { 0, 0, 0 };
+
+    if (angle > 0)
+        for (int axis = 0; axis < 3; axis++)
+            k[axis] = w[axis] / angle;
+
+    double s = std::sin(angle);
+    double c = 1 - std::cos(angle);
+    double K[3][3] = { { 0, -k[2], k[1] }, { k[2], 0, -k[0] }, { -k[1], k[0], 0 } };
+
+    for (int row = 0; row < 3; row++)
+        for (int col = 0; col < 3; col++)
+        {
+            double KK = 0;
+
+            for (int j = 0; j < 3; j++)
+                KK += K[row][j] * K[j][col];
+            m[row][col] = (row == col ? 1 : 0) + s * K[row][col] + c * KK;
+        }
+}
+static void     Multiply        (const double a[3][3], const double b[3][3], double m[3][3])
+{
+    for (int row = 0; row < 3; row++)
+        for (int col = 0; col < 3; col++)
+        {
+            m[row][col] = 0;
+            for (int k = 0; k < 3; k++)
+                m[row][col] += a[row][k] * b[k][col];
+        }
+}
+
+ViewPredictor::ViewPredictor    () :
+               hasView          (false),
+               moving           (false)
+{
+    memset(this->position, 0, sizeof(this->position));
+    memset(this->velocity, 0, sizeof(this->velocity));
+    memset(this->orientation, 0, sizeof(this->orientation));
+    memset(this->turn, 0, sizeof(this->turn));
+}
+ViewPredictor::~ViewPredictor   ()
+{
+}
+
+void    ViewPredictor::Update       (const float view[16])
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    double orientation[3][3];
+    double eye[3];
+    double dt = std::chrono::duration<double>(now - this->updated).count();
+
+    Decompose(view, orientation, eye);
+
+    if (!this->hasView || dt > VIEW_PREDICT_MAX_GAP)
+    {
+        /* the first view, or the first after a pause: standing still */
+        memcpy(this->position, eye, sizeof(this->position));
+        memset(this->velocity, 0, sizeof(this->velocity));
+        memset(this->turn, 0, sizeof(this->turn));
+        this->moving = false;
+    }
+    else if (dt > 1e-4)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            double predicted = this->position[axis] + this->velocity[axis] * dt;
+            double residual  = eye[axis] - predicted;
+
+            this->position[axis]  = predicted + VIEW_PREDICT_ALPHA * residual;
+            this->velocity[axis] += VIEW_PREDICT_BETA * residual / dt;
+        }
+
+        /* the rotation since the last view, in world coordinates */
+        double previous[3][3];
+        double delta[3][3];
+        double w[3];
+
+        for (int row = 0; row < 3; row++)
+            for (int col = 0; col < 3; col++)
+                previous[row][col] = this->orientation[col][row];
+        Multiply(orientation, previous, delta);
+        AxisAngle(delta, w);
+
+        for (int axis = 0; axis < 3; axis++)
+            this->turn[axis] += VIEW_PREDICT_TURN_ALPHA * (w[axis] / dt - this->turn[axis]);
+        this->moving = true;
+    }
+    else
+        return;
+
+    memcpy(this->orientation, orientation, sizeof(this->orientation));
+    this->updated = now;
+    this->hasView = true;
+}
+bool    ViewPredictor::HasView      () const
+{
+    return this->hasView;
+}
+void    ViewPredictor::Predict      (double seconds, float view[16], float eye[3]) const
+{
+    double ahead = 0;
+
+    /* counted from the last view; one too old to move from predicts where it was */
+    if (this->moving)
+    {
+        double since = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->updated).count();
+
+        if (since <= VIEW_PREDICT_MAX_GAP)
+            ahead = std::min(std::max(seconds, 0.0) + since, VIEW_PREDICT_MAX_SECONDS);
+    }
+
+    double w[3];
+    double rotation[3][3];
+    double orientation[3][3];
+    double position[3];
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        w[axis]        = this->turn[axis] * ahead;
+        position[axis] = this->position[axis] + this->velocity[axis] * ahead;
+    }
+    Rotation(w, rotation);
+    Multiply(rotation, this->orientation, orientation);
+
+    /* world to camera: the transposed orientation, and the eye moved to the origin */
+    for (int row = 0; row < 3; row++)
+    {
+        double t = 0;
+
+        for (int col = 0; col < 3; col++)
+        {
+            view[col * 4 + row] = (float) orientation[col][row];
+            t -= orientation[col][row] * position[col];
+        }
+        view[12 + row] = (float) t;
+        view[row * 4 + 3] = 0;
+        eye[row] = (float) position[row];
+    }
+    view[15] = 1;
+}
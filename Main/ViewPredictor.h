@@ -0,0 +1,52 @@
+/*
+ * ViewPredictor.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * Where the camera will be when a segment requested now is played. The
+ * renderer's view matrices are filtered into a position and velocity (an
+ * alpha-beta filter, the steady state of a constant-velocity Kalman filter)
+ * and an angular velocity, and both are extrapolated linearly. That covers
+ * a head turn or an orbit well for the second or so a segment takes to
+ * arrive; further ahead the prediction is held at VIEW_PREDICT_MAX_SECONDS,
+ * as the motion is as likely to stop as to go on.
+ *****************************************************************************/
+
+#ifndef VIEWPREDICTOR_H_
+#define VIEWPREDICTOR_H_
+
+#include <chrono>
+
+#define VIEW_PREDICT_ALPHA          0.5     /* weight of a new position against the predicted one */
+#define VIEW_PREDICT_BETA           0.2     /* weight of its residual in the velocity */
+#define VIEW_PREDICT_TURN_ALPHA     0.3     /* EWMA weight of the newest angular velocity */
+#define VIEW_PREDICT_MAX_SECONDS    2.0     /* predictions go no further ahead */
+#define VIEW_PREDICT_MAX_GAP        0.5     /* seconds without a view after which the motion is taken as stopped */
+
+namespace mcnl
+{
+    class ViewPredictor
+    {
+        public:
+            ViewPredictor           ();
+            virtual ~ViewPredictor  ();
+
+            /* column-major rigid view matrix (world to camera) of the frame presented now */
+            void    Update          (const float view[16]);
+            bool    HasView         () const;
+            /* the view matrix and camera position expected seconds from now; the last
+             * view itself until there are two to tell the motion from */
+            void    Predict         (double seconds, float view[16], float eye[3]) const;
+
+        private:
+            std::chrono::steady_clock::time_point   updated;
+            bool                                    hasView;
+            bool                                    moving;     /* velocities measured */
+            double                                  position[3];
+            double                                  velocity[3];
+            double                                  orientation[3][3];  /* camera to world */
+            double                                  turn[3];    /* axis times radians per second */
+    };
+}
+
+#endif /* VIEWPREDICTOR_H_ */
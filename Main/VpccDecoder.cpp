@@ -0,0 +1,428 @@
+/*
+ * VpccDecoder.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "VpccDecoder.h"
+#include "DeviceReconstructor.h"
+
+#include "PCCContext.h"
+#include "PCCFrameContext.h"
+#include "PCCDecoder.h"
+#include "PCCGroupOfFrames.h"
+#include "PCCBitstreamReader.h"
+#include "PCCV3CUnitIndex.h"
+#include "PCCVideoDecoder.h"
+#include "PCCVideoDecoderPool.h"
+#include "SampleStreamParser.h"
+#include "Tracer.h"
+
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+
+using namespace mcnl;
+using namespace pcc;
+
+VpccDecoder::VpccDecoder    () :
+             busySeconds        (0),
+             appVideoDecoder    (false),
+             traceSegment       (TRACE_NO_ID),
+             nextFrameId        (0),
+             frameIdStep        (1),
+             gofFrameId         (0),
+             skipFrames         (0),
+             context            (new PCCContext()),
+             videoDecoders      (new PCCVideoDecoderPool())
+{
+}
+VpccDecoder::~VpccDecoder   ()
+{
+}
+
+bool                    VpccDecoder::SetOptions     (const std::vector<std::string> &options)
+{
+    bool ret = true;
+
+    for (size_t i = 0; i < options.size(); i++)
+    {
+        const std::string &line = options[i];
+
+        if (line.compare(0, 2, "--") || line.find('=') == std::string::npos)
+            continue;
+
+        size_t eq = line.find('=');
+        ret &= this->SetOption(line.substr(2, eq - 2), line.substr(eq + 1));
+    }
+
+    return ret;
+}
+bool                    VpccDecoder::SetOption      (const std::string &key, const std::string &value)
+{
+    if (key == "videoDecoder")
+    {
+        if (value != "lib" && value != "app")
+        {
+            std::cerr << "VpccDecoder: videoDecoder must be lib or app, not " << value << std::endl;
+            return false;
+        }
+        this->appVideoDecoder = value == "app";
+    }
+    else if (key == "videoDecoderOccupancyPath")
+        this->params.videoDecoderOccupancyPath_ = value;
+    else if (key == "videoDecoderGeometryPath")
+        this->params.videoDecoderGeometryPath_ = value;
+    else if (key == "videoDecoderAttributePath")
+        this->params.videoDecoderAttributePath_ = value;
+    else if (key == "colorSpaceConversionPath")
+        this->params.colorSpaceConversionPath_ = value;
+    else if (key == "inverseColorSpaceConversionConfig")
+        this->params.inverseColorSpaceConversionConfig_ = value;
+    else if (key == "nbThread")
+        this->params.nbThread_ = atoi(value.c_str());
+    else if (key == "threadAffinity")
+        this->params.threadAffinity_ = value;
+    else if (key == "parallelFrames")
+        this->params.parallelFrames_ = atoi(value.c_str()) != 0;
+    else if (key == "videoDecoderThreads")
+        this->params.videoDecoderThreads_ = atoi(value.c_str());
+    else if (key == "videoDecoderHardware")
+        this->params.videoDecoderHardware_ = value;
+    else if (key == "deviceReconstruction")
+    {
+        this->reconstructor.reset();
+        if (value.empty() || value == "off")
+            return true;
+        try
+        {
+            this->reconstructor.reset(new DeviceReconstructor(value));
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "VpccDecoder: no device " << value << " for deviceReconstruction: " << e.what() << std::endl;
+            return false;
+        }
+        std::cout << "VpccDecoder: reconstructing on " << this->reconstructor->Device().ToString() << std::endl;
+    }
+    else if (key == "keepIntermediateFiles")
+        this->params.keepIntermediateFiles_ = atoi(value.c_str()) != 0;
+    else if (key == "patchColorSubsampling")
+        this->params.patchColorSubsampling_ = atoi(value.c_str()) != 0;
+    else if (key == "fixedPointSmoothing")
+        this->params.fixedPointSmoothing_ = atoi(value.c_str()) != 0;
+    else
+    {
+        std::cerr << "VpccDecoder: unknown option " << key << std::endl;
+        return false;
+    }
+
+    return true;
+}
+PCCDecoderParameters&   VpccDecoder::Parameters     ()
+{
+    return this->params;
+}
+bool                    VpccDecoder::Decodes        (const std::vector<std::string> &codecs)
+{
+    for (size_t i = 0; i < codecs.size(); i++)
+    {
+        /* sample entry 4CC, then the profile and level after the first '.' */
+        std::string codec4cc = codecs[i].substr(0, codecs[i].find('.'));
+
+        /* the V3C bitstream itself: v3c1, v3cg, v3e1, v3eg */
+        if (codec4cc.compare(0, 3, "v3c") == 0 || codec4cc.compare(0, 3, "v3e") == 0)
+            continue;
+        if (!PCCVideoDecoder::canDecode(codec4cc))
+            return false;
+    }
+
+    return true;
+}
+int                     VpccDecoder::Decode         (const std::string &segmentPath, FrameCallback callback)
+{
+    PCCBitstream bitstream;
+
+    if (!bitstream.initialize(segmentPath))
+        return -1;
+
+    /* the App video decoders derive their temporary file names from it */
+    this->params.compressedStreamPath_ = segmentPath;
+
+    return this->Decode(bitstream, callback);
+}
+int                     VpccDecoder::Decode         (const std::string &segmentPath, size_t firstFrame, FrameCallback callback)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    PCCBitstream bitstream;
+
+    if (!bitstream.initialize(segmentPath))
+        return -1;
+
+    this->params.compressedStreamPath_ = segmentPath;
+
+    PCCBitstreamStat bitstreamStat;
+    PCCDecoder       decoder;
+
+    this->Prepare(decoder, bitstreamStat, bitstream.size());
+
+    /* a missing or stale index is rebuilt by reading the whole segment */
+    V3CUnitIndex    index;
+    std::string     indexPath = segmentPath + ".v3ci";
+    bool            indexed   = index.read(indexPath) && index.getStreamSize() == bitstream.capacity();
+    size_t          gof       = indexed ? index.findGof(firstFrame) : 0;
+    bool            counted   = indexed;
+
+    if (gof >= index.getGofCount())
+        gof = 0;
+    for (size_t i = 0; i < index.getGofCount(); i++)
+        counted = counted && index.getGof(i).atlasFrameCountKnown_;
+
+    SampleStreamV3CUnit ssvu;
+    size_t              headerSize = PCCBitstreamReader::read(bitstream, ssvu, index, gof);
+    bitstreamStat.incrHeader(headerSize);
+
+    this->skipFrames = firstFrame;
+    if (gof < index.getGofCount())
+        this->skipFrames -= index.getGof(gof).firstAtlasFrame_;
+
+    int  ret  = 0;
+    bool more = true;
+    while (ret == 0 && more && ssvu.getV3CUnitCount() > 0)
+        ret = this->DecodeGof(ssvu, decoder, bitstreamStat, callback, more, &index, gof++);
+    this->skipFrames = 0;
+
+    if (!counted && !index.write(indexPath))
+        std::cerr << "VpccDecoder: cannot write " << indexPath << std::endl;
+
+    std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+    this->busySeconds = sec.count();
+
+    return ret;
+}
+int                     VpccDecoder::Decode         (std::vector<uint8_t> &data, const std::string &name, FrameCallback callback)
+{
+    PCCBitstream bitstream;
+
+    bitstream.vector().swap(data);
+    this->params.compressedStreamPath_ = name;
+
+    return this->Decode(bitstream, callback);
+}
+int                     VpccDecoder::Decode         (PCCBitstream &bitstream, FrameCallback callback)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    PCCBitstreamStat bitstreamStat;
+    PCCDecoder       decoder;
+
+    this->Prepare(decoder, bitstreamStat, bitstream.size());
+
+    SampleStreamV3CUnit ssvu;
+    size_t              headerSize = PCCBitstreamReader::read(bitstream, ssvu);
+    bitstreamStat.incrHeader(headerSize);
+
+    int  ret  = 0;
+    bool more = true;
+    while (ret == 0 && more && ssvu.getV3CUnitCount() > 0)
+        ret = this->DecodeGof(ssvu, decoder, bitstreamStat, callback, more);
+
+    std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+    this->busySeconds = sec.count();
+
+    return ret;
+}
+int                     VpccDecoder::Decode         (SegmentStream &stream, const std::string &name, FrameCallback callback)
+{
+    PCCBitstreamStat    bitstreamStat;
+    PCCDecoder          decoder;
+    SampleStreamV3CUnit ssvu;
+    SampleStreamParser  parser(ssvu);
+
+    this->params.compressedStreamPath_ = name;
+    this->busySeconds                  = 0;
+    this->Prepare(decoder, bitstreamStat, 0);
+
+    std::vector<uint8_t>    piece;
+    int                     ret  = 0;
+    bool                    more = true;
+
+    /* a GOF is complete once the VPS of the next one has arrived */
+    while (ret == 0 && more && stream.Read(piece))
+    {
+        parser.Feed(piece.data(), piece.size());
+
+        while (ret == 0 && more && HasCompleteGof(ssvu))
+            ret = this->TimedDecodeGof(ssvu, decoder, bitstreamStat, callback, more);
+    }
+
+    if (ret == 0 && more && !stream.Complete())
+    {
+        /* the download failed: the last GOF may be cut off */
+        std::cerr << "VpccDecoder: " << name << " ended early, dropping the last GOF" << std::endl;
+        return -1;
+    }
+
+    if (parser.Buffered() > 0)
+        std::cerr << "VpccDecoder: " << parser.Buffered() << " trailing bytes in " << name << std::endl;
+
+    bitstreamStat.incrHeader(parser.HeaderBytes());
+
+    while (ret == 0 && more && ssvu.getV3CUnitCount() > 0)
+        ret = this->TimedDecodeGof(ssvu, decoder, bitstreamStat, callback, more);
+
+    return ret;
+}
+double                  VpccDecoder::BusySeconds    () const
+{
+    return this->busySeconds;
+}
+void                    VpccDecoder::TraceSegment   (int64_t segment)
+{
+    this->traceSegment = segment;
+}
+void                    VpccDecoder::SetDeviceFrameCallback (DeviceFrameCallback callback)
+{
+    this->deviceCallback = callback;
+}
+void                    VpccDecoder::SetExecutionContext    (std::shared_ptr<PCCExecutionContext> context)
+{
+    this->executionContext = context;
+}
+void                    VpccDecoder::SetFrameIds    (uint64_t first, uint64_t step)
+{
+    this->nextFrameId = first;
+    this->frameIdStep = step;
+}
+void                    VpccDecoder::SetPostProcessingCallback  (PostProcessingCallback callback)
+{
+    this->postProcessingCallback = callback;
+}
+void                    VpccDecoder::Prepare        (PCCDecoder &decoder, PCCBitstreamStat &bitstreamStat, size_t size)
+{
+    this->logger.initilalize(removeFileExtension(this->params.compressedStreamPath_), false);
+    bitstreamStat.setHeader(size);
+    decoder.setLogger(this->logger);
+
+    /* PCCDecoder picks the app decoder whenever its path is set */
+    PCCDecoderParameters params = this->params;
+
+    if (!this->appVideoDecoder)
+    {
+        params.videoDecoderOccupancyPath_.clear();
+        params.videoDecoderGeometryPath_.clear();
+        params.videoDecoderAttributePath_.clear();
+    }
+    decoder.setParameters(params);
+    decoder.setVideoDecoderPool(this->videoDecoders);
+    if (this->executionContext)
+        decoder.setExecutionContext(this->executionContext);
+    decoder.setPostProcessingCallback(this->postProcessingCallback);
+
+    /* video sub-streams are decoded on TBB workers; a worker waiting inside
+     * one stage can run another one to completion, so stages nest per thread */
+    decoder.setStageCallback([this](const char *stage, int32_t frameIndex, bool begin) {
+        thread_local std::vector<uint64_t> starts;
+        Tracer &tracer = Tracer::Instance();
+
+        if (begin)
+        {
+            starts.push_back(tracer.Now());
+            return;
+        }
+        if (starts.empty())
+            return;
+
+        tracer.Complete(stage, "decode", starts.back(), tracer.Now(), this->traceSegment,
+                        frameIndex < 0 ? TRACE_NO_ID : (int64_t) (this->gofFrameId + frameIndex * this->frameIdStep));
+        starts.pop_back();
+    });
+}
+int                     VpccDecoder::TimedDecodeGof (SampleStreamV3CUnit &ssvu, PCCDecoder &decoder,
+                                                     PCCBitstreamStat &bitstreamStat, FrameCallback &callback, bool &more)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    int ret = this->DecodeGof(ssvu, decoder, bitstreamStat, callback, more);
+
+    std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+    this->busySeconds += sec.count();
+
+    return ret;
+}
+int                     VpccDecoder::DecodeGof      (SampleStreamV3CUnit &ssvu, PCCDecoder &decoder,
+                                                     PCCBitstreamStat &bitstreamStat, FrameCallback &callback, bool &more,
+                                                     V3CUnitIndex *index, size_t gofIndex)
+{
+    PCCGroupOfFrames    reconstructs;
+    PCCContext          &context = *this->context;
+    PCCBitstreamReader  bitstreamReader;
+
+    context.reset();
+    context.setBitstreamStat(bitstreamStat);
+
+    uint64_t    parseStart = Tracer::Instance().Now();
+    int32_t     parsed     = index ? bitstreamReader.decode(ssvu, context, *index, gofIndex)
+                                   : bitstreamReader.decode(ssvu, context);
+
+    Tracer::Instance().Complete("parse", "decode", parseStart, Tracer::Instance().Now(), this->traceSegment);
+    if (parsed == 0)
+    {
+        more = false;
+        return 0;
+    }
+
+    if (context.checkProfile() != 0)
+    {
+        std::cerr << "VpccDecoder: profile not correct" << std::endl;
+        return -1;
+    }
+    this->params.setReconstructionParameters(context.getVps().getProfileTierLevel().getProfileReconstructionIdc());
+    decoder.setReconstructionParameters(this->params);
+
+    context.resizeAtlas(context.getVps().getAtlasCountMinus1() + 1);
+    for (uint32_t atlId = 0; atlId < context.getVps().getAtlasCountMinus1() + 1; atlId++)
+    {
+        context.getAtlas(atlId).allocateVideoFrames(context, 0);
+        context.setAtlasIndex(atlId);
+
+        this->gofFrameId = this->nextFrameId;
+
+        /* frames arrive in order, each as soon as it is reconstructed */
+        decoder.setFrameCallback([this, &callback](PCCPointSet3 &frame, size_t) {
+            if (this->skipFrames > 0)
+            {
+                this->skipFrames--;
+                this->nextFrameId += this->frameIdStep;
+                return;
+            }
+            uint64_t frameId = this->nextFrameId;
+            this->nextFrameId += this->frameIdStep;
+            callback(frame, frameId);
+        });
+        if (this->reconstructor && this->deviceCallback)
+            decoder.setTexturesCallback([this](const PCCDecodedTextures &textures) {
+                if (this->skipFrames > 0)
+                {
+                    this->skipFrames--;
+                    this->nextFrameId += this->frameIdStep;
+                    return;
+                }
+                uint64_t start = Tracer::Instance().Now();
+                std::shared_ptr<open3d::t::geometry::PointCloud> cloud = this->reconstructor->Reconstruct(textures);
+
+                Tracer::Instance().Complete("device reconstruct", "decode", start, Tracer::Instance().Now(),
+                                            this->traceSegment, (int64_t) this->nextFrameId);
+                this->deviceCallback(cloud, this->nextFrameId);
+                this->nextFrameId += this->frameIdStep;
+            });
+        int ret = decoder.decode(context, reconstructs, atlId);
+        decoder.setFrameCallback(PCCDecoderFrameCallback());
+        decoder.setTexturesCallback(PCCDecoderTexturesCallback());
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * VpccDecoder.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *
+ * In-process V-PCC decode stage linked against PccLibDecoder. Replaces the
+ * fork/exec of PccAppDecoder and the PLY round-trip through dec_test/.
+ * The video sub-streams go through the HM library decoder by default; the
+ * TAppDecoder processes are used only with --videoDecoder=app.
+ * With a PccLibVideoDecoder built with USE_FFMPEG_VIDEO_CODEC,
+ * --videoDecoderHardware=auto (or vaapi, cuda, videotoolbox...) decodes
+ * them with libavcodec on the hardware HEVC decoder of the device instead.
+ * --deviceReconstruction=auto (or CUDA:0, CPU:0) reconstructs the frames
+ * that need no post-processing straight from the decoded images as Open3D
+ * tensor point clouds on that device (see DeviceReconstructor); they go to
+ * the DeviceFrameCallback, the other frames to the FrameCallback.
+ * The video codec of each segment is read from its VPS (and component
+ * codec mapping SEI), so HEVC and VVC (VTM library) representations of
+ * one content decode through the same VpccDecoder.
+ *****************************************************************************/
+
+#ifndef VPCCDECODER_H_
+#define VPCCDECODER_H_
+
+#include "PCCCommon.h"
+#include "PCCBitstream.h"
+#include "PCCLogger.h"
+#include "PCCPointSet.h"
+#include "PCCDecoderParameters.h"
+#include "PCCSampleStreamV3CUnit.h"
+#include "PackedCloud.h"
+#include "SegmentStream.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pcc
+{
+    class PCCDecoder;
+    class PCCContext;
+    class PCCExecutionContext;
+    class PCCVideoDecoderPool;
+    class V3CUnitIndex;
+}
+namespace open3d
+{
+    namespace t
+    {
+        namespace geometry
+        {
+            class PointCloud;
+        }
+    }
+}
+
+namespace mcnl
+{
+    /* decoded frame plus its presentation time, as handed to the renderer */
+    struct DecodedFrame
+    {
+        PackedCloud         points;         /* positions and colors only */
+        /* set instead of points for the frames reconstructed on the device */
+        std::shared_ptr<open3d::t::geometry::PointCloud>    deviceCloud;
+        double              pts;            /* seconds since stream start */
+        double              frameRate;
+        uint64_t            frameId;        /* see FrameCallback */
+        size_t              segmentNumber;
+    };
+
+    /* called once per reconstructed frame, in presentation order; frameId
+     * counts every frame the decoder produced and tags it in the trace */
+    typedef std::function<void(pcc::PCCPointSet3 &frame, uint64_t frameId)> FrameCallback;
+    /* same for the frames of --deviceReconstruction, with the same frameId sequence */
+    typedef std::function<void(std::shared_ptr<open3d::t::geometry::PointCloud> &cloud, uint64_t frameId)>
+        DeviceFrameCallback;
+    /* post-processing of the frame frameIndex of the GOF, see pcc::PCCDecoderPostProcessingCallback */
+    typedef std::function<pcc::PCCPostProcessing(size_t frameIndex)> PostProcessingCallback;
+
+    class DeviceReconstructor;
+
+    class VpccDecoder
+    {
+        public:
+            VpccDecoder             ();
+            virtual ~VpccDecoder    ();
+
+            /* "--key=value" lines, same syntax as PccAppDecoder (see decOpt.txt) */
+            bool    SetOptions      (const std::vector<std::string> &options);
+            bool    SetOption       (const std::string &key, const std::string &value);
+
+            int     Decode          (const std::string &segmentPath, FrameCallback callback);
+            /* seek: starts at atlas frame firstFrame of the segment, from the
+             * last IRAP GOF at or before it. The V3C unit index is kept next
+             * to the segment in segmentPath + ".v3ci", so seeking into it
+             * again parses nothing ahead of that GOF; until the index has
+             * counted the frames, decoding starts at the first GOF. Frames
+             * ahead of firstFrame are decoded but not handed on */
+            int     Decode          (const std::string &segmentPath, size_t firstFrame, FrameCallback callback);
+            /* takes over the contents of data; name is used for temporary files */
+            int     Decode          (std::vector<uint8_t> &data, const std::string &name, FrameCallback callback);
+            int     Decode          (pcc::PCCBitstream &bitstream, FrameCallback callback);
+            /* progressive: V3C units are parsed while the segment downloads
+             * and each GOF is decoded as soon as all of it has arrived */
+            int     Decode          (SegmentStream &stream, const std::string &name, FrameCallback callback);
+
+            /* time the last Decode spent decoding, without waiting for data */
+            double  BusySeconds     () const;
+            /* segment number recorded with the trace events of the next Decode */
+            void    TraceSegment    (int64_t segment);
+            /* receives the frames of the next Decode calls that are reconstructed on the device */
+            void    SetDeviceFrameCallback  (DeviceFrameCallback callback);
+            /* for decoders that run side by side (see DecodeScheduler): they share the worker
+             * threads of context, and their frameIds go first, first + step, first + 2 * step...
+             * so that they stay apart. Set before the first Decode */
+            void    SetExecutionContext     (std::shared_ptr<pcc::PCCExecutionContext> context);
+            void    SetFrameIds             (uint64_t first, uint64_t step);
+            /* picks the post-processing of each frame of the next Decode calls, see PostProcessingGovernor */
+            void    SetPostProcessingCallback   (PostProcessingCallback callback);
+
+            pcc::PCCDecoderParameters&  Parameters  ();
+
+            /* false if an entry of @codecs, e.g. v3c1,vvi1, names a video codec this
+             * build of PccLibVideoDecoder has no decoder for; true if codecs is empty */
+            static bool Decodes     (const std::vector<std::string> &codecs);
+
+        private:
+            pcc::PCCDecoderParameters   params;
+            pcc::PCCLogger              logger;
+            double                      busySeconds;
+            bool                        appVideoDecoder;    /* HM app decoders at the configured paths */
+            int64_t                     traceSegment;
+            uint64_t                    nextFrameId;
+            uint64_t                    frameIdStep;
+            uint64_t                    gofFrameId;     /* frameId of the first frame of the current GOF */
+            uint64_t                    skipFrames;     /* frames still to drop before a seek target */
+            /* kept across GOFs and segments so the video frames are allocated once */
+            std::unique_ptr<pcc::PCCContext> context;
+            /* video decoders kept warm across segments and quality switches */
+            std::shared_ptr<pcc::PCCVideoDecoderPool> videoDecoders;
+            std::shared_ptr<pcc::PCCExecutionContext> executionContext;   /* null: each PCCDecoder has its own */
+            std::unique_ptr<DeviceReconstructor>    reconstructor;  /* null without --deviceReconstruction */
+            DeviceFrameCallback                     deviceCallback;
+            PostProcessingCallback                  postProcessingCallback;
+
+            void    Prepare         (pcc::PCCDecoder &decoder, pcc::PCCBitstreamStat &bitstreamStat, size_t size);
+            /* one GOF off the front of ssvu; more is cleared at the end of the stream.
+             * With an index, the atlas frames of GOF gofIndex are counted in it */
+            int     DecodeGof       (pcc::SampleStreamV3CUnit &ssvu, pcc::PCCDecoder &decoder,
+                                     pcc::PCCBitstreamStat &bitstreamStat, FrameCallback &callback, bool &more,
+                                     pcc::V3CUnitIndex *index = nullptr, size_t gofIndex = 0);
+            int     TimedDecodeGof  (pcc::SampleStreamV3CUnit &ssvu, pcc::PCCDecoder &decoder,
+                                     pcc::PCCBitstreamStat &bitstreamStat, FrameCallback &callback, bool &more);
+    };
+}
+
+#endif /* VPCCDECODER_H_ */
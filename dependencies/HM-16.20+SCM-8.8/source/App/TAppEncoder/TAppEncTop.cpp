@@ -90,17 +90,12 @@ Void TAppEncTop::xInitLibCfg()
 
 #if PCC_ME_EXT
   m_cTEncTop.setUsePCCExt(m_usePCCExt);
-  if (m_usePCCExt) {
-	m_cTEncTop.setBlockToPatchFileName(m_blockToPatchFileName);
-	m_cTEncTop.setOccupancyMapFileName(m_occupancyMapFileName);
-	//m_cTencTop.setPatchInfoFileName                                 ( m_patchInfoFileName );
-  }
 #endif
 #if PCC_RDO_EXT
   m_cTEncTop.setUsePCCRDOExt(m_usePCCRDO);
 #endif
-#if PCC_RDO_EXT && !PCC_ME_EXT
-  m_cTEncTop.setOccupancyMapFileName(m_occupancyMapFileName);
+#if PCC_ME_EXT || PCC_RDO_EXT
+  m_cTEncTop.setPCCSideInfo(&m_pccSideInfo);
 #endif
 
   m_cTEncTop.setProfile                                           ( m_profile);
@@ -596,6 +591,93 @@ Void TAppEncTop::xInitLib(Bool isFieldCoding)
 // Public member functions
 // ====================================================================================================================
 
+#if PCC_ME_EXT || PCC_RDO_EXT
+/**
+ - read the OccupancyMapFile and, with readPatches, the BlockToPatchFile and PatchInfoFile: one frame of each for
+   every two pictures
+ */
+Void TAppEncTop::xReadPCCSideInfo(Bool readPatches)
+{
+  printf("\nReading the aux info files\n");
+  m_pccSideInfo.width              = m_inputFileWidth;
+  m_pccSideInfo.height             = m_inputFileHeight;
+  m_pccSideInfo.occupancyPrecision = 1;
+  m_pccSideInfo.frames.clear();
+
+  const size_t samples          = (size_t)m_inputFileWidth * m_inputFileHeight;
+  const size_t blocks           = (size_t)(m_inputFileWidth / 16) * (m_inputFileHeight / 16);
+  FILE*        occupancyMapFile = fopen(m_occupancyMapFileName.c_str(), "rb");
+  FILE*        blockToPatchFile = NULL;
+  FILE*        patchInfoFile    = NULL;
+#if PCC_ME_EXT
+  if (readPatches)
+  {
+    blockToPatchFile = fopen(m_blockToPatchFileName.c_str(), "rb");
+    patchInfoFile    = fopen(m_patchInfoFileName.c_str(), "rb");
+  }
+#endif
+  if (occupancyMapFile == NULL || (readPatches && (blockToPatchFile == NULL || patchInfoFile == NULL)))
+  {
+    fprintf(stderr, "\nfailed to open the aux info files\n");
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<Int> occupancyMap(samples);
+  while (fread(&occupancyMap[0], sizeof(Int), samples, occupancyMapFile) == samples)
+  {
+    m_pccSideInfo.frames.push_back(PCCFrameSideInfo());
+    PCCFrameSideInfo& frame = m_pccSideInfo.frames.back();
+    frame.occupancy.resize(samples);
+    for (size_t i = 0; i < samples; i++)
+    {
+      frame.occupancy[i] = occupancyMap[i] != 0;
+    }
+    if (!readPatches)
+    {
+      continue;
+    }
+
+    long long numPatches = 0;
+    frame.blockToPatch.resize(blocks);
+    if (fread(&frame.blockToPatch[0], sizeof(long long), blocks, blockToPatchFile) != blocks ||
+        fread(&numPatches, sizeof(long long), 1, patchInfoFile) != 1)
+    {
+      printf("error: Wrong Patch data group file");
+      break;
+    }
+    frame.patches.resize(numPatches);
+    for (long long patchIdx = 0; patchIdx < numPatches; patchIdx++)
+    {
+      long long         values[8];
+      PCCPatchSideInfo& patch = frame.patches[patchIdx];
+      if (fread(values, sizeof(long long), 8, patchInfoFile) != 8)
+      {
+        printf("error: Wrong Auxiliary data format");
+        break;
+      }
+      patch.projectionIndex = values[0];
+      patch.u0              = values[1];
+      patch.v0              = values[2];
+      patch.sizeU0          = values[3];
+      patch.sizeV0          = values[4];
+      patch.d1              = values[5];
+      patch.u1              = values[6];
+      patch.v1              = values[7];
+    }
+  }
+
+  fclose(occupancyMapFile);
+  if (blockToPatchFile != NULL)
+  {
+    fclose(blockToPatchFile);
+  }
+  if (patchInfoFile != NULL)
+  {
+    fclose(patchInfoFile);
+  }
+}
+#endif
+
 /**
  - create internal class
  - initialize internal variable
@@ -621,48 +703,20 @@ Void TAppEncTop::encode()
   xCreateLib();
   xInitLib(m_isField);
 
-#if PCC_ME_EXT
+#if PCC_ME_EXT && PCC_RDO_EXT
+  if (m_usePCCExt || m_usePCCRDO)
+  {
+    xReadPCCSideInfo(m_usePCCExt);
+  }
+#elif PCC_ME_EXT
   if (m_usePCCExt)
   {
-	  printf("\nReading the aux info files\n");
-	  FILE* patchFile = NULL;
-	  patchFile = fopen(m_patchInfoFileName.c_str(), "rb");
-
-	  for (Int i = 0; i < PCC_ME_EXT_MAX_NUM_FRAMES; i++)
-	  {
-		  long long readSize = fread(&g_numPatches[i], sizeof(long long), 1, patchFile);
-
-		  if (readSize != 1 && readSize != 0)
-		  {
-			  printf("error: Wrong Patch data group file");
-		  }
-
-		  for (Int patchIdx = 0; patchIdx < g_numPatches[i]; patchIdx++)
-		  {
-			  readSize = fread(&g_projectionIndex[i][patchIdx], sizeof(long long), 1, patchFile);
-
-			  if (readSize != 1)
-			  {
-				  printf("error: Wrong Auxiliary data format");
-			  }
-
-			  readSize = fread(g_patch2DInfo[i][patchIdx], sizeof(long long), 4, patchFile);
-
-			  if (readSize != 4)
-			  {
-				  printf("error: Wrong Auxiliary data format");
-			  }
-
-			  readSize = fread(g_patch3DInfo[i][patchIdx], sizeof(long long), 3, patchFile);
-
-			  if (readSize != 3)
-			  {
-				  printf("error: Wrong Auxiliary data format");
-			  }
-		  }
-	  }
-
-	  fclose(patchFile);
+    xReadPCCSideInfo(true);
+  }
+#elif PCC_RDO_EXT
+  if (m_usePCCRDO)
+  {
+    xReadPCCSideInfo(false);
   }
 #endif
 
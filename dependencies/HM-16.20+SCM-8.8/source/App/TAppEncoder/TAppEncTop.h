@@ -69,6 +69,9 @@ private:
 
   UInt m_essentialBytes;
   UInt m_totalBytes;
+#if PCC_ME_EXT || PCC_RDO_EXT
+  PCCSideInfo                m_pccSideInfo;                 ///< side information of the PCC motion estimation and RDO
+#endif
 
 protected:
   // initialization
@@ -76,6 +79,9 @@ protected:
   Void  xInitLibCfg       ();                               ///< initialize internal variables
   Void  xInitLib          (Bool isFieldCoding);             ///< initialize encoder class
   Void  xDestroyLib       ();                               ///< destroy encoder class
+#if PCC_ME_EXT || PCC_RDO_EXT
+  Void  xReadPCCSideInfo  (Bool readPatches);               ///< read the PCC side information files
+#endif
 
   /// obtain required buffers
   Void xGetBuffer(TComPicYuv*& rpcPicYuvRec);
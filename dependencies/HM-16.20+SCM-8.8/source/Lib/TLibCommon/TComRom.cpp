@@ -41,6 +41,7 @@
 #include <stdio.h>
 #include <iomanip>
 #include <assert.h>
+#include <mutex>
 #include "TComDataCU.h"
 #include "Debug.h"
 namespace pcc_hm {
@@ -232,9 +233,19 @@ UChar g_getMsbP1Idx(UInt uiVal)
   return idx+g_ucMsbP1Idx[uiVal];
 }
 
+// the ROM is shared by the encoders and decoders of a process: it is initialized by the first one and destroyed by
+// the last one
+static std::mutex g_romMutex;
+static Int        g_romCount = 0;
+
 // initialize ROM variables
 Void initROM()
 {
+  std::lock_guard<std::mutex> lock( g_romMutex );
+  if ( g_romCount++ > 0 )
+  {
+    return;
+  }
   Int i, c;
 
   // g_aucConvertToBit[ x ]: log2(x/4), if x=4 -> 0, x=8 -> 1, x=16 -> 2, ...
@@ -320,6 +331,11 @@ Void initROM()
 
 Void destroyROM()
 {
+  std::lock_guard<std::mutex> lock( g_romMutex );
+  if ( --g_romCount > 0 )
+  {
+    return;
+  }
   for(UInt groupTypeIndex = 0; groupTypeIndex < SCAN_NUMBER_OF_GROUP_TYPES; groupTypeIndex++)
   {
     for (UInt scanOrderIndex = 0; scanOrderIndex < SCAN_NUMBER_OF_TYPES; scanOrderIndex++)
@@ -761,15 +777,6 @@ const Int g_quantInterDefault8x8[8*8] =
 const UInt g_scalingListSize   [SCALING_LIST_SIZE_NUM] = {16,64,256,1024};
 const UInt g_scalingListSizeX  [SCALING_LIST_SIZE_NUM] = { 4, 8, 16,  32};
 
-#if PCC_ME_EXT
-long long g_numPatches[PCC_ME_EXT_MAX_NUM_FRAMES];
-long long g_projectionIndex[PCC_ME_EXT_MAX_NUM_FRAMES][PCC_ME_EXT_MAX_NUM_PATCHES];
-long long g_patch2DInfo[PCC_ME_EXT_MAX_NUM_FRAMES][PCC_ME_EXT_MAX_NUM_PATCHES][4];  // u0, v0, sizeU0, sizeV0
-long long g_patch3DInfo[PCC_ME_EXT_MAX_NUM_FRAMES][PCC_ME_EXT_MAX_NUM_PATCHES][3];  // d1, u1, v1
-
-Bool g_patchesChange[PCC_ME_EXT_MAX_NUM_PATCHES];
-#endif
-
 //! \}
 
 
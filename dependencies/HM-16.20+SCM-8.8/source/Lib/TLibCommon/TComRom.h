@@ -176,14 +176,6 @@ extern const UInt g_scalingListSizeX[SCALING_LIST_SIZE_NUM];
 extern UChar g_ucMsbP1Idx[256];
 extern UChar g_getMsbP1Idx(UInt uiVal);
 
-#if PATCH_BASED_MVP || PCC_ME_EXT
-extern long long g_numPatches[PCC_ME_EXT_MAX_NUM_FRAMES];
-extern long long g_projectionIndex[PCC_ME_EXT_MAX_NUM_FRAMES][PCC_ME_EXT_MAX_NUM_PATCHES];
-extern long long g_patch2DInfo[PCC_ME_EXT_MAX_NUM_FRAMES][PCC_ME_EXT_MAX_NUM_PATCHES][4];  // u0, v0, sizeU0, sizeV0
-extern long long g_patch3DInfo[PCC_ME_EXT_MAX_NUM_FRAMES][PCC_ME_EXT_MAX_NUM_PATCHES][3];  // d1, u1, v1
-extern Bool g_patchesChange[PCC_ME_EXT_MAX_NUM_PATCHES];
-#endif
-
 //! \}
 
 } // namespace pcc_hm
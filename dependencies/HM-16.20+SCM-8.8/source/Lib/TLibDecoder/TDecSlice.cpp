@@ -37,21 +37,79 @@
 
 #include "TDecSlice.h"
 #include "TDecConformance.h"
+#include "TLibCommon/TComPrediction.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 namespace pcc_hm {
 
 //! \ingroup TLibDecoder
 //! \{
 
+/// decoders of one substream: the state the slice decoder otherwise shares through TDecTop
+class TDecSubstreamDecoder
+{
+public:
+  TDecSubstreamDecoder() : m_cuCreated( false ) {}
+  ~TDecSubstreamDecoder() { destroy(); }
+
+  Void destroy()
+  {
+    if ( m_cuCreated )
+    {
+      m_cuDecoder.destroy();
+      m_cuCreated = false;
+    }
+  }
+
+  Void init( const TComSlice* pcSlice, TDecConformanceCheck* pDecConformanceCheck )
+  {
+    const TComSPS* sps = pcSlice->getSPS();
+    m_prediction.initTempBuff( sps->getChromaFormatIdc() );
+    m_trQuant.init( sps->getMaxTrSize() );
+    TDecSlice::setScalingList( &m_trQuant, pcSlice );
+    if ( !m_cuCreated )
+    {
+      m_cuDecoder.create( sps->getMaxTotalCUDepth(), sps->getMaxCUWidth(), sps->getMaxCUHeight(), sps->getChromaFormatIdc(), sps->getSpsScreenExtension().getPaletteMaxSize(), sps->getSpsScreenExtension().getPaletteMaxPredSize() );
+      m_cuCreated = true;
+    }
+#if MCTS_ENC_CHECK
+    m_cuDecoder.init( &m_entropyDecoder, &m_trQuant, &m_prediction, pDecConformanceCheck );
+    m_entropyDecoder.init( &m_prediction, pDecConformanceCheck );
+#else
+    m_cuDecoder.init( &m_entropyDecoder, &m_trQuant, &m_prediction );
+    m_entropyDecoder.init( &m_prediction );
+#endif
+    m_sbacDecoder.init( &m_binCABAC );
+    m_entropyDecoder.setEntropyDecoder( &m_sbacDecoder );
+  }
+
+  TComPrediction m_prediction;
+  TComTrQuant    m_trQuant;
+  TDecCu         m_cuDecoder;
+  TDecEntropy    m_entropyDecoder;
+  TDecSbac       m_sbacDecoder;
+  TDecBinCABAC   m_binCABAC;
+  Bool           m_cuCreated;
+};
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
 
 TDecSlice::TDecSlice()
+: m_numSubstreamThreads( 1 )
 {
 }
 
 TDecSlice::~TDecSlice()
 {
+  for ( size_t i = 0; i < m_substreamDecoders.size(); i++ )
+  {
+    delete m_substreamDecoders[i];
+  }
 }
 
 Void TDecSlice::create()
@@ -60,6 +118,43 @@ Void TDecSlice::create()
 
 Void TDecSlice::destroy()
 {
+  // the CU decoders follow the sizes of the SPS, which may change with the next slice; the rest is kept
+  for ( size_t i = 0; i < m_substreamDecoders.size(); i++ )
+  {
+    m_substreamDecoders[i]->destroy();
+  }
+}
+
+Void TDecSlice::setScalingList( TComTrQuant* pcTrQuant, const TComSlice* pcSlice )
+{
+  if(pcSlice->getSPS()->getScalingListFlag())
+  {
+    TComScalingList scalingList;
+    if(pcSlice->getPPS()->getScalingListPresentFlag())
+    {
+      scalingList = pcSlice->getPPS()->getScalingList();
+    }
+    else if (pcSlice->getSPS()->getScalingListPresentFlag())
+    {
+      scalingList = pcSlice->getSPS()->getScalingList();
+    }
+    else
+    {
+      scalingList.setDefaultScalingList();
+    }
+    pcTrQuant->setScalingListDec(scalingList);
+    pcTrQuant->setUseScalingList(true);
+  }
+  else
+  {
+    const Int maxLog2TrDynamicRange[MAX_NUM_CHANNEL_TYPE] =
+    {
+        pcSlice->getSPS()->getMaxLog2TrDynamicRange(CHANNEL_TYPE_LUMA),
+        pcSlice->getSPS()->getMaxLog2TrDynamicRange(CHANNEL_TYPE_CHROMA)
+    };
+    pcTrQuant->setFlatScalingList(maxLog2TrDynamicRange, pcSlice->getSPS()->getBitDepths());
+    pcTrQuant->setUseScalingList(false);
+  }
 }
 
 Void TDecSlice::init(TDecEntropy* pcEntropyDecoder, TDecCu* pcCuDecoder, TDecConformanceCheck *pDecConformanceCheck)
@@ -81,6 +176,14 @@ Void TDecSlice::decompressSlice(TComInputBitstream** ppcSubstreams, TComPic* pcP
   const Bool depSliceSegmentsEnabled = pcSlice->getPPS()->getDependentSliceSegmentsEnabledFlag();
   const Bool wavefrontsEnabled       = pcSlice->getPPS()->getEntropyCodingSyncEnabledFlag();
 
+  if ( xCanDecompressSubstreams( pcPic ) )
+  {
+    pcPic->setPicYuvPred( 0 );
+    pcPic->setPicYuvResi( 0 );
+    xDecompressSubstreams( ppcSubstreams, pcPic );
+    return;
+  }
+
   m_pcEntropyDecoder->setEntropyDecoder ( pcSbacDecoder  );
   m_pcEntropyDecoder->setBitstream      ( ppcSubstreams[0] );
   m_pcEntropyDecoder->resetEntropy      (pcSlice);
@@ -238,39 +341,7 @@ Void TDecSlice::decompressSlice(TComInputBitstream** ppcSubstreams, TComPic* pcP
 
     if ( pcSlice->getSPS()->getUseSAO() )
     {
-      SAOBlkParam& saoblkParam = (pcPic->getPicSym()->getSAOBlkParam())[ctuRsAddr];
-      Bool bIsSAOSliceEnabled = false;
-      Bool sliceEnabled[MAX_NUM_COMPONENT];
-      for(Int comp=0; comp < MAX_NUM_COMPONENT; comp++)
-      {
-        ComponentID compId=ComponentID(comp);
-        sliceEnabled[compId] = pcSlice->getSaoEnabledFlag(toChannelType(compId)) && (comp < pcPic->getNumberValidComponents());
-        if (sliceEnabled[compId])
-        {
-          bIsSAOSliceEnabled=true;
-        }
-        saoblkParam[compId].modeIdc = SAO_MODE_OFF;
-      }
-      if (bIsSAOSliceEnabled)
-      {
-        Bool leftMergeAvail = false;
-        Bool aboveMergeAvail= false;
-
-        //merge left condition
-        Int rx = (ctuRsAddr % frameWidthInCtus);
-        if(rx > 0)
-        {
-          leftMergeAvail = pcPic->getSAOMergeAvailability(ctuRsAddr, ctuRsAddr-1);
-        }
-        //merge up condition
-        Int ry = (ctuRsAddr / frameWidthInCtus);
-        if(ry > 0)
-        {
-          aboveMergeAvail = pcPic->getSAOMergeAvailability(ctuRsAddr, ctuRsAddr-frameWidthInCtus);
-        }
-
-        pcSbacDecoder->parseSAOBlkParam( saoblkParam, sliceEnabled, leftMergeAvail, aboveMergeAvail, pcSlice->getSPS()->getBitDepths());
-      }
+      xParseSAOBlkParam( pcPic, pcSlice, ctuRsAddr, pcSbacDecoder );
     }
 
     m_pcCuDecoder->decodeCtu     ( pCtu, isLastCtuOfSliceSegment );
@@ -362,6 +433,252 @@ Void TDecSlice::decompressSlice(TComInputBitstream** ppcSubstreams, TComPic* pcP
 }
 
 
+Bool TDecSlice::xCanDecompressSubstreams( TComPic* pcPic ) const
+{
+  TComSlice* pcSlice = pcPic->getSlice(pcPic->getCurrSliceIdx());
+#if ENC_DEC_TRACE || DECODER_PARTIAL_CONFORMANCE_CHECK != 0 || RExt__DECODER_DEBUG_BIT_STATISTICS
+  return false;
+#endif
+  // the palette predictor and the intra block copy reach across the substreams, dependent slice segments start
+  // from the CABAC state of the previous one: these are decoded in order, as are the slices after the first
+  return m_numSubstreamThreads > 1
+      && pcSlice->getNumberOfSubstreamSizes() > 0
+      && pcSlice->getSliceSegmentCurStartCtuTsAddr() == 0
+      && !pcSlice->getDependentSliceSegmentFlag()
+      && !pcSlice->getPPS()->getDependentSliceSegmentsEnabledFlag()
+      && !pcSlice->getSPS()->getSpsScreenExtension().getUsePaletteMode()
+      && !pcSlice->getSPS()->getSpsScreenExtension().getUseIntraBlockCopy()
+      && !pcSlice->getPPS()->getPpsScreenExtension().getUseIntraBlockCopy()
+      && !( m_pDecConformanceCheck && m_pDecConformanceCheck->getTMctsCheck() );
+}
+
+Void TDecSlice::xDecompressSubstreams( TComInputBitstream** ppcSubstreams, TComPic* pcPic )
+{
+  TComSlice* pcSlice                 = pcPic->getSlice(pcPic->getCurrSliceIdx());
+  const TComSPS* sps                 = pcSlice->getSPS();
+  const UInt numCtusInFrame          = pcPic->getNumberOfCtusInFrame();
+  const UInt frameWidthInCtus        = pcPic->getPicSym()->getFrameWidthInCtus();
+  const Bool wavefrontsEnabled       = pcSlice->getPPS()->getEntropyCodingSyncEnabledFlag();
+  const UInt numSubstreams           = pcSlice->getNumberOfSubstreamSizes()+1;
+  const UInt numComponents           = sps->getChromaFormatIdc() == CHROMA_400 ? 1 : 3;
+
+  // without palette mode, every CTU starts from the initial palette predictor of the slice
+  UChar lastPaletteSize[MAX_NUM_COMPONENT] = { 0, 0, 0 };
+  Pel lastPalette[MAX_NUM_COMPONENT][MAX_PALETTE_PRED_SIZE];
+  for(UChar comp=0; comp<MAX_NUM_COMPONENT; comp++)
+  {
+    memset(lastPalette[comp], 0, sizeof(Pel) * sps->getSpsScreenExtension().getPaletteMaxPredSize());
+  }
+  if (pcSlice->getPPS()->getPpsScreenExtension().getUsePalettePredictor())
+  {
+    xSetPredFromPPS(lastPalette, lastPaletteSize, pcSlice->getPPS(), sps);
+  }
+  else if (sps->getSpsScreenExtension().getUsePalettePredictor())
+  {
+    xSetPredFromSPS(lastPalette, lastPaletteSize, sps);
+  }
+  else
+  {
+    xSetPredDefault(lastPalette, lastPaletteSize, sps);
+  }
+
+  // the CTUs of every substream, in tile scan; they are all initialised before any is decoded, so that the
+  // neighbours a substream looks at (slice, tile, availability) are those of the current picture
+  std::vector<UInt> substreamStartCtuTsAddr( numSubstreams + 1, numCtusInFrame );
+  for( UInt ctuTsAddr = 0, substream = 0; ctuTsAddr < numCtusInFrame; ctuTsAddr++ )
+  {
+    const UInt ctuRsAddr = pcPic->getPicSym()->getCtuTsToRsAddrMap(ctuTsAddr);
+    const UInt uiSubStrm = pcPic->getSubstreamForCtuAddr(ctuRsAddr, true, pcSlice);
+    if ( uiSubStrm >= numSubstreams )
+    {
+      break;
+    }
+    for ( ; substream <= uiSubStrm; substream++ )
+    {
+      substreamStartCtuTsAddr[substream] = ctuTsAddr;
+    }
+    TComDataCU* pCtu = pcPic->getCtu( ctuRsAddr );
+    pCtu->initCtu( pcPic, ctuRsAddr );
+    for (UChar comp = 0; comp < numComponents; comp++)
+    {
+      pCtu->setLastPaletteInLcuSizeFinal(comp, lastPaletteSize[comp]);
+      for ( UInt idx = 0; idx < sps->getSpsScreenExtension().getPaletteMaxPredSize(); idx++ )
+      {
+        pCtu->setLastPaletteInLcuFinal(comp, lastPalette[comp][idx], idx);
+      }
+    }
+  }
+
+  const UInt numThreads = std::min<UInt>( m_numSubstreamThreads, numSubstreams );
+  while ( m_substreamDecoders.size() < numThreads )
+  {
+    m_substreamDecoders.push_back( new TDecSubstreamDecoder );
+  }
+  for ( UInt i = 0; i < numThreads; i++ )
+  {
+    m_substreamDecoders[i]->init( pcSlice, m_pDecConformanceCheck );
+  }
+
+  // a wavefront row starts once the row above has decoded the CTU above right: the CABAC state it starts from is
+  // stored after the second CTU of that row
+  std::vector<TDecSbac>   syncContextState( numSubstreams );
+  std::vector<UInt>       numDecodedCtus( numSubstreams, 0 );
+  std::mutex              progressMutex;
+  std::condition_variable progressChanged;
+  std::atomic<UInt>       nextSubstream( 0 );
+  std::atomic<UInt>       lastCtuTsAddr( numCtusInFrame );
+
+  auto decodeSubstreams = [&]( TDecSubstreamDecoder* decoder )
+  {
+    // substreams are taken in order, so the one a wavefront row waits for is always being decoded
+    for ( UInt substream = nextSubstream++; substream < numSubstreams; substream = nextSubstream++ )
+    {
+      const UInt startCtuTsAddr = substreamStartCtuTsAddr[substream];
+      const UInt endCtuTsAddr   = substreamStartCtuTsAddr[substream + 1];
+      Bool isLastCtuOfSliceSegment = false;
+
+      decoder->m_entropyDecoder.setBitstream( ppcSubstreams[substream] );
+      decoder->m_entropyDecoder.resetEntropy( pcSlice );
+
+      for( UInt ctuTsAddr = startCtuTsAddr; !isLastCtuOfSliceSegment && ctuTsAddr < endCtuTsAddr; ctuTsAddr++ )
+      {
+        const UInt ctuRsAddr = pcPic->getPicSym()->getCtuTsToRsAddrMap(ctuTsAddr);
+        const TComTile &currentTile = *(pcPic->getPicSym()->getTComTile(pcPic->getPicSym()->getTileIdxMap(ctuRsAddr)));
+        const UInt firstCtuRsAddrOfTile = currentTile.getFirstCtuRsAddr();
+        const UInt tileXPosInCtus = firstCtuRsAddrOfTile % frameWidthInCtus;
+        const UInt tileYPosInCtus = firstCtuRsAddrOfTile / frameWidthInCtus;
+        const UInt ctuXPosInCtus  = ctuRsAddr % frameWidthInCtus;
+        const UInt ctuYPosInCtus  = ctuRsAddr / frameWidthInCtus;
+        TComDataCU* pCtu = pcPic->getCtu( ctuRsAddr );
+
+        if ( wavefrontsEnabled && ctuYPosInCtus != tileYPosInCtus )
+        {
+          const UInt numCtusAbove = std::min( ctuXPosInCtus - tileXPosInCtus + 2, currentTile.getTileWidthInCtus() );
+          std::unique_lock<std::mutex> lock( progressMutex );
+          progressChanged.wait( lock, [&] { return numDecodedCtus[substream - 1] >= numCtusAbove; } );
+        }
+
+        if ( ctuXPosInCtus == tileXPosInCtus && wavefrontsEnabled && ctuRsAddr != firstCtuRsAddrOfTile )
+        {
+          // Synchronize cabac probabilities with upper-right CTU if it's available and at the start of a line.
+          TComDataCU *pCtuUp = pCtu->getCtuAbove();
+          if ( pCtuUp && ((ctuRsAddr%frameWidthInCtus+1) < frameWidthInCtus)  )
+          {
+            TComDataCU *pCtuTR = pcPic->getCtu( ctuRsAddr - frameWidthInCtus + 1 );
+            if ( pCtu->CUIsFromSameSliceAndTile(pCtuTR) )
+            {
+              decoder->m_sbacDecoder.loadContexts( &syncContextState[substream - 1] );
+            }
+          }
+        }
+
+        if ( sps->getUseSAO() )
+        {
+          xParseSAOBlkParam( pcPic, pcSlice, ctuRsAddr, &decoder->m_sbacDecoder );
+        }
+
+        decoder->m_cuDecoder.decodeCtu     ( pCtu, isLastCtuOfSliceSegment );
+        decoder->m_cuDecoder.decompressCtu ( pCtu );
+
+        //Store probabilities of second CTU in line into buffer
+        if ( ctuXPosInCtus == tileXPosInCtus+1 && wavefrontsEnabled)
+        {
+          syncContextState[substream].loadContexts( &decoder->m_sbacDecoder );
+        }
+
+        if (isLastCtuOfSliceSegment)
+        {
+#if DECODER_CHECK_SUBSTREAM_AND_SLICE_TRAILING_BYTES
+          decoder->m_sbacDecoder.parseRemainingBytes(false);
+#endif
+          lastCtuTsAddr = ctuTsAddr;
+        }
+        else if (  ctuXPosInCtus + 1 == tileXPosInCtus + currentTile.getTileWidthInCtus() &&
+                 ( ctuYPosInCtus + 1 == tileYPosInCtus + currentTile.getTileHeightInCtus() || wavefrontsEnabled)
+                )
+        {
+          // The sub-stream/stream should be terminated after this CTU.
+          // (end of slice-segment, end of tile, end of wavefront-CTU-row)
+          UInt binVal;
+          decoder->m_sbacDecoder.parseTerminatingBit( binVal );
+          assert( binVal );
+#if DECODER_CHECK_SUBSTREAM_AND_SLICE_TRAILING_BYTES
+          decoder->m_sbacDecoder.parseRemainingBytes(true);
+#endif
+        }
+
+        if ( wavefrontsEnabled )
+        {
+          std::lock_guard<std::mutex> lock( progressMutex );
+          numDecodedCtus[substream]++;
+          progressChanged.notify_all();
+        }
+      }
+
+      if ( wavefrontsEnabled )
+      {
+        // a row that ended early (end of slice segment) must not hold the one below
+        std::lock_guard<std::mutex> lock( progressMutex );
+        numDecodedCtus[substream] = numCtusInFrame;
+        progressChanged.notify_all();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for ( UInt i = 1; i < numThreads; i++ )
+  {
+    threads.push_back( std::thread( decodeSubstreams, m_substreamDecoders[i] ) );
+  }
+  decodeSubstreams( m_substreamDecoders[0] );
+  for ( size_t i = 0; i < threads.size(); i++ )
+  {
+    threads[i].join();
+  }
+
+  assert( lastCtuTsAddr < numCtusInFrame );
+  pcSlice->setSliceCurEndCtuTsAddr( lastCtuTsAddr+1 );
+  pcSlice->setSliceSegmentCurEndCtuTsAddr( lastCtuTsAddr+1 );
+}
+
+Void TDecSlice::xParseSAOBlkParam( TComPic* pcPic, const TComSlice* pcSlice, UInt ctuRsAddr, TDecSbac* pcSbacDecoder )
+{
+  const UInt frameWidthInCtus = pcPic->getPicSym()->getFrameWidthInCtus();
+  SAOBlkParam& saoblkParam = (pcPic->getPicSym()->getSAOBlkParam())[ctuRsAddr];
+  Bool bIsSAOSliceEnabled = false;
+  Bool sliceEnabled[MAX_NUM_COMPONENT];
+  for(Int comp=0; comp < MAX_NUM_COMPONENT; comp++)
+  {
+    ComponentID compId=ComponentID(comp);
+    sliceEnabled[compId] = pcSlice->getSaoEnabledFlag(toChannelType(compId)) && (comp < pcPic->getNumberValidComponents());
+    if (sliceEnabled[compId])
+    {
+      bIsSAOSliceEnabled=true;
+    }
+    saoblkParam[compId].modeIdc = SAO_MODE_OFF;
+  }
+  if (bIsSAOSliceEnabled)
+  {
+    Bool leftMergeAvail = false;
+    Bool aboveMergeAvail= false;
+
+    //merge left condition
+    Int rx = (ctuRsAddr % frameWidthInCtus);
+    if(rx > 0)
+    {
+      leftMergeAvail = pcPic->getSAOMergeAvailability(ctuRsAddr, ctuRsAddr-1);
+    }
+    //merge up condition
+    Int ry = (ctuRsAddr / frameWidthInCtus);
+    if(ry > 0)
+    {
+      aboveMergeAvail = pcPic->getSAOMergeAvailability(ctuRsAddr, ctuRsAddr-frameWidthInCtus);
+    }
+
+    pcSbacDecoder->parseSAOBlkParam( saoblkParam, sliceEnabled, leftMergeAvail, aboveMergeAvail, pcSlice->getSPS()->getBitDepths());
+  }
+}
+
 Void TDecSlice::xSetPredFromPPS(Pel lastPalette[MAX_NUM_COMPONENT][MAX_PALETTE_PRED_SIZE], UChar lastPaletteSize[MAX_NUM_COMPONENT], const TComPPS *pcPPS, const TComSPS *pcSPS)
 {
   UInt num = std::min(pcPPS->getPpsScreenExtension().getNumPalettePred(), pcSPS->getSpsScreenExtension().getPaletteMaxPredSize());
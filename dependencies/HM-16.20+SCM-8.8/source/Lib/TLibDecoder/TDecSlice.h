@@ -49,6 +49,7 @@
 #include "TDecCu.h"
 #include "TDecSbac.h"
 #include "TDecBinCoderCABAC.h"
+#include <vector>
 namespace pcc_hm {
 
 //! \ingroup TLibDecoder
@@ -59,6 +60,7 @@ namespace pcc_hm {
 // ====================================================================================================================
 
 class TDecConformanceCheck;
+class TDecSubstreamDecoder;
 
 /// slice decoder class
 class TDecSlice
@@ -78,6 +80,14 @@ private:
   Void xSetPredFromSPS(Pel lastPalette[MAX_NUM_COMPONENT][MAX_PALETTE_PRED_SIZE], UChar lastPaletteSize[MAX_NUM_COMPONENT], const TComSPS *pcSPS);
   Void xSetPredDefault(Pel lastPalette[MAX_NUM_COMPONENT][MAX_PALETTE_PRED_SIZE], UChar lastPaletteSize[MAX_NUM_COMPONENT], const TComSPS *pcSPS);
 
+  // substreams (tiles, wavefront rows) decoded in parallel, each by its own set of CU, entropy and CABAC decoders
+  Int                                m_numSubstreamThreads;
+  std::vector<TDecSubstreamDecoder*> m_substreamDecoders;
+
+  Void xParseSAOBlkParam            ( TComPic* pcPic, const TComSlice* pcSlice, UInt ctuRsAddr, TDecSbac* pcSbacDecoder );
+  Bool xCanDecompressSubstreams     ( TComPic* pcPic ) const;
+  Void xDecompressSubstreams        ( TComInputBitstream** ppcSubstreams, TComPic* pcPic );
+
 public:
   TDecSlice();
   virtual ~TDecSlice();
@@ -87,6 +97,12 @@ public:
   Void  destroy           ();
 
   Void  decompressSlice   ( TComInputBitstream** ppcSubstreams,   TComPic* pcPic, TDecSbac* pcSbacDecoder );
+
+  /// up to numThreads substreams of a slice are decoded at the same time, 1 decodes them in order
+  Void  setNumSubstreamThreads ( Int numThreads ) { m_numSubstreamThreads = numThreads; }
+
+  /// scaling list of the slice, used by the transform of every substream decoder
+  static Void setScalingList ( TComTrQuant* pcTrQuant, const TComSlice* pcSlice );
 };
 
 //! \}
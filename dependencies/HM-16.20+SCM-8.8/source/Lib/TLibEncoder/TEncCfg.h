@@ -101,6 +101,65 @@ struct GOPEntry
 };
 
 std::istringstream &operator>>(std::istringstream &in, GOPEntry &entry);     //input
+
+#if PCC_ME_EXT || PCC_RDO_EXT
+/// patch of a point cloud frame, as in the PatchInfoFile
+struct PCCPatchSideInfo
+{
+  long long projectionIndex;
+  long long u0, v0, sizeU0, sizeV0;  // in 16x16 blocks
+  long long d1, u1, v1;
+};
+
+/// side information of a point cloud frame, coded in PCC_ME_NUM_LAYERS_ACTIVE pictures
+struct PCCFrameSideInfo
+{
+  std::vector<long long>        blockToPatch;  // patch index + 1 of each 16x16 block, 0 if none
+  std::vector<UChar>            occupancy;     // of each occupancyPrecision x occupancyPrecision block
+  std::vector<PCCPatchSideInfo> patches;
+};
+
+/// side information of the PCC motion estimation and RDO, given in memory instead of the BlockToPatchFile,
+/// OccupancyMapFile and PatchInfoFile so that encoders running together keep their own
+struct PCCSideInfo
+{
+  Int                           width;               // luma samples of the frames
+  Int                           height;
+  Int                           occupancyPrecision;  // luma samples per occupancy value in each direction
+  std::vector<PCCFrameSideInfo> frames;
+
+  PCCSideInfo() : width(0), height(0), occupancyPrecision(1) {}
+
+  /// block to patch indices of a frame for a picture of picWidth x picHeight, 0 outside the frame
+  Void getBlockToPatch(Int frame, Int picWidth, Int picHeight, long long* blockToPatch) const
+  {
+    const Int                     stride = width / 16;
+    const std::vector<long long>& src    = frames[frame].blockToPatch;
+    for (Int y = 0; y < picHeight / 16; y++)
+    {
+      for (Int x = 0; x < picWidth / 16; x++)
+      {
+        blockToPatch[y * (picWidth / 16) + x] = x < stride && y < height / 16 ? src[y * stride + x] : 0;
+      }
+    }
+  }
+  /// occupancy of a frame for each luma sample of a picture of picWidth x picHeight, 0 outside the frame
+  Void getOccupancyMap(Int frame, Int picWidth, Int picHeight, Int* occupancyMap) const
+  {
+    const Int                 stride = (width + occupancyPrecision - 1) / occupancyPrecision;
+    const std::vector<UChar>& src    = frames[frame].occupancy;
+    for (Int y = 0; y < picHeight; y++)
+    {
+      for (Int x = 0; x < picWidth; x++)
+      {
+        occupancyMap[y * picWidth + x] =
+          x < width && y < height ? src[(y / occupancyPrecision) * stride + x / occupancyPrecision] : 0;
+      }
+    }
+  }
+};
+#endif
+
 //! \ingroup TLibEncoder
 //! \{
 
@@ -133,16 +192,13 @@ struct TEncSEIKneeFunctionInformation
 
 protected:
 #if PCC_ME_EXT
-	std::string m_blockToPatchFileName;
-	std::string m_occupancyFileName;
 	Bool        m_usePCCExt;
-	//std::string m_patchInfoFileName;
 #endif
 #if PCC_RDO_EXT
   Bool        m_usePCCRDOExt;
 #endif
-#if PCC_RDO_EXT && !PCC_ME_EXT
-  std::string m_occupancyFileName;
+#if PCC_ME_EXT || PCC_RDO_EXT
+  const PCCSideInfo* m_pccSideInfo;
 #endif
   //==== File I/O ========
   Int       m_iFrameRate;
@@ -567,18 +623,15 @@ public:
   {
     m_PCMBitDepth[CHANNEL_TYPE_LUMA]=8;
     m_PCMBitDepth[CHANNEL_TYPE_CHROMA]=8;
+#if PCC_ME_EXT || PCC_RDO_EXT
+    m_pccSideInfo = NULL;
+#endif
   }
 
   virtual ~TEncCfg()
   {}
 
 #if PCC_ME_EXT
-  Void setBlockToPatchFileName(std::string blockToPatchFileName) { m_blockToPatchFileName = blockToPatchFileName; }
-  std::string getBlockToPatchFileName() { return m_blockToPatchFileName; }
-
-  Void setOccupancyMapFileName(std::string occupancyMapFileName) { m_occupancyFileName = occupancyMapFileName; }
-  std::string getOccupancyMapFileName() { return m_occupancyFileName; }
-
   Void setUsePCCExt(Bool value) { m_usePCCExt = value; }
   Bool getUsePCCExt()         const { return m_usePCCExt; }
 #endif
@@ -588,9 +641,9 @@ public:
   Bool getUsePCCRDOExt()      const { return m_usePCCRDOExt; }
 #endif
 
-#if PCC_RDO_EXT && !PCC_ME_EXT
-  Void setOccupancyMapFileName(std::string occupancyMapFileName) { m_occupancyFileName = occupancyMapFileName; }
-  std::string getOccupancyMapFileName() { return m_occupancyFileName; }
+#if PCC_ME_EXT || PCC_RDO_EXT
+  Void setPCCSideInfo(const PCCSideInfo* sideInfo) { m_pccSideInfo = sideInfo; }
+  const PCCSideInfo* getPCCSideInfo() const { return m_pccSideInfo; }
 #endif
 
   Void setProfile(Profile::Name profile) { m_profile = profile; }
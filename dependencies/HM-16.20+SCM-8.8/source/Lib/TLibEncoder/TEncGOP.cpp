@@ -1777,43 +1777,15 @@ Void TEncGOP::compressGOP( Int iPOCLast, Int iNumPicRcvd, TComList<TComPic*>& rc
 			Int picWidth = pcPic->getPicYuvRec()->getWidth(COMPONENT_Y);
 			Int picHeight = pcPic->getPicYuvRec()->getHeight(COMPONENT_Y);
 
-			Int blockToPatchWidth = picWidth / 16;
-			Int blockToPatchHeight = picHeight / 16;
-
 			Int currPOC = pcSlice->getPOC() / PCC_ME_NUM_LAYERS_ACTIVE;
-			long long offset = (long long)currPOC * blockToPatchWidth * blockToPatchHeight;
-
-			std::string blockToPatchFileName = m_pcEncTop->getBlockToPatchFileName();
-			FILE* blockToPatchFile = NULL;
-			blockToPatchFile = fopen(blockToPatchFileName.c_str(), "rb");
-			fseek(blockToPatchFile, offset * sizeof(long long), SEEK_SET);
-			long long* blockToPatch = pcPic->getBlockToPatch();
-			size_t readSize = fread(blockToPatch, sizeof(long long), blockToPatchWidth * blockToPatchHeight, blockToPatchFile);
-			if (readSize != blockToPatchWidth * blockToPatchHeight)
-			{
-				printf("error: Resolution does not match");
-			}
-			fclose(blockToPatchFile);
-
-			offset = (long long)currPOC * picWidth * picHeight;
-			std::string occupancyMapFileName = m_pcEncTop->getOccupancyMapFileName();
-			FILE* occupancyMapFile = NULL;
-			occupancyMapFile = fopen(occupancyMapFileName.c_str(), "rb");
-			fseek(occupancyMapFile, offset * sizeof(Int), SEEK_SET);
-			Int* occupancyMap = pcPic->getOccupancyMap();
-			readSize = fread(occupancyMap, sizeof(Int), picWidth * picHeight, occupancyMapFile);
-			if (readSize != picWidth * picHeight)
+			const PCCSideInfo* sideInfo = m_pcEncTop->getPCCSideInfo();
+			if (sideInfo == NULL || currPOC >= (Int)sideInfo->frames.size())
 			{
-				printf("error: Resolution does not match");
-			}
-			fclose(occupancyMapFile);
-		}
-		if (usePccME)
-		{
-			for (Int i = 0; i < PCC_ME_EXT_MAX_NUM_PATCHES; i++)
-			{
-				g_patchesChange[i] = true;
+				printf("error: no side information for frame %d\n", currPOC);
+				exit(EXIT_FAILURE);
 			}
+			sideInfo->getBlockToPatch(currPOC, picWidth, picHeight, pcPic->getBlockToPatch());
+			sideInfo->getOccupancyMap(currPOC, picWidth, picHeight, pcPic->getOccupancyMap());
 		}
 #endif
 
@@ -1823,18 +1795,14 @@ Void TEncGOP::compressGOP( Int iPOCLast, Int iNumPicRcvd, TComList<TComPic*>& rc
       Int picWidth = pcPic->getPicYuvRec()->getWidth(COMPONENT_Y);
       Int picHeight = pcPic->getPicYuvRec()->getHeight(COMPONENT_Y);
       Int currPOC = pcSlice->getPOC() / 2;           // One occupancy map for every two frames
-      long long offset = (long long)currPOC * picWidth * picHeight;
-      std::string occupancyMapFileName = m_pcEncTop->getOccupancyMapFileName();
-      FILE* occupancyMapFile = NULL;
-      occupancyMapFile = fopen(occupancyMapFileName.c_str(), "rb");
-      fseek(occupancyMapFile, offset * sizeof(Int), SEEK_SET);
-      Int* tempOccupancyMap = new Int[picWidth * picHeight];
-      size_t readSize = fread(tempOccupancyMap, sizeof(Int), picWidth * picHeight, occupancyMapFile);
-      if (readSize != picWidth * picHeight)
+      const PCCSideInfo* sideInfo = m_pcEncTop->getPCCSideInfo();
+      if (sideInfo == NULL || currPOC >= (Int)sideInfo->frames.size())
       {
-        printf("error: Resolution does not match");
+        printf("error: no occupancy map for frame %d\n", currPOC);
+        exit(EXIT_FAILURE);
       }
-      fclose(occupancyMapFile);
+      Int* tempOccupancyMap = new Int[picWidth * picHeight];
+      sideInfo->getOccupancyMap(currPOC, picWidth, picHeight, tempOccupancyMap);
 
       TComPicYuv* occupancyMap = pcPic->getOccupancyMapYuv();
       Pel* lumaAddr = occupancyMap->getAddr(COMPONENT_Y);
@@ -1864,7 +1832,7 @@ Void TEncGOP::compressGOP( Int iPOCLast, Int iNumPicRcvd, TComList<TComPic*>& rc
           crAddr[i * chromaStride + j] = tempOccupancyMap[i * 2 * picWidth + j * 2];
         }
       }
-      delete tempOccupancyMap;
+      delete[] tempOccupancyMap;
       tempOccupancyMap = NULL;
     }
     else
@@ -4467,53 +4467,53 @@ Void TEncSearch::xTZSearch( const TComDataCU* const pcCU,
   
     Int* occupancyMap = pcCU->getPic()->getOccupancyMap();
     long long* blockToPatch = pcCU->getPic()->getBlockToPatch();
+    const std::vector<PCCFrameSideInfo>& frames = m_pcEncCfg->getPCCSideInfo()->frames;
   
-    if (pcCU->getSlice()->getPOC() % 2 == 0 && occupancyMap[yCoor * picWidth + xCoor])
+    Int xBlockIndex = xCoor / occupancyResolution;
+    Int yBlockIndex = yCoor / occupancyResolution;
+    Int patchIndex = blockToPatch[yBlockIndex * blockToPatchWidth + xBlockIndex] - 1;          // should be minus 1
+    Int frameIndex = pcCU->getSlice()->getPOC() / PCC_ME_NUM_LAYERS_ACTIVE;
+    Int refFrameIndex = pcCU->getSlice()->getRefPOC(pcPatternKey->getRefPicList(), pcPatternKey->getRefIndex()) / 2;
+
+    if (pcCU->getSlice()->getPOC() % 2 == 0 && occupancyMap[yCoor * picWidth + xCoor] &&
+        patchIndex >= 0 && patchIndex < (Int)frames[frameIndex].patches.size() && refFrameIndex < (Int)frames.size())
     {
-  	  Int xBlockIndex = xCoor / occupancyResolution;
-  	  Int yBlockIndex = yCoor / occupancyResolution;
-  
-  	  Int patchIndex = blockToPatch[yBlockIndex * blockToPatchWidth + xBlockIndex] - 1;          // should be minus 1
-  	  Int frameIndex = pcCU->getSlice()->getPOC() / PCC_ME_NUM_LAYERS_ACTIVE;
-  
+  	  const PCCPatchSideInfo& patch = frames[frameIndex].patches[patchIndex];
+  	  const std::vector<PCCPatchSideInfo>& refPatches = frames[refFrameIndex].patches;
+
   	  // current 3D coordinate derivation
-  	  Int projectIndex = g_projectionIndex[frameIndex][patchIndex];
+  	  Int projectIndex = patch.projectionIndex;
   
-  	  Int patchD1 = g_patch3DInfo[frameIndex][patchIndex][0];
-  	  Int patchU1 = g_patch3DInfo[frameIndex][patchIndex][1];
-  	  Int patchV1 = g_patch3DInfo[frameIndex][patchIndex][2];
+  	  Int patchD1 = patch.d1;
+  	  Int patchU1 = patch.u1;
+  	  Int patchV1 = patch.v1;
   
-  	  Int patchU0 = g_patch2DInfo[frameIndex][patchIndex][0];
-  	  Int patchV0 = g_patch2DInfo[frameIndex][patchIndex][1];
+  	  Int patchU0 = patch.u0;
+  	  Int patchV0 = patch.v0;
   
   	  Int xCoor3D = patchU1 + (xCoor - patchU0 * occupancyResolution);
   	  Int yCoor3D = patchV1 + (yCoor - patchV0 * occupancyResolution);
   
   
-  	  RefPicList eRefPicList = pcPatternKey->getRefPicList();
-  	  Int refIdx = pcPatternKey->getRefIndex();
-  
   	  // find the suitable patch in the reference frame
-  	  Int refPOC = pcCU->getSlice()->getRefPOC(eRefPicList, refIdx);
-  	  Int refFrameIndex = refPOC / 2;
-  	  Int refNumPatches = g_numPatches[refFrameIndex];
+  	  Int refNumPatches = (Int)refPatches.size();
   
   	  Int bestPatchIndex = 0;
   	  Int bestDist = MAX_INT;
   	  for (Int refPatchIdx = 0; refPatchIdx < refNumPatches; refPatchIdx++)
   	  {
-  	    Int refProjectionIndex = g_projectionIndex[refFrameIndex][refPatchIdx];
+  	    Int refProjectionIndex = refPatches[refPatchIdx].projectionIndex;
   	  
   	    if (refProjectionIndex != projectIndex)
   	    {
   	  	  continue;
   	    }
   	  
-  	    Int refPatchU1 = g_patch3DInfo[refFrameIndex][refPatchIdx][1];
-  	    Int refPatchV1 = g_patch3DInfo[refFrameIndex][refPatchIdx][2];
+  	    Int refPatchU1 = refPatches[refPatchIdx].u1;
+  	    Int refPatchV1 = refPatches[refPatchIdx].v1;
   	  
-  	    Int refPatchSizeU0 = g_patch2DInfo[refFrameIndex][refPatchIdx][2];
-  	    Int refPatchSizeV0 = g_patch2DInfo[refFrameIndex][refPatchIdx][3];
+  	    Int refPatchSizeU0 = refPatches[refPatchIdx].sizeU0;
+  	    Int refPatchSizeV0 = refPatches[refPatchIdx].sizeV0;
 	  
 	    Int refPatch3DEndU1 = refPatchU1 + refPatchSizeU0 * occupancyResolution - 1;
 	    Int refPatch3DEndV1 = refPatchV1 + refPatchSizeV0 * occupancyResolution - 1;
@@ -4523,7 +4523,7 @@ Void TEncSearch::xTZSearch( const TComDataCU* const pcCU,
 	  
 	    if (xCond && yCond)
 	    {
-	  	  Int refPatchD1 = g_patch3DInfo[refFrameIndex][refPatchIdx][0];
+	  	  Int refPatchD1 = refPatches[refPatchIdx].d1;
 	  	  Int patchDist = abs(patchD1 - refPatchD1);
 	  
 	  	  if (patchDist < bestDist)
@@ -4534,11 +4534,11 @@ Void TEncSearch::xTZSearch( const TComDataCU* const pcCU,
 	    }
 	  }
 
-	  Int diff3DU = g_patch3DInfo[frameIndex][patchIndex][1] - g_patch3DInfo[refFrameIndex][bestPatchIndex][1];
-	  Int diff3DV = g_patch3DInfo[frameIndex][patchIndex][2] - g_patch3DInfo[refFrameIndex][bestPatchIndex][2];
+	  Int diff3DU = refNumPatches > 0 ? patch.u1 - refPatches[bestPatchIndex].u1 : 0;
+	  Int diff3DV = refNumPatches > 0 ? patch.v1 - refPatches[bestPatchIndex].v1 : 0;
 
-	  Int diff2DU = (g_patch2DInfo[refFrameIndex][bestPatchIndex][0] - g_patch2DInfo[frameIndex][patchIndex][0]) * occupancyResolution;
-	  Int diff2DV = (g_patch2DInfo[refFrameIndex][bestPatchIndex][1] - g_patch2DInfo[frameIndex][patchIndex][1]) * occupancyResolution;
+	  Int diff2DU = refNumPatches > 0 ? (refPatches[bestPatchIndex].u0 - patch.u0) * occupancyResolution : 0;
+	  Int diff2DV = refNumPatches > 0 ? (refPatches[bestPatchIndex].v0 - patch.v0) * occupancyResolution : 0;
 
 	  Int diffTotalU = diff3DU + diff2DU;
 	  Int diffTotalV = diff3DV + diff2DV;
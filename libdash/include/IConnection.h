@@ -25,6 +25,17 @@ namespace dash
 {
     namespace network
     {
+        /**
+         *  HTTP version used for chunks downloaded by libdash itself (dash::network::IDownloadableChunk::StartDownload())
+         */
+        enum HTTPVersion
+        {
+            HTTP_VERSION_1_1,                   /**< one request per connection at a time */
+            HTTP_VERSION_2,                     /**< HTTP/2 via ALPN on https or Upgrade on http, falls back to HTTP/1.1 */
+            HTTP_VERSION_2_PRIOR_KNOWLEDGE,     /**< cleartext HTTP/2 without Upgrade, the server must speak it */
+            HTTP_VERSION_3                      /**< HTTP/3 over QUIC, https only; HTTP/2 if libcurl is built without it */
+        };
+
         class IConnection : public virtual dash::metrics::IDASHMetrics
         {
             public:
@@ -34,6 +34,50 @@ namespace dash
              *  @return     a pointer to an dash::mpd::IMPD object
              */
             virtual mpd::IMPD* Open (char *path) = 0;
+            /**
+             *  Returns a pointer to dash::mpd::IMPD object representing the information found in an MPD that is already in memory,
+             *  e.g. as downloaded. The buffer is not needed after the call returns.
+             *  @param      data    the MPD document
+             *  @param      length  size of \em data in bytes
+             *  @param      url     the URL the MPD was fetched from, used to resolve relative references
+             *  @return     a pointer to an dash::mpd::IMPD object or NULL if the MPD cannot be parsed
+             */
+            virtual mpd::IMPD* Open (const char *data, size_t length, const std::string &url) = 0;
+
+            /**
+             *  Writes \em mpd as an MPD document, e.g. one a packager built from dash::mpd objects. Reading the file
+             *  with Open gives the same media addressing back.
+             *  @param      mpd     the MPD to write
+             *  @param      path    file to (over)write
+             *  @return     false if the file cannot be written
+             */
+            virtual bool        Write   (const mpd::IMPD *mpd, const std::string &path) = 0;
+
+            /**
+             *  Sets the HTTP version for all chunks that are downloaded internally. With HTTP/2 the requests to one origin,
+             *  the MPD included, are multiplexed over a single connection; with HTTP/3 over a single QUIC connection, one
+             *  stream per request.
+             *  @param      version     a dash::network::HTTPVersion
+             */
+            virtual void        SetHTTPVersion  (network::HTTPVersion version) = 0;
+
+            /**
+             *  Sets how often dash::network::IDownloadObserver::OnDownloadRateChanged() is called for chunks downloaded
+             *  internally: once \em bytes more have arrived or \em milliseconds have passed since the last call, whichever
+             *  comes first. Observers are called on a notifier thread of their own, never on the download thread.
+             *  @param      bytes           default 64 KiB
+             *  @param      milliseconds    default 50
+             */
+            virtual void        SetProgressGranularity  (uint64_t bytes, uint32_t milliseconds) = 0;
+
+            /**
+             *  Returns a new dash::mpd::ISegment for an absolute URL that is not part of an MPD, e.g. the MPD itself.
+             *  The caller owns the segment.
+             *  @param      url     absolute URL
+             *  @param      range   byte range "first-last" or an empty string
+             *  @return     a pointer to a dash::mpd::ISegment object or NULL if the URL cannot be parsed
+             */
+            virtual mpd::ISegment*  CreateChunk (const std::string &url, const std::string &range) = 0;
 
             /**
              *  Frees allocated memory and deletes the DashManager
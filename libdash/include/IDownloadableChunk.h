@@ -50,6 +50,14 @@ namespace dash
                  */
                 virtual void    AbortDownload           ()                              = 0;
 
+                /**
+                 *  Waits until the download of this chunk has ended. Read can reach the end of the data a little before,
+                 *  so this is what tells a complete chunk from one that was cut short.
+                 *  @return     dash::network::COMPLETED if the whole response was received, dash::network::ABORTED if the
+                 *              download was aborted or failed, dash::network::NOT_STARTED if it was never started
+                 */
+                virtual DownloadState   WaitForDownload ()                              = 0;
+
                 /**
                  *  Reads
                  *  @param      data    pointer to a block of memory
@@ -86,6 +94,13 @@ namespace dash
                  *  @param      observer    a dash::network::IDownloadObserver
                  */
                 virtual void    DetachDownloadObserver  (IDownloadObserver *observer)   = 0;
+
+                /**
+                 *  Sets the HTTP/2 stream weight of this chunk, 1 to 256. Streams sharing a connection get bandwidth in
+                 *  proportion to their weight. Has to be set before the download is started.
+                 *  @param      weight  the stream weight, 16 by default
+                 */
+                virtual void    Priority                (uint32_t weight)               = 0;
         };
     }
 }
@@ -49,6 +49,13 @@ namespace dash
                 virtual uint64_t                                        Interval                () const = 0;
                 virtual const std::vector<IThroughputMeasurement *>&    ThroughputTrace         () const = 0;
                 virtual const std::string&                              HTTPHeader              () const = 0;
+
+                /* not part of annex D: when the last byte of the body arrived */
+                virtual const std::string&                              ResponseFinishedTime    () const = 0;
+                /* the three instants in ms since the epoch, 0 if not (yet) known */
+                virtual uint64_t                                        RequestSentTimeMs       () const = 0;
+                virtual uint64_t                                        ResponseReceivedTimeMs  () const = 0;
+                virtual uint64_t                                        ResponseFinishedTimeMs  () const = 0;
         };
     }
 }
@@ -43,6 +43,35 @@ namespace dash
                  */
                 virtual const std::vector<ISegmentURL *>&   GetSegmentURLs  ()  const = 0;
 
+                /**
+                 *  Returns the number of <tt><b>SegmentURL</b></tt> elements in this SegmentList.\n
+                 *  Together with GetSegmentMediaURI() and GetSegmentMediaRange() this walks a long list without creating
+                 *  the dash::mpd::ISegmentURL objects that GetSegmentURLs() needs.
+                 *  @return     the number of segments
+                 */
+                virtual size_t                              GetSegmentURLCount  ()  const = 0;
+
+                /**
+                 *  Returns a pointer to the dash::mpd::ISegmentURL object at \em index, creating only this one if it does not exist yet.
+                 *  @param      index   zero-based, below GetSegmentURLCount()
+                 *  @return     a pointer to a dash::mpd::ISegmentURL object, owned by this SegmentList
+                 */
+                virtual ISegmentURL*                        GetSegmentURL       (size_t index)  const = 0;
+
+                /**
+                 *  Returns the \c \@media attribute of the <tt><b>SegmentURL</b></tt> at \em index, see dash::mpd::ISegmentURL::GetMediaURI().
+                 *  @param      index   zero-based, below GetSegmentURLCount()
+                 *  @return     a string, empty if not present
+                 */
+                virtual std::string                         GetSegmentMediaURI  (size_t index)  const = 0;
+
+                /**
+                 *  Returns the \c \@mediaRange attribute of the <tt><b>SegmentURL</b></tt> at \em index, see dash::mpd::ISegmentURL::GetMediaRange().
+                 *  @param      index   zero-based, below GetSegmentURLCount()
+                 *  @return     a string, empty if not present
+                 */
+                virtual std::string                         GetSegmentMediaRange(size_t index)  const = 0;
+
                 /**
                  *  Returns a reference to a string that specifies a reference to an external <tt><b>SegmentList</b></tt> element.
                  *  @return     a reference to a string
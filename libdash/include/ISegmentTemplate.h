@@ -141,6 +141,17 @@ namespace dash
                  *  @return     a pointer to a dash::mpd::ISegment object
                  */
                 virtual ISegment*           GetIndexSegmentFromTime     (const std::vector<IBaseUrl *>& baseurls, const std::string& representationID, uint32_t bandwidth, uint32_t time) const = 0;
+
+                /**
+                 *  Returns the Media Segment URI with all identifiers of the Media template replaced, without applying any BaseURL.
+                 *  Unlike GetMediaSegmentFromTime() the time is 64 bit, as needed for live presentations with a fine timescale.
+                 *  @param      representationID    a string containing the representation ID that will replace the identifier \em \$RepresentationID\$
+                 *  @param      bandwidth           an integer that will replace the identifier \em \$Bandwidth\$
+                 *  @param      number              an integer that will replace the identifier \em \$Number\$
+                 *  @param      time                an integer that will replace the identifier \em \$Time\$
+                 *  @return     a string containing the URI, relative unless the template is absolute
+                 */
+                virtual std::string         GetMediaURI                 (const std::string& representationID, uint32_t bandwidth, uint32_t number, uint64_t time) const = 0;
         };
     }
 }
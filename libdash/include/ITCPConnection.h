@@ -33,6 +33,13 @@ namespace dash
                 virtual const std::string&  ConnectionClosedTime    () const = 0;
                 virtual uint64_t            ConnectionTime          () const = 0;
 
+                /* the kernel's last view of the connection (Linux TCP_INFO), 0 if it was never sampled */
+                virtual uint32_t            RTT                     () const = 0;   /* smoothed, microseconds */
+                virtual uint32_t            RTTVariance             () const = 0;   /* microseconds */
+                virtual uint32_t            CongestionWindow        () const = 0;   /* segments */
+                virtual uint32_t            Retransmits             () const = 0;   /* over the connection's lifetime */
+                virtual uint64_t            DeliveryRate            () const = 0;   /* bits per second */
+
         };
     }
 }
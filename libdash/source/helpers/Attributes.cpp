@@ -0,0 +1,65 @@
+/*
+ * Attributes.cpp
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#include "Attributes.h"
+
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+
+using namespace dash::helpers;
+
+const std::string*                  Attributes::Intern  (const char *name)
+{
+    /* MPDs may be parsed on several threads at once */
+    static std::mutex                       mutex;
+    static std::unordered_set<std::string>  *names = new std::unordered_set<std::string>();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    /* element of an unordered_set never move, rehashing included */
+    return &*names->insert(name).first;
+}
+const Attribute*                    Attributes::Find    (const AttributeList &list, const char *name)
+{
+    for(size_t i = 0; i < list.size(); i++)
+        if(strcmp(list[i].name->c_str(), name) == 0)
+            return &list[i];
+
+    return NULL;
+}
+void                                Attributes::Set     (AttributeList &list, const char *name, const char *value)
+{
+    for(size_t i = 0; i < list.size(); i++)
+    {
+        if(strcmp(list[i].name->c_str(), name) == 0)
+        {
+            list[i].value = value;
+            return;
+        }
+    }
+
+    Attribute attribute;
+
+    attribute.name  = Intern(name);
+    attribute.value = value;
+    list.push_back(std::move(attribute));
+}
+std::map<std::string, std::string>  Attributes::ToMap   (const AttributeList &list)
+{
+    std::map<std::string, std::string> map;
+
+    for(size_t i = 0; i < list.size(); i++)
+        map[*list[i].name] = list[i].value;
+
+    return map;
+}
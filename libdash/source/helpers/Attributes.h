@@ -0,0 +1,44 @@
+/*
+ * Attributes.h
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#ifndef ATTRIBUTES_H_
+#define ATTRIBUTES_H_
+
+#include "config.h"
+
+namespace dash
+{
+    namespace helpers
+    {
+        /* an XML attribute; its name is interned, one string per distinct name for the process */
+        struct Attribute
+        {
+            const std::string   *name;
+            std::string         value;
+        };
+
+        /* in document order; an element has a handful, a flat scan beats a map */
+        typedef std::vector<Attribute> AttributeList;
+
+        class Attributes
+        {
+            public:
+                /* never freed, names come from the fixed MPD schema and its extensions */
+                static const std::string*   Intern  (const char *name);
+                /* NULL if absent */
+                static const Attribute*     Find    (const AttributeList &list, const char *name);
+                static void                 Set     (AttributeList &list, const char *name, const char *value);
+                static std::map<std::string, std::string>   ToMap   (const AttributeList &list);
+        };
+    }
+}
+
+#endif /* ATTRIBUTES_H_ */
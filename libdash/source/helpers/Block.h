@@ -14,33 +14,81 @@
 
 #include "config.h"
 
+#include "BlockPool.h"
+
 namespace dash
 {
     namespace helpers
     {
         struct block_t
         {
-            uint8_t *data;
-            size_t  len;
+            uint8_t *data;      /* first unread byte */
+            size_t  len;        /* unread bytes from data on */
             float   millisec;
             size_t  offset;
+            uint8_t *buffer;    /* start of the allocation, data only moves forward */
+            size_t  capacity;
+            bool    pooled;     /* buffer belongs to the BlockPool */
         };
 
         static inline block_t*  AllocBlock      (size_t len)
         {
             block_t *block  = (block_t *)malloc(sizeof(block_t));
-            block->data     = new uint8_t[len];
+            block->buffer   = new uint8_t[len];
+            block->data     = block->buffer;
             block->len      = len;
             block->millisec = 0;
             block->offset   = 0;
+            block->capacity = len;
+            block->pooled   = false;
       
             return block;
         }
+        /* empty block of BLOCKPOOL_BLOCK_SIZE capacity, filled with AppendToBlock */
+        static inline block_t*  AllocPooledBlock()
+        {
+            block_t *block  = (block_t *)malloc(sizeof(block_t));
+            block->buffer   = BlockPool::Instance()->Acquire();
+            block->data     = block->buffer;
+            block->len      = 0;
+            block->millisec = 0;
+            block->offset   = 0;
+            block->capacity = BLOCKPOOL_BLOCK_SIZE;
+            block->pooled   = true;
+
+            return block;
+        }
+        static inline size_t    BlockSpace      (const block_t *block)
+        {
+            return block->capacity - (block->data - block->buffer) - block->len;
+        }
+        /* copies as much as fits behind the block's data, returns the count */
+        static inline size_t    AppendToBlock   (block_t *block, const uint8_t *data, size_t len)
+        {
+            size_t space = BlockSpace(block);
+
+            if(len > space)
+                len = space;
+
+            memcpy(block->data + block->len, data, len);
+            block->len += len;
+
+            return len;
+        }
+        /* drops len bytes from the front without reallocating */
+        static inline void      ConsumeBlock    (block_t *block, size_t len)
+        {
+            block->data += len;
+            block->len  -= len;
+        }
         static inline void      DeleteBlock     (block_t *block)
         {
             if(block)
             {
-                delete [] block->data;
+                if(block->pooled)
+                    BlockPool::Instance()->Release(block->buffer);
+                else
+                    delete [] block->buffer;
                 free(block);
                 block = NULL;
             }
@@ -52,7 +100,7 @@ namespace dash
 
             memcpy(ret->data, block->data, ret->len);
 
-            return block;
+            return ret;
         }
     }
 }
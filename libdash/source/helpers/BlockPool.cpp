@@ -0,0 +1,63 @@
+/*
+ * BlockPool.cpp
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#include "BlockPool.h"
+
+using namespace dash::helpers;
+
+BlockPool*  BlockPool::Instance     ()
+{
+    /* never destroyed: blocks may still be released during static teardown */
+    static BlockPool *pool = new BlockPool();
+    return pool;
+}
+
+BlockPool::BlockPool    ()
+{
+    InitializeCriticalSection(&this->monitorMutex);
+}
+BlockPool::~BlockPool   ()
+{
+    for (size_t i = 0; i < this->freeList.size(); i++)
+        delete [] this->freeList.at(i);
+
+    DeleteCriticalSection(&this->monitorMutex);
+}
+
+uint8_t*    BlockPool::Acquire      ()
+{
+    uint8_t *buffer = NULL;
+
+    EnterCriticalSection(&this->monitorMutex);
+    if (!this->freeList.empty())
+    {
+        buffer = this->freeList.back();
+        this->freeList.pop_back();
+    }
+    LeaveCriticalSection(&this->monitorMutex);
+
+    if (buffer == NULL)
+        buffer = new uint8_t[BLOCKPOOL_BLOCK_SIZE];
+
+    return buffer;
+}
+void        BlockPool::Release      (uint8_t *buffer)
+{
+    EnterCriticalSection(&this->monitorMutex);
+    if (this->freeList.size() < BLOCKPOOL_MAX_FREE)
+    {
+        this->freeList.push_back(buffer);
+        buffer = NULL;
+    }
+    LeaveCriticalSection(&this->monitorMutex);
+
+    delete [] buffer;
+}
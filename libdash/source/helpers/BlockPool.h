@@ -0,0 +1,48 @@
+/*
+ * BlockPool.h
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#ifndef __BLOCKPOOL_H__
+#define __BLOCKPOOL_H__
+
+#include "config.h"
+
+#include "../portable/MultiThreading.h"
+
+#define BLOCKPOOL_BLOCK_SIZE    32768
+#define BLOCKPOOL_MAX_FREE      512     /* 16 MB kept around at most */
+
+namespace dash
+{
+    namespace helpers
+    {
+        /*
+         * Free list of fixed-size buffers shared by all block streams, so
+         * download callbacks do not malloc/free per received packet.
+         */
+        class BlockPool
+        {
+            public:
+                static BlockPool*   Instance    ();
+
+                uint8_t*    Acquire     ();
+                void        Release     (uint8_t *buffer);
+
+            private:
+                BlockPool           ();
+                virtual ~BlockPool  ();
+
+                CRITICAL_SECTION        monitorMutex;
+                std::vector<uint8_t *>  freeList;
+        };
+    }
+}
+
+#endif // __BLOCKPOOL_H__
@@ -10,12 +10,14 @@
  *****************************************************************************/
 
 #include "BlockStream.h"
+#include <algorithm>
 #include <limits>
 
 using namespace dash::helpers;
 
 BlockStream::BlockStream    () :
-             length         (0)
+             length         (0),
+             consumed       (0)
 {
 }
 BlockStream::~BlockStream   ()
@@ -30,16 +32,52 @@ void            BlockStream::PopAndDeleteFront      ()
 
     this->length -= this->blockqueue.front()->len;
     DeleteBlock(this->blockqueue.front());
-    this->blockqueue.pop_front();
+    this->BlockQueuePopFront();
 }
 void            BlockStream::PushBack               (block_t *block)
 {
     this->length += block->len;
     this->blockqueue.push_back(block);
+    this->blockends.push_back(this->consumed + this->length);
+}
+void            BlockStream::Append                 (const uint8_t *data, size_t len)
+{
+    /* fill the spare room of the last pooled block first */
+    if(!this->blockqueue.empty() && this->blockqueue.back()->pooled)
+    {
+        size_t appended = AppendToBlock(this->blockqueue.back(), data, len);
+
+        data         += appended;
+        len          -= appended;
+        this->length += appended;
+        this->blockends.back() += appended;
+    }
+
+    while(len > 0)
+    {
+        block_t *block    = AllocPooledBlock();
+        size_t  appended  = AppendToBlock(block, data, len);
+
+        data         += appended;
+        len          -= appended;
+        this->length += appended;
+        this->blockqueue.push_back(block);
+        this->blockends.push_back(this->consumed + this->length);
+    }
 }
 void            BlockStream::PushFront              (block_t *block)
 {
-    this->length += block->len;
+    /* positions before the start of the stream: count everything from the new front */
+    if(this->consumed < block->len)
+    {
+        for(size_t i = 0; i < this->blockends.size(); i++)
+            this->blockends.at(i) += block->len - this->consumed;
+        this->consumed = block->len;
+    }
+
+    this->blockends.push_front(this->consumed);
+    this->consumed -= block->len;
+    this->length   += block->len;
     this->blockqueue.push_front(block);
 }
 const block_t*  BlockStream::GetBytes               (uint32_t len)
@@ -83,6 +121,9 @@ size_t          BlockStream::PeekBytes              (uint8_t *data, size_t len,
     if(len > this->length)
         len = (size_t) this->length;
 
+    if(offset >= this->length)
+        return 0;
+
     if (offset + len > this->length)
         len = (size_t) (this->length - offset);
 
@@ -101,7 +142,7 @@ const block_t*  BlockStream::GetFront               ()
 
     const block_t* ret = this->blockqueue.front();
     this->length -= ret->len;
-    this->blockqueue.pop_front();
+    this->BlockQueuePopFront();
 
     return ret;
 }
@@ -123,15 +164,10 @@ bool            BlockStream::BlockQueueGetBytes     (uint8_t *data, uint32_t len
         block = this->blockqueue.front();
         if((len - pos) < (block->len))
         {
+            /* partial block: advance in place instead of copying the rest */
             memcpy(data + pos, block->data, len - pos);
-
-            this->blockqueue.pop_front();
-
-            block_t* newfront = AllocBlock(block->len - (len - pos));
-            memcpy(newfront->data, block->data + (len - pos), newfront->len);
-
-            DeleteBlock(block);
-            this->blockqueue.push_front(newfront);
+            ConsumeBlock(block, len - pos);
+            this->consumed += len - pos;
 
             return true;
         }
@@ -141,7 +177,7 @@ bool            BlockStream::BlockQueueGetBytes     (uint8_t *data, uint32_t len
             pos += block->len;
 
             DeleteBlock(block);
-            this->blockqueue.pop_front();
+            this->BlockQueuePopFront();
         }
     }
 
@@ -149,48 +185,70 @@ bool            BlockStream::BlockQueueGetBytes     (uint8_t *data, uint32_t len
 }
 bool            BlockStream::BlockQueuePeekBytes    (uint8_t *data, uint32_t len, size_t offset)
 {
+    if(len == 0)
+        return true;
+
+    if(offset >= this->length)
+        return false;
+
     uint32_t pos = 0;
-    int      cnt = 0;
+    size_t   cnt = this->BlockQueueIndex(offset);
 
     const block_t *block = NULL;
 
-    while(pos < len)
+    /* offset within the first block copied from */
+    offset = (size_t) (this->consumed + offset - (cnt == 0 ? this->consumed : this->blockends.at(cnt - 1)));
+
+    while(pos < len && cnt < this->blockqueue.size())
     {
         block = this->blockqueue.at(cnt);
-        if((offset + len - pos) < (block->len))
-        {
-            memcpy(data + pos, block->data + offset, len - pos - offset);
-            return true;
-        }
-        else
-        {
-            memcpy(data + pos, block->data + offset, block->len - offset);
-            pos += block->len;
-        }
+
+        size_t size = block->len - offset;
+        if(size > len - pos)
+            size = len - pos;
+
+        memcpy(data + pos, block->data + offset, size);
+        pos    += size;
+        offset  = 0;
 
         cnt++;
     }
 
-    return false;
+    return pos == len;
 }
 uint8_t         BlockStream::ByteAt                 (uint64_t position) const
 {
-    if(position > this->length)
+    const uint8_t *data;
+
+    if(this->SpanAt(position, &data) == 0)
         return -1;
 
-    uint64_t pos = 0;
+    return *data;
+}
+size_t          BlockStream::SpanAt                 (uint64_t position, const uint8_t **data) const
+{
+    if(position >= this->length)
+        return 0;
 
-    for(size_t i = 0; i < this->blockqueue.size(); i++)
-    {
-        const block_t *block = this->blockqueue.at(i);
+    size_t   index = this->BlockQueueIndex(position);
+    uint64_t start = index == 0 ? this->consumed : this->blockends.at(index - 1);
+    uint64_t skip  = this->consumed + position - start;
 
-        if(pos + block->len > position)
-            return block->data[position - pos];
-        else
-            pos += block->len;
-    }
+    *data = this->blockqueue.at(index)->data + skip;
 
-    return -1;
+    return (size_t) (this->blockends.at(index) - start - skip);
+}
+size_t          BlockStream::BlockQueueIndex        (uint64_t position) const
+{
+    /* the first block ending after position */
+    return std::upper_bound(this->blockends.begin(), this->blockends.end(), this->consumed + position) -
+           this->blockends.begin();
+}
+void            BlockStream::BlockQueuePopFront     ()
+{
+    this->consumed = this->blockends.front();
+    this->blockqueue.pop_front();
+    this->blockends.pop_front();
 }
 const block_t*  BlockStream::ToBlock                ()
 {
@@ -207,7 +265,9 @@ void            BlockStream::Clear                  ()
         this->blockqueue.pop_front();
     }
 
-    this->length = 0;
+    this->blockends.clear();
+    this->length   = 0;
+    this->consumed = 0;
 }
 void            BlockStream::EraseFront             (uint64_t len)
 {
@@ -229,20 +289,16 @@ void            BlockStream::EraseFront             (uint64_t len)
             actLen          += front->len;
 
             DeleteBlock(front);
-            this->blockqueue.pop_front();
+            this->BlockQueuePopFront();
         }
         else
         {
             uint32_t diff       = (uint32_t) (len - actLen);
             this->length       -= diff;
+            this->consumed     += diff;
             actLen             += diff;
-            block_t* newfront   = AllocBlock(front->len - diff);
-
-            memcpy(newfront->data, front->data + diff, newfront->len);
 
-            DeleteBlock(front);
-            this->blockqueue.pop_front();
-            this->blockqueue.push_front(newfront);
+            ConsumeBlock(front, diff);
         }
     }
 }
@@ -265,7 +321,7 @@ BlockStream*    BlockStream::GetBlocks              (uint64_t len)
             actLen          += front->len;
 
             blocks->PushBack(front);
-            this->blockqueue.pop_front();
+            this->BlockQueuePopFront();
         }
         else
         {
@@ -273,16 +329,12 @@ BlockStream*    BlockStream::GetBlocks              (uint64_t len)
             this->length       -= diff;
             actLen             += diff;
             block_t *block      = AllocBlock(diff);
-            block_t* newfront   = AllocBlock(front->len - diff);
 
             memcpy(block->data, front->data, diff);
             blocks->PushBack(block);
 
-            memcpy(newfront->data, front->data+ diff, newfront->len);
-
-            DeleteBlock(front);
-            this->blockqueue.pop_front();
-            this->blockqueue.push_front(newfront);
+            ConsumeBlock(front, diff);
+            this->consumed     += diff;
         }
     }
 
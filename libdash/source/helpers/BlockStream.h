@@ -27,6 +27,8 @@ namespace dash
                 virtual ~BlockStream ();
 
                 virtual void            PushBack            (block_t *block);
+                /* copies into pooled blocks, no allocation per call */
+                virtual void            Append              (const uint8_t *data, size_t len);
                 virtual void            PushFront           (block_t *block);
                 virtual const block_t*  GetBytes            (uint32_t len);
                 virtual size_t          GetBytes            (uint8_t *data, size_t len);
@@ -36,6 +38,10 @@ namespace dash
                 virtual const block_t*  Front               ()                  const;
                 virtual uint64_t        Length              ()                  const;
                 virtual uint8_t         ByteAt              (uint64_t position) const;
+                /* the bytes from position to the end of its block, without a copy: *data points
+                 * into the block and stays valid until the front is consumed past it; 0 if
+                 * position is past the end */
+                virtual size_t          SpanAt              (uint64_t position, const uint8_t **data) const;
                 virtual const block_t*  ToBlock             ();
                 virtual void            Clear               ();
                 virtual void            EraseFront          (uint64_t len);
@@ -45,9 +51,18 @@ namespace dash
             protected:
                 uint64_t                length;
                 std::deque<block_t *>   blockqueue;
+                /* where each block of blockqueue ends, counted in bytes of the whole stream
+                 * from its start; consumed is where the front block's first unread byte is.
+                 * A position is found by binary search instead of summing the blocks */
+                std::deque<uint64_t>    blockends;
+                uint64_t                consumed;
 
                 virtual bool BlockQueueGetBytes     (uint8_t *data, uint32_t len);
                 virtual bool BlockQueuePeekBytes    (uint8_t *data, uint32_t len, size_t offset);
+                /* index of the block holding position, which is below length */
+                size_t       BlockQueueIndex        (uint64_t position) const;
+                /* the front block was consumed up to its end */
+                void         BlockQueuePopFront     ();
         };
     }
 }
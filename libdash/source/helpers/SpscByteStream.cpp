@@ -0,0 +1,197 @@
+/*
+ * SpscByteStream.cpp
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#include "SpscByteStream.h"
+
+#include <string.h>
+
+using namespace dash::helpers;
+
+SpscByteStream::SpscByteStream      () :
+                headPos             (0),
+                consumed            (0),
+                tailPos             (0),
+                produced            (0),
+                eos                 (false),
+                sequence            (0),
+                waiters             (0)
+{
+    this->head = this->NewSegment();
+    this->tail = this->head;
+}
+SpscByteStream::~SpscByteStream     ()
+{
+    while(this->head)
+    {
+        segment_t *next = this->head->next.load(std::memory_order_relaxed);
+
+        BlockPool::Instance()->Release(this->head->buffer);
+        delete this->head;
+
+        this->head = next;
+    }
+}
+
+void            SpscByteStream::Append      (const uint8_t *data, size_t len)
+{
+    while(len > 0)
+    {
+        if(this->tailPos == BLOCKPOOL_BLOCK_SIZE)
+        {
+            segment_t *segment = this->NewSegment();
+
+            this->tail->next.store(segment, std::memory_order_release);
+            this->tail    = segment;
+            this->tailPos = 0;
+        }
+
+        size_t size = BLOCKPOOL_BLOCK_SIZE - this->tailPos;
+        if(size > len)
+            size = len;
+
+        memcpy(this->tail->buffer + this->tailPos, data, size);
+
+        this->tailPos += size;
+        data          += size;
+        len           -= size;
+
+        this->produced.fetch_add(size, std::memory_order_release);
+    }
+
+    this->Publish();
+}
+void            SpscByteStream::SetEOS      (bool value)
+{
+    this->eos.store(value, std::memory_order_release);
+    this->Publish();
+}
+size_t          SpscByteStream::GetBytes    (uint8_t *data, size_t len)
+{
+    if(len == 0)
+        return 0;
+
+    uint64_t available = this->WaitFor(0);
+
+    return this->Copy(data, len < available ? len : (size_t) available, 0, true);
+}
+size_t          SpscByteStream::PeekBytes   (uint8_t *data, size_t len)
+{
+    return this->PeekBytes(data, len, 0);
+}
+size_t          SpscByteStream::PeekBytes   (uint8_t *data, size_t len, size_t offset)
+{
+    if(len == 0)
+        return 0;
+
+    uint64_t available = this->WaitFor(offset);
+
+    if(available <= offset)
+        return 0;
+
+    available -= offset;
+
+    return this->Copy(data, len < available ? len : (size_t) available, offset, false);
+}
+uint64_t        SpscByteStream::Length      () const
+{
+    return this->produced.load(std::memory_order_acquire) - this->consumed;
+}
+SpscByteStream::segment_t*  SpscByteStream::NewSegment  ()
+{
+    segment_t *segment = new segment_t;
+
+    segment->buffer = BlockPool::Instance()->Acquire();
+    segment->next.store(NULL, std::memory_order_relaxed);
+
+    return segment;
+}
+void            SpscByteStream::Publish     ()
+{
+    this->sequence.fetch_add(1, std::memory_order_seq_cst);
+
+    /* pairs with the seq_cst increment in WaitFor: either the reader sees
+     * the new sequence or we see the reader */
+    if(this->waiters.load(std::memory_order_seq_cst) > 0)
+        WakeAllOnValuePortable((volatile uint32_t *) &this->sequence);
+}
+uint64_t        SpscByteStream::WaitFor     (uint64_t needed)
+{
+    for(;;)
+    {
+        uint32_t seq       = this->sequence.load(std::memory_order_seq_cst);
+        uint64_t available = this->Length();
+
+        if(available > needed || this->eos.load(std::memory_order_acquire))
+            return this->Length();
+
+        this->waiters.fetch_add(1, std::memory_order_seq_cst);
+
+        if(this->sequence.load(std::memory_order_seq_cst) == seq)
+            WaitOnValuePortable((volatile uint32_t *) &this->sequence, seq);
+
+        this->waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+size_t          SpscByteStream::Copy        (uint8_t *data, size_t len, size_t offset, bool consume)
+{
+    segment_t   *segment = this->head;
+    size_t      pos      = this->headPos + offset;
+    size_t      done     = 0;
+
+    /* every segment but the writer's current one is full, so offsets map
+     * onto the list without looking at the writer's state */
+    while(pos >= BLOCKPOOL_BLOCK_SIZE)
+    {
+        segment = segment->next.load(std::memory_order_relaxed);
+        pos    -= BLOCKPOOL_BLOCK_SIZE;
+    }
+
+    while(done < len)
+    {
+        if(pos == BLOCKPOOL_BLOCK_SIZE)
+        {
+            segment = segment->next.load(std::memory_order_relaxed);
+            pos     = 0;
+        }
+
+        size_t size = BLOCKPOOL_BLOCK_SIZE - pos;
+        if(size > len - done)
+            size = len - done;
+
+        memcpy(data + done, segment->buffer + pos, size);
+
+        pos  += size;
+        done += size;
+    }
+
+    if(!consume)
+        return done;
+
+    this->consumed += done;
+    this->headPos  += done;
+
+    /* a drained segment can only go once the writer has moved past it */
+    while(this->headPos >= BLOCKPOOL_BLOCK_SIZE)
+    {
+        segment_t *next = this->head->next.load(std::memory_order_acquire);
+
+        if(next == NULL)
+            break;
+
+        BlockPool::Instance()->Release(this->head->buffer);
+        delete this->head;
+
+        this->head     = next;
+        this->headPos -= BLOCKPOOL_BLOCK_SIZE;
+    }
+
+    return done;
+}
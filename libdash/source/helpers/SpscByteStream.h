@@ -0,0 +1,79 @@
+/*
+ * SpscByteStream.h
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#ifndef __SPSCBYTESTREAM_H__
+#define __SPSCBYTESTREAM_H__
+
+#include "config.h"
+
+#include <atomic>
+
+#include "BlockPool.h"
+#include "../portable/MultiThreading.h"
+
+namespace dash
+{
+    namespace helpers
+    {
+        /*
+         * Byte stream for exactly one writer (the download) and one reader
+         * (the consumer of the chunk). Data lives in a linked list of pool
+         * buffers; the writer publishes bytes by advancing an atomic counter
+         * and the reader only sleeps, on a futex, when the stream is empty.
+         * Neither side ever takes a lock.
+         */
+        class SpscByteStream
+        {
+            public:
+                SpscByteStream          ();
+                virtual ~SpscByteStream ();
+
+                /* writer side */
+                void        Append      (const uint8_t *data, size_t len);
+                void        SetEOS      (bool value);
+
+                /* reader side, blocking until data is there or EOS */
+                size_t      GetBytes    (uint8_t *data, size_t len);
+                size_t      PeekBytes   (uint8_t *data, size_t len);
+                size_t      PeekBytes   (uint8_t *data, size_t len, size_t offset);
+                uint64_t    Length      () const;
+
+            private:
+                struct segment_t
+                {
+                    uint8_t                     *buffer;
+                    std::atomic<segment_t *>    next;
+                };
+
+                /* owned by the reader */
+                segment_t               *head;
+                size_t                  headPos;
+                uint64_t                consumed;
+
+                /* owned by the writer */
+                segment_t               *tail;
+                size_t                  tailPos;
+
+                std::atomic<uint64_t>   produced;
+                std::atomic<bool>       eos;
+                std::atomic<uint32_t>   sequence;   /* futex word, bumped on every publish */
+                std::atomic<uint32_t>   waiters;
+
+                segment_t*  NewSegment  ();
+                void        Publish     ();
+                /* waits until more than `needed` bytes are unread or EOS, returns the unread count */
+                uint64_t    WaitFor     (uint64_t needed);
+                size_t      Copy        (uint8_t *data, size_t len, size_t offset, bool consume);
+        };
+    }
+}
+
+#endif // __SPSCBYTESTREAM_H__
@@ -42,6 +42,15 @@ void            SyncedBlockStream::PushBack           (block_t *block)
     WakeAllConditionVariable(&this->full);
     LeaveCriticalSection(&this->monitorMutex);
 }
+void            SyncedBlockStream::Append             (const uint8_t *data, size_t len)
+{
+    EnterCriticalSection(&this->monitorMutex);
+
+    BlockStream::Append(data, len);
+
+    WakeAllConditionVariable(&this->full);
+    LeaveCriticalSection(&this->monitorMutex);
+}
 void            SyncedBlockStream::PushFront          (block_t *block)
 {
     EnterCriticalSection(&this->monitorMutex);
@@ -187,6 +196,18 @@ uint8_t         SyncedBlockStream::ByteAt             (uint64_t position) const
 
     return ret;
 }
+size_t          SyncedBlockStream::SpanAt             (uint64_t position, const uint8_t **data) const
+{
+    EnterCriticalSection(&this->monitorMutex);
+
+    while(this->length <= position && !this->eos)
+        SleepConditionVariableCS(&this->full, &this->monitorMutex, INFINITE);
+
+    size_t ret = BlockStream::SpanAt(position, data);
+    LeaveCriticalSection(&this->monitorMutex);
+
+    return ret;
+}
 const block_t*  SyncedBlockStream::ToBlock            ()
 {
     EnterCriticalSection(&this->monitorMutex);
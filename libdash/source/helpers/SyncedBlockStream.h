@@ -28,6 +28,7 @@ namespace dash
                 virtual ~SyncedBlockStream ();
 
                 virtual void            PushBack            (block_t *block);
+                virtual void            Append              (const uint8_t *data, size_t len);
                 virtual void            PushFront           (block_t *block);
                 virtual const block_t*  GetBytes            (uint32_t len);
                 virtual size_t          GetBytes            (uint8_t *data, size_t len);
@@ -37,6 +38,7 @@ namespace dash
                 virtual const block_t*  Front               ()                  const;
                 virtual uint64_t        Length              ()                  const;
                 virtual uint8_t         ByteAt              (uint64_t position) const;
+                virtual size_t          SpanAt              (uint64_t position, const uint8_t **data) const;
                 virtual const block_t*  ToBlock             ();
                 virtual void            Clear               ();
                 virtual void            EraseFront          (uint64_t len);
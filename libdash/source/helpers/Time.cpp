@@ -11,6 +11,9 @@
 
 #include "Time.h"
 
+#include <chrono>
+#include <stdio.h>
+
 using namespace dash::helpers;
 
 uint32_t    Time::GetCurrentUTCTimeInSec   ()
@@ -31,3 +34,26 @@ struct tm*  Time::GetCurrentUTCTime     ()
     time(&rawTime);
     return gmtime(&rawTime);
 }
+uint64_t    Time::GetCurrentUTCTimeInMs  ()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+std::string Time::GetUTCTimeStr          (uint64_t ms)
+{
+    time_t      rawTime = (time_t) (ms / 1000);
+    struct tm   utc;
+    char        timeString[30];
+    char        result[40];
+
+    /* called from several download threads, gmtime is not reentrant */
+#if defined _WIN32 || defined _WIN64
+    gmtime_s(&utc, &rawTime);
+#else
+    gmtime_r(&rawTime, &utc);
+#endif
+
+    strftime(timeString, 30, "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(result, sizeof(result), "%s.%03uZ", timeString, (unsigned) (ms % 1000));
+
+    return std::string(result);
+}
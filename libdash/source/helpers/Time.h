@@ -24,6 +24,9 @@ namespace dash
             public:
                 static uint32_t     GetCurrentUTCTimeInSec  ();
                 static std::string  GetCurrentUTCTimeStr    ();
+                static uint64_t     GetCurrentUTCTimeInMs   ();
+                /* ISO 8601 with milliseconds, e.g. 2013-04-01T12:00:00.123Z */
+                static std::string  GetUTCTimeStr           (uint64_t ms);
 
             private:
                 static struct tm*   GetCurrentUTCTime       ();
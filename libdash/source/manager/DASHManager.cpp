@@ -23,26 +23,64 @@ using namespace dash::helpers;
 
 DASHManager::DASHManager            ()
 {
+    /* curl global state, the transfer thread and the shared DNS/connection/TLS
+     * caches are set up once, not per chunk */
+    DownloadEngine::Instance();
 }
 DASHManager::~DASHManager           ()
 {
 }
 IMPD*           DASHManager::Open   (char *path)
 {
-    DOMParser parser(path);
+    MPDReader reader(path);
 
     uint32_t fetchTime = Time::GetCurrentUTCTimeInSec();
 
-    if (!parser.Parse())
-        return NULL;
+    MPD* mpd = reader.ReadFile();
 
-    MPD* mpd = parser.GetRootNode()->ToMPD();
+    if (mpd)
+        mpd->SetFetchTime(fetchTime);
+
+    return mpd;
+}
+IMPD*           DASHManager::Open   (const char *data, size_t length, const std::string &url)
+{
+    MPDReader reader(url);
+
+    uint32_t fetchTime = Time::GetCurrentUTCTimeInSec();
+
+    MPD* mpd = reader.ReadMemory(data, length);
 
     if (mpd)
         mpd->SetFetchTime(fetchTime);
 
     return mpd;
 }
+bool            DASHManager::Write  (const IMPD *mpd, const std::string &path)
+{
+    MPDWriter writer;
+
+    return writer.WriteFile(mpd, path);
+}
+void            DASHManager::SetHTTPVersion (HTTPVersion version)
+{
+    DownloadEngine::Instance()->SetHTTPVersion(version);
+}
+void            DASHManager::SetProgressGranularity (uint64_t bytes, uint32_t milliseconds)
+{
+    DownloadNotifier::Instance()->SetGranularity(bytes, milliseconds);
+}
+ISegment*       DASHManager::CreateChunk    (const std::string &url, const std::string &range)
+{
+    Segment *seg = new Segment();
+
+    if(seg->Init(std::vector<IBaseUrl *>(), url, range, dash::metrics::Other))
+        return seg;
+
+    delete(seg);
+
+    return NULL;
+}
 void            DASHManager::Delete ()
 {
     delete this;
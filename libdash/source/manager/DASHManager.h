@@ -16,8 +16,13 @@
 
 #include "../xml/Node.h"
 #include "../xml/DOMParser.h"
+#include "../xml/MPDReader.h"
+#include "../xml/MPDWriter.h"
 #include "IDASHManager.h"
 #include "../helpers/Time.h"
+#include "../network/DownloadEngine.h"
+#include "../network/DownloadNotifier.h"
+#include "../mpd/Segment.h"
 
 namespace dash
 {
@@ -27,8 +32,13 @@ namespace dash
             DASHManager             ();
             virtual ~DASHManager    ();
 
-            mpd::IMPD*  Open    (char *path);
-            void        Delete  ();
+            mpd::IMPD*      Open            (char *path);
+            mpd::IMPD*      Open            (const char *data, size_t length, const std::string &url);
+            bool            Write           (const mpd::IMPD *mpd, const std::string &path);
+            void            SetHTTPVersion  (network::HTTPVersion version);
+            void            SetProgressGranularity  (uint64_t bytes, uint32_t milliseconds);
+            mpd::ISegment*  CreateChunk     (const std::string &url, const std::string &range);
+            void            Delete          ();
     };
 }
 
@@ -17,14 +17,50 @@ HTTPTransaction::HTTPTransaction () :
                  tcpId           (0),
                  type            (dash::metrics::Other),
                  responseCode    (0),
-                 interval        (0),
+                 interval        (HTTPTRANSACTION_INTERVAL),
                  url             (""),
                  actualUrl       (""),
                  range           (""),
                  tRequest        (""),
                  tResponse       (""),
-                 httpHeader      ("")
-{
+                 httpHeader      (""),
+                 tFinish         (""),
+                 tRequestMs      (0),
+                 tResponseMs     (0),
+                 tFinishMs       (0),
+                 periodStartMs   (0)
+{
+}
+HTTPTransaction::HTTPTransaction (const IHTTPTransaction &other) :
+                 tcpId           (other.TCPId()),
+                 type            (other.Type()),
+                 responseCode    (other.ResponseCode()),
+                 interval        (other.Interval()),
+                 url             (other.OriginalUrl()),
+                 actualUrl       (other.ActualUrl()),
+                 range           (other.Range()),
+                 tRequest        (other.RequestSentTime()),
+                 tResponse       (other.ResponseReceivedTime()),
+                 httpHeader      (other.HTTPHeader()),
+                 tFinish         (other.ResponseFinishedTime()),
+                 tRequestMs      (other.RequestSentTimeMs()),
+                 tResponseMs     (other.ResponseReceivedTimeMs()),
+                 tFinishMs       (other.ResponseFinishedTimeMs()),
+                 periodStartMs   (0)
+{
+    for (size_t i = 0; i < other.ThroughputTrace().size(); i++)
+    {
+        IThroughputMeasurement  *from   = other.ThroughputTrace().at(i);
+        ThroughputMeasurement   *to     = new ThroughputMeasurement();
+
+        to->SetStartOfPeriod(from->StartOfPeriod());
+        to->SetDurationOfPeriod(from->DurationOfPeriod());
+
+        for (size_t k = 0; k < from->ReceivedBytesPerTrace().size(); k++)
+            to->AddReceivedBytes(from->ReceivedBytesPerTrace().at(k));
+
+        this->trace.push_back(to);
+    }
 }
 HTTPTransaction::~HTTPTransaction()
 {
@@ -120,3 +156,53 @@ void                                            HTTPTransaction::AddHTTPHeaderLi
 {
     this->httpHeader.append(headerLine);
 }
+const std::string&                              HTTPTransaction::ResponseFinishedTime       () const
+{
+    return this->tFinish;
+}
+uint64_t                                        HTTPTransaction::RequestSentTimeMs          () const
+{
+    return this->tRequestMs;
+}
+uint64_t                                        HTTPTransaction::ResponseReceivedTimeMs     () const
+{
+    return this->tResponseMs;
+}
+uint64_t                                        HTTPTransaction::ResponseFinishedTimeMs     () const
+{
+    return this->tFinishMs;
+}
+void                                            HTTPTransaction::RequestSent                ()
+{
+    this->tRequestMs = dash::helpers::Time::GetCurrentUTCTimeInMs();
+    this->tRequest   = dash::helpers::Time::GetUTCTimeStr(this->tRequestMs);
+}
+void                                            HTTPTransaction::ResponseReceived           (uint16_t respCode)
+{
+    this->tResponseMs  = dash::helpers::Time::GetCurrentUTCTimeInMs();
+    this->tResponse    = dash::helpers::Time::GetUTCTimeStr(this->tResponseMs);
+    this->responseCode = respCode;
+}
+void                                            HTTPTransaction::ResponseFinished           ()
+{
+    this->tFinishMs = dash::helpers::Time::GetCurrentUTCTimeInMs();
+    this->tFinish   = dash::helpers::Time::GetUTCTimeStr(this->tFinishMs);
+}
+void                                            HTTPTransaction::AddReceivedBytes           (uint32_t numberOfBytes)
+{
+    uint64_t now = dash::helpers::Time::GetCurrentUTCTimeInMs();
+
+    if (this->trace.empty() || now >= this->periodStartMs + this->interval)
+    {
+        ThroughputMeasurement *measurement = new ThroughputMeasurement();
+
+        measurement->SetStartOfPeriod(dash::helpers::Time::GetUTCTimeStr(now));
+        this->trace.push_back(measurement);
+        this->periodStartMs = now;
+    }
+
+    ThroughputMeasurement *current = this->trace.back();
+
+    current->AddReceivedBytes(numberOfBytes);
+    current->SetDurationOfPeriod(now - this->periodStartMs);
+}
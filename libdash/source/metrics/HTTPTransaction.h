@@ -14,6 +14,9 @@
 
 #include "IHTTPTransaction.h"
 #include "ThroughputMeasurement.h"
+#include "../helpers/Time.h"
+
+#define HTTPTRANSACTION_INTERVAL    100     /* ms covered by one ThroughputMeasurement */
 
 namespace dash
 {
@@ -23,6 +26,8 @@ namespace dash
         {
             public:
                 HTTPTransaction          ();
+                /* deep copy, including the trace */
+                HTTPTransaction          (const IHTTPTransaction &other);
                 virtual ~HTTPTransaction ();
 
                 uint32_t                                        TCPId                   () const;
@@ -36,6 +41,10 @@ namespace dash
                 uint64_t                                        Interval                () const;
                 const std::vector<IThroughputMeasurement *>&    ThroughputTrace         () const;
                 const std::string&                              HTTPHeader              () const;
+                const std::string&                              ResponseFinishedTime    () const;
+                uint64_t                                        RequestSentTimeMs       () const;
+                uint64_t                                        ResponseReceivedTimeMs  () const;
+                uint64_t                                        ResponseFinishedTimeMs  () const;
 
                 void    SetTCPId                    (uint32_t tcpId);
                 void    SetType                     (HTTPTransactionType type);
@@ -49,6 +58,14 @@ namespace dash
                 void    AddThroughputMeasurement    (ThroughputMeasurement *throuputEntry);
                 void    AddHTTPHeaderLine           (std::string headerLine);
 
+                /* stamp the current time; used by the connection layer */
+                void    RequestSent                 ();
+                void    ResponseReceived            (uint16_t respCode);
+                void    ResponseFinished            ();
+                /* extends the trace: one measurement per Interval() ms, one
+                 * ReceivedBytesPerTrace entry per read within it */
+                void    AddReceivedBytes            (uint32_t numberOfBytes);
+
             private:
                 uint32_t                                tcpId;
                 HTTPTransactionType                     type;
@@ -61,6 +78,11 @@ namespace dash
                 uint64_t                                interval;
                 std::vector<ThroughputMeasurement *>    trace;
                 std::string                             httpHeader;
+                std::string                             tFinish;
+                uint64_t                                tRequestMs;
+                uint64_t                                tResponseMs;
+                uint64_t                                tFinishMs;
+                uint64_t                                periodStartMs;
         };
     }
 }
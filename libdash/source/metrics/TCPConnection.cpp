@@ -13,7 +13,12 @@
 
 using namespace dash::metrics;
 
-TCPConnection::TCPConnection ()
+TCPConnection::TCPConnection () :
+               rtt              (0),
+               rttVariance      (0),
+               congestionWindow (0),
+               retransmits      (0),
+               deliveryRate     (0)
 {
 }
 TCPConnection::~TCPConnection()
@@ -60,3 +65,32 @@ void                TCPConnection::SetConnectionTime        (uint64_t tConnect)
 {
     this->tConnect = tConnect;
 }
+uint32_t            TCPConnection::RTT                      () const
+{
+    return this->rtt;
+}
+uint32_t            TCPConnection::RTTVariance              () const
+{
+    return this->rttVariance;
+}
+uint32_t            TCPConnection::CongestionWindow         () const
+{
+    return this->congestionWindow;
+}
+uint32_t            TCPConnection::Retransmits              () const
+{
+    return this->retransmits;
+}
+uint64_t            TCPConnection::DeliveryRate             () const
+{
+    return this->deliveryRate;
+}
+void                TCPConnection::SetTCPInfo               (uint32_t rtt, uint32_t rttVariance, uint32_t congestionWindow,
+                                                             uint32_t retransmits, uint64_t deliveryRate)
+{
+    this->rtt               = rtt;
+    this->rttVariance       = rttVariance;
+    this->congestionWindow  = congestionWindow;
+    this->retransmits       = retransmits;
+    this->deliveryRate      = deliveryRate;
+}
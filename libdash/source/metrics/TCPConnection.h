@@ -29,12 +29,19 @@ namespace dash
                 const std::string&      ConnectionOpenedTime    () const;
                 const std::string&      ConnectionClosedTime    () const;
                 uint64_t                ConnectionTime          () const;
+                uint32_t                RTT                     () const;
+                uint32_t                RTTVariance             () const;
+                uint32_t                CongestionWindow        () const;
+                uint32_t                Retransmits             () const;
+                uint64_t                DeliveryRate            () const;
 
                 void    SetTCPId                (uint32_t tcpId);
                 void    SetDestinationAddress   (const std::string& destAddress);
                 void    SetConnectionOpenedTime (std::string tOpen);
                 void    SetConnectionClosedTime (std::string tClose);
                 void    SetConnectionTime       (uint64_t tConnect);
+                void    SetTCPInfo              (uint32_t rtt, uint32_t rttVariance, uint32_t congestionWindow,
+                                                 uint32_t retransmits, uint64_t deliveryRate);
 
             private:
                 uint32_t        tcpId;
@@ -42,6 +49,11 @@ namespace dash
                 std::string     tOpen;
                 std::string     tClose;
                 uint64_t        tConnect;
+                uint32_t        rtt;
+                uint32_t        rttVariance;
+                uint32_t        congestionWindow;
+                uint32_t        retransmits;
+                uint64_t        deliveryRate;
         };
     }
 }
@@ -13,7 +13,8 @@
 
 using namespace dash::metrics;
 
-ThroughputMeasurement::ThroughputMeasurement ()
+ThroughputMeasurement::ThroughputMeasurement () :
+                       durationOfPeriod      (0)
 {
 }
 ThroughputMeasurement::~ThroughputMeasurement()
@@ -29,13 +29,22 @@ const std::vector<INode *>                  AbstractMPDElement::GetAdditionalSub
 }
 const std::map<std::string, std::string>    AbstractMPDElement::GetRawAttributes        ()  const
 {
-    return this->rawAttributes;
+    return helpers::Attributes::ToMap(this->rawAttributes);
 }
 void                                        AbstractMPDElement::AddAdditionalSubNode    (INode *node)
 {
     this->additionalSubNodes.push_back(node);
 }
 void                                        AbstractMPDElement::AddRawAttributes        (std::map<std::string, std::string> attributes)
+{
+    this->rawAttributes.clear();
+
+    std::map<std::string, std::string>::const_iterator it;
+
+    for(it = attributes.begin(); it != attributes.end(); ++it)
+        helpers::Attributes::Set(this->rawAttributes, it->first.c_str(), it->second.c_str());
+}
+void                                        AbstractMPDElement::AddRawAttributes        (const helpers::AttributeList &attributes)
 {
     this->rawAttributes = attributes;
 }
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include "config.h"
 
 #include "IMPDElement.h"
+#include "../helpers/Attributes.h"
 
 namespace dash
 {
@@ -30,10 +31,12 @@ namespace dash
                 virtual const std::map<std::string, std::string>    GetRawAttributes        ()  const;
                 virtual void                                        AddAdditionalSubNode    (xml::INode * node);
                 virtual void                                        AddRawAttributes        (std::map<std::string, std::string> attributes);
+                /* what the parser uses: a copy of the node's list, no map per element */
+                void                                                AddRawAttributes        (const helpers::AttributeList &attributes);
 
             private:
                 std::vector<xml::INode *>           additionalSubNodes;
-                std::map<std::string, std::string>  rawAttributes;
+                helpers::AttributeList              rawAttributes;      /* as a map on request only */
         };
     }
 }
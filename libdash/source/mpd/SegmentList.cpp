@@ -15,29 +15,116 @@
 
 #include "SegmentList.h"
 
+#include <utility>
+
 using namespace dash::mpd;
 
 SegmentList::SegmentList    () :
+                complete(true),
                 xlinkHref(""),
                 xlinkActuate("onRequest"),
                 xlinkType("simple"),
                 xlinkShow("embed")
 {
+    InitializeCriticalSection(&this->monitorMutex);
 }
 SegmentList::~SegmentList   ()
 {
     for (size_t i = 0; i < segmentURLs.size(); i++)
         delete(this->segmentURLs.at(i));
+
+    DeleteCriticalSection(&this->monitorMutex);
 }
 
 const std::vector<ISegmentURL*>& SegmentList::GetSegmentURLs    ()  const
 {
-    return (std::vector<ISegmentURL*> &) this->segmentURLs;
+    EnterCriticalSection(&this->monitorMutex);
+
+    if(!this->complete)
+    {
+        for (size_t i = 0; i < this->segmentURLs.size(); i++)
+            this->Materialize(i);
+
+        this->complete = true;
+    }
+
+    LeaveCriticalSection(&this->monitorMutex);
+
+    return this->segmentURLs;
+}
+size_t                          SegmentList::GetSegmentURLCount     ()  const
+{
+    return this->table.Size();
+}
+ISegmentURL*                    SegmentList::GetSegmentURL          (size_t index)  const
+{
+    EnterCriticalSection(&this->monitorMutex);
+    ISegmentURL *segmentURL = this->Materialize(index);
+    LeaveCriticalSection(&this->monitorMutex);
+
+    return segmentURL;
+}
+std::string                     SegmentList::GetSegmentMediaURI     (size_t index)  const
+{
+    return this->table.GetMediaURI(index);
+}
+std::string                     SegmentList::GetSegmentMediaRange   (size_t index)  const
+{
+    return this->table.GetMediaRange(index);
 }
 void                            SegmentList::AddSegmentURL      (SegmentURL *segmentURL)
 {
+    this->table.Add(segmentURL->GetMediaURI(), segmentURL->GetMediaRange(),
+                    segmentURL->GetIndexURI(), segmentURL->GetIndexRange());
     this->segmentURLs.push_back(segmentURL);
 }
+void                            SegmentList::AddSegmentURL      (const std::string& mediaURI, const std::string& mediaRange,
+                                                                 const std::string& indexURI, const std::string& indexRange)
+{
+    this->table.Add(mediaURI, mediaRange, indexURI, indexRange);
+    this->segmentURLs.push_back(NULL);
+    this->complete = false;
+}
+void                            SegmentList::ReserveSegmentURLs (size_t count)
+{
+    this->table.Reserve(count);
+    this->segmentURLs.reserve(count);
+}
+void                            SegmentList::SwapSegmentURLs    (SegmentList& other)
+{
+    this->table.Swap(other.table);
+    std::swap(this->segmentURLs,    other.segmentURLs);
+    std::swap(this->complete,       other.complete);
+}
+ISegmentURL*                    SegmentList::Materialize        (size_t index)  const
+{
+    ISegmentURL *&segmentURL = this->segmentURLs.at(index);
+
+    if(segmentURL != NULL)
+        return segmentURL;
+
+    SegmentURL              *url = new SegmentURL();
+    helpers::AttributeList  raw;
+
+    url->SetMediaURI(this->table.GetMediaURI(index));
+    url->SetMediaRange(this->table.GetMediaRange(index));
+    url->SetIndexURI(this->table.GetIndexURI(index));
+    url->SetIndexRange(this->table.GetIndexRange(index));
+
+    /* only rows without other attributes are kept in the table, these four are all there was */
+    if(!url->GetMediaURI().empty())
+        helpers::Attributes::Set(raw, "media",      url->GetMediaURI().c_str());
+    if(!url->GetMediaRange().empty())
+        helpers::Attributes::Set(raw, "mediaRange", url->GetMediaRange().c_str());
+    if(!url->GetIndexURI().empty())
+        helpers::Attributes::Set(raw, "index",      url->GetIndexURI().c_str());
+    if(!url->GetIndexRange().empty())
+        helpers::Attributes::Set(raw, "indexRange", url->GetIndexRange().c_str());
+    url->AddRawAttributes(raw);
+
+    segmentURL = url;
+    return segmentURL;
+}
 const std::string&              SegmentList::GetXlinkHref       ()  const
 {
     return this->xlinkHref;
@@ -21,6 +21,8 @@
 #include "ISegmentList.h"
 #include "MultipleSegmentBase.h"
 #include "SegmentURL.h"
+#include "SegmentURLTable.h"
+#include "../portable/MultiThreading.h"
 
 namespace dash
 {
@@ -33,19 +35,34 @@ namespace dash
                 virtual ~SegmentList    ();
 
                 const std::vector<ISegmentURL *>&   GetSegmentURLs  ()  const;
+                size_t                              GetSegmentURLCount  ()  const;
+                ISegmentURL*                        GetSegmentURL       (size_t index)  const;
+                std::string                         GetSegmentMediaURI  (size_t index)  const;
+                std::string                         GetSegmentMediaRange(size_t index)  const;
                 const std::string&                  GetXlinkHref    ()  const;
                 const std::string&                  GetXlinkActuate ()  const;
                 const std::string&                  GetXlinkType    ()  const;
                 const std::string&                  GetXlinkShow    ()  const;
 
                 void    AddSegmentURL   (SegmentURL *segmetURL);
+                /* a row of the table only, the SegmentURL is made if someone asks for it */
+                void    AddSegmentURL   (const std::string& mediaURI, const std::string& mediaRange,
+                                         const std::string& indexURI, const std::string& indexRange);
+                void    ReserveSegmentURLs  (size_t count);
+                void    SwapSegmentURLs     (SegmentList& other);
                 void    SetXlinkHref    (const std::string& xlinkHref);
                 void    SetXlinkActuate (const std::string& xlinkActuate);
                 void    SetXlinkType    (const std::string& xlinkType);
                 void    SetXlinkShow    (const std::string& xlinkShow);
 
             private:
-                std::vector<SegmentURL *> segmentURLs;
+                /* with monitorMutex held */
+                ISegmentURL*    Materialize     (size_t index)  const;
+
+                SegmentURLTable                     table;
+                mutable std::vector<ISegmentURL *>  segmentURLs;    /* NULL until asked for */
+                mutable bool                        complete;       /* none is NULL */
+                mutable CRITICAL_SECTION            monitorMutex;
                 std::string               xlinkHref;
                 std::string               xlinkActuate;
                 std::string               xlinkType;
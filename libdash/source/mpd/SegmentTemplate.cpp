@@ -81,7 +81,11 @@ ISegment*           SegmentTemplate::GetIndexSegmentFromTime        (const std::
 {
     return ToSegment(this->index, baseurls, representationID, bandwidth, dash::metrics::IndexSegment, 0, time);
 }
-std::string         SegmentTemplate::ReplaceParameters              (const std::string& uri, const std::string& representationID, uint32_t bandwidth, uint32_t number, uint32_t time) const
+std::string         SegmentTemplate::GetMediaURI                    (const std::string& representationID, uint32_t bandwidth, uint32_t number, uint64_t time) const
+{
+    return ReplaceParameters(this->media, representationID, bandwidth, number, time);
+}
+std::string         SegmentTemplate::ReplaceParameters              (const std::string& uri, const std::string& representationID, uint32_t bandwidth, uint32_t number, uint64_t time) const
 {
     std::vector<std::string> chunks;
     std::string replacedUri = "";
@@ -127,16 +131,20 @@ std::string         SegmentTemplate::ReplaceParameters              (const std::
         return replacedUri;
     }
 }
-void                SegmentTemplate::FormatChunk                    (std::string& uri, uint32_t number) const
+void                SegmentTemplate::FormatChunk                    (std::string& uri, uint64_t number) const
 {
     char formattedNumber [50];
     size_t pos = 0;
-    std::string formatTag = "%01d";
+    int width = 1;
 
+    /* format tag is %0<width>d */
     if ( (pos = uri.find("%0")) != std::string::npos)
-        formatTag = uri.substr(pos).append("d");
+        width = atoi(uri.c_str() + pos + 2);
+
+    if (width < 1 || width > 40)
+        width = 1;
 
-    sprintf(formattedNumber, formatTag.c_str(), number);
+    sprintf(formattedNumber, "%0*llu", width, (unsigned long long) number);
     uri = formattedNumber;
 }
 ISegment*           SegmentTemplate::ToSegment                      (const std::string& uri, const std::vector<IBaseUrl *>& baseurls, const std::string& representationID, uint32_t bandwidth, HTTPTransactionType type, uint32_t number, uint32_t time) const
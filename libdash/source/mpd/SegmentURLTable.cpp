@@ -0,0 +1,119 @@
+/*
+ * SegmentURLTable.cpp
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#include "SegmentURLTable.h"
+
+#include <cstdlib>
+
+#define RANGE_NONE  UINT64_MAX
+#define RANGE_TEXT  (UINT64_MAX - 1)
+
+using namespace dash::mpd;
+
+SegmentURLTable::SegmentURLTable    ()
+{
+}
+SegmentURLTable::~SegmentURLTable   ()
+{
+}
+
+void                        SegmentURLTable::Add            (const std::string &mediaURI, const std::string &mediaRange,
+                                                             const std::string &indexURI, const std::string &indexRange)
+{
+    Row row;
+
+    row.mediaOffset = this->Append(mediaURI);
+    row.mediaLength = (uint32_t) mediaURI.size();
+    row.indexOffset = this->Append(indexURI);
+    row.indexLength = (uint32_t) indexURI.size();
+    row.mediaRange  = this->Pack(mediaRange);
+    row.indexRange  = this->Pack(indexRange);
+
+    this->rows.push_back(row);
+}
+void                        SegmentURLTable::Reserve        (size_t count)
+{
+    this->rows.reserve(count);
+}
+void                        SegmentURLTable::Swap           (SegmentURLTable &other)
+{
+    this->rows.swap(other.rows);
+    this->blob.swap(other.blob);
+}
+size_t                      SegmentURLTable::Size           ()  const
+{
+    return this->rows.size();
+}
+std::string                 SegmentURLTable::GetMediaURI    (size_t index)  const
+{
+    const Row &row = this->rows.at(index);
+    return this->blob.substr(row.mediaOffset, row.mediaLength);
+}
+std::string                 SegmentURLTable::GetMediaRange  (size_t index)  const
+{
+    return this->Unpack(this->rows.at(index).mediaRange);
+}
+std::string                 SegmentURLTable::GetIndexURI    (size_t index)  const
+{
+    const Row &row = this->rows.at(index);
+    return this->blob.substr(row.indexOffset, row.indexLength);
+}
+std::string                 SegmentURLTable::GetIndexRange  (size_t index)  const
+{
+    return this->Unpack(this->rows.at(index).indexRange);
+}
+uint32_t                    SegmentURLTable::Append         (const std::string &text)
+{
+    uint32_t offset = (uint32_t) this->blob.size();
+
+    this->blob.append(text);
+    return offset;
+}
+SegmentURLTable::Range      SegmentURLTable::Pack           (const std::string &range)
+{
+    Range packed;
+
+    packed.first = RANGE_NONE;
+    packed.last  = 0;
+
+    if(range.empty())
+        return packed;
+
+    size_t dash = range.find('-');
+
+    if(dash != std::string::npos && dash > 0 && dash + 1 < range.size())
+    {
+        uint64_t first = strtoull(range.c_str(), NULL, 10);
+        uint64_t last  = strtoull(range.c_str() + dash + 1, NULL, 10);
+
+        /* only what formats back to the same text is kept as numbers */
+        if(first < RANGE_TEXT && std::to_string(first) + "-" + std::to_string(last) == range)
+        {
+            packed.first = first;
+            packed.last  = last;
+            return packed;
+        }
+    }
+
+    packed.first = RANGE_TEXT;
+    packed.last  = ((uint64_t) this->Append(range) << 32) | (uint32_t) range.size();
+    return packed;
+}
+std::string                 SegmentURLTable::Unpack         (const Range &range)    const
+{
+    if(range.first == RANGE_NONE)
+        return "";
+
+    if(range.first == RANGE_TEXT)
+        return this->blob.substr((size_t) (range.last >> 32), (size_t) (range.last & 0xFFFFFFFF));
+
+    return std::to_string(range.first) + "-" + std::to_string(range.last);
+}
@@ -0,0 +1,73 @@
+/*
+ * SegmentURLTable.h
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#ifndef SEGMENTURLTABLE_H_
+#define SEGMENTURLTABLE_H_
+
+#include "config.h"
+
+namespace dash
+{
+    namespace mpd
+    {
+        /*
+         * The <SegmentURL> entries of one SegmentList, one fixed-size row per
+         * segment: the URIs as offsets into a single string blob, the byte
+         * ranges as numbers. A long VOD list costs a few dozen bytes per
+         * segment instead of a SegmentURL object with four strings.
+         */
+        class SegmentURLTable
+        {
+            public:
+                SegmentURLTable             ();
+                virtual ~SegmentURLTable    ();
+
+                void        Add             (const std::string &mediaURI, const std::string &mediaRange,
+                                             const std::string &indexURI, const std::string &indexRange);
+                void        Reserve         (size_t count);
+                void        Swap            (SegmentURLTable &other);
+                size_t      Size            ()  const;
+
+                std::string GetMediaURI     (size_t index)  const;
+                std::string GetMediaRange   (size_t index)  const;
+                std::string GetIndexURI     (size_t index)  const;
+                std::string GetIndexRange   (size_t index)  const;
+
+            private:
+                /* first is RANGE_NONE when absent; RANGE_TEXT keeps a range that does
+                 * not read back as "first-last" verbatim, with its blob offset and
+                 * length packed into last */
+                struct Range
+                {
+                    uint64_t    first;
+                    uint64_t    last;
+                };
+                struct Row
+                {
+                    uint32_t    mediaOffset;
+                    uint32_t    mediaLength;
+                    uint32_t    indexOffset;
+                    uint32_t    indexLength;
+                    Range       mediaRange;
+                    Range       indexRange;
+                };
+
+                uint32_t    Append          (const std::string &text);
+                Range       Pack            (const std::string &range);
+                std::string Unpack          (const Range &range)    const;
+
+                std::vector<Row>    rows;
+                std::string         blob;
+        };
+    }
+}
+
+#endif /* SEGMENTURLTABLE_H_ */
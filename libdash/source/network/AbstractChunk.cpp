@@ -18,49 +18,111 @@ using namespace dash::metrics;
 uint32_t AbstractChunk::BLOCKSIZE = 32768;
 
 AbstractChunk::AbstractChunk        ()  :
+               observers            (std::make_shared<const ObserverList>()),
+               observerCount        (0),
                connection           (NULL),
                dlThread             (NULL),
-               bytesDownloaded      (0)
+               curl                 (NULL),
+               engineTransfer       (false),
+               bytesDownloaded      (0),
+               reportedBytes        (0),
+               reportedMs           (0),
+               deliveredBytes       (0),
+               posted               (false),
+               weight               (STREAM_WEIGHT_DEFAULT)
 {
+    InitializeCriticalSection(&this->observersLock);
+    InitializeCriticalSection(&this->notifyLock);
 }
 AbstractChunk::~AbstractChunk       ()
 {
     this->AbortDownload();
 
     DestroyThreadPortable(this->dlThread);
+
+    /* what the notifier has not delivered yet is delivered here */
+    DownloadNotifier::Instance()->Cancel(this);
+    if(this->posted.load())
+        this->Deliver();
+
+    DeleteCriticalSection(&this->notifyLock);
+    DeleteCriticalSection(&this->observersLock);
 }
 
 void    AbstractChunk::AbortDownload                ()
 {
     this->stateManager.CheckAndSet(IN_PROGRESS, REQUEST_ABORT);
-    this->stateManager.CheckAndWait(REQUEST_ABORT, ABORTED);
+
+    if(!this->engineTransfer)
+    {
+        this->stateManager.CheckAndWait(REQUEST_ABORT, ABORTED);
+        return;
+    }
+
+    /* inside a curl callback the engine cannot take the handle out; curl ends the transfer once it returns */
+    if(!DownloadEngine::Instance()->Remove(this))
+        return;
+
+    /* no callback runs anymore: a handle still held was taken out before curl was done with it */
+    if(this->curl == NULL)
+        return;
+
+    this->response = CURLE_ABORTED_BY_CALLBACK;
+
+    if(!this->httpTransactions.empty())
+        this->httpTransactions.back()->ResponseFinished();
+
+    DownloadEngine::Instance()->Handles()->Release(this->curl);
+    this->curl = NULL;
+
+    this->blockStream.SetEOS(true);
+    this->ChangeState(ABORTED);
+}
+DownloadState   AbstractChunk::WaitForDownload      ()
+{
+    return this->stateManager.WaitFinished();
 }
 bool    AbstractChunk::StartDownload                ()
 {
     if(this->stateManager.State() != NOT_STARTED)
         return false;
 
-    curl_global_init(CURL_GLOBAL_ALL);
+    /* the engine owns curl_global_init/cleanup and the shared handle pool */
+    DownloadEngine *engine = DownloadEngine::Instance();
 
-    this->curl = curl_easy_init();
+    this->curl = engine->Handles()->Acquire();
     curl_easy_setopt(this->curl, CURLOPT_URL, this->AbsoluteURI().c_str());
     curl_easy_setopt(this->curl, CURLOPT_WRITEFUNCTION, CurlResponseCallback);
     curl_easy_setopt(this->curl, CURLOPT_WRITEDATA, (void *)this);
-    /* Debug Callback */
-    curl_easy_setopt(this->curl, CURLOPT_VERBOSE, 1L);
-    curl_easy_setopt(this->curl, CURLOPT_DEBUGFUNCTION, CurlDebugCallback);
-    curl_easy_setopt(this->curl, CURLOPT_DEBUGDATA, (void *)this);
+    /* response headers feed the HTTPTransaction metrics; no verbose tracing */
+    curl_easy_setopt(this->curl, CURLOPT_HEADERFUNCTION, CurlHeaderCallback);
+    curl_easy_setopt(this->curl, CURLOPT_HEADERDATA, (void *)this);
     curl_easy_setopt(this->curl, CURLOPT_FAILONERROR, true);
+    /* lets an abort take effect while the transfer is stalled */
+    curl_easy_setopt(this->curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(this->curl, CURLOPT_XFERINFOFUNCTION, CurlProgressCallback);
+    curl_easy_setopt(this->curl, CURLOPT_XFERINFODATA, (void *)this);
 
     if(this->HasByteRange())
         curl_easy_setopt(this->curl, CURLOPT_RANGE, this->Range().c_str());
 
-    this->dlThread = CreateThreadPortable (DownloadInternalConnection, this);
+    engine->ApplyHTTPVersion(this->curl, this->weight);
 
-    if(this->dlThread == NULL)
-        return false;
+    /* set before handing over: the engine may complete the transfer at once */
+    this->ChangeState(IN_PROGRESS);
+    this->HandleHeaderOutCallback();
 
-    this->stateManager.State(IN_PROGRESS);
+    this->engineTransfer = true;
+
+    if(!engine->Add(this->curl, this))
+    {
+        this->engineTransfer = false;
+        engine->Handles()->Release(this->curl);
+        this->curl = NULL;
+        this->blockStream.SetEOS(true);
+        this->ChangeState(ABORTED);
+        return false;
+    }
 
     return true;
 }
@@ -74,7 +136,7 @@ bool    AbstractChunk::StartDownload                (IConnection *connection)
     if(this->dlThread == NULL)
         return false;
 
-    this->stateManager.State(IN_PROGRESS);
+    this->ChangeState(IN_PROGRESS);
     this->connection = connection;
 
     return true;
@@ -93,21 +155,45 @@ int     AbstractChunk::Peek                         (uint8_t *data, size_t len,
 }
 void    AbstractChunk::AttachDownloadObserver       (IDownloadObserver *observer)
 {
-    this->observers.push_back(observer);
-    this->stateManager.Attach(observer);
+    EnterCriticalSection(&this->observersLock);
+
+    std::shared_ptr<ObserverList> observers = std::make_shared<ObserverList>(*std::atomic_load(&this->observers));
+
+    observers->push_back(observer);
+    std::atomic_store(&this->observers, std::shared_ptr<const ObserverList>(observers));
+    this->observerCount.store(observers->size());
+
+    LeaveCriticalSection(&this->observersLock);
+}
+void    AbstractChunk::Priority                     (uint32_t weight)
+{
+    if(weight < 1)
+        weight = 1;
+    if(weight > STREAM_WEIGHT_MAX)
+        weight = STREAM_WEIGHT_MAX;
+
+    this->weight = weight;
 }
 void    AbstractChunk::DetachDownloadObserver       (IDownloadObserver *observer)
 {
-    uint32_t pos = -1;
+    EnterCriticalSection(&this->observersLock);
 
-    for(size_t i = 0; i < this->observers.size(); i++)
-        if(this->observers.at(i) == observer)
-            pos = i;
+    std::shared_ptr<ObserverList> observers = std::make_shared<ObserverList>(*std::atomic_load(&this->observers));
 
-    if(pos != -1)
-        this->observers.erase(this->observers.begin() + pos);
+    for(size_t i = observers->size(); i-- > 0;)
+        if(observers->at(i) == observer)
+        {
+            observers->erase(observers->begin() + i);
+            break;
+        }
+
+    std::atomic_store(&this->observers, std::shared_ptr<const ObserverList>(observers));
+    this->observerCount.store(observers->size());
+
+    LeaveCriticalSection(&this->observersLock);
 
-    this->stateManager.Detach(observer);
+    /* a delivery under way may still hold the old snapshot */
+    DownloadNotifier::Instance()->Quiesce(this);
 }
 void*   AbstractChunk::DownloadExternalConnection   (void *abstractchunk)
 {
@@ -120,9 +206,7 @@ void*   AbstractChunk::DownloadExternalConnection   (void *abstractchunk)
         ret = chunk->connection->Read(block->data, block->len, chunk);
         if(ret > 0)
         {
-            block_t *streamblock = AllocBlock(ret);
-            memcpy(streamblock->data, block->data, ret);
-            chunk->blockStream.PushBack(streamblock);
+            chunk->blockStream.Append(block->data, ret);
             chunk->bytesDownloaded += ret;
 
             chunk->NotifyDownloadRateChanged();
@@ -134,37 +218,93 @@ void*   AbstractChunk::DownloadExternalConnection   (void *abstractchunk)
 
     DeleteBlock(block);
 
+    /* the chunk may be destroyed as soon as the final state is set */
+    chunk->blockStream.SetEOS(true);
+
     if(chunk->stateManager.State() == REQUEST_ABORT)
-        chunk->stateManager.State(ABORTED);
+        chunk->ChangeState(ABORTED);
     else
-        chunk->stateManager.State(COMPLETED);
-
-    chunk->blockStream.SetEOS(true);
+        chunk->ChangeState(COMPLETED);
 
     return NULL;
 }
-void*   AbstractChunk::DownloadInternalConnection   (void *abstractchunk)
+void    AbstractChunk::OnTransferComplete           (CURLcode result)
 {
-    AbstractChunk *chunk  = (AbstractChunk *) abstractchunk;
+    this->response = result;
 
-    chunk->response = curl_easy_perform(chunk->curl);
+    if(!this->httpTransactions.empty())
+        this->httpTransactions.back()->ResponseFinished();
 
-    curl_easy_cleanup(chunk->curl);
-    curl_global_cleanup();
+    DownloadEngine::Instance()->Handles()->Release(this->curl);
+    this->curl = NULL;
 
-    if(chunk->stateManager.State() == REQUEST_ABORT)
-        chunk->stateManager.State(ABORTED);
+    /* the chunk may be destroyed as soon as the final state is set */
+    this->blockStream.SetEOS(true);
+
+    /* a failed transfer, an HTTP error with FAILONERROR included, did not complete */
+    if(this->stateManager.State() == REQUEST_ABORT || result != CURLE_OK)
+        this->ChangeState(ABORTED);
     else
-        chunk->stateManager.State(COMPLETED);
+        this->ChangeState(COMPLETED);
+}
+void    AbstractChunk::NotifyDownloadRateChanged    ()
+{
+    if(this->observerCount.load() == 0)
+        return;
 
-    chunk->blockStream.SetEOS(true);
+    uint64_t bytes  = this->bytesDownloaded.load();
+    uint64_t now    = Time::GetCurrentUTCTimeInMs();
 
-    return NULL;
+    if(!DownloadNotifier::Instance()->IsDue(bytes - this->reportedBytes, now, this->reportedMs))
+        return;
+
+    this->reportedBytes = bytes;
+    this->reportedMs    = now;
+    this->Post();
 }
-void    AbstractChunk::NotifyDownloadRateChanged    ()
+void    AbstractChunk::ChangeState                  (DownloadState state)
+{
+    /* queued first: a final state lets the owner destroy the chunk, nothing of it may be touched afterwards */
+    if(this->observerCount.load() > 0)
+    {
+        EnterCriticalSection(&this->notifyLock);
+        this->states.push_back(state);
+        LeaveCriticalSection(&this->notifyLock);
+
+        this->Post();
+    }
+
+    this->stateManager.State(state);
+}
+void    AbstractChunk::Post                         ()
+{
+    if(!this->posted.exchange(true))
+        DownloadNotifier::Instance()->Post(this);
+}
+void    AbstractChunk::Deliver                      ()
 {
-    for(size_t i = 0; i < this->observers.size(); i++)
-        this->observers.at(i)->OnDownloadRateChanged(this->bytesDownloaded);
+    /* anything from now on needs a new post */
+    this->posted.store(false);
+
+    std::vector<DownloadState> states;
+
+    EnterCriticalSection(&this->notifyLock);
+    states.swap(this->states);
+    LeaveCriticalSection(&this->notifyLock);
+
+    std::shared_ptr<const ObserverList> observers   = std::atomic_load(&this->observers);
+    uint64_t                            bytes       = this->bytesDownloaded.load();
+
+    /* progress first: a final state follows the last byte */
+    if(bytes != this->deliveredBytes)
+    {
+        this->deliveredBytes = bytes;
+        for(size_t i = 0; i < observers->size(); i++)
+            observers->at(i)->OnDownloadRateChanged(bytes);
+    }
+    for(size_t i = 0; i < states.size(); i++)
+        for(size_t j = 0; j < observers->size(); j++)
+            observers->at(j)->OnDownloadStateChanged(states.at(i));
 }
 size_t  AbstractChunk::CurlResponseCallback         (void *contents, size_t size, size_t nmemb, void *userp)
 {
@@ -174,35 +314,30 @@ size_t  AbstractChunk::CurlResponseCallback         (void *contents, size_t size
     if(chunk->stateManager.State() == REQUEST_ABORT)
         return 0;
 
-    block_t *block = AllocBlock(realsize);
+    chunk->blockStream.Append((const uint8_t *) contents, realsize);
 
-    memcpy(block->data, contents, realsize);
-    chunk->blockStream.PushBack(block);
+    if(!chunk->httpTransactions.empty())
+        chunk->httpTransactions.back()->AddReceivedBytes(realsize);
 
     chunk->bytesDownloaded += realsize;
     chunk->NotifyDownloadRateChanged();
 
     return realsize;
 }
-size_t  AbstractChunk::CurlDebugCallback            (CURL *url, curl_infotype infoType, char * data, size_t length, void *userdata)
+int     AbstractChunk::CurlProgressCallback         (void *userp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+    AbstractChunk *chunk = (AbstractChunk *)userp;
+
+    return chunk->stateManager.State() == REQUEST_ABORT ? 1 : 0;
+}
+size_t  AbstractChunk::CurlHeaderCallback           (void *headerData, size_t size, size_t nmemb, void *userdata)
 {
     AbstractChunk   *chunk      = (AbstractChunk *)userdata;
+    size_t          realsize    = size * nmemb;
 
-    switch (infoType) {
-        case CURLINFO_TEXT:
-            break;
-        case CURLINFO_HEADER_OUT:
-            chunk->HandleHeaderOutCallback();
-            break;
-        case CURLINFO_HEADER_IN:
-            chunk->HandleHeaderInCallback(std::string(data));
-            break;
-        case CURLINFO_DATA_IN:
-            break;
-        default:
-            return 0;
-    }
-    return 0;
+    chunk->HandleHeaderInCallback(std::string((char *) headerData, realsize));
+
+    return realsize;
 }
 void    AbstractChunk::HandleHeaderOutCallback      ()
 {
@@ -211,7 +346,8 @@ void    AbstractChunk::HandleHeaderOutCallback      ()
     httpTransaction->SetOriginalUrl(this->AbsoluteURI());
     httpTransaction->SetRange(this->Range());
     httpTransaction->SetType(this->GetType());
-    httpTransaction->SetRequestSentTime(Time::GetCurrentUTCTimeStr());
+    httpTransaction->SetActualUrl(this->AbsoluteURI());
+    httpTransaction->RequestSent();
 
     this->httpTransactions.push_back(httpTransaction);
 }
@@ -221,8 +357,7 @@ void    AbstractChunk::HandleHeaderInCallback       (std::string data)
 
     if (data.substr(0,4) == "HTTP")
     {
-        httpTransaction->SetResponseReceivedTime(Time::GetCurrentUTCTimeStr());
-        httpTransaction->SetResponseCode(strtoul(data.substr(9,3).c_str(), NULL, 10));
+        httpTransaction->ResponseReceived(strtoul(data.substr(9,3).c_str(), NULL, 10));
     }
 
     httpTransaction->AddHTTPHeaderLine(data);
@@ -16,7 +16,10 @@
 
 #include "IDownloadableChunk.h"
 #include "DownloadStateManager.h"
-#include "../helpers/SyncedBlockStream.h"
+#include "DownloadEngine.h"
+#include "DownloadNotifier.h"
+#include "../helpers/SpscByteStream.h"
+#include "../helpers/Block.h"
 #include "../portable/Networking.h"
 #include <curl/curl.h>
 #include "../metrics/HTTPTransaction.h"
@@ -24,11 +27,22 @@
 #include "../metrics/ThroughputMeasurement.h"
 #include "../helpers/Time.h"
 
+#include <atomic>
+#include <memory>
+
 namespace dash
 {
     namespace network
     {
-        class AbstractChunk : public virtual IDownloadableChunk
+        /*
+         * Observers are called on the DownloadNotifier thread, never on the
+         * thread reading the socket: progress at most once per notifier
+         * granularity, coalesced while a delivery is pending, then the state
+         * changes in order. The observer list is copy-on-write, a delivery
+         * reads a snapshot without taking the lock Attach and Detach share;
+         * once Detach returns the observer is not called anymore.
+         */
+        class AbstractChunk : public virtual IDownloadableChunk, public IDownloadTransfer, public IDownloadNotification
         {
             public:
                 AbstractChunk          ();
@@ -52,13 +66,24 @@ namespace dash
                 virtual bool    StartDownload           (IConnection *connection);
                 virtual bool    StartDownload           ();
                 virtual void    AbortDownload           ();
+                virtual DownloadState   WaitForDownload ();
                 virtual int     Read                    (uint8_t *data, size_t len);
                 virtual int     Peek                    (uint8_t *data, size_t len);
                 virtual int     Peek                    (uint8_t *data, size_t len, size_t offset);
                 virtual void    AttachDownloadObserver  (IDownloadObserver *observer);
                 virtual void    DetachDownloadObserver  (IDownloadObserver *observer);
+                virtual void    Priority                (uint32_t weight);
+                /*
+                 * IDownloadTransfer, called by the DownloadEngine
+                 */
+                virtual void    OnTransferComplete      (CURLcode result);
                 /*
-                 * Observer Notification
+                 * IDownloadNotification, called by the DownloadNotifier
+                 */
+                virtual void    Deliver                 ();
+                /*
+                 * Observer Notification, from the download thread; posts to the
+                 * notifier when the granularity says so
                  */
                 void NotifyDownloadRateChanged ();
                 /*
@@ -68,13 +93,25 @@ namespace dash
                 const std::vector<dash::metrics::IHTTPTransaction *>&   GetHTTPTransactionList  () const;
 
             private:
-                std::vector<IDownloadObserver *>    observers;
+                typedef std::vector<IDownloadObserver *>    ObserverList;
+
+                std::shared_ptr<const ObserverList> observers;      /* replaced, never changed in place */
+                CRITICAL_SECTION                    observersLock;  /* Attach/Detach among themselves */
+                std::atomic<size_t>                 observerCount;
                 THREAD_HANDLE                       dlThread;
                 IConnection                         *connection;
-                helpers::SyncedBlockStream          blockStream;
+                helpers::SpscByteStream             blockStream;
                 CURL                                *curl;
                 CURLcode                            response;
-                uint64_t                            bytesDownloaded;
+                bool                                engineTransfer; /* handed to the DownloadEngine */
+                std::atomic<uint64_t>               bytesDownloaded;
+                uint64_t                            reportedBytes;  /* download thread */
+                uint64_t                            reportedMs;
+                uint64_t                            deliveredBytes; /* notifier thread */
+                std::atomic<bool>                   posted;
+                CRITICAL_SECTION                    notifyLock;     /* states only, never held in a callback */
+                std::vector<DownloadState>          states;         /* changes not delivered yet */
+                uint32_t                            weight;
                 DownloadStateManager                stateManager;
 
                 std::vector<dash::metrics::TCPConnection *>     tcpConnections;
@@ -83,10 +120,12 @@ namespace dash
                 static uint32_t BLOCKSIZE;
 
                 static void*    DownloadExternalConnection  (void *chunk);
-                static void*    DownloadInternalConnection  (void *chunk);
                 static size_t   CurlResponseCallback        (void *contents, size_t size, size_t nmemb, void *userp);
+                static int      CurlProgressCallback        (void *userp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
                 static size_t   CurlHeaderCallback          (void *headerData, size_t size, size_t nmemb, void *userdata);
-                static size_t   CurlDebugCallback           (CURL *url, curl_infotype infoType, char * data, size_t length, void *userdata);
+                /* sets the state and queues its notification */
+                void            ChangeState                 (DownloadState state);
+                void            Post                        ();
                 void            HandleHeaderOutCallback     ();
                 void            HandleHeaderInCallback      (std::string data);
         };
@@ -0,0 +1,95 @@
+/*
+ * CurlHandlePool.cpp
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#include "CurlHandlePool.h"
+
+using namespace dash::network;
+
+#define MAX_IDLE_HANDLES 16
+
+CurlHandlePool::CurlHandlePool  ()
+{
+    InitializeCriticalSection(&this->monitorMutex);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+        InitializeCriticalSection(&this->shareLocks[i]);
+
+    this->share = curl_share_init();
+    curl_share_setopt(this->share, CURLSHOPT_LOCKFUNC, Lock);
+    curl_share_setopt(this->share, CURLSHOPT_UNLOCKFUNC, Unlock);
+    curl_share_setopt(this->share, CURLSHOPT_USERDATA, (void *) this);
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+}
+CurlHandlePool::~CurlHandlePool ()
+{
+    for (size_t i = 0; i < this->idle.size(); i++)
+        curl_easy_cleanup(this->idle.at(i));
+
+    curl_share_cleanup(this->share);
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+        DeleteCriticalSection(&this->shareLocks[i]);
+    DeleteCriticalSection(&this->monitorMutex);
+}
+
+CURL*   CurlHandlePool::Acquire     ()
+{
+    CURL *handle = NULL;
+
+    EnterCriticalSection(&this->monitorMutex);
+    if (!this->idle.empty())
+    {
+        handle = this->idle.back();
+        this->idle.pop_back();
+    }
+    LeaveCriticalSection(&this->monitorMutex);
+
+    if (handle == NULL)
+        handle = curl_easy_init();
+
+    if (handle)
+        curl_easy_setopt(handle, CURLOPT_SHARE, this->share);
+
+    return handle;
+}
+void    CurlHandlePool::Release     (CURL *handle)
+{
+    /* resets options only; caches stay with the share */
+    curl_easy_reset(handle);
+
+    EnterCriticalSection(&this->monitorMutex);
+    if (this->idle.size() < MAX_IDLE_HANDLES)
+    {
+        this->idle.push_back(handle);
+        handle = NULL;
+    }
+    LeaveCriticalSection(&this->monitorMutex);
+
+    if (handle)
+        curl_easy_cleanup(handle);
+}
+void    CurlHandlePool::Lock        (CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+    CurlHandlePool *pool = (CurlHandlePool *) userptr;
+
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+        EnterCriticalSection(&pool->shareLocks[data]);
+}
+void    CurlHandlePool::Unlock      (CURL *handle, curl_lock_data data, void *userptr)
+{
+    CurlHandlePool *pool = (CurlHandlePool *) userptr;
+
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST)
+        LeaveCriticalSection(&pool->shareLocks[data]);
+}
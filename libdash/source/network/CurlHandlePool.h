@@ -0,0 +1,53 @@
+/*
+ * CurlHandlePool.h
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#ifndef CURLHANDLEPOOL_H_
+#define CURLHANDLEPOOL_H_
+
+#include "config.h"
+
+#include "../portable/MultiThreading.h"
+#include <curl/curl.h>
+#include <vector>
+
+namespace dash
+{
+    namespace network
+    {
+        /*
+         * Recycles curl easy handles and attaches all of them to one CURLSH
+         * that shares the DNS cache, TLS sessions and (curl >= 7.57)
+         * connections, so a new chunk does not pay name resolution and
+         * connection setup again.
+         */
+        class CurlHandlePool
+        {
+            public:
+                CurlHandlePool          ();
+                virtual ~CurlHandlePool ();
+
+                /* handle with default options and the share attached */
+                CURL*   Acquire     ();
+                void    Release     (CURL *handle);
+
+            private:
+                static void     Lock        (CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+                static void     Unlock      (CURL *handle, curl_lock_data data, void *userptr);
+
+                CURLSH                  *share;
+                CRITICAL_SECTION        shareLocks[CURL_LOCK_DATA_LAST];
+                CRITICAL_SECTION        monitorMutex;
+                std::vector<CURL *>     idle;
+        };
+    }
+}
+
+#endif /* CURLHANDLEPOOL_H_ */
@@ -0,0 +1,292 @@
+/*
+ * DownloadEngine.cpp
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#include "DownloadEngine.h"
+
+using namespace dash::network;
+
+#define POLL_TIMEOUT_MS 100
+
+DownloadEngine*     DownloadEngine::Instance    ()
+{
+    /* created on first use and kept for the lifetime of the process, so
+     * chunk destructors never race with engine shutdown */
+    static DownloadEngine *engine = new DownloadEngine();
+    return engine;
+}
+
+DownloadEngine::DownloadEngine  () :
+                multi           (NULL),
+                handles         (NULL),
+                thread          (NULL),
+                removeRequested (0),
+                removeServed    (0),
+                active          (0),
+                httpVersion     (HTTP_VERSION_1_1)
+{
+    InitializeCriticalSection   (&this->monitorMutex);
+    InitializeConditionVariable (&this->work);
+    InitializeConditionVariable (&this->removed);
+
+    curl_global_init(CURL_GLOBAL_ALL);
+    this->handles = new CurlHandlePool();
+    this->multi   = curl_multi_init();
+
+#if LIBCURL_VERSION_NUM >= 0x072b00
+    /* only affects HTTP/2 connections, HTTP/1.1 is never pipelined */
+    curl_multi_setopt(this->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+    this->thread = CreateThreadPortable(Run, this);
+}
+DownloadEngine::~DownloadEngine ()
+{
+    curl_multi_cleanup(this->multi);
+    delete this->handles;
+    curl_global_cleanup();
+
+    DestroyThreadPortable(this->thread);
+    DeleteConditionVariable(&this->work);
+    DeleteConditionVariable(&this->removed);
+    DeleteCriticalSection(&this->monitorMutex);
+}
+
+bool    DownloadEngine::Add         (CURL *handle, IDownloadTransfer *transfer)
+{
+    if (this->thread == NULL)
+        return false;
+
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, (void *) transfer);
+
+    EnterCriticalSection(&this->monitorMutex);
+    this->pending.push_back(std::make_pair(handle, transfer));
+    WakeAllConditionVariable(&this->work);
+    LeaveCriticalSection(&this->monitorMutex);
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(this->multi);
+#endif
+
+    return true;
+}
+bool    DownloadEngine::Remove      (IDownloadTransfer *transfer)
+{
+    if (this->thread == NULL)
+        return false;
+
+    EnterCriticalSection(&this->monitorMutex);
+    if (std::this_thread::get_id() == this->engineThread)
+    {
+        LeaveCriticalSection(&this->monitorMutex);
+        return false;
+    }
+    this->removing.push_back(transfer);
+    uint64_t ticket = ++this->removeRequested;
+    WakeAllConditionVariable(&this->work);
+    LeaveCriticalSection(&this->monitorMutex);
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(this->multi);
+#endif
+
+    EnterCriticalSection(&this->monitorMutex);
+    while (this->removeServed < ticket)
+        SleepConditionVariableCS(&this->removed, &this->monitorMutex, INFINITE);
+    LeaveCriticalSection(&this->monitorMutex);
+
+    return true;
+}
+CurlHandlePool*     DownloadEngine::Handles ()
+{
+    return this->handles;
+}
+void    DownloadEngine::SetHTTPVersion      (HTTPVersion version)
+{
+#if LIBCURL_VERSION_NUM >= 0x074200
+    if (version == HTTP_VERSION_3 && !(curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP3))
+        version = HTTP_VERSION_2;
+#else
+    if (version == HTTP_VERSION_3)
+        version = HTTP_VERSION_2;
+#endif
+
+    EnterCriticalSection(&this->monitorMutex);
+    this->httpVersion = version;
+    LeaveCriticalSection(&this->monitorMutex);
+}
+HTTPVersion DownloadEngine::GetHTTPVersion  ()
+{
+    EnterCriticalSection(&this->monitorMutex);
+    HTTPVersion version = this->httpVersion;
+    LeaveCriticalSection(&this->monitorMutex);
+
+    return version;
+}
+void    DownloadEngine::ApplyHTTPVersion    (CURL *handle, uint32_t weight)
+{
+    HTTPVersion version = this->GetHTTPVersion();
+
+    if (version == HTTP_VERSION_1_1)
+    {
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_1_1);
+        return;
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x074200
+    /* every request is a QUIC stream of its own, a lost packet only holds
+     * up the segment it belongs to; tries TCP too if UDP gets no answer */
+    if (version == HTTP_VERSION_3)
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_3);
+    else
+#endif
+#if LIBCURL_VERSION_NUM >= 0x073100
+    if (version == HTTP_VERSION_2_PRIOR_KNOWLEDGE)
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
+    else
+#endif
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2_0);
+
+#if LIBCURL_VERSION_NUM >= 0x072b00
+    /* wait for the existing connection to turn out multiplexable instead of
+     * opening a second one while the first is still being set up */
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072e00
+    curl_easy_setopt(handle, CURLOPT_STREAM_WEIGHT, (long) weight);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x080b00
+    /* the TLS sessions are shared by all handles (CurlHandlePool), so a
+     * reconnect resumes and sends its GET as 0-RTT early data */
+    if (version == HTTP_VERSION_3)
+        curl_easy_setopt(handle, CURLOPT_SSL_OPTIONS, (long) CURLSSLOPT_EARLYDATA);
+#endif
+}
+size_t  DownloadEngine::Active      ()
+{
+    EnterCriticalSection(&this->monitorMutex);
+    size_t count = this->active + this->pending.size();
+    LeaveCriticalSection(&this->monitorMutex);
+
+    return count;
+}
+void*   DownloadEngine::Run         (void *engine)
+{
+    ((DownloadEngine *) engine)->Loop();
+    return NULL;
+}
+void    DownloadEngine::Loop        ()
+{
+    int running = 0;
+
+    EnterCriticalSection(&this->monitorMutex);
+    this->engineThread = std::this_thread::get_id();
+    LeaveCriticalSection(&this->monitorMutex);
+
+    while (true)
+    {
+        /* idle: sleep until a transfer is added or removed */
+        EnterCriticalSection(&this->monitorMutex);
+        while (this->active == 0 && this->pending.empty() && this->removing.empty())
+            SleepConditionVariableCS(&this->work, &this->monitorMutex, INFINITE);
+        LeaveCriticalSection(&this->monitorMutex);
+
+        this->AddPending();
+
+        curl_multi_perform(this->multi, &running);
+        this->CollectDone();
+
+        /* between the callbacks: curl is not inside one of a transfer taken out here */
+        this->RemoveRequested();
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_poll(this->multi, NULL, 0, POLL_TIMEOUT_MS, NULL);
+#else
+        curl_multi_wait(this->multi, NULL, 0, POLL_TIMEOUT_MS, NULL);
+#endif
+    }
+}
+void    DownloadEngine::AddPending  ()
+{
+    std::vector<std::pair<CURL *, IDownloadTransfer *> > added;
+
+    EnterCriticalSection(&this->monitorMutex);
+    added.swap(this->pending);
+    LeaveCriticalSection(&this->monitorMutex);
+
+    for (size_t i = 0; i < added.size(); i++)
+    {
+        if (curl_multi_add_handle(this->multi, added.at(i).first) != CURLM_OK)
+        {
+            added.at(i).second->OnTransferComplete(CURLE_FAILED_INIT);
+            continue;
+        }
+
+        this->transfers[added.at(i).second] = added.at(i).first;
+
+        EnterCriticalSection(&this->monitorMutex);
+        this->active++;
+        LeaveCriticalSection(&this->monitorMutex);
+    }
+}
+void    DownloadEngine::RemoveRequested ()
+{
+    std::vector<IDownloadTransfer *> removing;
+
+    EnterCriticalSection(&this->monitorMutex);
+    removing.swap(this->removing);
+    uint64_t served = this->removeRequested;
+    LeaveCriticalSection(&this->monitorMutex);
+
+    size_t removed = 0;
+
+    for (size_t i = 0; i < removing.size(); i++)
+    {
+        std::map<IDownloadTransfer *, CURL *>::iterator it = this->transfers.find(removing.at(i));
+
+        if (it == this->transfers.end())
+            continue;   /* done already, or never added */
+
+        curl_multi_remove_handle(this->multi, it->second);
+        this->transfers.erase(it);
+        removed++;
+    }
+
+    EnterCriticalSection(&this->monitorMutex);
+    this->active       -= removed;
+    this->removeServed  = served;
+    WakeAllConditionVariable(&this->removed);
+    LeaveCriticalSection(&this->monitorMutex);
+}
+void    DownloadEngine::CollectDone ()
+{
+    CURLMsg *msg  = NULL;
+    int     queue = 0;
+
+    while ((msg = curl_multi_info_read(this->multi, &queue)) != NULL)
+    {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+
+        CURL                *handle   = msg->easy_handle;
+        CURLcode            result    = msg->data.result;
+        IDownloadTransfer   *transfer = NULL;
+
+        curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char **) &transfer);
+        curl_multi_remove_handle(this->multi, handle);
+        this->transfers.erase(transfer);
+
+        EnterCriticalSection(&this->monitorMutex);
+        this->active--;
+        LeaveCriticalSection(&this->monitorMutex);
+
+        if (transfer)
+            transfer->OnTransferComplete(result);
+    }
+}
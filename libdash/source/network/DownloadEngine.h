@@ -0,0 +1,93 @@
+/*
+ * DownloadEngine.h
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#ifndef DOWNLOADENGINE_H_
+#define DOWNLOADENGINE_H_
+
+#include "config.h"
+
+#include "../portable/MultiThreading.h"
+#include "CurlHandlePool.h"
+#include "IConnection.h"
+#include <curl/curl.h>
+#include <map>
+#include <thread>
+
+#define STREAM_WEIGHT_DEFAULT   16      /* RFC 7540 default */
+#define STREAM_WEIGHT_MAX       256
+
+namespace dash
+{
+    namespace network
+    {
+        class IDownloadTransfer
+        {
+            public:
+                virtual ~IDownloadTransfer () {}
+
+                /* called on the engine thread once curl is done with the handle */
+                virtual void    OnTransferComplete  (CURLcode result) = 0;
+        };
+
+        /*
+         * Drives all internal-connection chunk downloads from one thread with
+         * curl_multi instead of one blocking curl_easy_perform thread per
+         * chunk. Handles are added from any thread; curl callbacks run on
+         * the engine thread.
+         */
+        class DownloadEngine
+        {
+            public:
+                static DownloadEngine*  Instance    ();
+
+                bool            Add         (CURL *handle, IDownloadTransfer *transfer);
+                /* takes the transfer out of the multi handle on the engine thread and waits for it: once it
+                 * returns, no callback of the transfer runs anymore and a handle it was not done with is left
+                 * to the caller. False on the engine thread itself, where curl may be inside a callback of it. */
+                bool            Remove      (IDownloadTransfer *transfer);
+                size_t          Active      ();
+                CurlHandlePool* Handles     ();
+
+                /* HTTP_VERSION_3 becomes HTTP_VERSION_2 if libcurl cannot do it */
+                void            SetHTTPVersion      (HTTPVersion version);
+                HTTPVersion     GetHTTPVersion      ();
+                /* sets the per-handle HTTP version, multiplexing and stream weight options */
+                void            ApplyHTTPVersion    (CURL *handle, uint32_t weight);
+
+            private:
+                DownloadEngine          ();
+                virtual ~DownloadEngine ();
+
+                static void*    Run     (void *engine);
+                void            Loop    ();
+                void            AddPending  ();
+                void            CollectDone ();
+                void            RemoveRequested ();
+
+                CURLM                                                   *multi;
+                CurlHandlePool                                          *handles;
+                THREAD_HANDLE                                           thread;
+                CRITICAL_SECTION                                        monitorMutex;
+                CONDITION_VARIABLE                                      work;
+                std::vector<std::pair<CURL *, IDownloadTransfer *> >    pending;
+                std::map<IDownloadTransfer *, CURL *>                   transfers;  /* in the multi, engine thread */
+                std::vector<IDownloadTransfer *>                        removing;
+                uint64_t                                                removeRequested;
+                uint64_t                                                removeServed;
+                CONDITION_VARIABLE                                      removed;
+                std::thread::id                                         engineThread;
+                size_t                                                  active;
+                HTTPVersion                                             httpVersion;
+        };
+    }
+}
+
+#endif /* DOWNLOADENGINE_H_ */
@@ -0,0 +1,112 @@
+/*
+ * DownloadNotifier.cpp
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#include "DownloadNotifier.h"
+
+#include <algorithm>
+
+using namespace dash::network;
+
+/* set on the notifier thread, so a delivery can detach observers without waiting for itself */
+static thread_local bool onNotifierThread = false;
+
+DownloadNotifier*   DownloadNotifier::Instance  ()
+{
+    /* kept for the lifetime of the process, like the DownloadEngine */
+    static DownloadNotifier *notifier = new DownloadNotifier();
+    return notifier;
+}
+
+DownloadNotifier::DownloadNotifier  () :
+                  thread            (NULL),
+                  current           (NULL),
+                  granularityBytes  (PROGRESS_GRANULARITY_BYTES),
+                  granularityMs     (PROGRESS_GRANULARITY_MS)
+{
+    InitializeCriticalSection   (&this->monitorMutex);
+    InitializeConditionVariable (&this->work);
+    InitializeConditionVariable (&this->delivered);
+
+    this->thread = CreateThreadPortable(Run, this);
+}
+DownloadNotifier::~DownloadNotifier ()
+{
+    DestroyThreadPortable(this->thread);
+    DeleteConditionVariable(&this->delivered);
+    DeleteConditionVariable(&this->work);
+    DeleteCriticalSection(&this->monitorMutex);
+}
+
+void    DownloadNotifier::Post              (IDownloadNotification *notification)
+{
+    EnterCriticalSection(&this->monitorMutex);
+    this->queue.push_back(notification);
+    WakeConditionVariable(&this->work);
+    LeaveCriticalSection(&this->monitorMutex);
+}
+void    DownloadNotifier::Cancel            (IDownloadNotification *notification)
+{
+    EnterCriticalSection(&this->monitorMutex);
+    this->queue.erase(std::remove(this->queue.begin(), this->queue.end(), notification), this->queue.end());
+    this->WaitIdle(notification);
+    LeaveCriticalSection(&this->monitorMutex);
+}
+void    DownloadNotifier::Quiesce           (IDownloadNotification *notification)
+{
+    EnterCriticalSection(&this->monitorMutex);
+    this->WaitIdle(notification);
+    LeaveCriticalSection(&this->monitorMutex);
+}
+void    DownloadNotifier::WaitIdle          (IDownloadNotification *notification)
+{
+    if (onNotifierThread)
+        return;
+
+    while (this->current == notification)
+        SleepConditionVariableCS(&this->delivered, &this->monitorMutex, INFINITE);
+}
+void    DownloadNotifier::SetGranularity    (uint64_t bytes, uint32_t milliseconds)
+{
+    this->granularityBytes.store(bytes);
+    this->granularityMs.store(milliseconds);
+}
+bool    DownloadNotifier::IsDue             (uint64_t bytes, uint64_t nowMs, uint64_t reportedMs) const
+{
+    return bytes >= this->granularityBytes.load() || nowMs - reportedMs >= this->granularityMs.load();
+}
+void*   DownloadNotifier::Run               (void *notifier)
+{
+    onNotifierThread = true;
+    ((DownloadNotifier *) notifier)->Loop();
+    return NULL;
+}
+void    DownloadNotifier::Loop              ()
+{
+    EnterCriticalSection(&this->monitorMutex);
+
+    while (true)
+    {
+        while (this->queue.empty())
+            SleepConditionVariableCS(&this->work, &this->monitorMutex, INFINITE);
+
+        IDownloadNotification *notification = this->queue.front();
+
+        this->current = notification;
+        this->queue.pop_front();
+        LeaveCriticalSection(&this->monitorMutex);
+
+        notification->Deliver();
+
+        EnterCriticalSection(&this->monitorMutex);
+        this->current = NULL;
+        WakeAllConditionVariable(&this->delivered);
+    }
+}
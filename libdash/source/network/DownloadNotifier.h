@@ -0,0 +1,85 @@
+/*
+ * DownloadNotifier.h
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#ifndef DOWNLOADNOTIFIER_H_
+#define DOWNLOADNOTIFIER_H_
+
+#include "config.h"
+
+#include "../portable/MultiThreading.h"
+
+#include <atomic>
+#include <deque>
+
+#define PROGRESS_GRANULARITY_BYTES  (64 << 10)
+#define PROGRESS_GRANULARITY_MS     50
+
+namespace dash
+{
+    namespace network
+    {
+        class IDownloadNotification
+        {
+            public:
+                virtual ~IDownloadNotification () {}
+
+                /* on the notifier thread: hands everything that happened since
+                 * the last call to the observers */
+                virtual void    Deliver     () = 0;
+        };
+
+        /*
+         * Runs the IDownloadObserver callbacks of all chunks on one thread of
+         * its own, so observer work never holds up a socket read. A download
+         * only marks its chunk as having news (Post); while the chunk waits
+         * for its turn, further progress coalesces into the one delivery.
+         * The download threads report progress every PROGRESS_GRANULARITY_BYTES
+         * bytes or PROGRESS_GRANULARITY_MS milliseconds, whichever comes first.
+         */
+        class DownloadNotifier
+        {
+            public:
+                static DownloadNotifier*    Instance    ();
+
+                /* once until its Deliver starts, the caller keeps track */
+                void        Post            (IDownloadNotification *notification);
+                /* drops the queued notification and waits for a delivery under
+                 * way, unless called from that delivery */
+                void        Cancel          (IDownloadNotification *notification);
+                /* waits for a delivery under way, unless called from it */
+                void        Quiesce         (IDownloadNotification *notification);
+
+                void        SetGranularity  (uint64_t bytes, uint32_t milliseconds);
+                /* true when progress of `bytes` since the last report at `reportedMs` is worth a report */
+                bool        IsDue           (uint64_t bytes, uint64_t nowMs, uint64_t reportedMs) const;
+
+            private:
+                DownloadNotifier            ();
+                virtual ~DownloadNotifier   ();
+
+                static void*    Run         (void *notifier);
+                void            Loop        ();
+                /* with monitorMutex held */
+                void            WaitIdle    (IDownloadNotification *notification);
+
+                THREAD_HANDLE                           thread;
+                CRITICAL_SECTION                        monitorMutex;
+                CONDITION_VARIABLE                      work;
+                CONDITION_VARIABLE                      delivered;
+                std::deque<IDownloadNotification *>     queue;
+                IDownloadNotification                   *current;   /* being delivered */
+                std::atomic<uint64_t>                   granularityBytes;
+                std::atomic<uint32_t>                   granularityMs;
+        };
+    }
+}
+
+#endif /* DOWNLOADNOTIFIER_H_ */
@@ -14,7 +14,8 @@
 using namespace dash::network;
 
 DownloadStateManager::DownloadStateManager  () :
-                     state                  (NOT_STARTED)
+                     state                  (NOT_STARTED),
+                     waiters                (0)
 {
     InitializeConditionVariable (&this->stateChanged);
     InitializeCriticalSection   (&this->stateLock);
@@ -41,55 +42,48 @@ void            DownloadStateManager::State         (DownloadState state)
 
     this->state = state;
 
-    this->Notify();
-    WakeAllConditionVariable(&this->stateChanged);
+    if(this->waiters > 0)
+        WakeAllConditionVariable(&this->stateChanged);
     LeaveCriticalSection(&this->stateLock);
 }
 void            DownloadStateManager::WaitState     (DownloadState state) const
 {
     EnterCriticalSection(&this->stateLock);
 
+    this->waiters++;
     while(this->state != state)
         SleepConditionVariableCS(&this->stateChanged, &this->stateLock, INFINITE);
+    this->waiters--;
 
     LeaveCriticalSection(&this->stateLock);
 }
-void            DownloadStateManager::CheckAndWait  (DownloadState check, DownloadState wait) const
+DownloadState   DownloadStateManager::WaitFinished  () const
 {
     EnterCriticalSection(&this->stateLock);
 
-    if(this->state == check)
-        while(this->state != wait)
-            SleepConditionVariableCS(&this->stateChanged, &this->stateLock, INFINITE);
+    this->waiters++;
+    while(this->state == IN_PROGRESS || this->state == REQUEST_ABORT)
+        SleepConditionVariableCS(&this->stateChanged, &this->stateLock, INFINITE);
+    this->waiters--;
+
+    DownloadState state = this->state;
 
     LeaveCriticalSection(&this->stateLock);
+
+    return state;
 }
-void            DownloadStateManager::Attach        (IDownloadObserver *observer)
-{
-    EnterCriticalSection(&this->stateLock);
-    this->observers.push_back(observer);
-    LeaveCriticalSection(&this->stateLock);
-}
-void            DownloadStateManager::Detach        (IDownloadObserver *observer)
+void            DownloadStateManager::CheckAndWait  (DownloadState check, DownloadState wait) const
 {
     EnterCriticalSection(&this->stateLock);
 
-    uint32_t pos = -1;
-
-    for(size_t i = 0; i < this->observers.size(); i++)
-        if(this->observers.at(i) == observer)
-            pos = i;
-
-    if(pos != -1)
-        this->observers.erase(this->observers.begin() + pos);
+    this->waiters++;
+    if(this->state == check)
+        while(this->state != wait)
+            SleepConditionVariableCS(&this->stateChanged, &this->stateLock, INFINITE);
+    this->waiters--;
 
     LeaveCriticalSection(&this->stateLock);
 }
-void            DownloadStateManager::Notify        ()
-{
-    for(size_t i = 0; i < this->observers.size(); i++)
-        this->observers.at(i)->OnDownloadStateChanged(this->state);
-}
 void            DownloadStateManager::CheckAndSet   (DownloadState check, DownloadState set)
 {
     EnterCriticalSection(&this->stateLock);
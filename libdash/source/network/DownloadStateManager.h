@@ -21,6 +21,10 @@ namespace dash
 {
     namespace network
     {
+        /*
+         * The state of one download and waiting for it. Observers are told by
+         * the chunk, through the DownloadNotifier.
+         */
         class DownloadStateManager
         {
             public:
@@ -29,20 +33,17 @@ namespace dash
 
                 DownloadState   State           () const;
                 void            WaitState       (DownloadState state) const;
+                /* waits for COMPLETED or ABORTED unless not started; returns the state */
+                DownloadState   WaitFinished    () const;
                 void            CheckAndWait    (DownloadState check, DownloadState wait) const;
                 void            CheckAndSet     (DownloadState check, DownloadState set);
                 void            State           (DownloadState state);
-                void            Attach          (IDownloadObserver *observer);
-                void            Detach          (IDownloadObserver *observer);
 
             private:
                 DownloadState               state;
                 mutable CRITICAL_SECTION    stateLock;
                 mutable CONDITION_VARIABLE  stateChanged;
-
-                std::vector<IDownloadObserver *>    observers;
-
-                void Notify ();
+                mutable uint32_t            waiters;    /* only woken if someone waits */
         };
     }
 }
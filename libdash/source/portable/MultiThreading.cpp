@@ -1,36 +1,58 @@
 #include "MultiThreading.h"
 
+#if defined _WIN32 || defined _WIN64
+    #pragma comment(lib, "Synchronization.lib")
+#elif defined __linux__
+    #include <unistd.h>
+    #include <sys/syscall.h>
+    #include <linux/futex.h>
+#else
+    #include <sched.h>
+#endif
+
 THREAD_HANDLE   CreateThreadPortable    (void *(*start_routine) (void *), void *arg)
 {
     #if defined _WIN32 || defined _WIN64
         return CreateThread (0, 0, (LPTHREAD_START_ROUTINE)start_routine, (LPVOID)arg, 0, 0);
     #else
-        THREAD_HANDLE th = (THREAD_HANDLE)malloc(sizeof(pthread_t));
-    
-        if (!th)
+        try
         {
-            std::cerr << "Error allocating thread." << std::endl;
-            return NULL;
-        }
-
-        // Create pthread as detached so it'll free its resources at exit
-        pthread_attr_t attr;
-        pthread_attr_init(&attr);
-        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+            // Detached, so it frees its resources at exit; the handle only tells a thread was started
+            THREAD_HANDLE th = new std::thread(start_routine, arg);
 
-        if(int err = pthread_create(th, &attr, start_routine, arg))
+            th->detach();
+            return th;
+        }
+        catch(const std::exception &e)
         {
-            std::cerr << strerror(err) << std::endl;
+            std::cerr << e.what() << std::endl;
             return NULL;
         }
-        return th;
     #endif
 }
 void            DestroyThreadPortable   (THREAD_HANDLE th)
 {
     #if !defined _WIN32 && !defined _WIN64
-        if(th)
-            free(th);
+        delete th;
+    #endif
+}
+void            WaitOnValuePortable     (volatile uint32_t *address, uint32_t expected)
+{
+    #if defined _WIN32 || defined _WIN64
+        WaitOnAddress((volatile VOID *)address, &expected, sizeof(expected), INFINITE);
+    #elif defined __linux__
+        syscall(SYS_futex, (uint32_t *)address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+    #else
+        if(*address == expected)
+            sched_yield();
+    #endif
+}
+void            WakeAllOnValuePortable  (volatile uint32_t *address)
+{
+    #if defined _WIN32 || defined _WIN64
+        WakeByAddressAll((PVOID)address);
+    #elif defined __linux__
+        syscall(SYS_futex, (uint32_t *)address, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
     #endif
 }
 
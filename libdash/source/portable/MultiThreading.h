@@ -1,6 +1,8 @@
 #ifndef PORTABLE_MULTITHREADING_H_
 #define PORTABLE_MULTITHREADING_H_
 
+#include <stdint.h>
+
 #if defined _WIN32 || defined _WIN64
 
     #define _WINSOCKAPI_
@@ -41,30 +43,53 @@
 
 #else
 
-    #include <string.h>
-    #include <pthread.h>
-    #include <errno.h>
     #include <stdlib.h>
+    #include <chrono>
+    #include <condition_variable>
     #include <iostream>
+    #include <mutex>
+    #include <thread>
+
+    /* the Win32 names on top of the standard library: no handle is allocated per
+     * lock or wait, and an uncontended lock stays in user space (a futex on Linux) */
+    typedef std::mutex              CRITICAL_SECTION;
+    typedef std::condition_variable CONDITION_VARIABLE;
+    typedef std::thread*            THREAD_HANDLE;
+
+    #define INFINITE                0xFFFFFFFF
 
-    #define CRITICAL_SECTION    pthread_mutex_t
-    #define CONDITION_VARIABLE  pthread_cond_t
+    inline void InitializeCriticalSection   (CRITICAL_SECTION *)            {}
+    inline void DeleteCriticalSection       (CRITICAL_SECTION *)            {}
+    inline void EnterCriticalSection        (CRITICAL_SECTION *mutex)       { mutex->lock(); }
+    inline void LeaveCriticalSection        (CRITICAL_SECTION *mutex)       { mutex->unlock(); }
+    inline void InitializeConditionVariable (CONDITION_VARIABLE *)          {}
+    inline void DeleteConditionVariable     (CONDITION_VARIABLE *)          {}
+    inline void WakeConditionVariable       (CONDITION_VARIABLE *cond)      { cond->notify_one(); }
+    inline void WakeAllConditionVariable    (CONDITION_VARIABLE *cond)      { cond->notify_all(); }
 
-    #define InitializeCriticalSection(mutex_p)                  pthread_mutex_init(mutex_p, NULL)
-    #define DeleteCriticalSection(mutex_p)                      pthread_mutex_destroy(mutex_p)
-    #define EnterCriticalSection(mutex_p)                       pthread_mutex_lock(mutex_p)
-    #define LeaveCriticalSection(mutex_p)                       pthread_mutex_unlock(mutex_p)
-    #define InitializeConditionVariable(cond_p)                 pthread_cond_init(cond_p, NULL)
-    #define DeleteConditionVariable(cond_p)                     pthread_cond_destroy(cond_p)
-    #define SleepConditionVariableCS(cond_p, mutex_p, infinite) pthread_cond_wait(cond_p, mutex_p) // INFINITE should be handled mor properly
-    #define WakeConditionVariable(cond_p)                       pthread_cond_signal(cond_p)
-    #define WakeAllConditionVariable(cond_p)                    pthread_cond_broadcast(cond_p)
+    /* like the Win32 call: false once milliseconds passed without a wake up */
+    inline bool SleepConditionVariableCS    (CONDITION_VARIABLE *cond, CRITICAL_SECTION *mutex, uint32_t milliseconds)
+    {
+        std::unique_lock<std::mutex>    lock    (*mutex, std::adopt_lock);
+        bool                            woken   = true;
 
-    typedef pthread_t* THREAD_HANDLE;
+        if(milliseconds == INFINITE)
+            cond->wait(lock);
+        else
+            woken = cond->wait_for(lock, std::chrono::milliseconds(milliseconds)) == std::cv_status::no_timeout;
+
+        /* the caller still holds the mutex */
+        lock.release();
+        return woken;
+    }
 
 #endif
 
 THREAD_HANDLE   CreateThreadPortable    (void *(*start_routine) (void *), void *arg);
 void            DestroyThreadPortable   (THREAD_HANDLE th);
 
+/* futex style wait: sleeps while *address == expected, may return spuriously */
+void            WaitOnValuePortable     (volatile uint32_t *address, uint32_t expected);
+void            WakeAllOnValuePortable  (volatile uint32_t *address);
+
 #endif  // PORTABLE_MULTITHREADING_H_
\ No newline at end of file
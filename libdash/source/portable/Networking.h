@@ -6,12 +6,15 @@
 #include <WinSock2.h>
 #include <WS2tcpip.h>
 
+#define SHUT_RDWR SD_BOTH
+
 #else
 
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/ip.h> /* superset of previous */ 
 #include <netdb.h>
+#include <arpa/inet.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
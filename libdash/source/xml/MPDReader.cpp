@@ -0,0 +1,274 @@
+/*
+ * MPDReader.cpp
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#include "MPDReader.h"
+
+using namespace dash::xml;
+using namespace dash::mpd;
+using namespace dash::helpers;
+
+MPDReader::MPDReader    (const std::string &url) :
+           reader       (NULL),
+           url          (url)
+{
+}
+MPDReader::~MPDReader   ()
+{
+}
+
+MPD*    MPDReader::ReadFile                 ()
+{
+    this->reader = xmlReaderForFile(this->url.c_str(), NULL, 0);
+
+    return this->Read();
+}
+MPD*    MPDReader::ReadMemory               (const char *data, size_t length)
+{
+    this->reader = xmlReaderForMemory(data, (int) length, this->url.c_str(), NULL, 0);
+
+    return this->Read();
+}
+MPD*    MPDReader::Read                     ()
+{
+    if(this->reader == NULL)
+        return NULL;
+
+    MPD *mpd = NULL;
+
+    /* skip to the root element */
+    while(xmlTextReaderRead(this->reader) == 1)
+    {
+        if(xmlTextReaderNodeType(this->reader) != Start)
+            continue;
+
+        if(this->Name() == "MPD")
+            mpd = this->ReadMPD();
+        break;
+    }
+
+    xmlFreeTextReader(this->reader);
+    this->reader = NULL;
+
+    return mpd;
+}
+MPD*    MPDReader::ReadMPD                  ()
+{
+    Node                    *node   = this->ReadElement();
+    int                     depth   = xmlTextReaderDepth(this->reader);
+    bool                    empty   = this->IsEmpty();
+    std::vector<Period *>   periods;
+
+    node->SetMPDPath(Path::GetDirectoryPath(this->url));
+
+    while(!empty && this->NextChild(depth))
+    {
+        if(this->Name() == "Period")
+            periods.push_back(this->ReadPeriod());
+        else
+            node->AddSubNode(this->ReadNode());
+    }
+
+    MPD *mpd = node->ToMPD();
+    delete node;
+
+    for(size_t i = 0; i < periods.size(); i++)
+        mpd->AddPeriod(periods.at(i));
+
+    return mpd;
+}
+Period* MPDReader::ReadPeriod               ()
+{
+    Node                            *node   = this->ReadElement();
+    int                             depth   = xmlTextReaderDepth(this->reader);
+    bool                            empty   = this->IsEmpty();
+    std::vector<AdaptationSet *>    adaptationSets;
+    SegmentList                     *segmentList = NULL;
+
+    while(!empty && this->NextChild(depth))
+    {
+        std::string name = this->Name();
+
+        if(name == "AdaptationSet")
+            adaptationSets.push_back(this->ReadAdaptationSet());
+        else if(name == "SegmentList" && segmentList == NULL)
+            segmentList = this->ReadSegmentList();
+        else
+            node->AddSubNode(this->ReadNode());
+    }
+
+    Period *period = node->ToPeriod();
+    delete node;
+
+    for(size_t i = 0; i < adaptationSets.size(); i++)
+        period->AddAdaptationSet(adaptationSets.at(i));
+
+    if(segmentList)
+        period->SetSegmentList(segmentList);
+
+    return period;
+}
+AdaptationSet*  MPDReader::ReadAdaptationSet    ()
+{
+    Node                            *node   = this->ReadElement();
+    int                             depth   = xmlTextReaderDepth(this->reader);
+    bool                            empty   = this->IsEmpty();
+    std::vector<Representation *>   representations;
+    SegmentList                     *segmentList = NULL;
+
+    while(!empty && this->NextChild(depth))
+    {
+        std::string name = this->Name();
+
+        if(name == "Representation")
+            representations.push_back(this->ReadRepresentation());
+        else if(name == "SegmentList" && segmentList == NULL)
+            segmentList = this->ReadSegmentList();
+        else
+            node->AddSubNode(this->ReadNode());
+    }
+
+    AdaptationSet *adaptationSet = node->ToAdaptationSet();
+    delete node;
+
+    for(size_t i = 0; i < representations.size(); i++)
+        adaptationSet->AddRepresentation(representations.at(i));
+
+    if(segmentList)
+        adaptationSet->SetSegmentList(segmentList);
+
+    return adaptationSet;
+}
+Representation* MPDReader::ReadRepresentation   ()
+{
+    Node        *node       = this->ReadElement();
+    int         depth       = xmlTextReaderDepth(this->reader);
+    bool        empty       = this->IsEmpty();
+    SegmentList *segmentList = NULL;
+
+    while(!empty && this->NextChild(depth))
+    {
+        if(this->Name() == "SegmentList" && segmentList == NULL)
+            segmentList = this->ReadSegmentList();
+        else
+            node->AddSubNode(this->ReadNode());
+    }
+
+    Representation *representation = node->ToRepresentation();
+    delete node;
+
+    if(segmentList)
+        representation->SetSegmentList(segmentList);
+
+    return representation;
+}
+SegmentList*    MPDReader::ReadSegmentList      ()
+{
+    Node        *node   = this->ReadElement();
+    int         depth   = xmlTextReaderDepth(this->reader);
+    bool        empty   = this->IsEmpty();
+    SegmentList segmentURLs;    /* collects the SegmentURLs until the list itself can be built */
+
+    while(!empty && this->NextChild(depth))
+    {
+        Node *child = this->ReadNode();
+
+        /* the bulk of a long MPD, converted one at a time */
+        if(child->GetName() == "SegmentURL")
+        {
+            child->AddSegmentURLTo(segmentURLs);
+            delete child;
+        }
+        else
+            node->AddSubNode(child);
+    }
+
+    SegmentList *segmentList = node->ToSegmentList();
+    delete node;
+
+    segmentList->SwapSegmentURLs(segmentURLs);
+
+    return segmentList;
+}
+Node*   MPDReader::ReadElement              ()
+{
+    Node *node = new Node();
+
+    node->SetType(Start);
+    node->SetName(this->Name());
+
+    if(xmlTextReaderHasAttributes(this->reader))
+    {
+        node->ReserveAttributes(xmlTextReaderAttributeCount(this->reader));
+
+        while(xmlTextReaderMoveToNextAttribute(this->reader))
+            node->AddAttribute((const char *) xmlTextReaderConstName(this->reader),
+                               (const char *) xmlTextReaderConstValue(this->reader));
+
+        xmlTextReaderMoveToElement(this->reader);
+    }
+
+    return node;
+}
+Node*   MPDReader::ReadNode                 ()
+{
+    Node    *node   = this->ReadElement();
+    int     depth   = xmlTextReaderDepth(this->reader);
+
+    if(this->IsEmpty())
+        return node;
+
+    while(xmlTextReaderRead(this->reader) == 1)
+    {
+        int type = xmlTextReaderNodeType(this->reader);
+
+        if(type == End && xmlTextReaderDepth(this->reader) == depth)
+            break;
+
+        if(type == Start)
+        {
+            node->AddSubNode(this->ReadNode());
+        }
+        else if(type == Text || type == XML_READER_TYPE_CDATA)
+        {
+            Node *text = new Node();
+
+            text->SetType(Text);
+            text->SetText((const char *) xmlTextReaderConstValue(this->reader));
+            node->AddSubNode(text);
+        }
+    }
+
+    return node;
+}
+bool    MPDReader::NextChild                (int depth)
+{
+    while(xmlTextReaderRead(this->reader) == 1)
+    {
+        int type = xmlTextReaderNodeType(this->reader);
+
+        if(type == End && xmlTextReaderDepth(this->reader) == depth)
+            return false;
+
+        if(type == Start)
+            return true;
+    }
+    return false;
+}
+bool    MPDReader::IsEmpty                  ()
+{
+    return xmlTextReaderIsEmptyElement(this->reader) == 1;
+}
+std::string MPDReader::Name                 ()
+{
+    const xmlChar *name = xmlTextReaderConstName(this->reader);
+
+    return name ? (const char *) name : "";
+}
@@ -0,0 +1,66 @@
+/*
+ * MPDReader.h
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#ifndef MPDREADER_H_
+#define MPDREADER_H_
+
+#include "config.h"
+
+#include "Node.h"
+#include "DOMParser.h"
+#include <libxml/xmlreader.h>
+#include "../helpers/Path.h"
+
+namespace dash
+{
+    namespace xml
+    {
+        /*
+         * One-pass alternative to DOMParser + Node::ToMPD. MPD, Period,
+         * AdaptationSet, Representation, SegmentList and SegmentURL are built
+         * straight from the reader events, so the document tree is never
+         * held in memory as a whole. Every other element is small and still
+         * goes through a Node, which keeps the conversion identical.
+         */
+        class MPDReader
+        {
+            public:
+                MPDReader           (const std::string &url);
+                virtual ~MPDReader  ();
+
+                /* the caller owns the returned MPD, NULL on error */
+                dash::mpd::MPD* ReadFile    ();
+                /* url is only used to resolve relative references */
+                dash::mpd::MPD* ReadMemory  (const char *data, size_t length);
+
+            private:
+                xmlTextReaderPtr    reader;
+                std::string         url;
+
+                dash::mpd::MPD*             Read                ();
+                dash::mpd::MPD*             ReadMPD             ();
+                dash::mpd::Period*          ReadPeriod          ();
+                dash::mpd::AdaptationSet*   ReadAdaptationSet   ();
+                dash::mpd::Representation*  ReadRepresentation  ();
+                dash::mpd::SegmentList*     ReadSegmentList     ();
+
+                /* the current element with its attributes but no children */
+                Node*   ReadElement     ();
+                /* the current element and its whole subtree */
+                Node*   ReadNode        ();
+                /* moves to the next child element of the current one; false at its end */
+                bool    NextChild       (int depth);
+                bool    IsEmpty         ();
+                std::string Name        ();
+        };
+    }
+}
+#endif /* MPDREADER_H_ */
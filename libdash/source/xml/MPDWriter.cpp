@@ -0,0 +1,396 @@
+/*
+ * MPDWriter.cpp
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#include "MPDWriter.h"
+
+#include <stdio.h>
+
+using namespace dash::xml;
+using namespace dash::mpd;
+
+#define MPD_NAMESPACE   "urn:mpeg:dash:schema:mpd:2011"
+
+MPDWriter::MPDWriter    () :
+           writer       (NULL),
+           failed       (false)
+{
+}
+MPDWriter::~MPDWriter   ()
+{
+}
+
+bool        MPDWriter::WriteFile                (const IMPD *mpd, const std::string &path)
+{
+    this->writer = xmlNewTextWriterFilename(path.c_str(), 0);
+
+    if (this->writer == NULL)
+        return false;
+
+    bool ok = this->Write(mpd);
+
+    xmlFreeTextWriter(this->writer);
+    this->writer = NULL;
+
+    return ok;
+}
+std::string MPDWriter::WriteMemory              (const IMPD *mpd)
+{
+    xmlBufferPtr buffer = xmlBufferCreate();
+
+    if (buffer == NULL)
+        return "";
+
+    this->writer = xmlNewTextWriterMemory(buffer, 0);
+
+    std::string document;
+
+    if (this->writer)
+    {
+        bool ok = this->Write(mpd);
+
+        /* flushes into the buffer */
+        xmlFreeTextWriter(this->writer);
+        this->writer = NULL;
+
+        if (ok)
+            document.assign((const char *) xmlBufferContent(buffer), xmlBufferLength(buffer));
+    }
+    xmlBufferFree(buffer);
+
+    return document;
+}
+bool        MPDWriter::Write                    (const IMPD *mpd)
+{
+    this->failed = false;
+
+    xmlTextWriterSetIndent(this->writer, 1);
+    xmlTextWriterSetIndentString(this->writer, BAD_CAST "  ");
+
+    if (xmlTextWriterStartDocument(this->writer, NULL, "UTF-8", NULL) < 0)
+        return false;
+
+    this->StartElement("MPD");
+    this->Attribute("xmlns", MPD_NAMESPACE);
+    this->OptionalAttribute("id",                           mpd->GetId());
+    this->ListAttribute("profiles",                         mpd->GetProfiles());
+    this->OptionalAttribute("type",                         mpd->GetType());
+    this->OptionalAttribute("availabilityStartTime",        mpd->GetAvailabilityStarttime());
+    this->OptionalAttribute("availabilityEndTime",          mpd->GetAvailabilityEndtime());
+    this->OptionalAttribute("publishTime",                  mpd->GetPublishTime());
+    this->OptionalAttribute("mediaPresentationDuration",    mpd->GetMediaPresentationDuration());
+    this->OptionalAttribute("minimumUpdatePeriod",          mpd->GetMinimumUpdatePeriod());
+    this->OptionalAttribute("minBufferTime",                mpd->GetMinBufferTime());
+    this->OptionalAttribute("timeShiftBufferDepth",         mpd->GetTimeShiftBufferDepth());
+    this->OptionalAttribute("suggestedPresentationDelay",   mpd->GetSuggestedPresentationDelay());
+    this->OptionalAttribute("maxSegmentDuration",           mpd->GetMaxSegmentDuration());
+    this->OptionalAttribute("maxSubsegmentDuration",        mpd->GetMaxSubsegmentDuration());
+
+    for (size_t i = 0; i < mpd->GetProgramInformations().size(); i++)
+    {
+        const IProgramInformation *info = mpd->GetProgramInformations().at(i);
+
+        this->StartElement("ProgramInformation");
+        this->OptionalAttribute("lang",                 info->GetLang());
+        this->OptionalAttribute("moreInformationURL",   info->GetMoreInformationURL());
+        if (!info->GetTitle().empty())
+            this->WriteElement("Title", info->GetTitle());
+        if (!info->GetSource().empty())
+            this->WriteElement("Source", info->GetSource());
+        if (!info->GetCopyright().empty())
+            this->WriteElement("Copyright", info->GetCopyright());
+        this->EndElement();
+    }
+    this->WriteBaseUrls(mpd->GetBaseUrls());
+    for (size_t i = 0; i < mpd->GetLocations().size(); i++)
+        this->WriteElement("Location", mpd->GetLocations().at(i));
+    for (size_t i = 0; i < mpd->GetPeriods().size(); i++)
+        this->WritePeriod(mpd->GetPeriods().at(i));
+
+    this->EndElement();
+
+    if (xmlTextWriterEndDocument(this->writer) < 0)
+        this->failed = true;
+
+    return !this->failed;
+}
+void        MPDWriter::WritePeriod              (const IPeriod *period)
+{
+    this->StartElement("Period");
+    this->OptionalAttribute("id",       period->GetId());
+    this->OptionalAttribute("start",    period->GetStart());
+    this->OptionalAttribute("duration", period->GetDuration());
+    if (period->GetBitstreamSwitching())
+        this->Attribute("bitstreamSwitching", "true");
+
+    this->WriteBaseUrls(period->GetBaseURLs());
+    this->WriteSegmentInformation(period->GetSegmentBase(), period->GetSegmentList(), period->GetSegmentTemplate());
+    for (size_t i = 0; i < period->GetAdaptationSets().size(); i++)
+        this->WriteAdaptationSet(period->GetAdaptationSets().at(i));
+
+    this->EndElement();
+}
+void        MPDWriter::WriteAdaptationSet       (const IAdaptationSet *adaptationSet)
+{
+    this->StartElement("AdaptationSet");
+    this->OptionalInteger("id",                     adaptationSet->GetId());
+    this->OptionalInteger("group",                  adaptationSet->GetGroup());
+    this->OptionalAttribute("lang",                 adaptationSet->GetLang());
+    this->OptionalAttribute("contentType",          adaptationSet->GetContentType());
+    this->OptionalAttribute("par",                  adaptationSet->GetPar());
+    this->OptionalInteger("minBandwidth",           adaptationSet->GetMinBandwidth());
+    this->OptionalInteger("maxBandwidth",           adaptationSet->GetMaxBandwidth());
+    this->OptionalInteger("minWidth",               adaptationSet->GetMinWidth());
+    this->OptionalInteger("maxWidth",               adaptationSet->GetMaxWidth());
+    this->OptionalInteger("minHeight",              adaptationSet->GetMinHeight());
+    this->OptionalInteger("maxHeight",              adaptationSet->GetMaxHeight());
+    this->OptionalAttribute("minFrameRate",         adaptationSet->GetMinFramerate());
+    this->OptionalAttribute("maxFrameRate",         adaptationSet->GetMaxFramerate());
+    if (adaptationSet->GetSegmentAligment())
+        this->Attribute("segmentAlignment", "true");
+    if (adaptationSet->GetSubsegmentAlignment())
+        this->Attribute("subsegmentAlignment", "true");
+    this->OptionalInteger("subsegmentStartsWithSAP", adaptationSet->GetSubsegmentStartsWithSAP());
+    if (adaptationSet->GetBitstreamSwitching())
+        this->Attribute("bitstreamSwitching", "true");
+    this->WriteRepresentationBase(adaptationSet);
+
+    this->WriteBaseUrls(adaptationSet->GetBaseURLs());
+    this->WriteSegmentInformation(adaptationSet->GetSegmentBase(), adaptationSet->GetSegmentList(),
+                                  adaptationSet->GetSegmentTemplate());
+    for (size_t i = 0; i < adaptationSet->GetRepresentation().size(); i++)
+        this->WriteRepresentation(adaptationSet->GetRepresentation().at(i));
+
+    this->EndElement();
+}
+void        MPDWriter::WriteRepresentation      (const IRepresentation *representation)
+{
+    this->StartElement("Representation");
+    this->Attribute("id",                   representation->GetId());
+    this->Attribute("bandwidth",            std::to_string(representation->GetBandwidth()));
+    this->OptionalInteger("qualityRanking", representation->GetQualityRanking());
+    this->ListAttribute("dependencyId",     representation->GetDependencyId());
+    this->WriteRepresentationBase(representation);
+
+    this->WriteBaseUrls(representation->GetBaseURLs());
+    this->WriteSegmentInformation(representation->GetSegmentBase(), representation->GetSegmentList(),
+                                  representation->GetSegmentTemplate());
+
+    this->EndElement();
+}
+void        MPDWriter::WriteRepresentationBase  (const IRepresentationBase *base)
+{
+    this->ListAttribute("profiles",             base->GetProfiles());
+    this->OptionalInteger("width",              base->GetWidth());
+    this->OptionalInteger("height",             base->GetHeight());
+    this->OptionalAttribute("sar",              base->GetSar());
+    this->OptionalAttribute("frameRate",        base->GetFrameRate());
+    this->OptionalAttribute("audioSamplingRate", base->GetAudioSamplingRate());
+    this->OptionalAttribute("mimeType",         base->GetMimeType());
+    this->ListAttribute("segmentProfiles",      base->GetSegmentProfiles());
+    this->ListAttribute("codecs",               base->GetCodecs());
+    this->OptionalDouble("maximumSAPPeriod",    base->GetMaximumSAPPeriod());
+    this->OptionalInteger("startWithSAP",       base->GetStartWithSAP());
+    this->OptionalDouble("maxPlayoutRate",      base->GetMaxPlayoutRate());
+    this->OptionalAttribute("scanType",         base->GetScanType());
+
+    /* the attributes are done, the children follow */
+    this->WriteDescriptors("EssentialProperty",     base->GetEssentialProperties());
+    this->WriteDescriptors("SupplementalProperty",  base->GetSupplementalProperties());
+}
+void        MPDWriter::WriteDescriptors         (const char *name, const std::vector<IDescriptor *> &descriptors)
+{
+    for (size_t i = 0; i < descriptors.size(); i++)
+    {
+        const IDescriptor *descriptor = descriptors.at(i);
+
+        this->StartElement(name);
+        this->Attribute("schemeIdUri",      descriptor->GetSchemeIdUri());
+        this->OptionalAttribute("value",    descriptor->GetValue());
+        this->OptionalAttribute("id",       descriptor->GetId());
+        this->EndElement();
+    }
+}
+void        MPDWriter::WriteBaseUrls            (const std::vector<IBaseUrl *> &baseUrls)
+{
+    for (size_t i = 0; i < baseUrls.size(); i++)
+    {
+        const IBaseUrl *url = baseUrls.at(i);
+
+        this->StartElement("BaseURL");
+        this->OptionalAttribute("serviceLocation",      url->GetServiceLocation());
+        this->OptionalAttribute("byteRange",            url->GetByteRange());
+        this->OptionalDouble("availabilityTimeOffset",  url->GetAvailabilityTimeOffset());
+        this->OptionalAttribute("timeShiftBufferDepth", url->GetTimeShiftBufferDepth());
+        if (xmlTextWriterWriteString(this->writer, BAD_CAST url->GetUrl().c_str()) < 0)
+            this->failed = true;
+        this->EndElement();
+    }
+}
+void        MPDWriter::WriteSegmentInformation  (const ISegmentBase *segmentBase, const ISegmentList *segmentList,
+                                                 const ISegmentTemplate *segmentTemplate)
+{
+    if (segmentBase)
+        this->WriteSegmentBase(segmentBase);
+    if (segmentList)
+        this->WriteSegmentList(segmentList);
+    if (segmentTemplate)
+        this->WriteSegmentTemplate(segmentTemplate);
+}
+void        MPDWriter::WriteSegmentBase         (const ISegmentBase *segmentBase)
+{
+    this->StartElement("SegmentBase");
+    this->WriteSegmentBaseAttributes(segmentBase);
+    this->WriteSegmentBaseChildren(segmentBase);
+    this->EndElement();
+}
+void        MPDWriter::WriteSegmentList         (const ISegmentList *segmentList)
+{
+    this->StartElement("SegmentList");
+    this->WriteSegmentBaseAttributes(segmentList);
+    this->WriteMultipleSegmentAttributes(segmentList);
+    this->WriteSegmentBaseChildren(segmentList);
+    this->WriteMultipleSegmentChildren(segmentList);
+
+    for (size_t i = 0; i < segmentList->GetSegmentURLs().size(); i++)
+    {
+        const ISegmentURL *url = segmentList->GetSegmentURLs().at(i);
+
+        this->StartElement("SegmentURL");
+        this->OptionalAttribute("media",        url->GetMediaURI());
+        this->OptionalAttribute("mediaRange",   url->GetMediaRange());
+        this->OptionalAttribute("index",        url->GetIndexURI());
+        this->OptionalAttribute("indexRange",   url->GetIndexRange());
+        this->EndElement();
+    }
+    this->EndElement();
+}
+void        MPDWriter::WriteSegmentTemplate     (const ISegmentTemplate *segmentTemplate)
+{
+    this->StartElement("SegmentTemplate");
+    this->WriteSegmentBaseAttributes(segmentTemplate);
+    this->WriteMultipleSegmentAttributes(segmentTemplate);
+    this->OptionalAttribute("media",                segmentTemplate->Getmedia());
+    this->OptionalAttribute("index",                segmentTemplate->Getindex());
+    this->OptionalAttribute("initialization",       segmentTemplate->Getinitialization());
+    this->OptionalAttribute("bitstreamSwitching",   segmentTemplate->GetbitstreamSwitching());
+    this->WriteSegmentBaseChildren(segmentTemplate);
+    this->WriteMultipleSegmentChildren(segmentTemplate);
+    this->EndElement();
+}
+void        MPDWriter::WriteSegmentBaseAttributes       (const ISegmentBase *segmentBase)
+{
+    /* the model defaults the timescale to 1 */
+    if (segmentBase->GetTimescale() != 1)
+        this->Attribute("timescale", std::to_string(segmentBase->GetTimescale()));
+    this->OptionalInteger("presentationTimeOffset", segmentBase->GetPresentationTimeOffset());
+    this->OptionalInteger("presentationDuration",   segmentBase->GetPresentationDuration());
+    this->OptionalAttribute("timeShiftBufferDepth", segmentBase->GetTimeShiftBufferDepth());
+    this->OptionalAttribute("indexRange",           segmentBase->GetIndexRange());
+    this->OptionalDouble("availabilityTimeOffset",  segmentBase->GetAvailabilityTimeOffset());
+}
+void        MPDWriter::WriteMultipleSegmentAttributes   (const IMultipleSegmentBase *segmentBase)
+{
+    this->OptionalInteger("duration", segmentBase->GetDuration());
+    /* the model defaults startNumber to 1 */
+    if (segmentBase->GetStartNumber() != 1)
+        this->Attribute("startNumber", std::to_string(segmentBase->GetStartNumber()));
+}
+void        MPDWriter::WriteSegmentBaseChildren         (const ISegmentBase *segmentBase)
+{
+    this->WriteURLType("Initialization",        segmentBase->GetInitialization());
+    this->WriteURLType("RepresentationIndex",   segmentBase->GetRepresentationIndex());
+}
+void        MPDWriter::WriteMultipleSegmentChildren     (const IMultipleSegmentBase *segmentBase)
+{
+    const ISegmentTimeline *timeline = segmentBase->GetSegmentTimeline();
+
+    if (timeline)
+    {
+        this->StartElement("SegmentTimeline");
+        for (size_t i = 0; i < timeline->GetTimelines().size(); i++)
+        {
+            const ITimeline *s = timeline->GetTimelines().at(i);
+
+            this->StartElement("S");
+            if (i == 0 || s->GetStartTime() != 0)
+                this->Attribute("t", std::to_string(s->GetStartTime()));
+            this->Attribute("d", std::to_string(s->GetDuration()));
+            /* an open-ended run is read as r="-1" wrapped to the unsigned model */
+            if (s->GetRepeatCount() == UINT32_MAX)
+                this->Attribute("r", "-1");
+            else
+                this->OptionalInteger("r", s->GetRepeatCount());
+            this->EndElement();
+        }
+        this->EndElement();
+    }
+    this->WriteURLType("BitstreamSwitching", segmentBase->GetBitstreamSwitching());
+}
+void        MPDWriter::WriteURLType             (const char *name, const IURLType *url)
+{
+    if (url == NULL)
+        return;
+
+    this->StartElement(name);
+    this->OptionalAttribute("sourceURL",    url->GetSourceURL());
+    this->OptionalAttribute("range",        url->GetRange());
+    this->EndElement();
+}
+
+void        MPDWriter::StartElement             (const char *name)
+{
+    if (xmlTextWriterStartElement(this->writer, BAD_CAST name) < 0)
+        this->failed = true;
+}
+void        MPDWriter::EndElement               ()
+{
+    if (xmlTextWriterEndElement(this->writer) < 0)
+        this->failed = true;
+}
+void        MPDWriter::WriteElement             (const char *name, const std::string &content)
+{
+    if (xmlTextWriterWriteElement(this->writer, BAD_CAST name, BAD_CAST content.c_str()) < 0)
+        this->failed = true;
+}
+void        MPDWriter::Attribute                (const char *name, const std::string &value)
+{
+    if (xmlTextWriterWriteAttribute(this->writer, BAD_CAST name, BAD_CAST value.c_str()) < 0)
+        this->failed = true;
+}
+void        MPDWriter::OptionalAttribute        (const char *name, const std::string &value)
+{
+    if (!value.empty())
+        this->Attribute(name, value);
+}
+void        MPDWriter::OptionalInteger          (const char *name, uint64_t value)
+{
+    if (value != 0)
+        this->Attribute(name, std::to_string(value));
+}
+void        MPDWriter::OptionalDouble           (const char *name, double value)
+{
+    if (value == 0)
+        return;
+
+    char text[32];
+
+    snprintf(text, sizeof(text), "%.10g", value);
+    this->Attribute(name, text);
+}
+void        MPDWriter::ListAttribute            (const char *name, const std::vector<std::string> &values)
+{
+    std::string value;
+
+    for (size_t i = 0; i < values.size(); i++)
+        value += (i == 0 ? "" : ",") + values.at(i);
+
+    this->OptionalAttribute(name, value);
+}
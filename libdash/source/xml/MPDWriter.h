@@ -0,0 +1,83 @@
+/*
+ * MPDWriter.h
+ *****************************************************************************
+ * Copyright (C) 2012, bitmovin Softwareentwicklung OG, All Rights Reserved
+ *
+ * Email: libdash-dev@vicky.bitmovin.net
+ *
+ * This source code and its use and distribution, is subject to the terms
+ * and conditions of the applicable license agreement.
+ *****************************************************************************/
+
+#ifndef MPDWRITER_H_
+#define MPDWRITER_H_
+
+#include "config.h"
+
+#include "IMPD.h"
+#include <libxml/xmlwriter.h>
+
+namespace dash
+{
+    namespace xml
+    {
+        /*
+         * Serializes an MPD object model, e.g. one built by a packager, to
+         * an MPD document that MPDReader reads back to the same model. The
+         * elements written are the ones that address media: ProgramInformation,
+         * BaseURL, Location, Period, AdaptationSet, Representation and their
+         * SegmentBase, SegmentList, SegmentTemplate and SegmentTimeline, and
+         * the EssentialProperty and SupplementalProperty descriptors of
+         * AdaptationSets and Representations.
+         * Attributes are left out when they hold the default of the model.
+         */
+        class MPDWriter
+        {
+            public:
+                MPDWriter           ();
+                virtual ~MPDWriter  ();
+
+                bool        WriteFile   (const dash::mpd::IMPD *mpd, const std::string &path);
+                /* the document, empty on error */
+                std::string WriteMemory (const dash::mpd::IMPD *mpd);
+
+            private:
+                xmlTextWriterPtr    writer;
+                bool                failed;
+
+                bool    Write                   (const dash::mpd::IMPD *mpd);
+                void    WritePeriod             (const dash::mpd::IPeriod *period);
+                void    WriteAdaptationSet      (const dash::mpd::IAdaptationSet *adaptationSet);
+                void    WriteRepresentation     (const dash::mpd::IRepresentation *representation);
+                void    WriteRepresentationBase (const dash::mpd::IRepresentationBase *base);
+                /* the children of RepresentationBase that come first, before BaseURL */
+                void    WriteDescriptors        (const char *name, const std::vector<dash::mpd::IDescriptor *> &descriptors);
+                void    WriteBaseUrls           (const std::vector<dash::mpd::IBaseUrl *> &baseUrls);
+                void    WriteSegmentInformation (const dash::mpd::ISegmentBase *segmentBase,
+                                                 const dash::mpd::ISegmentList *segmentList,
+                                                 const dash::mpd::ISegmentTemplate *segmentTemplate);
+                void    WriteSegmentBase        (const dash::mpd::ISegmentBase *segmentBase);
+                void    WriteSegmentList        (const dash::mpd::ISegmentList *segmentList);
+                void    WriteSegmentTemplate    (const dash::mpd::ISegmentTemplate *segmentTemplate);
+                /* attributes and children common to SegmentBase, SegmentList and SegmentTemplate */
+                void    WriteSegmentBaseAttributes      (const dash::mpd::ISegmentBase *segmentBase);
+                void    WriteMultipleSegmentAttributes  (const dash::mpd::IMultipleSegmentBase *segmentBase);
+                void    WriteSegmentBaseChildren        (const dash::mpd::ISegmentBase *segmentBase);
+                void    WriteMultipleSegmentChildren    (const dash::mpd::IMultipleSegmentBase *segmentBase);
+                void    WriteURLType            (const char *name, const dash::mpd::IURLType *url);
+
+                void    StartElement    (const char *name);
+                void    EndElement      ();
+                void    WriteElement    (const char *name, const std::string &content);
+                void    Attribute       (const char *name, const std::string &value);
+                /* only if value is not empty */
+                void    OptionalAttribute       (const char *name, const std::string &value);
+                /* only if value is not zero */
+                void    OptionalInteger         (const char *name, uint64_t value);
+                void    OptionalDouble          (const char *name, double value);
+                /* comma separated */
+                void    ListAttribute   (const char *name, const std::vector<std::string> &values);
+        };
+    }
+}
+#endif /* MPDWRITER_H_ */
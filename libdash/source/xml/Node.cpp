@@ -19,14 +19,16 @@
 using namespace dash::xml;
 using namespace dash::metrics;
 
-Node::Node  ()
+Node::Node  () :
+    attributeMapBuilt(false)
 {
 }
 Node::Node  (const Node& other) :
+    attributes(other.attributes),
+    attributeMapBuilt(false),
     name(other.name),
     text(other.text),
-    type(other.type),
-    attributes(other.attributes)
+    type(other.type)
 {
     for (size_t i = 0; i < other.subNodes.size(); i++)
         this->subNodes.push_back(new Node(*(other.subNodes.at(i))));
@@ -363,6 +365,26 @@ dash::mpd::SegmentURL*                      Node::ToSegmentURL          ()  cons
     segmentUrl->AddRawAttributes(this->attributes);
     return segmentUrl;
 }
+void                                        Node::AddSegmentURLTo       (dash::mpd::SegmentList& segmentList)  const
+{
+    bool plain = this->subNodes.empty();
+
+    for(size_t i = 0; plain && i < this->attributes.size(); i++)
+    {
+        const std::string &name = *this->attributes.at(i).name;
+
+        plain = name == "media" || name == "mediaRange" || name == "index" || name == "indexRange";
+    }
+
+    if(!plain)
+    {
+        segmentList.AddSegmentURL(this->ToSegmentURL());
+        return;
+    }
+
+    segmentList.AddSegmentURL(this->GetAttributeValue("media"), this->GetAttributeValue("mediaRange"),
+                              this->GetAttributeValue("index"), this->GetAttributeValue("indexRange"));
+}
 dash::mpd::SegmentList*                     Node::ToSegmentList         ()  const
 {
     dash::mpd::SegmentList* segmentList = new dash::mpd::SegmentList();
@@ -391,7 +413,7 @@ dash::mpd::SegmentList*                     Node::ToSegmentList         ()  cons
     {
         if (subNodes.at(i)->GetName() == "SegmentURL")
         {
-            segmentList->AddSegmentURL(subNodes.at(i)->ToSegmentURL());
+            subNodes.at(i)->AddSegmentURLTo(*segmentList);
             continue;
         }
         if (subNodes.at(i)->GetName() != "SegmentTimeline" && subNodes.at(i)->GetName() != "BitstreamSwitching" &&
@@ -1706,29 +1728,43 @@ void                                        Node::SetName               (const s
 }
 const std::string&                          Node::GetAttributeValue     (std::string key)   const
 {
-    //return this->attributes[key];
-    return this->attributes.find(key)->second;
+    return this->GetAttributeValue(key.c_str());
 }
-bool                                        Node::HasAttribute          (const std::string& name) const
+const std::string&                          Node::GetAttributeValue     (const char *key)   const
 {
-    if(this->attributes.find(name) != this->attributes.end())
-        return true;
+    static const std::string    empty;
+    const helpers::Attribute    *attribute = helpers::Attributes::Find(this->attributes, key);
 
-    return false;
+    return attribute ? attribute->value : empty;
+}
+bool                                        Node::HasAttribute          (const std::string& name) const
+{
+    return this->HasAttribute(name.c_str());
+}
+bool                                        Node::HasAttribute          (const char *name) const
+{
+    return helpers::Attributes::Find(this->attributes, name) != NULL;
 }
 void                                        Node::AddAttribute          (const std::string &key, const std::string &value)
 {
-    this->attributes[key] = value;
+    this->AddAttribute(key.c_str(), value.c_str());
+}
+void                                        Node::AddAttribute          (const char *key, const char *value)
+{
+    helpers::Attributes::Set(this->attributes, key, value);
+    this->attributeMapBuilt = false;
+}
+void                                        Node::ReserveAttributes     (size_t count)
+{
+    this->attributes.reserve(count);
 }
 std::vector<std::string>                    Node::GetAttributeKeys      ()  const
 {
     std::vector<std::string> keys;
-    std::map<std::string, std::string>::const_iterator it;
 
-    for(it = this->attributes.begin(); it != this->attributes.end(); ++it)
-    {
-        keys.push_back(it->first);
-    }
+    for(size_t i = 0; i < this->attributes.size(); i++)
+        keys.push_back(*this->attributes[i].name);
+
     return keys;
 }
 bool                                        Node::HasText               ()  const
@@ -1762,7 +1798,12 @@ void                                        Node::Print                 (std::os
 }
 const std::map<std::string,std::string>&    Node::GetAttributes         ()  const
 {
-    return this->attributes;
+    if(!this->attributeMapBuilt)
+    {
+        this->attributeMap      = helpers::Attributes::ToMap(this->attributes);
+        this->attributeMapBuilt = true;
+    }
+    return this->attributeMap;
 }
 int                                         Node::GetType               ()  const
 {
@@ -20,6 +20,7 @@
 
 #include "INode.h"
 #include "../helpers/String.h"
+#include "../helpers/Attributes.h"
 #include "../mpd/AdaptationSet.h"
 #include "../mpd/BaseUrl.h"
 #include "../mpd/ContentComponent.h"
@@ -88,10 +89,15 @@ namespace dash
                 int                                         GetType             ()  const;
                 void                                        SetType             (int type);
                 const std::string&                          GetAttributeValue   (std::string key) const;
+                /* no temporary string for a literal key; empty if absent */
+                const std::string&                          GetAttributeValue   (const char *key) const;
                 void                                        AddSubNode          (Node *node);
                 void                                        SetName             (const std::string &name);
                 bool                                        HasAttribute        (const std::string& name) const;
+                bool                                        HasAttribute        (const char *name) const;
                 void                                        AddAttribute        (const std::string &key, const std::string &value);
+                void                                        AddAttribute        (const char *key, const char *value);
+                void                                        ReserveAttributes   (size_t count);
                 bool                                        HasText             ()  const;
                 void                                        SetText             (const std::string &text);
                 void                                        Print               (std::ostream &stream)  const;
@@ -99,6 +105,9 @@ namespace dash
                 void                                        SetMPDPath          (std::string path);
 
             private:
+                /* builds the large containers itself and converts the rest through Nodes */
+                friend class MPDReader;
+
                 void                                        SetCommonValuesForDesc  (dash::mpd::Descriptor& object) const;
                 void                                        SetCommonValuesForRep   (dash::mpd::RepresentationBase& object) const;
                 void                                        SetCommonValuesForSeg   (dash::mpd::SegmentBase& object) const;
@@ -140,6 +149,8 @@ namespace dash
                 dash::mpd::Timeline*                        ToTimeline              ()  const;
                 dash::mpd::SegmentTimeline*                 ToSegmentTimeline       ()  const;
                 dash::mpd::SegmentURL*                      ToSegmentURL            ()  const;
+                /* a table row when media, mediaRange, index and indexRange are all there is, else ToSegmentURL */
+                void                                        AddSegmentURLTo         (dash::mpd::SegmentList& segmentList)  const;
                 dash::mpd::SubRepresentation*               ToSubRepresentation     ()  const;
                 dash::mpd::Subset*                          ToSubset                ()  const;
                 dash::mpd::Switching*                       ToSwitching             ()  const;
@@ -148,7 +159,9 @@ namespace dash
                 dash::mpd::URLType*                         ToURLType               (dash::metrics::HTTPTransactionType transActType)  const;
 
                 std::vector<Node *>                 subNodes;
-                std::map<std::string, std::string>  attributes;
+                helpers::AttributeList              attributes;
+                mutable std::map<std::string, std::string>  attributeMap;   /* GetAttributes() only, built on its first call */
+                mutable bool                        attributeMapBuilt;
                 std::string                         name;
                 std::string                         text;
                 int                                 type;
@@ -17,13 +17,18 @@ using namespace dash::network;
 HTTPChunk::HTTPChunk        (IChunk *chunk) :
            chunk            (chunk),
            contentLength    (0),
+           resourceLength   (-1),
            isHeaderParsed   (false),
            bytesLeft        (0),
-           bytesRead        (0)
+           bytesRead        (0),
+           isChunked        (false),
+           isLastChunk      (false)
 {
+    this->transaction = new dash::metrics::HTTPTransaction();
 }
 HTTPChunk::~HTTPChunk       ()
 {
+    delete this->transaction;
 }
 
 IChunk*     HTTPChunk::Chunk            ()
@@ -34,6 +39,14 @@ uint64_t    HTTPChunk::ContentLength    () const
 {
     return this->contentLength;
 }
+int64_t     HTTPChunk::ResourceLength   () const
+{
+    return this->resourceLength;
+}
+void        HTTPChunk::ResourceLength   (int64_t length)
+{
+    this->resourceLength = length;
+}
 bool        HTTPChunk::HeaderParsed     () const
 {
     return this->isHeaderParsed;
@@ -65,3 +78,35 @@ uint64_t    HTTPChunk::BytesLeft        () const
 {
     return this->bytesLeft;
 }
+bool        HTTPChunk::Chunked          () const
+{
+    return this->isChunked;
+}
+void        HTTPChunk::Chunked          (bool value)
+{
+    this->isChunked = value;
+}
+void        HTTPChunk::NextChunk        (uint64_t size)
+{
+    this->contentLength += size;
+    this->bytesLeft      = size;
+    this->isLastChunk    = size == 0;
+}
+bool        HTTPChunk::Finished         () const
+{
+    if(this->isChunked)
+        return this->isLastChunk;
+
+    return this->bytesLeft == 0;
+}
+dash::metrics::HTTPTransaction* HTTPChunk::Transaction          ()
+{
+    return this->transaction;
+}
+dash::metrics::HTTPTransaction* HTTPChunk::ReleaseTransaction   ()
+{
+    dash::metrics::HTTPTransaction *transaction = this->transaction;
+
+    this->transaction = NULL;
+    return transaction;
+}
@@ -13,6 +13,7 @@
 #define HTTPCHUNK_H_
 
 #include "IChunk.h"
+#include "../libdash/source/metrics/HTTPTransaction.h"
 
 namespace libdashtest
 {
@@ -24,21 +25,38 @@ namespace libdashtest
 
             dash::network::IChunk*  Chunk           ();
             uint64_t                ContentLength   () const;
+            int64_t                 ResourceLength  () const;
             uint64_t                BytesLeft       () const;
             uint64_t                BytesRead       () const;
             bool                    HeaderParsed    () const;
+            /* Transfer-Encoding: chunked; BytesLeft() then refers to the
+             * current chunk and ContentLength() grows with every chunk */
+            bool                    Chunked         () const;
+            /* everything of the response has been read */
+            bool                    Finished        () const;
+            /* metrics of this request, owned by the HTTPChunk until released */
+            dash::metrics::HTTPTransaction* Transaction         ();
+            dash::metrics::HTTPTransaction* ReleaseTransaction  ();
 
             void        HeaderParsed    (bool value);
             void        ContentLength   (uint64_t length);
+            void        ResourceLength  (int64_t length);
             void        BytesRead       (uint64_t bytes);
             void        AddBytesRead    (uint64_t bytes);
+            void        Chunked         (bool value);
+            /* size 0 is the last chunk */
+            void        NextChunk       (uint64_t size);
 
         private:
             dash::network::IChunk   *chunk;
             uint64_t                contentLength;
+            int64_t                 resourceLength;
             uint64_t                bytesLeft;
             uint64_t                bytesRead;
             bool                    isHeaderParsed;
+            bool                    isChunked;
+            bool                    isLastChunk;
+            dash::metrics::HTTPTransaction  *transaction;
     };
 }
 
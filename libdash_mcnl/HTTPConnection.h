@@ -14,14 +14,35 @@
 
 #include "../libdash/source/portable/Networking.h"
 #include "IConnection.h"
+#include "../libdash/source/metrics/HTTPTransaction.h"
+#include "../libdash/source/metrics/TCPConnection.h"
 
 #include <sstream>
 #include <stdint.h>
 
-#define PEEKBUFFER 4096
+#define RECVBUFFER 16384
 
 namespace libdashtest
 {
+    /* what the last parsed response header said besides its length */
+    struct HTTPResponseInfo
+    {
+        int             status;         /* e.g. 200, 304; 0 if the status line was unreadable */
+        std::string     etag;
+        std::string     lastModified;
+        std::string     contentEncoding;    /* e.g. gzip when asked for with Accept-Encoding; empty if plain */
+    };
+
+    /* the kernel's view of a connection while it downloads, see SampleTCP */
+    struct TCPInfoSample
+    {
+        double          rtt;                /* seconds, smoothed */
+        double          rttVariance;        /* seconds */
+        uint32_t        congestionWindow;   /* segments */
+        uint32_t        retransmits;        /* over the connection's lifetime */
+        double          deliveryRate;       /* bits per second, 0 if the kernel does not tell */
+    };
+
     class HTTPConnection : public dash::network::IConnection
     {
         public:
@@ -34,19 +55,31 @@ namespace libdashtest
             virtual bool    Schedule    (dash::network::IChunk *chunk);
             virtual void    CloseSocket ();
 
+            /* for a PersistentHTTPConnection valid right after ResponseLength,
+             * until the response body has been read */
+            const HTTPResponseInfo& LastResponse    () const;
+
+            /* TCP_INFO of the open socket, also kept in its TCPConnection record; false
+             * without a socket and off Linux */
+            bool    SampleTCP   (TCPInfoSample &sample);
+
             /*
-             *  IDASHMetrics
+             *  IDASHMetrics: one TCPConnection per socket opened, filled in by
+             *  ConnectToHost and CloseSocket
              */
             const std::vector<dash::metrics::ITCPConnection *>&     GetTCPConnectionList    () const;
             const std::vector<dash::metrics::IHTTPTransaction *>&   GetHTTPTransactionList  () const;
 
         protected:
             int                 httpSocket;
-            struct sockaddr_in  addr;
-            struct hostent      *hostent;
-            uint8_t             *peekBuffer;
-            size_t              peekBufferLen;
+            uint8_t             *recvBuffer;        /* bytes received but not consumed yet */
+            size_t              recvBufferPos;
+            size_t              recvBufferLen;
             int                 contentLength;
+            int64_t             resourceLength;     /* from Content-Range, -1 if absent */
+            bool                isChunked;          /* Transfer-Encoding: chunked */
+            HTTPResponseInfo    response;
+            dash::metrics::TCPConnection    *tcpConnection;     /* record of the open socket, NULL if none */
             bool                isInit;
             bool                isScheduled;
 
@@ -57,7 +90,9 @@ namespace libdashtest
             virtual bool        SendData        (std::string data);
             virtual bool        ParseHeader     ();
             virtual std::string ReadLine        ();
+            std::string         HeaderValue     (const std::string &line, size_t nameLength);
             virtual bool        ConnectToHost   (std::string host, int port);
+            int                 FillBuffer      ();
     };
 }
 
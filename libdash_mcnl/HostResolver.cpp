@@ -0,0 +1,164 @@
+/*
+ * HostResolver.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Client
+ *****************************************************************************/
+
+#include "HostResolver.h"
+
+#include <chrono>
+#include <cstdlib>
+
+using namespace libdashtest;
+
+static uint64_t     NowMs   ()
+{
+    return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static std::string  Key     (const std::string &host, int port)
+{
+    return host + ":" + std::to_string(port);
+}
+
+HostResolver::HostResolver      () :
+              stopping          (false)
+{
+    this->thread = std::thread(&HostResolver::Work, this);
+}
+HostResolver::~HostResolver     ()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        this->stopping = true;
+        this->queued.notify_all();
+        this->answered.notify_all();
+    }
+    this->thread.join();
+}
+
+HostResolver&                   HostResolver::Instance  ()
+{
+    static HostResolver resolver;
+    return resolver;
+}
+
+void                            HostResolver::Prefetch  (const std::string &host, int port)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->Lookup(Key(host, port));
+}
+std::vector<ResolvedAddress>    HostResolver::Resolve   (const std::string &host, int port)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    std::string key   = Key(host, port);
+    Entry       *entry = &this->Lookup(key);
+
+    /* only a host never answered for is waited for; the map never drops entries */
+    this->answered.wait(lock, [this, entry]() { return this->stopping || entry->resolvedAt > 0 || !entry->pending; });
+
+    return entry->addresses;
+}
+
+HostResolver::Entry&            HostResolver::Lookup    (const std::string &key)
+{
+    std::map<std::string, Entry>::iterator found = this->entries.find(key);
+
+    if (found == this->entries.end())
+    {
+        Entry entry;
+
+        entry.resolvedAt = 0;
+        entry.pending    = false;
+        entry.failed     = false;
+        found = this->entries.insert(std::make_pair(key, entry)).first;
+    }
+
+    Entry &entry = found->second;
+    bool  stale  = entry.resolvedAt == 0 || entry.failed ||
+                   NowMs() - entry.resolvedAt >= (uint64_t) HOST_RESOLVER_TTL * 1000;
+
+    if (stale && !entry.pending)
+    {
+        entry.pending = true;
+        this->queue.push_back(key);
+        this->queued.notify_one();
+    }
+    return entry;
+}
+void                            HostResolver::Work      ()
+{
+#if defined _WIN32 || defined _WIN64
+    WSADATA info;
+
+    if (WSAStartup(MAKEWORD(2,0), &info))
+        return;
+#endif
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (true)
+    {
+        this->queued.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+        if (this->stopping)
+            break;
+
+        std::string key = this->queue.front();
+
+        this->queue.pop_front();
+        lock.unlock();
+
+        size_t      colon = key.rfind(':');
+        std::string host  = key.substr(0, colon);
+        std::string port  = key.substr(colon + 1);
+        addrinfo    hints;
+        addrinfo    *results = NULL;
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+
+        std::vector<ResolvedAddress> addresses;
+
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &results) == 0)
+        {
+            for (addrinfo *result = results; result != NULL; result = result->ai_next)
+            {
+                ResolvedAddress address;
+
+                if (result->ai_addrlen > sizeof(address.address))
+                    continue;
+
+                memset(&address.address, 0, sizeof(address.address));
+                memcpy(&address.address, result->ai_addr, result->ai_addrlen);
+                address.length = (socklen_t) result->ai_addrlen;
+                address.family = result->ai_family;
+                addresses.push_back(address);
+            }
+            freeaddrinfo(results);
+        }
+
+        lock.lock();
+
+        Entry &entry = this->entries[key];
+
+        /* a failed lookup keeps the last good answer, it is tried again on the next use */
+        entry.pending = false;
+        entry.failed  = addresses.empty();
+        if (!addresses.empty())
+        {
+            entry.addresses  = addresses;
+            entry.resolvedAt = NowMs();
+        }
+        this->answered.notify_all();
+    }
+    lock.unlock();
+
+#if defined _WIN32 || defined _WIN64
+    WSACleanup();
+#endif
+}
@@ -35,13 +35,13 @@ using namespace libdashtest;
 using namespace std;
 using namespace dash::mpd;
 
-//const string filepath = "/video/loot.mpd";
+const string filepath = "/video/loot.mpd";
 const int BIN_COUNT = 10;
 
 void download(IConnection *connection, IChunk *chunk, ofstream *file)
 {
-    int     len     = 32768;
-    uint8_t *p_data = new uint8_t[32768];
+    uint8_t p_data[32768];
+    int     len     = sizeof(p_data);
 
     int ret = 0;
     do
@@ -99,29 +99,23 @@ int main(int argc, char*argv[])
 	IMPD *mpd = manager->Open("mcnl.mpd");
 	std::string baseUrl;
 	baseUrl = mpd->GetBaseUrls().at(0)->GetUrl();
-	string high[BIN_COUNT], mid[BIN_COUNT], low[BIN_COUNT];
-	for(int i=0;i<BIN_COUNT;i++){
-		high[i] = mpd->GetPeriods().at(0)->GetAdaptationSets().at(0)->GetRepresentation().at(0)->GetSegmentList()->GetSegmentURLs().at(i)->GetMediaURI();
-		mid[i] = mpd->GetPeriods().at(0)->GetAdaptationSets().at(0)->GetRepresentation().at(1)->GetSegmentList()->GetSegmentURLs().at(i)->GetMediaURI();
-		low[i] = mpd->GetPeriods().at(0)->GetAdaptationSets().at(0)->GetRepresentation().at(2)->GetSegmentList()->GetSegmentURLs().at(i)->GetMediaURI();
-	}
+	// only the requested segment of the requested quality is looked up
+	const std::vector<IRepresentation *> &reps = mpd->GetPeriods().at(0)->GetAdaptationSets().at(0)->GetRepresentation();
+	size_t rep = !strcmp(quality,"High") ? 0 : !strcmp(quality,"Mid") ? 1 : 2;
+	std::string media = reps.at(rep)->GetSegmentList()->GetSegmentMediaURI(number);
 
-	double HIGH_QUALITY = mpd->GetPeriods().at(0)->GetAdaptationSets().at(0)->GetRepresentation().at(0)->GetBandwidth();
-	double MID_QUALITY = mpd->GetPeriods().at(0)->GetAdaptationSets().at(0)->GetRepresentation().at(1)->GetBandwidth();
-	double LOW_QUALITY = mpd->GetPeriods().at(0)->GetAdaptationSets().at(0)->GetRepresentation().at(2)->GetBandwidth();
+	double HIGH_QUALITY = reps.at(0)->GetBandwidth();
+	double MID_QUALITY = reps.at(1)->GetBandwidth();
+	double LOW_QUALITY = reps.at(2)->GetBandwidth();
 
 	std::string  fileName, urls;
-	if(!strcmp(quality,"High")) fileName = high[number];
-	else if(!strcmp(quality,"Mid")) fileName = mid[number];
-	else fileName = low[number];
+	fileName = media;
 
 	int idx = fileName.find("/");
 	fileName= fileName.substr(idx + 1);
 	cout << "fileName : " << fileName << endl;
 
-	if(!strcmp(quality,"High")) urls = baseUrl + high[number];
-	else if(!strcmp(quality,"Mid")) urls = baseUrl + mid[number];
-	else urls = baseUrl + low[number];
+	urls = baseUrl + media;
 
 	cout << "*****************************************" << endl;
 	cout << "* Download files with external HTTP 1.0 *" << endl;
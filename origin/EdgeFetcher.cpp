@@ -0,0 +1,283 @@
+/*
+ * EdgeFetcher.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *****************************************************************************/
+
+#include "EdgeFetcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace mcnl;
+
+#define EDGE_MAX_HEADER     (16 << 10)
+
+static bool         EndsWith        (const std::string &text, const std::string &end)
+{
+    return text.size() >= end.size() && text.compare(text.size() - end.size(), end.size(), end) == 0;
+}
+static bool         SendAll         (int socket, const std::string &data)
+{
+    size_t sent = 0;
+
+    while (sent < data.size())
+    {
+        ssize_t n = send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+static int          Connect         (const std::string &host, size_t port)
+{
+    addrinfo    hints;
+    addrinfo    *addresses = NULL;
+    int         fd         = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+        return -1;
+
+    for (addrinfo *address = addresses; address != NULL && fd < 0; address = address->ai_next)
+    {
+        fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0)
+            continue;
+
+        timeval timeout;
+        timeout.tv_sec  = EDGE_UPSTREAM_TIMEOUT;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        if (connect(fd, address->ai_addr, address->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+
+    return fd;
+}
+
+EdgeFetcher::EdgeFetcher        (const std::string &root, const std::string &host, size_t port, size_t threads,
+                                 MetricsRegistry &registry) :
+             root               (root),
+             host               (host),
+             port               (port),
+             upstreamRequests   (registry.Counter("edge_upstream_requests_total", "Requests sent to the upstream.")),
+             collapsedRequests  (registry.Counter("edge_collapsed_requests_total",
+                                                  "Requests that waited for a fetch of the same path under way.")),
+             upstreamFailures   (registry.Counter("edge_upstream_failures_total",
+                                                  "Upstream requests that did not bring the file.")),
+             upstreamBytes      (registry.Counter("edge_upstream_bytes_total", "Body bytes from the upstream.")),
+             upstreamSeconds    (registry.Histogram("edge_upstream_seconds", "Time of a fetch from the upstream.",
+                                                    { 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5 })),
+             stopping           (false)
+{
+    while (this->root.size() > 1 && this->root.back() == '/')
+        this->root.pop_back();
+
+    for (size_t i = 0; i < (threads > 0 ? threads : 1); i++)
+        this->threads.push_back(std::thread(&EdgeFetcher::Work, this));
+}
+EdgeFetcher::~EdgeFetcher       ()
+{
+    this->Stop();
+}
+
+void        EdgeFetcher::Fetch          (const std::string &path, const Done &done)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    std::vector<Done> &waiting = this->waiting[path];
+
+    if (!waiting.empty())
+        this->collapsedRequests.Add();
+    else
+    {
+        this->queue.push_back(path);
+        this->queued.notify_one();
+    }
+    waiting.push_back(done);
+}
+void        EdgeFetcher::Stop           ()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (this->stopping)
+            return;
+        this->stopping = true;
+        this->queue.clear();
+        this->queued.notify_all();
+    }
+
+    for (size_t i = 0; i < this->threads.size(); i++)
+        this->threads.at(i).join();
+}
+
+void        EdgeFetcher::Work           ()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    while (true)
+    {
+        this->queued.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+        if (this->queue.empty())
+            return;
+
+        std::string path = this->queue.front();
+
+        this->queue.pop_front();
+        lock.unlock();
+
+        std::chrono::steady_clock::time_point   start  = std::chrono::steady_clock::now();
+        int                                     status = 0;
+
+        this->upstreamRequests.Add();
+        if (!this->Download(path, status))
+        {
+            this->upstreamFailures.Add();
+            /* gone upstream; a manifest copy is kept only when the upstream is not there */
+            if (status == 404)
+                remove((this->root + path).c_str());
+        }
+        this->upstreamSeconds.Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        lock.lock();
+
+        /* the requests that came meanwhile are answered by this fetch too */
+        std::vector<Done> done;
+
+        done.swap(this->waiting[path]);
+        this->waiting.erase(path);
+        lock.unlock();
+        for (size_t i = 0; i < done.size(); i++)
+            done.at(i)();
+        lock.lock();
+    }
+}
+bool        EdgeFetcher::Download       (const std::string &path, int &status)
+{
+    int fd = Connect(this->host, this->port);
+
+    if (fd < 0)
+        return false;
+
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + this->host +
+                          (this->port != 80 ? ":" + std::to_string(this->port) : "") +
+                          "\r\nConnection: close\r\n\r\n";
+    std::string header;
+    size_t      end = std::string::npos;
+
+    if (!SendAll(fd, request))
+    {
+        close(fd);
+        return false;
+    }
+    while (end == std::string::npos && header.size() <= EDGE_MAX_HEADER)
+    {
+        char    data[4096];
+        ssize_t received = recv(fd, data, sizeof(data), 0);
+
+        if (received <= 0)
+            break;
+        header.append(data, received);
+        end = header.find("\r\n\r\n");
+    }
+    if (end == std::string::npos || sscanf(header.c_str(), "HTTP/%*d.%*d %d", &status) != 1 || status != 200)
+    {
+        close(fd);
+        return false;
+    }
+
+    /* Content-Length if given, else up to the close */
+    uint64_t    length = UINT64_MAX;
+    std::string lower  = header.substr(0, end);
+
+    for (size_t i = 0; i < lower.size(); i++)
+        lower[i] = (char) tolower((unsigned char) lower[i]);
+
+    size_t at = lower.find("\r\ncontent-length:");
+
+    if (at != std::string::npos)
+        length = strtoull(lower.c_str() + at + 17, NULL, 10);
+    if (lower.find("\r\ntransfer-encoding:") != std::string::npos)
+    {
+        /* chunked bodies are not expected from an origin serving files */
+        close(fd);
+        return false;
+    }
+
+    std::string target    = this->root + path;
+    std::string temporary = target + ".part";
+
+    if (!this->MakeDirectories(target))
+    {
+        close(fd);
+        return false;
+    }
+
+    FILE        *file     = fopen(temporary.c_str(), "wb");
+    std::string body      = header.substr(end + 4);
+    uint64_t    written   = 0;
+    bool        ok        = file != NULL;
+
+    while (ok)
+    {
+        if (!body.empty())
+        {
+            size_t count = (size_t) std::min<uint64_t>(body.size(), length - written);
+
+            ok       = fwrite(body.data(), 1, count, file) == count;
+            written += count;
+            this->upstreamBytes.Add((double) count);
+        }
+        if (!ok || written == length)
+            break;
+
+        char    data[64 << 10];
+        ssize_t received = recv(fd, data, sizeof(data), 0);
+
+        if (received < 0)
+            ok = false;
+        if (received <= 0)
+            break;
+        body.assign(data, received);
+    }
+    close(fd);
+
+    ok = file != NULL && fclose(file) == 0 && ok && (length == UINT64_MAX || written == length);
+    if (!ok || rename(temporary.c_str(), target.c_str()) != 0)
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+bool        EdgeFetcher::MakeDirectories    (const std::string &path)
+{
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+    {
+        std::string directory = path.substr(0, slash);
+
+        if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+    }
+    return !EndsWith(path, "/");
+}
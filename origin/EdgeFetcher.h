@@ -0,0 +1,77 @@
+/*
+ * EdgeFetcher.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *
+ * Upstream side of an OriginServer run as a LAN edge cache (--upstream):
+ * a path that is not on the edge yet is fetched from the upstream origin
+ * with HTTP/1.1 into the edge's root directory, under a temporary name
+ * that is renamed into place once complete, and from there it is served
+ * like any other file. Requests for a path whose fetch is under way wait
+ * for that one (request collapsing), so the upstream sees each segment
+ * once however many viewers ask for it at the same time.
+ *
+ * MPDs change while a live content goes on, so they are fetched for every
+ * request, still collapsed; when the upstream cannot be reached the copy
+ * on the edge is served. The edge's root only grows, it is a cache that
+ * may be emptied whenever no session is running.
+ *****************************************************************************/
+
+#ifndef EDGEFETCHER_H_
+#define EDGEFETCHER_H_
+
+#include "MetricsRegistry.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+#define EDGE_UPSTREAM_TIMEOUT   10  /* seconds without progress of an upstream request */
+
+namespace mcnl
+{
+    class EdgeFetcher
+    {
+        public:
+            /* runs on a fetch thread once the fetch of the path is over,
+             * whether or not the file came */
+            typedef std::function<void ()> Done;
+
+            EdgeFetcher             (const std::string &root, const std::string &host, size_t port, size_t threads,
+                                     MetricsRegistry &registry);
+            virtual ~EdgeFetcher    ();
+
+            void        Fetch       (const std::string &path, const Done &done);
+            /* waits for the fetches under way, the queued ones are dropped without their Done */
+            void        Stop        ();
+
+        private:
+            std::string                             root;
+            std::string                             host;
+            size_t                                  port;
+            MetricCounter                           &upstreamRequests;
+            MetricCounter                           &collapsedRequests;
+            MetricCounter                           &upstreamFailures;
+            MetricCounter                           &upstreamBytes;
+            MetricHistogram                         &upstreamSeconds;
+            std::mutex                              mutex;
+            std::condition_variable                 queued;
+            std::map<std::string, std::vector<Done>> waiting;   /* by path, fetch queued or under way */
+            std::deque<std::string>                 queue;
+            bool                                    stopping;
+            std::vector<std::thread>                threads;
+
+            void        Work        ();
+            /* false if the upstream could not be asked or did not answer 200 */
+            bool        Download    (const std::string &path, int &status);
+            bool        MakeDirectories (const std::string &path);
+    };
+}
+
+#endif /* EDGEFETCHER_H_ */
@@ -0,0 +1,114 @@
+/*
+ * Origin.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *
+ * OriginServer [options] ROOT [CONTENT...]
+ *
+ * Serves the files under ROOT, e.g. /var/www/html, at their path relative
+ * to it, and preloads the segments of every CONTENT directory (relative to
+ * ROOT, e.g. video/longdress) before it starts listening. Options:
+ *   --port=P           default 80
+ *   --workers=N        epoll loops, default one per core
+ *   --maxOpenFiles=N   files kept open, default 4096
+ *   --upstream=HOST[:PORT]
+ *                      LAN edge cache of that origin: what is not under
+ *                      ROOT yet is fetched from it into ROOT, concurrent
+ *                      requests for a path sharing one fetch; the clients
+ *                      take the edge as BaseURL (Main --baseURL)
+ *   --upstreamThreads=N   fetches from the upstream at a time, default 8
+ * Runs until SIGINT or SIGTERM.
+ *****************************************************************************/
+
+#include "OriginServer.h"
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+using namespace mcnl;
+
+static bool Option  (const char *arg, const char *name, string &value)
+{
+	size_t length = strlen(name);
+
+	if(strncmp(arg, name, length) != 0 || arg[length] != '=')
+		return false;
+
+	value = arg + length + 1;
+	return true;
+}
+
+static int  Usage   ()
+{
+	cerr << "Usage: OriginServer [--port=P] [--workers=N] [--maxOpenFiles=N]\n"
+	        "                    [--upstream=HOST[:PORT] [--upstreamThreads=N]] ROOT [CONTENT...]\n";
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t port = 80, workers = thread::hardware_concurrency(), maxOpenFiles = 4096;
+	size_t upstreamPort = 80, upstreamThreads = 8;
+	string value, upstreamHost;
+	vector<string> positional;
+
+	for(int i = 1; i < argc; i++) {
+		if(Option(argv[i], "--port", value))
+			port = (size_t)strtoul(value.c_str(), NULL, 10);
+		else if(Option(argv[i], "--workers", value))
+			workers = (size_t)strtoul(value.c_str(), NULL, 10);
+		else if(Option(argv[i], "--maxOpenFiles", value))
+			maxOpenFiles = (size_t)strtoul(value.c_str(), NULL, 10);
+		else if(Option(argv[i], "--upstream", value)) {
+			size_t colon = value.rfind(':');
+			upstreamHost = value.substr(0, colon);
+			if(colon != string::npos)
+				upstreamPort = (size_t)strtoul(value.c_str() + colon + 1, NULL, 10);
+		}
+		else if(Option(argv[i], "--upstreamThreads", value))
+			upstreamThreads = (size_t)strtoul(value.c_str(), NULL, 10);
+		else if(strncmp(argv[i], "--", 2) == 0)
+			return Usage();
+		else
+			positional.push_back(argv[i]);
+	}
+	if(positional.empty() || port > 65535)
+		return Usage();
+
+	/* the signals are taken by sigwait below, not by the workers */
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	SegmentCache cache(positional[0], maxOpenFiles);
+	for(size_t i = 1; i < positional.size(); i++)
+		cout << "preloaded " << cache.Preload(positional[i]) << " files of " << positional[i] << "\n";
+
+	unique_ptr<EdgeFetcher> upstream;
+	OriginServer server(cache, MetricsRegistry::Instance());
+	if(!upstreamHost.empty()) {
+		upstream.reset(new EdgeFetcher(positional[0], upstreamHost, upstreamPort, upstreamThreads,
+		                               MetricsRegistry::Instance()));
+		server.SetUpstream(upstream.get());
+		cout << "edge cache of http://" << upstreamHost << ":" << upstreamPort << "\n";
+	}
+	if(!server.Start(port, workers)) {
+		cerr << "cannot listen on port " << port << "\n";
+		return 1;
+	}
+	cout << "serving " << positional[0] << " on port " << server.Port() << "\n";
+
+	int received = 0;
+	sigwait(&signals, &received);
+	server.Stop();
+
+	return 0;
+}
@@ -0,0 +1,538 @@
+/*
+ * OriginServer.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *****************************************************************************/
+
+#include "OriginServer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+
+using namespace mcnl;
+
+#define ORIGIN_SENDFILE_CHUNK   (1 << 20)   /* bytes per sendfile, so that one response does not hog a worker */
+#define ORIGIN_EVENTS           64
+
+static std::string  Lower           (std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char) tolower(c); });
+    return text;
+}
+static std::string  Trim            (const std::string &text)
+{
+    size_t first = text.find_first_not_of(" \t\r");
+    size_t last  = text.find_last_not_of(" \t\r");
+
+    return first == std::string::npos ? "" : text.substr(first, last - first + 1);
+}
+/* a single range "bytes=a-b", "bytes=a-" or "bytes=-n" of a file of size
+ * bytes; false if there is none to honor, satisfiable tells whether it
+ * lies in the file */
+static bool         ParseRange      (const std::string &range, uint64_t size, uint64_t &first, uint64_t &last,
+                                     bool &satisfiable)
+{
+    if (range.compare(0, 6, "bytes=") != 0 || range.find(',') != std::string::npos)
+        return false;
+
+    std::string spec = Trim(range.substr(6));
+    size_t      dash = spec.find('-');
+
+    if (dash == std::string::npos || spec.find_first_not_of("0123456789-") != std::string::npos ||
+        spec.find('-', dash + 1) != std::string::npos || spec.size() == 1)
+        return false;
+
+    satisfiable = true;
+    if (dash == 0)
+    {
+        uint64_t suffix = strtoull(spec.c_str() + 1, NULL, 10);
+
+        satisfiable = suffix > 0 && size > 0;
+        first       = size > suffix ? size - suffix : 0;
+        last        = size - 1;
+        return true;
+    }
+
+    first = strtoull(spec.c_str(), NULL, 10);
+    last  = dash + 1 < spec.size() ? strtoull(spec.c_str() + dash + 1, NULL, 10) : UINT64_MAX;
+    if (last < first)
+        return false;
+    if (first >= size)
+        satisfiable = false;
+    last = (std::min)(last, size - 1);
+    return true;
+}
+static std::string  StatusLine      (int status)
+{
+    switch (status)
+    {
+        case 200:   return "HTTP/1.1 200 OK\r\n";
+        case 206:   return "HTTP/1.1 206 Partial Content\r\n";
+        case 400:   return "HTTP/1.1 400 Bad Request\r\n";
+        case 404:   return "HTTP/1.1 404 Not Found\r\n";
+        case 416:   return "HTTP/1.1 416 Range Not Satisfiable\r\n";
+        case 431:   return "HTTP/1.1 431 Request Header Fields Too Large\r\n";
+        default:    return "HTTP/1.1 501 Not Implemented\r\n";
+    }
+}
+
+OriginServer::OriginServer      (SegmentCache &cache, MetricsRegistry &registry) :
+              cache             (cache),
+              registry          (registry),
+              requests          (registry.Counter("origin_requests_total", "Requests answered.")),
+              notFound          (registry.Counter("origin_not_found_total", "Requests of a path that is not there.")),
+              sentBytes         (registry.Counter("origin_sent_bytes_total", "Body bytes sent from files.")),
+              connections       (registry.Gauge("origin_connections", "Open client connections.")),
+              responseSeconds   (registry.Histogram("origin_response_seconds",
+                                                    "Time from a complete request to the last byte of its response.",
+                                                    { 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25,
+                                                      0.5, 1, 2.5 })),
+              upstream          (NULL),
+              open              (0),
+              listener          (-1),
+              port              (0),
+              running           (false)
+{
+}
+OriginServer::~OriginServer     ()
+{
+    this->Stop();
+}
+
+void        OriginServer::SetUpstream   (EdgeFetcher *upstream)
+{
+    this->upstream = upstream;
+}
+bool        OriginServer::Start         (size_t port, size_t workers)
+{
+    this->listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (this->listener < 0)
+        return false;
+
+    int reuse = 1;
+    setsockopt(this->listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port        = htons((uint16_t) port);
+
+    socklen_t length = sizeof(addr);
+    if (bind(this->listener, (sockaddr *) &addr, sizeof(addr)) != 0 || listen(this->listener, SOMAXCONN) != 0 ||
+        getsockname(this->listener, (sockaddr *) &addr, &length) != 0)
+    {
+        close(this->listener);
+        this->listener = -1;
+        return false;
+    }
+
+    this->port = ntohs(addr.sin_port);
+    this->running.store(true);
+    for (size_t i = 0; i < (std::max)(workers, (size_t) 1); i++)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+
+        worker->epoll  = epoll_create1(EPOLL_CLOEXEC);
+        worker->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        this->workers.push_back(std::thread(&OriginServer::Work, this, std::ref(*worker)));
+        this->workerStates.push_back(std::move(worker));
+    }
+    return true;
+}
+void        OriginServer::Stop          ()
+{
+    if (!this->running.exchange(false))
+        return;
+
+    /* no parked connection is handed back after this */
+    if (this->upstream)
+        this->upstream->Stop();
+
+    /* the workers see it within a second, at their next epoll timeout */
+    for (size_t i = 0; i < this->workers.size(); i++)
+        this->workers.at(i).join();
+    this->workers.clear();
+    for (size_t i = 0; i < this->workerStates.size(); i++)
+    {
+        close(this->workerStates.at(i)->epoll);
+        close(this->workerStates.at(i)->wakeup);
+    }
+    this->workerStates.clear();
+    close(this->listener);
+    this->listener = -1;
+}
+size_t      OriginServer::Port          () const
+{
+    return this->port;
+}
+
+void        OriginServer::Work          (Worker &worker)
+{
+    if (worker.epoll < 0 || worker.wakeup < 0)
+        return;
+
+    /* one worker is woken per new connection */
+    epoll_event event;
+    event.events   = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.ptr = NULL;
+    epoll_ctl(worker.epoll, EPOLL_CTL_ADD, this->listener, &event);
+    event.events   = EPOLLIN;
+    event.data.ptr = &worker;
+    epoll_ctl(worker.epoll, EPOLL_CTL_ADD, worker.wakeup, &event);
+
+    std::map<Connection *, std::unique_ptr<Connection>> connections;
+    epoll_event                                         events[ORIGIN_EVENTS];
+
+    while (this->running.load())
+    {
+        int                         count = epoll_wait(worker.epoll, events, ORIGIN_EVENTS, 1000);
+        std::vector<Connection *>   ready;
+
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.ptr == NULL)
+            {
+                int client;
+
+                while ((client = accept4(this->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+                {
+                    std::unique_ptr<Connection> connection(new Connection());
+                    int                         noDelay = 1;
+
+                    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                    connection->worker    = &worker;
+                    connection->socket    = client;
+                    connection->events    = 0;
+                    connection->written   = 0;
+                    connection->offset    = 0;
+                    connection->remaining = 0;
+                    connection->close     = false;
+                    connection->waiting   = false;
+                    connection->parked    = false;
+                    connection->fetched   = false;
+                    connection->active    = std::chrono::steady_clock::now();
+
+                    this->Watch(*connection);
+                    if (connection->events == 0)
+                    {
+                        close(client);
+                        continue;
+                    }
+                    connections[connection.get()] = std::move(connection);
+                    this->connections.Set((double) ++this->open);
+                }
+                continue;
+            }
+            if (events[i].data.ptr == &worker)
+            {
+                uint64_t                    signaled;
+                std::lock_guard<std::mutex> lock(worker.mutex);
+
+                if (read(worker.wakeup, &signaled, sizeof(signaled)) < 0)
+                    signaled = 0;
+                ready.insert(ready.end(), worker.fetched.begin(), worker.fetched.end());
+                worker.fetched.clear();
+                continue;
+            }
+            ready.push_back((Connection *) events[i].data.ptr);
+        }
+
+        for (size_t i = 0; i < ready.size(); i++)
+        {
+            Connection  &connection = *ready.at(i);
+            Progress    progress    = PROGRESS_DONE;
+
+            /* back from the upstream, answered from the edge's copy now */
+            if (connection.parked)
+            {
+                connection.parked  = false;
+                connection.fetched = true;
+                this->Respond(connection);
+                progress = this->Send(connection);
+            }
+            else if (connection.waiting)
+                progress = this->Send(connection);
+
+            /* the responses of requests that came meanwhile go out next */
+            if (progress == PROGRESS_DONE)
+                progress = this->Receive(connection);
+            connection.active = std::chrono::steady_clock::now();
+
+            if (progress == PROGRESS_CLOSE)
+            {
+                close(connection.socket);
+                connections.erase(&connection);
+                this->connections.Set((double) --this->open);
+                continue;
+            }
+            this->Watch(connection);
+        }
+
+        std::chrono::steady_clock::time_point idle =
+            std::chrono::steady_clock::now() - std::chrono::seconds(ORIGIN_IDLE_TIMEOUT);
+
+        for (std::map<Connection *, std::unique_ptr<Connection>>::iterator it = connections.begin();
+             it != connections.end();)
+        {
+            /* a parked one is still known to the fetcher */
+            if (it->second->active > idle || it->second->parked)
+            {
+                it++;
+                continue;
+            }
+            close(it->second->socket);
+            it = connections.erase(it);
+            this->connections.Set((double) --this->open);
+        }
+    }
+
+    for (std::map<Connection *, std::unique_ptr<Connection>>::iterator it = connections.begin();
+         it != connections.end(); it++)
+    {
+        close(it->second->socket);
+        this->connections.Set((double) --this->open);
+    }
+}
+void        OriginServer::Watch         (Connection &connection)
+{
+    uint32_t    events = connection.parked ? 0 : (connection.waiting ? EPOLLOUT : EPOLLIN) | EPOLLRDHUP;
+    epoll_event event;
+
+    if (events == connection.events)
+        return;
+
+    event.events   = events;
+    event.data.ptr = &connection;
+    if (events == 0)
+        epoll_ctl(connection.worker->epoll, EPOLL_CTL_DEL, connection.socket, &event);
+    else if (epoll_ctl(connection.worker->epoll, connection.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+                       connection.socket, &event) != 0)
+        events = 0;
+    connection.events = events;
+}
+OriginServer::Progress  OriginServer::Receive   (Connection &connection)
+{
+    while (true)
+    {
+        while (this->Handle(connection))
+        {
+            if (connection.parked)
+                return PROGRESS_PARKED;
+
+            Progress progress = this->Send(connection);
+
+            if (progress != PROGRESS_DONE)
+                return progress;
+        }
+
+        char    data[4096];
+        ssize_t received = recv(connection.socket, data, sizeof(data), 0);
+
+        if (received == 0)
+            return PROGRESS_CLOSE;
+        if (received < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK ? PROGRESS_DONE : PROGRESS_CLOSE;
+        connection.input.append(data, received);
+    }
+}
+bool        OriginServer::Handle        (Connection &connection)
+{
+    size_t end  = connection.input.find("\r\n\r\n");
+    size_t skip = 4;
+
+    if (end == std::string::npos)
+    {
+        end  = connection.input.find("\n\n");
+        skip = 2;
+    }
+    if (end == std::string::npos)
+    {
+        if (connection.input.size() <= ORIGIN_MAX_REQUEST)
+            return false;
+
+        connection.input.clear();
+        connection.output  = StatusLine(431) + "Content-Length: 0\r\nConnection: close\r\n\r\n";
+        connection.close   = true;
+        connection.started = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    std::istringstream  head(connection.input.substr(0, end));
+    std::string         line, path, version, persistence;
+
+    connection.input.erase(0, end + skip);
+    std::getline(head, line);
+    connection.range.clear();
+    std::istringstream(line) >> connection.method >> path >> version;
+
+    while (std::getline(head, line))
+    {
+        size_t colon = line.find(':');
+
+        if (colon == std::string::npos)
+            continue;
+
+        std::string name = Lower(Trim(line.substr(0, colon)));
+
+        if (name == "range")
+            connection.range = Trim(line.substr(colon + 1));
+        else if (name == "connection")
+            persistence = Lower(Trim(line.substr(colon + 1)));
+    }
+
+    /* HTTP/1.1 keeps the connection unless told otherwise, 1.0 only when asked */
+    connection.close   = version == "HTTP/1.1" ? persistence == "close" : persistence != "keep-alive";
+    connection.started = std::chrono::steady_clock::now();
+    connection.path    = path.substr(0, path.find('?'));
+    connection.fetched = false;
+    this->requests.Add();
+    this->Respond(connection);
+    return true;
+}
+void        OriginServer::Respond       (Connection &connection)
+{
+    const std::string   &method = connection.method;
+    const std::string   &path   = connection.path;
+    const std::string   &range  = connection.range;
+    std::ostringstream  header;
+    std::string         body;
+    std::string         persistence = connection.close ? "Connection: close\r\n" : "Connection: keep-alive\r\n";
+
+    connection.output.clear();
+    connection.written = 0;
+
+    if (method != "GET" && method != "HEAD")
+    {
+        connection.output = StatusLine(method.empty() ? 400 : 501) + "Content-Length: 0\r\n" + persistence + "\r\n";
+        return;
+    }
+    if (path == "/metrics")
+    {
+        std::ostringstream text;
+
+        this->registry.Write(text);
+        this->cache.Write(text);
+        body = text.str();
+        header << StatusLine(200);
+        header << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+        header << "Content-Length: " << body.size() << "\r\n" << persistence << "\r\n";
+        connection.output = header.str() + (method == "GET" ? body : "");
+        return;
+    }
+
+    std::shared_ptr<CachedFile> file;
+
+    if (this->upstream && !connection.fetched && (SegmentCache::IsManifest(path) || !(file = this->cache.Open(path))))
+    {
+        Connection  *parked = &connection;
+        Worker      *worker = connection.worker;
+
+        connection.parked = true;
+        this->upstream->Fetch(path, [parked, worker]() {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            uint64_t                    one = 1;
+
+            worker->fetched.push_back(parked);
+            if (write(worker->wakeup, &one, sizeof(one)) < 0)
+                return;
+        });
+        return;
+    }
+    if (!file)
+        file = this->cache.Open(path);
+    if (!file)
+    {
+        this->notFound.Add();
+        connection.output = StatusLine(404) + "Content-Length: 0\r\n" + persistence + "\r\n";
+        return;
+    }
+
+    uint64_t    size        = file->Size();
+    uint64_t    first       = 0;
+    uint64_t    last        = size > 0 ? size - 1 : 0;
+    bool        satisfiable = true;
+    bool        partial     = !range.empty() && ParseRange(range, size, first, last, satisfiable);
+
+    file->Counters().requests++;
+    if (partial && !satisfiable)
+    {
+        header << StatusLine(416) << "Content-Range: bytes */" << size << "\r\n";
+        header << "Content-Length: 0\r\n" << persistence << "\r\n";
+        connection.output = header.str();
+        return;
+    }
+
+    uint64_t length = size > 0 ? last - first + 1 : 0;
+
+    header << StatusLine(partial ? 206 : 200);
+    header << "Content-Type: " << file->ContentType() << "\r\n";
+    header << "Accept-Ranges: bytes\r\n";
+    if (partial)
+        header << "Content-Range: bytes " << first << "-" << last << "/" << size << "\r\n";
+    header << "Content-Length: " << length << "\r\n" << persistence << "\r\n";
+    connection.output = header.str();
+    if (method == "GET" && length > 0)
+    {
+        connection.file      = file;
+        connection.offset    = first;
+        connection.remaining = length;
+    }
+}
+OriginServer::Progress  OriginServer::Send      (Connection &connection)
+{
+    while (connection.written < connection.output.size())
+    {
+        ssize_t sent = send(connection.socket, connection.output.data() + connection.written,
+                            connection.output.size() - connection.written, MSG_NOSIGNAL);
+
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            connection.waiting = true;
+            return PROGRESS_WAIT;
+        }
+        if (sent <= 0)
+            return PROGRESS_CLOSE;
+        connection.written += sent;
+    }
+    while (connection.remaining > 0)
+    {
+        off_t   offset = (off_t) connection.offset;
+        ssize_t sent   = sendfile(connection.socket, connection.file->Descriptor(), &offset,
+                                  (size_t) (std::min)(connection.remaining, (uint64_t) ORIGIN_SENDFILE_CHUNK));
+
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            connection.waiting = true;
+            return PROGRESS_WAIT;
+        }
+        /* 0: the file got shorter than the Content-Length sent */
+        if (sent <= 0)
+            return PROGRESS_CLOSE;
+        connection.offset    += sent;
+        connection.remaining -= sent;
+        this->sentBytes.Add((double) sent);
+        connection.file->Counters().bytes += sent;
+    }
+
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - connection.started;
+
+    this->responseSeconds.Observe(seconds.count());
+    connection.file.reset();
+    connection.output.clear();
+    connection.written = 0;
+    connection.waiting = false;
+    return connection.close ? PROGRESS_CLOSE : PROGRESS_DONE;
+}
@@ -0,0 +1,133 @@
+/*
+ * OriginServer.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *
+ * HTTP/1.1 origin of the encoded contents, in place of a generic web
+ * server. The files come from a SegmentCache and their bodies go out with
+ * sendfile, straight from the page cache to the socket. Connections are
+ * kept alive, the clients fetch one segment after the other over them
+ * (see Main/ConnectionPool), and requests pipelined on one are answered
+ * in order.
+ *
+ * GET and HEAD only. A single byte range (Range: bytes=a-b, a- or -n) is
+ * answered with 206, as the single file packaging needs (SegmentURL@
+ * mediaRange), an unsatisfiable one with 416; other ranges get the whole
+ * file. GET /metrics answers with the registry and the counters of every
+ * path in the Prometheus text format.
+ *
+ * Every worker runs its own epoll loop over the shared listener and the
+ * connections it accepted, with non-blocking sockets: a slow client only
+ * holds its own connection. Connections idle for ORIGIN_IDLE_TIMEOUT are
+ * closed.
+ *
+ * As a LAN edge cache (SetUpstream) a request for a path the edge does not
+ * have, or for an MPD, is parked while an EdgeFetcher brings the file from
+ * the upstream origin: its connection leaves the worker's epoll set, the
+ * fetch thread hands it back through the worker's eventfd, and the
+ * worker answers it from the file on the edge.
+ *****************************************************************************/
+
+#ifndef ORIGINSERVER_H_
+#define ORIGINSERVER_H_
+
+#include "SegmentCache.h"
+#include "EdgeFetcher.h"
+#include "MetricsRegistry.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ORIGIN_IDLE_TIMEOUT     30          /* seconds */
+#define ORIGIN_MAX_REQUEST      (16 << 10)  /* longer request headers are answered with 431 */
+
+namespace mcnl
+{
+    class OriginServer
+    {
+        public:
+            OriginServer            (SegmentCache &cache, MetricsRegistry &registry);
+            virtual ~OriginServer   ();
+
+            /* edge cache mode, set before Start; the fetcher is stopped with the server */
+            void        SetUpstream (EdgeFetcher *upstream);
+
+            /* listens on all interfaces; port 0 picks a free one */
+            bool        Start       (size_t port, size_t workers);
+            void        Stop        ();
+
+            size_t      Port        () const;
+
+        private:
+            struct Worker;
+            struct Connection
+            {
+                Worker                                  *worker;
+                int                                     socket;
+                uint32_t                                events;     /* in the worker's epoll set, 0 if not */
+                std::string                             input;
+                std::string                             output;     /* header, or a whole small response */
+                size_t                                  written;
+                std::shared_ptr<CachedFile>             file;       /* the body, from offset on */
+                uint64_t                                offset;
+                uint64_t                                remaining;
+                bool                                    close;      /* after the response */
+                bool                                    waiting;    /* for the socket to take more */
+                bool                                    parked;     /* for the upstream */
+                bool                                    fetched;    /* answer from the edge's copy */
+                std::string                             method;
+                std::string                             path;
+                std::string                             range;
+                std::chrono::steady_clock::time_point   started;    /* of the response */
+                std::chrono::steady_clock::time_point   active;
+            };
+            struct Worker
+            {
+                int                         epoll;
+                int                         wakeup;     /* eventfd */
+                std::mutex                  mutex;
+                std::vector<Connection *>   fetched;    /* parked ones whose fetch is over */
+            };
+            enum Progress
+            {
+                PROGRESS_DONE,
+                PROGRESS_WAIT,
+                PROGRESS_PARKED,
+                PROGRESS_CLOSE
+            };
+
+            SegmentCache                &cache;
+            MetricsRegistry             &registry;
+            MetricCounter               &requests;
+            MetricCounter               &notFound;
+            MetricCounter               &sentBytes;
+            MetricGauge                 &connections;
+            MetricHistogram             &responseSeconds;
+            EdgeFetcher                 *upstream;
+            std::atomic<int64_t>        open;
+            int                         listener;
+            size_t                      port;
+            std::atomic<bool>           running;
+            std::vector<std::thread>    workers;
+            std::vector<std::unique_ptr<Worker>>    workerStates;
+
+            void        Work        (Worker &worker);
+            /* puts the connection in the epoll set for what it waits for, or takes it out while parked */
+            void        Watch       (Connection &connection);
+            /* reads what came and answers the complete requests */
+            Progress    Receive     (Connection &connection);
+            /* sets the response of one request up; false if none is complete */
+            bool        Handle      (Connection &connection);
+            void        Respond     (Connection &connection);
+            Progress    Send        (Connection &connection);
+    };
+}
+
+#endif /* ORIGINSERVER_H_ */
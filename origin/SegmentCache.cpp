@@ -0,0 +1,229 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *****************************************************************************/
+
+#include "SegmentCache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mcnl;
+
+/* the request path as the counters' label value */
+static std::string  EscapeLabel     (const std::string &value)
+{
+    std::string escaped;
+
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        if (value.at(i) == '\\' || value.at(i) == '"')
+            escaped += '\\';
+        escaped += value.at(i);
+    }
+    return escaped;
+}
+static bool         EndsWith        (const std::string &text, const std::string &end)
+{
+    return text.size() >= end.size() && text.compare(text.size() - end.size(), end.size(), end) == 0;
+}
+
+CachedFile::CachedFile          (int fd, uint64_t size, const std::string &contentType,
+                                 SegmentCounters &counters) :
+            fd                  (fd),
+            size                (size),
+            contentType         (contentType),
+            counters            (counters)
+{
+}
+CachedFile::~CachedFile         ()
+{
+    close(this->fd);
+}
+
+int                 CachedFile::Descriptor  () const
+{
+    return this->fd;
+}
+uint64_t            CachedFile::Size        () const
+{
+    return this->size.load();
+}
+const std::string&  CachedFile::ContentType () const
+{
+    return this->contentType;
+}
+SegmentCounters&    CachedFile::Counters    () const
+{
+    return this->counters;
+}
+bool                CachedFile::Refresh     ()
+{
+    struct stat info;
+
+    if (fstat(this->fd, &info) != 0)
+        return false;
+    this->size.store((uint64_t) info.st_size);
+    return true;
+}
+
+SegmentCache::SegmentCache      (const std::string &root, size_t maxOpenFiles) :
+              root              (root),
+              maxOpenFiles      (maxOpenFiles > 0 ? maxOpenFiles : 1)
+{
+    while (this->root.size() > 1 && this->root.back() == '/')
+        this->root.pop_back();
+}
+SegmentCache::~SegmentCache     ()
+{
+}
+
+size_t                      SegmentCache::Preload       (const std::string &directory)
+{
+    std::string path   = directory.empty() || directory.at(0) == '/' ? directory : "/" + directory;
+    DIR         *dir   = opendir((this->root + path).c_str());
+    size_t      opened = 0;
+
+    if (dir == NULL)
+        return 0;
+
+    for (dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir))
+    {
+        std::string name  = entry->d_name;
+        std::string child = path + "/" + name;
+        struct stat info;
+
+        if (name == "." || name == ".." || stat((this->root + child).c_str(), &info) != 0)
+            continue;
+        if (S_ISDIR(info.st_mode))
+        {
+            opened += this->Preload(child);
+            continue;
+        }
+        if (!S_ISREG(info.st_mode) || IsManifest(child))
+            continue;
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+
+            if (this->files.size() >= this->maxOpenFiles)
+                break;
+        }
+
+        std::shared_ptr<CachedFile> file = this->OpenFile(child);
+
+        if (!file)
+            continue;
+        /* read ahead now rather than on the first request */
+        posix_fadvise(file->Descriptor(), 0, 0, POSIX_FADV_WILLNEED);
+        this->Keep(child, file);
+        opened++;
+    }
+    closedir(dir);
+
+    return opened;
+}
+std::shared_ptr<CachedFile> SegmentCache::Open          (const std::string &path)
+{
+    if (path.empty() || path.at(0) != '/' || path.find("/..") != std::string::npos)
+        return NULL;
+
+    std::shared_ptr<CachedFile> file;
+
+    if (!IsManifest(path))
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        std::map<std::string, Entry>::iterator found = this->files.find(path);
+
+        if (found != this->files.end())
+        {
+            this->uses.splice(this->uses.begin(), this->uses, found->second.use);
+            file = found->second.file;
+        }
+    }
+    /* it may have been still being encoded when it was opened */
+    if (file)
+        return file->Refresh() ? file : NULL;
+
+    file = this->OpenFile(path);
+
+    if (file && !IsManifest(path))
+        this->Keep(path, file);
+    return file;
+}
+
+void                        SegmentCache::Write         (std::ostream &out) const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    out << "# HELP origin_segment_requests_total Requests of every path.\n";
+    out << "# TYPE origin_segment_requests_total counter\n";
+    for (std::map<std::string, std::unique_ptr<SegmentCounters>>::const_iterator it = this->counters.begin();
+         it != this->counters.end(); it++)
+        out << "origin_segment_requests_total{path=\"" << EscapeLabel(it->first) << "\"} " <<
+               it->second->requests.load() << "\n";
+
+    out << "# HELP origin_segment_sent_bytes_total Body bytes sent of every path.\n";
+    out << "# TYPE origin_segment_sent_bytes_total counter\n";
+    for (std::map<std::string, std::unique_ptr<SegmentCounters>>::const_iterator it = this->counters.begin();
+         it != this->counters.end(); it++)
+        out << "origin_segment_sent_bytes_total{path=\"" << EscapeLabel(it->first) << "\"} " <<
+               it->second->bytes.load() << "\n";
+}
+
+std::shared_ptr<CachedFile> SegmentCache::OpenFile      (const std::string &path)
+{
+    int         fd = open((this->root + path).c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    std::string contentType = IsManifest(path) ? "application/dash+xml" : "application/octet-stream";
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return std::make_shared<CachedFile>(fd, (uint64_t) info.st_size, contentType, this->CountersOf(path));
+}
+/* with the lock held */
+SegmentCounters&            SegmentCache::CountersOf    (const std::string &path)
+{
+    std::unique_ptr<SegmentCounters> &counters = this->counters[path];
+
+    if (!counters)
+        counters.reset(new SegmentCounters());
+    return *counters;
+}
+void                        SegmentCache::Keep          (const std::string &path, const std::shared_ptr<CachedFile> &file)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    /* another request may have opened it meanwhile, the first one stays */
+    if (this->files.count(path) > 0)
+        return;
+
+    while (this->files.size() >= this->maxOpenFiles && !this->uses.empty())
+    {
+        this->files.erase(this->uses.back());
+        this->uses.pop_back();
+    }
+
+    Entry entry;
+
+    this->uses.push_front(path);
+    entry.file = file;
+    entry.use  = this->uses.begin();
+    this->files[path] = entry;
+}
+bool                        SegmentCache::IsManifest    (const std::string &path)
+{
+    return EndsWith(path, ".mpd");
+}
@@ -0,0 +1,106 @@
+/*
+ * SegmentCache.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *
+ * Open files of the origin, by request path. A segment is looked up,
+ * opened and stat'ed once and then served from the kept descriptor with
+ * sendfile, so a request costs no path walk; the segments of the contents
+ * being streamed are preloaded into the page cache when the origin starts
+ * (Preload), ahead of the first client. At most maxOpenFiles are kept, the
+ * least recently requested one is closed first; a response still sending
+ * from it holds on to it until it is done.
+ *
+ * Segments do not change once written, the encoder only appends to one
+ * while it is being encoded, which the size read again from the kept
+ * descriptor covers. MPDs are replaced as a whole (MpdPackager::Write
+ * renames the new one into place), so they are opened anew for every
+ * request and never kept.
+ *
+ * Every path also has its request and byte counters, which stay when its
+ * file is closed.
+ *****************************************************************************/
+
+#ifndef SEGMENTCACHE_H_
+#define SEGMENTCACHE_H_
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mcnl
+{
+    struct SegmentCounters
+    {
+        std::atomic<uint64_t>   requests;
+        std::atomic<uint64_t>   bytes;      /* of the bodies sent */
+
+        SegmentCounters         () : requests(0), bytes(0) {}
+    };
+
+    class CachedFile
+    {
+        public:
+            CachedFile              (int fd, uint64_t size, const std::string &contentType,
+                                     SegmentCounters &counters);
+            virtual ~CachedFile     ();
+
+            int                 Descriptor  () const;
+            uint64_t            Size        () const;
+            const std::string&  ContentType () const;
+            SegmentCounters&    Counters    () const;
+            /* reads the size again from the descriptor; false if that fails */
+            bool                Refresh     ();
+
+        private:
+            int                     fd;
+            std::atomic<uint64_t>   size;
+            std::string             contentType;
+            SegmentCounters         &counters;
+    };
+
+    class SegmentCache
+    {
+        public:
+            /* root is the directory the request paths are relative to, e.g. /var/www/html */
+            SegmentCache            (const std::string &root, size_t maxOpenFiles);
+            virtual ~SegmentCache   ();
+
+            /* opens every file under root/directory and reads it into the
+             * page cache, up to maxOpenFiles; the number of files opened */
+            size_t                      Preload     (const std::string &directory);
+            /* NULL if path is outside root or not a regular file */
+            std::shared_ptr<CachedFile> Open        (const std::string &path);
+
+            /* the counters of every path, in the Prometheus text format */
+            void                        Write       (std::ostream &out) const;
+            /* MPDs, which are never kept */
+            static bool                 IsManifest  (const std::string &path);
+
+        private:
+            struct Entry
+            {
+                std::shared_ptr<CachedFile>         file;
+                std::list<std::string>::iterator    use;
+            };
+
+            std::string                                             root;
+            size_t                                                  maxOpenFiles;
+            mutable std::mutex                                      mutex;
+            std::map<std::string, Entry>                            files;
+            std::list<std::string>                                  uses;       /* most recent first */
+            std::map<std::string, std::unique_ptr<SegmentCounters>> counters;
+
+            std::shared_ptr<CachedFile> OpenFile    (const std::string &path);
+            SegmentCounters&            CountersOf  (const std::string &path);
+            void                        Keep        (const std::string &path, const std::shared_ptr<CachedFile> &file);
+    };
+}
+
+#endif /* SEGMENTCACHE_H_ */
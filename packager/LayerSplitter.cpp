@@ -0,0 +1,137 @@
+/*
+ * LayerSplitter.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *****************************************************************************/
+
+#include "LayerSplitter.h"
+
+using namespace mcnl;
+
+#define V3C_UNIT_HEADER_SIZE    4   /* vuh of every unit type */
+#define NAL_SIZE_PRECISION      4   /* of the video sub-bitstreams */
+
+/* vuh_unit_type: V3C_OVD, V3C_GVD, V3C_AVD */
+static bool         IsVideoUnit     (const uint8_t *unit, size_t size)
+{
+    return size >= V3C_UNIT_HEADER_SIZE && (unit[0] >> 3) >= 2 && (unit[0] >> 3) <= 4;
+}
+/* VPS_NUT, SPS_NUT, PPS_NUT */
+static bool         IsParameterSet  (const uint8_t *nal)
+{
+    size_t type = (nal[0] >> 1) & 0x3f;
+
+    return type >= 32 && type <= 34;
+}
+static size_t       LayerId         (const uint8_t *nal)
+{
+    return ((nal[0] & 1) << 5) | (nal[1] >> 3);
+}
+static uint64_t     ReadSize        (const uint8_t *data, size_t bytes)
+{
+    uint64_t size = 0;
+
+    for (size_t i = 0; i < bytes; i++)
+        size = (size << 8) | data[i];
+    return size;
+}
+static void         WriteSize       (std::vector<uint8_t> &out, uint64_t size, size_t bytes)
+{
+    for (size_t i = bytes; i > 0; i--)
+        out.push_back((uint8_t) (size >> (8 * (i - 1))));
+}
+
+bool        mcnl::SplitLayers       (const std::vector<uint8_t> &segment, size_t layers,
+                                     std::vector<std::vector<uint8_t>> &split)
+{
+    if (segment.empty() || layers == 0)
+        return false;
+
+    /* ssvh_unit_size_precision_bytes_minus1 u(3), reserved u(5) */
+    size_t precision = (segment[0] >> 5) + 1;
+    size_t pos       = 1;
+
+    split.assign(layers, std::vector<uint8_t>());
+    split[0].push_back(segment[0]);
+
+    for (uint32_t index = 0; pos < segment.size(); index++)
+    {
+        if (segment.size() - pos < precision)
+            return false;
+
+        uint64_t size = ReadSize(segment.data() + pos, precision);
+
+        pos += precision;
+        if (segment.size() - pos < size)
+            return false;
+
+        const uint8_t *unit = segment.data() + pos;
+
+        pos += size;
+        if (!IsVideoUnit(unit, size))
+        {
+            WriteSize(split[0], size, precision);
+            split[0].insert(split[0].end(), unit, unit + size);
+            continue;
+        }
+
+        std::vector<uint8_t>                base(unit, unit + V3C_UNIT_HEADER_SIZE);
+        std::vector<std::vector<uint8_t>>   records(layers);
+        std::vector<uint32_t>               counts(layers, 0);
+        /* NAL units of each layer so far, parameter sets counting as the base */
+        std::vector<uint32_t>               seen(layers, 0);
+
+        for (size_t at = V3C_UNIT_HEADER_SIZE; at < size;)
+        {
+            if (size - at < NAL_SIZE_PRECISION)
+                return false;
+
+            uint64_t        nalSize = ReadSize(unit + at, NAL_SIZE_PRECISION);
+            const uint8_t   *nal    = unit + at + NAL_SIZE_PRECISION;
+
+            if (size - at - NAL_SIZE_PRECISION < nalSize || nalSize < 2)
+                return false;
+            at += NAL_SIZE_PRECISION + nalSize;
+
+            size_t layer = IsParameterSet(nal) ? 0 : LayerId(nal);
+
+            if (layer >= layers)
+                return false;
+            if (layer == 0)
+                base.insert(base.end(), unit + at - NAL_SIZE_PRECISION - nalSize, unit + at);
+            else
+            {
+                uint32_t below = 0;
+
+                for (size_t k = 0; k < layer; k++)
+                    below += seen[k];
+                WriteSize(records[layer], below, 4);
+                WriteSize(records[layer], nalSize, 4);
+                records[layer].insert(records[layer].end(), nal, nal + nalSize);
+                counts[layer]++;
+            }
+            seen[layer]++;
+        }
+
+        WriteSize(split[0], base.size(), precision);
+        split[0].insert(split[0].end(), base.begin(), base.end());
+        for (size_t k = 1; k < layers; k++)
+        {
+            if (counts[k] == 0)
+                continue;
+            WriteSize(split[k], index, 4);
+            WriteSize(split[k], counts[k], 4);
+            split[k].insert(split[k].end(), records[k].begin(), records[k].end());
+        }
+    }
+
+    return true;
+}
+std::string mcnl::LayerPath         (const std::string &path, size_t layer)
+{
+    size_t slash = path.find_last_of('/');
+    size_t dot   = path.find_last_of('.');
+    size_t at    = dot == std::string::npos || (slash != std::string::npos && dot < slash) ? path.size() : dot;
+
+    return path.substr(0, at) + "_l" + std::to_string(layer) + path.substr(at);
+}
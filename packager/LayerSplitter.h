@@ -0,0 +1,53 @@
+/*
+ * LayerSplitter.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *
+ * Splits a segment whose video sub-bitstreams are SHVC coded (SHM, cfg/
+ * condition/shm-*-2L/3L.cfg) by layer, for packaging the layers as
+ * dependent representations (see MpdPackager::SplitLayers).
+ *
+ * The base layer stays a V3C sample stream: every V3C unit is kept, the
+ * video units with the NAL units of nuh_layer_id 0 and the parameter sets
+ * of all layers. The SHM decoder reads the size of the top layer from those
+ * and upsamples the base layer to it, so the base decodes on its own.
+ *
+ * Layer k >= 1 holds the other NAL units with nuh_layer_id k, one record
+ * for each video unit that has some, in the order of the units:
+ *
+ *   u32 unit       index of the V3C unit in the segment
+ *   u32 count      NAL units of the record
+ *   count times:
+ *     u32 position NAL units of the layers below k (and parameter sets)
+ *                  ahead of it in the unit
+ *     u32 size
+ *     the NAL unit
+ *
+ * all big-endian. Merging layers 1..k into the base in that order (see
+ * Main/LayerMerger) gives back the video units of the original segment
+ * without the layers above k, byte for byte.
+ *
+ * The video sub-bitstreams are taken as TMC2 writes them: NAL units each
+ * with a 4-byte size (PCCVideoBitstream::byteStreamToSampleStream) and HEVC
+ * NAL unit headers.
+ *****************************************************************************/
+
+#ifndef LAYERSPLITTER_H_
+#define LAYERSPLITTER_H_
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mcnl
+{
+    /* split[0] is the base, split[k] layer k; false if segment is not a
+     * V3C sample stream or has a NAL unit of layer `layers` or above */
+    bool        SplitLayers (const std::vector<uint8_t> &segment, size_t layers,
+                             std::vector<std::vector<uint8_t>> &split);
+    /* path with "_l<layer>" ahead of its extension, e.g. shvc/s$Number$_l1.bin */
+    std::string LayerPath   (const std::string &path, size_t layer);
+}
+
+#endif /* LAYERSPLITTER_H_ */
@@ -0,0 +1,759 @@
+/*
+ * MpdPackager.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *****************************************************************************/
+
+#include "MpdPackager.h"
+#include "LayerSplitter.h"
+#include "libdash.h"
+#include "mpd/MPD.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace mcnl;
+using namespace dash::mpd;
+
+/* xs:duration */
+static std::string  FormatDuration  (double seconds)
+{
+    char text[64];
+
+    snprintf(text, sizeof(text), "PT%.3fS", seconds);
+    return text;
+}
+/* FrameRateType is an integer or "num/den", never a decimal */
+static std::string  FormatFrameRate (double frameRate)
+{
+    char text[64];
+
+    if (frameRate == floor(frameRate))
+        snprintf(text, sizeof(text), "%.0f", frameRate);
+    else
+        snprintf(text, sizeof(text), "%.0f/1000", floor(frameRate * 1000 + 0.5));
+    return text;
+}
+/* integer frame rates count in frames, others in thousandths of a frame */
+static void         FrameTicks      (double frameRate, uint32_t &timescale, uint32_t &tick)
+{
+    bool integral = frameRate == floor(frameRate);
+
+    timescale = integral ? (uint32_t) frameRate : (uint32_t) floor(frameRate * 1000 + 0.5);
+    tick      = integral ? 1 : 1000;
+}
+/* xs:dateTime of now, UTC */
+static std::string  FormatNow       ()
+{
+    char    text[64];
+    time_t  now = time(NULL);
+    tm      utc;
+
+    gmtime_r(&now, &utc);
+    strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return text;
+}
+
+/* <bitstream>.complexity as PccAppEncoder names it, the extension replaced;
+ * left zero if it is not there */
+static void         ReadComplexity  (const std::string &bitstream, PackagedComplexity &complexity)
+{
+    size_t          dot = bitstream.find_last_of('.');
+    std::ifstream   in(((dot == std::string::npos ? bitstream : bitstream.substr(0, dot)) + ".complexity").c_str());
+    std::string     line;
+
+    /* frames,points,patches,atlasWidth,atlasHeight,occupancyBytes,geometryBytes,attributeBytes */
+    if (!in || !std::getline(in, line) || !std::getline(in, line))
+        return;
+
+    unsigned long long  values[8];
+    char                tail;
+
+    if (sscanf(line.c_str(), "%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu%c", &values[0], &values[1], &values[2],
+               &values[3], &values[4], &values[5], &values[6], &values[7], &tail) < 8)
+        return;
+
+    complexity.points         = values[1];
+    complexity.patches        = values[2];
+    complexity.atlasWidth     = (uint32_t) values[3];
+    complexity.atlasHeight    = (uint32_t) values[4];
+    complexity.occupancyBytes = values[5];
+    complexity.geometryBytes  = values[6];
+    complexity.attributeBytes = values[7];
+}
+
+uint32_t    mcnl::DeliveryBandwidth     (const std::vector<uint64_t> &bytes, const std::vector<double> &durations,
+                                         double minBufferTime)
+{
+    double bandwidth = 0;
+
+    if (minBufferTime <= 0)
+        return 0;
+
+    /* segment e, when delivery starts at segment s, must have arrived when
+     * its playout starts: bits(s..e) <= B * (minBufferTime + duration(s..e-1)) */
+    for (size_t s = 0; s < bytes.size(); s++)
+    {
+        double bits = 0;
+        double time = minBufferTime;
+
+        for (size_t e = s; e < bytes.size(); e++)
+        {
+            bits     += 8.0 * bytes.at(e);
+            bandwidth = (std::max)(bandwidth, bits / time);
+            time     += durations.at(e);
+        }
+    }
+
+    return bandwidth >= UINT32_MAX ? UINT32_MAX : (uint32_t) ceil(bandwidth);
+}
+
+/* @duration covers equal segments and a shorter last one, anything else
+ * needs a timeline; so does a live presentation, whose timeline starts at
+ * startTime once the first segments have left it */
+static void         SetTiming       (MultipleSegmentBase *base, const std::vector<PackagedSegment> &segments,
+                                     uint32_t timescale, uint32_t tick, bool live, uint64_t startTime)
+{
+    bool regular = !live;
+
+    for (size_t i = 0; i + 1 < segments.size(); i++)
+        if (segments.at(i).frames != segments.at(0).frames)
+            regular = false;
+    if (segments.back().frames > segments.at(0).frames)
+        regular = false;
+
+    base->SetTimescale(timescale);
+    base->SetStartNumber(segments.at(0).number);
+    if (regular)
+    {
+        base->SetDuration((uint32_t) segments.at(0).frames * tick);
+        return;
+    }
+
+    SegmentTimeline *timeline = new SegmentTimeline();
+    Timeline        *run      = NULL;
+
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        uint32_t duration = (uint32_t) segments.at(i).frames * tick;
+
+        if (run && run->GetDuration() == duration)
+        {
+            run->SetRepeatCount(run->GetRepeatCount() + 1);
+            continue;
+        }
+        run = new Timeline();
+        run->SetDuration(duration);
+        if (i == 0 && startTime > 0)
+            run->SetStartTime((uint32_t) startTime);
+        timeline->AddTimeline(run);
+    }
+    base->SetSegmentTimeline(timeline);
+}
+
+MpdPackager::MpdPackager      (double frameRate) :
+             frameRate        (frameRate),
+             minBufferTime    (0),
+             width            (0),
+             height           (0),
+             mimeType         (PACKAGER_MIME_TYPE),
+             startWithSAP     (1),
+             maximumSAPPeriod (0),
+             singleFile       (false),
+             live             (false),
+             minimumUpdatePeriod          (0),
+             timeShiftBufferDepth         (0),
+             suggestedPresentationDelay   (0)
+{
+}
+MpdPackager::~MpdPackager     ()
+{
+}
+
+void    MpdPackager::SetBaseURL         (const std::string &url)
+{
+    this->baseURL = url;
+}
+void    MpdPackager::SetTitle           (const std::string &title)
+{
+    this->title = title;
+}
+void    MpdPackager::SetMinBufferTime   (double seconds)
+{
+    this->minBufferTime = seconds;
+}
+void    MpdPackager::SetVideoSize       (uint32_t width, uint32_t height)
+{
+    this->width  = width;
+    this->height = height;
+}
+void    MpdPackager::SetMimeType        (const std::string &mimeType, const std::string &codecs)
+{
+    this->mimeType = mimeType;
+    this->codecs   = codecs;
+}
+void    MpdPackager::SetSAP             (uint8_t startWithSAP, double maximumSAPPeriod)
+{
+    this->startWithSAP     = startWithSAP;
+    this->maximumSAPPeriod = maximumSAPPeriod;
+}
+void    MpdPackager::SetLive            (const std::string &availabilityStartTime, double minimumUpdatePeriod,
+                                         double timeShiftBufferDepth, double suggestedPresentationDelay)
+{
+    this->live                       = true;
+    this->availabilityStartTime      = availabilityStartTime;
+    this->minimumUpdatePeriod        = minimumUpdatePeriod;
+    this->timeShiftBufferDepth       = timeShiftBufferDepth;
+    this->suggestedPresentationDelay = suggestedPresentationDelay;
+}
+void    MpdPackager::AddRepresentation  (const std::string &id, const std::string &media,
+                                         const std::string &codecs, double frameRate)
+{
+    PackagedRepresentation representation;
+
+    representation.id        = id;
+    representation.media     = media;
+    representation.codecs    = codecs;
+    representation.frameRate = frameRate;
+    this->representations.push_back(representation);
+}
+void    MpdPackager::AddSegment         (size_t representation, uint32_t number, size_t frames, uint64_t bytes,
+                                         const std::string &path)
+{
+    PackagedSegment segment;
+
+    segment.number = number;
+    segment.frames = frames;
+    segment.bytes  = bytes;
+    segment.path   = path;
+    segment.offset = 0;
+    segment.complexity = PackagedComplexity();
+    this->representations.at(representation).segments.push_back(segment);
+}
+bool    MpdPackager::ReadSizes          (const std::string &path, size_t first, size_t *streams)
+{
+    std::ifstream   in(path.c_str());
+    std::string     line;
+
+    if (streams != NULL)
+        *streams = 0;
+    if (!in || !std::getline(in, line))
+        return false;
+
+    /* segment,startFrameNumber,frameCount,stream,path,bytes */
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if (line.empty())
+            continue;
+
+        size_t fields[4];
+        size_t pos = 0;
+
+        for (size_t i = 0; i < 4; i++)
+        {
+            fields[i] = strtoul(line.c_str() + pos, NULL, 10);
+            pos       = line.find(',', pos);
+            if (pos == std::string::npos)
+                return false;
+            pos++;
+        }
+
+        /* the path may hold commas, the size is the last column */
+        size_t      last    = line.rfind(',');
+        long long   bytes   = strtoll(line.c_str() + last + 1, NULL, 10);
+
+        if (streams != NULL)
+            *streams = (std::max)(*streams, fields[3] + 1);
+        if (first + fields[3] >= this->representations.size())
+            continue;
+        std::string segmentPath = line.substr(pos, last - pos);
+        size_t      stream      = first + fields[3];
+
+        if (bytes < 0)
+        {
+            std::cerr << "missing segment " << fields[0] << ": " << segmentPath << "\n";
+            return false;
+        }
+        this->AddSegment(stream, (uint32_t) fields[0], fields[2], (uint64_t) bytes, segmentPath);
+        ReadComplexity(segmentPath, this->representations.at(stream).segments.back().complexity);
+    }
+
+    for (size_t i = 0; i < this->representations.size(); i++)
+    {
+        std::vector<PackagedSegment> &segments = this->representations.at(i).segments;
+
+        std::sort(segments.begin(), segments.end(),
+                  [](const PackagedSegment &a, const PackagedSegment &b) { return a.number < b.number; });
+    }
+
+    return true;
+}
+bool    MpdPackager::SplitLayers        (size_t layers)
+{
+    std::vector<PackagedRepresentation> split;
+
+    if (layers < 2)
+        return layers == 1;
+
+    for (size_t r = 0; r < this->representations.size(); r++)
+    {
+        const PackagedRepresentation        &packaged = this->representations.at(r);
+        std::vector<PackagedRepresentation> layered(layers);
+
+        for (size_t k = 0; k < layers; k++)
+        {
+            layered.at(k).id     = k == 0 ? packaged.id : packaged.id + "_l" + std::to_string(k);
+            layered.at(k).media  = LayerPath(packaged.media, k);
+            layered.at(k).codecs = packaged.codecs;
+            layered.at(k).frameRate = packaged.frameRate;
+            for (size_t d = 0; d < k; d++)
+                layered.at(k).dependencies.push_back(layered.at(d).id);
+        }
+
+        for (size_t i = 0; i < packaged.segments.size(); i++)
+        {
+            const PackagedSegment               &segment = packaged.segments.at(i);
+            std::ifstream                       in(segment.path.c_str(), std::ios::binary);
+            std::vector<uint8_t>                data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            std::vector<std::vector<uint8_t>>   parts;
+
+            if (!in || data.size() != segment.bytes || !mcnl::SplitLayers(data, layers, parts))
+            {
+                std::cerr << "cannot split " << segment.path << " into " << layers << " layers\n";
+                return false;
+            }
+
+            for (size_t k = 0; k < layers; k++)
+            {
+                PackagedSegment part = segment;
+                std::ofstream   out;
+
+                part.path  = LayerPath(segment.path, k);
+                part.bytes = parts.at(k).size();
+                out.open(part.path.c_str(), std::ios::binary | std::ios::trunc);
+                out.write((const char *) parts.at(k).data(), parts.at(k).size());
+                if (!out)
+                {
+                    std::cerr << "cannot write " << part.path << "\n";
+                    return false;
+                }
+                layered.at(k).segments.push_back(part);
+            }
+        }
+        split.insert(split.end(), layered.begin(), layered.end());
+    }
+    this->representations.swap(split);
+
+    return true;
+}
+
+size_t                          MpdPackager::RepresentationCount    ()  const
+{
+    return this->representations.size();
+}
+const PackagedRepresentation&   MpdPackager::Packaged              (size_t representation) const
+{
+    return this->representations.at(representation);
+}
+double                          MpdPackager::FrameRate              (size_t representation) const
+{
+    double frameRate = this->representations.at(representation).frameRate;
+
+    return frameRate > 0 ? frameRate : this->frameRate;
+}
+double                          MpdPackager::MinBufferTime          ()  const
+{
+    return this->minBufferTime > 0 ? this->minBufferTime : this->MaxDuration();
+}
+uint32_t                        MpdPackager::Bandwidth              (size_t representation) const
+{
+    const std::vector<PackagedSegment>  &segments = this->representations.at(representation).segments;
+    std::vector<size_t>                 chain     = this->Chain(representation);
+    std::vector<uint64_t>               bytes;
+    std::vector<double>                 durations;
+
+    /* Write checks that the segments line up */
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        bytes.push_back(0);
+        for (size_t k = 0; k < chain.size(); k++)
+            if (i < this->representations.at(chain.at(k)).segments.size())
+                bytes.back() += this->representations.at(chain.at(k)).segments.at(i).bytes;
+        durations.push_back(this->Seconds(representation, segments.at(i).frames));
+    }
+
+    return DeliveryBandwidth(bytes, durations, this->MinBufferTime());
+}
+double                          MpdPackager::PeakBitrate            (size_t representation) const
+{
+    const std::vector<PackagedSegment>  &segments = this->representations.at(representation).segments;
+    double                              peak      = 0;
+
+    for (size_t i = 0; i < segments.size(); i++)
+        if (segments.at(i).frames > 0)
+            peak = (std::max)(peak, 8.0 * segments.at(i).bytes /
+                                    this->Seconds(representation, segments.at(i).frames));
+
+    return peak;
+}
+double                          MpdPackager::MeanBitrate            (size_t representation) const
+{
+    const std::vector<PackagedSegment>  &segments = this->representations.at(representation).segments;
+    double                              bits      = 0;
+    size_t                              frames    = 0;
+
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        bits   += 8.0 * segments.at(i).bytes;
+        frames += segments.at(i).frames;
+    }
+
+    return frames > 0 ? bits / this->Seconds(representation, frames) : 0;
+}
+
+bool    MpdPackager::Concatenate        (const std::string &directory)
+{
+    for (size_t r = 0; r < this->representations.size(); r++)
+    {
+        PackagedRepresentation  &packaged = this->representations.at(r);
+        std::string             path      = directory.empty() ? packaged.media : directory + "/" + packaged.media;
+        std::ofstream           out(path.c_str(), std::ios::binary | std::ios::trunc);
+        uint64_t                offset    = 0;
+
+        if (!out)
+        {
+            std::cerr << "cannot write " << path << "\n";
+            return false;
+        }
+
+        for (size_t i = 0; i < packaged.segments.size(); i++)
+        {
+            PackagedSegment &segment = packaged.segments.at(i);
+            std::ifstream   in(segment.path.c_str(), std::ios::binary);
+
+            if (!in || segment.bytes == 0)
+            {
+                std::cerr << "cannot read " << segment.path << "\n";
+                return false;
+            }
+            if (in.peek() != std::ifstream::traits_type::eof())
+                out << in.rdbuf();
+            if (!out || (uint64_t) out.tellp() != offset + segment.bytes)
+            {
+                std::cerr << segment.path << " is not " << segment.bytes << " bytes\n";
+                return false;
+            }
+            segment.offset  = offset;
+            offset         += segment.bytes;
+        }
+    }
+    this->singleFile = true;
+
+    return true;
+}
+
+bool    MpdPackager::Write              (const std::string &path) const
+{
+    if (this->representations.empty() || this->representations.at(0).segments.empty() || !this->Aligned())
+        return false;
+
+    MPD *mpd = new MPD();
+
+    mpd->SetProfiles(PACKAGER_PROFILE);
+    if (this->live)
+    {
+        mpd->SetType("dynamic");
+        mpd->SetAvailabilityStarttime(this->availabilityStartTime);
+        mpd->SetPublishTime(FormatNow());
+        if (this->minimumUpdatePeriod > 0)
+            mpd->SetMinimumUpdatePeriod(FormatDuration(this->minimumUpdatePeriod));
+        if (this->timeShiftBufferDepth > 0)
+            mpd->SetTimeShiftBufferDepth(FormatDuration(this->timeShiftBufferDepth));
+        if (this->suggestedPresentationDelay > 0)
+            mpd->SetSuggestedPresentationDelay(FormatDuration(this->suggestedPresentationDelay));
+    }
+    else
+    {
+        mpd->SetType("static");
+        mpd->SetMediaPresentationDuration(FormatDuration(this->Duration()));
+    }
+    mpd->SetMinBufferTime(FormatDuration(this->MinBufferTime()));
+    mpd->SetMaxSegmentDuration(FormatDuration(this->MaxDuration()));
+    if (!this->title.empty())
+    {
+        ProgramInformation *information = new ProgramInformation();
+        information->SetTitle(this->title);
+        mpd->AddProgramInformation(information);
+    }
+    if (!this->baseURL.empty())
+    {
+        BaseUrl *url = new BaseUrl();
+        url->SetUrl(this->baseURL);
+        mpd->AddBaseUrl(url);
+    }
+
+    Period          *period         = new Period();
+    AdaptationSet   *adaptationSet  = new AdaptationSet();
+    uint32_t        minBandwidth    = UINT32_MAX;
+    uint32_t        maxBandwidth    = 0;
+    size_t          first           = this->FirstListed();
+    double          minFrameRate    = this->FrameRate(0);
+    double          maxFrameRate    = this->FrameRate(0);
+
+    for (size_t r = 1; r < this->representations.size(); r++)
+    {
+        minFrameRate = (std::min)(minFrameRate, this->FrameRate(r));
+        maxFrameRate = (std::max)(maxFrameRate, this->FrameRate(r));
+    }
+
+    period->SetId("0");
+    period->SetStart("PT0S");
+    adaptationSet->SetId(1);
+    adaptationSet->SetSegmentAlignment(true);
+    adaptationSet->SetMimeType(this->mimeType);
+    /* one frame rate for all, or the range and each its own */
+    if (minFrameRate == maxFrameRate)
+        adaptationSet->SetFrameRate(FormatFrameRate(maxFrameRate));
+    else
+    {
+        adaptationSet->SetMinFramerate(FormatFrameRate(minFrameRate));
+        adaptationSet->SetMaxFramerate(FormatFrameRate(maxFrameRate));
+    }
+    adaptationSet->SetMaxWidth(this->width);
+    adaptationSet->SetMaxHeight(this->height);
+    adaptationSet->SetStartWithSAP(this->startWithSAP);
+    adaptationSet->SetMaximumSAPPeriod(this->maximumSAPPeriod);
+
+    for (size_t r = 0; r < this->representations.size(); r++)
+    {
+        const PackagedRepresentation    &packaged       = this->representations.at(r);
+        Representation                  *representation = new Representation();
+        uint32_t                        bandwidth       = this->Bandwidth(r);
+        std::vector<PackagedSegment>    listed(packaged.segments.begin() + first, packaged.segments.end());
+        std::string                     complexity      = ComplexityValue(listed);
+        uint32_t                        timescale       = 0;
+        uint32_t                        tick            = 0;
+        uint64_t                        startTime       = 0;
+
+        FrameTicks(this->FrameRate(r), timescale, tick);
+        for (size_t i = 0; i < first; i++)
+            startTime += packaged.segments.at(i).frames * tick;
+
+        minBandwidth = (std::min)(minBandwidth, bandwidth);
+        maxBandwidth = (std::max)(maxBandwidth, bandwidth);
+
+        representation->SetId(packaged.id);
+        representation->SetBandwidth(bandwidth);
+        representation->SetWidth(this->width);
+        representation->SetHeight(this->height);
+        representation->SetCodecs(packaged.codecs.empty() ? this->codecs : packaged.codecs);
+        if (minFrameRate != maxFrameRate)
+            representation->SetFrameRate(FormatFrameRate(this->FrameRate(r)));
+        if (!packaged.dependencies.empty())
+        {
+            std::string dependencyId;
+
+            for (size_t k = 0; k < packaged.dependencies.size(); k++)
+                dependencyId += (k > 0 ? " " : "") + packaged.dependencies.at(k);
+            representation->SetDependencyId(dependencyId);
+        }
+        if (!complexity.empty())
+        {
+            Descriptor *property = new Descriptor();
+
+            property->SetSchemeIdUri(COMPLEXITY_SCHEME_ID);
+            property->SetValue(complexity);
+            representation->AddSupplementalProperty(property);
+        }
+
+        if (this->singleFile)
+        {
+            BaseUrl     *url  = new BaseUrl();
+            SegmentList *list = new SegmentList();
+
+            url->SetUrl(packaged.media);
+            representation->AddBaseURL(url);
+            SetTiming(list, listed, timescale, tick, this->live, startTime);
+            list->ReserveSegmentURLs(listed.size());
+            for (size_t i = 0; i < listed.size(); i++)
+            {
+                const PackagedSegment &segment = listed.at(i);
+
+                list->AddSegmentURL("", std::to_string(segment.offset) + "-" +
+                                        std::to_string(segment.offset + segment.bytes - 1), "", "");
+            }
+            representation->SetSegmentList(list);
+        }
+        else
+        {
+            SegmentTemplate *segmentTemplate = new SegmentTemplate();
+
+            segmentTemplate->SetMedia(packaged.media);
+            SetTiming(segmentTemplate, listed, timescale, tick, this->live, startTime);
+            representation->SetSegmentTemplate(segmentTemplate);
+        }
+        adaptationSet->AddRepresentation(representation);
+    }
+    adaptationSet->SetMinBandwidth(minBandwidth);
+    adaptationSet->SetMaxBandwidth(maxBandwidth);
+    period->AddAdaptationSet(adaptationSet);
+    mpd->AddPeriod(period);
+
+    dash::IDASHManager  *manager = CreateDashManager();
+    std::string         written  = path + ".tmp";
+    bool                ok       = manager->Write(mpd, written);
+
+    /* what the client will see */
+    if (ok)
+    {
+        std::vector<char>   name(written.begin(), written.end());
+        name.push_back('\0');
+        IMPD                *check = manager->Open(name.data());
+
+        ok = check != NULL && check->GetPeriods().size() == 1 &&
+             check->GetPeriods().at(0)->GetAdaptationSets().size() == 1;
+
+        for (size_t r = 0; ok && r < this->representations.size(); r++)
+        {
+            const std::vector<IRepresentation *> &read =
+                check->GetPeriods().at(0)->GetAdaptationSets().at(0)->GetRepresentation();
+            const std::vector<PackagedSegment>  &segments = this->representations.at(r).segments;
+            std::string                         complexity;
+
+            if (r < read.size())
+                for (size_t k = 0; k < read.at(r)->GetSupplementalProperties().size(); k++)
+                    if (read.at(r)->GetSupplementalProperties().at(k)->GetSchemeIdUri() == COMPLEXITY_SCHEME_ID)
+                        complexity = read.at(r)->GetSupplementalProperties().at(k)->GetValue();
+
+            ok = r < read.size() && read.at(r)->GetId() == this->representations.at(r).id &&
+                 complexity == ComplexityValue(std::vector<PackagedSegment>(segments.begin() + this->FirstListed(),
+                                                                            segments.end())) &&
+                 read.at(r)->GetBandwidth() == this->Bandwidth(r) &&
+                 read.at(r)->GetDependencyId() == this->representations.at(r).dependencies &&
+                 read.at(r)->GetFrameRate() == (minFrameRate == maxFrameRate ? "" : FormatFrameRate(this->FrameRate(r))) &&
+                 (this->singleFile ? read.at(r)->GetSegmentList() != NULL : read.at(r)->GetSegmentTemplate() != NULL);
+        }
+        if (!ok)
+            std::cerr << path << " does not read back\n";
+        delete check;
+    }
+    if (ok && rename(written.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "cannot rename " << written << " to " << path << "\n";
+        ok = false;
+    }
+    if (!ok)
+        remove(written.c_str());
+
+    manager->Delete();
+    delete mpd;
+
+    return ok;
+}
+
+double  MpdPackager::Seconds            (size_t representation, size_t frames) const
+{
+    double frameRate = this->FrameRate(representation);
+
+    return frameRate > 0 ? frames / frameRate : 0;
+}
+std::vector<size_t> MpdPackager::Chain (size_t representation) const
+{
+    const std::vector<std::string>  &dependencies = this->representations.at(representation).dependencies;
+    std::vector<size_t>             chain;
+
+    for (size_t k = 0; k < dependencies.size(); k++)
+        for (size_t r = 0; r < this->representations.size(); r++)
+            if (this->representations.at(r).id == dependencies.at(k))
+                chain.push_back(r);
+    chain.push_back(representation);
+
+    return chain;
+}
+double  MpdPackager::Duration           () const
+{
+    size_t frames = 0;
+
+    if (!this->representations.empty())
+        for (size_t i = 0; i < this->representations.at(0).segments.size(); i++)
+            frames += this->representations.at(0).segments.at(i).frames;
+
+    return this->Seconds(0, frames);
+}
+double  MpdPackager::MaxDuration        () const
+{
+    size_t frames = 0;
+
+    if (!this->representations.empty())
+        for (size_t i = 0; i < this->representations.at(0).segments.size(); i++)
+            frames = (std::max)(frames, this->representations.at(0).segments.at(i).frames);
+
+    return this->Seconds(0, frames);
+}
+size_t  MpdPackager::FirstListed        () const
+{
+    const std::vector<PackagedSegment>  &segments = this->representations.at(0).segments;
+    double                              from      = this->Duration() - this->timeShiftBufferDepth;
+    size_t                              first     = segments.size() - 1;
+    double                              start     = this->Duration() - this->Seconds(0, segments.back().frames);
+
+    if (!this->live || this->timeShiftBufferDepth <= 0)
+        return 0;
+
+    /* the last segment is always listed */
+    while (first > 0 && start - this->Seconds(0, segments.at(first - 1).frames) >= from)
+        start -= this->Seconds(0, segments.at(--first).frames);
+
+    return first;
+}
+std::string MpdPackager::ComplexityValue   (const std::vector<PackagedSegment> &segments)
+{
+    std::string value;
+
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        const PackagedComplexity    &complexity = segments.at(i).complexity;
+        char                        record[160];
+
+        if (complexity.points == 0)
+            return "";
+
+        snprintf(record, sizeof(record), "%s%llu,%llu,%u,%u,%llu,%llu,%llu", i > 0 ? " " : "",
+                 (unsigned long long) complexity.points, (unsigned long long) complexity.patches,
+                 complexity.atlasWidth, complexity.atlasHeight, (unsigned long long) complexity.occupancyBytes,
+                 (unsigned long long) complexity.geometryBytes, (unsigned long long) complexity.attributeBytes);
+        value += record;
+    }
+
+    return value;
+}
+bool    MpdPackager::Aligned            () const
+{
+    const std::vector<PackagedSegment> &first = this->representations.at(0).segments;
+
+    for (size_t i = 0; i < first.size(); i++)
+        if (first.at(i).number != first.at(0).number + i)
+            return false;
+
+    for (size_t r = 1; r < this->representations.size(); r++)
+    {
+        const std::vector<PackagedSegment> &segments = this->representations.at(r).segments;
+
+        if (segments.size() != first.size())
+            return false;
+        for (size_t i = 0; i < segments.size(); i++)
+            if (segments.at(i).number != first.at(i).number ||
+                fabs(this->Seconds(r, segments.at(i).frames) - this->Seconds(0, first.at(i).frames)) > 1e-6)
+                return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,216 @@
+/*
+ * MpdPackager.h
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *
+ * Builds the MPD of an encoded content from the real size and duration of
+ * every segment (see PccAppEncoder --segmentSizesPath) with the libdash MPD
+ * object model, and writes it through libdash. Each segment is a V3C sample
+ * stream that starts with its own VPS, so there is no initialization
+ * segment; the segments are addressed with a SegmentTemplate ($Number$),
+ * with a SegmentTimeline if their durations differ.
+ *
+ * In the single file mode the segments of a representation are
+ * concatenated into one file instead, and the MPD lists them as byte
+ * ranges of it (SegmentList, SegmentURL@mediaRange): one cacheable object
+ * per representation, fetched over one connection with Range requests.
+ *
+ * Every segment is encoded on its own (PccAppEncoder --segmentFrameCount),
+ * so it is a closed GOP that starts with an IDR whatever the coding
+ * condition: all-intra, low-delay or random-access. @startWithSAP is 1 by
+ * default; @maximumSAPPeriod tells how far apart the SAPs are, one frame
+ * for all-intra and one segment for inter coding.
+ *
+ * @bandwidth is what DASH means by it: the smallest rate in bits/s at which
+ * the representation, delivered from the start of any segment, has every
+ * segment complete before its playout starts when playout begins
+ * @minBufferTime after the first bit. For a dependent representation that
+ * is the representation together with all its complementary ones.
+ *
+ * A content encoded with SHVC can have every stream split by layer
+ * (SplitLayers): the base layer becomes a representation of its own, each
+ * enhancement layer one that depends on it and the layers in between
+ * (@dependencyId). A client that has the base of a segment then upgrades
+ * it with the enhancement bytes only.
+ *
+ * The representations need not share a video codec: every segment carries
+ * its own VPS, so e.g. the high tier can be VVC coded (@codecs v3c1,vvi1)
+ * next to HEVC (v3c1,hev1) ones, see AddRepresentation.
+ *
+ * A representation can have a frame rate of its own (temporal
+ * scalability): e.g. every quality at 30, 15 and 10 fps, with the segments
+ * of all of them lasting the same time, so fewer frames at the lower rates.
+ * A client short of decode time then halves its decode work at the same
+ * geometry quality instead of dropping to a coarser one. The frame rate of
+ * such a representation is its @frameRate, and the AdaptationSet tells the
+ * range in @minFrameRate and @maxFrameRate.
+ *
+ * A live content (SetLive, PccAppEncoder --segmentLive) is packaged again
+ * after every published segment into a type="dynamic" MPD, which lists the
+ * segments published so far in a SegmentTimeline: a client refreshes it
+ * every minimumUpdatePeriod and never asks for a segment that is not there.
+ *
+ * With the decode complexity of every segment, which PccAppEncoder
+ * --writeComplexity writes next to the bitstream as <bitstream>.complexity,
+ * each Representation tells what its listed segments take to decode, one
+ * record per segment in order, so that a client can predict the decode
+ * cost of a segment before it fetches it:
+ *
+ *   <SupplementalProperty schemeIdUri="urn:mcnl:vpcc:complexity:2022"
+ *       value="points,patches,atlasWidth,atlasHeight,occupancyBytes,geometryBytes,attributeBytes ..."/>
+ *
+ * points and patches are those of all the frames of the segment, the atlas
+ * is the largest one, and the bytes are those of the video bitstreams. A
+ * layer of SplitLayers carries the figures of the whole segment.
+ *****************************************************************************/
+
+#ifndef MPDPACKAGER_H_
+#define MPDPACKAGER_H_
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PACKAGER_MIME_TYPE  "application/octet-stream"  /* V3C sample streams, not ISOBMFF */
+#define PACKAGER_PROFILE    "urn:mpeg:dash:profile:full:2011"
+#define COMPLEXITY_SCHEME_ID "urn:mcnl:vpcc:complexity:2022"
+
+namespace mcnl
+{
+    /* see above; points is 0 if the encoder did not write it */
+    struct PackagedComplexity
+    {
+        uint64_t    points;
+        uint64_t    patches;
+        uint32_t    atlasWidth;
+        uint32_t    atlasHeight;
+        uint64_t    occupancyBytes;
+        uint64_t    geometryBytes;
+        uint64_t    attributeBytes;
+    };
+
+    struct PackagedSegment
+    {
+        uint32_t    number;     /* $Number$ */
+        size_t      frames;
+        uint64_t    bytes;
+        std::string path;       /* the encoder's bitstream */
+        uint64_t    offset;     /* in the single file */
+        PackagedComplexity  complexity;
+    };
+
+    struct PackagedRepresentation
+    {
+        std::string                     id;
+        /* SegmentTemplate@media, or the single file; relative to the BaseURL */
+        std::string                     media;
+        std::vector<PackagedSegment>    segments;
+        /* @codecs, empty for that of SetMimeType */
+        std::string                     codecs;
+        /* @dependencyId, the complementary representations, lowest layer first */
+        std::vector<std::string>        dependencies;
+        /* frames per second, 0 for that of the MpdPackager */
+        double                          frameRate;
+    };
+
+    /* bits/s, see above; durations in seconds */
+    uint32_t    DeliveryBandwidth   (const std::vector<uint64_t> &bytes, const std::vector<double> &durations,
+                                     double minBufferTime);
+
+    class MpdPackager
+    {
+        public:
+            MpdPackager             (double frameRate);
+            virtual ~MpdPackager    ();
+
+            void    SetBaseURL      (const std::string &url);
+            void    SetTitle        (const std::string &title);
+            /* seconds, default: the longest segment */
+            void    SetMinBufferTime(double seconds);
+            void    SetVideoSize    (uint32_t width, uint32_t height);
+            void    SetMimeType     (const std::string &mimeType, const std::string &codecs);
+            /* SAP type at the start of every segment; seconds between SAPs, 0 = not signaled */
+            void    SetSAP          (uint8_t startWithSAP, double maximumSAPPeriod);
+            /* type="dynamic", see above; availabilityStartTime is an
+             * xs:dateTime in UTC, the rest seconds. Only the segments of the
+             * last timeShiftBufferDepth are listed, and always the last one;
+             * 0 = all of them */
+            void    SetLive         (const std::string &availabilityStartTime, double minimumUpdatePeriod,
+                                     double timeShiftBufferDepth, double suggestedPresentationDelay);
+
+            /* codecs overrides that of SetMimeType for this representation,
+             * frameRate (if not 0) that of the MpdPackager */
+            void    AddRepresentation   (const std::string &id, const std::string &media,
+                                         const std::string &codecs = "", double frameRate = 0);
+            void    AddSegment          (size_t representation, uint32_t number, size_t frames, uint64_t bytes,
+                                         const std::string &path = "");
+            /* CSV of PccAppEncoder --segmentSizesPath; stream i goes to the
+             * representation first + i, so that the encodes of several frame
+             * rates follow one another. streams (if not NULL) is set to the
+             * number of streams in the CSV. The complexity of a segment is
+             * read from next to its bitstream, if it is there */
+            bool    ReadSizes           (const std::string &path, size_t first = 0, size_t *streams = NULL);
+            /* every representation is an SHVC stream of `layers` layers: each
+             * is replaced by its base layer, keeping the id, followed by one
+             * dependent representation ID_l<k> per enhancement layer. The
+             * segments of layer k are written next to the encoder's, see
+             * LayerPath, and so is the media; false if a segment cannot be
+             * read, split or written */
+            bool    SplitLayers         (size_t layers);
+
+            size_t                          RepresentationCount ()  const;
+            const PackagedRepresentation&   Packaged            (size_t representation) const;
+            double                          FrameRate           (size_t representation) const;
+            double                          MinBufferTime       ()  const;
+            uint32_t                        Bandwidth           (size_t representation) const;
+            /* bits/s of the largest segment over its own duration */
+            double                          PeakBitrate         (size_t representation) const;
+            double                          MeanBitrate         (size_t representation) const;
+
+            /* writes the single file of every representation, media
+             * relative to directory (that of the MPD), and switches Write
+             * to byte ranges; false if a bitstream is missing or its size
+             * differs from the one read */
+            bool    Concatenate         (const std::string &directory);
+
+            /* false if the segments do not line up or the MPD cannot be
+             * written; the written MPD is read back with libdash to check it,
+             * and only then renamed to path, so that the origin never
+             * serves a half written one */
+            bool    Write               (const std::string &path) const;
+
+        private:
+            double                              frameRate;
+            std::string                         baseURL;
+            std::string                         title;
+            double                              minBufferTime;
+            uint32_t                            width;
+            uint32_t                            height;
+            std::string                         mimeType;
+            std::string                         codecs;
+            uint8_t                             startWithSAP;
+            double                              maximumSAPPeriod;
+            std::vector<PackagedRepresentation> representations;
+            bool                                singleFile;
+            bool                                live;
+            std::string                         availabilityStartTime;
+            double                              minimumUpdatePeriod;
+            double                              timeShiftBufferDepth;
+            double                              suggestedPresentationDelay;
+
+            double  Seconds         (size_t representation, size_t frames) const;
+            /* the representation and its complementary ones */
+            std::vector<size_t> Chain   (size_t representation) const;
+            double  Duration        () const;
+            double  MaxDuration     () const;
+            /* the first segment within timeShiftBufferDepth */
+            size_t  FirstListed     () const;
+            /* all representations have the same segment numbers and durations */
+            bool    Aligned         () const;
+            /* the value of the complexity property, empty unless every segment has it */
+            static std::string  ComplexityValue (const std::vector<PackagedSegment> &segments);
+    };
+}
+
+#endif /* MPDPACKAGER_H_ */
@@ -0,0 +1,225 @@
+/*
+ * Packager.cpp
+ *****************************************************************************
+ * MCNL-ARstreaming Capston Project - Server
+ *
+ * MpdPackager [options] SIZES_CSV[,SIZES_CSV...] OUTPUT_MPD ID=MEDIA...
+ *
+ * One ID=MEDIA per stream of SIZES_CSV, in the order of the encoder's
+ * rateConfigs, e.g. low=low/low_s$Number$.bin. The streams of several
+ * SIZES_CSV, e.g. one encode per frame rate, follow one another in the
+ * order the files are given. Options:
+ *   --frameRate=F          frames per second (required)
+ *   --frameRate=ID=F       frames per second of representation ID instead,
+ *                          e.g. high_15=15 for the high tier at half the
+ *                          frame rate; its segments last as long as those
+ *                          of the others, with fewer frames
+ *   --baseURL=URL
+ *   --title=TITLE
+ *   --minBufferTime=S      seconds, default: the longest segment
+ *   --width=W --height=H   video size, left out if 0
+ *   --mimeType=TYPE        default application/octet-stream
+ *   --codecs=CODECS        @codecs of the representations, e.g. v3c1,hev1
+ *   --codecs=ID=CODECS     @codecs of representation ID instead, e.g.
+ *                          high=v3c1,vvi1 for a VVC coded high tier;
+ *                          repeated for each such representation
+ *   --startWithSAP=N       SAP type of the segment starts, default 1
+ *   --maximumSAPPeriod=S   seconds between SAPs: 1 / F for all-intra,
+ *                          the segment duration for low-delay and
+ *                          random-access; not signaled if 0
+ *   --singleFile           MEDIA is one file per representation, written
+ *                          next to OUTPUT_MPD from the segments, which
+ *                          the MPD then lists as byte ranges of it
+ *   --layers=N             every stream is SHVC coded with N layers: the
+ *                          base layer is representation ID, at MEDIA with
+ *                          _l0 ahead of the extension, and layer k the
+ *                          dependent representation ID_l<k> at MEDIA with
+ *                          _l<k>; the layer segments are written next to
+ *                          the encoder's
+ *   --availabilityStartTime=T
+ *                          live: a type="dynamic" MPD of the segments of
+ *                          SIZES_CSV so far, which is run again after each
+ *                          one that PccAppEncoder --segmentLive publishes;
+ *                          T is the UTC start of the stream, e.g.
+ *                          2021-10-25T09:00:00Z
+ *   --minimumUpdatePeriod=S   live: seconds between MPD refreshes of the
+ *                          clients, default: the longest segment
+ *   --timeShiftBufferDepth=S  live: seconds of segments listed, default all
+ *   --suggestedPresentationDelay=S
+ *                          live: seconds behind the live edge to play at
+ *****************************************************************************/
+
+#include "MpdPackager.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+using namespace mcnl;
+
+static bool Option  (const char *arg, const char *name, string &value)
+{
+	size_t length = strlen(name);
+
+	if(strncmp(arg, name, length) != 0 || arg[length] != '=')
+		return false;
+
+	value = arg + length + 1;
+	return true;
+}
+
+static int  Usage   ()
+{
+	cerr << "Usage: MpdPackager --frameRate=F [--baseURL=URL] [--title=T] [--minBufferTime=S] [--width=W --height=H]\n"
+	        "                   [--frameRate=ID=F]... [--mimeType=TYPE] [--codecs=[ID=]CODECS]... [--startWithSAP=N]\n"
+	        "                   [--maximumSAPPeriod=S] [--singleFile] [--layers=N]\n"
+	        "                   [--availabilityStartTime=T [--minimumUpdatePeriod=S] [--timeShiftBufferDepth=S]\n"
+	        "                    [--suggestedPresentationDelay=S]] SIZES_CSV[,SIZES_CSV...] OUTPUT_MPD ID=MEDIA...\n";
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	double frameRate = 0, minBufferTime = 0, maximumSAPPeriod = 0;
+	double minimumUpdatePeriod = 0, timeShiftBufferDepth = 0, suggestedPresentationDelay = 0;
+	unsigned startWithSAP = 1, layers = 1;
+	uint32_t width = 0, height = 0;
+	string baseURL, title, mimeType = PACKAGER_MIME_TYPE, codecs, availabilityStartTime, value;
+	vector<string> positional;
+	map<string, string> representationCodecs;
+	map<string, double> representationFrameRates;
+	bool singleFile = false;
+
+	for(int i = 1; i < argc; i++) {
+		if(Option(argv[i], "--frameRate", value)) {
+			size_t equal = value.find('=');
+			if(equal == string::npos)
+				frameRate = atof(value.c_str());
+			else
+				representationFrameRates[value.substr(0, equal)] = atof(value.c_str() + equal + 1);
+		}
+		else if(Option(argv[i], "--baseURL", value))
+			baseURL = value;
+		else if(Option(argv[i], "--title", value))
+			title = value;
+		else if(Option(argv[i], "--minBufferTime", value))
+			minBufferTime = atof(value.c_str());
+		else if(Option(argv[i], "--width", value))
+			width = (uint32_t)strtoul(value.c_str(), NULL, 10);
+		else if(Option(argv[i], "--height", value))
+			height = (uint32_t)strtoul(value.c_str(), NULL, 10);
+		else if(Option(argv[i], "--mimeType", value))
+			mimeType = value;
+		else if(Option(argv[i], "--codecs", value)) {
+			size_t equal = value.find('=');
+			if(equal == string::npos)
+				codecs = value;
+			else
+				representationCodecs[value.substr(0, equal)] = value.substr(equal + 1);
+		}
+		else if(Option(argv[i], "--startWithSAP", value))
+			startWithSAP = (unsigned)strtoul(value.c_str(), NULL, 10);
+		else if(Option(argv[i], "--maximumSAPPeriod", value))
+			maximumSAPPeriod = atof(value.c_str());
+		else if(Option(argv[i], "--layers", value))
+			layers = (unsigned)strtoul(value.c_str(), NULL, 10);
+		else if(Option(argv[i], "--availabilityStartTime", value))
+			availabilityStartTime = value;
+		else if(Option(argv[i], "--minimumUpdatePeriod", value))
+			minimumUpdatePeriod = atof(value.c_str());
+		else if(Option(argv[i], "--timeShiftBufferDepth", value))
+			timeShiftBufferDepth = atof(value.c_str());
+		else if(Option(argv[i], "--suggestedPresentationDelay", value))
+			suggestedPresentationDelay = atof(value.c_str());
+		else if(strcmp(argv[i], "--singleFile") == 0)
+			singleFile = true;
+		else if(strncmp(argv[i], "--", 2) == 0)
+			return Usage();
+		else
+			positional.push_back(argv[i]);
+	}
+	if(frameRate <= 0 || positional.size() < 3 || startWithSAP > 6 || layers == 0)
+		return Usage();
+	/* the single file of a live content would be rewritten with every segment */
+	if(singleFile && !availabilityStartTime.empty()) {
+		cerr << "--singleFile is not supported with --availabilityStartTime\n";
+		return Usage();
+	}
+
+	MpdPackager packager(frameRate);
+	packager.SetBaseURL(baseURL);
+	packager.SetTitle(title);
+	packager.SetMinBufferTime(minBufferTime);
+	packager.SetVideoSize(width, height);
+	packager.SetMimeType(mimeType, codecs);
+	packager.SetSAP((uint8_t)startWithSAP, maximumSAPPeriod);
+
+	for(size_t i = 2; i < positional.size(); i++) {
+		size_t equal = positional[i].find('=');
+		if(equal == string::npos || equal == 0)
+			return Usage();
+		string id = positional[i].substr(0, equal);
+		map<string, string>::iterator codec = representationCodecs.find(id);
+		map<string, double>::iterator rate = representationFrameRates.find(id);
+		packager.AddRepresentation(id, positional[i].substr(equal + 1),
+		                           codec == representationCodecs.end() ? "" : codec->second,
+		                           rate == representationFrameRates.end() ? 0 : rate->second);
+		if(codec != representationCodecs.end())
+			representationCodecs.erase(codec);
+		if(rate != representationFrameRates.end())
+			representationFrameRates.erase(rate);
+	}
+	if(!representationCodecs.empty()) {
+		cerr << "--codecs for " << representationCodecs.begin()->first << ", which is no representation\n";
+		return Usage();
+	}
+	if(!representationFrameRates.empty()) {
+		cerr << "--frameRate for " << representationFrameRates.begin()->first << ", which is no representation\n";
+		return Usage();
+	}
+
+	// the streams of each sizes file follow those of the one before
+	size_t first = 0;
+	for(size_t start = 0; start <= positional[0].size();) {
+		size_t comma = positional[0].find(',', start);
+		if(comma == string::npos)
+			comma = positional[0].size();
+		string sizes = positional[0].substr(start, comma - start);
+		size_t streams = 0;
+		if(!packager.ReadSizes(sizes, first, &streams)) {
+			cerr << "cannot read the segment sizes from " << sizes << "\n";
+			return 1;
+		}
+		first += streams;
+		start = comma + 1;
+	}
+	if(!packager.SplitLayers(layers))
+		return 1;
+	if(!availabilityStartTime.empty()) {
+		double longest = 0;
+		for(size_t i = 0; i < packager.Packaged(0).segments.size(); i++)
+			longest = max(longest, packager.Packaged(0).segments[i].frames / packager.FrameRate(0));
+		packager.SetLive(availabilityStartTime, minimumUpdatePeriod > 0 ? minimumUpdatePeriod : longest,
+		                 timeShiftBufferDepth, suggestedPresentationDelay);
+	}
+	if(singleFile) {
+		size_t slash = positional[1].find_last_of('/');
+		if(!packager.Concatenate(slash == string::npos ? "" : positional[1].substr(0, slash)))
+			return 1;
+	}
+	if(!packager.Write(positional[1])) {
+		cerr << "cannot write " << positional[1] << ", are the segments of all representations the same?\n";
+		return 1;
+	}
+
+	cout << "minBufferTime " << packager.MinBufferTime() << " s\n";
+	cout << "id\tbandwidth\tpeak\tmean (bits/s)\n";
+	for(size_t i = 0; i < packager.RepresentationCount(); i++)
+		cout << packager.Packaged(i).id << "\t" << packager.Bandwidth(i) << "\t" << (uint64_t)packager.PeakBitrate(i) <<
+			"\t" << (uint64_t)packager.MeanBitrate(i) << "\n";
+
+	return 0;
+}
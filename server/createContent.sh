@@ -7,9 +7,54 @@
 # TMC2 DIRECTORY
 TMC2_DIR=".."
 
+# MPD packager, built with the client (packager/)
+MPD_PACKAGER="$TMC2_DIR/bin/MpdPackager"
+
 # Compressed Stream Path
 STREAM_PATH="/var/www/html/video"
 
+# 1: one file per representation (low/low.bin, ...) whose segments are
+# fetched as byte ranges, 0: one file per segment
+SINGLE_FILE=0
+
+# 2 or 3: instead of the low/mid/high simulcast, one SHVC stream of that
+# many layers (cfg/condition/shm-$CONDITION-${LAYERS}L.cfg) whose base
+# layer and enhancement layers are packaged as dependent representations,
+# shvc, shvc_l1 (and shvc_l2); the client fetches the enhancement layers of
+# a segment only when it has the bandwidth. Needs the SHM encoder, and the
+# SHM decoder on the client (--videoDecoder=app in decOpt.txt)
+LAYERS=1
+SHM_ENCODER="$TMC2_DIR/dependencies/SHM-12.4/bin/TAppEncoderStatic"
+
+# rates (low, mid, high) whose videos are coded with VVC by the VTM library
+# (cfg/condition/vtm-$CONDITION.cfg, cfg/common/vvc.cfg) instead of HEVC:
+# fewer bits at the same QP, for a slower encode and decode. The MPD tells
+# the codec of every representation (@codecs v3c1,vvi1 or v3c1,hev1); a
+# client built without the VTM library leaves the VVC ones out. Needs TMC2
+# built with USE_VTMLIB_VIDEO_CODEC
+VVC_RATES="high"
+
+# rates (low, mid, high) coded at half the level of detail on a smaller
+# canvas (cfg/rate/lod2.cfg): fewer points and smaller videos, for clients
+# short of decode time. They reuse the segmentation of the same encoder
+# call like every rate, only their packing and videos are computed again,
+# e.g. "low". Not with LAYERS
+LOD_RATES=""
+
+# target bitrates in kbit/s of rates (low, mid, high), e.g. "low=2000
+# high=15000": every segment of such a rate is encoded a second time when
+# it is more than 10% off, at the QPs estimated from the first pass at
+# its rate.cfg QPs, so that its segments all come close to the bandwidth
+# of the representation. Not with LAYERS
+TARGET_KBPS=""
+
+# frame rates below FPS at which every rate is encoded again, e.g. "15 10"
+# with FPS 30: representations low_15, mid_15, high_15, ... whose segments
+# last as long as the others with fewer frames (FPS / rate must be whole).
+# A client short of decode time plays such a one at the same geometry
+# quality rather than a coarser one at the full frame rate. Not with LAYERS
+LOWER_FPS=""
+
 
 ### check the parameter ##
 if [ $# -ne 6 ]; then
@@ -23,6 +68,11 @@ fi
 #SEG_TS=1
 FRAME_PER_SEG=5
 
+# coding condition (cfg/condition/ctc-$CONDITION.cfg): all-intra,
+# low-delay or random-access. Every segment is encoded on its own, so
+# with inter coding it is still a closed GOP starting with an IDR
+CONDITION="all-intra"
+
 DATA_PATH=$1
 CFG_PATH=$2
 START_FRAME=$3
@@ -36,9 +86,14 @@ echo $SEG_TS
 ### make dir for files will be created ###
 mkdir $STREAM_PATH/$CONTENTS_NAME
 
-mkdir $STREAM_PATH/$CONTENTS_NAME/high
-mkdir $STREAM_PATH/$CONTENTS_NAME/mid
-mkdir $STREAM_PATH/$CONTENTS_NAME/low
+if [ $LAYERS -gt 1 ]
+then
+	mkdir $STREAM_PATH/$CONTENTS_NAME/shvc
+else
+	mkdir $STREAM_PATH/$CONTENTS_NAME/high
+	mkdir $STREAM_PATH/$CONTENTS_NAME/mid
+	mkdir $STREAM_PATH/$CONTENTS_NAME/low
+fi
 
 touch "$CONTENTS_NAME.log"
 chmod 644 "$CONTENTS_NAME.log"
@@ -46,118 +101,234 @@ chmod 644 "$CONTENTS_NAME.log"
 #####################################
 ### Frame Sampling for adjust FPS ###
 
-mkdir $DATA_PATH/${FPS}fr
-
+# the sampled frames are read once from the PLY files into one frame
+# cache, which all the encodes map instead of parsing the PLY files again
 ORIGIN_N_FRAMES=$(ls $DATA_PATH/*.ply | wc -l)
 
-target_d="$DATA_PATH/${FPS}fr"
 # 30 : Max FPS
 sampling_term=$((30 / $FPS))
-
-idx=$START_FRAME
 echo smpling term: $sampling_term
-for((f_idx = $START_FRAME; f_idx < $((START_FRAME + ORIGIN_N_FRAMES)); f_idx += $sampling_term ))
-do
-	target_f="*$f_idx*.ply"
 
-	cp $DATA_PATH/$target_f $target_d
-	mv $target_d/$target_f $target_d/${idx}.ply 2> /dev/null
+# printf pattern of the PLY files from the one of the first frame, e.g.
+# longdress_vox10_1051.ply -> longdress_vox10_%04d.ply
+FIRST_PLY=$(ls $DATA_PATH/*$START_FRAME*.ply | head -1)
+PLY_PATTERN="${FIRST_PLY%$START_FRAME*}%04d${FIRST_PLY##*$START_FRAME}"
+
+# positions divided by VOXEL_DIMENSION (1: as captured)
+VOXEL_DIMENSION=1
+FRAME_CACHE="$DATA_PATH/${FPS}fr_v${VOXEL_DIMENSION}.cache"
+
+if [ -f "$FRAME_CACHE" ]
+then
+	echo "Sampling MSG: Already Sampled Frames exist in $FRAME_CACHE"
+else
+	$TMC2_DIR/bin/PccAppIngest \
+	--uncompressedDataPath="$PLY_PATTERN" \
+	--startFrameNumber="$START_FRAME" \
+	--frameCount="$ORIGIN_N_FRAMES" \
+	--frameStep="$sampling_term" \
+	--voxelDimension="$VOXEL_DIMENSION" \
+	--cachePath="$FRAME_CACHE"
 	if [ $? -ne 0 ]
 	then
-		echo "Sampling MSG: Already Sampled Frame exists or Somthing wrong"
-		rm -rf ls $DATA_PATH/$target_d/!\([0-9][0-9][0-9][0-9].ply\)
-		break
+		echo "Sampling Fail"
+		exit 1
 	fi
-	
-	idx=$(($idx + 1))
-done
+fi
 
 #####################################
 ### Encode ###
 
-NUM_OF_FRAMES=$(ls $target_d | wc -l)
+NUM_OF_FRAMES=$(( (ORIGIN_N_FRAMES + sampling_term - 1) / sampling_term ))
 NUM_OF_SEG=$((NUM_OF_FRAMES / FRAME_PER_SEG))
 
 
 echo $NUM_OF_SEG
 FRAME_COUNT=$((NUM_OF_FRAMES / NUM_OF_SEG))
 
-LOW_OUT=""
-MID_OUT=""
-HIGH_OUT=""
-
 HIGH_BANDWIDTH=0
 MID_BANDWIDTH=0
 LOW_BANDWIDTH=0
 
-for((id = 0; id < $NUM_OF_SEG; id++))
+# segments encoded at the same time, each by its own encoder process; the
+# cores are shared between them. Another machine running this same command
+# on the same STREAM_PATH (e.g. over NFS) takes the segments not claimed yet
+JOBS=1
+SIZES="$STREAM_PATH/$CONTENTS_NAME/sizes.csv"
+
+# one encoder call for all the segments and all three rates: the normals, the
+# patch segmentation and the packing of a segment are computed once and only
+# the video encoding runs again for each rate. The video components are
+# encoded in-process by the HM library, without YUV or bitstream temporaries
+# one entry per rate; a VVC rate joins the vtm condition and the VVC codec
+# ids to its rate configuration (+: applied in that order)
+RATE_CONFIGS=""
+CODECS="--codecs=v3c1,hev1"
+for RATE in low mid high
 do
-$TMC2_DIR/bin/PccAppEncoder \
---configurationFolder=$TMC2_DIR/cfg/ \
---config=$TMC2_DIR/cfg/common/ctc-common.cfg \
---config=$TMC2_DIR/cfg/condition/ctc-all-intra.cfg \
---config=$CFG_PATH \
---config=$TMC2_DIR/cfg/rate/low.cfg \
---frameCount="$FRAME_COUNT" \
---startFrameNumber="$START_FRAME" \
---resolution="$RESOLUTION" \
---uncompressedDataPath=$target_d/%04d.ply \
---compressedStreamPath=$STREAM_PATH/$CONTENTS_NAME/low/low_s$id.bin
+	RATE_CONFIG="$TMC2_DIR/cfg/rate/$RATE.cfg"
+	if [[ " $VVC_RATES " == *" $RATE "* ]]
+	then
+		RATE_CONFIG="$TMC2_DIR/cfg/condition/vtm-$CONDITION.cfg+$TMC2_DIR/cfg/common/vvc.cfg+$RATE_CONFIG"
+		CODECS="$CODECS --codecs=$RATE=v3c1,vvi1"
+	fi
+	if [[ " $LOD_RATES " == *" $RATE "* ]]
+	then
+		RATE_CONFIG="$RATE_CONFIG+$TMC2_DIR/cfg/rate/lod2.cfg"
+	fi
+	KBPS=$(echo " $TARGET_KBPS " | sed -n "s/.* $RATE=\([0-9]*\) .*/\1/p")
+	if [ -n "$KBPS" ]
+	then
+		TARGET_CONFIG="$STREAM_PATH/$CONTENTS_NAME/target_$RATE.cfg"
+		echo "targetFrameBytes: $((KBPS * 125 / FPS))" > "$TARGET_CONFIG"
+		RATE_CONFIG="$RATE_CONFIG+$TARGET_CONFIG"
+	fi
+	RATE_CONFIGS="$RATE_CONFIGS${RATE_CONFIGS:+,}$RATE_CONFIG"
+done
 
+if [ $LAYERS -gt 1 ]
+then
+# geometry and attribute in SHVC layers at half the size each, the
+# occupancy map in plain HEVC, which stays all in the base layer
 $TMC2_DIR/bin/PccAppEncoder \
 --configurationFolder=$TMC2_DIR/cfg/ \
 --config=$TMC2_DIR/cfg/common/ctc-common.cfg \
---config=$TMC2_DIR/cfg/condition/ctc-all-intra.cfg \
+--config=$TMC2_DIR/cfg/condition/shm-$CONDITION-${LAYERS}L.cfg \
 --config=$CFG_PATH \
---config=$TMC2_DIR/cfg/rate/mid.cfg \
---frameCount="$FRAME_COUNT" \
+--config=$TMC2_DIR/cfg/rate/high.cfg \
+--videoEncoderOccupancyCodecId=HMLIB \
+--videoEncoderGeometryCodecId=SHMAPP \
+--videoEncoderAttributeCodecId=SHMAPP \
+--videoEncoderGeometryPath=$SHM_ENCODER \
+--videoEncoderAttributePath=$SHM_ENCODER \
+--shvcRateX=2 --shvcRateY=2 \
+--frameCount="$((NUM_OF_SEG * FRAME_COUNT))" \
 --startFrameNumber="$START_FRAME" \
 --resolution="$RESOLUTION" \
---uncompressedDataPath=$target_d/%04d.ply \
---compressedStreamPath=$STREAM_PATH/$CONTENTS_NAME/mid/mid_s$id.bin
-
+--uncompressedDataPath="$FRAME_CACHE" \
+--compressedStreamPath=$STREAM_PATH/$CONTENTS_NAME/shvc/shvc_s%d.bin \
+--segmentFrameCount="$FRAME_COUNT" \
+--segmentJobs="$JOBS" \
+--writeComplexity=1 \
+--segmentSizesPath="$SIZES"
+else
 $TMC2_DIR/bin/PccAppEncoder \
 --configurationFolder=$TMC2_DIR/cfg/ \
 --config=$TMC2_DIR/cfg/common/ctc-common.cfg \
---config=$TMC2_DIR/cfg/condition/ctc-all-intra.cfg \
+--config=$TMC2_DIR/cfg/condition/ctc-$CONDITION.cfg \
 --config=$CFG_PATH \
---config=$TMC2_DIR/cfg/rate/high.cfg \
---frameCount="$FRAME_COUNT" \
+--videoEncoderOccupancyCodecId=HMLIB \
+--videoEncoderGeometryCodecId=HMLIB \
+--videoEncoderAttributeCodecId=HMLIB \
+--frameCount="$((NUM_OF_SEG * FRAME_COUNT))" \
 --startFrameNumber="$START_FRAME" \
 --resolution="$RESOLUTION" \
---uncompressedDataPath=$target_d/%04d.ply \
---compressedStreamPath=$STREAM_PATH/$CONTENTS_NAME/high/high_s$id.bin
-
-
-### calc minimum bandwidth ###
-LOW_OUT=$STREAM_PATH/$CONTENTS_NAME/low/low_s$id.bin
-MID_OUT=$STREAM_PATH/$CONTENTS_NAME/mid/mid_s$id.bin
-HIGH_OUT=$STREAM_PATH/$CONTENTS_NAME/high/high_s$id.bin
-
-du -sk $HIGH_OUT | cut -f1
+--uncompressedDataPath="$FRAME_CACHE" \
+--rateConfigs="$RATE_CONFIGS" \
+--rateCompressedStreamPaths=$STREAM_PATH/$CONTENTS_NAME/low/low_s%d.bin,$STREAM_PATH/$CONTENTS_NAME/mid/mid_s%d.bin,$STREAM_PATH/$CONTENTS_NAME/high/high_s%d.bin \
+--segmentFrameCount="$FRAME_COUNT" \
+--segmentJobs="$JOBS" \
+--writeComplexity=1 \
+--segmentSizesPath="$SIZES"
+fi
 if [ $? -ne 0 ]
 then
 	echo "Encoding Fail"
 	exit 1
 fi
 
-HIGH_TEMP=$(du -sk $HIGH_OUT | cut -f1)
+# the lower frame rates: frames sampled further apart into a cache of
+# their own, the same segments in time with fewer frames each
+LOWER_SIZES=""
+LOWER_MEDIA=""
+LOWER_OPTIONS=""
+for LFPS in $LOWER_FPS
+do
+	if [ $LAYERS -gt 1 ] || [ $((FRAME_COUNT * LFPS % FPS)) -ne 0 ] || [ $((30 % LFPS)) -ne 0 ]
+	then
+		echo "Frame rate $LFPS does not divide the segments of $FRAME_COUNT frames at $FPS fps"
+		exit 1
+	fi
+	LOWER_TERM=$((30 / LFPS))
+	LOWER_FRAME_COUNT=$((FRAME_COUNT * LFPS / FPS))
+	LOWER_CACHE="$DATA_PATH/${LFPS}fr_v${VOXEL_DIMENSION}.cache"
+	LOWER_SIZE="$STREAM_PATH/$CONTENTS_NAME/sizes_$LFPS.csv"
 
-du -sk $MID_OUT | cut -f1
-if [ $? -ne 0 ]
-then
-	echo "Encoding Fail"
-	exit 1
-fi
-MID_TEMP=$(du -sk $MID_OUT | cut -f1)
+	if [ ! -f "$LOWER_CACHE" ]
+	then
+		$TMC2_DIR/bin/PccAppIngest \
+		--uncompressedDataPath="$PLY_PATTERN" \
+		--startFrameNumber="$START_FRAME" \
+		--frameCount="$ORIGIN_N_FRAMES" \
+		--frameStep="$LOWER_TERM" \
+		--voxelDimension="$VOXEL_DIMENSION" \
+		--cachePath="$LOWER_CACHE"
+		if [ $? -ne 0 ]
+		then
+			echo "Sampling Fail"
+			exit 1
+		fi
+	fi
 
-du -sk $LOW_OUT | cut -f1
-if [ $? -ne 0 ]
+	LOWER_PATHS=""
+	for RATE in low mid high
+	do
+		mkdir $STREAM_PATH/$CONTENTS_NAME/${RATE}_$LFPS
+		LOWER_PATHS="$LOWER_PATHS${LOWER_PATHS:+,}$STREAM_PATH/$CONTENTS_NAME/${RATE}_$LFPS/${RATE}_${LFPS}_s%d.bin"
+		if [ $SINGLE_FILE -eq 1 ]
+		then
+			LOWER_MEDIA="$LOWER_MEDIA ${RATE}_$LFPS=${RATE}_$LFPS/${RATE}_$LFPS.bin"
+		else
+			LOWER_MEDIA="$LOWER_MEDIA ${RATE}_$LFPS=${RATE}_$LFPS/${RATE}_${LFPS}_s\$Number\$.bin"
+		fi
+		LOWER_OPTIONS="$LOWER_OPTIONS --frameRate=${RATE}_$LFPS=$LFPS"
+		if [[ " $VVC_RATES " == *" $RATE "* ]]
+		then
+			LOWER_OPTIONS="$LOWER_OPTIONS --codecs=${RATE}_$LFPS=v3c1,vvi1"
+		fi
+	done
+
+	$TMC2_DIR/bin/PccAppEncoder \
+	--configurationFolder=$TMC2_DIR/cfg/ \
+	--config=$TMC2_DIR/cfg/common/ctc-common.cfg \
+	--config=$TMC2_DIR/cfg/condition/ctc-$CONDITION.cfg \
+	--config=$CFG_PATH \
+	--videoEncoderOccupancyCodecId=HMLIB \
+	--videoEncoderGeometryCodecId=HMLIB \
+	--videoEncoderAttributeCodecId=HMLIB \
+	--frameCount="$((NUM_OF_SEG * LOWER_FRAME_COUNT))" \
+	--startFrameNumber="$START_FRAME" \
+	--resolution="$RESOLUTION" \
+	--uncompressedDataPath="$LOWER_CACHE" \
+	--rateConfigs="$RATE_CONFIGS" \
+	--rateCompressedStreamPaths="$LOWER_PATHS" \
+	--segmentFrameCount="$LOWER_FRAME_COUNT" \
+	--segmentJobs="$JOBS" \
+	--writeComplexity=1 \
+	--segmentSizesPath="$LOWER_SIZE"
+	if [ $? -ne 0 ]
+	then
+		echo "Encoding Fail"
+		exit 1
+	fi
+	LOWER_SIZES="$LOWER_SIZES,$LOWER_SIZE"
+done
+
+### calc minimum bandwidth ###
+# sizes.csv: segment,startFrameNumber,frameCount,stream,path,bytes with the
+# streams in the order of rateConfigs (0 low, 1 mid, 2 high)
+for((id = 0; id < $NUM_OF_SEG && LAYERS == 1; id++))
+do
+
+read LOW_TEMP MID_TEMP HIGH_TEMP <<< $(awk -F, -v id=$id '
+	NR > 1 && $1 == id { kb[$4] = $6 < 0 ? -1 : int(($6 + 1023) / 1024) }
+	END { print kb[0], kb[1], kb[2] }' "$SIZES")
+
+if [ -z "$HIGH_TEMP" ] || [ $LOW_TEMP -lt 0 ] || [ $MID_TEMP -lt 0 ] || [ $HIGH_TEMP -lt 0 ]
 then
 	echo "Encoding Fail"
 	exit 1
 fi
-LOW_TEMP=$(du -sk $LOW_OUT | cut -f1)
 
 if [ $HIGH_TEMP -gt $HIGH_BANDWIDTH ]
 then
@@ -176,80 +347,59 @@ fi
 
 echo "==========$id-th Frame was created==========" >> "$CONTENTS_NAME.log"
 echo "Size(kb) | OUTPUT" >> "$CONTENTS_NAME.log"
-du -sk $LOW_OUT $MID_OUT $HIGH_OUT >> "$CONTENTS_NAME.log"
+awk -F, -v id=$id 'NR > 1 && $1 == id { printf "%d\t%s\n", ($6 + 1023) / 1024, $5 }' "$SIZES" >> "$CONTENTS_NAME.log"
 
 echo $LOW_BANDWIDTH $MID_BANDWIDTH $HIGH_BANDWIDTH >> $STREAM_PATH/$CONTENTS_NAME/bandwidth.txt
 
-START_FRAME=$((START_FRAME + FRAME_COUNT))
-
 done
 
 
 #### Generate MPD ####
-#dur_H=$(($(($NUM_OF_SEG * $SEG_TS))/3600))
-#dur_M=$(($(($(($NUM_OF_SEG * $SEG_TS)) - $dur_H * 3600))/60))
-#dur_S=$(($(($NUM_OF_SEG * $SEG_TS)) % 60))
-#minBufferTime=$SEG_TS
-
-#presentation_dur="PT${dur_H}H${dur_M}M${dur_S}.000S"
-baseURL="http://203.252.121.219/video/$CONTENTS_NAME/"
-
-HIGH_BANDWIDTH=$(($HIGH_BANDWIDTH*1000))
-MID_BANDWIDTH=$(($MID_BANDWIDTH*1000))
-LOW_BANDWIDTH=$(($LOW_BANDWIDTH*1000))
-
-echo "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" minBufferTime=\"PTS0H0M${SEG_TSi}\" type=\"static\" mediaPresentationDuration=\"PT0H0M${SEG_TS}S\" maxSegmentDuration=\"PT0H0M${SEG_TS}S\" profiles=\"urn:mpeg:dash:profile:full:2011\">" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "  <BaseURL>$baseURL</BaseURL>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "    <Period duration=\"$presentation_dur\">" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "      <AdaptationSet sgmentAlignment=\"true\" maxWidth=\"1024\" maxHeight=\"1024\" maxFrameRate=\"30\">" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-
-## HIGH ##
-echo "    	  <Representation id=\"0\" mimeType=\"video/mp4\" codecs=\"avc1.d44020\" width=\"1024\" height=\"1024\" framRate=\"$FPS\" sar=\"1:1\" startWithSAP=\"1\" bandwidth=\"$HIGH_BANDWIDTH\">" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			<SegmentBase>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-
-echo "			  <Initialization sourceURL=\"high/${CONTENTS_NAME}_high_init.mp4\"/>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			</SegmentBase>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			<SegmentList duration=\"$SEG_TS\">" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-
-for (( id = 0; id < $NUM_OF_SEG; id++ ))
-do
-	echo "			  <SegmentURL media=\"high/high_s$id.bin\"/>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-done
-
-echo "			</SegmentList>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "		  </Representation>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-
-## MID ##
-echo "    	  <Representation id=\"1\" mimeType=\"video/mp4\" codecs=\"avc1.d44020\" width=\"1024\" height=\"1024\" framRate=\"$FPS\" sar=\"1:1\" startWithSAP=\"1\" bandwidth=\"$MID_BANDWIDTH\">" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			<SegmentBase>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			  <Initialization sourceURL=\"mid/${CONTENTS_NAME}_mid_init.mp4\"/>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			</SegmentBase>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			<SegmentList duration=\"$SEG_TS\">" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-
-for (( id = 0; id < $NUM_OF_SEG; id++ ))
-do
-	echo "			  <SegmentURL media=\"mid/mid_s$id.bin\"/>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-done
-
-echo "			</SegmentList>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "		  </Representation>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-
-## LOW ##
-echo "    	  <Representation id=\"2\" mimeType=\"video/mp4\" codecs=\"avc1.d44020\" width=\"1024\" height=\"1024\" framRate=\"$FPS\" sar=\"1:1\" startWithSAP=\"1\" bandwidth=\"$LOW_BANDWIDTH\">" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			<SegmentBase>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			  <Initialization sourceURL=\"low/${CONTENTS_NAME}_low_init.mp4\"/>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			</SegmentBase>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "			<SegmentList duration=\"$SEG_TS\">" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-
-for (( id = 0; id < $NUM_OF_SEG; id++ ))
-do
-	echo "			  <SegmentURL media=\"low/low_s$id.bin\"/>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-done
+# bandwidth in bits/s from the real size and duration of every segment,
+# the segments are addressed with a SegmentTemplate or as byte ranges of
+# one file per representation
+# every segment starts with an IDR (SAP type 1); all-intra has a SAP on
+# every frame, inter coding only at the segment starts
+if [ "$CONDITION" = "all-intra" ]
+then
+	# a frame of the lowest frame rate
+	SAP_PERIOD=$(echo "$FPS $LOWER_FPS" | awk '{ m = $1; for (i = 2; i <= NF; i++) if ($i < m) m = $i; printf "%.6f", 1 / m }')
+else
+	SAP_PERIOD=$(echo "$FRAME_COUNT $FPS" | awk '{printf "%.6f", $1 / $2}')
+fi
 
-echo "			</SegmentList>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "		  </Representation>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
+if [ $SINGLE_FILE -eq 1 ]
+then
+	PACKAGING="--singleFile"
+	MEDIA="low=low/low.bin mid=mid/mid.bin high=high/high.bin"
+else
+	PACKAGING=""
+	MEDIA='low=low/low_s$Number$.bin mid=mid/mid_s$Number$.bin high=high/high_s$Number$.bin'
+fi
+# the layers of shvc/shvc_s$Number$.bin go to shvc/shvc_s$Number$_l<k>.bin
+if [ $LAYERS -gt 1 ]
+then
+	PACKAGING="$PACKAGING --layers=$LAYERS"
+	CODECS="--codecs=v3c1,hev1,svc1"
+	if [ $SINGLE_FILE -eq 1 ]
+	then
+		MEDIA="shvc=shvc/shvc.bin"
+	else
+		MEDIA='shvc=shvc/shvc_s$Number$.bin'
+	fi
+fi
 
-echo "		</AdaptationSet>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "    </Period>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
-echo "</MPD>" >> $STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd
+$MPD_PACKAGER $PACKAGING $CODECS $LOWER_OPTIONS \
+--frameRate="$FPS" \
+--startWithSAP=1 --maximumSAPPeriod="$SAP_PERIOD" \
+--baseURL="http://203.252.121.219/video/$CONTENTS_NAME/" \
+--title="$CONTENTS_NAME" \
+--width=1024 --height=1024 \
+"$SIZES$LOWER_SIZES" "$STREAM_PATH/$CONTENTS_NAME/$CONTENTS_NAME.mpd" \
+$MEDIA $LOWER_MEDIA \
+| tee -a "$CONTENTS_NAME.log"
+if [ ${PIPESTATUS[0]} -ne 0 ]
+then
+	echo "MPD Fail"
+	exit 1
+fi
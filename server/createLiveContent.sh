@@ -0,0 +1,122 @@
+#! /bin/bash
+# Filename : createLiveContent.sh
+#
+# Live counterpart of createContent.sh: the frames come from a capture
+# while they are encoded, and the content is a dynamic MPD that grows by
+# one segment as soon as the segment is encoded.
+#
+# The capture writes every frame as a PLY file into CAPTURE_PATH, named
+# after the printf pattern PLY_PATTERN with the frame number counted from
+# START_FRAME, e.g. frame_%04d.ply. Each file must be moved into place
+# once complete (written under another name, then renamed): the encoder
+# takes a frame as soon as its name is there. The stream ends when no new
+# frame comes for LIVE_TIMEOUT seconds.
+
+
+# TMC2 DIRECTORY
+TMC2_DIR=".."
+
+# MPD packager, built with the client (packager/)
+MPD_PACKAGER="$TMC2_DIR/bin/MpdPackager"
+
+# Compressed Stream Path
+STREAM_PATH="/var/www/html/video"
+
+# segments encoded at the same time, each by its own encoder process; while
+# one segment is encoded the next ones already wait for their frames
+JOBS=3
+
+# seconds without a new frame that end the stream
+LIVE_TIMEOUT=10
+
+# seconds of segments listed in the MPD
+TIME_SHIFT_BUFFER_DEPTH=30
+
+FRAME_PER_SEG=5
+
+# low-delay: every segment is still a closed GOP starting with an IDR
+CONDITION="low-delay"
+
+
+### check the parameter ##
+if [ $# -ne 7 ]; then
+	echo "script need 7 parameter"
+	echo "Usage: ./createLiveContent.sh [CAPTURE_PATH] [PLY_PATTERN] [CFG_PATH] [START_FRAME] [FPS] [resolution] [CONENTS_NAME]"
+
+	exit 1
+fi
+
+CAPTURE_PATH=$1
+PLY_PATTERN=$2
+CFG_PATH=$3
+START_FRAME=$4
+FPS=$5
+RESOLUTION=$6
+CONTENTS_NAME=$7
+
+CONTENT_PATH="$STREAM_PATH/$CONTENTS_NAME"
+SIZES="$CONTENT_PATH/sizes.csv"
+MPD="$CONTENT_PATH/$CONTENTS_NAME.mpd"
+
+### make dir for files will be created ###
+mkdir -p $CONTENT_PATH/high $CONTENT_PATH/mid $CONTENT_PATH/low
+
+touch "$CONTENTS_NAME.log"
+chmod 644 "$CONTENTS_NAME.log"
+
+#####################################
+### Publish ###
+
+# the stream starts now; a segment is listed once it is encoded, so the
+# clients never ask for one before it is on the origin
+AVAILABILITY_START_TIME=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+SEG_TS=$(echo "$FRAME_PER_SEG $FPS" | awk '{printf "%.6f", $1 / $2}')
+
+# run by the encoder after every segment, in segment order, once its rows
+# are in $SIZES; the media are quoted for the shell that runs it
+PUBLISH="$MPD_PACKAGER --codecs=v3c1,hev1 \
+--frameRate=$FPS \
+--startWithSAP=1 --maximumSAPPeriod=$SEG_TS \
+--baseURL=http://203.252.121.219/video/$CONTENTS_NAME/ \
+--title=$CONTENTS_NAME \
+--width=1024 --height=1024 \
+--availabilityStartTime=$AVAILABILITY_START_TIME \
+--minimumUpdatePeriod=$SEG_TS \
+--timeShiftBufferDepth=$TIME_SHIFT_BUFFER_DEPTH \
+--suggestedPresentationDelay=$SEG_TS \
+'$SIZES' '$MPD' \
+'low=low/low_s\$Number\$.bin' 'mid=mid/mid_s\$Number\$.bin' 'high=high/high_s\$Number\$.bin' \
+>> '$CONTENTS_NAME.log'"
+
+#####################################
+### Encode ###
+
+RATE_CONFIGS="$TMC2_DIR/cfg/rate/low.cfg,$TMC2_DIR/cfg/rate/mid.cfg,$TMC2_DIR/cfg/rate/high.cfg"
+
+$TMC2_DIR/bin/PccAppEncoder \
+--configurationFolder=$TMC2_DIR/cfg/ \
+--config=$TMC2_DIR/cfg/common/ctc-common.cfg \
+--config=$TMC2_DIR/cfg/condition/ctc-$CONDITION.cfg \
+--config=$CFG_PATH \
+--videoEncoderOccupancyCodecId=HMLIB \
+--videoEncoderGeometryCodecId=HMLIB \
+--videoEncoderAttributeCodecId=HMLIB \
+--frameCount=0 \
+--startFrameNumber="$START_FRAME" \
+--resolution="$RESOLUTION" \
+--uncompressedDataPath="$CAPTURE_PATH/$PLY_PATTERN" \
+--rateConfigs="$RATE_CONFIGS" \
+--rateCompressedStreamPaths=$CONTENT_PATH/low/low_s%d.bin,$CONTENT_PATH/mid/mid_s%d.bin,$CONTENT_PATH/high/high_s%d.bin \
+--segmentFrameCount="$FRAME_PER_SEG" \
+--segmentJobs="$JOBS" \
+--writeComplexity=1 \
+--segmentSizesPath="$SIZES" \
+--segmentLive=1 \
+--segmentLiveTimeout="$LIVE_TIMEOUT" \
+--segmentLivePublishCommand="$PUBLISH" \
+| tee -a "$CONTENTS_NAME.log"
+if [ ${PIPESTATUS[0]} -ne 0 ]
+then
+	echo "Encoding Fail"
+	exit 1
+fi
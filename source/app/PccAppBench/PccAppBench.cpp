@@ -0,0 +1,594 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "PCCCommon.h"
+#include "PCCMath.h"
+#include "PCCKdTree.h"
+#include "PCCCodec.h"
+#include "PCCVideo.h"
+#include "PCCContext.h"
+#include "PCCFrameContext.h"
+#include "PCCDecoder.h"
+#include "PCCBitstream.h"
+#include "PCCGroupOfFrames.h"
+#include "PCCBitstreamReader.h"
+#include "PCCNormalsGenerator.h"
+#include "PCCExecutionContext.h"
+#include "PCCDecoderParameters.h"
+#include "PCCInternalColorConverter.h"
+#include <program_options_lite.h>
+#include <tbb/tbb.h>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <new>
+#include <random>
+
+using namespace std;
+using namespace pcc;
+
+//---------------------------------------------------------------------------
+// :: Allocation counting
+//
+// Every allocation of the process goes through these operators, so that each
+// benchmark can report the allocations its kernel makes per repetition.
+
+static std::atomic<uint64_t> g_allocationCount( 0 );
+static std::atomic<uint64_t> g_allocationBytes( 0 );
+
+static void* countedAllocation( size_t size ) {
+  g_allocationCount.fetch_add( 1, std::memory_order_relaxed );
+  g_allocationBytes.fetch_add( size, std::memory_order_relaxed );
+  void* ptr = std::malloc( size != 0 ? size : 1 );
+  if ( ptr == nullptr ) { throw std::bad_alloc(); }
+  return ptr;
+}
+
+void* operator new( size_t size ) { return countedAllocation( size ); }
+void* operator new[]( size_t size ) { return countedAllocation( size ); }
+void  operator delete( void* ptr ) noexcept { std::free( ptr ); }
+void  operator delete[]( void* ptr ) noexcept { std::free( ptr ); }
+void  operator delete( void* ptr, size_t ) noexcept { std::free( ptr ); }
+void  operator delete[]( void* ptr, size_t ) noexcept { std::free( ptr ); }
+
+//---------------------------------------------------------------------------
+// :: Benchmark harness
+
+struct BenchParameters {
+  std::string uncompressedDataPath_;
+  std::string compressedStreamPath_;
+  std::string tmpPlyPath_          = "PccAppBench_tmp.ply";
+  size_t      startFrameNumber_    = 0;
+  size_t      nbThread_            = 0;
+  size_t      repetitions_         = 5;
+  size_t      syntheticPointCount_ = 1000000;
+  size_t      imageWidth_          = 1280;
+  size_t      imageHeight_         = 1280;
+  size_t      numNeighbors_        = 16;
+};
+
+// Runs each kernel once to warm the caches and the allocator, then repetitions times, and reports the median and
+// the best time, the throughput of the median time and the allocations of one repetition.
+class PCCBenchmark {
+ public:
+  PCCBenchmark( size_t repetitions ) : repetitions_( ( std::max )( repetitions, (size_t)1 ) ) {
+    printf( "%-40s %8s %10s %10s %14s %12s %10s \n", "kernel", "items", "median ms", "best ms", "throughput",
+            "allocs/rep", "MB/rep" );
+  }
+
+  // setup runs before every repetition, untimed, to restore the inputs the kernel modifies.
+  void run( const std::string&           name,
+            size_t                       items,
+            const char*                  unit,
+            const std::function<void()>& setup,
+            const std::function<void()>& kernel ) {
+    std::vector<double> seconds;
+    uint64_t            allocations = 0;
+    uint64_t            bytes       = 0;
+    for ( size_t i = 0; i <= repetitions_; i++ ) {
+      if ( setup ) { setup(); }
+      const uint64_t count = g_allocationCount.load();
+      const uint64_t size  = g_allocationBytes.load();
+      const auto     start = std::chrono::steady_clock::now();
+      kernel();
+      const auto end = std::chrono::steady_clock::now();
+      if ( i == 0 ) { continue; }
+      seconds.push_back( std::chrono::duration<double>( end - start ).count() );
+      allocations += g_allocationCount.load() - count;
+      bytes += g_allocationBytes.load() - size;
+    }
+    report( name, items, unit, seconds, allocations / repetitions_, bytes / repetitions_ );
+  }
+
+  // Reports a kernel timed by its caller, e.g. a decoder stage seen through the stage callback.
+  void report( const std::string&  name,
+               size_t              items,
+               const char*         unit,
+               std::vector<double> seconds,
+               uint64_t            allocations,
+               uint64_t            bytes ) {
+    if ( seconds.empty() ) { return; }
+    std::sort( seconds.begin(), seconds.end() );
+    const double median = seconds[seconds.size() / 2];
+    char         throughput[64];
+    snprintf( throughput, sizeof( throughput ), "%.2f M%s/s", median > 0 ? items / median * 1e-6 : 0., unit );
+    printf( "%-40s %8zu %10.3f %10.3f %14s %12" PRIu64 " %10.2f \n", name.c_str(), items, median * 1e3,
+            seconds[0] * 1e3, throughput, allocations, bytes / ( 1024. * 1024. ) );
+    fflush( stdout );
+  }
+
+ private:
+  size_t repetitions_;
+};
+
+//---------------------------------------------------------------------------
+// :: Inputs
+
+// Voxelized sphere of pointCount points in a 10-bit cube, cut into 64x64 patches along its dominant axis; the
+// points on the patch borders are marked as boundary points, as generatePointCloud() does.
+static void createSyntheticPointCloud( size_t pointCount, PCCPointSet3& pointCloud, std::vector<uint32_t>& partition ) {
+  std::mt19937                           generator( 1 );
+  std::normal_distribution<double>       normal( 0., 1. );
+  std::uniform_real_distribution<double> jitter( -2., 2. );
+  pointCloud.clear();
+  pointCloud.addColors();
+  pointCloud.addColors16bit();
+  pointCloud.resize( pointCount );
+  partition.resize( pointCount );
+  for ( size_t i = 0; i < pointCount; i++ ) {
+    PCCVector3D direction( normal( generator ), normal( generator ), normal( generator ) );
+    direction.normalize();
+    const double radius = 400. + jitter( generator );
+    PCCPoint3D   point;
+    for ( size_t k = 0; k < 3; k++ ) { point[k] = std::round( 512. + radius * direction[k] ); }
+    pointCloud[i] = point;
+    size_t axis   = 0;
+    for ( size_t k = 1; k < 3; k++ ) {
+      if ( std::abs( direction[k] ) > std::abs( direction[axis] ) ) { axis = k; }
+    }
+    const size_t u    = static_cast<size_t>( point[( axis + 1 ) % 3] );
+    const size_t v    = static_cast<size_t>( point[( axis + 2 ) % 3] );
+    partition[i]      = static_cast<uint32_t>( axis * 256 + ( u / 64 ) * 16 + ( v / 64 ) );
+    const bool border = u % 64 < 2 || u % 64 > 61 || v % 64 < 2 || v % 64 > 61;
+    pointCloud.setBoundaryPointType( i, border ? 1 : 0 );
+    pointCloud.setPointPatchIndex( i, 0, partition[i] );
+    const PCCColor3B color( static_cast<uint8_t>( u / 4 ), static_cast<uint8_t>( v / 4 ),
+                            static_cast<uint8_t>( ( u + v ) / 8 ) );
+    pointCloud.setColor( i, color );
+    pointCloud.setColor16bit( i, PCCColor16bit( color[0] * 257, color[1] * 257, color[2] * 257 ) );
+  }
+}
+
+template <typename T>
+static void createSyntheticImage( size_t          width,
+                                  size_t          height,
+                                  PCCCOLORFORMAT  format,
+                                  size_t          maxValue,
+                                  PCCVideo<T, 3>& video ) {
+  std::mt19937 generator( 2 );
+  video.resize( 1 );
+  auto& image = video.getFrame( 0 );
+  image.resize( width, height, format );
+  for ( size_t c = 0; c < 3; c++ ) {
+    for ( size_t v = 0; v < image.getPlaneHeight( c ); v++ ) {
+      T* row = image.getRow( c, v );
+      for ( size_t u = 0; u < image.getPlaneWidth( c ); u++ ) {
+        row[u] = static_cast<T>( ( ( u + v ) * ( c + 1 ) + ( generator() & 15 ) ) % ( maxValue + 1 ) );
+      }
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+// :: Kernels
+
+static void benchKdTree( PCCBenchmark& bench, const std::string& tag, const PCCPointSet3& pointCloud, size_t k ) {
+  const size_t pointCount = pointCloud.getPointCount();
+  bench.run( tag + " PCCKdTree::init", pointCount, "pts", nullptr, [&] { PCCKdTree kdtree( pointCloud ); } );
+  PCCKdTree kdtree( pointCloud );
+  bench.run( tag + " PCCKdTree::search", pointCount, "pts", nullptr, [&] {
+    PCCNNResult result;
+    for ( size_t i = 0; i < pointCount; i++ ) { kdtree.search( pointCloud[i], k, result ); }
+  } );
+}
+
+static void benchPly( PCCBenchmark& bench, const std::string& tag, PCCPointSet3& pointCloud, const std::string& path ) {
+  const size_t pointCount = pointCloud.getPointCount();
+  bench.run( tag + " PCCPointSet3::write", pointCount, "pts", nullptr, [&] { pointCloud.write( path, false ); } );
+  PCCPointSet3 readCloud;
+  bench.run( tag + " PCCPointSet3::read", pointCount, "pts", nullptr, [&] { readCloud.read( path ); } );
+  std::remove( path.c_str() );
+}
+
+static void benchNormals( PCCBenchmark&                         bench,
+                          const std::string&                    tag,
+                          const PCCPointSet3&                   pointCloud,
+                          const PCCNormalsGenerator3Parameters& normalParams,
+                          PCCExecutionContext&                  executionContext ) {
+  PCCKdTree kdtree( pointCloud );
+  bench.run( tag + " PCCNormalsGenerator3::compute", pointCloud.getPointCount(), "pts", nullptr, [&] {
+    PCCNormalsGenerator3 normalsGen;
+    normalsGen.compute( pointCloud, kdtree, normalParams, executionContext );
+  } );
+}
+
+// The colors of the points are transferred to a reconstruction of them with half of the points one voxel off, with
+// the default color transfer parameters of the encoder.
+static void benchColorTransfer( PCCBenchmark& bench, const std::string& tag, const PCCPointSet3& pointCloud ) {
+  const size_t pointCount = pointCloud.getPointCount();
+  PCCPointSet3 reconstruct;
+  reconstruct.resize( pointCount );
+  for ( size_t i = 0; i < pointCount; i++ ) {
+    reconstruct[i] = pointCloud[i];
+    if ( i % 2 == 1 ) { reconstruct[i][2] += 1; }
+  }
+  bench.run( tag + " PCCPointSet3::transferColors", pointCount, "pts", nullptr, [&] {
+    pointCloud.transferColors( reconstruct, 0, false, 1, 1, true, true, false, false, 0.0001, 0.0001, 10000.0,
+                               10000.0, 10000.0, 10000.0, false, 10.0 );
+  } );
+  bench.run( tag + " PCCPointSet3::transferColors16bit", pointCount, "pts", nullptr, [&] {
+    pointCloud.transferColors16bit( reconstruct, 0, false, 1, 1, true, true, false, false, 0.0001, 0.0001, 10000.0,
+                                    10000.0, 10000.0, 10000.0, false, 10.0 );
+  } );
+}
+
+static void benchColorConverter( PCCBenchmark& bench, size_t width, size_t height ) {
+  PCCInternalColorConverter<uint16_t> converter;
+  PCCVideo<uint16_t, 3>               yuv420;
+  PCCVideo<uint16_t, 3>               rgb444;
+  PCCVideo<uint16_t, 3>               video;
+  createSyntheticImage( width, height, PCCCOLORFORMAT::YUV420, 1023, yuv420 );
+  createSyntheticImage( width, height, PCCCOLORFORMAT::RGB444, 1023, rgb444 );
+  const size_t pixels = width * height;
+  for ( const std::string& config : {"YUV420ToYUV444_10_1", "YUV420ToRGB444_10_1"} ) {
+    bench.run( "PCCInternalColorConverter " + config, pixels, "px", nullptr,
+               [&] { converter.convert( config, yuv420, video ); } );
+  }
+  for ( const std::string& config : {"RGB444ToYUV420_10_1", "RGB444ToYUV444_10_1", "YUV444ToRGB444_10_1"} ) {
+    bench.run( "PCCInternalColorConverter " + config, pixels, "px", nullptr,
+               [&] { converter.convert( config, rgb444, video ); } );
+  }
+}
+
+// smoothPointCloudGrid() is private to PCCCodec: it is timed through smoothPointCloudPostprocess() with the grid
+// smoothing of the decoder, which is the only path that reaches it.
+static void benchSmoothing( PCCBenchmark&                bench,
+                            const PCCPointSet3&          source,
+                            const std::vector<uint32_t>& sourcePartition,
+                            size_t                       nbThread ) {
+  GeneratePointCloudParameters params = {};
+  params.occupancyResolution_         = 16;
+  params.occupancyPrecision_          = 4;
+  params.gridSmoothing_               = true;
+  params.gridSize_                    = 8;
+  params.thresholdSmoothing_          = 64;
+  params.nbThread_                    = nbThread;
+  params.flagGeometrySmoothing_       = true;
+  params.flagColorSmoothing_          = true;
+  params.thresholdColorSmoothing_     = 10;
+  params.cgridSize_                   = 4;
+  params.thresholdColorDifference_    = 10;
+  params.thresholdColorVariation_     = 6;
+  params.geometryBitDepth3D_          = 10;
+  PCCCodec              codec;
+  PCCPointSet3          pointCloud;
+  std::vector<uint32_t> partition;
+  const auto            restore = [&] {
+    pointCloud = source;
+    partition  = sourcePartition;
+  };
+  const size_t pointCount = source.getPointCount();
+  bench.run( "synthetic PCCCodec::smoothPointCloudGrid", pointCount, "pts", restore,
+             [&] { codec.smoothPointCloudPostprocess( pointCloud, COLOR_TRANSFORM_NONE, params, partition ); } );
+  GeneratePointCloudParameters fixedPointParams = params;
+  fixedPointParams.fixedPointSmoothing_         = true;
+  bench.run( "synthetic PCCCodec::smoothPointCloudGrid (fixed point)", pointCount, "pts", restore, [&] {
+    codec.smoothPointCloudPostprocess( pointCloud, COLOR_TRANSFORM_NONE, fixedPointParams, partition );
+  } );
+  bench.run( "synthetic PCCCodec::colorSmoothing", pointCount, "pts", restore,
+             [&] { codec.colorSmoothing( pointCloud, COLOR_TRANSFORM_NONE, params ); } );
+}
+
+// Decodes a compressed stream as PccAppDecoder does. PCCBitstreamReader::decode is timed directly, while
+// generatePointCloud() and the post-processing are timed through the "reconstruct" and "smoothing" stages of
+// the decoder, summed over the frames of the stream.
+static int benchBitstream( PCCBenchmark& bench, const std::string& compressedStreamPath, size_t nbThread ) {
+  PCCDecoderParameters decoderParams;
+  decoderParams.compressedStreamPath_ = compressedStreamPath;
+  decoderParams.nbThread_             = nbThread;
+  PCCBitstream bitstream;
+  if ( !bitstream.initialize( compressedStreamPath ) ) { return -1; }
+  const size_t bitstreamSize = bitstream.size();
+
+  struct StageTimes {
+    std::vector<double>                   seconds_;
+    uint64_t                              allocations_ = 0;
+    uint64_t                              bytes_       = 0;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t                              startAllocations_ = 0;
+    uint64_t                              startBytes_       = 0;
+  };
+  std::map<std::string, StageTimes> stages;
+  PCCDecoder                        decoder;
+  decoder.setParameters( decoderParams );
+  decoder.setStageCallback( [&]( const char* stage, int32_t frameIndex, bool begin ) {
+    if ( frameIndex < 0 ) { return; }
+    auto& times = stages[stage];
+    if ( begin ) {
+      times.startAllocations_ = g_allocationCount.load();
+      times.startBytes_       = g_allocationBytes.load();
+      times.start_            = std::chrono::steady_clock::now();
+    } else {
+      times.seconds_.push_back(
+          std::chrono::duration<double>( std::chrono::steady_clock::now() - times.start_ ).count() );
+      times.allocations_ += g_allocationCount.load() - times.startAllocations_;
+      times.bytes_ += g_allocationBytes.load() - times.startBytes_;
+    }
+  } );
+
+  SampleStreamV3CUnit ssvu;
+  pcc::PCCBitstreamReader::read( bitstream, ssvu );
+  std::vector<double> readerSeconds;
+  uint64_t            readerAllocations = 0;
+  uint64_t            readerBytes       = 0;
+  size_t              pointCount        = 0;
+  bool                bMoreData         = true;
+  PCCContext          context;
+  while ( bMoreData ) {
+    PCCGroupOfFrames reconstructs;
+    context.reset();
+    PCCBitstreamReader bitstreamReader;
+    const uint64_t     count = g_allocationCount.load();
+    const uint64_t     size  = g_allocationBytes.load();
+    const auto         start = std::chrono::steady_clock::now();
+    if ( bitstreamReader.decode( ssvu, context ) == 0 ) { break; }
+    readerSeconds.push_back( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+    readerAllocations += g_allocationCount.load() - count;
+    readerBytes += g_allocationBytes.load() - size;
+    if ( context.checkProfile() != 0 ) {
+      printf( "Profile not correct... \n" );
+      return -1;
+    }
+    decoderParams.setReconstructionParameters( context.getVps().getProfileTierLevel().getProfileReconstructionIdc() );
+    decoder.setReconstructionParameters( decoderParams );
+    context.resizeAtlas( context.getVps().getAtlasCountMinus1() + 1 );
+    for ( uint32_t atlId = 0; atlId < context.getVps().getAtlasCountMinus1() + 1; atlId++ ) {
+      context.getAtlas( atlId ).allocateVideoFrames( context, 0 );
+      context.setAtlasIndex( atlId );
+      if ( decoder.decode( context, reconstructs, atlId ) != 0 ) { return -1; }
+      for ( auto& frame : reconstructs.getFrames() ) { pointCount += frame.getPointCount(); }
+    }
+    bMoreData = ( ssvu.getV3CUnitCount() > 0 );
+  }
+  // one time per GOF (reader) or per frame (stages): each is credited with an even share of the stream items
+  const auto share = []( uint64_t value, size_t count ) { return count != 0 ? value / count : 0; };
+  bench.report( "stream PCCBitstreamReader::decode", bitstreamSize / ( std::max )( readerSeconds.size(), (size_t)1 ),
+                "B", readerSeconds, share( readerAllocations, readerSeconds.size() ),
+                share( readerBytes, readerSeconds.size() ) );
+  const std::pair<const char*, const char*> reported[] = {{"reconstruct", "stream PCCCodec::generatePointCloud"},
+                                                          {"smoothing", "stream PCCDecoder smoothing"}};
+  for ( const auto& entry : reported ) {
+    const auto&  times  = stages[entry.first];
+    const size_t frames = times.seconds_.size();
+    bench.report( entry.second, pointCount / ( std::max )( frames, (size_t)1 ), "pts", times.seconds_,
+                  share( times.allocations_, frames ), share( times.bytes_, frames ) );
+  }
+  return 0;
+}
+
+//---------------------------------------------------------------------------
+// :: Command line / config parsing
+
+bool parseParameters( int argc, char* argv[], BenchParameters& benchParams ) {
+  namespace po    = df::program_options_lite;
+  bool print_help = false;
+
+  // The definition of the program/config options, along with default values.
+  //
+  // NB: when updating the following tables:
+  //      (a) please keep to 80-columns for easier reading at a glance,
+  //      (b) do not vertically align values -- it breaks quickly
+  //
+  // clang-format off
+  po::Options opts;
+  std::string configurationFolder;
+  std::string uncompressedDataFolder;
+  size_t tmp = 0;
+  opts.addOptions()
+    ( "help", print_help, false,"This help text" )
+    ( "c,config", po::parseConfigFile, "Configuration file name" )
+    ( "configurationFolder",
+      configurationFolder,
+      configurationFolder, 
+      "Folder where the configuration files are stored,use for cfg relative paths." )
+    ( "uncompressedDataFolder",
+      uncompressedDataFolder,
+      uncompressedDataFolder,
+      "Folder where the uncompress input data are stored, use for cfg relative paths." )
+    ( "uncompressedDataPath",
+      benchParams.uncompressedDataPath_,
+      benchParams.uncompressedDataPath_,
+      "Input pointcloud of the real benchmarks. Multi-frame sequences may be represented by %04i" )
+    ( "compressedStreamPath",
+      benchParams.compressedStreamPath_,
+      benchParams.compressedStreamPath_,
+      "Compressed bitstream of the decoder benchmarks" )
+    ( "tmpPlyPath",
+      benchParams.tmpPlyPath_,
+      benchParams.tmpPlyPath_,
+      "Temporary file of the PLY write/read benchmarks" )
+    ( "startFrameNumber",
+      benchParams.startFrameNumber_,
+      benchParams.startFrameNumber_,
+      "Frame of the sequence read for the real benchmarks" )
+    //parameters not used, but in the configuration files, so we add them here
+    ( "frameCount",tmp,tmp,"UNUSED" )
+    ( "geometry3dCoordinatesBitdepth",tmp,tmp,"UNUSED" )
+    ( "geometryNominal2dBitdepth",tmp,tmp,"UNUSED" )
+    ( "groupOfFramesSize",tmp,tmp,"UNUSED" )
+    ( "iterationCountRefineSegmentation",tmp,tmp,"UNUSED" )
+    ( "minNormSumOfInvDist4MPSelection",tmp,tmp,"UNUSED" )
+    ( "partialAdditionalProjectionPlane",tmp,tmp,"UNUSED" )
+    ( "maxPatchSize",tmp,tmp,"UNUSED" )
+    ( "roiBoundingBoxMinX",tmp,tmp,"UNUSED" )
+    ( "roiBoundingBoxMaxX",tmp,tmp,"UNUSED" )
+    ( "roiBoundingBoxMinY",tmp,tmp,"UNUSED" )
+    ( "roiBoundingBoxMaxY",tmp,tmp,"UNUSED" )
+    ( "roiBoundingBoxMinZ",tmp,tmp,"UNUSED" )
+    ( "roiBoundingBoxMaxZ",tmp,tmp,"UNUSED" )
+    ( "numTilesHor",tmp,tmp,"UNUSED" )
+    ( "tileHeightToWidthRatio",tmp,tmp,"UNUSED" )
+    ( "numCutsAlong1stLongestAxis",tmp,tmp,"UNUSED" )
+    ( "numCutsAlong2ndLongestAxis",tmp,tmp,"UNUSED" )
+    ( "numCutsAlong3rdLongestAxis",tmp,tmp,"UNUSED" )
+    ( "voxelDimensionRefineSegmentation",tmp,tmp,"UNUSED" )
+    ( "minimumImageHeight",tmp,tmp,"UNUSED" )
+    ( "minimumImageWidth",tmp,tmp,"UNUSED" )
+    ( "flagColorPreSmoothing",tmp,tmp,"UNUSED" )
+    ( "surfaceSeparation",tmp,tmp,"UNUSED" )
+    ( "enhancedProjectionPlane",tmp,tmp,"UNUSED" )
+    ( "skipAvgIfIdenticalSourcePointPresentBwd",tmp,tmp,"UNUSED" )
+    // benchmark configuration
+    ( "nbThread",
+      benchParams.nbThread_,
+      benchParams.nbThread_,
+      "Number of thread used for parallel processing" )
+    ( "repetitions",
+      benchParams.repetitions_,
+      benchParams.repetitions_,
+      "Timed repetitions of each kernel, after one untimed warm-up run" )
+    ( "syntheticPointCount",
+      benchParams.syntheticPointCount_,
+      benchParams.syntheticPointCount_,
+      "Point count of the synthetic point cloud (0: no synthetic benchmarks)" )
+    ( "imageWidth",
+      benchParams.imageWidth_,
+      benchParams.imageWidth_,
+      "Width of the synthetic images of the color converter benchmarks" )
+    ( "imageHeight",
+      benchParams.imageHeight_,
+      benchParams.imageHeight_,
+      "Height of the synthetic images of the color converter benchmarks" )
+    ( "numNeighbors",
+      benchParams.numNeighbors_,
+      benchParams.numNeighbors_,
+      "Neighbor count of the PCCKdTree::search benchmark" )
+    ;
+  opts.addOptions();
+  // clang-format on
+  po::setDefaults( opts );
+  po::ErrorReporter        err;
+  const list<const char*>& argv_unhandled = po::scanArgv( opts, argc, (const char**)argv, err );
+  for ( const auto arg : argv_unhandled ) { printf( "Unhandled argument ignored: %s \n", arg ); }
+
+  if ( print_help ) {
+    po::doHelp( std::cout, opts, 78 );
+    return false;
+  }
+  if ( !benchParams.uncompressedDataPath_.empty() ) {
+    benchParams.uncompressedDataPath_ = uncompressedDataFolder + benchParams.uncompressedDataPath_;
+  }
+
+  printf( "parseParameters : \n" );
+  printf( "  uncompressedDataPath = %s \n", benchParams.uncompressedDataPath_.c_str() );
+  printf( "  compressedStreamPath = %s \n", benchParams.compressedStreamPath_.c_str() );
+  printf( "  startFrameNumber     = %zu \n", benchParams.startFrameNumber_ );
+  printf( "  nbThread             = %zu \n", benchParams.nbThread_ );
+  printf( "  repetitions          = %zu \n", benchParams.repetitions_ );
+  printf( "  syntheticPointCount  = %zu \n", benchParams.syntheticPointCount_ );
+  printf( "  image                = %zux%zu \n", benchParams.imageWidth_, benchParams.imageHeight_ );
+
+  // report the current configuration (only in the absence of errors so
+  // that errors/warnings are more obvious and in the same place).
+  return !err.is_errored;
+}
+
+int main( int argc, char* argv[] ) {
+  std::cout << "PccAppBench v" << TMC2_VERSION_MAJOR << "." << TMC2_VERSION_MINOR << std::endl << std::endl;
+  BenchParameters benchParams;
+  if ( !parseParameters( argc, argv, benchParams ) ) { return -1; }
+  tbb::task_scheduler_init init( benchParams.nbThread_ > 0 ? static_cast<int>( benchParams.nbThread_ )
+                                                           : tbb::task_scheduler_init::automatic );
+  PCCExecutionContext executionContext;
+  executionContext.initialize( benchParams.nbThread_ );
+  PCCNormalsGenerator3Parameters normalParams = {PCCVector3D( 0.0 ),
+                                                 ( std::numeric_limits<double>::max )(),
+                                                 ( std::numeric_limits<double>::max )(),
+                                                 ( std::numeric_limits<double>::max )(),
+                                                 ( std::numeric_limits<double>::max )(),
+                                                 16,
+                                                 16,
+                                                 16,
+                                                 0,
+                                                 PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE,
+                                                 false,
+                                                 false,
+                                                 false,
+                                                 0.005,
+                                                 3.0};  // default values of PccAppNormalGenerator
+  PCCBenchmark bench( benchParams.repetitions_ );
+  if ( benchParams.syntheticPointCount_ > 0 ) {
+    PCCPointSet3          pointCloud;
+    std::vector<uint32_t> partition;
+    createSyntheticPointCloud( benchParams.syntheticPointCount_, pointCloud, partition );
+    benchKdTree( bench, "synthetic", pointCloud, benchParams.numNeighbors_ );
+    benchPly( bench, "synthetic", pointCloud, benchParams.tmpPlyPath_ );
+    benchNormals( bench, "synthetic", pointCloud, normalParams, executionContext );
+    benchColorTransfer( bench, "synthetic", pointCloud );
+    benchSmoothing( bench, pointCloud, partition, benchParams.nbThread_ );
+  }
+  if ( benchParams.imageWidth_ > 0 && benchParams.imageHeight_ > 0 ) {
+    benchColorConverter( bench, benchParams.imageWidth_, benchParams.imageHeight_ );
+  }
+  if ( !benchParams.uncompressedDataPath_.empty() ) {
+    PCCGroupOfFrames sources;
+    if ( !sources.load( benchParams.uncompressedDataPath_, benchParams.startFrameNumber_,
+                        benchParams.startFrameNumber_ + 1, COLOR_TRANSFORM_NONE ) ) {
+      return -1;
+    }
+    PCCPointSet3& pointCloud = sources.getFrames()[0];
+    benchKdTree( bench, "sequence", pointCloud, benchParams.numNeighbors_ );
+    benchPly( bench, "sequence", pointCloud, benchParams.tmpPlyPath_ );
+    benchNormals( bench, "sequence", pointCloud, normalParams, executionContext );
+    benchColorTransfer( bench, "sequence", pointCloud );
+  }
+  if ( !benchParams.compressedStreamPath_.empty() ) {
+    if ( benchBitstream( bench, benchParams.compressedStreamPath_, benchParams.nbThread_ ) != 0 ) { return -1; }
+  }
+  return 0;
+}
@@ -56,7 +56,8 @@ bool parseParameters( int          argc,
                       size_t&      height,
                       std::string& colorFormat,
                       size_t&      inputNumBytes,
-                      size_t&      outputNumBytes ) {
+                      size_t&      outputNumBytes,
+                      size_t&      frameThreads ) {
   namespace po    = df::program_options_lite;
   bool print_help = false;
   // clang-format off
@@ -70,7 +71,8 @@ bool parseParameters( int          argc,
      ( "height",         height,         height,         "Source video height" )
      ( "colorFormat",    colorFormat,    colorFormat,    "Source color format" )
      ( "inputNumBytes",  inputNumBytes,  inputNumBytes,  "Source video nbyte" )
-     ( "outputNumBytes", outputNumBytes, outputNumBytes, "Output video nbyte" );
+     ( "outputNumBytes", outputNumBytes, outputNumBytes, "Output video nbyte" )
+     ( "frameThreads",   frameThreads,   frameThreads,   "Frames converted concurrently (0: one per core)" );
   // clang-format on
   po::setDefaults( opts );
   po::ErrorReporter        err;
@@ -86,6 +88,7 @@ bool parseParameters( int          argc,
   printf( "  colorFormat    = %s  \n", colorFormat.c_str() );
   printf( "  inputNumBytes  = %zu \n", inputNumBytes );
   printf( "  outputNumBytes = %zu \n", outputNumBytes );
+  printf( "  frameThreads   = %zu \n", frameThreads );
 
   if ( argc == 1 || print_help || srcVideoPath.empty() || dstVideoPath.empty() || configFile.empty() ||
        colorFormat.empty() || width == 0 || height == 0 || inputNumBytes == 0 || outputNumBytes == 0 ||
@@ -104,9 +107,9 @@ bool parseParameters( int          argc,
 int main( int argc, char* argv[] ) {
   std::cout << "PccAppVideoConverter v" << TMC2_VERSION_MAJOR << "." << TMC2_VERSION_MINOR << std::endl << std::endl;
   std::string srcVideoPath, dstVideoPath, configFile, colorFormat;
-  size_t      width = 0, height = 0, inputNumBytes = 0, outputNumBytes = 0;
+  size_t      width = 0, height = 0, inputNumBytes = 0, outputNumBytes = 0, frameThreads = 0;
   if ( !parseParameters( argc, argv, srcVideoPath, dstVideoPath, configFile, width, height, colorFormat, inputNumBytes,
-                         outputNumBytes ) ) {
+                         outputNumBytes, frameThreads ) ) {
     return -1;
   }
   typedef uint16_t T;
@@ -114,7 +117,7 @@ int main( int argc, char* argv[] ) {
   PCCVideo<T, 3>   videoSrc, videoRec;
   videoSrc.read( srcVideoPath, width, height, format, inputNumBytes );
 #ifdef USE_HDRTOOLS
-  PCCHDRToolsLibColorConverter<T> convert;
+  PCCHDRToolsLibColorConverter<T> convert( frameThreads );
 #else
   PCCHDRToolsAppColorConverter<T> convert;
 #endif
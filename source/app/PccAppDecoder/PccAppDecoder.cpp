@@ -35,6 +35,8 @@
 #endif
 #include "PCCCommon.h"
 #include "PCCChrono.h"
+#include "PCCProfiler.h"
+#include "PCCMemoryAccounting.h"
 #include "PCCMemory.h"
 #include "PCCDecoder.h"
 #include "PCCMetrics.h"
@@ -43,6 +45,7 @@
 #include "PCCFrameContext.h"
 #include "PCCBitstream.h"
 #include "PCCGroupOfFrames.h"
+#include "PCCFrameRing.h"
 #include "PCCBitstreamReader.h"
 #include "PCCDecoderParameters.h"
 #include "PCCMetricsParameters.h"
@@ -50,6 +53,10 @@
 #include "PCCConformance.h"
 #include <program_options_lite.h>
 #include <tbb/tbb.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 using namespace pcc;
@@ -149,6 +156,35 @@ bool parseParameters( int                       argc,
       decoderParams.nbThread_,
       decoderParams.nbThread_,
     "Number of thread used for parallel processing")
+    ( "threadAffinity",
+      decoderParams.threadAffinity_,
+      decoderParams.threadAffinity_,
+      "Cores the worker threads are pinned to, e.g. \"0-7,16-23\" (empty: no pinning)")
+    ( "parallelFrames",
+      decoderParams.parallelFrames_,
+      decoderParams.parallelFrames_,
+      "Reconstruct the frames of a GOF in parallel once its videos are decoded")
+    ( "videoDecoderThreads",
+      decoderParams.videoDecoderThreads_,
+      decoderParams.videoDecoderThreads_,
+      "Tiles or wavefront rows of a picture the HM library decoder decodes at the same time (0: all cores)")
+    ( "videoDecoderHardware",
+      decoderParams.videoDecoderHardware_,
+      decoderParams.videoDecoderHardware_,
+      "Decode the HEVC videos with libavcodec on this device: vaapi, cuda, videotoolbox, d3d11va or dxva2, "
+      "optionally followed by :device, auto for the first that opens, none for software (empty: HM)")
+    ( "frameRingName",
+      decoderParams.frameRingName_,
+      decoderParams.frameRingName_,
+      "Publish the decoded frames to a renderer through this POSIX shared memory object, e.g. /pcc_frames")
+    ( "frameRingSlots",
+      decoderParams.frameRingSlots_,
+      decoderParams.frameRingSlots_,
+      "Frames the shared memory ring holds before the oldest is written over")
+    ( "frameRingMaxPoints",
+      decoderParams.frameRingMaxPoints_,
+      decoderParams.frameRingMaxPoints_,
+      "Points a frame of the shared memory ring holds")
     ( "attributeTransferFilterType",
       decoderParams.attrTransferFilterType_,
       decoderParams.attrTransferFilterType_,
@@ -157,6 +193,10 @@ bool parseParameters( int                       argc,
       decoderParams.keepIntermediateFiles_,
       decoderParams.keepIntermediateFiles_,
       "Keep intermediate files: RGB, YUV and bin")
+    ( "writeQueueDepth",
+      decoderParams.writeQueueDepth_,
+      decoderParams.writeQueueDepth_,
+      "Decoded GOFs queued for writing while the next GOF is decoded (0: write each GOF before decoding on)")
 	  ( "shvcLayerIndex",
 	    decoderParams.shvcLayerIndex_,
 	    decoderParams.shvcLayerIndex_,
@@ -166,12 +206,22 @@ bool parseParameters( int                       argc,
     ( "patchColorSubsampling",
       decoderParams.patchColorSubsampling_, 
       decoderParams.patchColorSubsampling_, 
-    "Enable per-patch color up-sampling");
+    "Enable per-patch color up-sampling")
+    ( "fixedPointSmoothing",
+      decoderParams.fixedPointSmoothing_,
+      decoderParams.fixedPointSmoothing_,
+      "Grid smoothing in fixed-point integers, as set for the encoder");
 
     opts.addOptions()
     ( "computeChecksum", 
       metricsParams.computeChecksum_,
-      metricsParams.computeChecksum_, "Compute checksum")
+      metricsParams.computeChecksum_,
+      "Verification mode: compare the decoded frames with the .checksum file, trace the bitstream MD5 and the "
+      "reconstruction checksums and check the decoded atlas hash SEI (off: no checksum work while decoding)")
+    ( "fastChecksum", 
+      metricsParams.fastChecksum_,
+      metricsParams.fastChecksum_,
+      "Frame checksums as a 64-bit XXH64 digest instead of MD5, as written by an encoder run with fastChecksum")
     ( "computeMetrics", 
       metricsParams.computeMetrics_,
       metricsParams.computeMetrics_, "Compute metrics")
@@ -273,6 +323,65 @@ bool parseParameters( int                       argc,
   return !err.is_errored;
 }
 
+//---------------------------------------------------------------------------
+// :: Write-behind of the reconstructed frames
+
+// Writes the reconstructed GOFs on a thread of its own while the next ones are decoded. push() waits while depth GOFs
+// are queued, so that a decoder faster than the disk does not keep the whole sequence in memory.
+class PCCWriteBehind {
+ public:
+  PCCWriteBehind( const std::string& path, const size_t nbThread, const size_t depth ) :
+      path_( path ), nbThread_( nbThread ), depth_( ( std::max )( depth, size_t( 1 ) ) ) {
+    worker_ = std::thread( [this] { run(); } );
+  }
+  ~PCCWriteBehind() { finish(); }
+
+  void push( PCCGroupOfFrames&& frames, const size_t frameNumber ) {
+    std::unique_lock<std::mutex> lock( mutex_ );
+    changed_.wait( lock, [&] { return queue_.size() < depth_; } );
+    queue_.emplace_back( frameNumber, std::move( frames ) );
+    changed_.notify_all();
+  }
+  // waits for the queued GOFs to be written; false if a frame could not be
+  bool finish() {
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      done_ = true;
+      changed_.notify_all();
+    }
+    if ( worker_.joinable() ) { worker_.join(); }
+    return !failed_;
+  }
+
+ private:
+  void run() {
+    std::unique_lock<std::mutex> lock( mutex_ );
+    for ( ;; ) {
+      changed_.wait( lock, [&] { return !queue_.empty() || done_; } );
+      if ( queue_.empty() ) { return; }
+      // stays queued while written, so that the queue holds at most depth GOFs with the one on disk
+      size_t            frameNumber = queue_.front().first;
+      PCCGroupOfFrames& frames      = queue_.front().second;
+      lock.unlock();
+      const bool written = frames.write( path_, frameNumber, nbThread_, false );
+      lock.lock();
+      if ( !written ) { failed_ = true; }
+      queue_.pop_front();
+      changed_.notify_all();
+    }
+  }
+
+  const std::string                                  path_;
+  const size_t                                       nbThread_;
+  const size_t                                       depth_;
+  std::mutex                                         mutex_;
+  std::condition_variable                            changed_;
+  std::deque<std::pair<size_t, PCCGroupOfFrames>>    queue_;
+  bool                                               done_   = false;
+  bool                                               failed_ = false;
+  std::thread                                        worker_;
+};
+
 int decompressVideo( PCCDecoderParameters&       decoderParams,
                      const PCCMetricsParameters& metricsParams,
                      PCCConformanceParameters&   conformanceParams,
@@ -280,39 +389,72 @@ int decompressVideo( PCCDecoderParameters&       decoderParams,
   PCCBitstream     bitstream;
   PCCBitstreamStat bitstreamStat;
   PCCLogger        logger;
+  PCCConformance   conformance;
   logger.initilalize( removeFileExtension( decoderParams.compressedStreamPath_ ), false );
+#ifdef CONFORMANCE_TRACE
+  if ( conformanceParams.checkConformance_ ) {
+    // The logs are compared as the decoder traces them.
+    if ( !conformance.start( conformanceParams ) ) { return -1; }
+    logger.setRecordCallback( [&conformance]( PCCLoggerType type, const char* text, size_t size ) {
+      conformance.record( type, text, size );
+    } );
+  }
+#endif
 #if defined( BITSTREAM_TRACE ) || defined( CONFORMANCE_TRACE )
   bitstream.setLogger( logger );
   bitstream.setTrace( true );
 #endif
   if ( !bitstream.initialize( decoderParams.compressedStreamPath_ ) ) { return -1; }
-  bitstream.computeMD5();
+  if ( metricsParams.computeChecksum_ ) { bitstream.computeMD5(); }
   bitstreamStat.setHeader( bitstream.size() );
   size_t         frameNumber = decoderParams.startFrameNumber_;
   PCCMetrics     metrics;
   PCCChecksum    checksum;
-  PCCConformance conformance;
   metrics.setParameters( metricsParams );
   checksum.setParameters( metricsParams );
   if ( metricsParams.computeChecksum_ ) { checksum.read( decoderParams.compressedStreamPath_ ); }
-  PCCDecoder decoder;
+  PCCDecoder          decoder;
+  PCCMemoryAccounting memory;
   decoder.setLogger( logger );
+  decoder.setMemoryAccounting( memory );
+  decoderParams.verifyChecksums_ = metricsParams.computeChecksum_;
   decoder.setParameters( decoderParams );
+  PCCFrameRing frameRing;
+  if ( !decoderParams.frameRingName_.empty() &&
+       !frameRing.create( decoderParams.frameRingName_, decoderParams.frameRingSlots_,
+                          decoderParams.frameRingMaxPoints_ ) ) {
+    return -1;
+  }
+  std::unique_ptr<PCCWriteBehind> writeBehind;
+  if ( !decoderParams.reconstructedDataPath_.empty() && decoderParams.writeQueueDepth_ > 0 ) {
+    writeBehind.reset( new PCCWriteBehind( decoderParams.reconstructedDataPath_, decoderParams.nbThread_,
+                                           decoderParams.writeQueueDepth_ ) );
+  }
 
   SampleStreamV3CUnit ssvu;
   size_t              headerSize = pcc::PCCBitstreamReader::read( bitstream, ssvu );
   bitstreamStat.incrHeader( headerSize );
-  bool bMoreData = true;
+  bool       bMoreData = true;
+  PCCContext context;
   while ( bMoreData ) {
     PCCGroupOfFrames reconstructs;
-    PCCContext       context;
+    context.reset();
     context.setBitstreamStat( bitstreamStat );
     clock.start();
     PCCBitstreamReader bitstreamReader;
 #ifdef BITSTREAM_TRACE
     bitstreamReader.setLogger( logger );
 #endif
-    if ( bitstreamReader.decode( ssvu, context ) == 0 ) { return 0; }
+    {
+      PCC_PROFILE_ZONE( "bitstream read" );
+      if ( bitstreamReader.decode( ssvu, context ) == 0 ) { return 0; }
+    }
+    {
+      PCCMemoryUsage usage;
+      context.getMemoryUsage( usage );
+      usage.add( MEMORY_BITSTREAM, bitstream.getMemorySize() );
+      memory.sample( "bitstream read", usage );
+    }
 #if 1
     if ( context.checkProfile() != 0 ) {
       printf( "Profile not correct... \n" );
@@ -354,11 +496,24 @@ int decompressVideo( PCCDecoderParameters&       decoderParams,
 #ifdef CONFORMANCE_TRACE
       if ( conformanceParams.checkConformance_ ) {
         conformanceParams.levelIdc_ = context.getVps().getProfileTierLevel().getLevelIdc();
-        conformance.check( conformanceParams );
+        // Stops at the first mismatch.
+        if ( conformance.failed() ) {
+          bMoreData = false;
+          break;
+        }
       }
 #endif
 
-      if ( !decoderParams.reconstructedDataPath_.empty() ) {
+      if ( !decoderParams.frameRingName_.empty() ) {
+        for ( size_t i = 0; i < reconstructs.getFrameCount(); i++ ) {
+          frameRing.publish( frameNumber + i, reconstructs[i] );
+        }
+      }
+      if ( writeBehind ) {
+        const size_t frameCount = reconstructs.getFrameCount();
+        writeBehind->push( std::move( reconstructs ), frameNumber );
+        frameNumber += frameCount;
+      } else if ( !decoderParams.reconstructedDataPath_.empty() ) {
         reconstructs.write( decoderParams.reconstructedDataPath_, frameNumber, decoderParams.nbThread_, false );
       } else {
         frameNumber += reconstructs.getFrameCount();
@@ -366,10 +521,18 @@ int decompressVideo( PCCDecoderParameters&       decoderParams,
       bMoreData = ( ssvu.getV3CUnitCount() > 0 );
     }
   }
+  if ( writeBehind && !writeBehind->finish() ) {
+    std::cerr << "Error: can't write the reconstructed frames " << decoderParams.reconstructedDataPath_ << std::endl;
+    return -1;
+  }
   bitstreamStat.trace();
+  memory.trace();
   if ( metricsParams.computeMetrics_ ) { metrics.display(); }
   bool validChecksum = true;
   if ( metricsParams.computeChecksum_ ) { validChecksum &= checksum.compareRecDec(); }
+#ifdef CONFORMANCE_TRACE
+  if ( conformanceParams.checkConformance_ ) { validChecksum &= conformance.finish( conformanceParams.levelIdc_ ); }
+#endif
   return !validChecksum;
 }
 
@@ -380,7 +543,8 @@ int main( int argc, char* argv[] ) {
   PCCMetricsParameters     metricsParams;
   PCCConformanceParameters conformanceParams;
   if ( !parseParameters( argc, argv, decoderParams, metricsParams, conformanceParams ) ) { return -1; }
-  if ( decoderParams.nbThread_ > 0 ) { tbb::task_scheduler_init init( static_cast<int>( decoderParams.nbThread_ ) ); }
+  tbb::task_scheduler_init init( decoderParams.nbThread_ > 0 ? static_cast<int>( decoderParams.nbThread_ )
+                                                             : tbb::task_scheduler_init::automatic );
 
   // Timers to count elapsed wall/user time
   pcc::chrono::Stopwatch<std::chrono::steady_clock> clockWall;
@@ -399,5 +563,6 @@ int main( int argc, char* argv[] ) {
   std::cout << "Processing time (user.self): " << ( ret == 0 ? totalUserSelf / 1000.0 : -1 ) << " s\n";
   std::cout << "Processing time (user.children): " << ( ret == 0 ? totalUserChild / 1000.0 : -1 ) << " s\n";
   std::cout << "Peak memory: " << getPeakMemory() << " KB\n";
+  PCC_PROFILE_REPORT( stdout );
   return ret;
 }
@@ -0,0 +1,398 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "PCCCommon.h"
+#include "PCCContext.h"
+#include "PCCFrameContext.h"
+#include "PCCDecoder.h"
+#include "PCCProfiler.h"
+#include "PCCBitstream.h"
+#include "PCCGroupOfFrames.h"
+#include "PCCBitstreamReader.h"
+#include "PCCMemoryAccounting.h"
+#include "PCCDecoderParameters.h"
+#include <program_options_lite.h>
+#include <tbb/tbb.h>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+using namespace pcc;
+
+//---------------------------------------------------------------------------
+// :: Decoder performance regression
+//
+// Decodes every stream of a corpus of golden bitstreams, after one untimed
+// warm-up run, and compares the median over the repetitions of the decode
+// time, of the time of each stage and of the peak memory of the decoder
+// structures with baselines recorded earlier on the same machine, with the
+// same thread count. A slowdown beyond the tolerance fails the run.
+//
+// The stage times come from the profiler when it is compiled in
+// (ENABLE_PROFILER), which also times the nested zones such as the video
+// decompression, and from the stage callback of the decoder otherwise.
+//
+// The corpus lists one stream per line, "<name> <path>", the path relative
+// to the corpus file, '#' starting a comment. The baselines are tab
+// separated "<name> <metric> <value>" lines, written by updateBaselines.
+
+struct RegressionParameters {
+  std::string corpusPath_;
+  std::string baselinePath_;
+  bool        updateBaselines_ = false;
+  size_t      nbThread_        = 0;
+  size_t      repetitions_     = 3;
+  double      timeTolerance_   = 0.10;
+  double      memoryTolerance_ = 0.05;
+  double      minStageTime_    = 0.010;
+};
+
+struct CorpusStream {
+  std::string name_;
+  std::string path_;
+};
+
+// Metrics of a stream by name, in seconds, or in bytes for the peak memory.
+typedef std::map<std::string, double>  Metrics;
+typedef std::map<std::string, Metrics> Baselines;
+
+static const char* g_decodeMetric = "decode";
+static const char* g_memoryMetric = "peak memory";
+static const char* g_stagePrefix  = "stage ";
+
+static bool readCorpus( const std::string& path, std::vector<CorpusStream>& streams ) {
+  std::ifstream file( path );
+  if ( !file.is_open() ) {
+    printf( "Can't open the corpus %s \n", path.c_str() );
+    return false;
+  }
+  const size_t      slash  = path.find_last_of( "/\\" );
+  const std::string folder = slash == std::string::npos ? std::string() : path.substr( 0, slash + 1 );
+  std::string       line;
+  while ( std::getline( file, line ) ) {
+    const size_t comment = line.find( '#' );
+    if ( comment != std::string::npos ) { line.resize( comment ); }
+    std::istringstream fields( line );
+    CorpusStream       stream;
+    if ( !( fields >> stream.name_ ) ) { continue; }
+    if ( !( fields >> stream.path_ ) ) {
+      printf( "Corpus stream %s has no path \n", stream.name_.c_str() );
+      return false;
+    }
+    if ( stream.path_[0] != '/' ) { stream.path_ = folder + stream.path_; }
+    streams.push_back( stream );
+  }
+  if ( streams.empty() ) { printf( "The corpus %s lists no stream \n", path.c_str() ); }
+  return !streams.empty();
+}
+
+static bool readBaselines( const std::string& path, Baselines& baselines ) {
+  std::ifstream file( path );
+  if ( !file.is_open() ) { return false; }
+  std::string line;
+  while ( std::getline( file, line ) ) {
+    if ( line.empty() || line[0] == '#' ) { continue; }
+    const size_t first  = line.find( '\t' );
+    const size_t second = first == std::string::npos ? first : line.find( '\t', first + 1 );
+    if ( second == std::string::npos ) { continue; }
+    baselines[line.substr( 0, first )][line.substr( first + 1, second - first - 1 )] =
+        atof( line.c_str() + second + 1 );
+  }
+  return true;
+}
+
+static bool writeBaselines( const std::string& path, const Baselines& baselines ) {
+  FILE* file = fopen( path.c_str(), "w" );
+  if ( file == nullptr ) { return false; }
+  fprintf( file, "# PccAppDecoderRegression baselines: stream, metric, seconds or bytes\n" );
+  for ( const auto& stream : baselines ) {
+    for ( const auto& metric : stream.second ) {
+      fprintf( file, "%s\t%s\t%.6f\n", stream.first.c_str(), metric.first.c_str(), metric.second );
+    }
+  }
+  return fclose( file ) == 0;
+}
+
+// Decodes the stream once as PccAppDecoder does, without writing the reconstruction.
+static bool decodeStream( const std::string& path, size_t nbThread, Metrics& metrics ) {
+  PCCDecoderParameters decoderParams;
+  decoderParams.compressedStreamPath_ = path;
+  decoderParams.nbThread_             = nbThread;
+  PCCBitstream bitstream;
+  if ( !bitstream.initialize( path ) ) { return false; }
+  PCCDecoder          decoder;
+  PCCMemoryAccounting memory;
+  decoder.setMemoryAccounting( memory );
+  decoder.setParameters( decoderParams );
+#ifdef ENABLE_PROFILER
+  pcc::profiler::reset();
+#else
+  // the stages of the frames may overlap: each is matched with its own begin
+  std::mutex                                                                         mutex;
+  std::map<std::pair<std::string, int32_t>, std::chrono::steady_clock::time_point> starts;
+  decoder.setStageCallback( [&]( const char* stage, int32_t frameIndex, bool begin ) {
+    const auto                  now = std::chrono::steady_clock::now();
+    const auto                  key = std::make_pair( std::string( stage ), frameIndex );
+    std::lock_guard<std::mutex> lock( mutex );
+    if ( begin ) {
+      starts[key] = now;
+    } else {
+      metrics[g_stagePrefix + key.first] += std::chrono::duration<double>( now - starts[key] ).count();
+    }
+  } );
+#endif
+
+  const auto          start = std::chrono::steady_clock::now();
+  SampleStreamV3CUnit ssvu;
+  pcc::PCCBitstreamReader::read( bitstream, ssvu );
+  bool       bMoreData = true;
+  PCCContext context;
+  while ( bMoreData ) {
+    PCCGroupOfFrames reconstructs;
+    context.reset();
+    PCCBitstreamReader bitstreamReader;
+    const auto         readStart = std::chrono::steady_clock::now();
+    if ( bitstreamReader.decode( ssvu, context ) == 0 ) { break; }
+    metrics[std::string( g_stagePrefix ) + "bitstream read"] +=
+        std::chrono::duration<double>( std::chrono::steady_clock::now() - readStart ).count();
+    {
+      PCCMemoryUsage usage;
+      context.getMemoryUsage( usage );
+      usage.add( MEMORY_BITSTREAM, bitstream.getMemorySize() );
+      memory.sample( "bitstream read", usage );
+    }
+    if ( context.checkProfile() != 0 ) {
+      printf( "Profile not correct... \n" );
+      return false;
+    }
+    decoderParams.setReconstructionParameters( context.getVps().getProfileTierLevel().getProfileReconstructionIdc() );
+    decoder.setReconstructionParameters( decoderParams );
+    context.resizeAtlas( context.getVps().getAtlasCountMinus1() + 1 );
+    for ( uint32_t atlId = 0; atlId < context.getVps().getAtlasCountMinus1() + 1; atlId++ ) {
+      context.getAtlas( atlId ).allocateVideoFrames( context, 0 );
+      context.setAtlasIndex( atlId );
+      if ( decoder.decode( context, reconstructs, atlId ) != 0 ) { return false; }
+    }
+    bMoreData = ( ssvu.getV3CUnitCount() > 0 );
+  }
+  metrics[g_decodeMetric] = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+#ifdef ENABLE_PROFILER
+  std::map<std::string, pcc::profiler::ZoneTotal> zones;
+  pcc::profiler::totals( zones );
+  for ( const auto& zone : zones ) { metrics[g_stagePrefix + zone.first] += zone.second.total * 1e-9; }
+#endif
+  metrics[g_memoryMetric] = static_cast<double>( memory.getPeakTotal() );
+  return true;
+}
+
+// Median of each metric over the runs.
+static void median( const std::vector<Metrics>& runs, Metrics& metrics ) {
+  std::map<std::string, std::vector<double>> values;
+  for ( const auto& run : runs ) {
+    for ( const auto& metric : run ) { values[metric.first].push_back( metric.second ); }
+  }
+  for ( auto& value : values ) {
+    std::sort( value.second.begin(), value.second.end() );
+    metrics[value.first] = value.second[value.second.size() / 2];
+  }
+}
+
+static std::string formatMetric( const std::string& name, double value ) {
+  char text[32];
+  if ( name == g_memoryMetric ) {
+    snprintf( text, sizeof( text ), "%.1f MB", value / ( 1024. * 1024. ) );
+  } else {
+    snprintf( text, sizeof( text ), "%.2f ms", value * 1e3 );
+  }
+  return text;
+}
+
+// Prints the metrics of a stream against its baselines and returns the number of regressions. Stages too short to
+// be timed reliably are reported but not checked; the decode time and the peak memory always are.
+static size_t compareMetrics( const std::string&          name,
+                              const Metrics&              metrics,
+                              const Metrics*              baseline,
+                              const RegressionParameters& params ) {
+  size_t regressions = 0;
+  for ( const auto& metric : metrics ) {
+    const std::string measured = formatMetric( metric.first, metric.second );
+    const auto        it       = baseline != nullptr ? baseline->find( metric.first ) : Metrics::const_iterator();
+    if ( baseline == nullptr || it == baseline->end() ) {
+      printf( "%-20s %-32s %14s %14s %8s %s \n", name.c_str(), metric.first.c_str(), "-", measured.c_str(), "",
+              "new" );
+      continue;
+    }
+    const bool   memoryMetric = metric.first == g_memoryMetric;
+    const double reference    = it->second;
+    const double change       = reference > 0 ? metric.second / reference - 1. : 0.;
+    const double tolerance    = memoryMetric ? params.memoryTolerance_ : params.timeTolerance_;
+    const bool checked = memoryMetric || metric.first == g_decodeMetric || reference >= params.minStageTime_;
+    const bool regressed = checked && change > tolerance;
+    regressions += regressed ? 1 : 0;
+    printf( "%-20s %-32s %14s %14s %+7.1f%% %s \n", name.c_str(), metric.first.c_str(),
+            formatMetric( metric.first, reference ).c_str(), measured.c_str(), change * 100.,
+            regressed ? "REGRESSION" : checked ? "ok" : "not checked" );
+  }
+  fflush( stdout );
+  return regressions;
+}
+
+//---------------------------------------------------------------------------
+// :: Command line / config parsing
+
+bool parseParameters( int argc, char* argv[], RegressionParameters& params ) {
+  namespace po    = df::program_options_lite;
+  bool print_help = false;
+
+  // clang-format off
+  po::Options opts;
+  opts.addOptions()
+    ( "help", print_help, false,"This help text" )
+    ( "c,config", po::parseConfigFile, "Configuration file name" )
+    ( "corpusPath",
+      params.corpusPath_,
+      params.corpusPath_,
+      "List of the golden streams: one \"<name> <path>\" per line, relative to the list" )
+    ( "baselinePath",
+      params.baselinePath_,
+      params.baselinePath_,
+      "Baselines of the streams, recorded on this machine" )
+    ( "updateBaselines",
+      params.updateBaselines_,
+      params.updateBaselines_,
+      "Write the measured metrics to baselinePath instead of checking them" )
+    ( "nbThread",
+      params.nbThread_,
+      params.nbThread_,
+      "Number of thread used for parallel processing, as when the baselines were recorded" )
+    ( "repetitions",
+      params.repetitions_,
+      params.repetitions_,
+      "Timed decodes of each stream, after one untimed warm-up decode" )
+    ( "timeTolerance",
+      params.timeTolerance_,
+      params.timeTolerance_,
+      "Relative slowdown of a time over its baseline reported as a regression" )
+    ( "memoryTolerance",
+      params.memoryTolerance_,
+      params.memoryTolerance_,
+      "Relative growth of the peak memory over its baseline reported as a regression" )
+    ( "minStageTime",
+      params.minStageTime_,
+      params.minStageTime_,
+      "Stages whose baseline is shorter (s) are reported but not checked" )
+    ;
+  opts.addOptions();
+  // clang-format on
+  po::setDefaults( opts );
+  po::ErrorReporter        err;
+  const list<const char*>& argv_unhandled = po::scanArgv( opts, argc, (const char**)argv, err );
+  for ( const auto arg : argv_unhandled ) { printf( "Unhandled argument ignored: %s \n", arg ); }
+
+  if ( argc == 1 || print_help ) {
+    po::doHelp( std::cout, opts, 78 );
+    return false;
+  }
+  if ( params.corpusPath_.empty() || params.baselinePath_.empty() ) {
+    err.error( "Parameters" ) << "corpusPath and baselinePath must be set\n";
+  }
+  params.repetitions_ = ( std::max )( params.repetitions_, (size_t)1 );
+
+  printf( "parseParameters : \n" );
+  printf( "  corpusPath      = %s \n", params.corpusPath_.c_str() );
+  printf( "  baselinePath    = %s \n", params.baselinePath_.c_str() );
+  printf( "  updateBaselines = %d \n", params.updateBaselines_ );
+  printf( "  nbThread        = %zu \n", params.nbThread_ );
+  printf( "  repetitions     = %zu \n", params.repetitions_ );
+  printf( "  timeTolerance   = %.3f \n", params.timeTolerance_ );
+  printf( "  memoryTolerance = %.3f \n", params.memoryTolerance_ );
+  printf( "  minStageTime    = %.3f \n", params.minStageTime_ );
+
+  return !err.is_errored;
+}
+
+int main( int argc, char* argv[] ) {
+  std::cout << "PccAppDecoderRegression v" << TMC2_VERSION_MAJOR << "." << TMC2_VERSION_MINOR << std::endl
+            << std::endl;
+  RegressionParameters params;
+  if ( !parseParameters( argc, argv, params ) ) { return -1; }
+  tbb::task_scheduler_init init( params.nbThread_ > 0 ? static_cast<int>( params.nbThread_ )
+                                                      : tbb::task_scheduler_init::automatic );
+  std::vector<CorpusStream> streams;
+  if ( !readCorpus( params.corpusPath_, streams ) ) { return -1; }
+  Baselines baselines;
+  if ( !params.updateBaselines_ && !readBaselines( params.baselinePath_, baselines ) ) {
+    printf( "Can't read the baselines %s: record them with --updateBaselines=1 \n", params.baselinePath_.c_str() );
+    return -1;
+  }
+
+  printf( "%-20s %-32s %14s %14s %8s %s \n", "stream", "metric", "baseline", "measured", "change", "status" );
+  Baselines measured;
+  size_t    regressions = 0;
+  for ( const auto& stream : streams ) {
+    Metrics warmUp;
+    if ( !decodeStream( stream.path_, params.nbThread_, warmUp ) ) {
+      printf( "Can't decode %s (%s) \n", stream.name_.c_str(), stream.path_.c_str() );
+      return -1;
+    }
+    std::vector<Metrics> runs( params.repetitions_ );
+    for ( auto& run : runs ) {
+      if ( !decodeStream( stream.path_, params.nbThread_, run ) ) { return -1; }
+    }
+    auto& metrics = measured[stream.name_];
+    median( runs, metrics );
+    const auto baseline = baselines.find( stream.name_ );
+    regressions +=
+        compareMetrics( stream.name_, metrics, baseline != baselines.end() ? &baseline->second : nullptr, params );
+  }
+
+  if ( params.updateBaselines_ ) {
+    if ( !writeBaselines( params.baselinePath_, measured ) ) {
+      printf( "Can't write the baselines %s \n", params.baselinePath_.c_str() );
+      return -1;
+    }
+    printf( "Baselines written to %s \n", params.baselinePath_.c_str() );
+    return 0;
+  }
+  if ( regressions > 0 ) {
+    printf( "%zu regression(s) beyond the tolerance \n", regressions );
+    return 1;
+  }
+  printf( "No regression \n" );
+  return 0;
+}
@@ -35,6 +35,8 @@
 #endif
 #include "PCCCommon.h"
 #include "PCCChrono.h"
+#include "PCCProfiler.h"
+#include "PCCMemoryAccounting.h"
 #include "PCCMemory.h"
 #include "PCCEncoder.h"
 #include "PCCMetrics.h"
@@ -46,8 +48,16 @@
 #include "PCCEncoderParameters.h"
 #include "PCCBitstreamWriter.h"
 #include "PCCMetricsParameters.h"
+#include "PCCSystem.h"
 #include <program_options_lite.h>
 #include <tbb/tbb.h>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 using namespace pcc;
@@ -107,13 +117,39 @@ static std::istream& operator>>( std::istream& in, std::vector<int>& vector ) {
 
 }  // namespace pcc
 
+// Options of the multi-rate and the segment modes, they are not encoder parameters.
+struct AppOptions {
+  std::string rateConfigs_;
+  std::string rateCompressedStreamPaths_;
+  size_t      segmentFrameCount_ = 0;
+  size_t      segmentJobs_       = 1;
+  std::string segmentSizesPath_;
+  bool        segmentLive_        = false;
+  double      segmentLiveTimeout_ = 10.;
+  std::string segmentLivePublishCommand_;
+  bool        writeComplexity_ = false;
+};
+
+static std::vector<std::string> splitList( const std::string& list, char separator = ',' ) {
+  std::vector<std::string> items;
+  size_t                   start = 0;
+  while ( start < list.size() ) {
+    size_t end = list.find( separator, start );
+    if ( end == std::string::npos ) { end = list.size(); }
+    if ( end > start ) { items.push_back( list.substr( start, end - start ) ); }
+    start = end + 1;
+  }
+  return items;
+}
+
 //---------------------------------------------------------------------------
 // :: Command line / config parsing
 
 bool parseParameters( int                   argc,
                       char*                 argv[],
                       PCCEncoderParameters& encoderParams,
-                      PCCMetricsParameters& metricsParams ) {
+                      PCCMetricsParameters& metricsParams,
+                      AppOptions&           appOptions ) {
   namespace po    = df::program_options_lite;
   bool print_help = false;
 
@@ -153,6 +189,49 @@ bool parseParameters( int                   argc,
       encoderParams.reconstructedDataPath_,
       encoderParams.reconstructedDataPath_,
       "Output decoded pointcloud. Multi-frame sequences may be represented by %04i" )
+    ( "rateConfigs",
+      appOptions.rateConfigs_,
+      appOptions.rateConfigs_,
+      "Multi-rate encoding: comma separated rate configuration files, each applied on top of the other parameters. "
+      "An entry may join several files with '+', applied in that order, e.g. "
+      "condition/vtm-all-intra.cfg+common/vvc.cfg+rate/high.cfg for a VVC coded rate. "
+      "The segmentation of every GOF is computed once for all of them" )
+    ( "rateCompressedStreamPaths",
+      appOptions.rateCompressedStreamPaths_,
+      appOptions.rateCompressedStreamPaths_,
+      "Multi-rate encoding: comma separated compressed bitstreams, one per entry of rateConfigs" )
+    ( "segmentFrameCount",
+      appOptions.segmentFrameCount_,
+      appOptions.segmentFrameCount_,
+      "Segment mode: encode every segmentFrameCount frames as a separate bitstream, the compressed stream paths "
+      "are printf patterns of the segment index. 0 = off" )
+    ( "segmentJobs",
+      appOptions.segmentJobs_,
+      appOptions.segmentJobs_,
+      "Segment mode: number of segments encoded at the same time, each one by its own encoder process" )
+    ( "segmentSizesPath",
+      appOptions.segmentSizesPath_,
+      appOptions.segmentSizesPath_,
+      "Segment mode: CSV file of the size of every bitstream" )
+    ( "segmentLive",
+      appOptions.segmentLive_,
+      appOptions.segmentLive_,
+      "Segment mode: live, the frames are PLY files of uncompressedDataPath that arrive while encoding and every "
+      "segment is encoded as soon as its frames are there. frameCount is the most frames, 0 = until they stop" )
+    ( "segmentLiveTimeout",
+      appOptions.segmentLiveTimeout_,
+      appOptions.segmentLiveTimeout_,
+      "Segment mode, live: seconds without a new frame after which the stream ends" )
+    ( "segmentLivePublishCommand",
+      appOptions.segmentLivePublishCommand_,
+      appOptions.segmentLivePublishCommand_,
+      "Segment mode, live: shell command run for every segment, in segment order, once its bitstreams and its rows "
+      "of segmentSizesPath are written; a printf pattern of the segment index" )
+    ( "writeComplexity",
+      appOptions.writeComplexity_,
+      appOptions.writeComplexity_,
+      "Write the decode complexity of every compressed stream next to it, as <stream>.complexity: points, "
+      "patches, atlas size and video bytes by component, read by the MPD packager" )
     ( "forcedSsvhUnitSizePrecisionBytes",
       encoderParams.forcedSsvhUnitSizePrecisionBytes_,
       encoderParams.forcedSsvhUnitSizePrecisionBytes_,
@@ -171,6 +250,10 @@ bool parseParameters( int                   argc,
       encoderParams.groupOfFramesSize_,
       encoderParams.groupOfFramesSize_, 
       "Random access period" )
+    ( "frameWindowSize",
+      encoderParams.frameWindowSize_,
+      encoderParams.frameWindowSize_,
+      "Source frames kept in memory while encoding a group of frames, read again by each stage (0: whole group)" )
 
     // colour space conversion
     ( "colorTransform",
@@ -207,6 +290,23 @@ bool parseParameters( int                   argc,
       encoderParams.normalOrientation_,
       encoderParams.normalOrientation_,
       "Normal orientation: 0: None 1: spanning tree, 2:view point, 3:cubemap projection" )     
+    ( "temporalNormals",
+      encoderParams.temporalNormals_,
+      encoderParams.temporalNormals_,
+      "Seed the normals of each frame from those of the previous frame, recomputing those that no longer fit" )
+    ( "maxFitErrorTemporalNormals",
+      encoderParams.maxFitErrorTemporalNormals_,
+      encoderParams.maxFitErrorTemporalNormals_,
+      "Largest fraction of the neighborhood variance off the plane of a seeded normal" )
+    ( "maxDist2TemporalNormals",
+      encoderParams.maxDist2TemporalNormals_,
+      encoderParams.maxDist2TemporalNormals_,
+      "Largest squared distance to the point of the previous frame a normal is seeded from" )
+    ( "deviceSegmentation",
+      encoderParams.deviceSegmentation_,
+      encoderParams.deviceSegmentation_,
+      "Compute the normals, the initial segmentation and the grid-based refinement neighbors on the CUDA device "
+      "(encoder built with USE_CUDA), the CPU otherwise" )
     ( "gridBasedRefineSegmentation",
       encoderParams.gridBasedRefineSegmentation_,
       encoderParams.gridBasedRefineSegmentation_,
@@ -365,6 +465,10 @@ bool parseParameters( int                   argc,
       encoderParams.gridSize_,
       encoderParams.gridSize_,
       "grid size for the smoothing" )
+    ( "fixedPointSmoothing",
+      encoderParams.fixedPointSmoothing_,
+      encoderParams.fixedPointSmoothing_,
+      "Grid smoothing in fixed-point integers; not signalled, decode with the same setting" )
 
     // color smoothing
     ( "thresholdColorSmoothing",
@@ -510,6 +614,27 @@ bool parseParameters( int                   argc,
     encoderParams.byteStreamVideoCoderAttribute_,
     encoderParams.byteStreamVideoCoderAttribute_,
     "Attribute video encoder outputs byteStream" )
+    ( "videoEncoderWavefront",
+      encoderParams.videoEncoderWavefront_,
+      encoderParams.videoEncoderWavefront_,
+      "Geometry and attribute videos coded with one substream per CTU row (WPP), decodable in parallel" )
+    ( "videoEncoderTileColumns",
+      encoderParams.videoEncoderTileColumns_,
+      encoderParams.videoEncoderTileColumns_,
+      "Uniform tile columns of the geometry and attribute videos (HM)" )
+    ( "videoEncoderTileRows",
+      encoderParams.videoEncoderTileRows_,
+      encoderParams.videoEncoderTileRows_,
+      "Uniform tile rows of the geometry and attribute videos (HM)" )
+    ( "videoEncoderChunkFrames",
+      encoderParams.videoEncoderChunkFrames_,
+      encoderParams.videoEncoderChunkFrames_,
+      "Frames of the closed chunks the HM encoders code a video in, in parallel, each starting with an IDR "
+      "picture: a multiple of the GOP of the configuration, e.g. 2 with the ai ones. 0: one chunk" )
+    ( "videoEncoderHardware",
+      encoderParams.videoEncoderHardware_,
+      encoderParams.videoEncoderHardware_,
+      "Encoder of the FFMPEG video codec: nvenc, qsv, none for libx265 in software, auto for the first that opens" )
 
     ( "geometryQP",
       encoderParams.geometryQP_,
@@ -527,6 +652,20 @@ bool parseParameters( int                   argc,
       encoderParams.auxAttributeQP_,
       encoderParams.auxAttributeQP_,
       "QP for compression of auxiliary attribute video" )
+    ( "targetFrameBytes",
+      encoderParams.targetFrameBytes_,
+      encoderParams.targetFrameBytes_,
+      "Rate control: target bytes per frame of every GOF (a segment in segment mode), across the occupancy, "
+      "geometry and attribute streams. A GOF further off than targetTolerance is encoded again with the QPs "
+      "estimated from its first pass. 0 = off" )
+    ( "targetGeometryShare",
+      encoderParams.targetGeometryShare_,
+      encoderParams.targetGeometryShare_,
+      "Rate control: share of the video bytes for the geometry, the rest for the attribute. 0 = as in the first pass" )
+    ( "targetTolerance",
+      encoderParams.targetTolerance_,
+      encoderParams.targetTolerance_,
+      "Rate control: relative difference to the target bytes up to which the first pass is kept" )
     ( "geometryConfig",
       encoderParams.geometryConfig_,
       encoderParams.geometryConfig_,
@@ -585,6 +724,10 @@ bool parseParameters( int                   argc,
       encoderParams.nbThread_,
       encoderParams.nbThread_,
       "Number of thread used for parallel processing" )
+    ( "threadAffinity",
+      encoderParams.threadAffinity_,
+      encoderParams.threadAffinity_,
+      "Cores the worker threads are pinned to, e.g. \"0-7,16-23\" (empty: no pinning)" )
     ( "keepIntermediateFiles",
       encoderParams.keepIntermediateFiles_,
       encoderParams.keepIntermediateFiles_,
@@ -791,6 +934,10 @@ bool parseParameters( int                   argc,
       encoderParams.patchSize_,
       encoderParams.patchSize_,
       "Size of Patch for PLR" )
+    ( "plrEarlyTerminationDist",
+      encoderParams.plrEarlyTerminationDist_,
+      encoderParams.plrEarlyTerminationDist_,
+      "PLR mode search stops at the first mode whose geometry distance is at most this value (0: exhaustive)" )
     ( "enhancedProjectionPlane",
       encoderParams.enhancedPP_,
       encoderParams.enhancedPP_,
@@ -908,6 +1055,11 @@ bool parseParameters( int                   argc,
       metricsParams.computeChecksum_,
       metricsParams.computeChecksum_, 
       "Compute checksum" )
+    ( "fastChecksum", 
+      metricsParams.fastChecksum_,
+      metricsParams.fastChecksum_, 
+      "Frame checksums as a 64-bit XXH64 digest instead of MD5: faster, for regression comparisons only. "
+      "The decoder must use the same setting to compare with the .checksum file" )
     ( "computeMetrics", 
       metricsParams.computeMetrics_,
       metricsParams.computeMetrics_, 
@@ -1003,41 +1155,119 @@ bool parseParameters( int                   argc,
   return true;
 }
 
-int compressVideo( const PCCEncoderParameters& encoderParams,
-                   const PCCMetricsParameters& metricsParams,
-                   StopwatchUserTime&          clock ) {
-  const size_t startFrameNumber0        = encoderParams.startFrameNumber_;
-  size_t       endFrameNumber0          = encoderParams.startFrameNumber_ + encoderParams.frameCount_;
-  const size_t groupOfFramesSize0       = ( std::max )( size_t( 1 ), encoderParams.groupOfFramesSize_ );
-  size_t       startFrameNumber         = startFrameNumber0;
-  size_t       reconstructedFrameNumber = encoderParams.startFrameNumber_;
-
-  PCCLogger logger;
-  logger.initilalize( removeFileExtension( encoderParams.compressedStreamPath_ ), true );
-  std::unique_ptr<uint8_t> buffer;
-  size_t                   contextIndex = 0;
-  PCCEncoder               encoder;
-  PCCMetrics               metrics;
-  PCCChecksum              checksum;
-  PCCBitstreamStat         bitstreamStat;
-  SampleStreamV3CUnit      ssvu;
-  encoder.setLogger( logger );
-  encoder.setParameters( encoderParams );
-  metrics.setParameters( metricsParams );
-  checksum.setParameters( metricsParams );
+// Encoder and outputs of one rate; with rateConfigs there is one per rate configuration.
+struct RateEncoder {
+  PCCEncoderParameters params;
+  PCCLogger            logger;
+  PCCEncoder           encoder;
+  PCCMetrics           metrics;
+  PCCChecksum          checksum;
+  PCCBitstreamStat     bitstreamStat;
+  PCCMemoryAccounting  memory;
+  SampleStreamV3CUnit  ssvu;
+  // decode complexity of the stream, see writeComplexity
+  size_t frames      = 0;
+  size_t points      = 0;
+  size_t patches     = 0;
+  size_t atlasWidth  = 0;
+  size_t atlasHeight = 0;
+};
+
+// One CSV row after the header, what a decoder of the stream has to do: the reconstructed points and the patches
+// of all its frames, the largest atlas and the bytes of each video component.
+static void writeComplexity( RateEncoder& rate ) {
+  std::ofstream fout( removeFileExtension( rate.params.compressedStreamPath_ ) + ".complexity", std::ios::out );
+  if ( !fout.is_open() ) { return; }
+  PCCBitstreamGofStat total = rate.bitstreamStat.getTotalStat();
+  fout << "frames,points,patches,atlasWidth,atlasHeight,occupancyBytes,geometryBytes,attributeBytes" << std::endl;
+  fout << rate.frames << "," << rate.points << "," << rate.patches << "," << rate.atlasWidth << ","
+       << rate.atlasHeight << "," << total.getVideoBinSize( VIDEO_OCCUPANCY ) << "," << total.getTotalGeometry()
+       << "," << total.getTotalAttribute() << std::endl;
+}
+
+// Rate control: the QPs of the second pass of a GOF whose first pass, the last GOF of stat, is off targetBytes by
+// more than targetTolerance; false to keep the first pass. The occupancy map and the atlas data hardly depend on the
+// QPs, so the rest of the target goes to the geometry and the attribute videos, shared as in the first pass or by
+// targetGeometryShare. The QP of each moves by 6 * log2( first pass bytes / its share ): the bytes of a video about
+// halve every 6 QPs.
+static bool rateControlQPs( PCCBitstreamStat& stat, size_t targetBytes, PCCEncoderParameters& params ) {
+  const double total     = static_cast<double>( stat.getTotal() );
+  const double geometry  = static_cast<double>( stat.getTotalGeometry() );
+  const double attribute = static_cast<double>( stat.getTotalAttribute() );
+  const double target    = static_cast<double>( targetBytes );
+  if ( std::abs( total - target ) <= params.targetTolerance_ * target || geometry + attribute == 0. ) { return false; }
+  // the videos keep at least a 16th of their bytes, 24 QPs more
+  const double video = ( std::max )( target - ( total - geometry - attribute ), ( geometry + attribute ) / 16. );
+  const double share = params.targetGeometryShare_ > 0. && geometry > 0. && attribute > 0.
+                           ? params.targetGeometryShare_
+                           : geometry / ( geometry + attribute );
+  auto qp = []( int qp, double bytes, double budget ) {
+    if ( bytes == 0. || budget <= 0. ) { return qp; }
+    int delta = static_cast<int>( std::lround( 6. * std::log2( bytes / budget ) ) );
+    return ( std::min )( 51, ( std::max )( 0, qp + delta ) );
+  };
+  const int geometryQP  = qp( params.geometryQP_, geometry, video * share );
+  const int attributeQP = qp( params.attributeQP_, attribute, video * ( 1. - share ) );
+  std::cout << "Rate control: " << stat.getTotal() << " B for " << targetBytes << " B, geometryQP "
+            << params.geometryQP_ << " -> " << geometryQP << ", attributeQP " << params.attributeQP_ << " -> "
+            << attributeQP << std::endl;
+  if ( geometryQP == params.geometryQP_ && attributeQP == params.attributeQP_ ) { return false; }
+  params.geometryQP_  = geometryQP;
+  params.attributeQP_ = attributeQP;
+  return true;
+}
+
+int compressVideo( const std::vector<PCCEncoderParameters>& rateParams,
+                   const PCCMetricsParameters&              metricsParams,
+                   StopwatchUserTime&                       clock,
+                   bool                                     complexity ) {
+  // the parameters of the rates only differ in the rate parameters
+  const PCCEncoderParameters& encoderParams            = rateParams[0];
+  const size_t                startFrameNumber0        = encoderParams.startFrameNumber_;
+  size_t                      endFrameNumber0          = encoderParams.startFrameNumber_ + encoderParams.frameCount_;
+  const size_t                groupOfFramesSize0       = ( std::max )( size_t( 1 ), encoderParams.groupOfFramesSize_ );
+  size_t                      startFrameNumber         = startFrameNumber0;
+  size_t                      reconstructedFrameNumber = encoderParams.startFrameNumber_;
+
+  std::unique_ptr<uint8_t>                  buffer;
+  size_t                                    contextIndex = 0;
+  std::vector<std::unique_ptr<RateEncoder>> rates;
+  for ( const auto& params : rateParams ) {
+    rates.emplace_back( new RateEncoder );
+    auto& rate  = *rates.back();
+    rate.params = params;
+    rate.logger.initilalize( removeFileExtension( params.compressedStreamPath_ ), true );
+    rate.encoder.setLogger( rate.logger );
+    rate.encoder.setMemoryAccounting( rate.memory );
+    rate.encoder.setParameters( params );
+    rate.metrics.setParameters( metricsParams );
+    rate.checksum.setParameters( metricsParams );
+  }
+  // The rates share the packing of the first one with the same packing parameters.
+  std::vector<size_t> packingOf( rates.size() );
+  for ( size_t r = 0; r < rates.size(); r++ ) {
+    packingOf[r] = r;
+    for ( size_t q = 0; q < r && packingOf[r] == r; q++ ) {
+      if ( packingOf[q] == q && rates[r]->params.samePacking( rates[q]->params ) ) { packingOf[r] = q; }
+    }
+    if ( packingOf[r] != r ) {
+      std::cout << "Rate " << r << " reuses the packing of rate " << packingOf[r] << std::endl;
+    }
+  }
 
   // Place to get/set default values for gof metadata enabled flags (in sequence level).
   while ( startFrameNumber < endFrameNumber0 ) {
-    size_t     endFrameNumber = min( startFrameNumber + groupOfFramesSize0, endFrameNumber0 );
-    PCCContext context;
-    context.setBitstreamStat( bitstreamStat );
-    context.addV3CParameterSet( contextIndex );
-    context.setActiveVpsId( contextIndex );
-    PCCGroupOfFrames sources;
-    PCCGroupOfFrames reconstructs;
+    size_t                        endFrameNumber = min( startFrameNumber + groupOfFramesSize0, endFrameNumber0 );
+    PCCGroupOfFrames              sources;
+    std::vector<PCCGroupOfFrames> reconstructs( rates.size() );
     clock.start();
-    if ( !sources.load( encoderParams.uncompressedDataPath_, startFrameNumber, endFrameNumber,
-                        encoderParams.colorTransform_, false, encoderParams.nbThread_ ) ) {
+    if ( encoderParams.frameWindowSize_ > 0 ) {
+      if ( !sources.open( encoderParams.uncompressedDataPath_, startFrameNumber, endFrameNumber,
+                          encoderParams.colorTransform_, encoderParams.frameWindowSize_ ) ) {
+        return -1;
+      }
+    } else if ( !sources.load( encoderParams.uncompressedDataPath_, startFrameNumber, endFrameNumber,
+                               encoderParams.colorTransform_, false, encoderParams.nbThread_ ) ) {
       return -1;
     }
     if ( sources.getFrameCount() < endFrameNumber - startFrameNumber ) {
@@ -1046,12 +1276,67 @@ int compressVideo( const PCCEncoderParameters& encoderParams,
     }
     std::cout << "Compressing " << contextIndex << " frames " << startFrameNumber << " -> " << endFrameNumber << "..."
               << std::endl;
-    int                ret = encoder.encode( sources, context, reconstructs );
-    PCCBitstreamWriter bitstreamWriter;
+    int             ret = 0;
+    PCCSegmentation         segmentation;
+    std::vector<PCCPacking> packings( rates.size() );
+    // with rate control, a second pass of a GOF reuses the segmentation and the packing of its first pass
+    const bool rateControl = std::any_of( rates.begin(), rates.end(), []( const std::unique_ptr<RateEncoder>& rate ) {
+      return rate->params.targetFrameBytes_ > 0;
+    } );
+    const bool shareSegmentation = rates.size() > 1 || rateControl;
+    if ( shareSegmentation && !rates[0]->encoder.segment( sources, segmentation ) ) { ret = -1; }
+    // one pass of rate r over the GOF: its context, and its V3C units appended to the ones of the rate
+    auto encodeRate = [&]( size_t r, PCCContext& context ) {
+      auto& rate = *rates[r];
+      context.setBitstreamStat( rate.bitstreamStat );
+      context.addV3CParameterSet( contextIndex );
+      context.setActiveVpsId( contextIndex );
+      int ret = 0;
+      if ( shareSegmentation ) {
+        auto& packing = packings[packingOf[r]];
+        bool  shared  = rate.params.targetFrameBytes_ > 0 || packingOf[r] != r ||
+                      std::count( packingOf.begin(), packingOf.end(), r ) > 1;
+        ret = rate.encoder.encode( sources, segmentation, context, reconstructs[r], shared ? &packing : nullptr );
+      } else {
+        ret = rate.encoder.encode( sources, context, reconstructs[r] );
+      }
+      PCCBitstreamWriter bitstreamWriter;
 #ifdef BITSTREAM_TRACE
-    bitstreamWriter.setLogger( logger );
+      bitstreamWriter.setLogger( rate.logger );
 #endif
-    ret |= bitstreamWriter.encode( context, ssvu );
+      return ret | bitstreamWriter.encode( context, rate.ssvu );
+    };
+    for ( size_t r = 0; r < rates.size() && ret == 0; r++ ) {
+      auto& rate = *rates[r];
+      if ( rates.size() > 1 ) { std::cout << "Rate " << r << ": " << rate.params.compressedStreamPath_ << std::endl; }
+      const size_t                units = rate.ssvu.getV3CUnitCount();
+      std::unique_ptr<PCCContext> context( new PCCContext );
+      ret = encodeRate( r, *context );
+      PCCEncoderParameters params = rate.params;
+      if ( ret == 0 && params.targetFrameBytes_ > 0 &&
+           rateControlQPs( rate.bitstreamStat, params.targetFrameBytes_ * sources.getFrameCount(), params ) ) {
+        rate.bitstreamStat.removeGOF();
+        rate.ssvu.getV3CUnit().resize( units );
+        reconstructs[r].clear();
+        rate.encoder.setParameters( params );
+        context.reset( new PCCContext );
+        ret = encodeRate( r, *context );
+        rate.encoder.setParameters( rate.params );
+        if ( ret == 0 ) {
+          std::cout << "Rate control: " << rate.bitstreamStat.getTotal() << " B in the second pass" << std::endl;
+        }
+      }
+      for ( size_t i = 0; i < context->size(); i++ ) {
+        auto& atlasFrame = ( *context )[i];
+        for ( size_t t = 0; t < atlasFrame.getNumTilesInAtlasFrame(); t++ ) {
+          rate.patches += atlasFrame.getTile( t ).getPatches().size();
+        }
+        rate.atlasWidth  = ( std::max )( rate.atlasWidth, atlasFrame.getAtlasFrameWidth() );
+        rate.atlasHeight = ( std::max )( rate.atlasHeight, atlasFrame.getAtlasFrameHeight() );
+      }
+      rate.frames += reconstructs[r].getFrameCount();
+      for ( auto& frame : reconstructs[r] ) { rate.points += frame.getPointCount(); }
+    }
     clock.stop();
     PCCGroupOfFrames normals;
     if ( metricsParams.computeMetrics_ ) {
@@ -1062,18 +1347,22 @@ int compressVideo( const PCCEncoderParameters& encoderParams,
           bRunMetric = false;
         }
       }
-      if ( bRunMetric ) { metrics.compute( sources, reconstructs, normals ); }
+      if ( bRunMetric ) {
+        for ( size_t r = 0; r < rates.size(); r++ ) { rates[r]->metrics.compute( sources, reconstructs[r], normals ); }
+      }
     }
     if ( metricsParams.computeChecksum_ ) {
-      if ( encoderParams.rawPointsPatch_ && encoderParams.reconstructRawType_ != 0 ) {
-        checksum.computeSource( sources );
-        checksum.computeReordered( reconstructs );
+      for ( size_t r = 0; r < rates.size(); r++ ) {
+        if ( encoderParams.rawPointsPatch_ && encoderParams.reconstructRawType_ != 0 ) {
+          rates[r]->checksum.computeSource( sources );
+          rates[r]->checksum.computeReordered( reconstructs[r] );
+        }
+        rates[r]->checksum.computeReconstructed( reconstructs[r] );
       }
-      checksum.computeReconstructed( reconstructs );
     }
     if ( ret != 0 ) { return ret; }
     if ( !encoderParams.reconstructedDataPath_.empty() ) {
-      reconstructs.write( encoderParams.reconstructedDataPath_, reconstructedFrameNumber );
+      reconstructs[0].write( encoderParams.reconstructedDataPath_, reconstructedFrameNumber );
     }
     normals.clear();
     sources.clear();
@@ -1082,46 +1371,343 @@ int compressVideo( const PCCEncoderParameters& encoderParams,
     contextIndex++;
   }
 
-  PCCBitstream bitstream;
+  bool checksumEqual = true;
+  for ( auto& rate : rates ) {
+    PCCBitstream bitstream;
 #if defined( BITSTREAM_TRACE ) || defined( CONFORMANCE_TRACE )
-  bitstream.setLogger( logger );
-  bitstream.setTrace( true );
+    bitstream.setLogger( rate->logger );
+    bitstream.setTrace( true );
 #endif
 
-  bitstreamStat.setHeader( bitstream.size() );
-  PCCBitstreamWriter bitstreamWriter;
-  size_t headerSize = bitstreamWriter.write( ssvu, bitstream, encoderParams.forcedSsvhUnitSizePrecisionBytes_ );
-  bitstreamStat.incrHeader( headerSize );
-  bitstream.write( encoderParams.compressedStreamPath_ );
-  bitstreamStat.trace();
-  std::cout << "Total bitstream size " << bitstream.size() << " B" << std::endl;
-  bitstream.computeMD5();
+    rate->bitstreamStat.setHeader( bitstream.size() );
+    PCCBitstreamWriter bitstreamWriter;
+    size_t headerSize = bitstreamWriter.write( rate->ssvu, bitstream, encoderParams.forcedSsvhUnitSizePrecisionBytes_ );
+    rate->bitstreamStat.incrHeader( headerSize );
+    bitstream.write( rate->params.compressedStreamPath_ );
+    rate->bitstreamStat.trace();
+    rate->memory.trace();
+    std::cout << "Total bitstream size " << bitstream.size() << " B" << std::endl;
+    bitstream.computeMD5();
 
-  if ( metricsParams.computeMetrics_ ) { metrics.display(); }
-  bool checksumEqual = true;
-  if ( metricsParams.computeChecksum_ ) {
-    if ( encoderParams.rawPointsPatch_ && encoderParams.reconstructRawType_ != 0 ) {
-      checksumEqual = checksum.compareSrcRec();
+    if ( metricsParams.computeMetrics_ ) { rate->metrics.display(); }
+    if ( metricsParams.computeChecksum_ ) {
+      if ( encoderParams.rawPointsPatch_ && encoderParams.reconstructRawType_ != 0 ) {
+        checksumEqual = rate->checksum.compareSrcRec() && checksumEqual;
+      }
+      rate->checksum.write( rate->params.compressedStreamPath_ );
     }
-    checksum.write( encoderParams.compressedStreamPath_ );
+    if ( complexity ) { writeComplexity( *rate ); }
   }
   return checksumEqual ? 0 : -1;
 }
 
+// Segment mode: the frames are split in segments of segmentFrameCount frames, encoded as separate bitstreams by
+// child encoder processes (the in-process video encoders are not reentrant). The workers take the segments from a
+// shared queue; a segment is claimed by creating "<bitstream>.claim", so the encoders of several machines can share
+// the work through a common file system. Segments whose bitstreams all exist already are skipped.
+static std::string quoteArgument( const std::string& arg ) { return "\"" + arg + "\""; }
+
+static std::string segmentPath( const std::string& pattern, size_t segment ) {
+  std::vector<char> path( pattern.size() + 32 );
+  snprintf( path.data(), path.size(), pattern.c_str(), static_cast<int>( segment ) );
+  return path.data();
+}
+
+static bool fileExists( const std::string& path ) {
+  std::ifstream file( path.c_str(), std::ios::binary );
+  return file.good();
+}
+
+static int64_t fileSize( const std::string& path ) {
+  std::ifstream file( path.c_str(), std::ios::binary | std::ios::ate );
+  return file ? static_cast<int64_t>( file.tellg() ) : -1;
+}
+
+static int runSegment( const std::string&              command,
+                       const std::vector<std::string>& paths,
+                       bool                            multiRate,
+                       size_t                          segment,
+                       size_t                          startFrameNumber,
+                       size_t                          frameCount ) {
+  std::string segmentCommand = command + " --startFrameNumber=" + std::to_string( startFrameNumber ) +
+                               " --frameCount=" + std::to_string( frameCount );
+  if ( multiRate ) {
+    std::string list;
+    for ( auto& path : paths ) { list += ( list.empty() ? "" : "," ) + path; }
+    segmentCommand += " " + quoteArgument( "--rateCompressedStreamPaths=" + list );
+  } else {
+    segmentCommand += " " + quoteArgument( "--compressedStreamPath=" + paths[0] );
+  }
+  segmentCommand += " > " + quoteArgument( removeFileExtension( paths[0] ) + ".log" ) + " 2>&1";
+  int ret = pcc::system( segmentCommand.c_str() );
+  if ( ret != 0 ) {
+    std::cerr << "Segment " << segment << " failed (" << ret << "), see " << removeFileExtension( paths[0] ) << ".log"
+              << std::endl;
+  }
+  return ret;
+}
+
+// Live segment mode: a capture writes the frames as PLY files of uncompressedDataPath while the encoder runs, each
+// one moved into place once complete (written under another name, then renamed). A watcher polls for the next frame
+// and the jobs each wait for the frames of the next segment, so a segment starts the moment its last frame arrives,
+// next to the encodes of the segments before it. The segments are published in order: their rows are appended to
+// segmentSizesPath and segmentLivePublishCommand runs, e.g. to update a dynamic MPD. A failed segment ends the
+// stream, the segments after it could not be addressed.
+static int encodeLiveSegments( const PCCEncoderParameters&     encoderParams,
+                               const AppOptions&               appOptions,
+                               const std::string&              command,
+                               const std::vector<std::string>& patterns,
+                               bool                            multiRate,
+                               size_t                          jobs ) {
+  using Clock                    = std::chrono::steady_clock;
+  const size_t segmentFrameCount = appOptions.segmentFrameCount_;
+  const size_t maxFrameCount     = encoderParams.frameCount_ > 0 ? encoderParams.frameCount_ : SIZE_MAX;
+  const auto   timeout           = std::chrono::duration<double>( appOptions.segmentLiveTimeout_ );
+  struct Encoded {
+    int               ret;
+    size_t            frameCount;
+    Clock::time_point ready;  // when its last frame arrived
+  };
+  std::mutex                mutex;
+  std::condition_variable   changed;
+  size_t                    available  = 0;      // frames in place, from startFrameNumber on
+  bool                      ended      = false;  // no frame will come any more
+  bool                      stopped    = false;  // a segment failed
+  size_t                    next       = 0;
+  size_t                    published  = 0;
+  bool                      publishing = false;
+  std::map<size_t, Encoded> encoded;             // waiting to be published
+  std::atomic<size_t>       failed( 0 );
+
+  std::ofstream sizes;
+  if ( !appOptions.segmentSizesPath_.empty() ) {
+    sizes.open( appOptions.segmentSizesPath_.c_str() );
+    sizes << "segment,startFrameNumber,frameCount,stream,path,bytes" << std::endl;
+  }
+
+  std::thread watcher( [&] {
+    auto last = Clock::now();
+    for ( size_t frame = 0; frame < maxFrameCount; ) {
+      if ( fileExists( segmentPath( encoderParams.uncompressedDataPath_, encoderParams.startFrameNumber_ + frame ) ) ) {
+        std::lock_guard<std::mutex> lock( mutex );
+        available = ++frame;
+        last      = Clock::now();
+        changed.notify_all();
+        continue;
+      }
+      {
+        std::lock_guard<std::mutex> lock( mutex );
+        if ( ended || Clock::now() - last > timeout ) { break; }
+      }
+      std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+    }
+    std::lock_guard<std::mutex> lock( mutex );
+    ended = true;
+    changed.notify_all();
+  } );
+
+  // publishes the encoded segments that are next in order; called with the lock held, releases it meanwhile
+  auto publish = [&]( std::unique_lock<std::mutex>& lock ) {
+    if ( publishing ) { return; }
+    publishing = true;
+    for ( auto it = encoded.find( published ); it != encoded.end(); it = encoded.find( published ) ) {
+      const size_t  segment = published;
+      const Encoded done    = it->second;
+      encoded.erase( it );
+      if ( done.ret != 0 ) {
+        ended   = true;
+        stopped = true;
+        changed.notify_all();
+        break;
+      }
+      lock.unlock();
+      for ( size_t i = 0; i < patterns.size() && sizes.is_open(); i++ ) {
+        std::string path = segmentPath( patterns[i], segment );
+        sizes << segment << "," << encoderParams.startFrameNumber_ + segment * segmentFrameCount << ","
+              << done.frameCount << "," << i << "," << path << "," << fileSize( path ) << std::endl;
+      }
+      if ( !appOptions.segmentLivePublishCommand_.empty() ) {
+        std::string publishCommand = segmentPath( appOptions.segmentLivePublishCommand_, segment );
+        int         ret            = pcc::system( publishCommand.c_str() );
+        if ( ret != 0 ) { std::cerr << "Publishing segment " << segment << " failed (" << ret << ")" << std::endl; }
+      }
+      std::chrono::duration<double> latency = Clock::now() - done.ready;
+      std::cout << "Segment " << segment << " published " << latency.count() << " s after its last frame"
+                << std::endl;
+      lock.lock();
+      published++;
+    }
+    publishing = false;
+  };
+
+  std::cout << "Encoding live segments of " << segmentFrameCount << " frames with " << jobs << " jobs" << std::endl;
+  std::vector<std::thread> workers;
+  for ( size_t j = 0; j < jobs; j++ ) {
+    workers.emplace_back( [&] {
+      std::unique_lock<std::mutex> lock( mutex );
+      while ( true ) {
+        const size_t segment = next++;
+        const size_t first   = segment * segmentFrameCount;
+        if ( first >= maxFrameCount ) { return; }
+        size_t frameCount = ( std::min )( segmentFrameCount, maxFrameCount - first );
+        changed.wait( lock, [&] { return ended || available >= first + frameCount; } );
+        if ( stopped ) { return; }
+        if ( available < first + frameCount ) {
+          // the stream ended within or before the segment
+          frameCount = available > first ? available - first : 0;
+          if ( frameCount == 0 ) { return; }
+        }
+        const auto ready = Clock::now();
+        lock.unlock();
+
+        std::vector<std::string> paths;
+        for ( auto& pattern : patterns ) { paths.push_back( segmentPath( pattern, segment ) ); }
+        int ret = runSegment( command, paths, multiRate, segment, encoderParams.startFrameNumber_ + first,
+                              frameCount );
+        if ( ret != 0 ) { failed++; }
+
+        lock.lock();
+        encoded[segment] = {ret, frameCount, ready};
+        publish( lock );
+      }
+    } );
+  }
+  for ( auto& worker : workers ) { worker.join(); }
+  {
+    std::lock_guard<std::mutex> lock( mutex );
+    ended = true;
+  }
+  watcher.join();
+  std::cout << "Published " << published << " segments" << std::endl;
+  return failed == 0 ? 0 : -1;
+}
+
+int encodeSegments( int argc, char* argv[], const PCCEncoderParameters& encoderParams, const AppOptions& appOptions ) {
+  const size_t segmentFrameCount = appOptions.segmentFrameCount_;
+  const size_t segmentCount      = ( encoderParams.frameCount_ + segmentFrameCount - 1 ) / segmentFrameCount;
+  const size_t jobs              = ( std::max )( size_t( 1 ), appOptions.segmentJobs_ );
+  auto         patterns          = splitList( appOptions.rateCompressedStreamPaths_ );
+  const bool   multiRate         = !patterns.empty();
+  if ( !multiRate ) { patterns.push_back( encoderParams.compressedStreamPath_ ); }
+  for ( auto& pattern : patterns ) {
+    if ( pattern.find( '%' ) == std::string::npos ) {
+      std::cerr << "segmentFrameCount needs a printf pattern of the segment index in " << pattern << std::endl;
+      return -1;
+    }
+  }
+  // the cores are shared by the jobs unless nbThread is set
+  size_t nbThread = encoderParams.nbThread_;
+  if ( nbThread == 0 ) { nbThread = ( std::max )( 1U, std::thread::hardware_concurrency() / unsigned( jobs ) ); }
+  std::string command = quoteArgument( argv[0] );
+  for ( int i = 1; i < argc; i++ ) { command += " " + quoteArgument( argv[i] ); }
+  command += " --segmentFrameCount=0 --nbThread=" + std::to_string( nbThread );
+  if ( appOptions.segmentLive_ ) {
+    return encodeLiveSegments( encoderParams, appOptions, command, patterns, multiRate, jobs );
+  }
+
+  std::cout << "Encoding " << segmentCount << " segments of " << segmentFrameCount << " frames with " << jobs
+            << " jobs of " << nbThread << " threads" << std::endl;
+  std::atomic<size_t>      next( 0 );
+  std::atomic<size_t>      failed( 0 );
+  std::vector<std::thread> workers;
+  for ( size_t j = 0; j < jobs; j++ ) {
+    workers.emplace_back( [&] {
+      for ( size_t segment = next++; segment < segmentCount; segment = next++ ) {
+        std::vector<std::string> paths;
+        bool                     done = true;
+        for ( auto& pattern : patterns ) {
+          paths.push_back( segmentPath( pattern, segment ) );
+          done = done && fileExists( paths.back() );
+        }
+        if ( done ) { continue; }
+        std::string claim = paths[0] + ".claim";
+        FILE*       file  = fopen( claim.c_str(), "wx" );
+        if ( file == nullptr ) { continue; }
+        fclose( file );
+
+        const size_t startFrameNumber = encoderParams.startFrameNumber_ + segment * segmentFrameCount;
+        const size_t frameCount =
+            ( std::min )( segmentFrameCount, encoderParams.frameCount_ - segment * segmentFrameCount );
+        if ( runSegment( command, paths, multiRate, segment, startFrameNumber, frameCount ) != 0 ) { failed++; }
+        remove( claim.c_str() );
+      }
+    } );
+  }
+  for ( auto& worker : workers ) { worker.join(); }
+
+  // sizes of all the segments, including the ones encoded by other machines
+  std::ofstream sizes;
+  if ( !appOptions.segmentSizesPath_.empty() ) {
+    sizes.open( appOptions.segmentSizesPath_.c_str() );
+    sizes << "segment,startFrameNumber,frameCount,stream,path,bytes\n";
+  }
+  std::vector<int64_t> maxSize( patterns.size(), 0 );
+  for ( size_t segment = 0; segment < segmentCount; segment++ ) {
+    const size_t startFrameNumber = encoderParams.startFrameNumber_ + segment * segmentFrameCount;
+    const size_t frameCount =
+        ( std::min )( segmentFrameCount, encoderParams.frameCount_ - segment * segmentFrameCount );
+    for ( size_t i = 0; i < patterns.size(); i++ ) {
+      std::string path = segmentPath( patterns[i], segment );
+      int64_t     size = fileSize( path );
+      maxSize[i]       = ( std::max )( maxSize[i], size );
+      if ( sizes.is_open() ) {
+        sizes << segment << "," << startFrameNumber << "," << frameCount << "," << i << "," << path << "," << size
+              << "\n";
+      }
+    }
+  }
+  for ( size_t i = 0; i < patterns.size(); i++ ) {
+    std::cout << "Largest segment of " << patterns[i] << ": " << maxSize[i] << " B" << std::endl;
+  }
+  return failed == 0 ? 0 : -1;
+}
+
 int main( int argc, char* argv[] ) {
   std::cout << "PccAppEncoder v" << TMC2_VERSION_MAJOR << "." << TMC2_VERSION_MINOR << std::endl << std::endl;
 
   PCCEncoderParameters encoderParams;
   PCCMetricsParameters metricsParams;
-  if ( !parseParameters( argc, argv, encoderParams, metricsParams ) ) { return -1; }
-  if ( encoderParams.nbThread_ > 0 ) { tbb::task_scheduler_init init( static_cast<int>( encoderParams.nbThread_ ) ); }
+  AppOptions           appOptions;
+  if ( !parseParameters( argc, argv, encoderParams, metricsParams, appOptions ) ) { return -1; }
+  if ( appOptions.segmentFrameCount_ > 0 ) { return encodeSegments( argc, argv, encoderParams, appOptions ); }
+
+  // multi-rate: the parameters of each rate are the command line followed by its rate configuration
+  std::vector<PCCEncoderParameters> rateParams;
+  auto                              configs = splitList( appOptions.rateConfigs_ );
+  auto                              paths   = splitList( appOptions.rateCompressedStreamPaths_ );
+  if ( configs.size() != paths.size() ) {
+    std::cerr << "rateConfigs and rateCompressedStreamPaths must have the same number of entries \n";
+    return -1;
+  }
+  if ( !configs.empty() && !encoderParams.reconstructedDataPath_.empty() ) {
+    std::cerr << "reconstructedDataPath is not supported with rateConfigs \n";
+    return -1;
+  }
+  for ( size_t i = 0; i < configs.size(); i++ ) {
+    std::vector<std::string> args( argv, argv + argc );
+    for ( auto& config : splitList( configs[i], '+' ) ) { args.push_back( "--config=" + config ); }
+    args.push_back( "--compressedStreamPath=" + paths[i] );
+    std::vector<char*> rateArgv;
+    for ( auto& arg : args ) { rateArgv.push_back( &arg[0] ); }
+    PCCEncoderParameters params;
+    PCCMetricsParameters rateMetricsParams;
+    AppOptions           rateOptions;
+    if ( !parseParameters( static_cast<int>( rateArgv.size() ), rateArgv.data(), params, rateMetricsParams,
+                           rateOptions ) ) {
+      return -1;
+    }
+    rateParams.push_back( params );
+  }
+  if ( rateParams.empty() ) { rateParams.push_back( encoderParams ); }
+  tbb::task_scheduler_init init( encoderParams.nbThread_ > 0 ? static_cast<int>( encoderParams.nbThread_ )
+                                                             : tbb::task_scheduler_init::automatic );
 
   // Timers to count elapsed wall/user time
   pcc::chrono::Stopwatch<std::chrono::steady_clock> clockWall;
   pcc::chrono::StopwatchUserTime                    clockUser;
 
   clockWall.start();
-  int ret = compressVideo( encoderParams, metricsParams, clockUser );
+  int ret = compressVideo( rateParams, metricsParams, clockUser, appOptions.writeComplexity_ );
   clockWall.stop();
 
   using namespace std::chrono;
@@ -1133,5 +1719,6 @@ int main( int argc, char* argv[] ) {
   std::cout << "Processing time (user.self): " << ( ret == 0 ? totalUserSelf / 1000.0 : -1 ) << " s\n";
   std::cout << "Processing time (user.children): " << ( ret == 0 ? totalUserChild / 1000.0 : -1 ) << " s\n";
   std::cout << "Peak memory: " << getPeakMemory() << " KB\n";
+  PCC_PROFILE_REPORT( stdout );
   return ret;
 }
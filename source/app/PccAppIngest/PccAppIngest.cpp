@@ -0,0 +1,217 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "PCCCommon.h"
+#include "PCCPointSet.h"
+#include "PCCFrameCache.h"
+#include <program_options_lite.h>
+#include <tbb/tbb.h>
+#include <thread>
+
+using namespace std;
+using namespace pcc;
+
+// Reads a sequence of PLY files once, keeps one frame out of frameStep and voxelizes it, and writes the frames to a
+// frame cache (PCCFrameCache) that the encoders read as their uncompressedDataPath instead of the PLY files.
+struct IngestParameters {
+  std::string uncompressedDataPath_;
+  std::string cachePath_;
+  size_t      startFrameNumber_      = 0;
+  size_t      frameCount_            = 0;
+  size_t      frameStep_             = 1;
+  int64_t     cacheStartFrameNumber_ = -1;
+  size_t      voxelDimension_        = 1;
+  size_t      nbThread_              = 0;
+};
+
+//---------------------------------------------------------------------------
+// :: Command line / config parsing
+
+bool parseParameters( int argc, char* argv[], IngestParameters& params ) {
+  namespace po    = df::program_options_lite;
+  bool print_help = false;
+
+  // clang-format off
+  po::Options opts;
+  opts.addOptions()
+    ( "help", print_help, false,"This help text" )
+    ( "c,config", po::parseConfigFile, "Configuration file name" )
+    // i/o
+    ( "uncompressedDataPath",
+      params.uncompressedDataPath_,
+      params.uncompressedDataPath_,
+      "Input point clouds. Multi-frame sequences may be represented by %04i" )
+    ( "cachePath",
+      params.cachePath_,
+      params.cachePath_,
+      "Output frame cache, given as uncompressedDataPath to the encoders" )
+    // sequence configuration
+    ( "startFrameNumber",
+      params.startFrameNumber_,
+      params.startFrameNumber_,
+      "First frame number of the input sequence" )
+    ( "frameCount",
+      params.frameCount_,
+      params.frameCount_,
+      "Number of input frames read (0: up to the first missing file)" )
+    ( "frameStep",
+      params.frameStep_,
+      params.frameStep_,
+      "One input frame out of frameStep is kept, e.g. 3 for 10 fps out of 30 fps" )
+    ( "cacheStartFrameNumber",
+      params.cacheStartFrameNumber_,
+      params.cacheStartFrameNumber_,
+      "Frame number of the first cached frame (-1: startFrameNumber)" )
+    ( "voxelDimension",
+      params.voxelDimension_,
+      params.voxelDimension_,
+      "Positions divided by voxelDimension, the points of a voxel merged with their average color (1: as read)" )
+    // etc
+    ( "nbThread",
+      params.nbThread_,
+      params.nbThread_,
+      "Number of thread used for parallel processing" );
+  // clang-format on
+  po::setDefaults( opts );
+  po::ErrorReporter        err;
+  const list<const char*>& argv_unhandled = po::scanArgv( opts, argc, (const char**)argv, err );
+  for ( const auto arg : argv_unhandled ) { printf( "Unhandled argument ignored: %s \n", arg ); }
+
+  if ( argc == 1 || print_help ) {
+    po::doHelp( std::cout, opts, 78 );
+    return false;
+  }
+  if ( params.cacheStartFrameNumber_ < 0 ) { params.cacheStartFrameNumber_ = int64_t( params.startFrameNumber_ ); }
+  if ( params.uncompressedDataPath_.empty() || params.cachePath_.empty() ) {
+    err.error( "Parameters" ) << "uncompressedDataPath and cachePath must be set\n";
+  }
+  if ( params.frameStep_ == 0 || params.voxelDimension_ == 0 ) {
+    err.error( "Parameters" ) << "frameStep and voxelDimension must be at least 1\n";
+  }
+  if ( err.is_errored ) { return false; }
+
+  printf( "Ingest parameters \n" );
+  printf( "    uncompressedDataPath  = %s \n", params.uncompressedDataPath_.c_str() );
+  printf( "    cachePath             = %s \n", params.cachePath_.c_str() );
+  printf( "    startFrameNumber      = %zu \n", params.startFrameNumber_ );
+  printf( "    frameCount            = %zu \n", params.frameCount_ );
+  printf( "    frameStep             = %zu \n", params.frameStep_ );
+  printf( "    cacheStartFrameNumber = %lld \n", static_cast<long long>( params.cacheStartFrameNumber_ ) );
+  printf( "    voxelDimension        = %zu \n", params.voxelDimension_ );
+  printf( "    nbThread              = %zu \n", params.nbThread_ );
+  return true;
+}
+
+static std::string framePath( const std::string& pattern, size_t frameNumber ) {
+  char fileName[4096];
+  snprintf( fileName, sizeof( fileName ), pattern.c_str(), frameNumber );
+  return fileName;
+}
+
+static bool fileExists( const std::string& path ) {
+  FILE* file = fopen( path.c_str(), "rb" );
+  if ( file == nullptr ) { return false; }
+  fclose( file );
+  return true;
+}
+
+static void voxelize( PCCPointSet3& pointSet, const size_t voxelDimension ) {
+  if ( voxelDimension <= 1 ) { return; }
+  for ( auto& position : pointSet.getPositions() ) {
+    for ( size_t k = 0; k < 3; k++ ) { position[k] = static_cast<int16_t>( position[k] / int( voxelDimension ) ); }
+  }
+  PCCPointSet3 voxelized;
+  if ( pointSet.hasColors() ) { voxelized.addColors(); }
+  pointSet.removeDuplicate( voxelized, 2 );
+  pointSet = std::move( voxelized );
+}
+
+int ingest( const IngestParameters& params ) {
+  // the kept frames, up to the first missing file
+  std::vector<size_t> frameNumbers;
+  const size_t        endFrameNumber =
+      params.frameCount_ > 0 ? params.startFrameNumber_ + params.frameCount_ : ( std::numeric_limits<size_t>::max )();
+  for ( size_t frameNumber = params.startFrameNumber_; frameNumber < endFrameNumber;
+        frameNumber += params.frameStep_ ) {
+    if ( !fileExists( framePath( params.uncompressedDataPath_, frameNumber ) ) ) { break; }
+    frameNumbers.push_back( frameNumber );
+  }
+  if ( frameNumbers.empty() ) {
+    std::cerr << "No input frame " << framePath( params.uncompressedDataPath_, params.startFrameNumber_ ) << std::endl;
+    return -1;
+  }
+  std::cout << "Caching " << frameNumbers.size() << " frames as " << params.cacheStartFrameNumber_ << " -> "
+            << params.cacheStartFrameNumber_ + frameNumbers.size() - 1 << " in " << params.cachePath_ << std::endl;
+
+  PCCFrameCacheWriter writer;
+  if ( !writer.open( params.cachePath_, frameNumbers.size(), size_t( params.cacheStartFrameNumber_ ) ) ) {
+    std::cerr << "Error: can't create " << params.cachePath_ << std::endl;
+    return -1;
+  }
+  // the frames are read and voxelized in batches, one per thread, and appended in order
+  const size_t batchSize = params.nbThread_ > 0 ? params.nbThread_ : std::thread::hardware_concurrency();
+  std::vector<PCCPointSet3> batch;
+  bool                      ret = true;
+  for ( size_t first = 0; first < frameNumbers.size() && ret; first += batch.size() ) {
+    batch.assign( ( std::min )( ( std::max )( batchSize, size_t( 1 ) ), frameNumbers.size() - first ),
+                  PCCPointSet3() );
+    std::vector<uint8_t> read( batch.size(), 0 );
+    tbb::parallel_for( size_t( 0 ), batch.size(), [&]( const size_t i ) {
+      const std::string fileName = framePath( params.uncompressedDataPath_, frameNumbers[first + i] );
+      if ( batch[i].read( fileName ) ) {
+        voxelize( batch[i], params.voxelDimension_ );
+        read[i] = 1;
+      } else {
+        std::cerr << "Error: can't read " << fileName << std::endl;
+      }
+    } );
+    for ( size_t i = 0; i < batch.size() && ret; i++ ) { ret = read[i] != 0 && writer.append( batch[i] ); }
+  }
+  if ( !writer.close() || !ret ) {
+    std::cerr << "Error: can't write " << params.cachePath_ << std::endl;
+    remove( params.cachePath_.c_str() );
+    return -1;
+  }
+  return 0;
+}
+
+int main( int argc, char* argv[] ) {
+  std::cout << "PccAppIngest v" << TMC2_VERSION_MAJOR << "." << TMC2_VERSION_MINOR << std::endl << std::endl;
+  IngestParameters params;
+  if ( !parseParameters( argc, argv, params ) ) { return -1; }
+  tbb::task_scheduler_init init( params.nbThread_ > 0 ? static_cast<int>( params.nbThread_ )
+                                                      : tbb::task_scheduler_init::automatic );
+  return ingest( params );
+}
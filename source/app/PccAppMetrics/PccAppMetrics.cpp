@@ -40,6 +40,8 @@
 #include "PCCMetricsParameters.h"
 #include <program_options_lite.h>
 #include <tbb/tbb.h>
+#include <fstream>
+#include <memory>
 
 using namespace std;
 using namespace pcc;
@@ -89,6 +91,10 @@ bool parseParameters( int argc, char* argv[], PCCMetricsParameters& metricsParam
       metricsParams.normalDataPath_,
       metricsParams.normalDataPath_,
       "Input pointcloud to encode. Multi-frame sequences may be represented by %04i" ) 
+    ( "csvPath", 
+      metricsParams.csvPath_,
+      metricsParams.csvPath_,
+      "Output per-frame metrics as CSV, one row written as each frame completes" ) 
     ( "resolution", 
       metricsParams.resolution_, 
       metricsParams.resolution_,
@@ -131,28 +137,77 @@ bool parseParameters( int argc, char* argv[], PCCMetricsParameters& metricsParam
   return true;
 }
 
+// One frame pair on its way through the pipeline of computeMetrics().
+struct MetricsFrame {
+  size_t           frameIndex;
+  PCCGroupOfFrames sources;
+  PCCGroupOfFrames reconstructs;
+  PCCGroupOfFrames normals;
+  PCCMetrics       metrics;
+};
+
+// The frames go through a pipeline: they are read in order, their metrics (kd-tree and nearest neighbor queries)
+// are computed in parallel, and the results are reduced in order, written as CSV rows and kept for the display.
+// Only a few frames more than there are threads are in flight at once, so the memory does not grow with the
+// number of frames.
 int computeMetrics( const PCCMetricsParameters& metricsParams, StopwatchUserTime& clock ) {
   PCCMetrics metrics;
   metrics.setParameters( metricsParams );
-  for ( size_t frameIndex = metricsParams.startFrameNumber_;
-        frameIndex < metricsParams.startFrameNumber_ + metricsParams.frameCount_; frameIndex++ ) {
-    PCCGroupOfFrames sources;
-    PCCGroupOfFrames reconstructs;
-    PCCGroupOfFrames normals;
-    if ( !sources.load( metricsParams.uncompressedDataPath_, frameIndex, frameIndex + 1, COLOR_TRANSFORM_NONE ) ) {
-      return -1;
-    }
-    if ( !reconstructs.load( metricsParams.reconstructedDataPath_, frameIndex, frameIndex + 1,
-                             COLOR_TRANSFORM_NONE ) ) {
+  std::ofstream csv;
+  if ( !metricsParams.csvPath_.empty() ) {
+    csv.open( metricsParams.csvPath_ );
+    if ( !csv.is_open() ) {
+      printf( "Error: can't open %s \n", metricsParams.csvPath_.c_str() );
       return -1;
     }
-    if ( !metricsParams.normalDataPath_.empty() ) {
-      if ( !normals.load( metricsParams.normalDataPath_, frameIndex, frameIndex + 1, COLOR_TRANSFORM_NONE, true ) ) {
-        return -1;
-      }
-    }
-    metrics.compute( sources, reconstructs, normals );
+    metrics.writeCsvHeader( csv );
   }
+  const size_t threadCount = metricsParams.nbThread_ > 0 ? metricsParams.nbThread_
+                                                           : size_t( tbb::task_scheduler_init::default_num_threads() );
+  const size_t endFrame   = metricsParams.startFrameNumber_ + metricsParams.frameCount_;
+  size_t       frameIndex = metricsParams.startFrameNumber_;
+  bool         failed     = false;
+  tbb::parallel_pipeline(
+      2 * threadCount,
+      tbb::make_filter<void, MetricsFrame*>(
+          tbb::filter::serial_in_order,
+          [&]( tbb::flow_control& control ) -> MetricsFrame* {
+            if ( failed || frameIndex >= endFrame ) {
+              control.stop();
+              return nullptr;
+            }
+            std::unique_ptr<MetricsFrame> frame( new MetricsFrame );
+            frame->frameIndex = frameIndex++;
+            if ( !frame->sources.load( metricsParams.uncompressedDataPath_, frame->frameIndex, frame->frameIndex + 1,
+                                       COLOR_TRANSFORM_NONE ) ||
+                 !frame->reconstructs.load( metricsParams.reconstructedDataPath_, frame->frameIndex,
+                                            frame->frameIndex + 1, COLOR_TRANSFORM_NONE ) ||
+                 ( !metricsParams.normalDataPath_.empty() &&
+                   !frame->normals.load( metricsParams.normalDataPath_, frame->frameIndex, frame->frameIndex + 1,
+                                         COLOR_TRANSFORM_NONE, true ) ) ) {
+              failed = true;
+              control.stop();
+              return nullptr;
+            }
+            return frame.release();
+          } ) &
+          tbb::make_filter<MetricsFrame*, MetricsFrame*>( tbb::filter::parallel,
+                                                          [&]( MetricsFrame* frame ) {
+                                                            frame->metrics.setParameters( metricsParams );
+                                                            frame->metrics.compute( frame->sources,
+                                                                                    frame->reconstructs,
+                                                                                    frame->normals );
+                                                            return frame;
+                                                          } ) &
+          tbb::make_filter<MetricsFrame*, void>( tbb::filter::serial_in_order, [&]( MetricsFrame* frame ) {
+            std::unique_ptr<MetricsFrame> done( frame );
+            if ( csv.is_open() ) {
+              done->metrics.writeCsv( csv, done->frameIndex );
+              csv.flush();
+            }
+            metrics.merge( done->metrics );
+          } ) );
+  if ( failed ) { return -1; }
   metrics.display();
   return 0;
 }
@@ -162,7 +217,8 @@ int main( int argc, char* argv[] ) {
 
   PCCMetricsParameters metricsParams;
   if ( !parseParameters( argc, argv, metricsParams ) ) { return -1; }
-  if ( metricsParams.nbThread_ > 0 ) { tbb::task_scheduler_init init( static_cast<int>( metricsParams.nbThread_ ) ); }
+  tbb::task_scheduler_init init( metricsParams.nbThread_ > 0 ? static_cast<int>( metricsParams.nbThread_ )
+                                                             : tbb::task_scheduler_init::automatic );
 
   // Timers to count elapsed wall/user time
   pcc::chrono::Stopwatch<std::chrono::steady_clock> clockWall;
@@ -181,4 +237,4 @@ int main( int argc, char* argv[] ) {
   std::cout << "metric:Processing time (user.self): " << totalUserSelf / 1000.0 << " s\n";
   std::cout << "metric:Processing time (user.children): " << totalUserChild / 1000.0 << " s\n";
   return ret;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -38,6 +38,7 @@
 #include "PCCKdTree.h"
 #include "PCCGroupOfFrames.h"
 #include "PCCNormalsGenerator.h"
+#include "PCCExecutionContext.h"
 #include <program_options_lite.h>
 #include <tbb/tbb.h>
 
@@ -66,6 +67,7 @@ bool parseParameters( int                             argc,
                       size_t&                         startFrame,
                       size_t&                         numFrames,
                       size_t&                         numThread,
+                      bool&                           temporal,
                       PCCNormalsGenerator3Parameters& normalParams ) {
   namespace po    = df::program_options_lite;
   bool print_help = false;
@@ -205,6 +207,18 @@ bool parseParameters( int                             argc,
       normalParams.storeCentroids_,
       normalParams.storeCentroids_,
       "Store Centroids (0)false/(1)true" )
+    ( "temporal",
+      temporal,
+      temporal,
+      "Seed the normals of each frame from those of the previous frame (0)false/(1)true" )
+    ( "maxFitErrorTemporal",
+      normalParams.maxFitErrorTemporal_,
+      normalParams.maxFitErrorTemporal_,
+      "Largest fraction of the neighborhood variance off the plane of a seeded normal (default:0.005)" )
+    ( "maxDist2Temporal",
+      normalParams.maxDist2Temporal_,
+      normalParams.maxDist2Temporal_,
+      "Largest squared distance to the point of the previous frame a normal is seeded from (default:3)" )
     ;
   opts.addOptions();
   // clang-format on
@@ -249,6 +263,9 @@ bool parseParameters( int                             argc,
   printf( "    storeNumberOfNearestNeighborsInNormalEstimation = %u \n",
           normalParams.storeNumberOfNearestNeighborsInNormalEstimation_ );
   printf( "    storeCentroids                                  = %u \n", normalParams.storeCentroids_ );
+  printf( "    temporal                                        = %u \n", temporal );
+  printf( "    maxFitErrorTemporal                             = %f \n", normalParams.maxFitErrorTemporal_ );
+  printf( "    maxDist2Temporal                                = %f \n", normalParams.maxDist2Temporal_ );
 
   // report the current configuration (only in the absence of errors so
   // that errors/warnings are more obvious and in the same place).
@@ -262,6 +279,7 @@ int generateNormal( const std::string&                    uncompressedDataPath,
                     const size_t                          startFrameNumber,
                     const size_t                          frameCount,
                     const size_t                          nbThread,
+                    const bool                            temporal,
                     const PCCNormalsGenerator3Parameters& normalParams ) {
   PCCGroupOfFrames sources;
   // reading the input ply
@@ -270,6 +288,9 @@ int generateNormal( const std::string&                    uncompressedDataPath,
     return -1;
   }
   // calculating the normal for each frame
+  PCCExecutionContext executionContext;
+  executionContext.initialize( nbThread );
+  PCCNormalsReference reference;
   for ( int frIdx = startFrameNumber; frIdx < startFrameNumber + frameCount; frIdx++ ) {
     std::cout << std::endl << "============= FRAME " << frIdx << " ============= " << std::endl;
     std::cout << "  Computing normals for original point cloud... ";
@@ -277,12 +298,18 @@ int generateNormal( const std::string&                    uncompressedDataPath,
     PCCKdTree            kdtree( geometry );
     PCCNNResult          result;
     PCCNormalsGenerator3 normalsGen;
-    normalsGen.compute( geometry, kdtree, normalParams, nbThread );
+    if ( temporal ) {
+      normalsGen.compute( geometry, kdtree, normalParams, executionContext, reference );
+    } else {
+      normalsGen.compute( geometry, kdtree, normalParams, executionContext );
+    }
     geometry.addNormals();
     for ( int ptIdx = 0; ptIdx < geometry.getPointCount(); ptIdx++ ) {
       geometry.setNormal( ptIdx, normalsGen.getNormal( ptIdx ) );
     }
-    std::cout << "[done]" << std::endl;
+    std::cout << "[done]";
+    if ( temporal ) { std::cout << " " << normalsGen.getSeededNormalCount() << " from the previous frame"; }
+    std::cout << std::endl;
   }
   // saving the normal
   std::cout << std::endl << "============= OUTPUT: " << reconstructedDataPath << " ============= " << std::endl;
@@ -299,6 +326,7 @@ int main( int argc, char* argv[] ) {
   size_t                         startFrameNumber;
   size_t                         frameCount;
   size_t                         nbThread     = 0;
+  bool                           temporal     = false;
   PCCNormalsGenerator3Parameters normalParams = {PCCVector3D( 0.0 ),
                                                  ( std::numeric_limits<double>::max )(),
                                                  ( std::numeric_limits<double>::max )(),
@@ -311,13 +339,15 @@ int main( int argc, char* argv[] ) {
                                                  PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE,
                                                  false,
                                                  false,
-                                                 false};  // default values
+                                                 false,
+                                                 0.005,
+                                                 3.0};  // default values
   if ( !parseParameters( argc, argv, uncompressedDataPath, reconstructedDataPath, startFrameNumber, frameCount,
-                         nbThread, normalParams ) ) {
+                         nbThread, temporal, normalParams ) ) {
     return -1;
   }
-  if ( nbThread > 0 ) { tbb::task_scheduler_init init( static_cast<int>( nbThread ) ); }
+  tbb::task_scheduler_init init( nbThread > 0 ? static_cast<int>( nbThread ) : tbb::task_scheduler_init::automatic );
   int ret = generateNormal( uncompressedDataPath, reconstructedDataPath, startFrameNumber, frameCount, nbThread,
-                            normalParams );
+                            temporal, normalParams );
   return ret;
 }
\ No newline at end of file
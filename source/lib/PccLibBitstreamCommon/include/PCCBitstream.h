@@ -112,6 +112,8 @@ class PCCBitstreamStat {
     PCCBitstreamGofStat element;
     bitstreamGofStat_.push_back( element );
   }
+  // drops the last GOF, e.g. a rate control pass whose bitstream is not kept
+  void removeGOF() { bitstreamGofStat_.pop_back(); }
   void setHeader( size_t size ) { header_ = size; }
   void incrHeader( size_t size ) { header_ += size; }
   void overwriteV3CUnitSize( V3CUnitType type, size_t size ) {
@@ -124,6 +126,13 @@ class PCCBitstreamStat {
   size_t getTotalGeometry() { return bitstreamGofStat_.back().getTotalGeometry(); }
   size_t getTotalAttribute() { return bitstreamGofStat_.back().getTotalAttribute(); }
   size_t getTotalMetadata() { return bitstreamGofStat_.back().getTotalMetadata(); }
+  size_t getTotal() { return bitstreamGofStat_.back().getTotal(); }
+  // the sum of all the GOFs
+  PCCBitstreamGofStat getTotalStat() {
+    PCCBitstreamGofStat total;
+    for ( auto& element : bitstreamGofStat_ ) { total += element; }
+    return total;
+  }
 
   void trace( bool byGOF = false ) {
     printf( "Bitstream stat: \n" );
@@ -135,8 +144,7 @@ class PCCBitstreamStat {
       }
       printf( "  Total: \n" );
     }
-    PCCBitstreamGofStat totalBitstreamStat;
-    for ( auto& element : bitstreamGofStat_ ) { totalBitstreamStat += element; }
+    PCCBitstreamGofStat totalBitstreamStat = getTotalStat();
     totalBitstreamStat.trace();
     size_t totalMetadata  = totalBitstreamStat.getTotalMetadata() + header_;
     size_t totalGeometry  = totalBitstreamStat.getTotalGeometry();
@@ -176,6 +184,7 @@ class PCCBitstream {
   std::vector<uint8_t>& vector() { return data_; }
   uint64_t&             size() { return position_.bytes_; }
   uint64_t              capacity() { return data_.size(); }
+  size_t                getMemorySize() const { return data_.capacity(); }
   PCCBistreamPosition   getPosition() { return position_; }
   void                  setPosition( PCCBistreamPosition& val ) { position_ = val; }
   PCCBitstream&         operator+=( const uint64_t size ) {
@@ -185,7 +194,14 @@ class PCCBitstream {
   void copyFrom( PCCBitstream& dataBitstream, const uint64_t startByte, const uint64_t bitstreamSize );
   void copyTo( PCCBitstream& dataBitstream, uint64_t startByte, uint64_t outputSize );
   void writeVideoStream( PCCVideoBitstream& videoBitstream );
+  // Makes room for size more bytes from the position, so that writing them does not reallocate the buffer.
+  void reserve( const uint64_t size ) {
+    if ( position_.bytes_ + size + 16 >= data_.size() ) { data_.resize( position_.bytes_ + size + 16, 0 ); }
+  }
   void readVideoStream( PCCVideoBitstream& videoBitstream, size_t videoStreamSize );
+  // As readVideoStream(), but a video stream that runs to the end of the bitstream (the payload of a V3C unit) is
+  // not copied: the buffer is handed over to videoBitstream, and the bitstream is left without data.
+  void takeVideoStream( PCCVideoBitstream& videoBitstream, size_t videoStreamSize );
   bool byteAligned() { return ( position_.bits_ == 0 ); }
   bool moreData() { return position_.bytes_ < data_.size(); }
   void computeMD5();
@@ -193,11 +209,23 @@ class PCCBitstream {
   inline std::string readString() {
     while ( !byteAligned() ) { read( 1 ); }
     std::string str;
-    char        element = read( 8 );
+#ifdef BITSTREAM_TRACE
+    char element = read( 8 );
     while ( element != 0x00 ) {
       str.push_back( element );
       element = read( 8 );
     }
+#else
+    // byte aligned: the string is copied up to its null terminator at once (or to the end of the stream)
+    if ( position_.bytes_ < data_.size() ) {
+      const uint8_t* begin = data_.data() + position_.bytes_;
+      const size_t   count = data_.size() - position_.bytes_;
+      const uint8_t* end   = static_cast<const uint8_t*>( memchr( begin, 0, count ) );
+      const size_t   size  = end != nullptr ? end - begin : count;
+      str.assign( reinterpret_cast<const char*>( begin ), size );
+      position_.bytes_ += ( std::min )( size + 1, count );
+    }
+#endif
     return str;
   }
 
@@ -208,6 +236,12 @@ class PCCBitstream {
   }
 
   inline uint32_t peekByteAt( uint64_t peekPos ) { return data_[peekPos]; }
+  // The next bits ( <= 32 ) of the stream, without moving the position; bits past the end of the stream read as 0.
+  inline uint32_t peek( uint8_t bits ) const {
+    assert( bits <= 32 );
+    return bits == 0 ? 0 : static_cast<uint32_t>( ( window( position_ ) << position_.bits_ ) >> ( 64 - bits ) );
+  }
+  inline void skip( uint64_t bits ) { skip( bits, position_ ); }
   inline uint32_t read( uint8_t bits, bool bFullStream = false ) {
     uint32_t code = read( bits, position_ );
 #ifdef BITSTREAM_TRACE
@@ -286,16 +320,17 @@ class PCCBitstream {
     bool traceStartingValue = trace_;
     trace_                  = false;
 #endif
-    uint32_t value = 0, code = 0, length = 0;
-    code = read( 1 );
-    if ( 0 == code ) {
-      length = 0;
-      while ( !( code & 1 ) ) {
-        code = read( 1 );
-        length++;
-      }
-      value = read( length );
-      value += ( 1 << length ) - 1;
+    // Exp-Golomb: the leading zeros are counted in a 32-bit window, which holds the whole code of the values below
+    // 65535; a uint32_t value has at most 32 leading zeros.
+    uint32_t       value  = 0;
+    const uint32_t code   = peek( 32 );
+    const uint32_t length = code == 0 ? 32 : 31 - floorLog2( code );
+    if ( length < 16 ) {
+      value = ( code >> ( 31 - 2 * length ) ) - 1;
+      skip( 2 * length + 1 );
+    } else {
+      skip( length + 1 );
+      value = static_cast<uint32_t>( read( length ) + ( ( uint64_t( 1 ) << length ) - 1 ) );
     }
 #ifdef BITSTREAM_TRACE
     trace_ = traceStartingValue;
@@ -346,32 +381,54 @@ class PCCBitstream {
   void setLogger( PCCLogger& logger ) { logger_ = &logger; }
 #endif
  private:
-  inline void realloc( const size_t size = 4096 ) { data_.resize( data_.size() + ( ( ( size / 4096 ) + 1 ) * 4096 ) ); }
-  inline uint32_t read( uint8_t bits, PCCBistreamPosition& pos ) {
-    uint32_t value = 0;
-    for ( size_t i = 0; i < bits; i++ ) {
-      value |= ( ( data_[pos.bytes_] >> ( 7 - pos.bits_ ) ) & 1 ) << ( bits - 1 - i );
-      if ( pos.bits_ == 7 ) {
-        pos.bytes_++;
-        pos.bits_ = 0;
-      } else {
-        pos.bits_++;
-      }
+  // Grows by at least size bytes and by at least half the buffer, so that a stream written element by element is not
+  // copied once per 4 KB.
+  inline void realloc( const size_t size = 4096 ) {
+    data_.resize( data_.size() + ( std::max )( ( ( size / 4096 ) + 1 ) * 4096, data_.size() / 2 ) );
+  }
+  // The 8 bytes from the byte position, most significant first, the missing ones past the end of the stream as 0.
+  // The word is loaded for each syntax element rather than cached, since the position can be moved from outside.
+  inline uint64_t window( const PCCBistreamPosition& pos ) const {
+    uint64_t       word  = 0;
+    const size_t   count = pos.bytes_ < data_.size() ? ( std::min )( data_.size() - pos.bytes_, size_t( 8 ) ) : 0;
+    const uint8_t* data  = data_.data() + pos.bytes_;
+    if ( count == 8 ) {
+      for ( size_t i = 0; i < 8; i++ ) { word = ( word << 8 ) | data[i]; }
+    } else {
+      for ( size_t i = 0; i < 8; i++ ) { word = ( word << 8 ) | ( i < count ? data[i] : 0 ); }
     }
+    return word;
+  }
+  inline void skip( uint64_t bits, PCCBistreamPosition& pos ) {
+    bits += pos.bits_;
+    pos.bytes_ += bits >> 3;
+    pos.bits_ = static_cast<uint8_t>( bits & 7 );
+  }
+  inline uint32_t read( uint8_t bits, PCCBistreamPosition& pos ) {
+    assert( bits <= 32 );
+    if ( bits == 0 ) { return 0; }
+    const uint32_t value = static_cast<uint32_t>( ( window( pos ) << pos.bits_ ) >> ( 64 - bits ) );
+    skip( bits, pos );
     return value;
   }
 
+  // The value is placed in a 64-bit word aligned on the byte position and ORed into the (at most 5) bytes it spans,
+  // instead of one bit at a time. As for the reads, nothing is cached across calls since the position can be moved
+  // from outside. The bits past the 32 of value, e.g. of a unit size on 8 bytes, are zeros already in the buffer.
   inline void write( uint32_t value, uint8_t bits, PCCBistreamPosition& pos ) {
+    if ( bits == 0 ) { return; }
     if ( pos.bytes_ + bits + 16 >= data_.size() ) { realloc(); }
-    for ( size_t i = 0; i < bits; i++ ) {
-      data_[pos.bytes_] |= ( ( value >> ( bits - 1 - i ) ) & 1 ) << ( 7 - pos.bits_ );
-      if ( pos.bits_ == 7 ) {
-        pos.bytes_++;
-        pos.bits_ = 0;
-      } else {
-        pos.bits_++;
-      }
+    if ( bits > 32 ) {
+      skip( bits - 32, pos );
+      bits = 32;
+    }
+    const uint64_t code = bits < 32 ? value & ( ( uint32_t( 1 ) << bits ) - 1 ) : value;
+    const uint64_t word = code << ( 64 - pos.bits_ - bits );
+    uint8_t*       data = data_.data() + pos.bytes_;
+    for ( size_t i = 0; i * 8 < size_t( pos.bits_ ) + bits; i++ ) {
+      data[i] |= static_cast<uint8_t>( word >> ( 56 - 8 * i ) );
     }
+    skip( bits, pos );
   }
 
   std::vector<uint8_t> data_;
@@ -66,6 +66,11 @@ class PCCAtlasHighLevelSyntax {
   }
   size_t             getVideoBitstreamCount() { return videoBitstream_.size(); }
   PCCVideoBitstream& getVideoBitstream( size_t index ) { return videoBitstream_[index]; }
+  size_t             getVideoBitstreamMemorySize() const {
+    size_t size = 0;
+    for ( const auto& bitstream : videoBitstream_ ) { size += bitstream.getMemorySize(); }
+    return size;
+  }
   PCCVideoBitstream& getVideoBitstream( PCCVideoType type ) {
     for ( auto& value : videoBitstream_ ) {
       if ( value.type() == type ) { return value; }
@@ -211,6 +216,9 @@ class PCCHighLevelSyntax {
   PCCHighLevelSyntax();
   ~PCCHighLevelSyntax();
 
+  // Drops the parameter sets, atlas data and video sub-bitstreams before the next GOF is parsed.
+  void reset();
+
   // bitstream statistic related functions
   void              setBitstreamStat( PCCBitstreamStat& bitstreamStat ) { bitstreamStat_ = &bitstreamStat; }
   PCCBitstreamStat& getBitstreamStat() { return *bitstreamStat_; }
@@ -264,6 +272,12 @@ class PCCHighLevelSyntax {
     return atlasHLS_[atlasIndex_].createVideoBitstream( type );
   }
   size_t             getVideoBitstreamCount() { return atlasHLS_[atlasIndex_].getVideoBitstreamCount(); }
+  // bytes held by the video bitstreams of every atlas
+  size_t getVideoBitstreamMemorySize() const {
+    size_t size = 0;
+    for ( const auto& atlas : atlasHLS_ ) { size += atlas.getVideoBitstreamMemorySize(); }
+    return size;
+  }
   PCCVideoBitstream& getVideoBitstream( size_t index ) { return atlasHLS_[atlasIndex_].getVideoBitstream( index ); }
   PCCVideoBitstream& getVideoBitstream( PCCVideoType type ) { return atlasHLS_[atlasIndex_].getVideoBitstream( type ); }
   void               printVideoBitstream() { return atlasHLS_[atlasIndex_].printVideoBitstream(); };
@@ -35,7 +35,26 @@
 #define PCC_LOGGER_H
 
 #include "PCCBitstreamCommon.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+// Categories compiled in, one bit per PCCLoggerType (LOG_DESCR = bit 0 ... LOG_BITSTRMD5 = bit 8): the TRACE_* macros
+// of a cleared bit neither format nor evaluate their arguments, e.g. -DPCC_LOG_CATEGORIES=0x1F8 for the frame and
+// picture logs only.
+#ifndef PCC_LOG_CATEGORIES
+#define PCC_LOG_CATEGORIES 0xFFFFFFFFu
+#endif
+#define PCC_LOG_ENABLED( type ) ( ( ( PCC_LOG_CATEGORIES ) >> ( type ) ) & 1u )
+
+// The writer thread wakes every PCC_LOG_FLUSH_MS, or as soon as a file has PCC_LOG_FLUSH_BYTES waiting.
+#define PCC_LOG_FLUSH_MS 100
+#define PCC_LOG_FLUSH_BYTES ( 1 << 20 )
 
 namespace pcc {
 
@@ -88,14 +107,28 @@ static const std::string get( PCCLoggerType type ) {
   }
 }
 
+// Gets the text of the traces of one type in the order it is written to the file, e.g. to check the conformance logs
+// as they are traced rather than reading the files back. It runs under the lock of the file and must be short.
+typedef std::function<void( PCCLoggerType type, const char* text, size_t size )> PCCLogRecordCallback;
+
+// One log file. trace() formats into a buffer of the calling thread and appends the text to the file's pending
+// output under a short lock; the writer thread of the PCCLogger does the file I/O, so a trace costs no system call.
 class PCCVirtualLogger {
  public:
-  PCCVirtualLogger() : file_( NULL ), disable_( false ) {}
+  PCCVirtualLogger() : file_( NULL ), disable_( false ), type_( LOG_DESCR ), wake_( NULL ), record_( NULL ) {}
   ~PCCVirtualLogger() { close(); }
-  bool initialize( PCCLoggerType type, std::string& filename, bool encoder, size_t atlasId = 0 ) {
+  bool initialize( PCCLoggerType            type,
+                   std::string&             filename,
+                   bool                     encoder,
+                   std::condition_variable*    wake,
+                   const PCCLogRecordCallback* record,
+                   size_t                      atlasId = 0 ) {
     std::string str = get( type );
     // size_t pos = str.find_last_of( "." );  //ajt::disables adding the atlasID to the file name based on Danillo's
     // comment if ( pos != std::string::npos ) str.insert( pos, std::to_string( atlasId ) );
+    type_   = type;
+    wake_   = wake;
+    record_ = record;
     return open( filename + ( encoder ? "_enc" : "_dec" ) + str );
   }
   inline bool isInitialized() { return file_ != NULL; }
@@ -103,29 +136,64 @@ class PCCVirtualLogger {
   inline void enable() { disable_ = false; }
   template <typename... Args>
   inline void trace( const char* format, Args... eArgs ) {
-    if ( file_ && !disable_ ) { fprintf( file_, format, eArgs... ); }
+    if ( !file_ || disable_ ) { return; }
+    static thread_local std::vector<char> text( 1024 );
+    int                                   size = snprintf( text.data(), text.size(), format, eArgs... );
+    if ( size < 0 ) { return; }
+    if ( size_t( size ) >= text.size() ) {
+      text.resize( size + 1 );
+      snprintf( text.data(), text.size(), format, eArgs... );
+    }
+    std::lock_guard<std::mutex> lock( mutex_ );
+    pending_.append( text.data(), size );
+    if ( record_ && *record_ ) { ( *record_ )( type_, text.data(), size_t( size ) ); }
+    if ( pending_.size() >= PCC_LOG_FLUSH_BYTES && wake_ ) { wake_->notify_one(); }
   }
+  // Writes what is pending; called by the writer thread, and at the end.
   inline void flush() {
-    if ( !disable_ ) { fflush( file_ ); }
+    std::string text;
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      text.swap( pending_ );
+    }
+    if ( file_ && !text.empty() ) {
+      fwrite( text.data(), 1, text.size(), file_ );
+      fflush( file_ );
+    }
   }
 
  private:
   void close() {
-    if ( file_ ) { fclose( file_ ); }
+    if ( file_ ) {
+      flush();
+      fclose( file_ );
+    }
     file_ = NULL;
   }
   bool open( std::string name ) {
     close();
     return ( ( file_ = fopen( name.c_str(), "w+" ) ) != NULL );
   }
-  FILE* file_;
-  bool  disable_;
+  FILE*                    file_;
+  bool                     disable_;
+  std::mutex               mutex_;
+  std::string                 pending_;
+  PCCLoggerType               type_;
+  std::condition_variable*    wake_;
+  const PCCLogRecordCallback* record_;
 };
 
 class PCCLogger {
  public:
-  PCCLogger() : filename_( "" ), encoder_( true ) { logger_.resize( LOG_ERROR ); }
-  ~PCCLogger() { logger_.clear(); }
+  PCCLogger() : filename_( "" ), encoder_( true ), stop_( false ) {}
+  ~PCCLogger() {
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      stop_ = true;
+    }
+    wake_.notify_one();
+    if ( writer_.joinable() ) { writer_.join(); }
+  }
   void initilalize( std::string filename, bool encoder ) {
     filename_ = filename;
     encoder_  = encoder;
@@ -133,14 +201,22 @@ class PCCLogger {
   void         enable( PCCLoggerType type ) { logger_[type].enable(); }
   void         disable( PCCLoggerType type ) { logger_[type].disable(); }
   std::string& getLoggerBaseFileName() { return filename_; }
+  // To be set before the first trace.
+  void setRecordCallback( const PCCLogRecordCallback& record ) { record_ = record; }
+  // Writes everything traced so far, e.g. before the process may abort.
+  void flush() {
+    for ( auto& logger : logger_ ) { logger.flush(); }
+  }
 
   template <typename... Args>
   inline void trace( PCCLoggerType type, const char* format, Args... args ) {
-    if ( !logger_[type].isInitialized() ) { logger_[type].initialize( type, filename_, encoder_ ); }
-    if ( logger_[type].isInitialized() ) {
-      logger_[type].trace( format, args... );
-      logger_[type].flush();
+    if ( !logger_[type].isInitialized() ) {
+      // Files are opened by the tracing threads as they go.
+      std::lock_guard<std::mutex> lock( mutex_ );
+      if ( !logger_[type].isInitialized() ) { logger_[type].initialize( type, filename_, encoder_, &wake_, &record_ ); }
+      if ( !writer_.joinable() ) { writer_ = std::thread( &PCCLogger::write, this ); }
     }
+    if ( logger_[type].isInitialized() ) { logger_[type].trace( format, args... ); }
   }
   template <typename... Args>
   inline void traceDescr( const char* format, Args... args ) {
@@ -217,9 +293,24 @@ class PCCLogger {
   }
 
  private:
-  std::vector<PCCVirtualLogger> logger_;
-  std::string                   filename_;
-  bool                          encoder_;
+  void write() {
+    std::unique_lock<std::mutex> lock( mutex_ );
+    while ( !stop_ ) {
+      wake_.wait_for( lock, std::chrono::milliseconds( PCC_LOG_FLUSH_MS ) );
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+  }
+
+  std::array<PCCVirtualLogger, LOG_ERROR> logger_;
+  PCCLogRecordCallback                    record_;
+  std::string                             filename_;
+  bool                                    encoder_;
+  std::mutex                              mutex_;  // opening files, starting and stopping the writer
+  std::condition_variable                 wake_;
+  std::thread                             writer_;
+  bool                                    stop_;
 };
 
 #ifdef BITSTREAM_TRACE
@@ -243,13 +334,21 @@ class PCCLogger {
 #endif
 
 #ifdef CONFORMANCE_TRACE
-#define TRACE_HLS( fmt, ... ) logger_->traceHLS( fmt, ##__VA_ARGS__ );
-#define TRACE_ATLAS( fmt, ... ) logger_->traceAtlas( fmt, ##__VA_ARGS__ );
-#define TRACE_TILE( fmt, ... ) logger_->traceTiles( fmt, ##__VA_ARGS__ );
-#define TRACE_PCFRAME( fmt, ... ) logger_->tracePCFrame( fmt, ##__VA_ARGS__ );
-#define TRACE_RECFRAME( fmt, ... ) logger_->traceRecFrame( fmt, ##__VA_ARGS__ );
-#define TRACE_PICTURE( fmt, ... ) logger_->tracePicture( fmt, ##__VA_ARGS__ );
-#define TRACE_BITSTRMD5( fmt, ... ) logger_->traceBitStreamMD5( fmt, ##__VA_ARGS__ );
+// The condition is a constant: a category left out of PCC_LOG_CATEGORIES is removed with its arguments.
+#define TRACE_HLS( fmt, ... ) \
+  do { if ( PCC_LOG_ENABLED( LOG_HLS ) ) { logger_->traceHLS( fmt, ##__VA_ARGS__ ); } } while ( 0 );
+#define TRACE_ATLAS( fmt, ... ) \
+  do { if ( PCC_LOG_ENABLED( LOG_ATLAS ) ) { logger_->traceAtlas( fmt, ##__VA_ARGS__ ); } } while ( 0 );
+#define TRACE_TILE( fmt, ... ) \
+  do { if ( PCC_LOG_ENABLED( LOG_TILES ) ) { logger_->traceTiles( fmt, ##__VA_ARGS__ ); } } while ( 0 );
+#define TRACE_PCFRAME( fmt, ... ) \
+  do { if ( PCC_LOG_ENABLED( LOG_PCFRAME ) ) { logger_->tracePCFrame( fmt, ##__VA_ARGS__ ); } } while ( 0 );
+#define TRACE_RECFRAME( fmt, ... ) \
+  do { if ( PCC_LOG_ENABLED( LOG_RECFRAME ) ) { logger_->traceRecFrame( fmt, ##__VA_ARGS__ ); } } while ( 0 );
+#define TRACE_PICTURE( fmt, ... ) \
+  do { if ( PCC_LOG_ENABLED( LOG_PICTURE ) ) { logger_->tracePicture( fmt, ##__VA_ARGS__ ); } } while ( 0 );
+#define TRACE_BITSTRMD5( fmt, ... ) \
+  do { if ( PCC_LOG_ENABLED( LOG_BITSTRMD5 ) ) { logger_->traceBitStreamMD5( fmt, ##__VA_ARGS__ ); } } while ( 0 );
 #else
 #define TRACE_HLS( fmt, ... ) ;
 #define TRACE_ATLAS( fmt, ... ) ;
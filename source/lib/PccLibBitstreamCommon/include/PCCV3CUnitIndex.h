@@ -0,0 +1,103 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCC_BITSTREAM_V3CUNITINDEX_H
+#define PCC_BITSTREAM_V3CUNITINDEX_H
+
+#include "PCCBitstreamCommon.h"
+
+namespace pcc {
+
+// A V3C unit of a sample stream: position_ is the offset of its payload, after the unit size field.
+struct V3CUnitIndexEntry {
+  uint64_t    position_;
+  uint64_t    size_;
+  V3CUnitType type_;
+  uint32_t    gofIndex_;
+};
+
+// A GOF starts at a VPS and runs up to the next one. Its atlas frames are counted when the GOF is parsed, so
+// firstAtlasFrame_ is only known once the frames of all the previous GOFs are.
+struct V3CGofIndexEntry {
+  size_t   firstUnit_;
+  size_t   unitCount_;
+  uint32_t firstAtlasFrame_;
+  uint32_t atlasFrameCount_;
+  bool     irap_;  // the atlas data starts with an IRAP atlas frame: decoding can start at this GOF
+  bool     atlasFrameCountKnown_;
+};
+
+// Random access index of the V3C units of a sample stream, built by PCCBitstreamReader::read(). A decoder can
+// start at any GOF starting with an IRAP without parsing the units ahead of it. The index can be saved next to
+// the sample stream, and is only valid for a stream of the same size.
+class V3CUnitIndex {
+ public:
+  V3CUnitIndex() : streamSize_( 0 ), headerSize_( 0 ), ssvhUnitSizePrecisionBytesMinus1_( 0 ) {}
+  ~V3CUnitIndex() {}
+
+  void clear();
+  void addUnit( uint64_t position, uint64_t size, V3CUnitType type );
+  // the first ACL NAL unit of the atlas data of the last GOF is an IRAP one
+  void setIrap( bool irap ) {
+    if ( !gofs_.empty() ) { gofs_.back().irap_ = irap; }
+  }
+  void setAtlasFrameCount( size_t gofIndex, size_t atlasFrameCount );
+
+  size_t             getUnitCount() const { return units_.size(); }
+  V3CUnitIndexEntry& getUnit( size_t index ) { return units_[index]; }
+  size_t             getGofCount() const { return gofs_.size(); }
+  V3CGofIndexEntry&  getGof( size_t index ) { return gofs_[index]; }
+  // the GOF to start decoding at to reach the atlas frame: the last IRAP GOF at or before the one holding it, or
+  // getGofCount() if the frames are not counted up to there
+  size_t   findGof( size_t atlasFrame ) const;
+  uint64_t getStreamSize() const { return streamSize_; }
+  size_t   getHeaderSize() const { return headerSize_; }
+  uint32_t getSsvhUnitSizePrecisionBytesMinus1() const { return ssvhUnitSizePrecisionBytesMinus1_; }
+
+  void setStreamSize( uint64_t value ) { streamSize_ = value; }
+  void setHeaderSize( size_t value ) { headerSize_ = value; }
+  void setSsvhUnitSizePrecisionBytesMinus1( uint32_t value ) { ssvhUnitSizePrecisionBytesMinus1_ = value; }
+
+  bool write( const std::string& filename );
+  bool read( const std::string& filename );
+
+ private:
+  std::vector<V3CUnitIndexEntry> units_;
+  std::vector<V3CGofIndexEntry>  gofs_;
+  uint64_t                       streamSize_;
+  size_t                         headerSize_;
+  uint32_t                       ssvhUnitSizePrecisionBytesMinus1_;
+};
+
+};  // namespace pcc
+
+#endif  //~PCC_BITSTREAM_V3CUNITINDEX_H
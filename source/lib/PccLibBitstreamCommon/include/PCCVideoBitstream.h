@@ -35,19 +35,50 @@
 #define PCC_BITSTREAM_VIDEOBITSTREAM_H
 
 #include "PCCBitstreamCommon.h"
+#include <streambuf>
 namespace pcc {
 
+// A contiguous piece of a byte stream: a start code or a NAL unit read in place in the sample stream. position_ is
+// its offset in the byte stream.
+struct PCCVideoByteStreamSegment {
+  const uint8_t* data_;
+  size_t         size_;
+  size_t         position_;
+};
+
+// The video sub-bitstream is stored in data_ from begin_ on: the bitstream reader hands the buffer of the whole V3C
+// unit over to it rather than copying the payload out. buffer() and size() read the payload in place; vector() first
+// moves it to the front of the buffer.
 class PCCVideoBitstream {
  public:
   PCCVideoBitstream( PCCVideoType type ) : type_( type ) { data_.clear(); }
   ~PCCVideoBitstream() { data_.clear(); }
 
   PCCVideoBitstream&    operator=( const PCCVideoBitstream& ) = default;
-  void                  resize( size_t size ) { data_.resize( size ); }
-  std::vector<uint8_t>& vector() { return data_; }
-  uint8_t*              buffer() { return data_.data(); }
-  size_t                size() { return data_.size(); }
-  PCCVideoType          type() { return type_; }
+  void                  resize( size_t size ) { vector().resize( size ); }
+  std::vector<uint8_t>& vector() {
+    convertByteStreamView();
+    if ( begin_ != 0 ) {
+      data_.erase( data_.begin(), data_.begin() + begin_ );
+      begin_ = 0;
+    }
+    return data_;
+  }
+  uint8_t* buffer() {
+    convertByteStreamView();
+    return data_.data() + begin_;
+  }
+  size_t size() {
+    convertByteStreamView();
+    return data_.size() - begin_;
+  }
+  PCCVideoType type() { return type_; }
+  // Takes the buffer over, the video stream starting at begin.
+  void assign( std::vector<uint8_t>&& data, size_t begin ) {
+    data_           = std::move( data );
+    begin_          = begin;
+    byteStreamView_ = false;
+  }
 
   void trace() { std::cout << "      " << toString( type_ ) << " ->" << size() << " B " << std::endl; }
 
@@ -67,10 +98,49 @@ class PCCVideoBitstream {
                                  bool   emulationPreventionBytes = false,
                                  bool   changeStartCodeSize      = true );
 
+  // Defers sampleStreamToByteStream(): a PCCVideoByteStreamBuf reads the sample stream as a byte stream without
+  // converting it, and any other access to the data converts it first.
+  void setByteStreamView( bool isAvc = false, bool isVvc = false, size_t precision = 4 );
+  bool isByteStreamView() const { return byteStreamView_; }
+  size_t getMemorySize() const { return data_.capacity(); }
+  // The byte stream of a byte stream view as start codes and NAL units, or the data as a single segment.
+  void getByteStreamSegments( std::vector<PCCVideoByteStreamSegment>& segments );
+
  private:
+  void getSampleStreamSegments( bool                                    isAvc,
+                                bool                                    isVvc,
+                                size_t                                  precision,
+                                std::vector<PCCVideoByteStreamSegment>& segments ) const;
+  void convertByteStreamView() {
+    if ( byteStreamView_ ) { sampleStreamToByteStream( viewIsAvc_, viewIsVvc_, viewPrecision_ ); }
+  }
   size_t               getEndOfNaluPosition( size_t startIndex );
   std::vector<uint8_t> data_;
+  size_t               begin_ = 0;
   PCCVideoType         type_;
+  bool                 byteStreamView_ = false;
+  bool                 viewIsAvc_      = false;
+  bool                 viewIsVvc_      = false;
+  size_t               viewPrecision_  = 4;
+};
+
+// Reads a video bitstream as an Annex B byte stream through a std::istream. With a byte stream view, the start
+// codes are inserted on the fly and the NAL units read in place, so the sample stream is neither converted nor
+// copied. Seekable, as the HM and VTM decoders step back in their input.
+class PCCVideoByteStreamBuf : public std::streambuf {
+ public:
+  PCCVideoByteStreamBuf( PCCVideoBitstream& bitstream );
+
+ protected:
+  int_type underflow() override;
+  pos_type seekoff( off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which ) override;
+  pos_type seekpos( pos_type position, std::ios_base::openmode which ) override;
+
+ private:
+  void                                   setSegment( size_t index, size_t offset );
+  std::vector<PCCVideoByteStreamSegment> segments_;
+  size_t                                 segment_;
+  size_t                                 size_;
 };
 
 }  // namespace pcc
@@ -96,13 +96,28 @@ void PCCBitstream::readVideoStream( PCCVideoBitstream& videoBitstream, size_t vi
   position_.bytes_ += videoStreamSize;
 }
 
+void PCCBitstream::takeVideoStream( PCCVideoBitstream& videoBitstream, size_t videoStreamSize ) {
+  if ( position_.bits_ != 0 || position_.bytes_ + videoStreamSize != data_.size() ) {
+    readVideoStream( videoBitstream, videoStreamSize );
+    return;
+  }
+#ifdef BITSTREAM_TRACE
+  trace( "%s \n", "Code: PCCVideoBitstream" );
+  trace( "Code: size = %zu \n", videoStreamSize );
+#endif
+  videoBitstream.assign( std::move( data_ ), position_.bytes_ );
+  data_.clear();
+  videoBitstream.trace();
+  position_.bytes_ += videoStreamSize;
+}
+
 void PCCBitstream::writeVideoStream( PCCVideoBitstream& videoBitstream ) {
 #ifdef BITSTREAM_TRACE
   trace( "%s \n", "Code: PCCVideoBitstream" );
 #endif
   uint8_t* data = videoBitstream.buffer();
   size_t   size = videoBitstream.size();
-  realloc( size );
+  reserve( size );
 #ifdef BITSTREAM_TRACE
   trace( "Code: size = %zu \n", size );
 #endif
@@ -131,6 +146,8 @@ void PCCBitstream::copyTo( PCCBitstream& dataBitstream, uint64_t startByte, uint
 }
 
 void PCCBitstream::computeMD5() {
+#ifdef CONFORMANCE_TRACE
+  // The digest only goes to the conformance trace: without it, hashing the whole stream would be wasted time.
   MD5                  md5Hash;
   std::vector<uint8_t> tmp_digest;
   tmp_digest.resize( 16 );
@@ -139,6 +156,7 @@ void PCCBitstream::computeMD5() {
   md5Hash.update( data_.data(), dataSize );
   md5Hash.finalize( tmp_digest.data() );
   for ( auto& bitStr : tmp_digest ) TRACE_BITSTRMD5( "%02x", bitStr );
+#endif
   std::cout << std::endl;
   return;
 }
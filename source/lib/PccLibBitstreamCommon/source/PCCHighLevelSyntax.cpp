@@ -42,6 +42,13 @@ PCCHighLevelSyntax::~PCCHighLevelSyntax() {
   atlasHLS_.clear();
 }
 
+void PCCHighLevelSyntax::reset() {
+  videoBitstream_.clear();
+  vpccParameterSets_.clear();
+  atlasHLS_.clear();
+  atlasIndex_ = 0;
+}
+
 size_t PCCAtlasHighLevelSyntax::getNumRefIdxActive( AtlasTileHeader& ath ) {
   size_t afpsId          = ath.getAtlasFrameParameterSetId();
   auto&  afps            = getAtlasFrameParameterSet( afpsId );
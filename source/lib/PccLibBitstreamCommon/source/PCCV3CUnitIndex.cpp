@@ -0,0 +1,171 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCBitstreamCommon.h"
+#include "PCCV3CUnitIndex.h"
+
+using namespace pcc;
+
+// "V3CI", then the version of the file format
+static const uint32_t g_v3cUnitIndexMagic   = 0x56334349;
+static const uint32_t g_v3cUnitIndexVersion = 1;
+
+static void writeValue( std::ofstream& file, uint64_t value, size_t bytes ) {
+  uint8_t data[8];
+  for ( size_t i = 0; i < bytes; i++ ) { data[i] = static_cast<uint8_t>( value >> ( 8 * i ) ); }
+  file.write( reinterpret_cast<char*>( data ), bytes );
+}
+
+static uint64_t readValue( std::ifstream& file, size_t bytes ) {
+  uint8_t  data[8] = {0};
+  uint64_t value   = 0;
+  file.read( reinterpret_cast<char*>( data ), bytes );
+  for ( size_t i = 0; i < bytes; i++ ) { value |= static_cast<uint64_t>( data[i] ) << ( 8 * i ); }
+  return value;
+}
+
+void V3CUnitIndex::clear() {
+  units_.clear();
+  gofs_.clear();
+  streamSize_                       = 0;
+  headerSize_                       = 0;
+  ssvhUnitSizePrecisionBytesMinus1_ = 0;
+}
+
+void V3CUnitIndex::addUnit( uint64_t position, uint64_t size, V3CUnitType type ) {
+  if ( type == V3C_VPS || gofs_.empty() ) {
+    V3CGofIndexEntry gof;
+    gof.firstUnit_            = units_.size();
+    gof.unitCount_            = 0;
+    gof.firstAtlasFrame_      = 0;
+    gof.atlasFrameCount_      = 0;
+    gof.irap_                 = false;
+    gof.atlasFrameCountKnown_ = false;
+    if ( !gofs_.empty() && gofs_.back().atlasFrameCountKnown_ ) {
+      gof.firstAtlasFrame_ = gofs_.back().firstAtlasFrame_ + gofs_.back().atlasFrameCount_;
+    }
+    gofs_.push_back( gof );
+  }
+  units_.push_back( {position, size, type, static_cast<uint32_t>( gofs_.size() - 1 )} );
+  gofs_.back().unitCount_++;
+}
+
+void V3CUnitIndex::setAtlasFrameCount( size_t gofIndex, size_t atlasFrameCount ) {
+  if ( gofIndex >= gofs_.size() ) { return; }
+  gofs_[gofIndex].atlasFrameCount_      = static_cast<uint32_t>( atlasFrameCount );
+  gofs_[gofIndex].atlasFrameCountKnown_ = true;
+  bool known                            = true;
+  for ( size_t i = 0; i < gofs_.size(); i++ ) {
+    if ( i > 0 ) { gofs_[i].firstAtlasFrame_ = gofs_[i - 1].firstAtlasFrame_ + gofs_[i - 1].atlasFrameCount_; }
+    if ( !known ) { gofs_[i].firstAtlasFrame_ = 0; }
+    known = known && gofs_[i].atlasFrameCountKnown_;
+  }
+}
+
+size_t V3CUnitIndex::findGof( size_t atlasFrame ) const {
+  size_t start = gofs_.size();
+  for ( size_t i = 0; i < gofs_.size() && gofs_[i].atlasFrameCountKnown_; i++ ) {
+    if ( gofs_[i].irap_ ) { start = i; }
+    if ( atlasFrame < gofs_[i].firstAtlasFrame_ + gofs_[i].atlasFrameCount_ ) { return start; }
+  }
+  return gofs_.size();
+}
+
+bool V3CUnitIndex::write( const std::string& filename ) {
+  std::ofstream file( filename, std::ios::binary );
+  if ( !file.good() ) { return false; }
+  writeValue( file, g_v3cUnitIndexMagic, 4 );
+  writeValue( file, g_v3cUnitIndexVersion, 4 );
+  writeValue( file, streamSize_, 8 );
+  writeValue( file, headerSize_, 8 );
+  writeValue( file, ssvhUnitSizePrecisionBytesMinus1_, 1 );
+  writeValue( file, units_.size(), 8 );
+  for ( auto& unit : units_ ) {
+    writeValue( file, unit.position_, 8 );
+    writeValue( file, unit.size_, 8 );
+    writeValue( file, unit.type_, 1 );
+    writeValue( file, unit.gofIndex_, 4 );
+  }
+  writeValue( file, gofs_.size(), 8 );
+  for ( auto& gof : gofs_ ) {
+    writeValue( file, gof.firstUnit_, 8 );
+    writeValue( file, gof.unitCount_, 8 );
+    writeValue( file, gof.firstAtlasFrame_, 4 );
+    writeValue( file, gof.atlasFrameCount_, 4 );
+    writeValue( file, ( gof.irap_ ? 1 : 0 ) | ( gof.atlasFrameCountKnown_ ? 2 : 0 ), 1 );
+  }
+  bool good = file.good();
+  file.close();
+  return good;
+}
+
+bool V3CUnitIndex::read( const std::string& filename ) {
+  std::ifstream file( filename, std::ios::binary );
+  clear();
+  if ( !file.good() ) { return false; }
+  if ( readValue( file, 4 ) != g_v3cUnitIndexMagic || readValue( file, 4 ) != g_v3cUnitIndexVersion ) {
+    return false;
+  }
+  streamSize_                       = readValue( file, 8 );
+  headerSize_                       = readValue( file, 8 );
+  ssvhUnitSizePrecisionBytesMinus1_ = static_cast<uint32_t>( readValue( file, 1 ) );
+  units_.resize( readValue( file, 8 ) );
+  for ( auto& unit : units_ ) {
+    unit.position_ = readValue( file, 8 );
+    unit.size_     = readValue( file, 8 );
+    unit.type_     = static_cast<V3CUnitType>( readValue( file, 1 ) );
+    unit.gofIndex_ = static_cast<uint32_t>( readValue( file, 4 ) );
+    if ( !file.good() ) { break; }
+  }
+  if ( file.good() ) { gofs_.resize( readValue( file, 8 ) ); }
+  for ( auto& gof : gofs_ ) {
+    gof.firstUnit_            = readValue( file, 8 );
+    gof.unitCount_            = readValue( file, 8 );
+    gof.firstAtlasFrame_      = static_cast<uint32_t>( readValue( file, 4 ) );
+    gof.atlasFrameCount_      = static_cast<uint32_t>( readValue( file, 4 ) );
+    uint64_t flags            = readValue( file, 1 );
+    gof.irap_                 = ( flags & 1 ) != 0;
+    gof.atlasFrameCountKnown_ = ( flags & 2 ) != 0;
+    if ( !file.good() || gof.firstUnit_ + gof.unitCount_ > units_.size() ) { break; }
+  }
+  if ( !file.good() ) {
+    clear();
+    return false;
+  }
+  for ( auto& gof : gofs_ ) {
+    if ( gof.firstUnit_ + gof.unitCount_ > units_.size() ) {
+      clear();
+      return false;
+    }
+  }
+  return true;
+}
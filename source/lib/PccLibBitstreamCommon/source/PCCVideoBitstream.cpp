@@ -60,7 +60,10 @@ std::string PCCVideoBitstream::getExtension() {
 bool PCCVideoBitstream::write( const std::string& filename ) {
   std::ofstream file( filename, std::ios::binary );
   if ( !file.good() ) { return false; }
-  file.write( reinterpret_cast<char*>( data_.data() ), data_.size() );
+  // a byte stream view is written segment by segment, without being converted
+  std::vector<PCCVideoByteStreamSegment> segments;
+  getByteStreamSegments( segments );
+  for ( auto& segment : segments ) { file.write( reinterpret_cast<const char*>( segment.data_ ), segment.size_ ); }
   file.close();
   return true;
 }
@@ -69,6 +72,7 @@ bool PCCVideoBitstream::read( const std::string& filename ) {
   std::ifstream file( filename, std::ios::binary | std::ios::ate );
   if ( !file.good() ) { return false; }
   const uint64_t fileSize = file.tellg();
+  byteStreamView_          = false;
   resize( (size_t)fileSize );
   file.clear();
   file.seekg( 0 );
@@ -83,6 +87,7 @@ bool PCCVideoBitstream::_write( const std::string& filename ) { return write( fi
 #endif
 
 void PCCVideoBitstream::byteStreamToSampleStream( size_t precision, bool emulationPreventionBytes ) {
+  vector();
   size_t               startIndex = 0, endIndex = 0;
   std::vector<uint8_t> data;
   do {
@@ -116,10 +121,21 @@ void PCCVideoBitstream::sampleStreamToByteStream( bool   isAvc,
                                                   size_t precision,
                                                   bool   emulationPreventionBytes,
                                                   bool   changeStartCodeSize ) {
+  printf( "isAvc = %d isVvc = %d \n", isAvc, isVvc );
+  byteStreamView_ = false;
+  if ( !emulationPreventionBytes ) {
+    std::vector<PCCVideoByteStreamSegment> segments;
+    getSampleStreamSegments( isAvc, isVvc, precision, segments );
+    std::vector<uint8_t> data( segments.empty() ? 0 : segments.back().position_ + segments.back().size_ );
+    for ( auto& segment : segments ) { memcpy( data.data() + segment.position_, segment.data_, segment.size_ ); }
+    data_.swap( data );
+    begin_ = 0;
+    return;
+  }
+  vector();
   size_t               sizeStartCode = 4, startIndex = 0, endIndex = 0;
   std::vector<uint8_t> data;
   bool                 newFrame = true;
-  printf( "isAvc = %d isVvc = %d \n", isAvc, isVvc );
   do {
     int32_t naluSize = 0;
     for ( size_t i = 0; i < precision; i++ ) { naluSize = ( naluSize << 8 ) + data_[startIndex + i]; }
@@ -171,6 +187,112 @@ void PCCVideoBitstream::sampleStreamToByteStream( bool   isAvc,
   data_.swap( data );
 }
 
+void PCCVideoBitstream::setByteStreamView( bool isAvc, bool isVvc, size_t precision ) {
+  printf( "isAvc = %d isVvc = %d (byte stream view) \n", isAvc, isVvc );
+  byteStreamView_ = true;
+  viewIsAvc_      = isAvc;
+  viewIsVvc_      = isVvc;
+  viewPrecision_  = precision;
+}
+
+void PCCVideoBitstream::getByteStreamSegments( std::vector<PCCVideoByteStreamSegment>& segments ) {
+  if ( byteStreamView_ ) {
+    getSampleStreamSegments( viewIsAvc_, viewIsVvc_, viewPrecision_, segments );
+  } else {
+    segments.assign( 1, {data_.data() + begin_, data_.size() - begin_, 0} );
+  }
+}
+
+// The NAL units of the sample stream, each preceded by the start code sampleStreamToByteStream() gives it: 4 bytes
+// for the first one, for the AVC ones and for the parameter sets, 3 bytes for the others of a frame.
+void PCCVideoBitstream::getSampleStreamSegments( bool                                    isAvc,
+                                                 bool                                    isVvc,
+                                                 size_t                                  precision,
+                                                 std::vector<PCCVideoByteStreamSegment>& segments ) const {
+  static const uint8_t startCode[4] = {0x00, 0x00, 0x00, 0x01};
+  const uint8_t*       data         = data_.data() + begin_;
+  const size_t         size         = data_.size() - begin_;
+  size_t               sizeStartCode = 4, startIndex = 0, position = 0;
+  bool                 newFrame      = true;
+  segments.clear();
+  while ( startIndex + precision <= size ) {
+    size_t naluSize = 0;
+    for ( size_t i = 0; i < precision; i++ ) { naluSize = ( naluSize << 8 ) + data[startIndex + i]; }
+    naluSize = ( std::min )( naluSize, size - startIndex - precision );
+    segments.push_back( {startCode + 4 - sizeStartCode, sizeStartCode, position} );
+    position += sizeStartCode;
+    segments.push_back( {data + startIndex + precision, naluSize, position} );
+    position += naluSize;
+    startIndex += precision + naluSize;
+    if ( ( startIndex + precision ) < size ) {
+      int  naluType         = 0;
+      bool useLongStartCode = false;
+      newFrame              = false;
+      if ( isAvc ) {
+        useLongStartCode = true;
+      } else if ( isVvc ) {
+        naluType         = ( ( ( data[startIndex + precision + 1] ) & 248 ) >> 3 );
+        useLongStartCode = newFrame || ( naluType >= 12 && naluType < 20 );
+        if ( naluType < 12 ) { newFrame = true; }
+      } else {
+        naluType         = ( ( ( data[startIndex + precision] ) & 126 ) >> 1 );
+        useLongStartCode = newFrame || ( naluType >= 32 && naluType < 41 );
+        if ( naluType < 12 ) { newFrame = true; }
+      }
+      sizeStartCode = useLongStartCode ? 4 : 3;
+    }
+  }
+}
+
+PCCVideoByteStreamBuf::PCCVideoByteStreamBuf( PCCVideoBitstream& bitstream ) : segment_( 0 ), size_( 0 ) {
+  bitstream.getByteStreamSegments( segments_ );
+  if ( !segments_.empty() ) { size_ = segments_.back().position_ + segments_.back().size_; }
+  setSegment( 0, 0 );
+}
+
+void PCCVideoByteStreamBuf::setSegment( size_t index, size_t offset ) {
+  segment_ = index;
+  if ( index < segments_.size() ) {
+    auto* data = reinterpret_cast<char*>( const_cast<uint8_t*>( segments_[index].data_ ) );
+    setg( data, data + offset, data + segments_[index].size_ );
+  } else {
+    setg( nullptr, nullptr, nullptr );
+  }
+}
+
+PCCVideoByteStreamBuf::int_type PCCVideoByteStreamBuf::underflow() {
+  while ( gptr() == egptr() && segment_ < segments_.size() ) { setSegment( segment_ + 1, 0 ); }
+  return gptr() == egptr() ? traits_type::eof() : traits_type::to_int_type( *gptr() );
+}
+
+PCCVideoByteStreamBuf::pos_type PCCVideoByteStreamBuf::seekoff( off_type                offset,
+                                                                std::ios_base::seekdir  dir,
+                                                                std::ios_base::openmode which ) {
+  off_type base = 0;
+  if ( dir == std::ios_base::cur ) {
+    base = segment_ < segments_.size() ? segments_[segment_].position_ + ( gptr() - eback() ) : size_;
+  } else if ( dir == std::ios_base::end ) {
+    base = size_;
+  }
+  return seekpos( pos_type( base + offset ), which );
+}
+
+PCCVideoByteStreamBuf::pos_type PCCVideoByteStreamBuf::seekpos( pos_type position, std::ios_base::openmode which ) {
+  const off_type offset = position;
+  if ( ( which & std::ios_base::in ) == 0 || offset < 0 || offset > off_type( size_ ) ) { return pos_type( -1 ); }
+  // the last segment starting at or before the position
+  auto segment = std::upper_bound(
+      segments_.begin(), segments_.end(), size_t( offset ),
+      []( size_t value, const PCCVideoByteStreamSegment& segment ) { return value < segment.position_; } );
+  if ( segment == segments_.begin() ) {
+    setSegment( 0, 0 );
+  } else {
+    --segment;
+    setSegment( segment - segments_.begin(), ( std::min )( size_t( offset ) - segment->position_, segment->size_ ) );
+  }
+  return position;
+}
+
 size_t PCCVideoBitstream::getEndOfNaluPosition( size_t startIndex ) {
   const size_t size = data_.size();
   if ( size < startIndex + 4 ) { return size; }
@@ -80,6 +80,7 @@ class EndOfSequenceRbsp;
 class EndOfAtlasSubBitstreamRbsp;
 class FillerDataRbsp;
 class V3CUnit;
+class V3CUnitIndex;
 class VpsVpccExtension;
 class AspsVpccExtension;
 class AfpsVpccExtension;
@@ -93,7 +94,14 @@ class PCCBitstreamReader {
   ~PCCBitstreamReader();
 
   static size_t read( PCCBitstream& bitstream, SampleStreamV3CUnit& ssvu );
+  // records the position, type and GOF of each V3C unit in index
+  static size_t read( PCCBitstream& bitstream, SampleStreamV3CUnit& ssvu, V3CUnitIndex& index );
+  // reads only the V3C units of the GOFs from gofIndex on, where index says they are; an index of another stream
+  // is rebuilt first
+  static size_t read( PCCBitstream& bitstream, SampleStreamV3CUnit& ssvu, V3CUnitIndex& index, size_t gofIndex );
   int32_t       decode( SampleStreamV3CUnit& ssvu, PCCHighLevelSyntax& syntax );
+  // also counts the atlas frames of the GOF in index
+  int32_t decode( SampleStreamV3CUnit& ssvu, PCCHighLevelSyntax& syntax, V3CUnitIndex& index, size_t gofIndex );
 
 #ifdef BITSTREAM_TRACE
   void setLogger( PCCLogger& logger ) { logger_ = &logger; }
@@ -376,6 +384,9 @@ class PCCBitstreamReader {
 
   // C.2.2  Sample stream V3C unit syntax
   static void sampleStreamV3CUnit( PCCBitstream& bitstream, SampleStreamV3CUnit& ssvu, V3CUnit& v3cUnit );
+  static bool isIrapAtlasData( V3CUnit& v3cUnit );
+  // the atlas tile data units of an atlas sub-bitstream, each read from its own copy of its NAL unit
+  void atlasTileDataUnits( PCCHighLevelSyntax& syntax );
 
   // D.2 Sample stream NAL unit syntax and semantics
   // D.2.1 Sample stream NAL header syntax
@@ -500,6 +511,10 @@ class PCCBitstreamReader {
   int32_t predPatchIndex_;
   int32_t prevFrameIndex_;
 
+  // the atlas tile data units left to parse once all the NAL units of the atlas sub-bitstream have been read,
+  // along with the indexes of their atlas tile layers
+  std::vector<std::shared_ptr<PCCBitstream>> tileDataBitstreams_;
+  std::vector<size_t>                        tileDataAtglIndexes_;
 #ifdef BITSTREAM_TRACE
   PCCLogger* logger_ = nullptr;
 #endif
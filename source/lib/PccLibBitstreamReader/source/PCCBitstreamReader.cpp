@@ -36,8 +36,10 @@
 #include "PCCHighLevelSyntax.h"
 #include "PCCAtlasAdaptationParameterSetRbsp.h"
 #include "PCCAccessUnitDelimiterRbsp.h"
+#include "PCCV3CUnitIndex.h"
 
 #include "PCCBitstreamReader.h"
+#include <tbb/tbb.h>
 
 using namespace pcc;
 
@@ -50,25 +52,85 @@ PCCBitstreamReader::~PCCBitstreamReader() = default;
 
 // B.2  Sample stream V3C unit syntax
 size_t PCCBitstreamReader::read( PCCBitstream& bitstream, SampleStreamV3CUnit& ssvu ) {
+  V3CUnitIndex index;
+  return read( bitstream, ssvu, index );
+}
+
+size_t PCCBitstreamReader::read( PCCBitstream& bitstream, SampleStreamV3CUnit& ssvu, V3CUnitIndex& index ) {
   size_t headerSize = 0;
   TRACE_BITSTREAM( "%s \n", "PCCBitstreamXXcoder: SampleStream Vpcc Unit start" );
+  index.clear();
+  index.setStreamSize( bitstream.capacity() );
   sampleStreamV3CHeader( bitstream, ssvu );
   headerSize++;
+  index.setSsvhUnitSizePrecisionBytesMinus1( ssvu.getSsvhUnitSizePrecisionBytesMinus1() );
   TRACE_BITSTREAM( "UnitSizePrecisionBytesMinus1 %d <=> bytesToRead %d\n", ssvu.getSsvhUnitSizePrecisionBytesMinus1(),
                    ( 8 * ( ssvu.getSsvhUnitSizePrecisionBytesMinus1() + 1 ) ) );
   size_t unitCount = 0;
+  bool   atlasData = false;
   printf( "PCCBitstreamReader read: \n" );
   while ( bitstream.moreData() ) {
     auto& v3cUnit = ssvu.addV3CUnit();
     sampleStreamV3CUnit( bitstream, ssvu, v3cUnit );
     TRACE_BITSTREAM( "V3C Unit Size(%zuth/%zu)  = %zu \n", unitCount, ssvu.getV3CUnitCount(), v3cUnit.getSize() );
+    index.addUnit( bitstream.getPosition().bytes_ - v3cUnit.getSize(), v3cUnit.getSize(), v3cUnit.getType() );
+    if ( v3cUnit.getType() == V3C_VPS ) { atlasData = false; }
+    if ( v3cUnit.getType() == V3C_AD && !atlasData ) {
+      index.setIrap( isIrapAtlasData( v3cUnit ) );
+      atlasData = true;
+    }
     unitCount++;
     headerSize += ssvu.getSsvhUnitSizePrecisionBytesMinus1() + 1;
   }
+  index.setHeaderSize( headerSize );
   TRACE_BITSTREAM( "%s \n", "PCCBitstreamXXcoder: SampleStream Vpcc Unit start done" );
   return headerSize;
 }
 
+size_t PCCBitstreamReader::read( PCCBitstream&        bitstream,
+                                 SampleStreamV3CUnit& ssvu,
+                                 V3CUnitIndex&        index,
+                                 size_t               gofIndex ) {
+  if ( index.getStreamSize() != bitstream.capacity() || index.getGofCount() == 0 ) {
+    // not the index of this stream: parse the whole of it again and drop the units ahead of the GOF
+    size_t headerSize = read( bitstream, ssvu, index );
+    if ( gofIndex < index.getGofCount() ) {
+      for ( size_t i = 0; i < index.getGof( gofIndex ).firstUnit_; i++ ) { ssvu.popFront(); }
+    } else {
+      while ( ssvu.getV3CUnitCount() > 0 ) { ssvu.popFront(); }
+    }
+    return headerSize;
+  }
+  printf( "PCCBitstreamReader read: from GOF %zu \n", gofIndex );
+  ssvu.setSsvhUnitSizePrecisionBytesMinus1( index.getSsvhUnitSizePrecisionBytesMinus1() );
+  if ( gofIndex >= index.getGofCount() ) { return index.getHeaderSize(); }
+  for ( size_t i = index.getGof( gofIndex ).firstUnit_; i < index.getUnitCount(); i++ ) {
+    auto& entry   = index.getUnit( i );
+    auto& v3cUnit = ssvu.addV3CUnit();
+    v3cUnit.setSize( entry.size_ );
+    v3cUnit.getBitstream().copyFrom( bitstream, entry.position_, entry.size_ );
+    v3cUnit.setType( entry.type_ );
+  }
+  return index.getHeaderSize();
+}
+
+// The first ACL NAL unit of an atlas sub-bitstream, read from the NAL unit headers only
+bool PCCBitstreamReader::isIrapAtlasData( V3CUnit& v3cUnit ) {
+  const uint8_t* data = v3cUnit.getBitstream().buffer();
+  const size_t   size = v3cUnit.getSize();
+  // 4 bytes of V3C unit header, then the sample stream NAL header
+  if ( size < 5 ) { return false; }
+  size_t precision = ( data[4] >> 5 ) + 1;
+  for ( size_t position = 5; position + precision + 1 < size; ) {
+    size_t naluSize = 0;
+    for ( size_t i = 0; i < precision; i++ ) { naluSize = ( naluSize << 8 ) + data[position + i]; }
+    auto naluType = static_cast<NalUnitType>( ( data[position + precision] >> 1 ) & 0x3F );
+    if ( naluType <= NAL_RSV_ACL_35 ) { return naluType >= NAL_BLA_W_LP && naluType <= NAL_RSV_IRAP_ACL_29; }
+    position += precision + naluSize;
+  }
+  return false;
+}
+
 int32_t PCCBitstreamReader::decode( SampleStreamV3CUnit& ssvu, PCCHighLevelSyntax& syntax ) {
   printf( "PCCBitstreamReader decode: \n" );
   bool  endOfGop     = false;
@@ -97,6 +159,25 @@ int32_t PCCBitstreamReader::decode( SampleStreamV3CUnit& ssvu, PCCHighLevelSynta
   return 1;
 }
 
+int32_t PCCBitstreamReader::decode( SampleStreamV3CUnit& ssvu,
+                                    PCCHighLevelSyntax&  syntax,
+                                    V3CUnitIndex&        index,
+                                    size_t               gofIndex ) {
+  int32_t ret = decode( ssvu, syntax );
+  // the tiles of an atlas frame follow each other and share its atlas frame order count
+  auto&  atlList         = syntax.getAtlasTileLayerList();
+  size_t atlasFrameCount = 0;
+  for ( size_t i = 0; i < atlList.size(); i++ ) {
+    if ( i == 0 ||
+         atlList[i].getHeader().getAtlasFrmOrderCntLsb() != atlList[i - 1].getHeader().getAtlasFrmOrderCntLsb() ) {
+      atlasFrameCount++;
+    }
+  }
+  index.setAtlasFrameCount( gofIndex, atlasFrameCount );
+  return ret;
+}
+
+// The V3C unit is dropped once parsed, so its buffer is handed over to the video bitstream rather than copied.
 void PCCBitstreamReader::videoSubStream( PCCHighLevelSyntax& syntax,
                                          PCCBitstream&       bitstream,
                                          V3CUnitType&        V3CUnitType,
@@ -107,24 +188,24 @@ void PCCBitstreamReader::videoSubStream( PCCHighLevelSyntax& syntax,
   auto&  bistreamStat = syntax.getBitstreamStat();
   if ( V3CUnitType == V3C_OVD ) {
     TRACE_BITSTREAM( "%s \n", "OccupancyMap" );
-    bitstream.readVideoStream( syntax.createVideoBitstream( VIDEO_OCCUPANCY ), V3CPayloadSize );
+    bitstream.takeVideoStream( syntax.createVideoBitstream( VIDEO_OCCUPANCY ), V3CPayloadSize );
     bistreamStat.setVideoBinSize( VIDEO_OCCUPANCY, syntax.getVideoBitstream( VIDEO_OCCUPANCY ).size() );
   } else if ( V3CUnitType == V3C_GVD ) {
     auto& vuh = syntax.getV3CUnitHeader( static_cast<size_t>( V3C_GVD ) - 1 );
     if ( vuh.getAuxiliaryVideoFlag() ) {
       TRACE_BITSTREAM( "%s \n", "Geometry RAW" );
-      bitstream.readVideoStream( syntax.createVideoBitstream( VIDEO_GEOMETRY_RAW ), V3CPayloadSize );
+      bitstream.takeVideoStream( syntax.createVideoBitstream( VIDEO_GEOMETRY_RAW ), V3CPayloadSize );
       bistreamStat.setVideoBinSize( VIDEO_GEOMETRY_RAW, syntax.getVideoBitstream( VIDEO_GEOMETRY_RAW ).size() );
     } else {
       auto& vps = syntax.getVps();
       if ( vps.getMapCountMinus1( atlasIndex ) > 0 && vps.getMultipleMapStreamsPresentFlag( atlasIndex ) ) {
         auto geometryIndex = static_cast<PCCVideoType>( VIDEO_GEOMETRY_D0 + vuh.getMapIndex() );
         TRACE_BITSTREAM( "Geometry MAP: %d\n", vuh.getMapIndex() );
-        bitstream.readVideoStream( syntax.createVideoBitstream( geometryIndex ), V3CPayloadSize );
+        bitstream.takeVideoStream( syntax.createVideoBitstream( geometryIndex ), V3CPayloadSize );
         bistreamStat.setVideoBinSize( geometryIndex, syntax.getVideoBitstream( geometryIndex ).size() );
       } else {
         TRACE_BITSTREAM( "%s \n", "Geometry" );
-        bitstream.readVideoStream( syntax.createVideoBitstream( VIDEO_GEOMETRY ), V3CPayloadSize );
+        bitstream.takeVideoStream( syntax.createVideoBitstream( VIDEO_GEOMETRY ), V3CPayloadSize );
         bistreamStat.setVideoBinSize( VIDEO_GEOMETRY, syntax.getVideoBitstream( VIDEO_GEOMETRY ).size() );
       }
     }
@@ -135,19 +216,19 @@ void PCCBitstreamReader::videoSubStream( PCCHighLevelSyntax& syntax,
       if ( vuh.getAuxiliaryVideoFlag() ) {
         auto attributeIndex = static_cast<PCCVideoType>( VIDEO_ATTRIBUTE_RAW + vuh.getAttributeDimensionIndex() );
         TRACE_BITSTREAM( "Attribute RAW, PARTITION: %d\n", vuh.getAttributeDimensionIndex() );
-        bitstream.readVideoStream( syntax.createVideoBitstream( attributeIndex ), V3CPayloadSize );
+        bitstream.takeVideoStream( syntax.createVideoBitstream( attributeIndex ), V3CPayloadSize );
         bistreamStat.setVideoBinSize( attributeIndex, syntax.getVideoBitstream( attributeIndex ).size() );
       } else {
         if ( vps.getMapCountMinus1( atlasIndex ) > 0 && vps.getMultipleMapStreamsPresentFlag( atlasIndex ) ) {
           auto attributeIndex = static_cast<PCCVideoType>(
               VIDEO_ATTRIBUTE_T0 + vuh.getMapIndex() * MAX_NUM_ATTR_PARTITIONS + vuh.getAttributeDimensionIndex() );
           TRACE_BITSTREAM( "Attribute MAP: %d, PARTITION: %d\n", vuh.getMapIndex(), vuh.getAttributeDimensionIndex() );
-          bitstream.readVideoStream( syntax.createVideoBitstream( attributeIndex ), V3CPayloadSize );
+          bitstream.takeVideoStream( syntax.createVideoBitstream( attributeIndex ), V3CPayloadSize );
           bistreamStat.setVideoBinSize( attributeIndex, syntax.getVideoBitstream( attributeIndex ).size() );
         } else {
           auto attributeIndex = static_cast<PCCVideoType>( VIDEO_ATTRIBUTE + vuh.getAttributeDimensionIndex() );
           TRACE_BITSTREAM( "Attribute PARTITION: %d\n", vuh.getAttributeDimensionIndex() );
-          bitstream.readVideoStream( syntax.createVideoBitstream( attributeIndex ), V3CPayloadSize );
+          bitstream.takeVideoStream( syntax.createVideoBitstream( attributeIndex ), V3CPayloadSize );
           bistreamStat.setVideoBinSize( attributeIndex, syntax.getVideoBitstream( attributeIndex ).size() );
         }
       }
@@ -234,6 +315,8 @@ void PCCBitstreamReader::atlasSubStream( PCCHighLevelSyntax& syntax, PCCBitstrea
   SampleStreamNalUnit ssnu;
   sampleStreamNalHeader( bitstream, ssnu );
   PCCSEI prefixSEI;  // list to store the prefix sei message, this list will be copy in the next ATGL.
+  tileDataBitstreams_.clear();
+  tileDataAtglIndexes_.clear();
   while ( bitstream.size() < sizeBitstream ) {
     ssnu.addNalUnit();
     sampleStreamNalUnit( syntax, bitstream, ssnu, ssnu.getNalUnit().size() - 1, prefixSEI );
@@ -244,6 +327,33 @@ void PCCBitstreamReader::atlasSubStream( PCCHighLevelSyntax& syntax, PCCBitstrea
                      bitstream.size() );
 #endif
   }
+  atlasTileDataUnits( syntax );
+}
+
+// The atlas tile data units only depend on the parameter sets and on the header of their tile, and are parsed in
+// parallel, each by its own reader. With point local reconstruction, an inter patch refers to the patches of the
+// tile parsed before it, so they are parsed in order.
+void PCCBitstreamReader::atlasTileDataUnits( PCCHighLevelSyntax& syntax ) {
+  auto& atlList = syntax.getAtlasTileLayerList();
+  bool  serial  = tileDataBitstreams_.size() < 2;
+  for ( size_t i = 0; i < syntax.getAtlasSequenceParameterSetList().size() && !serial; i++ ) {
+    serial = syntax.getAtlasSequenceParameterSetList()[i].getPLREnabledFlag();
+  }
+  auto parse = [&]( PCCBitstreamReader& reader, size_t i ) {
+    auto& atgl = atlList[tileDataAtglIndexes_[i]];
+    reader.atlasTileDataUnit( atgl.getDataUnit(), atgl.getHeader(), syntax, *tileDataBitstreams_[i] );
+    reader.rbspTrailingBits( *tileDataBitstreams_[i] );
+  };
+  if ( serial ) {
+    for ( size_t i = 0; i < tileDataBitstreams_.size(); i++ ) { parse( *this, i ); }
+  } else {
+    tbb::parallel_for( size_t( 0 ), tileDataBitstreams_.size(), [&]( const size_t i ) {
+      PCCBitstreamReader reader;
+      parse( reader, i );
+    } );
+  }
+  tileDataBitstreams_.clear();
+  tileDataAtglIndexes_.clear();
 }
 // 8.3.3 Byte alignment syntax
 void PCCBitstreamReader::byteAlignment( PCCBitstream& bitstream ) {
@@ -1406,6 +1516,9 @@ void PCCBitstreamReader::sampleStreamNalUnit( PCCHighLevelSyntax&  syntax,
   TRACE_BITSTREAM( "UnitSizePrecisionBytesMinus1 = %lu \n", ssnu.getSizePrecisionBytesMinus1() );
   nalu.setSize( bitstream.read( 8 * ( ssnu.getSizePrecisionBytesMinus1() + 1 ) ) );  // u(v)
   nalu.allocate();
+#ifndef BITSTREAM_TRACE
+  const uint64_t naluEnd = bitstream.getPosition().bytes_ + nalu.getSize();
+#endif
   nalUnitHeader( bitstream, nalu );
   printf( "      sampleStreamNalUnit %3zu type = %3zu %s \n", index, (size_t)nalu.getType(),
           toString( nalu.getType() ).c_str() );
@@ -1425,11 +1538,28 @@ void PCCBitstreamReader::sampleStreamNalUnit( PCCHighLevelSyntax&  syntax,
     case NAL_RASL_R:
     case NAL_SKIP_N:
     case NAL_SKIP_R:
-    case NAL_IDR_N_LP:
+    case NAL_IDR_N_LP: {
+#ifdef BITSTREAM_TRACE
       atlasTileLayerRbsp( syntax.addAtlasTileLayer(), syntax, nalu.getType(), bitstream );
+#else
+      // the data unit is copied out with the bits of the NAL unit left after the header, and parsed by
+      // atlasTileDataUnits()
+      auto& atgl = syntax.addAtlasTileLayer();
+      atlasTileHeader( atgl.getHeader(), syntax, nalu.getType(), bitstream );
+      auto position      = bitstream.getPosition();
+      auto tileBitstream = std::make_shared<PCCBitstream>();
+      tileBitstream->copyFrom( bitstream, position.bytes_, naluEnd - position.bytes_ );
+      PCCBistreamPosition tilePosition = {0, position.bits_};
+      tileBitstream->setPosition( tilePosition );
+      tileDataBitstreams_.push_back( tileBitstream );
+      tileDataAtglIndexes_.push_back( syntax.getAtlasTileLayerList().size() - 1 );
+      PCCBistreamPosition endPosition = {naluEnd, 0};
+      bitstream.setPosition( endPosition );
+#endif
       syntax.getAtlasTileLayerList().back().getSEI().getSeiPrefix() = prefixSEI.getSeiPrefix();
       prefixSEI.getSeiPrefix().clear();
       break;
+    }
     case NAL_PREFIX_ESEI:
     case NAL_PREFIX_NSEI: seiRbsp( syntax, bitstream, nalu.getType(), prefixSEI ); break;
     case NAL_SUFFIX_ESEI:
@@ -73,6 +73,11 @@ size_t PCCBitstreamWriter::write( SampleStreamV3CUnit& ssvu,
   ssvu.setSsvhUnitSizePrecisionBytesMinus1( precision - 1 );
   TRACE_BITSTREAM( " => SsvhUnitSizePrecisionBytesMinus1 = %u \n", ssvu.getSsvhUnitSizePrecisionBytesMinus1() );
 
+  // the size of the sample stream is known: it is allocated once and each unit, video payloads included, is copied
+  // straight to its place instead of growing the stream unit by unit
+  size_t streamSize = 1;
+  for ( auto& v3cUnit : ssvu.getV3CUnit() ) { streamSize += precision + v3cUnit.getSize(); }
+  bitstream.reserve( streamSize );
   sampleStreamV3CHeader( bitstream, ssvu );
   headerSize += 1;
   TRACE_BITSTREAM( "UnitSizePrecisionBytesMinus1 %d <=> bytesToRead %d\n", precision,
@@ -410,6 +415,12 @@ void PCCBitstreamWriter::atlasSubStream( PCCHighLevelSyntax& syntax, PCCBitstrea
   uint32_t precision = static_cast<uint32_t>(
       min( max( static_cast<int>( ceil( static_cast<double>( ceilLog2( maxUnitSize + 1 ) ) / 8.0 ) ), 1 ), 8 ) - 1 );
   ssnu.setSizePrecisionBytesMinus1( precision );
+  // the sizes of the NAL units are known from the pass above: the sub-bitstream is allocated once
+  size_t nalUnitCount = aspsSizeList.size() + afpsSizeList.size() + atglSize;
+  for ( size_t atglIndex = 0; atglIndex < atglSize; atglIndex++ ) {
+    nalUnitCount += seiPrefixSizeList[atglIndex].size() + seiSuffixSizeList[atglIndex].size();
+  }
+  bitstream.reserve( 1 + lastSize + nalUnitCount * ( precision + 1 + nalHeaderSize ) );
   sampleStreamNalHeader( bitstream, ssnu );
   for ( size_t aspsCount = 0; aspsCount < syntax.getAtlasSequenceParameterSetList().size(); aspsCount++ ) {
     NalUnit nu( NAL_ASPS, 0, 1 );
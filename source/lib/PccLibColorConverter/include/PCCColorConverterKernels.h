@@ -0,0 +1,93 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCColorConverterKernels_h
+#define PCCColorConverterKernels_h
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pcc {
+
+// Vectorized loops of PCCInternalColorConverter. The AVX2 versions are picked at run time; every function
+// returns how many leading samples it produced (0 when AVX2 is not available) and leaves the rest to the
+// scalar code. The operations and their order are the scalar ones, so the results are bit exact.
+
+bool hasAvx2();
+
+// dst = clamp( (float)( weight * (double)( src - offset ) ), minValue, maxValue )
+size_t toFloatKernel( const uint8_t* src, float* dst, size_t count, int offset, double weight, float minValue,
+                      float maxValue );
+size_t toFloatKernel( const uint16_t* src, float* dst, size_t count, int offset, double weight, float minValue,
+                      float maxValue );
+
+// dst = clip( round( (float)( scale * (double)src + offset ) ), 0, scale )
+size_t toFixedKernel( const float* src, uint8_t* dst, size_t count, double scale, double offset );
+size_t toFixedKernel( const float* src, uint16_t* dst, size_t count, double scale, double offset );
+
+// dst = (float)src / scale
+size_t rgbToFloatKernel( const uint8_t* src, float* dst, size_t count, float scale );
+size_t rgbToFloatKernel( const uint16_t* src, float* dst, size_t count, float scale );
+
+// dst = clip( round( scale * src ), 0, scale )
+size_t floatToRgbKernel( const float* src, uint8_t* dst, size_t count, float scale );
+size_t floatToRgbKernel( const float* src, uint16_t* dst, size_t count, float scale );
+
+// BT.709 matrices of convertRGBToYUV and convertYUVToRGB
+size_t rgbToYuvKernel( const float* r, const float* g, const float* b, float* y, float* u, float* v, size_t count );
+size_t yuvToRgbKernel( const float* y, const float* u, const float* v, float* r, float* g, float* b, size_t count );
+
+// dst[j] = ( sum_k taps[k] * rows[k][j] ) * scale, accumulated in float
+size_t filterColumnsKernel( const float* const* rows, const float* taps, int size, float scale, float* dst,
+                            size_t count );
+// same, accumulated in double
+size_t filterColumnsKernel( const float* const* rows, const float* taps, int size, double scale, float* dst,
+                            size_t count );
+
+// dst[2j] = ( sum_k taps0[k] * src0[j + k] ) * scale0, dst[2j + 1] = ( sum_k taps1[k] * src1[j + k] ) * scale1
+size_t upsampleRowKernel( const float* src0,
+                          const float* taps0,
+                          int          size0,
+                          float        scale0,
+                          const float* src1,
+                          const float* taps1,
+                          int          size1,
+                          float        scale1,
+                          float*       dst,
+                          size_t       count );
+
+// dst[j] = ( sum_k taps[k] * src[2j + k] ) * scale, accumulated in double
+size_t downsampleRowKernel( const float* src, const float* taps, int size, double scale, float* dst, size_t count );
+
+};  // namespace pcc
+
+#endif /* PCCColorConverterKernels_h */
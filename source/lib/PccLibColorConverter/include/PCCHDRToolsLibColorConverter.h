@@ -45,7 +45,9 @@ namespace pcc {
 template <class T>
 class PCCHDRToolsLibColorConverter : public PCCVirtualColorConverter<T> {
  public:
-  PCCHDRToolsLibColorConverter();
+  // frameThreads: frames converted concurrently, each with an HDRTools context of its own; 0 for as many as the task
+  // scheduler has threads.
+  PCCHDRToolsLibColorConverter( size_t frameThreads = 0 );
   ~PCCHDRToolsLibColorConverter();
   void convert( std::string        configuration,
                 PCCVideo<T, 3>&    videoSrc,
@@ -61,6 +63,9 @@ class PCCHDRToolsLibColorConverter : public PCCVirtualColorConverter<T> {
                 PCCVideo<T, 3>&    videoDst,
                 const std::string& externalPath = "",
                 const std::string& fileName     = "" );
+
+ private:
+  size_t frameThreads_;
 };
 
 };  // namespace pcc
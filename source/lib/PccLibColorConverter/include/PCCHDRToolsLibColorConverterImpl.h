@@ -64,16 +64,26 @@
 
 namespace pcc {
 
+// One HDRTools conversion context: the frame stores and processing objects of one thread. The parameters are the
+// global ones of HDRTools, read by configure() and shared read-only by all the contexts once they are initialized.
 template <class T>
 class PCCHDRToolsLibColorConverterImpl {
  public:
   PCCHDRToolsLibColorConverterImpl();
   ~PCCHDRToolsLibColorConverterImpl();
-  void convert( std::string configFile, PCCVideo<T, 3>& videoSrc, PCCVideo<T, 3>& videoDst );
+  static ProjectParameters* configure( std::string configFile, PCCVideo<T, 3>& videoSrc );
+
+  // init() updates the parameters and must not run concurrently with any other context; only one context opens the
+  // output file of the configuration.
+  void init( ProjectParameters* inputParams, bool openOutputFile );
+  // Converts the frames [frameBegin, frameEnd) into videoDst, which already holds all the frames.
+  void process( ProjectParameters* inputParams,
+                PCCVideo<T, 3>&    videoSrc,
+                PCCVideo<T, 3>&    videoDst,
+                size_t             frameBegin,
+                size_t             frameEnd );
 
  private:
-  void init( ProjectParameters* inputParams );
-  void process( ProjectParameters* inputParams, PCCVideo<T, 3>& videoSrc, PCCVideo<T, 3>& videoDst );
   void destroy();
 
   int                 m_nFrameStores;
@@ -78,7 +78,13 @@ class PCCInternalColorConverter : public PCCVirtualColorConverter<T> {
   void upsample( PCCVideo<T, 3>& video, size_t rate, size_t nbyte, size_t filter );
   void upsample( PCCImage<T, 3>& image, size_t rate, size_t nbyte, size_t filter );
 
+  // Internal configuration ("YUV420ToYUV444_<bitdepth>_<filter>") giving the same samples as the HDRTools
+  // configuration file, or an empty string if the file asks for more than a plain chroma upsampling.
+  static std::string getConfiguration( const std::string& hdrToolsConfigFile );
+
  private:
+  typedef typename PCCImage<T, 3>::Channel Channel;
+
   void extractParameters( std::string& configuration, std::string& config, int32_t& bitdepth, int32_t& filter );
   void convertRGB44ToYUV420( PCCVideo<T, 3>& videoSrc, PCCVideo<T, 3>& videoDst, size_t nbyte, size_t filter );
   void convertRGB44ToYUV420( PCCImage<T, 3>& imageSrc, PCCImage<T, 3>& imageDst, size_t nbyte, size_t filter );
@@ -95,7 +101,7 @@ class PCCInternalColorConverter : public PCCVirtualColorConverter<T> {
   void convertYUV444ToRGB444( PCCVideo<T, 3>& videoSrc, PCCVideo<T, 3>& videoDst, size_t nbyte, size_t filter );
   void convertYUV444ToRGB444( PCCImage<T, 3>& imageSrc, PCCImage<T, 3>& imageDst, size_t nbyte, size_t filter );
 
-  void RGBtoFloatRGB( const std::vector<T>& src, std::vector<float>& dst, const size_t nbyte ) const;
+  void RGBtoFloatRGB( const Channel& src, std::vector<float>& dst, const size_t nbyte ) const;
 
   void convertRGBToYUV( const std::vector<float>& R,
                         const std::vector<float>& G,
@@ -114,12 +120,12 @@ class PCCInternalColorConverter : public PCCVirtualColorConverter<T> {
   static inline float fClip( float x, float low, float high ) { return fMin( fMax( x, low ), high ); }
 
   // TODO: This currently can't handle 10-bit. A new parameter is needed.
-  void floatYUVToYUV( const std::vector<float>& src, std::vector<T>& dst, const bool chroma, const size_t nbyte ) const;
+  void floatYUVToYUV( const std::vector<float>& src, Channel& dst, const bool chroma, const size_t nbyte ) const;
 
-  void YUVtoFloatYUV( const std::vector<T>& src,
-                      std::vector<float>&   dst,
-                      const bool            chroma,
-                      const size_t          nbBytes ) const;
+  void YUVtoFloatYUV( const Channel&       src,
+                      std::vector<float>& dst,
+                      const bool          chroma,
+                      const size_t        nbBytes ) const;
 
   void convertYUVToRGB( const std::vector<float>& Y,
                         const std::vector<float>& U,
@@ -128,7 +134,7 @@ class PCCInternalColorConverter : public PCCVirtualColorConverter<T> {
                         std::vector<float>&       G,
                         std::vector<float>&       B ) const;
 
-  void floatRGBToRGB( const std::vector<float>& src, std::vector<T>& dst, const size_t nbyte ) const;
+  void floatRGBToRGB( const std::vector<float>& src, Channel& dst, const size_t nbyte ) const;
 
   void downsampling( const std::vector<float>& chroma_in,
                      std::vector<float>&       chroma_out,
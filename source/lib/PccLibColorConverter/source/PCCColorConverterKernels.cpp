@@ -0,0 +1,437 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCColorConverterKernels.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#define PCC_KERNELS_AVX2
+#include <immintrin.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define PCC_TARGET_AVX2
+#else
+#define PCC_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#endif
+#endif
+
+using namespace pcc;
+
+#ifdef PCC_KERNELS_AVX2
+
+static bool detectAvx2() {
+#if defined( _MSC_VER )
+  int info[4];
+  __cpuid( info, 0 );
+  if ( info[0] < 7 ) { return false; }
+  __cpuid( info, 1 );
+  // the OS must save the ymm registers
+  if ( ( info[2] & ( 1 << 27 ) ) == 0 || ( info[2] & ( 1 << 28 ) ) == 0 ) { return false; }
+  if ( ( _xgetbv( 0 ) & 6 ) != 6 ) { return false; }
+  __cpuidex( info, 7, 0 );
+  return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+  return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+}
+
+bool pcc::hasAvx2() {
+  static const bool avx2 = detectAvx2();
+  return avx2;
+}
+
+PCC_TARGET_AVX2 static inline __m256i load8( const uint8_t* src ) {
+  return _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)src ) );
+}
+
+PCC_TARGET_AVX2 static inline __m256i load8( const uint16_t* src ) {
+  return _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i*)src ) );
+}
+
+PCC_TARGET_AVX2 static inline void store8( uint8_t* dst, __m256i value ) {
+  __m128i packed = _mm_packus_epi32( _mm256_castsi256_si128( value ), _mm256_extracti128_si256( value, 1 ) );
+  _mm_storel_epi64( (__m128i*)dst, _mm_packus_epi16( packed, packed ) );
+}
+
+PCC_TARGET_AVX2 static inline void store8( uint16_t* dst, __m256i value ) {
+  _mm_storeu_si128( (__m128i*)dst,
+                    _mm_packus_epi32( _mm256_castsi256_si128( value ), _mm256_extracti128_si256( value, 1 ) ) );
+}
+
+PCC_TARGET_AVX2 static inline __m256 combine( __m128 low, __m128 high ) {
+  return _mm256_insertf128_ps( _mm256_castps128_ps256( low ), high, 1 );
+}
+
+// std::round(): nearest, halfway cases away from zero; x - trunc( x ) is exact
+PCC_TARGET_AVX2 static inline __m256 roundHalfAway( __m256 x ) {
+  const __m256 one       = _mm256_set1_ps( 1.f );
+  const __m256 truncated = _mm256_round_ps( x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC );
+  const __m256 fraction  = _mm256_sub_ps( x, truncated );
+  const __m256 up        = _mm256_and_ps( _mm256_cmp_ps( fraction, _mm256_set1_ps( 0.5f ), _CMP_GE_OQ ), one );
+  const __m256 down      = _mm256_and_ps( _mm256_cmp_ps( fraction, _mm256_set1_ps( -0.5f ), _CMP_LE_OQ ), one );
+  return _mm256_sub_ps( _mm256_add_ps( truncated, up ), down );
+}
+
+// clamp( v, a, b ) = v < a ? a : ( v > b ? b : v ): max/min return their second operand unless the first wins
+PCC_TARGET_AVX2 static inline __m256 clamp( __m256 v, __m256 a, __m256 b ) {
+  return _mm256_min_ps( b, _mm256_max_ps( a, v ) );
+}
+
+PCC_TARGET_AVX2 static inline __m256d clamp( __m256d v, __m256d a, __m256d b ) {
+  return _mm256_min_pd( b, _mm256_max_pd( a, v ) );
+}
+
+template <typename T>
+PCC_TARGET_AVX2 static size_t toFloatAvx2( const T*     src,
+                                           float*       dst,
+                                           size_t       count,
+                                           int          offset,
+                                           double       weight,
+                                           float        minValue,
+                                           float        maxValue ) {
+  const __m256i vOffset = _mm256_set1_epi32( offset );
+  const __m256d vWeight = _mm256_set1_pd( weight );
+  const __m256  vMin    = _mm256_set1_ps( minValue );
+  const __m256  vMax    = _mm256_set1_ps( maxValue );
+  size_t        i       = 0;
+  for ( ; i + 8 <= count; i += 8 ) {
+    __m256i value = _mm256_sub_epi32( load8( src + i ), vOffset );
+    __m128  low   = _mm256_cvtpd_ps( _mm256_mul_pd( vWeight, _mm256_cvtepi32_pd( _mm256_castsi256_si128( value ) ) ) );
+    __m128  high =
+        _mm256_cvtpd_ps( _mm256_mul_pd( vWeight, _mm256_cvtepi32_pd( _mm256_extracti128_si256( value, 1 ) ) ) );
+    _mm256_storeu_ps( dst + i, clamp( combine( low, high ), vMin, vMax ) );
+  }
+  return i;
+}
+
+template <typename T>
+PCC_TARGET_AVX2 static size_t toFixedAvx2( const float* src, T* dst, size_t count, double scale, double offset ) {
+  const __m256d vScale  = _mm256_set1_pd( scale );
+  const __m256d vOffset = _mm256_set1_pd( offset );
+  const __m256  vMax    = _mm256_set1_ps( (float)scale );
+  const __m256  vZero   = _mm256_setzero_ps();
+  size_t        i       = 0;
+  for ( ; i + 8 <= count; i += 8 ) {
+    __m256 value = _mm256_loadu_ps( src + i );
+    __m128 low   = _mm256_cvtpd_ps(
+        _mm256_add_pd( _mm256_mul_pd( vScale, _mm256_cvtps_pd( _mm256_castps256_ps128( value ) ) ), vOffset ) );
+    __m128 high = _mm256_cvtpd_ps(
+        _mm256_add_pd( _mm256_mul_pd( vScale, _mm256_cvtps_pd( _mm256_extractf128_ps( value, 1 ) ) ), vOffset ) );
+    // fClip( x, low, high ) = fMin( fMax( x, low ), high )
+    value = _mm256_min_ps( _mm256_max_ps( roundHalfAway( combine( low, high ) ), vZero ), vMax );
+    store8( dst + i, _mm256_cvttps_epi32( value ) );
+  }
+  return i;
+}
+
+template <typename T>
+PCC_TARGET_AVX2 static size_t rgbToFloatAvx2( const T* src, float* dst, size_t count, float scale ) {
+  const __m256 vScale = _mm256_set1_ps( scale );
+  size_t       i      = 0;
+  for ( ; i + 8 <= count; i += 8 ) {
+    _mm256_storeu_ps( dst + i, _mm256_div_ps( _mm256_cvtepi32_ps( load8( src + i ) ), vScale ) );
+  }
+  return i;
+}
+
+template <typename T>
+PCC_TARGET_AVX2 static size_t floatToRgbAvx2( const float* src, T* dst, size_t count, float scale ) {
+  const __m256 vScale = _mm256_set1_ps( scale );
+  const __m256 vZero  = _mm256_setzero_ps();
+  size_t       i      = 0;
+  for ( ; i + 8 <= count; i += 8 ) {
+    __m256 value = roundHalfAway( _mm256_mul_ps( vScale, _mm256_loadu_ps( src + i ) ) );
+    store8( dst + i, _mm256_cvttps_epi32( clamp( value, vZero, vScale ) ) );
+  }
+  return i;
+}
+
+PCC_TARGET_AVX2 static size_t rgbToYuvAvx2( const float* r,
+                                            const float* g,
+                                            const float* b,
+                                            float*       y,
+                                            float*       u,
+                                            float*       v,
+                                            size_t       count ) {
+  const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd( 1.0 );
+  const __m256d minC = _mm256_set1_pd( -0.5 ), maxC = _mm256_set1_pd( 0.5 );
+  size_t        i = 0;
+  for ( ; i + 4 <= count; i += 4 ) {
+    __m256d R  = _mm256_cvtps_pd( _mm_loadu_ps( r + i ) );
+    __m256d G  = _mm256_cvtps_pd( _mm_loadu_ps( g + i ) );
+    __m256d B  = _mm256_cvtps_pd( _mm_loadu_ps( b + i ) );
+    __m256d vY = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( _mm256_set1_pd( 0.212600 ), R ),
+                                               _mm256_mul_pd( _mm256_set1_pd( 0.715200 ), G ) ),
+                                _mm256_mul_pd( _mm256_set1_pd( 0.072200 ), B ) );
+    __m256d vU = _mm256_add_pd( _mm256_sub_pd( _mm256_mul_pd( _mm256_set1_pd( -0.114572 ), R ),
+                                               _mm256_mul_pd( _mm256_set1_pd( 0.385428 ), G ) ),
+                                _mm256_mul_pd( _mm256_set1_pd( 0.500000 ), B ) );
+    __m256d vV = _mm256_sub_pd( _mm256_sub_pd( _mm256_mul_pd( _mm256_set1_pd( 0.500000 ), R ),
+                                               _mm256_mul_pd( _mm256_set1_pd( 0.454153 ), G ) ),
+                                _mm256_mul_pd( _mm256_set1_pd( 0.045847 ), B ) );
+    _mm_storeu_ps( y + i, _mm256_cvtpd_ps( clamp( vY, zero, one ) ) );
+    _mm_storeu_ps( u + i, _mm256_cvtpd_ps( clamp( vU, minC, maxC ) ) );
+    _mm_storeu_ps( v + i, _mm256_cvtpd_ps( clamp( vV, minC, maxC ) ) );
+  }
+  return i;
+}
+
+PCC_TARGET_AVX2 static size_t yuvToRgbAvx2( const float* y,
+                                            const float* u,
+                                            const float* v,
+                                            float*       r,
+                                            float*       g,
+                                            float*       b,
+                                            size_t       count ) {
+  const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd( 1.0 );
+  size_t        i = 0;
+  for ( ; i + 4 <= count; i += 4 ) {
+    __m256d Y  = _mm256_cvtps_pd( _mm_loadu_ps( y + i ) );
+    __m256d U  = _mm256_cvtps_pd( _mm_loadu_ps( u + i ) );
+    __m256d V  = _mm256_cvtps_pd( _mm_loadu_ps( v + i ) );
+    __m256d vR = _mm256_add_pd( Y, _mm256_mul_pd( _mm256_set1_pd( 1.57480 ), V ) );
+    __m256d vG = _mm256_sub_pd( _mm256_sub_pd( Y, _mm256_mul_pd( _mm256_set1_pd( 0.18733 ), U ) ),
+                                _mm256_mul_pd( _mm256_set1_pd( 0.46813 ), V ) );
+    __m256d vB = _mm256_add_pd( Y, _mm256_mul_pd( _mm256_set1_pd( 1.85563 ), U ) );
+    _mm_storeu_ps( r + i, _mm256_cvtpd_ps( clamp( vR, zero, one ) ) );
+    _mm_storeu_ps( g + i, _mm256_cvtpd_ps( clamp( vG, zero, one ) ) );
+    _mm_storeu_ps( b + i, _mm256_cvtpd_ps( clamp( vB, zero, one ) ) );
+  }
+  return i;
+}
+
+PCC_TARGET_AVX2 static size_t filterColumnsAvx2( const float* const* rows,
+                                                 const float*        taps,
+                                                 int                 size,
+                                                 float               scale,
+                                                 float*              dst,
+                                                 size_t              count ) {
+  const __m256 vScale = _mm256_set1_ps( scale );
+  size_t       j      = 0;
+  for ( ; j + 8 <= count; j += 8 ) {
+    __m256 value = _mm256_setzero_ps();
+    for ( int k = 0; k < size; k++ ) {
+      value = _mm256_add_ps( value, _mm256_mul_ps( _mm256_set1_ps( taps[k] ), _mm256_loadu_ps( rows[k] + j ) ) );
+    }
+    _mm256_storeu_ps( dst + j, _mm256_mul_ps( value, vScale ) );
+  }
+  return j;
+}
+
+PCC_TARGET_AVX2 static size_t filterColumnsAvx2( const float* const* rows,
+                                                 const float*        taps,
+                                                 int                 size,
+                                                 double              scale,
+                                                 float*              dst,
+                                                 size_t              count ) {
+  const __m256d vScale = _mm256_set1_pd( scale );
+  size_t        j      = 0;
+  for ( ; j + 4 <= count; j += 4 ) {
+    __m256d value = _mm256_setzero_pd();
+    for ( int k = 0; k < size; k++ ) {
+      value = _mm256_add_pd(
+          value, _mm256_mul_pd( _mm256_set1_pd( (double)taps[k] ), _mm256_cvtps_pd( _mm_loadu_ps( rows[k] + j ) ) ) );
+    }
+    _mm_storeu_ps( dst + j, _mm256_cvtpd_ps( _mm256_mul_pd( value, vScale ) ) );
+  }
+  return j;
+}
+
+PCC_TARGET_AVX2 static size_t upsampleRowAvx2( const float* src0,
+                                               const float* taps0,
+                                               int          size0,
+                                               float        scale0,
+                                               const float* src1,
+                                               const float* taps1,
+                                               int          size1,
+                                               float        scale1,
+                                               float*       dst,
+                                               size_t       count ) {
+  const __m256 vScale0 = _mm256_set1_ps( scale0 );
+  const __m256 vScale1 = _mm256_set1_ps( scale1 );
+  size_t       j       = 0;
+  for ( ; j + 8 <= count; j += 8 ) {
+    __m256 even = _mm256_setzero_ps(), odd = _mm256_setzero_ps();
+    for ( int k = 0; k < size0; k++ ) {
+      even = _mm256_add_ps( even, _mm256_mul_ps( _mm256_set1_ps( taps0[k] ), _mm256_loadu_ps( src0 + j + k ) ) );
+    }
+    for ( int k = 0; k < size1; k++ ) {
+      odd = _mm256_add_ps( odd, _mm256_mul_ps( _mm256_set1_ps( taps1[k] ), _mm256_loadu_ps( src1 + j + k ) ) );
+    }
+    even = _mm256_mul_ps( even, vScale0 );
+    odd  = _mm256_mul_ps( odd, vScale1 );
+    // interleave: unpack works per 128 bit lane, the permutes put the lanes back in order
+    __m256 low  = _mm256_unpacklo_ps( even, odd );
+    __m256 high = _mm256_unpackhi_ps( even, odd );
+    _mm256_storeu_ps( dst + 2 * j, _mm256_permute2f128_ps( low, high, 0x20 ) );
+    _mm256_storeu_ps( dst + 2 * j + 8, _mm256_permute2f128_ps( low, high, 0x31 ) );
+  }
+  return j;
+}
+
+PCC_TARGET_AVX2 static size_t downsampleRowAvx2( const float* src,
+                                                 const float* taps,
+                                                 int          size,
+                                                 double       scale,
+                                                 float*       dst,
+                                                 size_t       count ) {
+  const __m256d vScale = _mm256_set1_pd( scale );
+  const __m256i even   = _mm256_setr_epi32( 0, 2, 4, 6, 1, 3, 5, 7 );
+  size_t        j      = 0;
+  // each load reads one sample past the last even one, hence the extra output kept for the scalar code
+  for ( ; j + 5 <= count; j += 4 ) {
+    __m256d value = _mm256_setzero_pd();
+    for ( int k = 0; k < size; k++ ) {
+      __m256 samples = _mm256_permutevar8x32_ps( _mm256_loadu_ps( src + 2 * j + k ), even );
+      __m256d product =
+          _mm256_mul_pd( _mm256_set1_pd( (double)taps[k] ), _mm256_cvtps_pd( _mm256_castps256_ps128( samples ) ) );
+      value = _mm256_add_pd( value, product );
+    }
+    _mm_storeu_ps( dst + j, _mm256_cvtpd_ps( _mm256_mul_pd( value, vScale ) ) );
+  }
+  return j;
+}
+
+#define PCC_DISPATCH( call ) return hasAvx2() ? call : 0
+
+#else  // PCC_KERNELS_AVX2
+
+bool pcc::hasAvx2() { return false; }
+
+#define PCC_DISPATCH( call ) return 0
+
+#endif  // PCC_KERNELS_AVX2
+
+size_t pcc::toFloatKernel( const uint8_t* src,
+                           float*         dst,
+                           size_t         count,
+                           int            offset,
+                           double         weight,
+                           float          minValue,
+                           float          maxValue ) {
+  PCC_DISPATCH( toFloatAvx2( src, dst, count, offset, weight, minValue, maxValue ) );
+}
+
+size_t pcc::toFloatKernel( const uint16_t* src,
+                           float*          dst,
+                           size_t          count,
+                           int             offset,
+                           double          weight,
+                           float           minValue,
+                           float           maxValue ) {
+  PCC_DISPATCH( toFloatAvx2( src, dst, count, offset, weight, minValue, maxValue ) );
+}
+
+size_t pcc::toFixedKernel( const float* src, uint8_t* dst, size_t count, double scale, double offset ) {
+  // 16 bit samples do not fit, leave the scalar cast to deal with it
+  if ( scale > 255. ) { return 0; }
+  PCC_DISPATCH( toFixedAvx2( src, dst, count, scale, offset ) );
+}
+
+size_t pcc::toFixedKernel( const float* src, uint16_t* dst, size_t count, double scale, double offset ) {
+  PCC_DISPATCH( toFixedAvx2( src, dst, count, scale, offset ) );
+}
+
+size_t pcc::rgbToFloatKernel( const uint8_t* src, float* dst, size_t count, float scale ) {
+  PCC_DISPATCH( rgbToFloatAvx2( src, dst, count, scale ) );
+}
+
+size_t pcc::rgbToFloatKernel( const uint16_t* src, float* dst, size_t count, float scale ) {
+  PCC_DISPATCH( rgbToFloatAvx2( src, dst, count, scale ) );
+}
+
+size_t pcc::floatToRgbKernel( const float* src, uint8_t* dst, size_t count, float scale ) {
+  PCC_DISPATCH( floatToRgbAvx2( src, dst, count, scale ) );
+}
+
+size_t pcc::floatToRgbKernel( const float* src, uint16_t* dst, size_t count, float scale ) {
+  PCC_DISPATCH( floatToRgbAvx2( src, dst, count, scale ) );
+}
+
+size_t pcc::rgbToYuvKernel( const float* r,
+                            const float* g,
+                            const float* b,
+                            float*       y,
+                            float*       u,
+                            float*       v,
+                            size_t       count ) {
+  PCC_DISPATCH( rgbToYuvAvx2( r, g, b, y, u, v, count ) );
+}
+
+size_t pcc::yuvToRgbKernel( const float* y,
+                            const float* u,
+                            const float* v,
+                            float*       r,
+                            float*       g,
+                            float*       b,
+                            size_t       count ) {
+  PCC_DISPATCH( yuvToRgbAvx2( y, u, v, r, g, b, count ) );
+}
+
+size_t pcc::filterColumnsKernel( const float* const* rows,
+                                 const float*        taps,
+                                 int                 size,
+                                 float               scale,
+                                 float*              dst,
+                                 size_t              count ) {
+  PCC_DISPATCH( filterColumnsAvx2( rows, taps, size, scale, dst, count ) );
+}
+
+size_t pcc::filterColumnsKernel( const float* const* rows,
+                                 const float*        taps,
+                                 int                 size,
+                                 double              scale,
+                                 float*              dst,
+                                 size_t              count ) {
+  PCC_DISPATCH( filterColumnsAvx2( rows, taps, size, scale, dst, count ) );
+}
+
+size_t pcc::upsampleRowKernel( const float* src0,
+                               const float* taps0,
+                               int          size0,
+                               float        scale0,
+                               const float* src1,
+                               const float* taps1,
+                               int          size1,
+                               float        scale1,
+                               float*       dst,
+                               size_t       count ) {
+  PCC_DISPATCH( upsampleRowAvx2( src0, taps0, size0, scale0, src1, taps1, size1, scale1, dst, count ) );
+}
+
+size_t pcc::downsampleRowKernel( const float* src,
+                                 const float* taps,
+                                 int          size,
+                                 double       scale,
+                                 float*       dst,
+                                 size_t       count ) {
+  PCC_DISPATCH( downsampleRowAvx2( src, taps, size, scale, dst, count ) );
+}
@@ -34,13 +34,14 @@
 
 #ifdef USE_HDRTOOLS
 
+#include <tbb/tbb.h>  // ahead of the HDRTools headers, which declare syscall in their namespace
 #include "PCCHDRToolsLibColorConverter.h"
 #include "PCCHDRToolsLibColorConverterImpl.h"
 
 using namespace pcc;
 
 template <typename T>
-PCCHDRToolsLibColorConverter<T>::PCCHDRToolsLibColorConverter() {}
+PCCHDRToolsLibColorConverter<T>::PCCHDRToolsLibColorConverter( size_t frameThreads ) : frameThreads_( frameThreads ) {}
 template <typename T>
 PCCHDRToolsLibColorConverter<T>::~PCCHDRToolsLibColorConverter() {}
 
@@ -50,8 +51,23 @@ void PCCHDRToolsLibColorConverter<T>::convert( std::string        configFile,
                                                PCCVideo<T, 3>&    videoDst,
                                                const std::string& externalPath,
                                                const std::string& fileName ) {
-  PCCHDRToolsLibColorConverterImpl<T> converter;
-  converter.convert( configFile, videoSrc, videoDst );
+  ProjectParameters* inputParams = PCCHDRToolsLibColorConverterImpl<T>::configure( configFile, videoSrc );
+  const size_t       frameCount  = videoSrc.getFrameCount();
+  size_t             threads = frameThreads_ > 0 ? frameThreads_ : size_t( tbb::this_task_arena::max_concurrency() );
+  threads                    = ( std::max )( size_t( 1 ), ( std::min )( threads, frameCount ) );
+
+  // The contexts are initialized one after the other, as HDRTools updates its global parameters on the way, then
+  // each converts a contiguous range of frames.
+  std::vector<std::unique_ptr<PCCHDRToolsLibColorConverterImpl<T>>> contexts( threads );
+  for ( size_t i = 0; i < threads; i++ ) {
+    contexts[i].reset( new PCCHDRToolsLibColorConverterImpl<T>() );
+    contexts[i]->init( inputParams, i == 0 );
+  }
+  videoDst.clear();
+  videoDst.resize( frameCount );
+  tbb::parallel_for( size_t( 0 ), threads, [&]( size_t i ) {
+    contexts[i]->process( inputParams, videoSrc, videoDst, frameCount * i / threads, frameCount * ( i + 1 ) / threads );
+  } );
 }
 
 template class pcc::PCCHDRToolsLibColorConverter<uint8_t>;
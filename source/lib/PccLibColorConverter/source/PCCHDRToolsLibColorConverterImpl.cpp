@@ -78,11 +78,8 @@ PCCHDRToolsLibColorConverterImpl<T>::~PCCHDRToolsLibColorConverterImpl() {
 }
 
 template <typename T>
-void PCCHDRToolsLibColorConverterImpl<T>::convert( std::string     configFile,
-                                                   PCCVideo<T, 3>& videoSrc,
-                                                   PCCVideo<T, 3>& videoDst ) {
+ProjectParameters* PCCHDRToolsLibColorConverterImpl<T>::configure( std::string configFile, PCCVideo<T, 3>& videoSrc ) {
   using hdrtoolslib::params;
-  using hdrtoolslib::ZERO;
   params                         = &ccParams;
   ProjectParameters* inputParams = (ProjectParameters*)( params );
   inputParams->refresh();
@@ -94,13 +91,11 @@ void PCCHDRToolsLibColorConverterImpl<T>::convert( std::string     configFile,
   inputParams->m_source.m_height[0] = videoSrc.getHeight();
   inputParams->m_numberOfFrames     = videoSrc.getFrameCount();
   inputParams->update();
-  init( inputParams );
-  process( inputParams, videoSrc, videoDst );
-  destroy();
+  return inputParams;
 }
 
 template <typename T>
-void PCCHDRToolsLibColorConverterImpl<T>::init( ProjectParameters* inputParams ) {
+void PCCHDRToolsLibColorConverterImpl<T>::init( ProjectParameters* inputParams, bool openOutputFile ) {
   m_filterInFloat        = inputParams->m_filterInFloat;
   m_inputFile            = &inputParams->m_inputFile;
   m_outputFile           = &inputParams->m_outputFile;
@@ -125,7 +120,7 @@ void PCCHDRToolsLibColorConverterImpl<T>::init( ProjectParameters* inputParams )
   m_inputFile->m_videoType = hdrtoolslib::VideoFileType::VIDEO_YUV;
   m_inputFrame             = hdrtoolslib::Input::create( m_inputFile, input, inputParams );
   // Output file
-  IOFunctions::openFile( m_outputFile, OPENFLAGS_WRITE, OPEN_PERMISSIONS );
+  if ( openOutputFile ) { IOFunctions::openFile( m_outputFile, OPENFLAGS_WRITE, OPEN_PERMISSIONS ); }
 
   // create frame memory as necessary
   // Input. This has the same format as the Input file.
@@ -538,44 +533,34 @@ void PCCHDRToolsLibColorConverterImpl<T>::init( ProjectParameters* inputParams )
 template <typename T>
 void PCCHDRToolsLibColorConverterImpl<T>::process( ProjectParameters* inputParams,
                                                    PCCVideo<T, 3>&    videoSrc,
-                                                   PCCVideo<T, 3>&    videoDst ) {
-  int                       frameNumber;
-  int                       iCurrentFrameToProcess = 0;
-  float                     fDistance0   = inputParams->m_source.m_frameRate / inputParams->m_output.m_frameRate;
-  bool                      errorRead    = false;
+                                                   PCCVideo<T, 3>&    videoDst,
+                                                   size_t             frameBegin,
+                                                   size_t             frameEnd ) {
   hdrtoolslib::Frame*       currentFrame = NULL;
   hdrtoolslib::FrameFormat* input        = &inputParams->m_source;
-  videoDst.clear();
-  // Now process all frames
-  for ( frameNumber = 0; frameNumber < inputParams->m_numberOfFrames; frameNumber++ ) {
-    iCurrentFrameToProcess = int( frameNumber * fDistance0 );
+  // The HDRTools stages read the frame data arrays themselves (Frame::copy, ConvertBitDepth), so the planes are
+  // copied in and out of the frame stores rather than the stores pointing to the PCCImage planes.
+  for ( size_t frameNumber = frameBegin; frameNumber < frameEnd; frameNumber++ ) {
     // read frames
-    m_iFrameStore->m_frameNo = frameNumber;
+    m_iFrameStore->m_frameNo = int( frameNumber );
     if ( m_iFrameStore->m_isFloat ) {
       printf( "float input not supported \n" );
       exit( -1 );
     } else {
-      if ( m_iFrameStore->m_bitDepth == 8 ) {
-        for ( int8_t c = 0; c < 3; c++ ) {
-          auto& image = videoSrc.getFrame( frameNumber );
-          auto& src   = image.getChannel( c );
-          for ( size_t i = 0; i < m_iFrameStore->m_compSize[c]; i++ ) { m_iFrameStore->m_comp[c][i] = src[i]; }
-        }
-      } else {
-        for ( int8_t c = 0; c < 3; c++ ) {
-          auto& src = videoSrc.getFrame( frameNumber ).getChannel( c );
-          for ( size_t i = 0; i < m_iFrameStore->m_compSize[c]; i++ ) { m_iFrameStore->m_ui16Comp[c][i] = src[i]; }
+      auto& image = videoSrc.getFrame( frameNumber );
+      for ( int8_t c = 0; c < 3; c++ ) {
+        auto& src = image.getChannel( c );
+        if ( m_iFrameStore->m_bitDepth == 8 ) {
+          std::copy( src.begin(), src.begin() + m_iFrameStore->m_compSize[c], m_iFrameStore->m_comp[c] );
+        } else {
+          std::copy( src.begin(), src.begin() + m_iFrameStore->m_compSize[c], m_iFrameStore->m_ui16Comp[c] );
         }
       }
     }
     // optional forced clipping of the data given their defined range. This is
     // done here without consideration of the upconversion process.
     if ( inputParams->m_forceClipping == 1 ) { m_iFrameStore->clipRange(); }
-    if ( errorRead == true ) {
-      break;
-    } else if ( inputParams->m_silentMode == false ) {
-      printf( "%05d ", frameNumber );
-    }
+    if ( inputParams->m_silentMode == false ) { printf( "%05zu ", frameNumber ); }
     currentFrame = m_iFrameStore;
     if ( m_croppedFrameStore != NULL ) {
       m_croppedFrameStore->copy( m_iFrameStore, m_cropOffsetLeft, m_cropOffsetTop,
@@ -659,16 +644,12 @@ void PCCHDRToolsLibColorConverterImpl<T>::process( ProjectParameters* inputParam
     } else {
       m_convertProcess->process( m_oFrameStore, m_pFrameStore[4] );
     }
-    // frame output
-    m_outputFrame->copyFrame( m_oFrameStore );
-    // m_outputFrame->writeOneFrame( m_outputFile, frameNumber,
-    // m_outputFile->m_fileHeader, 0 );
+    // frame output, straight into the frame of videoDst (the output file is not written)
     if ( m_oFrameStore->m_isFloat ) {
       printf( "float input not supported \n" );
       exit( -1 );
     } else {
-      videoDst.resize( videoDst.getFrameCount() + 1 );
-      auto&          image = videoDst.getFrames().back();
+      auto&          image = videoDst.getFrame( frameNumber );
       PCCCOLORFORMAT format =
           m_oFrameStore->m_chromaFormat == hdrtoolslib::CF_420
               ? PCCCOLORFORMAT::YUV420
@@ -676,13 +657,13 @@ void PCCHDRToolsLibColorConverterImpl<T>::process( ProjectParameters* inputParam
       image.resize( m_oFrameStore->m_width[hdrtoolslib::Y_COMP], m_oFrameStore->m_height[hdrtoolslib::Y_COMP], format );
       if ( m_oFrameStore->m_bitDepth == 8 ) {
         for ( int8_t c = 0; c < 3; c++ ) {
-          auto& dst = videoDst.getFrame( frameNumber ).getChannel( c );
-          for ( size_t i = 0; i < dst.size(); i++ ) { dst[i] = m_oFrameStore->m_comp[c][i]; }
+          auto& dst = image.getChannel( c );
+          std::copy( m_oFrameStore->m_comp[c], m_oFrameStore->m_comp[c] + dst.size(), dst.begin() );
         }
       } else if ( m_oFrameStore->m_bitDepth > 8 ) {
         for ( int8_t c = 0; c < 3; c++ ) {
-          auto& dst = videoDst.getFrame( frameNumber ).getChannel( c );
-          for ( size_t i = 0; i < dst.size(); i++ ) { dst[i] = m_oFrameStore->m_ui16Comp[c][i]; }
+          auto& dst = image.getChannel( c );
+          std::copy( m_oFrameStore->m_ui16Comp[c], m_oFrameStore->m_ui16Comp[c] + dst.size(), dst.begin() );
         }
       } else {
         printf( "output format not yet supported ( frame depht = %d \n", m_oFrameStore->m_bitDepth );
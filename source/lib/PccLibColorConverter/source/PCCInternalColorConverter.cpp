@@ -31,6 +31,7 @@
  * THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "PCCInternalColorConverter.h"
+#include "PCCColorConverterKernels.h"
 
 using namespace pcc;
 
@@ -375,6 +376,58 @@ void PCCInternalColorConverter<T>::convert( std::string        configuration,
   }
 }
 
+template <typename T>
+std::string PCCInternalColorConverter<T>::getConfiguration( const std::string& hdrToolsConfigFile ) {
+  std::ifstream file( hdrToolsConfigFile );
+  if ( !file.is_open() ) { return ""; }
+  std::map<std::string, std::string> params;
+  std::string                        line;
+  while ( std::getline( file, line ) ) {
+    line.erase( std::find( line.begin(), line.end(), '#' ), line.end() );
+    size_t pos = line.find( '=' );
+    if ( pos == std::string::npos ) { continue; }
+    std::string key = line.substr( 0, pos ), value = line.substr( pos + 1 );
+    key.erase( std::remove_if( key.begin(), key.end(), ::isspace ), key.end() );
+    value.erase( std::remove_if( value.begin(), value.end(), ::isspace ), value.end() );
+    params[key] = value;
+  }
+  auto get = [&]( const std::string& key ) -> int {
+    auto it = params.find( key );
+    return it == params.end() || it->second.empty() ? -1 : std::atoi( it->second.c_str() );
+  };
+
+  // YCbCr 4:2:0 full range to 16 bit YCbCr 4:4:4 full range, same primaries, no transfer function, chroma
+  // location 0, filtering on floats and nothing else: HDRTools then dequantizes with 1 / ( 2^bitdepth - 1 ),
+  // upsamples with the UCF filters and requantizes with 65535, which is what convertYUV420ToYUV444 does.
+  const int32_t sourceBitDepth = get( "SourceBitDepthCmp0" );
+  const int32_t filter         = get( "ChromaUpsampleFilter" );
+  if ( sourceBitDepth != 8 && sourceBitDepth != 10 ) { return ""; }
+  if ( get( "SourceBitDepthCmp1" ) != sourceBitDepth || get( "SourceBitDepthCmp2" ) != sourceBitDepth ) {
+    return "";
+  }
+  for ( const auto& key : {"OutputBitDepthCmp0", "OutputBitDepthCmp1", "OutputBitDepthCmp2"} ) {
+    if ( get( key ) != 16 ) { return ""; }
+  }
+  if ( filter < 1 || filter > (int32_t)g_filter420to444.size() ) { return ""; }
+  const std::vector<std::pair<const char*, int32_t>> required = {
+      {"SourceChromaFormat", 1},         {"OutputChromaFormat", 3},         {"SourceColorSpace", 0},
+      {"OutputColorSpace", 0},           {"SourceSampleRange", 1},          {"OutputSampleRange", 1},
+      {"SourceTransferFunction", 0},     {"OutputTransferFunction", 0},     {"SourceChromaLocationTop", 0},
+      {"OutputChromaLocationTop", 0},    {"SourceChromaLocationBottom", 0}, {"OutputChromaLocationBottom", 0},
+      {"SourceInterlaced", 0},           {"FilterUsingFloats", 1},          {"UseAdaptiveFiltering", 0},
+      {"UseMinMaxFiltering", 0},         {"UseChromaDeblocking", 0},        {"UseWienerFiltering", 0},
+      {"Use2DSepFiltering", 0},          {"AddNoise", 0},                   {"ToneMappingMode", 0},
+      {"CropOffsetLeft", 0},             {"CropOffsetTop", 0},              {"CropOffsetRight", 0},
+      {"CropOffsetBottom", 0}};
+  for ( const auto& param : required ) {
+    if ( get( param.first ) != param.second ) { return ""; }
+  }
+  if ( get( "SourceColorPrimaries" ) != get( "OutputColorPrimaries" ) ) { return ""; }
+
+  // HDRTools counts UF_NN as upsampling filter 0, g_filter420to444 starts at UF_F0
+  return stringFormat( "YUV420ToYUV444_%d_%d", sourceBitDepth, filter - 1 );
+}
+
 template <typename T>
 void PCCInternalColorConverter<T>::extractParameters( std::string& configuration,
                                                       std::string& config,
@@ -551,13 +604,15 @@ void PCCInternalColorConverter<T>::convertYUV444ToRGB444( PCCImage<T, 3>& imageS
 }
 
 template <typename T>
-void PCCInternalColorConverter<T>::RGBtoFloatRGB( const std::vector<T>& src,
-                                                  std::vector<float>&   dst,
-                                                  const size_t          nbyte ) const {
+void PCCInternalColorConverter<T>::RGBtoFloatRGB( const Channel&       src,
+                                                  std::vector<float>& dst,
+                                                  const size_t        nbyte ) const {
   size_t count = src.size();
   dst.resize( count );
   float offset = nbyte == 1 ? 255.f : 1023.f;
-  for ( size_t i = 0; i < count; i++ ) { dst[i] = (float)src[i] / offset; }
+  for ( size_t i = rgbToFloatKernel( src.data(), dst.data(), count, offset ); i < count; i++ ) {
+    dst[i] = (float)src[i] / offset;
+  }
 }
 
 template <typename T>
@@ -571,7 +626,8 @@ void PCCInternalColorConverter<T>::convertRGBToYUV( const std::vector<float>& R,
   Y.resize( count );
   U.resize( count );
   V.resize( count );
-  for ( size_t i = 0; i < count; i++ ) {
+  for ( size_t i = rgbToYuvKernel( R.data(), G.data(), B.data(), Y.data(), U.data(), V.data(), count ); i < count;
+        i++ ) {
     Y[i] = (float)( (double)clamp( 0.212600 * R[i] + 0.715200 * G[i] + 0.072200 * B[i], 0.0, 1.0 ) );
     U[i] = (float)( (double)clamp( -0.114572 * R[i] - 0.385428 * G[i] + 0.500000 * B[i], -0.5, 0.5 ) );
     V[i] = (float)( (double)clamp( 0.500000 * R[i] - 0.454153 * G[i] - 0.045847 * B[i], -0.5, 0.5 ) );
@@ -580,23 +636,23 @@ void PCCInternalColorConverter<T>::convertRGBToYUV( const std::vector<float>& R,
 
 template <typename T>
 void PCCInternalColorConverter<T>::floatYUVToYUV( const std::vector<float>& src,
-                                                  std::vector<T>&           dst,
+                                                  Channel&                  dst,
                                                   const bool                chroma,
                                                   const size_t              nbyte ) const {
   size_t count = src.size();
   dst.resize( count );
   double offset = chroma ? nbyte == 1 ? 128. : 32768. : 0;
   double scale  = nbyte == 1 ? 255. : 65535.;
-  for ( size_t i = 0; i < count; i++ ) {
+  for ( size_t i = toFixedKernel( src.data(), dst.data(), count, scale, offset ); i < count; i++ ) {
     dst[i] = static_cast<T>( fClip( std::round( (float)( scale * (double)src[i] + offset ) ), 0.f, (float)scale ) );
   }
 }
 
 template <typename T>
-void PCCInternalColorConverter<T>::YUVtoFloatYUV( const std::vector<T>& src,
-                                                  std::vector<float>&   dst,
-                                                  const bool            chroma,
-                                                  const size_t          nbBytes ) const {
+void PCCInternalColorConverter<T>::YUVtoFloatYUV( const Channel&       src,
+                                                  std::vector<float>& dst,
+                                                  const bool          chroma,
+                                                  const size_t        nbBytes ) const {
   size_t count = src.size();
   dst.resize( count );
   float    minV   = chroma ? -0.5f : 0.f;
@@ -604,7 +660,7 @@ void PCCInternalColorConverter<T>::YUVtoFloatYUV( const std::vector<T>& src,
   uint16_t offset = chroma ? nbBytes == 1 ? 128 : 512 : 0;
   double   scale  = nbBytes == 1 ? 255. : 1023.;
   double   weight = 1.0 / scale;
-  for ( size_t i = 0; i < count; i++ ) {
+  for ( size_t i = toFloatKernel( src.data(), dst.data(), count, offset, weight, minV, maxV ); i < count; i++ ) {
     dst[i] = clamp( (float)( weight * (double)( src[i] - offset ) ), minV, maxV );
   }
 }
@@ -620,7 +676,8 @@ void PCCInternalColorConverter<T>::convertYUVToRGB( const std::vector<float>& Y,
   R.resize( count );
   G.resize( count );
   B.resize( count );
-  for ( size_t i = 0; i < count; i++ ) {
+  for ( size_t i = yuvToRgbKernel( Y.data(), U.data(), V.data(), R.data(), G.data(), B.data(), count ); i < count;
+        i++ ) {
     R[i] = (float)( (double)clamp( Y[i] + 1.57480 * V[i], 0.0, 1.0 ) );
     G[i] = (float)( (double)clamp( Y[i] - 0.18733 * U[i] - 0.46813 * V[i], 0.0, 1.0 ) );
     B[i] = (float)( (double)clamp( Y[i] + 1.85563 * U[i], 0.0, 1.0 ) );
@@ -629,12 +686,12 @@ void PCCInternalColorConverter<T>::convertYUVToRGB( const std::vector<float>& Y,
 
 template <typename T>
 void PCCInternalColorConverter<T>::floatRGBToRGB( const std::vector<float>& src,
-                                                  std::vector<T>&           dst,
+                                                  Channel&                  dst,
                                                   const size_t              nbyte ) const {
   size_t count = src.size();
   dst.resize( count );
   float scale = nbyte == 1 ? 255.f : 1023.f;
-  for ( size_t i = 0; i < count; i++ ) {
+  for ( size_t i = floatToRgbKernel( src.data(), dst.data(), count, scale ); i < count; i++ ) {
     dst[i] = static_cast<T>( clamp( (T)std::round( scale * src[i] ), (T)0, (T)scale ) );
   }
 }
@@ -651,14 +708,41 @@ void PCCInternalColorConverter<T>::downsampling( const std::vector<float>& chrom
   std::vector<float> temp;
   chroma_out.resize( widthOut * heightOut );
   temp.resize( widthOut * heightIn );
+  const Filter& horizontal = g_filter444to420[filter].horizontal_;
+  const Filter& vertical   = g_filter444to420[filter].vertical_;
+  const int     sizeH      = (int)horizontal.data_.size();
+  const int     sizeV      = (int)vertical.data_.size();
+  const int     positionH  = ( sizeH - 1 ) >> 1;
+  const int     positionV  = ( sizeV - 1 ) >> 1;
+  const double  scaleH     = 1.0f / ( (float)( 1 << ( (int)horizontal.shift_ ) ) );
+  const double  scaleV     = 1.0f / ( (float)( 1 << ( (int)vertical.shift_ ) ) );
+
+  // outputs whose taps all fall inside the row go through the kernel, the others clamp
+  const int jBegin = ( positionH + 1 ) / 2;
+  const int jEnd   = widthIn - sizeH + positionH < 0
+                         ? jBegin
+                         : std::max( jBegin, std::min( widthOut, ( widthIn - sizeH + positionH ) / 2 + 1 ) );
   for ( int i = 0; i < heightIn; i++ ) {
+    const float* row  = chroma_in.data() + i * widthIn;
+    const int    done = jBegin < jEnd ? jBegin + (int)downsampleRowKernel( row + 2 * jBegin - positionH,
+                                                                         horizontal.data_.data(), sizeH, scaleH,
+                                                                         temp.data() + i * widthOut + jBegin,
+                                                                         jEnd - jBegin )
+                                      : jBegin;
     for ( int j = 0; j < widthOut; j++ ) {
+      if ( j >= jBegin && j < done ) { continue; }
       temp[i * widthOut + j] =
           downsamplingHorizontal( g_filter444to420[filter], chroma_in, widthIn, heightIn, i, j * 2 );
     }
   }
+  std::vector<const float*> rows( sizeV );
   for ( int i = 0; i < heightOut; i++ ) {
-    for ( int j = 0; j < widthOut; j++ ) {
+    for ( int k = 0; k < sizeV; k++ ) {
+      rows[k] = temp.data() + clamp( 2 * i + k - positionV, 0, heightIn - 1 ) * widthOut;
+    }
+    const int done = (int)filterColumnsKernel( rows.data(), vertical.data_.data(), sizeV, scaleV,
+                                               chroma_out.data() + i * widthOut, widthOut );
+    for ( int j = done; j < widthOut; j++ ) {
       chroma_out[i * widthOut + j] =
           downsamplingVertical( g_filter444to420[filter], temp, widthOut, heightIn, 2 * i, j );
     }
@@ -676,16 +760,56 @@ void PCCInternalColorConverter<T>::upsampling( const std::vector<float>& chromaI
   std::vector<float> temp;
   chromaOut.resize( widthOut * heightOut );
   temp.resize( widthIn * heightOut );
+  const Filter420to444& filters    = g_filter420to444[filter];
+  const int             sizeV0     = (int)filters.vertical0_.data_.size();
+  const int             sizeV1     = (int)filters.vertical1_.data_.size();
+  const int             sizeH0     = (int)filters.horizontal0_.data_.size();
+  const int             sizeH1     = (int)filters.horizontal1_.data_.size();
+  const int             positionV0 = ( sizeV0 + 1 ) >> 1;
+  const int             positionV1 = ( sizeV1 + 1 ) >> 1;
+  const int             positionH0 = ( sizeH0 + 1 ) >> 1;
+  const int             positionH1 = ( sizeH1 + 1 ) >> 1;
+  const float           scaleV0    = 1.0f / ( (float)( 1 << ( (int)filters.vertical0_.shift_ ) ) );
+  const float           scaleV1    = 1.0f / ( (float)( 1 << ( (int)filters.vertical1_.shift_ ) ) );
+  const float           scaleH0    = 1.0f / ( (float)( 1 << ( (int)filters.horizontal0_.shift_ ) ) );
+  const float           scaleH1    = 1.0f / ( (float)( 1 << ( (int)filters.horizontal1_.shift_ ) ) );
+
+  std::vector<const float*> rows0( sizeV0 ), rows1( sizeV1 );
   for ( int i = 0; i < heightIn; i++ ) {
-    for ( int j = 0; j < widthIn; j++ ) {
+    for ( int k = 0; k < sizeV0; k++ ) {
+      rows0[k] = chromaIn.data() + clamp( i + k - positionV0, 0, heightIn - 1 ) * widthIn;
+    }
+    for ( int k = 0; k < sizeV1; k++ ) {
+      rows1[k] = chromaIn.data() + clamp( i + 1 + k - positionV1, 0, heightIn - 1 ) * widthIn;
+    }
+    const int done0 = (int)filterColumnsKernel( rows0.data(), filters.vertical0_.data_.data(), sizeV0, scaleV0,
+                                                temp.data() + ( 2 * i ) * widthIn, widthIn );
+    const int done1 = (int)filterColumnsKernel( rows1.data(), filters.vertical1_.data_.data(), sizeV1, scaleV1,
+                                                temp.data() + ( 2 * i + 1 ) * widthIn, widthIn );
+    for ( int j = done0; j < widthIn; j++ ) {
       temp[( 2 * i ) * widthIn + j] =
           upsamplingVertical0( g_filter420to444[filter], chromaIn, widthIn, heightIn, i + 0, j );
+    }
+    for ( int j = done1; j < widthIn; j++ ) {
       temp[( 2 * i + 1 ) * widthIn + j] =
           upsamplingVertical1( g_filter420to444[filter], chromaIn, widthIn, heightIn, i + 1, j );
     }
   }
+
+  // columns whose taps all fall inside the row go through the kernel, the others clamp
+  const int jBegin = std::max( positionH0, positionH1 - 1 );
+  const int jLast  = std::min( widthIn - sizeH0 + positionH0, widthIn - sizeH1 + positionH1 - 1 );
+  const int jEnd   = std::max( jBegin, std::min( widthIn, jLast + 1 ) );
   for ( int i = 0; i < heightOut; i++ ) {
+    const float* row  = temp.data() + i * widthIn;
+    const int    done = jBegin < jEnd ? jBegin + (int)upsampleRowKernel(
+                                                  row + jBegin - positionH0, filters.horizontal0_.data_.data(), sizeH0,
+                                                  scaleH0, row + jBegin + 1 - positionH1,
+                                                  filters.horizontal1_.data_.data(), sizeH1, scaleH1,
+                                                  chromaOut.data() + i * widthOut + 2 * jBegin, jEnd - jBegin )
+                                      : jBegin;
     for ( int j = 0; j < widthIn; j++ ) {
+      if ( j >= jBegin && j < done ) { continue; }
       chromaOut[i * widthOut + j * 2] =
           upsamplingHorizontal0( g_filter420to444[filter], temp, widthIn, heightOut, i, j + 0 );
       chromaOut[i * widthOut + j * 2 + 1] =
@@ -0,0 +1,165 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PCCArena_h
+#define PCCArena_h
+
+#include "PCCCommon.h"
+#include <cstddef>
+#include <memory>
+
+namespace pcc {
+
+// Monotonic allocator for the short-lived buffers of a reconstruction stage: allocating bumps a cursor in the
+// current block, freeing is a no-op and a PCCArenaScope rewinds the cursor in O(1) when the stage ends. The blocks
+// are kept for the next frames until release(), so the steady state allocates nothing and takes no page faults.
+// An arena is not thread safe: the parallel stages use one arena per thread.
+class PCCMonotonicArena {
+ public:
+  struct Marker {
+    size_t block_;
+    size_t offset_;
+  };
+
+  explicit PCCMonotonicArena( const size_t blockSize = size_t( 1 ) << 20 ) :
+      blockSize_( blockSize ), block_( 0 ), offset_( 0 ) {}
+  PCCMonotonicArena( const PCCMonotonicArena& ) = delete;
+  PCCMonotonicArena& operator=( const PCCMonotonicArena& ) = delete;
+  ~PCCMonotonicArena()                                     = default;
+
+  void* allocate( const size_t size, const size_t alignment ) {
+    assert( alignment <= alignof( std::max_align_t ) );
+    if ( block_ < blocks_.size() ) {
+      const size_t start = ( offset_ + alignment - 1 ) & ~( alignment - 1 );
+      if ( start + size <= blocks_[block_].size_ ) {
+        offset_ = start + size;
+        return blocks_[block_].data_.get() + start;
+      }
+    }
+    return allocateInNextBlock( size );
+  }
+  Marker mark() const { return {block_, offset_}; }
+  void   rewind( const Marker& marker ) {
+    block_  = marker.block_;
+    offset_ = marker.offset_;
+  }
+  // Frees the blocks: every buffer of the arena must be dead.
+  void release() {
+    blocks_.clear();
+    block_  = 0;
+    offset_ = 0;
+  }
+  size_t getCapacity() const {
+    size_t capacity = 0;
+    for ( const auto& block : blocks_ ) { capacity += block.size_; }
+    return capacity;
+  }
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data_;
+    size_t                  size_;
+  };
+  // The blocks start on max_align_t boundaries, so a buffer at the start of a block is aligned for any type.
+  void* allocateInNextBlock( const size_t size ) {
+    size_t next = block_ < blocks_.size() ? block_ + 1 : block_;
+    while ( next < blocks_.size() && blocks_[next].size_ < size ) { next++; }
+    if ( next >= blocks_.size() ) {
+      Block block;
+      block.size_ = ( std::max )( blockSize_, size );
+      block.data_.reset( new char[block.size_] );
+      blocks_.push_back( std::move( block ) );
+      next = blocks_.size() - 1;
+    }
+    block_  = next;
+    offset_ = size;
+    return blocks_[block_].data_.get();
+  }
+
+  size_t             blockSize_;
+  size_t             block_;
+  size_t             offset_;
+  std::vector<Block> blocks_;
+};
+
+// Rewinds the arena to its state at the construction of the scope.
+class PCCArenaScope {
+ public:
+  explicit PCCArenaScope( PCCMonotonicArena& arena ) : arena_( arena ), marker_( arena.mark() ) {}
+  PCCArenaScope( const PCCArenaScope& ) = delete;
+  PCCArenaScope& operator=( const PCCArenaScope& ) = delete;
+  ~PCCArenaScope() { arena_.rewind( marker_ ); }
+
+ private:
+  PCCMonotonicArena&        arena_;
+  PCCMonotonicArena::Marker marker_;
+};
+
+// STL allocator drawing from a PCCMonotonicArena.
+template <typename T>
+class PCCArenaAllocator {
+ public:
+  typedef T value_type;
+  template <typename U>
+  struct rebind {
+    typedef PCCArenaAllocator<U> other;
+  };
+  explicit PCCArenaAllocator( PCCMonotonicArena& arena ) : arena_( &arena ) {}
+  template <typename U>
+  PCCArenaAllocator( const PCCArenaAllocator<U>& allocator ) : arena_( allocator.getArena() ) {}
+
+  T* allocate( size_t count ) {
+    return static_cast<T*>( arena_->allocate( count * sizeof( T ), alignof( T ) ) );
+  }
+  void               deallocate( T*, size_t ) {}
+  PCCMonotonicArena* getArena() const { return arena_; }
+  template <typename U>
+  bool operator==( const PCCArenaAllocator<U>& rhs ) const {
+    return arena_ == rhs.getArena();
+  }
+  template <typename U>
+  bool operator!=( const PCCArenaAllocator<U>& rhs ) const {
+    return arena_ != rhs.getArena();
+  }
+
+ private:
+  PCCMonotonicArena* arena_;
+};
+
+template <typename T>
+using PCCArenaVector = std::vector<T, PCCArenaAllocator<T>>;
+
+}  // namespace pcc
+
+#endif /* PCCArena_h */
@@ -0,0 +1,102 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifndef PCCBlockToPatchMap_h
+#define PCCBlockToPatchMap_h
+
+#include "PCCCommon.h"
+#include <unordered_map>
+
+namespace pcc {
+
+// Patch index + 1 of each occupancy block of a tile, 0 if none, two bytes per block. Values that do not fit in 16
+// bits keep the escape code in the block and the value on the side, so every lookup of a usual frame stays within
+// the 16-bit array.
+class PCCBlockToPatchMap {
+ public:
+  PCCBlockToPatchMap()  = default;
+  ~PCCBlockToPatchMap() = default;
+
+  size_t size() const { return blocks_.size(); }
+  bool   empty() const { return blocks_.empty(); }
+  void   resize( const size_t size ) { blocks_.resize( size, 0 ); }
+  // Sets every block to value.
+  void fill( const size_t value ) {
+    escapes_.clear();
+    if ( value < kEscape ) {
+      std::fill( blocks_.begin(), blocks_.end(), uint16_t( value ) );
+    } else {
+      for ( size_t i = 0; i < blocks_.size(); ++i ) { set( i, value ); }
+    }
+  }
+  void clear() {
+    blocks_.clear();
+    escapes_.clear();
+  }
+
+  size_t operator[]( const size_t index ) const {
+    const uint16_t value = blocks_[index];
+    return value != kEscape ? value : escapes_.at( index );
+  }
+  void set( const size_t index, const size_t value ) {
+    assert( value <= UINT32_MAX );
+    if ( value < kEscape ) {
+      if ( blocks_[index] == kEscape ) { escapes_.erase( index ); }
+      blocks_[index] = uint16_t( value );
+    } else {
+      blocks_[index]  = kEscape;
+      escapes_[index] = uint32_t( value );
+    }
+  }
+
+  // The values widened to size_t, for the debug prints and the side files written as size_t.
+  std::vector<size_t> toVector() const {
+    std::vector<size_t> values( blocks_.size() );
+    for ( size_t i = 0; i < blocks_.size(); ++i ) { values[i] = ( *this )[i]; }
+    return values;
+  }
+  size_t getMemorySize() const {
+    return blocks_.capacity() * sizeof( uint16_t ) + escapes_.size() * ( sizeof( size_t ) + sizeof( uint32_t ) );
+  }
+
+ private:
+  static const uint16_t                kEscape = 0xFFFF;
+  std::vector<uint16_t>                blocks_;
+  std::unordered_map<size_t, uint32_t> escapes_;
+};
+
+}  // namespace pcc
+
+#endif /* PCCBlockToPatchMap_h */
@@ -39,6 +39,9 @@
 #include "PCCMath.h"
 #include "PCCVideo.h"
 #include "PCCContext.h"
+#include "PCCExecutionContext.h"
+#include "PCCOccupancyBitMap.h"
+#include "PCCMemoryAccounting.h"
 
 namespace pcc {
 class PCCPatch;
@@ -69,6 +72,7 @@ struct GeneratePointCloudParameters {
   double      radius2Smoothing_;
   double      radius2BoundaryDetection_;
   double      thresholdSmoothing_;
+  bool        fixedPointSmoothing_;
   size_t      rawPointColorFormat_;
   size_t      nbThread_;
   bool        multipleStreams_;
@@ -99,6 +103,36 @@ struct GeneratePointCloudParameters {
   int16_t     pbfLog2Threshold_;
 };
 
+// The reconstruction flags tested in the pixel loop of generatePatchPoints(). A specialized kernel fixes a flag at
+// compile time ( 0 or 1 ) so that its branches leave the loop; -1 reads it from the parameters, as the generic kernel
+// does for all of them.
+template <int EOM, int PLR, int SMPI, int PBF>
+struct PCCReconstructionKernel {
+  static inline bool enhancedOccupancyMapCode( const GeneratePointCloudParameters& params ) {
+    return EOM < 0 ? params.enhancedOccupancyMapCode_ : EOM != 0;
+  }
+  static inline bool pointLocalReconstruction( const GeneratePointCloudParameters& params ) {
+    return PLR < 0 ? params.pointLocalReconstruction_ : PLR != 0;
+  }
+  static inline bool singleMapPixelInterleaving( const GeneratePointCloudParameters& params ) {
+    return SMPI < 0 ? params.singleMapPixelInterleaving_ : SMPI != 0;
+  }
+  static inline bool pbfEnableFlag( const GeneratePointCloudParameters& params ) {
+    return PBF < 0 ? params.pbfEnableFlag_ : PBF != 0;
+  }
+  static bool matches( const GeneratePointCloudParameters& params ) {
+    return enhancedOccupancyMapCode( params ) == params.enhancedOccupancyMapCode_ &&
+           pointLocalReconstruction( params ) == params.pointLocalReconstruction_ &&
+           singleMapPixelInterleaving( params ) == params.singleMapPixelInterleaving_ &&
+           pbfEnableFlag( params ) == params.pbfEnableFlag_;
+  }
+};
+typedef PCCReconstructionKernel<-1, -1, -1, -1> PCCGenericReconstruction;
+// one or two maps, without EOM, PLR, pixel interleaving nor patch border filtering: the lossy CTC configurations
+typedef PCCReconstructionKernel<0, 0, 0, 0> PCCProjectedReconstruction;
+// the lossless CTC configurations
+typedef PCCReconstructionKernel<1, 0, 0, 0> PCCEomReconstruction;
+
 struct PatchParams {
   PatchParams( uint8_t mapCntMinus1 = 0 ) :
       patchType_( PROJECTED ),
@@ -157,13 +191,19 @@ class PCCCodec {
   PCCCodec();
   ~PCCCodec();
 
+  // patchColors, when set, holds the debug colour of each patch, as drawn by generatePatchColors(); otherwise the
+  // colours are drawn here.
   void generatePointCloud( PCCPointSet3&                       reconstruct,
                            PCCContext&                         context,
                            size_t                              frameIndex,
                            size_t                              tileIndex,
                            const GeneratePointCloudParameters& params,
                            std::vector<uint32_t>&              partition,
-                           bool                                bDecoder );
+                           bool                                bDecoder,
+                           const std::vector<PCCColor3B>*      patchColors = nullptr );
+
+  // Draws the debug colours of patchCount patches from rand(), in the order generatePointCloud() uses them.
+  void generatePatchColors( size_t patchCount, std::vector<PCCColor3B>& patchColors );
 
   size_t colorPointCloud( PCCPointSet3&                       reconstruct,
                           PCCContext&                         context,
@@ -190,6 +230,13 @@ class PCCCodec {
   void generateRawPointsAttributefromVideo( PCCContext& context, size_t frameIndex );
 
   void setLogger( PCCLogger& logger ) { logger_ = &logger; }
+  // Samples the memory held by the context and the point clouds at the end of the stages.
+  void setMemoryAccounting( PCCMemoryAccounting& accounting ) { memoryAccounting_ = &accounting; }
+
+  // The arena the parallel stages of this codec run in; codecs working on the same sequence share one.
+  PCCExecutionContext&                        getExecutionContext() { return *executionContext_; }
+  const std::shared_ptr<PCCExecutionContext>& getSharedExecutionContext() const { return executionContext_; }
+  void setExecutionContext( const std::shared_ptr<PCCExecutionContext>& context ) { executionContext_ = context; }
 
  protected:
   void generateOccupancyMap( PCCFrameContext&      tile,
@@ -231,6 +278,15 @@ class PCCCodec {
                                                   const size_t          occupancyResolution,
                                                   const size_t          occupancyPrecision );
 
+  // Fills the block to patch map of tile from the occupancy video, the tile canvas starting at (xOffset, yOffset)
+  // in the video frame. Each patch block is one popcount test over the bit-packed occupancy of its pixels.
+  void generateBlockToPatch( PCCFrameContext&      tile,
+                             PCCImageOccupancyMap& occupancyMapImage,
+                             const size_t          xOffset,
+                             const size_t          yOffset,
+                             const size_t          occupancyResolution,
+                             const size_t          occupancyPrecision );
+
   int getDeltaNeighbors( const PCCImageGeometry& frame,
                          const PCCPatch&         patch,
                          const int               xOrg,
@@ -239,24 +295,39 @@ class PCCCodec {
                          const int               threshold,
                          const bool              projectionMode );
 
-  std::vector<PCCPoint3D> generatePoints( const GeneratePointCloudParameters&  params,
-                                          PCCFrameContext&                     tile,
-                                          const std::vector<PCCVideoGeometry>& videoMultiple,
-                                          const size_t                         videoFrameIndex,
-                                          const size_t                         patchIndex,
-                                          const size_t                         u,
-                                          const size_t                         v,
-                                          const size_t                         x,
-                                          const size_t                         y,
-                                          const bool                           interpolate = 0,
-                                          const bool                           filling     = 0,
-                                          const size_t                         minD1       = 0,
-                                          const size_t                         neighbor    = 0 );
-  void                    generateAfti( PCCContext& context, size_t frameIndex, AtlasFrameTileInformation& afti );
-
-  inline double entropy( std::vector<uint8_t>& Data, int N ) {
-    std::vector<size_t> count;
-    count.resize( 256, 0 );
+  void generatePoints( PCCArenaVector<PCCPoint3D>&          createdPoints,
+                       const GeneratePointCloudParameters&  params,
+                       PCCFrameContext&                     tile,
+                       const std::vector<PCCVideoGeometry>& videoMultiple,
+                       const size_t                         videoFrameIndex,
+                       const size_t                         patchIndex,
+                       const size_t                         u,
+                       const size_t                         v,
+                       const size_t                         x,
+                       const size_t                         y,
+                       const bool                           interpolate = 0,
+                       const bool                           filling     = 0,
+                       const size_t                         minD1       = 0,
+                       const size_t                         neighbor    = 0 );
+  template <typename Kernel>
+  void generatePoints( PCCArenaVector<PCCPoint3D>&          createdPoints,
+                       const GeneratePointCloudParameters&  params,
+                       PCCFrameContext&                     tile,
+                       const std::vector<PCCVideoGeometry>& videoMultiple,
+                       const size_t                         videoFrameIndex,
+                       const size_t                         patchIndex,
+                       const size_t                         u,
+                       const size_t                         v,
+                       const size_t                         x,
+                       const size_t                         y,
+                       const bool                           interpolate,
+                       const bool                           filling,
+                       const size_t                         minD1,
+                       const size_t                         neighbor );
+  void generateAfti( PCCContext& context, size_t frameIndex, AtlasFrameTileInformation& afti );
+
+  inline double entropy( const uint8_t* Data, int N ) {
+    size_t count[256] = {0};
     for ( size_t i = 0; i < N; ++i ) { ++count[size_t( Data[i] )]; }
     double s = 0;
     for ( size_t i = 0; i < 256; ++i ) {
@@ -268,18 +339,17 @@ class PCCCodec {
     return s;
   }
 
-  inline double median( std::vector<uint16_t>& Data, int N ) {
-    std::sort( Data.begin(), Data.end() );
-
+  inline double median( uint16_t* data, int N ) {
+    std::nth_element( data, data + N / 2, data + N );
     if ( N % 2 == 0 )
-      return ( double( Data[N / 2] ) + double( Data[N / 2 - 1] ) ) / 2.0;
+      return ( double( data[N / 2] ) + double( *std::max_element( data, data + N / 2 ) ) ) / 2.0;
     else
-      return double( Data[N / 2] );
+      return double( data[N / 2] );
   }
 
-  inline double mean( std::vector<uint16_t>& Data, int N ) {
+  inline double mean( const uint16_t* data, int N ) {
     double s = 0.0;
-    for ( size_t i = 0; i < N; ++i ) { s += double( Data[i] ); }
+    for ( size_t i = 0; i < N; ++i ) { s += double( data[i] ); }
     return s / double( N );
   }
 
@@ -338,9 +408,65 @@ class PCCCodec {
     vec.clear();
   }
 
-  PCCLogger* logger_ = nullptr;
+  PCCMonotonicArena& getThreadArena() { return executionContext_->getThreadArena(); }
+
+  // Only call once the tasks of the stage are done with the context.
+  void sampleMemory( const char*             stage,
+                     const PCCContext&       context,
+                     const PCCGroupOfFrames& frames,
+                     const PCCGroupOfFrames* sources = nullptr );
+
+  PCCLogger*                           logger_           = nullptr;
+  PCCMemoryAccounting*                 memoryAccounting_ = nullptr;
+  std::shared_ptr<PCCExecutionContext> executionContext_;
 
  private:
+  // A boundary cell of the geometry smoothing grid. The filter reads the 2x2x2 cells around each boundary point, so
+  // everything it needs from one cell sits in the same record. centerFx_ is the center in fixed point, with
+  // kGeoSmoothingFractionBits fraction bits, read by gridFilteringFixedPoint().
+  struct GeoSmoothingCell {
+    PCCVector3<float> center_;
+    int32_t           centerFx_[3];
+    uint16_t          count_;
+    bool              doSmooth_;
+  };
+  static const int kGeoSmoothingFractionBits = 8;
+
+  // A boundary cell of the attribute smoothing grid. lumOutlier_ is set when the mean and the median luma of the
+  // cell points differ by more than thresholdColorVariation_, i.e. when the cell must not be used as a centroid.
+  struct ColorSmoothingCell {
+    PCCVector3<float> center_;
+    uint16_t          count_;
+    bool              doSmooth_;
+    bool              lumOutlier_;
+  };
+
+  template <typename Kernel>
+  void generatePatchPoints( PCCPointSet3&                       reconstruct,
+                            std::vector<uint32_t>&              partition,
+                            std::vector<PCCVector3<size_t>>&    pointToPixel,
+                            std::vector<PCCPoint3D>&            eomPoints,
+                            PCCContext&                         context,
+                            PCCFrameContext&                    tile,
+                            size_t                              tileIndex,
+                            size_t                              patchIndex,
+                            size_t                              videoFrameIndex,
+                            const PCCColor3B&                   color,
+                            const GeneratePointCloudParameters& params );
+  typedef void ( PCCCodec::*PatchPointsKernel )( PCCPointSet3&,
+                                                 std::vector<uint32_t>&,
+                                                 std::vector<PCCVector3<size_t>>&,
+                                                 std::vector<PCCPoint3D>&,
+                                                 PCCContext&,
+                                                 PCCFrameContext&,
+                                                 size_t,
+                                                 size_t,
+                                                 size_t,
+                                                 const PCCColor3B&,
+                                                 const GeneratePointCloudParameters& );
+  // The specialized generatePatchPoints() matching the flags of params, the generic one if none does.
+  static PatchPointsKernel selectPatchPointsKernel( const GeneratePointCloudParameters& params );
+
   void smoothPointCloud( PCCPointSet3&                      reconstruct,
                          const std::vector<uint32_t>&       partition,
                          const GeneratePointCloudParameters params );
@@ -351,76 +477,47 @@ class PCCCodec {
                              uint16_t                            gridWidth,
                              std::vector<int>&                   cellIndex );
 
-  void addGridCentroid( PCCPoint3D&                     point,
-                        uint32_t                        patchIdx,
-                        std::vector<uint16_t>&          count,
-                        std::vector<PCCVector3<float>>& center,
-                        std::vector<uint32_t>&          partition,
-                        std::vector<bool>&              doSmooth,
-                        uint8_t                         gridSize,
-                        uint16_t                        gridWidth,
-                        int                             cellId );
-
-  void addGridColorCentroid( PCCPoint3D&                             point,
-                             PCCVector3D&                            color,
-                             std::pair<size_t, size_t>               tilePatchIdx,
-                             std::vector<uint16_t>&                  colorGridCount,
-                             std::vector<PCCVector3<float>>&         colorCenter,
-                             std::vector<std::pair<size_t, size_t>>& colorPartition,
-                             std::vector<bool>&                      colorDoSmooth,
-                             uint8_t                                 colorGrid,
-                             std::vector<std::vector<uint16_t>>&     colorLum,
-                             const GeneratePointCloudParameters&     params,
-                             int                                     cellId );
-
-  bool gridFilteringColor( PCCPoint3D&                         curPos,
+  bool gridFilteringColor( const PCCPoint3D&                   curPos,
                            PCCVector3D&                        colorCentroid,
                            int&                                colorCount,
-                           std::vector<uint16_t>&              colorGridCount,
-                           std::vector<PCCVector3<float>>&     colorCenterGrid,
-                           std::vector<bool>&                  colorDoSmooth,
                            uint8_t                             gridSize,
-                           PCCVector3D&                        curPosColor,
+                           const PCCVector3D&                  curPosColor,
                            const GeneratePointCloudParameters& params,
-                           std::vector<int>&                   cellIndex );
+                           const std::vector<int>&             cellIndex ) const;
 
   void smoothPointCloudColorLC( PCCPointSet3&                       reconstruct,
                                 const GeneratePointCloudParameters& params,
                                 std::vector<int>&                   cellIndex );
 
-  bool gridFiltering( const std::vector<uint32_t>&    partition,
-                      PCCPointSet3&                   pointCloud,
-                      PCCPoint3D&                     curPoint,
-                      PCCVector3D&                    centroid,
-                      int&                            count,
-                      std::vector<uint16_t>&          gridCount,
-                      std::vector<PCCVector3<float>>& center,
-                      std::vector<bool>&              doSmooth,
-                      uint8_t                         gridSize,
-                      uint16_t                        gridWidth,
-                      std::vector<int>&               cellIndex );
-
-  void identifyBoundaryPoints( const std::vector<uint32_t>& occupancyMap,
-                               const size_t                 x,
-                               const size_t                 y,
-                               const size_t                 imageWidth,
-                               const size_t                 imageHeight,
-                               const size_t                 pointIndex,
-                               std::vector<uint32_t>&       BPflag,
-                               PCCPointSet3&                reconstruct );
+  bool gridFiltering( const PCCPoint3D&       curPoint,
+                      PCCVector3D&            centroid,
+                      int&                    count,
+                      uint8_t                 gridSize,
+                      const std::vector<int>& cellIndex ) const;
+
+  // gridFiltering() in integers: centroid[k] is the trilinear sum of the fixed-point cell centers, i.e. the centroid
+  // times ( 2 * gridSize )^3 << kGeoSmoothingFractionBits.
+  bool gridFilteringFixedPoint( const PCCPoint3D&       curPoint,
+                                int64_t                 centroid[3],
+                                int&                    count,
+                                uint8_t                 gridSize,
+                                const std::vector<int>& cellIndex ) const;
+
+  // Marks the first pointCount points of reconstruct, pixel pointToPixel[i], that lie on the first two boundary
+  // layers: an occupied pixel at most two pixels from an empty one, or at most one from the edge of the map. The
+  // empty pixels are dilated word by word on the bit-packed map, then the points are tested in parallel.
+  void identifyBoundaryPoints( const std::vector<uint32_t>&           occupancyMap,
+                               const size_t                           imageWidth,
+                               const size_t                           imageHeight,
+                               const std::vector<PCCVector3<size_t>>& pointToPixel,
+                               const size_t                           pointCount,
+                               PCCPointSet3&                          reconstruct );
 
 #ifdef CODEC_TRACE
   void printChecksum( PCCPointSet3& ePointcloud, std::string eString );
 #endif
-  std::vector<uint16_t>                  geoSmoothingCount_;
-  std::vector<PCCVector3<float>>         geoSmoothingCenter_;
-  std::vector<bool>                      geoSmoothingDoSmooth_;
-  std::vector<uint32_t>                  geoSmoothingPartition_;
-  std::vector<uint16_t>                  colorSmoothingCount_;
-  std::vector<PCCVector3<float>>         colorSmoothingCenter_;
-  std::vector<bool>                      colorSmoothingDoSmooth_;
-  std::vector<std::pair<size_t, size_t>> colorSmoothingPartition_;
-  std::vector<std::vector<uint16_t>>     colorSmoothingLum_;
+  std::vector<GeoSmoothingCell>   geoSmoothingCells_;
+  std::vector<ColorSmoothingCell> colorSmoothingCells_;
 };
 
 };  // namespace pcc
@@ -6,6 +6,9 @@
 
 /* #undef ENABLE_PAPI_PROFILING */
 
+/* Scoped-zone profiler of the encoder and decoder stages (PCCProfiler.h) */
+/* #undef ENABLE_PROFILER */
+
 #define USE_JMAPP_VIDEO_CODEC
 #define USE_HMAPP_VIDEO_CODEC
 #define USE_SHMAPP_VIDEO_CODEC
@@ -14,6 +17,9 @@
 #define USE_VTMLIB_VIDEO_CODEC
 /* #undef USE_FFMPEG_VIDEO_CODEC */
 
+/* CUDA kernels of the encoder segmentation (PCCSegmentationKernels.h) */
+/* #undef USE_CUDA */
+
 #define USE_HDRTOOLS
 
 
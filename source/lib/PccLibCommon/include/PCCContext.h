@@ -38,12 +38,14 @@
 #include "PCCVideo.h"
 #include "PCCBitstreamCommon.h"
 #include "PCCHighLevelSyntax.h"
+#include "PCCPatch.h"
 #include <map>
 
 namespace pcc {
 
 class PCCGroupOfFrames;
 class PCCFrameContext;
+struct PCCMemoryUsage;
 class PCCAtlasFrameContext;
 typedef PCCVideo<uint8_t, 3>  PCCVideoOccupancyMap;
 typedef PCCVideo<uint16_t, 3> PCCVideoGeometry;
@@ -60,6 +62,9 @@ class PCCAtlasContext {
   PCCAtlasContext();
   ~PCCAtlasContext();
 
+  // Clears the frame contexts and empties the videos, keeping the frame buffers and the patches for the next GOF.
+  void reset();
+
   // atlas related functions
   void   setAtlasIndex( size_t atlIdx ) { atlasIndex_ = atlIdx; }
   size_t getAtlasIndex() { return atlasIndex_; }
@@ -75,13 +80,16 @@ class PCCAtlasContext {
   std::vector<std::pair<size_t, size_t>>&     getFramesInAFPS() { return framesInAFPS_; }
   size_t                                      calculateAFOCLsb( size_t frameOrder );
   void                                        allocOneLayerData();
+  PCCPatchPool&                               getPatchPool() { return patchPool_; }
   void                                        printBlockToPatch( const size_t occupancyResolution );
+  void                                        getMemoryUsage( PCCMemoryUsage& usage ) const;
   void   setLog2MaxAtlasFrameOrderCntLsb( size_t value ) { log2MaxAtlasFrameOrderCntLsb_ = value; }
   size_t getLog2MaxAtlasFrameOrderCntLsb() { return log2MaxAtlasFrameOrderCntLsb_; }
 
   // video related functions
   void                            allocateVideoFrames( PCCHighLevelSyntax& syntax, size_t numFrames );
   void                            clearVideoFrames();
+  void                            resetVideoFrames();
   PCCVideoOccupancyMap&           getVideoOccupancyMap() { return occFrames_; }
   std::vector<PCCVideoGeometry>&  getVideoGeometryMultiple() { return geoFrames_; }
   PCCVideoGeometry&               getVideoGeometryMultiple( size_t index ) { return geoFrames_[index]; }
@@ -119,6 +127,7 @@ class PCCAtlasContext {
   std::vector<std::vector<PCCVideoAttribute>>                attrAuxFrames_;
   std::vector<SubContext>                                    subContexts_;
   std::vector<unionPatch>                                    unionPatch_;
+  PCCPatchPool                                               patchPool_;
 };
 
 // used for context handling
@@ -127,6 +136,10 @@ class PCCContext : public PCCHighLevelSyntax {
   PCCContext();
   ~PCCContext();
 
+  // Prepares the context for the next GOF of the stream: the syntax and the frame contexts are cleared as in a new
+  // context, but the video frames keep their buffers, so a GOF of the same resolution does not reallocate them.
+  void reset();
+
   // Atlas related functions
   const size_t                  sizeAtlas() { return atlasContexts_.size(); }
   std::vector<PCCAtlasContext>& getAtlases() { return atlasContexts_; }
@@ -196,6 +209,9 @@ class PCCContext : public PCCHighLevelSyntax {
   uint16_t             computeCRC( uint8_t* byteString, size_t size );
   uint32_t             computeCheckSum( uint8_t* byteString, size_t size );
 
+  // Adds the bytes held by the videos, frame contexts and video bitstreams of every atlas.
+  void getMemoryUsage( PCCMemoryUsage& usage ) const;
+
  private:
   PCCVector3<float>            modelOrigin_;
   float                        modelScale_;
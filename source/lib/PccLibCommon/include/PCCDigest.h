@@ -0,0 +1,129 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCCDigest_h
+#define PCCDigest_h
+
+#include "PCCCommon.h"
+
+namespace pcc {
+
+// Streaming 64-bit XXH64 digest, as an alternative to MD5 for regression checksums: several times faster on one
+// core and as good at telling two frames apart, but not cryptographic. finalize() writes the canonical big-endian
+// form of the hash, so digests print and compare the same way as the MD5 ones.
+class PCCDigest64 {
+ public:
+  static const size_t DIGEST_LENGTH = 8;
+
+  PCCDigest64( const uint64_t seed = 0 ) :
+      acc_{seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1}, seed_( seed ), length_( 0 ), buffered_( 0 ) {}
+
+  void update( const uint8_t* data, size_t size ) {
+    length_ += size;
+    if ( buffered_ + size < 32 ) {
+      memcpy( buffer_ + buffered_, data, size );
+      buffered_ += size;
+      return;
+    }
+    if ( buffered_ > 0 ) {
+      const size_t fill = 32 - buffered_;
+      memcpy( buffer_ + buffered_, data, fill );
+      stripe( buffer_ );
+      data += fill;
+      size -= fill;
+      buffered_ = 0;
+    }
+    for ( ; size >= 32; data += 32, size -= 32 ) { stripe( data ); }
+    memcpy( buffer_, data, size );
+    buffered_ = size;
+  }
+
+  void finalize( uint8_t digest[DIGEST_LENGTH] ) const {
+    uint64_t hash;
+    if ( length_ >= 32 ) {
+      hash = rotl( acc_[0], 1 ) + rotl( acc_[1], 7 ) + rotl( acc_[2], 12 ) + rotl( acc_[3], 18 );
+      for ( auto acc : acc_ ) { hash = ( hash ^ round( 0, acc ) ) * PRIME1 + PRIME4; }
+    } else {
+      hash = seed_ + PRIME5;
+    }
+    hash += length_;
+    const uint8_t* data = buffer_;
+    size_t         size = buffered_;
+    for ( ; size >= 8; data += 8, size -= 8 ) { hash = rotl( hash ^ round( 0, read64( data ) ), 27 ) * PRIME1 + PRIME4; }
+    if ( size >= 4 ) {
+      hash = rotl( hash ^ ( read32( data ) * PRIME1 ), 23 ) * PRIME2 + PRIME3;
+      data += 4;
+      size -= 4;
+    }
+    for ( ; size > 0; data++, size-- ) { hash = rotl( hash ^ ( *data * PRIME5 ), 11 ) * PRIME1; }
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    for ( size_t i = 0; i < DIGEST_LENGTH; i++ ) { digest[i] = uint8_t( hash >> ( 56 - 8 * i ) ); }
+  }
+
+ private:
+  static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+  static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+  static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+  static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+  static const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+  static uint64_t rotl( const uint64_t value, const int shift ) { return ( value << shift ) | ( value >> ( 64 - shift ) ); }
+  static uint64_t round( uint64_t acc, const uint64_t input ) { return rotl( acc + input * PRIME2, 31 ) * PRIME1; }
+  // Little-endian loads, whatever the host order.
+  static uint64_t read64( const uint8_t* data ) {
+    uint64_t value = 0;
+    for ( int i = 7; i >= 0; i-- ) { value = ( value << 8 ) | data[i]; }
+    return value;
+  }
+  static uint64_t read32( const uint8_t* data ) {
+    return uint64_t( data[0] ) | ( uint64_t( data[1] ) << 8 ) | ( uint64_t( data[2] ) << 16 ) |
+           ( uint64_t( data[3] ) << 24 );
+  }
+  void stripe( const uint8_t* data ) {
+    for ( size_t i = 0; i < 4; i++ ) { acc_[i] = round( acc_[i], read64( data + 8 * i ) ); }
+  }
+
+  uint64_t acc_[4];
+  uint64_t seed_;
+  uint64_t length_;
+  uint8_t  buffer_[32];
+  size_t   buffered_;
+};
+
+};  // namespace pcc
+
+#endif /* PCCDigest_h */
@@ -0,0 +1,111 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCCExecutionContext_h
+#define PCCExecutionContext_h
+
+#include "PCCCommon.h"
+#include "PCCArena.h"
+#include "tbb/task_arena.h"
+#include "tbb/enumerable_thread_specific.h"
+#include <functional>
+#include <mutex>
+
+namespace pcc {
+
+class PCCThreadPinning;
+
+// Long-lived TBB arena shared by all the parallel stages of a codec. It replaces the arenas each stage used to create
+// for itself, so the thread count is set once per sequence and the worker threads, once pinned, stay on their cores.
+class PCCExecutionContext {
+ public:
+  PCCExecutionContext();
+  ~PCCExecutionContext();
+
+  // nbThread = 0 uses every core. affinity lists the cores the worker threads are pinned to, e.g. "0-7,16-23" to
+  // stay on one NUMA node; empty leaves the threads to the OS. Re-initializing with other settings recreates the arena.
+  void initialize( size_t nbThread, const std::string& affinity = "" );
+
+  // Several codecs can share one context, e.g. the decoders of independent segments running side by side. Each holds
+  // it from enter() to leave(): only the first one in initializes the arena, so the others must use the same settings,
+  // and the last one out frees the thread arenas.
+  void enter( size_t nbThread, const std::string& affinity = "" );
+  void leave();
+
+  // Runs on every worker thread as it joins the arena, after its pinning, e.g. to set its scheduling priority. Takes
+  // effect when the arena is (re)initialized.
+  void setWorkerSetup( const std::function<void()>& setup ) { workerSetup_ = setup; }
+
+  size_t getThreadCount() const { return nbThread_; }
+
+  template <typename F>
+  void execute( F& f ) {
+    arena_.execute( f );
+  }
+  template <typename F>
+  void execute( const F& f ) {
+    arena_.execute( f );
+  }
+  // Queues f on the arena and returns at once; a worker runs it when it looks for work, ahead of the tasks of a
+  // lower priority.
+  template <typename F>
+  void enqueue( const F& f, tbb::priority_t priority = tbb::priority_normal ) {
+    arena_.enqueue( f, priority );
+  }
+
+  // Scratch memory of the calling thread for the temporaries of the parallel stages. A stage rewinds it with a
+  // PCCArenaScope when it is done, so the blocks are reused from one patch, point or frame to the next; the scopes
+  // nest, as a thread only picks up other tasks from inside the one it runs.
+  PCCMonotonicArena& getThreadArena() { return threadArenas_.local(); }
+  // Frees the blocks of every thread, e.g. between two GOFs: no stage may be running.
+  void releaseThreadArenas() {
+    for ( auto& arena : threadArenas_ ) { arena.release(); }
+  }
+
+ private:
+  PCCExecutionContext( const PCCExecutionContext& ) = delete;
+  PCCExecutionContext& operator=( const PCCExecutionContext& ) = delete;
+
+  std::mutex                                         usersMutex_;
+  size_t                                             users_;
+  size_t                                             nbThread_;
+  std::string                                        affinity_;
+  tbb::task_arena                                    arena_;
+  std::unique_ptr<PCCThreadPinning>                  pinning_;
+  std::function<void()>                              workerSetup_;
+  tbb::enumerable_thread_specific<PCCMonotonicArena> threadArenas_;
+};
+
+}  // namespace pcc
+
+#endif /* PCCExecutionContext_h */
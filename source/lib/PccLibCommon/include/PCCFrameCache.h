@@ -0,0 +1,104 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCFrameCache_h
+#define PCCFrameCache_h
+
+#include "PCCCommon.h"
+#include "PCCSystem.h"
+
+namespace pcc {
+class PCCPointSet3;
+
+/**
+ * Binary cache of the source frames of a sequence, written once by PccAppIngest and read through a memory mapping
+ * by every encode of the sequence instead of parsing the PLY files again:
+ *
+ *   char[8]  "PCCFRMC1"
+ *   uint64   frameCount
+ *   uint64   startFrameNumber   number of the first frame
+ *   frameCount times: uint64 offset, uint64 pointCount
+ *   the frames: pointCount positions (3 x int16) then pointCount colors (3 x uint8)
+ *
+ * in the byte order of the machine. Frames start on 64-byte boundaries, so that the positions of a mapped frame can
+ * be handed as they are to SIMD code or a GPU upload; older caches without the padding read all the same, the
+ * offsets being in the index.
+ *
+ * A frame written by PCCPointSet3::write to a file named *.pcf is a cache of that one frame, and PCCPointSet3::read
+ * takes such a file wherever it takes a PLY file, e.g. as a reconstructedDataPath or a metrics reference.
+ */
+class PCCFrameCache {
+ public:
+  // true if path is a frame cache, otherwise e.g. a %04d pattern of PLY files
+  static bool isFrameCache( const std::string& path );
+  static bool isFrameCache( const uint8_t* data, const size_t size );
+
+  bool   open( const std::string& path );
+  size_t getFrameCount() const { return frameCount_; }
+  size_t getStartFrameNumber() const { return startFrameNumber_; }
+  bool   contains( const size_t frameNumber ) const {
+    return frameNumber >= startFrameNumber_ && frameNumber < startFrameNumber_ + frameCount_;
+  }
+  // copies the frame out of the mapping
+  bool read( const size_t frameNumber, PCCPointSet3& pointSet ) const;
+
+ private:
+  PCCMappedFile file_;
+  size_t        frameCount_       = 0;
+  size_t        startFrameNumber_ = 0;
+};
+
+/**
+ * writes a frame cache frame by frame; the frame count is known up front.
+ */
+class PCCFrameCacheWriter {
+ public:
+  PCCFrameCacheWriter() = default;
+  ~PCCFrameCacheWriter() { close(); }
+  PCCFrameCacheWriter( const PCCFrameCacheWriter& ) = delete;
+  PCCFrameCacheWriter& operator=( const PCCFrameCacheWriter& ) = delete;
+
+  bool open( const std::string& path, const size_t frameCount, const size_t startFrameNumber );
+  bool append( const PCCPointSet3& pointSet );
+  // writes the index; false if a frame is missing or could not be written
+  bool close();
+
+ private:
+  FILE*                 file_       = nullptr;
+  size_t                frameCount_ = 0;
+  uint64_t              offset_     = 0;
+  std::vector<uint64_t> index_;
+  bool                  failed_     = false;
+};
+}  // namespace pcc
+
+#endif /* PCCFrameCache_h */
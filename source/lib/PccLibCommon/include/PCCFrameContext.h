@@ -37,6 +37,7 @@
 
 #include "PCCPointSet.h"
 #include "PCCPatch.h"
+#include "PCCSpatialIndexCache.h"
 #include "PCCContext.h"
 
 namespace pcc {
@@ -61,7 +62,9 @@ class PCCFrameContext {
     for ( size_t i = 0; i < value.size(); i++ ) pointToPixel_.push_back( value[i] );
     return pointToPixel_.size();
   }
-  std::vector<size_t>&            getBlockToPatch() { return blockToPatch_; }
+  PCCBlockToPatchMap&             getBlockToPatch() { return blockToPatch_; }
+  // per patch, its blocks holding an occupied pixel as u0 | v0 << 16, see PCCCodec::generatePointCloud()
+  std::vector<std::vector<uint32_t>>& getOccupiedBlocks() { return occupiedBlocks_; }
   std::vector<uint32_t>&          getOccupancyMap() { return occupancyMap_; }
   std::vector<uint32_t>&          getFullOccupancyMap() { return fullOccupancyMap_; }
   std::vector<PCCPatch>&          getPatches() { return patches_; }
@@ -89,6 +92,7 @@ class PCCFrameContext {
   void                            setMaxDepth( size_t value ) { maxDepth_ = value; }
   size_t                          getGeometry2dBitdepth() { return geometry2dBitdepth_; }
   std::vector<PCCPointSet3>&      getSrcPointCloudByPatch() { return srcPointCloudByPatch_; }
+  PCCSpatialIndexCache&           getSpatialIndex() { return spatialIndex_; }
   PCCPointSet3&              getSrcPointCloudByPatch( size_t patchIndex ) { return srcPointCloudByPatch_[patchIndex]; }
   std::vector<PCCPointSet3>& getSrcPointCloudByBlock() { return srcPointCloudByBlock_; }
   uint8_t&                   getPointLocalReconstructionNumber() { return pointLocalReconstructionNumber_; }
@@ -154,6 +158,7 @@ class PCCFrameContext {
   void printBlockToPatch( const size_t occupancyResolution );
   void printPatch();
   void printPatchDecoder();
+  void getMemoryUsage( PCCMemoryUsage& usage ) const;
 
  private:
   size_t                                       frameIndex_;
@@ -185,7 +190,8 @@ class PCCFrameContext {
   size_t                                       log2PatchQuantizerSizeX_;
   size_t                                       log2PatchQuantizerSizeY_;
   std::vector<PCCVector3<size_t>>              pointToPixel_;
-  std::vector<size_t>                          blockToPatch_;
+  PCCBlockToPatchMap                           blockToPatch_;
+  std::vector<std::vector<uint32_t>>           occupiedBlocks_;
   std::vector<uint32_t>                        occupancyMap_;
   std::vector<uint32_t>                        fullOccupancyMap_;
   std::vector<PCCPatch>                        patches_;
@@ -194,6 +200,7 @@ class PCCFrameContext {
   std::vector<PCCColor3B>                      rawAttributes_;
   std::vector<PCCColor3B>                      eomAttributes_;
   std::vector<PCCPointSet3>                    srcPointCloudByPatch_;
+  PCCSpatialIndexCache                         spatialIndex_;
   std::vector<PCCPointSet3>                    srcPointCloudByBlock_;
   std::vector<PCCPointSet3>                    recPointCloudByBlock_;
   std::vector<std::vector<PCCVector3<size_t>>> pointToPixelByBlock_;
@@ -557,6 +564,11 @@ class PCCAtlasFrameContext {
 
   std::vector<int>& getPartitionToTileMap() { return partitionToTileMap_; }
 
+  void getMemoryUsage( PCCMemoryUsage& usage ) const {
+    for ( const auto& tile : tileContexts_ ) { tile.getMemoryUsage( usage ); }
+    titleFrameContext_.getMemoryUsage( usage );
+  }
+
  private:
   size_t                       atlasFrameIndex_;
   size_t                       atlasFrameWidth_;
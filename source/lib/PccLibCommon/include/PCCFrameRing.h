@@ -0,0 +1,110 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCFrameRing_h
+#define PCCFrameRing_h
+
+#include "PCCCommon.h"
+
+namespace pcc {
+class PCCPointSet3;
+
+/**
+ * Ring of decoded frames in POSIX shared memory (shm_open), for a renderer in another process to take the frames
+ * from as fast as they are decoded, without PLY files in between:
+ *
+ *   header, 64 bytes:
+ *     char[8]  "PCCRING1"
+ *     uint32   slotCount
+ *     uint32   maxPoints          points a slot holds
+ *     uint64   slotSize           bytes of a slot, its header included
+ *     uint32   published          frames published so far, modulo 2^32; the word to futex-wait on
+ *   slotCount slots of slotSize bytes, frame k of the ring in slot k % slotCount:
+ *     uint32   sequence           odd while the slot is written
+ *     uint32   (padding)
+ *     uint64   frameIndex         frame number in the sequence
+ *     uint64   pointCount
+ *     uint64   timestamp          nanoseconds of the steady clock when the frame was published
+ *     (padding to 64 bytes)
+ *     maxPoints positions (3 x int16), then maxPoints colors (3 x uint8), of which the first pointCount are used
+ *
+ * in the byte order of the machine. The decoder never waits for the renderer: a slot it comes back to is written
+ * over, and a reader that sees sequence change while it copied the slot drops that copy. On Linux the writer wakes
+ * the readers with a futex on published after each frame; elsewhere they poll it.
+ */
+class PCCFrameRing {
+ public:
+  PCCFrameRing() = default;
+  ~PCCFrameRing() { close(); }
+  PCCFrameRing( const PCCFrameRing& ) = delete;
+  PCCFrameRing& operator=( const PCCFrameRing& ) = delete;
+
+  // creates the shared memory object name ("/name"), in place of one left by an earlier decoder
+  bool create( const std::string& name, const size_t slotCount, const size_t maxPoints );
+  // false if the frame has more points than a slot holds
+  bool publish( const size_t frameIndex, const PCCPointSet3& pointSet );
+  // unmaps and unlinks the object; readers keep their mapping of it
+  void close();
+
+ private:
+  uint8_t*    data_ = nullptr;
+  size_t      size_ = 0;
+  std::string name_;
+};
+
+/**
+ * the renderer's side of a PCCFrameRing.
+ */
+class PCCFrameRingReader {
+ public:
+  PCCFrameRingReader() = default;
+  ~PCCFrameRingReader() { close(); }
+  PCCFrameRingReader( const PCCFrameRingReader& ) = delete;
+  PCCFrameRingReader& operator=( const PCCFrameRingReader& ) = delete;
+
+  bool open( const std::string& name );
+  void close();
+  // frames published so far
+  uint32_t getPublished() const;
+  // waits up to timeoutMs for published to move on from seen, and returns it
+  uint32_t wait( const uint32_t seen, const int timeoutMs ) const;
+  // copies frame k of the ring; false if it is no longer, or not yet, in its slot
+  bool read( const uint32_t k, PCCPointSet3& pointSet, size_t& frameIndex, uint64_t& timestamp ) const;
+
+ private:
+  uint8_t* data_ = nullptr;
+  size_t   size_ = 0;
+};
+
+}  // namespace pcc
+
+#endif  // PCCFrameRing_h
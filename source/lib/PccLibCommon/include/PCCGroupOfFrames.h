@@ -42,11 +42,14 @@ class PCCGroupOfFrames {
  public:
   PCCGroupOfFrames();
   PCCGroupOfFrames( size_t value );
+  PCCGroupOfFrames( PCCGroupOfFrames&& other ) noexcept;
+  PCCGroupOfFrames& operator=( PCCGroupOfFrames&& other ) noexcept;
   ~PCCGroupOfFrames();
 
-  void                clear() { frames_.clear(); }
+  void                clear();
   size_t              getFrameCount() const { return frames_.size(); }
   void                setFrameCount( size_t n ) { frames_.resize( n ); }
+  size_t              getMemorySize() const;
   const PCCPointSet3& operator[]( const size_t index ) const {
     assert( index < frames_.size() );
     return frames_[index];
@@ -66,13 +69,29 @@ class PCCGroupOfFrames {
              const bool              readNormals = false,
              const size_t            nbThread    = 1 );
 
+  // Windowed group: the frames are only read when acquired, the next windowSize - 1 ones being prefetched by a
+  // loader thread, and are freed when released, so that about windowSize frames are resident whatever the group
+  // size. The frames of a windowed group are accessed with acquire/release only.
+  bool open( const std::string&      uncompressedDataPath,
+             const size_t            startFrameNumber,
+             const size_t            endFrameNumber,
+             const PCCColorTransform colorTransform,
+             const size_t            windowSize,
+             const bool              readNormals = false );
+  bool                isWindowed() const { return window_ != nullptr; }
+  const PCCPointSet3& acquire( const size_t index ) const;
+  void                release( const size_t index ) const;
+
   bool write( const std::string& reconstructedDataPath,
               size_t&            frameNumber,
               const size_t       nbThread = 1,
-              const bool         isAscii  = true );
+              const bool         isAscii  = true,
+              const bool         directIO = false );
 
  private:
+  class Window;
   std::vector<PCCPointSet3> frames_;
+  std::unique_ptr<Window>   window_;
 };
 }  // namespace pcc
 
@@ -35,17 +35,96 @@
 #define PCCImage_h
 
 #include "PCCCommon.h"
+#if defined( _WIN32 )
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
 
 namespace pcc {
 
+#define PCC_IMAGE_ALIGNMENT 64
+#define PCC_IMAGE_LARGE_PAGE ( size_t( 2 ) << 20 )
+
+// Buffers of a large page or more, the channels of whole frames, start on a large page boundary and are backed by
+// transparent huge pages where the system has them: fewer TLB misses when frames are copied to and from files and
+// codecs. Smaller ones are aligned to alignment.
+void* allocateImageBuffer( size_t size, size_t alignment );
+void  freeImageBuffer( void* ptr );
+
+// Allocator giving cache line (and AVX-512) aligned buffers to the image channels.
+template <typename T, size_t Alignment = PCC_IMAGE_ALIGNMENT>
+class PCCAlignedAllocator {
+ public:
+  typedef T value_type;
+  template <typename U>
+  struct rebind {
+    typedef PCCAlignedAllocator<U, Alignment> other;
+  };
+  PCCAlignedAllocator() = default;
+  template <typename U>
+  PCCAlignedAllocator( const PCCAlignedAllocator<U, Alignment>& ) {}
+
+  T* allocate( size_t count ) {
+    void* ptr = allocateImageBuffer( count * sizeof( T ), Alignment );
+    if ( ptr == nullptr ) { throw std::bad_alloc(); }
+    return static_cast<T*>( ptr );
+  }
+  void deallocate( T* ptr, size_t ) { freeImageBuffer( ptr ); }
+  template <typename U>
+  bool operator==( const PCCAlignedAllocator<U, Alignment>& ) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=( const PCCAlignedAllocator<U, Alignment>& ) const {
+    return false;
+  }
+};
+
+// View of one channel of a PCCImage in the resolution of that channel: row v starts at getRow( v ).
+template <typename T>
+class PCCImagePlane {
+ public:
+  PCCImagePlane( T* data, size_t width, size_t height, size_t stride ) :
+      data_( data ), width_( width ), height_( height ), stride_( stride ) {}
+  T*     getData() const { return data_; }
+  size_t getWidth() const { return width_; }
+  size_t getHeight() const { return height_; }
+  size_t getStride() const { return stride_; }
+  T*     getRow( const size_t v ) const { return data_ + v * stride_; }
+  T&     operator()( const size_t u, const size_t v ) const { return data_[v * stride_ + u]; }
+
+ private:
+  T*     data_;
+  size_t width_;
+  size_t height_;
+  size_t stride_;
+};
+
+// What PCCImage::set() applies to the samples it copies, in the same pass: the bit depth alignment of
+// convertBitdepth() and the YUV420 to YUV444 upsampling of convertYUV420ToYUV444(). With upsampleChroma the image
+// gets deprecated color format 0, as after PCCVideoDecoder's setDeprecatedColorFormat() and convertYUV420ToYUV444().
+struct PCCImageConversion {
+  uint8_t bitdepthInput  = 0;  // 0 for no bit depth alignment
+  uint8_t bitdepthOutput = 0;
+  bool    msbAlignFlag   = false;
+  bool    upsampleChroma = false;
+};
+
 template <typename T, size_t N>
 class PCCImage {
  public:
-  PCCImage() : width_( 0 ), height_( 0 ), format_( PCCCOLORFORMAT::UNKNOWN ), deprecatedColorFormat_( 0 ) {}
+  typedef std::vector<T, PCCAlignedAllocator<T>> Channel;
+
+  PCCImage() : width_( 0 ), height_( 0 ), format_( PCCCOLORFORMAT::UNKNOWN ), deprecatedColorFormat_( 0 ) {
+    for ( size_t c = 0; c < N; c++ ) { planeWidth_[c] = planeHeight_[c] = shift_[c] = 0; }
+  }
   PCCImage( const PCCImage& ) = default;
+  PCCImage( PCCImage&& )      = default;
   PCCImage& operator=( const PCCImage& rhs ) = default;
-  ~PCCImage()                                = default;
-  std::vector<T>& operator[]( int index ) { return channels_[index]; }
+  PCCImage& operator=( PCCImage&& rhs ) = default;
+  ~PCCImage()                           = default;
+  Channel& operator[]( int index ) { return channels_[index]; }
 
   template <typename FromT>
   PCCImage<T, 3>& operator=( const PCCImage<FromT, 3>& image ) {
@@ -71,9 +150,31 @@ class PCCImage {
   size_t                getChannelCount() const { return N; }
   size_t                getDeprecatedColorFormat() const { return deprecatedColorFormat_; }
   void                  setDeprecatedColorFormat( size_t value ) { deprecatedColorFormat_ = value; }
-  const std::vector<T>& getChannel( size_t index ) const { return channels_[index]; }
-  std::vector<T>&       getChannel( size_t index ) { return channels_[index]; }
-  void                  set( const T value = 0 ) {
+  const Channel&        getChannel( size_t index ) const { return channels_[index]; }
+  Channel&              getChannel( size_t index ) { return channels_[index]; }
+  size_t                getMemorySize() const {
+    size_t size = 0;
+    for ( const auto& channel : channels_ ) { size += channel.capacity() * sizeof( T ); }
+    return size;
+  }
+
+  // channel geometry: chroma planes of YUV420 images are half the width and height of the luma one. The rows of
+  // a plane are contiguous (stride == width) so that the channels keep their file and codec layout.
+  size_t                getPlaneWidth( size_t index ) const { return planeWidth_[index]; }
+  size_t                getPlaneHeight( size_t index ) const { return planeHeight_[index]; }
+  size_t                getStride( size_t index ) const { return planeWidth_[index]; }
+  T*                    getRow( size_t index, size_t v ) { return channels_[index].data() + v * planeWidth_[index]; }
+  const T*              getRow( size_t index, size_t v ) const {
+    return channels_[index].data() + v * planeWidth_[index];
+  }
+  PCCImagePlane<T> getPlane( size_t index ) {
+    return PCCImagePlane<T>( channels_[index].data(), planeWidth_[index], planeHeight_[index], planeWidth_[index] );
+  }
+  PCCImagePlane<const T> getPlane( size_t index ) const {
+    return PCCImagePlane<const T>( channels_[index].data(), planeWidth_[index], planeHeight_[index],
+                                   planeWidth_[index] );
+  }
+  void set( const T value = 0 ) {
     for ( auto& channel : channels_ ) {
       for ( auto& p : channel ) { p = value; }
     }
@@ -98,8 +199,17 @@ class PCCImage {
             size_t         strideC,
             int16_t        shiftbits,
             PCCCOLORFORMAT format,
-            bool           rgb2bgr ) {
+            bool           rgb2bgr,
+            const PCCImageConversion& conversion = PCCImageConversion() ) {
+    const bool upsample = conversion.upsampleChroma && format == PCCCOLORFORMAT::YUV420;
+    const int  bitDiff  = (int)conversion.bitdepthInput - (int)conversion.bitdepthOutput;
+    if ( upsample || ( conversion.bitdepthInput != 0 && ( bitDiff >= 0 || conversion.msbAlignFlag ) ) ) {
+      setConverted( Y, U, V, widthY, heightY, strideY, widthC, heightC, strideC, shiftbits, format, rgb2bgr,
+                    conversion );
+      return;
+    }
     resize( widthY, heightY, format );
+    if ( conversion.upsampleChroma ) { deprecatedColorFormat_ = 0; }
     const Pel*   ptr[2][3] = {{Y, U, V}, {V, Y, U}};
     const size_t width[3]  = {widthY, widthC, widthC};
     const size_t height[3] = {heightY, heightC, heightC};
@@ -175,8 +285,26 @@ class PCCImage {
     }
   }
 
+  // bytes of the frame in a raw video file: the channels one after the other, nbyte bytes per sample
+  size_t getFileSize( const size_t nbyte ) const;
+  // same for an image of that size and format, as resize() lays it out
+  static size_t getFileSize( const size_t sizeU0, const size_t sizeV0, const PCCCOLORFORMAT format, const size_t nbyte ) {
+    const size_t size = sizeU0 * sizeV0;
+    return ( format == PCCCOLORFORMAT::YUV420 ? size + 2 * ( size >> 2 ) : N * size ) * nbyte;
+  }
+  // the frame from and to the memory of a raw video file, e.g. a mapped one; read() resizes the image and fails if
+  // size is less than the frame. 8-bit samples are converted on the fly for and from 16-bit images
+  bool read( const uint8_t*       data,
+             const size_t         size,
+             const size_t         sizeU0,
+             const size_t         sizeV0,
+             const PCCCOLORFORMAT format,
+             const size_t         nbyte );
+  bool write( uint8_t* data, const size_t nbyte ) const;
+
   bool write( std::ofstream& outfile, const size_t nbyte );
 
+  // through a memory mapping of the file, see PCCMappedFile and PCCMappedOutputFile
   bool write( const std::string fileName, const size_t nbyte );
 
   bool read( std::ifstream&       infile,
@@ -190,13 +318,11 @@ class PCCImage {
              const PCCCOLORFORMAT format,
              const size_t         nbyte );
 
+  // u and v are luma coordinates, the chroma ones are derived from the plane subsampling without branching
   void setValue( const size_t channelIndex, const size_t u, const size_t v, const T value ) {
     assert( channelIndex < N && u < width_ && v < height_ );
-    if ( format_ == YUV420 && channelIndex != 0 ) {
-      channels_[channelIndex][( v >> 1 ) * ( width_ >> 1 ) + ( u >> 1 )] = value;
-    } else {
-      channels_[channelIndex][v * width_ + u] = value;
-    }
+    const size_t shift = shift_[channelIndex];
+    channels_[channelIndex][( v >> shift ) * planeWidth_[channelIndex] + ( u >> shift )] = value;
   }
   void setValueYuvChroma( const size_t channelIndex, const size_t u, const size_t v, const T value ) {
     channels_[channelIndex][v * ( width_ >> 1 ) + u] = value;
@@ -204,18 +330,35 @@ class PCCImage {
 
   T getValue( const size_t channelIndex, const size_t u, const size_t v ) const {
     assert( channelIndex < N && u < width_ && v < height_ );
-    if ( format_ == YUV420 && channelIndex != 0 ) {
-      return channels_[channelIndex][( v >> 1 ) * ( width_ >> 1 ) + ( u >> 1 )];
-    } else {
-      return channels_[channelIndex][v * width_ + u];
-    }
+    const size_t shift = shift_[channelIndex];
+    return channels_[channelIndex][( v >> shift ) * planeWidth_[channelIndex] + ( u >> shift )];
   }
   T& getValue( const size_t channelIndex, const size_t u, const size_t v ) {
     assert( channelIndex < N && u < width_ && v < height_ );
-    if ( format_ == YUV420 && channelIndex != 0 ) {
-      return channels_[channelIndex][( v >> 1 ) * ( width_ >> 1 ) + ( u >> 1 )];
+    const size_t shift = shift_[channelIndex];
+    return channels_[channelIndex][( v >> shift ) * planeWidth_[channelIndex] + ( u >> shift )];
+  }
+
+  // fast paths for callers that know the format: all planes full size, or chroma subsampled by two
+  T getValue444( const size_t channelIndex, const size_t u, const size_t v ) const {
+    assert( format_ != YUV420 && channelIndex < N && u < width_ && v < height_ );
+    return channels_[channelIndex][v * width_ + u];
+  }
+  void setValue444( const size_t channelIndex, const size_t u, const size_t v, const T value ) {
+    assert( format_ != YUV420 && channelIndex < N && u < width_ && v < height_ );
+    channels_[channelIndex][v * width_ + u] = value;
+  }
+  T getValue420( const size_t channelIndex, const size_t u, const size_t v ) const {
+    assert( format_ == YUV420 && channelIndex < N && u < width_ && v < height_ );
+    return channelIndex == 0 ? channels_[0][v * width_ + u]
+                             : channels_[channelIndex][( v >> 1 ) * ( width_ >> 1 ) + ( u >> 1 )];
+  }
+  void setValue420( const size_t channelIndex, const size_t u, const size_t v, const T value ) {
+    assert( format_ == YUV420 && channelIndex < N && u < width_ && v < height_ );
+    if ( channelIndex == 0 ) {
+      channels_[0][v * width_ + u] = value;
     } else {
-      return channels_[channelIndex][v * width_ + u];
+      channels_[channelIndex][( v >> 1 ) * ( width_ >> 1 ) + ( u >> 1 )] = value;
     }
   }
 
@@ -236,9 +379,71 @@ class PCCImage {
   float  clamp( float v, float a, float b ) const { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
   double clamp( double v, double a, double b ) const { return ( ( v < a ) ? a : ( ( v > b ) ? b : v ) ); }
 
+  // true if the block has the format of this image and its edges fall on whole samples of every plane: then
+  // copyBlock() and setBlock() copy the rows of each plane, and otherwise sample by sample in luma coordinates
+  bool isBlockAligned( size_t top, size_t left, size_t width, size_t height, const PCCImage& block ) const;
+
+  // set() with the conversion applied to each sample as it is written, one row at a time: an upsampled chroma row is
+  // written twice as wide and copied to the next row while it is still in the cache.
+  template <typename Pel>
+  void setConverted( const Pel*                Y,
+                     const Pel*                U,
+                     const Pel*                V,
+                     size_t                    widthY,
+                     size_t                    heightY,
+                     size_t                    strideY,
+                     size_t                    widthC,
+                     size_t                    heightC,
+                     size_t                    strideC,
+                     int16_t                   shiftbits,
+                     PCCCOLORFORMAT            format,
+                     bool                      rgb2bgr,
+                     const PCCImageConversion& conversion ) {
+    const bool upsample = conversion.upsampleChroma && format == PCCCOLORFORMAT::YUV420;
+    resize( widthY, heightY, upsample ? PCCCOLORFORMAT::YUV444 : format );
+    if ( conversion.upsampleChroma ) { deprecatedColorFormat_ = 0; }
+    const Pel*   ptr[2][3] = {{Y, U, V}, {V, Y, U}};
+    const size_t width[3]  = {widthY, widthC, widthC};
+    const size_t height[3] = {heightY, heightC, heightC};
+    const size_t stride[3] = {strideY, strideC, strideC};
+    const int    rounding  = shiftbits > 0 ? 1 << ( shiftbits - 1 ) : 0;
+    const T      maxShift  = shiftbits > 0 ? ( T )( ( 1 << ( 10 - (int)shiftbits ) ) - 1 ) : T( 0 );
+    const int    bitDiff   = (int)conversion.bitdepthInput - (int)conversion.bitdepthOutput;
+    const bool   align     = conversion.bitdepthInput != 0 && ( bitDiff >= 0 || conversion.msbAlignFlag );
+    const T      maxValue  = ( T )( ( 1 << conversion.bitdepthOutput ) - 1 );
+    auto         convert   = [&]( const Pel sample ) {
+      T value = shiftbits > 0 ? clamp( ( T )( ( sample + rounding ) >> shiftbits ), T( 0 ), maxShift ) : (T)sample;
+      if ( align ) {
+        if ( bitDiff >= 0 ) {
+          value = conversion.msbAlignFlag ? ( T )( value >> bitDiff ) : tMin( value, maxValue );
+        } else {
+          value = ( T )( value << -bitDiff );
+        }
+      }
+      return value;
+    };
+    for ( size_t c = 0; c < 3; c++ ) {
+      auto* src = ptr[rgb2bgr][c];
+      auto* dst = channels_[c].data();
+      if ( upsample && c > 0 ) {
+        for ( size_t v = 0; v < height[c]; ++v, src += stride[c], dst += 2 * width_ ) {
+          for ( size_t u = 0; u < width[c]; ++u ) { dst[2 * u] = dst[2 * u + 1] = convert( src[u] ); }
+          memcpy( dst + width_, dst, width_ * sizeof( T ) );
+        }
+      } else {
+        for ( size_t v = 0; v < height[c]; ++v, src += stride[c], dst += width[c] ) {
+          for ( size_t u = 0; u < width[c]; ++u ) { dst[u] = convert( src[u] ); }
+        }
+      }
+    }
+  }
+
   size_t         width_;
   size_t         height_;
-  std::vector<T> channels_[N];
+  Channel        channels_[N];
+  size_t         planeWidth_[N];
+  size_t         planeHeight_[N];
+  size_t         shift_[N];  // log2 of the plane subsampling
   PCCCOLORFORMAT format_;
   size_t         deprecatedColorFormat_;  // 0.RGB 1.YUV420 2.YUV444 16bits  // TODO JR: must be removed
 };
@@ -35,6 +35,7 @@
 
 #include "PCCCommon.h"
 #include "PCCPointSet.h"
+#include "PCCArena.h"
 
 namespace pcc {
 
@@ -82,6 +83,30 @@ class PCCNNResult {
   std::vector<double> dist_;
 };
 
+// Neighbors of a batch of query points, stored as flat row-major matrices: row i holds the neighbors of the query
+// point i, closest first.
+template <typename T = double>
+class PCCNNBatchResult {
+ public:
+  PCCNNBatchResult() : neighborCount_( 0 ) {}
+  inline void resize( const size_t queryCount, const size_t neighborCount ) {
+    neighborCount_ = neighborCount;
+    indices_.resize( queryCount * neighborCount );
+    dist_.resize( queryCount * neighborCount );
+  }
+  inline size_t  queryCount() const { return neighborCount_ == 0 ? 0 : indices_.size() / neighborCount_; }
+  inline size_t  neighborCount() const { return neighborCount_; }
+  inline size_t& indices( size_t query, size_t index ) { return indices_[query * neighborCount_ + index]; }
+  inline T&      dist( size_t query, size_t index ) { return dist_[query * neighborCount_ + index]; }
+  inline size_t* indices( size_t query ) { return indices_.data() + query * neighborCount_; }
+  inline T*      dist( size_t query ) { return dist_.data() + query * neighborCount_; }
+
+ private:
+  size_t              neighborCount_;
+  std::vector<size_t> indices_;
+  std::vector<T>      dist_;
+};
+
 class PCCKdTree {
  public:
   PCCKdTree();
@@ -93,6 +118,17 @@ class PCCKdTree {
                      const size_t      num_results,
                      const double      radius,
                      PCCNNResult&      results ) const;
+  // Same neighbors in the same order, collected into a caller-provided buffer instead of a new vector per query.
+  void searchRadius( const PCCPoint3D&                          point,
+                     const size_t                               num_results,
+                     const double                               radius,
+                     PCCArenaVector<std::pair<size_t, double>>& results ) const;
+  // k nearest neighbors of all the points, searched in parallel. Each row holds min( num_results, tree point count )
+  // neighbors; T is double or float.
+  template <typename T>
+  void searchBatch( const std::vector<PCCPoint3D>& points,
+                    const size_t                   num_results,
+                    PCCNNBatchResult<T>&           results ) const;
 
  private:
   void  clear();
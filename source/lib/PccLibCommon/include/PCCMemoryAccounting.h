@@ -0,0 +1,86 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "PCCCommon.h"
+#include <map>
+#include <mutex>
+
+namespace pcc {
+
+// Owners of the large buffers of the encoder and decoder, as accounted by PCCMemoryAccounting.
+enum PCCMemoryTag {
+  MEMORY_VIDEO = 0,       // frames of the occupancy, geometry and attribute videos
+  MEMORY_POINT_SET,       // point clouds: reconstructions, sources and per patch or block clouds
+  MEMORY_BLOCK_TO_PATCH,  // block to patch, occupancy and point to pixel maps of the frame contexts
+  MEMORY_PATCH,           // patch lists with their depth and occupancy maps
+  MEMORY_BITSTREAM,       // V3C and video bitstreams
+  MEMORY_TAG_COUNT
+};
+
+// Bytes held by each owner, measured from the capacity of its buffers.
+struct PCCMemoryUsage {
+  size_t bytes_[MEMORY_TAG_COUNT] = {};
+
+  void   add( PCCMemoryTag tag, size_t bytes ) { bytes_[tag] += bytes; }
+  size_t getTotal() const;
+};
+
+// High-water marks of the owners per stage and over the whole run. getPeakMemory() only reports the process peak;
+// this tells which structures make it up. The codecs sample the usage at the end of their stages, once the tasks
+// of the stage are done with the structures.
+class PCCMemoryAccounting {
+ public:
+  PCCMemoryAccounting()  = default;
+  ~PCCMemoryAccounting() = default;
+
+  void                  sample( const std::string& stage, const PCCMemoryUsage& usage );
+  const PCCMemoryUsage& getPeak() const { return peak_; }
+  size_t                getPeakTotal() const { return peakTotal_; }
+  void                  trace();
+
+ private:
+  struct Stage {
+    PCCMemoryUsage peak_;
+    size_t         peakTotal_ = 0;
+    size_t         count_     = 0;
+  };
+  std::mutex                   mutex_;
+  std::vector<std::string>     order_;
+  std::map<std::string, Stage> stages_;
+  PCCMemoryUsage               peak_;  // of each owner, possibly reached at different stages
+  size_t                       peakTotal_ = 0;
+  std::string                  peakStage_;
+};
+
+}  // namespace pcc
@@ -0,0 +1,85 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCMorton_h
+#define PCCMorton_h
+
+#include "PCCCommon.h"
+#include "PCCMath.h"
+
+namespace pcc {
+
+// Morton codes of 3D positions: the bits of x, y and z, 21 bits each, interleaved with x in the lowest bit of every
+// triplet. Sorting by code visits the cells of an octree depth first, so that the points close in space are close in
+// memory. The scalar functions spread and compact the bits with shifts and masks; mortonEncode() of a point array
+// uses BMI2 pdep when the CPU has it.
+
+static inline uint64_t mortonSpread( uint64_t value ) {
+  value &= 0x1fffff;
+  value = ( value | value << 32 ) & 0x1f00000000ffff;
+  value = ( value | value << 16 ) & 0x1f0000ff0000ff;
+  value = ( value | value << 8 ) & 0x100f00f00f00f00f;
+  value = ( value | value << 4 ) & 0x10c30c30c30c30c3;
+  value = ( value | value << 2 ) & 0x1249249249249249;
+  return value;
+}
+
+static inline uint32_t mortonCompact( uint64_t value ) {
+  value &= 0x1249249249249249;
+  value = ( value | value >> 2 ) & 0x10c30c30c30c30c3;
+  value = ( value | value >> 4 ) & 0x100f00f00f00f00f;
+  value = ( value | value >> 8 ) & 0x1f0000ff0000ff;
+  value = ( value | value >> 16 ) & 0x1f00000000ffff;
+  value = ( value | value >> 32 ) & 0x1fffff;
+  return static_cast<uint32_t>( value );
+}
+
+static inline uint64_t mortonEncode( const uint32_t x, const uint32_t y, const uint32_t z ) {
+  return mortonSpread( x ) | mortonSpread( y ) << 1 | mortonSpread( z ) << 2;
+}
+
+static inline void mortonDecode( const uint64_t code, uint32_t& x, uint32_t& y, uint32_t& z ) {
+  x = mortonCompact( code );
+  y = mortonCompact( code >> 1 );
+  z = mortonCompact( code >> 2 );
+}
+
+// codes[i] = the code of ( points[i] - origin ) >> shift; the points must not be below origin.
+void mortonEncode( const PCCPoint3D* points,
+                   const size_t      count,
+                   const PCCPoint3D& origin,
+                   const uint32_t    shift,
+                   uint64_t*         codes );
+
+};  // namespace pcc
+
+#endif /* PCCMorton_h */
@@ -0,0 +1,242 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef PCCOccupancyBitMap_h
+#define PCCOccupancyBitMap_h
+
+#include "PCCCommon.h"
+#include "PCCImage.h"
+#include "PCCPointSetKernels.h"
+
+namespace pcc {
+
+static inline size_t popcount64( uint64_t x ) {
+#ifdef __GNUC__
+  return static_cast<size_t>( __builtin_popcountll( x ) );
+#else
+  x = x - ( ( x >> 1 ) & 0x5555555555555555ULL );
+  x = ( x & 0x3333333333333333ULL ) + ( ( x >> 2 ) & 0x3333333333333333ULL );
+  x = ( x + ( x >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<size_t>( ( x * 0x0101010101010101ULL ) >> 56 );
+#endif
+}
+
+// Occupancy map packed one bit per pixel in 64-bit words, each row starting on a new word. Block occupancy tests
+// are popcounts over the words of the block rows instead of one test per pixel. The patch packing uses it with one
+// bit per block as the canvas the patches are fitted in.
+class PCCOccupancyBitMap {
+ public:
+  PCCOccupancyBitMap() : width_( 0 ), height_( 0 ), stride_( 0 ) {}
+  ~PCCOccupancyBitMap() = default;
+
+  void resize( const size_t width, const size_t height ) {
+    width_  = width;
+    height_ = height;
+    stride_ = ( width + 63 ) / 64;
+    words_.assign( stride_ * height, 0 );
+  }
+  // Adds or removes rows at the bottom, keeping the others.
+  void setHeight( const size_t height ) {
+    height_ = height;
+    words_.resize( stride_ * height, 0 );
+  }
+  size_t          getWidth() const { return width_; }
+  size_t          getHeight() const { return height_; }
+  const uint64_t* getRow( const size_t y ) const { return words_.data() + y * stride_; }
+  bool get( const size_t x, const size_t y ) const { return ( ( getRow( y )[x >> 6] >> ( x & 63 ) ) & 1U ) != 0U; }
+  void set( const size_t x, const size_t y ) { words_[y * stride_ + ( x >> 6 )] |= uint64_t( 1 ) << ( x & 63 ); }
+  void reset( const size_t x, const size_t y ) { words_[y * stride_ + ( x >> 6 )] &= ~( uint64_t( 1 ) << ( x & 63 ) ); }
+
+  // True when a set bit of mask, placed with its top left corner at (x0, y0), is also set here. The mask must lie
+  // within the map; each of its words is shifted in place and ANDed with the two words it straddles.
+  bool intersects( const PCCOccupancyBitMap& mask, const size_t x0, const size_t y0 ) const {
+    const size_t word  = x0 >> 6;
+    const size_t shift = x0 & 63;
+    for ( size_t y = 0; y < mask.height_; ++y ) {
+      const uint64_t* src = mask.getRow( y );
+      const uint64_t* dst = getRow( y0 + y ) + word;
+      for ( size_t w = 0; w < mask.stride_; ++w ) {
+        if ( src[w] == 0 ) { continue; }
+        if ( ( dst[w] & ( src[w] << shift ) ) != 0 ) { return true; }
+        if ( shift != 0 && word + w + 1 < stride_ && ( dst[w + 1] & ( src[w] >> ( 64 - shift ) ) ) != 0 ) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Packs the width x height rectangle of the first channel of image starting at (x0, y0): a bit is set when the
+  // pixel value is above threshold. The 64 comparisons of a word are made without branches, those of 8-bit images
+  // 32 at a time when AVX2 is available.
+  template <typename T, size_t N>
+  void threshold( const PCCImage<T, N>& image,
+                  const size_t          x0,
+                  const size_t          y0,
+                  const size_t          width,
+                  const size_t          height,
+                  const size_t          threshold ) {
+    resize( width, height );
+    for ( size_t y = 0; y < height; ++y ) {
+      thresholdRow( image.getRow( 0, y0 + y ) + x0, width, threshold, words_.data() + y * stride_ );
+    }
+  }
+
+  // Same for a map of width x height values stored row after row.
+  template <typename T>
+  void threshold( const T* values, const size_t width, const size_t height, const size_t threshold ) {
+    resize( width, height );
+    for ( size_t y = 0; y < height; ++y ) {
+      thresholdRow( values + y * width, width, threshold, words_.data() + y * stride_ );
+    }
+  }
+
+  // Flips every bit of the map; the bits past the width of a row stay clear.
+  void invert() {
+    for ( auto& word : words_ ) { word = ~word; }
+    clearPadding( words_ );
+  }
+
+  // Sets every bit within radius (below 64) of a set bit, diagonals included: each bit becomes the OR of the square of side
+  // 2 * radius + 1 around it, clipped to the map. The rows are dilated a word at a time by shifts that carry across
+  // the word boundaries, then ORed with the radius rows above and below.
+  void dilate( const size_t radius ) {
+    if ( radius == 0 || words_.empty() ) { return; }
+    std::vector<uint64_t> rows( words_.size() );
+    for ( size_t y = 0; y < height_; ++y ) {
+      const uint64_t* src = getRow( y );
+      uint64_t*       dst = rows.data() + y * stride_;
+      for ( size_t w = 0; w < stride_; ++w ) {
+        uint64_t word = src[w];
+        for ( size_t k = 1; k <= radius && k < 64; ++k ) {
+          word |= ( src[w] << k ) | ( src[w] >> k );
+          if ( w > 0 ) { word |= src[w - 1] >> ( 64 - k ); }
+          if ( w + 1 < stride_ ) { word |= src[w + 1] << ( 64 - k ); }
+        }
+        dst[w] = word;
+      }
+    }
+    clearPadding( rows );
+    for ( size_t y = 0; y < height_; ++y ) {
+      const size_t y0  = y > radius ? y - radius : 0;
+      const size_t y1  = ( std::min )( y + radius + 1, height_ );
+      uint64_t*    dst = words_.data() + y * stride_;
+      for ( size_t w = 0; w < stride_; ++w ) {
+        uint64_t word = 0;
+        for ( size_t r = y0; r < y1; ++r ) { word |= rows[r * stride_ + w]; }
+        dst[w] = word;
+      }
+    }
+  }
+
+  // Writes the map back into the first channel of image at (x0, y0) as 0 / 1 values.
+  template <typename T, size_t N>
+  void copyTo( PCCImage<T, N>& image, const size_t x0, const size_t y0 ) const {
+    for ( size_t y = 0; y < height_; ++y ) {
+      T*              dst = image.getRow( 0, y0 + y ) + x0;
+      const uint64_t* src = getRow( y );
+      for ( size_t x = 0; x < width_; ++x ) { dst[x] = static_cast<T>( ( src[x >> 6] >> ( x & 63 ) ) & 1U ); }
+    }
+  }
+
+  // dst[u] = bit u / precision of row y, 0 or 1, for u < count: the row upsampled by precision, as the decoder
+  // expands the occupancy video to the tile resolution.
+  void expandRow( const size_t y, const size_t precision, uint32_t* dst, const size_t count ) const {
+    const uint64_t* src = getRow( y );
+    for ( size_t u = expandOccupancyKernel( src, precision, dst, count ); u < count; ++u ) {
+      const size_t x = u / precision;
+      dst[u]         = static_cast<uint32_t>( ( src[x >> 6] >> ( x & 63 ) ) & 1U );
+    }
+  }
+
+  // Number of set bits in the rectangle [x0, x1) x [y0, y1).
+  size_t count( const size_t x0, const size_t y0, const size_t x1, const size_t y1 ) const {
+    size_t total = 0;
+    if ( x0 >= x1 ) { return 0; }
+    const size_t   w0    = x0 >> 6;
+    const size_t   w1    = ( x1 - 1 ) >> 6;
+    const uint64_t mask0 = ~uint64_t( 0 ) << ( x0 & 63 );
+    const uint64_t mask1 = ~uint64_t( 0 ) >> ( 63 - ( ( x1 - 1 ) & 63 ) );
+    for ( size_t y = y0; y < y1; ++y ) {
+      const uint64_t* row = getRow( y );
+      if ( w0 == w1 ) {
+        total += popcount64( row[w0] & mask0 & mask1 );
+      } else {
+        total += popcount64( row[w0] & mask0 );
+        for ( size_t w = w0 + 1; w < w1; ++w ) { total += popcount64( row[w] ); }
+        total += popcount64( row[w1] & mask1 );
+      }
+    }
+    return total;
+  }
+
+ private:
+  // The words of a row of width pixels, from pixel first on, a multiple of 64.
+  template <typename T>
+  static void thresholdWords( const T*     src,
+                              const size_t first,
+                              const size_t width,
+                              const size_t threshold,
+                              uint64_t*    dst ) {
+    for ( size_t x = first; x < width; x += 64 ) {
+      const size_t count = ( std::min )( size_t( 64 ), width - x );
+      uint64_t     word  = 0;
+      for ( size_t i = 0; i < count; ++i ) { word |= uint64_t( size_t( src[x + i] ) > threshold ) << i; }
+      dst[x >> 6] = word;
+    }
+  }
+  template <typename T>
+  static void thresholdRow( const T* src, const size_t width, const size_t threshold, uint64_t* dst ) {
+    thresholdWords( src, 0, width, threshold, dst );
+  }
+  // The 8-bit rows of the videos go through the vectorized kernel first.
+  static void thresholdRow( const uint8_t* src, const size_t width, const size_t threshold, uint64_t* dst ) {
+    thresholdWords( src, thresholdOccupancyKernel( src, width, threshold, dst ), width, threshold, dst );
+  }
+
+  void clearPadding( std::vector<uint64_t>& words ) const {
+    if ( ( width_ & 63 ) == 0 ) { return; }
+    const uint64_t mask = ( uint64_t( 1 ) << ( width_ & 63 ) ) - 1;
+    for ( size_t y = 0; y < height_; ++y ) { words[y * stride_ + stride_ - 1] &= mask; }
+  }
+
+  size_t                width_;
+  size_t                height_;
+  size_t                stride_;
+  std::vector<uint64_t> words_;
+};
+
+}  // namespace pcc
+
+#endif /* PCCOccupancyBitMap_h */
@@ -36,6 +36,10 @@
 
 #include "PCCCommon.h"
 #include "PCCPointSet.h"
+#include "PCCImage.h"
+#include "PCCOccupancyBitMap.h"
+#include "PCCBlockToPatchMap.h"
+#include <mutex>
 
 namespace pcc {
 
@@ -70,10 +74,37 @@ struct GPAPatchData {
   }
 };
 
+// Canvas pixel ( x, y ) of the patch pixel ( u, v ) in the orientation of the patch, as an integer affine map with
+// coefficients in { -1, 0, 1 }: x = x0_ + xu_ * u + xv_ * v and y = y0_ + yu_ * u + yv_ * v. The matrix is a rotation
+// or a reflection, so its transpose maps the canvas back to the patch. Built once per patch, it keeps the orientation
+// switch of patch2Canvas() and canvasTo3D() out of the pixel loops.
+struct PCCPatchCanvasTransform {
+  int64_t x0_;
+  int64_t xu_;
+  int64_t xv_;
+  int64_t y0_;
+  int64_t yu_;
+  int64_t yv_;
+  size_t  x( const size_t u, const size_t v ) const { return size_t( x0_ + xu_ * int64_t( u ) + xv_ * int64_t( v ) ); }
+  size_t  y( const size_t u, const size_t v ) const { return size_t( y0_ + yu_ * int64_t( u ) + yv_ * int64_t( v ) ); }
+  size_t  u( const size_t x, const size_t y ) const {
+    return size_t( xu_ * ( int64_t( x ) - x0_ ) + yu_ * ( int64_t( y ) - y0_ ) );
+  }
+  size_t v( const size_t x, const size_t y ) const {
+    return size_t( xv_ * ( int64_t( x ) - x0_ ) + yv_ * ( int64_t( y ) - y0_ ) );
+  }
+};
+
 class PCCPatch {
  public:
   PCCPatch();
+  PCCPatch( const PCCPatch& ) = default;
+  PCCPatch( PCCPatch&& )      = default;
+  PCCPatch& operator=( const PCCPatch& ) = default;
+  PCCPatch& operator=( PCCPatch&& ) = default;
   ~PCCPatch();
+  // Puts the patch back in the state of a new one but keeps the capacity of its buffers.
+  void recycle();
   size_t                      getEOMCount() const { return eomCount_; }
   size_t                      getEOMandD1Count() const { return eomandD1Count_; }
   size_t                      getD0Count() const { return d0Count_; }
@@ -207,6 +238,7 @@ class PCCPatch {
   }
 
   PCCPoint3D canvasTo3D( const size_t x, const size_t y, const uint16_t depth ) const;
+  PCCPatchCanvasTransform getCanvasTransform() const;
 
   size_t patch2Canvas( const size_t u, const size_t v, size_t canvasStride, size_t canvasHeight );
   size_t patch2Canvas( const size_t u, const size_t v, size_t canvasStride, size_t canvasHeight, size_t& x, size_t& y );
@@ -216,12 +248,24 @@ class PCCPatch {
                                  size_t       canvasHeightBlk,
                                  const Tile   tile = Tile() ) const;
 
-  bool checkFitPatchCanvas( std::vector<bool> canvas,
-                            size_t            canvasStrideBlk,
-                            size_t            canvasHeightBlk,
-                            bool              bPrecedence,
-                            int               safeguard = 0,
-                            const Tile        tile      = Tile() );
+  bool checkFitPatchCanvas( const std::vector<bool>& canvas,
+                            size_t                   canvasStrideBlk,
+                            size_t                   canvasHeightBlk,
+                            bool                     bPrecedence,
+                            int                      safeguard = 0,
+                            const Tile               tile      = Tile() );
+
+  // Blocks the patch needs free in its current orientation, with (0, 0) at the canvas block (u0_ - safeguard,
+  // v0_ - safeguard): its occupied blocks when bPrecedence is set, all of them otherwise, dilated by safeguard. The
+  // mask does not depend on the position, so it is built once per orientation for all the candidate positions.
+  void getCanvasBlockMask( PCCOccupancyBitMap& mask, bool bPrecedence, int safeguard = 0 ) const;
+
+  // Same test as above on a canvas of one bit per block, with the mask of getCanvasBlockMask() for the current
+  // orientation: the mask must lie within the canvas (and the tile) and not intersect its occupied blocks.
+  bool checkFitPatchCanvas( const PCCOccupancyBitMap& canvas,
+                            const PCCOccupancyBitMap& mask,
+                            int                       safeguard = 0,
+                            const Tile                tile      = Tile() ) const;
 
   bool        smallerRefFirst( const PCCPatch& rhs );
   bool        gt( const PCCPatch& rhs );
@@ -237,19 +281,31 @@ class PCCPatch {
                          std::vector<int>& rightHorizon,
                          std::vector<int>& leftHorizon );
 
+  // Bias of calculateWastedSpace() towards the upper part of the canvas: above the horizon the wasted space is at
+  // least wastedSpaceLambda_ * v0_.
+  static constexpr int wastedSpaceLambda_ = 100;
+
   int calculateWastedSpace( std::vector<int>& horizon,
                             std::vector<int>& topHorizon,
                             std::vector<int>& bottomHorizon,
                             std::vector<int>& rightHorizon,
                             std::vector<int>& leftHorizon );
 
+  // Lowest v0_ for which the patch, in its current orientation at u0_, lies above the horizon; the patch must fit in
+  // the width of the horizon.
+  size_t getLowestV0AboveHorizon( const std::vector<int>& horizon,
+                                  const std::vector<int>& topHorizon,
+                                  const std::vector<int>& bottomHorizon,
+                                  const std::vector<int>& rightHorizon,
+                                  const std::vector<int>& leftHorizon ) const;
+
   bool isPatchLocationAboveHorizon( std::vector<int>& horizon,
                                     std::vector<int>& topHorizon,
                                     std::vector<int>& bottomHorizon,
                                     std::vector<int>& rightHorizon,
                                     std::vector<int>& leftHorizon );
 
-  bool isPatchDimensionSwitched() {
+  bool isPatchDimensionSwitched() const {
     return !( ( getPatchOrientation() == PATCH_ORIENTATION_DEFAULT ) ||
               ( getPatchOrientation() == PATCH_ORIENTATION_ROT180 ) ||
               ( getPatchOrientation() == PATCH_ORIENTATION_MIRROR ) ||
@@ -271,11 +327,11 @@ class PCCPatch {
                                     size_t       canvasStrideBlk,
                                     size_t       canvasHeightBlk ) const;
 
-  bool checkFitPatchCanvasForGPA( std::vector<bool> canvas,
-                                  size_t            canvasStrideBlk,
-                                  size_t            canvasHeightBlk,
-                                  bool              bPrecedence,
-                                  int               safeguard = 0 );
+  bool checkFitPatchCanvasForGPA( const std::vector<bool>& canvas,
+                                  size_t                   canvasStrideBlk,
+                                  size_t                   canvasHeightBlk,
+                                  bool                     bPrecedence,
+                                  int                      safeguard = 0 );
 
   void     allocOneLayerData();
   uint8_t& getPointLocalReconstructionLevel() { return pointLocalReconstructionLevel_; }
@@ -290,21 +346,21 @@ class PCCPatch {
 
   inline void   setIndexCopy( size_t index ) { indexCopy_ = index; }
   inline size_t getIndexCopy() { return indexCopy_; }
-  void          setDepthFromGeometryVideo( const std::vector<uint16_t>& geometryVideo,
-                                           const int32_t                u2,
-                                           const int32_t                v2,
-                                           int32_t                      width,
-                                           int32_t                      height,
-                                           int32_t                      occupancyPrecision,
-                                           int16_t*                     depth );
-
-  void setLocalData( const std::vector<uint8_t>&  occupancyMapVideo,
-                     const std::vector<uint16_t>& geometryVideo,
-                     std::vector<size_t>&         blockToPatch,
-                     const int32_t                width,
-                     const int32_t                height,
-                     const int32_t                occupancyPrecision,
-                     const int32_t                threhold );
+  void          setDepthFromGeometryVideo( const PCCImage<uint16_t, 3>::Channel& geometryVideo,
+                                           const int32_t                         u2,
+                                           const int32_t                         v2,
+                                           int32_t                               width,
+                                           int32_t                               height,
+                                           int32_t                               occupancyPrecision,
+                                           int16_t*                              depth );
+
+  void setLocalData( const PCCImage<uint8_t, 3>::Channel&  occupancyMapVideo,
+                     const PCCImage<uint16_t, 3>::Channel& geometryVideo,
+                     const PCCBlockToPatchMap&             blockToPatch,
+                     const int32_t                         width,
+                     const int32_t                         height,
+                     const int32_t                         occupancyPrecision,
+                     const int32_t                         threhold );
   void setPointLocalReconstructionMode( const size_t u, const size_t v, const uint8_t value ) {
     if ( pointLocalReconstructionLevel_ == 1 ) {
       pointLocalReconstructionModeByPatch_ = value;
@@ -343,6 +399,14 @@ class PCCPatch {
     neighboringPatches_.clear();
     depthMap_.clear();
   }
+  // bytes held by the depth, occupancy and filtering buffers of the patch
+  size_t getMemorySize() const {
+    return ( depth_[0].capacity() + depth_[1].capacity() + depthEOM_.capacity() + depthMap_.capacity() ) *
+               sizeof( int16_t ) +
+           ( occupancy_.capacity() + 7 ) / 8 + depth0PCidx_.capacity() * sizeof( int64_t ) +
+           pointLocalReconstructionModeByBlock_.capacity() + occupancyMap_.capacity() +
+           neighboringPatches_.capacity() * sizeof( size_t ) + borderPoints_.capacity() * sizeof( PCCPoint3D );
+  }
 
   void filtering( const int8_t           passesCount,
                   const int8_t           filterSize,
@@ -350,6 +414,9 @@ class PCCPatch {
                   std::vector<PCCPatch>& patches );
 
  private:
+  // Position of a patch block in the canvas relative to (u0_, v0_); false for an unknown orientation.
+  bool orientPatchBlock( const size_t uBlk, const size_t vBlk, size_t& x, size_t& y ) const;
+
   size_t                  index_;          // patch index
   size_t                  originalIndex_;  // patch original index
   size_t                  frameIndex_;     // Frame index
@@ -408,16 +475,58 @@ class PCCPatch {
   std::vector<PCCPoint3D> borderPoints_;        // 3D points created from borders of the patch
 };
 
+// Patches kept with their buffers from one GOF to the next. The decoder takes the patches of its tiles from the pool
+// and PCCAtlasContext::reset() gives them back, so after the first GOF allocOneLayerData() and the reconstruction
+// reuse the depth, occupancy and block buffers instead of allocating them patch by patch. The tiles of a frame are
+// built in parallel, hence the lock; a copy of the pool is empty.
+class PCCPatchPool {
+ public:
+  PCCPatchPool() = default;
+  PCCPatchPool( const PCCPatchPool& ) {}
+  PCCPatchPool& operator=( const PCCPatchPool& ) { return *this; }
+  ~PCCPatchPool() = default;
+
+  // A new patch, with the buffers of a released one when there is one.
+  PCCPatch acquire() {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    if ( free_.empty() ) { return PCCPatch(); }
+    PCCPatch patch = std::move( free_.back() );
+    free_.pop_back();
+    return patch;
+  }
+  // Takes the patches, which are left empty.
+  void release( std::vector<PCCPatch>& patches ) {
+    for ( auto& patch : patches ) { patch.recycle(); }
+    std::lock_guard<std::mutex> lock( mutex_ );
+    for ( auto& patch : patches ) { free_.push_back( std::move( patch ) ); }
+    patches.clear();
+  }
+  void clear() {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    free_.clear();
+  }
+  size_t getMemorySize() const {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    size_t                      size = free_.capacity() * sizeof( PCCPatch );
+    for ( const auto& patch : free_ ) { size += patch.getMemorySize(); }
+    return size;
+  }
+
+ private:
+  mutable std::mutex    mutex_;
+  std::vector<PCCPatch> free_;
+};
+
 class PatchBlockFiltering {
  public:
   PatchBlockFiltering() {}
   ~PatchBlockFiltering() {}
 
   inline void setPatches( std::vector<PCCPatch>* patches ) { patches_ = patches; }
-  inline void setBlockToPatch( std::vector<size_t>* value ) { blockToPatch_ = value; }
+  inline void setBlockToPatch( const PCCBlockToPatchMap* value ) { blockToPatch_ = value; }
   inline void setOccupancyMapEncoder( std::vector<uint32_t>* value ) { occupancyMapEncoder_ = value; }
-  inline void setOccupancyMapVideo( const std::vector<uint8_t>* value ) { occupancyMapVideo_ = value; }
-  inline void setGeometryVideo( const std::vector<uint16_t>* value ) { geometryVideo_ = value; }
+  inline void setOccupancyMapVideo( const PCCImage<uint8_t, 3>::Channel* value ) { occupancyMapVideo_ = value; }
+  inline void setGeometryVideo( const PCCImage<uint16_t, 3>::Channel* value ) { geometryVideo_ = value; }
 
   void patchBorderFiltering( size_t imageWidth,
                              size_t imageHeight,
@@ -429,11 +538,11 @@ class PatchBlockFiltering {
                              int8_t log2Threshold );
 
  private:
-  std::vector<PCCPatch>*       patches_;
-  std::vector<size_t>*         blockToPatch_;
-  std::vector<uint32_t>*       occupancyMapEncoder_;
-  const std::vector<uint8_t>*  occupancyMapVideo_;
-  const std::vector<uint16_t>* geometryVideo_;
+  std::vector<PCCPatch>*                patches_;
+  const PCCBlockToPatchMap*             blockToPatch_;
+  std::vector<uint32_t>*                occupancyMapEncoder_;
+  const PCCImage<uint8_t, 3>::Channel*  occupancyMapVideo_;
+  const PCCImage<uint16_t, 3>::Channel* geometryVideo_;
 };
 
 struct PCCEomPatch {
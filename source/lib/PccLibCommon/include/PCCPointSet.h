@@ -38,12 +38,23 @@
 #include "PCCMath.h"
 
 namespace pcc {
+class PCCKdTree;
+
+// vertex color layouts of convertColors16bit(): 3 bytes, 4 bytes with an opaque alpha, or 3 floats in [0, 1]
+enum PCCColorBufferFormat { COLOR_BUFFER_RGB8 = 0, COLOR_BUFFER_RGBA8, COLOR_BUFFER_FLOAT3 };
 
 class PCCPointSet3 {
  public:
-  PCCPointSet3() : withNormals_( false ), withColors_( false ), withReflectances_( false ) {}
+  PCCPointSet3() :
+      withNormals_( false ),
+      withColors_( false ),
+      withColors16bit_( false ),
+      withReflectances_( false ),
+      withParentPointIndexes_( false ) {}
   PCCPointSet3( const PCCPointSet3& ) = default;
+  PCCPointSet3( PCCPointSet3&& )      = default;
   PCCPointSet3& operator=( const PCCPointSet3& rhs ) = default;
+  PCCPointSet3& operator=( PCCPointSet3&& rhs )      = default;
   ~PCCPointSet3()                                    = default;
 
   PCCPoint3D operator[]( const size_t index ) const {
@@ -55,14 +66,14 @@ class PCCPointSet3 {
     return positions_[index];
   }
   size_t appendPointSet( PCCPointSet3& pointSet ) {
-    std::vector<PCCPoint3D>::iterator                itPositions;
-    std::vector<PCCColor3B>::iterator                itColors;
-    std::vector<PCCColor16bit>::iterator             itColors16bit;
-    std::vector<uint16_t>::iterator                  itReflectances;
-    std::vector<uint16_t>::iterator                  itBoundaryPointTypes;
-    std::vector<std::pair<size_t, size_t>>::iterator itPointPatchIndexes;
-    std::vector<uint8_t>::iterator                   itTypes;
-    std::vector<PCCNormal3D>::iterator               itNormals;
+    std::vector<PCCPoint3D>::iterator                    itPositions;
+    std::vector<PCCColor3B>::iterator                    itColors;
+    std::vector<PCCColor16bit>::iterator                 itColors16bit;
+    std::vector<uint16_t>::iterator                      itReflectances;
+    std::vector<uint16_t>::iterator                      itBoundaryPointTypes;
+    std::vector<std::pair<uint32_t, uint32_t>>::iterator itPointPatchIndexes;
+    std::vector<uint8_t>::iterator                       itTypes;
+    std::vector<PCCNormal3D>::iterator                   itNormals;
 
     itPositions          = positions_.end();
     itColors             = colors_.end();
@@ -107,63 +118,27 @@ class PCCPointSet3 {
   }
   std::vector<PCCColor16bit>& getColor16bit() { return colors16bit_; }
   PCCColor16bit               getColor16bit( const size_t index ) const {
-    assert( index < colors16bit_.size() && withColors_ );
+    assert( index < colors16bit_.size() && withColors16bit_ );
     return colors16bit_[index];
   }
   PCCColor16bit& getColor16bit( const size_t index ) {
-    assert( index < colors16bit_.size() && withColors_ );
+    assert( index < colors16bit_.size() && withColors16bit_ );
     return colors16bit_[index];
   }
   void setColor16bit( const size_t index, const PCCColor16bit color16bit ) {
-    assert( index < colors16bit_.size() && withColors_ );
+    assert( index < colors16bit_.size() && withColors16bit_ );
     colors16bit_[index] = color16bit;
   }
-  void copyRGB16ToRGB8() {
-    for ( size_t k = 0; k < getPointCount(); k++ ) {
-      colors_[k][0] = uint8_t( colors16bit_[k][0] );
-      colors_[k][1] = uint8_t( colors16bit_[k][1] );
-      colors_[k][2] = uint8_t( colors16bit_[k][2] );
-    }
-  }
+  void copyRGB16ToRGB8();
   void fillColor( PCCColor3B color = {0, 0, 0} ) {
     for ( size_t k = 0; k < getPointCount(); k++ ) { colors_[k] = color; }
   }
 
-  /// convert yuv444 (16bit) to normalized yuv444 (format double)
-  void convertYUV16ToRGB8() {
-    for ( size_t k = 0; k < getPointCount(); k++ ) {
-      double y1     = colors16bit_[k][0];
-      double u1     = colors16bit_[k][1];
-      double v1     = colors16bit_[k][2];
-      double offset = 32768.0;
-      double scale  = 65535.0;
-      double weight = 1.0 / scale;
-
-      y1 = weight * y1;
-      u1 = weight * ( u1 - offset );
-      v1 = weight * ( v1 - offset );
-      y1 = ( std::max )( y1, 0.0 );
-      y1 = ( std::min )( y1, 1.0 );
-      u1 = ( std::max )( u1, -0.5 );
-      u1 = ( std::min )( u1, 0.5 );
-      v1 = ( std::max )( v1, -0.5 );
-      v1 = ( std::min )( v1, 0.5 );
-
-      //// convert normalized yuv444 to normalized rgb (fromat double)
-      double r = y1 /*- 0.00000 * u1*/ + 1.57480 * v1;
-      double g = y1 - 0.18733 * u1 - 0.46813 * v1;
-      double b = y1 + 1.85563 * u1 /*+ 0.00000 * v1*/;
-
-      //// convert normalized rgb to 8-bit rgb
-      r = PCCClip( round( r * 255 ), 0.0, 255.0 );
-      g = PCCClip( round( g * 255 ), 0.0, 255.0 );
-      b = PCCClip( round( b * 255 ), 0.0, 255.0 );
-
-      colors_[k][0] = static_cast<uint8_t>( r );
-      colors_[k][1] = static_cast<uint8_t>( g );
-      colors_[k][2] = static_cast<uint8_t>( b );
-    }
-  }
+  /// convert yuv444 (16bit) to rgb444 (8bit), BT.709
+  void convertYUV16ToRGB8();
+  /// copyRGB16ToRGB8() or convertYUV16ToRGB8() of the 16-bit colors written straight to a renderer vertex buffer
+  /// of getPointCount() entries of the format, without going through the 8-bit colors
+  void convertColors16bit( const bool isYUV, const PCCColorBufferFormat format, void* buffer ) const;
 
   uint16_t getBoundaryPointType( const size_t index ) const {
     assert( index < boundaryPointTypes_.size() );
@@ -177,12 +152,12 @@ class PCCPointSet3 {
     assert( index < boundaryPointTypes_.size() );
     boundaryPointTypes_[index] = BoundaryPointType;
   }
-  std::vector<std::pair<size_t, size_t>>& getPointPatchIndexes() { return pointPatchIndexes_; }
-  std::pair<size_t, size_t>               getPointPatchIndex( const size_t index ) const {
+  std::vector<std::pair<uint32_t, uint32_t>>& getPointPatchIndexes() { return pointPatchIndexes_; }
+  std::pair<uint32_t, uint32_t>               getPointPatchIndex( const size_t index ) const {
     assert( index < pointPatchIndexes_.size() );
     return pointPatchIndexes_[index];
   }
-  std::pair<size_t, size_t>& getPointPatchIndex( const size_t index ) {
+  std::pair<uint32_t, uint32_t>& getPointPatchIndex( const size_t index ) {
     assert( index < pointPatchIndexes_.size() );
     return pointPatchIndexes_[index];
   }
@@ -192,11 +167,20 @@ class PCCPointSet3 {
     pointPatchIndexes_[index].second = patchIndex;
   }
   std::vector<uint64_t>& getParentPointIndex() { return parentPointIndex_; }
-  uint64_t&              getParentPointIndex( const size_t index ) { return parentPointIndex_[index]; }
-  void                   setParentPointIndex( const size_t index, const uint64_t parentIndex ) {
-    assert( index < parentPointIndex_.size() );
+  uint64_t&              getParentPointIndex( const size_t index ) {
+    assert( index < parentPointIndex_.size() && withParentPointIndexes_ );
+    return parentPointIndex_[index];
+  }
+  void setParentPointIndex( const size_t index, const uint64_t parentIndex ) {
+    assert( index < parentPointIndex_.size() && withParentPointIndexes_ );
     parentPointIndex_[index] = parentIndex;
   }
+  // Only the colour transfers map the points of a sub-cloud back to the cloud they were taken from.
+  bool hasParentPointIndexes() const { return withParentPointIndexes_; }
+  void addParentPointIndexes() {
+    withParentPointIndexes_ = true;
+    resize( getPointCount() );
+  }
   uint16_t getReflectance( const size_t index ) const {
     assert( index < reflectances_.size() && withReflectances_ );
     return reflectances_[index];
@@ -211,6 +195,8 @@ class PCCPointSet3 {
   }
   std::vector<PCCPoint3D>&    getPositions() { return positions_; }
   std::vector<PCCColor3B>&    getColors() { return colors_; }
+  const std::vector<PCCPoint3D>& getPositions() const { return positions_; }
+  const std::vector<PCCColor3B>& getColors() const { return colors_; }
   std::vector<PCCColor16bit>& getColors16bit() { return colors16bit_; }
   std::vector<uint16_t>&      getReflectances() { return reflectances_; }
   std::vector<uint8_t>&       getTypes() { return types_; }
@@ -246,13 +232,26 @@ class PCCPointSet3 {
     withColors_ = false;
     colors_.resize( 0 );
   }
+  // The 16-bit colours are the working copy of the attribute reconstruction: they come with the 8-bit ones but are
+  // only allocated on request, and removing them frees their storage once they are converted to 8-bit.
+  bool hasColors16bit() const { return withColors16bit_; }
   void addColors16bit() {
-    withColors_ = true;
+    withColors_      = true;
+    withColors16bit_ = true;
     resize( getPointCount() );
   }
   void removeColors16bit() {
-    withColors_ = false;
-    colors16bit_.resize( 0 );
+    withColors16bit_ = false;
+    std::vector<PCCColor16bit>().swap( colors16bit_ );
+  }
+  // Frees what only the reconstruction and its post-processing use, keeping the positions and the output attributes,
+  // e.g. before a decoded frame is queued for rendering.
+  void removeReconstructionData() {
+    removeColors16bit();
+    withParentPointIndexes_ = false;
+    std::vector<uint16_t>().swap( boundaryPointTypes_ );
+    std::vector<std::pair<uint32_t, uint32_t>>().swap( pointPatchIndexes_ );
+    std::vector<uint64_t>().swap( parentPointIndex_ );
   }
   const std::vector<PCCNormal3D>& getNormals() const { return normals_; }
   bool                            hasNormals() const { return withNormals_; }
@@ -301,7 +300,8 @@ class PCCPointSet3 {
                        double        maxColorDist2Fwd                        = 10000.0,
                        double        maxColorDist2Bwd                        = 10000.0,
                        const bool    excludeColorOutlier                     = false,
-                       const double  thresholdColorOutlierDist               = 10.0 ) const;
+                       const double  thresholdColorOutlierDist               = 10.0,
+                       const PCCKdTree* kdtreeSource                         = nullptr ) const;
 
   bool transferColors16bitBP( PCCPointSet3& target,
                               const int     filterType,
@@ -365,30 +365,56 @@ class PCCPointSet3 {
   bool transferColorWeight( PCCPointSet3& target, const double bestColorSearchStep = 0.1 );
 
   size_t getPointCount() const { return positions_.size(); }
+  size_t getMemorySize() const;
   void   resize( const size_t size ) {
     positions_.resize( size );
-    if ( hasColors() ) {
-      colors_.resize( size );
-      colors16bit_.resize( size );
-    }
+    if ( hasColors() ) { colors_.resize( size ); }
+    if ( hasColors16bit() ) { colors16bit_.resize( size ); }
     if ( hasReflectances() ) { reflectances_.resize( size ); }
     if ( PCC_SAVE_POINT_TYPE ) { types_.resize( size ); }
     if ( hasNormals() ) { normals_.resize( size ); }
+    if ( hasParentPointIndexes() ) { parentPointIndex_.resize( size ); }
     boundaryPointTypes_.resize( size );
     pointPatchIndexes_.resize( size );
-    parentPointIndex_.resize( size );
   }
+  // Reserves the attributes the point set has, so that a cloud filled point by point is allocated once.
   void reserve( const size_t size ) {
     positions_.reserve( size );
-    if ( hasColors() ) {
-      colors_.reserve( size );
-      colors16bit_.reserve( size );
-    }
+    if ( hasColors() ) { colors_.reserve( size ); }
+    if ( hasColors16bit() ) { colors16bit_.reserve( size ); }
     if ( hasReflectances() ) { reflectances_.reserve( size ); }
     if ( PCC_SAVE_POINT_TYPE ) { types_.reserve( size ); }
+    if ( hasNormals() ) { normals_.reserve( size ); }
+    if ( hasParentPointIndexes() ) { parentPointIndex_.reserve( size ); }
     boundaryPointTypes_.reserve( size );
     pointPatchIndexes_.reserve( size );
-    parentPointIndex_.reserve( size );
+  }
+  // Copies the positions into one array per axis, e.g. float arrays for a renderer or int arrays for SIMD code.
+  template <typename T>
+  void exportPositions( std::vector<T>& x, std::vector<T>& y, std::vector<T>& z ) const {
+    const size_t pointCount = getPointCount();
+    x.resize( pointCount );
+    y.resize( pointCount );
+    z.resize( pointCount );
+    for ( size_t i = 0; i < pointCount; i++ ) {
+      x[i] = static_cast<T>( positions_[i][0] );
+      y[i] = static_cast<T>( positions_[i][1] );
+      z[i] = static_cast<T>( positions_[i][2] );
+    }
+  }
+  // Copies the positions and, with colors, the 8-bit and 16-bit colours into snapshot, and nothing else: a compact
+  // read-only copy of the frame (the source of a kd-tree or of a colour transfer) while the frame is modified in
+  // place. The buffers of snapshot are reused.
+  void copyPositionsAndColors( PCCPointSet3& snapshot, const bool colors = true ) const {
+    snapshot.withNormals_            = false;
+    snapshot.withReflectances_       = false;
+    snapshot.withParentPointIndexes_ = false;
+    snapshot.withColors_             = colors && withColors_;
+    snapshot.withColors16bit_        = colors && withColors16bit_;
+    snapshot.clear();
+    snapshot.positions_ = positions_;
+    if ( snapshot.withColors_ ) { snapshot.colors_ = colors_; }
+    if ( snapshot.withColors16bit_ ) { snapshot.colors16bit_ = colors16bit_; }
   }
   void clear() {
     positions_.clear();
@@ -475,7 +501,8 @@ class PCCPointSet3 {
     if ( !buf.empty() ) tokens.push_back( buf );
     return !tokens.empty();
   }
-  bool write( const std::string& fileName, const bool asAscii = false );
+  // directIO writes binary files around the page cache, see writeFile().
+  bool write( const std::string& fileName, const bool asAscii = false, const bool directIO = false );
   bool read( const std::string& fileName, const bool readNormals = false );
   void convertRGBToYUV();
   void convertRGBToYUVClosedLoop();
@@ -496,7 +523,8 @@ class PCCPointSet3 {
   void                 removeDuplicate( PCCPointSet3& newPointcloud, size_t dropDuplicates ) const;
   void                 copyNormals( const PCCPointSet3& sourceWithNormal );
   void                 scaleNormals( const PCCPointSet3& sourceWithNormal );
-  std::vector<uint8_t> computeChecksum( bool reorderPoints = false );
+  // MD5 of the points, or with fastDigest their 64-bit PCCDigest64 (regression comparisons only).
+  std::vector<uint8_t> computeChecksum( bool reorderPoints = false, bool fastDigest = false );
   void                 sortColor( std::vector<size_t>& list );
   void                 reorder();
   void                 reorder( PCCPointSet3& newPointcloud, bool dropDuplicates );
@@ -515,20 +543,23 @@ class PCCPointSet3 {
   void distance( const PCCPointSet3& pointcloud, float& distPAB, float& distPBA ) const;
   void distance( const PCCPointSet3& pointcloud, float& distP, float& distY, float& distU, float& distV ) const;
   void distance( const PCCPointSet3& pointcloud, float& distP ) const;
-  std::vector<uint8_t> computeMd5();
+  template <typename Digest>
+  std::vector<uint8_t> computeDigest( const size_t length );
 
-  std::vector<PCCPoint3D>                positions_;
-  std::vector<PCCColor3B>                colors_;
-  std::vector<PCCColor16bit>             colors16bit_;
-  std::vector<uint16_t>                  reflectances_;
-  std::vector<uint16_t>                  boundaryPointTypes_;
-  std::vector<std::pair<size_t, size_t>> pointPatchIndexes_;
-  std::vector<uint64_t>                  parentPointIndex_;
-  std::vector<uint8_t>                   types_;
-  std::vector<PCCNormal3D>               normals_;
-  bool                                   withNormals_;
-  bool                                   withColors_;
-  bool                                   withReflectances_;
+  std::vector<PCCPoint3D>                    positions_;
+  std::vector<PCCColor3B>                    colors_;
+  std::vector<PCCColor16bit>                 colors16bit_;
+  std::vector<uint16_t>                      reflectances_;
+  std::vector<uint16_t>                      boundaryPointTypes_;
+  std::vector<std::pair<uint32_t, uint32_t>> pointPatchIndexes_;
+  std::vector<uint64_t>                      parentPointIndex_;
+  std::vector<uint8_t>                       types_;
+  std::vector<PCCNormal3D>                   normals_;
+  bool                                       withNormals_;
+  bool                                       withColors_;
+  bool                                       withColors16bit_;
+  bool                                       withReflectances_;
+  bool                                       withParentPointIndexes_;
 };
 }  // namespace pcc
 
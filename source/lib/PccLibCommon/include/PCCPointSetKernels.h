@@ -0,0 +1,65 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCPointSetKernels_h
+#define PCCPointSetKernels_h
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pcc {
+
+// Vectorized color loops of PCCPointSet3, on planes of the 16-bit colors. As the kernels of the color converter,
+// the AVX2 versions are picked at run time, every function returns how many leading samples it produced (0 when
+// AVX2 is not available) and leaves the rest to the scalar code, and the results are bit exact.
+
+// r, g, b = the 8-bit BT.709 RGB of the 16-bit y, u, v, computed in double as convertYUV16ToRGB8()
+size_t yuv16ToRgb8Kernel( const uint16_t* y,
+                          const uint16_t* u,
+                          const uint16_t* v,
+                          uint8_t*        r,
+                          uint8_t*        g,
+                          uint8_t*        b,
+                          size_t          count );
+
+// The occupancy map kernels of the decoder, on the same terms.
+
+// bits = one bit per pixel of src, set when the pixel is above threshold, for the leading whole words of count
+// pixels, as PCCOccupancyBitMap::threshold()
+size_t thresholdOccupancyKernel( const uint8_t* src, size_t count, size_t threshold, uint64_t* bits );
+
+// dst[u] = bit u / precision of bits, 0 or 1: a row of bits upsampled by precision, which must be 1, 2, 4 or 8
+size_t expandOccupancyKernel( const uint64_t* bits, size_t precision, uint32_t* dst, size_t count );
+
+};  // namespace pcc
+
+#endif /* PCCPointSetKernels_h */
@@ -0,0 +1,116 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include "PCCConfig.h"
+#include "PCCChrono.h"
+#include <cstdio>
+#include <map>
+#include <string>
+
+//===========================================================================
+
+namespace pcc {
+namespace profiler {
+/**
+ * Hierarchical scoped-zone profiler.
+ *
+ * Zones are timed with the steady clock and nest per thread: a zone opened
+ * while another one is open on the same thread is reported as its child.
+ * Each thread records closed zones into its own ring buffer, which is only
+ * merged into the global per-zone aggregates (count, total, min, max and a
+ * log2 histogram of the durations) when it fills up or when a report is
+ * requested, so timing a zone costs two clock reads and no shared state.
+ *
+ * The profiler is compiled out unless ENABLE_PROFILER is defined: the
+ * PCC_PROFILE_* macros then expand to nothing.
+ */
+typedef std::chrono::steady_clock clock;
+
+/// Open a zone on the calling thread. name must outlive the profiler.
+void begin( const char* name );
+
+/// Close the innermost zone opened on the calling thread.
+void end( const char* name );
+
+/// Merge every thread buffer and print the zone tree with its histograms.
+void report( FILE* out );
+
+/// Drop every recorded zone.
+void reset();
+
+/**
+ * Time spent in a zone, summed over all the parents it was opened in.
+ */
+struct ZoneTotal {
+  size_t  count = 0;
+  int64_t total = 0;  // ns
+  int64_t max   = 0;  // ns
+};
+
+/// Merge every thread buffer and return the totals of each zone by name.
+void totals( std::map<std::string, ZoneTotal>& zones );
+
+/**
+ * Zone covering the lifetime of the object.
+ */
+class Zone {
+ public:
+  explicit Zone( const char* name ) : name_( name ) { begin( name_ ); }
+  ~Zone() { end( name_ ); }
+  Zone( const Zone& ) = delete;
+  Zone& operator=( const Zone& ) = delete;
+
+ private:
+  const char* name_;
+};
+}  // namespace profiler
+}  // namespace pcc
+
+//===========================================================================
+
+#ifdef ENABLE_PROFILER
+#define PCC_PROFILE_CONCAT_( a, b ) a##b
+#define PCC_PROFILE_CONCAT( a, b ) PCC_PROFILE_CONCAT_( a, b )
+#define PCC_PROFILE_ZONE( name ) pcc::profiler::Zone PCC_PROFILE_CONCAT( profileZone, __LINE__ )( name )
+#define PCC_PROFILE_BEGIN( name ) pcc::profiler::begin( name )
+#define PCC_PROFILE_END( name ) pcc::profiler::end( name )
+#define PCC_PROFILE_REPORT( out ) pcc::profiler::report( out )
+#else
+#define PCC_PROFILE_ZONE( name )
+#define PCC_PROFILE_BEGIN( name )
+#define PCC_PROFILE_END( name )
+#define PCC_PROFILE_REPORT( out )
+#endif
+
+//===========================================================================
@@ -0,0 +1,79 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCSpatialIndexCache_h
+#define PCCSpatialIndexCache_h
+
+#include "PCCCommon.h"
+#include "PCCKdTree.h"
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace pcc {
+
+// KD-trees of the point sets of a frame, built once and shared by the stages that search the same points: the
+// source frame is searched by the normal estimation and segmentation, the 3D padding of each geometry map and the
+// color transfer. An entry is keyed by the address of its point set and checked against a fingerprint of its
+// positions at each lookup, so that a set resized, edited in place or freed and replaced at the same address gets a
+// new tree rather than a stale one. A tree refers to the points of its set: it is only valid while the set lives.
+// Copying the cache, e.g. with its frame context, gives an empty one.
+class PCCSpatialIndexCache {
+ public:
+  PCCSpatialIndexCache() = default;
+  PCCSpatialIndexCache( const PCCSpatialIndexCache& ) {}
+  PCCSpatialIndexCache& operator=( const PCCSpatialIndexCache& ) {
+    clear();
+    return *this;
+  }
+  ~PCCSpatialIndexCache() = default;
+
+  // the tree of pointCloud, built on first use
+  std::shared_ptr<const PCCKdTree> getKdTree( const PCCPointSet3& pointCloud );
+  // drops the trees, e.g. once the last stage searching the frame is done
+  void clear();
+
+ private:
+  struct Entry {
+    size_t                           pointCount;
+    uint64_t                         fingerprint;
+    std::shared_ptr<const PCCKdTree> kdtree;
+  };
+  static uint64_t fingerprint( const PCCPointSet3& pointCloud );
+
+  std::mutex                              mutex_;
+  std::map<const PCCPointSet3*, Entry>    entries_;
+};
+
+}  // namespace pcc
+
+#endif /* PCCSpatialIndexCache_h */
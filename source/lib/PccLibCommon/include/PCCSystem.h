@@ -48,6 +48,66 @@ int system( const char* command ) noexcept;
 #else
 static inline int system( const char* command ) { return ::system( command ); }
 #endif
+
+/**
+ * read-only view of a whole file, memory-mapped so that it is parsed in place.
+ */
+class PCCMappedFile {
+ public:
+  PCCMappedFile() = default;
+  ~PCCMappedFile() { close(); }
+  PCCMappedFile( const PCCMappedFile& ) = delete;
+  PCCMappedFile& operator=( const PCCMappedFile& ) = delete;
+
+  bool           open( const std::string& fileName );
+  void           close();
+  const uint8_t* data() const { return data_; }
+  size_t         size() const { return size_; }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t         size_ = 0;
+#ifdef _WIN32
+  void* file_    = nullptr;
+  void* mapping_ = nullptr;
+#endif
+};
+
+/**
+ * file of a size known up front, written through a writable memory mapping: e.g. raw YUV frames are copied
+ * straight from the image channels into the page cache. The space is reserved by open() where the system
+ * can, so that a full disk fails there instead of while the mapping is written.
+ */
+class PCCMappedOutputFile {
+ public:
+  PCCMappedOutputFile() = default;
+  ~PCCMappedOutputFile() { close(); }
+  PCCMappedOutputFile( const PCCMappedOutputFile& ) = delete;
+  PCCMappedOutputFile& operator=( const PCCMappedOutputFile& ) = delete;
+
+  // creates or truncates fileName to size bytes
+  bool     open( const std::string& fileName, size_t size );
+  // false if the file could not be completed
+  bool     close();
+  uint8_t* data() const { return data_; }
+  size_t   size() const { return size_; }
+
+ private:
+  uint8_t* data_ = nullptr;
+  size_t   size_ = 0;
+#ifdef _WIN32
+  void* file_    = nullptr;
+  void* mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+};
+
+/**
+ * writes a whole file from memory. directIO bypasses the page cache (O_DIRECT) where the system and
+ * the file system support it, for large outputs that are not read back soon; otherwise it is ignored.
+ */
+bool writeFile( const std::string& fileName, const void* data, size_t size, bool directIO = false );
 }  // namespace pcc
 
 //===========================================================================
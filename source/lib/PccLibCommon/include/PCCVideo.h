@@ -43,12 +43,31 @@ class PCCVideo {
  public:
   PCCVideo()                  = default;
   PCCVideo( const PCCVideo& ) = default;
+  PCCVideo( PCCVideo&& )      = default;
   PCCVideo& operator=( const PCCVideo& rhs ) = default;
-  ~PCCVideo()                                = default;
-  void resize( const size_t frameCount ) { frames_.resize( frameCount ); }
+  PCCVideo& operator=( PCCVideo&& rhs ) = default;
+  ~PCCVideo()                           = default;
+
+  // The frames removed by resize() or reset() keep their buffers in a pool, and the frames added later take them
+  // back: a video decoded GOF after GOF at the same resolution allocates its frames once. clear() frees everything.
+  void resize( const size_t frameCount ) {
+    while ( frames_.size() > frameCount ) {
+      frames_.back().clear();
+      pool_.push_back( std::move( frames_.back() ) );
+      frames_.pop_back();
+    }
+    frames_.reserve( frameCount );
+    while ( frames_.size() < frameCount && !pool_.empty() ) {
+      frames_.push_back( std::move( pool_.back() ) );
+      pool_.pop_back();
+    }
+    frames_.resize( frameCount );
+  }
+  void reset() { resize( 0 ); }
   void clear() {
     for ( auto& frame : frames_ ) { frame.clear(); }
     frames_.clear();
+    pool_.clear();
   }
 
   typename std::vector<PCCImage<T, N> >::iterator begin() { return frames_.begin(); }
@@ -81,6 +100,13 @@ class PCCVideo {
     return frames_.empty() ? PCCCOLORFORMAT::UNKNOWN : frames_[0].getColorFormat();
   }
   size_t getFrameCount() const { return frames_.size(); }
+  // bytes held by the frames, including the pooled ones kept for the next GOF
+  size_t getMemorySize() const {
+    size_t size = 0;
+    for ( const auto& frame : frames_ ) { size += frame.getMemorySize(); }
+    for ( const auto& frame : pool_ ) { size += frame.getMemorySize(); }
+    return size;
+  }
 
   bool write( const std::string fileName, const size_t nbyte );
   bool read( const std::string    fileName,
@@ -117,6 +143,7 @@ class PCCVideo {
              const size_t         nbyte );
 
   std::vector<PCCImage<T, N> > frames_;
+  std::vector<PCCImage<T, N> > pool_;
 };
 
 }  // namespace pcc
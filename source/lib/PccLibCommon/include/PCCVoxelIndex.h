@@ -0,0 +1,98 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCCVoxelIndex_h
+#define PCCVoxelIndex_h
+
+#include "PCCCommon.h"
+#include "PCCPointSet.h"
+#include "PCCKdTree.h"
+#include "PCCArena.h"
+
+namespace pcc {
+
+// Neighbor search for integer point clouds: the points are bucketed in cubic cells of 2^cellShift voxels and stored
+// cell by cell in Morton order, under an octree whose nodes list their children in the same order. A query descends
+// the octree, nearest children first, and skips the nodes farther than its current candidates. It answers the same
+// queries as PCCKdTree with the same neighbors and distances; points at equal distances are returned by increasing
+// index, where PCCKdTree returns them in its traversal order.
+class PCCVoxelIndex {
+ public:
+  PCCVoxelIndex();
+  PCCVoxelIndex( const PCCPointSet3& pointCloud, const uint32_t cellShift = 2 );
+  ~PCCVoxelIndex() = default;
+  void init( const PCCPointSet3& pointCloud, const uint32_t cellShift = 2 );
+  void search( const PCCPoint3D& point, const size_t num_results, PCCNNResult& results ) const;
+  void searchRadius( const PCCPoint3D& point,
+                     const size_t      num_results,
+                     const double      radius,
+                     PCCNNResult&      results ) const;
+  void searchRadius( const PCCPoint3D&                          point,
+                     const size_t                               num_results,
+                     const double                               radius,
+                     PCCArenaVector<std::pair<size_t, double>>& results ) const;
+  template <typename T>
+  void searchBatch( const std::vector<PCCPoint3D>& points,
+                    const size_t                   num_results,
+                    PCCNNBatchResult<T>&           results ) const;
+
+ private:
+  typedef std::pair<double, size_t> DistIndex;
+  template <typename Pruned, typename Visit>
+  void traverse( const int32_t position[3],
+                 const size_t  level,
+                 const size_t  node,
+                 const int32_t x,
+                 const int32_t y,
+                 const int32_t z,
+                 Pruned&       pruned,
+                 Visit&        visit ) const;
+  void searchNearest( const PCCPoint3D&       point,
+                      const size_t            num_results,
+                      const double            radius,
+                      std::vector<DistIndex>& nearest ) const;
+
+  uint32_t                           cellShift_;
+  PCCPoint3D                         origin_;
+  // The nodes of level l are cubes of 2^l x 2^l x 2^l cells in Morton order. The children of the node n of level l are
+  // the nodes nodeStarts_[l][n] to nodeStarts_[l][n + 1] - 1 of level l - 1, and nodeOctants_[l - 1] tells which
+  // octant of n each of them is. The nodes of level 0 are the cells: their points are positions_[nodeStarts_[0][n]]
+  // to positions_[nodeStarts_[0][n + 1] - 1].
+  std::vector<std::vector<uint32_t>> nodeStarts_;
+  std::vector<std::vector<uint8_t>>  nodeOctants_;
+  std::vector<PCCPoint3D>            positions_;
+  std::vector<uint32_t>              indices_;
+};
+
+}  // namespace pcc
+#endif /* PCCVoxelIndex_h */
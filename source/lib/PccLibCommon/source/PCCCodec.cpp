@@ -41,14 +41,32 @@
 #include "PCCFrameContext.h"
 #include "PCCGroupOfFrames.h"
 #include "PCCPatch.h"
+#include "PCCMorton.h"
 
 #include "PCCCodec.h"
 
 using namespace pcc;
 
-PCCCodec::PCCCodec() {}
+// The Morton code of a cell, so that the 2x2x2 cells around a point are close in memory.
+static inline uint64_t gridCellCode( const uint64_t x, const uint64_t y, const uint64_t z ) {
+  return mortonEncode( uint32_t( x ), uint32_t( y ), uint32_t( z ) );
+}
+
+PCCCodec::PCCCodec() : executionContext_( std::make_shared<PCCExecutionContext>() ) {}
 PCCCodec::~PCCCodec() = default;
 
+void PCCCodec::sampleMemory( const char*             stage,
+                             const PCCContext&       context,
+                             const PCCGroupOfFrames& frames,
+                             const PCCGroupOfFrames* sources ) {
+  if ( memoryAccounting_ == nullptr ) { return; }
+  PCCMemoryUsage usage;
+  context.getMemoryUsage( usage );
+  usage.add( MEMORY_POINT_SET, frames.getMemorySize() );
+  if ( sources != nullptr ) { usage.add( MEMORY_POINT_SET, sources->getMemorySize() ); }
+  memoryAccounting_->sample( stage, usage );
+}
+
 void PCCCodec::smoothPointCloudPostprocess( PCCPointSet3&                       reconstruct,
                                             const PCCColorTransform             colorTransform,
                                             const GeneratePointCloudParameters& params,
@@ -78,10 +96,12 @@ void PCCCodec::smoothPointCloudPostprocess( PCCPointSet3&
       const size_t w =
           ( maxSize + static_cast<int>( params.gridSize_ ) - 1 ) / ( static_cast<int>( params.gridSize_ ) );
 
-      // identify boundary cells
-      size_t           pointCount = reconstruct.getPointCount();
+      // identify boundary cells; the cells are indexed by their Morton code
+      size_t pointCount = reconstruct.getPointCount();
+      size_t codeWidth  = 1;
+      while ( codeWidth < w ) { codeWidth <<= 1; }
       std::vector<int> cellIndex;
-      cellIndex.resize( w * w * w );
+      cellIndex.resize( codeWidth * codeWidth * codeWidth );
       std::fill( cellIndex.begin(), cellIndex.end(), -1 );
       size_t    numBoundaryCells = 0;
       const int disth            = ( std::max )( static_cast<int>( params.gridSize_ ) / 2, 1 );
@@ -100,7 +120,7 @@ void PCCCodec::smoothPointCloudPostprocess( PCCPointSet3&
           for ( int ix = 0; ix < 2; ix++ ) {
             for ( int iy = 0; iy < 2; iy++ ) {
               for ( int iz = 0; iz < 2; iz++ ) {
-                int cellId = ( Q[0] + ix ) + ( Q[1] + iy ) * w + ( Q[2] + iz ) * w * w;
+                auto cellId = gridCellCode( Q[0] + ix, Q[1] + iy, Q[2] + iz );
                 if ( cellIndex[cellId] == -1 ) {
                   cellIndex[cellId] = numBoundaryCells;
                   numBoundaryCells++;
@@ -110,31 +130,62 @@ void PCCCodec::smoothPointCloudPostprocess( PCCPointSet3&
           }
         }
       }
-      geoSmoothingCenter_.resize( numBoundaryCells );
-      geoSmoothingCount_.resize( numBoundaryCells );
-      geoSmoothingPartition_.resize( numBoundaryCells );
-      geoSmoothingDoSmooth_.resize( numBoundaryCells );
-      int size = static_cast<int>( geoSmoothingCount_.size() );
-      geoSmoothingCount_.resize( 0 );
-      geoSmoothingCount_.resize( size, 0 );
-      for ( int j = 0; j < reconstruct.getPointCount(); j++ ) {
-        PCCPoint3D      point = reconstruct[j];
-        PCCVector3<int> P     = point;
-        if ( P[0] < disth || P[1] < disth || P[2] < disth || th <= P[0] + disth || th <= P[1] + disth ||
-             th <= P[2] + disth ) {
-          continue;
-        }
-        PCCVector3<int> P2     = point / params.gridSize_;
-        int             cellId = P2[0] + P2[1] * w + P2[2] * w * w;
-        if ( cellIndex[cellId] != -1 ) {
-          addGridCentroid( reconstruct[j], partition[j] + 1, geoSmoothingCount_, geoSmoothingCenter_,
-                           geoSmoothingPartition_, geoSmoothingDoSmooth_, static_cast<int>( params.gridSize_ ), w,
-                           cellIndex[cellId] );
-        }
-      }
-      for ( int i = 0; i < geoSmoothingCount_.size(); i++ ) {
-        if ( geoSmoothingCount_[i] != 0U ) { geoSmoothingCenter_[i] /= geoSmoothingCount_[i]; }
-      }
+      // Each thread sums the points of its range per cell, the partial sums are then reduced. The coordinates are
+      // summed as integers, so the centroids do not depend on the order the points are added in.
+      struct CellSum {
+        uint32_t count_;
+        uint32_t minPatch_;
+        uint32_t maxPatch_;
+        uint32_t sum_[3];
+      };
+      const CellSum                                         emptyCell = {0, UINT32_MAX, 0, {0, 0, 0}};
+      tbb::enumerable_thread_specific<std::vector<CellSum>> partialSums(
+          std::vector<CellSum>( numBoundaryCells, emptyCell ) );
+      executionContext_->execute( [&] {
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0, pointCount ), [&]( const tbb::blocked_range<size_t>& range ) {
+          auto& sums = partialSums.local();
+          for ( size_t j = range.begin(); j < range.end(); j++ ) {
+            PCCVector3<int> P = reconstruct[j];
+            if ( P[0] < disth || P[1] < disth || P[2] < disth || th <= P[0] + disth || th <= P[1] + disth ||
+                 th <= P[2] + disth ) {
+              continue;
+            }
+            PCCVector3<int> P2    = P / params.gridSize_;
+            const int       index = cellIndex[gridCellCode( P2[0], P2[1], P2[2] )];
+            if ( index == -1 ) { continue; }
+            const uint32_t patchIdx = partition[j] + 1;
+            auto&          cell     = sums[index];
+            cell.minPatch_          = ( std::min )( cell.minPatch_, patchIdx );
+            cell.maxPatch_          = ( std::max )( cell.maxPatch_, patchIdx );
+            cell.count_++;
+            for ( size_t k = 0; k < 3; k++ ) { cell.sum_[k] += P[k]; }
+          }
+        } );
+        geoSmoothingCells_.resize( numBoundaryCells );
+        tbb::parallel_for( size_t( 0 ), numBoundaryCells, [&]( const size_t i ) {
+          CellSum total = emptyCell;
+          for ( const auto& sums : partialSums ) {
+            total.minPatch_ = ( std::min )( total.minPatch_, sums[i].minPatch_ );
+            total.maxPatch_ = ( std::max )( total.maxPatch_, sums[i].maxPatch_ );
+            total.count_ += sums[i].count_;
+            for ( size_t k = 0; k < 3; k++ ) { total.sum_[k] += sums[i].sum_[k]; }
+          }
+          // a cell is smoothed when its points belong to several patches
+          auto& cell     = geoSmoothingCells_[i];
+          cell.count_    = static_cast<uint16_t>( total.count_ );
+          cell.doSmooth_ = total.count_ != 0 && total.minPatch_ != total.maxPatch_;
+          cell.center_   = PCCVector3<float>( static_cast<float>( total.sum_[0] ), static_cast<float>( total.sum_[1] ),
+                                            static_cast<float>( total.sum_[2] ) );
+          if ( cell.count_ != 0U ) { cell.center_ /= cell.count_; }
+          for ( size_t k = 0; k < 3; k++ ) {
+            cell.centerFx_[k] = cell.count_ != 0U ? static_cast<int32_t>(
+                                                        ( ( int64_t( total.sum_[k] ) << kGeoSmoothingFractionBits ) +
+                                                          cell.count_ / 2 ) /
+                                                        cell.count_ )
+                                                  : 0;
+          }
+        } );
+      } );
       smoothPointCloudGrid( reconstruct, partition, params, w, cellIndex );
       cellIndex.clear();
     } else {
@@ -193,18 +244,11 @@ void PCCCodec::colorSmoothing( PCCPointSet3&                       reconstruct,
       }
     }
   }
-  colorSmoothingCenter_.resize( numBoundaryCells );
-  colorSmoothingCount_.resize( numBoundaryCells );
-  colorSmoothingPartition_.resize( numBoundaryCells );
-  colorSmoothingDoSmooth_.resize( numBoundaryCells );
-  std::fill( colorSmoothingCenter_.begin(), colorSmoothingCenter_.end(), 0 );
-  std::fill( colorSmoothingCount_.begin(), colorSmoothingCount_.end(), 0 );
-  std::pair<size_t, size_t> initPair;
-  initPair.first = initPair.second = 0;
-  std::fill( colorSmoothingPartition_.begin(), colorSmoothingPartition_.end(), initPair );
-  std::fill( colorSmoothingDoSmooth_.begin(), colorSmoothingDoSmooth_.end(), 0 );
-  colorSmoothingLum_.clear();
-  colorSmoothingLum_.resize( numBoundaryCells );
+  const ColorSmoothingCell               emptyCell = {{0., 0., 0.}, 0, false, false};
+  std::vector<std::pair<uint32_t, uint32_t>> cellPartition( numBoundaryCells );
+  std::vector<int>                       pointCell( pointCount, -1 );
+  std::vector<uint32_t>                  lumOffset( numBoundaryCells + 1, 0 );
+  colorSmoothingCells_.assign( numBoundaryCells, emptyCell );
   for ( int k = 0; k < reconstruct.getPointCount(); k++ ) {
     PCCPoint3D      point  = reconstruct[k];
     PCCVector3<int> P2     = reconstruct[k] / gridSize;
@@ -213,26 +257,48 @@ void PCCCodec::colorSmoothing( PCCPointSet3&                       reconstruct,
       TRACE_CODEC( " cellId >  cellIndex.size() <=>  %zu > %zu \n", cellId, cellIndex.size() );
     } else {
       if ( cellIndex[cellId] != -1 ) {
+        const int   index                 = cellIndex[cellId];
         PCCVector3D clr                   = reconstruct.getColor16bit( k );
         auto        tilePatchIndexPlusOne = reconstruct.getPointPatchIndex( k );
         tilePatchIndexPlusOne.second      = tilePatchIndexPlusOne.second + 1;
-        addGridColorCentroid( reconstruct[k], clr, tilePatchIndexPlusOne, colorSmoothingCount_, colorSmoothingCenter_,
-                              colorSmoothingPartition_, colorSmoothingDoSmooth_, gridSize, colorSmoothingLum_, params,
-                              cellIndex[cellId] );
+        auto& cell                        = colorSmoothingCells_[index];
+        if ( cell.count_ == 0 ) {
+          cellPartition[index] = tilePatchIndexPlusOne;
+        } else if ( !cell.doSmooth_ && cellPartition[index] != tilePatchIndexPlusOne ) {
+          cell.doSmooth_ = true;
+        }
+        cell.center_ += PCCVector3<float>( clr );
+        cell.count_++;
+        pointCell[k] = index;
+        lumOffset[index + 1]++;
       }
     }
   }
+  // The luma of the points is stored cell after cell, and the mean / median test of each cell is done once here
+  // rather than for every boundary point that reads the cell.
+  for ( size_t i = 0; i < numBoundaryCells; i++ ) { lumOffset[i + 1] += lumOffset[i]; }
+  std::vector<uint16_t> lum( lumOffset[numBoundaryCells] );
+  {
+    std::vector<uint32_t> cursor( lumOffset.begin(), lumOffset.end() - 1 );
+    for ( size_t k = 0; k < pointCount; k++ ) {
+      if ( pointCell[k] != -1 ) { lum[cursor[pointCell[k]]++] = reconstruct.getColor16bit( k )[0]; }
+    }
+  }
+  const double mmThresh = params.thresholdColorVariation_ * 256.0;
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), numBoundaryCells, [&]( const size_t i ) {
+      auto& cell = colorSmoothingCells_[i];
+      if ( cell.count_ > 1 ) {
+        uint16_t* cellLum = lum.data() + lumOffset[i];
+        double    meanY   = mean( cellLum, cell.count_ );
+        double    medianY = median( cellLum, cell.count_ );
+        cell.lumOutlier_  = abs( meanY - medianY ) > mmThresh;
+      }
+    } );
+  } );
   smoothPointCloudColorLC( reconstruct, params, cellIndex );
-  colorSmoothingCenter_.resize( 0 );
-  colorSmoothingCenter_.shrink_to_fit();
-  colorSmoothingCount_.resize( 0 );
-  colorSmoothingCount_.shrink_to_fit();
-  colorSmoothingPartition_.resize( 0 );
-  colorSmoothingPartition_.shrink_to_fit();
-  colorSmoothingDoSmooth_.resize( 0 );
-  colorSmoothingDoSmooth_.shrink_to_fit();
-  colorSmoothingLum_.resize( 0 );
-  colorSmoothingLum_.shrink_to_fit();
+  colorSmoothingCells_.resize( 0 );
+  colorSmoothingCells_.shrink_to_fit();
 }
 
 int PCCCodec::getDeltaNeighbors( const PCCImageGeometry& frame,
@@ -263,91 +329,75 @@ int PCCCodec::getDeltaNeighbors( const PCCImageGeometry& frame,
   return deltaMax;
 }
 
-void PCCCodec::identifyBoundaryPoints( const std::vector<uint32_t>& occupancyMap,
-                                       const size_t                 x,
-                                       const size_t                 y,
-                                       const size_t                 imageWidth,
-                                       const size_t                 imageHeight,
-                                       const size_t                 pointindex,
-                                       std::vector<uint32_t>&       BPflag,
-                                       PCCPointSet3&                reconstruct ) {
-  if ( occupancyMap[y * imageWidth + x] != 0 ) {
-    if ( y > 0 && y < imageHeight - 1 ) {
-      if ( occupancyMap[( y - 1 ) * imageWidth + x] == 0 || occupancyMap[( y + 1 ) * imageWidth + x] == 0 ) {
-        BPflag[y * imageWidth + x] = 1;
-        reconstruct.setBoundaryPointType( pointindex, static_cast<uint16_t>( 1 ) );
-      }
-    }
-    if ( x > 0 && x < imageWidth - 1 && reconstruct.getBoundaryPointType( pointindex ) != 1 ) {
-      if ( occupancyMap[y * imageWidth + ( x + 1 )] == 0 || occupancyMap[y * imageWidth + ( x - 1 )] == 0 ) {
-        BPflag[y * imageWidth + x] = 1;
-        reconstruct.setBoundaryPointType( pointindex, static_cast<uint16_t>( 1 ) );
-      }
-    }
-    if ( y > 0 && y < imageHeight - 1 && x > 0 && reconstruct.getBoundaryPointType( pointindex ) != 1 ) {
-      if ( occupancyMap[( y - 1 ) * imageWidth + ( x - 1 )] == 0 ||
-           occupancyMap[( y + 1 ) * imageWidth + ( x - 1 )] == 0 ) {
-        BPflag[y * imageWidth + x] = 1;
-        reconstruct.setBoundaryPointType( pointindex, static_cast<uint16_t>( 1 ) );
-      }
-    }
-    if ( y > 0 && y < imageHeight - 1 && x < imageWidth - 1 && reconstruct.getBoundaryPointType( pointindex ) != 1 ) {
-      if ( occupancyMap[( y - 1 ) * imageWidth + ( x + 1 )] == 0 ||
-           occupancyMap[( y + 1 ) * imageWidth + ( x + 1 )] == 0 ) {
-        BPflag[y * imageWidth + x] = 1;
-        reconstruct.setBoundaryPointType( pointindex, static_cast<uint16_t>( 1 ) );
-      }
-    }
-    if ( y == 0 || y == imageHeight - 1 || x == 0 || x == imageWidth - 1 ) {
-      BPflag[y * imageWidth + x] = 1;
-      reconstruct.setBoundaryPointType( pointindex, static_cast<uint16_t>( 1 ) );
-    }
-  }
-  ////////////// second layer
-  if ( ( occupancyMap[y * imageWidth + x] != 0U ) && reconstruct.getBoundaryPointType( pointindex ) != 1 ) {
-    for ( int ix = -2; ix <= 2; ++ix ) {
-      for ( int iy = -2; iy <= 2; ++iy ) {
-        if ( abs( int( ix ) ) > 1 || abs( int( iy ) ) > 1 ) {
-          if ( ( y + iy ) >= 0 && ( y + iy ) < imageHeight && ( x + ix ) >= 0 && ( x + ix ) < imageWidth ) {
-            if ( occupancyMap[( y + iy ) * imageWidth + ( x + ix )] == 0 ) {
-              reconstruct.setBoundaryPointType( pointindex, static_cast<uint16_t>( 1 ) );
-              ix = 4;
-              iy = 4;
-            }
-          }
+void PCCCodec::identifyBoundaryPoints( const std::vector<uint32_t>&           occupancyMap,
+                                       const size_t                           imageWidth,
+                                       const size_t                           imageHeight,
+                                       const std::vector<PCCVector3<size_t>>& pointToPixel,
+                                       const size_t                           pointCount,
+                                       PCCPointSet3&                          reconstruct ) {
+  // The empty pixels, dilated by two: a set bit has an empty pixel in the 5 x 5 square around it.
+  PCCOccupancyBitMap nearEmpty;
+  nearEmpty.threshold( occupancyMap.data(), imageWidth, imageHeight, 0 );
+  nearEmpty.invert();
+  nearEmpty.dilate( 2 );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, pointCount ), [&]( const tbb::blocked_range<size_t>& range ) {
+      for ( size_t i = range.begin(); i < range.end(); ++i ) {
+        const size_t x = pointToPixel[i][0];
+        const size_t y = pointToPixel[i][1];
+        if ( occupancyMap[y * imageWidth + x] == 0 ) { continue; }
+        if ( x <= 1 || y <= 1 || x + 2 >= imageWidth || y + 2 >= imageHeight || nearEmpty.get( x, y ) ) {
+          reconstruct.setBoundaryPointType( i, static_cast<uint16_t>( 1 ) );
         }
       }
-    }
-    if ( y == 1 || y == imageHeight - 2 || x == 1 || x == imageWidth - 2 ) {
-      reconstruct.setBoundaryPointType( pointindex, static_cast<uint16_t>( 1 ) );
-    }
-  }
+    } );
+  } );
 }
 
-std::vector<PCCPoint3D> PCCCodec::generatePoints( const GeneratePointCloudParameters&  params,
-                                                  PCCFrameContext&                     tile,
-                                                  const std::vector<PCCVideoGeometry>& videoGeometryMultiple,
-                                                  const size_t                         videoFrameIndex,
-                                                  const size_t                         patchIndex,
-                                                  const size_t                         u,
-                                                  const size_t                         v,
-                                                  const size_t                         x,
-                                                  const size_t                         y,
-                                                  const bool                           interpolate,
-                                                  const bool                           filling,
-                                                  const size_t                         minD1,
-                                                  const size_t                         neighbor ) {
-  const auto&             patch  = tile.getPatch( patchIndex );
-  auto&                   frame0 = videoGeometryMultiple[0].getFrame( videoFrameIndex );
-  std::vector<PCCPoint3D> createdPoints;
-  PCCPoint3D              point0;
-  if ( params.pbfEnableFlag_ ) {
+void PCCCodec::generatePoints( PCCArenaVector<PCCPoint3D>&          createdPoints,
+                               const GeneratePointCloudParameters&  params,
+                               PCCFrameContext&                     tile,
+                               const std::vector<PCCVideoGeometry>& videoGeometryMultiple,
+                               const size_t                         videoFrameIndex,
+                               const size_t                         patchIndex,
+                               const size_t                         u,
+                               const size_t                         v,
+                               const size_t                         x,
+                               const size_t                         y,
+                               const bool                           interpolate,
+                               const bool                           filling,
+                               const size_t                         minD1,
+                               const size_t                         neighbor ) {
+  generatePoints<PCCGenericReconstruction>( createdPoints, params, tile, videoGeometryMultiple, videoFrameIndex,
+                                            patchIndex, u, v, x, y, interpolate, filling, minD1, neighbor );
+}
+
+template <typename Kernel>
+void PCCCodec::generatePoints( PCCArenaVector<PCCPoint3D>&          createdPoints,
+                               const GeneratePointCloudParameters&  params,
+                               PCCFrameContext&                     tile,
+                               const std::vector<PCCVideoGeometry>& videoGeometryMultiple,
+                               const size_t                         videoFrameIndex,
+                               const size_t                         patchIndex,
+                               const size_t                         u,
+                               const size_t                         v,
+                               const size_t                         x,
+                               const size_t                         y,
+                               const bool                           interpolate,
+                               const bool                           filling,
+                               const size_t                         minD1,
+                               const size_t                         neighbor ) {
+  const auto& patch  = tile.getPatch( patchIndex );
+  auto&       frame0 = videoGeometryMultiple[0].getFrame( videoFrameIndex );
+  PCCPoint3D  point0;
+  createdPoints.clear();
+  if ( Kernel::pbfEnableFlag( params ) ) {
     point0 = patch.generatePoint( u, v, patch.getDepthMap( u, v ) );
   } else {
     point0 = patch.generatePoint( u, v, frame0.getValue( 0, x, y ) );
   }
   createdPoints.push_back( point0 );
-  if ( params.singleMapPixelInterleaving_ ) {
+  if ( Kernel::singleMapPixelInterleaving( params ) ) {
     size_t     patchIndexPlusOne = patchIndex + 1;
     double     depth0;
     double     depth1;
@@ -357,7 +407,7 @@ std::vector<PCCPoint3D> PCCCodec::generatePoints( const GeneratePointCloudParame
     bool       occupancyBotton;
     bool       occupancyLeft;
     bool       occupancyRight;
-    if ( !params.pbfEnableFlag_ ) {
+    if ( !Kernel::pbfEnableFlag( params ) ) {
       auto& occupancyMap = tile.getOccupancyMap();
       occupancyTop       = y > 0 && ( occupancyMap[( y - 1 ) * imageWidth + x] != 0U );
       occupancyBotton    = y < ( imageHeight - 1 ) && ( occupancyMap[( y + 1 ) * imageWidth + x] != 0U );
@@ -432,7 +482,7 @@ std::vector<PCCPoint3D> PCCCodec::generatePoints( const GeneratePointCloudParame
         if ( depthNeighbors[3] > maximumDepth ) { maximumDepth = depthNeighbors[3]; }
       }
     }
-    if ( count == 0 ) { return createdPoints; }
+    if ( count == 0 ) { return; }
     if ( ( x + y ) % 2 == 1 ) {
       depth1 = point0[patch.getNormalAxis()];
       PCCPoint3D interpolateD0( point0 );
@@ -469,7 +519,7 @@ std::vector<PCCPoint3D> PCCCodec::generatePoints( const GeneratePointCloudParame
       fillPoint[patch.getNormalAxis()] = xmin + double( step );
       createdPoints.push_back( fillPoint );
     }
-  } else if ( params.pointLocalReconstruction_ ) {
+  } else if ( Kernel::pointLocalReconstruction( params ) ) {
     int deltaDepth = 0;
     if ( interpolate ) {
       deltaDepth =
@@ -511,7 +561,235 @@ std::vector<PCCPoint3D> PCCCodec::generatePoints( const GeneratePointCloudParame
       createdPoints.push_back( point1 );
     }  // if ( params.mapCountMinus1_ > 0 ) {
   }    // fi (pointLocalReconstruction)
-  return createdPoints;
+}
+
+template <typename Kernel>
+void PCCCodec::generatePatchPoints( PCCPointSet3&                       reconstruct,
+                                    std::vector<uint32_t>&              partition,
+                                    std::vector<PCCVector3<size_t>>&    pointToPixel,
+                                    std::vector<PCCPoint3D>&            eomPoints,
+                                    PCCContext&                         context,
+                                    PCCFrameContext&                    tile,
+                                    size_t                              tileIndex,
+                                    size_t                              patchIndex,
+                                    size_t                              videoFrameIndex,
+                                    const PCCColor3B&                   color,
+                                    const GeneratePointCloudParameters& params ) {
+  auto&        videoGeometry         = context.getVideoGeometryMultiple()[0];
+  auto&        videoGeometryMultiple = context.getVideoGeometryMultiple();
+  auto&        occupancyMap          = tile.getOccupancyMap();
+  auto&        patch                 = tile.getPatch( patchIndex );
+  const size_t tileWidth             = tile.getWidth();
+  const size_t tileHeight            = tile.getHeight();
+  const auto&  frame0                = params.multipleStreams_ ? videoGeometryMultiple[0].getFrame( videoFrameIndex )
+                                                                 : videoGeometry.getFrame( videoFrameIndex );
+  auto&                      arena = getThreadArena();
+  PCCArenaScope              scope( arena );
+  PCCArenaVector<PCCPoint3D> createdPoints{PCCArenaAllocator<PCCPoint3D>( arena )};
+  if ( patch.getSizeU0() == 0 || patch.getSizeV0() == 0 ) { return; }
+  // the orientation is resolved once per patch; patch2Canvas() on two opposite corners checks that the whole patch
+  // lies within the tile, the pixel loop then maps without branches or bound checks.
+  const PCCPatchCanvasTransform transform = patch.getCanvasTransform();
+  patch.patch2Canvas( 0, 0, tileWidth, tileHeight );
+  patch.patch2Canvas( patch.getSizeU0() * patch.getOccupancyResolution() - 1,
+                      patch.getSizeV0() * patch.getOccupancyResolution() - 1, tileWidth, tileHeight );
+  for ( const uint32_t block : tile.getOccupiedBlocks()[patchIndex] ) {
+    const size_t u0 = block & 0xFFFFu;
+    const size_t v0 = block >> 16;
+    for ( size_t v1 = 0; v1 < patch.getOccupancyResolution(); ++v1 ) {
+      const size_t v = v0 * patch.getOccupancyResolution() + v1;
+      for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
+        const size_t u = u0 * patch.getOccupancyResolution() + u1;
+        const size_t x             = transform.x( u, v );
+        const size_t y             = transform.y( u, v );
+        const size_t canvasIndex   = x + tileWidth * y;
+        bool         occupancy     = false;
+        size_t       xInVideoFrame = x + tile.getLeftTopXInFrame();
+        size_t       yInVideoFrame = y + tile.getLeftTopYInFrame();
+        bool         isBoundary    = false;
+        if ( Kernel::pbfEnableFlag( params ) ) {
+          occupancy = patch.getOccupancyMap( u, v ) != 0;
+          if ( occupancy ) { isBoundary = patch.isBorder( u, v ); }
+        } else {
+          occupancy = occupancyMap[canvasIndex] != 0;
+        }
+        if ( !occupancy ) { continue; }
+        if ( Kernel::enhancedOccupancyMapCode( params ) ) {
+          // D0
+          PCCPoint3D point0 = patch.generatePoint( u, v, frame0.getValue( 0, xInVideoFrame, yInVideoFrame ) );
+          size_t     pointIndex0;  // = reconstruct.addPoint(point0);
+          if ( patch.getAxisOfAdditionalPlane() == 0 ) {
+            pointIndex0 = reconstruct.addPoint( point0 );
+          } else {
+            PCCVector3D tmp;
+            inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(), params.geometryBitDepth3D_,
+                                                 point0, tmp );
+            pointIndex0 = reconstruct.addPoint( tmp );
+          }
+          reconstruct.setPointPatchIndex( pointIndex0, tileIndex, patchIndex );
+          reconstruct.setColor( pointIndex0, color );
+          if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex0, POINT_D0 ); }
+          partition.push_back( uint32_t( patchIndex ) );
+          pointToPixel.emplace_back( x, y, 0 );
+          uint16_t    eomCode = 0;
+          size_t      d1pos   = 0;
+          const auto& frame0  = params.multipleStreams_ ? videoGeometryMultiple[0].getFrame( videoFrameIndex )
+                                                       : videoGeometry.getFrame( videoFrameIndex );
+          const auto& indx = canvasIndex;
+          if ( params.mapCountMinus1_ > 0 ) {
+            const auto& frame1 = params.multipleStreams_ ? videoGeometryMultiple[1].getFrame( videoFrameIndex )
+                                                         : videoGeometry.getFrame( videoFrameIndex + 1 );
+            int16_t diff = params.absoluteD1_
+                               ? ( static_cast<int16_t>( frame1.getValue( 0, xInVideoFrame, yInVideoFrame ) ) -
+                                   static_cast<int16_t>( frame0.getValue( 0, xInVideoFrame, yInVideoFrame ) ) )
+                               : static_cast<int16_t>( frame1.getValue( 0, xInVideoFrame, yInVideoFrame ) );
+            assert( diff >= 0 );
+            // Convert occupancy map to eomCode
+            if ( diff == 0 ) {
+              eomCode = 0;
+            } else if ( diff == 1 ) {
+              d1pos   = 1;
+              eomCode = 1;
+            } else if ( diff > 0 ) {
+              uint16_t bits = diff - 1;
+              uint16_t symbol =
+                  ( 1 << bits ) - occupancyMap[canvasIndex];
+              eomCode = symbol | ( 1 << bits );
+              d1pos   = ( bits );
+            }
+          } else {  // params.mapCountMinus1_ == 0
+            eomCode = ( 1 << params.EOMFixBitCount_ ) - occupancyMap[indx];
+          }
+          PCCPoint3D point1( point0 );
+          if ( eomCode == 0 ) {
+            if ( !params.removeDuplicatePoints_ ) {
+              size_t pointIndex1;  // = reconstruct.addPoint(point1);
+              if ( patch.getAxisOfAdditionalPlane() == 0 ) {
+                pointIndex1 = reconstruct.addPoint( point1 );
+              } else {
+                PCCVector3D tmp;
+                inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(), params.geometryBitDepth3D_,
+                                                     point1, tmp );
+                pointIndex1 = reconstruct.addPoint( tmp );
+              }
+              reconstruct.setPointPatchIndex( pointIndex1, tileIndex, patchIndex );
+              reconstruct.setColor( pointIndex1, color );
+              if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_D1 ); }
+              partition.push_back( uint32_t( patchIndex ) );
+              pointToPixel.emplace_back( x, y, 1 );
+            }
+          } else {  // eomCode != 0
+            uint16_t addedPointCount = 0;
+            size_t   pointIndex1     = 0;
+            for ( uint16_t i = 0; i < 10; i++ ) {
+              if ( ( eomCode & ( 1 << i ) ) != 0 ) { d1pos = i; }
+            }
+            for ( uint16_t i = 0; i < 10; i++ ) {
+              if ( ( eomCode & ( 1 << i ) ) != 0 ) {
+                uint8_t deltaDCur = ( i + 1 );
+                if ( patch.getProjectionMode() == 0 ) {
+                  point1[patch.getNormalAxis()] =
+                      static_cast<double>( point0[patch.getNormalAxis()] + deltaDCur );
+                } else {
+                  point1[patch.getNormalAxis()] =
+                      static_cast<double>( point0[patch.getNormalAxis()] - deltaDCur );
+                }
+                if ( ( eomCode == 1 || i == d1pos ) && ( params.mapCountMinus1_ > 0 ) ) {  // d1
+                  if ( patch.getAxisOfAdditionalPlane() == 0 ) {
+                    pointIndex1 = reconstruct.addPoint( point1 );
+                  } else {
+                    PCCVector3D tmp;
+                    inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(),
+                                                         params.geometryBitDepth3D_, point1, tmp );
+                    pointIndex1 = reconstruct.addPoint( tmp );
+                  }
+                  reconstruct.setPointPatchIndex( pointIndex1, tileIndex, patchIndex );
+                  reconstruct.setColor( pointIndex1, color );
+                  if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_D1 ); }
+                  partition.push_back( uint32_t( patchIndex ) );
+                  pointToPixel.emplace_back( x, y, 1 );
+                } else {
+                  if ( patch.getAxisOfAdditionalPlane() == 0 ) {
+                    eomPoints.push_back( point1 );
+                  } else {
+                    PCCVector3D tmp;
+                    inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(),
+                                                         params.geometryBitDepth3D_, point1, tmp );
+                    eomPoints.push_back( PCCPoint3D( tmp[0], tmp[1], tmp[2] ) );
+                  }
+                }
+                addedPointCount++;
+              }
+            }  // for each bit of EOM code
+            if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_D1 ); }
+            // Without "Identify boundary points" & "1st Extension boundary region" as EOM code is only for
+            // lossless coding now
+          }       // if (eomCode == 0)
+        } else {  // not params.enhancedOccupancyMapCode_
+          if ( Kernel::pointLocalReconstruction( params ) ) {
+            auto& mode =
+                context.getPointLocalReconstructionMode( patch.getPointLocalReconstructionMode( u0, v0 ) );
+            generatePoints<Kernel>( createdPoints, params, tile, videoGeometryMultiple, videoFrameIndex,
+                                    patchIndex, u, v, xInVideoFrame, yInVideoFrame, mode.interpolate_,
+                                    mode.filling_, mode.minD1_, mode.neighbor_ );
+          } else {
+            generatePoints<Kernel>( createdPoints, params, tile, videoGeometryMultiple, videoFrameIndex,
+                                    patchIndex, u, v, xInVideoFrame, yInVideoFrame, false, false, 0, 0 );
+          }
+          if ( !createdPoints.empty() ) {
+            for ( size_t i = 0; i < createdPoints.size(); i++ ) {
+              if ( ( !params.removeDuplicatePoints_ ) ||
+                   ( ( i == 0 ) || ( createdPoints[i] != createdPoints[0] ) ) ) {
+                size_t pointindex = 0;
+                if ( patch.getAxisOfAdditionalPlane() == 0 ) {
+                  pointindex = reconstruct.addPoint( createdPoints[i] );
+                  reconstruct.setPointPatchIndex( pointindex, tileIndex, patchIndex );
+                } else {
+                  PCCVector3D tmp;
+                  inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(),
+                                                       params.geometryBitDepth3D_, createdPoints[i], tmp );
+                  pointindex = reconstruct.addPoint( tmp );
+                  reconstruct.setPointPatchIndex( pointindex, tileIndex, patchIndex );
+                }
+                const size_t pointindex_1 = pointindex;
+                reconstruct.setColor( pointindex_1, color );
+                if ( Kernel::pbfEnableFlag( params ) ) { reconstruct.setBoundaryPointType( pointindex_1, isBoundary ); }
+                if ( PCC_SAVE_POINT_TYPE == 1 ) {
+                  if ( Kernel::singleMapPixelInterleaving( params ) ) {
+                    size_t flag;
+                    flag = ( i == 0 ) ? ( x + y ) % 2 : ( i == 1 ) ? ( x + y + 1 ) % 2 : g_intermediateLayerIndex;
+                    reconstruct.setType( pointindex_1, flag == 0 ? POINT_D0 : flag == 1 ? POINT_D1 : POINT_DF );
+                  } else {
+                    reconstruct.setType( pointindex_1, i == 0 ? POINT_D0 : i == 1 ? POINT_D1 : POINT_DF );
+                  }
+                }
+                partition.push_back( uint32_t( patchIndex ) );
+                if ( Kernel::singleMapPixelInterleaving( params ) ) {
+                  pointToPixel.emplace_back(
+                      x, y,
+                      i == 0 ? ( static_cast<size_t>( x + y ) % 2 )
+                             : i == 1 ? ( static_cast<size_t>( x + y + 1 ) % 2 ) : g_intermediateLayerIndex );
+                } else if ( Kernel::pointLocalReconstruction( params ) ) {
+                  pointToPixel.emplace_back(
+                      x, y, i == 0 ? 0 : i == 1 ? g_intermediateLayerIndex : g_intermediateLayerIndex + 1 );
+                } else {
+                  pointToPixel.emplace_back( x, y, i < 2 ? i : g_intermediateLayerIndex + 1 );
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+PCCCodec::PatchPointsKernel PCCCodec::selectPatchPointsKernel( const GeneratePointCloudParameters& params ) {
+  if ( PCCProjectedReconstruction::matches( params ) ) {
+    return &PCCCodec::generatePatchPoints<PCCProjectedReconstruction>;
+  }
+  if ( PCCEomReconstruction::matches( params ) ) { return &PCCCodec::generatePatchPoints<PCCEomReconstruction>; }
+  return &PCCCodec::generatePatchPoints<PCCGenericReconstruction>;
 }
 
 void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstruct,
@@ -520,7 +798,8 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
                                    size_t                              tileIndex,
                                    const GeneratePointCloudParameters& params,
                                    std::vector<uint32_t>&              partition,
-                                   bool                                bDecoder ) {
+                                   bool                                bDecoder,
+                                   const std::vector<PCCColor3B>*      patchColors ) {
   TRACE_CODEC( "generatePointCloud F = %zu start \n", frameIndex );
   auto&        tile                  = context[frameIndex].getTile( tileIndex );
   auto&        videoGeometry         = context.getVideoGeometryMultiple()[0];
@@ -553,18 +832,37 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
     TRACE_CODEC( "%s \n", "PBF done" );
   }
 
-  // point cloud occupancy map upscaling from video using nearest neighbor
-  auto& occupancyMap = tile.getOccupancyMap();
+  // point cloud occupancy map upscaling from video using nearest neighbor: the map is cleared, and only the occupied
+  // samples of the video are written, each as a square of occupancyPrecision pixels. The blocks holding one are
+  // flagged, for the lists of occupied blocks below.
+  auto&                occupancyMap = tile.getOccupancyMap();
+  std::vector<uint8_t> blockOccupied;
+  size_t               occupiedPixelCount = 0;
   if ( !params.pbfEnableFlag_ ) {
-    auto width  = tile.getWidth();
-    auto height = tile.getHeight();
-    occupancyMap.resize( width * height, 0 );
-    for ( size_t v = 0; v < height; ++v ) {
-      for ( size_t u = 0; u < width; ++u ) {
-        occupancyMap[v * width + u] =
-            videoOccupancyMap.getFrame( tile.getFrameIndex() )
-                .getValue( 0, tile.getLeftTopXInFrame() / params.occupancyPrecision_ + u / params.occupancyPrecision_,
-                           tile.getLeftTopYInFrame() / params.occupancyPrecision_ + v / params.occupancyPrecision_ );
+    const size_t width     = tile.getWidth();
+    const size_t height    = tile.getHeight();
+    const size_t precision = params.occupancyPrecision_;
+    const auto&  video     = videoOccupancyMap.getFrame( tile.getFrameIndex() );
+    occupancyMap.assign( width * height, 0 );
+    blockOccupied.assign( blockToPatchWidth * blockToPatchHeight, 0 );
+    for ( size_t y0 = 0; y0 < height; y0 += precision ) {
+      for ( size_t x0 = 0; x0 < width; x0 += precision ) {
+        const uint32_t value = video.getValue( 0, tile.getLeftTopXInFrame() / precision + x0 / precision,
+                                               tile.getLeftTopYInFrame() / precision + y0 / precision );
+        if ( value == 0 ) { continue; }
+        const size_t x1 = ( std::min )( x0 + precision, width );
+        const size_t y1 = ( std::min )( y0 + precision, height );
+        for ( size_t v = y0; v < y1; ++v ) {
+          std::fill( occupancyMap.begin() + v * width + x0, occupancyMap.begin() + v * width + x1, value );
+        }
+        occupiedPixelCount += ( x1 - x0 ) * ( y1 - y0 );
+        for ( size_t v = y0 / params.occupancyResolution_;
+              v <= ( y1 - 1 ) / params.occupancyResolution_ && v < blockToPatchHeight; ++v ) {
+          for ( size_t u = x0 / params.occupancyResolution_;
+                u <= ( x1 - 1 ) / params.occupancyResolution_ && u < blockToPatchWidth; ++u ) {
+            blockOccupied[v * blockToPatchWidth + u] = 1;
+          }
+        }
       }
     }
   }
@@ -577,6 +875,7 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
       size_t patchSizeYInPixel = ( patch.getPatchSize2DYInPixel() / quantizerSizeY ) * quantizerSizeY;
       if ( tile.getLog2PatchQuantizerSizeX() == 0 ) { assert( patchSizeXInPixel == patch.getPatchSize2DXInPixel() ); }
       if ( tile.getLog2PatchQuantizerSizeY() == 0 ) { assert( patchSizeYInPixel == patch.getPatchSize2DYInPixel() ); }
+      const PCCPatchCanvasTransform transform = patch.getCanvasTransform();
       for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
         for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
           const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
@@ -586,7 +885,7 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
               for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
                 const size_t u = u0 * patch.getOccupancyResolution() + u1;
                 if ( u >= patchSizeXInPixel || v >= patchSizeYInPixel ) {
-                  occupancyMap[patch.patch2Canvas( u, v, tile.getWidth(), tile.getHeight() )] = 0;
+                  occupancyMap[transform.x( u, v ) + tile.getWidth() * transform.y( u, v )] = 0;
                 }
               }  // u1
             }    // v1
@@ -595,9 +894,34 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
       }          // v0
     }
   }
+  // The blocks of each patch, in its raster order, that are its own in the block to patch map and hold an occupied
+  // pixel: the pixel loops of generatePatchPoints() visit these, not the empty blocks of the patch box. With the
+  // patch border filtering the occupancy is that of the patches, and all the blocks of a patch are listed.
+  auto& occupiedBlocks = tile.getOccupiedBlocks();
+  occupiedBlocks.assign( totalPatchCount, std::vector<uint32_t>() );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), totalPatchCount, [&]( const size_t i ) {
+      const auto& patch = patches[i];
+      for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
+        for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
+          const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
+          if ( blockToPatch[blockIndex] == i + 1 && ( blockOccupied.empty() || blockOccupied[blockIndex] != 0 ) ) {
+            occupiedBlocks[i].push_back( uint32_t( u0 | ( v0 << 16 ) ) );
+          }
+        }
+      }
+    } );
+  } );
   // partition.resize( 0 );
   pointToPixel.resize( 0 );
   reconstruct.clear();
+  if ( !params.pbfEnableFlag_ ) {
+    // One point per map for each occupied pixel: the attributes are allocated once instead of growing point by point.
+    // The count is taken before the size quantization, which only clears pixels: it is an upper bound.
+    reconstruct.reserve( occupiedPixelCount * mapCount );
+    partition.reserve( partition.size() + occupiedPixelCount * mapCount );
+    pointToPixel.reserve( occupiedPixelCount * mapCount );
+  }
 
   TRACE_CODEC( " Frame %zu in generatePointCloud \n", tile.getFrameIndex() );
   TRACE_CODEC( " params.useAdditionalPointsPatch = %d \n", params.useAdditionalPointsPatch_ );
@@ -616,20 +940,26 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
   TRACE_CODEC( " videoFrameIndex(shift):frameIndex*mapCount  = %d \n", videoFrameIndex );
   const auto& frame0 = params.multipleStreams_ ? videoGeometryMultiple[0].getFrame( videoFrameIndex )
                                                : videoGeometry.getFrame( videoFrameIndex );
-  const size_t          tileWidth  = tile.getWidth();
-  const size_t          tileHeight = tile.getHeight();
-  std::vector<uint32_t> BPflag;
-  if ( !params.pbfEnableFlag_ ) { BPflag.resize( tileWidth * tileHeight, 0 ); }
+  const size_t tileWidth  = tile.getWidth();
+  const size_t tileHeight = tile.getHeight();
 
   std::vector<std::vector<PCCPoint3D>> eomPointsPerPatch;
   eomPointsPerPatch.resize( totalPatchCount );
   uint32_t   index;
   const bool patchPrecedenceOrderFlag = context.getAtlasSequenceParameterSet( 0 ).getPatchPrecedenceOrderFlag();
+
+  // Patch colours are drawn here, in patch order, so that the rand() sequence does not depend on the threading.
+  std::vector<PCCColor3B> drawnPatchColors;
+  if ( patchColors == nullptr ) {
+    generatePatchColors( totalPatchCount, drawnPatchColors );
+    patchColors = &drawnPatchColors;
+  }
+  assert( patchColors->size() == totalPatchCount );
+  std::vector<size_t> patchOrder( totalPatchCount );
   for ( index = 0; index < patches.size(); index++ ) {
-    patchIndex                     = ( bDecoder && patchPrecedenceOrderFlag ) ? ( totalPatchCount - index - 1 ) : index;
-    const size_t patchIndexPlusOne = patchIndex + 1;
-    auto&        patch             = patches[patchIndex];
-    PCCColor3B   color( uint8_t( 0 ) );
+    patchOrder[index] = ( bDecoder && patchPrecedenceOrderFlag ) ? ( totalPatchCount - index - 1 ) : index;
+  }
+  auto tracePatch = [&]( const size_t patchIndex, const PCCPatch& patch ) {
     TRACE_CODEC(
         "P%2lu/%2lu: 2D=(%2lu,%2lu)*(%2lu,%2lu) 3D(%4zu,%4zu,%4zu)*(%4zu,%4zu) A=(%zu,%zu,%zu) Or=%zu P=%zu => %zu "
         "AxisOfAdditionalPlane = %zu \n",
@@ -638,214 +968,59 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
         patch.getSizeV0() * patch.getOccupancyResolution(), patch.getNormalAxis(), patch.getTangentAxis(),
         patch.getBitangentAxis(), patch.getPatchOrientation(), patch.getProjectionMode(), reconstruct.getPointCount(),
         patch.getAxisOfAdditionalPlane() );
-
-    while ( color[0] == color[1] || color[2] == color[1] || color[2] == color[0] ) {
-      color[0] = static_cast<uint8_t>( rand() % 32 ) * 8;
-      color[1] = static_cast<uint8_t>( rand() % 32 ) * 8;
-      color[2] = static_cast<uint8_t>( rand() % 32 ) * 8;
+  };
+  // the reconstruction flags are the same for all the patches: the kernel is chosen once, not tested per pixel
+  const PatchPointsKernel generatePatchPointsKernel = selectPatchPointsKernel( params );
+  if ( params.nbThread_ == 1 || totalPatchCount < 2 ) {
+    for ( index = 0; index < patches.size(); index++ ) {
+      patchIndex = patchOrder[index];
+      tracePatch( patchIndex, patches[patchIndex] );
+      ( this->*generatePatchPointsKernel )( reconstruct, partition, pointToPixel, eomPointsPerPatch[patchIndex],
+                                            context, tile, tileIndex, patchIndex, videoFrameIndex,
+                                            ( *patchColors )[index], params );
     }
-    for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
-      for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
-        const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
-        if ( blockToPatch[blockIndex] == patchIndexPlusOne ) {
-          for ( size_t v1 = 0; v1 < patch.getOccupancyResolution(); ++v1 ) {
-            const size_t v = v0 * patch.getOccupancyResolution() + v1;
-            for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
-              const size_t u = u0 * patch.getOccupancyResolution() + u1;
-              size_t       x;
-              size_t       y;
-              bool         occupancy     = false;
-              size_t       canvasIndex   = patch.patch2Canvas( u, v, tileWidth, tileHeight, x, y );
-              size_t       xInVideoFrame = x + tile.getLeftTopXInFrame();
-              size_t       yInVideoFrame = y + tile.getLeftTopYInFrame();
-              bool         isBoundary    = false;
-              if ( params.pbfEnableFlag_ ) {
-                occupancy = patch.getOccupancyMap( u, v ) != 0;
-                if ( occupancy ) { isBoundary = patch.isBorder( u, v ); }
-              } else {
-                occupancy = occupancyMap[canvasIndex] != 0;
-              }
-              if ( !occupancy ) { continue; }
-              if ( params.enhancedOccupancyMapCode_ ) {
-                // D0
-                PCCPoint3D point0 = patch.generatePoint( u, v, frame0.getValue( 0, xInVideoFrame, yInVideoFrame ) );
-                size_t     pointIndex0;  // = reconstruct.addPoint(point0);
-                if ( patch.getAxisOfAdditionalPlane() == 0 ) {
-                  pointIndex0 = reconstruct.addPoint( point0 );
-                } else {
-                  PCCVector3D tmp;
-                  inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(), params.geometryBitDepth3D_,
-                                                       point0, tmp );
-                  pointIndex0 = reconstruct.addPoint( tmp );
-                }
-                reconstruct.setPointPatchIndex( pointIndex0, tileIndex, patchIndex );
-                reconstruct.setColor( pointIndex0, color );
-                if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex0, POINT_D0 ); }
-                partition.push_back( uint32_t( patchIndex ) );
-                pointToPixel.emplace_back( x, y, 0 );
-                uint16_t    eomCode = 0;
-                size_t      d1pos   = 0;
-                const auto& frame0  = params.multipleStreams_ ? videoGeometryMultiple[0].getFrame( videoFrameIndex )
-                                                             : videoGeometry.getFrame( videoFrameIndex );
-                const auto& indx = patch.patch2Canvas( u, v, tileWidth, tileHeight, x, y );
-                if ( params.mapCountMinus1_ > 0 ) {
-                  const auto& frame1 = params.multipleStreams_ ? videoGeometryMultiple[1].getFrame( videoFrameIndex )
-                                                               : videoGeometry.getFrame( videoFrameIndex + 1 );
-                  int16_t diff = params.absoluteD1_
-                                     ? ( static_cast<int16_t>( frame1.getValue( 0, xInVideoFrame, yInVideoFrame ) ) -
-                                         static_cast<int16_t>( frame0.getValue( 0, xInVideoFrame, yInVideoFrame ) ) )
-                                     : static_cast<int16_t>( frame1.getValue( 0, xInVideoFrame, yInVideoFrame ) );
-                  assert( diff >= 0 );
-                  // Convert occupancy map to eomCode
-                  if ( diff == 0 ) {
-                    eomCode = 0;
-                  } else if ( diff == 1 ) {
-                    d1pos   = 1;
-                    eomCode = 1;
-                  } else if ( diff > 0 ) {
-                    uint16_t bits = diff - 1;
-                    uint16_t symbol =
-                        ( 1 << bits ) - occupancyMap[patch.patch2Canvas( u, v, tileWidth, tileHeight, x, y )];
-                    eomCode = symbol | ( 1 << bits );
-                    d1pos   = ( bits );
-                  }
-                } else {  // params.mapCountMinus1_ == 0
-                  eomCode = ( 1 << params.EOMFixBitCount_ ) - occupancyMap[indx];
-                }
-                PCCPoint3D point1( point0 );
-                if ( eomCode == 0 ) {
-                  if ( !params.removeDuplicatePoints_ ) {
-                    size_t pointIndex1;  // = reconstruct.addPoint(point1);
-                    if ( patch.getAxisOfAdditionalPlane() == 0 ) {
-                      pointIndex1 = reconstruct.addPoint( point1 );
-                    } else {
-                      PCCVector3D tmp;
-                      inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(), params.geometryBitDepth3D_,
-                                                           point1, tmp );
-                      pointIndex1 = reconstruct.addPoint( tmp );
-                    }
-                    reconstruct.setPointPatchIndex( pointIndex1, tileIndex, patchIndex );
-                    reconstruct.setColor( pointIndex1, color );
-                    if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_D1 ); }
-                    partition.push_back( uint32_t( patchIndex ) );
-                    pointToPixel.emplace_back( x, y, 1 );
-                  }
-                } else {  // eomCode != 0
-                  uint16_t addedPointCount = 0;
-                  size_t   pointIndex1     = 0;
-                  for ( uint16_t i = 0; i < 10; i++ ) {
-                    if ( ( eomCode & ( 1 << i ) ) != 0 ) { d1pos = i; }
-                  }
-                  for ( uint16_t i = 0; i < 10; i++ ) {
-                    if ( ( eomCode & ( 1 << i ) ) != 0 ) {
-                      uint8_t deltaDCur = ( i + 1 );
-                      if ( patch.getProjectionMode() == 0 ) {
-                        point1[patch.getNormalAxis()] =
-                            static_cast<double>( point0[patch.getNormalAxis()] + deltaDCur );
-                      } else {
-                        point1[patch.getNormalAxis()] =
-                            static_cast<double>( point0[patch.getNormalAxis()] - deltaDCur );
-                      }
-                      if ( ( eomCode == 1 || i == d1pos ) && ( params.mapCountMinus1_ > 0 ) ) {  // d1
-                        if ( patch.getAxisOfAdditionalPlane() == 0 ) {
-                          pointIndex1 = reconstruct.addPoint( point1 );
-                        } else {
-                          PCCVector3D tmp;
-                          inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(),
-                                                               params.geometryBitDepth3D_, point1, tmp );
-                          pointIndex1 = reconstruct.addPoint( tmp );
-                        }
-                        reconstruct.setPointPatchIndex( pointIndex1, tileIndex, patchIndex );
-                        reconstruct.setColor( pointIndex1, color );
-                        if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_D1 ); }
-                        partition.push_back( uint32_t( patchIndex ) );
-                        pointToPixel.emplace_back( x, y, 1 );
-                      } else {
-                        if ( patch.getAxisOfAdditionalPlane() == 0 ) {
-                          eomPointsPerPatch[patchIndex].push_back( point1 );
-                        } else {
-                          PCCVector3D tmp;
-                          inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(),
-                                                               params.geometryBitDepth3D_, point1, tmp );
-                          eomPointsPerPatch[patchIndex].push_back( PCCPoint3D( tmp[0], tmp[1], tmp[2] ) );
-                        }
-                      }
-                      addedPointCount++;
-                    }
-                  }  // for each bit of EOM code
-                  if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_D1 ); }
-                  // Without "Identify boundary points" & "1st Extension boundary region" as EOM code is only for
-                  // lossless coding now
-                }       // if (eomCode == 0)
-              } else {  // not params.enhancedOccupancyMapCode_
-                std::vector<PCCPoint3D> createdPoints;
-                if ( params.pointLocalReconstruction_ ) {
-                  auto& mode =
-                      context.getPointLocalReconstructionMode( patch.getPointLocalReconstructionMode( u0, v0 ) );
-                  createdPoints = generatePoints( params, tile, videoGeometryMultiple, videoFrameIndex, patchIndex, u,
-                                                  v, xInVideoFrame, yInVideoFrame, mode.interpolate_, mode.filling_,
-                                                  mode.minD1_, mode.neighbor_ );
-                } else {
-                  createdPoints = generatePoints( params, tile, videoGeometryMultiple, videoFrameIndex, patchIndex, u,
-                                                  v, xInVideoFrame, yInVideoFrame );
-                }
-                if ( !createdPoints.empty() ) {
-                  for ( size_t i = 0; i < createdPoints.size(); i++ ) {
-                    if ( ( !params.removeDuplicatePoints_ ) ||
-                         ( ( i == 0 ) || ( createdPoints[i] != createdPoints[0] ) ) ) {
-                      size_t pointindex = 0;
-                      if ( patch.getAxisOfAdditionalPlane() == 0 ) {
-                        pointindex = reconstruct.addPoint( createdPoints[i] );
-                        reconstruct.setPointPatchIndex( pointindex, tileIndex, patchIndex );
-                      } else {
-                        PCCVector3D tmp;
-                        inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(),
-                                                             params.geometryBitDepth3D_, createdPoints[i], tmp );
-                        pointindex = reconstruct.addPoint( tmp );
-                        reconstruct.setPointPatchIndex( pointindex, tileIndex, patchIndex );
-                      }
-                      const size_t pointindex_1 = pointindex;
-                      reconstruct.setColor( pointindex_1, color );
-                      if ( params.pbfEnableFlag_ ) { reconstruct.setBoundaryPointType( pointindex_1, isBoundary ); }
-                      if ( PCC_SAVE_POINT_TYPE == 1 ) {
-                        if ( params.singleMapPixelInterleaving_ ) {
-                          size_t flag;
-                          flag = ( i == 0 ) ? ( x + y ) % 2 : ( i == 1 ) ? ( x + y + 1 ) % 2 : g_intermediateLayerIndex;
-                          reconstruct.setType( pointindex_1, flag == 0 ? POINT_D0 : flag == 1 ? POINT_D1 : POINT_DF );
-                        } else {
-                          reconstruct.setType( pointindex_1, i == 0 ? POINT_D0 : i == 1 ? POINT_D1 : POINT_DF );
-                        }
-                      }
-                      partition.push_back( uint32_t( patchIndex ) );
-                      if ( params.singleMapPixelInterleaving_ ) {
-                        pointToPixel.emplace_back(
-                            x, y,
-                            i == 0 ? ( static_cast<size_t>( x + y ) % 2 )
-                                   : i == 1 ? ( static_cast<size_t>( x + y + 1 ) % 2 ) : g_intermediateLayerIndex );
-                      } else if ( params.pointLocalReconstruction_ ) {
-                        pointToPixel.emplace_back(
-                            x, y, i == 0 ? 0 : i == 1 ? g_intermediateLayerIndex : g_intermediateLayerIndex + 1 );
-                      } else {
-                        pointToPixel.emplace_back( x, y, i < 2 ? i : g_intermediateLayerIndex + 1 );
-                      }
-                    }
-                  }
-                }
-              }
-            }
-          }
-        }
-      }
+  } else {
+    // Each patch is reconstructed into its own buffers, which are then appended in patch order: the points, the
+    // partition and the point to pixel map are the same as with the sequential loop.
+    std::vector<PCCPointSet3>                    patchPoints( totalPatchCount );
+    std::vector<std::vector<uint32_t>>           patchPartitions( totalPatchCount );
+    std::vector<std::vector<PCCVector3<size_t>>> patchPointToPixels( totalPatchCount );
+    executionContext_->execute( [&] {
+      tbb::parallel_for( size_t( 0 ), totalPatchCount, [&]( const size_t i ) {
+        patchPoints[i].addColors();
+        ( this->*generatePatchPointsKernel )( patchPoints[i], patchPartitions[i], patchPointToPixels[i],
+                                              eomPointsPerPatch[patchOrder[i]], context, tile, tileIndex,
+                                              patchOrder[i], videoFrameIndex, ( *patchColors )[i], params );
+      } );
+    } );
+    for ( index = 0; index < patches.size(); index++ ) {
+      tracePatch( patchOrder[index], patches[patchOrder[index]] );
+      reconstruct.appendPointSet( patchPoints[index] );
+      partition.insert( partition.end(), patchPartitions[index].begin(), patchPartitions[index].end() );
+      pointToPixel.insert( pointToPixel.end(), patchPointToPixels[index].begin(), patchPointToPixels[index].end() );
     }
   }
   tile.setTotalNumberOfRegularPoints( reconstruct.getPointCount() );
   printf( "frame %zu, tile %zu: regularPoints %zu\n", frameIndex, tileIndex, reconstruct.getPointCount() );
   patchIndex                         = index;
   size_t       totalEOMPointsInFrame = 0;
-  PCCPointSet3 eomSavedPoints;
   if ( params.enhancedOccupancyMapCode_ ) {
     const size_t blockSize     = params.occupancyResolution_ * params.occupancyResolution_;
     size_t       numEOMPatches = tile.getEomPatches().size();
+    // The EOM points of the member patches are placed with a prefix sum over their counts, then written in
+    // parallel: the points, the partition and the point to pixel map are the same as appended one by one.
+    struct EomRun {
+      size_t memberPatchIdx;
+      size_t firstPoint;  // among the EOM points of the tile
+      size_t firstInEom;  // in its EOM patch, which gives the pixel of each point
+      size_t u0Eom;
+      size_t v0Eom;
+    };
+    std::vector<EomRun> eomRuns;
+    const size_t        firstEomPoint     = reconstruct.getPointCount();
+    const size_t        firstEomPartition = partition.size();
+    const size_t        firstEomPixel     = pointToPixel.size();
+    size_t              eomPointCount     = 0;
     for ( int j = 0; j < numEOMPatches; j++ ) {
       auto&  eomPatch               = tile.getEomPatch( j );
       size_t numPatchesInEOMPatches = eomPatch.memberPatches_.size();
@@ -857,32 +1032,49 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
         size_t memberPatchIdx = ( bDecoder && context.getAtlasSequenceParameterSet( 0 ).getPatchPrecedenceOrderFlag() )
                                     ? ( totalPatchCount - eomPatch.memberPatches_[patchIdxInEom] - 1 )
                                     : eomPatch.memberPatches_[patchIdxInEom];
-        size_t numberOfEOMPointsPerPatch = eomPointsPerPatch[memberPatchIdx].size();
-        for ( size_t pointCount = 0; pointCount < numberOfEOMPointsPerPatch; pointCount++ ) {
-          size_t currBlock                 = totalPointCount / blockSize;
-          size_t nPixelInCurrentBlockCount = totalPointCount - currBlock * blockSize;
-          size_t uBlock                    = currBlock % blockToPatchWidth;
-          size_t vBlock                    = currBlock / blockToPatchWidth;
-          size_t uu =
-              uBlock * params.occupancyResolution_ + nPixelInCurrentBlockCount % params.occupancyResolution_ + u0Eom;
-          size_t vv =
-              vBlock * params.occupancyResolution_ + nPixelInCurrentBlockCount / params.occupancyResolution_ + v0Eom;
-          PCCPoint3D point1      = eomPointsPerPatch[memberPatchIdx][pointCount];
-          size_t     pointIndex1 = reconstruct.addPoint( point1 );
-          reconstruct.setPointPatchIndex( pointIndex1, tileIndex, patchIndex );
-          eomSavedPoints.addPoint( point1 );
-
-          // reconstruct.setColor( pointIndex1, color );
-          if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_EOM ); }
-          partition.push_back( uint32_t( patchIndex ) );
-          totalPointCount++;
-          pointToPixel.emplace_back( uu, vv, 0 );
-          if ( !params.useAuxSeperateVideo_ ) { occupancyMap[vv * tileWidth + uu] = 1; }  // occupied
-        }
+        eomRuns.push_back( {memberPatchIdx, eomPointCount, totalPointCount, u0Eom, v0Eom} );
+        eomPointCount += eomPointsPerPatch[memberPatchIdx].size();
+        totalPointCount += eomPointsPerPatch[memberPatchIdx].size();
       }
       TRACE_CODEC( "%d eomPatch :%zu,%zu\t %zu patches, %zu points\n", j, u0Eom, v0Eom, numPatchesInEOMPatches,
                    eomPatch.eomCount_ );
     }
+    reconstruct.resize( firstEomPoint + eomPointCount );
+    partition.resize( firstEomPartition + eomPointCount, uint32_t( patchIndex ) );
+    pointToPixel.resize( firstEomPixel + eomPointCount );
+    // the EOM patches of a separate video all start at 0: their pixels may be the same, set once afterwards
+    const bool setOccupancy = !params.useAuxSeperateVideo_ && !useRawPointsSeparateVideo;
+    auto       fillRun      = [&]( const EomRun& run ) {
+      const auto& points = eomPointsPerPatch[run.memberPatchIdx];
+      for ( size_t pointCount = 0; pointCount < points.size(); pointCount++ ) {
+        size_t currBlock                 = ( run.firstInEom + pointCount ) / blockSize;
+        size_t nPixelInCurrentBlockCount = ( run.firstInEom + pointCount ) - currBlock * blockSize;
+        size_t uBlock                    = currBlock % blockToPatchWidth;
+        size_t vBlock                    = currBlock / blockToPatchWidth;
+        size_t uu =
+            uBlock * params.occupancyResolution_ + nPixelInCurrentBlockCount % params.occupancyResolution_ + run.u0Eom;
+        size_t vv =
+            vBlock * params.occupancyResolution_ + nPixelInCurrentBlockCount / params.occupancyResolution_ + run.v0Eom;
+        size_t pointIndex1       = firstEomPoint + run.firstPoint + pointCount;
+        reconstruct[pointIndex1] = points[pointCount];
+        reconstruct.setPointPatchIndex( pointIndex1, tileIndex, patchIndex );
+        if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( pointIndex1, POINT_EOM ); }
+        pointToPixel[firstEomPixel + run.firstPoint + pointCount] = PCCVector3<size_t>( uu, vv, 0 );
+        if ( setOccupancy ) { occupancyMap[vv * tileWidth + uu] = 1; }  // occupied
+      }
+    };
+    if ( params.nbThread_ == 1 || eomRuns.size() < 2 ) {
+      for ( const auto& run : eomRuns ) { fillRun( run ); }
+    } else {
+      executionContext_->execute( [&] {
+        tbb::parallel_for( size_t( 0 ), eomRuns.size(), [&]( const size_t i ) { fillRun( eomRuns[i] ); } );
+      } );
+    }
+    if ( !params.useAuxSeperateVideo_ && useRawPointsSeparateVideo ) {
+      for ( size_t i = firstEomPixel; i < pointToPixel.size(); i++ ) {
+        occupancyMap[pointToPixel[i][1] * tileWidth + pointToPixel[i][0]] = 1;  // occupied
+      }
+    }
     tile.setTotalNumberOfEOMPoints( totalEOMPointsInFrame );
     printf( "frame %zu, tile %zu: regularPoints+eomPoints %zu\n", frameIndex, tileIndex, reconstruct.getPointCount() );
   } else {
@@ -962,14 +1154,7 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
       }
     }
     size_t pointCount = reconstruct.getPointCount() - tile.getTotalNumberOfRawPoints();
-    for ( size_t i = 0; i < pointCount; ++i ) {
-      const PCCVector3<size_t> location = pointToPixel[i];
-      const size_t             x        = location[0];
-      const size_t             y        = location[1];
-      if ( occupancyMap[y * tileWidth + x] != 0 ) {
-        identifyBoundaryPoints( occupancyMap, x, y, tileWidth, tileHeight, i, BPflag, reconstruct );
-      }
-    }
+    identifyBoundaryPoints( occupancyMap, tileWidth, tileHeight, pointToPixel, pointCount, reconstruct );
   }
 #ifdef CODEC_TRACE
   TRACE_CODEC( " generatePointCloud create %zu points \n", reconstruct.getPointCount() );
@@ -977,37 +1162,23 @@ void PCCCodec::generatePointCloud( PCCPointSet3&                       reconstru
 #endif
 }
 
-void PCCCodec::addGridCentroid( PCCPoint3D&                     point,
-                                uint32_t                        patchIdx,
-                                std::vector<uint16_t>&          count,
-                                std::vector<PCCVector3<float>>& centerGrid,
-                                std::vector<uint32_t>&          gpartition,
-                                std::vector<bool>&              doSmooth,
-                                uint8_t                         gridSize,
-                                uint16_t                        gridWidth,
-                                int                             cellId ) {
-  if ( count[cellId] == 0 ) {
-    gpartition[cellId] = patchIdx;
-    centerGrid[cellId] = {0., 0., 0.};
-    doSmooth[cellId]   = false;
-  } else if ( !doSmooth[cellId] && gpartition[cellId] != patchIdx ) {
-    doSmooth[cellId] = true;
+void PCCCodec::generatePatchColors( size_t patchCount, std::vector<PCCColor3B>& patchColors ) {
+  patchColors.resize( patchCount );
+  for ( auto& color : patchColors ) {
+    color = PCCColor3B( uint8_t( 0 ) );
+    while ( color[0] == color[1] || color[2] == color[1] || color[2] == color[0] ) {
+      color[0] = static_cast<uint8_t>( rand() % 32 ) * 8;
+      color[1] = static_cast<uint8_t>( rand() % 32 ) * 8;
+      color[2] = static_cast<uint8_t>( rand() % 32 ) * 8;
+    }
   }
-  centerGrid[cellId] += PCCVector3<float>( point );
-  count[cellId]++;
 }
 
-bool PCCCodec::gridFiltering( const std::vector<uint32_t>&    partition,
-                              PCCPointSet3&                   pointCloud,
-                              PCCPoint3D&                     curPoint,
-                              PCCVector3D&                    centroid,
-                              int&                            count,
-                              std::vector<uint16_t>&          gridCount,
-                              std::vector<PCCVector3<float>>& center,
-                              std::vector<bool>&              doSmooth,
-                              uint8_t                         gridSize,
-                              uint16_t                        gridWidth,
-                              std::vector<int>&               cellIndex ) {
+bool PCCCodec::gridFiltering( const PCCPoint3D&       curPoint,
+                              PCCVector3D&            centroid,
+                              int&                    count,
+                              uint8_t                 gridSize,
+                              const std::vector<int>& cellIndex ) const {
   const uint16_t  gridSizeHalf           = gridSize / 2;
   bool            otherClusterPointCount = false;
   PCCVector3<int> P                      = curPoint;
@@ -1015,13 +1186,13 @@ bool PCCCodec::gridFiltering( const std::vector<uint32_t>&    partition,
   PCCVector3<int> P3                     = P - P2 * gridSize;
   PCCVector3<int> S( P2[0] + ( ( P3[0] < gridSizeHalf ) ? -1 : 0 ), P2[1] + ( ( P3[1] < gridSizeHalf ) ? -1 : 0 ),
                      P2[2] + ( ( P3[2] < gridSizeHalf ) ? -1 : 0 ) );
-  int             idx[2][2][2];
+  // the boundary points only see cells inside the grid, all of them marked as boundary cells
+  const GeoSmoothingCell* cells[2][2][2];
   for ( int dz = 0; dz < 2; dz++ ) {
     for ( int dy = 0; dy < 2; dy++ ) {
       for ( int dx = 0; dx < 2; dx++ ) {
-        int tmp         = ( S[0] + dx ) + ( S[1] + dy ) * gridWidth + ( S[2] + dz ) * gridWidth * gridWidth;
-        idx[dz][dy][dx] = tmp;
-        if ( doSmooth[cellIndex[tmp]] && ( gridCount[cellIndex[tmp]] != 0U ) ) { otherClusterPointCount = true; }
+        cells[dz][dy][dx] = &geoSmoothingCells_[cellIndex[gridCellCode( S[0] + dx, S[1] + dy, S[2] + dz )]];
+        if ( cells[dz][dy][dx]->doSmooth_ && ( cells[dz][dy][dx]->count_ != 0U ) ) { otherClusterPointCount = true; }
       }
     }
   }
@@ -1029,18 +1200,13 @@ bool PCCCodec::gridFiltering( const std::vector<uint32_t>&    partition,
   PCCVector3D     centroid3[2][2][2] = {};
   PCCVector3D     curVector          = P;
   int             gridSize2          = gridSize * 2;
-  int             gridWidth3         = gridWidth * gridWidth * gridWidth;
   PCCVector3<int> S2                 = S * gridSize;
   PCCVector3<int> W                  = ( P - S2 - gridSizeHalf ) * 2 + 1;
   for ( int dz = 0; dz < 2; dz++ ) {
     for ( int dy = 0; dy < 2; dy++ ) {
       for ( int dx = 0; dx < 2; dx++ ) {
-        if ( ( dx == 0 && dy == 0 && dz == 0 ) || ( idx[dz][dy][dx] < gridWidth3 ) ) {
-          auto index            = cellIndex[idx[dz][dy][dx]];
-          centroid3[dz][dy][dx] = gridCount[index] > 0 ? PCCVector3<double>( center[index] ) : curVector;
-        } else {
-          centroid3[dz][dy][dx] = curVector;
-        }
+        const auto& cell      = *cells[dz][dy][dx];
+        centroid3[dz][dy][dx] = cell.count_ > 0 ? PCCVector3<double>( cell.center_ ) : curVector;
       }
     }
   }
@@ -1052,7 +1218,7 @@ bool PCCCodec::gridFiltering( const std::vector<uint32_t>&    partition,
       for ( int dx = 0, a = Q[0]; dx < 2; dx++, a = W[0] ) {
         centroid3[dz][dy][dx] *= a * b * c;
         centroid4 += centroid3[dz][dy][dx];
-        count += a * b * c * gridCount[cellIndex[idx[dz][dy][dx]]];
+        count += a * b * c * cells[dz][dy][dx]->count_;
       }
     }
   }
@@ -1062,6 +1228,54 @@ bool PCCCodec::gridFiltering( const std::vector<uint32_t>&    partition,
   return otherClusterPointCount;
 }
 
+bool PCCCodec::gridFilteringFixedPoint( const PCCPoint3D&       curPoint,
+                                        int64_t                 centroid[3],
+                                        int&                    count,
+                                        uint8_t                 gridSize,
+                                        const std::vector<int>& cellIndex ) const {
+  const uint16_t  gridSizeHalf           = gridSize / 2;
+  bool            otherClusterPointCount = false;
+  PCCVector3<int> P                      = curPoint;
+  PCCVector3<int> P2                     = P / gridSize;
+  PCCVector3<int> P3                     = P - P2 * gridSize;
+  PCCVector3<int> S( P2[0] + ( ( P3[0] < gridSizeHalf ) ? -1 : 0 ), P2[1] + ( ( P3[1] < gridSizeHalf ) ? -1 : 0 ),
+                     P2[2] + ( ( P3[2] < gridSizeHalf ) ? -1 : 0 ) );
+  const GeoSmoothingCell* cells[2][2][2];
+  for ( int dz = 0; dz < 2; dz++ ) {
+    for ( int dy = 0; dy < 2; dy++ ) {
+      for ( int dx = 0; dx < 2; dx++ ) {
+        cells[dz][dy][dx] = &geoSmoothingCells_[cellIndex[gridCellCode( S[0] + dx, S[1] + dy, S[2] + dz )]];
+        if ( cells[dz][dy][dx]->doSmooth_ && ( cells[dz][dy][dx]->count_ != 0U ) ) { otherClusterPointCount = true; }
+      }
+    }
+  }
+  if ( !otherClusterPointCount ) { return otherClusterPointCount; }
+  // an empty cell weighs in with the point itself, as in gridFiltering()
+  const int64_t   curFx[3]  = {int64_t( P[0] ) << kGeoSmoothingFractionBits,
+                            int64_t( P[1] ) << kGeoSmoothingFractionBits,
+                            int64_t( P[2] ) << kGeoSmoothingFractionBits};
+  int             gridSize2 = gridSize * 2;
+  PCCVector3<int> S2        = S * gridSize;
+  PCCVector3<int> W         = ( P - S2 - gridSizeHalf ) * 2 + 1;
+  PCCVector3<int> Q( gridSize2 - W[0], gridSize2 - W[1], gridSize2 - W[2] );
+  count = 0;
+  for ( size_t k = 0; k < 3; k++ ) { centroid[k] = 0; }
+  for ( int dz = 0, c = Q[2]; dz < 2; dz++, c = W[2] ) {
+    for ( int dy = 0, b = Q[1]; dy < 2; dy++, b = W[1] ) {
+      for ( int dx = 0, a = Q[0]; dx < 2; dx++, a = W[0] ) {
+        const auto&   cell   = *cells[dz][dy][dx];
+        const int64_t weight = a * b * c;
+        for ( size_t k = 0; k < 3; k++ ) {
+          centroid[k] += weight * ( cell.count_ > 0 ? cell.centerFx_[k] : curFx[k] );
+        }
+        count += a * b * c * cell.count_;
+      }
+    }
+  }
+  count /= gridSize2 * gridSize2 * gridSize2;
+  return otherClusterPointCount;
+}
+
 void PCCCodec::smoothPointCloudGrid( PCCPointSet3&                       reconstruct,
                                      const std::vector<uint32_t>&        partition,
                                      const GeneratePointCloudParameters& params,
@@ -1072,34 +1286,65 @@ void PCCCodec::smoothPointCloudGrid( PCCPointSet3&                       reconst
   const int    gridSize   = static_cast<int>( params.gridSize_ );
   const int    disth      = ( std::max )( gridSize / 2, 1 );
   const int    th         = gridSize * gridWidth;
-  for ( int c = 0; c < pointCount; c++ ) {
-    PCCPoint3D      curPoint = reconstruct[c];
-    PCCVector3<int> P        = curPoint;
-    if ( P[0] < disth || P[1] < disth || P[2] < disth || th <= P[0] + disth || th <= P[1] + disth ||
-         th <= P[2] + disth ) {
-      continue;
-    }
-    PCCVector3D centroid( 0.0 );
-    PCCVector3D curVector              = P;
-    int         count                  = 0;
-    bool        otherClusterPointCount = false;
-    PCCVector3D color( 0, 0, 0 );
-    if ( reconstruct.getBoundaryPointType( c ) == 1 ) {
-      otherClusterPointCount =
-          gridFiltering( partition, reconstruct, curPoint, centroid, count, geoSmoothingCount_, geoSmoothingCenter_,
-                         geoSmoothingDoSmooth_, gridSize, gridWidth, cellIndex );
-    }
-    if ( otherClusterPointCount ) {
-      double dist2 = ( ( curVector * count - centroid ).getNorm2() ) / static_cast<double>( count ) + 0.5;
-      if ( dist2 >= ( std::max )( static_cast<int>( params.thresholdSmoothing_ ), count ) * 2 ) {
-        centroid = centroid / static_cast<double>( count ) + 0.5;
-        for ( size_t k = 0; k < 3; ++k ) { centroid[k] = double( int64_t( centroid[k] ) ); }
-        reconstruct[c] = centroid;
-        if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( c, POINT_SMOOTH ); }
-        reconstruct.setBoundaryPointType( c, static_cast<uint16_t>( 3 ) );
+  // the trilinear weights of gridFiltering() sum to ( 2 * gridSize )^3, the fixed-point centroid carries them too
+  const int64_t weightSum     = int64_t( 8 ) * gridSize * gridSize * gridSize;
+  const int64_t centroidScale = weightSum << kGeoSmoothingFractionBits;
+  // each point only reads the grid and writes itself
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t c ) {
+      PCCPoint3D      curPoint = reconstruct[c];
+      PCCVector3<int> P        = curPoint;
+      if ( P[0] < disth || P[1] < disth || P[2] < disth || th <= P[0] + disth || th <= P[1] + disth ||
+           th <= P[2] + disth ) {
+        return;
       }
-    }
-  }
+      if ( params.fixedPointSmoothing_ ) {
+        // The test below in integers: count * |P - centroid|^2 + 0.5 >= 2 * max( threshold, count ), with the
+        // distance rounded to kGeoSmoothingFractionBits fraction bits. The neighbourhood is a few cells wide, so
+        // the products stay far from overflowing.
+        int64_t centroid[3];
+        int     count = 0;
+        if ( reconstruct.getBoundaryPointType( c ) != 1 ||
+             !gridFilteringFixedPoint( curPoint, centroid, count, gridSize, cellIndex ) || count == 0 ) {
+          return;
+        }
+        int64_t dist2 = 0;
+        for ( size_t k = 0; k < 3; ++k ) {
+          const int64_t diff  = P[k] * centroidScale - centroid[k];
+          const int64_t error =
+              diff >= 0 ? ( diff + weightSum / 2 ) / weightSum : -( ( weightSum / 2 - diff ) / weightSum );
+          dist2 += error * error;
+        }
+        const int64_t threshold = ( std::max )( static_cast<int>( params.thresholdSmoothing_ ), count ) * 2;
+        if ( count * dist2 + ( int64_t( 1 ) << ( 2 * kGeoSmoothingFractionBits - 1 ) ) >=
+             ( threshold << ( 2 * kGeoSmoothingFractionBits ) ) ) {
+          for ( size_t k = 0; k < 3; ++k ) {
+            reconstruct[c][k] = static_cast<int16_t>( ( centroid[k] + centroidScale / 2 ) / centroidScale );
+          }
+          if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( c, POINT_SMOOTH ); }
+          reconstruct.setBoundaryPointType( c, static_cast<uint16_t>( 3 ) );
+        }
+        return;
+      }
+      PCCVector3D centroid( 0.0 );
+      PCCVector3D curVector              = P;
+      int         count                  = 0;
+      bool        otherClusterPointCount = false;
+      if ( reconstruct.getBoundaryPointType( c ) == 1 ) {
+        otherClusterPointCount = gridFiltering( curPoint, centroid, count, gridSize, cellIndex );
+      }
+      if ( otherClusterPointCount ) {
+        double dist2 = ( ( curVector * count - centroid ).getNorm2() ) / static_cast<double>( count ) + 0.5;
+        if ( dist2 >= ( std::max )( static_cast<int>( params.thresholdSmoothing_ ), count ) * 2 ) {
+          centroid = centroid / static_cast<double>( count ) + 0.5;
+          for ( size_t k = 0; k < 3; ++k ) { centroid[k] = double( int64_t( centroid[k] ) ); }
+          reconstruct[c] = centroid;
+          if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( c, POINT_SMOOTH ); }
+          reconstruct.setBoundaryPointType( c, static_cast<uint16_t>( 3 ) );
+        }
+      }
+    } );
+  } );
   TRACE_CODEC( "%s \n", "smoothPointCloudGrid done" );
 }
 
@@ -1107,24 +1352,30 @@ void PCCCodec::smoothPointCloud( PCCPointSet3&                      reconstruct,
                                  const std::vector<uint32_t>&       partition,
                                  const GeneratePointCloudParameters params ) {
   TRACE_CODEC( "%s \n", "smoothPointCloud start" );
+  // Double buffered: the neighbours are searched in a position-only snapshot of the frame, so the smoothed positions
+  // are written into reconstruct as they are computed.
   const size_t pointCount = reconstruct.getPointCount();
-  PCCKdTree    kdtree( reconstruct );
-  PCCPointSet3 temp;
-  temp.resize( pointCount );
-  tbb::task_arena limited( static_cast<int>( params.nbThread_ ) );
-  limited.execute( [&] {
+  PCCPointSet3 source;
+  reconstruct.copyPositionsAndColors( source, false );
+  PCCKdTree kdtree( source );
+  executionContext_->execute( [&] {
     tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
-      const size_t clusterindex_ = partition[i];
-      PCCNNResult  result;
-      kdtree.searchRadius( reconstruct[i], params.neighborCountSmoothing_, params.radius2Smoothing_, result );
-      PCCVector3D centroid( 0.0 );
-      bool        otherClusterPointCount = false;
-      size_t      neighborCount          = 0;
-      for ( size_t r = 0; r < result.count(); ++r ) {
-        const double& dist2 = result.dist( r );
+      const size_t                              clusterindex_ = partition[i];
+      auto&                                     threadArena   = getThreadArena();
+      PCCArenaScope                             pointScope( threadArena );
+      PCCArenaVector<std::pair<size_t, double>> result{PCCArenaAllocator<std::pair<size_t, double>>( threadArena )};
+      kdtree.searchRadius( source[i], params.neighborCountSmoothing_, params.radius2Smoothing_, result );
+      // The positions are integers, so is their sum: the centroid and the distance to it are accumulated in int64,
+      // which gives the values the double accumulation rounded to, without the conversions.
+      int64_t centroid[3]            = {0, 0, 0};
+      bool    otherClusterPointCount = false;
+      int64_t neighborCount          = 0;
+      for ( const auto& neighbor : result ) {
+        const double& dist2 = neighbor.second;
         ++neighborCount;
-        const size_t pointindex_ = result.indices( r );
-        centroid += reconstruct[pointindex_];
+        const size_t      pointindex_ = neighbor.first;
+        const PCCPoint3D& point       = source[pointindex_];
+        for ( size_t k = 0; k < 3; ++k ) { centroid[k] += point[k]; }
         otherClusterPointCount |=
             ( dist2 <= params.radius2BoundaryDetection_ ) && ( partition[pointindex_] != clusterindex_ );
       }
@@ -1132,63 +1383,32 @@ void PCCCodec::smoothPointCloud( PCCPointSet3&                      reconstruct,
         if ( reconstruct.getBoundaryPointType( i ) == 1 ) {
           reconstruct.setBoundaryPointType( i, static_cast<uint16_t>( 2 ) );
         }
-        const PCCVector3D scaledPoint =
-            double( neighborCount ) * PCCVector3D( reconstruct[i][0], reconstruct[i][1], reconstruct[i][2] );
-        const double distToCentroid2 =
-            int64_t( ( centroid - scaledPoint ).getNorm2() + ( neighborCount / 2.0 ) ) / double( neighborCount );
+        int64_t norm2 = 0;
         for ( size_t k = 0; k < 3; ++k ) {
-          centroid[k] = double( int64_t( ( centroid[k] + ( neighborCount / 2 ) ) / neighborCount ) );
+          const int64_t diff = centroid[k] - neighborCount * source[i][k];
+          norm2 += diff * diff;
         }
+        const double distToCentroid2 = double( norm2 + neighborCount / 2 ) / double( neighborCount );
         if ( distToCentroid2 >= params.thresholdSmoothing_ ) {
-          temp[i] = centroid;
+          for ( size_t k = 0; k < 3; ++k ) {
+            reconstruct[i][k] = static_cast<int16_t>( ( centroid[k] + neighborCount / 2 ) / neighborCount );
+          }
           reconstruct.setColor( i, PCCColor3B( 255, 0, 0 ) );
           if ( PCC_SAVE_POINT_TYPE == 1 ) { reconstruct.setType( i, POINT_SMOOTH ); }
-        } else {
-          temp[i] = reconstruct[i];
         }
-      } else {
-        temp[i] = reconstruct[i];
       }
     } );
   } );
-  limited.execute(
-      [&] { tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) { reconstruct[i] = temp[i]; } ); } );
   TRACE_CODEC( "%s \n", "smoothPointCloud done" );
 }
 
-void PCCCodec::addGridColorCentroid( PCCPoint3D&                             point,
-                                     PCCVector3D&                            color,
-                                     std::pair<size_t, size_t>               tilePatchIdx,
-                                     std::vector<uint16_t>&                  colorGridCount,
-                                     std::vector<PCCVector3<float>>&         colorCenter,
-                                     std::vector<std::pair<size_t, size_t>>& colorPartition,
-                                     std::vector<bool>&                      colorDoSmooth,
-                                     uint8_t                                 gridSize,
-                                     std::vector<std::vector<uint16_t>>&     colorLum,
-                                     const GeneratePointCloudParameters&     params,
-                                     int                                     cellId ) {
-  if ( colorGridCount[cellId] == 0 ) {
-    colorPartition[cellId] = tilePatchIdx;
-    colorCenter[cellId]    = {0., 0., 0.};
-    colorDoSmooth[cellId]  = false;
-  } else if ( !colorDoSmooth[cellId] && colorPartition[cellId] != tilePatchIdx ) {
-    colorDoSmooth[cellId] = true;
-  }
-  colorCenter[cellId] += PCCVector3<float>( color );
-  colorGridCount[cellId]++;
-  colorLum[cellId].push_back( uint16_t( color[0] ) );
-}
-
-bool PCCCodec::gridFilteringColor( PCCPoint3D&                         curPos,
+bool PCCCodec::gridFilteringColor( const PCCPoint3D&                   curPos,
                                    PCCVector3D&                        colorCentroid,
                                    int&                                colorCount,
-                                   std::vector<uint16_t>&              colorGridCount,
-                                   std::vector<PCCVector3<float>>&     colorCenter,
-                                   std::vector<bool>&                  colorDoSmooth,
                                    uint8_t                             gridSize,
-                                   PCCVector3D&                        curPosColor,
+                                   const PCCVector3D&                  curPosColor,
                                    const GeneratePointCloudParameters& params,
-                                   std::vector<int>&                   cellIndex ) {
+                                   const std::vector<int>&             cellIndex ) const {
   int             idx[2][2][2];
   const int       w                      = pow( 2, params.geometryBitDepth3D_ ) / gridSize;
   bool            otherClusterPointCount = false;
@@ -1200,10 +1420,9 @@ bool PCCCodec::gridFilteringColor( PCCPoint3D&                         curPos,
   for ( int dz = 0; dz < 2; dz++ ) {
     for ( int dy = 0; dy < 2; dy++ ) {
       for ( int dx = 0; dx < 2; dx++ ) {
-        idx[dz][dy][dx] = ( S[0] + dx ) + ( S[1] + dy ) * w + ( S[2] + dz ) * w * w;
-        if ( colorDoSmooth[cellIndex[idx[dz][dy][dx]]] && ( colorGridCount[cellIndex[idx[dz][dy][dx]]] != 0U ) ) {
-          otherClusterPointCount = true;
-        }
+        idx[dz][dy][dx]  = ( S[0] + dx ) + ( S[1] + dy ) * w + ( S[2] + dz ) * w * w;
+        const auto& cell = colorSmoothingCells_[cellIndex[idx[dz][dy][dx]]];
+        if ( cell.doSmooth_ && ( cell.count_ != 0U ) ) { otherClusterPointCount = true; }
       }
     }
   }
@@ -1212,35 +1431,24 @@ bool PCCCodec::gridFilteringColor( PCCPoint3D&                         curPos,
   PCCVector3<int> W                       = ( P - S2 - gridSize / 2 ) * 2 + 1;
   PCCVector3D     colorCentroid3[2][2][2] = {};
   const int       gridSize2               = gridSize * 2;
-  const double    mmThresh                = params.thresholdColorVariation_ * 256.0;
   const double    yThresh                 = params.thresholdColorDifference_ * 256.0;
   double          Y0                      = 0;
   for ( int dz = 0; dz < 2; dz++ ) {
     for ( int dy = 0; dy < 2; dy++ ) {
       for ( int dx = 0; dx < 2; dx++ ) {
-        int   index = cellIndex[idx[dz][dy][dx]];
-        auto& dst   = colorCentroid3[dz][dy][dx];
-        if ( colorGridCount[index] > 0 ) {
-          for ( size_t c = 0; c < 3; c++ ) {
-            dst[c] = double( colorCenter[index][c] ) / double( colorGridCount[index] );
-          }
+        const auto& cell = colorSmoothingCells_[cellIndex[idx[dz][dy][dx]]];
+        auto&       dst  = colorCentroid3[dz][dy][dx];
+        if ( cell.count_ > 0 ) {
+          for ( size_t c = 0; c < 3; c++ ) { dst[c] = double( cell.center_[c] ) / double( cell.count_ ); }
           if ( dx == 0 && dy == 0 && dz == 0 ) {
-            if ( colorGridCount[index] > 1 ) {
-              double meanY   = mean( colorSmoothingLum_[index], int( colorGridCount[index] ) );
-              double medianY = median( colorSmoothingLum_[index], int( colorGridCount[index] ) );
-              if ( abs( meanY - medianY ) > mmThresh ) {
-                colorCentroid = curPosColor;
-                colorCount    = 1;
-                return otherClusterPointCount;
-              }
+            if ( cell.lumOutlier_ ) {
+              colorCentroid = curPosColor;
+              colorCount    = 1;
+              return otherClusterPointCount;
             }
           } else {
             if ( abs( Y0 - dst[0] ) > yThresh ) { dst = curPosColor; }
-            if ( colorGridCount[index] > 1 ) {
-              double meanY   = mean( colorSmoothingLum_[index], int( colorGridCount[index] ) );
-              double medianY = median( colorSmoothingLum_[index], int( colorGridCount[index] ) );
-              if ( abs( meanY - medianY ) > mmThresh ) { dst = curPosColor; }
-            }
+            if ( cell.lumOutlier_ ) { dst = curPosColor; }
           }
         } else {
           dst = curPosColor;
@@ -1271,38 +1479,41 @@ void PCCCodec::smoothPointCloudColorLC( PCCPointSet3&                       reco
   const size_t pointCount = reconstruct.getPointCount();
   const int    gridSize   = params.occupancyPrecision_;
   const int    disth      = ( std::max )( gridSize / 2, 1 );
-  for ( int i = 0; i < pointCount; i++ ) {
-    PCCPoint3D curPos    = reconstruct[i];
-    int        x         = curPos.x();
-    int        y         = curPos.y();
-    int        z         = curPos.z();
-    int        pcMaxSize = pow( 2, params.geometryBitDepth3D_ );
-    if ( x < disth || y < disth || z < disth || pcMaxSize <= x + disth || pcMaxSize <= y + disth ||
-         pcMaxSize <= z + disth ) {
-      continue;
-    }
-    PCCVector3D colorCentroid( 0.0 );
-    int         colorCount             = 0;
-    bool        otherClusterPointCount = false;
-    PCCVector3D curPosColor            = reconstruct.getColor16bit( i );
-    if ( reconstruct.getBoundaryPointType( i ) == 1 ) {
-      otherClusterPointCount =
-          gridFilteringColor( curPos, colorCentroid, colorCount, colorSmoothingCount_, colorSmoothingCenter_,
-                              colorSmoothingDoSmooth_, gridSize, curPosColor, params, cellIndex );
-    }
-    if ( otherClusterPointCount ) {
-      colorCentroid = ( colorCentroid + static_cast<double>( colorCount ) / 2.0 ) / static_cast<double>( colorCount );
-      for ( size_t k = 0; k < 3; ++k ) { colorCentroid[k] = double( int64_t( colorCentroid[k] ) ); }
-      double distToCentroid2 = 0;
-      double Ycent           = colorCentroid[0];
-      double Ycur            = curPosColor[0];
-      distToCentroid2        = abs( Ycent - Ycur ) * 10. / 256.;
-      if ( distToCentroid2 >= params.thresholdColorSmoothing_ ) {
-        PCCColor16bit color16bit = colorCentroid;
-        reconstruct.setColor16bit( i, color16bit );
+  const int    pcMaxSize  = pow( 2, params.geometryBitDepth3D_ );
+  // Only the color of the current point is written and the grid cells are read-only here: the points are independent.
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
+      PCCPoint3D curPos = reconstruct[i];
+      int        x      = curPos.x();
+      int        y      = curPos.y();
+      int        z      = curPos.z();
+      if ( x < disth || y < disth || z < disth || pcMaxSize <= x + disth || pcMaxSize <= y + disth ||
+           pcMaxSize <= z + disth ) {
+        return;
       }
-    }
-  }
+      PCCVector3D colorCentroid( 0.0 );
+      int         colorCount             = 0;
+      bool        otherClusterPointCount = false;
+      PCCVector3D curPosColor            = reconstruct.getColor16bit( i );
+      if ( reconstruct.getBoundaryPointType( i ) == 1 ) {
+        otherClusterPointCount =
+            gridFilteringColor( curPos, colorCentroid, colorCount, gridSize, curPosColor, params, cellIndex );
+      }
+      if ( otherClusterPointCount ) {
+        colorCentroid =
+            ( colorCentroid + static_cast<double>( colorCount ) / 2.0 ) / static_cast<double>( colorCount );
+        for ( size_t k = 0; k < 3; ++k ) { colorCentroid[k] = double( int64_t( colorCentroid[k] ) ); }
+        double distToCentroid2 = 0;
+        double Ycent           = colorCentroid[0];
+        double Ycur            = curPosColor[0];
+        distToCentroid2        = abs( Ycent - Ycur ) * 10. / 256.;
+        if ( distToCentroid2 >= params.thresholdColorSmoothing_ ) {
+          PCCColor16bit color16bit = colorCentroid;
+          reconstruct.setColor16bit( i, color16bit );
+        }
+      }
+    } );
+  } );
 }
 
 size_t PCCCodec::colorPointCloud( PCCPointSet3&                       reconstruct,
@@ -1480,16 +1691,16 @@ void PCCCodec::generateRawPointsGeometryfromVideo( PCCContext& context, PCCFrame
     size_t numberOfRawPoints    = rawPointsPatch.getNumberOfRawPoints();
     numberOfRawPoints *= 3;
     rawPointsPatch.resize( numberOfRawPoints );
-    for ( size_t v = 0; v < rawPointsPatch.sizeV_; ++v ) {
+    // gather: every pixel holds one coordinate in raster order, the rows are read in parallel
+    const size_t auxTileLeftTopY = context[frameIndex].getAuxTileLeftTopY( tile.getTileIndex() );
+    tbb::parallel_for( size_t( 0 ), rawPointsPatch.sizeV_, [&]( const size_t v ) {
+      const size_t y = ( v0 + v ) + auxTileLeftTopY;
       for ( size_t u = 0; u < rawPointsPatch.sizeU_; ++u ) {
         const size_t p = v * rawPointsPatch.sizeU_ + u;
-        if ( p < numberOfRawPoints ) {
-          const size_t x       = ( u0 + u );
-          const size_t y       = ( v0 + v ) + context[frameIndex].getAuxTileLeftTopY( tile.getTileIndex() );
-          rawPointsPatch.x_[p] = image.getValue( 0, x, y );
-        }
+        if ( p >= numberOfRawPoints ) { break; }
+        rawPointsPatch.x_[p] = image.getValue( 0, u0 + u, y );
       }
-    }
+    } );
   }
 }
 
@@ -1592,15 +1803,35 @@ void PCCCodec::generateOccupancyMap( PCCFrameContext&      tile,
   size_t v0           = tile.getLeftTopYInFrame() / occupancyPrecision;
   auto&  occupancyMap = tile.getOccupancyMap();
   occupancyMap.resize( width * height, 0 );
-  for ( size_t v = 0; v < height; ++v ) {
-    for ( size_t u = 0; u < width; ++u ) {
-      uint8_t& pixel = videoFrame.getValue( 0, u0 + u / occupancyPrecision, v0 + v / occupancyPrecision );
-      if ( !enhancedOccupancyMapForDepthFlag ) {
-        occupancyMap[v * width + u] = ( pixel > thresholdLossyOM );
-        pixel                       = occupancyMap[v * width + u];
-      } else {
-        occupancyMap[v * width + u] = pixel;
+  if ( enhancedOccupancyMapForDepthFlag ) {
+    for ( size_t v = 0; v < height; ++v ) {
+      auto* dst = occupancyMap.data() + v * width;
+      if ( v % occupancyPrecision != 0 ) {
+        std::copy( dst - width, dst, dst );
+        continue;
       }
+      const uint8_t* src = videoFrame.getRow( 0, v0 + v / occupancyPrecision ) + u0;
+      for ( size_t u = 0, x = 0; u < width; ++x ) {
+        const size_t end = ( std::min )( u + occupancyPrecision, width );
+        std::fill( dst + u, dst + end, src[x] );
+        u = end;
+      }
+    }
+    return;
+  }
+  // The lossy threshold is applied once per video pixel, on 64 pixels at a time, and the thresholded video is then
+  // upsampled to the tile resolution, the rows sharing a video row being copies of the first one. Both steps are
+  // vectorized for 8-bit videos and precisions up to 8.
+  PCCOccupancyBitMap bits;
+  bits.threshold( videoFrame, u0, v0, ( width + occupancyPrecision - 1 ) / occupancyPrecision,
+                  ( height + occupancyPrecision - 1 ) / occupancyPrecision, thresholdLossyOM );
+  bits.copyTo( videoFrame, u0, v0 );
+  for ( size_t v = 0; v < height; ++v ) {
+    auto* dst = occupancyMap.data() + v * width;
+    if ( v % occupancyPrecision != 0 ) {
+      std::copy( dst - width, dst, dst );
+    } else {
+      bits.expandRow( v / occupancyPrecision, occupancyPrecision, dst, width );
     }
   }
 }
@@ -1624,38 +1855,8 @@ void PCCCodec::generateTileBlockToPatchFromOccupancyMapVideo( PCCContext&
                                                               PCCImageOccupancyMap& atlasOccupancyMapImage,
                                                               const size_t          occupancyResolution,
                                                               const size_t          occupancyPrecision ) {
-  auto&        patches            = tile.getPatches();
-  const size_t patchCount         = patches.size();
-  const size_t blockToPatchWidth  = tile.getWidth() / occupancyResolution;
-  const size_t blockToPatchHeight = tile.getHeight() / occupancyResolution;
-  const size_t blockCount         = blockToPatchWidth * blockToPatchHeight;
-  auto&        blockToPatch       = tile.getBlockToPatch();
-  blockToPatch.resize( blockCount );
-  std::fill( blockToPatch.begin(), blockToPatch.end(), 0 );
-  for ( size_t patchIndex = 0; patchIndex < patchCount; ++patchIndex ) {
-    auto&  patch        = patches[patchIndex];
-    size_t nonZeroPixel = 0;
-    for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
-      for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
-        const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
-        nonZeroPixel            = 0;
-        for ( size_t v1 = 0; v1 < patch.getOccupancyResolution(); ++v1 ) {
-          const size_t v = v0 * patch.getOccupancyResolution() + v1;
-          for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
-            const size_t u = u0 * patch.getOccupancyResolution() + u1;
-            size_t       x;
-            size_t       y;
-            patch.patch2Canvas( u, v, tile.getWidth(), tile.getHeight(), x, y );
-            x += tile.getLeftTopXInFrame();
-            y += tile.getLeftTopYInFrame();
-            nonZeroPixel += static_cast<unsigned long long>(
-                atlasOccupancyMapImage.getValue( 0, x / occupancyPrecision, y / occupancyPrecision ) != 0 );
-          }
-        }
-        if ( nonZeroPixel > 0 ) { blockToPatch[blockIndex] = patchIndex + 1; }
-      }
-    }
-  }
+  generateBlockToPatch( tile, atlasOccupancyMapImage, tile.getLeftTopXInFrame(), tile.getLeftTopYInFrame(),
+                        occupancyResolution, occupancyPrecision );
 }
 
 void PCCCodec::generateAtlasBlockToPatchFromOccupancyMapVideo( PCCContext&  context,
@@ -1677,36 +1878,7 @@ void PCCCodec::generateAtlasBlockToPatchFromOccupancyMapVideo( PCCContext&
                                                                PCCImageOccupancyMap& occupancyMapImage,
                                                                const size_t          occupancyResolution,
                                                                const size_t          occupancyPrecision ) {
-  auto&        patches            = titleFrame.getPatches();
-  const size_t patchCount         = patches.size();
-  const size_t blockToPatchWidth  = titleFrame.getWidth() / occupancyResolution;
-  const size_t blockToPatchHeight = titleFrame.getHeight() / occupancyResolution;
-  const size_t blockCount         = blockToPatchWidth * blockToPatchHeight;
-  auto&        blockToPatch       = titleFrame.getBlockToPatch();
-  blockToPatch.resize( blockCount );
-  std::fill( blockToPatch.begin(), blockToPatch.end(), 0 );
-  for ( size_t patchIndex = 0; patchIndex < patchCount; ++patchIndex ) {
-    auto&  patch        = patches[patchIndex];
-    size_t nonZeroPixel = 0;
-    for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
-      for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
-        const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
-        nonZeroPixel            = 0;
-        for ( size_t v1 = 0; v1 < patch.getOccupancyResolution(); ++v1 ) {
-          const size_t v = v0 * patch.getOccupancyResolution() + v1;
-          for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
-            const size_t u = u0 * patch.getOccupancyResolution() + u1;
-            size_t       x;
-            size_t       y;
-            patch.patch2Canvas( u, v, titleFrame.getWidth(), titleFrame.getHeight(), x, y );
-            nonZeroPixel += static_cast<unsigned long long>(
-                occupancyMapImage.getValue( 0, x / occupancyPrecision, y / occupancyPrecision ) != 0 );
-          }
-        }
-        if ( nonZeroPixel > 0 ) { blockToPatch[blockIndex] = patchIndex + 1; }
-      }
-    }
-  }
+  generateBlockToPatch( titleFrame, occupancyMapImage, 0, 0, occupancyResolution, occupancyPrecision );
 }
 
 void PCCCodec::generateBlockToPatchFromOccupancyMapVideo( PCCContext&  context,
@@ -1728,6 +1900,16 @@ void PCCCodec::generateBlockToPatchFromOccupancyMapVideo( PCCContext&
                                                           PCCImageOccupancyMap& occupancyMapImage,
                                                           const size_t          occupancyResolution,
                                                           const size_t          occupancyPrecision ) {
+  generateBlockToPatch( tile, occupancyMapImage, tile.getLeftTopXInFrame(), tile.getLeftTopYInFrame(),
+                        occupancyResolution, occupancyPrecision );
+}
+
+void PCCCodec::generateBlockToPatch( PCCFrameContext&      tile,
+                                     PCCImageOccupancyMap& occupancyMapImage,
+                                     const size_t          xOffset,
+                                     const size_t          yOffset,
+                                     const size_t          occupancyResolution,
+                                     const size_t          occupancyPrecision ) {
   auto&        patches            = tile.getPatches();
   const size_t patchCount         = patches.size();
   const size_t blockToPatchWidth  = tile.getWidth() / occupancyResolution;
@@ -1735,28 +1917,33 @@ void PCCCodec::generateBlockToPatchFromOccupancyMapVideo( PCCContext&
   const size_t blockCount         = blockToPatchWidth * blockToPatchHeight;
   auto&        blockToPatch       = tile.getBlockToPatch();
   blockToPatch.resize( blockCount );
-  std::fill( blockToPatch.begin(), blockToPatch.end(), 0 );
+  blockToPatch.fill( 0 );
+  if ( tile.getWidth() == 0 || tile.getHeight() == 0 ) { return; }
+  const size_t x0 = xOffset / occupancyPrecision;
+  const size_t y0 = yOffset / occupancyPrecision;
+  const size_t x1 = ( std::min )( ( xOffset + tile.getWidth() - 1 ) / occupancyPrecision + 1,
+                                  size_t( occupancyMapImage.getWidth() ) );
+  const size_t y1 = ( std::min )( ( yOffset + tile.getHeight() - 1 ) / occupancyPrecision + 1,
+                                  size_t( occupancyMapImage.getHeight() ) );
+  PCCOccupancyBitMap occupancy;
+  occupancy.threshold( occupancyMapImage, x0, y0, x1 - x0, y1 - y0, 0 );
   for ( size_t patchIndex = 0; patchIndex < patchCount; ++patchIndex ) {
-    auto&  patch        = patches[patchIndex];
-    size_t nonZeroPixel = 0;
+    auto&        patch      = patches[patchIndex];
+    const size_t resolution = patch.getOccupancyResolution();
     for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
       for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
         const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
-        nonZeroPixel            = 0;
-        for ( size_t v1 = 0; v1 < patch.getOccupancyResolution(); ++v1 ) {
-          const size_t v = v0 * patch.getOccupancyResolution() + v1;
-          for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
-            const size_t u = u0 * patch.getOccupancyResolution() + u1;
-            size_t       x;
-            size_t       y;
-            patch.patch2Canvas( u, v, tile.getWidth(), tile.getHeight(), x, y );
-            x += tile.getLeftTopXInFrame();
-            y += tile.getLeftTopYInFrame();
-            nonZeroPixel += static_cast<unsigned long long>(
-                occupancyMapImage.getValue( 0, x / occupancyPrecision, y / occupancyPrecision ) != 0 );
-          }
-        }
-        if ( nonZeroPixel > 0 ) { blockToPatch[blockIndex] = patchIndex + 1; }
+        // the patch orientations map the first and the last pixels of the block onto opposite corners of a canvas
+        // block, so the block pixels are the rectangle they span.
+        size_t xa, ya, xb, yb;
+        patch.patch2Canvas( u0 * resolution, v0 * resolution, tile.getWidth(), tile.getHeight(), xa, ya );
+        patch.patch2Canvas( u0 * resolution + resolution - 1, v0 * resolution + resolution - 1, tile.getWidth(),
+                            tile.getHeight(), xb, yb );
+        const size_t bx0 = ( ( std::min )( xa, xb ) + xOffset ) / occupancyPrecision - x0;
+        const size_t by0 = ( ( std::min )( ya, yb ) + yOffset ) / occupancyPrecision - y0;
+        const size_t bx1 = ( std::min )( ( ( std::max )( xa, xb ) + xOffset ) / occupancyPrecision - x0 + 1, x1 - x0 );
+        const size_t by1 = ( std::min )( ( ( std::max )( ya, yb ) + yOffset ) / occupancyPrecision - y0 + 1, y1 - y0 );
+        if ( occupancy.count( bx0, by0, bx1, by1 ) > 0 ) { blockToPatch.set( blockIndex, patchIndex + 1 ); }
       }
     }
   }
@@ -34,6 +34,8 @@
 #include "PCCFrameContext.h"
 #include "PCCVideo.h"
 #include "PCCContext.h"
+#include "PCCPatch.h"
+#include "PCCMemoryAccounting.h"
 #include "MD5.h"
 
 using namespace pcc;
@@ -42,6 +44,12 @@ PCCContext::PCCContext() = default;
 
 PCCContext::~PCCContext() { atlasContexts_.clear(); }
 
+void PCCContext::reset() {
+  PCCHighLevelSyntax::reset();
+  for ( auto& atlas : atlasContexts_ ) { atlas.reset(); }
+  atlasIndex_ = 0;
+}
+
 void PCCContext::resizeAtlas( size_t size ) {
   atlasContexts_.resize( size );
   for ( int atlIdx = 0; atlIdx < size; atlIdx++ ) { atlasContexts_[atlIdx].setAtlasIndex( atlIdx ); }
@@ -56,6 +64,19 @@ PCCAtlasContext::~PCCAtlasContext() {
   unionPatch_.clear();
 }
 
+void PCCAtlasContext::reset() {
+  for ( auto& frameContext : frameContexts_ ) {
+    for ( auto& tile : frameContext.getTiles() ) { patchPool_.release( tile.getPatches() ); }
+    patchPool_.release( frameContext.getTitleFrameContext().getPatches() );
+  }
+  frameContexts_.clear();
+  framesInAFPS_.clear();
+  subContexts_.clear();
+  unionPatch_.clear();
+  log2MaxAtlasFrameOrderCntLsb_ = 4;
+  resetVideoFrames();
+}
+
 void PCCAtlasContext::resize( size_t size, size_t frameStart ) {
   frameContexts_.resize( size );
   for ( size_t i = frameStart; i < size + frameStart; i++ ) { frameContexts_[i].setAtlasFrameIndex( i ); }
@@ -108,6 +129,26 @@ void PCCAtlasContext::printBlockToPatch( const size_t occupancyResolution ) {
   }
 }
 
+void PCCAtlasContext::getMemoryUsage( PCCMemoryUsage& usage ) const {
+  size_t videos = occFrames_.getMemorySize() + geoAuxFrames_.getMemorySize();
+  for ( const auto& video : geoFrames_ ) { videos += video.getMemorySize(); }
+  for ( const auto& attribute : attrFrames_ ) {
+    for ( const auto& partition : attribute ) {
+      for ( const auto& video : partition ) { videos += video.getMemorySize(); }
+    }
+  }
+  for ( const auto& attribute : attrAuxFrames_ ) {
+    for ( const auto& video : attribute ) { videos += video.getMemorySize(); }
+  }
+  usage.add( MEMORY_VIDEO, videos );
+  for ( const auto& frameContext : frameContexts_ ) { frameContext.getMemoryUsage( usage ); }
+  size_t patches = 0;
+  for ( const auto& patch : unionPatch_ ) {
+    for ( const auto& entry : patch ) { patches += sizeof( entry ) + entry.second.getMemorySize(); }
+  }
+  usage.add( MEMORY_PATCH, patches + patchPool_.getMemorySize() );
+}
+
 void PCCAtlasContext::allocateVideoFrames( PCCHighLevelSyntax& syntax, size_t numFrames ) {
   // syntax elements values
   size_t attrCount     = syntax.getVps().getAttributeInformation( atlasIndex_ ).getAttributeCount();
@@ -224,6 +265,20 @@ void PCCAtlasContext::clearVideoFrames() {
   attrAuxFrames_.clear();
 }
 
+void PCCAtlasContext::resetVideoFrames() {
+  occFrames_.reset();
+  for ( auto& geoFrames : geoFrames_ ) { geoFrames.reset(); }
+  geoAuxFrames_.reset();
+  for ( auto& attrFrames : attrFrames_ ) {
+    for ( auto& partFrames : attrFrames ) {
+      for ( auto& mapFrames : partFrames ) { mapFrames.reset(); }
+    }
+  }
+  for ( auto& attrAuxFrame : attrAuxFrames_ ) {
+    for ( auto& partFrames : attrAuxFrame ) { partFrames.reset(); }
+  }
+}
+
 std::vector<uint8_t> PCCContext::computeMD5( uint8_t* byteString, size_t len ) {
   MD5                  md5Hash;
   std::vector<uint8_t> tmp_digest;
@@ -255,6 +310,11 @@ uint32_t PCCContext::computeCheckSum( uint8_t* byteString, size_t len ) {
   return checkSum;
 }
 
+void PCCContext::getMemoryUsage( PCCMemoryUsage& usage ) const {
+  for ( const auto& atlas : atlasContexts_ ) { atlas.getMemoryUsage( usage ); }
+  usage.add( MEMORY_BITSTREAM, getVideoBitstreamMemorySize() );
+}
+
 void PCCContext::allocOneLayerData() {
   printf( "Alloc One layer deata \n" );
   fflush( stdout );
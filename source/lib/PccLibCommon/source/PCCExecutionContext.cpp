@@ -0,0 +1,124 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+// Arena-local observers are part of the library but still flagged as a preview in TBB 2017.
+#define TBB_PREVIEW_LOCAL_OBSERVER 1
+#include "PCCCommon.h"
+#include "PCCExecutionContext.h"
+#include "tbb/task_scheduler_observer.h"
+#include "tbb/atomic.h"
+#if defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace pcc {
+
+// Pins every worker thread that joins the arena to the next core of the list, then runs the worker setup.
+class PCCThreadPinning : public tbb::task_scheduler_observer {
+ public:
+  PCCThreadPinning( tbb::task_arena& arena, const std::vector<int>& cores, const std::function<void()>& setup ) :
+      tbb::task_scheduler_observer( arena ), cores_( cores ), setup_( setup ) {
+    next_ = 0;
+    observe( true );
+  }
+  ~PCCThreadPinning() { observe( false ); }
+
+  void on_scheduler_entry( bool isWorker ) override {
+    if ( !isWorker ) { return; }
+#if defined( __linux__ )
+    if ( !cores_.empty() ) {
+      cpu_set_t set;
+      CPU_ZERO( &set );
+      CPU_SET( cores_[( next_++ ) % cores_.size()], &set );
+      pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+    }
+#endif
+    if ( setup_ ) { setup_(); }
+  }
+
+ private:
+  std::vector<int>      cores_;
+  std::function<void()> setup_;
+  tbb::atomic<size_t>   next_;
+};
+
+}  // namespace pcc
+
+using namespace pcc;
+
+static std::vector<int> parseCoreList( const std::string& affinity ) {
+  std::vector<int>  cores;
+  std::stringstream list( affinity );
+  std::string       range;
+  while ( std::getline( list, range, ',' ) ) {
+    if ( range.empty() ) { continue; }
+    const size_t dash  = range.find( '-' );
+    const int    first = std::stoi( range.substr( 0, dash ) );
+    const int    last  = dash == std::string::npos ? first : std::stoi( range.substr( dash + 1 ) );
+    for ( int core = first; core <= last; core++ ) { cores.push_back( core ); }
+  }
+  return cores;
+}
+
+PCCExecutionContext::PCCExecutionContext() : users_( 0 ), nbThread_( 0 ) {}
+PCCExecutionContext::~PCCExecutionContext() {
+  pinning_.reset();
+  arena_.terminate();
+}
+
+void PCCExecutionContext::initialize( size_t nbThread, const std::string& affinity ) {
+  if ( arena_.is_active() && nbThread == nbThread_ && affinity == affinity_ ) { return; }
+  pinning_.reset();
+  arena_.terminate();
+  nbThread_ = nbThread;
+  affinity_ = affinity;
+  arena_.initialize( nbThread_ > 0 ? static_cast<int>( nbThread_ ) : static_cast<int>( tbb::task_arena::automatic ) );
+  std::vector<int> cores;
+  try {
+    cores = parseCoreList( affinity_ );
+  } catch ( const std::exception& ) {
+    std::cerr << "Error: invalid thread affinity \"" << affinity_ << "\", threads are not pinned" << std::endl;
+    cores.clear();
+  }
+  if ( !cores.empty() || workerSetup_ ) { pinning_.reset( new PCCThreadPinning( arena_, cores, workerSetup_ ) ); }
+}
+
+void PCCExecutionContext::enter( size_t nbThread, const std::string& affinity ) {
+  std::lock_guard<std::mutex> lock( usersMutex_ );
+  if ( users_++ == 0 ) { initialize( nbThread, affinity ); }
+}
+
+void PCCExecutionContext::leave() {
+  std::lock_guard<std::mutex> lock( usersMutex_ );
+  if ( --users_ == 0 ) { releaseThreadArenas(); }
+}
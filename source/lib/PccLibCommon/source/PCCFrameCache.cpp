@@ -0,0 +1,150 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+#include "PCCPointSet.h"
+#include "PCCFrameCache.h"
+
+using namespace pcc;
+
+static const char   g_frameCacheMagic[8]  = { 'P', 'C', 'C', 'F', 'R', 'M', 'C', '1' };
+static const size_t g_frameCacheHeader    = sizeof( g_frameCacheMagic ) + 2 * sizeof( uint64_t );
+static const size_t g_frameCacheIndexSize = 2 * sizeof( uint64_t );
+static const size_t g_frameCacheAlignment = 64;
+static_assert( sizeof( PCCPoint3D ) == 3 * sizeof( int16_t ), "positions are stored as 3 x int16" );
+static_assert( sizeof( PCCColor3B ) == 3 * sizeof( uint8_t ), "colors are stored as 3 x uint8" );
+
+static uint64_t readUInt64( const uint8_t* data ) {
+  uint64_t value;
+  memcpy( &value, data, sizeof( value ) );
+  return value;
+}
+
+bool PCCFrameCache::isFrameCache( const std::string& path ) {
+  if ( path.find( '%' ) != std::string::npos ) { return false; }
+  FILE* file = fopen( path.c_str(), "rb" );
+  if ( file == nullptr ) { return false; }
+  char       magic[sizeof( g_frameCacheMagic )];
+  const bool ret = fread( magic, 1, sizeof( magic ), file ) == sizeof( magic ) &&
+                   memcmp( magic, g_frameCacheMagic, sizeof( magic ) ) == 0;
+  fclose( file );
+  return ret;
+}
+
+bool PCCFrameCache::isFrameCache( const uint8_t* data, const size_t size ) {
+  return size >= g_frameCacheHeader && memcmp( data, g_frameCacheMagic, sizeof( g_frameCacheMagic ) ) == 0;
+}
+
+bool PCCFrameCache::open( const std::string& path ) {
+  frameCount_ = 0;
+  if ( !file_.open( path ) || !isFrameCache( file_.data(), file_.size() ) ) {
+    std::cout << "Error: " << path << " is not a frame cache" << std::endl;
+    return false;
+  }
+  const uint64_t frameCount = readUInt64( file_.data() + sizeof( g_frameCacheMagic ) );
+  if ( frameCount > ( file_.size() - g_frameCacheHeader ) / g_frameCacheIndexSize ) {
+    std::cout << "Error: truncated frame cache " << path << std::endl;
+    return false;
+  }
+  frameCount_       = static_cast<size_t>( frameCount );
+  startFrameNumber_ = static_cast<size_t>( readUInt64( file_.data() + sizeof( g_frameCacheMagic ) + 8 ) );
+  return true;
+}
+
+bool PCCFrameCache::read( const size_t frameNumber, PCCPointSet3& pointSet ) const {
+  if ( !contains( frameNumber ) ) { return false; }
+  const uint8_t* entry      = file_.data() + g_frameCacheHeader + ( frameNumber - startFrameNumber_ ) * g_frameCacheIndexSize;
+  const uint64_t offset     = readUInt64( entry );
+  const uint64_t pointCount = readUInt64( entry + 8 );
+  const uint64_t frameSize  = pointCount * ( sizeof( PCCPoint3D ) + sizeof( PCCColor3B ) );
+  if ( offset > file_.size() || pointCount > file_.size() || frameSize > file_.size() - offset ) { return false; }
+  PCCPointSet3 frame;
+  frame.addColors();
+  frame.resize( static_cast<size_t>( pointCount ) );
+  memcpy( static_cast<void*>( frame.getPositions().data() ), file_.data() + offset, pointCount * sizeof( PCCPoint3D ) );
+  memcpy( static_cast<void*>( frame.getColors().data() ), file_.data() + offset + pointCount * sizeof( PCCPoint3D ),
+          pointCount * sizeof( PCCColor3B ) );
+  pointSet = std::move( frame );
+  return true;
+}
+
+bool PCCFrameCacheWriter::open( const std::string& path, const size_t frameCount, const size_t startFrameNumber ) {
+  close();
+  file_ = fopen( path.c_str(), "wb" );
+  if ( file_ == nullptr ) { return false; }
+  frameCount_ = frameCount;
+  offset_     = g_frameCacheHeader + frameCount * g_frameCacheIndexSize;
+  failed_     = false;
+  index_.clear();
+  index_.reserve( 2 * frameCount );
+  // the index is written again by close()
+  const uint64_t            header[2] = { frameCount, startFrameNumber };
+  const std::vector<uint8_t> index( frameCount * g_frameCacheIndexSize, 0 );
+  failed_ = fwrite( g_frameCacheMagic, sizeof( g_frameCacheMagic ), 1, file_ ) != 1 ||
+            fwrite( header, sizeof( header ), 1, file_ ) != 1 ||
+            ( frameCount > 0 && fwrite( index.data(), index.size(), 1, file_ ) != 1 );
+  return !failed_;
+}
+
+bool PCCFrameCacheWriter::append( const PCCPointSet3& pointSet ) {
+  if ( file_ == nullptr || failed_ || index_.size() == 2 * frameCount_ ) { return false; }
+  const size_t   pointCount = pointSet.getPointCount();
+  const uint64_t padding    = ( g_frameCacheAlignment - offset_ % g_frameCacheAlignment ) % g_frameCacheAlignment;
+  const uint8_t  zeros[g_frameCacheAlignment] = {};
+  if ( padding > 0 && fwrite( zeros, 1, padding, file_ ) != padding ) {
+    failed_ = true;
+    return false;
+  }
+  offset_ += padding;
+  index_.push_back( offset_ );
+  index_.push_back( pointCount );
+  offset_ += pointCount * ( sizeof( PCCPoint3D ) + sizeof( PCCColor3B ) );
+  std::vector<PCCColor3B> colors;
+  if ( !pointSet.hasColors() ) { colors.assign( pointCount, PCCColor3B( uint8_t( 0 ) ) ); }
+  const PCCColor3B* colorData = pointSet.hasColors() ? pointSet.getColors().data() : colors.data();
+  failed_ = pointCount > 0 &&
+            ( fwrite( pointSet.getPositions().data(), sizeof( PCCPoint3D ), pointCount, file_ ) != pointCount ||
+              fwrite( colorData, sizeof( PCCColor3B ), pointCount, file_ ) != pointCount );
+  return !failed_;
+}
+
+bool PCCFrameCacheWriter::close() {
+  if ( file_ == nullptr ) { return false; }
+  bool ret = !failed_ && index_.size() == 2 * frameCount_;
+  if ( ret && frameCount_ > 0 ) {
+    ret = fseek( file_, static_cast<long>( g_frameCacheHeader ), SEEK_SET ) == 0 &&
+          fwrite( index_.data(), sizeof( uint64_t ), index_.size(), file_ ) == index_.size();
+  }
+  ret = fclose( file_ ) == 0 && ret;
+  file_ = nullptr;
+  return ret;
+}
@@ -33,6 +33,7 @@
 #include "PCCCommon.h"
 #include "PCCPatch.h"
 #include "PCCFrameContext.h"
+#include "PCCMemoryAccounting.h"
 
 using namespace pcc;
 
@@ -64,6 +65,7 @@ PCCFrameContext::PCCFrameContext() :
 PCCFrameContext::~PCCFrameContext() {
   pointToPixel_.clear();
   blockToPatch_.clear();
+  occupiedBlocks_.clear();
   occupancyMap_.clear();
   fullOccupancyMap_.clear();
   patches_.clear();
@@ -145,7 +147,7 @@ void PCCFrameContext::allocOneLayerData() {
 }
 
 void PCCFrameContext::printBlockToPatch( const size_t resolution ) {
-  printVector( blockToPatch_, width_ / resolution, height_ / resolution,
+  printVector( blockToPatch_.toVector(), width_ / resolution, height_ / resolution,
                stringFormat( "blockToPatch[%d]", frameIndex_ ), true );
 }
 void PCCFrameContext::printPatch() {
@@ -158,6 +160,32 @@ void PCCFrameContext::printPatch() {
   fflush( stdout );
 }
 
+void PCCFrameContext::getMemoryUsage( PCCMemoryUsage& usage ) const {
+  size_t maps = pointToPixel_.capacity() * sizeof( PCCVector3<size_t> ) + blockToPatch_.getMemorySize() +
+                ( occupancyMap_.capacity() + fullOccupancyMap_.capacity() ) * sizeof( uint32_t );
+  for ( const auto& block : pointToPixelByBlock_ ) { maps += block.capacity() * sizeof( PCCVector3<size_t> ); }
+  for ( const auto& blocks : occupiedBlocks_ ) { maps += blocks.capacity() * sizeof( uint32_t ); }
+  usage.add( MEMORY_BLOCK_TO_PATCH, maps );
+
+  size_t patches = patches_.capacity() * sizeof( PCCPatch ) +
+                   rawPointsPatches_.capacity() * sizeof( PCCRawPointsPatch ) +
+                   eomPatches_.capacity() * sizeof( PCCEomPatch );
+  for ( const auto& patch : patches_ ) { patches += patch.getMemorySize(); }
+  for ( const auto& patch : rawPointsPatches_ ) {
+    patches += ( patch.occupancy_.capacity() + 7 ) / 8 +
+               ( patch.x_.capacity() + patch.y_.capacity() + patch.z_.capacity() + patch.r_.capacity() +
+                 patch.g_.capacity() + patch.b_.capacity() ) *
+                   sizeof( uint16_t );
+  }
+  usage.add( MEMORY_PATCH, patches );
+
+  size_t points = ( rawAttributes_.capacity() + eomAttributes_.capacity() ) * sizeof( PCCColor3B );
+  for ( const auto& cloud : srcPointCloudByPatch_ ) { points += cloud.getMemorySize(); }
+  for ( const auto& cloud : srcPointCloudByBlock_ ) { points += cloud.getMemorySize(); }
+  for ( const auto& cloud : recPointCloudByBlock_ ) { points += cloud.getMemorySize(); }
+  usage.add( MEMORY_POINT_SET, points );
+}
+
 void PCCFrameContext::printPatchDecoder() {
   size_t index = 0;
   printf( "Patch %4zu:", patches_.size() );
@@ -0,0 +1,271 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+#include "PCCPointSet.h"
+#include "PCCFrameRing.h"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#if !_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined( __linux__ )
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace pcc;
+
+static const char   g_frameRingMagic[8]   = { 'P', 'C', 'C', 'R', 'I', 'N', 'G', '1' };
+static const size_t g_frameRingHeader     = 64;
+static const size_t g_frameRingSlotHeader = 64;
+static const size_t g_publishedOffset     = 32;
+static_assert( sizeof( PCCPoint3D ) == 3 * sizeof( int16_t ), "positions are stored as 3 x int16" );
+static_assert( sizeof( PCCColor3B ) == 3 * sizeof( uint8_t ), "colors are stored as 3 x uint8" );
+static_assert( sizeof( std::atomic<uint32_t> ) == sizeof( uint32_t ), "the shared counters are plain uint32" );
+
+struct PCCFrameRingSlot {
+  std::atomic<uint32_t> sequence;
+  uint32_t              padding;
+  uint64_t              frameIndex;
+  uint64_t              pointCount;
+  uint64_t              timestamp;
+};
+
+static std::atomic<uint32_t>* published( uint8_t* data ) {
+  return reinterpret_cast<std::atomic<uint32_t>*>( data + g_publishedOffset );
+}
+
+static uint64_t readUInt64( const uint8_t* data ) {
+  uint64_t value;
+  memcpy( &value, data, sizeof( value ) );
+  return value;
+}
+
+#if _WIN32
+bool PCCFrameRing::create( const std::string& name, const size_t, const size_t ) {
+  std::cout << "Error: no shared memory frame output on this system: " << name << std::endl;
+  return false;
+}
+
+void PCCFrameRing::close() {}
+
+bool PCCFrameRing::publish( const size_t, const PCCPointSet3& ) { return false; }
+
+bool PCCFrameRingReader::open( const std::string& ) { return false; }
+
+void PCCFrameRingReader::close() {}
+
+uint32_t PCCFrameRingReader::getPublished() const { return 0; }
+
+uint32_t PCCFrameRingReader::wait( const uint32_t seen, const int ) const { return seen; }
+
+bool PCCFrameRingReader::read( const uint32_t, PCCPointSet3&, size_t&, uint64_t& ) const { return false; }
+#else
+bool PCCFrameRing::create( const std::string& name, const size_t slotCount, const size_t maxPoints ) {
+  close();
+  if ( slotCount == 0 || maxPoints == 0 || maxPoints > UINT32_MAX || slotCount > UINT32_MAX ) { return false; }
+  // slots start on 64-byte boundaries
+  const uint64_t slotSize =
+      ( g_frameRingSlotHeader + maxPoints * ( sizeof( PCCPoint3D ) + sizeof( PCCColor3B ) ) + 63 ) & ~uint64_t( 63 );
+  const size_t size = g_frameRingHeader + slotCount * slotSize;
+  // an object left by an earlier decoder is unlinked rather than resized under its readers, who open the new one
+  shm_unlink( name.c_str() );
+  const int fd = shm_open( name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644 );
+  if ( fd < 0 ) {
+    std::cout << "Error: can't create the shared memory object " << name << std::endl;
+    return false;
+  }
+  void* data = ftruncate( fd, static_cast<off_t>( size ) ) == 0
+                   ? mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 )
+                   : MAP_FAILED;
+  ::close( fd );
+  if ( data == MAP_FAILED ) {
+    std::cout << "Error: can't map " << size << " bytes of shared memory for " << name << std::endl;
+    shm_unlink( name.c_str() );
+    return false;
+  }
+  data_ = static_cast<uint8_t*>( data );
+  size_ = size;
+  name_ = name;
+  const uint32_t counts[2] = { static_cast<uint32_t>( slotCount ), static_cast<uint32_t>( maxPoints ) };
+  memcpy( data_ + 8, counts, sizeof( counts ) );
+  memcpy( data_ + 16, &slotSize, sizeof( slotSize ) );
+  // readers check the magic last
+  std::atomic_thread_fence( std::memory_order_release );
+  memcpy( data_, g_frameRingMagic, sizeof( g_frameRingMagic ) );
+  return true;
+}
+
+void PCCFrameRing::close() {
+  if ( data_ != nullptr ) {
+    munmap( data_, size_ );
+    shm_unlink( name_.c_str() );
+  }
+  data_ = nullptr;
+  size_ = 0;
+  name_.clear();
+}
+
+bool PCCFrameRing::publish( const size_t frameIndex, const PCCPointSet3& pointSet ) {
+  if ( data_ == nullptr ) { return false; }
+  uint32_t slotCount, maxPoints;
+  memcpy( &slotCount, data_ + 8, sizeof( slotCount ) );
+  memcpy( &maxPoints, data_ + 12, sizeof( maxPoints ) );
+  const size_t pointCount = pointSet.getPointCount();
+  if ( pointCount > maxPoints ) {
+    std::cout << "Warning: frame " << frameIndex << " has " << pointCount << " points, more than the "
+              << maxPoints << " of a shared memory slot: not published" << std::endl;
+    return false;
+  }
+  const uint32_t    k    = published( data_ )->load( std::memory_order_relaxed );
+  uint8_t*          base = data_ + g_frameRingHeader + ( k % slotCount ) * readUInt64( data_ + 16 );
+  PCCFrameRingSlot* slot = reinterpret_cast<PCCFrameRingSlot*>( base );
+  const uint32_t    sequence = slot->sequence.load( std::memory_order_relaxed );
+  slot->sequence.store( sequence + 1, std::memory_order_relaxed );
+  std::atomic_thread_fence( std::memory_order_release );
+  slot->frameIndex = frameIndex;
+  slot->pointCount = pointCount;
+  slot->timestamp  = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() )
+          .count() );
+  uint8_t* positions = base + g_frameRingSlotHeader;
+  uint8_t* colors    = positions + size_t( maxPoints ) * sizeof( PCCPoint3D );
+  if ( pointCount > 0 ) {
+    memcpy( positions, pointSet.getPositions().data(), pointCount * sizeof( PCCPoint3D ) );
+    if ( pointSet.hasColors() ) {
+      memcpy( colors, pointSet.getColors().data(), pointCount * sizeof( PCCColor3B ) );
+    } else {
+      memset( colors, 0, pointCount * sizeof( PCCColor3B ) );
+    }
+  }
+  slot->sequence.store( sequence + 2, std::memory_order_release );
+  published( data_ )->store( k + 1, std::memory_order_release );
+#if defined( __linux__ )
+  syscall( SYS_futex, published( data_ ), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0 );
+#endif
+  return true;
+}
+
+bool PCCFrameRingReader::open( const std::string& name ) {
+  close();
+  const int fd = shm_open( name.c_str(), O_RDWR, 0 );
+  if ( fd < 0 ) { return false; }
+  struct stat status;
+  void*       data = fstat( fd, &status ) == 0 && static_cast<size_t>( status.st_size ) >= g_frameRingHeader
+                         ? mmap( nullptr, static_cast<size_t>( status.st_size ), PROT_READ | PROT_WRITE, MAP_SHARED,
+                           fd, 0 )
+                         : MAP_FAILED;
+  ::close( fd );
+  if ( data == MAP_FAILED ) { return false; }
+  data_ = static_cast<uint8_t*>( data );
+  size_ = static_cast<size_t>( status.st_size );
+  uint32_t slotCount, maxPoints;
+  memcpy( &slotCount, data_ + 8, sizeof( slotCount ) );
+  memcpy( &maxPoints, data_ + 12, sizeof( maxPoints ) );
+  const uint64_t slotSize = readUInt64( data_ + 16 );
+  const bool     valid    = memcmp( data_, g_frameRingMagic, sizeof( g_frameRingMagic ) ) == 0 && slotCount > 0 &&
+                     slotSize >= g_frameRingSlotHeader + uint64_t( maxPoints ) * ( sizeof( PCCPoint3D ) + sizeof( PCCColor3B ) ) &&
+                     slotSize <= ( size_ - g_frameRingHeader ) / slotCount;
+  std::atomic_thread_fence( std::memory_order_acquire );
+  if ( !valid ) { close(); }
+  return valid;
+}
+
+void PCCFrameRingReader::close() {
+  if ( data_ != nullptr ) { munmap( data_, size_ ); }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+uint32_t PCCFrameRingReader::getPublished() const {
+  return data_ == nullptr ? 0 : published( data_ )->load( std::memory_order_acquire );
+}
+
+uint32_t PCCFrameRingReader::wait( const uint32_t seen, const int timeoutMs ) const {
+  if ( data_ == nullptr ) { return seen; }
+  const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds( timeoutMs );
+  uint32_t   k;
+  while ( ( k = getPublished() ) == seen ) {
+    const auto left = std::chrono::duration_cast<std::chrono::nanoseconds>( end - std::chrono::steady_clock::now() );
+    if ( left.count() <= 0 ) { break; }
+#if defined( __linux__ )
+    // returns at once if published is no longer seen
+    struct timespec timeout = { static_cast<time_t>( left.count() / 1000000000 ),
+                                static_cast<long>( left.count() % 1000000000 ) };
+    syscall( SYS_futex, published( data_ ), FUTEX_WAIT, seen, &timeout, nullptr, 0 );
+#else
+    usleep( 1000 );
+#endif
+  }
+  return k;
+}
+
+bool PCCFrameRingReader::read( const uint32_t k,
+                               PCCPointSet3&  pointSet,
+                               size_t&        frameIndex,
+                               uint64_t&      timestamp ) const {
+  if ( data_ == nullptr ) { return false; }
+  uint32_t slotCount, maxPoints;
+  memcpy( &slotCount, data_ + 8, sizeof( slotCount ) );
+  memcpy( &maxPoints, data_ + 12, sizeof( maxPoints ) );
+  // only the last slotCount frames are still in the ring
+  const uint32_t count = getPublished();
+  if ( count - k - 1 >= slotCount ) { return false; }
+  const uint8_t*          base = data_ + g_frameRingHeader + ( k % slotCount ) * readUInt64( data_ + 16 );
+  const PCCFrameRingSlot* slot = reinterpret_cast<const PCCFrameRingSlot*>( base );
+  const uint32_t          sequence = slot->sequence.load( std::memory_order_acquire );
+  if ( ( sequence & 1 ) != 0 ) { return false; }
+  const size_t pointCount = static_cast<size_t>( std::min<uint64_t>( slot->pointCount, maxPoints ) );
+  frameIndex              = static_cast<size_t>( slot->frameIndex );
+  timestamp               = slot->timestamp;
+  PCCPointSet3 frame;
+  frame.addColors();
+  frame.resize( pointCount );
+  const uint8_t* positions = base + g_frameRingSlotHeader;
+  memcpy( static_cast<void*>( frame.getPositions().data() ), positions, pointCount * sizeof( PCCPoint3D ) );
+  memcpy( static_cast<void*>( frame.getColors().data() ), positions + size_t( maxPoints ) * sizeof( PCCPoint3D ),
+          pointCount * sizeof( PCCColor3B ) );
+  // the writer came back to the slot while it was copied
+  std::atomic_thread_fence( std::memory_order_acquire );
+  if ( slot->sequence.load( std::memory_order_relaxed ) != sequence ||
+       getPublished() - k - 1 >= slotCount ) {
+    return false;
+  }
+  pointSet = std::move( frame );
+  return true;
+}
+#endif
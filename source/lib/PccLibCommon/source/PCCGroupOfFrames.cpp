@@ -33,13 +33,173 @@
 #include "PCCCommon.h"
 #include "PCCPointSet.h"
 #include "PCCGroupOfFrames.h"
+#include "PCCFrameCache.h"
 #include "tbb/tbb.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 using namespace pcc;
 
+// reads a frame of a printf pattern of PLY files, or of a frame cache if cache is not null
+static bool readFrame( const std::string&      path,
+                       const PCCFrameCache*    cache,
+                       const size_t            frameNumber,
+                       const PCCColorTransform colorTransform,
+                       const bool              readNormals,
+                       PCCPointSet3&           pointSet ) {
+  if ( cache != nullptr ) {
+    if ( !cache->read( frameNumber, pointSet ) ) {
+      std::cout << "Error: no frame " << frameNumber << " in " << path << std::endl;
+      return false;
+    }
+  } else {
+    char fileName[4096];
+    sprintf( fileName, path.c_str(), frameNumber );
+    if ( !pointSet.read( fileName, readNormals ) ) {
+      std::cout << "Error: can't open " << fileName << std::endl;
+      return false;
+    }
+  }
+  if ( colorTransform == COLOR_TRANSFORM_RGB_TO_YCBCR ) { pointSet.convertRGBToYUV(); }
+  return true;
+}
+
+// Frames of a windowed group: read on demand or ahead by the loader thread, freed once no longer acquired.
+class PCCGroupOfFrames::Window {
+ public:
+  Window( const std::string&      path,
+          const size_t            startFrameNumber,
+          const size_t            frameCount,
+          const PCCColorTransform colorTransform,
+          const size_t            windowSize,
+          const bool              readNormals,
+          const bool              isFrameCache ) :
+      path_( path ),
+      startFrameNumber_( startFrameNumber ),
+      colorTransform_( colorTransform ),
+      windowSize_( ( std::max )( windowSize, size_t( 1 ) ) ),
+      readNormals_( readNormals ),
+      frames_( frameCount ),
+      states_( frameCount, FRAME_EMPTY ),
+      pins_( frameCount, 0 ) {
+    if ( isFrameCache ) { cacheOpened_ = cache_.open( path ); }
+    loader_ = std::thread( &Window::prefetch, this );
+  }
+  ~Window() {
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      stop_ = true;
+    }
+    changed_.notify_all();
+    loader_.join();
+  }
+
+  const PCCPointSet3& acquire( const size_t index ) {
+    std::unique_lock<std::mutex> lock( mutex_ );
+    changed_.wait( lock, [&] { return states_[index] != FRAME_LOADING; } );
+    pins_[index]++;
+    if ( states_[index] != FRAME_LOADED ) { load( index, lock ); }
+    for ( size_t i = index + 1; i < index + windowSize_ && i < frames_.size(); i++ ) {
+      if ( states_[i] == FRAME_EMPTY ) {
+        states_[i] = FRAME_QUEUED;
+        queue_.push_back( i );
+      }
+    }
+    changed_.notify_all();
+    return frames_[index];
+  }
+
+  void release( const size_t index ) {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    assert( pins_[index] > 0 );
+    if ( --pins_[index] == 0 ) {
+      frames_[index] = PCCPointSet3();
+      states_[index] = FRAME_EMPTY;
+      resident_--;
+      changed_.notify_all();
+    }
+  }
+
+  size_t getMemorySize() {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    size_t                      size = 0;
+    for ( size_t i = 0; i < frames_.size(); i++ ) {
+      if ( states_[i] == FRAME_LOADED ) { size += frames_[i].getMemorySize(); }
+    }
+    return size;
+  }
+
+ private:
+  enum FrameState { FRAME_EMPTY, FRAME_QUEUED, FRAME_LOADING, FRAME_LOADED };
+
+  // reads the frame without holding the lock
+  void load( const size_t index, std::unique_lock<std::mutex>& lock ) {
+    states_[index] = FRAME_LOADING;
+    resident_++;
+    lock.unlock();
+    PCCPointSet3 pointSet;
+    readFrame( path_, cacheOpened_ ? &cache_ : nullptr, startFrameNumber_ + index, colorTransform_, readNormals_,
+               pointSet );
+    lock.lock();
+    frames_[index] = std::move( pointSet );
+    states_[index] = FRAME_LOADED;
+    changed_.notify_all();
+  }
+
+  // a queued frame is dropped if the window is full; its next acquisition reads it
+  void prefetch() {
+    std::unique_lock<std::mutex> lock( mutex_ );
+    while ( true ) {
+      changed_.wait( lock, [&] { return stop_ || !queue_.empty(); } );
+      if ( stop_ ) { return; }
+      const size_t index = queue_.front();
+      queue_.pop_front();
+      if ( states_[index] != FRAME_QUEUED ) { continue; }
+      if ( resident_ >= windowSize_ ) {
+        states_[index] = FRAME_EMPTY;
+        continue;
+      }
+      load( index, lock );
+    }
+  }
+
+  const std::string         path_;
+  const size_t              startFrameNumber_;
+  const PCCColorTransform   colorTransform_;
+  const size_t              windowSize_;
+  const bool                readNormals_;
+  PCCFrameCache             cache_;
+  bool                      cacheOpened_ = false;
+  std::vector<PCCPointSet3> frames_;
+  std::vector<FrameState>   states_;
+  std::vector<size_t>       pins_;
+  size_t                    resident_ = 0;
+  std::deque<size_t>        queue_;
+  bool                      stop_ = false;
+  std::mutex                mutex_;
+  std::condition_variable   changed_;
+  std::thread               loader_;
+};
+
 PCCGroupOfFrames::PCCGroupOfFrames() = default;
 PCCGroupOfFrames::PCCGroupOfFrames( size_t value ) { frames_.resize( value ); }
-PCCGroupOfFrames::~PCCGroupOfFrames() { frames_.clear(); }
+PCCGroupOfFrames::PCCGroupOfFrames( PCCGroupOfFrames&& other ) noexcept = default;
+PCCGroupOfFrames& PCCGroupOfFrames::operator=( PCCGroupOfFrames&& other ) noexcept = default;
+PCCGroupOfFrames::~PCCGroupOfFrames() { clear(); }
+
+void PCCGroupOfFrames::clear() {
+  window_.reset();
+  frames_.clear();
+}
+
+size_t PCCGroupOfFrames::getMemorySize() const {
+  if ( window_ ) { return window_->getMemorySize(); }
+  size_t size = 0;
+  for ( const auto& frame : frames_ ) { size += frame.getMemorySize(); }
+  return size;
+}
 
 bool PCCGroupOfFrames::load( const std::string&      uncompressedDataPath,
                              const size_t            startFrameNumber,
@@ -48,38 +208,88 @@ bool PCCGroupOfFrames::load( const std::string&      uncompressedDataPath,
                              const bool              readNormals,
                              const size_t            nbThread ) {
   if ( endFrameNumber < startFrameNumber ) { return false; }
-  const size_t frameCount = endFrameNumber - startFrameNumber;
+  size_t        frameCount   = endFrameNumber - startFrameNumber;
+  const bool    isFrameCache = PCCFrameCache::isFrameCache( uncompressedDataPath );
+  PCCFrameCache cache;
+  if ( isFrameCache ) {
+    if ( !cache.open( uncompressedDataPath ) ) { return false; }
+    // the group ends at the last frame of the cache, as at the first missing file
+    frameCount = !cache.contains( startFrameNumber )
+                     ? 0
+                     : ( std::min )( frameCount,
+                                     cache.getStartFrameNumber() + cache.getFrameCount() - startFrameNumber );
+  }
   frames_.resize( frameCount );
-  tbb::task_arena limited( static_cast<int>( nbThread ) );
+  tbb::task_arena limited( nbThread > 0 ? static_cast<int>( nbThread ) : tbb::task_arena::automatic );
   limited.execute( [&] {
-    tbb::parallel_for( size_t( startFrameNumber ), endFrameNumber, [&]( const size_t frameNumber ) {
-      char fileName[4096];
-      sprintf( fileName, uncompressedDataPath.c_str(), frameNumber );
+    tbb::parallel_for( startFrameNumber, startFrameNumber + frameCount, [&]( const size_t frameNumber ) {
       auto& pointSet = frames_[frameNumber - startFrameNumber];
       pointSet.resize( 0 );
-      if ( !pointSet.read( fileName, readNormals ) ) {
-        std::cout << "Error: can't open " << fileName << std::endl;
+      if ( !readFrame( uncompressedDataPath, isFrameCache ? &cache : nullptr, frameNumber, colorTransform,
+                       readNormals, pointSet ) ) {
         frames_.resize( frameNumber - startFrameNumber );
-      } else {
-        if ( colorTransform == COLOR_TRANSFORM_RGB_TO_YCBCR ) { pointSet.convertRGBToYUV(); }
       }
     } );
   } );
   return ( startFrameNumber != endFrameNumber );
 }
 
+bool PCCGroupOfFrames::open( const std::string&      uncompressedDataPath,
+                             const size_t            startFrameNumber,
+                             const size_t            endFrameNumber,
+                             const PCCColorTransform colorTransform,
+                             const size_t            windowSize,
+                             const bool              readNormals ) {
+  if ( endFrameNumber < startFrameNumber ) { return false; }
+  clear();
+  // the group ends at the first missing frame, as with load()
+  size_t     frameCount   = 0;
+  const bool isFrameCache = PCCFrameCache::isFrameCache( uncompressedDataPath );
+  if ( isFrameCache ) {
+    PCCFrameCache cache;
+    if ( !cache.open( uncompressedDataPath ) ) { return false; }
+    while ( startFrameNumber + frameCount < endFrameNumber && cache.contains( startFrameNumber + frameCount ) ) {
+      frameCount++;
+    }
+  }
+  for ( ; !isFrameCache && startFrameNumber + frameCount < endFrameNumber; frameCount++ ) {
+    char fileName[4096];
+    sprintf( fileName, uncompressedDataPath.c_str(), startFrameNumber + frameCount );
+    FILE* file = fopen( fileName, "rb" );
+    if ( file == nullptr ) {
+      std::cout << "Error: can't open " << fileName << std::endl;
+      break;
+    }
+    fclose( file );
+  }
+  frames_.resize( frameCount );
+  window_.reset( new Window( uncompressedDataPath, startFrameNumber, frameCount, colorTransform, windowSize,
+                             readNormals, isFrameCache ) );
+  return ( startFrameNumber != endFrameNumber );
+}
+
+const PCCPointSet3& PCCGroupOfFrames::acquire( const size_t index ) const {
+  assert( index < frames_.size() );
+  return window_ ? window_->acquire( index ) : frames_[index];
+}
+
+void PCCGroupOfFrames::release( const size_t index ) const {
+  if ( window_ ) { window_->release( index ); }
+}
+
 bool PCCGroupOfFrames::write( const std::string& reconstructedDataPath,
                               size_t&            frameNumber,
                               const size_t       nbThread,
-                              const bool         isAscii ) {
+                              const bool         isAscii,
+                              const bool         directIO ) {
   bool            ret = true;
-  tbb::task_arena limited( static_cast<int>( nbThread ) );
+  tbb::task_arena limited( nbThread > 0 ? static_cast<int>( nbThread ) : tbb::task_arena::automatic );
   limited.execute( [&] {
     tbb::parallel_for( size_t( 0 ), frames_.size(), [&]( const size_t i ) {
       char  fileName[4096];
       auto& pointSet = frames_[i];
       sprintf( fileName, reconstructedDataPath.c_str(), frameNumber + i );
-      if ( !pointSet.write( fileName, isAscii ) ) { ret = false; }
+      if ( !pointSet.write( fileName, isAscii, directIO ) ) { ret = false; }
     } );
   } );
   frameNumber += frames_.size();
@@ -32,10 +32,38 @@
  */
 
 #include "PCCImage.h"
+#include "PCCSystem.h"
 #include "MD5.h"
+#if !defined( _WIN32 )
+#include <sys/mman.h>
+#endif
 
 using namespace pcc;
 
+void* pcc::allocateImageBuffer( size_t size, size_t alignment ) {
+  void* ptr = nullptr;
+#if defined( _WIN32 )
+  ptr = _aligned_malloc( size, alignment );
+#else
+#if defined( MADV_HUGEPAGE )
+  if ( size >= PCC_IMAGE_LARGE_PAGE && posix_memalign( &ptr, PCC_IMAGE_LARGE_PAGE, size ) == 0 ) {
+    madvise( ptr, size, MADV_HUGEPAGE );
+    return ptr;
+  }
+#endif
+  if ( posix_memalign( &ptr, alignment, size ) != 0 ) { ptr = nullptr; }
+#endif
+  return ptr;
+}
+
+void pcc::freeImageBuffer( void* ptr ) {
+#if defined( _WIN32 )
+  _aligned_free( ptr );
+#else
+  free( ptr );
+#endif
+}
+
 template <typename T, size_t N>
 void PCCImage<T, N>::resize( const size_t sizeU0, const size_t sizeV0, PCCCOLORFORMAT format ) {
   if ( format == PCCCOLORFORMAT::UNKNOWN ) {
@@ -55,6 +83,11 @@ void PCCImage<T, N>::resize( const size_t sizeU0, const size_t sizeV0, PCCCOLORF
   } else {
     for ( auto& channel : channels_ ) { channel.resize( size, 0 ); }
   }
+  for ( size_t c = 0; c < N; c++ ) {
+    shift_[c]       = format_ == PCCCOLORFORMAT::YUV420 && c != 0 ? 1 : 0;
+    planeWidth_[c]  = width_ >> shift_[c];
+    planeHeight_[c] = height_ >> shift_[c];
+  }
 }
 
 template <typename T, size_t N>
@@ -63,7 +96,12 @@ void PCCImage<T, N>::swap( PCCImage<T, N>& image ) {
   std::swap( height_, image.height_ );
   std::swap( format_, image.format_ );
   std::swap( deprecatedColorFormat_, image.deprecatedColorFormat_ );
-  for ( size_t c = 0; c < N; c++ ) { channels_[c].swap( image.channels_[c] ); }
+  for ( size_t c = 0; c < N; c++ ) {
+    channels_[c].swap( image.channels_[c] );
+    std::swap( planeWidth_[c], image.planeWidth_[c] );
+    std::swap( planeHeight_[c], image.planeHeight_[c] );
+    std::swap( shift_[c], image.shift_[c] );
+  }
 }
 
 template <typename T, size_t N>
@@ -155,12 +193,52 @@ bool PCCImage<T, N>::write( std::ofstream& outfile, const size_t nbyte ) {
 
 template <typename T, size_t N>
 bool PCCImage<T, N>::write( const std::string fileName, const size_t nbyte ) {
-  std::ofstream outfile( fileName, std::ios::binary );
-  if ( write( outfile, nbyte ) ) {
-    outfile.close();
-    return true;
+  PCCMappedOutputFile file;
+  if ( !file.open( fileName, getFileSize( nbyte ) ) ) { return false; }
+  bool success = write( file.data(), nbyte );
+  return file.close() && success;
+}
+
+template <typename T, size_t N>
+size_t PCCImage<T, N>::getFileSize( const size_t nbyte ) const {
+  size_t size = 0;
+  for ( const auto& channel : channels_ ) { size += channel.size() * nbyte; }
+  return size;
+}
+
+template <typename T, size_t N>
+bool PCCImage<T, N>::read( const uint8_t*       data,
+                           const size_t         size,
+                           const size_t         sizeU0,
+                           const size_t         sizeV0,
+                           const PCCCOLORFORMAT format,
+                           const size_t         nbyte ) {
+  if ( nbyte != sizeof( T ) && nbyte != 1 ) { return false; }
+  resize( sizeU0, sizeV0, format );
+  if ( size < getFileSize( nbyte ) ) { return false; }
+  for ( auto& channel : channels_ ) {
+    if ( nbyte == sizeof( T ) ) {
+      memcpy( channel.data(), data, channel.size() * sizeof( T ) );
+    } else {
+      for ( size_t i = 0; i < channel.size(); i++ ) { channel[i] = static_cast<T>( data[i] ); }
+    }
+    data += channel.size() * nbyte;
   }
-  return false;
+  return true;
+}
+
+template <typename T, size_t N>
+bool PCCImage<T, N>::write( uint8_t* data, const size_t nbyte ) const {
+  if ( nbyte != sizeof( T ) && nbyte != 1 ) { return false; }
+  for ( const auto& channel : channels_ ) {
+    if ( nbyte == sizeof( T ) ) {
+      memcpy( data, channel.data(), channel.size() * sizeof( T ) );
+    } else {
+      for ( size_t i = 0; i < channel.size(); i++ ) { data[i] = static_cast<uint8_t>( channel[i] ); }
+    }
+    data += channel.size() * nbyte;
+  }
+  return true;
 }
 
 template <typename T, size_t N>
@@ -193,17 +271,25 @@ bool PCCImage<T, N>::read( const std::string    fileName,
                            const size_t         sizeV0,
                            const PCCCOLORFORMAT format,
                            const size_t         nbyte ) {
-  std::ifstream infile( fileName, std::ios::binary );
-  if ( read( infile, sizeU0, sizeV0, format, nbyte ) ) {
-    infile.close();
-    return true;
-  }
-  return false;
+  PCCMappedFile file;
+  return file.open( fileName ) && read( file.data(), file.size(), sizeU0, sizeV0, format, nbyte );
 }
 
 template <typename T, size_t N>
 bool PCCImage<T, N>::copyBlock( size_t top, size_t left, size_t width, size_t height, PCCImage& block ) {
   assert( top >= 0 && left >= 0 && ( width + left ) <= width_ && ( height + top ) <= height_ );
+  if ( isBlockAligned( top, left, width, height, block ) ) {
+    for ( size_t cc = 0; cc < N; cc++ ) {
+      const size_t     shift = shift_[cc];
+      PCCImagePlane<T> src   = getPlane( cc );
+      PCCImagePlane<T> dst   = block.getPlane( cc );
+      for ( size_t v = 0; v < ( height >> shift ); v++ ) {
+        const T* row = src.getRow( ( top >> shift ) + v ) + ( left >> shift );
+        std::copy( row, row + ( width >> shift ), dst.getRow( v ) );
+      }
+    }
+    return true;
+  }
   for ( size_t cc = 0; cc < N; cc++ ) {
     for ( size_t i = top; i < top + height; i++ ) {
       for ( size_t j = left; j < left + width; j++ ) {
@@ -216,6 +302,18 @@ bool PCCImage<T, N>::copyBlock( size_t top, size_t left, size_t width, size_t he
 template <typename T, size_t N>
 bool PCCImage<T, N>::setBlock( size_t top, size_t left, PCCImage& block ) {
   assert( top >= 0 && left >= 0 && ( block.getWidth() + left ) < width_ && ( block.getHeight() + top ) < height_ );
+  if ( isBlockAligned( top, left, block.getWidth(), block.getHeight(), block ) ) {
+    for ( size_t cc = 0; cc < N; cc++ ) {
+      const size_t     shift = shift_[cc];
+      PCCImagePlane<T> src   = block.getPlane( cc );
+      PCCImagePlane<T> dst   = getPlane( cc );
+      for ( size_t v = 0; v < ( block.getHeight() >> shift ); v++ ) {
+        const T* row = src.getRow( v );
+        std::copy( row, row + ( block.getWidth() >> shift ), dst.getRow( ( top >> shift ) + v ) + ( left >> shift ) );
+      }
+    }
+    return true;
+  }
   for ( size_t cc = 0; cc < N; cc++ ) {
     for ( size_t i = top; i < top + block.getHeight(); i++ ) {
       for ( size_t j = left; j < left + block.getWidth(); j++ ) {
@@ -226,6 +324,15 @@ bool PCCImage<T, N>::setBlock( size_t top, size_t left, PCCImage& block ) {
   return true;
 }
 template <typename T, size_t N>
+bool PCCImage<T, N>::isBlockAligned( size_t top, size_t left, size_t width, size_t height, const PCCImage& block ) const {
+  if ( block.format_ != format_ ) { return false; }
+  for ( size_t cc = 0; cc < N; cc++ ) {
+    const size_t mask = ( size_t( 1 ) << shift_[cc] ) - 1;
+    if ( ( ( top | left | width | height ) & mask ) != 0 ) { return false; }
+  }
+  return true;
+}
+template <typename T, size_t N>
 void PCCImage<T, N>::copyFrom( PCCImage& image ) {
   size_t       width         = ( std::min )( width_, image.width_ );
   size_t       height        = ( std::min )( height_, image.height_ );
@@ -268,31 +375,20 @@ void PCCImage<T, N>::convertBitdepth( uint8_t bitdepthInput, uint8_t bitdepthOut
     exit( -1 );
   }
   int bitDiff = (int)bitdepthInput - (int)bitdepthOutput;
-  if ( bitDiff >= 0 ) {
-    if ( msbAlignFlag ) {
-      for ( size_t cc = 0; cc < N; cc++ ) {
-        for ( size_t h = 0; h < height_; h++ ) {
-          for ( size_t w = 0; w < width_; w++ ) { setValue( cc, w, h, ( getValue( cc, w, h ) >> bitDiff ) ); }
-        }
-      }
-    } else {
-      for ( size_t cc = 0; cc < N; cc++ ) {
-        for ( size_t h = 0; h < height_; h++ ) {
-          for ( size_t w = 0; w < width_; w++ ) {
-            setValue( cc, w, h, tMin( getValue( cc, w, h ), ( T )( ( 1 << bitdepthOutput ) - 1 ) ) );
-          }
-        }
-      }
-    }
-  } else {
-    if ( msbAlignFlag ) {
-      for ( size_t cc = 0; cc < N; cc++ ) {
-        for ( size_t h = 0; h < height_; h++ ) {
-          for ( size_t w = 0; w < width_; w++ ) { setValue( cc, w, h, ( getValue( cc, w, h ) << ( -bitDiff ) ) ); }
-        }
+  if ( bitDiff < 0 && !msbAlignFlag ) { return; }  // the values are correct
+  // each sample once, in the resolution of its plane
+  const T maxValue = ( T )( ( 1 << bitdepthOutput ) - 1 );
+  for ( size_t cc = 0; cc < N; cc++ ) {
+    PCCImagePlane<T> plane = getPlane( cc );
+    for ( size_t v = 0; v < plane.getHeight(); v++ ) {
+      T* const row = plane.getRow( v );
+      if ( bitDiff >= 0 && msbAlignFlag ) {
+        for ( size_t u = 0; u < plane.getWidth(); u++ ) { row[u] = row[u] >> bitDiff; }
+      } else if ( bitDiff >= 0 ) {
+        for ( size_t u = 0; u < plane.getWidth(); u++ ) { row[u] = tMin( row[u], maxValue ); }
+      } else {
+        for ( size_t u = 0; u < plane.getWidth(); u++ ) { row[u] = row[u] << ( -bitDiff ); }
       }
-    } else {
-      // do nothing, the vaue is correct
     }
   }
 }
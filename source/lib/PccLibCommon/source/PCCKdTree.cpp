@@ -36,6 +36,7 @@
 #include "PCCKdTree.h"
 
 #include "KDTreeVectorOfVectorsAdaptor.h"
+#include <tbb/tbb.h>
 
 using namespace pcc;
 
@@ -77,3 +78,61 @@ void PCCKdTree::searchRadius( const PCCPoint3D& point,
   results.reserve( retSize );
   for ( const auto& result : ret ) { results.pushBack( result ); }
 }
+
+// nanoflann::RadiusResultSet for an arena vector.
+class PCCArenaRadiusResultSet {
+ public:
+  PCCArenaRadiusResultSet( const double radius, PCCArenaVector<std::pair<size_t, double>>& indicesDists ) :
+      radius_( radius ), indicesDists_( indicesDists ) {
+    init();
+  }
+  inline void   init() { clear(); }
+  inline void   clear() { indicesDists_.clear(); }
+  inline size_t size() const { return indicesDists_.size(); }
+  inline bool   full() const { return true; }
+  inline void   addPoint( const double dist, const size_t index ) {
+    if ( dist < radius_ ) { indicesDists_.emplace_back( index, dist ); }
+  }
+  inline double worstDist() const { return radius_; }
+
+ private:
+  const double                               radius_;
+  PCCArenaVector<std::pair<size_t, double>>& indicesDists_;
+};
+
+void PCCKdTree::searchRadius( const PCCPoint3D&                          point,
+                              const size_t                               num_results,
+                              const double                               radius,
+                              PCCArenaVector<std::pair<size_t, double>>& results ) const {
+  PCCArenaRadiusResultSet resultSet( radius, results );
+  nanoflann::SearchParams params;
+  ( static_cast<KdTreeAdaptor*>( kdtree_ ) )->index->radiusSearchCustomCallback( &point[0], resultSet, params );
+  std::sort( results.begin(), results.end(), nanoflann::IndexDist_Sorter() );
+  if ( results.size() > num_results ) { results.resize( num_results ); }
+}
+
+template <typename T>
+void PCCKdTree::searchBatch( const std::vector<PCCPoint3D>& points,
+                             const size_t                   num_results,
+                             PCCNNBatchResult<T>&           results ) const {
+  auto*        kdtree      = static_cast<KdTreeAdaptor*>( kdtree_ );
+  const size_t queryCount  = points.size();
+  const size_t resultCount = ( std::min )( num_results, kdtree->kdtree_get_point_count() );
+  results.resize( queryCount, resultCount );
+  if ( resultCount == 0 ) { return; }
+  tbb::parallel_for( tbb::blocked_range<size_t>( 0, queryCount, 256 ), [&]( const tbb::blocked_range<size_t>& range ) {
+    std::vector<double> dist( resultCount );
+    for ( size_t i = range.begin(); i < range.end(); ++i ) {
+      kdtree->index->knnSearch( &points[i][0], resultCount, results.indices( i ), dist.data() );
+      T* resultDist = results.dist( i );
+      for ( size_t j = 0; j < resultCount; ++j ) { resultDist[j] = static_cast<T>( dist[j] ); }
+    }
+  } );
+}
+
+template void PCCKdTree::searchBatch<double>( const std::vector<PCCPoint3D>& points,
+                                              const size_t                   num_results,
+                                              PCCNNBatchResult<double>&      results ) const;
+template void PCCKdTree::searchBatch<float>( const std::vector<PCCPoint3D>& points,
+                                             const size_t                   num_results,
+                                             PCCNNBatchResult<float>&       results ) const;
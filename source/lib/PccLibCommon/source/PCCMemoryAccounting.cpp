@@ -0,0 +1,85 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCMemoryAccounting.h"
+
+using namespace pcc;
+
+static const char* g_memoryTagNames[MEMORY_TAG_COUNT] = {"video", "point set", "block to patch", "patch",
+                                                         "bitstream"};
+
+size_t PCCMemoryUsage::getTotal() const {
+  size_t total = 0;
+  for ( size_t tag = 0; tag < MEMORY_TAG_COUNT; tag++ ) { total += bytes_[tag]; }
+  return total;
+}
+
+void PCCMemoryAccounting::sample( const std::string& stage, const PCCMemoryUsage& usage ) {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  auto                        it = stages_.find( stage );
+  if ( it == stages_.end() ) {
+    it = stages_.emplace( stage, Stage() ).first;
+    order_.push_back( stage );
+  }
+  auto&        entry = it->second;
+  const size_t total = usage.getTotal();
+  for ( size_t tag = 0; tag < MEMORY_TAG_COUNT; tag++ ) {
+    entry.peak_.bytes_[tag] = ( std::max )( entry.peak_.bytes_[tag], usage.bytes_[tag] );
+    peak_.bytes_[tag]       = ( std::max )( peak_.bytes_[tag], usage.bytes_[tag] );
+  }
+  entry.peakTotal_ = ( std::max )( entry.peakTotal_, total );
+  entry.count_++;
+  if ( total > peakTotal_ ) {
+    peakTotal_ = total;
+    peakStage_ = stage;
+  }
+}
+
+void PCCMemoryAccounting::trace() {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  if ( order_.empty() ) { return; }
+  const double kB = 1024.;
+  printf( "Memory high-water marks (KB):\n" );
+  printf( "  %-24s", "stage" );
+  for ( auto& name : g_memoryTagNames ) { printf( " %14s", name ); }
+  printf( " %14s\n", "total" );
+  for ( auto& name : order_ ) {
+    auto& entry = stages_[name];
+    printf( "  %-24s", name.c_str() );
+    for ( size_t tag = 0; tag < MEMORY_TAG_COUNT; tag++ ) { printf( " %14.0f", entry.peak_.bytes_[tag] / kB ); }
+    printf( " %14.0f\n", entry.peakTotal_ / kB );
+  }
+  printf( "  %-24s", "peak" );
+  for ( size_t tag = 0; tag < MEMORY_TAG_COUNT; tag++ ) { printf( " %14.0f", peak_.bytes_[tag] / kB ); }
+  printf( " %14.0f (%s)\n", peakTotal_ / kB, peakStage_.c_str() );
+  fflush( stdout );
+}
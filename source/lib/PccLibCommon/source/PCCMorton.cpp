@@ -0,0 +1,103 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCMorton.h"
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define PCC_MORTON_BMI2
+#include <immintrin.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define PCC_TARGET_BMI2
+#else
+#define PCC_TARGET_BMI2 __attribute__( ( target( "bmi2" ) ) )
+#endif
+#endif
+
+using namespace pcc;
+
+#ifdef PCC_MORTON_BMI2
+
+static bool detectBmi2() {
+#if defined( _MSC_VER )
+  int info[4];
+  __cpuid( info, 0 );
+  if ( info[0] < 7 ) { return false; }
+  __cpuidex( info, 7, 0 );
+  return ( info[1] & ( 1 << 8 ) ) != 0;
+#else
+  return __builtin_cpu_supports( "bmi2" ) != 0;
+#endif
+}
+
+static bool useBmi2() {
+  static const bool bmi2 = detectBmi2();
+  return bmi2;
+}
+
+// One pdep per coordinate deposits its 21 bits at every third bit of the code.
+PCC_TARGET_BMI2 static void mortonEncodeBmi2( const PCCPoint3D* points,
+                                              const size_t      count,
+                                              const PCCPoint3D& origin,
+                                              const uint32_t    shift,
+                                              uint64_t*         codes ) {
+  const int32_t x0 = origin.x();
+  const int32_t y0 = origin.y();
+  const int32_t z0 = origin.z();
+  for ( size_t i = 0; i < count; i++ ) {
+    const auto x = static_cast<uint64_t>( ( int32_t( points[i].x() ) - x0 ) >> shift ) & 0x1fffff;
+    const auto y = static_cast<uint64_t>( ( int32_t( points[i].y() ) - y0 ) >> shift ) & 0x1fffff;
+    const auto z = static_cast<uint64_t>( ( int32_t( points[i].z() ) - z0 ) >> shift ) & 0x1fffff;
+    codes[i]     = _pdep_u64( x, 0x1249249249249249 ) | _pdep_u64( y, 0x2492492492492492 ) |
+               _pdep_u64( z, 0x4924924924924924 );
+  }
+}
+
+#endif
+
+void pcc::mortonEncode( const PCCPoint3D* points,
+                        const size_t      count,
+                        const PCCPoint3D& origin,
+                        const uint32_t    shift,
+                        uint64_t*         codes ) {
+#ifdef PCC_MORTON_BMI2
+  if ( useBmi2() ) {
+    mortonEncodeBmi2( points, count, origin, shift, codes );
+    return;
+  }
+#endif
+  for ( size_t i = 0; i < count; i++ ) {
+    codes[i] = mortonEncode( uint32_t( ( int32_t( points[i].x() ) - int32_t( origin.x() ) ) >> shift ),
+                             uint32_t( ( int32_t( points[i].y() ) - int32_t( origin.y() ) ) >> shift ),
+                             uint32_t( ( int32_t( points[i].z() ) - int32_t( origin.z() ) ) >> shift ) );
+  }
+}
@@ -108,6 +108,28 @@ PCCPatch::~PCCPatch() {
   depthMap_.clear();
 };
 
+// The buffer moves to dst, emptied.
+template <typename T>
+static void keepBuffer( std::vector<T>& dst, std::vector<T>& src ) {
+  dst.swap( src );
+  dst.clear();
+}
+
+void PCCPatch::recycle() {
+  PCCPatch patch;
+  keepBuffer( patch.depth_[0], depth_[0] );
+  keepBuffer( patch.depth_[1], depth_[1] );
+  keepBuffer( patch.occupancy_, occupancy_ );
+  keepBuffer( patch.depthEOM_, depthEOM_ );
+  keepBuffer( patch.depth0PCidx_, depth0PCidx_ );
+  keepBuffer( patch.pointLocalReconstructionModeByBlock_, pointLocalReconstructionModeByBlock_ );
+  keepBuffer( patch.neighboringPatches_, neighboringPatches_ );
+  keepBuffer( patch.depthMap_, depthMap_ );
+  keepBuffer( patch.occupancyMap_, occupancyMap_ );
+  keepBuffer( patch.borderPoints_, borderPoints_ );
+  *this = std::move( patch );
+}
+
 void PCCPatch::setViewId( size_t viewId ) {
   viewId_ = viewId;
   // now set the other variables according to the viewId
@@ -137,51 +159,29 @@ void PCCPatch::setViewId( size_t viewId ) {
   }
 }
 PCCPoint3D PCCPatch::canvasTo3D( const size_t x, const size_t y, const uint16_t depth ) const {
-  PCCPoint3D point0;
-  size_t     u = 0, v = 0;
+  const auto transform = getCanvasTransform();
+  return generatePoint( transform.u( x, y ), transform.v( x, y ), depth );
+}
+
+PCCPatchCanvasTransform PCCPatch::getCanvasTransform() const {
+  const int64_t x0    = int64_t( u0_ * occupancyResolution_ );
+  const int64_t y0    = int64_t( v0_ * occupancyResolution_ );
+  const int64_t lastU = int64_t( sizeU0_ * occupancyResolution_ ) - 1;
+  const int64_t lastV = int64_t( sizeV0_ * occupancyResolution_ ) - 1;
   switch ( patchOrientation_ ) {
-    case PATCH_ORIENTATION_DEFAULT:
-      u = x - u0_ * occupancyResolution_;
-      v = y - v0_ * occupancyResolution_;
-      break;
-    case PATCH_ORIENTATION_ROT90:
-      v = ( sizeV0_ * occupancyResolution_ - 1 - ( x - u0_ * occupancyResolution_ ) );
-      u = y - v0_ * occupancyResolution_;
-      break;
-    case PATCH_ORIENTATION_ROT180:
-      u = ( sizeU0_ * occupancyResolution_ - 1 - ( x - u0_ * occupancyResolution_ ) );
-      v = ( sizeV0_ * occupancyResolution_ - 1 - ( y - v0_ * occupancyResolution_ ) );
-      break;
-    case PATCH_ORIENTATION_ROT270:
-      v = x - u0_ * occupancyResolution_;
-      u = ( sizeU0_ * occupancyResolution_ - 1 - ( y - v0_ * occupancyResolution_ ) );
-      break;
-    case PATCH_ORIENTATION_MIRROR:
-      u = ( sizeU0_ * occupancyResolution_ - 1 - ( x - u0_ * occupancyResolution_ ) );
-      v = y - v0_ * occupancyResolution_;
-      break;
-    case PATCH_ORIENTATION_MROT90:
-      v = ( sizeV0_ * occupancyResolution_ - 1 - ( x - u0_ * occupancyResolution_ ) );
-      u = ( sizeU0_ * occupancyResolution_ - 1 - ( y - v0_ * occupancyResolution_ ) );
-      break;
-    case PATCH_ORIENTATION_MROT180:
-      u = x - u0_ * occupancyResolution_;
-      v = ( sizeV0_ * occupancyResolution_ - 1 - ( y - v0_ * occupancyResolution_ ) );
-      break;
+    case PATCH_ORIENTATION_DEFAULT: return {x0, 1, 0, y0, 0, 1};
+    case PATCH_ORIENTATION_ROT90: return {x0 + lastV, 0, -1, y0, 1, 0};
+    case PATCH_ORIENTATION_ROT180: return {x0 + lastU, -1, 0, y0 + lastV, 0, -1};
+    case PATCH_ORIENTATION_ROT270: return {x0, 0, 1, y0 + lastU, -1, 0};
+    case PATCH_ORIENTATION_MIRROR: return {x0 + lastU, -1, 0, y0, 0, 1};
+    case PATCH_ORIENTATION_MROT90: return {x0 + lastV, 0, -1, y0 + lastU, -1, 0};
+    case PATCH_ORIENTATION_MROT180: return {x0, 1, 0, y0 + lastV, 0, -1};
     case PATCH_ORIENTATION_MROT270:
-      v = x - u0_ * occupancyResolution_;
-      u = y - v0_ * occupancyResolution_;
-      break;
     case PATCH_ORIENTATION_SWAP:  // swapAxis
-      v = x - u0_ * occupancyResolution_;
-      u = y - v0_ * occupancyResolution_;
-      break;
+      return {x0, 0, 1, y0, 1, 0};
     default: assert( 0 ); break;
   }
-  point0[normalAxis_]    = generateNormalCoordinate( depth );
-  point0[tangentAxis_]   = ( double( u ) * levelOfDetailX_ + u1_ );
-  point0[bitangentAxis_] = ( double( v ) * levelOfDetailY_ + v1_ );
-  return point0;
+  return {x0, 1, 0, y0, 0, 1};
 }
 
 size_t PCCPatch::patch2Canvas( const size_t u, const size_t v, size_t canvasStride, size_t canvasHeight ) {
@@ -250,51 +250,58 @@ size_t PCCPatch::patch2Canvas( const size_t u,
   return ( x + canvasStride * y );
 }
 
-int PCCPatch::patchBlock2CanvasBlock( const size_t uBlk,
-                                      const size_t vBlk,
-                                      size_t       canvasStrideBlk,
-                                      size_t       canvasHeightBlk,
-                                      const Tile   tile ) const {
-  size_t x, y;
+bool PCCPatch::orientPatchBlock( const size_t uBlk, const size_t vBlk, size_t& x, size_t& y ) const {
   switch ( patchOrientation_ ) {
     case PATCH_ORIENTATION_DEFAULT:
-      x = uBlk + u0_;
-      y = vBlk + v0_;
+      x = uBlk;
+      y = vBlk;
       break;
     case PATCH_ORIENTATION_ROT90:
-      x = ( sizeV0_ - 1 - vBlk ) + u0_;
-      y = uBlk + v0_;
+      x = sizeV0_ - 1 - vBlk;
+      y = uBlk;
       break;
     case PATCH_ORIENTATION_ROT180:
-      x = ( sizeU0_ - 1 - uBlk ) + u0_;
-      y = ( sizeV0_ - 1 - vBlk ) + v0_;
+      x = sizeU0_ - 1 - uBlk;
+      y = sizeV0_ - 1 - vBlk;
       break;
     case PATCH_ORIENTATION_ROT270:
-      x = vBlk + u0_;
-      y = ( sizeU0_ - 1 - uBlk ) + v0_;
+      x = vBlk;
+      y = sizeU0_ - 1 - uBlk;
       break;
     case PATCH_ORIENTATION_MIRROR:
-      x = ( sizeU0_ - 1 - uBlk ) + u0_;
-      y = vBlk + v0_;
+      x = sizeU0_ - 1 - uBlk;
+      y = vBlk;
       break;
     case PATCH_ORIENTATION_MROT90:
-      x = ( sizeV0_ - 1 - vBlk ) + u0_;
-      y = ( sizeU0_ - 1 - uBlk ) + v0_;
+      x = sizeV0_ - 1 - vBlk;
+      y = sizeU0_ - 1 - uBlk;
       break;
     case PATCH_ORIENTATION_MROT180:
-      x = uBlk + u0_;
-      y = ( sizeV0_ - 1 - vBlk ) + v0_;
+      x = uBlk;
+      y = sizeV0_ - 1 - vBlk;
       break;
     case PATCH_ORIENTATION_MROT270:
-      x = vBlk + u0_;
-      y = uBlk + v0_;
+      x = vBlk;
+      y = uBlk;
       break;
     case PATCH_ORIENTATION_SWAP:  // swapAxis
-      x = vBlk + u0_;
-      y = uBlk + v0_;
+      x = vBlk;
+      y = uBlk;
       break;
-    default: return -1; break;
+    default: return false; break;
   }
+  return true;
+}
+
+int PCCPatch::patchBlock2CanvasBlock( const size_t uBlk,
+                                      const size_t vBlk,
+                                      size_t       canvasStrideBlk,
+                                      size_t       canvasHeightBlk,
+                                      const Tile   tile ) const {
+  size_t x, y;
+  if ( !orientPatchBlock( uBlk, vBlk, x, y ) ) { return -1; }
+  x += u0_;
+  y += v0_;
   // checking the results are within canvasHeightBlk boundary (missing y check)
   if ( x >= canvasStrideBlk ) { return -1; }
   if ( y >= canvasHeightBlk ) { return -1; }
@@ -307,12 +314,12 @@ int PCCPatch::patchBlock2CanvasBlock( const size_t uBlk,
   return int( x + canvasStrideBlk * y );
 }
 
-bool PCCPatch::checkFitPatchCanvas( std::vector<bool> canvas,
-                                    size_t            canvasStrideBlk,
-                                    size_t            canvasHeightBlk,
-                                    bool              bPrecedence,
-                                    int               safeguard,
-                                    const Tile        tile ) {
+bool PCCPatch::checkFitPatchCanvas( const std::vector<bool>& canvas,
+                                    size_t                   canvasStrideBlk,
+                                    size_t                   canvasHeightBlk,
+                                    bool                     bPrecedence,
+                                    int                      safeguard,
+                                    const Tile               tile ) {
   for ( size_t v0 = 0; v0 < sizeV0_; ++v0 ) {
     for ( size_t u0 = 0; u0 < sizeU0_; ++u0 ) {
       for ( int deltaY = -safeguard; deltaY < safeguard + 1; deltaY++ ) {
@@ -334,6 +341,44 @@ bool PCCPatch::checkFitPatchCanvas( std::vector<bool> canvas,
   return true;
 }
 
+void PCCPatch::getCanvasBlockMask( PCCOccupancyBitMap& mask, bool bPrecedence, int safeguard ) const {
+  size_t x, y;
+  if ( sizeU0_ == 0 || sizeV0_ == 0 || !orientPatchBlock( 0, 0, x, y ) ) {
+    mask.resize( 0, 0 );
+    return;
+  }
+  const size_t width  = isPatchDimensionSwitched() ? sizeV0_ : sizeU0_;
+  const size_t height = isPatchDimensionSwitched() ? sizeU0_ : sizeV0_;
+  mask.resize( width + 2 * safeguard, height + 2 * safeguard );
+  for ( size_t v0 = 0; v0 < sizeV0_; ++v0 ) {
+    for ( size_t u0 = 0; u0 < sizeU0_; ++u0 ) {
+      if ( bPrecedence && !occupancy_[u0 + sizeU0_ * v0] ) { continue; }
+      orientPatchBlock( u0, v0, x, y );
+      for ( size_t dy = 0; dy <= 2 * safeguard; ++dy ) {
+        for ( size_t dx = 0; dx <= 2 * safeguard; ++dx ) { mask.set( x + dx, y + dy ); }
+      }
+    }
+  }
+}
+
+bool PCCPatch::checkFitPatchCanvas( const PCCOccupancyBitMap& canvas,
+                                    const PCCOccupancyBitMap& mask,
+                                    int                       safeguard,
+                                    const Tile                tile ) const {
+  if ( sizeU0_ == 0 || sizeV0_ == 0 ) { return true; }
+  if ( mask.getWidth() == 0 || u0_ < size_t( safeguard ) || v0_ < size_t( safeguard ) ) { return false; }
+  const size_t x0 = u0_ - safeguard;
+  const size_t y0 = v0_ - safeguard;
+  if ( x0 + mask.getWidth() > canvas.getWidth() || y0 + mask.getHeight() > canvas.getHeight() ) { return false; }
+  if ( tile.minU != -1 ) {
+    if ( x0 < size_t( tile.minU ) || y0 < size_t( tile.minV ) ) { return false; }
+    if ( x0 + mask.getWidth() - 1 > size_t( tile.maxU ) || y0 + mask.getHeight() - 1 > size_t( tile.maxV ) ) {
+      return false;
+    }
+  }
+  return !canvas.intersects( mask, x0, y0 );
+}
+
 bool PCCPatch::smallerRefFirst( const PCCPatch& rhs ) {
   if ( bestMatchIdx_ == -1 && rhs.getBestMatchIdx() == -1 ) {
     return gt( rhs );
@@ -428,7 +473,7 @@ int PCCPatch::calculateWastedSpace( std::vector<int>& horizon,
   int wasted_space          = 0;
   int wasted_space_external = 0;
   int wasted_space_internal = 0;
-  int lambda                = 100;  //--> bias towards the upper part of the canvas
+  int lambda                = wastedSpaceLambda_;  //--> bias towards the upper part of the canvas
   if ( patchOrientation_ == PATCH_ORIENTATION_DEFAULT ) {
     for ( int idx = 0; idx < sizeU0_; idx++ ) {
       wasted_space_external += v0_ + bottomHorizon[idx] - horizon[u0_ + idx];
@@ -512,49 +557,43 @@ int PCCPatch::calculateWastedSpace( std::vector<int>& horizon,
   return wasted_space;
 }
 
-bool PCCPatch::isPatchLocationAboveHorizon( std::vector<int>& horizon,
-                                            std::vector<int>& topHorizon,
-                                            std::vector<int>& bottomHorizon,
-                                            std::vector<int>& rightHorizon,
-                                            std::vector<int>& leftHorizon ) {
+size_t PCCPatch::getLowestV0AboveHorizon( const std::vector<int>& horizon,
+                                          const std::vector<int>& topHorizon,
+                                          const std::vector<int>& bottomHorizon,
+                                          const std::vector<int>& rightHorizon,
+                                          const std::vector<int>& leftHorizon ) const {
+  size_t lowest = 0;
+  auto   raise  = [&]( const int canvasHorizon, const int patchHorizon ) {
+    if ( canvasHorizon > patchHorizon ) { lowest = ( std::max )( lowest, size_t( canvasHorizon - patchHorizon ) ); }
+  };
   if ( patchOrientation_ == PATCH_ORIENTATION_DEFAULT ) {
-    for ( int idx = 0; idx < sizeU0_; idx++ ) {
-      if ( v0_ + bottomHorizon[idx] < horizon[u0_ + idx] ) { return false; }
-    }
+    for ( int idx = 0; idx < sizeU0_; idx++ ) { raise( horizon[u0_ + idx], bottomHorizon[idx] ); }
   } else if ( patchOrientation_ == PATCH_ORIENTATION_ROT90 ) {
-    for ( int idx = 0; idx < sizeV0_; idx++ ) {
-      if ( v0_ + leftHorizon[sizeV0_ - 1 - idx] < horizon[u0_ + idx] ) { return false; }
-    }
+    for ( int idx = 0; idx < sizeV0_; idx++ ) { raise( horizon[u0_ + idx], leftHorizon[sizeV0_ - 1 - idx] ); }
   } else if ( patchOrientation_ == PATCH_ORIENTATION_ROT180 ) {
-    for ( int idx = 0; idx < sizeU0_; idx++ ) {
-      if ( v0_ + topHorizon[sizeU0_ - 1 - idx] < horizon[u0_ + idx] ) { return false; }
-    }
+    for ( int idx = 0; idx < sizeU0_; idx++ ) { raise( horizon[u0_ + idx], topHorizon[sizeU0_ - 1 - idx] ); }
   } else if ( patchOrientation_ == PATCH_ORIENTATION_ROT270 ) {
-    for ( int idx = 0; idx < sizeV0_; idx++ ) {
-      if ( v0_ + rightHorizon[idx] < horizon[u0_ + idx] ) { return false; }
-    }
+    for ( int idx = 0; idx < sizeV0_; idx++ ) { raise( horizon[u0_ + idx], rightHorizon[idx] ); }
   } else if ( patchOrientation_ == PATCH_ORIENTATION_MIRROR ) {
-    for ( int idx = 0; idx < sizeU0_; idx++ ) {
-      if ( v0_ + bottomHorizon[sizeU0_ - 1 - idx] < horizon[u0_ + idx] ) { return false; }
-    }
+    for ( int idx = 0; idx < sizeU0_; idx++ ) { raise( horizon[u0_ + idx], bottomHorizon[sizeU0_ - 1 - idx] ); }
   } else if ( patchOrientation_ == PATCH_ORIENTATION_MROT90 ) {
-    for ( int idx = 0; idx < sizeV0_; idx++ ) {
-      if ( v0_ + rightHorizon[sizeV0_ - 1 - idx] < horizon[u0_ + idx] ) { return false; }
-    }
+    for ( int idx = 0; idx < sizeV0_; idx++ ) { raise( horizon[u0_ + idx], rightHorizon[sizeV0_ - 1 - idx] ); }
   } else if ( patchOrientation_ == PATCH_ORIENTATION_MROT180 ) {
-    for ( int idx = 0; idx < sizeU0_; idx++ ) {
-      if ( v0_ + topHorizon[idx] < horizon[u0_ + idx] ) { return false; }
-    }
+    for ( int idx = 0; idx < sizeU0_; idx++ ) { raise( horizon[u0_ + idx], topHorizon[idx] ); }
   } else if ( patchOrientation_ == PATCH_ORIENTATION_MROT270 ) {
-    for ( int idx = 0; idx < sizeV0_; idx++ ) {
-      if ( v0_ + leftHorizon[idx] < horizon[u0_ + idx] ) { return false; }
-    }
+    for ( int idx = 0; idx < sizeV0_; idx++ ) { raise( horizon[u0_ + idx], leftHorizon[idx] ); }
   } else if ( patchOrientation_ == PATCH_ORIENTATION_SWAP ) {
-    for ( int idx = 0; idx < sizeV0_; idx++ ) {
-      if ( v0_ + leftHorizon[idx] < horizon[u0_ + idx] ) { return false; }
-    }
+    for ( int idx = 0; idx < sizeV0_; idx++ ) { raise( horizon[u0_ + idx], leftHorizon[idx] ); }
   }
-  return true;
+  return lowest;
+}
+
+bool PCCPatch::isPatchLocationAboveHorizon( std::vector<int>& horizon,
+                                            std::vector<int>& topHorizon,
+                                            std::vector<int>& bottomHorizon,
+                                            std::vector<int>& rightHorizon,
+                                            std::vector<int>& leftHorizon ) {
+  return v0_ >= getLowestV0AboveHorizon( horizon, topHorizon, bottomHorizon, rightHorizon, leftHorizon );
 }
 
 void PCCPatch::updateHorizon( std::vector<int>& horizon,
@@ -664,11 +703,11 @@ int PCCPatch::patchBlock2CanvasBlockForGPA( const size_t uBlk,
   return int( x + canvasStrideBlk * y );
 }
 
-bool PCCPatch::checkFitPatchCanvasForGPA( std::vector<bool> canvas,
-                                          size_t            canvasStrideBlk,
-                                          size_t            canvasHeightBlk,
-                                          bool              bPrecedence,
-                                          int               safeguard ) {
+bool PCCPatch::checkFitPatchCanvasForGPA( const std::vector<bool>& canvas,
+                                          size_t                   canvasStrideBlk,
+                                          size_t                   canvasHeightBlk,
+                                          bool                     bPrecedence,
+                                          int                      safeguard ) {
   for ( size_t v0 = 0; v0 < curGPAPatchData_.sizeV0_; ++v0 ) {
     for ( size_t u0 = 0; u0 < curGPAPatchData_.sizeU0_; ++u0 ) {
       for ( int deltaY = -safeguard; deltaY < safeguard + 1; deltaY++ ) {
@@ -698,13 +737,13 @@ void PCCPatch::allocOneLayerData() {
   std::fill( pointLocalReconstructionModeByBlock_.begin(), pointLocalReconstructionModeByBlock_.end(), 0 );
 }
 
-void PCCPatch::setDepthFromGeometryVideo( const std::vector<uint16_t>& geometryVideo,
-                                          const int32_t                u2,
-                                          const int32_t                v2,
-                                          int32_t                      width,
-                                          int32_t                      height,
-                                          int32_t                      occupancyPrecision,
-                                          int16_t*                     depth ) {
+void PCCPatch::setDepthFromGeometryVideo( const PCCImage<uint16_t, 3>::Channel& geometryVideo,
+                                          const int32_t                         u2,
+                                          const int32_t                         v2,
+                                          int32_t                               width,
+                                          int32_t                               height,
+                                          int32_t                               occupancyPrecision,
+                                          int16_t*                              depth ) {
   const int32_t x0 = ( int32_t )( u0_ * occupancyResolution_ );
   const int32_t y0 = ( int32_t )( v0_ * occupancyResolution_ );
   depth += v2 * depthMapWidth_;
@@ -794,13 +833,13 @@ void PCCPatch::setDepthFromGeometryVideo( const std::vector<uint16_t>& geometryV
   }
 }
 
-void PCCPatch::setLocalData( const std::vector<uint8_t>&  occupancyMapVideo,
-                             const std::vector<uint16_t>& geometryVideo,
-                             std::vector<size_t>&         blockToPatch,
-                             const int32_t                width,
-                             const int32_t                height,
-                             const int32_t                occupancyPrecision,
-                             const int32_t                threhold ) {
+void PCCPatch::setLocalData( const PCCImage<uint8_t, 3>::Channel&  occupancyMapVideo,
+                             const PCCImage<uint16_t, 3>::Channel& geometryVideo,
+                             const PCCBlockToPatchMap&             blockToPatch,
+                             const int32_t                         width,
+                             const int32_t                         height,
+                             const int32_t                         occupancyPrecision,
+                             const int32_t                         threhold ) {
   border_         = occupancyPrecision >= 8 ? 16 : 8;
   depthMapWidth_  = sizeU0_ * occupancyResolution_ + 2 * border_;
   depthMapHeight_ = sizeV0_ * occupancyResolution_ + 2 * border_;
@@ -36,38 +36,93 @@
 #include "PCCMath.h"
 #include "KDTreeVectorOfVectorsAdaptor.h"
 #include "PCCKdTree.h"
+#include "PCCSystem.h"
+#include "PCCFrameCache.h"
+#include "PCCPointSetKernels.h"
+#include "PCCDigest.h"
+#include <tbb/tbb.h>
 #include <numeric>
+#include <atomic>
 
 using namespace pcc;
 
+namespace {
+
+// Stable LSD radix sort of the ( key, index ) pairs on the 48 low bits of the keys, 12 bits a pass. The pairs are cut
+// in blocks whose digits are counted and scattered in parallel, each block writing a digit after the same digit of the
+// blocks before it. A pass is skipped when all the keys share its digit, e.g. the high bits of the coordinates.
+void radixSort48( std::vector<std::pair<uint64_t, size_t>>& keys ) {
+  const size_t digitBits  = 12;
+  const size_t digitCount = size_t( 1 ) << digitBits;
+  const size_t count      = keys.size();
+  const size_t blockSize =
+      ( std::max )( size_t( 1 ) << 14, count / ( 4 * size_t( tbb::this_task_arena::max_concurrency() ) ) + 1 );
+  const size_t                             blockCount = ( count + blockSize - 1 ) / blockSize;
+  std::vector<std::pair<uint64_t, size_t>> buffer( count );
+  std::vector<size_t>                      offsets( blockCount * digitCount );
+  for ( size_t shift = 0; shift < 48; shift += digitBits ) {
+    std::fill( offsets.begin(), offsets.end(), 0 );
+    tbb::parallel_for( size_t( 0 ), blockCount, [&]( const size_t block ) {
+      size_t*      histogram = offsets.data() + block * digitCount;
+      const size_t end       = ( std::min )( count, ( block + 1 ) * blockSize );
+      for ( size_t i = block * blockSize; i < end; ++i ) { histogram[( keys[i].first >> shift ) & ( digitCount - 1 )]++; }
+    } );
+    size_t total = 0;
+    bool   skip  = false;
+    for ( size_t digit = 0; digit < digitCount && !skip; ++digit ) {
+      const size_t start = total;
+      for ( size_t block = 0; block < blockCount; ++block ) {
+        const size_t n                      = offsets[block * digitCount + digit];
+        offsets[block * digitCount + digit] = total;
+        total += n;
+      }
+      skip = total - start == count;
+    }
+    if ( skip ) { continue; }
+    tbb::parallel_for( size_t( 0 ), blockCount, [&]( const size_t block ) {
+      size_t*      offset = offsets.data() + block * digitCount;
+      const size_t end    = ( std::min )( count, ( block + 1 ) * blockSize );
+      for ( size_t i = block * blockSize; i < end; ++i ) {
+        buffer[offset[( keys[i].first >> shift ) & ( digitCount - 1 )]++] = keys[i];
+      }
+    } );
+    keys.swap( buffer );
+  }
+}
+
+// The point indices ordered by position, x then y then z as signed values, and by index for equal positions. A
+// position packs into 48 bits, each coordinate offset so that the unsigned order of the keys is its signed order.
+std::vector<std::pair<uint64_t, size_t>> sortByPosition( const std::vector<PCCPoint3D>& positions ) {
+  std::vector<std::pair<uint64_t, size_t>> keys( positions.size() );
+  tbb::parallel_for( size_t( 0 ), positions.size(), [&]( const size_t i ) {
+    const PCCPoint3D& p = positions[i];
+    keys[i].first       = ( uint64_t( uint16_t( p[0] + 32768 ) ) << 32 ) |
+                    ( uint64_t( uint16_t( p[1] + 32768 ) ) << 16 ) | uint64_t( uint16_t( p[2] + 32768 ) );
+    keys[i].second = i;
+  } );
+  radixSort48( keys );
+  return keys;
+}
+
+}  // namespace
+
 void PCCPointSet3::removeDuplicate() {
   PCCPointSet3 newPointcloud;
   if ( withColors_ ) { newPointcloud.hasColors(); }
   if ( withReflectances_ ) { newPointcloud.addReflectances(); }
-  std::map<float, std::map<float, std::map<float, size_t>>> eMapA;
+  // the first point of each position is kept
+  const auto           sorted = sortByPosition( positions_ );
+  std::vector<uint8_t> isFirst( positions_.size(), 0 );
+  tbb::parallel_for( size_t( 0 ), sorted.size(), [&]( const size_t i ) {
+    isFirst[sorted[i].second] = static_cast<uint8_t>( i == 0 || sorted[i].first != sorted[i - 1].first );
+  } );
   if ( withColors_ ) {
     for ( size_t i = 0; i < positions_.size(); ++i ) {
-      float x = positions_[i][0];
-      float y = positions_[i][1];
-      float z = positions_[i][2];
-      if ( eMapA.find( x ) != eMapA.end() && eMapA[x].find( y ) != eMapA[x].end() &&
-           eMapA[x][y].find( z ) != eMapA[x][y].end() ) {
-      } else {
-        eMapA[x][y][z] = i;
-        newPointcloud.addPoint( positions_[i], colors_[i] );
-      }
+      if ( isFirst[i] != 0u ) { newPointcloud.addPoint( positions_[i], colors_[i] ); }
     }
   } else {
     for ( size_t i = 0; i < positions_.size(); ++i ) {
-      float x = positions_[i][0];
-      float y = positions_[i][1];
-      float z = positions_[i][2];
-      if ( eMapA.find( x ) != eMapA.end() && eMapA[x].find( y ) != eMapA[x].end() &&
-           eMapA[x][y].find( z ) != eMapA[x][y].end() ) {
-      } else {
-        eMapA[x][y][z] = i;
-        newPointcloud.addPoint( positions_[i] );
-      }
+      if ( isFirst[i] != 0u ) { newPointcloud.addPoint( positions_[i] ); }
     }
   }
   positions_.swap( newPointcloud.positions_ );
@@ -173,135 +228,117 @@ void PCCPointSet3::removeDuplicate( PCCPointSet3& newPointcloud, size_t dropDupl
     std::cerr << "Normaled objects can't be modified or reordered \n" << std::endl;
     exit( -1 );
   }
-  std::map<float, std::map<float, std::map<float, std::vector<size_t>>>> map;
-  for ( size_t i = 0; i < positions_.size(); ++i ) {
-    float x = positions_[i][0];
-    float y = positions_[i][1];
-    float z = positions_[i][2];
-    map[x][y][z].push_back( i );
-  }
-  if ( withColors_ ) {
-    for ( auto& itX : map ) {
-      for ( auto& itY : itX.second ) {
-        for ( auto& itZ : itY.second ) {
-          auto& listIndex = itZ.second;
-          if ( listIndex.size() == 1 || dropDuplicates == 1 ) {
-            newPointcloud.addPoint( positions_[listIndex[0]], colors_[listIndex[0]] );
-          } else {
-            PCCColor3B average;
-            size_t     r = 0;
-            size_t     g = 0;
-            size_t     b = 0;
-            for ( auto& index : listIndex ) {
-              r += colors_[index][0];
-              g += colors_[index][1];
-              b += colors_[index][2];
-            }
-            average[0] = r / listIndex.size();
-            average[1] = g / listIndex.size();
-            average[2] = b / listIndex.size();
-            newPointcloud.addPoint( positions_[listIndex[0]], average );
-          }
-        }
-      }
-    }
-  } else {
-    for ( auto& itX : map ) {
-      for ( auto& itY : itX.second ) {
-        for ( auto& itZ : itY.second ) {
-          auto& listIndex = itZ.second;
-          newPointcloud.addPoint( positions_[listIndex[0]] );
-        }
+  // the points of a position are consecutive in sorted, by index
+  const auto sorted = sortByPosition( positions_ );
+  for ( size_t start = 0, end = 0; start < sorted.size(); start = end ) {
+    while ( end < sorted.size() && sorted[end].first == sorted[start].first ) { ++end; }
+    const size_t first = sorted[start].second;
+    if ( !withColors_ ) {
+      newPointcloud.addPoint( positions_[first] );
+    } else if ( end - start == 1 || dropDuplicates == 1 ) {
+      newPointcloud.addPoint( positions_[first], colors_[first] );
+    } else {
+      PCCColor3B average;
+      size_t     r = 0;
+      size_t     g = 0;
+      size_t     b = 0;
+      for ( size_t i = start; i < end; ++i ) {
+        r += colors_[sorted[i].second][0];
+        g += colors_[sorted[i].second][1];
+        b += colors_[sorted[i].second][2];
       }
+      average[0] = r / ( end - start );
+      average[1] = g / ( end - start );
+      average[2] = b / ( end - start );
+      newPointcloud.addPoint( positions_[first], average );
     }
   }
 }
 
 using UInt = unsigned int;
 #include "MD5.h"
-std::vector<uint8_t> PCCPointSet3::computeChecksum( bool reorderPoints ) {
+std::vector<uint8_t> PCCPointSet3::computeChecksum( bool reorderPoints, bool fastDigest ) {
   if ( reorderPoints ) {
     PCCPointSet3 reorderPointCloud;
     if ( withColors_ ) { reorderPointCloud.hasColors(); }
     if ( withReflectances_ ) { reorderPointCloud.addReflectances(); }
     reorder( reorderPointCloud, true );
-    return reorderPointCloud.computeMd5();
+    return reorderPointCloud.computeChecksum( false, fastDigest );
   }
-  return computeMd5();
+  return fastDigest ? computeDigest<PCCDigest64>( PCCDigest64::DIGEST_LENGTH )
+                    : computeDigest<MD5>( MD5_DIGEST_STRING_LENGTH );
 }
-std::vector<uint8_t> PCCPointSet3::computeMd5() {
+template <typename Digest>
+std::vector<uint8_t> PCCPointSet3::computeDigest( const size_t length ) {
   std::vector<uint8_t> digest;
-  MD5                  md5;
-  md5.update( reinterpret_cast<uint8_t*>( positions_.data() ), positions_.size() * sizeof( PCCPoint3D ) );
+  Digest               hash;
+  hash.update( reinterpret_cast<uint8_t*>( positions_.data() ), positions_.size() * sizeof( PCCPoint3D ) );
   if ( withColors_ ) {
-    md5.update( reinterpret_cast<uint8_t*>( colors_.data() ), colors_.size() * sizeof( PCCColor3B ) );
+    hash.update( reinterpret_cast<uint8_t*>( colors_.data() ), colors_.size() * sizeof( PCCColor3B ) );
   }
   if ( withReflectances_ ) {
-    md5.update( reinterpret_cast<uint8_t*>( reflectances_.data() ), reflectances_.size() * sizeof( uint16_t ) );
+    hash.update( reinterpret_cast<uint8_t*>( reflectances_.data() ), reflectances_.size() * sizeof( uint16_t ) );
   }
-  digest.resize( MD5_DIGEST_STRING_LENGTH );
-  md5.finalize( digest.data() );
+  digest.resize( length );
+  hash.finalize( digest.data() );
   return digest;
 }
 
 void PCCPointSet3::sortColor( std::vector<size_t>& list ) {
-  for ( size_t i = 0; i < list.size(); ++i ) {
-    size_t indexMin = i;
-    for ( size_t j = i + 1; j < list.size(); ++j ) {
-      if ( colors_[list[j]] < colors_[list[indexMin]] ) { indexMin = j; }
-    }
-    if ( i != indexMin ) {
-      size_t tmp     = list[indexMin];
-      list[indexMin] = list[i];
-      list[i]        = tmp;
-    }
-  }
+  std::stable_sort( list.begin(), list.end(),
+                    [&]( const size_t a, const size_t b ) { return colors_[a] < colors_[b]; } );
 }
 
 void PCCPointSet3::reorder( PCCPointSet3& newPointcloud, bool dropDuplicates ) {
-  std::map<float, std::map<float, std::map<float, std::vector<size_t>>>> map;
-  for ( size_t i = 0; i < positions_.size(); ++i ) {
-    float x = positions_[i][0];
-    float y = positions_[i][1];
-    float z = positions_[i][2];
-    map[x][y][z].push_back( i );
+  // Points in ( x, y, z ) order and, at the same position, in colour order: the packed positions are radix sorted,
+  // then the few points of each position are ordered by colour. The new points are gathered in parallel, all their
+  // attributes at once.
+  auto                sorted = sortByPosition( positions_ );
+  std::vector<size_t> runs;
+  for ( size_t i = 0; i < sorted.size(); i++ ) {
+    if ( i == 0 || sorted[i].first != sorted[i - 1].first ) { runs.push_back( i ); }
   }
+  runs.push_back( sorted.size() );
+  const size_t runCount = runs.size() - 1;
   if ( withColors_ ) {
-    for ( auto& itX : map ) {
-      for ( auto& itY : itX.second ) {
-        for ( auto& itZ : itY.second ) {
-          auto& listIndex = itZ.second;
-          if ( listIndex.size() > 1 ) { sortColor( listIndex ); }
-          if ( dropDuplicates ) {
-            PCCColor3B average;
-            size_t     r = 0;
-            size_t     g = 0;
-            size_t     b = 0;
-            for ( auto& index : listIndex ) {
-              r += colors_[index][0];
-              g += colors_[index][1];
-              b += colors_[index][2];
-            }
-            average[0] = r / listIndex.size();
-            average[1] = g / listIndex.size();
-            average[2] = b / listIndex.size();
-            newPointcloud.addPoint( positions_[listIndex[0]], average );
-          } else {
-            for ( auto& index : listIndex ) { newPointcloud.addPoint( positions_[index], colors_[index] ); }
-          }
-        }
+    tbb::parallel_for( size_t( 0 ), runCount, [&]( const size_t r ) {
+      if ( runs[r + 1] - runs[r] > 1 ) {
+        std::sort( sorted.begin() + runs[r], sorted.begin() + runs[r + 1],
+                   [&]( const std::pair<uint64_t, size_t>& a, const std::pair<uint64_t, size_t>& b ) {
+                     if ( colors_[a.second] != colors_[b.second] ) { return colors_[a.second] < colors_[b.second]; }
+                     return a.second < b.second;
+                   } );
       }
-    }
-  } else {
-    for ( auto& itX : map ) {
-      for ( auto& itY : itX.second ) {
-        for ( auto& itZ : itY.second ) {
-          auto& listIndex = itZ.second;
-          for ( auto& index : listIndex ) { newPointcloud.addPoint( positions_[index] ); }
-        }
+    } );
+  }
+  const bool   average = withColors_ && dropDuplicates;
+  const size_t count   = average ? runCount : sorted.size();
+  const size_t base    = newPointcloud.getPointCount();
+  if ( withColors_ ) { newPointcloud.addColors(); }
+  newPointcloud.resize( base + count );
+  tbb::parallel_for( size_t( 0 ), count, [&]( const size_t i ) {
+    if ( average ) {
+      const size_t begin = runs[i];
+      const size_t end   = runs[i + 1];
+      PCCColor3B   color;
+      size_t       r = 0;
+      size_t       g = 0;
+      size_t       b = 0;
+      for ( size_t j = begin; j < end; j++ ) {
+        r += colors_[sorted[j].second][0];
+        g += colors_[sorted[j].second][1];
+        b += colors_[sorted[j].second][2];
       }
+      color[0]                           = r / ( end - begin );
+      color[1]                           = g / ( end - begin );
+      color[2]                           = b / ( end - begin );
+      newPointcloud.positions_[base + i] = positions_[sorted[begin].second];
+      newPointcloud.colors_[base + i]    = color;
+    } else {
+      newPointcloud.positions_[base + i] = positions_[sorted[i].second];
+      if ( withColors_ ) { newPointcloud.colors_[base + i] = colors_[sorted[i].second]; }
     }
-  }
+  } );
 }
 
 void PCCPointSet3::reorder() {
@@ -311,6 +348,14 @@ void PCCPointSet3::reorder() {
   reorder( newPointcloud, false );
   swap( newPointcloud );
 }
+size_t PCCPointSet3::getMemorySize() const {
+  return positions_.capacity() * sizeof( PCCPoint3D ) + colors_.capacity() * sizeof( PCCColor3B ) +
+         colors16bit_.capacity() * sizeof( PCCColor16bit ) +
+         ( reflectances_.capacity() + boundaryPointTypes_.capacity() ) * sizeof( uint16_t ) +
+         pointPatchIndexes_.capacity() * sizeof( std::pair<uint32_t, uint32_t> ) +
+         parentPointIndex_.capacity() * sizeof( uint64_t ) + types_.capacity() +
+         normals_.capacity() * sizeof( PCCNormal3D );
+}
 void PCCPointSet3::swap( PCCPointSet3& newPointcloud ) {
   positions_.swap( newPointcloud.positions_ );
   colors_.swap( newPointcloud.colors_ );
@@ -356,58 +401,54 @@ bool PCCPointSet3::isRawPointsBboxEmpty( std::vector<size_t> rawPoints, PCCBox3D
   return true;
 }
 
-bool PCCPointSet3::write( const std::string& fileName, const bool asAscii ) {
-  std::ofstream fout( fileName, std::ofstream::out );
-  if ( !fout.is_open() ) { return false; }
+bool PCCPointSet3::write( const std::string& fileName, const bool asAscii, const bool directIO ) {
+  // positions and colors only, see PCCFrameCache
+  if ( fileName.size() > 4 && fileName.compare( fileName.size() - 4, 4, ".pcf" ) == 0 ) {
+    PCCFrameCacheWriter writer;
+    return writer.open( fileName, 1, 0 ) && writer.append( *this ) && writer.close();
+  }
   const size_t pointCount = getPointCount();
-  fout << "ply" << std::endl;
-
+  std::string  header     = "ply\n";
   if ( asAscii ) {
-    fout << "format ascii 1.0" << std::endl;
+    header += "format ascii 1.0\n";
   } else {
     PCCEndianness endianess = PCCSystemEndianness();
     if ( endianess == PCC_BIG_ENDIAN ) {
-      fout << "format binary_big_endian 1.0" << std::endl;
+      header += "format binary_big_endian 1.0\n";
     } else {
-      fout << "format binary_little_endian 1.0" << std::endl;
+      header += "format binary_little_endian 1.0\n";
     }
   }
-  fout << "element vertex " << pointCount << std::endl;
-  if ( asAscii ) {
-    fout << "property float x" << std::endl;
-    fout << "property float y" << std::endl;
-    fout << "property float z" << std::endl;
-  } else {
-    // fout << "property int16 x" << std::endl;
-    // fout << "property int16 y" << std::endl;
-    // fout << "property int16 z" << std::endl;
-    fout << "property float x" << std::endl;
-    fout << "property float y" << std::endl;
-    fout << "property float z" << std::endl;
-  }
+  header += "element vertex " + std::to_string( pointCount ) + "\n";
+  header += "property float x\n";
+  header += "property float y\n";
+  header += "property float z\n";
   if ( hasNormals() ) {
-    fout << "property float nx" << std::endl;
-    fout << "property float ny" << std::endl;
-    fout << "property float nz" << std::endl;
+    header += "property float nx\n";
+    header += "property float ny\n";
+    header += "property float nz\n";
   }
   if ( hasColors() ) {
-    fout << "property uchar red" << std::endl;
-    fout << "property uchar green" << std::endl;
-    fout << "property uchar blue" << std::endl;
+    header += "property uchar red\n";
+    header += "property uchar green\n";
+    header += "property uchar blue\n";
   }
-  if ( hasReflectances() ) { fout << "property uint16 refc" << std::endl; }
+  if ( hasReflectances() ) { header += "property uint16 refc\n"; }
   if ( PCC_SAVE_POINT_TYPE != 0u ) {
-    fout << "property uchar type" << std::endl;
+    header += "property uchar type\n";
     switch ( PCC_SAVE_POINT_TYPE ) {
-      case 1: fout << "comment POINT_TYPE: Unset D0 D1 Filling Smooth InBetween" << std::endl; break;
-      case 2: fout << "comment POINT_TYPE: type0 type1 type2  " << std::endl; break;
+      case 1: header += "comment POINT_TYPE: Unset D0 D1 Filling Smooth InBetween\n"; break;
+      case 2: header += "comment POINT_TYPE: type0 type1 type2  \n"; break;
       default: break;
     }
   }
-  fout << "element face 0" << std::endl;
-  fout << "property list uint8 int32 vertex_index" << std::endl;
-  fout << "end_header" << std::endl;
+  header += "element face 0\n";
+  header += "property list uint8 int32 vertex_index\n";
+  header += "end_header\n";
   if ( asAscii ) {
+    std::ofstream fout( fileName, std::ofstream::out );
+    if ( !fout.is_open() ) { return false; }
+    fout << header;
     fout << std::setprecision( std::numeric_limits<double>::max_digits10 );
     for ( size_t i = 0; i < pointCount; ++i ) {
       const PCCPoint3D& position = ( *this )[i];
@@ -424,46 +465,72 @@ bool PCCPointSet3::write( const std::string& fileName, const bool asAscii ) {
       }
       if ( hasReflectances() ) { fout << " " << static_cast<int>( getReflectance( i ) ); }
       if ( PCC_SAVE_POINT_TYPE != 0u ) { fout << " " << static_cast<int>( types_[i] ); }
-      fout << std::endl;
+      fout << '\n';
     }
-  } else {
-    fout.clear();
     fout.close();
-    fout.open( fileName, std::ofstream::binary | std::ofstream::out | std::ofstream::app );
-    for ( size_t i = 0; i < pointCount; ++i ) {
-      const PCCPoint3D& position = ( *this )[i];
-      // fout.write( reinterpret_cast<const char* const>( &position ), sizeof( PCCType ) * 3 );
-      float value[3];
-      value[0] = position[0];
-      value[1] = position[1];
-      value[2] = position[2];
-      fout.write( reinterpret_cast<const char*>( &value ), sizeof( float ) * 3 );
-      if ( hasNormals() ) {
-        const PCCNormal3D& normal = getNormals()[i];
-        value[0]                  = normal[0];
-        value[1]                  = normal[1];
-        value[2]                  = normal[2];
-        fout.write( reinterpret_cast<const char*>( &value ), sizeof( float ) * 3 );
-      }
-      if ( hasColors() ) {
-        const PCCColor3B& color = getColor( i );
-        fout.write( reinterpret_cast<const char*>( &color ), sizeof( uint8_t ) * 3 );
-      }
-      if ( hasReflectances() ) {
-        const uint16_t& reflectance = getReflectance( i );
-        fout.write( reinterpret_cast<const char*>( &reflectance ), sizeof( uint16_t ) );
-      }
-      if ( PCC_SAVE_POINT_TYPE != 0u ) {
-        fout.write( reinterpret_cast<const char* const>( &types_[i] ), sizeof( uint8_t ) );
-      }
+    return !fout.fail();
+  }
+  // The binary file is assembled in memory, in the byte order of the system, and written at once.
+  const size_t stride = 3 * sizeof( float ) + ( hasNormals() ? 3 * sizeof( float ) : 0 ) + ( hasColors() ? 3 : 0 ) +
+                        ( hasReflectances() ? sizeof( uint16_t ) : 0 ) + ( PCC_SAVE_POINT_TYPE != 0u ? 1 : 0 );
+  std::vector<uint8_t> buffer( header.size() + pointCount * stride );
+  memcpy( buffer.data(), header.data(), header.size() );
+  uint8_t* record = buffer.data() + header.size();
+  for ( size_t i = 0; i < pointCount; ++i ) {
+    const PCCPoint3D& position = ( *this )[i];
+    float             value[3];
+    value[0] = position[0];
+    value[1] = position[1];
+    value[2] = position[2];
+    memcpy( record, value, sizeof( value ) );
+    record += sizeof( value );
+    if ( hasNormals() ) {
+      const PCCNormal3D& normal = getNormals()[i];
+      value[0]                  = normal[0];
+      value[1]                  = normal[1];
+      value[2]                  = normal[2];
+      memcpy( record, value, sizeof( value ) );
+      record += sizeof( value );
+    }
+    if ( hasColors() ) {
+      const PCCColor3B& color = getColor( i );
+      record[0]               = color[0];
+      record[1]               = color[1];
+      record[2]               = color[2];
+      record += 3;
     }
+    if ( hasReflectances() ) {
+      const uint16_t reflectance = getReflectance( i );
+      memcpy( record, &reflectance, sizeof( uint16_t ) );
+      record += sizeof( uint16_t );
+    }
+    if ( PCC_SAVE_POINT_TYPE != 0u ) { *record++ = types_[i]; }
   }
-  fout.close();
-  return true;
+  return writeFile( fileName, buffer.data(), buffer.size(), directIO );
 }
+
+// Value of a binary PLY property of the given type, stored in the given byte order.
+template <typename T>
+static inline T readPlyValue( const uint8_t* data, const bool swapBytes ) {
+  T value;
+  if ( swapBytes ) {
+    uint8_t bytes[sizeof( T )];
+    for ( size_t k = 0; k < sizeof( T ); k++ ) { bytes[k] = data[sizeof( T ) - 1 - k]; }
+    memcpy( &value, bytes, sizeof( T ) );
+  } else {
+    memcpy( &value, data, sizeof( T ) );
+  }
+  return value;
+}
+
 bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
-  std::ifstream ifs( fileName, std::ifstream::in );
-  if ( !ifs.is_open() ) { return false; }
+  PCCMappedFile file;
+  if ( !file.open( fileName ) ) { return false; }
+  if ( PCCFrameCache::isFrameCache( file.data(), file.size() ) ) {
+    file.close();
+    PCCFrameCache cache;
+    return cache.open( fileName ) && cache.getFrameCount() > 0 && cache.read( cache.getStartFrameNumber(), *this );
+  }
   enum AttributeType {
     ATTRIBUTE_TYPE_FLOAT64 = 0,
     ATTRIBUTE_TYPE_FLOAT32 = 1,
@@ -484,36 +551,46 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
 
   std::vector<AttributeInfo> attributesInfo;
   attributesInfo.reserve( 16 );
-  const size_t             MAX_BUFFER_SIZE = 4096;
-  char                     tmp[MAX_BUFFER_SIZE];
   const char*              sep = " \t\r";
   std::vector<std::string> tokens;
+  std::string              line;
+
+  // The file is parsed in place: cursor is the start of the next line.
+  const char*       cursor  = reinterpret_cast<const char*>( file.data() );
+  const char* const fileEnd = cursor + file.size();
+  auto              getLine = [&]() {
+    const char* lineEnd = cursor;
+    while ( lineEnd < fileEnd && *lineEnd != '\n' ) { lineEnd++; }
+    line.assign( cursor, lineEnd );
+    cursor = lineEnd < fileEnd ? lineEnd + 1 : fileEnd;
+    getTokens( line.c_str(), sep, tokens );
+  };
 
-  ifs.getline( tmp, MAX_BUFFER_SIZE );
-  getTokens( tmp, sep, tokens );
+  getLine();
   if ( tokens.empty() || tokens[0] != "ply" ) {
     std::cout << "Error: corrupted file!" << std::endl;
     return false;
   }
-  bool   isAscii          = false;
-  double version          = 1.0;
-  size_t pointCount       = 0;
-  bool   isVertexProperty = true;
+  bool          isAscii          = false;
+  PCCEndianness endianness       = PCC_LITTLE_ENDIAN;
+  double        version          = 1.0;
+  size_t        pointCount       = 0;
+  bool          isVertexProperty = true;
   while ( true ) {
-    if ( ifs.eof() ) {
+    if ( cursor >= fileEnd ) {
       std::cout << "Error: corrupted header!" << std::endl;
       return false;
     }
-    ifs.getline( tmp, MAX_BUFFER_SIZE );
-    getTokens( tmp, sep, tokens );
+    getLine();
     if ( tokens.empty() || tokens[0] == "comment" ) { continue; }
     if ( tokens[0] == "format" ) {
       if ( tokens.size() != 3 ) {
         std::cout << "Error: corrupted format info!" << std::endl;
         return false;
       }
-      isAscii = tokens[1] == "ascii";
-      version = atof( tokens[2].c_str() );
+      isAscii    = tokens[1] == "ascii";
+      endianness = tokens[1] == "binary_big_endian" ? PCC_BIG_ENDIAN : PCC_LITTLE_ENDIAN;
+      version    = atof( tokens[2].c_str() );
     } else if ( tokens[0] == "element" ) {
       if ( tokens.size() != 3 ) {
         std::cout << "Error: corrupted element info!" << std::endl;
@@ -535,7 +612,7 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
       attributesInfo.resize( attributeIndex + 1 );
       AttributeInfo& attributeInfo = attributesInfo[attributeIndex];
       attributeInfo.name           = propertyName;
-      if ( propertyType == "float64" ) {
+      if ( propertyType == "float64" || propertyType == "double" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_FLOAT64;
         attributeInfo.byteCount = 8;
       } else if ( propertyType == "float" || propertyType == "float32" ) {
@@ -544,10 +621,10 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
       } else if ( propertyType == "uint64" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_UINT64;
         attributeInfo.byteCount = 8;
-      } else if ( propertyType == "uint32" ) {
+      } else if ( propertyType == "uint32" || propertyType == "uint" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_UINT32;
         attributeInfo.byteCount = 4;
-      } else if ( propertyType == "uint16" ) {
+      } else if ( propertyType == "uint16" || propertyType == "ushort" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_UINT16;
         attributeInfo.byteCount = 2;
       } else if ( propertyType == "uchar" || propertyType == "uint8" ) {
@@ -559,12 +636,15 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
       } else if ( propertyType == "int32" || propertyType == "int" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_INT32;
         attributeInfo.byteCount = 4;
-      } else if ( propertyType == "int16" ) {
+      } else if ( propertyType == "int16" || propertyType == "short" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_INT16;
         attributeInfo.byteCount = 2;
       } else if ( propertyType == "char" || propertyType == "int8" ) {
         attributeInfo.type      = ATTRIBUTE_TYPE_INT8;
         attributeInfo.byteCount = 1;
+      } else {
+        std::cout << "Error: non-supported property type " << propertyType << "!" << std::endl;
+        return false;
       }
     } else if ( tokens[0] == "end_header" ) {
       break;
@@ -624,9 +704,8 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
   resize( pointCount );
   if ( isAscii ) {
     size_t pointCounter = 0;
-    while ( !ifs.eof() && pointCounter < pointCount ) {
-      ifs.getline( tmp, MAX_BUFFER_SIZE );
-      getTokens( tmp, sep, tokens );
+    while ( cursor < fileEnd && pointCounter < pointCount ) {
+      getLine();
       if ( tokens.empty() ) { continue; }
       if ( tokens.size() < attributeCount ) { return false; }
       auto& position = positions_[pointCounter];
@@ -643,112 +722,75 @@ bool PCCPointSet3::read( const std::string& fileName, const bool readNormals ) {
       ++pointCounter;
     }
   } else {
-    ifs.close();
-    ifs.open( fileName, std::ifstream::binary | std::ifstream::in );
-    ifs.read( tmp, MAX_BUFFER_SIZE );
-    char* str       = strstr( tmp, "end_header" );
-    str             = strstr( str, "\n" );
-    int headerCount = str - tmp + 1;
-    ifs.close();
-    ifs.open( fileName, std::ifstream::binary | std::ifstream::in );
-    ifs.read( tmp, headerCount );
-    for ( size_t pointCounter = 0; pointCounter < pointCount && !ifs.eof(); ++pointCounter ) {
-      auto& position = positions_[pointCounter];
-      for ( size_t a = 0; a < attributeCount && !ifs.eof(); ++a ) {
-        const auto& attributeInfo = attributesInfo[a];
-        if ( a == indexX ) {
-          if ( attributeInfo.byteCount == 2 ) {
-            uint16_t x;
-            ifs.read( reinterpret_cast<char*>( &x ), sizeof( uint16_t ) );
-            position[0] = x;
-          } else if ( attributeInfo.byteCount == 4 ) {
-            float x;
-            ifs.read( reinterpret_cast<char*>( &x ), sizeof( float ) );
-            position[0] = x;
-          } else {
-            double x;
-            ifs.read( reinterpret_cast<char*>( &x ), sizeof( double ) );
-            position[0] = x;
-          }
-        } else if ( a == indexY ) {
-          if ( attributeInfo.byteCount == 2 ) {
-            uint16_t y;
-            ifs.read( reinterpret_cast<char*>( &y ), sizeof( uint16_t ) );
-            position[1] = y;
-          } else if ( attributeInfo.byteCount == 4 ) {
-            float y;
-            ifs.read( reinterpret_cast<char*>( &y ), sizeof( float ) );
-            position[1] = y;
-          } else {
-            double y;
-            ifs.read( reinterpret_cast<char*>( &y ), sizeof( double ) );
-            position[1] = y;
-          }
-        } else if ( a == indexZ ) {
-          if ( attributeInfo.byteCount == 2 ) {
-            uint16_t z;
-            ifs.read( reinterpret_cast<char*>( &z ), sizeof( uint16_t ) );
-            position[2] = z;
-          } else if ( attributeInfo.byteCount == 4 ) {
-            float z;
-            ifs.read( reinterpret_cast<char*>( &z ), sizeof( float ) );
-            position[2] = z;
-          } else {
-            double z;
-            ifs.read( reinterpret_cast<char*>( &z ), sizeof( double ) );
-            position[2] = z;
-          }
-        } else if ( a == indexR && attributeInfo.byteCount == 1 ) {
-          auto& color = colors_[pointCounter];
-          ifs.read( reinterpret_cast<char*>( &color[0] ), sizeof( uint8_t ) );
-        } else if ( a == indexG && attributeInfo.byteCount == 1 ) {
-          auto& color = colors_[pointCounter];
-          ifs.read( reinterpret_cast<char*>( &color[1] ), sizeof( uint8_t ) );
-        } else if ( a == indexB && attributeInfo.byteCount == 1 ) {
-          auto& color = colors_[pointCounter];
-          ifs.read( reinterpret_cast<char*>( &color[2] ), sizeof( uint8_t ) );
-        } else if ( a == indexNX ) {
-          if ( attributeInfo.byteCount == 4 ) {
-            float nx;
-            ifs.read( reinterpret_cast<char*>( &nx ), sizeof( float ) );
-            normals_[pointCounter][0] = nx;
-          } else {
-            double nx;
-            ifs.read( reinterpret_cast<char*>( &nx ), sizeof( double ) );
-            normals_[pointCounter][0] = nx;
-          }
-        } else if ( a == indexNY ) {
-          if ( attributeInfo.byteCount == 4 ) {
-            float ny;
-            ifs.read( reinterpret_cast<char*>( &ny ), sizeof( float ) );
-            normals_[pointCounter][1] = ny;
-          } else {
-            double ny;
-            ifs.read( reinterpret_cast<char*>( &ny ), sizeof( double ) );
-            normals_[pointCounter][1] = ny;
-          }
-        } else if ( a == indexNZ ) {
-          if ( attributeInfo.byteCount == 4 ) {
-            float nz;
-            ifs.read( reinterpret_cast<char*>( &nz ), sizeof( float ) );
-            normals_[pointCounter][2] = nz;
-          } else {
-            double nz;
-            ifs.read( reinterpret_cast<char*>( &nz ), sizeof( double ) );
-            normals_[pointCounter][2] = nz;
-          }
-        } else if ( a == indexReflectance && attributeInfo.byteCount <= 2 ) {
-          if ( indexReflectance == 1 ) {
-            uint8_t reflectance;
-            ifs.read( reinterpret_cast<char*>( &reflectance ), sizeof( uint8_t ) );
-            reflectances_[pointCounter] = reflectance;
-          } else {
-            auto& reflectance = reflectances_[pointCounter];
-            ifs.read( reinterpret_cast<char*>( reflectance ), sizeof( uint16_t ) );
-          }
-        } else {
-          char buffer[128];
-          ifs.read( buffer, attributeInfo.byteCount );
+    std::vector<size_t> offsets( attributeCount );
+    size_t              stride = 0;
+    for ( size_t a = 0; a < attributeCount; ++a ) {
+      offsets[a] = stride;
+      stride += attributesInfo[a].byteCount;
+    }
+    const bool     swapBytes = endianness != PCCSystemEndianness();
+    const uint8_t* records   = reinterpret_cast<const uint8_t*>( cursor );
+    // The points of a truncated file are read as far as they go, the others are left at zero.
+    const size_t recordCount = ( std::min )( pointCount, size_t( fileEnd - cursor ) / stride );
+    auto         readValue   = [&]( const uint8_t* data, const AttributeType type ) -> double {
+      switch ( type ) {
+        case ATTRIBUTE_TYPE_FLOAT64: return readPlyValue<double>( data, swapBytes );
+        case ATTRIBUTE_TYPE_FLOAT32: return readPlyValue<float>( data, swapBytes );
+        case ATTRIBUTE_TYPE_UINT64: return double( readPlyValue<uint64_t>( data, swapBytes ) );
+        case ATTRIBUTE_TYPE_UINT32: return readPlyValue<uint32_t>( data, swapBytes );
+        case ATTRIBUTE_TYPE_UINT16: return readPlyValue<uint16_t>( data, swapBytes );
+        case ATTRIBUTE_TYPE_UINT8: return data[0];
+        case ATTRIBUTE_TYPE_INT64: return double( readPlyValue<int64_t>( data, swapBytes ) );
+        case ATTRIBUTE_TYPE_INT32: return readPlyValue<int32_t>( data, swapBytes );
+        case ATTRIBUTE_TYPE_INT16: return readPlyValue<int16_t>( data, swapBytes );
+        case ATTRIBUTE_TYPE_INT8: return static_cast<int8_t>( data[0] );
+      }
+      return 0.0;
+    };
+    // Fast path for the layout of the sequences and of the reconstructed clouds: float x y z, then optionally uchar
+    // red green blue, in the byte order of the system.
+    const bool isXYZ = indexX == 0 && indexY == 1 && indexZ == 2 && attributesInfo[0].type == ATTRIBUTE_TYPE_FLOAT32 &&
+                       attributesInfo[1].type == ATTRIBUTE_TYPE_FLOAT32 &&
+                       attributesInfo[2].type == ATTRIBUTE_TYPE_FLOAT32;
+    const bool isRGB = !hasColors() || ( indexR == 3 && indexG == 4 && indexB == 5 );
+    if ( isXYZ && isRGB && !swapBytes && !hasNormals() && !hasReflectances() ) {
+      for ( size_t i = 0; i < recordCount; ++i ) {
+        const uint8_t* record = records + i * stride;
+        float          value[3];
+        memcpy( value, record, sizeof( value ) );
+        auto& position = positions_[i];
+        position[0]    = value[0];
+        position[1]    = value[1];
+        position[2]    = value[2];
+        if ( hasColors() ) {
+          auto& color = colors_[i];
+          color[0]    = record[12];
+          color[1]    = record[13];
+          color[2]    = record[14];
+        }
+      }
+    } else {
+      for ( size_t i = 0; i < recordCount; ++i ) {
+        const uint8_t* record   = records + i * stride;
+        auto&          position = positions_[i];
+        position[0]             = readValue( record + offsets[indexX], attributesInfo[indexX].type );
+        position[1]             = readValue( record + offsets[indexY], attributesInfo[indexY].type );
+        position[2]             = readValue( record + offsets[indexZ], attributesInfo[indexZ].type );
+        if ( hasColors() ) {
+          auto& color = colors_[i];
+          color[0]    = record[offsets[indexR]];
+          color[1]    = record[offsets[indexG]];
+          color[2]    = record[offsets[indexB]];
+        }
+        if ( hasNormals() ) {
+          auto& normal = normals_[i];
+          normal[0]    = readValue( record + offsets[indexNX], attributesInfo[indexNX].type );
+          normal[1]    = readValue( record + offsets[indexNY], attributesInfo[indexNY].type );
+          normal[2]    = readValue( record + offsets[indexNZ], attributesInfo[indexNZ].type );
+        }
+        if ( hasReflectances() ) {
+          reflectances_[i] =
+              uint16_t( readValue( record + offsets[indexReflectance], attributesInfo[indexReflectance].type ) );
         }
       }
     }
@@ -804,6 +846,199 @@ void PCCPointSet3::convertYUVToRGB() {  // BT709
   }
 }
 
+namespace {
+
+// The 16-bit colors are converted by blocks, transposed to planes for the kernels and back to the buffer format.
+const size_t colorBlockSize = 256;
+
+void yuv16ToRgb8( const uint16_t y, const uint16_t u, const uint16_t v, uint8_t& r8, uint8_t& g8, uint8_t& b8 ) {
+  const double offset = 32768.0;
+  const double scale  = 65535.0;
+  const double weight = 1.0 / scale;
+  double       y1     = weight * y;
+  double       u1     = weight * ( u - offset );
+  double       v1     = weight * ( v - offset );
+  y1                  = ( std::max )( y1, 0.0 );
+  y1                  = ( std::min )( y1, 1.0 );
+  u1                  = ( std::max )( u1, -0.5 );
+  u1                  = ( std::min )( u1, 0.5 );
+  v1                  = ( std::max )( v1, -0.5 );
+  v1                  = ( std::min )( v1, 0.5 );
+
+  //// convert normalized yuv444 to normalized rgb (fromat double)
+  const double r = y1 /*- 0.00000 * u1*/ + 1.57480 * v1;
+  const double g = y1 - 0.18733 * u1 - 0.46813 * v1;
+  const double b = y1 + 1.85563 * u1 /*+ 0.00000 * v1*/;
+
+  //// convert normalized rgb to 8-bit rgb
+  r8 = static_cast<uint8_t>( PCCClip( round( r * 255 ), 0.0, 255.0 ) );
+  g8 = static_cast<uint8_t>( PCCClip( round( g * 255 ), 0.0, 255.0 ) );
+  b8 = static_cast<uint8_t>( PCCClip( round( b * 255 ), 0.0, 255.0 ) );
+}
+
+}  // namespace
+
+void PCCPointSet3::copyRGB16ToRGB8() { convertColors16bit( false, COLOR_BUFFER_RGB8, colors_.data() ); }
+
+void PCCPointSet3::convertYUV16ToRGB8() { convertColors16bit( true, COLOR_BUFFER_RGB8, colors_.data() ); }
+
+void PCCPointSet3::convertColors16bit( const bool isYUV, const PCCColorBufferFormat format, void* buffer ) const {
+  static_assert( sizeof( PCCColor3B ) == 3 && sizeof( PCCColor16bit ) == 6, "colors must be packed triples" );
+  const size_t pointCount = getPointCount();
+  const size_t blockCount = ( pointCount + colorBlockSize - 1 ) / colorBlockSize;
+  tbb::parallel_for( tbb::blocked_range<size_t>( 0, blockCount ), [&]( const tbb::blocked_range<size_t>& blocks ) {
+    uint16_t planes16[3][colorBlockSize];
+    uint8_t  planes8[3][colorBlockSize];
+    for ( size_t block = blocks.begin(); block < blocks.end(); block++ ) {
+      const size_t         start = block * colorBlockSize;
+      const size_t         count = ( std::min )( colorBlockSize, pointCount - start );
+      const PCCColor16bit* src   = colors16bit_.data() + start;
+      for ( size_t k = 0; k < count; k++ ) {
+        planes16[0][k] = src[k][0];
+        planes16[1][k] = src[k][1];
+        planes16[2][k] = src[k][2];
+      }
+      if ( isYUV ) {
+        size_t k = yuv16ToRgb8Kernel( planes16[0], planes16[1], planes16[2], planes8[0], planes8[1], planes8[2],
+                                      count );
+        for ( ; k < count; k++ ) {
+          yuv16ToRgb8( planes16[0][k], planes16[1][k], planes16[2][k], planes8[0][k], planes8[1][k], planes8[2][k] );
+        }
+      } else {
+        // the low byte, as the 8-bit cast of the scalar copy
+        for ( size_t c = 0; c < 3; c++ ) {
+          for ( size_t k = 0; k < count; k++ ) { planes8[c][k] = uint8_t( planes16[c][k] ); }
+        }
+      }
+      switch ( format ) {
+        case COLOR_BUFFER_RGB8: {
+          uint8_t* dst = static_cast<uint8_t*>( buffer ) + 3 * start;
+          for ( size_t k = 0; k < count; k++ ) {
+            dst[3 * k]     = planes8[0][k];
+            dst[3 * k + 1] = planes8[1][k];
+            dst[3 * k + 2] = planes8[2][k];
+          }
+          break;
+        }
+        case COLOR_BUFFER_RGBA8: {
+          uint8_t* dst = static_cast<uint8_t*>( buffer ) + 4 * start;
+          for ( size_t k = 0; k < count; k++ ) {
+            dst[4 * k]     = planes8[0][k];
+            dst[4 * k + 1] = planes8[1][k];
+            dst[4 * k + 2] = planes8[2][k];
+            dst[4 * k + 3] = 255;
+          }
+          break;
+        }
+        case COLOR_BUFFER_FLOAT3: {
+          float* dst = static_cast<float*>( buffer ) + 3 * start;
+          for ( size_t k = 0; k < count; k++ ) {
+            dst[3 * k]     = planes8[0][k] * ( 1.0f / 255.0f );
+            dst[3 * k + 1] = planes8[1][k] * ( 1.0f / 255.0f );
+            dst[3 * k + 2] = planes8[2][k] * ( 1.0f / 255.0f );
+          }
+          break;
+        }
+      }
+    }
+  } );
+}
+
+namespace {
+
+// A source point of the backward direction of the color transfer, candidate for the color of a target point that is
+// among its nearest neighbors.
+template <typename ColorType>
+struct BackwardCandidate {
+  double    dist;
+  ColorType color;
+  uint32_t  source;
+};
+
+// The candidates of one target point. Removing candidates only shortens the list.
+template <typename ColorType>
+class BackwardCandidateList {
+ public:
+  BackwardCandidateList( BackwardCandidate<ColorType>* first, size_t count ) : first_( first ), count_( count ) {}
+  inline bool                          empty() const { return count_ == 0; }
+  inline size_t                        size() const { return count_; }
+  inline BackwardCandidate<ColorType>& operator[]( size_t index ) { return first_[index]; }
+  inline BackwardCandidate<ColorType>* begin() { return first_; }
+  inline BackwardCandidate<ColorType>* end() { return first_ + count_; }
+  inline void                          pop_back() { --count_; }
+  inline void                          resize( size_t count ) { count_ = std::min( count, count_ ); }
+
+ private:
+  BackwardCandidate<ColorType>* first_;
+  size_t                        count_;
+};
+
+// The backward contributions of all the source points, grouped by target point in one buffer instead of a vector per
+// target point. The sources are scattered in parallel: each target point counts its candidates, a prefix sum of the
+// counts gives where its candidates start, and atomic cursors place them. Each list is then put back in source point
+// order, so that the lists, and the colors derived from them, are the same as those of the serial scatter.
+template <typename ColorType>
+class BackwardCandidates {
+ public:
+  // results: the nearest target points of each source point; color( source ) is the color of a source point.
+  template <typename GetColor>
+  void build( PCCNNBatchResult<double>& results,
+              const size_t              pointCountTarget,
+              const double              maxGeometryDist2,
+              const bool                sortByDist,
+              GetColor                  color ) {
+    const size_t                       pointCountSource = results.queryCount();
+    const size_t                       neighborCount    = results.neighborCount();
+    std::vector<std::atomic<uint32_t>> cursors( pointCountTarget );
+    tbb::parallel_for( size_t( 0 ), pointCountSource, [&]( const size_t index ) {
+      for ( size_t i = 0; i < neighborCount; ++i ) {
+        if ( results.dist( index, i ) <= maxGeometryDist2 ) {
+          cursors[results.indices( index, i )].fetch_add( 1, std::memory_order_relaxed );
+        }
+      }
+    } );
+    offsets_.resize( pointCountTarget + 1 );
+    offsets_[0] = 0;
+    for ( size_t index = 0; index < pointCountTarget; ++index ) {
+      offsets_[index + 1] = offsets_[index] + cursors[index].load( std::memory_order_relaxed );
+      cursors[index].store( uint32_t( offsets_[index] ), std::memory_order_relaxed );
+    }
+    entries_.resize( offsets_[pointCountTarget] );
+    tbb::parallel_for( size_t( 0 ), pointCountSource, [&]( const size_t index ) {
+      const ColorType sourceColor = color( index );
+      for ( size_t i = 0; i < neighborCount; ++i ) {
+        if ( results.dist( index, i ) <= maxGeometryDist2 ) {
+          const uint32_t position = cursors[results.indices( index, i )].fetch_add( 1, std::memory_order_relaxed );
+          entries_[position]      = BackwardCandidate<ColorType>{results.dist( index, i ), sourceColor, uint32_t( index )};
+        }
+      }
+    } );
+    tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+      auto first = entries_.begin() + offsets_[index];
+      auto last  = entries_.begin() + offsets_[index + 1];
+      if ( last - first < 2 ) { return; }
+      std::sort( first, last, []( const BackwardCandidate<ColorType>& c1, const BackwardCandidate<ColorType>& c2 ) {
+        return c1.source < c2.source;
+      } );
+      if ( sortByDist ) {
+        std::sort( first, last, []( const BackwardCandidate<ColorType>& c1, const BackwardCandidate<ColorType>& c2 ) {
+          return c1.dist < c2.dist;
+        } );
+      }
+    } );
+  }
+  inline BackwardCandidateList<ColorType> operator[]( size_t target ) {
+    return BackwardCandidateList<ColorType>( entries_.data() + offsets_[target],
+                                             offsets_[target + 1] - offsets_[target] );
+  }
+
+ private:
+  std::vector<size_t>                       offsets_;
+  std::vector<BackwardCandidate<ColorType>> entries_;
+};
+
+}  // namespace
+
 bool PCCPointSet3::transferColors( PCCPointSet3& target,
                                    const int32_t searchRange,
                                    const bool    losslessAttribute,
@@ -820,14 +1055,20 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
                                    double        maxColorDist2Fwd,
                                    double        maxColorDist2Bwd,
                                    const bool    excludeColorOutlier,
-                                   const double  thresholdColorOutlierDist ) const {
+                                   const double  thresholdColorOutlierDist,
+                                   const PCCKdTree* kdtreeSource ) const {
   printf( "transferColors \n" );
   const auto&  source           = *this;
   const size_t pointCountSource = source.getPointCount();
   const size_t pointCountTarget = target.getPointCount();
   if ( ( pointCountSource == 0u ) || ( pointCountTarget == 0u ) || !source.hasColors() ) { return false; }
   PCCKdTree kdtreeTarget( target );
-  PCCKdTree kdtreeSource( source );
+  // the tree of the source if the caller holds one, see PCCSpatialIndexCache
+  PCCKdTree ownKdtreeSource;
+  if ( kdtreeSource == nullptr ) {
+    ownKdtreeSource.init( source );
+    kdtreeSource = &ownKdtreeSource;
+  }
   target.addColors();
   std::vector<PCCColor3B> refinedColors1;
   refinedColors1.resize( pointCountTarget );
@@ -841,27 +1082,26 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
   // ==========================================================================================
   // for each target point indexed by index, derive the refined color as
   // refinedColors1[index]
-  PCCNNResult result;
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    kdtreeSource.search( target[index], numNeighborsColorTransferFwd, result );
+  PCCNNBatchResult<double> resultsFwd;
+  kdtreeSource->searchBatch( target.getPositions(), numNeighborsColorTransferFwd, resultsFwd );
+  tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+    const size_t* indices   = resultsFwd.indices( index );
+    const double* distances = resultsFwd.dist( index );
     // keep the points that satisfy geometry dist threshold
-    while ( true ) {
-      if ( result.size() == 1 ) { break; }
-      if ( result.dist( int( result.size() ) - 1 ) <= maxGeometryDist2Fwd ) { break; }
-      result.popBack();
-    }
+    size_t resultCount = resultsFwd.neighborCount();
+    while ( resultCount > 1 && distances[resultCount - 1] > maxGeometryDist2Fwd ) { --resultCount; }
     bool isDone = false;
     if ( skipAvgIfIdenticalSourcePointPresentFwd ) {
-      if ( result.dist( 0 ) < 0.0001 ) {
-        refinedColors1[index] = source.getColor( result.indices( 0 ) );
+      if ( distances[0] < 0.0001 ) {
+        refinedColors1[index] = source.getColor( indices[0] );
         isDone                = true;
       }
     }
     if ( !isDone ) {
-      int nNN = static_cast<int>( result.size() );
+      int nNN = static_cast<int>( resultCount );
       while ( nNN > 0 && !isDone ) {
         if ( nNN == 1 ) {
-          refinedColors1[index] = source.getColor( result.indices( 0 ) );
+          refinedColors1[index] = source.getColor( indices[0] );
           isDone                = true;
         }
         if ( !isDone ) {
@@ -869,7 +1109,7 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
           colors.resize( 0 );
           colors.resize( nNN );
           for ( int i = 0; i < nNN; ++i ) {
-            for ( int k = 0; k < 3; ++k ) { colors[i][k] = double( source.getColor( result.indices( i ) )[k] ); }
+            for ( int k = 0; k < 3; ++k ) { colors[i][k] = double( source.getColor( indices[i] )[k] ); }
           }
           double maxColorDist2 = std::numeric_limits<double>::min();
           for ( int i = 0; i < nNN; ++i ) {
@@ -883,8 +1123,8 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
             if ( useDistWeightedAverageFwd ) {
               double sumWeights{0.0};
               for ( int i = 0; i < nNN; ++i ) {
-                const double weight = 1 / ( result.dist( i ) + distOffsetFwd );
-                for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor( result.indices( i ) )[k] * weight; }
+                const double weight = 1 / ( distances[i] + distOffsetFwd );
+                for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor( indices[i] )[k] * weight; }
                 sumWeights += weight;
               }
               refinedColor /= sumWeights;
@@ -894,16 +1134,16 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
                 sumWeights               = 0.0;
                 for ( int i = 0; i < nNN; ++i ) {
                   double      dist     = 0.0;
-                  PCCColor3B  tmpColor = source.getColor( result.indices( i ) );
+                  PCCColor3B  tmpColor = source.getColor( indices[i] );
                   PCCVector3D sourceColor( tmpColor[0], tmpColor[1], tmpColor[2] );
                   dist = ( sourceColor - refinedColor ).getNorm2();
                   if ( dist > thresholdColorOutlierDist * thresholdColorOutlierDist ) {
                     excludeCount += 1;
                     continue;
                   }
-                  const double weight = 1 / ( result.dist( i ) + distOffsetFwd );
+                  const double weight = 1 / ( distances[i] + distOffsetFwd );
                   for ( int k = 0; k < 3; ++k ) {
-                    excludeOutlierRefinedColor[k] += source.getColor( result.indices( i ) )[k] * weight;
+                    excludeOutlierRefinedColor[k] += source.getColor( indices[i] )[k] * weight;
                   }
                   sumWeights += weight;
                 }
@@ -914,7 +1154,7 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
               }
             } else {
               for ( int i = 0; i < nNN; ++i ) {
-                for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor( result.indices( i ) )[k]; }
+                for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor( indices[i] )[k]; }
               }
               refinedColor /= nNN;
             }
@@ -928,7 +1168,7 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
         }
       }
     }
-  }
+  } );
   // ==========================================================================================
   //                                  Backward direction
   // ==========================================================================================
@@ -937,28 +1177,16 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
   // colorsDists2 is iteratively refined (by removing the farthest points) until
   // the
   // std of remaining colors in it is smaller than a threshold.
-  std::vector<std::vector<DistColor8Bit>> refinedColorsDists2;
-  refinedColorsDists2.resize( pointCountTarget );
-  // populate refinedColorsDists2
-  for ( size_t index = 0; index < pointCountSource; ++index ) {
-    const PCCColor3B color = source.getColor( index );
-    kdtreeTarget.search( source[index], numNeighborsColorTransferBwd, result );
-    // keep the points that satisfy geometry dist threshold
-    for ( int i = 0; i < result.size(); ++i ) {
-      if ( result.dist( i ) <= maxGeometryDist2Bwd ) {
-        refinedColorsDists2[result.indices( i )].push_back( DistColor8Bit{result.dist( i ), color} );
-      }
-    }
-  }
-  // sort refinedColorsDists2 according to distance
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    std::sort( refinedColorsDists2[index].begin(), refinedColorsDists2[index].end(),
-               []( DistColor8Bit& dc1, DistColor8Bit& dc2 ) { return dc1.dist < dc2.dist; } );
-  }
+  PCCNNBatchResult<double> resultsBwd;
+  kdtreeTarget.searchBatch( source.getPositions(), numNeighborsColorTransferBwd, resultsBwd );
+  // populate refinedColorsDists2, each list sorted according to distance
+  BackwardCandidates<PCCColor3B> refinedColorsDists2;
+  refinedColorsDists2.build( resultsBwd, pointCountTarget, maxGeometryDist2Bwd, true,
+                             [&]( const size_t index ) { return source.getColor( index ); } );
   // compute centroid2
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
+  tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
     const PCCColor3B color1       = refinedColors1[index];       // refined color derived in forward direction
-    auto&            colorsDists2 = refinedColorsDists2[index];  // set of candidate points
+    auto             colorsDists2 = refinedColorsDists2[index];  // set of candidate points
                                                                  // derived in backward
                                                                  // direction
     if ( colorsDists2.empty() || losslessAttribute ) {
@@ -969,9 +1197,7 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
       PCCVector3D       centroid2( 0.0 );
       if ( skipAvgIfIdenticalSourcePointPresentBwd ) {
         if ( colorsDists2[0].dist < 0.0001 ) {
-          auto temp = colorsDists2[0];
-          colorsDists2.clear();
-          colorsDists2.push_back( temp );
+          colorsDists2.resize( 1 );
           for ( int k = 0; k < 3; ++k ) { centroid2[k] = colorsDists2[0].color[k]; }
           isDone = true;
         }
@@ -981,9 +1207,7 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
         while ( nNN > 0 && !isDone ) {
           nNN = static_cast<int>( colorsDists2.size() );
           if ( nNN == 1 ) {
-            auto temp = colorsDists2[0];
-            colorsDists2.clear();
-            colorsDists2.push_back( temp );
+            colorsDists2.resize( 1 );
             for ( int k = 0; k < 3; ++k ) { centroid2[k] = colorsDists2[0].color[k]; }
             isDone = true;
           }
@@ -1119,7 +1343,7 @@ bool PCCPointSet3::transferColors( PCCPointSet3& target,
         target.setColor( index, color1 );
       }
     }
-  }
+  } );
   return true;
 }
 
@@ -1155,7 +1379,8 @@ bool PCCPointSet3::transferColors16bitBP( PCCPointSet3& target,
   maxColorDist2Fwd    = ( maxColorDist2Fwd < 131072 ) ? maxColorDist2Fwd : std::numeric_limits<double>::max();
   maxColorDist2Bwd    = ( maxColorDist2Bwd < 131072 ) ? maxColorDist2Bwd : std::numeric_limits<double>::max();
   PCCPointSet3 partSource;
-  partSource.addColors();
+  partSource.addColors16bit();
+  partSource.addParentPointIndexes();
   // ==========================================================================================
   //                                     Forward direction
   // ==========================================================================================
@@ -1275,18 +1500,21 @@ bool PCCPointSet3::transferColors16bitBP( PCCPointSet3& target,
   if ( filterType == 1 ) {
     refinedColorsDists2.resize( pointCountTarget );
     // populate refinedColorsDists2
-    auto sampleSetPointCount = partSource.getPointCount();
+    auto                     sampleSetPointCount = partSource.getPointCount();
+    PCCNNBatchResult<double> resultsBwd;
+    kdtreeTarget.searchBatch( partSource.getPositions(), numNeighborsColorTransferBwd, resultsBwd );
     for ( size_t index = 0; index < sampleSetPointCount; ++index ) {
       const PCCColor16bit color = partSource.getColor16bit( index );
-      kdtreeTarget.search( partSource[index], numNeighborsColorTransferBwd, result );
       // keep the points that satisfy geometry dist threshold
-      for ( int i = 0; i < result.size(); ++i ) {
-        if ( result.dist( i ) <= maxGeometryDist2Bwd ) {
-          if ( std::abs( color[0] - target.getColor16bit()[result.indices( i )][0] ) < 40 &&
-               std::abs( color[1] - target.getColor16bit()[result.indices( i )][1] ) < 40 &&
-               std::abs( color[2] - target.getColor16bit()[result.indices( i )][2] ) < 40 )
-            refinedColorsDists2[result.indices( i )].push_back( DistColor{
-                result.dist( i ), color, target[result.indices( i )], partSource.getParentPointIndex( index ), index} );
+      for ( size_t i = 0; i < resultsBwd.neighborCount(); ++i ) {
+        const size_t indexInTarget = resultsBwd.indices( index, i );
+        if ( resultsBwd.dist( index, i ) <= maxGeometryDist2Bwd ) {
+          if ( std::abs( color[0] - target.getColor16bit()[indexInTarget][0] ) < 40 &&
+               std::abs( color[1] - target.getColor16bit()[indexInTarget][1] ) < 40 &&
+               std::abs( color[2] - target.getColor16bit()[indexInTarget][2] ) < 40 )
+            refinedColorsDists2[indexInTarget].push_back( DistColor{resultsBwd.dist( index, i ), color,
+                                                                    target[indexInTarget],
+                                                                    partSource.getParentPointIndex( index ), index} );
         }
       }
     }
@@ -1299,13 +1527,15 @@ bool PCCPointSet3::transferColors16bitBP( PCCPointSet3& target,
   } else {
     // populate refinedColorsDists2
     refinedColorsDists2.resize( pointCountTarget );
+    PCCNNBatchResult<double> resultsBwd;
+    kdtreeTarget.searchBatch( source.getPositions(), numNeighborsColorTransferBwd, resultsBwd );
     for ( size_t index = 0; index < pointCountSource; ++index ) {
       const PCCColor16bit color = source.getColor16bit( index );
-      kdtreeTarget.search( source[index], numNeighborsColorTransferBwd, result );
       // keep the points that satisfy geometry dist threshold
-      for ( int i = 0; i < result.size(); ++i ) {
-        if ( result.dist( i ) <= maxGeometryDist2Bwd ) {
-          refinedColorsDists2[result.indices( i )].push_back( DistColor{result.dist( i ), color} );
+      for ( size_t i = 0; i < resultsBwd.neighborCount(); ++i ) {
+        if ( resultsBwd.dist( index, i ) <= maxGeometryDist2Bwd ) {
+          refinedColorsDists2[resultsBwd.indices( index, i )].push_back(
+              DistColor{resultsBwd.dist( index, i ), color} );
         }
       }
     }
@@ -1524,7 +1754,8 @@ bool PCCPointSet3::transferColorsBackward16bitBP( PCCPointSet3& target,
   refinedColors1.resize( pointCountTarget );
 
   PCCPointSet3 partTarget;
-  partTarget.addColors();
+  partTarget.addColors16bit();
+  partTarget.addParentPointIndexes();
   if ( filterType == 9 ) {
     for ( size_t index = 0; index < pointCountTarget; ++index ) {
       if ( target.getBoundaryPointType( index ) == 3 ) {
@@ -1812,27 +2043,26 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
   // ==========================================================================================
   // for each target point indexed by index, derive the refined color as
   // refinedColors1[index]
-  PCCNNResult result;
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    kdtreeSource.search( target[index], numNeighborsColorTransferFwd, result );
+  PCCNNBatchResult<double> resultsFwd;
+  kdtreeSource.searchBatch( target.getPositions(), numNeighborsColorTransferFwd, resultsFwd );
+  tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+    const size_t* indices   = resultsFwd.indices( index );
+    const double* distances = resultsFwd.dist( index );
     // keep the points that satisfy geometry dist threshold
-    while ( true ) {
-      if ( result.size() == 1 ) { break; }
-      if ( result.dist( int( result.size() ) - 1 ) <= maxGeometryDist2Fwd ) { break; }
-      result.popBack();
-    }
+    size_t resultCount = resultsFwd.neighborCount();
+    while ( resultCount > 1 && distances[resultCount - 1] > maxGeometryDist2Fwd ) { --resultCount; }
     bool isDone = false;
     if ( skipAvgIfIdenticalSourcePointPresentFwd ) {
-      if ( result.dist( 0 ) < 0.0001 ) {
-        refinedColors1[index] = source.getColor16bit( result.indices( 0 ) );
+      if ( distances[0] < 0.0001 ) {
+        refinedColors1[index] = source.getColor16bit( indices[0] );
         isDone                = true;
       }
     }
     if ( !isDone ) {
-      int nNN = static_cast<int>( result.size() );
+      int nNN = static_cast<int>( resultCount );
       while ( nNN > 0 && !isDone ) {
         if ( nNN == 1 ) {
-          refinedColors1[index] = source.getColor16bit( result.indices( 0 ) );
+          refinedColors1[index] = source.getColor16bit( indices[0] );
           isDone                = true;
         }
         if ( !isDone ) {
@@ -1840,7 +2070,7 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
           colors.resize( 0 );
           colors.resize( nNN );
           for ( int i = 0; i < nNN; ++i ) {
-            for ( int k = 0; k < 3; ++k ) { colors[i][k] = double( source.getColor16bit( result.indices( i ) )[k] ); }
+            for ( int k = 0; k < 3; ++k ) { colors[i][k] = double( source.getColor16bit( indices[i] )[k] ); }
           }
           double maxColorDist2 = std::numeric_limits<double>::min();
           for ( int i = 0; i < nNN; ++i ) {
@@ -1854,9 +2084,9 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
             if ( useDistWeightedAverageFwd ) {
               double sumWeights{0.0};
               for ( int i = 0; i < nNN; ++i ) {
-                const double weight = 1 / ( result.dist( i ) + distOffsetFwd );
+                const double weight = 1 / ( distances[i] + distOffsetFwd );
                 for ( int k = 0; k < 3; ++k ) {
-                  refinedColor[k] += source.getColor16bit( result.indices( i ) )[k] * weight;
+                  refinedColor[k] += source.getColor16bit( indices[i] )[k] * weight;
                 }
                 sumWeights += weight;
               }
@@ -1866,16 +2096,16 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
                 size_t      excludeCount = 0;
                 sumWeights               = 0.0;
                 for ( int i = 0; i < nNN; ++i ) {
-                  PCCColor16bit tmpColor = source.getColor16bit( result.indices( i ) );
+                  PCCColor16bit tmpColor = source.getColor16bit( indices[i] );
                   PCCVector3D   sourceColor( tmpColor[0], tmpColor[1], tmpColor[2] );
                   double        dist = ( sourceColor - refinedColor ).getNorm2();
                   if ( dist > thresholdColorOutlierDist * thresholdColorOutlierDist * 256.0 * 256.0 ) {
                     excludeCount += 1;
                     continue;
                   }
-                  const double weight = 1 / ( result.dist( i ) + distOffsetFwd );
+                  const double weight = 1 / ( distances[i] + distOffsetFwd );
                   for ( int k = 0; k < 3; ++k ) {
-                    excludeOutlierRefinedColor[k] += source.getColor16bit( result.indices( i ) )[k] * weight;
+                    excludeOutlierRefinedColor[k] += source.getColor16bit( indices[i] )[k] * weight;
                   }
                   sumWeights += weight;
                 }
@@ -1886,7 +2116,7 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
               }
             } else {
               for ( int i = 0; i < nNN; ++i ) {
-                for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor16bit( result.indices( i ) )[k]; }
+                for ( int k = 0; k < 3; ++k ) { refinedColor[k] += source.getColor16bit( indices[i] )[k]; }
               }
               refinedColor /= nNN;
             }
@@ -1900,7 +2130,7 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
         }
       }
     }
-  }
+  } );
   // ==========================================================================================
   //                                  Backward direction
   // ==========================================================================================
@@ -1909,28 +2139,16 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
   // colorsDists2 is iteratively refined (by removing the farthest points) until
   // the
   // std of remaining colors in it is smaller than a threshold.
-  std::vector<std::vector<DistColor>> refinedColorsDists2;
-  refinedColorsDists2.resize( pointCountTarget );
-  // populate refinedColorsDists2
-  for ( size_t index = 0; index < pointCountSource; ++index ) {
-    const PCCColor16bit color = source.getColor16bit( index );
-    kdtreeTarget.search( source[index], numNeighborsColorTransferBwd, result );
-    // keep the points that satisfy geometry dist threshold
-    for ( int i = 0; i < result.size(); ++i ) {
-      if ( result.dist( i ) <= maxGeometryDist2Bwd ) {
-        refinedColorsDists2[result.indices( i )].push_back( DistColor{result.dist( i ), color} );
-      }
-    }
-  }
-  // sort refinedColorsDists2 according to distance
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    std::sort( refinedColorsDists2[index].begin(), refinedColorsDists2[index].end(),
-               []( DistColor& dc1, DistColor& dc2 ) { return dc1.dist < dc2.dist; } );
-  }
+  PCCNNBatchResult<double> resultsBwd;
+  kdtreeTarget.searchBatch( source.getPositions(), numNeighborsColorTransferBwd, resultsBwd );
+  // populate refinedColorsDists2, each list sorted according to distance
+  BackwardCandidates<PCCColor16bit> refinedColorsDists2;
+  refinedColorsDists2.build( resultsBwd, pointCountTarget, maxGeometryDist2Bwd, true,
+                             [&]( const size_t index ) { return source.getColor16bit( index ); } );
   // compute centroid2
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
+  tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
     const PCCColor16bit color1       = refinedColors1[index];       // refined color derived in forward direction
-    auto&               colorsDists2 = refinedColorsDists2[index];  // set of candidate points
+    auto                colorsDists2 = refinedColorsDists2[index];  // set of candidate points
                                                                     // derived in backward
                                                                     // direction
     if ( colorsDists2.empty() || losslessAttribute ) {
@@ -1941,9 +2159,7 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
       PCCVector3D       centroid2( 0.0 );
       if ( skipAvgIfIdenticalSourcePointPresentBwd ) {
         if ( colorsDists2[0].dist < 0.0001 ) {
-          auto temp = colorsDists2[0];
-          colorsDists2.clear();
-          colorsDists2.push_back( temp );
+          colorsDists2.resize( 1 );
           for ( int k = 0; k < 3; ++k ) { centroid2[k] = colorsDists2[0].color[k]; }
           isDone = true;
         }
@@ -1953,9 +2169,7 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
         while ( nNN > 0 && !isDone ) {
           nNN = static_cast<int>( colorsDists2.size() );
           if ( nNN == 1 ) {
-            auto temp = colorsDists2[0];
-            colorsDists2.clear();
-            colorsDists2.push_back( temp );
+            colorsDists2.resize( 1 );
             for ( int k = 0; k < 3; ++k ) { centroid2[k] = colorsDists2[0].color[k]; }
             isDone = true;
           }
@@ -2091,7 +2305,7 @@ bool PCCPointSet3::transferColors16bit( PCCPointSet3& target,
         target.setColor16bit( index, color1 );
       }
     }
-  }
+  } );
   return true;
 }
 bool PCCPointSet3::transferColorsFilter3( PCCPointSet3& target,
@@ -2106,27 +2320,24 @@ bool PCCPointSet3::transferColorsFilter3( PCCPointSet3& target,
   PCCKdTree kdtreeTarget( target );
   PCCKdTree kdtreeSource( source );
   target.addColors();
-  std::vector<PCCColor3B>              refinedColors1;
-  std::vector<std::vector<PCCColor3B>> refinedColors2;
+  std::vector<PCCColor3B>        refinedColors1;
+  BackwardCandidates<PCCColor3B> refinedColors2;
   refinedColors1.resize( pointCountTarget );
-  refinedColors2.resize( pointCountTarget );
   const size_t num_results = 1;
-  PCCNNResult  result;
   //  Find THE closest point in reconstruction to each source point
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    kdtreeSource.search( target[index], num_results, result );
-    refinedColors1[index] = source.getColor( result.indices( 0 ) );
-  }
+  PCCNNBatchResult<double> results;
+  kdtreeSource.searchBatch( target.getPositions(), num_results, results );
+  tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+    refinedColors1[index] = source.getColor( results.indices( index, 0 ) );
+  } );
   //  Find points in source that are closest to point in reconstruction
-  for ( size_t index = 0; index < pointCountSource; ++index ) {
-    const PCCColor3B color = source.getColor( index );
-    kdtreeTarget.search( source[index], num_results, result );
-    refinedColors2[result.indices( 0 )].push_back( color );
-  }
+  kdtreeTarget.searchBatch( source.getPositions(), num_results, results );
+  refinedColors2.build( results, pointCountTarget, std::numeric_limits<double>::max(), false,
+                        [&]( const size_t index ) { return source.getColor( index ); } );
 
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    const PCCColor3B               color1  = refinedColors1[index];
-    const std::vector<PCCColor3B>& colors2 = refinedColors2[index];
+  tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+    const PCCColor3B color1  = refinedColors1[index];
+    auto             colors2 = refinedColors2[index];
     if ( colors2.empty() || losslessAttribute ) {
       target.setColor( index, color1 );
     } else {
@@ -2134,14 +2345,14 @@ bool PCCPointSet3::transferColorsFilter3( PCCPointSet3& target,
       const PCCVector3D centroid1( color1[0], color1[1], color1[2] );
       PCCVector3D       centroid2( 0.0 );
       for ( const auto& color2 : colors2 ) {
-        for ( size_t k = 0; k < 3; ++k ) { centroid2[k] += color2[k]; }
+        for ( size_t k = 0; k < 3; ++k ) { centroid2[k] += color2.color[k]; }
       }
       centroid2 /= H;
 
       double D2 = 0.0;
       for ( const auto& color2 : colors2 ) {
         for ( size_t k = 0; k < 3; ++k ) {
-          const double d2 = centroid2[k] - color2[k];
+          const double d2 = centroid2[k] - color2.color[k];
           D2 += d2 * d2;
         }
       }
@@ -2166,7 +2377,7 @@ bool PCCPointSet3::transferColorsFilter3( PCCPointSet3& target,
         target.setColor( index, color1 );
       }
     }
-  }
+  } );
   return true;
 }
 
@@ -2181,24 +2392,21 @@ bool PCCPointSet3::transferColorSimple( PCCPointSet3& target, const double bestC
   PCCKdTree kdtreeSource( source );
   PCCKdTree kdtreeTarget( target );
 
-  std::vector<PCCColor3B>              refinedColors1;
-  std::vector<std::vector<PCCColor3B>> refinedColors2;
+  std::vector<PCCColor3B>        refinedColors1;
+  BackwardCandidates<PCCColor3B> refinedColors2;
   refinedColors1.resize( pointCountTarget );
-  refinedColors2.resize( pointCountTarget );
   const size_t num_results = 1;
-  PCCNNResult  result;
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    kdtreeSource.search( target[index], num_results, result );
-    refinedColors1[index] = source.getColor( result.indices( 0 ) );
-  }
-  for ( size_t index = 0; index < pointCountSource; ++index ) {
-    const PCCColor3B color = source.getColor( index );
-    kdtreeTarget.search( source[index], num_results, result );
-    refinedColors2[result.indices( 0 )].push_back( color );
-  }
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    const PCCColor3B              color1  = refinedColors1[index];
-    const std::vector<PCCColor3B> colors2 = refinedColors2[index];
+  PCCNNBatchResult<double> results;
+  kdtreeSource.searchBatch( target.getPositions(), num_results, results );
+  tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+    refinedColors1[index] = source.getColor( results.indices( index, 0 ) );
+  } );
+  kdtreeTarget.searchBatch( source.getPositions(), num_results, results );
+  refinedColors2.build( results, pointCountTarget, std::numeric_limits<double>::max(), false,
+                        [&]( const size_t index ) { return source.getColor( index ); } );
+  tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+    const PCCColor3B color1  = refinedColors1[index];
+    auto             colors2 = refinedColors2[index];
     if ( colors2.empty() ) {
       target.setColor( index, color1 );
     } else {
@@ -2212,7 +2420,7 @@ bool PCCPointSet3::transferColorSimple( PCCPointSet3& target, const double bestC
         const double w2 = 1.0 - w1;
         PCCVector3D  color( 0.0 );
         for ( const auto& color2 : colors2 ) {
-          for ( size_t k = 0; k < 3; ++k ) { color[k] += color2[k]; }
+          for ( size_t k = 0; k < 3; ++k ) { color[k] += color2.color[k]; }
         }
         for ( size_t k = 0; k < 3; ++k ) {
           color[k] = ( std::min )( round( w2 * s * color[k] + w1 * color1[k] ), 255.0 );
@@ -2228,7 +2436,7 @@ bool PCCPointSet3::transferColorSimple( PCCPointSet3& target, const double bestC
         double e2 = 0.0;
         for ( const auto& color2 : colors2 ) {
           for ( size_t k = 0; k < 3; ++k ) {
-            const double d = color[k] - color2[k];
+            const double d = color[k] - color2.color[k];
             e2 += d * d;
           }
         }
@@ -2243,7 +2451,7 @@ bool PCCPointSet3::transferColorSimple( PCCPointSet3& target, const double bestC
       }
       target.setColor( index, PCCColor3B( uint8_t( bestColor[0] ), uint8_t( bestColor[1] ), uint8_t( bestColor[2] ) ) );
     }
-  }
+  } );
   return true;
 }
 
@@ -2253,17 +2461,20 @@ bool PCCPointSet3::transferColorWeight( PCCPointSet3& target, const double bestC
   const size_t pointCountTarget = target.getPointCount();
   if ( ( pointCountSource == 0u ) || ( pointCountTarget == 0u ) || !source.hasColors() ) { return false; }
   target.addColors16bit();
-  PCCKdTree    kdtreeSource( source );
-  PCCNNResult  result;
-  const size_t num_results = 5;
-  for ( size_t index = 0; index < pointCountTarget; ++index ) {
-    kdtreeSource.search( target[index], num_results, result );
-    PCCVector3D color16bit( 0.0 );
-    if ( result.size() > 1 && result.dist( 0 ) > 0.0001 ) {
+  PCCKdTree                kdtreeSource( source );
+  PCCNNBatchResult<double> results;
+  const size_t             num_results = 5;
+  kdtreeSource.searchBatch( target.getPositions(), num_results, results );
+  tbb::parallel_for( size_t( 0 ), pointCountTarget, [&]( const size_t index ) {
+    const size_t  resultCount = results.neighborCount();
+    const size_t* indices     = results.indices( index );
+    const double* dist        = results.dist( index );
+    PCCVector3D   color16bit( 0.0 );
+    if ( resultCount > 1 && dist[0] > 0.0001 ) {
       double sum = 0;
-      for ( size_t i = 0; i < result.size(); ++i ) {
-        const double w     = 1.0 / pow( result.dist( i ), 2.0 );
-        auto         found = source.getColor16bit( result.indices( i ) );
+      for ( size_t i = 0; i < resultCount; ++i ) {
+        const double w     = 1.0 / pow( dist[i], 2.0 );
+        auto         found = source.getColor16bit( indices[i] );
         PCCVector3D  scaled;
         scaled = found;
         color16bit += scaled * w;
@@ -2271,11 +2482,11 @@ bool PCCPointSet3::transferColorWeight( PCCPointSet3& target, const double bestC
       }
       color16bit /= sum;
     } else {
-      const auto& found = source.getColor16bit( result.indices( 0 ) );
+      const auto& found = source.getColor16bit( indices[0] );
       color16bit        = found;
     }
     target.getColor16bit( index ) = color16bit;
-  }
+  } );
   return true;
 }
 
@@ -0,0 +1,214 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCPointSetKernels.h"
+
+#include <algorithm>
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#define PCC_KERNELS_AVX2
+#include <immintrin.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define PCC_TARGET_AVX2
+#else
+#define PCC_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#endif
+#endif
+
+using namespace pcc;
+
+#ifdef PCC_KERNELS_AVX2
+
+// PccLibCommon does not link the color converter, so it has its own copy of hasAvx2()
+static bool detectAvx2() {
+#if defined( _MSC_VER )
+  int info[4];
+  __cpuid( info, 0 );
+  if ( info[0] < 7 ) { return false; }
+  __cpuid( info, 1 );
+  // the OS must save the ymm registers
+  if ( ( info[2] & ( 1 << 27 ) ) == 0 || ( info[2] & ( 1 << 28 ) ) == 0 ) { return false; }
+  if ( ( _xgetbv( 0 ) & 6 ) != 6 ) { return false; }
+  __cpuidex( info, 7, 0 );
+  return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+  return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+}
+
+static bool useAvx2() {
+  static const bool avx2 = detectAvx2();
+  return avx2;
+}
+
+PCC_TARGET_AVX2 static inline __m256d load4( const uint16_t* src ) {
+  return _mm256_cvtepi32_pd( _mm_cvtepu16_epi32( _mm_loadl_epi64( (const __m128i*)src ) ) );
+}
+
+// 8 values already rounded and clipped to [0, 255]
+PCC_TARGET_AVX2 static inline void store8( uint8_t* dst, __m256d low, __m256d high ) {
+  __m128i packed = _mm_packs_epi32( _mm256_cvttpd_epi32( low ), _mm256_cvttpd_epi32( high ) );
+  _mm_storel_epi64( (__m128i*)dst, _mm_packus_epi16( packed, packed ) );
+}
+
+// std::round(): nearest, halfway cases away from zero; x - trunc( x ) is exact
+PCC_TARGET_AVX2 static inline __m256d roundHalfAway( __m256d x ) {
+  const __m256d one       = _mm256_set1_pd( 1. );
+  const __m256d truncated = _mm256_round_pd( x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC );
+  const __m256d fraction  = _mm256_sub_pd( x, truncated );
+  const __m256d up        = _mm256_and_pd( _mm256_cmp_pd( fraction, _mm256_set1_pd( 0.5 ), _CMP_GE_OQ ), one );
+  const __m256d down      = _mm256_and_pd( _mm256_cmp_pd( fraction, _mm256_set1_pd( -0.5 ), _CMP_LE_OQ ), one );
+  return _mm256_sub_pd( _mm256_add_pd( truncated, up ), down );
+}
+
+// clamp( v, a, b ) = v < a ? a : ( v > b ? b : v ): max/min return their second operand unless the first wins
+PCC_TARGET_AVX2 static inline __m256d clamp( __m256d v, __m256d a, __m256d b ) {
+  return _mm256_min_pd( b, _mm256_max_pd( a, v ) );
+}
+
+// PCCClip( round( x * 255 ), 0.0, 255.0 )
+PCC_TARGET_AVX2 static inline __m256d toRgb8( __m256d x ) {
+  return clamp( roundHalfAway( _mm256_mul_pd( x, _mm256_set1_pd( 255. ) ) ), _mm256_setzero_pd(),
+                _mm256_set1_pd( 255. ) );
+}
+
+PCC_TARGET_AVX2 static size_t yuv16ToRgb8Avx2( const uint16_t* y,
+                                               const uint16_t* u,
+                                               const uint16_t* v,
+                                               uint8_t*        r,
+                                               uint8_t*        g,
+                                               uint8_t*        b,
+                                               size_t          count ) {
+  const __m256d weight   = _mm256_set1_pd( 1.0 / 65535.0 );
+  const __m256d offset   = _mm256_set1_pd( 32768.0 );
+  const __m256d zero     = _mm256_setzero_pd();
+  const __m256d one      = _mm256_set1_pd( 1.0 );
+  const __m256d halfLow  = _mm256_set1_pd( -0.5 );
+  const __m256d halfHigh = _mm256_set1_pd( 0.5 );
+  const __m256d rv       = _mm256_set1_pd( 1.57480 );
+  const __m256d gu       = _mm256_set1_pd( 0.18733 );
+  const __m256d gv       = _mm256_set1_pd( 0.46813 );
+  const __m256d bu       = _mm256_set1_pd( 1.85563 );
+  size_t        i        = 0;
+  for ( ; i + 8 <= count; i += 8 ) {
+    __m256d rgb[3][2];
+    for ( size_t h = 0; h < 2; h++ ) {
+      const __m256d y1 = clamp( _mm256_mul_pd( weight, load4( y + i + 4 * h ) ), zero, one );
+      const __m256d u1 =
+          clamp( _mm256_mul_pd( weight, _mm256_sub_pd( load4( u + i + 4 * h ), offset ) ), halfLow, halfHigh );
+      const __m256d v1 =
+          clamp( _mm256_mul_pd( weight, _mm256_sub_pd( load4( v + i + 4 * h ), offset ) ), halfLow, halfHigh );
+      rgb[0][h] = toRgb8( _mm256_add_pd( y1, _mm256_mul_pd( rv, v1 ) ) );
+      rgb[1][h] = toRgb8( _mm256_sub_pd( _mm256_sub_pd( y1, _mm256_mul_pd( gu, u1 ) ), _mm256_mul_pd( gv, v1 ) ) );
+      rgb[2][h] = toRgb8( _mm256_add_pd( y1, _mm256_mul_pd( bu, u1 ) ) );
+    }
+    store8( r + i, rgb[0][0], rgb[0][1] );
+    store8( g + i, rgb[1][0], rgb[1][1] );
+    store8( b + i, rgb[2][0], rgb[2][1] );
+  }
+  return i;
+}
+
+size_t pcc::yuv16ToRgb8Kernel( const uint16_t* y,
+                               const uint16_t* u,
+                               const uint16_t* v,
+                               uint8_t*        r,
+                               uint8_t*        g,
+                               uint8_t*        b,
+                               size_t          count ) {
+  return useAvx2() ? yuv16ToRgb8Avx2( y, u, v, r, g, b, count ) : 0;
+}
+
+PCC_TARGET_AVX2 static size_t thresholdOccupancyAvx2( const uint8_t* src,
+                                                      size_t         count,
+                                                      size_t         threshold,
+                                                      uint64_t*      bits ) {
+  const size_t words = count / 64;
+  if ( threshold >= 255 ) {
+    std::fill( bits, bits + words, 0 );
+    return words * 64;
+  }
+  // src > threshold exactly when max( src, threshold + 1 ) == src
+  const __m256i limit = _mm256_set1_epi8( static_cast<char>( threshold + 1 ) );
+  for ( size_t w = 0; w < words; w++, src += 64 ) {
+    const __m256i low     = _mm256_loadu_si256( (const __m256i*)src );
+    const __m256i high    = _mm256_loadu_si256( (const __m256i*)( src + 32 ) );
+    const __m256i lowSet  = _mm256_cmpeq_epi8( _mm256_max_epu8( low, limit ), low );
+    const __m256i highSet = _mm256_cmpeq_epi8( _mm256_max_epu8( high, limit ), high );
+    bits[w] = uint64_t( static_cast<uint32_t>( _mm256_movemask_epi8( lowSet ) ) ) |
+              ( uint64_t( static_cast<uint32_t>( _mm256_movemask_epi8( highSet ) ) ) << 32 );
+  }
+  return words * 64;
+}
+
+// Each group of 8 outputs takes the 8 / precision bits it covers, which never straddle two words, and lane i keeps
+// bit i / precision of them.
+PCC_TARGET_AVX2 static size_t expandOccupancyAvx2( const uint64_t* bits, size_t shift, uint32_t* dst, size_t count ) {
+  const __m256i lanes = _mm256_srli_epi32( _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ), static_cast<int>( shift ) );
+  const __m256i masks = _mm256_sllv_epi32( _mm256_set1_epi32( 1 ), lanes );
+  const size_t  step  = 8 >> shift;
+  size_t        i     = 0;
+  for ( size_t bit = 0; i + 8 <= count; i += 8, bit += step ) {
+    const __m256i group = _mm256_set1_epi32( static_cast<int>( ( bits[bit >> 6] >> ( bit & 63 ) ) & 0xFF ) );
+    const __m256i set   = _mm256_cmpeq_epi32( _mm256_and_si256( group, masks ), masks );
+    _mm256_storeu_si256( (__m256i*)( dst + i ), _mm256_srli_epi32( set, 31 ) );
+  }
+  return i;
+}
+
+size_t pcc::thresholdOccupancyKernel( const uint8_t* src, size_t count, size_t threshold, uint64_t* bits ) {
+  return useAvx2() ? thresholdOccupancyAvx2( src, count, threshold, bits ) : 0;
+}
+
+size_t pcc::expandOccupancyKernel( const uint64_t* bits, size_t precision, uint32_t* dst, size_t count ) {
+  if ( !useAvx2() ) { return 0; }
+  switch ( precision ) {
+    case 1: return expandOccupancyAvx2( bits, 0, dst, count );
+    case 2: return expandOccupancyAvx2( bits, 1, dst, count );
+    case 4: return expandOccupancyAvx2( bits, 2, dst, count );
+    case 8: return expandOccupancyAvx2( bits, 3, dst, count );
+    default: return 0;
+  }
+}
+
+#else
+
+size_t pcc::yuv16ToRgb8Kernel( const uint16_t*, const uint16_t*, const uint16_t*, uint8_t*, uint8_t*, uint8_t*, size_t ) {
+  return 0;
+}
+
+size_t pcc::thresholdOccupancyKernel( const uint8_t*, size_t, size_t, uint64_t* ) { return 0; }
+
+size_t pcc::expandOccupancyKernel( const uint64_t*, size_t, uint32_t*, size_t ) { return 0; }
+
+#endif
@@ -0,0 +1,243 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2018, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCProfiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+//===========================================================================
+
+namespace pcc {
+namespace profiler {
+namespace detail {
+static const size_t kRingSize      = 4096;
+static const size_t kHistogramSize = 32;
+static const size_t kMaxDepth      = 64;
+
+// Closed zone waiting to be merged; the names are the literals given to begin().
+struct Record {
+  const char* name;
+  const char* parent;
+  int64_t     duration;  // ns
+};
+
+// Zones still open on a thread.
+struct OpenZone {
+  const char*                   name;
+  pcc::chrono::Stopwatch<clock> stopwatch;
+};
+
+// Per thread state. The mutex is only contended while a report is merging the buffer.
+struct ThreadBuffer {
+  std::mutex            mutex;
+  std::vector<Record>   ring;
+  std::vector<OpenZone> stack;
+  ThreadBuffer() {
+    ring.reserve( kRingSize );
+    stack.reserve( kMaxDepth );
+  }
+};
+
+struct Aggregate {
+  size_t  count = 0;
+  int64_t total = 0;
+  int64_t min   = INT64_MAX;
+  int64_t max   = 0;
+  size_t  histogram[kHistogramSize] = {};
+};
+
+typedef std::pair<std::string, std::string> ZoneKey;  // ( parent, name )
+
+struct Registry {
+  std::mutex                                 mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::map<ZoneKey, Aggregate>               zones;
+};
+
+static Registry& registry() {
+  static Registry instance;
+  return instance;
+}
+
+// Registered on first use; the registry keeps the buffer alive after the thread exits.
+static ThreadBuffer& threadBuffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer;
+  if ( !buffer ) {
+    buffer = std::make_shared<ThreadBuffer>();
+    auto&                       reg = registry();
+    std::lock_guard<std::mutex> lock( reg.mutex );
+    reg.buffers.push_back( buffer );
+  }
+  return *buffer;
+}
+
+// Bucket b holds the durations in [2^(b-1), 2^b) us, bucket 0 everything below 1 us.
+static size_t bucket( int64_t duration ) {
+  int64_t us = duration / 1000;
+  size_t  b  = 0;
+  while ( us > 0 && b + 1 < kHistogramSize ) {
+    us >>= 1;
+    b++;
+  }
+  return b;
+}
+
+// Called with both the registry and the buffer mutexes held.
+static void merge( Registry& reg, ThreadBuffer& buffer ) {
+  for ( const auto& record : buffer.ring ) {
+    auto& zone = reg.zones[ZoneKey( record.parent ? record.parent : "", record.name )];
+    zone.count++;
+    zone.total += record.duration;
+    zone.min = std::min( zone.min, record.duration );
+    zone.max = std::max( zone.max, record.duration );
+    zone.histogram[bucket( record.duration )]++;
+  }
+  buffer.ring.clear();
+}
+
+static void printBucket( FILE* out, size_t b ) {
+  // upper bound of the bucket
+  double us = static_cast<double>( 1ull << b );
+  if ( us < 1000. ) {
+    fprintf( out, " <%.0fus", us );
+  } else if ( us < 1000000. ) {
+    fprintf( out, " <%.0fms", us / 1000. );
+  } else {
+    fprintf( out, " <%.0fs", us / 1000000. );
+  }
+}
+
+static void printTree( FILE* out, const Registry& reg, const std::string& parent, size_t depth ) {
+  if ( depth >= kMaxDepth ) { return; }
+  auto begin = reg.zones.lower_bound( ZoneKey( parent, std::string() ) );
+  for ( auto it = begin; it != reg.zones.end() && it->first.first == parent; ++it ) {
+    const auto&       zone = it->second;
+    const std::string name = std::string( 2 * depth, ' ' ) + it->first.second;
+    fprintf( out, "%-40s %8zu %12.3f %10.3f %10.3f %10.3f\n", name.c_str(), zone.count, zone.total / 1e6,
+             zone.total / 1e6 / zone.count, zone.min / 1e6, zone.max / 1e6 );
+    fprintf( out, "%*s", static_cast<int>( 2 * depth + 2 ), "" );
+    for ( size_t b = 0; b < kHistogramSize; b++ ) {
+      if ( zone.histogram[b] == 0 ) { continue; }
+      printBucket( out, b );
+      fprintf( out, ":%zu", zone.histogram[b] );
+    }
+    fprintf( out, "\n" );
+    if ( it->first.second != parent ) { printTree( out, reg, it->first.second, depth + 1 ); }
+  }
+}
+}  // namespace detail
+}  // namespace profiler
+}  // namespace pcc
+
+//===========================================================================
+
+using namespace pcc::profiler::detail;
+
+void pcc::profiler::begin( const char* name ) {
+  auto& buffer = threadBuffer();
+  buffer.stack.push_back( OpenZone{name, {}} );
+  buffer.stack.back().stopwatch.start();
+}
+
+//---------------------------------------------------------------------------
+
+void pcc::profiler::end( const char* name ) {
+  auto& buffer = threadBuffer();
+  if ( buffer.stack.empty() ) { return; }
+  const auto  duration = buffer.stack.back().stopwatch.stop();
+  const char* parent   = buffer.stack.size() > 1 ? buffer.stack[buffer.stack.size() - 2].name : nullptr;
+  buffer.stack.pop_back();
+  std::unique_lock<std::mutex> lock( buffer.mutex );
+  buffer.ring.push_back(
+      Record{name, parent, std::chrono::duration_cast<std::chrono::nanoseconds>( duration ).count()} );
+  if ( buffer.ring.size() >= kRingSize ) {
+    lock.unlock();
+    auto&                       reg = registry();
+    std::lock_guard<std::mutex> regLock( reg.mutex );
+    std::lock_guard<std::mutex> bufLock( buffer.mutex );
+    merge( reg, buffer );
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void pcc::profiler::report( FILE* out ) {
+  auto&                       reg = registry();
+  std::lock_guard<std::mutex> lock( reg.mutex );
+  for ( auto& buffer : reg.buffers ) {
+    std::lock_guard<std::mutex> bufLock( buffer->mutex );
+    merge( reg, *buffer );
+  }
+  fprintf( out, "%-40s %8s %12s %10s %10s %10s\n", "Profile zone", "count", "total(ms)", "mean(ms)", "min(ms)",
+           "max(ms)" );
+  printTree( out, reg, std::string(), 0 );
+  fflush( out );
+}
+
+//---------------------------------------------------------------------------
+
+void pcc::profiler::totals( std::map<std::string, ZoneTotal>& zones ) {
+  auto&                       reg = registry();
+  std::lock_guard<std::mutex> lock( reg.mutex );
+  for ( auto& buffer : reg.buffers ) {
+    std::lock_guard<std::mutex> bufLock( buffer->mutex );
+    merge( reg, *buffer );
+  }
+  zones.clear();
+  for ( const auto& it : reg.zones ) {
+    auto& zone = zones[it.first.second];
+    zone.count += it.second.count;
+    zone.total += it.second.total;
+    zone.max = std::max( zone.max, it.second.max );
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void pcc::profiler::reset() {
+  auto&                       reg = registry();
+  std::lock_guard<std::mutex> lock( reg.mutex );
+  for ( auto& buffer : reg.buffers ) {
+    std::lock_guard<std::mutex> bufLock( buffer->mutex );
+    buffer->ring.clear();
+  }
+  reg.zones.clear();
+}
+
+//===========================================================================
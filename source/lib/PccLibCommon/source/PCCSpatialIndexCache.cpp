@@ -0,0 +1,68 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+#include "PCCPointSet.h"
+#include "PCCSpatialIndexCache.h"
+
+using namespace pcc;
+
+uint64_t PCCSpatialIndexCache::fingerprint( const PCCPointSet3& pointCloud ) {
+  // a multiplicative hash of the packed positions: a pass over the points costs a fraction of building the tree
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for ( const auto& point : pointCloud.getPositions() ) {
+    const uint64_t packed = uint64_t( uint16_t( point[0] ) ) | ( uint64_t( uint16_t( point[1] ) ) << 16 ) |
+                            ( uint64_t( uint16_t( point[2] ) ) << 32 );
+    hash = ( hash ^ packed ) * 0x100000001b3ULL;
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+std::shared_ptr<const PCCKdTree> PCCSpatialIndexCache::getKdTree( const PCCPointSet3& pointCloud ) {
+  const size_t   pointCount = pointCloud.getPointCount();
+  const uint64_t hash       = fingerprint( pointCloud );
+  // built under the lock: the stages of a frame ask for the same tree, and one build is enough
+  std::lock_guard<std::mutex> lock( mutex_ );
+  Entry&                      entry = entries_[&pointCloud];
+  if ( !entry.kdtree || entry.pointCount != pointCount || entry.fingerprint != hash ) {
+    entry.pointCount  = pointCount;
+    entry.fingerprint = hash;
+    entry.kdtree      = std::make_shared<PCCKdTree>( pointCloud );
+  }
+  return entry.kdtree;
+}
+
+void PCCSpatialIndexCache::clear() {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  entries_.clear();
+}
@@ -34,9 +34,16 @@
 #if _WIN32
 #define _UNICODE
 #include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include <chrono>
+#include <cstring>
+#include <fstream>
 #include <memory>
 #include "PCCSystem.h"
 
@@ -105,3 +112,191 @@ int pcc::system( const char* command ) noexcept {
 #endif
 
 //===========================================================================
+
+#if _WIN32
+bool pcc::PCCMappedFile::open( const std::string& fileName ) {
+  close();
+  file_ = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+  if ( file_ == INVALID_HANDLE_VALUE ) {
+    file_ = nullptr;
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  if ( GetFileSizeEx( file_, &fileSize ) == 0 ) {
+    close();
+    return false;
+  }
+  size_ = static_cast<size_t>( fileSize.QuadPart );
+  if ( size_ == 0 ) { return true; }
+  mapping_ = CreateFileMappingA( file_, nullptr, PAGE_READONLY, 0, 0, nullptr );
+  if ( mapping_ != nullptr ) { data_ = static_cast<const uint8_t*>( MapViewOfFile( mapping_, FILE_MAP_READ, 0, 0, 0 ) ); }
+  if ( data_ == nullptr ) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void pcc::PCCMappedFile::close() {
+  if ( data_ != nullptr ) { UnmapViewOfFile( data_ ); }
+  if ( mapping_ != nullptr ) { CloseHandle( mapping_ ); }
+  if ( file_ != nullptr ) { CloseHandle( file_ ); }
+  data_    = nullptr;
+  size_    = 0;
+  mapping_ = nullptr;
+  file_    = nullptr;
+}
+#else
+bool pcc::PCCMappedFile::open( const std::string& fileName ) {
+  close();
+  const int fd = ::open( fileName.c_str(), O_RDONLY );
+  if ( fd < 0 ) { return false; }
+  struct stat status;
+  if ( fstat( fd, &status ) != 0 ) {
+    ::close( fd );
+    return false;
+  }
+  size_ = static_cast<size_t>( status.st_size );
+  if ( size_ > 0 ) {
+    void* data = mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if ( data == MAP_FAILED ) {
+      size_ = 0;
+      ::close( fd );
+      return false;
+    }
+    // The file is parsed once from start to end.
+    madvise( data, size_, MADV_SEQUENTIAL );
+    data_ = static_cast<const uint8_t*>( data );
+  }
+  ::close( fd );
+  return true;
+}
+
+void pcc::PCCMappedFile::close() {
+  if ( data_ != nullptr ) { munmap( const_cast<uint8_t*>( data_ ), size_ ); }
+  data_ = nullptr;
+  size_ = 0;
+}
+#endif
+
+//===========================================================================
+
+#if _WIN32
+bool pcc::PCCMappedOutputFile::open( const std::string& fileName, size_t size ) {
+  close();
+  file_ = CreateFileA( fileName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                       FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+  if ( file_ == INVALID_HANDLE_VALUE ) {
+    file_ = nullptr;
+    return false;
+  }
+  if ( size == 0 ) { return true; }
+  // the mapping extends the file to its size
+  const uint64_t size64 = size;
+  mapping_ = CreateFileMappingA( file_, nullptr, PAGE_READWRITE, static_cast<DWORD>( size64 >> 32 ),
+                                 static_cast<DWORD>( size64 & 0xFFFFFFFF ), nullptr );
+  if ( mapping_ != nullptr ) { data_ = static_cast<uint8_t*>( MapViewOfFile( mapping_, FILE_MAP_WRITE, 0, 0, 0 ) ); }
+  if ( data_ == nullptr ) {
+    close();
+    return false;
+  }
+  size_ = size;
+  return true;
+}
+
+bool pcc::PCCMappedOutputFile::close() {
+  bool success = true;
+  if ( data_ != nullptr ) { success = UnmapViewOfFile( data_ ) != 0; }
+  if ( mapping_ != nullptr ) { CloseHandle( mapping_ ); }
+  if ( file_ != nullptr ) { success = CloseHandle( file_ ) != 0 && success; }
+  data_    = nullptr;
+  size_    = 0;
+  mapping_ = nullptr;
+  file_    = nullptr;
+  return success;
+}
+#else
+bool pcc::PCCMappedOutputFile::open( const std::string& fileName, size_t size ) {
+  close();
+  fd_ = ::open( fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if ( fd_ < 0 ) { return false; }
+  if ( size == 0 ) { return true; }
+  // a sparse file would raise SIGBUS in the middle of the copy once the disk is full. File systems without
+  // fallocate (e.g. NFSv3) get a sparse file all the same, rather than writing it twice as posix_fallocate would
+#if defined( __linux__ )
+  bool reserved = fallocate( fd_, 0, 0, static_cast<off_t>( size ) ) == 0;
+  reserved      = reserved || ftruncate( fd_, static_cast<off_t>( size ) ) == 0;
+#else
+  bool reserved = ftruncate( fd_, static_cast<off_t>( size ) ) == 0;
+#endif
+  void* data = reserved ? mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0 ) : MAP_FAILED;
+  if ( data == MAP_FAILED ) {
+    close();
+    return false;
+  }
+  // written once from start to end
+  madvise( data, size, MADV_SEQUENTIAL );
+  data_ = static_cast<uint8_t*>( data );
+  size_ = size;
+  return true;
+}
+
+bool pcc::PCCMappedOutputFile::close() {
+  bool success = true;
+  if ( data_ != nullptr ) { success = munmap( data_, size_ ) == 0; }
+  if ( fd_ >= 0 ) { success = ::close( fd_ ) == 0 && success; }
+  data_ = nullptr;
+  size_ = 0;
+  fd_   = -1;
+  return success;
+}
+#endif
+
+//===========================================================================
+
+#if !_WIN32 && defined( O_DIRECT )
+// O_DIRECT transfers whole aligned blocks: the data goes through an aligned bounce buffer, the last block is padded
+// and the file is then truncated to its size.
+static bool writeFileDirect( const std::string& fileName, const uint8_t* data, const size_t size ) {
+  const size_t alignment = 4096;
+  const size_t chunkSize = size_t( 4 ) << 20;
+  const int    fd        = ::open( fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644 );
+  if ( fd < 0 ) { return false; }
+  void* buffer = nullptr;
+  if ( posix_memalign( &buffer, alignment, chunkSize ) != 0 ) {
+    ::close( fd );
+    return false;
+  }
+  bool success = true;
+  for ( size_t offset = 0; success && offset < size; ) {
+    const size_t count  = ( std::min )( chunkSize, size - offset );
+    const size_t padded = ( count + alignment - 1 ) & ~( alignment - 1 );
+    memcpy( buffer, data + offset, count );
+    memset( static_cast<uint8_t*>( buffer ) + count, 0, padded - count );
+    for ( size_t written = 0; success && written < padded; ) {
+      const ssize_t ret = ::write( fd, static_cast<uint8_t*>( buffer ) + written, padded - written );
+      success           = ret > 0;
+      written += success ? static_cast<size_t>( ret ) : 0;
+    }
+    offset += count;
+  }
+  free( buffer );
+  success = success && ftruncate( fd, static_cast<off_t>( size ) ) == 0;
+  return ::close( fd ) == 0 && success;
+}
+#endif
+
+bool pcc::writeFile( const std::string& fileName, const void* data, size_t size, bool directIO ) {
+#if !_WIN32 && defined( O_DIRECT )
+  // Falls back to a buffered write, e.g. on tmpfs which refuses O_DIRECT.
+  if ( directIO && writeFileDirect( fileName, static_cast<const uint8_t*>( data ), size ) ) { return true; }
+#endif
+  std::ofstream fout( fileName, std::ofstream::binary | std::ofstream::out );
+  if ( !fout.is_open() ) { return false; }
+  fout.write( static_cast<const char*>( data ), static_cast<std::streamsize>( size ) );
+  fout.close();
+  return !fout.fail();
+}
+
+//===========================================================================
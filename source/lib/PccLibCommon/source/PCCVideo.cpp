@@ -32,19 +32,31 @@
  */
 
 #include "PCCVideo.h"
+#include "PCCSystem.h"
 
 using namespace pcc;
 
+// The files are mapped: the frames are copied from the page cache straight into their channels (and back), without
+// the stream buffers, and the frames added take their buffers from the pool.
 template <typename T, size_t N>
 bool PCCVideo<T, N>::read( const std::string    fileName,
                            const size_t         sizeU0,
                            const size_t         sizeV0,
                            const PCCCOLORFORMAT format,
                            const size_t         nbyte ) {
-  std::ifstream infile( fileName, std::ios::binary );
-  auto          ret = read( infile, sizeU0, sizeV0, format, nbyte );
-  infile.close();
-  return ret;
+  PCCMappedFile file;
+  if ( !file.open( fileName ) ) { return false; }
+  const size_t frameSize  = PCCImage<T, N>::getFileSize( sizeU0, sizeV0, format, nbyte );
+  const size_t first      = frames_.size();
+  const size_t frameCount = frameSize > 0 ? file.size() / frameSize : 0;
+  resize( first + frameCount );
+  for ( size_t i = 0; i < frameCount; i++ ) {
+    if ( !frames_[first + i].read( file.data() + i * frameSize, frameSize, sizeU0, sizeV0, format, nbyte ) ) {
+      resize( first + i );
+      break;
+    }
+  }
+  return !frames_.empty();
 }
 
 template <typename T, size_t N>
@@ -62,12 +74,17 @@ bool PCCVideo<T, N>::read( std::ifstream&       infile,
 
 template <typename T, size_t N>
 bool PCCVideo<T, N>::write( const std::string fileName, const size_t nbyte ) {
-  std::ofstream outfile( fileName, std::ios::binary );
-  if ( write( outfile, nbyte ) ) {
-    outfile.close();
-    return true;
+  size_t size = 0;
+  for ( const auto& frame : frames_ ) { size += frame.getFileSize( nbyte ); }
+  PCCMappedOutputFile file;
+  if ( !file.open( fileName, size ) ) { return false; }
+  bool     success = true;
+  uint8_t* data    = file.data();
+  for ( const auto& frame : frames_ ) {
+    success = success && frame.write( data, nbyte );
+    data += frame.getFileSize( nbyte );
   }
-  return false;
+  return file.close() && success;
 }
 
 template <typename T, size_t N>
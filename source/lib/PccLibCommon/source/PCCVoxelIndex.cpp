@@ -0,0 +1,260 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PCCCommon.h"
+
+#include "PCCPointSet.h"
+#include "PCCVoxelIndex.h"
+#include "PCCMorton.h"
+
+#include <tbb/tbb.h>
+
+using namespace pcc;
+
+PCCVoxelIndex::PCCVoxelIndex() : cellShift_( 0 ), origin_( 0, 0, 0 ) {}
+
+PCCVoxelIndex::PCCVoxelIndex( const PCCPointSet3& pointCloud, const uint32_t cellShift ) :
+    cellShift_( 0 ), origin_( 0, 0, 0 ) {
+  init( pointCloud, cellShift );
+}
+
+void PCCVoxelIndex::init( const PCCPointSet3& pointCloud, const uint32_t cellShift ) {
+  const size_t pointCount = pointCloud.getPointCount();
+  cellShift_              = cellShift;
+  origin_                 = PCCPoint3D( 0, 0, 0 );
+  nodeStarts_.clear();
+  nodeOctants_.clear();
+  positions_.resize( pointCount );
+  indices_.resize( pointCount );
+  if ( pointCount == 0 ) { return; }
+  PCCPoint3D minimum = pointCloud[0];
+  PCCPoint3D maximum = pointCloud[0];
+  for ( size_t i = 1; i < pointCount; ++i ) {
+    for ( size_t k = 0; k < 3; ++k ) {
+      minimum[k] = ( std::min )( minimum[k], pointCloud[i][k] );
+      maximum[k] = ( std::max )( maximum[k], pointCloud[i][k] );
+    }
+  }
+  origin_ = minimum;
+  // the points are sorted by cell, and by index within a cell
+  std::vector<std::pair<uint64_t, uint32_t>> codes( pointCount );
+  const size_t chunkSize  = 4096;
+  const size_t chunkCount = ( pointCount + chunkSize - 1 ) / chunkSize;
+  tbb::parallel_for( size_t( 0 ), chunkCount, [&]( const size_t chunk ) {
+    const size_t start = chunk * chunkSize;
+    const size_t count = ( std::min )( chunkSize, pointCount - start );
+    uint64_t     cellCodes[chunkSize];
+    mortonEncode( pointCloud.getPositions().data() + start, count, origin_, cellShift_, cellCodes );
+    for ( size_t i = 0; i < count; ++i ) { codes[start + i] = std::make_pair( cellCodes[i], uint32_t( start + i ) ); }
+  } );
+  tbb::parallel_sort( codes.begin(), codes.end() );
+  std::vector<std::vector<uint64_t>> nodeCodes( 1 );
+  nodeStarts_.resize( 1 );
+  for ( size_t i = 0; i < pointCount; ++i ) {
+    positions_[i] = pointCloud[codes[i].second];
+    indices_[i]   = codes[i].second;
+    if ( i == 0 || codes[i].first != codes[i - 1].first ) {
+      nodeCodes[0].push_back( codes[i].first );
+      nodeStarts_[0].push_back( uint32_t( i ) );
+    }
+  }
+  nodeStarts_[0].push_back( uint32_t( pointCount ) );
+  // each level groups the nodes of the level below by eight, up to a single root
+  while ( nodeCodes.back().size() > 1 || nodeCodes.back()[0] != 0 ) {
+    const auto&           children = nodeCodes.back();
+    std::vector<uint64_t> parents;
+    std::vector<uint32_t> starts;
+    for ( size_t i = 0; i < children.size(); ++i ) {
+      if ( i == 0 || ( children[i] >> 3 ) != ( children[i - 1] >> 3 ) ) {
+        parents.push_back( children[i] >> 3 );
+        starts.push_back( uint32_t( i ) );
+      }
+    }
+    starts.push_back( uint32_t( children.size() ) );
+    nodeCodes.push_back( std::move( parents ) );
+    nodeStarts_.push_back( std::move( starts ) );
+  }
+  // a node is located by the octant of its parent it occupies, the last three bits of its code
+  nodeOctants_.resize( nodeCodes.size() );
+  for ( size_t l = 0; l < nodeCodes.size(); ++l ) {
+    nodeOctants_[l].resize( nodeCodes[l].size() );
+    for ( size_t n = 0; n < nodeCodes[l].size(); ++n ) { nodeOctants_[l][n] = uint8_t( nodeCodes[l][n] & 7 ); }
+  }
+}
+
+// Visits the points of the node of the given level whose first cell is ( x, y, z ). The children are visited nearest
+// first, unless pruned( their squared distance ) is true.
+template <typename Pruned, typename Visit>
+void PCCVoxelIndex::traverse( const int32_t position[3],
+                              const size_t  level,
+                              const size_t  node,
+                              const int32_t x,
+                              const int32_t y,
+                              const int32_t z,
+                              Pruned&       pruned,
+                              Visit&        visit ) const {
+  const uint32_t begin = nodeStarts_[level][node];
+  const uint32_t end   = nodeStarts_[level][node + 1];
+  if ( level == 0 ) {
+    for ( uint32_t j = begin; j < end; ++j ) { visit( j ); }
+    return;
+  }
+  const int32_t half     = 1 << ( level - 1 );
+  const int64_t halfSize = int64_t( half ) << cellShift_;
+  const auto&   octants  = nodeOctants_[level - 1];
+  size_t        childCount = 0;
+  uint32_t      childNode[8];
+  int32_t       childOrigin[8][3];
+  int64_t       childDist2[8];
+  for ( uint32_t child = begin; child < end; ++child ) {
+    const uint32_t octant    = octants[child];
+    const int32_t  origin[3] = {x + int32_t( octant & 1 ) * half, y + int32_t( ( octant >> 1 ) & 1 ) * half,
+                               z + int32_t( ( octant >> 2 ) & 1 ) * half};
+    int64_t        dist2     = 0;
+    for ( size_t k = 0; k < 3; ++k ) {
+      const int64_t lo  = int64_t( origin[k] ) << cellShift_;
+      const int64_t gap = ( std::max )( ( std::max )( lo - position[k], position[k] - ( lo + halfSize - 1 ) ),
+                                        int64_t( 0 ) );
+      dist2 += gap * gap;
+    }
+    // insertion by increasing distance
+    size_t i = childCount++;
+    for ( ; i > 0 && childDist2[i - 1] > dist2; --i ) {
+      childNode[i]  = childNode[i - 1];
+      childDist2[i] = childDist2[i - 1];
+      for ( size_t k = 0; k < 3; ++k ) { childOrigin[i][k] = childOrigin[i - 1][k]; }
+    }
+    childNode[i]  = child;
+    childDist2[i] = dist2;
+    for ( size_t k = 0; k < 3; ++k ) { childOrigin[i][k] = origin[k]; }
+  }
+  for ( size_t i = 0; i < childCount; ++i ) {
+    if ( pruned( childDist2[i] ) ) { break; }
+    traverse( position, level - 1, childNode[i], childOrigin[i][0], childOrigin[i][1], childOrigin[i][2], pruned,
+              visit );
+  }
+}
+
+void PCCVoxelIndex::searchNearest( const PCCPoint3D&       point,
+                                   const size_t            num_results,
+                                   const double            radius,
+                                   std::vector<DistIndex>& nearest ) const {
+  nearest.clear();
+  const size_t count = ( std::min )( num_results, positions_.size() );
+  if ( count == 0 ) { return; }
+  nearest.reserve( count );
+  int32_t position[3];
+  for ( size_t k = 0; k < 3; ++k ) { position[k] = int32_t( point[k] ) - int32_t( origin_[k] ); }
+  // nearest is a max-heap on ( distance, index ) holding the best candidates so far; nodes at the distance of the
+  // worst candidate are still visited since they may hold a point of lower index.
+  auto pruned = [&]( const int64_t dist2 ) {
+    return double( dist2 ) >= radius || ( nearest.size() == count && double( dist2 ) > nearest.front().first );
+  };
+  auto visit = [&]( const size_t j ) {
+    int64_t dist2 = 0;
+    for ( size_t k = 0; k < 3; ++k ) {
+      const int64_t d = int64_t( point[k] ) - int64_t( positions_[j][k] );
+      dist2 += d * d;
+    }
+    const DistIndex candidate( double( dist2 ), indices_[j] );
+    if ( candidate.first >= radius ) { return; }
+    if ( nearest.size() < count ) {
+      nearest.push_back( candidate );
+      std::push_heap( nearest.begin(), nearest.end() );
+    } else if ( candidate < nearest.front() ) {
+      std::pop_heap( nearest.begin(), nearest.end() );
+      nearest.back() = candidate;
+      std::push_heap( nearest.begin(), nearest.end() );
+    }
+  };
+  traverse( position, nodeStarts_.size() - 1, 0, 0, 0, 0, pruned, visit );
+  std::sort_heap( nearest.begin(), nearest.end() );
+}
+
+void PCCVoxelIndex::search( const PCCPoint3D& point, const size_t num_results, PCCNNResult& results ) const {
+  std::vector<DistIndex> nearest;
+  searchNearest( point, num_results, ( std::numeric_limits<double>::max )(), nearest );
+  results.resize( nearest.size() );
+  for ( size_t i = 0; i < nearest.size(); ++i ) {
+    results.indices( i ) = nearest[i].second;
+    results.dist( i )    = nearest[i].first;
+  }
+}
+
+void PCCVoxelIndex::searchRadius( const PCCPoint3D& point,
+                                  const size_t      num_results,
+                                  const double      radius,
+                                  PCCNNResult&      results ) const {
+  // radius is a squared distance, as for PCCKdTree
+  std::vector<DistIndex> nearest;
+  searchNearest( point, num_results, radius, nearest );
+  results.reserve( nearest.size() );
+  for ( const auto& neighbor : nearest ) { results.pushBack( std::make_pair( neighbor.second, neighbor.first ) ); }
+}
+
+void PCCVoxelIndex::searchRadius( const PCCPoint3D&                          point,
+                                  const size_t                               num_results,
+                                  const double                               radius,
+                                  PCCArenaVector<std::pair<size_t, double>>& results ) const {
+  std::vector<DistIndex> nearest;
+  searchNearest( point, num_results, radius, nearest );
+  results.resize( nearest.size() );
+  for ( size_t i = 0; i < nearest.size(); ++i ) { results[i] = std::make_pair( nearest[i].second, nearest[i].first ); }
+}
+
+template <typename T>
+void PCCVoxelIndex::searchBatch( const std::vector<PCCPoint3D>& points,
+                                 const size_t                   num_results,
+                                 PCCNNBatchResult<T>&           results ) const {
+  const size_t queryCount  = points.size();
+  const size_t resultCount = ( std::min )( num_results, positions_.size() );
+  results.resize( queryCount, resultCount );
+  if ( resultCount == 0 ) { return; }
+  tbb::parallel_for( tbb::blocked_range<size_t>( 0, queryCount, 256 ), [&]( const tbb::blocked_range<size_t>& range ) {
+    std::vector<DistIndex> nearest;
+    for ( size_t i = range.begin(); i < range.end(); ++i ) {
+      searchNearest( points[i], resultCount, ( std::numeric_limits<double>::max )(), nearest );
+      for ( size_t j = 0; j < resultCount; ++j ) {
+        results.indices( i, j ) = nearest[j].second;
+        results.dist( i, j )    = static_cast<T>( nearest[j].first );
+      }
+    }
+  } );
+}
+
+template void PCCVoxelIndex::searchBatch<double>( const std::vector<PCCPoint3D>& points,
+                                                  const size_t                   num_results,
+                                                  PCCNNBatchResult<double>&      results ) const;
+template void PCCVoxelIndex::searchBatch<float>( const std::vector<PCCPoint3D>& points,
+                                                 const size_t                   num_results,
+                                                 PCCNNBatchResult<float>&       results ) const;
@@ -34,8 +34,10 @@
 #ifndef PCCConformanceParser_h
 #define PCCConformanceParser_h
 
+#include "PCCLogger.h"
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <list>
@@ -46,6 +48,7 @@
 namespace pcc {
 
 class PCCConformanceParameters;
+struct PCCConformanceStream;
 typedef std::vector<std::map<std::string, std::string>> KeyValMaps;
 
 class PCCConformance {
@@ -54,6 +57,15 @@ class PCCConformance {
   ~PCCConformance();
   void check( const PCCConformanceParameters& params );
 
+  // Checks the decoder logs while they are traced, without writing and reading back the files of check(): start()
+  // parses the encoder logs, record() is the PCCLogRecordCallback of the decoder logger and compares each complete
+  // line, a frame, tile or picture record, as a task of its own, failed() is set by the first mismatch so that the
+  // decoding can stop there, and finish() waits for the comparisons, reports and checks the level limits.
+  bool start( const PCCConformanceParameters& params );
+  void record( PCCLoggerType type, const char* text, size_t size );
+  bool failed() const;
+  bool finish( uint8_t levelIdc );
+
  private:
   bool compareLogFiles( std::string&, std::string&, const std::vector<std::string>&, KeyValMaps&, KeyValMaps& );
   void checkLevelLimits( uint8_t, double, KeyValMaps&, bool );
@@ -68,6 +80,8 @@ class PCCConformance {
   size_t logFilesMatchCount_;
   bool   logFileTestsMatch_;
   bool   levelLimitTestsMatch_;
+
+  std::unique_ptr<PCCConformanceStream> stream_;
 };
 
 }  // namespace pcc
@@ -33,10 +33,114 @@
 #include "PCCConformance.h"
 #include "PCCConfigurationFileParser.h"
 #include "PCCConformanceParameters.h"
+#include <atomic>
+#include <mutex>
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
 
 using namespace std;
 using namespace pcc;
 
+namespace pcc {
+
+// One decoder log of the streaming check.
+struct PCCStreamLog {
+  PCCStreamLog( PCCLoggerType type, const std::vector<std::string>& keys, const std::string& title ) :
+      type_( type ),
+      keys_( &keys ),
+      title_( title ),
+      count_( 0 ),
+      match_( true ) {}
+  PCCLoggerType                   type_;
+  const std::vector<std::string>* keys_;
+  std::string                     title_;
+  KeyValMaps                      enc_;      // parsed by start()
+  KeyValMaps                      dec_;      // sized like enc_, filled by the comparisons
+  std::string                     partial_;  // the line being traced
+  size_t                          count_;    // records traced
+  bool                            match_;
+};
+
+struct PCCConformanceStream {
+  PCCConformanceStream() : fps_( 0 ), failed_( false ), compared_( 0 ), matched_( 0 ), mismatchIndex_( 0 ) {}
+  ~PCCConformanceStream() { tasks_.wait(); }
+
+  PCCStreamLog* find( PCCLoggerType type ) {
+    for ( auto& log : logs_ ) {
+      if ( log.type_ == type ) { return &log; }
+    }
+    return NULL;
+  }
+
+  // A line of the decoder log, called under mutex_: the records, the lines the parser does not skip, are numbered
+  // in the order they are traced and compared with the same record of the encoder log.
+  void push( PCCStreamLog& log, const std::string& line ) {
+    if ( line.rfind( "**********", 0 ) == 0 || line.find( '#' ) != std::string::npos ||
+         line.find_first_not_of( " \t\n\r" ) == std::string::npos ) {
+      return;
+    }
+    const size_t index = log.count_++;
+    if ( index >= log.enc_.size() ) {
+      fail( log, index, "the encoder log has " + std::to_string( log.enc_.size() ) + " records only" );
+      return;
+    }
+    PCCStreamLog* target = &log;
+    tasks_.run( [this, target, index, line] { compare( *target, index, line ); } );
+  }
+
+  void compare( PCCStreamLog& log, size_t index, std::string line ) {
+    if ( failed_ ) { return; }
+    PCCConfigurationFileParser parser( *log.keys_ );
+    KeyValMaps                 maps;
+    parser.scanLine( line, maps );
+    if ( maps.empty() ) {
+      fail( log, index, "can't parse the decoder record" );
+      return;
+    }
+    StringStringMap& enc = log.enc_[index];
+    StringStringMap& dec = log.dec_[index];
+    dec.swap( maps[0] );
+    for ( auto& keyVal : enc ) {
+      if ( keyVal.first == "Occupancy" || keyVal.first == "Geometry" || keyVal.first == "Attribute" ) { continue; }
+      auto it = dec.find( keyVal.first );
+      compared_++;
+      if ( it != dec.end() && it->second == keyVal.second ) {
+        matched_++;
+        continue;
+      }
+      std::ostringstream what;
+      what << "(Enc: " << left << setw( 30 ) << keyVal.first << ", " << setw( 32 ) << keyVal.second << " )"
+           << " **DIFF**  (Dec: " << left << setw( 30 ) << keyVal.first << ", " << setw( 32 )
+           << ( it != dec.end() ? it->second : "" ) << " )";
+      fail( log, index, what.str() );
+      return;
+    }
+  }
+
+  // Keeps the mismatch of the earliest record.
+  void fail( PCCStreamLog& log, size_t index, const std::string& what ) {
+    std::lock_guard<std::mutex> lock( failMutex_ );
+    log.match_ = false;
+    if ( failed_ && mismatchIndex_ <= index ) { return; }
+    mismatchIndex_ = index;
+    mismatch_      = log.title_ + ", record " + std::to_string( index ) + ": " + what;
+    failed_        = true;
+  }
+
+  std::vector<PCCStreamLog> logs_;
+  size_t                    fps_;
+  std::mutex                mutex_;  // partial_ and count_ of the logs
+  tbb::task_group           tasks_;
+  std::atomic<bool>         failed_;
+  std::atomic<size_t>       compared_;
+  std::atomic<size_t>       matched_;
+  std::mutex                failMutex_;
+  size_t                    mismatchIndex_;
+  std::string               mismatch_;
+};
+
+}  // namespace pcc
+
 PCCConformance::PCCConformance() :
     levelLimitsCount_( 0 ),
     levelLimitsExceedCount_( 0 ),
@@ -155,6 +259,103 @@ void PCCConformance::check( const PCCConformanceParameters& params ) {
        << levelLimitsCount_ << std::endl;
 }
 
+bool PCCConformance::start( const PCCConformanceParameters& params ) {
+  cout << "\n MPEG PCC Conformance v" << TMC2_VERSION_MAJOR << "." << TMC2_VERSION_MINOR << endl;
+  stream_.reset( new PCCConformanceStream );
+  auto& logs    = stream_->logs_;
+  stream_->fps_ = params.fps_;
+  logs.emplace_back( LOG_BITSTRMD5, bitStrMD5Keys, "BitStream MD5" );
+  logs.emplace_back( LOG_HLS, hlsKeys, "High Level Syntax MD5" );
+  logs.emplace_back( LOG_ATLAS, atlasKeys, "Atlas Log" );
+  logs.emplace_back( LOG_TILES, tileKeys, "Tile Log" );
+  logs.emplace_back( LOG_PCFRAME, pcframeKeys, "Point Cloud Frame Log" );
+  logs.emplace_back( LOG_RECFRAME, recPcframeKeys, "Post Reconstruction Point Cloud Frame Log" );
+  logs.emplace_back( LOG_PICTURE, pictureKeys, "Picture Log" );
+  std::vector<uint8_t> opened( logs.size(), 0 );
+  tbb::parallel_for( size_t( 0 ), logs.size(), [&]( const size_t i ) {
+    std::string                name = params.path_ + "enc" + get( logs[i].type_ );
+    PCCConfigurationFileParser parser( *logs[i].keys_ );
+    opened[i] = parser.parseFile( name, logs[i].enc_ );
+    logs[i].dec_.resize( logs[i].enc_.size() );
+  } );
+  for ( size_t i = 0; i < logs.size(); i++ ) {
+    if ( !opened[i] ) {
+      cout << " Encoder File " << params.path_ << "enc" << get( logs[i].type_ ) << " not exist \n";
+      stream_.reset();
+      return false;
+    }
+  }
+  return true;
+}
+
+void PCCConformance::record( PCCLoggerType type, const char* text, size_t size ) {
+  PCCConformanceStream* stream = stream_.get();
+  if ( !stream || stream->failed_ ) { return; }
+  PCCStreamLog* log = stream->find( type );
+  if ( !log ) { return; }
+  std::lock_guard<std::mutex> lock( stream->mutex_ );
+  log->partial_.append( text, size );
+  size_t start = 0, end;
+  while ( ( end = log->partial_.find( '\n', start ) ) != std::string::npos ) {
+    stream->push( *log, log->partial_.substr( start, end - start ) );
+    start = end + 1;
+  }
+  log->partial_.erase( 0, start );
+}
+
+bool PCCConformance::failed() const { return stream_ && stream_->failed_; }
+
+bool PCCConformance::finish( uint8_t levelIdc ) {
+  if ( !stream_ ) { return false; }
+  PCCConformanceStream& stream = *stream_;
+  {
+    std::lock_guard<std::mutex> lock( stream.mutex_ );
+    for ( auto& log : stream.logs_ ) {
+      if ( !log.partial_.empty() && !stream.failed_ ) { stream.push( log, log.partial_ ); }
+      log.partial_.clear();
+    }
+  }
+  stream.tasks_.wait();
+  for ( auto& log : stream.logs_ ) {
+    if ( !stream.failed_ && log.count_ != log.enc_.size() ) {
+      stream.fail( log, log.count_,
+                   "the encoder log has " + std::to_string( log.enc_.size() ) + " records, the decoder traced " +
+                       std::to_string( log.count_ ) );
+    }
+  }
+  logFilesCount_          = stream.compared_;
+  logFilesMatchCount_     = stream.matched_;
+  levelLimitsCount_       = 0;
+  levelLimitsExceedCount_ = 0;
+  logFileTestsMatch_      = !stream.failed_;
+  levelLimitTestsMatch_   = true;
+  for ( auto& log : stream.logs_ ) {
+    cout << "^^^^^^ " << log.title_ << " : "
+         << ( !log.match_ ? "DIFF" : stream.failed_ ? "STOPPED AT THE FIRST MISMATCH" : "MATCH" ) << std::endl;
+  }
+  if ( stream.failed_ ) {
+    PCCErrorMessage errMsg;
+    errMsg.warn( "\n ******* Please Check ******* \n", stream.mismatch_ );
+  } else {
+    // The sliding windows of the level limits go through the records in order, once all are in.
+    bool         limitsMatch = true;
+    const double aR          = 1. / (double)stream.fps_;
+    for ( auto& log : stream.logs_ ) {
+      if ( log.type_ != LOG_ATLAS && log.type_ != LOG_PCFRAME ) { continue; }
+      levelLimitTestsMatch_ = true;
+      checkLevelLimits( levelIdc, aR, log.dec_, log.type_ == LOG_ATLAS );
+      cout << "^^^^^^ " << log.title_ << " Level Limits: " << ( levelLimitTestsMatch_ ? "MATCH" : "DIFF" ) << std::endl;
+      limitsMatch &= levelLimitTestsMatch_;
+    }
+    levelLimitTestsMatch_ = limitsMatch;
+  }
+  cout << "\n File Check Tests (matched / total): " << logFilesMatchCount_ << " / " << logFilesCount_ << std::endl;
+  cout << "\n Level Limits Tests ( passed / total): " << ( levelLimitsCount_ - levelLimitsExceedCount_ ) << " / "
+       << levelLimitsCount_ << std::endl;
+  stream_.reset();
+  return logFileTestsMatch_ && levelLimitTestsMatch_;
+}
+
 bool PCCConformance::compareLogFiles( std::string&                    fNameEnc,
                                       std::string&                    fNameDec,
                                       const std::vector<std::string>& keyList,
@@ -38,22 +38,64 @@
 #include "PCCCodec.h"
 #include "PCCMath.h"
 #include "PCCPatch.h"
+#include "PCCProfiler.h"
+#include <functional>
 
 namespace pcc {
 
 class PCCContext;
 class PCCFrameContext;
+class PCCPointSet3;
 class PCCGroupOfFrames;
 class PCCPatch;
 class PatchFrameGeometryParameterSet;
 class GeometryPatchParameterSet;
 class V3CParameterSet;
 class PLRData;
+class PCCVideoDecoderPool;
 
 template <typename T, size_t N>
 class PCCImage;
 typedef pcc::PCCImage<uint8_t, 3> PCCImageOccupancyMap;
 
+// Reports the start and the end of each decoding stage (video sub-stream
+// decoding, reconstruction, smoothing); frameIndex is -1 for stages that
+// cover the whole GOF. The video sub-streams are decoded concurrently, so
+// the callback is called from several threads at once; a stage begins and
+// ends on the same thread.
+typedef std::function<void( const char* stage, int32_t frameIndex, bool begin )> PCCDecoderStageCallback;
+
+// Hands out each reconstructed frame of the GOF, in frame order, as soon as the frame and all the frames before it
+// are done. With parallelFrames_ it is called from a TBB worker, one frame at a time.
+typedef std::function<void( PCCPointSet3& frame, size_t frameIndex )> PCCDecoderFrameCallback;
+
+// The decoded videos and the patch metadata of one frame, for a reconstruction done elsewhere (e.g. on a GPU): each
+// occupied pixel (x, y) of the canvas, blockToPatch[y / occupancyResolution][x / occupancyResolution] = p + 1, gives
+// patch p's point canvasTo3D( x, y, depth ), depth from geometry[0], and a second point from geometry[1] if any. The
+// occupancy map is at 1 / occupancyPrecision of the canvas and already thresholded to 0 / 1. The attribute images,
+// one per map or none, are 16-bit YUV 4:4:4 unless attributesRGB.
+struct PCCDecodedTextures {
+  size_t                                    frameIndex;
+  PCCFrameContext*                          tile;
+  const PCCImageOccupancyMap*               occupancy;
+  size_t                                    occupancyPrecision;
+  size_t                                    occupancyResolution;
+  std::vector<const PCCImageGeometry*>      geometry;
+  bool                                      absoluteD1;
+  bool                                      removeDuplicatePoints;
+  std::vector<const PCCImage<uint16_t, 3>*> attributes;
+  bool                                      attributesRGB;
+};
+
+// Hands out the decoded textures of each frame, in frame order, instead of its reconstructed point cloud when the
+// frame needs nothing but the per-pixel reconstruction: a single tile, no patch border filtering, smoothing, EOM, raw
+// or PLR patches, at most two maps and one attribute. The PCCDecoderFrameCallback still gets the other frames.
+typedef std::function<void( const PCCDecodedTextures& textures )> PCCDecoderTexturesCallback;
+
+// Picks the post-processing of each frame just before it is reconstructed, e.g. from how close the frame is to its
+// presentation time. With parallelFrames_ it is called from several TBB workers at once.
+typedef std::function<PCCPostProcessing( size_t frameIndex )> PCCDecoderPostProcessingCallback;
+
 class PCCDecoder : public PCCCodec {
  public:
   PCCDecoder();
@@ -69,8 +111,42 @@ class PCCDecoder : public PCCCodec {
                                         size_t                        atglIndex );
   void createPatchFrameDataStructure( PCCContext& context );
   void createPatchFrameDataStructure( PCCContext& context, size_t atglIndex );
+  // the SEI messages of an atlas tile, once the tiles of its frame are built
+  void createPatchFrameDataStructureSEI( PCCContext& context, size_t atglIndex );
+  void setStageCallback( const PCCDecoderStageCallback& callback ) { stageCallback_ = callback; }
+  void setFrameCallback( const PCCDecoderFrameCallback& callback ) { frameCallback_ = callback; }
+  void setTexturesCallback( const PCCDecoderTexturesCallback& callback ) { texturesCallback_ = callback; }
+  void setPostProcessingCallback( const PCCDecoderPostProcessingCallback& callback ) {
+    postProcessingCallback_ = callback;
+  }
+  // The video decoders come from this pool, kept warm across GOFs; a client that decodes a stream segment by segment
+  // with one PCCDecoder per segment shares one pool between them.
+  void setVideoDecoderPool( const std::shared_ptr<PCCVideoDecoderPool>& pool ) { videoDecoderPool_ = pool; }
 
  private:
+  // Reconstructs and post-processes one frame once the videos are decoded. tilePatchColors holds the patch colours of
+  // each tile, or is null to draw them while reconstructing; smoother provides the smoothing buffers.
+  void reconstructFrame( PCCContext&                                 context,
+                         PCCGroupOfFrames&                           reconstructs,
+                         size_t                                      frameIdx,
+                         int32_t                                     atlasIndex,
+                         const std::vector<std::vector<bool>>&       absoluteT1List,
+                         const std::function<void()>&                waitForAttributes,
+                         const std::vector<std::vector<PCCColor3B>>* tilePatchColors,
+                         PCCCodec&                                   smoother,
+                         PCCPostProcessing                           postProcessing );
+  // Hands the textures of the frame to texturesCallback_ if the frame can be reconstructed from them alone; false
+  // if it has to be reconstructed here.
+  bool handTextures( PCCContext&                           context,
+                     size_t                                frameIdx,
+                     int32_t                               atlasIndex,
+                     const std::vector<std::vector<bool>>& absoluteT1List,
+                     PCCPostProcessing                     postProcessing );
+
+  // mapIndex -1: single attribute stream
+  void decodeAttributeVideo( PCCContext& context, const std::string& path, int32_t atlasIndex, int32_t mapIndex );
+  void decodeRawAttributeVideo( PCCContext& context, const std::string& path, int32_t atlasIndex );
+
   void       setPointLocalReconstruction( PCCContext& context );
   void       setPLRData( PCCFrameContext& tile, PCCPatch& patch, PLRData& plrd, size_t occupancyPackingBlockSize );
   void       setTilePartitionSizeAfti( PCCContext& context );
@@ -83,8 +159,28 @@ class PCCDecoder : public PCCCodec {
   void       setConsitantFourCCCode( PCCContext& context, size_t atglIndex );
   PCCCodecId getCodedCodecId( PCCContext& context, const uint8_t codecCodecId, const std::string& videoDecoderPath );
 
-  PCCDecoderParameters     params_;
-  std::vector<std::string> consitantFourCCCode_;
+  void stage( const char* name, int32_t frameIndex, bool begin ) {
+    if ( begin ) {
+      PCC_PROFILE_BEGIN( name );
+    } else {
+      PCC_PROFILE_END( name );
+    }
+    if ( stageCallback_ ) { stageCallback_( name, frameIndex, begin ); }
+  }
+  PCCPostProcessing postProcessing( size_t frameIndex ) {
+    return postProcessingCallback_ ? postProcessingCallback_( frameIndex ) : POST_PROCESSING_FULL;
+  }
+  void frameDone( PCCPointSet3& frame, size_t frameIndex ) {
+    if ( frameCallback_ ) { frameCallback_( frame, frameIndex ); }
+  }
+
+  PCCDecoderParameters                 params_;
+  std::vector<std::string>             consitantFourCCCode_;
+  PCCDecoderStageCallback              stageCallback_;
+  PCCDecoderFrameCallback              frameCallback_;
+  PCCDecoderTexturesCallback           texturesCallback_;
+  PCCDecoderPostProcessingCallback     postProcessingCallback_;
+  std::shared_ptr<PCCVideoDecoderPool> videoDecoderPool_;
 };
 
 };  // namespace pcc
@@ -37,6 +37,11 @@
 
 namespace pcc {
 
+// How much of the post-processing signalled by the SEI messages a frame gets. REDUCED keeps the geometry smoothing and
+// the occupancy synthesis but leaves out the attribute work, i.e. the colour transfer onto the smoothed points and the
+// attribute smoothing; NONE leaves out all of it.
+enum PCCPostProcessing { POST_PROCESSING_FULL = 0, POST_PROCESSING_REDUCED, POST_PROCESSING_NONE };
+
 class PCCDecoderParameters {
  public:
   PCCDecoderParameters();
@@ -59,8 +64,23 @@ class PCCDecoderParameters {
   std::string       colorSpaceConversionPath_;
   std::string       inverseColorSpaceConversionConfig_;
   size_t            nbThread_;
+  std::string       threadAffinity_;
+  bool              parallelFrames_;
+  size_t            videoDecoderThreads_;
+  std::string       videoDecoderHardware_;
+  // Shared memory object the decoded frames are published to for a renderer, see PCCFrameRing. Empty: none.
+  std::string       frameRingName_;
+  // GOFs waiting for the reconstructed frames to be written while the next ones are decoded; 0 writes them in turn
+  size_t            writeQueueDepth_;
+  size_t            frameRingSlots_;
+  size_t            frameRingMaxPoints_;
+  // Conformance / verification: reconstruction checksums and decoded atlas hash SEI checks. Off, no checksum work
+  // at all is done while decoding.
+  bool              verifyChecksums_;
   bool              keepIntermediateFiles_;
   bool              patchColorSubsampling_;
+  // Grid smoothing in fixed point, as the encoder was run with: the choice is not signalled.
+  bool              fixedPointSmoothing_;
   size_t            bestColorSearchRange_;
   int               numNeighborsColorTransferFwd_;
   int               numNeighborsColorTransferBwd_;
@@ -0,0 +1,108 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCCStreamingDecoder_h
+#define PCCStreamingDecoder_h
+
+#include "PCCCommon.h"
+#include "PCCContext.h"
+#include "PCCDecoder.h"
+#include "PCCDecoderParameters.h"
+#include "PCCPointSet.h"
+#include "PCCSampleStreamV3CUnit.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace pcc {
+
+// Decodes a V3C sample stream (ISO/IEC 23090-5 Annex C) that arrives in pieces of any size. A worker thread decodes
+// each GOF as soon as its last V3C unit arrived and hands out every frame once it is reconstructed and
+// post-processed, so a player can render the first frames of a GOF while the next ones are still being decoded.
+class PCCStreamingDecoder {
+ public:
+  PCCStreamingDecoder();
+  ~PCCStreamingDecoder();
+
+  // Must be called before the first push().
+  void setParameters( const PCCDecoderParameters& params );
+
+  // Appends bytes of the sample stream, starting with the sample stream header.
+  void push( const uint8_t* data, size_t size );
+
+  // No more bytes will be pushed: the last GOF is decoded with the units it has.
+  void close();
+
+  // Waits for the next frame. Returns false once the stream is closed and every frame was handed out, or when the
+  // decoding failed (getStatus() != 0).
+  bool pop( PCCPointSet3& frame );
+
+  // Same as pop() but returns false at once when no frame is ready.
+  bool tryPop( PCCPointSet3& frame );
+
+  // 0 while the stream decodes fine, the error code of PCCDecoder::decode() otherwise.
+  int getStatus();
+
+ private:
+  PCCStreamingDecoder( const PCCStreamingDecoder& ) = delete;
+  PCCStreamingDecoder& operator=( const PCCStreamingDecoder& ) = delete;
+
+  void run();
+  void parseUnits();
+  bool hasCompleteGof();
+  int  decodeGof( bool& more );
+
+  PCCDecoderParameters params_;
+  PCCDecoder           decoder_;
+  PCCContext           context_;  // kept across GOFs so the video frames are reused
+  PCCLogger            logger_;
+  PCCBitstreamStat     bitstreamStat_;
+  SampleStreamV3CUnit  ssvu_;
+  std::vector<uint8_t> buffer_;  // bytes not parsed into ssvu_ yet
+  size_t               precision_;
+
+  std::thread              worker_;
+  std::mutex               mutex_;
+  std::condition_variable  inputReady_;
+  std::condition_variable  frameReady_;
+  std::vector<uint8_t>     input_;  // bytes pushed since the worker last looked
+  std::deque<PCCPointSet3> frames_;
+  bool                     closed_;
+  bool                     finished_;
+  int                      status_;
+};
+
+}  // namespace pcc
+
+#endif /* PCCStreamingDecoder_h */
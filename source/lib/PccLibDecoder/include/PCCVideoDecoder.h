@@ -43,6 +43,7 @@ class PCCVideo;
 class PCCContext;
 class PCCVideoBitstream;
 class PCCLogger;
+class PCCVideoDecoderPool;
 
 class PCCVideoDecoder {
  public:
@@ -65,10 +66,35 @@ class PCCVideoDecoder {
                    const std::string& colorSpaceConversionPath          = "",
                    const size_t       upsamplingFilter                  = 0 );
 
+  // true if this build has a decoder for the video codec of codec4cc (component codec mapping SEI, DASH @codecs),
+  // e.g. "hev1" or "vvi1"
+  static bool canDecode( const std::string& codec4cc );
+
   void setLogger( PCCLogger& logger ) { logger_ = &logger; }
 
+  // tiles or wavefront rows of a picture the HM library decoder decodes at the same time, 0 = all hardware threads
+  void setSubstreamThreads( size_t substreamThreads ) { substreamThreads_ = substreamThreads; }
+
+  // device the FFMPEG decoder decodes on, see PCCFFMPEGLibVideoDecoder::setHardwareDevice()
+  void setHardwareDevice( const std::string& hardwareDevice ) { hardwareDevice_ = hardwareDevice; }
+
+  // takes the video decoders from pool and gives them back after each decompress(), instead of creating one per call
+  void setPool( PCCVideoDecoderPool* pool ) { pool_ = pool; }
+
+  // decompress() gives the video in nominalBitdepth, as PCCImage::convertBitdepth() from its output bit depth; the
+  // decoders that can do it convert while they write the pictures, with the chroma upsampling
+  void setNominalBitdepth( size_t nominalBitdepth, bool msbAlignFlag ) {
+    nominalBitdepth_ = nominalBitdepth;
+    msbAlignFlag_    = msbAlignFlag;
+  }
+
  private:
-  PCCLogger* logger_ = nullptr;
+  PCCLogger*           logger_           = nullptr;
+  PCCVideoDecoderPool* pool_             = nullptr;
+  size_t               substreamThreads_ = 1;
+  std::string          hardwareDevice_;
+  size_t               nominalBitdepth_ = 0;  // 0 for the output bit depth
+  bool                 msbAlignFlag_    = false;
 };
 
 };  // namespace pcc
@@ -0,0 +1,91 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCVideoDecoderPool_h
+#define PCCVideoDecoderPool_h
+
+#include "PCCCommon.h"
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace pcc {
+
+class PCCVideoBitstream;
+template <class T>
+class PCCVirtualVideoDecoder;
+
+// Video decoders kept warm across the GOFs of a stream and across segments, so that a decoder keeping state between
+// its decode() calls (devices, codec contexts, threads) sets it up once. A decoder is handed out for one video
+// component (occupancy, a geometry map, an attribute partition...) and codec, and is matched to the parameter sets
+// of the bitstream: a stream that goes back to a quality it has decoded before finds its decoder still warm. Up to
+// capacity decoders are kept per component; beyond that, the least recently used one is reset for the new parameter
+// sets. A decoder is used by one decode at a time.
+class PCCVideoDecoderPool {
+ public:
+  PCCVideoDecoderPool( size_t capacity = 2 ) : capacity_( capacity ) {}
+  ~PCCVideoDecoderPool() = default;
+
+  template <typename T>
+  std::shared_ptr<PCCVirtualVideoDecoder<T>> acquire( PCCVideoType       component,
+                                                      PCCCodecId         codecId,
+                                                      const std::string& parameterSets );
+  // gives back a decoder of acquire() once its decode is done
+  template <typename T>
+  void release( PCCVideoType                               component,
+                PCCCodecId                                 codecId,
+                const std::string&                         parameterSets,
+                std::shared_ptr<PCCVirtualVideoDecoder<T>> decoder );
+  void clear();
+
+  // The VPS, SPS and PPS NAL units at the start of the bitstream, as the key of its decoder.
+  static std::string getParameterSets( PCCVideoBitstream& bitstream, PCCCodecId codecId );
+
+ private:
+  struct Entry {
+    PCCVideoType          component_;
+    PCCCodecId            codecId_;
+    size_t                sampleSize_;
+    std::string           parameterSets_;
+    std::shared_ptr<void> decoder_;
+  };
+  PCCVideoDecoderPool( const PCCVideoDecoderPool& ) = delete;
+  PCCVideoDecoderPool& operator=( const PCCVideoDecoderPool& ) = delete;
+
+  size_t           capacity_;
+  std::mutex       mutex_;
+  std::list<Entry> entries_;  // idle decoders, most recently used first
+};
+
+};  // namespace pcc
+
+#endif /* PCCVideoDecoderPool_h */
@@ -38,17 +38,16 @@
 #include "PCCFrameContext.h"
 #include "PCCPatch.h"
 #include "PCCVideoDecoder.h"
+#include "PCCVideoDecoderPool.h"
 #include "PCCGroupOfFrames.h"
 #include <tbb/tbb.h>
 #include "PCCDecoder.h"
 #include <iostream>
-#include <fstream>
-#include <ctime>
 
 using namespace pcc;
 using namespace std;
 
-PCCDecoder::PCCDecoder() {
+PCCDecoder::PCCDecoder() : videoDecoderPool_( std::make_shared<PCCVideoDecoderPool>() ) {
 #ifdef ENABLE_PAPI_PROFILING
   initPapiProfiler();
 #endif
@@ -68,20 +67,10 @@ void PCCDecoder::setReconstructionParameters( const PCCDecoderParameters& params
 }
 
 int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs, int32_t atlasIndex = 0 ) {
-	struct tm curr_tm;
-	time_t curr_time = time(nullptr);
-	localtime_r(&curr_time, &curr_tm);
-
-
-	ofstream out("/home/mcnl/test.txt", ios::app);
-	out << curr_tm.tm_year + 1900 << "-" << curr_tm.tm_mon + 1 << "-" <<curr_tm.tm_mday << "-" << curr_tm.tm_hour << ":" << curr_tm.tm_min << ":" << curr_tm.tm_sec << endl;
-	out << "New GroupOfFrames has come" << endl;
-
-  if ( params_.nbThread_ > 0 ) { tbb::task_scheduler_init init( static_cast<int>( params_.nbThread_ ) ); }
+  PCC_PROFILE_ZONE( "decode" );
+  executionContext_->enter( params_.nbThread_, params_.threadAffinity_ );
   createPatchFrameDataStructure( context );
 
-  PCCVideoDecoder videoDecoder;
-  videoDecoder.setLogger( *logger_ );
   std::stringstream path;
   auto&             sps              = context.getVps();
   auto&             ai               = sps.getAttributeInformation( atlasIndex );
@@ -103,190 +92,154 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs, int
   printf( "=> Video decoder : occupancy = %d geometry = %d \n", (int)occupancyCodecId, (int)geometryCodecId );
   printf( " Decode 0 size = %zu \n", context.getVideoBitstream( VIDEO_OCCUPANCY ).size() );
   fflush( stdout );
-  TRACE_PICTURE( "Occupancy\n" );
-  TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0\n" );
-  videoDecoder.decompress( context.getVideoOccupancyMap(),                // video
-                           context,                                       // contexts
-                           path.str(),                                    // path
-                           context.getVideoBitstream( VIDEO_OCCUPANCY ),  // bitstream
-                           params_.byteStreamVideoCoderOccupancy_,        // byte stream video coder
-                           occupancyCodecId,                              // codecId
-                           params_.videoDecoderOccupancyPath_,            // decoder path
-                           8,                                             // output bit depth
-                           params_.keepIntermediateFiles_ );              // keep intermediate files
-
-  // converting the decoded bitdepth to the nominal bitdepth
-  context.getVideoOccupancyMap().convertBitdepth( 8, oi.getOccupancy2DBitdepthMinus1() + 1,
-                                                  oi.getOccupancyMSBAlignFlag() );
-
-  if ( sps.getMultipleMapStreamsPresentFlag( atlasIndex ) ) {
-    context.getVideoGeometryMultiple().resize( sps.getMapCountMinus1( atlasIndex ) + 1 );
-    size_t totalGeoSize = 0;
-    for ( uint32_t mapIndex = 0; mapIndex < sps.getMapCountMinus1( atlasIndex ) + 1; mapIndex++ ) {
-      TRACE_PICTURE( "Geometry\n" );
-      TRACE_PICTURE( "MapIdx = %d, AuxiliaryVideoFlag = 0\n", mapIndex );
-      std::cout << "*******Video Decoding: Geometry[" << mapIndex << "] ********" << std::endl;
-      auto  geometryIndex  = static_cast<PCCVideoType>( VIDEO_GEOMETRY_D0 + mapIndex );
-      auto& videoBitstream = context.getVideoBitstream( geometryIndex );
-      videoDecoder.decompress( context.getVideoGeometryMultiple( mapIndex ),  // video
+  // The video sub-streams do not depend on each other and are decoded as concurrent tasks, each with its own
+  // video decoder. Decodes that write the same video (the attributes and partitions of one map) stay in one task,
+  // in bitstream order. Reconstruction starts once occupancy and geometry are ready and waits for the attributes
+  // only when it first needs them.
+  const std::string videoPath = path.str();
+  tbb::task_group   geometryTasks;
+  tbb::task_group   attributeTasks;
+  bool              attributesReady = false;
+  auto              waitForAttributes = [&] {
+    if ( !attributesReady ) {
+      executionContext_->execute( [&] { attributeTasks.wait(); } );
+      attributesReady = true;
+    }
+  };
+
+  executionContext_->execute( [&] {
+    geometryTasks.run( [&] {
+      TRACE_PICTURE( "Occupancy\n" );
+      TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0\n" );
+      PCCVideoDecoder videoDecoder;
+      videoDecoder.setLogger( *logger_ );
+      videoDecoder.setSubstreamThreads( params_.videoDecoderThreads_ );
+      videoDecoder.setHardwareDevice( params_.videoDecoderHardware_ );
+      videoDecoder.setPool( videoDecoderPool_.get() );
+      // converting the decoded bitdepth to the nominal bitdepth
+      videoDecoder.setNominalBitdepth( oi.getOccupancy2DBitdepthMinus1() + 1, oi.getOccupancyMSBAlignFlag() );
+      stage( "video occupancy", -1, true );
+      videoDecoder.decompress( context.getVideoOccupancyMap(),                // video
                                context,                                       // contexts
-                               path.str(),                                    // path
-                               videoBitstream,                                // bitstream
-                               params_.byteStreamVideoCoderGeometry_,         // byte stream video coder
-                               geometryCodecId,                               // codecId
-                               params_.videoDecoderGeometryPath_,             // decoder path
-                               geometryBitDepth,                              // output bit depth
-                               params_.keepIntermediateFiles_,                // keep intermediate files
-                               0 );                                           // SHVC layer index
-
-      context.getVideoGeometryMultiple()[mapIndex].convertBitdepth(
-          geometryBitDepth, gi.getGeometry2dBitdepthMinus1() + 1, gi.getGeometryMSBAlignFlag() );
-      std::cout << "geometry D" << mapIndex << " video ->" << videoBitstream.size() << " B" << std::endl;
-      totalGeoSize += videoBitstream.size();
+                               videoPath,                                     // path
+                               context.getVideoBitstream( VIDEO_OCCUPANCY ),  // bitstream
+                               params_.byteStreamVideoCoderOccupancy_,        // byte stream video coder
+                               occupancyCodecId,                              // codecId
+                               params_.videoDecoderOccupancyPath_,            // decoder path
+                               8,                                             // output bit depth
+                               params_.keepIntermediateFiles_ );              // keep intermediate files
+      stage( "video occupancy", -1, false );
+    } );
+
+    if ( sps.getMultipleMapStreamsPresentFlag( atlasIndex ) ) {
+      context.getVideoGeometryMultiple().resize( mapCount );
+      for ( uint32_t mapIndex = 0; mapIndex < mapCount; mapIndex++ ) {
+        geometryTasks.run( [&, mapIndex] {
+          TRACE_PICTURE( "Geometry\n" );
+          TRACE_PICTURE( "MapIdx = %d, AuxiliaryVideoFlag = 0\n", mapIndex );
+          std::cout << "*******Video Decoding: Geometry[" << mapIndex << "] ********" << std::endl;
+          auto            geometryIndex  = static_cast<PCCVideoType>( VIDEO_GEOMETRY_D0 + mapIndex );
+          auto&           videoBitstream = context.getVideoBitstream( geometryIndex );
+          PCCVideoDecoder videoDecoder;
+          videoDecoder.setLogger( *logger_ );
+          videoDecoder.setSubstreamThreads( params_.videoDecoderThreads_ );
+          videoDecoder.setHardwareDevice( params_.videoDecoderHardware_ );
+          videoDecoder.setPool( videoDecoderPool_.get() );
+          videoDecoder.setNominalBitdepth( gi.getGeometry2dBitdepthMinus1() + 1, gi.getGeometryMSBAlignFlag() );
+          stage( "video geometry", -1, true );
+          videoDecoder.decompress( context.getVideoGeometryMultiple( mapIndex ),  // video
+                                   context,                                       // contexts
+                                   videoPath,                                     // path
+                                   videoBitstream,                                // bitstream
+                                   params_.byteStreamVideoCoderGeometry_,         // byte stream video coder
+                                   geometryCodecId,                               // codecId
+                                   params_.videoDecoderGeometryPath_,             // decoder path
+                                   geometryBitDepth,                              // output bit depth
+                                   params_.keepIntermediateFiles_,                // keep intermediate files
+                                   0 );                                           // SHVC layer index
+          stage( "video geometry", -1, false );
+          std::cout << "geometry D" << mapIndex << " video ->" << videoBitstream.size() << " B" << std::endl;
+        } );
+      }
+    } else {
+      geometryTasks.run( [&] {
+        TRACE_PICTURE( "Geometry\n" );
+        TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0\n" );
+        std::cout << "*******Video Decoding: Geometry ********" << std::endl;
+        auto&           videoBitstream = context.getVideoBitstream( VIDEO_GEOMETRY );
+        PCCVideoDecoder videoDecoder;
+        videoDecoder.setLogger( *logger_ );
+        videoDecoder.setSubstreamThreads( params_.videoDecoderThreads_ );
+        videoDecoder.setHardwareDevice( params_.videoDecoderHardware_ );
+        videoDecoder.setPool( videoDecoderPool_.get() );
+        videoDecoder.setNominalBitdepth( gi.getGeometry2dBitdepthMinus1() + 1, gi.getGeometryMSBAlignFlag() );
+
+        printf( " Decode G size = %zu \n", videoBitstream.size() );
+        fflush( stdout );
+        stage( "video geometry", -1, true );
+        videoDecoder.decompress( context.getVideoGeometryMultiple( 0 ),  // video
+                                 context,                                // contexts
+                                 videoPath,                              // path
+                                 videoBitstream,                         // bitstream
+                                 params_.byteStreamVideoCoderGeometry_,  // byte stream video coder
+                                 geometryCodecId,                        // codecId
+                                 params_.videoDecoderGeometryPath_,      // decoder path
+                                 geometryBitDepth,                       // output bit depth
+                                 params_.keepIntermediateFiles_,         // keep intermediate files
+                                 params_.shvcLayerIndex_ );              // SHVC layer index
+        stage( "video geometry", -1, false );
+        std::cout << "geometry video ->" << videoBitstream.size() << " B" << std::endl;
+      } );
     }
-    std::cout << "total geometry video ->" << totalGeoSize << " B" << std::endl;
-  } else {
-    TRACE_PICTURE( "Geometry\n" );
-    TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0\n" );
-    std::cout << "*******Video Decoding: Geometry ********" << std::endl;
-    auto& videoBitstream = context.getVideoBitstream( VIDEO_GEOMETRY );
-
-    printf( " Decode G size = %zu \n", videoBitstream.size() );
-    fflush( stdout );
-    videoDecoder.decompress( context.getVideoGeometryMultiple( 0 ),  // video
-                             context,                                // contexts
-                             path.str(),                             // path
-                             videoBitstream,                         // bitstream
-                             params_.byteStreamVideoCoderGeometry_,  // byte stream video coder
-                             geometryCodecId,                        // codecId
-                             params_.videoDecoderGeometryPath_,      // decoder path
-                             geometryBitDepth,                       // output bit depth
-                             params_.keepIntermediateFiles_,         // keep intermediate files
-                             params_.shvcLayerIndex_ );              // SHVC layer index
-
-    context.getVideoGeometryMultiple()[0].convertBitdepth( geometryBitDepth, gi.getGeometry2dBitdepthMinus1() + 1,
-                                                           gi.getGeometryMSBAlignFlag() );
-    std::cout << "geometry video ->" << videoBitstream.size() << " B" << std::endl;
-  }
-
-  if ( asps.getRawPatchEnabledFlag() && asps.getAuxiliaryVideoEnabledFlag() &&
-       sps.getAuxiliaryVideoPresentFlag( atlasIndex ) ) {
-    TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 1\n" );
-    std::cout << "*******Video Decoding: Aux Geometry ********" << std::endl;
-    auto& videoBitstreamMP = context.getVideoBitstream( VIDEO_GEOMETRY_RAW );
-    auto  auxGeometryCodecId =
-        getCodedCodecId( context, gi.getAuxiliaryGeometryCodecId(), params_.videoDecoderGeometryPath_ );
-    videoDecoder.decompress( context.getVideoRawPointsGeometry(),    // video
-                             context,                                // contexts
-                             path.str(),                             // path
-                             videoBitstreamMP,                       // bitstream
-                             params_.byteStreamVideoCoderGeometry_,  // byte stream video coder
-                             auxGeometryCodecId,                     // codecId
-                             params_.videoDecoderGeometryPath_,      // decoder path
-                             geometryBitDepth,                       // output bit depth
-                             params_.keepIntermediateFiles_,         // keep intermediate files
-                             params_.shvcLayerIndex_ );              // SHVC layer index
-
-    context.getVideoRawPointsGeometry().convertBitdepth( geometryBitDepth, gi.getGeometry2dBitdepthMinus1() + 1,
-                                                         gi.getGeometryMSBAlignFlag() );
-    std::cout << " raw points geometry -> " << videoBitstreamMP.size() << " B " << endl;
-  }
 
-  if ( ai.getAttributeCount() > 0 ) {
-    for ( int attrIndex = 0; attrIndex < ai.getAttributeCount(); attrIndex++ ) {
-      int  attributeBitDepth  = ai.getAttribute2dBitdepthMinus1( attrIndex ) + 1;
-      int  attributeTypeId    = ai.getAttributeTypeId( attrIndex );
-      int  attributeDimension = ai.getAttributeDimensionPartitionsMinus1( attrIndex ) + 1;
-      auto attributeCodecId =
-          getCodedCodecId( context, ai.getAttributeCodecId( attrIndex ), params_.videoDecoderAttributePath_ );
-      printf( "CodecId attributeCodecId = %d \n", (int)attributeCodecId );
-      for ( int attrPartitionIndex = 0; attrPartitionIndex < attributeDimension; attrPartitionIndex++ ) {
-        if ( sps.getMultipleMapStreamsPresentFlag( atlasIndex ) ) {
-          int sizeAttributeVideo = 0;
-          context.getVideoAttributesMultiple().resize( sps.getMapCountMinus1( atlasIndex ) + 1 );
-          // this allocation is considering only one attribute, with a single partition, but multiple streams
-          for ( uint32_t mapIndex = 0; mapIndex < sps.getMapCountMinus1( atlasIndex ) + 1; mapIndex++ ) {
-            // decompress T[mapIndex]
-            TRACE_PICTURE( "Attribute\n" );
-            TRACE_PICTURE( "AttrIdx = %d, AttrPartIdx = %d, AttrTypeID = %d, MapIdx = %d, AuxiliaryVideoFlag = 0\n",
-                           attrIndex, attrPartitionIndex, attributeTypeId, mapIndex );
-            std::cout << "*******Video Decoding: Attribute [" << mapIndex << "] ********" << std::endl;
-            auto  attributeIndex = static_cast<PCCVideoType>( VIDEO_ATTRIBUTE_T0 + attrPartitionIndex +
-                                                             MAX_NUM_ATTR_PARTITIONS * mapIndex );
-            auto& videoBitstream = context.getVideoBitstream( attributeIndex );
-            videoDecoder.decompress( context.getVideoAttributesMultiple( mapIndex ),  // video
-                                     context,                                         // contexts
-                                     path.str(),                                      // path
-                                     videoBitstream,                                  // bitstream
-                                     params_.byteStreamVideoCoderAttribute_,          // byte stream video coder
-                                     attributeCodecId,                                // codecId
-                                     params_.videoDecoderAttributePath_,              // decoder path
-                                     attributeBitDepth,                               // output bit depth
-                                     params_.keepIntermediateFiles_,                  // keep intermediate files
-                                     params_.shvcLayerIndex_,                         // SHVC layer index
-                                     params_.patchColorSubsampling_,                  // patch color subsampling
-                                     params_.inverseColorSpaceConversionConfig_,      // inverse color space conversion
-                                     params_.colorSpaceConversionPath_ );             // color space conversion path
-            std::cout << "attribute T" << mapIndex << " video ->" << videoBitstream.size() << " B" << std::endl;
-            sizeAttributeVideo += videoBitstream.size();
-          }
-          std::cout << "attribute    video ->" << sizeAttributeVideo << " B" << std::endl;
-        } else {
-          TRACE_PICTURE( "Attribute\n" );
-          TRACE_PICTURE( "AttrIdx = 0, AttrPartIdx = %d, AttrTypeID = %d, MapIdx = 0, AuxiliaryVideoFlag = 0\n",
-                         attrPartitionIndex, attributeTypeId );
-          std::cout << "*******Video Decoding: Attribute ********" << std::endl;
-          auto  attributeIndex = static_cast<PCCVideoType>( VIDEO_ATTRIBUTE + attrPartitionIndex );
-          auto& videoBitstream = context.getVideoBitstream( attributeIndex );
-          printf( " Decode T size = %zu \n", videoBitstream.size() );
-          fflush( stdout );
-          videoDecoder.decompress( context.getVideoAttributesMultiple( 0 ),     // video
-                                   context,                                     // contexts
-                                   path.str(),                                  // path
-                                   videoBitstream,                              // bitstream
-                                   params_.byteStreamVideoCoderAttribute_,      // byte stream video coder
-                                   attributeCodecId,                            // codecId
-                                   params_.videoDecoderAttributePath_,          // decoder path
-                                   attributeBitDepth,                           // output bit depth
-                                   params_.keepIntermediateFiles_,              // keep intermediate files
-                                   params_.shvcLayerIndex_,                     // SHVC layer index
-                                   params_.patchColorSubsampling_,              // patch color subsampling
-                                   params_.inverseColorSpaceConversionConfig_,  // inverse color space conversionConfig
-                                   params_.colorSpaceConversionPath_ );         // color space conversion path
-          std::cout << "attribute video  ->" << videoBitstream.size() << " B" << std::endl;
-        }
+    if ( asps.getRawPatchEnabledFlag() && asps.getAuxiliaryVideoEnabledFlag() &&
+         sps.getAuxiliaryVideoPresentFlag( atlasIndex ) ) {
+      geometryTasks.run( [&] {
+        TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 1\n" );
+        std::cout << "*******Video Decoding: Aux Geometry ********" << std::endl;
+        auto& videoBitstreamMP = context.getVideoBitstream( VIDEO_GEOMETRY_RAW );
+        auto  auxGeometryCodecId =
+            getCodedCodecId( context, gi.getAuxiliaryGeometryCodecId(), params_.videoDecoderGeometryPath_ );
+        PCCVideoDecoder videoDecoder;
+        videoDecoder.setLogger( *logger_ );
+        videoDecoder.setSubstreamThreads( params_.videoDecoderThreads_ );
+        videoDecoder.setHardwareDevice( params_.videoDecoderHardware_ );
+        videoDecoder.setPool( videoDecoderPool_.get() );
+        videoDecoder.setNominalBitdepth( gi.getGeometry2dBitdepthMinus1() + 1, gi.getGeometryMSBAlignFlag() );
+        stage( "video geometry raw", -1, true );
+        videoDecoder.decompress( context.getVideoRawPointsGeometry(),    // video
+                                 context,                                // contexts
+                                 videoPath,                              // path
+                                 videoBitstreamMP,                       // bitstream
+                                 params_.byteStreamVideoCoderGeometry_,  // byte stream video coder
+                                 auxGeometryCodecId,                     // codecId
+                                 params_.videoDecoderGeometryPath_,      // decoder path
+                                 geometryBitDepth,                       // output bit depth
+                                 params_.keepIntermediateFiles_,         // keep intermediate files
+                                 params_.shvcLayerIndex_ );              // SHVC layer index
+        stage( "video geometry raw", -1, false );
+        std::cout << " raw points geometry -> " << videoBitstreamMP.size() << " B " << endl;
+      } );
+    }
 
-        if ( asps.getRawPatchEnabledFlag() && asps.getAuxiliaryVideoEnabledFlag() &&
-             sps.getAuxiliaryVideoPresentFlag( atlasIndex ) ) {
-          std::cout << "*******Video Decoding: Aux Attribute ********" << std::endl;
-          auto attributeIndex = static_cast<PCCVideoType>( VIDEO_ATTRIBUTE_RAW + attrPartitionIndex );
-          TRACE_PICTURE( "Attribute\n" );
-          TRACE_PICTURE( "AttrIdx = 0, AttrPartIdx = %d, AttrTypeID = %d, MapIdx = 0, AuxiliaryVideoFlag = 1\n",
-                         attrPartitionIndex, attributeTypeId );
-          auto& videoBitstreamMP    = context.getVideoBitstream( attributeIndex );
-          auto  auxAttributeCodecId = getCodedCodecId( context, ai.getAuxiliaryAttributeCodecId( attrIndex ),
-                                                      params_.videoDecoderAttributePath_ );
-          printf( "CodecId auxAttributeCodecId = %d \n", (int)auxAttributeCodecId );
-          videoDecoder.decompress( context.getVideoRawPointsAttribute(),        // video
-                                   context,                                     // contexts
-                                   path.str(),                                  // path
-                                   videoBitstreamMP,                            // bitstream
-                                   params_.byteStreamVideoCoderAttribute_,      // byte stream video coder
-                                   auxAttributeCodecId,                         // codecId
-                                   params_.videoDecoderAttributePath_,          // decoder path
-                                   attributeBitDepth,                           // output bit depth
-                                   params_.keepIntermediateFiles_,              // keep intermediate files
-                                   params_.shvcLayerIndex_,                     // SHVC layer index
-                                   false,                                       // patch color subsampling
-                                   params_.inverseColorSpaceConversionConfig_,  // inverse color space conversionConfig
-                                   params_.colorSpaceConversionPath_ );         // color space conversion path
-          // generateRawPointsAttributefromVideo( context, reconstructs );
-          std::cout << " raw points attribute -> " << videoBitstreamMP.size() << " B" << endl;
+    if ( ai.getAttributeCount() > 0 ) {
+      // this allocation is considering only one attribute, with a single partition, but multiple streams
+      if ( sps.getMultipleMapStreamsPresentFlag( atlasIndex ) ) {
+        context.getVideoAttributesMultiple().resize( mapCount );
+        for ( uint32_t mapIndex = 0; mapIndex < mapCount; mapIndex++ ) {
+          attributeTasks.run( [&, mapIndex] { decodeAttributeVideo( context, videoPath, atlasIndex, mapIndex ); } );
         }
+      } else {
+        attributeTasks.run( [&] { decodeAttributeVideo( context, videoPath, atlasIndex, -1 ); } );
+      }
+      if ( asps.getRawPatchEnabledFlag() && asps.getAuxiliaryVideoEnabledFlag() &&
+           sps.getAuxiliaryVideoPresentFlag( atlasIndex ) ) {
+        attributeTasks.run( [&] { decodeRawAttributeVideo( context, videoPath, atlasIndex ); } );
       }
     }
-  }
 
+    geometryTasks.wait();
+  } );
   reconstructs.setFrameCount( frameCount );
   // recreating the prediction list per attribute (either the attribute is coded absolute, or follows the geometry)
   // see contribution m52529
@@ -307,191 +260,478 @@ int PCCDecoder::decode( PCCContext& context, PCCGroupOfFrames& reconstructs, int
   }
   printf( "generate point cloud of %zu frames \n", frameCount );
   fflush( stdout );
-  for ( size_t frameIdx = 0; frameIdx < frameCount; frameIdx++ ) {
-    // All video have been decoded, start reconsctruction processes
+  context.setOccupancyPrecision( sps.getFrameWidth( atlasIndex ) / context.getVideoOccupancyMap().getWidth() );
+  if ( texturesCallback_ ) {
+    // The frames the callback reconstructs from their textures are not reconstructed here; the others are, one after
+    // the other, so that the two callbacks see the frames in order.
+    waitForAttributes();
+    for ( size_t frameIdx = 0; frameIdx < frameCount; frameIdx++ ) {
+      const PCCPostProcessing frameProcessing = postProcessing( frameIdx );
+      if ( !handTextures( context, frameIdx, atlasIndex, absoluteT1List, frameProcessing ) ) {
+        reconstructFrame( context, reconstructs, frameIdx, atlasIndex, absoluteT1List, waitForAttributes, nullptr,
+                          *this, frameProcessing );
+        frameDone( reconstructs[frameIdx], frameIdx );
+      }
+    }
+  } else if ( params_.parallelFrames_ && frameCount > 1 ) {
+    // Once the videos are decoded, the reconstruction of a frame only reads the shared context, so the frames are
+    // reconstructed as concurrent flow graph tasks, each with its own smoothing buffers, and handed out in frame
+    // order. The patch colours are drawn up front, in frame order, so the rand() sequence is the serial one.
+    waitForAttributes();
     if ( asps.getRawPatchEnabledFlag() && asps.getAuxiliaryVideoEnabledFlag() &&
          sps.getAuxiliaryVideoPresentFlag( atlasIndex ) ) {
-      for ( int attrIndex = 0; attrIndex < ai.getAttributeCount(); attrIndex++ ) {
-        int attributeDimensionPartitions = ai.getAttributeDimensionPartitionsMinus1( attrIndex ) + 1;
-        for ( int attrPartitionIndex = 0; attrPartitionIndex < attributeDimensionPartitions; attrPartitionIndex++ ) {
-          printf( "generateRawPointsAttributefromVideo attrIndex = %d attrPartitionIndex = %d \n", attrIndex,
-                  attrPartitionIndex );
-          fflush( stdout );
-          generateRawPointsAttributefromVideo( context, frameIdx );
-        }
+      context.getVideoRawPointsAttribute().resize( frameCount );
+    }
+    std::vector<std::vector<std::vector<PCCColor3B>>> patchColors( frameCount );
+    for ( size_t frameIdx = 0; frameIdx < frameCount; frameIdx++ ) {
+      patchColors[frameIdx].resize( context[frameIdx].getNumTilesInAtlasFrame() );
+      for ( size_t tileIdx = 0; tileIdx < patchColors[frameIdx].size(); tileIdx++ ) {
+        generatePatchColors( context[frameIdx].getTile( tileIdx ).getPatches().size(), patchColors[frameIdx][tileIdx] );
       }
-    }  // getAuxiliaryVideoEnabledFlag()
+    }
+    executionContext_->execute( [&] {
+      tbb::flow::graph                         graph;
+      tbb::flow::function_node<size_t, size_t> reconstruct( graph, tbb::flow::unlimited, [&]( size_t frameIdx ) {
+        PCCCodec smoother;
+        smoother.setExecutionContext( executionContext_ );
+        if ( logger_ != nullptr ) { smoother.setLogger( *logger_ ); }
+        reconstructFrame( context, reconstructs, frameIdx, atlasIndex, absoluteT1List, waitForAttributes,
+                          &patchColors[frameIdx], smoother, postProcessing( frameIdx ) );
+        return frameIdx;
+      } );
+      tbb::flow::sequencer_node<size_t> order( graph, []( const size_t& frameIdx ) { return frameIdx; } );
+      tbb::flow::function_node<size_t>  emit( graph, tbb::flow::serial, [&]( size_t frameIdx ) {
+        frameDone( reconstructs[frameIdx], frameIdx );
+        return tbb::flow::continue_msg();
+      } );
+      tbb::flow::make_edge( reconstruct, order );
+      tbb::flow::make_edge( order, emit );
+      for ( size_t frameIdx = 0; frameIdx < frameCount; frameIdx++ ) { reconstruct.try_put( frameIdx ); }
+      graph.wait_for_all();
+    } );
+  } else {
+    for ( size_t frameIdx = 0; frameIdx < frameCount; frameIdx++ ) {
+      reconstructFrame( context, reconstructs, frameIdx, atlasIndex, absoluteT1List, waitForAttributes, nullptr,
+                        *this, postProcessing( frameIdx ) );
+      frameDone( reconstructs[frameIdx], frameIdx );
+    }
+  }
+  waitForAttributes();
+  sampleMemory( "reconstruct", context, reconstructs );
+  executionContext_->leave();
+  return 0;
+}
 
-    context.setOccupancyPrecision( sps.getFrameWidth( atlasIndex ) / context.getVideoOccupancyMap().getWidth() );
-    GeneratePointCloudParameters gpcParams;
-    GeneratePointCloudParameters ppSEIParams;
+// Clears the flags of the post-processing the frame goes without; the colour transfer is left out by the caller.
+static void limitPostProcessing( GeneratePointCloudParameters& params, PCCPostProcessing postProcessing ) {
+  if ( postProcessing == POST_PROCESSING_FULL ) { return; }
+  params.flagColorSmoothing_ = false;
+  if ( postProcessing == POST_PROCESSING_NONE ) {
+    params.flagGeometrySmoothing_ = false;
+    params.gridSmoothing_         = false;
+    params.pbfEnableFlag_         = false;
+  }
+}
 
-    auto&                 reconstruct = reconstructs[frameIdx];
-    std::vector<uint32_t> partition;
-    // Decode point cloud
-    printf( "call generatePointCloud() \n" );
-    std::vector<size_t> accTilePointCount;
-    accTilePointCount.resize( ai.getAttributeCount(), 0 );
-    for ( size_t tileIdx = 0; tileIdx < context[frameIdx].getNumTilesInAtlasFrame(); tileIdx++ ) {
-      auto atglIndex = context.getAtlasHighLevelSyntax().getAtlasTileLayerIndex( frameIdx, tileIdx );
-      setGeneratePointCloudParameters( gpcParams, context, atglIndex );
-      setPostProcessingSeiParameters( ppSEIParams, context, atglIndex );
-      // std::cout << "Processing frame " << frameIdx << " tile " << tileIdx << std::endl;
-      auto& tile = context[frameIdx].getTile( tileIdx );
-      if ( !ppSEIParams.pbfEnableFlag_ ) {
-        generateOccupancyMap( tile, context.getVideoOccupancyMap().getFrame( tile.getFrameIndex() ),
-                              context.getOccupancyPrecision(), oi.getLossyOccupancyCompressionThreshold(),
-                              asps.getEomPatchEnabledFlag() );
-      }
-      if ( context[frameIdx].getNumTilesInAtlasFrame() > 1 ) {
-        generateTileBlockToPatchFromOccupancyMapVideo(
-            context, tile, frameIdx, context.getVideoOccupancyMap().getFrame( frameIdx ),
-            size_t( 1 ) << asps.getLog2PatchPackingBlockSize(), context.getOccupancyPrecision() );
+bool PCCDecoder::handTextures( PCCContext&                           context,
+                               size_t                                frameIdx,
+                               int32_t                               atlasIndex,
+                               const std::vector<std::vector<bool>>& absoluteT1List,
+                               PCCPostProcessing                     postProcessing ) {
+  auto& sps  = context.getVps();
+  auto& ai   = sps.getAttributeInformation( atlasIndex );
+  auto& oi   = sps.getOccupancyInformation( atlasIndex );
+  auto& asps = context.getAtlasSequenceParameterSet( 0 );
+  if ( context[frameIdx].getNumTilesInAtlasFrame() != 1 || ai.getAttributeCount() > 1 ||
+       asps.getEomPatchEnabledFlag() || asps.getRawPatchEnabledFlag() || asps.getPLREnabledFlag() ) {
+    return false;
+  }
+  GeneratePointCloudParameters gpcParams;
+  GeneratePointCloudParameters ppSEIParams;
+  auto                         atglIndex = context.getAtlasHighLevelSyntax().getAtlasTileLayerIndex( frameIdx, 0 );
+  setGeneratePointCloudParameters( gpcParams, context, atglIndex );
+  setPostProcessingSeiParameters( ppSEIParams, context, atglIndex );
+  limitPostProcessing( gpcParams, postProcessing );
+  limitPostProcessing( ppSEIParams, postProcessing );
+  const size_t mapCount = gpcParams.mapCountMinus1_ + 1;
+  if ( ppSEIParams.pbfEnableFlag_ || gpcParams.enableSizeQuantization_ || gpcParams.singleMapPixelInterleaving_ ||
+       gpcParams.pointLocalReconstruction_ || gpcParams.useAdditionalPointsPatch_ || mapCount > 2 ||
+       ( params_.applyGeoSmoothingType_ != 0 && ppSEIParams.flagGeometrySmoothing_ ) ||
+       ( params_.applyAttrSmoothingType_ != 0 && ppSEIParams.flagColorSmoothing_ ) ) {
+    return false;
+  }
+  // the second attribute map of multiple streams is a delta from the first one
+  if ( ai.getAttributeCount() > 0 && gpcParams.multipleStreams_ && mapCount > 1 && !absoluteT1List[0][1] ) {
+    return false;
+  }
+  auto& tile = context[frameIdx].getTile( 0 );
+  for ( auto& patch : tile.getPatches() ) {
+    if ( patch.getAxisOfAdditionalPlane() != 0 ) { return false; }
+  }
+  stage( "reconstruct", frameIdx, true );
+  auto& occupancy = context.getVideoOccupancyMap().getFrame( frameIdx );
+  generateOccupancyMap( tile, occupancy, context.getOccupancyPrecision(), oi.getLossyOccupancyCompressionThreshold(),
+                        false );
+  generateBlockToPatchFromOccupancyMapVideo( context, tile, frameIdx, occupancy,
+                                             size_t( 1 ) << asps.getLog2PatchPackingBlockSize(),
+                                             context.getOccupancyPrecision() );
+  PCCDecodedTextures textures;
+  textures.frameIndex            = frameIdx;
+  textures.tile                  = &tile;
+  textures.occupancy             = &occupancy;
+  textures.occupancyPrecision    = context.getOccupancyPrecision();
+  textures.occupancyResolution   = gpcParams.occupancyResolution_;
+  textures.absoluteD1            = gpcParams.absoluteD1_;
+  textures.removeDuplicatePoints = gpcParams.removeDuplicatePoints_;
+  textures.attributesRGB         = false;
+  const size_t shift = gpcParams.multipleStreams_ ? tile.getFrameIndex() : tile.getFrameIndex() * mapCount;
+  for ( size_t mapIdx = 0; mapIdx < mapCount; mapIdx++ ) {
+    textures.geometry.push_back( gpcParams.multipleStreams_
+                                     ? &context.getVideoGeometryMultiple()[mapIdx].getFrame( shift )
+                                     : &context.getVideoGeometryMultiple()[0].getFrame( shift + mapIdx ) );
+    if ( ai.getAttributeCount() > 0 ) {
+      textures.attributes.push_back( gpcParams.multipleStreams_
+                                         ? &context.getVideoAttributesMultiple()[mapIdx].getFrame( shift )
+                                         : &context.getVideoAttributesMultiple()[0].getFrame( shift + mapIdx ) );
+      textures.attributesRGB = context.getVideoAttributesMultiple( 0 ).getColorFormat() == PCCCOLORFORMAT::RGB444;
+    }
+  }
+  stage( "reconstruct", frameIdx, false );
+  texturesCallback_( textures );
+  return true;
+}
 
-      } else {
-        generateBlockToPatchFromOccupancyMapVideo(
-            context, tile, frameIdx, context.getVideoOccupancyMap().getFrame( frameIdx ),
-            size_t( 1 ) << asps.getLog2PatchPackingBlockSize(), context.getOccupancyPrecision() );
+void PCCDecoder::reconstructFrame( PCCContext&                                 context,
+                                   PCCGroupOfFrames&                           reconstructs,
+                                   size_t                                      frameIdx,
+                                   int32_t                                     atlasIndex,
+                                   const std::vector<std::vector<bool>>&       absoluteT1List,
+                                   const std::function<void()>&                waitForAttributes,
+                                   const std::vector<std::vector<PCCColor3B>>* tilePatchColors,
+                                   PCCCodec&                                   smoother,
+                                   PCCPostProcessing                           postProcessing ) {
+  auto& sps  = context.getVps();
+  auto& ai   = sps.getAttributeInformation( atlasIndex );
+  auto& oi   = sps.getOccupancyInformation( atlasIndex );
+  auto& asps = context.getAtlasSequenceParameterSet( 0 );
+  stage( "reconstruct", frameIdx, true );
+  // All video have been decoded, start reconsctruction processes
+  if ( asps.getRawPatchEnabledFlag() && asps.getAuxiliaryVideoEnabledFlag() &&
+       sps.getAuxiliaryVideoPresentFlag( atlasIndex ) ) {
+    waitForAttributes();
+    for ( int attrIndex = 0; attrIndex < ai.getAttributeCount(); attrIndex++ ) {
+      int attributeDimensionPartitions = ai.getAttributeDimensionPartitionsMinus1( attrIndex ) + 1;
+      for ( int attrPartitionIndex = 0; attrPartitionIndex < attributeDimensionPartitions; attrPartitionIndex++ ) {
+        printf( "generateRawPointsAttributefromVideo attrIndex = %d attrPartitionIndex = %d \n", attrIndex,
+                attrPartitionIndex );
+        fflush( stdout );
+        generateRawPointsAttributefromVideo( context, frameIdx );
       }
+    }
+  }  // getAuxiliaryVideoEnabledFlag()
+
+  GeneratePointCloudParameters gpcParams;
+  GeneratePointCloudParameters ppSEIParams;
+
+  auto&                 reconstruct = reconstructs[frameIdx];
+  std::vector<uint32_t> partition;
+  // Decode point cloud
+  printf( "call generatePointCloud() \n" );
+  std::vector<size_t> accTilePointCount;
+  accTilePointCount.resize( ai.getAttributeCount(), 0 );
+  for ( size_t tileIdx = 0; tileIdx < context[frameIdx].getNumTilesInAtlasFrame(); tileIdx++ ) {
+    auto atglIndex = context.getAtlasHighLevelSyntax().getAtlasTileLayerIndex( frameIdx, tileIdx );
+    setGeneratePointCloudParameters( gpcParams, context, atglIndex );
+    setPostProcessingSeiParameters( ppSEIParams, context, atglIndex );
+    limitPostProcessing( gpcParams, postProcessing );
+    limitPostProcessing( ppSEIParams, postProcessing );
+    // std::cout << "Processing frame " << frameIdx << " tile " << tileIdx << std::endl;
+    auto& tile = context[frameIdx].getTile( tileIdx );
+    if ( !ppSEIParams.pbfEnableFlag_ ) {
+      generateOccupancyMap( tile, context.getVideoOccupancyMap().getFrame( tile.getFrameIndex() ),
+                            context.getOccupancyPrecision(), oi.getLossyOccupancyCompressionThreshold(),
+                            asps.getEomPatchEnabledFlag() );
+    }
+    if ( context[frameIdx].getNumTilesInAtlasFrame() > 1 ) {
+      generateTileBlockToPatchFromOccupancyMapVideo(
+          context, tile, frameIdx, context.getVideoOccupancyMap().getFrame( frameIdx ),
+          size_t( 1 ) << asps.getLog2PatchPackingBlockSize(), context.getOccupancyPrecision() );
 
-      printf( "call generatePointCloud() \n" );
-      PCCPointSet3 tileReconstrct;
-      generatePointCloud( tileReconstrct, context, frameIdx, tileIdx, gpcParams, partition, true );
-      reconstruct.appendPointSet( tileReconstrct );
-      if ( context[frameIdx].getNumTilesInAtlasFrame() > 1 )
-        context[frameIdx].getTitleFrameContext().appendPointToPixel(
-            context[frameIdx].getTile( tileIdx ).getPointToPixel() );
-      if ( ai.getAttributeCount() > 0 ) {
-        reconstruct.addColors();
-        reconstruct.addColors16bit();
-        for ( size_t attIdx = 0; attIdx < ai.getAttributeCount(); attIdx++ ) {
-          printf( "start colorPointCloud attIdx = %zu / %u ] \n", attIdx, ai.getAttributeCount() );
-          fflush( stdout );
-          size_t updatedPointCount  = colorPointCloud( reconstruct, context, tile, absoluteT1List[attIdx],
-                                                      sps.getMultipleMapStreamsPresentFlag( atlasIndex ),
-                                                      ai.getAttributeCount(), accTilePointCount[attIdx], gpcParams );
-          accTilePointCount[attIdx] = updatedPointCount;
-        }
+    } else {
+      generateBlockToPatchFromOccupancyMapVideo(
+          context, tile, frameIdx, context.getVideoOccupancyMap().getFrame( frameIdx ),
+          size_t( 1 ) << asps.getLog2PatchPackingBlockSize(), context.getOccupancyPrecision() );
+    }
+
+    printf( "call generatePointCloud() \n" );
+    PCCPointSet3 tileReconstrct;
+    generatePointCloud( tileReconstrct, context, frameIdx, tileIdx, gpcParams, partition, true,
+                        tilePatchColors != nullptr ? &( *tilePatchColors )[tileIdx] : nullptr );
+    reconstruct.appendPointSet( tileReconstrct );
+    if ( context[frameIdx].getNumTilesInAtlasFrame() > 1 )
+      context[frameIdx].getTitleFrameContext().appendPointToPixel(
+          context[frameIdx].getTile( tileIdx ).getPointToPixel() );
+    if ( ai.getAttributeCount() > 0 ) {
+      waitForAttributes();
+      reconstruct.addColors();
+      reconstruct.addColors16bit();
+      for ( size_t attIdx = 0; attIdx < ai.getAttributeCount(); attIdx++ ) {
+        printf( "start colorPointCloud attIdx = %zu / %u ] \n", attIdx, ai.getAttributeCount() );
+        fflush( stdout );
+        size_t updatedPointCount  = colorPointCloud( reconstruct, context, tile, absoluteT1List[attIdx],
+                                                    sps.getMultipleMapStreamsPresentFlag( atlasIndex ),
+                                                    ai.getAttributeCount(), accTilePointCount[attIdx], gpcParams );
+        accTilePointCount[attIdx] = updatedPointCount;
       }
-    }  // tile
+    }
+  }  // tile
 
 #ifdef CONFORMANCE_TRACE
-    size_t numProjPoints = 0, numRawPoints = 0, numEomPoints = 0;
-    for ( size_t tileIdx = 0; tileIdx < context[frameIdx].getNumTilesInAtlasFrame(); tileIdx++ ) {
-      auto& tile = context[frameIdx].getTile( tileIdx );
-      numProjPoints += tile.getTotalNumberOfRegularPoints();
-      numEomPoints += tile.getTotalNumberOfEOMPoints();
-      numRawPoints += tile.getTotalNumberOfRawPoints();
-    }  // tile
-    if ( ai.getAttributeCount() == 0 ) {
-      reconstructs[frameIdx].removeColors();
-      reconstructs[frameIdx].removeColors16bit();
+  size_t numProjPoints = 0, numRawPoints = 0, numEomPoints = 0;
+  for ( size_t tileIdx = 0; tileIdx < context[frameIdx].getNumTilesInAtlasFrame(); tileIdx++ ) {
+    auto& tile = context[frameIdx].getTile( tileIdx );
+    numProjPoints += tile.getTotalNumberOfRegularPoints();
+    numEomPoints += tile.getTotalNumberOfEOMPoints();
+    numRawPoints += tile.getTotalNumberOfRawPoints();
+  }  // tile
+  if ( ai.getAttributeCount() == 0 ) {
+    reconstructs[frameIdx].removeColors();
+    reconstructs[frameIdx].removeColors16bit();
+  } else {
+    bool isAttributes444 = context.getVideoAttributesMultiple( 0 ).getColorFormat() == PCCCOLORFORMAT::RGB444;
+    if ( !isAttributes444 ) {  // lossy: convert 16-bit yuv444 to 8-bit RGB444
+      reconstructs[frameIdx].convertYUV16ToRGB8();
     } else {
-      bool isAttributes444 = context.getVideoAttributesMultiple( 0 ).getColorFormat() == PCCCOLORFORMAT::RGB444;
-      if ( !isAttributes444 ) {  // lossy: convert 16-bit yuv444 to 8-bit RGB444
-        reconstructs[frameIdx].convertYUV16ToRGB8();
-      } else {
-        reconstructs[frameIdx].copyRGB16ToRGB8();
-      }
+      reconstructs[frameIdx].copyRGB16ToRGB8();
     }
-    TRACE_PCFRAME( "AtlasFrameIndex = %d\n", frameIdx );
-    TRACE_PCFRAME( "PointCloudFrameOrderCntVal = %d, NumProjPoints = %zu, NumRawPoints = %zu, NumEomPoints = %zu,",
-                   frameIdx, numProjPoints, numRawPoints, numEomPoints );
-    auto checksumFrame = reconstructs[frameIdx].computeChecksum( true );
-    TRACE_PCFRAME( " MD5 checksum = " );
-    for ( auto& c : checksumFrame ) { TRACE_PCFRAME( "%02x", c ); }
-    TRACE_PCFRAME( "\n" );
+  }
+  TRACE_PCFRAME( "AtlasFrameIndex = %d\n", frameIdx );
+  TRACE_PCFRAME( "PointCloudFrameOrderCntVal = %d, NumProjPoints = %zu, NumRawPoints = %zu, NumEomPoints = %zu,",
+                 frameIdx, numProjPoints, numRawPoints, numEomPoints );
+  auto checksumFrame = reconstructs[frameIdx].computeChecksum( true );
+  TRACE_PCFRAME( " MD5 checksum = " );
+  for ( auto& c : checksumFrame ) { TRACE_PCFRAME( "%02x", c ); }
+  TRACE_PCFRAME( "\n" );
 #endif
 
-    // Post-Processing
-    TRACE_PATCH( "Post-Processing: postprocessSmoothing = %zu pbfEnableFlag = %d \n", params_.attrTransferFilterType_,
-                 ppSEIParams.pbfEnableFlag_ );
-    if ( params_.applyGeoSmoothingType_ != 0 && ppSEIParams.flagGeometrySmoothing_ ) {
-      PCCPointSet3 tempFrameBuffer = reconstruct;
-      if ( ppSEIParams.gridSmoothing_ ) {
-        smoothPointCloudPostprocess( reconstruct, params_.colorTransform_, ppSEIParams, partition );
-      }
-      if ( ai.getAttributeCount() > 0 ) {
-        bool isAttributes444 = context.getVideoAttributesMultiple( 0 ).getColorFormat() == PCCCOLORFORMAT::RGB444;
-        printf( "isAttributes444 = %d Format = %d \n", isAttributes444,
-                context.getVideoAttributesMultiple( 0 ).getColorFormat() );
-        fflush( stdout );
-
-        if ( !ppSEIParams.pbfEnableFlag_ ) {
-          // These are different attribute transfer functions
-          if ( params_.attrTransferFilterType_ == 1 || params_.attrTransferFilterType_ == 5 ) {
-            TRACE_PATCH( " transferColors16bitBP \n" );
-            tempFrameBuffer.transferColors16bitBP( reconstruct,                      // target
-                                                   params_.attrTransferFilterType_,  // filterType
-                                                   int32_t( 0 ),                     // searchRange
-                                                   isAttributes444,                  // losslessAttribute
-                                                   8,                                // numNeighborsColorTransferFwd
-                                                   1,                                // numNeighborsColorTransferBwd
-                                                   true,                             // useDistWeightedAverageFwd
-                                                   true,                             // useDistWeightedAverageBwd
-                                                   true,        // skipAvgIfIdenticalSourcePointPresentFwd
-                                                   false,       // skipAvgIfIdenticalSourcePointPresentBwd
-                                                   4,           // distOffsetFwd
-                                                   4,           // distOffsetBwd
-                                                   1000,        // maxGeometryDist2Fwd
-                                                   1000,        // maxGeometryDist2Bwd
-                                                   1000 * 256,  // maxColorDist2Fwd
-                                                   1000 * 256   // maxColorDist2Bwd
-            );
-          } else if ( params_.attrTransferFilterType_ == 2 ) {
-            TRACE_PATCH( " transferColorWeight \n" );
-            tempFrameBuffer.transferColorWeight( reconstruct, 0.1 );
-          } else if ( params_.attrTransferFilterType_ == 3 ) {
-            TRACE_PATCH( " transferColorsFilter3 \n" );
-            tempFrameBuffer.transferColorsFilter3( reconstruct, int32_t( 0 ), isAttributes444 );
-          } else if ( params_.attrTransferFilterType_ == 7 || params_.attrTransferFilterType_ == 9 ) {
-            TRACE_PATCH( " transferColorsFilter3 \n" );
-            tempFrameBuffer.transferColorsBackward16bitBP( reconstruct,                      //  target
-                                                           params_.attrTransferFilterType_,  //  filterType
-                                                           int32_t( 0 ),                     //  searchRange
-                                                           isAttributes444,                  //  losslessAttribute
-                                                           8,           //  numNeighborsColorTransferFwd
-                                                           1,           //  numNeighborsColorTransferBwd
-                                                           true,        //  useDistWeightedAverageFwd
-                                                           true,        //  useDistWeightedAverageBwd
-                                                           true,        //  skipAvgIfIdenticalSourcePointPresentFwd
-                                                           false,       //  skipAvgIfIdenticalSourcePointPresentBwd
-                                                           4,           //  distOffsetFwd
-                                                           4,           //  distOffsetBwd
-                                                           1000,        //  maxGeometryDist2Fwd
-                                                           1000,        //  maxGeometryDist2Bwd
-                                                           1000 * 256,  //  maxColorDist2Fwd
-                                                           1000 * 256   //  maxColorDist2Bwd
-            );
-          }
-        }
-      }  // if ( ai.getAttributeCount() > 0 )
+  stage( "reconstruct", frameIdx, false );
+  stage( "smoothing", frameIdx, true );
+  // Post-Processing
+  TRACE_PATCH( "Post-Processing: postprocessSmoothing = %zu pbfEnableFlag = %d \n", params_.attrTransferFilterType_,
+               ppSEIParams.pbfEnableFlag_ );
+  if ( params_.applyGeoSmoothingType_ != 0 && ppSEIParams.flagGeometrySmoothing_ ) {
+    // The smoothing is done in place: the colour transfer only needs the positions and the colours of the frame as it
+    // was before it, so only these are kept aside, and only when there is a transfer.
+    const auto   filterType      = postProcessing == POST_PROCESSING_FULL ? params_.attrTransferFilterType_ : 0;
+    const bool   transferColors  = ai.getAttributeCount() > 0 && !ppSEIParams.pbfEnableFlag_ &&
+                                  ( filterType == 1 || filterType == 2 || filterType == 3 || filterType == 5 ||
+                                    filterType == 7 || filterType == 9 );
+    PCCPointSet3 tempFrameBuffer;
+    if ( transferColors ) { reconstruct.copyPositionsAndColors( tempFrameBuffer ); }
+    if ( ppSEIParams.gridSmoothing_ ) {
+      PCC_PROFILE_ZONE( "geometry smoothing" );
+      smoother.smoothPointCloudPostprocess( reconstruct, params_.colorTransform_, ppSEIParams, partition );
     }
     if ( ai.getAttributeCount() > 0 ) {
-      if ( params_.applyAttrSmoothingType_ != 0 && ppSEIParams.flagColorSmoothing_ ) {
-        TRACE_PATCH( " colorSmoothing \n" );
-        colorSmoothing( reconstruct, params_.colorTransform_, ppSEIParams );
-      }
-      if ( context.getVideoAttributesMultiple( 0 ).getColorFormat() !=
-           PCCCOLORFORMAT::RGB444 ) {  // lossy: convert 16-bit yuv444 to 8-bit RGB444
-        TRACE_PATCH( "lossy: convert 16-bit yuv444 to 8-bit RGB444 (convertYUV16ToRGB8) \n" );
-        reconstruct.convertYUV16ToRGB8();
-      } else {  // lossless: copy 16-bit RGB to 8-bit RGB
-        TRACE_PATCH( "lossy: lossless: copy 16-bit RGB to 8-bit RGB (copyRGB16ToRGB8) \n" );
-        reconstruct.copyRGB16ToRGB8();
+      bool isAttributes444 = context.getVideoAttributesMultiple( 0 ).getColorFormat() == PCCCOLORFORMAT::RGB444;
+      printf( "isAttributes444 = %d Format = %d \n", isAttributes444,
+              context.getVideoAttributesMultiple( 0 ).getColorFormat() );
+      fflush( stdout );
+
+      if ( !ppSEIParams.pbfEnableFlag_ ) {
+        // These are different attribute transfer functions
+        if ( filterType == 1 || filterType == 5 ) {
+          TRACE_PATCH( " transferColors16bitBP \n" );
+          tempFrameBuffer.transferColors16bitBP( reconstruct,                      // target
+                                                 filterType,                       // filterType
+                                                 int32_t( 0 ),                     // searchRange
+                                                 isAttributes444,                  // losslessAttribute
+                                                 8,                                // numNeighborsColorTransferFwd
+                                                 1,                                // numNeighborsColorTransferBwd
+                                                 true,                             // useDistWeightedAverageFwd
+                                                 true,                             // useDistWeightedAverageBwd
+                                                 true,        // skipAvgIfIdenticalSourcePointPresentFwd
+                                                 false,       // skipAvgIfIdenticalSourcePointPresentBwd
+                                                 4,           // distOffsetFwd
+                                                 4,           // distOffsetBwd
+                                                 1000,        // maxGeometryDist2Fwd
+                                                 1000,        // maxGeometryDist2Bwd
+                                                 1000 * 256,  // maxColorDist2Fwd
+                                                 1000 * 256   // maxColorDist2Bwd
+          );
+        } else if ( filterType == 2 ) {
+          TRACE_PATCH( " transferColorWeight \n" );
+          tempFrameBuffer.transferColorWeight( reconstruct, 0.1 );
+        } else if ( filterType == 3 ) {
+          TRACE_PATCH( " transferColorsFilter3 \n" );
+          tempFrameBuffer.transferColorsFilter3( reconstruct, int32_t( 0 ), isAttributes444 );
+        } else if ( filterType == 7 || filterType == 9 ) {
+          TRACE_PATCH( " transferColorsFilter3 \n" );
+          tempFrameBuffer.transferColorsBackward16bitBP( reconstruct,                      //  target
+                                                         filterType,                       //  filterType
+                                                         int32_t( 0 ),                     //  searchRange
+                                                         isAttributes444,                  //  losslessAttribute
+                                                         8,           //  numNeighborsColorTransferFwd
+                                                         1,           //  numNeighborsColorTransferBwd
+                                                         true,        //  useDistWeightedAverageFwd
+                                                         true,        //  useDistWeightedAverageBwd
+                                                         true,        //  skipAvgIfIdenticalSourcePointPresentFwd
+                                                         false,       //  skipAvgIfIdenticalSourcePointPresentBwd
+                                                         4,           //  distOffsetFwd
+                                                         4,           //  distOffsetBwd
+                                                         1000,        //  maxGeometryDist2Fwd
+                                                         1000,        //  maxGeometryDist2Bwd
+                                                         1000 * 256,  //  maxColorDist2Fwd
+                                                         1000 * 256   //  maxColorDist2Bwd
+          );
+        }
       }
+    }  // if ( ai.getAttributeCount() > 0 )
+  }
+  if ( ai.getAttributeCount() > 0 ) {
+    if ( params_.applyAttrSmoothingType_ != 0 && ppSEIParams.flagColorSmoothing_ ) {
+      TRACE_PATCH( " colorSmoothing \n" );
+      PCC_PROFILE_ZONE( "color smoothing" );
+      smoother.colorSmoothing( reconstruct, params_.colorTransform_, ppSEIParams );
+    }
+    if ( context.getVideoAttributesMultiple( 0 ).getColorFormat() !=
+         PCCCOLORFORMAT::RGB444 ) {  // lossy: convert 16-bit yuv444 to 8-bit RGB444
+      TRACE_PATCH( "lossy: convert 16-bit yuv444 to 8-bit RGB444 (convertYUV16ToRGB8) \n" );
+      reconstruct.convertYUV16ToRGB8();
+    } else {  // lossless: copy 16-bit RGB to 8-bit RGB
+      TRACE_PATCH( "lossy: lossless: copy 16-bit RGB to 8-bit RGB (copyRGB16ToRGB8) \n" );
+      reconstruct.copyRGB16ToRGB8();
     }
-    /*auto tmp = reconstruct.computeChecksum();
-    TRACE_PCFRAME( " MD5 checksum = " );
-    for ( auto& c : tmp ) { TRACE_PCFRAME( "%02x", c ); }
-    TRACE_PCFRAME( "\n" );*/
+    reconstruct.removeColors16bit();
+  }
+  stage( "smoothing", frameIdx, false );
+  /*auto tmp = reconstruct.computeChecksum();
+  TRACE_PCFRAME( " MD5 checksum = " );
+  for ( auto& c : tmp ) { TRACE_PCFRAME( "%02x", c ); }
+  TRACE_PCFRAME( "\n" );*/
+  if ( params_.verifyChecksums_ ) {
     TRACE_RECFRAME( "AtlasFrameIndex = %d\n", frameIdx );
     auto checksum = reconstructs[frameIdx].computeChecksum( true );
     TRACE_RECFRAME( " MD5 checksum = " );
     for ( auto& c : checksum ) { TRACE_RECFRAME( "%02x", c ); }
     TRACE_RECFRAME( "\n" );
   }
-  return 0;
+}
+
+void PCCDecoder::decodeAttributeVideo( PCCContext&        context,
+                                       const std::string& path,
+                                       int32_t            atlasIndex,
+                                       int32_t            mapIndex ) {
+  auto&           sps = context.getVps();
+  auto&           ai  = sps.getAttributeInformation( atlasIndex );
+  PCCVideoDecoder videoDecoder;
+  videoDecoder.setLogger( *logger_ );
+  videoDecoder.setSubstreamThreads( params_.videoDecoderThreads_ );
+  videoDecoder.setHardwareDevice( params_.videoDecoderHardware_ );
+  videoDecoder.setPool( videoDecoderPool_.get() );
+  for ( int attrIndex = 0; attrIndex < ai.getAttributeCount(); attrIndex++ ) {
+    int  attributeBitDepth  = ai.getAttribute2dBitdepthMinus1( attrIndex ) + 1;
+    int  attributeTypeId    = ai.getAttributeTypeId( attrIndex );
+    int  attributeDimension = ai.getAttributeDimensionPartitionsMinus1( attrIndex ) + 1;
+    auto attributeCodecId =
+        getCodedCodecId( context, ai.getAttributeCodecId( attrIndex ), params_.videoDecoderAttributePath_ );
+    printf( "CodecId attributeCodecId = %d \n", (int)attributeCodecId );
+    for ( int attrPartitionIndex = 0; attrPartitionIndex < attributeDimension; attrPartitionIndex++ ) {
+      if ( mapIndex >= 0 ) {
+        // decompress T[mapIndex]
+        TRACE_PICTURE( "Attribute\n" );
+        TRACE_PICTURE( "AttrIdx = %d, AttrPartIdx = %d, AttrTypeID = %d, MapIdx = %d, AuxiliaryVideoFlag = 0\n",
+                       attrIndex, attrPartitionIndex, attributeTypeId, mapIndex );
+        std::cout << "*******Video Decoding: Attribute [" << mapIndex << "] ********" << std::endl;
+        auto  attributeIndex = static_cast<PCCVideoType>( VIDEO_ATTRIBUTE_T0 + attrPartitionIndex +
+                                                         MAX_NUM_ATTR_PARTITIONS * mapIndex );
+        auto& videoBitstream = context.getVideoBitstream( attributeIndex );
+        stage( "video attribute", -1, true );
+        videoDecoder.decompress( context.getVideoAttributesMultiple( mapIndex ),  // video
+                                 context,                                         // contexts
+                                 path,                                            // path
+                                 videoBitstream,                                  // bitstream
+                                 params_.byteStreamVideoCoderAttribute_,          // byte stream video coder
+                                 attributeCodecId,                                // codecId
+                                 params_.videoDecoderAttributePath_,              // decoder path
+                                 attributeBitDepth,                               // output bit depth
+                                 params_.keepIntermediateFiles_,                  // keep intermediate files
+                                 params_.shvcLayerIndex_,                         // SHVC layer index
+                                 params_.patchColorSubsampling_,                  // patch color subsampling
+                                 params_.inverseColorSpaceConversionConfig_,      // inverse color space conversion
+                                 params_.colorSpaceConversionPath_ );             // color space conversion path
+        stage( "video attribute", -1, false );
+        std::cout << "attribute T" << mapIndex << " video ->" << videoBitstream.size() << " B" << std::endl;
+      } else {
+        TRACE_PICTURE( "Attribute\n" );
+        TRACE_PICTURE( "AttrIdx = 0, AttrPartIdx = %d, AttrTypeID = %d, MapIdx = 0, AuxiliaryVideoFlag = 0\n",
+                       attrPartitionIndex, attributeTypeId );
+        std::cout << "*******Video Decoding: Attribute ********" << std::endl;
+        auto  attributeIndex = static_cast<PCCVideoType>( VIDEO_ATTRIBUTE + attrPartitionIndex );
+        auto& videoBitstream = context.getVideoBitstream( attributeIndex );
+        printf( " Decode T size = %zu \n", videoBitstream.size() );
+        fflush( stdout );
+        stage( "video attribute", -1, true );
+        videoDecoder.decompress( context.getVideoAttributesMultiple( 0 ),     // video
+                                 context,                                     // contexts
+                                 path,                                        // path
+                                 videoBitstream,                              // bitstream
+                                 params_.byteStreamVideoCoderAttribute_,      // byte stream video coder
+                                 attributeCodecId,                            // codecId
+                                 params_.videoDecoderAttributePath_,          // decoder path
+                                 attributeBitDepth,                           // output bit depth
+                                 params_.keepIntermediateFiles_,              // keep intermediate files
+                                 params_.shvcLayerIndex_,                     // SHVC layer index
+                                 params_.patchColorSubsampling_,              // patch color subsampling
+                                 params_.inverseColorSpaceConversionConfig_,  // inverse color space conversionConfig
+                                 params_.colorSpaceConversionPath_ );         // color space conversion path
+        stage( "video attribute", -1, false );
+        std::cout << "attribute video  ->" << videoBitstream.size() << " B" << std::endl;
+      }
+    }
+  }
+}
+
+void PCCDecoder::decodeRawAttributeVideo( PCCContext& context, const std::string& path, int32_t atlasIndex ) {
+  auto&           sps = context.getVps();
+  auto&           ai  = sps.getAttributeInformation( atlasIndex );
+  PCCVideoDecoder videoDecoder;
+  videoDecoder.setLogger( *logger_ );
+  videoDecoder.setSubstreamThreads( params_.videoDecoderThreads_ );
+  videoDecoder.setHardwareDevice( params_.videoDecoderHardware_ );
+  videoDecoder.setPool( videoDecoderPool_.get() );
+  for ( int attrIndex = 0; attrIndex < ai.getAttributeCount(); attrIndex++ ) {
+    int attributeBitDepth  = ai.getAttribute2dBitdepthMinus1( attrIndex ) + 1;
+    int attributeTypeId    = ai.getAttributeTypeId( attrIndex );
+    int attributeDimension = ai.getAttributeDimensionPartitionsMinus1( attrIndex ) + 1;
+    for ( int attrPartitionIndex = 0; attrPartitionIndex < attributeDimension; attrPartitionIndex++ ) {
+      std::cout << "*******Video Decoding: Aux Attribute ********" << std::endl;
+      auto attributeIndex = static_cast<PCCVideoType>( VIDEO_ATTRIBUTE_RAW + attrPartitionIndex );
+      TRACE_PICTURE( "Attribute\n" );
+      TRACE_PICTURE( "AttrIdx = 0, AttrPartIdx = %d, AttrTypeID = %d, MapIdx = 0, AuxiliaryVideoFlag = 1\n",
+                     attrPartitionIndex, attributeTypeId );
+      auto& videoBitstreamMP    = context.getVideoBitstream( attributeIndex );
+      auto  auxAttributeCodecId = getCodedCodecId( context, ai.getAuxiliaryAttributeCodecId( attrIndex ),
+                                                  params_.videoDecoderAttributePath_ );
+      printf( "CodecId auxAttributeCodecId = %d \n", (int)auxAttributeCodecId );
+      stage( "video attribute raw", -1, true );
+      videoDecoder.decompress( context.getVideoRawPointsAttribute(),        // video
+                               context,                                     // contexts
+                               path,                                        // path
+                               videoBitstreamMP,                            // bitstream
+                               params_.byteStreamVideoCoderAttribute_,      // byte stream video coder
+                               auxAttributeCodecId,                         // codecId
+                               params_.videoDecoderAttributePath_,          // decoder path
+                               attributeBitDepth,                           // output bit depth
+                               params_.keepIntermediateFiles_,              // keep intermediate files
+                               params_.shvcLayerIndex_,                     // SHVC layer index
+                               false,                                       // patch color subsampling
+                               params_.inverseColorSpaceConversionConfig_,  // inverse color space conversionConfig
+                               params_.colorSpaceConversionPath_ );         // color space conversion path
+      stage( "video attribute raw", -1, false );
+      std::cout << " raw points attribute -> " << videoBitstreamMP.size() << " B" << endl;
+    }
+  }
 }
 
 void PCCDecoder::setPointLocalReconstruction( PCCContext& context ) {
@@ -572,6 +812,7 @@ void PCCDecoder::setPostProcessingSeiParameters( GeneratePointCloudParameters& p
   params.gridSmoothing_         = false;
   params.gridSize_              = 0;
   params.thresholdSmoothing_    = 0;
+  params.fixedPointSmoothing_   = params_.fixedPointSmoothing_;
   params.pbfEnableFlag_         = false;
   params.pbfPassesCount_        = 0;
   params.pbfFilterSize_         = 0;
@@ -669,6 +910,7 @@ void PCCDecoder::setGeneratePointCloudParameters( GeneratePointCloudParameters&
   params.gridSmoothing_         = false;
   params.gridSize_              = 0;
   params.thresholdSmoothing_    = 0;
+  params.fixedPointSmoothing_   = params_.fixedPointSmoothing_;
   params.pbfEnableFlag_         = false;
   params.pbfPassesCount_        = 0;
   params.pbfFilterSize_         = 0;
@@ -770,69 +1012,86 @@ void PCCDecoder::createPatchFrameDataStructure( PCCContext& context ) {
   }
   context.resize( frameCount );
   setPointLocalReconstruction( context );
-  for ( size_t atglIndex = 0; atglIndex < atlList.size(); atglIndex++ ) {
-    auto& atgl = atlList[atglIndex];
-    if ( atglIndex == 0 || atgl.getAtlasFrmOrderCntVal() != atlList[atglIndex - 1].getAtlasFrmOrderCntVal() ) {
-      setTileSizeAndLocation( context, atgl.getHeader().getFrameIndex(), atgl.getHeader() );
+  // the tiles of an atlas frame are built in parallel; the inter patches refer to the tiles of the previous frames,
+  // so the frames are built in order
+  for ( size_t frameStart = 0, frameEnd = 0; frameStart < atlList.size(); frameStart = frameEnd ) {
+    frameEnd = frameStart + 1;
+    while ( frameEnd < atlList.size() &&
+            atlList[frameEnd].getAtlasFrmOrderCntVal() == atlList[frameStart].getAtlasFrmOrderCntVal() ) {
+      frameEnd++;
+    }
+    auto& ath = atlList[frameStart].getHeader();
+    setTileSizeAndLocation( context, ath.getFrameIndex(), ath );
+#ifdef CODEC_TRACE
+    for ( size_t atglIndex = frameStart; atglIndex < frameEnd; atglIndex++ ) {
+      createPatchFrameDataStructure( context, atglIndex );
+    }
+#else
+    tbb::parallel_for( frameStart, frameEnd,
+                       [&]( const size_t atglIndex ) { createPatchFrameDataStructure( context, atglIndex ); } );
+#endif
+    for ( size_t atglIndex = frameStart; atglIndex < frameEnd; atglIndex++ ) {
+      createPatchFrameDataStructureSEI( context, atglIndex );
     }
-    auto&  atlu       = context.getAtlasTileLayer( atglIndex );
-    auto&  ath        = atlu.getHeader();
-    size_t frameIndex = ath.getFrameIndex();
-    createPatchFrameDataStructure( context, atglIndex );
+  }
+}
 
+void PCCDecoder::createPatchFrameDataStructureSEI( PCCContext& context, size_t atglIndex ) {
+  auto& atlList = context.getAtlasTileLayerList();
+  auto& atgl    = atlList[atglIndex];
 #ifdef CONFORMANCE_TRACE
-    if ( atgl.getSEI().seiIsPresent( NAL_PREFIX_ESEI, GEOMETRY_SMOOTHING ) ) {
-      auto* sei = static_cast<SEIGeometrySmoothing*>( atgl.getSEI().getSei( NAL_PREFIX_ESEI, GEOMETRY_SMOOTHING ) );
-      auto& vec = sei->getMD5ByteStrData();
-      if ( vec.size() > 0 ) {
-        TRACE_HLS( "**********GEOMETRY_SMOOTHING_ESEI***********\n" );
-        TRACE_HLS( "SEI%02dMD5 = ", sei->getPayloadType() );
-        SEIMd5Checksum( context, vec );
-      }
+  size_t frameIndex = atgl.getHeader().getFrameIndex();
+  if ( atgl.getSEI().seiIsPresent( NAL_PREFIX_ESEI, GEOMETRY_SMOOTHING ) ) {
+    auto* sei = static_cast<SEIGeometrySmoothing*>( atgl.getSEI().getSei( NAL_PREFIX_ESEI, GEOMETRY_SMOOTHING ) );
+    auto& vec = sei->getMD5ByteStrData();
+    if ( vec.size() > 0 ) {
+      TRACE_HLS( "**********GEOMETRY_SMOOTHING_ESEI***********\n" );
+      TRACE_HLS( "SEI%02dMD5 = ", sei->getPayloadType() );
+      SEIMd5Checksum( context, vec );
     }
-    if ( atgl.getSEI().seiIsPresent( NAL_PREFIX_ESEI, OCCUPANCY_SYNTHESIS ) ) {
-      auto* sei = static_cast<SEIOccupancySynthesis*>( atgl.getSEI().getSei( NAL_PREFIX_ESEI, OCCUPANCY_SYNTHESIS ) );
-      auto& vec = sei->getMD5ByteStrData();
-      if ( vec.size() > 0 ) {
-        TRACE_HLS( "**********OCCUPANCY_SYNTHESIS_ESEI***********\n" );
-        TRACE_HLS( "SEI%02dMD5 = ", sei->getPayloadType() );
-        SEIMd5Checksum( context, vec );
-      }
+  }
+  if ( atgl.getSEI().seiIsPresent( NAL_PREFIX_ESEI, OCCUPANCY_SYNTHESIS ) ) {
+    auto* sei = static_cast<SEIOccupancySynthesis*>( atgl.getSEI().getSei( NAL_PREFIX_ESEI, OCCUPANCY_SYNTHESIS ) );
+    auto& vec = sei->getMD5ByteStrData();
+    if ( vec.size() > 0 ) {
+      TRACE_HLS( "**********OCCUPANCY_SYNTHESIS_ESEI***********\n" );
+      TRACE_HLS( "SEI%02dMD5 = ", sei->getPayloadType() );
+      SEIMd5Checksum( context, vec );
     }
-    if ( atgl.getSEI().seiIsPresent( NAL_PREFIX_ESEI, ATTRIBUTE_SMOOTHING ) ) {
-      auto* sei = static_cast<SEIAttributeSmoothing*>( atgl.getSEI().getSei( NAL_PREFIX_ESEI, ATTRIBUTE_SMOOTHING ) );
-      auto& vec = sei->getMD5ByteStrData();
-      if ( vec.size() > 0 ) {
-        TRACE_HLS( "**********ATTRIBUTE_SMOOTHING_ESEI***********\n" );
-        TRACE_HLS( "SEI%02dMD5 = ", sei->getPayloadType() );
-        SEIMd5Checksum( context, vec );
-      }
+  }
+  if ( atgl.getSEI().seiIsPresent( NAL_PREFIX_ESEI, ATTRIBUTE_SMOOTHING ) ) {
+    auto* sei = static_cast<SEIAttributeSmoothing*>( atgl.getSEI().getSei( NAL_PREFIX_ESEI, ATTRIBUTE_SMOOTHING ) );
+    auto& vec = sei->getMD5ByteStrData();
+    if ( vec.size() > 0 ) {
+      TRACE_HLS( "**********ATTRIBUTE_SMOOTHING_ESEI***********\n" );
+      TRACE_HLS( "SEI%02dMD5 = ", sei->getPayloadType() );
+      SEIMd5Checksum( context, vec );
     }
-    if ( atgl.getSEI().seiIsPresent( NAL_PREFIX_ESEI, COMPONENT_CODEC_MAPPING ) ) {
-      auto* sei =
-          static_cast<SEIOccupancySynthesis*>( atgl.getSEI().getSei( NAL_PREFIX_ESEI, COMPONENT_CODEC_MAPPING ) );
-      auto& temp = sei->getMD5ByteStrData();
-      if ( temp.size() > 0 ) {
-        TRACE_HLS( "**********CODEC_COMPONENT_MAPPING_ESEI***********\n" );
-        TRACE_HLS( "SEI%02dMD5 = ", sei->getPayloadType() );
-        SEIMd5Checksum( context, temp );
-      }
+  }
+  if ( atgl.getSEI().seiIsPresent( NAL_PREFIX_ESEI, COMPONENT_CODEC_MAPPING ) ) {
+    auto* sei = static_cast<SEIOccupancySynthesis*>( atgl.getSEI().getSei( NAL_PREFIX_ESEI, COMPONENT_CODEC_MAPPING ) );
+    auto& temp = sei->getMD5ByteStrData();
+    if ( temp.size() > 0 ) {
+      TRACE_HLS( "**********CODEC_COMPONENT_MAPPING_ESEI***********\n" );
+      TRACE_HLS( "SEI%02dMD5 = ", sei->getPayloadType() );
+      SEIMd5Checksum( context, temp );
     }
+  }
 #endif
-    bool isLastTileOfTheFrames = atglIndex + 1 == atlList.size() ||
-                                 atgl.getAtlasFrmOrderCntVal() != atlList[atglIndex + 1].getAtlasFrmOrderCntVal();
-    if ( isLastTileOfTheFrames && atgl.getSEI().seiIsPresent( NAL_SUFFIX_NSEI, DECODED_ATLAS_INFORMATION_HASH ) ) {
-      auto* sei = static_cast<SEIDecodedAtlasInformationHash*>(
-          atgl.getSEI().getSei( NAL_SUFFIX_NSEI, DECODED_ATLAS_INFORMATION_HASH ) );
-      TRACE_PATCH( "create Hash SEI \n" );
-      auto& atlu = context.getAtlasTileLayer( atglIndex );
-      auto& ath  = atlu.getHeader();
-      createHashSEI( context, ath.getFrameIndex(), *sei );
-    }
+  bool isLastTileOfTheFrames = atglIndex + 1 == atlList.size() ||
+                               atgl.getAtlasFrmOrderCntVal() != atlList[atglIndex + 1].getAtlasFrmOrderCntVal();
+  if ( params_.verifyChecksums_ && isLastTileOfTheFrames &&
+       atgl.getSEI().seiIsPresent( NAL_SUFFIX_NSEI, DECODED_ATLAS_INFORMATION_HASH ) ) {
+    auto* sei = static_cast<SEIDecodedAtlasInformationHash*>(
+        atgl.getSEI().getSei( NAL_SUFFIX_NSEI, DECODED_ATLAS_INFORMATION_HASH ) );
+    TRACE_PATCH( "create Hash SEI \n" );
+    auto& atlu = context.getAtlasTileLayer( atglIndex );
+    auto& ath  = atlu.getHeader();
+    createHashSEI( context, ath.getFrameIndex(), *sei );
+  }
 #ifdef CONFORMANCE_TRACE
-    if ( isLastTileOfTheFrames ) { createHlsAtlasTileLogFiles( context, frameIndex ); }
+  if ( isLastTileOfTheFrames ) { createHlsAtlasTileLogFiles( context, frameIndex ); }
 #endif
-  }
 }
 
 void PCCDecoder::createPatchFrameDataStructure( PCCContext& context, size_t atglIndex ) {
@@ -900,11 +1159,14 @@ void PCCDecoder::createPatchFrameDataStructure( PCCContext& context, size_t atgl
   int32_t quantizerSizeY         = 1 << ath.getPatchSizeYinfoQuantizer();
   tile.setLog2PatchQuantizerSizeX( ath.getPatchSizeXinfoQuantizer() );
   tile.setLog2PatchQuantizerSizeY( ath.getPatchSizeYinfoQuantizer() );
+  // the patches and their buffers come from those of the previous GOF
+  auto& patchPool = context.getAtlas( context.getAtlasIndex() ).getPatchPool();
+  patches.reserve( patches.size() + patchCount - numRawPatches - numEomPatch );
   for ( patchIndex = 0; patchIndex < patchCount; patchIndex++ ) {
     auto&        pid           = atgdu.getPatchInformationData( patchIndex );
     PCCPatchType currPatchType = getPatchType( tileType, atgdu.getPatchMode( patchIndex ) );
     if ( currPatchType == INTRA_PATCH ) {
-      PCCPatch patch;
+      PCCPatch patch = patchPool.acquire();
       auto&    pdu = pid.getPatchDataUnit();
       patch.setOccupancyResolution( size_t( 1 ) << asps.getLog2PatchPackingBlockSize() );
       patch.setU0( pdu.get2dPosX() );
@@ -960,9 +1222,9 @@ void PCCDecoder::createPatchFrameDataStructure( PCCContext& context, size_t atgl
       if ( asps.getPLREnabledFlag() ) {
         setPLRData( tile, patch, pdu.getPLRData(), size_t( 1 ) << asps.getLog2PatchPackingBlockSize() );
       }
-      patches.push_back( patch );
+      patches.push_back( std::move( patch ) );
     } else if ( currPatchType == INTER_PATCH ) {
-      PCCPatch patch;
+      PCCPatch patch = patchPool.acquire();
       patch.setOccupancyResolution( size_t( 1 ) << asps.getLog2PatchPackingBlockSize() );
       auto& ipdu = pid.getInterPatchDataUnit();
       TRACE_PATCH( "patch %zu / %zu: Inter \n", patchIndex, patchCount );
@@ -1027,10 +1289,10 @@ void PCCDecoder::createPatchFrameDataStructure( PCCContext& context, size_t atgl
       if ( asps.getPLREnabledFlag() ) {
         setPLRData( tile, patch, ipdu.getPLRData(), size_t( 1 ) << asps.getLog2PatchPackingBlockSize() );
       }
-      patches.push_back( patch );
+      patches.push_back( std::move( patch ) );
     } else if ( currPatchType == MERGE_PATCH ) {
       assert( -2 );
-      PCCPatch patch;
+      PCCPatch patch = patchPool.acquire();
       patch.setOccupancyResolution( size_t( 1 ) << asps.getLog2PatchPackingBlockSize() );
       auto&        mpdu            = pid.getMergePatchDataUnit();
       bool         overridePlrFlag = false;
@@ -1096,10 +1358,10 @@ void PCCDecoder::createPatchFrameDataStructure( PCCContext& context, size_t atgl
       if ( asps.getPLREnabledFlag() ) {
         setPLRData( tile, patch, mpdu.getPLRData(), size_t( 1 ) << asps.getLog2PatchPackingBlockSize() );
       }
-      patches.push_back( patch );
+      patches.push_back( std::move( patch ) );
     } else if ( currPatchType == SKIP_PATCH ) {
       assert( -1 );
-      PCCPatch patch;
+      PCCPatch patch = patchPool.acquire();
       TRACE_PATCH( "patch %zu / %zu: Inter \n", patchIndex, patchCount );
       TRACE_PATCH( "SDU: refAtlasFrame= 0 refPatchIdx = %d \n", patchIndex );
       patch.setBestMatchIdx( static_cast<int32_t>( patchIndex ) );
@@ -1139,7 +1401,7 @@ void PCCDecoder::createPatchFrameDataStructure( PCCContext& context, size_t atgl
           patch.getNormalAxis(), patch.getTangentAxis(), patch.getBitangentAxis(), patch.getLodScaleX(),
           patch.getLodScaleY() );
       patch.allocOneLayerData();
-      patches.push_back( patch );
+      patches.push_back( std::move( patch ) );
     } else if ( currPatchType == RAW_PATCH ) {
       TRACE_PATCH( "patch %zu / %zu: raw \n", patchIndex, patchCount );
       auto&             rpdu = pid.getRawPatchDataUnit();
@@ -1845,6 +2107,9 @@ PCCCodecId PCCDecoder::getCodedCodecId( PCCContext&        context,
       break;
     case CODEC_GROUP_HEVC_MAIN10:
     case CODEC_GROUP_HEVC444:
+#if defined( USE_FFMPEG_VIDEO_CODEC )
+      if ( !params_.videoDecoderHardware_.empty() ) { return FFMPEG; }
+#endif
 #if defined( USE_HMAPP_VIDEO_CODEC ) && defined( USE_HMLIB_VIDEO_CODEC )
       return videoDecoderPath.empty() ? HMLIB : HMAPP;
 #elif defined( USE_HMLIB_VIDEO_CODEC )
@@ -1888,6 +2153,9 @@ PCCCodecId PCCDecoder::getCodedCodecId( PCCContext&        context,
           exit( -1 );
 #endif
         } else if ( codec4cc.compare( "hev1" ) == 0 ) {
+#if defined( USE_FFMPEG_VIDEO_CODEC )
+          if ( !params_.videoDecoderHardware_.empty() ) { return FFMPEG; }
+#endif
 #if defined( USE_HMAPP_VIDEO_CODEC ) && defined( USE_HMLIB_VIDEO_CODEC )
           return videoDecoderPath.empty() ? HMLIB : HMAPP;
 #elif defined( USE_HMLIB_VIDEO_CODEC )
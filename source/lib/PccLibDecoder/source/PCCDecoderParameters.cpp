@@ -49,6 +49,15 @@ PCCDecoderParameters::PCCDecoderParameters() {
   byteStreamVideoCoderGeometry_      = true;
   byteStreamVideoCoderAttribute_     = true;
   nbThread_                          = 1;
+  threadAffinity_                    = {};
+  parallelFrames_                    = false;
+  videoDecoderThreads_               = 1;
+  videoDecoderHardware_              = {};
+  frameRingName_                     = {};
+  writeQueueDepth_                   = 2;
+  frameRingSlots_                    = 3;
+  frameRingMaxPoints_                = 2000000;
+  verifyChecksums_                   = false;
   keepIntermediateFiles_             = false;
   pixelDeinterleavingType_           = -1;
   pointLocalReconstructionType_      = -1;
@@ -61,6 +70,7 @@ PCCDecoderParameters::PCCDecoderParameters() {
   applyOccupanySynthesisType_        = -1;
 
   patchColorSubsampling_ = false;
+  fixedPointSmoothing_   = false;
   shvcLayerIndex_        = 8;
 }
 
@@ -72,6 +82,15 @@ void PCCDecoderParameters::print() {
   std::cout << "\t startFrameNumber                    " << startFrameNumber_ << std::endl;
   std::cout << "\t colorTransform                      " << colorTransform_ << std::endl;
   std::cout << "\t nbThread                            " << nbThread_ << std::endl;
+  std::cout << "\t threadAffinity                      " << threadAffinity_ << std::endl;
+  std::cout << "\t parallelFrames                      " << parallelFrames_ << std::endl;
+  std::cout << "\t videoDecoderThreads                 " << videoDecoderThreads_ << std::endl;
+  std::cout << "\t videoDecoderHardware                " << videoDecoderHardware_ << std::endl;
+  std::cout << "\t writeQueueDepth                     " << writeQueueDepth_ << std::endl;
+  std::cout << "\t frameRingName                       " << frameRingName_ << std::endl;
+  std::cout << "\t frameRingSlots                      " << frameRingSlots_ << std::endl;
+  std::cout << "\t frameRingMaxPoints                  " << frameRingMaxPoints_ << std::endl;
+  std::cout << "\t verifyChecksums                     " << verifyChecksums_ << std::endl;
   std::cout << "\t keepIntermediateFiles               " << keepIntermediateFiles_ << std::endl;
   std::cout << "\t video encoding" << std::endl;
   std::cout << "\t   colorSpaceConversionPath          " << colorSpaceConversionPath_ << std::endl;
@@ -80,6 +99,7 @@ void PCCDecoderParameters::print() {
   std::cout << "\t   videoDecoderAttributePath         " << videoDecoderAttributePath_ << std::endl;
   std::cout << "\t   inverseColorSpaceConversionConfig " << inverseColorSpaceConversionConfig_ << std::endl;
   std::cout << "\t   patchColorSubsampling             " << patchColorSubsampling_ << std::endl;
+  std::cout << "\t   fixedPointSmoothing               " << fixedPointSmoothing_ << std::endl;
   std::cout << "\t   shvcLayerIndex                    " << shvcLayerIndex_ << std::endl;
 }
 
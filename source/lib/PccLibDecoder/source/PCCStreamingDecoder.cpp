@@ -0,0 +1,186 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+#include "PCCContext.h"
+#include "PCCFrameContext.h"
+#include "PCCGroupOfFrames.h"
+#include "PCCStreamingDecoder.h"
+#include "PCCBitstreamReader.h"
+
+using namespace pcc;
+
+PCCStreamingDecoder::PCCStreamingDecoder() : precision_( 0 ), closed_( false ), finished_( false ), status_( 0 ) {
+  decoder_.setLogger( logger_ );
+  decoder_.setFrameCallback( [this]( PCCPointSet3& frame, size_t ) {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    frames_.push_back( std::move( frame ) );
+    frameReady_.notify_all();
+  } );
+}
+
+PCCStreamingDecoder::~PCCStreamingDecoder() {
+  close();
+  if ( worker_.joinable() ) { worker_.join(); }
+}
+
+void PCCStreamingDecoder::setParameters( const PCCDecoderParameters& params ) {
+  params_ = params;
+  logger_.initilalize( removeFileExtension( params_.compressedStreamPath_ ), false );
+  decoder_.setParameters( params_ );
+}
+
+void PCCStreamingDecoder::push( const uint8_t* data, size_t size ) {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  if ( closed_ || finished_ || size == 0 ) { return; }
+  input_.insert( input_.end(), data, data + size );
+  if ( !worker_.joinable() ) { worker_ = std::thread( &PCCStreamingDecoder::run, this ); }
+  inputReady_.notify_one();
+}
+
+void PCCStreamingDecoder::close() {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  closed_ = true;
+  if ( !worker_.joinable() ) {
+    finished_ = true;
+    frameReady_.notify_all();
+  }
+  inputReady_.notify_one();
+}
+
+bool PCCStreamingDecoder::pop( PCCPointSet3& frame ) {
+  std::unique_lock<std::mutex> lock( mutex_ );
+  frameReady_.wait( lock, [this] { return !frames_.empty() || finished_; } );
+  if ( frames_.empty() || status_ != 0 ) { return false; }
+  frame = std::move( frames_.front() );
+  frames_.pop_front();
+  return true;
+}
+
+bool PCCStreamingDecoder::tryPop( PCCPointSet3& frame ) {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  if ( frames_.empty() || status_ != 0 ) { return false; }
+  frame = std::move( frames_.front() );
+  frames_.pop_front();
+  return true;
+}
+
+int PCCStreamingDecoder::getStatus() {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  return status_;
+}
+
+void PCCStreamingDecoder::run() {
+  int  ret    = 0;
+  bool more   = true;
+  bool closed = false;
+  while ( ret == 0 && more && !closed ) {
+    {
+      std::unique_lock<std::mutex> lock( mutex_ );
+      inputReady_.wait( lock, [this] { return !input_.empty() || closed_; } );
+      buffer_.insert( buffer_.end(), input_.begin(), input_.end() );
+      input_.clear();
+      closed = closed_;
+    }
+    parseUnits();
+    // a GOF is complete once the VPS of the next one has arrived
+    while ( ret == 0 && more && hasCompleteGof() ) { ret = decodeGof( more ); }
+  }
+  if ( ret == 0 && more ) {
+    if ( !buffer_.empty() ) { std::cerr << "Warning: " << buffer_.size() << " trailing bytes dropped" << std::endl; }
+    while ( ret == 0 && more && ssvu_.getV3CUnitCount() > 0 ) { ret = decodeGof( more ); }
+  }
+  std::lock_guard<std::mutex> lock( mutex_ );
+  status_   = ret;
+  finished_ = true;
+  frameReady_.notify_all();
+}
+
+void PCCStreamingDecoder::parseUnits() {
+  size_t pos = 0;
+  if ( precision_ == 0 ) {
+    if ( buffer_.empty() ) { return; }
+    // ssvh_unit_size_precision_bytes_minus1 u(3), reserved u(5)
+    ssvu_.setSsvhUnitSizePrecisionBytesMinus1( buffer_[pos] >> 5 );
+    precision_ = ( buffer_[pos] >> 5 ) + 1;
+    bitstreamStat_.incrHeader( 1 );
+    pos++;
+  }
+  while ( buffer_.size() - pos >= precision_ ) {
+    size_t size = 0;
+    for ( size_t i = 0; i < precision_; i++ ) { size = ( size << 8 ) | buffer_[pos + i]; }
+    if ( buffer_.size() - pos - precision_ < size ) { break; }
+    const uint8_t* unitData = buffer_.data() + pos + precision_;
+    auto&          unit     = ssvu_.addV3CUnit();
+    unit.setSize( size );
+    unit.allocate();
+    // vuh_unit_type is the first 5 bits of the unit
+    unit.setType( size > 0 ? static_cast<V3CUnitType>( unitData[0] >> 3 ) : V3C_RSVD_05 );
+    if ( size > 0 ) { memcpy( unit.getBitstream().buffer(), unitData, size ); }
+    bitstreamStat_.incrHeader( precision_ );
+    pos += precision_ + size;
+  }
+  buffer_.erase( buffer_.begin(), buffer_.begin() + pos );
+}
+
+bool PCCStreamingDecoder::hasCompleteGof() {
+  auto& units = ssvu_.getV3CUnit();
+  for ( size_t i = 1; i < units.size(); i++ ) {
+    if ( units[i].getType() == V3C_VPS ) { return true; }
+  }
+  return false;
+}
+
+int PCCStreamingDecoder::decodeGof( bool& more ) {
+  PCCGroupOfFrames   reconstructs;
+  PCCBitstreamReader bitstreamReader;
+  context_.reset();
+  context_.setBitstreamStat( bitstreamStat_ );
+  if ( bitstreamReader.decode( ssvu_, context_ ) == 0 ) {
+    more = false;
+    return 0;
+  }
+  if ( context_.checkProfile() != 0 ) {
+    std::cerr << "Error: profile not correct" << std::endl;
+    return -1;
+  }
+  params_.setReconstructionParameters( context_.getVps().getProfileTierLevel().getProfileReconstructionIdc() );
+  decoder_.setReconstructionParameters( params_ );
+  context_.resizeAtlas( context_.getVps().getAtlasCountMinus1() + 1 );
+  for ( uint32_t atlId = 0; atlId < context_.getVps().getAtlasCountMinus1() + 1; atlId++ ) {
+    context_.getAtlas( atlId ).allocateVideoFrames( context_, 0 );
+    context_.setAtlasIndex( atlId );
+    int ret = decoder_.decode( context_, reconstructs, atlId );
+    if ( ret != 0 ) { return ret; }
+  }
+  return 0;
+}
@@ -31,6 +31,7 @@
  * THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "PCCCommon.h"
+#include "PCCProfiler.h"
 #include "PCCVideo.h"
 
 #include "PCCVideoDecoder.h"
@@ -42,6 +43,7 @@
 #include "PCCFrameContext.h"
 #include "PCCPatch.h"
 #include "PCCVirtualVideoDecoder.h"
+#include "PCCVideoDecoderPool.h"
 #include "PCCInternalColorConverter.h"
 #ifdef USE_HDRTOOLS
 #include "PCCHDRToolsLibColorConverter.h"
@@ -50,13 +52,54 @@
 #endif
 
 #include "PCCSHMAppVideoDecoder.h"
+#include "PCCHMLibVideoDecoder.h"
+#include "PCCFFMPEGLibVideoDecoder.h"
+#include <mutex>
 
 
 using namespace pcc;
 
+// HM, JM and VTM initialize and free their tables in globals with every decoder instance, so the library
+// decoders must not run concurrently. The app decoders are separate processes and run in parallel.
+static std::mutex g_libraryDecoderMutex;
+
+static bool isLibraryDecoder( PCCCodecId codecId ) {
+#ifdef USE_JMLIB_VIDEO_CODEC
+  if ( codecId == JMLIB ) { return true; }
+#endif
+#ifdef USE_HMLIB_VIDEO_CODEC
+  if ( codecId == HMLIB ) { return true; }
+#endif
+#ifdef USE_VTMLIB_VIDEO_CODEC
+  if ( codecId == VTMLIB ) { return true; }
+#endif
+  return false;
+}
+
 PCCVideoDecoder::PCCVideoDecoder()  = default;
 PCCVideoDecoder::~PCCVideoDecoder() = default;
 
+bool PCCVideoDecoder::canDecode( const std::string& codec4cc ) {
+  if ( codec4cc == "avc1" || codec4cc == "avc3" ) {
+#if defined( USE_JMAPP_VIDEO_CODEC ) || defined( USE_JMLIB_VIDEO_CODEC )
+    return true;
+#endif
+  } else if ( codec4cc == "hvc1" || codec4cc == "hev1" ) {
+#if defined( USE_HMAPP_VIDEO_CODEC ) || defined( USE_HMLIB_VIDEO_CODEC ) || defined( USE_FFMPEG_VIDEO_CODEC )
+    return true;
+#endif
+  } else if ( codec4cc == "svc1" || codec4cc == "lhv1" || codec4cc == "lhe1" ) {
+#if defined( USE_SHMAPP_VIDEO_CODEC )
+    return true;
+#endif
+  } else if ( codec4cc == "vvc1" || codec4cc == "vvi1" ) {
+#if defined( USE_VTMLIB_VIDEO_CODEC )
+    return true;
+#endif
+  }
+  return false;
+}
+
 template <typename T>
 bool PCCVideoDecoder::decompress( PCCVideo<T, 3>&    video,
                                   PCCContext&        contexts,
@@ -80,7 +123,8 @@ bool PCCVideoDecoder::decompress( PCCVideo<T, 3>&    video,
   printf( "byteStreamVideoCoder = %d codecId = %d \n", byteStreamVideoCoder, codecId );
   fflush( stdout );
   if ( byteStreamVideoCoder ) {
-    bitstream.sampleStreamToByteStream(
+    // converted when the decoder reads the data, unless it reads the view through a PCCVideoByteStreamBuf
+    bitstream.setByteStreamView(
 #if defined( USE_JMAPP_VIDEO_CODEC ) || defined( USE_JMLIB_VIDEO_CODEC )
         codecId == JMAPP || codecId == JMLIB,
 #else
@@ -93,7 +137,11 @@ bool PCCVideoDecoder::decompress( PCCVideo<T, 3>&    video,
   }
 
   // Decode video
-  auto decoder = PCCVirtualVideoDecoder<T>::create( codecId );
+  const PCCVideoType component = bitstream.type();
+  const std::string  parameterSets =
+      pool_ != nullptr ? PCCVideoDecoderPool::getParameterSets( bitstream, codecId ) : std::string();
+  auto decoder = pool_ != nullptr ? pool_->acquire<T>( component, codecId, parameterSets )
+                                  : PCCVirtualVideoDecoder<T>::create( codecId );
   printf( " decompress codecId = %d size(T) = %zu \n", (int)codecId, sizeof( T ) );
   fflush( stdout );
 #ifdef USE_SHMAPP_VIDEO_CODEC
@@ -103,8 +151,44 @@ bool PCCVideoDecoder::decompress( PCCVideo<T, 3>&    video,
     shmDecoder->setLayerIndex( shvcLayerIndex );
   }
 #endif
-  auto start = std::chrono::system_clock::now();
-  decoder->decode( bitstream, video, outputBitDepth, decoderPath, fileName );
+#ifdef USE_HMLIB_VIDEO_CODEC
+  if ( codecId == HMLIB ) {
+    std::shared_ptr<PCCHMLibVideoDecoder<T>> hmDecoder =
+        std::dynamic_pointer_cast<PCCHMLibVideoDecoder<T>>( decoder );
+    hmDecoder->setSubstreamThreads( substreamThreads_ );
+  }
+#endif
+#ifdef USE_FFMPEG_VIDEO_CODEC
+  if ( codecId == FFMPEG ) {
+    std::shared_ptr<PCCFFMPEGLibVideoDecoder<T>> ffmpegDecoder =
+        std::dynamic_pointer_cast<PCCFFMPEGLibVideoDecoder<T>>( decoder );
+    ffmpegDecoder->setHardwareDevice( hardwareDevice_ );
+    ffmpegDecoder->setThreads( substreamThreads_ );
+  }
+#endif
+  // The bit depth alignment and the chroma upsampling below are done by the decoder as it writes the pictures when it
+  // can, saving two passes over the video. Not when the pictures are kept or traced as they were decoded.
+  PCCImageConversion conversion;
+  if ( nominalBitdepth_ != 0 && nominalBitdepth_ <= sizeof( T ) * 8 && outputBitDepth <= sizeof( T ) * 8 ) {
+    conversion.bitdepthInput  = uint8_t( outputBitDepth );
+    conversion.bitdepthOutput = uint8_t( nominalBitdepth_ );
+    conversion.msbAlignFlag   = msbAlignFlag_;
+  }
+  conversion.upsampleChroma = inverseColorSpaceConversionConfig.empty();
+#ifdef CONFORMANCE_TRACE
+  const bool fuseConversion = false;
+#else
+  const bool fuseConversion = !keepIntermediateFiles;
+#endif
+  const bool converted =
+      decoder->setOutputConversion( fuseConversion ? conversion : PCCImageConversion() ) && fuseConversion;
+  {
+    std::unique_lock<std::mutex> lock( g_libraryDecoderMutex, std::defer_lock );
+    if ( isLibraryDecoder( codecId ) ) { lock.lock(); }
+    PCC_PROFILE_ZONE( "video decompress" );
+    decoder->decode( bitstream, video, outputBitDepth, decoderPath, fileName );
+  }
+  if ( pool_ != nullptr ) { pool_->release<T>( component, codecId, parameterSets, decoder ); }
 
   size_t width      = video.getWidth();
   size_t height     = video.getHeight();
@@ -124,13 +208,28 @@ bool PCCVideoDecoder::decompress( PCCVideo<T, 3>&    video,
     bitstream.write( binFileName );
     video.write( video.addFormat( fileName + "_rec", outputBitDepth == 8 ? "8" : "10" ), outputBitDepth == 8 ? 1 : 2 );
   }
+  if ( !converted && nominalBitdepth_ != 0 ) {
+    video.convertBitdepth( uint8_t( outputBitDepth ), uint8_t( nominalBitdepth_ ), msbAlignFlag_ );
+  }
 
   // Convert dec video
   std::shared_ptr<PCCVirtualColorConverter<T>> converter;
   std::string                                  configInverseColorSpace;
+  // the internal converter reproduces plain HDRTools upsampling configurations sample for sample, which saves
+  // running HDRConvert and writing/reading the video twice
+  std::string internalConfig;
+  if ( !colorSpaceConversionPath.empty() && !inverseColorSpaceConversionConfig.empty() ) {
+    internalConfig = PCCInternalColorConverter<T>::getConfiguration( inverseColorSpaceConversionConfig );
+  }
+  bool useInternal = colorSpaceConversionPath.empty() || !internalConfig.empty();
   if ( colorSpaceConversionPath.empty() ) {
     converter               = std::make_shared<PCCInternalColorConverter<T>>();
     configInverseColorSpace = stringFormat( "YUV420ToYUV444_%zu_%zu", outputBitDepth, upsamplingFilter );
+  } else if ( useInternal ) {
+    printf( "%s is done by the internal color converter: %s \n", inverseColorSpaceConversionConfig.c_str(),
+            internalConfig.c_str() );
+    converter               = std::make_shared<PCCInternalColorConverter<T>>();
+    configInverseColorSpace = internalConfig;
   } else {
 #ifdef USE_HDRTOOLS
     converter = std::make_shared<PCCHDRToolsLibColorConverter<T>>();
@@ -140,7 +239,9 @@ bool PCCVideoDecoder::decompress( PCCVideo<T, 3>&    video,
     configInverseColorSpace = inverseColorSpaceConversionConfig;
   }
   if ( inverseColorSpaceConversionConfig.empty() || is444 ) {
-    if ( is444 ) {
+    if ( converted && conversion.upsampleChroma ) {
+      // upsampled, and their deprecated color format set, by the decoder
+    } else if ( is444 ) {
       video.setDeprecatedColorFormat( 0 );
     } else {
       video.setDeprecatedColorFormat( 1 );
@@ -162,7 +263,7 @@ bool PCCVideoDecoder::decompress( PCCVideo<T, 3>&    video,
         destImage.resize( width, height, PCCCOLORFORMAT::YUV444 );
         // iterate the patch information and perform chroma down-sampling on each patch individually
         std::vector<PCCPatch>& patches      = context.getTitleFrameContext().getPatches();
-        std::vector<size_t>&   blockToPatch = context.getTitleFrameContext().getBlockToPatch();
+        const auto&            blockToPatch = context.getTitleFrameContext().getBlockToPatch();
         for ( int patchIdx = 0; patchIdx <= patches.size(); patchIdx++ ) {
           size_t occupancyResolution;
           size_t patch_left;
@@ -348,7 +449,10 @@ bool PCCVideoDecoder::decompress( PCCVideo<T, 3>&    video,
           PCCVideo<T, 3> tmpVideo;
           tmpVideo.resize( 1 );
           tmpVideo[0] = tmpImage;
-          converter->convert( configInverseColorSpace, tmpVideo, colorSpaceConversionPath, fileName + "_tmp" );
+          {
+            PCC_PROFILE_ZONE( "color convert" );
+            converter->convert( configInverseColorSpace, tmpVideo, colorSpaceConversionPath, fileName + "_tmp" );
+          }
           tmpImage = tmpVideo[0];
           // substitute the pixels in the output image for compression
           for ( size_t i = 0; i < patch_height; i++ ) {
@@ -370,8 +474,11 @@ bool PCCVideoDecoder::decompress( PCCVideo<T, 3>&    video,
       }
     } else {
 		std::cout << "No SumbSampling \n\n\n No SubSampling \n\n\n No SubSampling \n\n\n";	
-      converter->convert( configInverseColorSpace, video, colorSpaceConversionPath, fileName + "_rec" );
-      video.setDeprecatedColorFormat( colorSpaceConversionPath.empty() ? 1 : 2 );
+      {
+        PCC_PROFILE_ZONE( "color convert" );
+        converter->convert( configInverseColorSpace, video, colorSpaceConversionPath, fileName + "_rec" );
+      }
+      video.setDeprecatedColorFormat( useInternal ? 1 : 2 );
       if ( keepIntermediateFiles ) { video.write( video.addFormat( fileName + "_rec", "16" ), 2 ); }
     }
   }
@@ -0,0 +1,181 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+#include "PCCVideoBitstream.h"
+#include "PCCVirtualVideoDecoder.h"
+#include "PCCVideoDecoderPool.h"
+
+using namespace pcc;
+
+template <typename T>
+std::shared_ptr<PCCVirtualVideoDecoder<T>> PCCVideoDecoderPool::acquire( PCCVideoType       component,
+                                                                         PCCCodecId         codecId,
+                                                                         const std::string& parameterSets ) {
+  std::shared_ptr<void> decoder;
+  bool                  reset = false;
+  {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    auto                        match = entries_.end(), leastRecent = entries_.end();
+    size_t                      count = 0;
+    for ( auto entry = entries_.begin(); entry != entries_.end(); ++entry ) {
+      if ( entry->component_ != component || entry->codecId_ != codecId || entry->sampleSize_ != sizeof( T ) ) {
+        continue;
+      }
+      if ( entry->parameterSets_ == parameterSets ) {
+        match = entry;
+        break;
+      }
+      leastRecent = entry;
+      count++;
+    }
+    if ( match == entries_.end() && count >= capacity_ && count > 0 ) {
+      match = leastRecent;
+      reset = true;
+    }
+    if ( match != entries_.end() ) {
+      decoder = match->decoder_;
+      entries_.erase( match );
+    }
+  }
+  if ( !decoder ) { return PCCVirtualVideoDecoder<T>::create( codecId ); }
+  auto typed = std::static_pointer_cast<PCCVirtualVideoDecoder<T>>( decoder );
+  if ( reset ) { typed->reset(); }
+  return typed;
+}
+
+template <typename T>
+void PCCVideoDecoderPool::release( PCCVideoType                               component,
+                                   PCCCodecId                                 codecId,
+                                   const std::string&                         parameterSets,
+                                   std::shared_ptr<PCCVirtualVideoDecoder<T>> decoder ) {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  entries_.push_front( {component, codecId, sizeof( T ), parameterSets, decoder} );
+  // the decoders of a component that were in use at the same time are all given back: keep the capacity_ last
+  size_t count = 0;
+  for ( auto entry = entries_.begin(); entry != entries_.end(); ) {
+    if ( entry->component_ == component && entry->codecId_ == codecId && entry->sampleSize_ == sizeof( T ) &&
+         ++count > capacity_ ) {
+      entry = entries_.erase( entry );
+    } else {
+      ++entry;
+    }
+  }
+}
+
+void PCCVideoDecoderPool::clear() {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  entries_.clear();
+}
+
+// nal points at the NAL unit header
+static void getNalType( PCCCodecId codecId, const uint8_t* nal, bool& isParameterSet, bool& isSlice ) {
+#if defined( USE_JMAPP_VIDEO_CODEC ) || defined( USE_JMLIB_VIDEO_CODEC )
+  if ( false
+#ifdef USE_JMAPP_VIDEO_CODEC
+       || codecId == JMAPP
+#endif
+#ifdef USE_JMLIB_VIDEO_CODEC
+       || codecId == JMLIB
+#endif
+  ) {
+    const int type = nal[0] & 0x1f;
+    isParameterSet = type == 7 || type == 8;  // SPS, PPS
+    isSlice        = type >= 1 && type <= 5;
+    return;
+  }
+#endif
+#ifdef USE_VTMLIB_VIDEO_CODEC
+  if ( codecId == VTMLIB ) {
+    const int type = nal[1] >> 3;
+    isParameterSet = type >= 14 && type <= 16;  // VPS, SPS, PPS
+    isSlice        = type < 12;
+    return;
+  }
+#endif
+  // HEVC
+  const int type = ( nal[0] >> 1 ) & 0x3f;
+  isParameterSet = type >= 32 && type <= 34;  // VPS, SPS, PPS
+  isSlice        = type < 32;
+}
+
+std::string PCCVideoDecoderPool::getParameterSets( PCCVideoBitstream& bitstream, PCCCodecId codecId ) {
+  // the parameter sets come before the first slice, at the start of the byte stream
+  const size_t                           headSize = 16384;
+  std::vector<PCCVideoByteStreamSegment> segments;
+  std::vector<uint8_t>                   head;
+  bitstream.getByteStreamSegments( segments );
+  for ( auto& segment : segments ) {
+    if ( head.size() >= headSize ) { break; }
+    head.insert( head.end(), segment.data_, segment.data_ + ( std::min )( segment.size_, headSize - head.size() ) );
+  }
+  const bool truncated      = head.size() == headSize;
+  auto       findStartCode = [&]( size_t from ) {
+    for ( size_t i = from; i + 3 <= head.size(); i++ ) {
+      if ( head[i] == 0 && head[i + 1] == 0 && head[i + 2] == 1 ) { return i; }
+    }
+    return std::string::npos;
+  };
+  std::string parameterSets;
+  for ( size_t start = findStartCode( 0 ); start != std::string::npos; ) {
+    const size_t begin = start + 3;
+    const size_t next  = findStartCode( begin );
+    if ( next == std::string::npos && truncated ) { break; }
+    size_t end = next == std::string::npos ? head.size() : next;
+    while ( end > begin && head[end - 1] == 0 ) { end--; }  // zero byte of a 4-byte start code
+    if ( end - begin >= 2 ) {
+      bool isParameterSet = false, isSlice = false;
+      getNalType( codecId, head.data() + begin, isParameterSet, isSlice );
+      if ( isSlice ) { break; }
+      if ( isParameterSet ) {
+        parameterSets.append( reinterpret_cast<const char*>( head.data() + start ), end - start );
+      }
+    }
+    start = next;
+  }
+  return parameterSets;
+}
+
+template std::shared_ptr<PCCVirtualVideoDecoder<uint8_t>> PCCVideoDecoderPool::acquire<uint8_t>( PCCVideoType,
+                                                                                                   PCCCodecId,
+                                                                                                   const std::string& );
+template std::shared_ptr<PCCVirtualVideoDecoder<uint16_t>> PCCVideoDecoderPool::acquire<uint16_t>( PCCVideoType,
+                                                                                                     PCCCodecId,
+                                                                                                     const std::string& );
+template void PCCVideoDecoderPool::release<uint8_t>( PCCVideoType,
+                                                     PCCCodecId,
+                                                     const std::string&,
+                                                     std::shared_ptr<PCCVirtualVideoDecoder<uint8_t>> );
+template void PCCVideoDecoderPool::release<uint16_t>( PCCVideoType,
+                                                      PCCCodecId,
+                                                      const std::string&,
+                                                      std::shared_ptr<PCCVirtualVideoDecoder<uint16_t>> );
@@ -37,6 +37,8 @@
 #include "PCCEncoderParameters.h"
 #include "PCCCodec.h"
 #include "PCCKdTree.h"
+#include "PCCFrameContext.h"
+#include "PCCNormalsGenerator.h"
 #include <map>
 
 namespace pcc {
@@ -51,6 +53,7 @@ class GeometryPatchParameterSet;
 class V3CParameterSet;
 class PLRData;
 struct PatchParams;
+struct PCCMotionEstimationSideInfo;
 
 template <typename T, size_t N>
 class PCCVideo;
@@ -108,6 +111,23 @@ typedef std::map<size_t, PCCPatch> unionPatch;  // unionPatch ------
 typedef std::pair<size_t, size_t> SubContext;   // SubContext ------ [start,
                                                 // end);
 
+// Rate-independent part of the encoding of a group of frames: the normals, the patch segmentation and the raw and
+// EOM patches of every frame, see PCCEncoder::segment().
+struct PCCSegmentation {
+  std::vector<PCCAtlasFrameContext> frames_;
+  // the segmentation may switch the encoder from point local reconstruction to two maps
+  bool   pointLocalReconstruction_   = false;
+  size_t mapCountMinus1_             = 0;
+  bool   singleMapPixelInterleaving_ = false;
+};
+
+// Patch packing of a group of frames: its frames once their patches are placed, and the sub-contexts of the global
+// patch allocation. The rates of a multi-rate encode share it when PCCEncoderParameters::samePacking() holds.
+struct PCCPacking {
+  std::vector<PCCAtlasFrameContext> frames_;
+  std::vector<SubContext>           subContexts_;
+};
+
 #define BAD_HEIGHT_THRESHOLD 1.10
 #define BAD_CONDITION_THRESHOLD 2
 
@@ -119,6 +139,16 @@ class PCCEncoder : public PCCCodec {
 
   int encode( const PCCGroupOfFrames& sources, PCCContext& context, PCCGroupOfFrames& reconstructs );
 
+  // Multi-rate encoding: the segmentation is computed once and reused by the encoders of every rate. Only valid if
+  // their parameters differ in the rate dependent ones (QPs, occupancy precision). The packing is reused too when
+  // packing holds the one of a previous rate, and is stored in it otherwise; the later steps run again for every rate.
+  bool segment( const PCCGroupOfFrames& sources, PCCSegmentation& segmentation );
+  int  encode( const PCCGroupOfFrames& sources,
+               const PCCSegmentation&  segmentation,
+               PCCContext&             context,
+               PCCGroupOfFrames&       reconstructs,
+               PCCPacking*             packing = nullptr );
+
   void setPostProcessingSeiParameters( GeneratePointCloudParameters& params, PCCContext& context );
   void setGeneratePointCloudParameters( GeneratePointCloudParameters& gpcParams, PCCContext& context );
   void createPatchFrameDataStructure( PCCContext& context );
@@ -174,6 +204,13 @@ class PCCEncoder : public PCCCodec {
   void   placeTiles( PCCContext& context, size_t minFrameWidth, size_t minFrameHeight );
   void   replaceFrameContext( PCCContext& context );
 
+  int  encode( const PCCGroupOfFrames& sources,
+               const PCCSegmentation*  segmentation,
+               PCCPacking*             packing,
+               PCCContext&             context,
+               PCCGroupOfFrames&       reconstructs );
+  void initializeFrames( const PCCGroupOfFrames& sources, PCCContext& context );
+
   //**patch segmentation**//
   bool generateSegments( const PCCGroupOfFrames& sources, PCCContext& context );
   bool generateSegments( const PCCPointSet3&                 source,
@@ -238,7 +275,7 @@ class PCCEncoder : public PCCCodec {
                                size_t            y,
                                uint16_t          mean_val,
                                PCCImageGeometry& image,
-                               PCCKdTree&        kdtree,
+                               const PCCKdTree&  kdtree,
                                PCCFrameContext&  frame );
 
   // Push-pull background filling
@@ -435,9 +472,9 @@ class PCCEncoder : public PCCCodec {
                                                      size_t                              frameIndex,
                                                      float&                              distanceSrcRec );
   //**tools**//
-  static inline uint64_t mortonAddr( const int32_t x, const int32_t y, const int32_t z );
-  uint64_t               mortonAddr( const PCCPoint3D& vec, int depth );
-  void                   create3DMotionEstimationFiles( PCCContext& context, const std::string& path );
+  void                   create3DMotionEstimationSideInfo( PCCContext& context, PCCMotionEstimationSideInfo& sideInfo );
+  static void            write3DMotionEstimationFiles( const PCCMotionEstimationSideInfo& sideInfo,
+                                                       const std::string&                 path );
   static void            remove3DMotionEstimationFiles( const std::string& path );
   void                   presmoothPointCloudColor( PCCPointSet3& reconstruct, const PCCEncoderParameters params );
   PCCVector3D            calculateWeightNormal( size_t geometryBitDepth3D, const PCCPointSet3& source );
@@ -447,6 +484,8 @@ class PCCEncoder : public PCCCodec {
   static void printMapTetris( std::vector<bool> img, const size_t sizeU, const size_t sizeV, std::vector<int> horizon );
 
   PCCEncoderParameters params_;
+  // normals of the last frame segmented, from one GOF to the next, with temporalNormals
+  PCCNormalsReference normalsReference_;
 };
 
 };  // namespace pcc
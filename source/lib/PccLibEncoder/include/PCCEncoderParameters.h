@@ -49,6 +49,9 @@ class PCCEncoderParameters {
   static void constructAspsRefListStruct( PCCContext& context, size_t aspsIdx, size_t afpsIdx );
   void        initializeContext( PCCContext& context );
   uint8_t     getCodecIdIndex( PCCCodecId codecId );
+  // True when the patch packing made with other is also the one of these parameters, so that the rates of a
+  // multi-rate encode can share it: the parameters the packing reads are the same.
+  bool samePacking( const PCCEncoderParameters& other ) const;
 
   size_t            startFrameNumber_;
   std::string       configurationFolder_;
@@ -66,13 +69,20 @@ class PCCEncoderParameters {
   bool              byteStreamVideoCoderOccupancy_;
   bool              byteStreamVideoCoderGeometry_;
   bool              byteStreamVideoCoderAttribute_;
+  bool              videoEncoderWavefront_;
+  size_t            videoEncoderTileColumns_;
+  size_t            videoEncoderTileRows_;
+  size_t            videoEncoderChunkFrames_;
+  std::string       videoEncoderHardware_;
   bool              use3dmc_;
   bool              usePccRDO_;
   std::string       colorSpaceConversionConfig_;
   std::string       inverseColorSpaceConversionConfig_;
   size_t            nbThread_;
+  std::string       threadAffinity_;
   size_t            frameCount_;
   size_t            groupOfFramesSize_;
+  size_t            frameWindowSize_;
   std::string       uncompressedDataPath_;
   uint32_t          forcedSsvhUnitSizePrecisionBytes_;
 
@@ -89,6 +99,10 @@ class PCCEncoderParameters {
   int         deltaQPT1_;
   int         auxGeometryQP_;
   int         auxAttributeQP_;
+  // rate control: bytes per frame of every GOF, 0 = off, see PccAppEncoder
+  size_t      targetFrameBytes_;
+  double      targetGeometryShare_;
+  double      targetTolerance_;
   std::string geometryConfig_;
   std::string geometry0Config_;
   std::string geometry1Config_;
@@ -102,6 +116,11 @@ class PCCEncoderParameters {
   size_t voxelDimensionGridBasedSegmentation_;
   size_t nnNormalEstimation_;
   size_t normalOrientation_;
+  bool   temporalNormals_;
+  double maxFitErrorTemporalNormals_;
+  double maxDist2TemporalNormals_;
+  // normals, initial segmentation and grid-based refinement adjacency on the CUDA device, see PCCSegmentationKernels.h
+  bool   deviceSegmentation_;
   bool   gridBasedRefineSegmentation_;
   size_t maxNNCountRefineSegmentation_;
   size_t iterationCountRefineSegmentation_;
@@ -140,6 +159,9 @@ class PCCEncoderParameters {
   bool   gridSmoothing_;
   size_t gridSize_;
   bool   flagGeometrySmoothing_;
+  // Grid smoothing in fixed point, see PCCCodec::gridFilteringFixedPoint(). Not signalled: the decoder must be run
+  // with the same setting.
+  bool   fixedPointSmoothing_;
 
   // Patch Expansion (m47772, CE2.12)
   bool patchExpansion_;
@@ -215,6 +237,7 @@ class PCCEncoderParameters {
   bool   pointLocalReconstruction_;
   size_t patchSize_;
   size_t plrlNumberOfModes_;
+  double plrEarlyTerminationDist_;
   bool   singleMapPixelInterleaving_;
 
   // visual quality
@@ -0,0 +1,94 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCImagePaddingKernels_h
+#define PCCImagePaddingKernels_h
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pcc {
+
+// Vectorized rows of the push-pull padding of PCCEncoder, on the planes of 4:4:4 images. As the kernels of
+// PCCColorConverterKernels.h, the AVX2 versions are picked at run time, every function returns how many leading
+// samples it produced (0 when AVX2 is not available) and leaves the rest to the scalar code, and the results are
+// bit exact. An occupancy is the one of the pixel of the same index; the unoccupied samples are the ones written.
+
+// mip of pushPullMip: dst[x] = the mean of the occupied ones of src0[2x], src0[2x + 1], src1[2x] and src1[2x + 1],
+// truncated to 8 bits as the scalar version does, rounded down; unchanged if none is
+size_t pushPullMipRowKernel( const uint8_t*  src0,
+                             const uint8_t*  src1,
+                             const uint32_t* occupancy0,
+                             const uint32_t* occupancy1,
+                             uint8_t*        dst,
+                             size_t          count );
+size_t pushPullMipRowKernel( const uint16_t* src0,
+                             const uint16_t* src1,
+                             const uint32_t* occupancy0,
+                             const uint32_t* occupancy1,
+                             uint16_t*       dst,
+                             size_t          count );
+
+// fill of pushPullFill, away from the borders: dst[j] = ( 144 * m + 48 * mh + 48 * n + 16 * nh ) >> 8 for the
+// unoccupied j, with m = mip[j / 2], mh = mip[j / 2 - 1] for an even j and mip[j / 2 + 1] for an odd one, and n, nh
+// the same from mipNeighbor, the mip row above or below; mip and mipNeighbor are read from -1 to mipCount - 1
+size_t pushPullFillRowKernel( const uint8_t*  mip,
+                              const uint8_t*  mipNeighbor,
+                              size_t          mipCount,
+                              const uint32_t* occupancy,
+                              uint8_t*        dst,
+                              size_t          count );
+size_t pushPullFillRowKernel( const uint16_t* mip,
+                              const uint16_t* mipNeighbor,
+                              size_t          mipCount,
+                              const uint32_t* occupancy,
+                              uint16_t*       dst,
+                              size_t          count );
+
+// smoothing of pushPullFill: dst[j] = ( the sum of the 8 neighbors of row[j] in above, row and below + 4 ) >> 3 for
+// the unoccupied j; the rows are read from -1 to count
+size_t pushPullSmoothRowKernel( const uint8_t*  above,
+                                const uint8_t*  row,
+                                const uint8_t*  below,
+                                const uint32_t* occupancy,
+                                uint8_t*        dst,
+                                size_t          count );
+size_t pushPullSmoothRowKernel( const uint16_t* above,
+                                const uint16_t* row,
+                                const uint16_t* below,
+                                const uint32_t* occupancy,
+                                uint16_t*       dst,
+                                size_t          count );
+
+};  // namespace pcc
+
+#endif /* PCCImagePaddingKernels_h */
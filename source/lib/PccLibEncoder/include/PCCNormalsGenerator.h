@@ -35,8 +35,11 @@
 #define PCCNormalsGenerator_h
 
 #include "PCCCommon.h"
+#include "PCCPointSet.h"
 
 namespace pcc {
+class PCCExecutionContext;
+
 enum PCCNormalsGeneratorOrientation {
   PCC_NORMALS_GENERATOR_ORIENTATION_NONE               = 0,
   PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE      = 1,
@@ -58,6 +61,24 @@ struct PCCNormalsGenerator3Parameters {
   bool                           storeEigenvalues_;
   bool                           storeNumberOfNearestNeighborsInNormalEstimation_;
   bool                           storeCentroids_;
+  // temporal mode: a normal of the previous frame is kept if its plane leaves at most this fraction of the variance
+  // of the neighborhood more off it than the best plane does, e.g. 0.005 for a tilt of up to about 6 degrees on a
+  // surface patch
+  double                         maxFitErrorTemporal_;
+  // and if it belongs to a point of the previous frame within this squared distance
+  double                         maxDist2Temporal_;
+};
+
+// Points and oriented normals of the previous frame of a sequence. The temporal mode of PCCNormalsGenerator3::compute
+// seeds the normals of a frame from those of the nearest points of this one, recomputes the normals that no longer
+// fit, only orients the recomputed ones from the seeded ones and then keeps the frame as the next reference.
+struct PCCNormalsReference {
+  PCCPointSet3             points_;
+  std::vector<PCCVector3D> normals_;
+  void                     clear() {
+    points_.clear();
+    normals_.clear();
+  }
 };
 
 class PCCNormalsGenerator3 {
@@ -81,8 +102,15 @@ class PCCNormalsGenerator3 {
   void                      compute( const PCCPointSet3&                   pointCloud,
                                      const PCCKdTree&                      kdtree,
                                      const PCCNormalsGenerator3Parameters& params,
-                                     const size_t                          nbThread );
-  std::vector<PCCVector3D>& getNormals() { return normals_; }
+                                     PCCExecutionContext&                  executionContext );
+  // temporal mode, see PCCNormalsReference; the first frame, with an empty reference, is computed as above
+  void                      compute( const PCCPointSet3&                   pointCloud,
+                                     const PCCKdTree&                      kdtree,
+                                     const PCCNormalsGenerator3Parameters& params,
+                                     PCCExecutionContext&                  executionContext,
+                                     PCCNormalsReference&                  reference );
+  std::vector<PCCVector3D>&       getNormals() { return normals_; }
+  const std::vector<PCCVector3D>& getNormals() const { return normals_; }
   PCCVector3D               getNormal( const size_t pos ) const {
     assert( pos < normals_.size() );
     return normals_[pos];
@@ -100,18 +128,32 @@ class PCCNormalsGenerator3 {
     return numberOfNearestNeighborsInNormalEstimation_[index];
   }
   size_t getNormalCount() const { return normals_.size(); }
+  // computes the normals on the CUDA device when there is one, see PCCSegmentationKernels.h; not the seeded ones of
+  // the temporal mode, nor when the eigenvalues, centroids or neighbor counts are stored
+  void setUseDevice( const bool useDevice ) { useDevice_ = useDevice; }
+  // normals kept from the reference by the last temporal compute
+  size_t getSeededNormalCount() const { return seededNormalCount_; }
 
-  void computeNormal( const size_t                          index,
+  // with a seed, an oriented normal of the previous frame, keeps it if it fits the neighborhood of the point and
+  // returns true
+  bool computeNormal( const size_t                          index,
                       const PCCPointSet3&                   pointCloud,
                       const PCCKdTree&                      kdtree,
                       const PCCNormalsGenerator3Parameters& params,
-                      PCCNNResult&                          nNResult );
+                      PCCNNResult&                          nNResult,
+                      const PCCVector3D*                    seed = nullptr );
   void computeNormals( const PCCPointSet3&                   pointCloud,
                        const PCCKdTree&                      kdtree,
-                       const PCCNormalsGenerator3Parameters& params );
+                       const PCCNormalsGenerator3Parameters& params,
+                       const PCCNormalsReference*            reference = nullptr );
   void orientNormals( const PCCPointSet3&                   pointCloud,
                       const PCCKdTree&                      kdtree,
                       const PCCNormalsGenerator3Parameters& params );
+  // orients the normals not visited yet from the visited ones, along spanning trees of spatial blocks built in
+  // parallel and then flipped as a whole to agree with each other
+  void orientUnvisitedNormals( const PCCPointSet3&                   pointCloud,
+                               const PCCKdTree&                      kdtree,
+                               const PCCNormalsGenerator3Parameters& params );
   void addNeighbors( const uint32_t      current,
                      const PCCPointSet3& pointCloud,
                      const PCCKdTree&    kdtree,
@@ -130,7 +172,9 @@ class PCCNormalsGenerator3 {
   std::vector<uint32_t>                numberOfNearestNeighborsInNormalEstimation_;
   std::vector<uint32_t>                visited_;
   std::priority_queue<PCCWeightedEdge> edges_;
-  size_t                               nbThread_;
+  PCCExecutionContext*                 executionContext_  = nullptr;
+  size_t                               seededNormalCount_ = 0;
+  bool                                 useDevice_         = false;
 };
 }  // namespace pcc
 
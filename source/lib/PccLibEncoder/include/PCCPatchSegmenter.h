@@ -39,17 +39,59 @@
 
 namespace pcc {
 
-typedef std::unordered_map<uint64_t, std::vector<size_t>> Voxels;
+// index in the voxelized cloud of the voxel of each point of the source cloud
+typedef std::vector<uint32_t> Voxels;
+
+// Neighbors of every point of a cloud as compressed sparse rows: those of point i are the entries offsets[i] to
+// offsets[i + 1] of indices (and of distances, when they are kept), closest first.
+class PCCAdjacency {
+ public:
+  class Row {
+   public:
+    Row( const uint32_t* begin, const uint32_t* end ) : begin_( begin ), end_( end ) {}
+    const uint32_t* begin() const { return begin_; }
+    const uint32_t* end() const { return end_; }
+    size_t          size() const { return end_ - begin_; }
+    uint32_t        operator[]( const size_t j ) const { return begin_[j]; }
+
+   private:
+    const uint32_t* begin_;
+    const uint32_t* end_;
+  };
+  PCCAdjacency() = default;
+  ~PCCAdjacency() = default;
+  size_t size() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+  Row    operator[]( const size_t i ) const {
+    return Row( indices_.data() + offsets_[i], indices_.data() + offsets_[i + 1] );
+  }
+  double                 getDistance( const size_t i, const size_t j ) const { return distances_[offsets_[i] + j]; }
+  std::vector<size_t>&   getOffsets() { return offsets_; }
+  std::vector<uint32_t>& getIndices() { return indices_; }
+  std::vector<double>&   getDistances() { return distances_; }
+  // keeps the first counts[i] neighbors of each point i
+  void truncate( const std::vector<size_t>& counts );
+
+ private:
+  std::vector<size_t>   offsets_;
+  std::vector<uint32_t> indices_;
+  std::vector<double>   distances_;
+};
 
 class PCCNormalsGenerator3;
+struct PCCNormalsReference;
+class PCCExecutionContext;
 class PCCKdTree;
 class PCCPatch;
+class PCCSpatialIndexCache;
 
 struct PCCPatchSegmenter3Parameters {
   bool             gridBasedSegmentation_;
   size_t           voxelDimensionGridBasedSegmentation_;
   size_t           nnNormalEstimation_;
   size_t           normalOrientation_;
+  double           maxFitErrorTemporalNormals_;
+  double           maxDist2TemporalNormals_;
+  bool             deviceSegmentation_;
   bool             gridBasedRefineSegmentation_;
   size_t           maxNNCountRefineSegmentation_;
   size_t           iterationCountRefineSegmentation_;
@@ -100,11 +142,16 @@ struct PCCPatchSegmenter3Parameters {
 
 class PCCPatchSegmenter3 {
  public:
-  PCCPatchSegmenter3( void ) : nbThread_( 0 ) {}
+  PCCPatchSegmenter3( void ) :
+      executionContext_( nullptr ), normalsReference_( nullptr ), spatialIndex_( nullptr ), useDevice_( false ) {}
   PCCPatchSegmenter3( const PCCPatchSegmenter3& ) = delete;
   PCCPatchSegmenter3& operator=( const PCCPatchSegmenter3& ) = delete;
   ~PCCPatchSegmenter3()                                      = default;
-  void setNbThread( size_t nbThread );
+  void setExecutionContext( PCCExecutionContext& executionContext ) { executionContext_ = &executionContext; }
+  // seeds the normals from those of the previous frame, see PCCNormalsReference
+  void setNormalsReference( PCCNormalsReference& reference ) { normalsReference_ = &reference; }
+  // takes the tree of the source points from the frame's cache, where later stages find it again
+  void setSpatialIndex( PCCSpatialIndexCache& spatialIndex ) { spatialIndex_ = &spatialIndex; }
 
   void compute( const PCCPointSet3&                 geometry,
                 const size_t                        frameIndex,
@@ -119,11 +166,7 @@ class PCCPatchSegmenter3 {
                               PCCPointSet3&       sourceVox,
                               Voxels&             voxels );
 
-  void applyVoxelsDataToPoints( size_t                pointCount,
-                                size_t                geoBits,
-                                size_t                voxDim,
-                                Voxels&               voxels,  // const
-                                const PCCPointSet3&   source,
+  void applyVoxelsDataToPoints( const Voxels&         voxels,
                                 PCCNormalsGenerator3& normalsGen,
                                 std::vector<size_t>&  partitions );
 
@@ -138,22 +181,22 @@ class PCCPatchSegmenter3 {
                             const PCCVector3D*          orientations,
                             const size_t                orientationCount,
                             std::vector<size_t>&        partition );
-  void computeAdjacencyInfo( const PCCPointSet3&               pointCloud,
-                             const PCCKdTree&                  kdtree,
-                             std::vector<std::vector<size_t>>& adj,
-                             const size_t                      maxNNCount );
-
-  void computeAdjacencyInfoDist( const PCCPointSet3&               pointCloud,
-                                 const PCCKdTree&                  kdtree,
-                                 std::vector<std::vector<size_t>>& adj,
-                                 std::vector<std::vector<double>>& adjDist,
-                                 const size_t                      maxNNCount );
-
-  void computeAdjacencyInfoInRadius( const PCCPointSet3&                 pointCloud,
-                                     const PCCKdTree&                    kdtree,
-                                     std::vector<std::vector<uint32_t>>& adj,
-                                     const size_t                        maxNNCount,
-                                     const size_t                        radius );
+  void computeAdjacencyInfo( const PCCPointSet3& pointCloud,
+                             const PCCKdTree&    kdtree,
+                             PCCAdjacency&       adj,
+                             const size_t        maxNNCount );
+
+  // same, with the squared distances to the neighbors
+  void computeAdjacencyInfoDist( const PCCPointSet3& pointCloud,
+                                 const PCCKdTree&    kdtree,
+                                 PCCAdjacency&       adj,
+                                 const size_t        maxNNCount );
+
+  void computeAdjacencyInfoInRadius( const PCCPointSet3& pointCloud,
+                                     const PCCKdTree&    kdtree,
+                                     PCCAdjacency&       adj,
+                                     const size_t        maxNNCount,
+                                     const size_t        radius );
 
   bool colorSimilarity( PCCColor3B& colorD1candidate, PCCColor3B& colorD0, uint8_t threshold ) {
     bool bSimilarity = ( std::abs( colorD0[0] - colorD1candidate[0] ) < threshold ) &&
@@ -231,7 +274,11 @@ class PCCPatchSegmenter3 {
                                     std::vector<size_t>&        partition );
 
  private:
-  size_t                nbThread_;
+  PCCExecutionContext*  executionContext_;
+  PCCNormalsReference*  normalsReference_;
+  PCCSpatialIndexCache* spatialIndex_;
+  // deviceSegmentation_ of the frame being segmented
+  bool                  useDevice_;
   std::vector<PCCPatch> boxMinDepths_;  // box depth list
   std::vector<PCCPatch> boxMaxDepths_;  // box depth list
 
@@ -285,7 +332,7 @@ class PCCPatchSegmenter3 {
                                           const double                      minGradient,
                                           const size_t                      minNumHighGradientPoints,
                                           std::vector<size_t>&              partition,
-                                          std::vector<std::vector<size_t>>& adj,
+                                          const PCCAdjacency&               adj,
                                           std::vector<std::vector<size_t>>& connectedComponents );
   static void determinePatchOrientation( const size_t         additionalProjectionAxis,
                                          const bool           absoluteD1,
@@ -310,7 +357,7 @@ class PCCPatchSegmenter3 {
                                  const double                      minGradient,
                                  const size_t                      minNumHighGradientPoints,
                                  PCCPatch&                         patch,
-                                 std::vector<std::vector<size_t>>& adj,
+                                 const PCCAdjacency&               adj,
                                  std::vector<std::vector<size_t>>& highGradientConnectedComponents,
                                  std::vector<bool>&                isRemoved );
 
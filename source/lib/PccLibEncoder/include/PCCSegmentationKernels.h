@@ -0,0 +1,82 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCSegmentationKernels_h
+#define PCCSegmentationKernels_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pcc {
+
+// CUDA versions of the front end of the encoder: the normals of PCCNormalsGenerator3, the scores of
+// PCCPatchSegmenter3::initialSegmentation() and the neighboring grid cells of refineSegmentationGridBased(). They are
+// built with USE_CUDA, from PCCSegmentationKernels.cu; without it, or without a CUDA device, every function returns
+// false and leaves its outputs to the CPU code, as do the functions that fail on the device. The neighbors are
+// searched on a uniform grid of the points sorted by cell instead of a k-d tree. Positions are xyz triplets.
+
+// the most neighbors computeNormalsKernel() fits a plane to
+const size_t g_segmentationMaxNeighborCount = 64;
+
+bool segmentationDeviceAvailable();
+
+// normals[3 * i], [3 * i + 1] and [3 * i + 2]: the normal of the plane fit to the neighborCount nearest points of
+// point i, itself included, oriented towards viewPoint, as PCCNormalsGenerator3::computeNormal() without a seed: the
+// covariance in double, diagonalized by the Jacobi rotations of PCCDiagonalize(). Where the last neighbor kept ties
+// with others, the one kept may not be the one the k-d tree keeps.
+bool computeNormalsKernel( const int16_t* positions,
+                           size_t         pointCount,
+                           size_t         neighborCount,
+                           const double   viewPoint[3],
+                           double*        normals );
+
+// partition[i]: the orientation of the best weighted score of normal i, as initialSegmentation()
+bool initialSegmentationKernel( const double* normals,
+                                size_t        pointCount,
+                                const double* orientations,
+                                const double* weights,
+                                size_t        orientationCount,
+                                size_t*       partition );
+
+// the rows of a PCCAdjacency: the points at a squared distance below radius2 of each point, itself included, closest
+// first, at most maxNeighborCount of them. Equidistant points are in index order, the k-d tree leaves them in any.
+bool radiusAdjacencyKernel( const int16_t*         positions,
+                            size_t                 pointCount,
+                            double                 radius2,
+                            size_t                 maxNeighborCount,
+                            std::vector<size_t>&   offsets,
+                            std::vector<uint32_t>& indices );
+
+};  // namespace pcc
+
+#endif /* PCCSegmentationKernels_h */
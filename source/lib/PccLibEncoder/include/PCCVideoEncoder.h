@@ -42,6 +42,7 @@ class PCCVideo;
 class PCCContext;
 class PCCVideoBitstream;
 class PCCLogger;
+struct PCCMotionEstimationSideInfo;
 
 class PCCVideoEncoder {
  public:
@@ -84,8 +85,35 @@ class PCCVideoEncoder {
 
   void setLogger( PCCLogger& logger ) { logger_ = &logger; }
 
+  // whether the encoder of codecId reads the side information of use3dmv and usePccRDO from files
+  static bool readsMotionEstimationFiles( PCCCodecId codecId );
+
+  // substreams the HM encoders code the video in, so that a decoder can decode them in parallel: one per CTU
+  // row (WPP) or one per tile
+  void setParallelSubstreams( bool wavefront, size_t tileColumns, size_t tileRows ) {
+    wavefront_   = wavefront;
+    tileColumns_ = tileColumns;
+    tileRows_    = tileRows;
+  }
+
+  // side information the library encoders take in memory when use3dmv or usePccRDO is set; the application encoders
+  // read it from the files the PCC encoder writes
+  void setMotionEstimationSideInfo( const PCCMotionEstimationSideInfo& sideInfo ) { sideInfo_ = &sideInfo; }
+
+  // encoder the FFMPEG codec encodes with, see PCCVideoEncoderParameters::hardwareDevice_
+  void setHardwareDevice( const std::string& hardwareDevice ) { hardwareDevice_ = hardwareDevice; }
+
+  // frames of the chunks the HM encoders code in parallel, see PCCVideoEncoderParameters::chunkFrames_
+  void setChunkFrames( size_t chunkFrames ) { chunkFrames_ = chunkFrames; }
+
  private:
-  PCCLogger* logger_ = nullptr;
+  PCCLogger*                         logger_      = nullptr;
+  bool                               wavefront_   = false;
+  size_t                             tileColumns_ = 1;
+  size_t                             tileRows_    = 1;
+  const PCCMotionEstimationSideInfo* sideInfo_    = nullptr;
+  std::string                        hardwareDevice_;
+  size_t                             chunkFrames_ = 0;
 };
 
 };  // namespace pcc
@@ -38,14 +38,20 @@
 #include "PCCPatch.h"
 #include "PCCPatchSegmenter.h"
 #include "PCCVideoEncoder.h"
+#include "PCCVirtualVideoEncoder.h"
 #include "PCCGroupOfFrames.h"
 #include "PCCPointSet.h"
 #include "PCCEncoderParameters.h"
 #include "PCCKdTree.h"
+#include "PCCMorton.h"
 #include <tbb/tbb.h>
+#include <atomic>
+#include <functional>
 #include "PCCChrono.h"
+#include "PCCProfiler.h"
 #include "PCCEncoder.h"
 #include "PCCEncoderConstant.h"
+#include "PCCImagePaddingKernels.h"
 
 using namespace std;
 using namespace pcc;
@@ -56,6 +62,81 @@ std::string getEncoderConfig1L( const std::string& string ) {
   return result;
 }
 
+namespace {
+
+// Uniform grid over the rectangles ( U1, V1, sizeU, sizeV ) of the patches of a frame, for the IoU matching of the
+// patches of another frame against them: a rectangle that does not overlap has an IoU of 0 and never makes a match,
+// so only the patches sharing a cell are compared instead of all of them. Cells are about the mean patch size.
+class PCCPatchRectGrid {
+ public:
+  PCCPatchRectGrid( const std::vector<PCCPatch>& patches ) {
+    size_t count = 0, extent = 0;
+    for ( const auto& patch : patches ) {
+      if ( patch.getSizeU() == 0 || patch.getSizeV() == 0 ) { continue; }
+      minU_ = count == 0 ? patch.getU1() : ( std::min )( minU_, patch.getU1() );
+      minV_ = count == 0 ? patch.getV1() : ( std::min )( minV_, patch.getV1() );
+      maxU_ = count == 0 ? patch.getU1() + patch.getSizeU() : ( std::max )( maxU_, patch.getU1() + patch.getSizeU() );
+      maxV_ = count == 0 ? patch.getV1() + patch.getSizeV() : ( std::max )( maxV_, patch.getV1() + patch.getSizeV() );
+      extent += ( std::max )( patch.getSizeU(), patch.getSizeV() );
+      count++;
+    }
+    if ( count == 0 ) { return; }
+    cellSize_ = ( std::max )( extent / count, size_t( 1 ) );
+    // at most 256 x 256 cells, however spread the patches are
+    cellSize_ = ( std::max )( cellSize_, ( ( std::max )( maxU_ - minU_, maxV_ - minV_ ) + 255 ) / 256 );
+    columns_  = ( maxU_ - minU_ + cellSize_ - 1 ) / cellSize_ + 1;
+    rows_     = ( maxV_ - minV_ + cellSize_ - 1 ) / cellSize_ + 1;
+    cells_.resize( columns_ * rows_ );
+    for ( size_t index = 0; index < patches.size(); index++ ) {
+      const auto& patch = patches[index];
+      if ( patch.getSizeU() == 0 || patch.getSizeV() == 0 ) { continue; }
+      size_t u0, v0, u1, v1;
+      if ( cellRange( patch.getU1(), patch.getV1(), patch.getSizeU(), patch.getSizeV(), u0, v0, u1, v1 ) ) {
+        for ( size_t v = v0; v <= v1; v++ ) {
+          for ( size_t u = u0; u <= u1; u++ ) { cells_[v * columns_ + u].push_back( index ); }
+        }
+      }
+    }
+  }
+
+  // the indices of the patches whose rectangle may overlap the one of patch, in increasing order as the matching
+  // loops keep the first of equal IoUs
+  void query( const PCCPatch& patch, std::vector<size_t>& indices ) const {
+    indices.clear();
+    size_t u0, v0, u1, v1;
+    if ( cells_.empty() || patch.getSizeU() == 0 || patch.getSizeV() == 0 ||
+         !cellRange( patch.getU1(), patch.getV1(), patch.getSizeU(), patch.getSizeV(), u0, v0, u1, v1 ) ) {
+      return;
+    }
+    for ( size_t v = v0; v <= v1; v++ ) {
+      for ( size_t u = u0; u <= u1; u++ ) {
+        const auto& cell = cells_[v * columns_ + u];
+        indices.insert( indices.end(), cell.begin(), cell.end() );
+      }
+    }
+    std::sort( indices.begin(), indices.end() );
+    indices.erase( std::unique( indices.begin(), indices.end() ), indices.end() );
+  }
+
+ private:
+  // the cells [u0, u1] x [v0, v1] the rectangle covers, clipped to the grid; false if it lies outside
+  bool cellRange( size_t u, size_t v, size_t sizeU, size_t sizeV, size_t& u0, size_t& v0, size_t& u1, size_t& v1 )
+      const {
+    if ( u >= maxU_ || v >= maxV_ || u + sizeU <= minU_ || v + sizeV <= minV_ ) { return false; }
+    u0 = ( ( std::max )( u, minU_ ) - minU_ ) / cellSize_;
+    v0 = ( ( std::max )( v, minV_ ) - minV_ ) / cellSize_;
+    u1 = ( ( std::min )( u + sizeU, maxU_ ) - 1 - minU_ ) / cellSize_;
+    v1 = ( ( std::min )( v + sizeV, maxV_ ) - 1 - minV_ ) / cellSize_;
+    return true;
+  }
+
+  size_t                           minU_ = 0, minV_ = 0, maxU_ = 0, maxV_ = 0;
+  size_t                           cellSize_ = 1, columns_ = 0, rows_ = 0;
+  std::vector<std::vector<size_t>> cells_;
+};
+
+}  // namespace
+
 PCCEncoder::PCCEncoder() {
 #ifdef ENABLE_PAPI_PROFILING
   initPapiProfiler();
@@ -67,18 +148,47 @@ PCCEncoder::~PCCEncoder() = default;
 void PCCEncoder::setParameters( const PCCEncoderParameters& params ) { params_ = params; }
 
 int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PCCGroupOfFrames& reconstructs ) {
-  size_t pointLocalReconstructionOriginal   = static_cast<size_t>( params_.pointLocalReconstruction_ );
-  size_t layerCountMinus1Original           = params_.mapCountMinus1_;
-  size_t singleMapPixelInterleavingOriginal = static_cast<size_t>( params_.singleMapPixelInterleaving_ );
-  if ( params_.nbThread_ > 0 ) { tbb::task_scheduler_init init( static_cast<int>( params_.nbThread_ ) ); }
+  return encode( sources, nullptr, nullptr, context, reconstructs );
+}
 
-  if ( sources.getFrameCount() == 0 ) { return 0; }
-  assert( sources.getFrameCount() < 256 );
-  if ( ( params_.rawPointsPatch_ || params_.lossyRawPointsPatch_ ) && params_.tileSegmentationType_ > 0 &&
-       params_.numMaxTilePerFrame_ > 1 ) {
-    params_.numMaxTilePerFrame_ += 1;
-  }
-  reconstructs.setFrameCount( sources.getFrameCount() );
+bool PCCEncoder::segment( const PCCGroupOfFrames& sources, PCCSegmentation& segmentation ) {
+  const bool   pointLocalReconstructionOriginal   = params_.pointLocalReconstruction_;
+  const size_t layerCountMinus1Original           = params_.mapCountMinus1_;
+  const bool   singleMapPixelInterleavingOriginal = params_.singleMapPixelInterleaving_;
+  executionContext_->initialize( params_.nbThread_, params_.threadAffinity_ );
+
+  PCCContext context;
+  initializeFrames( sources, context );
+  bool res = sources.getFrameCount() == 0 || generateSegments( sources, context );
+  segmentation.frames_                     = std::move( context.getFrames() );
+  segmentation.pointLocalReconstruction_   = params_.pointLocalReconstruction_;
+  segmentation.mapCountMinus1_             = params_.mapCountMinus1_;
+  segmentation.singleMapPixelInterleaving_ = params_.singleMapPixelInterleaving_;
+  params_.pointLocalReconstruction_        = pointLocalReconstructionOriginal;
+  params_.mapCountMinus1_                  = layerCountMinus1Original;
+  params_.singleMapPixelInterleaving_      = singleMapPixelInterleavingOriginal;
+  return res;
+}
+
+int PCCEncoder::encode( const PCCGroupOfFrames& sources,
+                        const PCCSegmentation&  segmentation,
+                        PCCContext&             context,
+                        PCCGroupOfFrames&       reconstructs,
+                        PCCPacking*             packing ) {
+  if ( segmentation.frames_.size() != sources.getFrameCount() ) {
+    std::cerr << "Segmentation of " << segmentation.frames_.size() << " frames for " << sources.getFrameCount()
+              << " source frames" << std::endl;
+    return -1;
+  }
+  if ( packing != nullptr && !packing->frames_.empty() && packing->frames_.size() != sources.getFrameCount() ) {
+    std::cerr << "Packing of " << packing->frames_.size() << " frames for " << sources.getFrameCount()
+              << " source frames" << std::endl;
+    return -1;
+  }
+  return encode( sources, &segmentation, packing, context, reconstructs );
+}
+
+void PCCEncoder::initializeFrames( const PCCGroupOfFrames& sources, PCCContext& context ) {
   context.resizeAtlas( 1 );
   context.setAtlasIndex( 0 );
   context.resize( sources.getFrameCount() );
@@ -95,15 +205,54 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
     frameContext.setLog2PatchQuantizerSizeX( params_.log2QuantizerSizeX_ );
     frameContext.setLog2PatchQuantizerSizeY( params_.log2QuantizerSizeY_ );
   }
+}
+
+int PCCEncoder::encode( const PCCGroupOfFrames& sources,
+                        const PCCSegmentation*  segmentation,
+                        PCCPacking*             packing,
+                        PCCContext&             context,
+                        PCCGroupOfFrames&       reconstructs ) {
+  PCC_PROFILE_ZONE( "encode" );
+  size_t pointLocalReconstructionOriginal   = static_cast<size_t>( params_.pointLocalReconstruction_ );
+  size_t layerCountMinus1Original           = params_.mapCountMinus1_;
+  size_t singleMapPixelInterleavingOriginal = static_cast<size_t>( params_.singleMapPixelInterleaving_ );
+  executionContext_->initialize( params_.nbThread_, params_.threadAffinity_ );
+
+  if ( sources.getFrameCount() == 0 ) { return 0; }
+  assert( sources.getFrameCount() < 256 );
+  if ( ( params_.rawPointsPatch_ || params_.lossyRawPointsPatch_ ) && params_.tileSegmentationType_ > 0 &&
+       params_.numMaxTilePerFrame_ > 1 ) {
+    params_.numMaxTilePerFrame_ += 1;
+  }
+  reconstructs.setFrameCount( sources.getFrameCount() );
+  initializeFrames( sources, context );
+  auto& frames = context.getFrames();
 
   // Segmentation
-  generateSegments( sources, context );
+  if ( segmentation == nullptr ) {
+    generateSegments( sources, context );
+  } else {
+    for ( size_t i = 0; i < frames.size(); i++ ) { frames[i] = segmentation->frames_[i]; }
+    params_.pointLocalReconstruction_   = segmentation->pointLocalReconstruction_;
+    params_.mapCountMinus1_             = segmentation->mapCountMinus1_;
+    params_.singleMapPixelInterleaving_ = segmentation->singleMapPixelInterleaving_;
+  }
+  sampleMemory( "segmentation", context, reconstructs, &sources );
 
   // Init context and tiles
   params_.initializeContext( context );
 
   // Segment Placement
-  placeSegments( sources, context );
+  if ( packing != nullptr && !packing->frames_.empty() ) {
+    for ( size_t i = 0; i < frames.size(); i++ ) { frames[i] = packing->frames_[i]; }
+    context.getSubContexts() = packing->subContexts_;
+  } else {
+    placeSegments( sources, context );
+    if ( packing != nullptr ) {
+      packing->frames_      = frames;
+      packing->subContexts_ = context.getSubContexts();
+    }
+  }
 
   // updatePartitionInformation
   if ( params_.tileSegmentationType_ > 1 && params_.numMaxTilePerFrame_ > 1 ) {
@@ -111,13 +260,13 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
   }
   if ( params_.tileSegmentationType_ > 0 ) { replaceFrameContext( context ); }
 
-  PCCVideoEncoder videoEncoder;
-  videoEncoder.setLogger( *logger_ );
   size_t            atlasIndex = context.getAtlasIndex();
-  const size_t      pointCount = sources[0].getPointCount();
+  const size_t      pointCount = sources.acquire( 0 ).getPointCount();
+  sources.release( 0 );
   auto&             sps        = context.getVps();
   std::stringstream path;
   path << removeFileExtension( params_.compressedStreamPath_ ) << "_GOF" << sps.getV3CParameterSetId() << "_";
+  PCCMotionEstimationSideInfo motionEstimationSideInfo;
   sps.setFrameWidth( atlasIndex, static_cast<uint16_t>( frames[0].getAtlasFrameWidth() ) );
   sps.setFrameHeight( atlasIndex, static_cast<uint16_t>( frames[0].getAtlasFrameHeight() ) );
   for ( auto& asps : context.getAtlasSequenceParameterSetList() ) {
@@ -127,108 +276,51 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
 
   // GENERATE OCCUPANCY MAP
   generateOccupancyMap( context, true );
+  sampleMemory( "occupancy map", context, reconstructs, &sources );
 
-  // ENCODE OCCUPANCY MAP
-  TRACE_PICTURE( "Occupancy\n" );
-  TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0\n" );
-  auto& videoBitstream = context.createVideoBitstream( VIDEO_OCCUPANCY );
-  generateOccupancyMapVideo( sources, context );
-  auto& videoOccupancyMap = context.getVideoOccupancyMap();
-  videoEncoder.compress( videoOccupancyMap,                         // video
-                         path.str(),                                // path
-                         params_.occupancyMapQP_,                   // QP
-                         videoBitstream,                            // bitstream
-                         params_.occupancyMapConfig_,               // config file
-                         params_.videoEncoderOccupancyPath_,        // encoder path
-                         params_.videoEncoderOccupancyCodecId_,     // Codec id
-                         params_.byteStreamVideoCoderOccupancy_,    // byteStreamVideoCoder
-                         context,                                   // context
-                         ( params_.EOMFixBitCount_ <= 8 ) ? 1 : 2,  // nByte
-                         false,                                     // use444CodecIo
-                         false,                                     // use3dmv
-                         false,                                     // usePccRDO
-                         0,                                         // SHVC Layer Index
-                         0,                                         // SHVC ratio X
-                         0,                                         // SHVC ratio Y
-                         8,                                         // internalBitDepth
-                         false,                                     // useConversion
-                         params_.keepIntermediateFiles_ );          // keepIntermediateFiles
-  if ( params_.offsetLossyOM_ > 0 ) { modifyOccupancyMap( sources, context ); }
-  if ( !params_.useRawPointsSeparateVideo_ && ( params_.rawPointsPatch_ || params_.lossyRawPointsPatch_ ) ) {
-    markRawPatchLocationOccupancyMapVideo( context );
-  }
-  if ( params_.tileSegmentationType_ > 0 ) {
-    generateAtlasBlockToPatchFromOccupancyMapVideo( context, params_.occupancyResolution_,
-                                                    params_.occupancyPrecision_ );
-  } else {
-    generateBlockToPatchFromOccupancyMapVideo( context, params_.occupancyResolution_, params_.occupancyPrecision_ );
-  }
-
-  // Generate GEOMETRY IMAGE & dilation
-  generateGeometryVideo( sources, context );
-
-  // ENCODE GEOMETRY IMAGE
-  TRACE_PICTURE( "Geometry\n" );
-  TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0\n" );
-  if ( params_.use3dmc_ || params_.usePccRDO_ ) { create3DMotionEstimationFiles( context, path.str() ); }
+  // The video streams are encoded as concurrent tasks, each with its own video encoder. The occupancy video is
+  // encoded first since the geometry video is generated from its reconstruction; the raw points geometry video
+  // only depends on the packing and is encoded alongside both. D1 runs next to D0 when coded absolute and after it
+  // when predicted from the reconstructed D0. The bitstreams are created up front, in the order of the sequential
+  // encoder, so that the tasks keep valid references to them.
   auto&  gi                      = context.getVps().getGeometryInformation( atlasIndex );
+  auto&  asps                    = context.getAtlasSequenceParameterSet( atlasIndex );
   size_t geometryVideoBitDepth   = gi.getGeometry2dBitdepthMinus1() + 1;
   size_t geometryMPVideoBitDepth = gi.getGeometry2dBitdepthMinus1() + 1;
   size_t nbyteGeo                = ( geometryVideoBitDepth <= 8 ) ? 1 : 2;
   size_t nbyteGeoMP              = ( geometryMPVideoBitDepth <= 8 ) ? 1 : 2;
   size_t internalBitDepth        = 10;
   if ( params_.rawPointsPatch_ ) { internalBitDepth = geometryVideoBitDepth; }
-  auto&       videoBitstreamD0 = params_.multipleStreams_ ? context.createVideoBitstream( VIDEO_GEOMETRY_D0 )
-                                                          : context.createVideoBitstream( VIDEO_GEOMETRY );
-  auto&       videoGeometry    = context.getVideoGeometryMultiple()[0];
-  std::string geometryConfigFile =
-      params_.multipleStreams_
-          ? params_.geometry0Config_
-          : ( params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.geometryConfig_ ) : params_.geometryConfig_ );
-  videoEncoder.compress( videoGeometry,                             // video
-                         path.str(),                                // path
-                         params_.geometryQP_ + params_.deltaQPD0_,  // QP
-                         videoBitstreamD0,                          // bitstream
-                         geometryConfigFile,                        // config file
-                         params_.videoEncoderGeometryPath_,         // encoder path
-                         params_.videoEncoderGeometryCodecId_,      // Codec id
-                         params_.byteStreamVideoCoderGeometry_,     // byteStreamVideoCoder
-                         context,                                   // context
-                         nbyteGeo,                                  // nbyte
-                         false,                                     // use444CodecIo
-                         params_.use3dmc_,                          // use3dmv
-                         params_.usePccRDO_,                        // usePccRDO
-                         params_.shvcLayerIndex_,                   // SHVC layer index
-                         params_.shvcRateX_,                        // SHVC rate X
-                         params_.shvcRateY_,                        // SHVC rate Y
-                         internalBitDepth,                          // internalBitDepth
-                         false,                                     // useConversion
-                         params_.keepIntermediateFiles_ );          // keep intermediate
-  size_t sizeGeometryVideo = videoBitstreamD0.size();
-  std::cout << "sizeGeometryVideo: " << sizeGeometryVideo << std::endl;
-  if ( params_.multipleStreams_ ) {
-    if ( params_.lossyRawPointsPatch_ ) {
-      std::cout << "Error: lossyRawPointsPatch has not been implemented for "
-                   "absoluteD1_ = 0 as "
-                   "yet. Exiting... "
-                << std::endl;
-      std::exit( -1 );
-    }
-    if ( !params_.absoluteD1_ ) {
-      // Form differential video geometry1
-      for ( size_t f = 0; f < frames.size(); ++f ) {
-        auto& frame1 = context.getVideoGeometryMultiple()[1].getFrame( f );
-        predictGeometryFrame( frames[f].getTitleFrameContext(), videoGeometry.getFrame( f ), frame1 );
-        dilate3DPadding( sources[f], frames[f], frames[f].getTitleFrameContext(), frame1,
-                         videoOccupancyMap.getFrame( f ) );
-      }
-    }
-
+  const bool auxiliaryVideo = asps.getRawPatchEnabledFlag() && asps.getAuxiliaryVideoEnabledFlag();
+  context.createVideoBitstream( VIDEO_OCCUPANCY );
+  context.createVideoBitstream( params_.multipleStreams_ ? VIDEO_GEOMETRY_D0 : VIDEO_GEOMETRY );
+  if ( params_.multipleStreams_ ) { context.createVideoBitstream( VIDEO_GEOMETRY_D1 ); }
+  if ( auxiliaryVideo ) { context.createVideoBitstream( VIDEO_GEOMETRY_RAW ); }
+  auto&  videoBitstream    = context.getVideoBitstream( VIDEO_OCCUPANCY );
+  auto&  videoBitstreamD0  = context.getVideoBitstream( params_.multipleStreams_ ? VIDEO_GEOMETRY_D0 : VIDEO_GEOMETRY );
+  auto&  videoOccupancyMap = context.getVideoOccupancyMap();
+  auto&  videoGeometry     = context.getVideoGeometryMultiple()[0];
+  size_t sizeGeometryVideo = 0;
+  if ( params_.multipleStreams_ && params_.lossyRawPointsPatch_ ) {
+    std::cout << "Error: lossyRawPointsPatch has not been implemented for "
+                 "absoluteD1_ = 0 as "
+                 "yet. Exiting... "
+              << std::endl;
+    std::exit( -1 );
+  }
+  auto encodeGeometryD1 = [&] {
     // Compress geometry1
     TRACE_PICTURE( "Geometry\n" );
     TRACE_PICTURE( "MapIdx = 1, AuxiliaryVideoFlag = 0\n" );
-    auto& videoGeometryD1  = context.getVideoGeometryMultiple()[1];
-    auto& videoBitstreamD1 = context.createVideoBitstream( VIDEO_GEOMETRY_D1 );
+    auto&           videoGeometryD1  = context.getVideoGeometryMultiple()[1];
+    auto&           videoBitstreamD1 = context.getVideoBitstream( VIDEO_GEOMETRY_D1 );
+    PCCVideoEncoder videoEncoder;
+    videoEncoder.setLogger( *logger_ );
+    videoEncoder.setHardwareDevice( params_.videoEncoderHardware_ );
+    videoEncoder.setChunkFrames( params_.videoEncoderChunkFrames_ );
+    videoEncoder.setParallelSubstreams( params_.videoEncoderWavefront_, params_.videoEncoderTileColumns_,
+                                        params_.videoEncoderTileRows_ );
+    videoEncoder.setMotionEstimationSideInfo( motionEstimationSideInfo );
     videoEncoder.compress( videoGeometryD1,                           // video
                            path.str(),                                // path
                            params_.geometryQP_ + params_.deltaQPD1_,  // QP
@@ -248,41 +340,147 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
                            internalBitDepth,                          // internalBitDepth
                            false,                                     // useConversion
                            params_.keepIntermediateFiles_ );          // keep intermediate
-    size_t sizeGeometryVideoD1 = videoBitstreamD1.size();
+  };
+
+  tbb::task_group geometryTasks;
+  executionContext_->execute( [&] {
+    if ( auxiliaryVideo ) {
+      geometryTasks.run( [&] {
+        TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 1\n" );
+        std::cout << "*******Video: Aux (Geometry) ********" << std::endl;
+        placeAuxiliaryPointsTiles( context );
+        auto& videoRawPointsGeometryBitstream = context.getVideoBitstream( VIDEO_GEOMETRY_RAW );
+        generateRawPointsGeometryVideo( context );
+        auto&           videoRawPointsGeometry = context.getVideoRawPointsGeometry();
+        PCCVideoEncoder videoEncoder;
+        videoEncoder.setLogger( *logger_ );
+        videoEncoder.setHardwareDevice( params_.videoEncoderHardware_ );
+        videoEncoder.setChunkFrames( params_.videoEncoderChunkFrames_ );
+        videoEncoder.compress( videoRawPointsGeometry,                 // video,
+                               path.str(),                             // path,
+                               params_.auxGeometryQP_,                 // qp,
+                               videoRawPointsGeometryBitstream,        // bitstream,
+                               params_.geometryAuxVideoConfig_,        // encoderConfig,
+                               params_.videoEncoderGeometryPath_,      // encoderPath,
+                               params_.videoEncoderGeometryCodecId_,   // codecId,
+                               params_.byteStreamVideoCoderGeometry_,  // byteStreamVideoCoder,
+                               context,                                // context
+                               nbyteGeoMP,                             // nbyte
+                               false,                                  // use444CodecIo
+                               false,                                  // use3dmv
+                               false,                                  // usePccRDO
+                               params_.shvcLayerIndex_,                // SHVC layer index
+                               params_.shvcRateX_,                     // SHVC rate X
+                               params_.shvcRateY_,                     // SHVC rate Y
+                               internalBitDepth,                       // internalBitDepth
+                               false,                                  // useConversion
+                               params_.keepIntermediateFiles_ );       // keepIntermediateFiles
+      } );
+    }
+
+    // ENCODE OCCUPANCY MAP
+    TRACE_PICTURE( "Occupancy\n" );
+    TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0\n" );
+    generateOccupancyMapVideo( sources, context );
+    PCCVideoEncoder videoEncoder;
+    videoEncoder.setLogger( *logger_ );
+    videoEncoder.setHardwareDevice( params_.videoEncoderHardware_ );
+    videoEncoder.setChunkFrames( params_.videoEncoderChunkFrames_ );
+    videoEncoder.compress( videoOccupancyMap,                         // video
+                           path.str(),                                // path
+                           params_.occupancyMapQP_,                   // QP
+                           videoBitstream,                            // bitstream
+                           params_.occupancyMapConfig_,               // config file
+                           params_.videoEncoderOccupancyPath_,        // encoder path
+                           params_.videoEncoderOccupancyCodecId_,     // Codec id
+                           params_.byteStreamVideoCoderOccupancy_,    // byteStreamVideoCoder
+                           context,                                   // context
+                           ( params_.EOMFixBitCount_ <= 8 ) ? 1 : 2,  // nByte
+                           false,                                     // use444CodecIo
+                           false,                                     // use3dmv
+                           false,                                     // usePccRDO
+                           0,                                         // SHVC Layer Index
+                           0,                                         // SHVC ratio X
+                           0,                                         // SHVC ratio Y
+                           8,                                         // internalBitDepth
+                           false,                                     // useConversion
+                           params_.keepIntermediateFiles_ );          // keepIntermediateFiles
+    if ( params_.offsetLossyOM_ > 0 ) { modifyOccupancyMap( sources, context ); }
+    if ( !params_.useRawPointsSeparateVideo_ && ( params_.rawPointsPatch_ || params_.lossyRawPointsPatch_ ) ) {
+      markRawPatchLocationOccupancyMapVideo( context );
+    }
+    if ( params_.tileSegmentationType_ > 0 ) {
+      generateAtlasBlockToPatchFromOccupancyMapVideo( context, params_.occupancyResolution_,
+                                                      params_.occupancyPrecision_ );
+    } else {
+      generateBlockToPatchFromOccupancyMapVideo( context, params_.occupancyResolution_,
+                                                 params_.occupancyPrecision_ );
+    }
+
+    // Generate GEOMETRY IMAGE & dilation
+    generateGeometryVideo( sources, context );
+
+    // ENCODE GEOMETRY IMAGE
+    TRACE_PICTURE( "Geometry\n" );
+    TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0\n" );
+    if ( params_.use3dmc_ || params_.usePccRDO_ ) {
+      create3DMotionEstimationSideInfo( context, motionEstimationSideInfo );
+      if ( PCCVideoEncoder::readsMotionEstimationFiles( params_.videoEncoderGeometryCodecId_ ) ||
+           PCCVideoEncoder::readsMotionEstimationFiles( params_.videoEncoderAttributeCodecId_ ) ) {
+        write3DMotionEstimationFiles( motionEstimationSideInfo, path.str() );
+      }
+    }
+    if ( params_.multipleStreams_ && params_.absoluteD1_ ) { geometryTasks.run( encodeGeometryD1 ); }
+    std::string geometryConfigFile =
+        params_.multipleStreams_ ? params_.geometry0Config_
+                                 : ( params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.geometryConfig_ )
+                                                                  : params_.geometryConfig_ );
+    videoEncoder.setParallelSubstreams( params_.videoEncoderWavefront_, params_.videoEncoderTileColumns_,
+                                        params_.videoEncoderTileRows_ );
+    videoEncoder.setMotionEstimationSideInfo( motionEstimationSideInfo );
+    videoEncoder.compress( videoGeometry,                             // video
+                           path.str(),                                // path
+                           params_.geometryQP_ + params_.deltaQPD0_,  // QP
+                           videoBitstreamD0,                          // bitstream
+                           geometryConfigFile,                        // config file
+                           params_.videoEncoderGeometryPath_,         // encoder path
+                           params_.videoEncoderGeometryCodecId_,      // Codec id
+                           params_.byteStreamVideoCoderGeometry_,     // byteStreamVideoCoder
+                           context,                                   // context
+                           nbyteGeo,                                  // nbyte
+                           false,                                     // use444CodecIo
+                           params_.use3dmc_,                          // use3dmv
+                           params_.usePccRDO_,                        // usePccRDO
+                           params_.shvcLayerIndex_,                   // SHVC layer index
+                           params_.shvcRateX_,                        // SHVC rate X
+                           params_.shvcRateY_,                        // SHVC rate Y
+                           internalBitDepth,                          // internalBitDepth
+                           false,                                     // useConversion
+                           params_.keepIntermediateFiles_ );          // keep intermediate
+    sizeGeometryVideo = videoBitstreamD0.size();
+    std::cout << "sizeGeometryVideo: " << sizeGeometryVideo << std::endl;
+    if ( params_.multipleStreams_ && !params_.absoluteD1_ ) {
+      // Form differential video geometry1
+      for ( size_t f = 0; f < frames.size(); ++f ) {
+        auto& frame1 = context.getVideoGeometryMultiple()[1].getFrame( f );
+        predictGeometryFrame( frames[f].getTitleFrameContext(), videoGeometry.getFrame( f ), frame1 );
+        dilate3DPadding( sources.acquire( f ), frames[f], frames[f].getTitleFrameContext(), frame1,
+                         videoOccupancyMap.getFrame( f ) );
+        sources.release( f );
+      }
+      encodeGeometryD1();
+    }
+    geometryTasks.wait();
+  } );
+  sampleMemory( "geometry video", context, reconstructs, &sources );
+  if ( params_.multipleStreams_ ) {
+    size_t sizeGeometryVideoD1 = context.getVideoBitstream( VIDEO_GEOMETRY_D1 ).size();
     std::cout << "sizeGeometryVideoD1: " << sizeGeometryVideoD1 << std::endl;
     std::cout << "geometryVideo ->" << ( sizeGeometryVideo + sizeGeometryVideoD1 ) << "=" << sizeGeometryVideo << "+"
               << sizeGeometryVideoD1 << " B ("
               << ( ( sizeGeometryVideo + sizeGeometryVideoD1 ) * 8.0 ) / ( 2 * frames.size() * pointCount ) << " bpp)"
               << std::endl;
   }
-  auto& asps = context.getAtlasSequenceParameterSet( atlasIndex );
-  if ( asps.getRawPatchEnabledFlag() && asps.getAuxiliaryVideoEnabledFlag() ) {
-    TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 1\n" );
-    std::cout << "*******Video: Aux (Geometry) ********" << std::endl;
-    placeAuxiliaryPointsTiles( context );
-    auto& videoRawPointsGeometryBitstream = context.createVideoBitstream( VIDEO_GEOMETRY_RAW );
-    generateRawPointsGeometryVideo( context );
-    auto& videoRawPointsGeometry = context.getVideoRawPointsGeometry();
-    videoEncoder.compress( videoRawPointsGeometry,                 // video,
-                           path.str(),                             // path,
-                           params_.auxGeometryQP_,                 // qp,
-                           videoRawPointsGeometryBitstream,        // bitstream,
-                           params_.geometryAuxVideoConfig_,        // encoderConfig,
-                           params_.videoEncoderGeometryPath_,      // encoderPath,
-                           params_.videoEncoderGeometryCodecId_,   // codecId,
-                           params_.byteStreamVideoCoderGeometry_,  // byteStreamVideoCoder,
-                           context,                                // context
-                           nbyteGeoMP,                             // nbyte
-                           false,                                  // use444CodecIo
-                           false,                                  // use3dmv
-                           false,                                  // usePccRDO
-                           params_.shvcLayerIndex_,                // SHVC layer index
-                           params_.shvcRateX_,                     // SHVC rate X
-                           params_.shvcRateY_,                     // SHVC rate Y
-                           internalBitDepth,                       // internalBitDepth
-                           false,                                  // useConversion
-                           params_.keepIntermediateFiles_ );       // keepIntermediateFiles
-  }
   // Tile summary
   printf( "****TileInfo***Summary******************\n" );
   fflush( stdout );
@@ -337,8 +535,7 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
     generateAttributeVideo( sources, reconstructs, context, params_ );
     if ( params_.attributeBGFill_ < 3 ) {
       // ATTRIBUTE IMAGE PADDING
-      tbb::task_arena limited( static_cast<int>( params_.nbThread_ ) );
-      limited.execute( [&] {
+      executionContext_->execute( [&] {
         tbb::parallel_for( size_t( 0 ), frames.size(), [&]( const size_t f ) {
           using namespace std::chrono;
           pcc::chrono::Stopwatch<std::chrono::steady_clock> clockPadding;
@@ -411,71 +608,31 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
       } );
     }
     // ENCODE ATTRIBUTE IMAGE
-    TRACE_PICTURE( "Attribute\n" );
-    std::cout << "attribute video " << std::endl;
-    auto&        videoBitstream = params_.multipleStreams_ ? context.createVideoBitstream( VIDEO_ATTRIBUTE_T0 )
-                                                           : context.createVideoBitstream( VIDEO_ATTRIBUTE );
-    const size_t nbyteAtt       = 1;
-    int attrPartitionIndex      = sps.getAttributeInformation( atlasIndex ).getAttributeDimensionPartitionsMinus1( 0 );
-    int attrTypeId              = sps.getAttributeInformation( atlasIndex ).getAttributeTypeId( 0 );
-    TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0, AttrIdx = 0, AttrPartIdx = %d, AttrTypeID = %d\n",
-                   attrPartitionIndex, attrTypeId );
-    auto encoderConfig0 = params_.multipleStreams_
-                              ? ( params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.attributeConfig_ )
-                                                               : params_.attribute0Config_ )
-                              : ( params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.attributeConfig_ )
-                                                               : params_.attributeConfig_ );
-    videoEncoder.compress( context.getVideoAttributesMultiple()[0],     // video,
-                           path.str(),                                  // path
-                           params_.attributeQP_ + params_.deltaQPT0_,   // qp
-                           videoBitstream,                              // bitstream
-                           encoderConfig0,                              // encoderConfig
-                           params_.videoEncoderAttributePath_,          // encoderPath
-                           params_.videoEncoderAttributeCodecId_,       // codecId
-                           params_.byteStreamVideoCoderAttribute_,      // byteStreamVideoCoder
-                           context,                                     // context
-                           nbyteAtt,                                    // nbyte
-                           params_.attributeVideo444_,                  // use444CodecIo
-                           params_.use3dmc_,                            // use3dmv
-                           params_.usePccRDO_,                          // usePccRDO
-                           params_.shvcLayerIndex_,                     // SHVC layer index
-                           params_.shvcRateX_,                          // SHVC rate X
-                           params_.shvcRateY_,                          // SHVC rate Y
-                           params_.rawPointsPatch_ ? 8 : 10,            // internalBitDepth
-                           !params_.rawPointsPatch_,                    // useConversion
-                           params_.keepIntermediateFiles_,              // keepIntermediateFiles
-                           params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
-                           params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
-                           params_.colorSpaceConversionPath_ );         // colorSpaceConversionPath
-
-    auto sizeAttributeVideo = videoBitstream.size();
-    std::cout << "attribute video ->" << sizeAttributeVideo << " B ("
-              << ( sizeAttributeVideo * 8.0 ) / ( 2 * frames.size() * pointCount ) << " bpp)" << std::endl;
-
-    if ( params_.multipleStreams_ ) {
-      // Form differential video attribute1
-      if ( !params_.absoluteT1_ ) {
-        for ( size_t f = 0; f < frames.size(); ++f ) {
-          auto& frame0 = context.getVideoAttributesMultiple()[0].getFrame( f );
-          auto& frame1 = context.getVideoAttributesMultiple()[1].getFrame( f );
-          predictAttributeFrame( frames[f].getTitleFrameContext(), frame0, frame1 );
-          switch ( params_.attributeBGFill_ ) {
-            case 0: dilate( frames[f].getTitleFrameContext(), frame1 ); break;
-            case 1: dilateSmoothedPushPull( frames[f].getTitleFrameContext(), frame1 ); break;
-            case 2: dilateHarmonicBackgroundFill( frames[f].getTitleFrameContext(), frame1 ); break;
-            default: std::cout << "Warning: no attribute padding applied!" << std::endl;
-          }
-        }
-        std::cout << "attribute prediction done " << std::endl;
-      }
-
+    // T1 runs next to T0 when coded absolute and after it when predicted from the reconstructed T0; the raw points
+    // attribute video is encoded alongside both.
+    context.createVideoBitstream( params_.multipleStreams_ ? VIDEO_ATTRIBUTE_T0 : VIDEO_ATTRIBUTE );
+    if ( params_.multipleStreams_ ) { context.createVideoBitstream( VIDEO_ATTRIBUTE_T1 ); }
+    if ( auxiliaryVideo ) { context.createVideoBitstream( VIDEO_ATTRIBUTE_RAW ); }
+    auto& videoBitstream =
+        context.getVideoBitstream( params_.multipleStreams_ ? VIDEO_ATTRIBUTE_T0 : VIDEO_ATTRIBUTE );
+    const size_t nbyteAtt           = 1;
+    int          attrPartitionIndex = ai.getAttributeDimensionPartitionsMinus1( 0 );
+    int          attrTypeId         = ai.getAttributeTypeId( 0 );
+    auto encodeAttributeT1 = [&] {
       // compress attribute1
       TRACE_PICTURE( "Attribute\n" );
       TRACE_PICTURE( "AttrIdx = 0, AttrPartIdx = %d, AttrTypeID = %d, MapIdx = 1, AuxiliaryVideoFlag = 0\n",
                      attrPartitionIndex, attrTypeId );
-      auto& videoBitstreamT1 = context.createVideoBitstream( VIDEO_ATTRIBUTE_T1 );
+      auto& videoBitstreamT1 = context.getVideoBitstream( VIDEO_ATTRIBUTE_T1 );
       auto  encoderConfig1 =
           params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.attributeConfig_ ) : params_.attribute1Config_;
+      PCCVideoEncoder videoEncoder;
+      videoEncoder.setLogger( *logger_ );
+      videoEncoder.setHardwareDevice( params_.videoEncoderHardware_ );
+      videoEncoder.setChunkFrames( params_.videoEncoderChunkFrames_ );
+      videoEncoder.setParallelSubstreams( params_.videoEncoderWavefront_, params_.videoEncoderTileColumns_,
+                                          params_.videoEncoderTileRows_ );
+      videoEncoder.setMotionEstimationSideInfo( motionEstimationSideInfo );
       videoEncoder.compress( context.getVideoAttributesMultiple()[1],     // video,
                              path.str(),                                  // path
                              params_.attributeQP_ + params_.deltaQPT1_,   // qp
@@ -498,48 +655,124 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
                              params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
                              params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
                              params_.colorSpaceConversionPath_ );         // keepIntermediateFiles
-      size_t sizeAttributeVideoT1 = videoBitstreamT1.size();
-      std::cout << "attribute video ->" << ( sizeAttributeVideo + sizeAttributeVideoT1 ) << "=" << sizeAttributeVideo
-                << "+" << sizeAttributeVideoT1 << " B ("
-                << ( ( sizeAttributeVideo + sizeAttributeVideoT1 ) * 8.0 ) / ( 2 * frames.size() * pointCount )
-                << " bpp)" << std::endl;
-    }
+    };
+
+    tbb::task_group attributeTasks;
+    executionContext_->execute( [&] {
+      if ( auxiliaryVideo ) {
+        attributeTasks.run( [&] {
+          TRACE_PICTURE( "Attribute\n" );
+          TRACE_PICTURE( "AttrIdx = 0, AttrPartIdx = %d, AttrTypeID = %d, MapIdx = 0, AuxiliaryVideoFlag = 1\n",
+                         attrPartitionIndex, attrTypeId );
+          std::cout << "*******Video: Aux (Attribute) ********" << std::endl;
+          auto& videoBitstreamMP = context.getVideoBitstream( VIDEO_ATTRIBUTE_RAW );
+          generateRawPointsAttributeVideo( context );
+          auto&           videoRawPointsAttribute = context.getVideoRawPointsAttribute();
+          const size_t    nByteAttMP              = 1;
+          PCCVideoEncoder videoEncoder;
+          videoEncoder.setLogger( *logger_ );
+          videoEncoder.setHardwareDevice( params_.videoEncoderHardware_ );
+          videoEncoder.setChunkFrames( params_.videoEncoderChunkFrames_ );
+          videoEncoder.compress( videoRawPointsAttribute,                     // video,
+                                 path.str(),                                  // path
+                                 params_.auxAttributeQP_,                     // qp
+                                 videoBitstreamMP,                            // bitstream
+                                 params_.attributeAuxVideoConfig_,            // encoderConfig
+                                 params_.videoEncoderAttributePath_,          // encoderPath
+                                 params_.videoEncoderAttributeCodecId_,       // codecId
+                                 params_.byteStreamVideoCoderAttribute_,      // byteStreamVideoCoder
+                                 context,                                     // context
+                                 nByteAttMP,                                  // nbyte
+                                 params_.attributeVideo444_,                  // use444CodecIo
+                                 false,                                       // use3dmv
+                                 false,                                       // usePccRDO
+                                 params_.shvcLayerIndex_,                     // SHVC layer index
+                                 params_.shvcRateX_,                          // SHVC rate X
+                                 params_.shvcRateY_,                          // SHVC rate Y
+                                 10,                                          // internalBitDepth
+                                 !params_.rawPointsPatch_,                    // useConversion
+                                 params_.keepIntermediateFiles_,              // keepIntermediateFiles
+                                 params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
+                                 params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
+                                 params_.colorSpaceConversionPath_ );         // colorSpaceConversionPath
+        } );
+      }
+      if ( params_.multipleStreams_ && params_.absoluteT1_ ) { attributeTasks.run( encodeAttributeT1 ); }
 
-    if ( asps.getRawPatchEnabledFlag() && asps.getAuxiliaryVideoEnabledFlag() ) {
       TRACE_PICTURE( "Attribute\n" );
-      TRACE_PICTURE( "AttrIdx = 0, AttrPartIdx = %d, AttrTypeID = %d, MapIdx = 0, AuxiliaryVideoFlag = 1\n",
+      std::cout << "attribute video " << std::endl;
+      TRACE_PICTURE( "MapIdx = 0, AuxiliaryVideoFlag = 0, AttrIdx = 0, AttrPartIdx = %d, AttrTypeID = %d\n",
                      attrPartitionIndex, attrTypeId );
-      std::cout << "*******Video: Aux (Attribute) ********" << std::endl;
-      auto& videoBitstreamMP = context.createVideoBitstream( VIDEO_ATTRIBUTE_RAW );
-      generateRawPointsAttributeVideo( context );
-      auto&        videoRawPointsAttribute = context.getVideoRawPointsAttribute();
-      const size_t nByteAttMP              = 1;
-      videoEncoder.compress( videoRawPointsAttribute,                     // video,
+      auto encoderConfig0 = params_.multipleStreams_
+                                ? ( params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.attributeConfig_ )
+                                                                 : params_.attribute0Config_ )
+                                : ( params_.mapCountMinus1_ == 0 ? getEncoderConfig1L( params_.attributeConfig_ )
+                                                                 : params_.attributeConfig_ );
+      PCCVideoEncoder videoEncoder;
+      videoEncoder.setLogger( *logger_ );
+      videoEncoder.setHardwareDevice( params_.videoEncoderHardware_ );
+      videoEncoder.setChunkFrames( params_.videoEncoderChunkFrames_ );
+      videoEncoder.setParallelSubstreams( params_.videoEncoderWavefront_, params_.videoEncoderTileColumns_,
+                                          params_.videoEncoderTileRows_ );
+      videoEncoder.setMotionEstimationSideInfo( motionEstimationSideInfo );
+      videoEncoder.compress( context.getVideoAttributesMultiple()[0],     // video,
                              path.str(),                                  // path
-                             params_.auxAttributeQP_,                     // qp
-                             videoBitstreamMP,                            // bitstream
-                             params_.attributeAuxVideoConfig_,            // encoderConfig
+                             params_.attributeQP_ + params_.deltaQPT0_,   // qp
+                             videoBitstream,                              // bitstream
+                             encoderConfig0,                              // encoderConfig
                              params_.videoEncoderAttributePath_,          // encoderPath
                              params_.videoEncoderAttributeCodecId_,       // codecId
                              params_.byteStreamVideoCoderAttribute_,      // byteStreamVideoCoder
                              context,                                     // context
-                             nByteAttMP,                                  // nbyte
+                             nbyteAtt,                                    // nbyte
                              params_.attributeVideo444_,                  // use444CodecIo
-                             false,                                       // use3dmv
-                             false,                                       // usePccRDO
+                             params_.use3dmc_,                            // use3dmv
+                             params_.usePccRDO_,                          // usePccRDO
                              params_.shvcLayerIndex_,                     // SHVC layer index
                              params_.shvcRateX_,                          // SHVC rate X
                              params_.shvcRateY_,                          // SHVC rate Y
-                             10,                                          // internalBitDepth
+                             params_.rawPointsPatch_ ? 8 : 10,            // internalBitDepth
                              !params_.rawPointsPatch_,                    // useConversion
                              params_.keepIntermediateFiles_,              // keepIntermediateFiles
                              params_.colorSpaceConversionConfig_,         // colorSpaceConversionConfig
                              params_.inverseColorSpaceConversionConfig_,  // inverseColorSpaceConversionConfig
                              params_.colorSpaceConversionPath_ );         // colorSpaceConversionPath
+
+      if ( params_.multipleStreams_ && !params_.absoluteT1_ ) {
+        // Form differential video attribute1
+        for ( size_t f = 0; f < frames.size(); ++f ) {
+          auto& frame0 = context.getVideoAttributesMultiple()[0].getFrame( f );
+          auto& frame1 = context.getVideoAttributesMultiple()[1].getFrame( f );
+          predictAttributeFrame( frames[f].getTitleFrameContext(), frame0, frame1 );
+          switch ( params_.attributeBGFill_ ) {
+            case 0: dilate( frames[f].getTitleFrameContext(), frame1 ); break;
+            case 1: dilateSmoothedPushPull( frames[f].getTitleFrameContext(), frame1 ); break;
+            case 2: dilateHarmonicBackgroundFill( frames[f].getTitleFrameContext(), frame1 ); break;
+            default: std::cout << "Warning: no attribute padding applied!" << std::endl;
+          }
+        }
+        std::cout << "attribute prediction done " << std::endl;
+        encodeAttributeT1();
+      }
+      attributeTasks.wait();
+    } );
+
+    auto sizeAttributeVideo = videoBitstream.size();
+    std::cout << "attribute video ->" << sizeAttributeVideo << " B ("
+              << ( sizeAttributeVideo * 8.0 ) / ( 2 * frames.size() * pointCount ) << " bpp)" << std::endl;
+    if ( params_.multipleStreams_ ) {
+      size_t sizeAttributeVideoT1 = context.getVideoBitstream( VIDEO_ATTRIBUTE_T1 ).size();
+      std::cout << "attribute video ->" << ( sizeAttributeVideo + sizeAttributeVideoT1 ) << "=" << sizeAttributeVideo
+                << "+" << sizeAttributeVideoT1 << " B ("
+                << ( ( sizeAttributeVideo + sizeAttributeVideoT1 ) * 8.0 ) / ( 2 * frames.size() * pointCount )
+                << " bpp)" << std::endl;
+    }
+    if ( auxiliaryVideo ) {
       printf( "generateRawPointsAttributefromVideo \n" );
       for ( size_t fi = 0; fi < context.size(); fi++ ) { generateRawPointsAttributefromVideo( context, fi ); }
     }
   }  // attribute
+  sampleMemory( "attribute video", context, reconstructs, &sources );
 
   if ( params_.flagGeometrySmoothing_ ) {
     if ( params_.pbfEnableFlag_ ) {
@@ -562,6 +795,7 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
   if ( ai.getAttributeCount() > 0 ) {
     // RECOLOR RECONSTRUCTED POINT CLOUD
     std::cout << "Color Point Clouds" << std::endl;
+    PCC_PROFILE_ZONE( "color point cloud" );
     std::vector<std::vector<bool>> absoluteT1List;
     absoluteT1List.resize( ai.getAttributeCount() );
     for ( int attrIdx = 0; attrIdx < ai.getAttributeCount(); ++attrIdx ) {
@@ -584,6 +818,7 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
       }  // tile
     }
   }  // if ( ai.getAttributeCount() > 0 )
+  sampleMemory( "reconstruct", context, reconstructs, &sources );
 
 #ifdef CONFORMANCE_TRACE
   for ( size_t frameIdx = 0; frameIdx < context.size(); frameIdx++ ) {
@@ -617,6 +852,7 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
   std::cout << "Post Processing Point Clouds" << std::endl;
   bool isAttributes444 = static_cast<int>( params_.rawPointsPatch_ ) == 1;
   for ( size_t frameIdx = 0; frameIdx < sources.getFrameCount(); frameIdx++ ) {
+    PCC_PROFILE_ZONE( "post processing" );
     GeneratePointCloudParameters ppSEIParams;
     setPostProcessingSeiParameters( ppSEIParams, context );
     auto& reconstruct = reconstructs[frameIdx];
@@ -633,8 +869,16 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
         params_.pbfEnableFlag_ );
 
     if ( params_.applyGeoSmoothingType_ != 0 && ppSEIParams.flagGeometrySmoothing_ ) {
-      PCCPointSet3 tempFrameBuffer = reconstruct;
+      // The smoothing is done in place: the colour transfer only needs the positions and the colours of the frame as it
+      // was before it, so only these are kept aside, and only when there is a transfer.
+      const auto   filterType      = params_.attrTransferFilterType_;
+      const bool   transferColors  = ai.getAttributeCount() > 0 && !ppSEIParams.pbfEnableFlag_ &&
+                                    ( filterType == 1 || filterType == 2 || filterType == 3 || filterType == 5 ||
+                                      filterType == 7 || filterType == 9 );
+      PCCPointSet3 tempFrameBuffer;
+      if ( transferColors ) { reconstruct.copyPositionsAndColors( tempFrameBuffer ); }
       if ( ppSEIParams.gridSmoothing_ ) {
+        PCC_PROFILE_ZONE( "geometry smoothing" );
         smoothPointCloudPostprocess( reconstruct, params_.colorTransform_, ppSEIParams, partition );
       }
       if ( ai.getAttributeCount() > 0 ) {
@@ -689,6 +933,7 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
     if ( ai.getAttributeCount() > 0 ) {
       if ( params_.applyAttrSmoothingType_ != 0 && ppSEIParams.flagColorSmoothing_ ) {
         TRACE_PATCH( " colorSmoothing \n" );
+        PCC_PROFILE_ZONE( "color smoothing" );
         colorSmoothing( reconstruct, params_.colorTransform_, ppSEIParams );
       }
       if ( !isAttributes444 ) {  // lossy: convert 16-bit yuv444 to 8-bit RGB444
@@ -705,6 +950,7 @@ int PCCEncoder::encode( const PCCGroupOfFrames& sources, PCCContext& context, PC
     for ( auto& c : checksum ) { TRACE_RECFRAME( "%02x", c ); }
     TRACE_RECFRAME( "\n" );
   }  // frame
+  sampleMemory( "post processing", context, reconstructs, &sources );
   if ( !params_.keepIntermediateFiles_ && ( params_.use3dmc_ || params_.usePccRDO_ ) ) {
     remove3DMotionEstimationFiles( path.str() );
   }
@@ -759,10 +1005,10 @@ void PCCEncoder::preFilterOccupancyMap( PCCImageOccupancyMap& image, size_t kwid
   const size_t kCenterW = kwidth / 2;
   const size_t kCenterH = kheight / 2;
   const auto   imageTemp( image );
-  int          val;
-  for ( size_t v = 0; v < height; v++ ) {
+  // each row only reads the copy of the image: the rows are filtered in parallel
+  tbb::parallel_for( size_t( 0 ), height, [&]( const size_t v ) {
     for ( size_t u = 0; u < width; u++ ) {
-      val = 0;
+      int val = 0;
       for ( size_t n = 0; n < kheight; n++ ) {
         size_t nn = kheight - 1 - n;
         for ( size_t m = 0; m < kwidth; m++ ) {
@@ -775,19 +1021,24 @@ void PCCEncoder::preFilterOccupancyMap( PCCImageOccupancyMap& image, size_t kwid
       }
       image.setValue( 0, u, v, static_cast<uint8_t>( val >> 8 ) );
     }
-  }
+  } );
 }
 
 bool PCCEncoder::generateOccupancyMapVideo( const PCCGroupOfFrames& sources, PCCContext& context ) {
-  auto& videoOccupancyMap = context.getVideoOccupancyMap();
-  bool  ret               = true;
+  PCC_PROFILE_ZONE( "occupancy video" );
+  auto&             videoOccupancyMap = context.getVideoOccupancyMap();
+  std::atomic<bool> ret( true );
   videoOccupancyMap.resize( sources.getFrameCount() );
-  for ( size_t f = 0; f < sources.getFrameCount(); ++f ) {
-    auto&                 contextFrame = context.getFrames()[f];
-    PCCImageOccupancyMap& videoFrame   = videoOccupancyMap.getFrame( f );
-    ret &= generateOccupancyMapVideo( contextFrame.getAtlasFrameWidth(), contextFrame.getAtlasFrameHeight(),
-                                      contextFrame.getTitleFrameContext().getOccupancyMap(), videoFrame );
-  }
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), sources.getFrameCount(), [&]( const size_t f ) {
+      auto&                 contextFrame = context.getFrames()[f];
+      PCCImageOccupancyMap& videoFrame   = videoOccupancyMap.getFrame( f );
+      if ( !generateOccupancyMapVideo( contextFrame.getAtlasFrameWidth(), contextFrame.getAtlasFrameHeight(),
+                                       contextFrame.getTitleFrameContext().getOccupancyMap(), videoFrame ) ) {
+        ret = false;
+      }
+    } );
+  } );
   return ret;
 }
 
@@ -882,69 +1133,66 @@ bool PCCEncoder::modifyOccupancyMap( const size_t           imageWidth,
                                      uint64_t&              changedPixCnt0To1,
                                      uint64_t&              changedPixCnt1To0,
                                      uint64_t&              pixCnt ) {
-  const size_t          numSubBlksV = imageHeight / params_.occupancyPrecision_;
-  const size_t          numSubBlksH = imageWidth / params_.occupancyPrecision_;
-  std::vector<uint32_t> newOccupancyMap;
-  newOccupancyMap.resize( imageWidth * imageHeight );
-  char char0   = static_cast<char>( 0 );
-  char char255 = static_cast<char>( 255 );
-  for ( size_t v0 = 0; v0 < numSubBlksV; ++v0 ) {
-    const size_t v1 = v0 * params_.occupancyPrecision_;
-    for ( size_t u0 = 0; u0 < numSubBlksH; ++u0 ) {
-      const size_t u1    = u0 * params_.occupancyPrecision_;
-      uint8_t      pixel = videoFrameOccupancyMap.getValue( 0, u0, v0 );
-      for ( size_t v2 = 0; v2 < params_.occupancyPrecision_; v2++ ) {
-        for ( size_t u2 = 0; u2 < params_.occupancyPrecision_; u2++ ) {
-          size_t index = ( v1 + v2 ) * imageWidth + u1 + u2;
-          pixCnt++;
-          if ( pixel <= params_.thresholdLossyOM_ ) {
-            newOccupancyMap[index] = 0;
-          } else {
-            newOccupancyMap[index] = 1;
-          }
-          if ( occupancyMap[index] != newOccupancyMap[index] ) {
-            changedPixCnt++;
-            if ( occupancyMap[index] == 0 ) {
-              changedPixCnt0To1++;
-              if ( params_.keepIntermediateFiles_ ) {
-                ofile.write( &char255, 1 );
-                ofile.write( &char0, 1 );
-                ofile.write( &char0, 1 );
-              }
-            } else {
-              changedPixCnt1To0++;
-              if ( params_.keepIntermediateFiles_ ) {
-                ofile.write( &char0, 1 );
-                ofile.write( &char255, 1 );
-                ofile.write( &char0, 1 );
-              }
-            }
-          } else {
-            if ( occupancyMap[index] == 0 ) {
-              if ( params_.keepIntermediateFiles_ ) {
-                ofile.write( &char0, 1 );
-                ofile.write( &char0, 1 );
-                ofile.write( &char0, 1 );
-              }
-            } else {
-              if ( params_.keepIntermediateFiles_ ) {
-                ofile.write( &char255, 1 );
-                ofile.write( &char255, 1 );
-                ofile.write( &char255, 1 );
+  const size_t precision   = params_.occupancyPrecision_;
+  const size_t numSubBlksV = imageHeight / precision;
+  const size_t numSubBlksH = imageWidth / precision;
+  // The video is thresholded once, 64 pixels at a time, as the decoder does. Each row of blocks then updates its own
+  // rows of the map in parallel; the map before the update is only kept to write the intermediate file.
+  PCCOccupancyBitMap bits;
+  bits.threshold( videoFrameOccupancyMap, 0, 0, videoFrameOccupancyMap.getWidth(),
+                  videoFrameOccupancyMap.getHeight(), params_.thresholdLossyOM_ );
+  std::vector<uint32_t> previousOccupancyMap;
+  if ( params_.keepIntermediateFiles_ ) { previousOccupancyMap = occupancyMap; }
+  std::vector<uint64_t> changedRow0To1( numSubBlksV, 0 );
+  std::vector<uint64_t> changedRow1To0( numSubBlksV, 0 );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), numSubBlksV, [&]( const size_t v0 ) {
+      const uint64_t* row = bits.getRow( v0 );
+      for ( size_t v = v0 * precision; v < ( v0 + 1 ) * precision; ++v ) {
+        for ( size_t u0 = 0; u0 < numSubBlksH; ++u0 ) {
+          const uint32_t value = static_cast<uint32_t>( ( row[u0 >> 6] >> ( u0 & 63 ) ) & 1U );
+          for ( size_t u = u0 * precision; u < ( u0 + 1 ) * precision; ++u ) {
+            auto& pixel = occupancyMap[v * imageWidth + u];
+            if ( pixel != value ) {
+              if ( pixel == 0 ) {
+                changedRow0To1[v0]++;
+              } else {
+                changedRow1To0[v0]++;
               }
+              pixel = value;
             }
           }
-          occupancyMap[index] = newOccupancyMap[index];
+        }
+      }
+    } );
+  } );
+  for ( size_t v0 = 0; v0 < numSubBlksV; ++v0 ) {
+    changedPixCnt0To1 += changedRow0To1[v0];
+    changedPixCnt1To0 += changedRow1To0[v0];
+    changedPixCnt += changedRow0To1[v0] + changedRow1To0[v0];
+  }
+  pixCnt += numSubBlksV * numSubBlksH * precision * precision;
+  if ( params_.keepIntermediateFiles_ ) {
+    // red: 0 to 1, green: 1 to 0, white and black: unchanged; written block after block
+    std::string rgb;
+    rgb.reserve( 3 * numSubBlksV * numSubBlksH * precision * precision );
+    for ( size_t v0 = 0; v0 < numSubBlksV; ++v0 ) {
+      for ( size_t u0 = 0; u0 < numSubBlksH; ++u0 ) {
+        for ( size_t v = v0 * precision; v < ( v0 + 1 ) * precision; ++v ) {
+          for ( size_t u = u0 * precision; u < ( u0 + 1 ) * precision; ++u ) {
+            const size_t index    = v * imageWidth + u;
+            const bool   previous = previousOccupancyMap[index] != 0;
+            const bool   changed  = previousOccupancyMap[index] != occupancyMap[index];
+            rgb.push_back( static_cast<char>( !previous ? ( changed ? 255 : 0 ) : ( changed ? 0 : 255 ) ) );
+            rgb.push_back( static_cast<char>( previous ? 255 : 0 ) );
+            rgb.push_back( static_cast<char>( previous && !changed ? 255 : 0 ) );
+          }
         }
       }
     }
+    ofile.write( rgb.data(), rgb.size() );
   }
-  for ( size_t yy = 0; yy < videoFrameOccupancyMap.getHeight(); yy++ ) {
-    for ( size_t xx = 0; xx < videoFrameOccupancyMap.getWidth(); xx++ ) {
-      auto pixel = videoFrameOccupancyMap.getValue( 0, xx, yy );
-      videoFrameOccupancyMap.setValue( 0, xx, yy, ( pixel <= params_.thresholdLossyOM_ ) ? 0 : 1 );
-    }
-  }
+  bits.copyTo( videoFrameOccupancyMap, 0, 0 );
   return true;
 }
 
@@ -955,7 +1203,11 @@ void PCCEncoder::modifyOccupancyMapEOM( PCCFrameContext& tile ) {
   auto& height           = tile.getHeight();
   occupancyMap.resize( width * height, 0 );
   if ( !params_.absoluteD1_ || !params_.absoluteT1_ ) { fullOccupancyMap.resize( width * height, 0 ); }
-  for ( auto& patch : tile.getPatches() ) {
+  // the points of a patch only fill the blocks it occupies, which no other patch does: the patches are updated in
+  // parallel
+  auto& patches = tile.getPatches();
+  tbb::parallel_for( size_t( 0 ), patches.size(), [&]( const size_t patchIndex ) {
+    auto& patch = patches[patchIndex];
     for ( size_t v = 0; v < patch.getSizeV(); ++v ) {
       for ( size_t u = 0; u < patch.getSizeU(); ++u ) {
         const size_t  p       = v * patch.getSizeU() + u;
@@ -987,7 +1239,7 @@ void PCCEncoder::modifyOccupancyMapEOM( PCCFrameContext& tile ) {
         }
       }
     }  // u
-  }    // v
+  } );  // v
   if ( !params_.absoluteD1_ || !params_.absoluteT1_ ) { fullOccupancyMap = occupancyMap; }
 }
 
@@ -1254,13 +1506,16 @@ void PCCEncoder::spatialConsistencyPackFlexible( PCCFrameContext& tile,
   matchedPatches.clear();
   float  thresholdIOU    = 0.2F;
   size_t bestRefFrameIdx = 0;
+  PCCPatchRectGrid    grid( patches );
+  std::vector<size_t> candidates;
   // main loop.
   for ( auto& patch : prevPatches ) {
     id++;
     float maxIou  = 0.0F;
     int   bestIdx = -1;
-    int   cId     = 0;
-    for ( auto& cpatch : patches ) {
+    grid.query( patch, candidates );
+    for ( size_t cId : candidates ) {
+      auto& cpatch = patches[cId];
       if ( ( patch.getViewId() == cpatch.getViewId() ) && ( cpatch.getBestMatchIdx() == g_invalidPatchIndex ) &&
            ( patch.getLodScaleX() == cpatch.getLodScaleX() && patch.getLodScaleY() == cpatch.getLodScaleY() ) ) {
         patch.setPatchType( static_cast<uint8_t>( P_INTRA ) );
@@ -1269,10 +1524,9 @@ void PCCEncoder::spatialConsistencyPackFlexible( PCCFrameContext& tile,
         float iou   = computeIOU( rect, crect );
         if ( iou > maxIou ) {
           maxIou  = iou;
-          bestIdx = cId;
+          bestIdx = static_cast<int>( cId );
         }
       }  // end of if (patch.viewId == cpatch.viewId).
-      cId++;
     }
 
     if ( maxIou > thresholdIOU ) {
@@ -1323,18 +1577,44 @@ void PCCEncoder::spatialConsistencyPackFlexible( PCCFrameContext& tile,
   int               numOrientations = packingStrategy == 0 ? 1 : ( params_.useEightOrientations_ ? 8 : 2 );
   std::vector<bool> occupancyMap;
   occupancyMap.resize( occupancySizeU * occupancySizeV, false );
+  // the same blocks one bit each, the fit tests AND the patch masks with it word by word
+  PCCOccupancyBitMap canvas;
+  canvas.resize( occupancySizeU, occupancySizeV );
   for ( auto& patch : patches ) {
     assert( patch.getSizeU0() <= occupancySizeU );
     assert( patch.getSizeV0() <= occupancySizeV );
     bool  locationFound = false;
     auto& occupancy     = patch.getOccupancy();
+    // the blocks the patch needs free in each orientation, whatever its position: in the one of its match without
+    // and with the safeguard, or in each of the others when unmatched
+    PCCOccupancyBitMap              matchedMask;
+    PCCOccupancyBitMap              matchedSafeguardMask;
+    std::vector<PCCOccupancyBitMap> masks( numOrientations );
+    if ( patch.getBestMatchIdx() != g_invalidPatchIndex ) {
+      patch.setPatchOrientation( prevPatches[patch.getBestMatchIdx()].getPatchOrientation() );
+      patch.getCanvasBlockMask( matchedMask, params_.lowDelayEncoding_ );
+      patch.getCanvasBlockMask( matchedSafeguardMask, params_.lowDelayEncoding_, safeguard );
+    } else {
+      for ( size_t orientationIdx = 0; orientationIdx < numOrientations; orientationIdx++ ) {
+        if ( packingStrategy == 0 )
+          patch.setPatchOrientation( PATCH_ORIENTATION_DEFAULT );
+        else {
+          if ( patch.getSizeU0() > patch.getSizeV0() ) {
+            patch.setPatchOrientation( g_orientationHorizontal[orientationIdx] );
+          } else {
+            patch.setPatchOrientation( g_orientationVertical[orientationIdx] );
+          }
+        }
+        patch.getCanvasBlockMask( masks[orientationIdx], params_.lowDelayEncoding_, safeguard );
+      }
+    }
     while ( !locationFound ) {
       if ( patch.getBestMatchIdx() != g_invalidPatchIndex ) {
         patch.setPatchOrientation( prevPatches[patch.getBestMatchIdx()].getPatchOrientation() );
         // try to place on the same position as the matched patch
         patch.setU0( prevPatches[patch.getBestMatchIdx()].getU0() );
         patch.setV0( prevPatches[patch.getBestMatchIdx()].getV0() );
-        if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_ ) ) {
+        if ( patch.checkFitPatchCanvas( canvas, matchedMask ) ) {
           locationFound = true;
           if ( g_printDetailedInfo ) {
             std::cout << "Maintained orientation " << patch.getPatchOrientation() << " for matched patch "
@@ -1347,8 +1627,7 @@ void PCCEncoder::spatialConsistencyPackFlexible( PCCFrameContext& tile,
           for ( int u = 0; u <= occupancySizeU && !locationFound; ++u ) {
             patch.setU0( u );
             patch.setV0( v );
-            if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_,
-                                            safeguard ) ) {
+            if ( patch.checkFitPatchCanvas( canvas, matchedSafeguardMask, safeguard ) ) {
               locationFound = true;
               if ( g_printDetailedInfo ) {
                 std::cout << "Maintained orientation " << patch.getPatchOrientation() << " for matched patch "
@@ -1373,8 +1652,7 @@ void PCCEncoder::spatialConsistencyPackFlexible( PCCFrameContext& tile,
                   patch.setPatchOrientation( g_orientationVertical[orientationIdx] );
                 }
               }
-              if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_,
-                                              safeguard ) ) {
+              if ( patch.checkFitPatchCanvas( canvas, masks[orientationIdx], safeguard ) ) {
                 locationFound = true;
                 if ( g_printDetailedInfo ) {
                   std::cout << "Orientation " << patch.getPatchOrientation() << " selected for unmatched patch "
@@ -1388,6 +1666,7 @@ void PCCEncoder::spatialConsistencyPackFlexible( PCCFrameContext& tile,
       if ( !locationFound ) {
         occupancySizeV *= 2;
         occupancyMap.resize( occupancySizeU * occupancySizeV );
+        canvas.setHeight( occupancySizeV );
       }
     }
     for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
@@ -1398,6 +1677,7 @@ void PCCEncoder::spatialConsistencyPackFlexible( PCCFrameContext& tile,
         } else {
           occupancyMap[coord] = occupancyMap[coord] || occupancy[v0 * patch.getSizeU0() + u0];
         }
+        if ( occupancyMap[coord] ) { canvas.set( coord % occupancySizeU, coord / occupancySizeU ); }
       }
     }
     if ( !( patch.isPatchDimensionSwitched() ) ) {
@@ -1442,6 +1722,8 @@ void PCCEncoder::spatialConsistencyPackTetris( PCCFrameContext& frame,
   matchedPatches.clear();
   float thresholdIOU = 0.2F;
 
+  PCCPatchRectGrid    grid( patches );
+  std::vector<size_t> candidates;
   // main loop.
   for ( auto& patch : prevPatches ) {
     assert( patch.getSizeU0() <= occupancySizeU );
@@ -1449,8 +1731,9 @@ void PCCEncoder::spatialConsistencyPackTetris( PCCFrameContext& frame,
     id++;
     float maxIou  = 0.0;
     int   bestIdx = -1;
-    int   cId     = 0;
-    for ( auto& cpatch : patches ) {
+    grid.query( patch, candidates );
+    for ( size_t cId : candidates ) {
+      auto& cpatch = patches[cId];
       if ( ( patch.getViewId() == cpatch.getViewId() ) && ( cpatch.getBestMatchIdx() == -1 ) &&
            ( patch.getLodScaleX() == cpatch.getLodScaleX() && patch.getLodScaleY() == cpatch.getLodScaleY() ) ) {
         Rect  rect  = Rect( patch.getU1(), patch.getV1(), patch.getSizeU(), patch.getSizeV() );
@@ -1458,10 +1741,9 @@ void PCCEncoder::spatialConsistencyPackTetris( PCCFrameContext& frame,
         float iou   = computeIOU( rect, crect );
         if ( iou > maxIou ) {
           maxIou  = iou;
-          bestIdx = cId;
+          bestIdx = static_cast<int>( cId );
         }
       }  // end of if (patch.viewId == cpatch.viewId).
-      cId++;
     }
     if ( maxIou > thresholdIOU ) {
       // store the best match index
@@ -1499,6 +1781,9 @@ void PCCEncoder::spatialConsistencyPackTetris( PCCFrameContext& frame,
   size_t            maxOccupancyRow = 0;
   std::vector<bool> occupancyMap;
   occupancyMap.resize( occupancySizeU * occupancySizeV, false );
+  // the same blocks one bit each, the fit tests AND the patch masks with it word by word
+  PCCOccupancyBitMap canvas;
+  canvas.resize( occupancySizeU, occupancySizeV );
   std::vector<int> horizon;
   horizon.resize( occupancySizeU, 0 );
 
@@ -1512,7 +1797,25 @@ void PCCEncoder::spatialConsistencyPackTetris( PCCFrameContext& frame,
     std::vector<int> rightHorizon;
     std::vector<int> leftHorizon;
     patch.getPatchHorizons( topHorizon, bottomHorizon, rightHorizon, leftHorizon );
-    bool locationFound = false;
+    bool        locationFound      = false;
+    vector<int> orientation_values = {
+        PATCH_ORIENTATION_DEFAULT, PATCH_ORIENTATION_SWAP,    PATCH_ORIENTATION_ROT180,
+        PATCH_ORIENTATION_MIRROR,  PATCH_ORIENTATION_MROT180, PATCH_ORIENTATION_ROT270,
+        PATCH_ORIENTATION_MROT90,  PATCH_ORIENTATION_ROT90 };  // favoring vertical orientation
+    int numOrientations = params_.useEightOrientations_ ? 8 : 2;
+    // the blocks the patch needs free in each orientation, whatever its position: in the one of its match, or in
+    // each of the others when unmatched
+    std::vector<PCCOccupancyBitMap> masks( numOrientations );
+    std::vector<size_t>             lowestV( numOrientations );
+    if ( patch.getBestMatchIdx() != -1 ) {
+      patch.setPatchOrientation( prevPatches[patch.getBestMatchIdx()].getPatchOrientation() );
+      patch.getCanvasBlockMask( masks[0], params_.lowDelayEncoding_, safeguard );
+    } else {
+      for ( size_t orientationIdx = 0; orientationIdx < numOrientations; orientationIdx++ ) {
+        patch.setPatchOrientation( orientation_values[orientationIdx] );
+        patch.getCanvasBlockMask( masks[orientationIdx], params_.lowDelayEncoding_, safeguard );
+      }
+    }
     while ( !locationFound ) {
       int    best_wasted_space = (std::numeric_limits<int>::max)();
       size_t bestU;
@@ -1533,8 +1836,7 @@ void PCCEncoder::spatialConsistencyPackTetris( PCCFrameContext& frame,
           if ( xp >= 0 && xp < occupancySizeU && yp >= 0 && yp < occupancySizeV ) {
             patch.setU0( xp );
             patch.setV0( yp );
-            if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_,
-                                            safeguard ) ) {
+            if ( patch.checkFitPatchCanvas( canvas, masks[0], safeguard ) ) {
               locationFound = true;
               bestU         = xp;
               bestV         = yp;
@@ -1551,28 +1853,31 @@ void PCCEncoder::spatialConsistencyPackTetris( PCCFrameContext& frame,
           }
         }
       } else {
-        vector<int> orientation_values = {
-            PATCH_ORIENTATION_DEFAULT, PATCH_ORIENTATION_SWAP,    PATCH_ORIENTATION_ROT180,
-            PATCH_ORIENTATION_MIRROR,  PATCH_ORIENTATION_MROT180, PATCH_ORIENTATION_ROT270,
-            PATCH_ORIENTATION_MROT90,  PATCH_ORIENTATION_ROT90 };  // favoring vertical orientation
-        int numOrientations = params_.useEightOrientations_ ? 8 : 2;
-        // tetris packing
+        // tetris packing, a column is searched from the lowest position above the horizon of each orientation, and
+        // only as long as the wasted space, which grows with v, can still be lower than the best one
         for ( size_t u = 0; u < occupancySizeU; ++u ) {
+          patch.setU0( u );
+          for ( size_t orientationIdx = 0; orientationIdx < numOrientations; orientationIdx++ ) {
+            patch.setPatchOrientation( orientation_values[orientationIdx] );
+            lowestV[orientationIdx] =
+                u + ( patch.isPatchDimensionSwitched() ? patch.getSizeV0() : patch.getSizeU0() ) <= occupancySizeU
+                    ? patch.getLowestV0AboveHorizon( horizon, topHorizon, bottomHorizon, rightHorizon, leftHorizon )
+                    : occupancySizeV;
+          }
           for ( size_t v = 0; v < occupancySizeV; ++v ) {
+            if ( locationFound && PCCPatch::wastedSpaceLambda_ * v >= size_t( best_wasted_space ) ) { break; }
             patch.setU0( u );
             patch.setV0( v );
             for ( size_t orientationIdx = 0; orientationIdx < numOrientations; orientationIdx++ ) {
               patch.setPatchOrientation( orientation_values[orientationIdx] );
-              if ( !patch.isPatchLocationAboveHorizon( horizon, topHorizon, bottomHorizon, rightHorizon,
-                                                       leftHorizon ) ) {
+              if ( v < lowestV[orientationIdx] ) {
                 if ( g_printDetailedInfo ) {
                   std::cout << "(" << u << "," << v << "|" << patch.getPatchOrientation() << ") above horizon"
                             << std::endl;
                 }
                 continue;
               }
-              if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_,
-                                              safeguard ) ) {
+              if ( patch.checkFitPatchCanvas( canvas, masks[orientationIdx], safeguard ) ) {
                 // now calculate the wasted space
                 int wasted_space =
                     patch.calculateWastedSpace( horizon, topHorizon, bottomHorizon, rightHorizon, leftHorizon );
@@ -1591,6 +1896,7 @@ void PCCEncoder::spatialConsistencyPackTetris( PCCFrameContext& frame,
       if ( !locationFound ) {
         occupancySizeV *= 2;
         occupancyMap.resize( occupancySizeU * occupancySizeV );
+        canvas.setHeight( occupancySizeV );
       } else {
         // select the best position and orientation
         patch.setU0( bestU );
@@ -1618,6 +1924,7 @@ void PCCEncoder::spatialConsistencyPackTetris( PCCFrameContext& frame,
         } else {
           occupancyMap[coord] = occupancyMap[coord] || occupancy[v0 * patch.getSizeU0() + u0];
         }
+        if ( occupancyMap[coord] ) { canvas.set( coord % occupancySizeU, coord / occupancySizeU ); }
       }
     }
     if ( !( patch.isPatchDimensionSwitched() ) ) {
@@ -1668,13 +1975,16 @@ void PCCEncoder::findMatchesForGlobalTetrisPacking( PCCFrameContext& tile, PCCFr
   int              id = 0;
   matchedPatches.clear();
   float thresholdIOU = 0.2F;
+  PCCPatchRectGrid    grid( patches );
+  std::vector<size_t> candidates;
   // main loop.
   for ( auto& patch : prevPatches ) {
     id++;
     float maxIou  = 0.0F;
     int   bestIdx = -1;
-    int   cId     = 0;
-    for ( auto& cpatch : patches ) {
+    grid.query( patch, candidates );
+    for ( size_t cId : candidates ) {
+      auto& cpatch = patches[cId];
       if ( ( patch.getViewId() == cpatch.getViewId() ) && ( cpatch.getBestMatchIdx() == g_invalidPatchIndex ) &&
            ( patch.getLodScaleX() == cpatch.getLodScaleX() && patch.getLodScaleY() == cpatch.getLodScaleY() ) ) {
         Rect  rect  = Rect( patch.getU1(), patch.getV1(), patch.getSizeU(), patch.getSizeV() );
@@ -1682,10 +1992,9 @@ void PCCEncoder::findMatchesForGlobalTetrisPacking( PCCFrameContext& tile, PCCFr
         float iou   = computeIOU( rect, crect );
         if ( iou > maxIou ) {
           maxIou  = iou;
-          bestIdx = cId;
+          bestIdx = static_cast<int>( cId );
         }
       }  // end of if (patch.viewId == cpatch.viewId).
-      cId++;
     }
     if ( maxIou > thresholdIOU ) {
       // checking the size of the matched patches
@@ -2392,11 +2701,28 @@ void PCCEncoder::packFlexible( PCCFrameContext& tile,
   std::vector<bool> occupancyMap;
   int               numOrientations = ( packingStrategy == 0 ) ? 1 : ( params_.useEightOrientations_ ? 8 : 2 );
   occupancyMap.resize( occupancySizeU * occupancySizeV, false );
+  // the same blocks one bit each, the fit tests AND the patch masks with it word by word
+  PCCOccupancyBitMap canvas;
+  canvas.resize( occupancySizeU, occupancySizeV );
   for ( auto& patch : patches ) {
     assert( patch.getSizeU0() <= occupancySizeU );
     assert( patch.getSizeV0() <= occupancySizeV );
     bool  locationFound = false;
     auto& occupancy     = patch.getOccupancy();
+    // the blocks the patch needs free in each orientation, whatever its position
+    std::vector<PCCOccupancyBitMap> masks( numOrientations );
+    for ( size_t orientationIdx = 0; orientationIdx < numOrientations; orientationIdx++ ) {
+      if ( packingStrategy == 0 )
+        patch.setPatchOrientation( PATCH_ORIENTATION_DEFAULT );
+      else {
+        if ( patch.getSizeU0() > patch.getSizeV0() ) {
+          patch.setPatchOrientation( g_orientationHorizontal[orientationIdx] );
+        } else {
+          patch.setPatchOrientation( g_orientationVertical[orientationIdx] );
+        }
+      }
+      patch.getCanvasBlockMask( masks[orientationIdx], params_.lowDelayEncoding_, safeguard );
+    }
     while ( !locationFound ) {
       for ( size_t v = 0; v < occupancySizeV && !locationFound; ++v ) {
         for ( size_t u = 0; u < occupancySizeU && !locationFound; ++u ) {
@@ -2412,8 +2738,7 @@ void PCCEncoder::packFlexible( PCCFrameContext& tile,
                 patch.setPatchOrientation( g_orientationVertical[orientationIdx] );
               }
             }
-            if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_,
-                                            safeguard ) ) {
+            if ( patch.checkFitPatchCanvas( canvas, masks[orientationIdx], safeguard ) ) {
               locationFound = true;
               if ( g_printDetailedInfo ) {
                 std::cout << "Orientation " << patch.getPatchOrientation() << " selected for patch " << patch.getIndex()
@@ -2426,6 +2751,7 @@ void PCCEncoder::packFlexible( PCCFrameContext& tile,
       if ( !locationFound ) {
         occupancySizeV *= 2;
         occupancyMap.resize( occupancySizeU * occupancySizeV );
+        canvas.setHeight( occupancySizeV );
       }
     }
     for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
@@ -2436,6 +2762,7 @@ void PCCEncoder::packFlexible( PCCFrameContext& tile,
         } else {
           occupancyMap[coord] = occupancyMap[coord] || occupancy[v0 * patch.getSizeU0() + u0];
         }
+        if ( occupancyMap[coord] ) { canvas.set( coord % occupancySizeU, coord / occupancySizeU ); }
       }
     }
     if ( !( patch.isPatchDimensionSwitched() ) ) {
@@ -2771,14 +3098,18 @@ void PCCEncoder::spatialConsistencyPackMultipleTiles( PCCAtlasFrameContext& atla
   newOrderPatches.clear();
   float thresholdIOU = 0.2f;
 
+  PCCPatchRectGrid    grid( patches );
+  std::vector<size_t> candidates;
   // main loop. (NOTICE: enforcing the match to be from the same ROI)
   for ( auto& patch : prevPatches ) {
     assert( patch.getSizeU0() <= occupancySizeU );
     assert( patch.getSizeV0() <= occupancySizeV );
     id++;
     float maxIou  = 0.0f;
-    int   bestIdx = -1, cId = 0;
-    for ( auto& cpatch : patches ) {
+    int   bestIdx = -1;
+    grid.query( patch, candidates );
+    for ( size_t cId : candidates ) {
+      auto& cpatch = patches[cId];
       if ( ( patch.getViewId() == cpatch.getViewId() ) && ( cpatch.getBestMatchIdx() == g_invalidPatchIndex ) &&
            ( patch.getLodScaleX() == cpatch.getLodScaleX() && patch.getLodScaleY() == cpatch.getLodScaleY() ) &&
            ( patch.getRoiIndex() == cpatch.getRoiIndex() ) ) {
@@ -2787,10 +3118,9 @@ void PCCEncoder::spatialConsistencyPackMultipleTiles( PCCAtlasFrameContext& atla
         float iou   = computeIOU( rect, crect );
         if ( iou > maxIou ) {
           maxIou  = iou;
-          bestIdx = cId;
+          bestIdx = static_cast<int>( cId );
         }
       }  // end of if (patch.viewId == cpatch.viewId).
-      cId++;
     }
     if ( maxIou > thresholdIOU ) {
       // store the best match index
@@ -2929,12 +3259,16 @@ void PCCEncoder::spatialConsistencyPackFlexibleMultipleTiles( PCCAtlasFrameConte
   matchedPatches.clear();
   float  thresholdIOU    = 0.2f;
   size_t bestRefFrameIdx = 0;
+  PCCPatchRectGrid    grid( patches );
+  std::vector<size_t> candidates;
   // main loop. (NOTE: enforcing the matches to be from the same ROI)
   for ( auto& patch : prevPatches ) {
     id++;
     float maxIou  = 0.0f;
-    int   bestIdx = -1, cId = 0;
-    for ( auto& cpatch : patches ) {
+    int   bestIdx = -1;
+    grid.query( patch, candidates );
+    for ( size_t cId : candidates ) {
+      auto& cpatch = patches[cId];
       if ( ( patch.getViewId() == cpatch.getViewId() ) && ( cpatch.getBestMatchIdx() == g_invalidPatchIndex ) &&
            ( patch.getLodScaleX() == cpatch.getLodScaleX() && patch.getLodScaleY() == cpatch.getLodScaleY() &&
              ( patch.getRoiIndex() == cpatch.getRoiIndex() ) ) ) {
@@ -2944,10 +3278,9 @@ void PCCEncoder::spatialConsistencyPackFlexibleMultipleTiles( PCCAtlasFrameConte
         float iou   = computeIOU( rect, crect );
         if ( iou > maxIou ) {
           maxIou  = iou;
-          bestIdx = cId;
+          bestIdx = static_cast<int>( cId );
         }
       }  // end of if (patch.viewId == cpatch.viewId).
-      cId++;
     }
     if ( maxIou > thresholdIOU ) {
       // store the best match index
@@ -3238,6 +3571,9 @@ void PCCEncoder::packTetris( PCCFrameContext& frame, size_t presetWidth, size_t
   size_t            maxOccupancyRow = 0;
   std::vector<bool> occupancyMap;
   occupancyMap.resize( occupancySizeU * occupancySizeV, false );
+  // the same blocks one bit each, the fit tests AND the patch masks with it word by word
+  PCCOccupancyBitMap canvas;
+  canvas.resize( occupancySizeU, occupancySizeV );
   std::vector<int> horizon;
   horizon.resize( occupancySizeU, 0 );
   if ( g_printDetailedInfo ) {
@@ -3259,18 +3595,36 @@ void PCCEncoder::packTetris( PCCFrameContext& frame, size_t presetWidth, size_t
     bool locationFound = false;
     // try to place the patch tetris-style
     int numOrientations = params_.useEightOrientations_ ? 8 : 2;
+    // the blocks the patch needs free in each orientation, whatever its position
+    std::vector<PCCOccupancyBitMap> masks( numOrientations );
+    std::vector<size_t>             lowestV( numOrientations );
+    for ( size_t orientationIdx = 0; orientationIdx < numOrientations; orientationIdx++ ) {
+      patch.setPatchOrientation( g_orientationVertical[orientationIdx] );
+      patch.getCanvasBlockMask( masks[orientationIdx], params_.lowDelayEncoding_, safeguard );
+    }
     while ( !locationFound ) {
       int    best_wasted_space = (std::numeric_limits<int>::max)();
       size_t bestU;
       size_t bestV;
       int    bestOrientation;
       for ( size_t u = 0; u < occupancySizeU; ++u ) {
+        // a column is searched from the lowest position above the horizon of each orientation, and only as long as
+        // the wasted space, which grows with v, can still be lower than the best one
+        patch.setU0( u );
+        for ( size_t orientationIdx = 0; orientationIdx < numOrientations; orientationIdx++ ) {
+          patch.setPatchOrientation( g_orientationVertical[orientationIdx] );
+          lowestV[orientationIdx] =
+              u + ( patch.isPatchDimensionSwitched() ? patch.getSizeV0() : patch.getSizeU0() ) <= occupancySizeU
+                  ? patch.getLowestV0AboveHorizon( horizon, topHorizon, bottomHorizon, rightHorizon, leftHorizon )
+                  : occupancySizeV;
+        }
         for ( size_t v = 0; v < occupancySizeV; ++v ) {
+          if ( locationFound && PCCPatch::wastedSpaceLambda_ * v >= size_t( best_wasted_space ) ) { break; }
           patch.setU0( u );
           patch.setV0( v );
           for ( size_t orientationIdx = 0; orientationIdx < numOrientations; orientationIdx++ ) {
             patch.setPatchOrientation( g_orientationVertical[orientationIdx] );
-            if ( !patch.isPatchLocationAboveHorizon( horizon, topHorizon, bottomHorizon, rightHorizon, leftHorizon ) ) {
+            if ( v < lowestV[orientationIdx] ) {
               if ( g_printDetailedInfo ) {
                 std::cout << "(" << u << "," << v << "|" << patch.getPatchOrientation() << ") above horizon"
                           << std::endl;
@@ -3280,8 +3634,7 @@ void PCCEncoder::packTetris( PCCFrameContext& frame, size_t presetWidth, size_t
             if ( g_printDetailedInfo ) {
               std::cout << "(" << u << "," << v << "|" << patch.getPatchOrientation() << ")" << std::endl;
             }
-            if ( patch.checkFitPatchCanvas( occupancyMap, occupancySizeU, occupancySizeV, params_.lowDelayEncoding_,
-                                            safeguard ) ) {
+            if ( patch.checkFitPatchCanvas( canvas, masks[orientationIdx], safeguard ) ) {
               // now calculate the wasted space
               int wasted_space =
                   patch.calculateWastedSpace( horizon, topHorizon, bottomHorizon, rightHorizon, leftHorizon );
@@ -3300,6 +3653,7 @@ void PCCEncoder::packTetris( PCCFrameContext& frame, size_t presetWidth, size_t
       if ( !locationFound ) {
         occupancySizeV *= 2;
         occupancyMap.resize( occupancySizeU * occupancySizeV );
+        canvas.setHeight( occupancySizeV );
         if ( g_printDetailedInfo ) {
           std::cout << "Increasing frame size (" << occupancySizeU << "," << occupancySizeV << ")" << std::endl;
         }
@@ -3330,6 +3684,7 @@ void PCCEncoder::packTetris( PCCFrameContext& frame, size_t presetWidth, size_t
         } else {
           occupancyMap[coord] = occupancyMap[coord] || occupancy[v0 * patch.getSizeU0() + u0];
         }
+        if ( occupancyMap[coord] ) { canvas.set( coord % occupancySizeU, coord / occupancySizeU ); }
       }
     }
     if ( !( patch.isPatchDimensionSwitched() ) ) {
@@ -3585,17 +3940,21 @@ PCCVector3D PCCEncoder::calculateWeightNormal( size_t geometryBitDepth3D, const
 }
 
 bool PCCEncoder::generateScaledGeometry( PCCFrameContext& title ) {
-  auto& patches = title.getPatches();
+  auto&        patches = title.getPatches();
+  const size_t lodX    = params_.levelOfDetailX_;
+  const size_t lodY    = params_.levelOfDetailY_;
   std::sort( patches.begin(), patches.end() );
-  for ( size_t i = 0; i < 3; i++ ) {
+  // every patch keeps the first pixel of each lodX x lodY block, rounding up so that a patch narrower than the level
+  // of detail keeps one column or row
+  for ( size_t i = 0; i < patches.size(); i++ ) {
     std::vector<int16_t> depth[2];  // depth
-    size_t               scaleSizeU = patches[i].getSizeU() / params_.levelOfDetailX_;
-    size_t               scaleSizeV = patches[i].getSizeV() / params_.levelOfDetailY_;
+    size_t               scaleSizeU = ( patches[i].getSizeU() + lodX - 1 ) / lodX;
+    size_t               scaleSizeV = ( patches[i].getSizeV() + lodY - 1 ) / lodY;
     depth[0].resize( scaleSizeU * scaleSizeV );
     depth[1].resize( scaleSizeU * scaleSizeV );
     for ( size_t v = 0; v < scaleSizeV; v++ ) {
       for ( size_t u = 0; u < scaleSizeU; u++ ) {
-        size_t p       = v * params_.levelOfDetailY_ * patches[i].getSizeU() + u * params_.levelOfDetailX_;
+        size_t p       = v * lodY * patches[i].getSizeU() + u * lodX;
         size_t pScaled = v * scaleSizeU + u;
         if ( patches[i].getDepth( 0 )[p] == g_infiniteDepth ) {
           depth[0][pScaled] = depth[1][pScaled] = g_infiniteDepth;
@@ -3605,8 +3964,8 @@ bool PCCEncoder::generateScaledGeometry( PCCFrameContext& title ) {
         }
       }
     }
-    patches[i].setLodScaleX( params_.levelOfDetailX_ );
-    patches[i].setLodScaleYIdc( params_.levelOfDetailY_ );
+    patches[i].setLodScaleX( lodX );
+    patches[i].setLodScaleYIdc( lodY );
     patches[i].setSizeU( scaleSizeU );
     patches[i].setSizeV( scaleSizeV );
     patches[i].setSizeU0( std::ceil( static_cast<double>( scaleSizeU ) / params_.occupancyResolution_ ) );
@@ -3635,7 +3994,7 @@ bool PCCEncoder::generateScaledGeometry( PCCFrameContext& title ) {
         }
       }
     }
-  }  // i<3
+  }
   return true;
 }
 
@@ -3650,7 +4009,9 @@ bool PCCEncoder::generateSegments( const PCCPointSet3&                 source,
     auto& patches = frame.getPatches();
     patches.reserve( 256 );
     PCCPatchSegmenter3 segmenter;
-    segmenter.setNbThread( params_.nbThread_ );
+    segmenter.setExecutionContext( *executionContext_ );
+    segmenter.setSpatialIndex( frame.getSpatialIndex() );
+    if ( params_.temporalNormals_ ) { segmenter.setNormalsReference( normalsReference_ ); }
     segmenter.compute( source, frame.getFrameIndex(), segmenterParams, patches, frame.getSrcPointCloudByPatch(),
                        distanceSrcRec );
   } else {
@@ -3676,7 +4037,7 @@ bool PCCEncoder::generateSegments( const PCCPointSet3&                 source,
 void PCCEncoder::dilateGroupGeometryVideo( PCCContext& context, PCCFrameContext& frame, size_t frameIdx ) {
   auto& videoGeometry         = context.getVideoGeometryMultiple()[0];
   auto& videoGeometryMultiple = context.getVideoGeometryMultiple();
-  auto  videoOccupancyMap     = context.getVideoOccupancyMap();
+  auto& videoOccupancyMap     = context.getVideoOccupancyMap();
   auto  width                 = frame.getWidth();
   auto  height                = frame.getHeight();
   auto& occupancyMap          = videoOccupancyMap.getFrame( frameIdx );
@@ -3697,29 +4058,34 @@ void PCCEncoder::dilateGroupGeometryVideo( PCCContext& context, PCCFrameContext&
   }
 }
 bool PCCEncoder::generateOccupancyMap( PCCContext& context, bool copyToFrame ) {
-  for ( auto& frame : context.getFrames() ) {
-    auto& entireFrame = frame.getTitleFrameContext();
-    entireFrame.getOccupancyMap().resize( entireFrame.getWidth() * entireFrame.getHeight(), 0 );
-    printf( "generateOccupancyMap frame %zu: entireFrameSize:%zux%zu\n", entireFrame.getFrameIndex(),
-            entireFrame.getWidth(), entireFrame.getHeight() );
-    for ( size_t ti = 0; ti < frame.getNumTilesInAtlasFrame(); ti++ ) {
-      auto& tile = frame.getTile( ti );
-      generateOccupancyMap( tile );
-      if ( params_.enhancedOccupancyMapCode_ ) { modifyOccupancyMapEOM( tile ); }
-      if ( copyToFrame ) {
-        for ( size_t y = 0; y < tile.getHeight(); y++ ) {
-          for ( size_t x = 0; x < tile.getWidth(); x++ ) {
-            entireFrame.getOccupancyMap()[( y + tile.getLeftTopYInFrame() ) * entireFrame.getWidth() +
-                                          ( x + tile.getLeftTopXInFrame() )] =
-                frame.getTile( ti ).getOccupancyMap()[y * tile.getWidth() + x];
+  PCC_PROFILE_ZONE( "occupancy map" );
+  auto& frames = context.getFrames();
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), frames.size(), [&]( const size_t f ) {
+      auto& frame       = frames[f];
+      auto& entireFrame = frame.getTitleFrameContext();
+      entireFrame.getOccupancyMap().resize( entireFrame.getWidth() * entireFrame.getHeight(), 0 );
+      printf( "generateOccupancyMap frame %zu: entireFrameSize:%zux%zu\n", entireFrame.getFrameIndex(),
+              entireFrame.getWidth(), entireFrame.getHeight() );
+      for ( size_t ti = 0; ti < frame.getNumTilesInAtlasFrame(); ti++ ) {
+        auto& tile = frame.getTile( ti );
+        generateOccupancyMap( tile );
+        if ( params_.enhancedOccupancyMapCode_ ) { modifyOccupancyMapEOM( tile ); }
+        if ( copyToFrame ) {
+          const auto& tileOccupancyMap = tile.getOccupancyMap();
+          for ( size_t y = 0; y < tile.getHeight(); y++ ) {
+            std::copy( tileOccupancyMap.begin() + y * tile.getWidth(),
+                       tileOccupancyMap.begin() + ( y + 1 ) * tile.getWidth(),
+                       entireFrame.getOccupancyMap().begin() +
+                           ( y + tile.getLeftTopYInFrame() ) * entireFrame.getWidth() + tile.getLeftTopXInFrame() );
           }
         }
       }
-    }
-    if ( !params_.absoluteD1_ || !params_.absoluteT1_ ) {
-      frame.getTitleFrameContext().getFullOccupancyMap() = frame.getTitleFrameContext().getOccupancyMap();
-    }
-  }
+      if ( !params_.absoluteD1_ || !params_.absoluteT1_ ) {
+        entireFrame.getFullOccupancyMap() = entireFrame.getOccupancyMap();
+      }
+    } );
+  } );
   return true;
 }
 
@@ -3730,7 +4096,9 @@ void PCCEncoder::generateOccupancyMap( PCCFrameContext& tile ) {
   auto& height           = tile.getHeight();
   occupancyMap.resize( width * height, 0 );
   if ( !params_.absoluteD1_ || !params_.absoluteT1_ ) { fullOccupancyMap.resize( width * height, 0 ); }
-  for ( auto& patch : tile.getPatches() ) {
+  auto& patches = tile.getPatches();
+  tbb::parallel_for( size_t( 0 ), patches.size(), [&]( const size_t patchIndex ) {
+    auto& patch = patches[patchIndex];
     for ( size_t v = 0; v < patch.getSizeV(); ++v ) {
       for ( size_t u = 0; u < patch.getSizeU(); ++u ) {
         const size_t  p = v * patch.getSizeU() + u;
@@ -3738,97 +4106,72 @@ void PCCEncoder::generateOccupancyMap( PCCFrameContext& tile ) {
         if ( d < g_infiniteDepth ) { occupancyMap[patch.patch2Canvas( u, v, width, height )] = 1; }
       }
     }
-  }
+  } );
   if ( !params_.absoluteD1_ || !params_.absoluteT1_ ) { fullOccupancyMap = occupancyMap; }
 }
 
 void PCCEncoder::refineOccupancyMap( PCCFrameContext& tile ) {
   auto&        patches    = tile.getPatches();
   const size_t patchCount = patches.size();
-  for ( size_t patchIndex = 0; patchIndex < patchCount; ++patchIndex ) {
-    auto& patch = patches[patchIndex];
-    // Count number of points in each block 4x4
-    if ( params_.occupancyPrecision_ > 1 ) {
-      for ( size_t v0 = 0; v0 < patch.getSizeV0(); v0++ ) {
-        for ( size_t u0 = 0; u0 < patch.getSizeU0(); u0++ ) {
-          for ( size_t v1 = 0; v1 < params_.occupancyResolution_; v1 += params_.occupancyPrecision_ ) {
-            for ( size_t u1 = 0; u1 < params_.occupancyResolution_; u1 += params_.occupancyPrecision_ ) {
-              size_t countOccupancyMapBlock4x4 = 0;
-              for ( size_t v2 = 0; v2 < params_.occupancyPrecision_; v2++ ) {
-                const size_t v = v0 * params_.occupancyResolution_ + v1 + v2;
-                if ( v < patch.getSizeV() ) {
-                  for ( size_t u2 = 0; u2 < params_.occupancyPrecision_; u2++ ) {
-                    const size_t u = u0 * params_.occupancyResolution_ + u1 + u2;
-                    if ( u < patch.getSizeU() ) {
-                      const size_t p = v * patch.getSizeU() + u;
-                      if ( patch.getDepth( 0 )[p] < g_infiniteDepth ) { countOccupancyMapBlock4x4++; }
-                    }
-                  }
-                }
-              }
-              if ( countOccupancyMapBlock4x4 > 0 ) {
-                if ( countOccupancyMapBlock4x4 == 1 ) {
-                  for ( size_t v2 = 0; v2 < params_.occupancyPrecision_; v2++ ) {
-                    const size_t v = v0 * params_.occupancyResolution_ + v1 + v2;
-                    if ( v < patch.getSizeV() ) {
-                      for ( size_t u2 = 0; u2 < params_.occupancyPrecision_; u2++ ) {
-                        const size_t u = u0 * params_.occupancyResolution_ + u1 + u2;
-                        if ( u < patch.getSizeU() ) {
-                          const size_t p = v * patch.getSizeU() + u;
-                          patch.setDepth( 0, p, g_infiniteDepth );
-                          patch.setDepth( 1, p, g_infiniteDepth );
-                        }
-                      }
-                    }
-                  }
-                }
-              }
-            }
+  const size_t resolution = params_.occupancyResolution_;
+  const size_t precision  = params_.occupancyPrecision_;
+  // The points of each patch are packed one bit per pixel and the blocks are counted by popcounts; the patches are
+  // refined in parallel.
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), patchCount, [&]( const size_t patchIndex ) {
+      auto&              patch = patches[patchIndex];
+      const size_t       sizeU = patch.getSizeU();
+      const size_t       sizeV = patch.getSizeV();
+      PCCOccupancyBitMap points;
+      points.resize( sizeU, sizeV );
+      for ( size_t v = 0; v < sizeV; ++v ) {
+        for ( size_t u = 0; u < sizeU; ++u ) {
+          if ( patch.getDepth( 0 )[v * sizeU + u] < g_infiniteDepth ) { points.set( u, v ); }
+        }
+      }
+      // removes the points of the rectangle [u0, u1) x [v0, v1), clipped to the patch
+      auto removeBlock = [&]( const size_t u0, const size_t v0, const size_t u1, const size_t v1 ) {
+        for ( size_t v = v0; v < ( std::min )( v1, sizeV ); ++v ) {
+          for ( size_t u = u0; u < ( std::min )( u1, sizeU ); ++u ) {
+            const size_t p = v * sizeU + u;
+            patch.setDepth( 0, p, g_infiniteDepth );
+            patch.setDepth( 1, p, g_infiniteDepth );
+            points.reset( u, v );
           }
         }
-      }
-    }
-    // Count number of points in each block 16x16
-    for ( size_t v0 = 0; v0 < patch.getSizeV0(); v0++ ) {
-      for ( size_t u0 = 0; u0 < patch.getSizeU0(); u0++ ) {
-        size_t countOccupancyMapBlock16x16 = 0;
-        for ( size_t v1 = 0; v1 < params_.occupancyResolution_; ++v1 ) {
-          const size_t v = v0 * params_.occupancyResolution_ + v1;
-          if ( v < patch.getSizeV() ) {
-            for ( size_t u1 = 0; u1 < params_.occupancyResolution_; ++u1 ) {
-              const size_t u = u0 * params_.occupancyResolution_ + u1;
-              if ( u < patch.getSizeU() ) {
-                const size_t p      = v * patch.getSizeU() + u;
-                int16_t      depth0 = patch.getDepth( 0 )[p];
-                if ( depth0 < g_infiniteDepth ) { countOccupancyMapBlock16x16++; }
+      };
+      // Count number of points in each block 4x4
+      if ( precision > 1 ) {
+        for ( size_t v0 = 0; v0 < patch.getSizeV0(); v0++ ) {
+          for ( size_t u0 = 0; u0 < patch.getSizeU0(); u0++ ) {
+            for ( size_t v1 = 0; v1 < resolution; v1 += precision ) {
+              for ( size_t u1 = 0; u1 < resolution; u1 += precision ) {
+                const size_t u                         = u0 * resolution + u1;
+                const size_t v                         = v0 * resolution + v1;
+                const size_t countOccupancyMapBlock4x4 = points.count(
+                    u, v, ( std::min )( u + precision, sizeU ), ( std::min )( v + precision, sizeV ) );
+                if ( countOccupancyMapBlock4x4 == 1 ) { removeBlock( u, v, u + precision, v + precision ); }
               }
             }
           }
         }
-        if ( countOccupancyMapBlock16x16 == 0 ) {
-          patch.setOccupancy( v0 * patch.getSizeU0() + u0, false );
-        } else {
-          if ( countOccupancyMapBlock16x16 < 4 && countOccupancyMapBlock16x16 != 0 ) {
+      }
+      // Count number of points in each block 16x16
+      for ( size_t v0 = 0; v0 < patch.getSizeV0(); v0++ ) {
+        for ( size_t u0 = 0; u0 < patch.getSizeU0(); u0++ ) {
+          const size_t u                           = u0 * resolution;
+          const size_t v                           = v0 * resolution;
+          const size_t countOccupancyMapBlock16x16 =
+              points.count( u, v, ( std::min )( u + resolution, sizeU ), ( std::min )( v + resolution, sizeV ) );
+          if ( countOccupancyMapBlock16x16 < 4 ) {
             patch.setOccupancy( v0 * patch.getSizeU0() + u0, false );
             // remove block 16x16
-            for ( size_t v1 = 0; v1 < params_.occupancyResolution_; ++v1 ) {
-              const size_t v = v0 * params_.occupancyResolution_ + v1;
-              if ( v < patch.getSizeV() ) {
-                for ( size_t u1 = 0; u1 < params_.occupancyResolution_; ++u1 ) {
-                  const size_t u = u0 * params_.occupancyResolution_ + u1;
-                  if ( u < patch.getSizeU() ) {
-                    const size_t p = v * patch.getSizeU() + u;
-                    patch.setDepth( 0, p, g_infiniteDepth );
-                    patch.setDepth( 1, p, g_infiniteDepth );
-                  }
-                }
-              }
-            }
+            if ( countOccupancyMapBlock16x16 != 0 ) { removeBlock( u, v, u + resolution, v + resolution ); }
           }
         }
       }
-    }
-  }
+    } );
+  } );
 }
 
 void PCCEncoder::remove3DMotionEstimationFiles( const std::string& path ) {
@@ -3837,47 +4180,65 @@ void PCCEncoder::remove3DMotionEstimationFiles( const std::string& path ) {
   removeFile( path + "blockToPatch.txt" );
 }
 
-void PCCEncoder::create3DMotionEstimationFiles( PCCContext& context, const std::string& path ) {
-  FILE* occupancyFile    = fopen( ( path + "occupancy.txt" ).c_str(), "wb" );
-  FILE* patchInfoFile    = fopen( ( path + "patchInfo.txt" ).c_str(), "wb" );
-  FILE* blockToPatchFile = fopen( ( path + "blockToPatch.txt" ).c_str(), "wb" );
+void PCCEncoder::create3DMotionEstimationSideInfo( PCCContext& context, PCCMotionEstimationSideInfo& sideInfo ) {
+  sideInfo.occupancyResolution_ = params_.occupancyResolution_;
+  sideInfo.occupancyPrecision_  = params_.occupancyPrecision_;
+  sideInfo.frames_.resize( context.size() );
   for ( size_t frIdx = 0; frIdx < context.size(); ++frIdx ) {
-    auto&        frame              = context.getFrame( frIdx ).getTitleFrameContext();
-    auto&        occupancyMapImage  = context.getVideoOccupancyMap().getFrame( frIdx );
-    auto&        patches            = frame.getPatches();
-    auto&        blockToPatch       = frame.getBlockToPatch();
-    const size_t blockToPatchWidth  = frame.getWidth() / params_.occupancyResolution_;
-    const size_t blockToPatchHeight = frame.getHeight() / params_.occupancyResolution_;
-    fwrite( &blockToPatch[0], sizeof( size_t ), blockToPatchHeight * blockToPatchWidth, blockToPatchFile );
-    uint32_t zeroVal = 0, oneVal = 1;
-    for ( int y = 0; y < frame.getHeight(); y++ ) {
-      for ( int x = 0; x < frame.getWidth(); x++ ) {
-        if ( occupancyMapImage.getValue( 0, x / params_.occupancyPrecision_, y / params_.occupancyPrecision_ ) > 0 ) {
-          fwrite( &oneVal, sizeof( uint32_t ), 1, occupancyFile );
-        } else {
-          fwrite( &zeroVal, sizeof( uint32_t ), 1, occupancyFile );
-        }
-      }
+    auto&        frame             = context.getFrame( frIdx ).getTitleFrameContext();
+    auto&        occupancyMapImage = context.getVideoOccupancyMap().getFrame( frIdx );
+    auto&        info              = sideInfo.frames_[frIdx];
+    const size_t blockToPatchSize =
+        ( frame.getWidth() / params_.occupancyResolution_ ) * ( frame.getHeight() / params_.occupancyResolution_ );
+    const size_t occupancyWidth  = frame.getWidth() / params_.occupancyPrecision_;
+    const size_t occupancyHeight = frame.getHeight() / params_.occupancyPrecision_;
+    sideInfo.width_              = frame.getWidth();
+    sideInfo.height_             = frame.getHeight();
+    info.blockToPatch_ = frame.getBlockToPatch().toVector();
+    info.blockToPatch_.resize( blockToPatchSize );
+    info.occupancy_.resize( occupancyWidth * occupancyHeight );
+    for ( size_t v = 0; v < occupancyHeight; v++ ) {
+      for ( size_t u = 0; u < occupancyWidth; u++ ) {
+        info.occupancy_[v * occupancyWidth + u] = occupancyMapImage.getValue( 0, u, v ) > 0 ? 1 : 0;
+      }
+    }
+    info.patches_.clear();
+    for ( const auto& patch : frame.getPatches() ) {
+      PCCMotionEstimationPatch mePatch;
+      mePatch.projectionIndex_ = patch.getNormalAxis();
+      mePatch.u0_              = patch.getU0();
+      mePatch.v0_              = patch.getV0();
+      mePatch.sizeU0_          = patch.getSizeU0();
+      mePatch.sizeV0_          = patch.getSizeV0();
+      mePatch.d1_              = patch.getD1();
+      mePatch.u1_              = patch.getU1();
+      mePatch.v1_              = patch.getV1();
+      info.patches_.push_back( mePatch );
     }
-    const size_t numPatches = patches.size();
+  }
+}
+
+void PCCEncoder::write3DMotionEstimationFiles( const PCCMotionEstimationSideInfo& sideInfo, const std::string& path ) {
+  FILE*        occupancyFile    = fopen( ( path + "occupancy.txt" ).c_str(), "wb" );
+  FILE*        patchInfoFile    = fopen( ( path + "patchInfo.txt" ).c_str(), "wb" );
+  FILE*        blockToPatchFile = fopen( ( path + "blockToPatch.txt" ).c_str(), "wb" );
+  const size_t occupancyWidth   = sideInfo.width_ / sideInfo.occupancyPrecision_;
+  for ( const auto& info : sideInfo.frames_ ) {
+    fwrite( info.blockToPatch_.data(), sizeof( size_t ), info.blockToPatch_.size(), blockToPatchFile );
+    std::vector<uint32_t> row( sideInfo.width_ );
+    for ( size_t y = 0; y < sideInfo.height_; y++ ) {
+      for ( size_t x = 0; x < sideInfo.width_; x++ ) {
+        row[x] = info.occupancy_[( y / sideInfo.occupancyPrecision_ ) * occupancyWidth +
+                                 x / sideInfo.occupancyPrecision_];
+      }
+      fwrite( row.data(), sizeof( uint32_t ), row.size(), occupancyFile );
+    }
+    const size_t numPatches = info.patches_.size();
     fwrite( &numPatches, sizeof( size_t ), 1, patchInfoFile );
-    for ( const auto& patch : patches ) {
-      size_t projectionIndex = patch.getNormalAxis();
-      size_t u0              = patch.getU0();
-      size_t v0              = patch.getV0();
-      size_t sizeU0          = patch.getSizeU0();
-      size_t sizeV0          = patch.getSizeV0();
-      size_t d1              = patch.getD1();
-      size_t u1              = patch.getU1();
-      size_t v1              = patch.getV1();
-      fwrite( &projectionIndex, sizeof( size_t ), 1, patchInfoFile );
-      fwrite( &u0, sizeof( size_t ), 1, patchInfoFile );
-      fwrite( &v0, sizeof( size_t ), 1, patchInfoFile );
-      fwrite( &sizeU0, sizeof( size_t ), 1, patchInfoFile );
-      fwrite( &sizeV0, sizeof( size_t ), 1, patchInfoFile );
-      fwrite( &d1, sizeof( size_t ), 1, patchInfoFile );
-      fwrite( &u1, sizeof( size_t ), 1, patchInfoFile );
-      fwrite( &v1, sizeof( size_t ), 1, patchInfoFile );
+    for ( const auto& patch : info.patches_ ) {
+      const size_t values[8] = {patch.projectionIndex_, patch.u0_, patch.v0_, patch.sizeU0_,
+                                patch.sizeV0_,          patch.d1_, patch.u1_, patch.v1_};
+      fwrite( values, sizeof( size_t ), 8, patchInfoFile );
     }
   }
   fclose( blockToPatchFile );
@@ -3891,26 +4252,34 @@ void PCCEncoder::generateIntraImage( PCCAtlasFrameContext& atlasFrame,
   image.resize( atlasFrame.getAtlasFrameWidth(), atlasFrame.getAtlasFrameHeight(), PCCCOLORFORMAT::YUV444 );
   image.set( 0 );
   for ( size_t ti = 0; ti < atlasFrame.getNumTilesInAtlasFrame(); ti++ ) {
-    auto&  tile     = atlasFrame.getTile( ti );
-    auto   width    = tile.getWidth();
-    auto   height   = tile.getHeight();
-    size_t maxDepth = 0;
-    for ( auto& patch : tile.getPatches() ) {
-      for ( size_t v = 0; v < patch.getSizeV(); ++v ) {
-        for ( size_t u = 0; u < patch.getSizeU(); ++u ) {
-          const size_t  p = v * patch.getSizeU() + u;
-          const int16_t d = patch.getDepth( mapIndex, p );
-          if ( d < g_infiniteDepth ) {
-            size_t x;
-            size_t y;
-            patch.patch2Canvas( u, v, width, height, x, y );
-            assert( x < width && y < height );
-            image.setValue( 0, x + tile.getLeftTopXInFrame(), y + tile.getLeftTopYInFrame(), uint16_t( d ) );
-            maxDepth = (std::max)( maxDepth, (size_t)d );
+    auto&               tile    = atlasFrame.getTile( ti );
+    auto                width   = tile.getWidth();
+    auto                height  = tile.getHeight();
+    auto&               patches = tile.getPatches();
+    std::vector<size_t> maxDepths( patches.size(), 0 );
+    // the depths of a patch only fill the blocks it occupies, which no other patch does: the patches are written in
+    // parallel
+    executionContext_->execute( [&] {
+      tbb::parallel_for( size_t( 0 ), patches.size(), [&]( const size_t patchIndex ) {
+        auto& patch = patches[patchIndex];
+        for ( size_t v = 0; v < patch.getSizeV(); ++v ) {
+          for ( size_t u = 0; u < patch.getSizeU(); ++u ) {
+            const size_t  p = v * patch.getSizeU() + u;
+            const int16_t d = patch.getDepth( mapIndex, p );
+            if ( d < g_infiniteDepth ) {
+              size_t x;
+              size_t y;
+              patch.patch2Canvas( u, v, width, height, x, y );
+              assert( x < width && y < height );
+              image.setValue( 0, x + tile.getLeftTopXInFrame(), y + tile.getLeftTopYInFrame(), uint16_t( d ) );
+              maxDepths[patchIndex] = (std::max)( maxDepths[patchIndex], (size_t)d );
+            }
           }
         }
-      }
-    }
+      } );
+    } );
+    size_t maxDepth = 0;
+    for ( const auto depth : maxDepths ) { maxDepth = (std::max)( maxDepth, depth ); }
     if ( maxDepth >= ( size_t( 1 ) << tile.getGeometry2dBitdepth() ) ) {
       std::cout << "Error: maxDepth(" << maxDepth << ") >=" << ( 1 << tile.getGeometry2dBitdepth() ) << std::endl;
       exit( -1 );
@@ -4072,10 +4441,11 @@ void PCCEncoder::generateEomPatch( const PCCPointSet3& source, PCCFrameContext&
   size_t patchCount    = frame.getPatches().size();
   size_t totalEOMCount = 0;
   std::cout << "eomPointsPatch:==============================" << std::endl;
-  for ( size_t patchIdx = 0; patchIdx < patchCount; patchIdx++ ) {
-    auto&  patch            = frame.getPatches()[patchIdx];
-    size_t eomCountPerPatch = 0;
-    totalEOMCount += patch.getEOMCount();
+  // the EOM points of each patch are counted in parallel, the patch then joins the EOM patch in patch order
+  std::vector<size_t> eomCounts( patchCount, 0 );
+  tbb::parallel_for( size_t( 0 ), patchCount, [&]( const size_t patchIdx ) {
+    const auto& patch            = frame.getPatches()[patchIdx];
+    size_t      eomCountPerPatch = 0;
     for ( size_t v = 0; v < patch.getSizeV(); ++v ) {
       for ( size_t u = 0; u < patch.getSizeU(); ++u ) {
         const size_t p       = v * patch.getSizeU() + u;
@@ -4090,11 +4460,16 @@ void PCCEncoder::generateEomPatch( const PCCPointSet3& source, PCCFrameContext&
         }
       }
     }
+    eomCounts[patchIdx] = eomCountPerPatch;
+  } );
+  for ( size_t patchIdx = 0; patchIdx < patchCount; patchIdx++ ) {
+    auto& patch = frame.getPatches()[patchIdx];
+    totalEOMCount += patch.getEOMCount();
     eomPatches[0].occupancyResolution_ = params_.occupancyResolution_;
     eomPatches[0].memberPatches_.push_back( patchIdx );
     eomPatches[0].eomCountPerPatch_.push_back( patch.getEOMCount() );
-    assert( patch.getEOMCount() == eomCountPerPatch );
-    patch.setEOMCount( eomCountPerPatch );
+    assert( patch.getEOMCount() == eomCounts[patchIdx] );
+    patch.setEOMCount( eomCounts[patchIdx] );
   }
   eomPatches[0].eomCount_ = totalEOMCount;
   std::cout << "\t::numbereOfEomPatch = 1 #point : " << totalEOMCount << std::endl;
@@ -4184,14 +4559,13 @@ void PCCEncoder::generateRawPointsPatch( const PCCPointSet3& source,
       }
     }
   }
-  PCCKdTree           kdtreeRawPoints( pointsToBeProjected );
-  PCCNNResult         result;
+  PCCKdTree                kdtreeRawPoints( pointsToBeProjected );
+  PCCNNBatchResult<double> results;
+  kdtreeRawPoints.searchBatch( source.getPositions(), 1, results );
   std::vector<size_t> rawPoints;
   rawPoints.resize( 0 );
   for ( size_t i = 0; i < source.getPointCount(); ++i ) {
-    kdtreeRawPoints.search( source[i], 1, result );
-    const double dist2 = result.dist( 0 );
-    if ( dist2 > 0.0 ) { rawPoints.push_back( i ); }
+    if ( results.neighborCount() == 0 || results.dist( i, 0 ) > 0.0 ) { rawPoints.push_back( i ); }
   }
   size_t numRawPoints = rawPoints.size();
   if ( params_.lossyRawPointsPatch_ ) {
@@ -4205,13 +4579,17 @@ void PCCEncoder::generateRawPointsPatch( const PCCPointSet3& source,
     rawPointsSet.resize( numRawPoints );
     // create raw points cloud
     for ( size_t i = 0; i < numRawPoints; ++i ) { rawPointsSet[i] = source[rawPoints[i]]; }
-    PCCKdTree kdtreeRawPointsSet( rawPointsSet );
-    for ( size_t i = 0; i < numRawPoints; ++i ) {
+    PCCKdTree            kdtreeRawPointsSet( rawPointsSet );
+    std::vector<uint8_t> selected( numRawPoints, 0 );
+    tbb::parallel_for( size_t( 0 ), numRawPoints, [&]( const size_t i ) {
       double      sumOfInverseDist = 0.0;
       PCCNNResult result;
       kdtreeRawPointsSet.searchRadius( rawPointsSet[i], maxNeighborCount, maxDist, result );
       for ( size_t j = 1; j < result.count(); ++j ) { sumOfInverseDist += 1 / result.dist( j ); }
-      if ( sumOfInverseDist >= minSumOfInvDist4RawPointsSelection ) { tmpRawPoints.push_back( rawPoints[i] ); }
+      selected[i] = static_cast<uint8_t>( sumOfInverseDist >= minSumOfInvDist4RawPointsSelection );
+    } );
+    for ( size_t i = 0; i < numRawPoints; ++i ) {
+      if ( selected[i] != 0u ) { tmpRawPoints.push_back( rawPoints[i] ); }
     }
     numRawPoints = tmpRawPoints.size();
     rawPoints.resize( numRawPoints );
@@ -4231,69 +4609,83 @@ void PCCEncoder::generateRawPointsPatch( const PCCPointSet3& source,
             << inputBbox.max_.z() << ");" << std::endl;
   PCCBox3D bboxRawPoints;
   auto     mpsBoxSize = double( 1 << params_.geometryNominal2dBitdepth_ );
-  bboxRawPoints.min_  = inputBbox.min_;
-  bboxRawPoints.max_  = inputBbox.min_;
-  bboxRawPoints.max_.x() += mpsBoxSize;
-  bboxRawPoints.max_.y() += mpsBoxSize;
-  bboxRawPoints.max_.z() += mpsBoxSize;
-  bool   isEmptyBox               = true;
+  // bucket the raw points by box in a single pass instead of scanning all of them for every box: the boxes are
+  // visited in the x, y, z scan order and each bucket keeps the raw point order.
+  const size_t boxCountX = inputBbox.max_.x() < 0 ? 0 : size_t( inputBbox.max_.x() / mpsBoxSize ) + 1;
+  const size_t boxCountY = inputBbox.max_.y() < 0 ? 0 : size_t( inputBbox.max_.y() / mpsBoxSize ) + 1;
+  const size_t boxCountZ = inputBbox.max_.z() < 0 ? 0 : size_t( inputBbox.max_.z() / mpsBoxSize ) + 1;
+  const size_t boxCount  = boxCountX * boxCountY * boxCountZ;
+  std::vector<size_t> boxOfRawPoint( rawPoints.size(), boxCount );
+  std::vector<size_t> boxStart( boxCount + 1, 0 );
+  for ( size_t i = 0; i < rawPoints.size(); ++i ) {
+    const PCCPoint3D& pt = source[rawPoints[i]];
+    if ( pt[0] < 0 || pt[1] < 0 || pt[2] < 0 ) { continue; }
+    const size_t bx = size_t( pt[0] / mpsBoxSize );
+    const size_t by = size_t( pt[1] / mpsBoxSize );
+    const size_t bz = size_t( pt[2] / mpsBoxSize );
+    if ( bx < boxCountX && by < boxCountY && bz < boxCountZ ) {
+      boxOfRawPoint[i] = ( bx * boxCountY + by ) * boxCountZ + bz;
+      boxStart[boxOfRawPoint[i] + 1]++;
+    }
+  }
+  for ( size_t b = 0; b < boxCount; ++b ) { boxStart[b + 1] += boxStart[b]; }
+  std::vector<size_t> rawPointsByBox( boxStart[boxCount] );
+  {
+    std::vector<size_t> cursor( boxStart.begin(), boxStart.end() - 1 );
+    for ( size_t i = 0; i < rawPoints.size(); ++i ) {
+      if ( boxOfRawPoint[i] < boxCount ) { rawPointsByBox[cursor[boxOfRawPoint[i]]++] = rawPoints[i]; }
+    }
+  }
   size_t numberOfRawPointsPatches = 0;
-  for ( bboxRawPoints.min_.x() = inputBbox.min_.x(); bboxRawPoints.min_.x() <= inputBbox.max_.x();
-        bboxRawPoints.min_.x() += mpsBoxSize ) {
+  for ( size_t box = 0; box < boxCount; ++box ) {
+    if ( boxStart[box] == boxStart[box + 1] ) { continue; }
+    bboxRawPoints.min_.x() = inputBbox.min_.x() + double( box / ( boxCountY * boxCountZ ) ) * mpsBoxSize;
+    bboxRawPoints.min_.y() = inputBbox.min_.y() + double( ( box / boxCountZ ) % boxCountY ) * mpsBoxSize;
+    bboxRawPoints.min_.z() = inputBbox.min_.z() + double( box % boxCountZ ) * mpsBoxSize;
     bboxRawPoints.max_.x() = bboxRawPoints.min_.x() + ( mpsBoxSize - 1 );
-    for ( bboxRawPoints.min_.y() = inputBbox.min_.y(); bboxRawPoints.min_.y() <= inputBbox.max_.y();
-          bboxRawPoints.min_.y() += mpsBoxSize ) {
-      bboxRawPoints.max_.y() = bboxRawPoints.min_.y() + ( mpsBoxSize - 1 );
-      for ( bboxRawPoints.min_.z() = inputBbox.min_.z(); bboxRawPoints.min_.z() <= inputBbox.max_.z();
-            bboxRawPoints.min_.z() += mpsBoxSize ) {
-        bboxRawPoints.max_.z() = bboxRawPoints.min_.z() + ( mpsBoxSize - 1 );
-        isEmptyBox             = source.isRawPointsBboxEmpty( rawPoints, bboxRawPoints );
-        if ( !isEmptyBox ) {
-          std::cout << "Box = ( " << bboxRawPoints.min_.x() << ", " << bboxRawPoints.min_.y() << ", "
-                    << bboxRawPoints.min_.z() << ") ~ (" << bboxRawPoints.max_.x() << ", " << bboxRawPoints.max_.y()
-                    << ", " << bboxRawPoints.max_.z() << ") " << std::endl;
-          numberOfRawPointsPatches++;
-          auto&             mpsPatches = frame.getRawPointsPatches();
-          PCCRawPointsPatch rawPointsPatch;
-          rawPointsPatch.frameIndex_ = frame.getFrameIndex();
-          std::vector<size_t> rawPointsBBox;
-          source.fillRawPointsBbox( rawPoints, bboxRawPoints, rawPointsBBox );
-          const size_t numRawPointsBBox = rawPointsBBox.size();
-          frame.getNumberOfRawPoints().resize( numberOfRawPointsPatches );
-          frame.setNumberOfRawPoints( numberOfRawPointsPatches - 1, numRawPointsBBox );
-          rawPointsPatch.occupancyResolution_ = params_.occupancyResolution_;
-          rawPointsPatch.isPatchInAuxVideo_   = params_.useRawPointsSeparateVideo_;
-          rawPointsPatch.sizeU_               = 0;
-          rawPointsPatch.sizeV_               = 0;
-          rawPointsPatch.u0_                  = 0;
-          rawPointsPatch.v0_                  = 0;
-          rawPointsPatch.sizeV0_              = 0;
-          rawPointsPatch.sizeU0_              = 0;
-          rawPointsPatch.u1_                  = size_t( bboxRawPoints.min_.x() );
-          rawPointsPatch.v1_                  = size_t( bboxRawPoints.min_.y() );
-          rawPointsPatch.d1_                  = size_t( bboxRawPoints.min_.z() );
-          rawPointsPatch.occupancy_.resize( 0 );
-          rawPointsPatch.setNumberOfRawPoints( numRawPointsBBox );
-          rawPointsPatch.resize( 3 * numRawPointsBBox );
-          for ( auto i = 0; i < numRawPointsBBox; ++i ) {
-            const PCCPoint3D rawPoints                  = source[rawPointsBBox[i]];
-            rawPointsPatch.x_[i]                        = static_cast<uint16_t>( rawPoints.x() - rawPointsPatch.u1_ );
-            rawPointsPatch.x_[numRawPointsBBox + i]     = static_cast<uint16_t>( rawPoints.y() - rawPointsPatch.v1_ );
-            rawPointsPatch.x_[2 * numRawPointsBBox + i] = static_cast<uint16_t>( rawPoints.z() - rawPointsPatch.d1_ );
-            rawPointsPatch.y_[i]                        = infiniteValue;
-            rawPointsPatch.y_[numRawPointsBBox + i]     = infiniteValue;
-            rawPointsPatch.y_[2 * numRawPointsBBox + i] = infiniteValue;
-            rawPointsPatch.z_[i]                        = infiniteValue;
-            rawPointsPatch.z_[numRawPointsBBox + i]     = infiniteValue;
-            rawPointsPatch.z_[2 * numRawPointsBBox + i] = infiniteValue;
-          }
-          mpsPatches.push_back( rawPointsPatch );
-          std::cout << "\t::numberOfRawPointsPatches = " << frame.getNumberOfRawPointsPatches()
-                    << " #point : " << rawPointsPatch.getNumberOfRawPoints()
-                    << " #pixels: " << rawPointsPatch.getNumberOfRawPoints() * 3 << std::endl;
-        }  // not empty
-      }
-    }
+    bboxRawPoints.max_.y() = bboxRawPoints.min_.y() + ( mpsBoxSize - 1 );
+    bboxRawPoints.max_.z() = bboxRawPoints.min_.z() + ( mpsBoxSize - 1 );
+    std::cout << "Box = ( " << bboxRawPoints.min_.x() << ", " << bboxRawPoints.min_.y() << ", "
+              << bboxRawPoints.min_.z() << ") ~ (" << bboxRawPoints.max_.x() << ", " << bboxRawPoints.max_.y() << ", "
+              << bboxRawPoints.max_.z() << ") " << std::endl;
+    numberOfRawPointsPatches++;
+    auto&             mpsPatches = frame.getRawPointsPatches();
+    PCCRawPointsPatch rawPointsPatch;
+    rawPointsPatch.frameIndex_ = frame.getFrameIndex();
+    const size_t* rawPointsBBox    = rawPointsByBox.data() + boxStart[box];
+    const size_t  numRawPointsBBox = boxStart[box + 1] - boxStart[box];
+    frame.getNumberOfRawPoints().resize( numberOfRawPointsPatches );
+    frame.setNumberOfRawPoints( numberOfRawPointsPatches - 1, numRawPointsBBox );
+    rawPointsPatch.occupancyResolution_ = params_.occupancyResolution_;
+    rawPointsPatch.isPatchInAuxVideo_   = params_.useRawPointsSeparateVideo_;
+    rawPointsPatch.sizeU_               = 0;
+    rawPointsPatch.sizeV_               = 0;
+    rawPointsPatch.u0_                  = 0;
+    rawPointsPatch.v0_                  = 0;
+    rawPointsPatch.sizeV0_              = 0;
+    rawPointsPatch.sizeU0_              = 0;
+    rawPointsPatch.u1_                  = size_t( bboxRawPoints.min_.x() );
+    rawPointsPatch.v1_                  = size_t( bboxRawPoints.min_.y() );
+    rawPointsPatch.d1_                  = size_t( bboxRawPoints.min_.z() );
+    rawPointsPatch.occupancy_.resize( 0 );
+    rawPointsPatch.setNumberOfRawPoints( numRawPointsBBox );
+    rawPointsPatch.resize( 3 * numRawPointsBBox );
+    for ( size_t i = 0; i < numRawPointsBBox; ++i ) {
+      const PCCPoint3D rawPoints                  = source[rawPointsBBox[i]];
+      rawPointsPatch.x_[i]                        = static_cast<uint16_t>( rawPoints.x() - rawPointsPatch.u1_ );
+      rawPointsPatch.x_[numRawPointsBBox + i]     = static_cast<uint16_t>( rawPoints.y() - rawPointsPatch.v1_ );
+      rawPointsPatch.x_[2 * numRawPointsBBox + i] = static_cast<uint16_t>( rawPoints.z() - rawPointsPatch.d1_ );
+      rawPointsPatch.y_[i]                        = infiniteValue;
+      rawPointsPatch.y_[numRawPointsBBox + i]     = infiniteValue;
+      rawPointsPatch.y_[2 * numRawPointsBBox + i] = infiniteValue;
+      rawPointsPatch.z_[i]                        = infiniteValue;
+      rawPointsPatch.z_[numRawPointsBBox + i]     = infiniteValue;
+      rawPointsPatch.z_[2 * numRawPointsBBox + i] = infiniteValue;
+    }
+    mpsPatches.push_back( rawPointsPatch );
+    std::cout << "\t::numberOfRawPointsPatches = " << frame.getNumberOfRawPointsPatches()
+              << " #point : " << rawPointsPatch.getNumberOfRawPoints()
+              << " #pixels: " << rawPointsPatch.getNumberOfRawPoints() * 3 << std::endl;
   }
 }
 
@@ -4307,17 +4699,31 @@ void PCCEncoder::sortRawPointsPatchMorton( PCCFrameContext& frame, size_t index
       rawPointsSet[i] = PCCPoint3D( rawPointsPatch.x_[i], rawPointsPatch.x_[i + numRawPoints],
                                     rawPointsPatch.x_[i + numRawPoints * 2] );
     }
-    // calc Morton code of rawPointsSet
-    std::vector<std::pair<uint64_t, PCCPoint3D>> mortonPoint;
-    mortonPoint.resize( numRawPoints );
+    // calc Morton code of rawPointsSet, x in the highest bit of each triplet as the raw points have always been sorted
+    std::vector<uint64_t> mortonCodes( numRawPoints );
+    uint64_t              usedBits = 0;
     for ( size_t i = 0; i < numRawPoints; ++i ) {
-      mortonPoint[i].first  = mortonAddr( rawPointsSet[i], 0 );
-      mortonPoint[i].second = rawPointsSet[i];
+      const PCCPoint3D& point = rawPointsSet[i];
+      mortonCodes[i]          = mortonEncode( uint32_t( point.z() ), uint32_t( point.y() ), uint32_t( point.x() ) );
+      usedBits |= mortonCodes[i];
+    }
+    // sort points according to their Morton codes: LSD radix sort, one byte per pass and only over the bytes the
+    // codes use. A code identifies a position, so equal codes are equal points and the order is the one of a
+    // comparison sort on ( code, point ).
+    std::vector<size_t> order( numRawPoints );
+    std::vector<size_t> sorted( numRawPoints );
+    for ( size_t i = 0; i < numRawPoints; ++i ) { order[i] = i; }
+    for ( size_t shift = 0; shift < 64 && ( usedBits >> shift ) != 0u; shift += 8 ) {
+      size_t bucketStart[257] = {0};
+      for ( size_t i = 0; i < numRawPoints; ++i ) { bucketStart[( ( mortonCodes[i] >> shift ) & 0xFF ) + 1]++; }
+      for ( size_t b = 0; b < 256; ++b ) { bucketStart[b + 1] += bucketStart[b]; }
+      for ( size_t i = 0; i < numRawPoints; ++i ) {
+        sorted[bucketStart[( mortonCodes[order[i]] >> shift ) & 0xFF]++] = order[i];
+      }
+      order.swap( sorted );
     }
-    // sort points according to their Morton codes
-    std::sort( mortonPoint.begin(), mortonPoint.end() );
     for ( size_t i = 0; i < numRawPoints; ++i ) {
-      const PCCPoint3D rawPoints              = mortonPoint[i].second;
+      const PCCPoint3D rawPoints              = rawPointsSet[order[i]];
       rawPointsPatch.x_[i]                    = static_cast<uint16_t>( rawPoints.x() );
       rawPointsPatch.x_[i + numRawPoints]     = static_cast<uint16_t>( rawPoints.y() );
       rawPointsPatch.x_[i + numRawPoints * 2] = static_cast<uint16_t>( rawPoints.z() );
@@ -4512,7 +4918,8 @@ void PCCEncoder::generateRawPointsAttributeVideo( PCCContext& context ) {
   cout << "RawPoints Attribute [done]" << endl;
 }
 void PCCEncoder::generateRawPointsGeometryImage( PCCContext& context, PCCFrameContext& tile, PCCImageGeometry& image ) {
-  size_t numberOfRawPointsPatches = tile.getNumberOfRawPointsPatches();
+  size_t       numberOfRawPointsPatches = tile.getNumberOfRawPointsPatches();
+  const size_t auxTileLeftTopY          = context[tile.getFrameIndex()].getAuxTileLeftTopY( tile.getTileIndex() );
   for ( int i = 0; i < numberOfRawPointsPatches; i++ ) {
     auto&        rawPointsPatch    = tile.getRawPointsPatch( i );
     const size_t v0                = rawPointsPatch.v0_ * rawPointsPatch.occupancyResolution_;
@@ -4522,41 +4929,30 @@ void PCCEncoder::generateRawPointsGeometryImage( PCCContext& context, PCCFrameCo
             rawPointsPatch.sizeU_, rawPointsPatch.sizeV_ );
     rawPointsPatch.isPatchInAuxVideo_ = true;
     numberOfRawPoints *= 3;
-    uint16_t lastValue = rawPointsPatch.x_[numberOfRawPoints - 1];
     if ( rawPointsPatch.getNumberOfRawPoints() != 0u ) {
-      for ( size_t v = 0; v < rawPointsPatch.sizeV_; ++v ) {
+      const uint16_t lastValue = rawPointsPatch.x_[numberOfRawPoints - 1];
+      // the patches cover disjoint blocks of the auxiliary video, the rows of a patch are written in parallel
+      tbb::parallel_for( size_t( 0 ), rawPointsPatch.sizeV_, [&]( const size_t v ) {
+        const size_t y = ( v0 + v ) + auxTileLeftTopY;
         for ( size_t u = 0; u < rawPointsPatch.sizeU_; ++u ) {
           const size_t p = v * rawPointsPatch.sizeU_ + u;
+          const size_t x = ( u0 + u );  // always starts at 0
+          assert( x < context[tile.getFrameIndex()].getAuxVideoWidth() &&
+                  y < context[tile.getFrameIndex()].getAuxVideoHeight() );
+          if ( !( x < image.getWidth() && y < image.getHeight() ) ) {
+            printf( "ERROR: X and y outside the picture: ( %zu, %zu) / ( %zu, %zu) \n", x, y, image.getWidth(),
+                    image.getHeight() );
+            fflush( stdout );
+            exit( 19 );
+          }
           if ( p < numberOfRawPoints && rawPointsPatch.x_[p] < g_infiniteDepth ) {
-            const size_t x = ( u0 + u );  // always starts at 0
-            const size_t y = ( v0 + v ) + context[tile.getFrameIndex()].getAuxTileLeftTopY( tile.getTileIndex() );
-            assert( x < context[tile.getFrameIndex()].getAuxVideoWidth() &&
-                    y < context[tile.getFrameIndex()].getAuxVideoHeight() );
-            assert( x < image.getWidth() && y < image.getHeight() );
-            if ( !( x < image.getWidth() && y < image.getHeight() ) ) {
-              printf( "ERROR: X and y outside the picture: ( %zu, %zu) / ( %zu, %zu) (then) \n", x, y, image.getWidth(),
-                      image.getHeight() );
-              fflush( stdout );
-              exit( 19 );
-            } else {
-              image.setValue( 0, x, y, uint16_t( rawPointsPatch.x_[p] ) );
-            }
+            image.setValue( 0, x, y, uint16_t( rawPointsPatch.x_[p] ) );
           } else {
-            const size_t x = ( u0 + u );
-            const size_t y = ( v0 + v ) + context[tile.getFrameIndex()].getAuxTileLeftTopY( tile.getTileIndex() );
-            assert( x < image.getWidth() && y < image.getHeight() );
-            if ( !( x < image.getWidth() && y < image.getHeight() ) ) {
-              printf( "ERROR: X and y outside the picture: ( %zu, %zu) / ( %zu, %zu) (else) \n", x, y, image.getWidth(),
-                      image.getHeight() );
-              fflush( stdout );
-              exit( 19 );
-            } else {
-              image.setValue( 0, x, y, static_cast<uint16_t>( lastValue ) );
-            }
+            image.setValue( 0, x, y, lastValue );
           }
         }  // u
-      }    // v
-    }      // size()!=0
+      } );  // v
+    }       // size()!=0
   }
 }
 
@@ -4569,31 +4965,30 @@ void PCCEncoder::generateRawPointsAttributeImage( PCCContext&        context,
   size_t numberOfRawPoints        = tile.getTotalNumberOfRawPoints();
   size_t width                    = context[tile.getFrameIndex()].getAuxVideoWidth();
   if ( numberOfRawPoints != 0 ) {
-    size_t imageWidthInBlock = width / params_.occupancyResolution_;
-    int    rawPatchOffset    = 0;
+    const size_t             auxTileLeftTopY = context[tile.getFrameIndex()].getAuxTileLeftTopY( tile.getTileIndex() );
+    std::vector<PCCColor3B>& rawAttributes   = tile.getRawPointsAttribute();
+    size_t                   rawPatchOffset  = 0;
     for ( int i = 0; i < numberOfRawPointsPatches; i++ ) {
-      int    pointIndex        = 0;
-      auto&  rawPointsPatch    = tile.getRawPointsPatch( i );
-      size_t numRawColorPoints = rawPointsPatch.getNumberOfRawPoints();
+      auto&        rawPointsPatch    = tile.getRawPointsPatch( i );
+      const size_t numRawColorPoints = rawPointsPatch.getNumberOfRawPoints();
       printf( "\tgenerateRawPointsAttributeImage:: (u0,v0) %zu,%zu, (sizeU,sizeU) %zux%zu\n", rawPointsPatch.u0_,
               rawPointsPatch.v0_, rawPointsPatch.sizeU_, rawPointsPatch.sizeV_ );
-      const size_t             v0            = rawPointsPatch.v0_ * rawPointsPatch.occupancyResolution_;
-      const size_t             u0            = rawPointsPatch.u0_ * rawPointsPatch.occupancyResolution_;
-      std::vector<PCCColor3B>& rawAttributes = tile.getRawPointsAttribute();
-      for ( size_t v = 0; v < rawPointsPatch.sizeV_; ++v ) {
-        for ( size_t u = 0; u < rawPointsPatch.sizeU_; ++u ) {
-          const size_t x = ( u0 + u );
-          const size_t y = ( v0 + v ) + context[tile.getFrameIndex()].getAuxTileLeftTopY( tile.getTileIndex() );
-          if ( pointIndex < numRawColorPoints ) {
-            image.setValue( 0, x, y, uint16_t( rawAttributes[rawPatchOffset + pointIndex].r() ) );
-            image.setValue( 1, x, y, uint16_t( rawAttributes[rawPatchOffset + pointIndex].g() ) );
-            image.setValue( 2, x, y, uint16_t( rawAttributes[rawPatchOffset + pointIndex].b() ) );
-            pointIndex++;
-          } else {
-            break;
-          }
+      const size_t v0    = rawPointsPatch.v0_ * rawPointsPatch.occupancyResolution_;
+      const size_t u0    = rawPointsPatch.u0_ * rawPointsPatch.occupancyResolution_;
+      const size_t sizeU = rawPointsPatch.sizeU_;
+      // the colors fill the patch in raster order, the rows holding them are written in parallel
+      const size_t rowCount =
+          sizeU == 0 ? 0 : ( std::min )( rawPointsPatch.sizeV_, ( numRawColorPoints + sizeU - 1 ) / sizeU );
+      tbb::parallel_for( size_t( 0 ), rowCount, [&]( const size_t v ) {
+        const size_t y = ( v0 + v ) + auxTileLeftTopY;
+        for ( size_t u = 0; u < sizeU && v * sizeU + u < numRawColorPoints; ++u ) {
+          const size_t      x     = ( u0 + u );
+          const PCCColor3B& color = rawAttributes[rawPatchOffset + v * sizeU + u];
+          image.setValue( 0, x, y, uint16_t( color.r() ) );
+          image.setValue( 1, x, y, uint16_t( color.g() ) );
+          image.setValue( 2, x, y, uint16_t( color.b() ) );
         }
-      }
+      } );
       rawPatchOffset += numRawColorPoints;
     }  // numberOfRawPointsPatches
     assert( numberOfRawPoints == rawPatchOffset );
@@ -4630,6 +5025,7 @@ void PCCEncoder::generateRawPointsAttributeImage( PCCContext&        context,
 }
 
 bool PCCEncoder::generateSegments( const PCCGroupOfFrames& sources, PCCContext& context ) {
+  PCC_PROFILE_ZONE( "segmentation" );
   PCCPatchSegmenter3Parameters params;
   bool                         res            = true;
   auto&                        frames         = context.getFrames();
@@ -4637,6 +5033,9 @@ bool PCCEncoder::generateSegments( const PCCGroupOfFrames& sources, PCCContext&
   params.voxelDimensionGridBasedSegmentation_ = params_.voxelDimensionGridBasedSegmentation_;
   params.nnNormalEstimation_                  = params_.nnNormalEstimation_;
   params.normalOrientation_                   = params_.normalOrientation_;
+  params.maxFitErrorTemporalNormals_          = params_.maxFitErrorTemporalNormals_;
+  params.maxDist2TemporalNormals_             = params_.maxDist2TemporalNormals_;
+  params.deviceSegmentation_                  = params_.deviceSegmentation_;
   params.gridBasedRefineSegmentation_         = params_.gridBasedRefineSegmentation_;
   params.maxNNCountRefineSegmentation_        = params_.maxNNCountRefineSegmentation_;
   params.iterationCountRefineSegmentation_    = params_.iterationCountRefineSegmentation_;
@@ -4683,12 +5082,15 @@ bool PCCEncoder::generateSegments( const PCCGroupOfFrames& sources, PCCContext&
   params.numCutsAlong3rdLongestAxis_   = params_.numCutsAlong3rdLongestAxis_;
   params.createSubPointCloud_          = params_.pointLocalReconstruction_ || params_.singleMapPixelInterleaving_;
   if ( params_.additionalProjectionPlaneMode_ == 0 || params_.additionalProjectionPlaneMode_ == 5 ) {
-    params.weightNormal_ = calculateWeightNormal( params.geometryBitDepth3D_, sources[0] );
+    params.weightNormal_ = calculateWeightNormal( params.geometryBitDepth3D_, sources.acquire( 0 ) );
+    sources.release( 0 );
   }
   float sumDistanceSrcRec = 0;
   for ( size_t i = 0; i < frames.size(); i++ ) {
-    float distanceSrcRec = 0;
-    if ( !generateSegments( sources[i], frames[i], params, i, distanceSrcRec ) ) {
+    float      distanceSrcRec = 0;
+    const bool segmented      = generateSegments( sources.acquire( i ), frames[i], params, i, distanceSrcRec );
+    sources.release( i );
+    if ( !segmented ) {
       res = false;
       break;
     }
@@ -4706,16 +5108,22 @@ bool PCCEncoder::generateSegments( const PCCGroupOfFrames& sources, PCCContext&
 }
 
 bool PCCEncoder::placeSegments( const PCCGroupOfFrames& sources, PCCContext& context ) {
+  PCC_PROFILE_ZONE( "packing" );
   bool res = true;
   if ( params_.tileSegmentationType_ == 1 ) {
     generateTilesFromImage( context );
   } else {
     if ( params_.numMaxTilePerFrame_ > 1 ) { generateTilesFromSegments( context ); }
+    // checked once for all the tiles, the frames of a windowed group being read again for each check
+    for ( size_t frameIndex = 0; frameIndex < context.size(); frameIndex++ ) {
+      const bool empty = sources.acquire( frameIndex ).getPointCount() == 0u;
+      sources.release( frameIndex );
+      if ( empty ) { return false; }
+    }
     for ( size_t tileIdx = 0; tileIdx < params_.numMaxTilePerFrame_; tileIdx++ ) {
       size_t initTileWidth  = context.getFrame( 0 ).getTile( tileIdx ).getWidth();
       size_t initTileHeight = context.getFrame( 0 ).getTile( tileIdx ).getHeight();
       for ( size_t frameIndex = 0; frameIndex < context.size(); frameIndex++ ) {
-        if ( sources[frameIndex].getPointCount() == 0u ) { return false; }
         auto&  tile       = context.getFrame( frameIndex ).getTile( tileIdx );
         size_t tileWidth  = tile.getWidth();
         size_t tileHeight = tile.getHeight();
@@ -5338,121 +5746,134 @@ void PCCEncoder::pointLocalReconstructionSearch( PCCContext&
   size_t       nbOfOptimizationMode = context.getPointLocalReconstructionModeNumber();
   const size_t imageWidth           = videoMultiple[0].getWidth();
   const size_t imageHeight          = videoMultiple[0].getHeight();
-  for ( size_t patchIndex = 0; patchIndex < patchCount; ++patchIndex ) {
-    const size_t  patchIndexPlusOne = patchIndex + 1;
-    auto&         patch             = patches[patchIndex];
-    const size_t& patchSize         = patch.getSizeU0() * patch.getSizeV0();
-    if ( patchSize == 1 || patchSize <= params_.patchSize_ ) {
-      patch.getPointLocalReconstructionLevel()     = 1;
-      auto&                     srcPointCloudPatch = frame.getSrcPointCloudByPatch( patch.getOriginalIndex() );
-      std::vector<PCCPointSet3> reconstruct;
-      std::vector<float>        distance;
-      reconstruct.resize( nbOfOptimizationMode );
-      distance.resize( nbOfOptimizationMode );
-      size_t optimizationIndex    = 0;
-      size_t optimizationIndexMin = 0;
-      for ( size_t i = 0; i < nbOfOptimizationMode; i++ ) {
-        auto& mode = context.getPointLocalReconstructionMode( i );
-        for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
-          for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
-            const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
-            if ( blockToPatch[blockIndex] == patchIndexPlusOne ) {
-              for ( size_t v1 = 0; v1 < patch.getOccupancyResolution(); ++v1 ) {
-                const size_t v = v0 * patch.getOccupancyResolution() + v1;
-                for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
-                  const size_t u = u0 * patch.getOccupancyResolution() + u1;
-                  size_t       x;
-                  size_t       y;
-                  const bool   occupancy = occupancyMap[patch.patch2Canvas( u, v, imageWidth, imageHeight, x, y )] != 0;
-                  if ( !occupancy ) { continue; }
-                  auto createdPoints = generatePoints( params, frame, videoMultiple, frameIndex, patchIndex, u, v, x, y,
-                                                       mode.interpolate_, mode.filling_, mode.minD1_, mode.neighbor_ );
-                  if ( !createdPoints.empty() ) {
-                    for ( const auto& createdPoint : createdPoints ) {
-                      reconstruct[optimizationIndex].addPoint( createdPoint );
+  // The patches, and the blocks of a patch, are searched in parallel: each task reconstructs the candidate modes into
+  // its own point sets and writes the modes of its own patch or block only. The modes are tried in order and a mode
+  // must be strictly better to replace the current one, so stopping at the first mode within plrEarlyTerminationDist_
+  // changes nothing at its default of 0.
+  const double earlyTerminationDist = params_.plrEarlyTerminationDist_;
+  typedef std::function<void( size_t, PCCArenaVector<PCCPoint3D>&, PCCPointSet3& )> ModeReconstruction;
+  auto searchModes = [&]( const PCCPointSet3& srcPointCloud, const ModeReconstruction& reconstruct ) {
+    auto&                      arena = getThreadArena();
+    PCCArenaScope              scope( arena );
+    PCCArenaVector<PCCPoint3D> createdPoints{PCCArenaAllocator<PCCPoint3D>( arena )};
+    size_t                     optimizationIndexMin = 0;
+    float                      distanceMin          = 0.F;
+    for ( size_t i = 0; i < nbOfOptimizationMode; i++ ) {
+      PCCPointSet3 reconstructed;
+      reconstruct( i, createdPoints, reconstructed );
+      float distancePSrcRec;
+      float distancePRecSrc;
+      srcPointCloud.distanceGeo( reconstructed, distancePSrcRec, distancePRecSrc );
+      const float distance = ( std::max )( distancePSrcRec, distancePRecSrc );
+      if ( i == 0 || distanceMin > distance ) {
+        optimizationIndexMin = i;
+        distanceMin          = distance;
+      }
+      if ( distanceMin <= earlyTerminationDist ) { break; }
+    }
+    return optimizationIndexMin;
+  };
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), patchCount, [&]( const size_t patchIndex ) {
+      const size_t  patchIndexPlusOne  = patchIndex + 1;
+      auto&         patch              = patches[patchIndex];
+      const size_t& patchSize          = patch.getSizeU0() * patch.getSizeV0();
+      auto&         srcPointCloudPatch = frame.getSrcPointCloudByPatch( patch.getOriginalIndex() );
+      if ( patchSize == 1 || patchSize <= params_.patchSize_ ) {
+        patch.getPointLocalReconstructionLevel() = 1;
+        const size_t bestMode                    = searchModes(
+            srcPointCloudPatch,
+            [&]( const size_t i, PCCArenaVector<PCCPoint3D>& createdPoints, PCCPointSet3& reconstruct ) {
+              auto& mode = context.getPointLocalReconstructionMode( i );
+              for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
+                for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
+                  const size_t blockIndex =
+                      patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
+                  if ( blockToPatch[blockIndex] == patchIndexPlusOne ) {
+                    for ( size_t v1 = 0; v1 < patch.getOccupancyResolution(); ++v1 ) {
+                      const size_t v = v0 * patch.getOccupancyResolution() + v1;
+                      for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
+                        const size_t u = u0 * patch.getOccupancyResolution() + u1;
+                        size_t       x;
+                        size_t       y;
+                        const bool   occupancy =
+                            occupancyMap[patch.patch2Canvas( u, v, imageWidth, imageHeight, x, y )] != 0;
+                        if ( !occupancy ) { continue; }
+                        generatePoints( createdPoints, params, frame, videoMultiple, frameIndex, patchIndex, u, v, x,
+                                        y, mode.interpolate_, mode.filling_, mode.minD1_, mode.neighbor_ );
+                        for ( const auto& createdPoint : createdPoints ) { reconstruct.addPoint( createdPoint ); }
+                      }
                     }
                   }
                 }
               }
-            }
+            } );
+        patch.setPointLocalReconstructionMode( bestMode );
+      } else {
+        patch.getPointLocalReconstructionLevel() = 0;
+        // source points of each block, in the patch order, bucketed once instead of filtered for every block
+        const size_t        res = patch.getOccupancyResolution();
+        std::vector<size_t> blockOfPoint( srcPointCloudPatch.getPointCount(), patchSize );
+        std::vector<size_t> blockStart( patchSize + 1, 0 );
+        for ( size_t i = 0; i < srcPointCloudPatch.getPointCount(); i++ ) {
+          const int64_t t = int64_t( srcPointCloudPatch[i][patch.getTangentAxis()] ) - int64_t( patch.getU1() );
+          const int64_t b = int64_t( srcPointCloudPatch[i][patch.getBitangentAxis()] ) - int64_t( patch.getV1() );
+          if ( t < 0 || b < 0 || size_t( t ) / res >= patch.getSizeU0() || size_t( b ) / res >= patch.getSizeV0() ) {
+            continue;
+          }
+          blockOfPoint[i] = ( size_t( b ) / res ) * patch.getSizeU0() + size_t( t ) / res;
+          blockStart[blockOfPoint[i] + 1]++;
+        }
+        for ( size_t i = 0; i < patchSize; i++ ) { blockStart[i + 1] += blockStart[i]; }
+        std::vector<size_t> pointsByBlock( blockStart[patchSize] );
+        {
+          std::vector<size_t> cursor( blockStart.begin(), blockStart.end() - 1 );
+          for ( size_t i = 0; i < blockOfPoint.size(); i++ ) {
+            if ( blockOfPoint[i] < patchSize ) { pointsByBlock[cursor[blockOfPoint[i]]++] = i; }
           }
         }
-        float distancePSrcRec;
-        float distancePRecSrc;
-        srcPointCloudPatch.distanceGeo( reconstruct[optimizationIndex], distancePSrcRec, distancePRecSrc );
-        distance[optimizationIndex] = (std::max)( distancePSrcRec, distancePRecSrc );
-        if ( optimizationIndex == 0 || distance[optimizationIndexMin] > distance[optimizationIndex] ) {
-          optimizationIndexMin = optimizationIndex;
-          patch.setPointLocalReconstructionMode( optimizationIndexMin );
-        }
-        optimizationIndex++;
-      }
-    } else {
-      patch.getPointLocalReconstructionLevel() = 0;
-      for ( size_t v0 = 0; v0 < patch.getSizeV0(); ++v0 ) {
-        for ( size_t u0 = 0; u0 < patch.getSizeU0(); ++u0 ) {
+        tbb::parallel_for( size_t( 0 ), patchSize, [&]( const size_t block ) {
+          const size_t u0 = block % patch.getSizeU0();
+          const size_t v0 = block / patch.getSizeU0();
           patch.setPointLocalReconstructionMode( u0, v0, 0 );
           const size_t blockIndex = patch.patchBlock2CanvasBlock( u0, v0, blockToPatchWidth, blockToPatchHeight );
-          if ( blockToPatch[blockIndex] == patchIndexPlusOne ) {
-            auto&        srcPointCloudPatch = frame.getSrcPointCloudByPatch( patch.getOriginalIndex() );
-            PCCPointSet3 blockSrcPointCloud;
-            const size_t xMin = u0 * patch.getOccupancyResolution() + patch.getU1();
-            const size_t yMin = v0 * patch.getOccupancyResolution() + patch.getV1();
-            for ( size_t i = 0; i < srcPointCloudPatch.getPointCount(); i++ ) {
-              if ( xMin <= srcPointCloudPatch[i][patch.getTangentAxis()] &&
-                   srcPointCloudPatch[i][patch.getTangentAxis()] < xMin + patch.getOccupancyResolution() &&
-                   yMin <= srcPointCloudPatch[i][patch.getBitangentAxis()] &&
-                   srcPointCloudPatch[i][patch.getBitangentAxis()] < yMin + patch.getOccupancyResolution() ) {
-                blockSrcPointCloud.addPoint( srcPointCloudPatch[i] );
-              }
-            }
-            std::vector<PCCPointSet3> reconstruct;
-            std::vector<float>        distance;
-            reconstruct.resize( nbOfOptimizationMode );
-            distance.resize( nbOfOptimizationMode );
-            size_t optimizationIndex    = 0;
-            size_t optimizationIndexMin = 0;
-            for ( size_t i = 0; i < nbOfOptimizationMode; i++ ) {
-              auto& mode = context.getPointLocalReconstructionMode( i );
-              for ( size_t v1 = 0; v1 < patch.getOccupancyResolution(); ++v1 ) {
-                const size_t v = v0 * patch.getOccupancyResolution() + v1;
-                for ( size_t u1 = 0; u1 < patch.getOccupancyResolution(); ++u1 ) {
-                  const size_t u = u0 * patch.getOccupancyResolution() + u1;
-                  size_t       x;
-                  size_t       y;
-                  const bool   occupancy = occupancyMap[patch.patch2Canvas( u, v, imageWidth, imageHeight, x, y )] != 0;
-                  if ( !occupancy ) { continue; }
-                  auto createdPoints = generatePoints( params, frame, videoMultiple, frameIndex, patchIndex, u, v, x, y,
-                                                       mode.interpolate_, mode.filling_, mode.minD1_, mode.neighbor_ );
-                  if ( !createdPoints.empty() ) {
+          if ( blockToPatch[blockIndex] != patchIndexPlusOne ) { return; }
+          PCCPointSet3 blockSrcPointCloud;
+          for ( size_t i = blockStart[block]; i < blockStart[block + 1]; i++ ) {
+            blockSrcPointCloud.addPoint( srcPointCloudPatch[pointsByBlock[i]] );
+          }
+          const size_t bestMode = searchModes(
+              blockSrcPointCloud,
+              [&]( const size_t i, PCCArenaVector<PCCPoint3D>& createdPoints, PCCPointSet3& reconstruct ) {
+                auto& mode = context.getPointLocalReconstructionMode( i );
+                for ( size_t v1 = 0; v1 < res; ++v1 ) {
+                  const size_t v = v0 * res + v1;
+                  for ( size_t u1 = 0; u1 < res; ++u1 ) {
+                    const size_t u = u0 * res + u1;
+                    size_t       x;
+                    size_t       y;
+                    const bool occupancy = occupancyMap[patch.patch2Canvas( u, v, imageWidth, imageHeight, x, y )] != 0;
+                    if ( !occupancy ) { continue; }
+                    generatePoints( createdPoints, params, frame, videoMultiple, frameIndex, patchIndex, u, v, x, y,
+                                    mode.interpolate_, mode.filling_, mode.minD1_, mode.neighbor_ );
                     for ( const auto& createdPoint : createdPoints ) {
                       if ( patch.getAxisOfAdditionalPlane() == 0 ) {
-                        reconstruct[optimizationIndex].addPoint( createdPoint );
+                        reconstruct.addPoint( createdPoint );
                       } else {
                         PCCVector3D tmp;
                         inverseRotatePosition45DegreeOnAxis( patch.getAxisOfAdditionalPlane(),
                                                              params.geometryBitDepth3D_, createdPoint, tmp );
-                        reconstruct[optimizationIndex].addPoint( tmp );
+                        reconstruct.addPoint( tmp );
                       }
                     }
                   }
                 }
-              }
-              float distancePSrcRec;
-              float distancePRecSrc;
-              blockSrcPointCloud.distanceGeo( reconstruct[optimizationIndex], distancePSrcRec, distancePRecSrc );
-              distance[optimizationIndex] = (std::max)( distancePSrcRec, distancePRecSrc );
-              if ( optimizationIndex == 0 || distance[optimizationIndexMin] > distance[optimizationIndex] ) {
-                optimizationIndexMin = optimizationIndex;
-                patch.setPointLocalReconstructionMode( u0, v0, optimizationIndexMin );
-              }
-              optimizationIndex++;
-            }
-          }  // if block is used
-        }
+              } );
+          patch.setPointLocalReconstructionMode( u0, v0, bestMode );
+        } );
       }
-    }
-  }  // patch
+    } );
+  } );
 }
 
 bool PCCEncoder::resizeGeometryVideo( PCCContext& context, PCCCodecId codecId ) {
@@ -5627,56 +6048,67 @@ void PCCEncoder::markRawPatchLocation( PCCFrameContext& frame, PCCImageOccupancy
 }
 
 bool PCCEncoder::generateGeometryVideo( const PCCGroupOfFrames& sources, PCCContext& context ) {
-  auto& videoGeometry         = context.getVideoGeometryMultiple()[0];
-  auto& videoGeometryMultiple = context.getVideoGeometryMultiple();
-  auto& videoOccupancyMap     = context.getVideoOccupancyMap();
-  auto& frameInfos            = context.getFrames();
-  for ( size_t i = 0; i < frameInfos.size(); i++ ) {
-    auto& frame = frameInfos[i].getTitleFrameContext();
-    if ( !params_.useRawPointsSeparateVideo_ && ( params_.rawPointsPatch_ || params_.lossyRawPointsPatch_ ) ) {
-      markRawPatchLocation( frame, videoOccupancyMap.getFrame( i ) );
-    }
-    if ( params_.multipleStreams_ ) {
-      const size_t geometryVideoSize = videoGeometryMultiple[0].getFrameCount();
-      videoGeometryMultiple[0].resize( geometryVideoSize + 1 );
-      videoGeometryMultiple[1].resize( geometryVideoSize + 1 );
-      auto& frame0 = videoGeometryMultiple[0].getFrame( geometryVideoSize );
-      generateIntraImage( frameInfos[i], 0, frame0 );
-      auto& frame1 = videoGeometryMultiple[1].getFrame( geometryVideoSize );
-      generateIntraImage( frameInfos[i], 1, frame1 );
-      dilate3DPadding( sources[i], frameInfos[i], frame, frame0, videoOccupancyMap.getFrame( i ) );
-      if ( params_.absoluteD1_ ) {
-        dilate3DPadding( sources[i], frameInfos[i], frame, frame1, videoOccupancyMap.getFrame( i ) );
-      }
-    } else {
-      const size_t geometryVideoSize = videoGeometry.getFrameCount();
-      const size_t mapCount          = params_.mapCountMinus1_ + 1;
-      videoGeometry.resize( geometryVideoSize + mapCount );
-      if ( params_.singleMapPixelInterleaving_ ) {
-        auto& frame1 = videoGeometry.getFrame( geometryVideoSize );
-        generateIntraImage( frameInfos[i], 0, frame1 );
-        dilate( frame, frame1 );
-        PCCImageGeometry frame2;
-        generateIntraImage( frameInfos[i], 1, frame2 );
-        dilate3DPadding( sources[i], frameInfos[i], frame, frame2, videoOccupancyMap.getFrame( i ) );
-        for ( size_t x = 0; x < frame1.getWidth(); x++ ) {
-          for ( size_t y = 0; y < frame1.getHeight(); y++ ) {
-            if ( ( x + y ) % 2 == 1 ) { frame1.setValue( 0, x, y, frame2.getValue( 0, x, y ) ); }
-          }
+  PCC_PROFILE_ZONE( "geometry video" );
+  auto&        videoGeometry         = context.getVideoGeometryMultiple()[0];
+  auto&        videoGeometryMultiple = context.getVideoGeometryMultiple();
+  auto&        videoOccupancyMap     = context.getVideoOccupancyMap();
+  auto&        frameInfos            = context.getFrames();
+  const size_t mapCount              = params_.mapCountMinus1_ + 1;
+  // the images of a frame only depend on its patches and its source: the frames are generated in parallel, into
+  // videos sized for all of them upfront
+  const size_t geometryVideoSize =
+      params_.multipleStreams_ ? videoGeometryMultiple[0].getFrameCount() : videoGeometry.getFrameCount();
+  if ( params_.multipleStreams_ ) {
+    videoGeometryMultiple[0].resize( geometryVideoSize + frameInfos.size() );
+    videoGeometryMultiple[1].resize( geometryVideoSize + frameInfos.size() );
+  } else {
+    videoGeometry.resize( geometryVideoSize + frameInfos.size() * mapCount );
+  }
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), frameInfos.size(), [&]( const size_t i ) {
+      auto&       frame  = frameInfos[i].getTitleFrameContext();
+      const auto& source = sources.acquire( i );
+      if ( !params_.useRawPointsSeparateVideo_ && ( params_.rawPointsPatch_ || params_.lossyRawPointsPatch_ ) ) {
+        markRawPatchLocation( frame, videoOccupancyMap.getFrame( i ) );
+      }
+      if ( params_.multipleStreams_ ) {
+        auto& frame0 = videoGeometryMultiple[0].getFrame( geometryVideoSize + i );
+        generateIntraImage( frameInfos[i], 0, frame0 );
+        auto& frame1 = videoGeometryMultiple[1].getFrame( geometryVideoSize + i );
+        generateIntraImage( frameInfos[i], 1, frame1 );
+        dilate3DPadding( source, frameInfos[i], frame, frame0, videoOccupancyMap.getFrame( i ) );
+        if ( params_.absoluteD1_ ) {
+          dilate3DPadding( source, frameInfos[i], frame, frame1, videoOccupancyMap.getFrame( i ) );
         }
       } else {
-        for ( size_t f = 0; f < mapCount; ++f ) {
-          auto& geoImage = videoGeometry.getFrame( geometryVideoSize + f );
-          generateIntraImage( frameInfos[i], f, geoImage );
-          dilate3DPadding( sources[i], frameInfos[i], frame, geoImage, videoOccupancyMap.getFrame( i ) );
+        const size_t frameVideoIndex = geometryVideoSize + i * mapCount;
+        if ( params_.singleMapPixelInterleaving_ ) {
+          auto& frame1 = videoGeometry.getFrame( frameVideoIndex );
+          generateIntraImage( frameInfos[i], 0, frame1 );
+          dilate( frame, frame1 );
+          PCCImageGeometry frame2;
+          generateIntraImage( frameInfos[i], 1, frame2 );
+          dilate3DPadding( source, frameInfos[i], frame, frame2, videoOccupancyMap.getFrame( i ) );
+          for ( size_t x = 0; x < frame1.getWidth(); x++ ) {
+            for ( size_t y = 0; y < frame1.getHeight(); y++ ) {
+              if ( ( x + y ) % 2 == 1 ) { frame1.setValue( 0, x, y, frame2.getValue( 0, x, y ) ); }
+            }
+          }
+        } else {
+          for ( size_t f = 0; f < mapCount; ++f ) {
+            auto& geoImage = videoGeometry.getFrame( frameVideoIndex + f );
+            generateIntraImage( frameInfos[i], f, geoImage );
+            dilate3DPadding( source, frameInfos[i], frame, geoImage, videoOccupancyMap.getFrame( i ) );
+          }
         }
       }
-    }
-    // Group dilation in Geometry
-    if ( params_.groupDilation_ && params_.absoluteD1_ && params_.mapCountMinus1_ > 0 ) {
-      dilateGroupGeometryVideo( context, frame, i );
-    }
-  }  // frame
+      // Group dilation in Geometry
+      if ( params_.groupDilation_ && params_.absoluteD1_ && params_.mapCountMinus1_ > 0 ) {
+        dilateGroupGeometryVideo( context, frame, i );
+      }
+      sources.release( i );
+    } );
+  } );
   return true;
 }
 
@@ -5689,13 +6121,16 @@ void PCCEncoder::dilate( PCCFrameContext& frame, PCCImage<T, 3>& image, const PC
   const int64_t neighbors[4][2]          = { { 0, -1 }, { -1, 0 }, { 1, 0 }, { 0, 1 } };
   const size_t  MAX_OCCUPANCY_RESOLUTION = 64;
   assert( params_.occupancyResolution_ <= MAX_OCCUPANCY_RESOLUTION );
-  size_t              count[MAX_OCCUPANCY_RESOLUTION][MAX_OCCUPANCY_RESOLUTION];
-  PCCVector3<int32_t> values[MAX_OCCUPANCY_RESOLUTION][MAX_OCCUPANCY_RESOLUTION];
-  for ( size_t v1 = 0; v1 < occupancyMapSizeV; ++v1 ) {
-    const int64_t v0 = v1 * params_.occupancyResolution_;
-    for ( size_t u1 = 0; u1 < occupancyMapSizeU; ++u1 ) {
+  // the blocks with occupied pixels only read and write their own pixels and are dilated in parallel, the empty
+  // ones then copy their left or top neighbor in raster order
+  std::vector<size_t> nonZeroPixelCounts( occupancyMapSizeU * occupancyMapSizeV, 0 );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), nonZeroPixelCounts.size(), [&]( const size_t blockIndex ) {
+      const size_t  v1                = blockIndex / occupancyMapSizeU;
+      const size_t  u1                = blockIndex % occupancyMapSizeU;
+      const int64_t v0                = v1 * params_.occupancyResolution_;
       const int64_t u0                = u1 * params_.occupancyResolution_;
-      size_t        nonZeroPixelCount = 0;
+      size_t&       nonZeroPixelCount = nonZeroPixelCounts[blockIndex];
       for ( size_t v2 = 0; v2 < params_.occupancyResolution_; ++v2 ) {
         for ( size_t u2 = 0; u2 < params_.occupancyResolution_; ++u2 ) {
           const int64_t x0 = u0 + u2;
@@ -5709,44 +6144,9 @@ void PCCEncoder::dilate( PCCFrameContext& frame, PCCImage<T, 3>& image, const PC
           }
         }
       }
-      if ( !nonZeroPixelCount ) {
-        if ( reference ) {
-          for ( size_t v2 = 0; v2 < params_.occupancyResolution_; ++v2 ) {
-            for ( size_t u2 = 0; u2 < params_.occupancyResolution_; ++u2 ) {
-              const size_t x0 = u0 + u2;
-              const size_t y0 = v0 + v2;
-              image.setValue( 0, x0, y0, reference->getValue( 0, x0, y0 ) );
-              image.setValue( 1, x0, y0, reference->getValue( 1, x0, y0 ) );
-              image.setValue( 2, x0, y0, reference->getValue( 2, x0, y0 ) );
-            }
-          }
-        } else if ( u1 > 0 ) {
-          for ( size_t v2 = 0; v2 < params_.occupancyResolution_; ++v2 ) {
-            for ( size_t u2 = 0; u2 < params_.occupancyResolution_; ++u2 ) {
-              const size_t x0 = u0 + u2;
-              const size_t y0 = v0 + v2;
-              assert( x0 > 0 );
-              const size_t x1 = x0 - 1;
-              image.setValue( 0, x0, y0, image.getValue( 0, x1, y0 ) );
-              image.setValue( 1, x0, y0, image.getValue( 1, x1, y0 ) );
-              image.setValue( 2, x0, y0, image.getValue( 2, x1, y0 ) );
-            }
-          }
-        } else if ( v1 > 0 ) {
-          for ( size_t v2 = 0; v2 < params_.occupancyResolution_; ++v2 ) {
-            for ( size_t u2 = 0; u2 < params_.occupancyResolution_; ++u2 ) {
-              const size_t x0 = u0 + u2;
-              const size_t y0 = v0 + v2;
-              assert( y0 > 0 );
-              const size_t y1 = y0 - 1;
-              image.setValue( 0, x0, y0, image.getValue( 0, x0, y1 ) );
-              image.setValue( 1, x0, y0, image.getValue( 1, x0, y1 ) );
-              image.setValue( 2, x0, y0, image.getValue( 2, x0, y1 ) );
-            }
-          }
-        }
-        continue;
-      }
+      if ( !nonZeroPixelCount ) { return; }
+      size_t              count[MAX_OCCUPANCY_RESOLUTION][MAX_OCCUPANCY_RESOLUTION];
+      PCCVector3<int32_t> values[MAX_OCCUPANCY_RESOLUTION][MAX_OCCUPANCY_RESOLUTION];
       for ( size_t v2 = 0; v2 < params_.occupancyResolution_; ++v2 ) {
         for ( size_t u2 = 0; u2 < params_.occupancyResolution_; ++u2 ) {
           values[v2][u2] = 0;
@@ -5797,6 +6197,49 @@ void PCCEncoder::dilate( PCCFrameContext& frame, PCCImage<T, 3>& image, const PC
         }
         ++iteration;
       }
+    } );
+  } );
+  for ( size_t v1 = 0; v1 < occupancyMapSizeV; ++v1 ) {
+    const int64_t v0 = v1 * params_.occupancyResolution_;
+    for ( size_t u1 = 0; u1 < occupancyMapSizeU; ++u1 ) {
+      const int64_t u0 = u1 * params_.occupancyResolution_;
+      if ( nonZeroPixelCounts[v1 * occupancyMapSizeU + u1] == 0 ) {
+        if ( reference ) {
+          for ( size_t v2 = 0; v2 < params_.occupancyResolution_; ++v2 ) {
+            for ( size_t u2 = 0; u2 < params_.occupancyResolution_; ++u2 ) {
+              const size_t x0 = u0 + u2;
+              const size_t y0 = v0 + v2;
+              image.setValue( 0, x0, y0, reference->getValue( 0, x0, y0 ) );
+              image.setValue( 1, x0, y0, reference->getValue( 1, x0, y0 ) );
+              image.setValue( 2, x0, y0, reference->getValue( 2, x0, y0 ) );
+            }
+          }
+        } else if ( u1 > 0 ) {
+          for ( size_t v2 = 0; v2 < params_.occupancyResolution_; ++v2 ) {
+            for ( size_t u2 = 0; u2 < params_.occupancyResolution_; ++u2 ) {
+              const size_t x0 = u0 + u2;
+              const size_t y0 = v0 + v2;
+              assert( x0 > 0 );
+              const size_t x1 = x0 - 1;
+              image.setValue( 0, x0, y0, image.getValue( 0, x1, y0 ) );
+              image.setValue( 1, x0, y0, image.getValue( 1, x1, y0 ) );
+              image.setValue( 2, x0, y0, image.getValue( 2, x1, y0 ) );
+            }
+          }
+        } else if ( v1 > 0 ) {
+          for ( size_t v2 = 0; v2 < params_.occupancyResolution_; ++v2 ) {
+            for ( size_t u2 = 0; u2 < params_.occupancyResolution_; ++u2 ) {
+              const size_t x0 = u0 + u2;
+              const size_t y0 = v0 + v2;
+              assert( y0 > 0 );
+              const size_t y1 = y0 - 1;
+              image.setValue( 0, x0, y0, image.getValue( 0, x0, y1 ) );
+              image.setValue( 1, x0, y0, image.getValue( 1, x0, y1 ) );
+              image.setValue( 2, x0, y0, image.getValue( 2, x0, y1 ) );
+            }
+          }
+        }
+      }
     }
   }
 }
@@ -5806,7 +6249,7 @@ size_t PCCEncoder::adjustDepth3DPadding( size_t            x,
                                          size_t            y,
                                          uint16_t          mean_val,
                                          PCCImageGeometry& image,
-                                         PCCKdTree&        kdtree,
+                                         const PCCKdTree&  kdtree,
                                          PCCFrameContext&  frame ) {
   auto&  blockToPatch = frame.getBlockToPatch();
   auto&  patches      = frame.getPatches();
@@ -5815,11 +6258,12 @@ size_t PCCEncoder::adjustDepth3DPadding( size_t            x,
   size_t patchIndex = blockToPatch[block_addr];
   auto&  patch      = patches[patchIndex - 1];
   size_t distance   = (std::numeric_limits<int16_t>::max)();
+  // one result reused by all the searches of the pixel
+  PCCNNResult result;
   // testing the mean value
-  PCCNNResult result_mean;
-  PCCPoint3D  point_mean = patch.canvasTo3D( x, y, mean_val );
-  kdtree.search( point_mean, 1, result_mean );
-  const double dist2_mean = result_mean.dist( 0 );
+  PCCPoint3D point_mean = patch.canvasTo3D( x, y, mean_val );
+  kdtree.search( point_mean, 1, result );
+  const double dist2_mean = result.dist( 0 );
   if ( dist2_mean < distance ) {
     image.setValue( 0, x, y, mean_val );
     image.setValue( 1, x, y, 0 );
@@ -5835,7 +6279,6 @@ size_t PCCEncoder::adjustDepth3DPadding( size_t            x,
     for ( uint16_t depth = 1; depth < deltadepth; depth++ ) {
       PCCPoint3D point = patch.canvasTo3D( x, y, mean_val + depth );
       // now find the distance between the point and the original point cloud
-      PCCNNResult result;
       kdtree.search( point, 1, result );
       const double dist2 = result.dist( 0 );
       if ( dist2 < distance ) {
@@ -5846,9 +6289,8 @@ size_t PCCEncoder::adjustDepth3DPadding( size_t            x,
       }
       PCCPoint3D point_neg = patch.canvasTo3D( x, y, mean_val - depth );
       // now find the distance between the point and the original point cloud
-      PCCNNResult result_neg;
-      kdtree.search( point_neg, 1, result_neg );
-      const double dist2_neg = result_neg.dist( 0 );
+      kdtree.search( point_neg, 1, result );
+      const double dist2_neg = result.dist( 0 );
       if ( dist2_neg < distance ) {
         image.setValue( 0, x, y, mean_val - depth );
         image.setValue( 1, x, y, 0 );
@@ -5877,56 +6319,60 @@ void PCCEncoder::dilate3DPadding( const PCCPointSet3&     source,
   std::vector<uint32_t> occupancyMapTemp;
   auto&                 occupancyMapOriginal = frame.getOccupancyMap();
   occupancyMapTemp.resize( image.getWidth() * image.getHeight(), 0 );
-  PCCKdTree kdtree( source );
-  // fill in positions that are added to the sequence, because of occupancyMap video coding
-  for ( size_t y_OM = 0; y_OM < occupancyMap.getHeight(); ++y_OM ) {
-    for ( size_t x_OM = 0; x_OM < occupancyMap.getWidth(); ++x_OM ) {
-      if ( occupancyMap.getValue( 0, x_OM, y_OM ) >= 1 ) {
-        // this is an area that has active values, update the temporary occupancy Map struture, and store the mean value
-        // in this area
-        uint16_t mean_val = 0;
-        size_t   count    = 0;
-        for ( size_t j = 0; j < params_.occupancyPrecision_; j++ ) {
-          size_t y = y_OM * params_.occupancyPrecision_ + j;
-          for ( size_t i = 0; i < params_.occupancyPrecision_; i++ ) {
-            size_t x = x_OM * params_.occupancyPrecision_ + i;
-            if ( occupancyMapOriginal[y * image.getWidth() + x] != 0 ) {
-              mean_val += image.getValue( 0, x, y );
-              count++;
+  // the same tree for every map of the frame, see PCCSpatialIndexCache
+  const std::shared_ptr<const PCCKdTree> kdtree = frame.getSpatialIndex().getKdTree( source );
+  // fill in positions that are added to the sequence, because of occupancyMap video coding. A block only writes its own
+  // pixels, where the original occupancy map is empty, and only reads the occupied ones: the rows run in parallel.
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), size_t( occupancyMap.getHeight() ), [&]( const size_t y_OM ) {
+      for ( size_t x_OM = 0; x_OM < occupancyMap.getWidth(); ++x_OM ) {
+        if ( occupancyMap.getValue( 0, x_OM, y_OM ) >= 1 ) {
+          // this is an area that has active values, update the temporary occupancy Map struture, and store the mean
+          // value in this area
+          uint16_t mean_val = 0;
+          size_t   count    = 0;
+          for ( size_t j = 0; j < params_.occupancyPrecision_; j++ ) {
+            size_t y = y_OM * params_.occupancyPrecision_ + j;
+            for ( size_t i = 0; i < params_.occupancyPrecision_; i++ ) {
+              size_t x = x_OM * params_.occupancyPrecision_ + i;
+              if ( occupancyMapOriginal[y * image.getWidth() + x] != 0 ) {
+                mean_val += image.getValue( 0, x, y );
+                count++;
+              }
             }
           }
-        }
-        if ( count == 0 ) {
-          printf( "dilate3DPadding %zu frame- %zux%zu, %zux%zu frame : (%zu,%zu) in OM (%zu,%zu)\n",
-                  frame.getFrameIndex(), frame.getWidth(), frame.getHeight(), image.getWidth(), image.getHeight(), x_OM,
-                  y_OM, x_OM * params_.occupancyPrecision_, y_OM * params_.occupancyPrecision_ );
-          exit( 123 );
-        }
-        assert( count > 0 );
-        mean_val /= count;
-        // now fill in the missing positions with depth values searched in 3D space
-        for ( size_t j = 0; j < params_.occupancyPrecision_; j++ ) {
-          size_t y = y_OM * params_.occupancyPrecision_ + j;
-          for ( size_t i = 0; i < params_.occupancyPrecision_; i++ ) {
-            size_t x = x_OM * params_.occupancyPrecision_ + i;
-            // if depth value is undefined, this position will be added, find the best value
-            if ( occupancyMapOriginal[y * image.getWidth() + x] == 0 ) {
-              // try to find the best value to approximate this new point to the original point cloud get the patch
-              // information
-              if ( params_.geometryPadding_ == 1 ) {
-                occupancyMapTemp[y * image.getWidth() + x] =
-                    adjustDepth3DPadding( x, y, mean_val, image, kdtree, frame );
+          if ( count == 0 ) {
+            printf( "dilate3DPadding %zu frame- %zux%zu, %zux%zu frame : (%zu,%zu) in OM (%zu,%zu)\n",
+                    frame.getFrameIndex(), frame.getWidth(), frame.getHeight(), image.getWidth(), image.getHeight(),
+                    x_OM, y_OM, x_OM * params_.occupancyPrecision_, y_OM * params_.occupancyPrecision_ );
+            exit( 123 );
+          }
+          assert( count > 0 );
+          mean_val /= count;
+          // now fill in the missing positions with depth values searched in 3D space
+          for ( size_t j = 0; j < params_.occupancyPrecision_; j++ ) {
+            size_t y = y_OM * params_.occupancyPrecision_ + j;
+            for ( size_t i = 0; i < params_.occupancyPrecision_; i++ ) {
+              size_t x = x_OM * params_.occupancyPrecision_ + i;
+              // if depth value is undefined, this position will be added, find the best value
+              if ( occupancyMapOriginal[y * image.getWidth() + x] == 0 ) {
+                // try to find the best value to approximate this new point to the original point cloud get the patch
+                // information
+                if ( params_.geometryPadding_ == 1 ) {
+                  occupancyMapTemp[y * image.getWidth() + x] =
+                      adjustDepth3DPadding( x, y, mean_val, image, *kdtree, frame );
+                } else {
+                  occupancyMapTemp[y * image.getWidth() + x] = 0;
+                }
               } else {
-                occupancyMapTemp[y * image.getWidth() + x] = 0;
+                occupancyMapTemp[y * image.getWidth() + x] = 1;
               }
-            } else {
-              occupancyMapTemp[y * image.getWidth() + x] = 1;
             }
           }
         }
       }
-    }
-  }
+    } );
+  } );
 
   // now continue adding the pixels with the previous dilation approach
   for ( size_t v1 = 0; v1 < occupancyMapSizeV; ++v1 ) {
@@ -6091,26 +6537,30 @@ void PCCEncoder::createCoarseLayer( PCCImage<T, 3>&        image,
   mipOccupancyMap.resize( ( dyadicWidth / 2 ) * ( dyadicHeight / 2 ), 0 );
   int stride    = image.getWidth();
   int newStride = ( dyadicWidth / 2 );
-  for ( size_t y = 0; y < mip.getHeight(); y++ ) {
-    for ( size_t x = 0; x < mip.getWidth(); x++ ) {
-      double num[3] = { 0.0, 0.0, 0.0 };
-      double den    = 0;
-      for ( size_t i = 0; i < 2; i++ ) {
-        for ( size_t j = 0; j < 2; j++ ) {
-          int row = ( 2 * y + i ) < 0 ? 0 : ( 2 * y + i ) >= image.getHeight() ? image.getHeight() - 1 : ( 2 * y + i );
-          int column = ( 2 * x + j ) < 0 ? 0 : ( 2 * x + j ) >= image.getWidth() ? image.getWidth() - 1 : ( 2 * x + j );
-          if ( occupancyMap[column + stride * row] == 1 ) {
-            den++;
-            for ( int cc = 0; cc < 3; cc++ ) { num[cc] += image.getValue( cc, column, row ); }
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), mip.getHeight(), [&]( const size_t y ) {
+      for ( size_t x = 0; x < mip.getWidth(); x++ ) {
+        double num[3] = { 0.0, 0.0, 0.0 };
+        double den    = 0;
+        for ( size_t i = 0; i < 2; i++ ) {
+          for ( size_t j = 0; j < 2; j++ ) {
+            int row =
+                ( 2 * y + i ) < 0 ? 0 : ( 2 * y + i ) >= image.getHeight() ? image.getHeight() - 1 : ( 2 * y + i );
+            int column =
+                ( 2 * x + j ) < 0 ? 0 : ( 2 * x + j ) >= image.getWidth() ? image.getWidth() - 1 : ( 2 * x + j );
+            if ( occupancyMap[column + stride * row] == 1 ) {
+              den++;
+              for ( int cc = 0; cc < 3; cc++ ) { num[cc] += image.getValue( cc, column, row ); }
+            }
           }
         }
+        if ( den > 0 ) {
+          mipOccupancyMap[x + newStride * y] = 1;
+          for ( int cc = 0; cc < 3; cc++ ) { mip.setValue( cc, x, y, std::round( num[cc] / den ) ); }
+        }
       }
-      if ( den > 0 ) {
-        mipOccupancyMap[x + newStride * y] = 1;
-        for ( int cc = 0; cc < 3; cc++ ) { mip.setValue( cc, x, y, std::round( num[cc] / den ) ); }
-      }
-    }
-  }
+    } );
+  } );
 }
 
 template <typename T>
@@ -6224,33 +6674,36 @@ void PCCEncoder::regionFill( PCCImage<T, 3>& image, std::vector<uint32_t>& occup
   }
   int    maxIteration = 1024;
   double maxError     = 0.00001;
-  for ( int cc = 0; cc < 3; cc++ ) {
-    int it = 0;
-    for ( ; it < maxIteration; it++ ) {
-      int    idxSparse = 0;
-      double error     = 0;
-      for ( int centerIdx = 0; centerIdx < numElem; centerIdx++ ) {
-        // add the b result
-        double val = b[cc][centerIdx];
-        while ( ( idxSparse < numSparseElem ) && ( iSparse[idxSparse] == centerIdx ) ) {
-          if ( valSparse[idxSparse] < 0 ) {
-            val += x[cc][jSparse[idxSparse]];
-            idxSparse++;
-          } else {
-            // final value
-            val /= valSparse[idxSparse];
-            // accumulate the error
-            error += ( val - x[cc][centerIdx] ) * ( val - x[cc][centerIdx] );
-            // update the value
-            x[cc][centerIdx] = val;
-            idxSparse++;
+  // the channels converge independently
+  executionContext_->execute( [&] {
+    tbb::parallel_for( 0, 3, [&]( const int cc ) {
+      int it = 0;
+      for ( ; it < maxIteration; it++ ) {
+        int    idxSparse = 0;
+        double error     = 0;
+        for ( int centerIdx = 0; centerIdx < numElem; centerIdx++ ) {
+          // add the b result
+          double val = b[cc][centerIdx];
+          while ( ( idxSparse < numSparseElem ) && ( iSparse[idxSparse] == centerIdx ) ) {
+            if ( valSparse[idxSparse] < 0 ) {
+              val += x[cc][jSparse[idxSparse]];
+              idxSparse++;
+            } else {
+              // final value
+              val /= valSparse[idxSparse];
+              // accumulate the error
+              error += ( val - x[cc][centerIdx] ) * ( val - x[cc][centerIdx] );
+              // update the value
+              x[cc][centerIdx] = val;
+              idxSparse++;
+            }
           }
         }
+        error = error / numElem;
+        if ( error < maxError ) { break; }
       }
-      error = error / numElem;
-      if ( error < maxError ) { break; }
-    }
-  }
+    } );
+  } );
   // put the value back in the image
   idx = 0;
   for ( int row = 0; row < image.getHeight(); row++ ) {
@@ -6286,70 +6739,89 @@ void PCCEncoder::pushPullMip( const PCCImage<T, 3>&        image,
                               PCCImage<T, 3>&              mip,
                               const std::vector<uint32_t>& occupancyMap,
                               std::vector<uint32_t>&       mipOccupancyMap ) {
-  unsigned char w1;
-  unsigned char w2;
-  unsigned char w3;
-  unsigned char w4;
-  unsigned char val1;
-  unsigned char val2;
-  unsigned char val3;
-  unsigned char val4;
-  const size_t  width     = image.getWidth();
-  const size_t  height    = image.getHeight();
-  const size_t  newWidth  = ( ( width + 1 ) >> 1 );
-  const size_t  newHeight = ( ( height + 1 ) >> 1 );
+  const size_t width     = image.getWidth();
+  const size_t height    = image.getHeight();
+  const size_t newWidth  = ( ( width + 1 ) >> 1 );
+  const size_t newHeight = ( ( height + 1 ) >> 1 );
+  assert( image.getPlaneWidth( 1 ) == width && image.getPlaneWidth( 2 ) == width );
   // allocate the mipmap with half the resolution
   mip.resize( newWidth, newHeight, PCCCOLORFORMAT::YUV444 );
   mipOccupancyMap.resize( newWidth * newHeight, 0 );
-  for ( size_t y = 0; y < newHeight; ++y ) {
-    const size_t yUp = y << 1;
-    for ( size_t x = 0; x < newWidth; ++x ) {
-      const size_t xUp = x << 1;
-      if ( occupancyMap[xUp + width * yUp] == 0 ) {
-        w1 = 0;
-      } else {
-        w1 = 255;
-      }
-      if ( ( xUp + 1 >= width ) || ( occupancyMap[xUp + 1 + width * yUp] == 0 ) ) {
-        w2 = 0;
-      } else {
-        w2 = 255;
-      }
-      if ( ( yUp + 1 >= height ) || ( occupancyMap[xUp + width * ( yUp + 1 )] == 0 ) ) {
-        w3 = 0;
-      } else {
-        w3 = 255;
-      }
-      if ( ( xUp + 1 >= width ) || ( yUp + 1 >= height ) || ( occupancyMap[xUp + 1 + width * ( yUp + 1 )] == 0 ) ) {
-        w4 = 0;
-      } else {
-        w4 = 255;
-      }
-      if ( w1 + w2 + w3 + w4 > 0 ) {
-        for ( int cc = 0; cc < 3; cc++ ) {
-          val1 = image.getValue( cc, xUp, yUp );
-          if ( xUp + 1 >= width ) {
-            val2 = 0;
-          } else {
-            val2 = image.getValue( cc, xUp + 1, yUp );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), newHeight, [&]( const size_t y ) {
+      unsigned char w1;
+      unsigned char w2;
+      unsigned char w3;
+      unsigned char w4;
+      unsigned char val1;
+      unsigned char val2;
+      unsigned char val3;
+      unsigned char val4;
+      const size_t  yUp  = y << 1;
+      size_t        done = 0;
+      // the 2x2 blocks inside the image are vectorized, the other ones are weighted as the pixels out of it
+      if ( yUp + 1 < height ) {
+        const uint32_t* occupancy0 = occupancyMap.data() + width * yUp;
+        const uint32_t* occupancy1 = occupancy0 + width;
+        for ( size_t cc = 0; cc < 3; cc++ ) {
+          done = pushPullMipRowKernel( image.getRow( cc, yUp ), image.getRow( cc, yUp + 1 ), occupancy0, occupancy1,
+                                       mip.getRow( cc, y ), width >> 1 );
+        }
+        for ( size_t x = 0; x < done; ++x ) {
+          if ( occupancy0[2 * x] != 0 || occupancy0[2 * x + 1] != 0 || occupancy1[2 * x] != 0 ||
+               occupancy1[2 * x + 1] != 0 ) {
+            mipOccupancyMap[x + newWidth * y] = 1;
           }
-          if ( yUp + 1 >= height ) {
-            val3 = 0;
-          } else {
-            val3 = image.getValue( cc, xUp, yUp + 1 );
-          }
-          if ( ( xUp + 1 >= width ) || ( yUp + 1 >= height ) ) {
-            val4 = 0;
-          } else {
-            val4 = image.getValue( cc, xUp + 1, yUp + 1 );
+        }
+      }
+      for ( size_t x = done; x < newWidth; ++x ) {
+        const size_t xUp = x << 1;
+        if ( occupancyMap[xUp + width * yUp] == 0 ) {
+          w1 = 0;
+        } else {
+          w1 = 255;
+        }
+        if ( ( xUp + 1 >= width ) || ( occupancyMap[xUp + 1 + width * yUp] == 0 ) ) {
+          w2 = 0;
+        } else {
+          w2 = 255;
+        }
+        if ( ( yUp + 1 >= height ) || ( occupancyMap[xUp + width * ( yUp + 1 )] == 0 ) ) {
+          w3 = 0;
+        } else {
+          w3 = 255;
+        }
+        if ( ( xUp + 1 >= width ) || ( yUp + 1 >= height ) || ( occupancyMap[xUp + 1 + width * ( yUp + 1 )] == 0 ) ) {
+          w4 = 0;
+        } else {
+          w4 = 255;
+        }
+        if ( w1 + w2 + w3 + w4 > 0 ) {
+          for ( int cc = 0; cc < 3; cc++ ) {
+            val1 = image.getValue( cc, xUp, yUp );
+            if ( xUp + 1 >= width ) {
+              val2 = 0;
+            } else {
+              val2 = image.getValue( cc, xUp + 1, yUp );
+            }
+            if ( yUp + 1 >= height ) {
+              val3 = 0;
+            } else {
+              val3 = image.getValue( cc, xUp, yUp + 1 );
+            }
+            if ( ( xUp + 1 >= width ) || ( yUp + 1 >= height ) ) {
+              val4 = 0;
+            } else {
+              val4 = image.getValue( cc, xUp + 1, yUp + 1 );
+            }
+            T newVal = mean4w( val1, w1, val2, w2, val3, w3, val4, w4 );
+            mip.setValue( cc, x, y, newVal );
           }
-          T newVal = mean4w( val1, w1, val2, w2, val3, w3, val4, w4 );
-          mip.setValue( cc, x, y, newVal );
+          mipOccupancyMap[x + newWidth * y] = 1;
         }
-        mipOccupancyMap[x + newWidth * y] = 1;
       }
-    }
-  }
+    } );
+  } );
 }
 
 // interpolate using mipmap
@@ -6364,89 +6836,120 @@ void PCCEncoder::pushPullFill( PCCImage<T, 3>&              image,
   const size_t heightUp = image.getHeight();
   assert( ( ( widthUp + 1 ) >> 1 ) == width );
   assert( ( ( heightUp + 1 ) >> 1 ) == height );
-  unsigned char w1;
-  unsigned char w2;
-  unsigned char w3;
-  unsigned char w4;
-  for ( int yUp = 0; yUp < heightUp; ++yUp ) {
-    int y = yUp >> 1;
-    for ( int xUp = 0; xUp < widthUp; ++xUp ) {
-      int x = xUp >> 1;
-      if ( occupancyMap[xUp + widthUp * yUp] == 0 ) {
-        if ( ( xUp % 2 == 0 ) && ( yUp % 2 == 0 ) ) {
-          w1 = 144;
-          w2 = ( x > 0 ? static_cast<unsigned char>( 48 ) : 0 );
-          w3 = ( y > 0 ? static_cast<unsigned char>( 48 ) : 0 );
-          w4 = ( ( ( x > 0 ) && ( y > 0 ) ) ? static_cast<unsigned char>( 16 ) : 0 );
-          for ( int cc = 0; cc < 3; cc++ ) {
-            T val       = mip.getValue( cc, x, y );
-            T valLeft   = ( x > 0 ? mip.getValue( cc, x - 1, y ) : 0 );
-            T valUp     = ( y > 0 ? mip.getValue( cc, x, y - 1 ) : 0 );
-            T valUpLeft = ( ( x > 0 && y > 0 ) ? mip.getValue( cc, x - 1, y - 1 ) : 0 );
-            T newVal    = mean4w( val, w1, valLeft, w2, valUp, w3, valUpLeft, w4 );
-            image.setValue( cc, xUp, yUp, newVal );
-          }
-        } else if ( ( xUp % 2 == 1 ) && ( yUp % 2 == 0 ) ) {
-          w1 = 144;
-          w2 = ( x < width - 1 ? static_cast<unsigned char>( 48 ) : 0 );
-          w3 = ( y > 0 ? static_cast<unsigned char>( 48 ) : 0 );
-          w4 = ( ( ( x < width - 1 ) && ( y > 0 ) ) ? static_cast<unsigned char>( 16 ) : 0 );
-          for ( int cc = 0; cc < 3; cc++ ) {
-            T val        = mip.getValue( cc, x, y );
-            T valRight   = ( x < width - 1 ? mip.getValue( cc, x + 1, y ) : 0 );
-            T valUp      = ( y > 0 ? mip.getValue( cc, x, y - 1 ) : 0 );
-            T valUpRight = ( ( ( x < width - 1 ) && ( y > 0 ) ) ? mip.getValue( cc, x + 1, y - 1 ) : 0 );
-            T newVal     = mean4w( val, w1, valRight, w2, valUp, w3, valUpRight, w4 );
-            image.setValue( cc, xUp, yUp, newVal );
-          }
-        } else if ( ( xUp % 2 == 0 ) && ( yUp % 2 == 1 ) ) {
-          w1 = 144;
-          w2 = ( x > 0 ? static_cast<unsigned char>( 48 ) : 0 );
-          w3 = ( y < height - 1 ? static_cast<unsigned char>( 48 ) : 0 );
-          w4 = ( ( ( x > 0 ) && ( y < height - 1 ) ) ? static_cast<unsigned char>( 16 ) : 0 );
-          for ( int cc = 0; cc < 3; cc++ ) {
-            T val         = mip.getValue( cc, x, y );
-            T valLeft     = ( x > 0 ? mip.getValue( cc, x - 1, y ) : 0 );
-            T valDown     = ( ( y < height - 1 ) ? mip.getValue( cc, x, y + 1 ) : 0 );
-            T valDownLeft = ( ( x > 0 && ( y < height - 1 ) ) ? mip.getValue( cc, x - 1, y + 1 ) : 0 );
-            T newVal      = mean4w( val, w1, valLeft, w2, valDown, w3, valDownLeft, w4 );
-            image.setValue( cc, xUp, yUp, newVal );
-          }
-        } else {
-          w1 = 144;
-          w2 = ( x < width - 1 ? static_cast<unsigned char>( 48 ) : 0 );
-          w3 = ( y < height - 1 ? static_cast<unsigned char>( 48 ) : 0 );
-          w4 = ( ( ( x < width - 1 ) && ( y < height - 1 ) ) ? static_cast<unsigned char>( 16 ) : 0 );
-          for ( int cc = 0; cc < 3; cc++ ) {
-            T val          = mip.getValue( cc, x, y );
-            T valRight     = ( x < width - 1 ? mip.getValue( cc, x + 1, y ) : 0 );
-            T valDown      = ( ( y < height - 1 ) ? mip.getValue( cc, x, y + 1 ) : 0 );
-            T valDownRight = ( ( ( x < width - 1 ) && ( y < height - 1 ) ) ? mip.getValue( cc, x + 1, y + 1 ) : 0 );
-            T newVal       = mean4w( val, w1, valRight, w2, valDown, w3, valDownRight, w4 );
-            image.setValue( cc, xUp, yUp, newVal );
+  assert( image.getPlaneWidth( 1 ) == widthUp && image.getPlaneWidth( 2 ) == widthUp );
+  // the pixels away from the borders of the mip are vectorized, from the third column on
+  const size_t begin = ( std::min )( widthUp, size_t( 2 ) );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), heightUp, [&]( const size_t row ) {
+      unsigned char w1;
+      unsigned char w2;
+      unsigned char w3;
+      unsigned char w4;
+      const int     yUp       = int( row );
+      const int     y         = yUp >> 1;
+      auto          fillPixel = [&]( const int xUp ) {
+        int x = xUp >> 1;
+        if ( occupancyMap[xUp + widthUp * yUp] == 0 ) {
+          if ( ( xUp % 2 == 0 ) && ( yUp % 2 == 0 ) ) {
+            w1 = 144;
+            w2 = ( x > 0 ? static_cast<unsigned char>( 48 ) : 0 );
+            w3 = ( y > 0 ? static_cast<unsigned char>( 48 ) : 0 );
+            w4 = ( ( ( x > 0 ) && ( y > 0 ) ) ? static_cast<unsigned char>( 16 ) : 0 );
+            for ( int cc = 0; cc < 3; cc++ ) {
+              T val       = mip.getValue( cc, x, y );
+              T valLeft   = ( x > 0 ? mip.getValue( cc, x - 1, y ) : 0 );
+              T valUp     = ( y > 0 ? mip.getValue( cc, x, y - 1 ) : 0 );
+              T valUpLeft = ( ( x > 0 && y > 0 ) ? mip.getValue( cc, x - 1, y - 1 ) : 0 );
+              T newVal    = mean4w( val, w1, valLeft, w2, valUp, w3, valUpLeft, w4 );
+              image.setValue( cc, xUp, yUp, newVal );
+            }
+          } else if ( ( xUp % 2 == 1 ) && ( yUp % 2 == 0 ) ) {
+            w1 = 144;
+            w2 = ( x < width - 1 ? static_cast<unsigned char>( 48 ) : 0 );
+            w3 = ( y > 0 ? static_cast<unsigned char>( 48 ) : 0 );
+            w4 = ( ( ( x < width - 1 ) && ( y > 0 ) ) ? static_cast<unsigned char>( 16 ) : 0 );
+            for ( int cc = 0; cc < 3; cc++ ) {
+              T val        = mip.getValue( cc, x, y );
+              T valRight   = ( x < width - 1 ? mip.getValue( cc, x + 1, y ) : 0 );
+              T valUp      = ( y > 0 ? mip.getValue( cc, x, y - 1 ) : 0 );
+              T valUpRight = ( ( ( x < width - 1 ) && ( y > 0 ) ) ? mip.getValue( cc, x + 1, y - 1 ) : 0 );
+              T newVal     = mean4w( val, w1, valRight, w2, valUp, w3, valUpRight, w4 );
+              image.setValue( cc, xUp, yUp, newVal );
+            }
+          } else if ( ( xUp % 2 == 0 ) && ( yUp % 2 == 1 ) ) {
+            w1 = 144;
+            w2 = ( x > 0 ? static_cast<unsigned char>( 48 ) : 0 );
+            w3 = ( y < height - 1 ? static_cast<unsigned char>( 48 ) : 0 );
+            w4 = ( ( ( x > 0 ) && ( y < height - 1 ) ) ? static_cast<unsigned char>( 16 ) : 0 );
+            for ( int cc = 0; cc < 3; cc++ ) {
+              T val         = mip.getValue( cc, x, y );
+              T valLeft     = ( x > 0 ? mip.getValue( cc, x - 1, y ) : 0 );
+              T valDown     = ( ( y < height - 1 ) ? mip.getValue( cc, x, y + 1 ) : 0 );
+              T valDownLeft = ( ( x > 0 && ( y < height - 1 ) ) ? mip.getValue( cc, x - 1, y + 1 ) : 0 );
+              T newVal      = mean4w( val, w1, valLeft, w2, valDown, w3, valDownLeft, w4 );
+              image.setValue( cc, xUp, yUp, newVal );
+            }
+          } else {
+            w1 = 144;
+            w2 = ( x < width - 1 ? static_cast<unsigned char>( 48 ) : 0 );
+            w3 = ( y < height - 1 ? static_cast<unsigned char>( 48 ) : 0 );
+            w4 = ( ( ( x < width - 1 ) && ( y < height - 1 ) ) ? static_cast<unsigned char>( 16 ) : 0 );
+            for ( int cc = 0; cc < 3; cc++ ) {
+              T val          = mip.getValue( cc, x, y );
+              T valRight     = ( x < width - 1 ? mip.getValue( cc, x + 1, y ) : 0 );
+              T valDown      = ( ( y < height - 1 ) ? mip.getValue( cc, x, y + 1 ) : 0 );
+              T valDownRight = ( ( ( x < width - 1 ) && ( y < height - 1 ) ) ? mip.getValue( cc, x + 1, y + 1 ) : 0 );
+              T newVal       = mean4w( val, w1, valRight, w2, valDown, w3, valDownRight, w4 );
+              image.setValue( cc, xUp, yUp, newVal );
+            }
           }
         }
+      };
+      size_t done = 0;
+      if ( yUp % 2 == 0 ? y > 0 : y < height - 1 ) {
+        const int neighbor = yUp % 2 == 0 ? y - 1 : y + 1;
+        for ( size_t cc = 0; cc < 3; cc++ ) {
+          done = pushPullFillRowKernel( mip.getRow( cc, y ) + 1, mip.getRow( cc, neighbor ) + 1, width - 1,
+                                        occupancyMap.data() + widthUp * yUp + begin, image.getRow( cc, yUp ) + begin,
+                                        widthUp - begin );
+        }
       }
-    }
-  }
+      for ( size_t xUp = 0; xUp < begin; ++xUp ) { fillPixel( int( xUp ) ); }
+      for ( size_t xUp = begin + done; xUp < widthUp; ++xUp ) { fillPixel( int( xUp ) ); }
+    } );
+  } );
   auto tmpImage( image );
   for ( size_t n = 0; n < numIters; n++ ) {
-    for ( int y = 0; y < heightUp; y++ ) {
-      for ( int x = 0; x < widthUp; x++ ) {
-        if ( occupancyMap[x + widthUp * y] == 0 ) {
-          int x1 = ( x > 0 ) ? x - 1 : x;
-          int y1 = ( y > 0 ) ? y - 1 : y;
-          int x2 = ( x < widthUp - 1 ) ? x + 1 : x;
-          int y2 = ( y < heightUp - 1 ) ? y + 1 : y;
+    executionContext_->execute( [&] {
+      tbb::parallel_for( size_t( 0 ), heightUp, [&]( const size_t row ) {
+        const int y           = int( row );
+        int       y1          = ( y > 0 ) ? y - 1 : y;
+        int       y2          = ( y < heightUp - 1 ) ? y + 1 : y;
+        auto      smoothPixel = [&]( const int x ) {
+          if ( occupancyMap[x + widthUp * y] == 0 ) {
+            int x1 = ( x > 0 ) ? x - 1 : x;
+            int x2 = ( x < widthUp - 1 ) ? x + 1 : x;
+            for ( size_t c = 0; c < 3; c++ ) {
+              int val = image.getValue( c, x1, y1 ) + image.getValue( c, x2, y1 ) + image.getValue( c, x1, y2 ) +
+                        image.getValue( c, x2, y2 ) + image.getValue( c, x1, y ) + image.getValue( c, x2, y ) +
+                        image.getValue( c, x, y1 ) + image.getValue( c, x, y2 );
+              tmpImage.setValue( c, x, y, ( val + 4 ) >> 3 );
+            }
+          }
+        };
+        // the first and last columns are clamped
+        size_t done = 0;
+        if ( widthUp > 2 ) {
           for ( size_t c = 0; c < 3; c++ ) {
-            int val = image.getValue( c, x1, y1 ) + image.getValue( c, x2, y1 ) + image.getValue( c, x1, y2 ) +
-                      image.getValue( c, x2, y2 ) + image.getValue( c, x1, y ) + image.getValue( c, x2, y ) +
-                      image.getValue( c, x, y1 ) + image.getValue( c, x, y2 );
-            tmpImage.setValue( c, x, y, ( val + 4 ) >> 3 );
+            done = pushPullSmoothRowKernel( image.getRow( c, y1 ) + 1, image.getRow( c, y ) + 1,
+                                            image.getRow( c, y2 ) + 1, occupancyMap.data() + widthUp * y + 1,
+                                            tmpImage.getRow( c, y ) + 1, widthUp - 2 );
           }
         }
-      }
-    }
+        smoothPixel( 0 );
+        for ( size_t x = 1 + done; x < widthUp; ++x ) { smoothPixel( int( x ) ); }
+      } );
+    } );
     swap( image, tmpImage );
   }
 }
@@ -6505,26 +7008,28 @@ void PCCEncoder::dilateSmoothedPushPull( PCCFrameContext& frame, PCCImage<T, 3>&
 void PCCEncoder::presmoothPointCloudColor( PCCPointSet3& reconstruct, const PCCEncoderParameters params ) {
   const size_t            pointCount = reconstruct.getPointCount();
   PCCKdTree               kdtree( reconstruct );
-  PCCNNResult             result;
   std::vector<PCCColor3B> temp;
   temp.resize( pointCount );
   for ( size_t m = 0; m < pointCount; ++m ) { temp[m] = reconstruct.getColor( m ); }
-  tbb::task_arena limited( static_cast<int>( params.nbThread_ ) );
-  limited.execute( [&] {
+  executionContext_->execute( [&] {
     tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
       //  for (size_t i = 0; i < pointCount; ++i) {
-      PCCNNResult result;
       if ( reconstruct.getBoundaryPointType( i ) == 2 ) {
+        // the neighbors and luma values live in the thread's scratch arena, rewound after each point
+        auto&                                     threadArena = getThreadArena();
+        PCCArenaScope                             pointScope( threadArena );
+        PCCArenaVector<std::pair<size_t, double>> result{PCCArenaAllocator<std::pair<size_t, double>>( threadArena )};
+        PCCArenaVector<uint8_t>                   Lum{PCCArenaAllocator<uint8_t>( threadArena )};
         kdtree.searchRadius( reconstruct[i], params.neighborCountColorPreSmoothing_, params.radius2ColorPreSmoothing_,
                              result );
-        PCCVector3D          centroid( 0.0 );
-        size_t               neighborCount = 0;
-        std::vector<uint8_t> Lum;
-        for ( size_t r = 0; r < result.count(); ++r ) {
-          const double dist2 = result.dist( r );
+        Lum.reserve( result.size() );
+        PCCVector3D centroid( 0.0 );
+        size_t      neighborCount = 0;
+        for ( const auto& neighbor : result ) {
+          const double dist2 = neighbor.second;
           if ( dist2 > params.radius2ColorPreSmoothing_ ) { break; }
           ++neighborCount;
-          const size_t index = result.indices( r );
+          const size_t index = neighbor.first;
           PCCColor3B   color = reconstruct.getColor( index );
           centroid[0] += double( color[0] );
           centroid[1] += double( color[1] );
@@ -6540,7 +7045,7 @@ void PCCEncoder::presmoothPointCloudColor( PCCPointSet3& reconstruct, const PCCE
           }
 
           // Attribute characterization
-          double     H               = entropy( Lum, int( neighborCount ) );
+          double     H               = entropy( Lum.data(), int( neighborCount ) );
           PCCColor3B colorQP         = reconstruct.getColor( i );
           double     distToCentroid2 = 0;
           for ( size_t k = 0; k < 3; ++k ) { distToCentroid2 += abs( centroid[k] - double( colorQP[k] ) ); }
@@ -6556,7 +7061,7 @@ void PCCEncoder::presmoothPointCloudColor( PCCPointSet3& reconstruct, const PCCE
     } );
   } );
 
-  limited.execute( [&] {
+  executionContext_->execute( [&] {
     tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
       // for (size_t i = 0; i < pointCount; ++i) {
       reconstruct.setColor( i, temp[i] );
@@ -6568,6 +7073,7 @@ bool PCCEncoder::generateAttributeVideo( const PCCGroupOfFrames&     sources,
                                          PCCGroupOfFrames&           reconstructs,
                                          PCCContext&                 context,
                                          const PCCEncoderParameters& params ) {
+  PCC_PROFILE_ZONE( "attribute video" );
   auto& video = context.getVideoAttributesMultiple()[0];
   if ( params_.multipleStreams_ ) {
     video.resize( context.size() );
@@ -6576,60 +7082,68 @@ bool PCCEncoder::generateAttributeVideo( const PCCGroupOfFrames&     sources,
   } else {
     video.resize( context.size() * ( params.mapCountMinus1_ + 1 ) );
   }
-  bool ret = true;
-  for ( size_t i = 0; i < context.size(); i++ ) {
-    auto&  frame    = context[i].getTitleFrameContext();
-    size_t mapCount = params_.mapCountMinus1_ + 1;
-    sources[i].transferColors(
-        reconstructs[i],                                   // target
-        int32_t( params_.bestColorSearchRange_ ),          // searchRange
-        params_.rawPointsPatch_,                           // losslessAttribute,
-        params_.numNeighborsColorTransferFwd_,             // numNeighborsColorTransferFwd
-        params_.numNeighborsColorTransferBwd_,             // numNeighborsColorTransferBwd
-        params_.useDistWeightedAverageFwd_,                // useDistWeightedAverageFwd
-        params_.useDistWeightedAverageBwd_,                // useDistWeightedAverageBwd
-        params_.skipAvgIfIdenticalSourcePointPresentFwd_,  // skipAvgIfIdenticalSourcePointPresentFwd
-        params_.skipAvgIfIdenticalSourcePointPresentBwd_,  // skipAvgIfIdenticalSourcePointPresentBwd
-        params_.distOffsetFwd_,                            // distOffsetFwd
-        params_.distOffsetBwd_,                            // distOffsetBwd
-        params_.maxGeometryDist2Fwd_,                      // maxGeometryDist2Fwd
-        params_.maxGeometryDist2Bwd_,                      // maxGeometryDist2Bwd
-        params_.maxColorDist2Fwd_,                         // maxColorDist2Fwd
-        params_.maxColorDist2Bwd_,                         // maxColorDist2Bwd
-        params_.excludeColorOutlier_,                      // excludeColorOutlier
-        params_.thresholdColorOutlierDist_                 // thresholdColorOutlierDist
-    );
-    // color pre-smoothing
-    if ( params_.flagColorPreSmoothing_ ) { presmoothPointCloudColor( reconstructs[i], params ); }
-    size_t imageWidth  = frame.getWidth();
-    size_t imageHeight = frame.getHeight();
-    if ( params_.multipleStreams_ ) {
-      auto& image = video.getFrame( i );
-      image.resize( imageWidth, imageHeight, PCCCOLORFORMAT::RGB444 );
-      image.set( 0 );
-      auto& videoT1 = context.getVideoAttributesMultiple()[1];
-      auto& image1  = videoT1.getFrame( i );
-      image1.resize( imageWidth, imageHeight, PCCCOLORFORMAT::RGB444 );
-      image1.set( 0 );
-      size_t accTilePointCount = 0;
-      for ( size_t tileIdx = 0; tileIdx < context[i].getNumTilesInAtlasFrame(); tileIdx++ ) {
-        accTilePointCount =
-            generateAttributeVideo( reconstructs[i], context, i, tileIdx, video, videoT1, mapCount, accTilePointCount );
-      }
-    } else {
-      for ( size_t f = 0; f < mapCount; ++f ) {
-        auto& image = video.getFrame( f + mapCount * i );
+  // a frame only writes its own images and reconstruction: the frames are generated in parallel
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), context.size(), [&]( const size_t i ) {
+      auto&  frame    = context[i].getTitleFrameContext();
+      size_t mapCount = params_.mapCountMinus1_ + 1;
+      const auto&                            source       = sources.acquire( i );
+      const std::shared_ptr<const PCCKdTree> kdtreeSource = frame.getSpatialIndex().getKdTree( source );
+      source.transferColors(
+          reconstructs[i],                                   // target
+          int32_t( params_.bestColorSearchRange_ ),          // searchRange
+          params_.rawPointsPatch_,                           // losslessAttribute,
+          params_.numNeighborsColorTransferFwd_,             // numNeighborsColorTransferFwd
+          params_.numNeighborsColorTransferBwd_,             // numNeighborsColorTransferBwd
+          params_.useDistWeightedAverageFwd_,                // useDistWeightedAverageFwd
+          params_.useDistWeightedAverageBwd_,                // useDistWeightedAverageBwd
+          params_.skipAvgIfIdenticalSourcePointPresentFwd_,  // skipAvgIfIdenticalSourcePointPresentFwd
+          params_.skipAvgIfIdenticalSourcePointPresentBwd_,  // skipAvgIfIdenticalSourcePointPresentBwd
+          params_.distOffsetFwd_,                            // distOffsetFwd
+          params_.distOffsetBwd_,                            // distOffsetBwd
+          params_.maxGeometryDist2Fwd_,                      // maxGeometryDist2Fwd
+          params_.maxGeometryDist2Bwd_,                      // maxGeometryDist2Bwd
+          params_.maxColorDist2Fwd_,                         // maxColorDist2Fwd
+          params_.maxColorDist2Bwd_,                         // maxColorDist2Bwd
+          params_.excludeColorOutlier_,                      // excludeColorOutlier
+          params_.thresholdColorOutlierDist_,                // thresholdColorOutlierDist
+          kdtreeSource.get()                                 // kdtreeSource
+      );
+      // the last stage searching the source of the frame
+      frame.getSpatialIndex().clear();
+      sources.release( i );
+      // color pre-smoothing
+      if ( params_.flagColorPreSmoothing_ ) { presmoothPointCloudColor( reconstructs[i], params ); }
+      size_t imageWidth  = frame.getWidth();
+      size_t imageHeight = frame.getHeight();
+      if ( params_.multipleStreams_ ) {
+        auto& image = video.getFrame( i );
         image.resize( imageWidth, imageHeight, PCCCOLORFORMAT::RGB444 );
         image.set( 0 );
+        auto& videoT1 = context.getVideoAttributesMultiple()[1];
+        auto& image1  = videoT1.getFrame( i );
+        image1.resize( imageWidth, imageHeight, PCCCOLORFORMAT::RGB444 );
+        image1.set( 0 );
+        size_t accTilePointCount = 0;
+        for ( size_t tileIdx = 0; tileIdx < context[i].getNumTilesInAtlasFrame(); tileIdx++ ) {
+          accTilePointCount =
+              generateAttributeVideo( reconstructs[i], context, i, tileIdx, video, videoT1, mapCount, accTilePointCount );
+        }
+      } else {
+        for ( size_t f = 0; f < mapCount; ++f ) {
+          auto& image = video.getFrame( f + mapCount * i );
+          image.resize( imageWidth, imageHeight, PCCCOLORFORMAT::RGB444 );
+          image.set( 0 );
+        }
+        size_t accTilePointCount = 0;
+        for ( size_t tileIdx = 0; tileIdx < context[i].getNumTilesInAtlasFrame(); tileIdx++ ) {
+          accTilePointCount =
+              generateAttributeVideo( reconstructs[i], context, i, tileIdx, video, video, mapCount, accTilePointCount );
+        }
       }
-      size_t accTilePointCount = 0;
-      for ( size_t tileIdx = 0; tileIdx < context[i].getNumTilesInAtlasFrame(); tileIdx++ ) {
-        accTilePointCount =
-            generateAttributeVideo( reconstructs[i], context, i, tileIdx, video, video, mapCount, accTilePointCount );
-      }
-    }
-  }
-  return ret;
+    } );
+  } );
+  return true;
 }
 
 size_t PCCEncoder::generateAttributeVideo( const PCCPointSet3& reconstruct,
@@ -6907,6 +7421,8 @@ void PCCEncoder::generateGlobalPatches( PCCContext&    context,
                                         size_t         preIndex ) {
   auto& curPatches = context[frameIndex].getTile( tileIndex ).getPatches();
   assert( !curPatches.empty() );
+  PCCPatchRectGrid    grid( curPatches );
+  std::vector<size_t> candidates;
   for ( auto& globalPatchTrack : globalPatchTracks ) {
     auto& trackPatches = globalPatchTrack.second;  // !!!< <frameIndex, patchIndex> >;
     if ( trackPatches.empty() ) { continue; }
@@ -6914,9 +7430,10 @@ void PCCEncoder::generateGlobalPatches( PCCContext&    context,
     const auto& prePatch       = context[preGlobalPatch.first].getTile( tileIndex ).getPatches()[preGlobalPatch.second];
     float       thresholdIOU   = 0.2F;
     float       maxIou         = 0.0F;
-    int32_t     bestIdx        = -1;       // best matched patch index in curPatches;
-    int32_t     cId            = 0;        // patch index in curPatches;
-    for ( auto& curPatch : curPatches ) {  // curPatches; may be modified;
+    int32_t     bestIdx        = -1;  // best matched patch index in curPatches;
+    grid.query( prePatch, candidates );
+    for ( size_t cId : candidates ) {    // patch index in curPatches;
+      auto& curPatch = curPatches[cId];  // may be modified;
       if ( prePatch.getViewId() == curPatch.getViewId() && !( curPatch.getCurGPAPatchData().isMatched_ ) &&
            ( prePatch.getLodScaleX() == curPatch.getLodScaleX() &&
              prePatch.getLodScaleY() == curPatch.getLodScaleY() ) ) {
@@ -6925,10 +7442,9 @@ void PCCEncoder::generateGlobalPatches( PCCContext&    context,
         float iou     = computeIOU( preRect, curRect );
         if ( iou > maxIou ) {
           maxIou  = iou;
-          bestIdx = cId;
+          bestIdx = static_cast<int32_t>( cId );
         }
       }
-      cId++;
     }
     if ( maxIou > thresholdIOU ) {                                 // !!!best match found;
       curPatches[bestIdx].getCurGPAPatchData().isMatched_ = true;  // indicating the patch is already matched;
@@ -7833,6 +8349,7 @@ void PCCEncoder::setPostProcessingSeiParameters( GeneratePointCloudParameters& p
   params.radius2Smoothing_           = params_.radius2Smoothing_;
   params.radius2BoundaryDetection_   = params_.radius2BoundaryDetection_;
   params.thresholdSmoothing_         = params_.thresholdSmoothing_;
+  params.fixedPointSmoothing_        = params_.fixedPointSmoothing_;
   params.rawPointColorFormat_        = size_t( COLOURFORMAT420 );
   params.nbThread_                   = params_.nbThread_;
   params.absoluteD1_                 = params_.absoluteD1_;
@@ -7873,6 +8390,7 @@ void PCCEncoder::setGeneratePointCloudParameters( GeneratePointCloudParameters&
   params.radius2Smoothing_           = params_.radius2Smoothing_;
   params.radius2BoundaryDetection_   = params_.radius2BoundaryDetection_;
   params.thresholdSmoothing_         = params_.thresholdSmoothing_;
+  params.fixedPointSmoothing_        = params_.fixedPointSmoothing_;
   params.rawPointColorFormat_        = size_t( COLOURFORMAT420 );
   params.nbThread_                   = params_.nbThread_;
   params.absoluteD1_                 = params_.absoluteD1_;
@@ -8787,7 +9305,8 @@ void PCCEncoder::segmentationPartiallyAddtinalProjectionPlane( const PCCPointSet
     PCCPatchSegmenter3 segmenter;
     Orthogonal.reserve( 256 );
     float distanceSrcRecA;
-    segmenter.setNbThread( params_.nbThread_ );
+    segmenter.setExecutionContext( *executionContext_ );
+    segmenter.setSpatialIndex( frame.getSpatialIndex() );
     segmenter.compute( source, frame.getFrameIndex(), local, Orthogonal, frame.getSrcPointCloudByPatch(),
                        distanceSrcRecA );
     distanceSrcRec                  = distanceSrcRecA;
@@ -8804,7 +9323,7 @@ void PCCEncoder::segmentationPartiallyAddtinalProjectionPlane( const PCCPointSet
     PCCPatchSegmenter3 segmenter;
     Additional.reserve( 256 );
     float distanceSrcRecA;
-    segmenter.setNbThread( params_.nbThread_ );
+    segmenter.setExecutionContext( *executionContext_ );
     segmenter.compute( partial, frame.getFrameIndex(), local, Additional, frame.getSrcPointCloudByPatch(),
                        distanceSrcRecA );
     distanceSrcRec                  = distanceSrcRecA;
@@ -8828,17 +9347,3 @@ void PCCEncoder::segmentationPartiallyAddtinalProjectionPlane( const PCCPointSet
   std::copy( Additional.begin(), Additional.end(), std::back_inserter( patches ) );
 }
 
-inline uint64_t PCCEncoder::mortonAddr( const int32_t x, const int32_t y, const int32_t z ) {
-  uint64_t answer = g_kMortonCode256X[( x >> 16 ) & 0xFF] | g_kMortonCode256Y[( y >> 16 ) & 0xFF] |
-                    g_kMortonCode256Z[( z >> 16 ) & 0xFF];
-  answer = answer << 24 | g_kMortonCode256X[( x >> 8 ) & 0xFF] | g_kMortonCode256Y[( y >> 8 ) & 0xFF] |
-           g_kMortonCode256Z[( z >> 8 ) & 0xFF];
-  answer = answer << 24 | g_kMortonCode256X[x & 0xFF] | g_kMortonCode256Y[y & 0xFF] | g_kMortonCode256Z[z & 0xFF];
-  return answer;
-}
-uint64_t PCCEncoder::mortonAddr( const PCCPoint3D& vec, int depth ) {
-  int x = int( vec.x() ) >> depth;
-  int y = int( vec.y() ) >> depth;
-  int z = int( vec.z() ) >> depth;
-  return mortonAddr( x, y, z );
-}
@@ -35,6 +35,7 @@
 #include "PCCContext.h"
 #include "PCCFrameContext.h"
 #include "PCCVirtualVideoEncoder.h"
+#include "PCCSegmentationKernels.h"
 using namespace pcc;
 
 const std::vector<PointLocalReconstructionMode> g_pointLocalReconstructionMode = {
@@ -53,12 +54,17 @@ PCCEncoderParameters::PCCEncoderParameters() {
   startFrameNumber_                    = 0;
   frameCount_                          = 300;
   groupOfFramesSize_                   = 32;
+  frameWindowSize_                     = 0;
   colorTransform_                      = COLOR_TRANSFORM_NONE;
   colorSpaceConversionPath_            = {};
   colorSpaceConversionConfig_          = {};
   inverseColorSpaceConversionConfig_   = {};
   nnNormalEstimation_                  = 16;
   normalOrientation_                   = 1;
+  temporalNormals_                     = false;
+  maxFitErrorTemporalNormals_          = 0.005;
+  maxDist2TemporalNormals_             = 3.0;
+  deviceSegmentation_                  = false;
   forcedSsvhUnitSizePrecisionBytes_    = 0;
   gridBasedRefineSegmentation_         = true;
   maxNNCountRefineSegmentation_        = gridBasedRefineSegmentation_ ? ( gridBasedSegmentation_ ? 384 : 1024 ) : 256;
@@ -89,6 +95,7 @@ PCCEncoderParameters::PCCEncoderParameters() {
   patchExpansion_                      = false;
   gridSmoothing_                       = true;
   gridSize_                            = 8;
+  fixedPointSmoothing_                 = false;
   neighborCountSmoothing_              = 4 * 16;
   radius2Smoothing_                    = 4.0 * 16;
   radius2BoundaryDetection_            = 4.0 * 16;
@@ -117,10 +124,18 @@ PCCEncoderParameters::PCCEncoderParameters() {
   byteStreamVideoCoderOccupancy_           = true;
   byteStreamVideoCoderGeometry_            = true;
   byteStreamVideoCoderAttribute_           = true;
+  videoEncoderWavefront_                   = false;
+  videoEncoderTileColumns_                 = 1;
+  videoEncoderTileRows_                    = 1;
+  videoEncoderChunkFrames_                 = 0;
+  videoEncoderHardware_                    = "auto";
   geometryQP_                              = 28;
   attributeQP_                             = 43;
   auxGeometryQP_                           = 0;
   auxAttributeQP_                          = 0;
+  targetFrameBytes_                        = 0;
+  targetGeometryShare_                     = 0.;
+  targetTolerance_                         = 0.1;
   geometryConfig_                          = {};
   geometry0Config_                         = {};
   geometry1Config_                         = {};
@@ -134,6 +149,7 @@ PCCEncoderParameters::PCCEncoderParameters() {
   geometryAuxVideoConfig_                  = {};
   attributeAuxVideoConfig_                 = {};
   nbThread_                                = 1;
+  threadAffinity_                          = {};
   keepIntermediateFiles_                   = false;
   absoluteD1_                              = false;
   absoluteT1_                              = false;
@@ -167,6 +183,7 @@ PCCEncoderParameters::PCCEncoderParameters() {
   pointLocalReconstruction_   = false;
   plrlNumberOfModes_          = 6;
   patchSize_                  = 9;
+  plrEarlyTerminationDist_    = 0.0;
   singleMapPixelInterleaving_ = false;
   surfaceSeparation_          = false;
 
@@ -332,8 +349,10 @@ void PCCEncoderParameters::print() {
   std::cout << "\t mapCountMinus1                             " << mapCountMinus1_ << std::endl;
   std::cout << "\t startFrameNumber                           " << startFrameNumber_ << std::endl;
   std::cout << "\t groupOfFramesSize                          " << groupOfFramesSize_ << std::endl;
+  std::cout << "\t frameWindowSize                            " << frameWindowSize_ << std::endl;
   std::cout << "\t colorTransform                             " << colorTransform_ << std::endl;
   std::cout << "\t nbThread                                   " << nbThread_ << std::endl;
+  std::cout << "\t threadAffinity                             " << threadAffinity_ << std::endl;
   std::cout << "\t keepIntermediateFiles                      " << keepIntermediateFiles_ << std::endl;
   std::cout << "\t multipleStreams                            " << multipleStreams_ << std::endl;
   std::cout << "\t multipleStreams                            " << multipleStreams_ << std::endl;
@@ -354,6 +373,10 @@ void PCCEncoderParameters::print() {
   std::cout << "\t   voxelDimensionGridBasedSegmentation      " << voxelDimensionGridBasedSegmentation_ << std::endl;
   std::cout << "\t   nnNormalEstimation                       " << nnNormalEstimation_ << std::endl;
   std::cout << "\t   normalOrientation                        " << normalOrientation_ << std::endl;
+  std::cout << "\t   temporalNormals                          " << temporalNormals_ << std::endl;
+  std::cout << "\t   maxFitErrorTemporalNormals               " << maxFitErrorTemporalNormals_ << std::endl;
+  std::cout << "\t   maxDist2TemporalNormals                  " << maxDist2TemporalNormals_ << std::endl;
+  std::cout << "\t   deviceSegmentation                       " << deviceSegmentation_ << std::endl;
   std::cout << "\t   gridBasedRefineSegmentation              " << gridBasedRefineSegmentation_ << std::endl;
   std::cout << "\t   maxNNCountRefineSegmentation             " << maxNNCountRefineSegmentation_ << std::endl;
   std::cout << "\t   iterationCountRefineSegmentation         " << iterationCountRefineSegmentation_ << std::endl;
@@ -396,6 +419,11 @@ void PCCEncoderParameters::print() {
   std::cout << "\t Video encoding" << std::endl;
   std::cout << "\t   geometryQP                               " << geometryQP_ << std::endl;
   std::cout << "\t   attributeQP                              " << attributeQP_ << std::endl;
+  std::cout << "\t   targetFrameBytes                         " << targetFrameBytes_ << std::endl;
+  if ( targetFrameBytes_ > 0 ) {
+    std::cout << "\t   targetGeometryShare                      " << targetGeometryShare_ << std::endl;
+    std::cout << "\t   targetTolerance                          " << targetTolerance_ << std::endl;
+  }
   std::cout << "\t   usePccRDO                                " << usePccRDO_ << std::endl;
   std::cout << "\t   colorSpaceConversionPath                 " << colorSpaceConversionPath_ << std::endl;
   std::cout << "\t   videoEncoderOccupancyPath                " << videoEncoderOccupancyPath_ << std::endl;
@@ -404,6 +432,11 @@ void PCCEncoderParameters::print() {
   std::cout << "\t   videoEncoderOccupancyCodecId             " << videoEncoderOccupancyCodecId_ << std::endl;
   std::cout << "\t   videoEncoderGeometryCodecId              " << videoEncoderGeometryCodecId_ << std::endl;
   std::cout << "\t   videoEncoderAttributeCodecId             " << videoEncoderAttributeCodecId_ << std::endl;
+  std::cout << "\t   videoEncoderWavefront                    " << videoEncoderWavefront_ << std::endl;
+  std::cout << "\t   videoEncoderTileColumns                  " << videoEncoderTileColumns_ << std::endl;
+  std::cout << "\t   videoEncoderTileRows                     " << videoEncoderTileRows_ << std::endl;
+  std::cout << "\t   videoEncoderChunkFrames                  " << videoEncoderChunkFrames_ << std::endl;
+  std::cout << "\t   videoEncoderHardware                     " << videoEncoderHardware_ << std::endl;
   if ( multipleStreams_ ) {
     std::cout << "\t   geometry0Config                          " << geometry0Config_ << std::endl;
     std::cout << "\t   geometry1Config                          " << geometry1Config_ << std::endl;
@@ -451,6 +484,7 @@ void PCCEncoderParameters::print() {
     std::cout << "\t   gridSmoothing                            " << gridSmoothing_ << std::endl;
     if ( gridSmoothing_ ) {
       std::cout << "\t   gridSize                                 " << gridSize_ << std::endl;
+      std::cout << "\t   fixedPointSmoothing                      " << fixedPointSmoothing_ << std::endl;
       std::cout << "\t   thresholdSmoothing                       " << thresholdSmoothing_ << std::endl;
     } else {
       std::cout << "\t   neighborCountSmoothing                   " << neighborCountSmoothing_ << std::endl;
@@ -500,6 +534,7 @@ void PCCEncoderParameters::print() {
   std::cout << "\t   pointLocalReconstruction                 " << pointLocalReconstruction_ << std::endl;
   std::cout << "\t     plrlNumberOfModes                      " << plrlNumberOfModes_ << std::endl;
   std::cout << "\t     patchSize                              " << patchSize_ << std::endl;
+  std::cout << "\t     plrEarlyTerminationDist                " << plrEarlyTerminationDist_ << std::endl;
   std::cout << "\t   singleMapPixelInterleaving               " << singleMapPixelInterleaving_ << std::endl;
   std::cout << "\t   rawPointReconstruction                   " << reconstructRawType_ << std::endl;
   std::cout << "\t   eomPointReconstruction                   " << reconstructEomType_ << std::endl;
@@ -805,6 +840,14 @@ bool PCCEncoderParameters::check() {
     levelOfDetailY_ = 1;
     std::cerr << "scaling is not allowed in lossless case\n";
   }
+  if ( targetFrameBytes_ > 0 && rawPointsPatch_ ) {
+    targetFrameBytes_ = 0;
+    std::cerr << "targetFrameBytes is ignored in lossless case\n";
+  }
+  if ( targetGeometryShare_ < 0. || targetGeometryShare_ >= 1. ) {
+    std::cerr << "targetGeometryShare must be in [0, 1) \n";
+    ret = false;
+  }
   if ( enablePointCloudPartitioning_ && patchExpansion_ ) {
     std::cerr << "Point cloud partitioning does not currently support patch expansion. \n";
   }
@@ -920,6 +963,15 @@ bool PCCEncoderParameters::check() {
     std::cerr << "WARNING: the normal orientation is out of the possible range [0;3]\n";
     normalOrientation_ = 1;
   }
+  if ( temporalNormals_ && additionalProjectionPlaneMode_ == 5 ) {
+    std::cerr << "WARNING: temporalNormals is not supported with the partial additional projection plane\n";
+    temporalNormals_ = false;
+  }
+  if ( deviceSegmentation_ && !segmentationDeviceAvailable() ) {
+    std::cerr << "WARNING: deviceSegmentation needs a CUDA device and an encoder built with USE_CUDA. Force "
+                 "deviceSegmentation_=FALSE.\n";
+    deviceSegmentation_ = false;
+  }
   if ( !absoluteT1_ && absoluteD1_ ) {
     std::cerr << "absoluteT1 should be true when absoluteD1 is true\n";
     absoluteT1_ = 1;
@@ -1176,14 +1228,22 @@ bool PCCEncoderParameters::check() {
     case CODEC_GROUP_HEVC444:
     case CODEC_GROUP_HEVC_MAIN10:
 #if defined( USE_HMAPP_VIDEO_CODEC ) || defined( USE_HMLIB_VIDEO_CODEC )
-      if ( ( videoEncoderOccupancyCodecId_ != HMLIB && videoEncoderOccupancyCodecId_ != HMAPP ) ||
-           ( videoEncoderGeometryCodecId_ != HMLIB && videoEncoderGeometryCodecId_ != HMAPP ) ||
-           ( videoEncoderAttributeCodecId_ != HMLIB && videoEncoderAttributeCodecId_ != HMAPP ) ) {
+    {
+      // the libavcodec encoders code HEVC too
+      auto isHevc = []( PCCCodecId codecId ) {
+#ifdef USE_FFMPEG_VIDEO_CODEC
+        if ( codecId == FFMPEG ) { return true; }
+#endif
+        return codecId == HMLIB || codecId == HMAPP;
+      };
+      if ( !isHevc( videoEncoderOccupancyCodecId_ ) || !isHevc( videoEncoderGeometryCodecId_ ) ||
+           !isHevc( videoEncoderAttributeCodecId_ ) ) {
         std::cerr << "profileCodecGroupIdc_ is HEVC444 or HEVCMAIN10 force codecId. \n";
         videoEncoderOccupancyCodecId_ = HMLIB;
         videoEncoderGeometryCodecId_  = HMLIB;
         videoEncoderAttributeCodecId_ = HMLIB;
       }
+    }
 #else
       std::cerr << "profileCodecGroupIdc_ is HEVC444 or HEVCMAIN10, not supported. \n";
       ret = false;
@@ -1221,6 +1281,15 @@ bool PCCEncoderParameters::check() {
     std::cerr << "SHMAPP codec requiered shvcRateX and shvcRateY equal to 2. \n";
     ret = false;
   }
+  if ( videoEncoderTileColumns_ == 0 || videoEncoderTileRows_ == 0 ) {
+    std::cerr << "videoEncoderTileColumns and videoEncoderTileRows must be at least 1. \n";
+    ret = false;
+  }
+  if ( videoEncoderWavefront_ && videoEncoderTileColumns_ * videoEncoderTileRows_ > 1 ) {
+    // HEVC Main and Main 10 do not allow both at the same time
+    std::cerr << "videoEncoderWavefront can not be used with videoEncoderTileColumns or videoEncoderTileRows. \n";
+    ret = false;
+  }
 
   return ret;
 }
@@ -1276,6 +1345,36 @@ uint8_t PCCEncoderParameters::getCodecIdIndex( PCCCodecId codecId ) {
   return 0;
 }
 
+bool PCCEncoderParameters::samePacking( const PCCEncoderParameters& other ) const {
+  // the occupancy precision only changes the packing when it refines the patches, or rounds the atlas size for JM
+#ifdef USE_JMAPP_VIDEO_CODEC
+  const bool precision = occupancyMapRefinement_ || videoEncoderOccupancyCodecId_ == JMAPP;
+#else
+  const bool precision = occupancyMapRefinement_;
+#endif
+  return occupancyResolution_ == other.occupancyResolution_ &&
+         occupancyMapRefinement_ == other.occupancyMapRefinement_ &&
+         ( !precision || occupancyPrecision_ == other.occupancyPrecision_ ) &&
+         videoEncoderOccupancyCodecId_ == other.videoEncoderOccupancyCodecId_ &&
+         minimumImageWidth_ == other.minimumImageWidth_ && minimumImageHeight_ == other.minimumImageHeight_ &&
+         packingStrategy_ == other.packingStrategy_ && safeGuardDistance_ == other.safeGuardDistance_ &&
+         useEightOrientations_ == other.useEightOrientations_ && lowDelayEncoding_ == other.lowDelayEncoding_ &&
+         constrainedPack_ == other.constrainedPack_ && globalPatchAllocation_ == other.globalPatchAllocation_ &&
+         globalPackingStrategyGOF_ == other.globalPackingStrategyGOF_ &&
+         globalPackingStrategyReset_ == other.globalPackingStrategyReset_ &&
+         globalPackingStrategyThreshold_ == other.globalPackingStrategyThreshold_ &&
+         maxNumRefAtlasFrame_ == other.maxNumRefAtlasFrame_ && levelOfDetailX_ == other.levelOfDetailX_ &&
+         levelOfDetailY_ == other.levelOfDetailY_ && enhancedOccupancyMapCode_ == other.enhancedOccupancyMapCode_ &&
+         rawPointsPatch_ == other.rawPointsPatch_ && lossyRawPointsPatch_ == other.lossyRawPointsPatch_ &&
+         useRawPointsSeparateVideo_ == other.useRawPointsSeparateVideo_ &&
+         enablePointCloudPartitioning_ == other.enablePointCloudPartitioning_ && numROIs_ == other.numROIs_ &&
+         numTilesHor_ == other.numTilesHor_ && tileHeightToWidthRatio_ == other.tileHeightToWidthRatio_ &&
+         tileSegmentationType_ == other.tileSegmentationType_ && numMaxTilePerFrame_ == other.numMaxTilePerFrame_ &&
+         tilePartitionWidth_ == other.tilePartitionWidth_ && tilePartitionHeight_ == other.tilePartitionHeight_ &&
+         tilePartitionWidthList_ == other.tilePartitionWidthList_ &&
+         tilePartitionHeightList_ == other.tilePartitionHeightList_;
+}
+
 void PCCEncoderParameters::initializeContext( PCCContext& context ) {
   size_t  numAtlas   = 1;
   size_t  atlasIndex = 0;
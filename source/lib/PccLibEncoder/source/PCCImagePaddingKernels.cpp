@@ -0,0 +1,239 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCImagePaddingKernels.h"
+#include "PCCColorConverterKernels.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#define PCC_KERNELS_AVX2
+#include <immintrin.h>
+#if defined( _MSC_VER )
+#define PCC_TARGET_AVX2
+#else
+#define PCC_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#endif
+#endif
+
+using namespace pcc;
+
+#ifdef PCC_KERNELS_AVX2
+
+PCC_TARGET_AVX2 static inline __m256i load8( const uint8_t* src ) {
+  return _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)src ) );
+}
+
+PCC_TARGET_AVX2 static inline __m256i load8( const uint16_t* src ) {
+  return _mm256_cvtepu16_epi32( _mm_loadu_si128( (const __m128i*)src ) );
+}
+
+PCC_TARGET_AVX2 static inline __m256i load8( const uint32_t* src ) {
+  return _mm256_loadu_si256( (const __m256i*)src );
+}
+
+// src[2i] in the low and src[2i + 1] in the high 16 bits of lane i
+PCC_TARGET_AVX2 static inline __m256i loadPairs( const uint8_t* src ) {
+  return _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*)src ) );
+}
+
+PCC_TARGET_AVX2 static inline __m256i loadPairs( const uint16_t* src ) {
+  return _mm256_loadu_si256( (const __m256i*)src );
+}
+
+PCC_TARGET_AVX2 static inline void store8( uint8_t* dst, __m256i value ) {
+  __m128i packed = _mm_packus_epi32( _mm256_castsi256_si128( value ), _mm256_extracti128_si256( value, 1 ) );
+  _mm_storel_epi64( (__m128i*)dst, _mm_packus_epi16( packed, packed ) );
+}
+
+PCC_TARGET_AVX2 static inline void store8( uint16_t* dst, __m256i value ) {
+  _mm_storeu_si128( (__m128i*)dst,
+                    _mm_packus_epi32( _mm256_castsi256_si128( value ), _mm256_extracti128_si256( value, 1 ) ) );
+}
+
+// masks of the unoccupied occupancy[2i] and occupancy[2i + 1], i < 8
+PCC_TARGET_AVX2 static inline void unoccupiedPairs( const uint32_t* occupancy, __m256i& even, __m256i& odd ) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256  low  = _mm256_castsi256_ps( _mm256_cmpeq_epi32( load8( occupancy ), zero ) );
+  const __m256  high = _mm256_castsi256_ps( _mm256_cmpeq_epi32( load8( occupancy + 8 ), zero ) );
+  // [ l0 l2 h0 h2 | l4 l6 h4 h6 ] to [ l0 l2 l4 l6 | h0 h2 h4 h6 ]
+  even = _mm256_permute4x64_epi64( _mm256_castps_si256( _mm256_shuffle_ps( low, high, _MM_SHUFFLE( 2, 0, 2, 0 ) ) ),
+                                   _MM_SHUFFLE( 3, 1, 2, 0 ) );
+  odd  = _mm256_permute4x64_epi64( _mm256_castps_si256( _mm256_shuffle_ps( low, high, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ),
+                                  _MM_SHUFFLE( 3, 1, 2, 0 ) );
+}
+
+template <typename T>
+PCC_TARGET_AVX2 static size_t pushPullMipRowAvx2( const T*        src0,
+                                                  const T*        src1,
+                                                  const uint32_t* occupancy0,
+                                                  const uint32_t* occupancy1,
+                                                  T*              dst,
+                                                  size_t          count ) {
+  const __m256i low8 = _mm256_set1_epi32( 0xFF );
+  const __m256i zero = _mm256_setzero_si256();
+  size_t        x    = 0;
+  for ( ; x + 8 <= count; x += 8 ) {
+    const __m256i pairs0 = loadPairs( src0 + 2 * x );
+    const __m256i pairs1 = loadPairs( src1 + 2 * x );
+    __m256i       empty[4];
+    unoccupiedPairs( occupancy0 + 2 * x, empty[0], empty[1] );
+    unoccupiedPairs( occupancy1 + 2 * x, empty[2], empty[3] );
+    const __m256i samples[4] = {
+        _mm256_and_si256( pairs0, low8 ), _mm256_and_si256( _mm256_srli_epi32( pairs0, 16 ), low8 ),
+        _mm256_and_si256( pairs1, low8 ), _mm256_and_si256( _mm256_srli_epi32( pairs1, 16 ), low8 )};
+    __m256i sum      = zero;
+    __m256i occupied = _mm256_set1_epi32( 4 );
+    for ( size_t k = 0; k < 4; k++ ) {
+      sum      = _mm256_add_epi32( sum, _mm256_andnot_si256( empty[k], samples[k] ) );
+      occupied = _mm256_add_epi32( occupied, empty[k] );
+    }
+    // the mean is below 256, so the float quotient truncates to the integer one
+    const __m256i mean =
+        _mm256_cvttps_epi32( _mm256_div_ps( _mm256_cvtepi32_ps( sum ), _mm256_cvtepi32_ps( occupied ) ) );
+    store8( dst + x, _mm256_blendv_epi8( mean, load8( dst + x ), _mm256_cmpeq_epi32( occupied, zero ) ) );
+  }
+  return x;
+}
+
+template <typename T>
+PCC_TARGET_AVX2 static size_t pushPullFillRowAvx2( const T*        mip,
+                                                   const T*        mipNeighbor,
+                                                   size_t          mipCount,
+                                                   const uint32_t* occupancy,
+                                                   T*              dst,
+                                                   size_t          count ) {
+  // lanes of mip[j / 2 - 1 + k] to m and mh of the outputs j to j + 7
+  const __m256i center = _mm256_setr_epi32( 1, 1, 2, 2, 3, 3, 4, 4 );
+  const __m256i side   = _mm256_setr_epi32( 0, 2, 1, 3, 2, 4, 3, 5 );
+  const __m256i zero   = _mm256_setzero_si256();
+  size_t        j      = 0;
+  for ( ; j + 8 <= count && j / 2 + 7 <= mipCount; j += 8 ) {
+    const __m256i m  = load8( mip + j / 2 - 1 );
+    const __m256i n  = load8( mipNeighbor + j / 2 - 1 );
+    const __m256i mc = _mm256_permutevar8x32_epi32( m, center );
+    const __m256i nc = _mm256_permutevar8x32_epi32( n, center );
+    const __m256i ms = _mm256_permutevar8x32_epi32( m, side );
+    const __m256i ns = _mm256_permutevar8x32_epi32( n, side );
+    // ( 144 * m + 48 * mh + 48 * n + 16 * nh ) >> 8 = ( 9 * m + 3 * ( mh + n ) + nh ) >> 4
+    const __m256i cross = _mm256_add_epi32( ms, nc );
+    __m256i       value = _mm256_add_epi32( _mm256_add_epi32( _mm256_slli_epi32( mc, 3 ), mc ),
+                                      _mm256_add_epi32( _mm256_slli_epi32( cross, 1 ), cross ) );
+    value               = _mm256_srli_epi32( _mm256_add_epi32( value, ns ), 4 );
+    const __m256i empty = _mm256_cmpeq_epi32( load8( occupancy + j ), zero );
+    store8( dst + j, _mm256_blendv_epi8( load8( dst + j ), value, empty ) );
+  }
+  return j;
+}
+
+template <typename T>
+PCC_TARGET_AVX2 static size_t pushPullSmoothRowAvx2( const T*        above,
+                                                     const T*        row,
+                                                     const T*        below,
+                                                     const uint32_t* occupancy,
+                                                     T*              dst,
+                                                     size_t          count ) {
+  const __m256i four = _mm256_set1_epi32( 4 );
+  const __m256i zero = _mm256_setzero_si256();
+  size_t        j    = 0;
+  for ( ; j + 8 <= count; j += 8 ) {
+    __m256i sum = _mm256_add_epi32( load8( row + j - 1 ), load8( row + j + 1 ) );
+    sum = _mm256_add_epi32( sum, _mm256_add_epi32( _mm256_add_epi32( load8( above + j - 1 ), load8( above + j ) ),
+                                                 load8( above + j + 1 ) ) );
+    sum = _mm256_add_epi32( sum, _mm256_add_epi32( _mm256_add_epi32( load8( below + j - 1 ), load8( below + j ) ),
+                                                 load8( below + j + 1 ) ) );
+    const __m256i value = _mm256_srli_epi32( _mm256_add_epi32( sum, four ), 3 );
+    const __m256i empty = _mm256_cmpeq_epi32( load8( occupancy + j ), zero );
+    store8( dst + j, _mm256_blendv_epi8( load8( dst + j ), value, empty ) );
+  }
+  return j;
+}
+
+#define PCC_DISPATCH( call ) return hasAvx2() ? call : 0
+
+#else  // PCC_KERNELS_AVX2
+
+#define PCC_DISPATCH( call ) return 0
+
+#endif  // PCC_KERNELS_AVX2
+
+size_t pcc::pushPullMipRowKernel( const uint8_t*  src0,
+                                  const uint8_t*  src1,
+                                  const uint32_t* occupancy0,
+                                  const uint32_t* occupancy1,
+                                  uint8_t*        dst,
+                                  size_t          count ) {
+  PCC_DISPATCH( pushPullMipRowAvx2( src0, src1, occupancy0, occupancy1, dst, count ) );
+}
+
+size_t pcc::pushPullMipRowKernel( const uint16_t* src0,
+                                  const uint16_t* src1,
+                                  const uint32_t* occupancy0,
+                                  const uint32_t* occupancy1,
+                                  uint16_t*       dst,
+                                  size_t          count ) {
+  PCC_DISPATCH( pushPullMipRowAvx2( src0, src1, occupancy0, occupancy1, dst, count ) );
+}
+
+size_t pcc::pushPullFillRowKernel( const uint8_t*  mip,
+                                   const uint8_t*  mipNeighbor,
+                                   size_t          mipCount,
+                                   const uint32_t* occupancy,
+                                   uint8_t*        dst,
+                                   size_t          count ) {
+  PCC_DISPATCH( pushPullFillRowAvx2( mip, mipNeighbor, mipCount, occupancy, dst, count ) );
+}
+
+size_t pcc::pushPullFillRowKernel( const uint16_t* mip,
+                                   const uint16_t* mipNeighbor,
+                                   size_t          mipCount,
+                                   const uint32_t* occupancy,
+                                   uint16_t*       dst,
+                                   size_t          count ) {
+  PCC_DISPATCH( pushPullFillRowAvx2( mip, mipNeighbor, mipCount, occupancy, dst, count ) );
+}
+
+size_t pcc::pushPullSmoothRowKernel( const uint8_t*  above,
+                                     const uint8_t*  row,
+                                     const uint8_t*  below,
+                                     const uint32_t* occupancy,
+                                     uint8_t*        dst,
+                                     size_t          count ) {
+  PCC_DISPATCH( pushPullSmoothRowAvx2( above, row, below, occupancy, dst, count ) );
+}
+
+size_t pcc::pushPullSmoothRowKernel( const uint16_t* above,
+                                     const uint16_t* row,
+                                     const uint16_t* below,
+                                     const uint32_t* occupancy,
+                                     uint16_t*       dst,
+                                     size_t          count ) {
+  PCC_DISPATCH( pushPullSmoothRowAvx2( above, row, below, occupancy, dst, count ) );
+}
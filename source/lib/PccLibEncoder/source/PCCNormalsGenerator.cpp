@@ -35,6 +35,8 @@
 #include "PCCKdTree.h"
 #include "tbb/tbb.h"
 #include "PCCNormalsGenerator.h"
+#include "PCCExecutionContext.h"
+#include "PCCSegmentationKernels.h"
 
 #include "PCCImage.h"
 
@@ -61,18 +63,47 @@ void PCCNormalsGenerator3::init( const size_t pointCount, const PCCNormalsGenera
 void PCCNormalsGenerator3::compute( const PCCPointSet3&                   pointCloud,
                                     const PCCKdTree&                      kdtree,
                                     const PCCNormalsGenerator3Parameters& params,
-                                    const size_t                          nbThread ) {
-  nbThread_ = nbThread;
+                                    PCCExecutionContext&                  executionContext ) {
+  executionContext_ = &executionContext;
   init( pointCloud.getPointCount(), params );
   computeNormals( pointCloud, kdtree, params );
   if ( params.numberOfIterationsInNormalSmoothing_ != 0u ) { smoothNormals( pointCloud, kdtree, params ); }
   orientNormals( pointCloud, kdtree, params );
 }
-void PCCNormalsGenerator3::computeNormal( const size_t                          index,
+void PCCNormalsGenerator3::compute( const PCCPointSet3&                   pointCloud,
+                                    const PCCKdTree&                      kdtree,
+                                    const PCCNormalsGenerator3Parameters& params,
+                                    PCCExecutionContext&                  executionContext,
+                                    PCCNormalsReference&                  reference ) {
+  const size_t pointCount = pointCloud.getPointCount();
+  if ( reference.normals_.empty() ) {
+    compute( pointCloud, kdtree, params, executionContext );
+    seededNormalCount_ = 0;
+  } else {
+    executionContext_ = &executionContext;
+    init( pointCount, params );
+    computeNormals( pointCloud, kdtree, params, &reference );
+    if ( params.numberOfIterationsInNormalSmoothing_ != 0u ) { smoothNormals( pointCloud, kdtree, params ); }
+    // the seeded normals are oriented as in the previous frame: the spanning tree only grows from them into the
+    // recomputed ones, instead of over the whole frame, and no longer flips the frame to face the view point
+    if ( params.orientationStrategy_ == PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE ||
+         params.orientationStrategy_ == PCC_NORMALS_GENERATOR_ORIENTATION_CUBEMAP_PROJECTION ) {
+      orientUnvisitedNormals( pointCloud, kdtree, params );
+    } else {
+      orientNormals( pointCloud, kdtree, params );
+    }
+  }
+  reference.points_.clear();
+  reference.points_.resize( pointCount );
+  for ( size_t i = 0; i < pointCount; ++i ) { reference.points_[i] = pointCloud[i]; }
+  reference.normals_ = normals_;
+}
+bool PCCNormalsGenerator3::computeNormal( const size_t                          index,
                                           const PCCPointSet3&                   pointCloud,
                                           const PCCKdTree&                      kdtree,
                                           const PCCNormalsGenerator3Parameters& params,
-                                          PCCNNResult&                          nNResult ) {
+                                          PCCNNResult&                          nNResult,
+                                          const PCCVector3D*                    seed ) {
   PCCVector3D bary( pointCloud[index][0], pointCloud[index][1], pointCloud[index][2] );
   PCCVector3D normal( 0.0 );
   PCCVector3D eigenval( 0.0 );
@@ -100,6 +131,41 @@ void PCCNormalsGenerator3::computeNormal( const size_t
     covMat[2][1] = covMat[1][2];
     covMat /= ( nNResult.count() - 1.0 );
 
+    if ( seed != nullptr && !params.storeEigenvalues_ ) {
+      // variance of the neighborhood off the plane of the seed, in excess of that off the best plane (the smallest
+      // eigenvalue, in closed form), against the total variance
+      double offPlane = 0.0;
+      for ( size_t i = 0; i < 3; ++i ) {
+        for ( size_t j = 0; j < 3; ++j ) { offPlane += ( *seed )[i] * covMat[i][j] * ( *seed )[j]; }
+      }
+      const double trace  = covMat[0][0] + covMat[1][1] + covMat[2][2];
+      const double q      = trace / 3.0;
+      const double p1     = covMat[0][1] * covMat[0][1] + covMat[0][2] * covMat[0][2] + covMat[1][2] * covMat[1][2];
+      const double p      = std::sqrt( ( ( covMat[0][0] - q ) * ( covMat[0][0] - q ) +
+                                    ( covMat[1][1] - q ) * ( covMat[1][1] - q ) +
+                                    ( covMat[2][2] - q ) * ( covMat[2][2] - q ) + 2.0 * p1 ) /
+                                  6.0 );
+      double       minEig = q;
+      if ( p > 0.0 ) {
+        PCCMatrix3D b = covMat;
+        for ( size_t i = 0; i < 3; ++i ) { b[i][i] -= q; }
+        b /= p;
+        const double r = 0.5 * ( b[0][0] * ( b[1][1] * b[2][2] - b[1][2] * b[2][1] ) -
+                                 b[0][1] * ( b[1][0] * b[2][2] - b[1][2] * b[2][0] ) +
+                                 b[0][2] * ( b[1][0] * b[2][1] - b[1][1] * b[2][0] ) );
+        const double phi = std::acos( ( std::max )( -1.0, ( std::min )( 1.0, r ) ) ) / 3.0;
+        minEig           = q + 2.0 * p * std::cos( phi + 2.0 * std::acos( -1.0 ) / 3.0 );
+      }
+      if ( offPlane - minEig <= params.maxFitErrorTemporal_ * trace ) {
+        normals_[index] = *seed;
+        if ( params.storeCentroids_ ) { barycenters_[index] = bary; }
+        if ( params.storeNumberOfNearestNeighborsInNormalEstimation_ ) {
+          numberOfNearestNeighborsInNormalEstimation_[index] = uint32_t( nNResult.count() );
+        }
+        return true;
+      }
+    }
+
     PCCDiagonalize( covMat, Q, D );
 
     D[0][0] = fabs( D[0][0] );
@@ -154,26 +220,54 @@ void PCCNormalsGenerator3::computeNormal( const size_t
   if ( params.storeNumberOfNearestNeighborsInNormalEstimation_ ) {
     numberOfNearestNeighborsInNormalEstimation_[index] = uint32_t( nNResult.count() );
   }
+  return false;
 }
 void PCCNormalsGenerator3::computeNormals( const PCCPointSet3&                   pointCloud,
                                            const PCCKdTree&                      kdtree,
-                                           const PCCNormalsGenerator3Parameters& params ) {
+                                           const PCCNormalsGenerator3Parameters& params,
+                                           const PCCNormalsReference*            reference ) {
   const size_t pointCount = pointCloud.getPointCount();
   normals_.resize( pointCount );
+  if ( useDevice_ && reference == nullptr && !params.storeEigenvalues_ && !params.storeCentroids_ &&
+       !params.storeNumberOfNearestNeighborsInNormalEstimation_ && pointCount != 0 ) {
+    static_assert( sizeof( PCCPoint3D ) == 3 * sizeof( int16_t ), "positions are packed xyz triplets" );
+    static_assert( sizeof( PCCVector3D ) == 3 * sizeof( double ), "normals are packed xyz triplets" );
+    const double viewPoint[3] = {params.viewPoint_[0], params.viewPoint_[1], params.viewPoint_[2]};
+    if ( computeNormalsKernel( &pointCloud[0][0], pointCount, params.numberOfNearestNeighborsInNormalEstimation_,
+                               viewPoint, &normals_[0][0] ) ) {
+      seededNormalCount_ = 0;
+      return;
+    }
+  }
   std::vector<size_t> subRanges;
   const size_t        chunckCount = 64;
   PCCDivideRange( 0, pointCount, chunckCount, subRanges );
-  tbb::task_arena limited( static_cast<int>( nbThread_ ) );
-  limited.execute( [&] {
+  // the seeded points are the visited ones for the orientation
+  PCCKdTree referenceKdtree;
+  if ( reference != nullptr ) {
+    referenceKdtree.init( reference->points_ );
+    visited_.resize( pointCount );
+    std::fill( visited_.begin(), visited_.end(), 0 );
+  }
+  executionContext_->execute( [&] {
     tbb::parallel_for( size_t( 0 ), subRanges.size() - 1, [&]( const size_t i ) {
       const size_t start = subRanges[i];
       const size_t end   = subRanges[i + 1];
       PCCNNResult  nNResult;
+      PCCNNResult  referenceResult;
       for ( size_t ptIndex = start; ptIndex < end; ++ptIndex ) {
-        computeNormal( ptIndex, pointCloud, kdtree, params, nNResult );
+        const PCCVector3D* seed = nullptr;
+        if ( reference != nullptr ) {
+          referenceKdtree.search( pointCloud[ptIndex], 1, referenceResult );
+          if ( referenceResult.dist( 0 ) <= params.maxDist2Temporal_ ) {
+            seed = &reference->normals_[referenceResult.indices( 0 )];
+          }
+        }
+        if ( computeNormal( ptIndex, pointCloud, kdtree, params, nNResult, seed ) ) { visited_[ptIndex] = 1; }
       }
     } );
   } );
+  seededNormalCount_ = reference != nullptr ? std::count( visited_.begin(), visited_.end(), 1u ) : 0;
 }
 void PCCNormalsGenerator3::orientNormals( const PCCPointSet3&                   pointCloud,
                                           const PCCKdTree&                      kdtree,
@@ -189,41 +283,9 @@ void PCCNormalsGenerator3::orientNormals( const PCCPointSet3&
 #endif
   if ( params.orientationStrategy_ == PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE ) {
     const size_t pointCount = pointCloud.getPointCount();
-    PCCNNResult  nNResult;
     visited_.resize( pointCount );
     std::fill( visited_.begin(), visited_.end(), 0 );
-    PCCNNQuery3 nNQuery  = {PCCPoint3D( 0.0 ),
-                           static_cast<float>( params.radiusNormalOrientation_ ) * params.radiusNormalOrientation_,
-                           params.numberOfNearestNeighborsInNormalOrientation_};
-    PCCNNQuery3 nNQuery2 = {PCCPoint3D( 0.0 ), ( std::numeric_limits<float>::max )(),
-                            params.numberOfNearestNeighborsInNormalOrientation_};
-    for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
-      if ( visited_[ptIndex] == 0u ) {
-        visited_[ptIndex] = 1;
-        size_t      numberOfNormals;
-        PCCVector3D accumulatedNormals;
-        addNeighbors( uint32_t( ptIndex ), pointCloud, kdtree, nNQuery2, nNResult, accumulatedNormals,
-                      numberOfNormals );
-        if ( numberOfNormals == 0u ) {
-          if ( ptIndex != 0u ) {
-            accumulatedNormals = normals_[ptIndex - 1];
-          } else {
-            accumulatedNormals = ( params.viewPoint_ - pointCloud[ptIndex] );
-          }
-        }
-        if ( normals_[ptIndex] * accumulatedNormals < 0.0 ) { normals_[ptIndex] = -normals_[ptIndex]; }
-        while ( !edges_.empty() ) {
-          PCCWeightedEdge edge = edges_.top();
-          edges_.pop();
-          uint32_t current = edge.end_;
-          if ( visited_[current] == 0u ) {
-            visited_[current] = 1;
-            if ( normals_[edge.start_] * normals_[current] < 0.0 ) { normals_[current] = -normals_[current]; }
-            addNeighbors( current, pointCloud, kdtree, nNQuery, nNResult, accumulatedNormals, numberOfNormals );
-          }
-        }
-      }
-    }
+    orientUnvisitedNormals( pointCloud, kdtree, params );
     size_t negNormalCount = 0;
     for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
       negNormalCount +=
@@ -243,8 +305,7 @@ void PCCNormalsGenerator3::orientNormals( const PCCPointSet3&
 #endif
   } else if ( params.orientationStrategy_ == PCC_NORMALS_GENERATOR_ORIENTATION_VIEW_POINT ) {
     const size_t    pointCount = pointCloud.getPointCount();
-    tbb::task_arena limited( static_cast<int>( nbThread_ ) );
-    limited.execute( [&] {
+    executionContext_->execute( [&] {
       tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t ptIndex ) {
         if ( normals_[ptIndex] * ( params.viewPoint_ - pointCloud[ptIndex] ) < 0.0 ) {
           normals_[ptIndex] = -normals_[ptIndex];
@@ -464,33 +525,7 @@ void PCCNormalsGenerator3::orientNormals( const PCCPointSet3&
     }
     saveNormal3.write( "normal_projection_orientation_smoothed.ply" );
 #endif
-    for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
-      if ( visited_[ptIndex] == 0u ) {
-        visited_[ptIndex] = 1;
-        size_t      numberOfNormals;
-        PCCVector3D accumulatedNormals;
-        addNeighbors( uint32_t( ptIndex ), pointCloud, kdtree, nNQuery2, nNResult, accumulatedNormals,
-                      numberOfNormals );
-        if ( numberOfNormals == 0u ) {
-          if ( ptIndex != 0u ) {
-            accumulatedNormals = normals_[ptIndex - 1];
-          } else {
-            accumulatedNormals = ( params.viewPoint_ - pointCloud[ptIndex] );
-          }
-        }
-        if ( normals_[ptIndex] * accumulatedNormals < 0.0 ) { normals_[ptIndex] = -normals_[ptIndex]; }
-        while ( !edges_.empty() ) {
-          PCCWeightedEdge edge = edges_.top();
-          edges_.pop();
-          uint32_t current = edge.end_;
-          if ( visited_[current] == 0u ) {
-            visited_[current] = 1;
-            if ( normals_[edge.start_] * normals_[current] < 0.0 ) { normals_[current] = -normals_[current]; }
-            addNeighbors( current, pointCloud, kdtree, nNQuery, nNResult, accumulatedNormals, numberOfNormals );
-          }
-        }
-      }
-    }
+    orientUnvisitedNormals( pointCloud, kdtree, params );
 #ifdef DEBUG_NORMAL
     // save mesh
     PCCPointSet3 saveNormal4 = pointCloud;
@@ -502,6 +537,195 @@ void PCCNormalsGenerator3::orientNormals( const PCCPointSet3&
 #endif
   }
 }
+void PCCNormalsGenerator3::orientUnvisitedNormals( const PCCPointSet3&                   pointCloud,
+                                                   const PCCKdTree&                      kdtree,
+                                                   const PCCNormalsGenerator3Parameters& params ) {
+  // The points not visited yet are oriented in parallel, block by block, along a spanning tree of the neighbors of
+  // each block. Each tree is then flipped as a whole, along a maximum spanning tree of the trees: two trees, or a
+  // tree and the visited points, are made to agree on the sign of the sum of the products of the normals of their
+  // neighbors across them. On a smooth normal field this is the orientation of a spanning tree of all the points.
+  const size_t        pointCount    = pointCloud.getPointCount();
+  const size_t        neighborCount = params.numberOfNearestNeighborsInNormalOrientation_;
+  const float         radius2 = static_cast<float>( params.radiusNormalOrientation_ ) * params.radiusNormalOrientation_;
+  const uint32_t      blockSizeLog2 = 5;
+  const uint32_t      unassigned    = ( std::numeric_limits<uint32_t>::max )();
+  std::vector<size_t> subRanges;
+  PCCDivideRange( 0, pointCount, 64, subRanges );
+  // the edges left by addNeighbors are replaced by the neighbor lists below
+  std::priority_queue<PCCWeightedEdge>().swap( edges_ );
+
+  // neighbors of the points not visited, as searched by addNeighbors
+  std::vector<uint32_t> neighbors( pointCount * neighborCount );
+  std::vector<uint32_t> neighborCounts( pointCount, 0 );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), subRanges.size() - 1, [&]( const size_t i ) {
+      PCCNNResult nNResult;
+      for ( size_t ptIndex = subRanges[i]; ptIndex < subRanges[i + 1]; ++ptIndex ) {
+        if ( visited_[ptIndex] != 0u ) { continue; }
+        if ( radius2 > 32768.0 ) {
+          kdtree.search( pointCloud[ptIndex], neighborCount, nNResult );
+        } else {
+          kdtree.searchRadius( pointCloud[ptIndex], neighborCount, radius2, nNResult );
+        }
+        uint32_t* row = neighbors.data() + ptIndex * neighborCount;
+        for ( size_t j = 0; j < nNResult.count(); ++j ) {
+          if ( nNResult.indices( j ) != ptIndex ) {
+            row[neighborCounts[ptIndex]++] = uint32_t( nNResult.indices( j ) );
+          }
+        }
+      }
+    } );
+  } );
+
+  // blocks of ( 1 << blockSizeLog2 )^3 voxels, their points in index order
+  std::vector<std::pair<uint64_t, uint32_t>> blockPoints;
+  for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
+    if ( visited_[ptIndex] != 0u ) { continue; }
+    const auto& point = pointCloud[ptIndex];
+    uint64_t    key   = 0;
+    for ( size_t k = 0; k < 3; ++k ) { key = ( key << 21 ) | ( uint64_t( point[k] >> blockSizeLog2 ) & 0x1FFFFF ); }
+    blockPoints.emplace_back( key, uint32_t( ptIndex ) );
+  }
+  tbb::parallel_sort( blockPoints.begin(), blockPoints.end() );
+  std::vector<size_t>   blockStarts;
+  std::vector<uint32_t> blockOfPoint( pointCount, unassigned );
+  for ( size_t k = 0; k < blockPoints.size(); ++k ) {
+    if ( k == 0 || blockPoints[k].first != blockPoints[k - 1].first ) { blockStarts.push_back( k ); }
+    blockOfPoint[blockPoints[k].second] = uint32_t( blockStarts.size() - 1 );
+  }
+  blockStarts.push_back( blockPoints.size() );
+
+  // spanning trees of the blocks, each point labeled with the root of its tree, its smallest point
+  std::vector<uint32_t> roots( pointCount, unassigned );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), blockStarts.size() - 1, [&]( const size_t b ) {
+      auto&                           threadArena = executionContext_->getThreadArena();
+      PCCArenaScope                   blockScope( threadArena );
+      PCCArenaVector<PCCWeightedEdge> container{PCCArenaAllocator<PCCWeightedEdge>( threadArena )};
+      std::priority_queue<PCCWeightedEdge, PCCArenaVector<PCCWeightedEdge>> edges( std::less<PCCWeightedEdge>(),
+                                                                                   std::move( container ) );
+      auto addEdges = [&]( const uint32_t current ) {
+        const uint32_t* row = neighbors.data() + current * neighborCount;
+        for ( size_t j = 0; j < neighborCounts[current]; ++j ) {
+          if ( blockOfPoint[row[j]] == b && roots[row[j]] == unassigned ) {
+            edges.push( {fabs( normals_[current] * normals_[row[j]] ), current, row[j]} );
+          }
+        }
+      };
+      for ( size_t k = blockStarts[b]; k < blockStarts[b + 1]; ++k ) {
+        const uint32_t root = blockPoints[k].second;
+        if ( roots[root] != unassigned ) { continue; }
+        roots[root] = root;
+        addEdges( root );
+        while ( !edges.empty() ) {
+          PCCWeightedEdge edge = edges.top();
+          edges.pop();
+          if ( roots[edge.end_] == unassigned ) {
+            roots[edge.end_] = root;
+            if ( normals_[edge.start_] * normals_[edge.end_] < 0.0 ) { normals_[edge.end_] = -normals_[edge.end_]; }
+            addEdges( edge.end_ );
+          }
+        }
+      }
+    } );
+  } );
+
+  // sums of the products of the normals across the trees, and across a tree and the visited points
+  std::vector<uint32_t> treeOfRoot( pointCount, unassigned );
+  std::vector<uint32_t> treeRoots;
+  for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
+    if ( roots[ptIndex] == ptIndex ) {
+      treeOfRoot[ptIndex] = uint32_t( treeRoots.size() );
+      treeRoots.push_back( uint32_t( ptIndex ) );
+    }
+  }
+  const size_t                         treeCount = treeRoots.size();
+  std::vector<double>                  visitedSums( treeCount, 0.0 );
+  std::unordered_map<uint64_t, double> treeSums;
+  for ( size_t ptIndex = 0; ptIndex < pointCount; ++ptIndex ) {
+    if ( visited_[ptIndex] != 0u ) { continue; }
+    const uint32_t  tree = treeOfRoot[roots[ptIndex]];
+    const uint32_t* row  = neighbors.data() + ptIndex * neighborCount;
+    for ( size_t j = 0; j < neighborCounts[ptIndex]; ++j ) {
+      const double product = normals_[ptIndex] * normals_[row[j]];
+      if ( visited_[row[j]] != 0u ) {
+        visitedSums[tree] += product;
+      } else if ( treeOfRoot[roots[row[j]]] != tree ) {
+        const uint32_t other = treeOfRoot[roots[row[j]]];
+        treeSums[( std::min )( tree, other ) * uint64_t( treeCount ) + ( std::max )( tree, other )] += product;
+      }
+    }
+  }
+  std::vector<std::vector<std::pair<uint32_t, double>>> adjacentTrees( treeCount );
+  for ( const auto& sum : treeSums ) {
+    adjacentTrees[sum.first / treeCount].emplace_back( uint32_t( sum.first % treeCount ), sum.second );
+    adjacentTrees[sum.first % treeCount].emplace_back( uint32_t( sum.first / treeCount ), sum.second );
+  }
+
+  // flips of the trees: from the visited points first, then from the root of the first tree left, as the point of
+  // the same index is by the spanning tree orientation of all the points
+  struct PCCTreeEdge {
+    double   weight_;
+    uint32_t tree_;
+    bool     flip_;
+    bool     operator<( const PCCTreeEdge& rhs ) const {
+      return weight_ == rhs.weight_ ? tree_ > rhs.tree_ : weight_ < rhs.weight_;
+    }
+  };
+  std::vector<int8_t>              flips( treeCount, -1 );
+  std::priority_queue<PCCTreeEdge> treeEdges;
+  auto                             setFlip = [&]( const uint32_t tree, const bool flip ) {
+    flips[tree] = int8_t( flip );
+    for ( const auto& adjacent : adjacentTrees[tree] ) {
+      if ( flips[adjacent.first] < 0 ) {
+        treeEdges.push( {fabs( adjacent.second ), adjacent.first, flip != ( adjacent.second < 0.0 )} );
+      }
+    }
+  };
+  auto orientedNormal = [&]( const size_t index ) {
+    return visited_[index] != 0u || flips[treeOfRoot[roots[index]]] <= 0 ? normals_[index] : -normals_[index];
+  };
+  for ( uint32_t tree = 0; tree < treeCount; ++tree ) {
+    if ( visitedSums[tree] != 0.0 ) { treeEdges.push( {fabs( visitedSums[tree] ), tree, visitedSums[tree] < 0.0} ); }
+  }
+  PCCNNResult nNResult;
+  for ( uint32_t nextTree = 0;; ) {
+    while ( !treeEdges.empty() ) {
+      PCCTreeEdge edge = treeEdges.top();
+      treeEdges.pop();
+      if ( flips[edge.tree_] < 0 ) { setFlip( edge.tree_, edge.flip_ ); }
+    }
+    while ( nextTree < treeCount && flips[nextTree] >= 0 ) { ++nextTree; }
+    if ( nextTree == treeCount ) { break; }
+    const uint32_t root = treeRoots[nextTree];
+    PCCVector3D    accumulatedNormals( 0.0 );
+    size_t         numberOfNormals = 0;
+    kdtree.search( pointCloud[root], neighborCount, nNResult );
+    for ( size_t j = 0; j < nNResult.count(); ++j ) {
+      const size_t index = nNResult.indices( j );
+      if ( index != root && ( visited_[index] != 0u || flips[treeOfRoot[roots[index]]] >= 0 ) ) {
+        accumulatedNormals += orientedNormal( index );
+        ++numberOfNormals;
+      }
+    }
+    if ( numberOfNormals == 0u ) {
+      if ( root != 0u ) {
+        accumulatedNormals = orientedNormal( root - 1 );
+      } else {
+        accumulatedNormals = ( params.viewPoint_ - pointCloud[root] );
+      }
+    }
+    setFlip( nextTree, normals_[root] * accumulatedNormals < 0.0 );
+  }
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t ptIndex ) {
+      if ( visited_[ptIndex] == 0u ) {
+        normals_[ptIndex] = orientedNormal( ptIndex );
+        visited_[ptIndex] = 1;
+      }
+    } );
+  } );
+}
 void PCCNormalsGenerator3::addNeighbors( const uint32_t      current,
                                          const PCCPointSet3& pointCloud,
                                          const PCCKdTree&    kdtree,
@@ -544,8 +768,7 @@ void PCCNormalsGenerator3::smoothNormals( const PCCPointSet3&
   PCCDivideRange( 0, pointCount, chunckCount, subRanges );
   const double radius = params.radiusNormalSmoothing_ * params.radiusNormalSmoothing_;
   for ( size_t it = 0; it < params.numberOfIterationsInNormalSmoothing_; ++it ) {
-    tbb::task_arena limited( static_cast<int>( nbThread_ ) );
-    limited.execute( [&] {
+    executionContext_->execute( [&] {
       tbb::parallel_for( size_t( 0 ), subRanges.size() - 1, [&]( const size_t i ) {
         const size_t start = subRanges[i];
         const size_t end   = subRanges[i + 1];
@@ -34,16 +34,73 @@
 #include "PCCCommon.h"
 
 #include "PCCKdTree.h"
+#include "PCCSpatialIndexCache.h"
 #include "PCCNormalsGenerator.h"
 #include "tbb/tbb.h"
 #include "PCCPatchSegmenter.h"
+#include "PCCExecutionContext.h"
 #include "PCCPatch.h"
+#include "PCCSegmentationKernels.h"
+#include <atomic>
 
 using namespace pcc;
 
-void PCCPatchSegmenter3::setNbThread( size_t nbThread ) {
-  nbThread_ = nbThread;
-  if ( nbThread_ > 0 ) { tbb::task_scheduler_init init( static_cast<int>( nbThread ) ); }
+// points searched in parallel at a time when filling an adjacency, of which only the results are held outside it
+static const size_t g_adjacencyBatchSize = 16384;
+
+void PCCAdjacency::truncate( const std::vector<size_t>& counts ) {
+  size_t end = 0;
+  for ( size_t i = 0; i < size(); ++i ) {
+    const size_t begin = offsets_[i];
+    const size_t count = ( std::min )( counts[i], offsets_[i + 1] - begin );
+    std::copy( indices_.begin() + begin, indices_.begin() + begin + count, indices_.begin() + end );
+    if ( !distances_.empty() ) {
+      std::copy( distances_.begin() + begin, distances_.begin() + begin + count, distances_.begin() + end );
+    }
+    offsets_[i] = end;
+    end += count;
+  }
+  if ( !offsets_.empty() ) { offsets_.back() = end; }
+  indices_.resize( end );
+  if ( !distances_.empty() ) { distances_.resize( end ); }
+}
+
+// Fills adj with the neighbors search( point, result ) finds for each point of pointCloud. The points are searched
+// in parallel by batches, the rows of a batch appended to adj once its searches are done.
+template <typename Search>
+static void fillAdjacency( PCCExecutionContext& executionContext,
+                           const PCCPointSet3&  pointCloud,
+                           const bool           keepDistances,
+                           Search               search,
+                           PCCAdjacency&        adj ) {
+  const size_t             pointCount = pointCloud.getPointCount();
+  auto&                    offsets    = adj.getOffsets();
+  auto&                    indices    = adj.getIndices();
+  auto&                    distances  = adj.getDistances();
+  std::vector<PCCNNResult> results( ( std::min )( pointCount, g_adjacencyBatchSize ) );
+  offsets.assign( 1, 0 );
+  offsets.reserve( pointCount + 1 );
+  indices.clear();
+  distances.clear();
+  for ( size_t start = 0; start < pointCount; start += g_adjacencyBatchSize ) {
+    const size_t batchSize = ( std::min )( pointCount - start, g_adjacencyBatchSize );
+    executionContext.execute( [&] {
+      tbb::parallel_for( size_t( 0 ), batchSize, [&]( const size_t k ) { search( pointCloud[start + k], results[k] ); } );
+    } );
+    for ( size_t k = 0; k < batchSize; ++k ) { offsets.push_back( offsets.back() + results[k].count() ); }
+    indices.resize( offsets.back() );
+    if ( keepDistances ) { distances.resize( offsets.back() ); }
+    executionContext.execute( [&] {
+      tbb::parallel_for( size_t( 0 ), batchSize, [&]( const size_t k ) {
+        auto&        result = results[k];
+        const size_t offset = offsets[start + k];
+        for ( size_t j = 0; j < result.count(); ++j ) {
+          indices[offset + j] = static_cast<uint32_t>( result.indices( j ) );
+          if ( keepDistances ) { distances[offset + j] = result.dist( j ); }
+        }
+      } );
+    } );
+  }
 }
 
 void PCCPatchSegmenter3::compute( const PCCPointSet3&                 geometry,
@@ -71,20 +128,26 @@ void PCCPatchSegmenter3::compute( const PCCPointSet3&                 geometry,
     orientationCount = 18;
   }
   std::cout << std::endl << "============= FRAME " << frameIndex << " ============= " << std::endl;
-  PCCPointSet3 geometryVox;
+  useDevice_ = params.deviceSegmentation_;
+  PCCPointSet3 voxelized;
   Voxels       voxels;
   if ( params.gridBasedSegmentation_ ) {
     std::cout << "  Converting points to voxels... ";
     convertPointsToVoxels( geometry, params.geometryBitDepth3D_, params.voxelDimensionGridBasedSegmentation_,
-                           geometryVox, voxels );
+                           voxelized, voxels );
     std::cout << "[done]" << std::endl;
-  } else {
-    geometryVox = geometry;
   }
+  const PCCPointSet3& geometryVox = params.gridBasedSegmentation_ ? voxelized : geometry;
+  auto                sourceKdtree = [&] {
+    return spatialIndex_ != nullptr ? spatialIndex_->getKdTree( geometry )
+                                    : std::shared_ptr<const PCCKdTree>( std::make_shared<PCCKdTree>( geometry ) );
+  };
   std::cout << "  Computing normals for original point cloud... ";
-  PCCKdTree            kdtree( geometryVox );
+  std::shared_ptr<const PCCKdTree> kdtree =
+      params.gridBasedSegmentation_ ? std::make_shared<PCCKdTree>( geometryVox ) : sourceKdtree();
   PCCNNResult          result;
   PCCNormalsGenerator3 normalsGen;
+  normalsGen.setUseDevice( useDevice_ );
   auto                 normalsOrientation = static_cast<PCCNormalsGeneratorOrientation>( params.normalOrientation_ );
   const PCCNormalsGenerator3Parameters normalsGenParams = {PCCVector3D( 0.0 ),
                                                            ( std::numeric_limits<double>::max )(),
@@ -98,10 +161,18 @@ void PCCPatchSegmenter3::compute( const PCCPointSet3&                 geometry,
                                                            normalsOrientation,
                                                            false,
                                                            false,
-                                                           false};
+                                                           false,
+                                                           params.maxFitErrorTemporalNormals_,
+                                                           params.maxDist2TemporalNormals_};
   // PCC_NORMALS_GENERATOR_ORIENTATION_SPANNING_TREE,
-  normalsGen.compute( geometryVox, kdtree, normalsGenParams, nbThread_ );
-  std::cout << "[done]" << std::endl;
+  if ( normalsReference_ != nullptr ) {
+    normalsGen.compute( geometryVox, *kdtree, normalsGenParams, *executionContext_, *normalsReference_ );
+    std::cout << "[done] " << normalsGen.getSeededNormalCount() << " of " << geometryVox.getPointCount()
+              << " normals from the previous frame" << std::endl;
+  } else {
+    normalsGen.compute( geometryVox, *kdtree, normalsGenParams, *executionContext_ );
+    std::cout << "[done]" << std::endl;
+  }
 
   std::cout << "  Computing initial segmentation... ";
   std::vector<size_t> partition;
@@ -121,7 +192,7 @@ void PCCPatchSegmenter3::compute( const PCCPointSet3&                 geometry,
                                  params.searchRadiusRefineSegmentation_, partition );
   } else {
     std::cout << "  Refining segmentation... ";
-    refineSegmentation( geometryVox, kdtree, normalsGen, orientations, orientationCount,
+    refineSegmentation( geometryVox, *kdtree, normalsGen, orientations, orientationCount,
                         params.maxNNCountRefineSegmentation_, params.lambdaRefineSegmentation_,
                         params.iterationCountRefineSegmentation_, partition );
   }
@@ -129,10 +200,9 @@ void PCCPatchSegmenter3::compute( const PCCPointSet3&                 geometry,
 
   if ( params.gridBasedSegmentation_ ) {
     std::cout << "  Applying voxels' data to points... ";
-    applyVoxelsDataToPoints( geometry.getPointCount(), params.geometryBitDepth3D_,
-                             params.voxelDimensionGridBasedSegmentation_, voxels, geometryVox, normalsGen, partition );
+    applyVoxelsDataToPoints( voxels, normalsGen, partition );
     std::cout << "[done]" << std::endl;
-    kdtree.init( geometry );
+    kdtree = sourceKdtree();
   }
   std::cout << "  Patch segmentation... ";
   PCCPointSet3        resampled;
@@ -140,7 +210,7 @@ void PCCPatchSegmenter3::compute( const PCCPointSet3&                 geometry,
   std::vector<size_t> resampledPatchPartition;
   std::vector<size_t> rawPoints;
 
-  segmentPatches( geometry, frameIndex, kdtree, params, partition, patches, patchPartition, resampledPatchPartition,
+  segmentPatches( geometry, frameIndex, *kdtree, params, partition, patches, patchPartition, resampledPatchPartition,
                   rawPoints, resampled, subPointCloud, distanceSrcRec, normalsGen, orientations, orientationCount );
   std::cout << "[done]" << std::endl;
 }
@@ -150,62 +220,81 @@ void PCCPatchSegmenter3::convertPointsToVoxels( const PCCPointSet3& source,
                                                 size_t              voxDim,
                                                 PCCPointSet3&       sourceVox,
                                                 Voxels&             voxels ) {
-#define ADD_COLOR 0
   const size_t geoBits2    = geoBits << 1;
   size_t       voxDimShift = 0;
   for ( size_t i = voxDim; i > 1; ++voxDimShift, i >>= 1 ) { ; }
   const size_t voxDimHalf = voxDim >> 1;
+  const size_t pointCount = source.getPointCount();
 
+  auto toVoxel  = [&]( const PCCPoint3D& pos, size_t c ) {
+    return ( static_cast<uint64_t>( pos[c] ) + voxDimHalf ) >> voxDimShift;
+  };
   auto subToInd = [&]( uint64_t x, uint64_t y, uint64_t z ) { return x + ( y << geoBits ) + ( z << geoBits2 ); };
 
-  for ( size_t i = 0; i < source.getPointCount(); ++i ) {
-    const auto& pos = source[i];
-    const auto  x0  = ( static_cast<uint64_t>( pos[0] ) + voxDimHalf ) >> voxDimShift;
-    const auto  y0  = ( static_cast<uint64_t>( pos[1] ) + voxDimHalf ) >> voxDimShift;
-    const auto  z0  = ( static_cast<uint64_t>( pos[2] ) + voxDimHalf ) >> voxDimShift;
-    const auto  p   = subToInd( x0, y0, z0 );
-    if ( voxels.count( p ) == 0u ) {
-      voxels[p].reserve( voxDim * voxDim << 1 );
-      const size_t j = sourceVox.addPoint( PCCPoint3D( x0, y0, z0 ) );
-#if ADD_COLOR
-      sourceVox.addColors();
-      sourceVox.setColor( j, source.getColor( i ) );
-#endif
+  // open addressing table of the occupied voxels, at most half full, filled in parallel: each slot holds the code of
+  // a voxel and the first of its points in the source order
+  const uint64_t emptySlot = ( std::numeric_limits<uint64_t>::max )();
+  size_t         slotBits  = 1;
+  while ( ( size_t( 1 ) << slotBits ) < ( pointCount << 1 ) ) { ++slotBits; }
+  const size_t                             slotCount = size_t( 1 ) << slotBits;
+  std::unique_ptr<std::atomic<uint64_t>[]> codes( new std::atomic<uint64_t>[slotCount] );
+  std::unique_ptr<std::atomic<uint32_t>[]> firstPoints( new std::atomic<uint32_t>[slotCount] );
+  std::vector<uint32_t>                    slots( pointCount );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), slotCount, [&]( const size_t s ) {
+      codes[s].store( emptySlot, std::memory_order_relaxed );
+      firstPoints[s].store( ( std::numeric_limits<uint32_t>::max )(), std::memory_order_relaxed );
+    } );
+  } );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
+      const auto&    pos  = source[i];
+      const uint64_t code = subToInd( toVoxel( pos, 0 ), toVoxel( pos, 1 ), toVoxel( pos, 2 ) );
+      size_t         s    = ( code * 0x9E3779B97F4A7C15ULL ) >> ( 64 - slotBits );
+      while ( true ) {
+        uint64_t current = emptySlot;
+        if ( codes[s].compare_exchange_strong( current, code, std::memory_order_relaxed ) || current == code ) {
+          break;
+        }
+        s = ( s + 1 ) & ( slotCount - 1 );
+      }
+      uint32_t first = firstPoints[s].load( std::memory_order_relaxed );
+      while ( i < first &&
+              !firstPoints[s].compare_exchange_weak( first, static_cast<uint32_t>( i ), std::memory_order_relaxed ) ) {
+      }
+      slots[i] = static_cast<uint32_t>( s );
+    } );
+  } );
+
+  // the voxels are numbered in the order of their first points, as when they were added point by point
+  std::vector<uint32_t> voxelOfSlot( slotCount );
+  for ( size_t i = 0; i < pointCount; ++i ) {
+    const size_t s = slots[i];
+    if ( firstPoints[s].load( std::memory_order_relaxed ) == i ) {
+      const auto& pos = source[i];
+      voxelOfSlot[s]  = static_cast<uint32_t>(
+          sourceVox.addPoint( PCCPoint3D( toVoxel( pos, 0 ), toVoxel( pos, 1 ), toVoxel( pos, 2 ) ) ) );
     }
-    voxels[p].push_back( i );
   }
+  voxels.resize( pointCount );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) { voxels[i] = voxelOfSlot[slots[i]]; } );
+  } );
 }
 
-void PCCPatchSegmenter3::applyVoxelsDataToPoints( size_t                pointCount,
-                                                  size_t                geoBits,
-                                                  size_t                voxDim,
-                                                  Voxels&               voxels,  // const
-                                                  const PCCPointSet3&   sourceVox,
+void PCCPatchSegmenter3::applyVoxelsDataToPoints( const Voxels&         voxels,
                                                   PCCNormalsGenerator3& normalsGen,
                                                   std::vector<size_t>&  partitions ) {
+  const size_t             pointCount = voxels.size();
   std::vector<size_t>      partitionsTmp( pointCount );
   std::vector<PCCVector3D> normalsTmp( pointCount );
   auto&                    normals = normalsGen.getNormals();
-
-  const size_t geoBits2    = geoBits << 1;
-  size_t       voxDimShift = 0;
-  for ( size_t i = voxDim; i > 1; ++voxDimShift, i >>= 1 ) { ; }
-  const size_t voxDimHalf = voxDim >> 1;
-
-  auto subToInd = [&]( const PCCPoint3D& point ) {
-    return (uint64_t)point[0] + ( (uint64_t)point[1] << geoBits ) + ( (uint64_t)point[2] << geoBits2 );
-  };
-
-  for ( size_t i = 0; i < sourceVox.getPointCount(); i++ ) {
-    const auto& partition = partitions[i];
-    const auto& normal    = normals[i];
-    const auto& pos       = sourceVox[i];
-    const auto& indices   = voxels[subToInd( pos )];
-    for ( const auto& index : indices ) {
-      partitionsTmp[index] = partition;
-      normalsTmp[index]    = normal;
-    }
-  }
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
+      partitionsTmp[i] = partitions[voxels[i]];
+      normalsTmp[i]    = normals[voxels[i]];
+    } );
+  } );
   swap( partitions, partitionsTmp );
   swap( normalsGen.getNormals(), normalsTmp );
 }
@@ -234,8 +323,14 @@ void PCCPatchSegmenter3::initialSegmentation( const PCCPointSet3&         geomet
   weightValue[0] = weightValue[3] = axisWeight[0];
   weightValue[1] = weightValue[4] = axisWeight[1];
   weightValue[2] = weightValue[5] = axisWeight[2];
-  tbb::task_arena limited( static_cast<int>( nbThread_ ) );
-  limited.execute( [&] {
+  if ( useDevice_ && pointCount != 0 ) {
+    static_assert( sizeof( PCCVector3D ) == 3 * sizeof( double ), "normals are packed xyz triplets" );
+    if ( initialSegmentationKernel( &normalsGen.getNormals()[0][0], pointCount, &orientations[0][0], weightValue,
+                                    orientationCount, partition.data() ) ) {
+      return;
+    }
+  }
+  executionContext_->execute( [&] {
     tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
       const PCCVector3D normal       = normalsGen.getNormal( i );
       size_t            clusterIndex = 0;
@@ -252,66 +347,36 @@ void PCCPatchSegmenter3::initialSegmentation( const PCCPointSet3&         geomet
   } );
 }
 
-void PCCPatchSegmenter3::computeAdjacencyInfo( const PCCPointSet3&               pointCloud,
-                                               const PCCKdTree&                  kdtree,
-                                               std::vector<std::vector<size_t>>& adj,
-                                               const size_t                      maxNNCount ) {
-  const size_t pointCount = pointCloud.getPointCount();
-  adj.resize( pointCount );
-  tbb::task_arena limited( static_cast<int>( nbThread_ ) );
-  limited.execute( [&] {
-    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
-      PCCNNResult result;
-      kdtree.search( pointCloud[i], maxNNCount, result );
-      std::vector<size_t>& neighbors = adj[i];
-      neighbors.resize( result.count() );
-      for ( size_t j = 0; j < result.count(); ++j ) { neighbors[j] = result.indices( j ); }
-    } );
-  } );
+void PCCPatchSegmenter3::computeAdjacencyInfo( const PCCPointSet3& pointCloud,
+                                               const PCCKdTree&    kdtree,
+                                               PCCAdjacency&       adj,
+                                               const size_t        maxNNCount ) {
+  fillAdjacency(
+      *executionContext_, pointCloud, false,
+      [&]( const PCCPoint3D& point, PCCNNResult& result ) { kdtree.search( point, maxNNCount, result ); }, adj );
 }
 
-void PCCPatchSegmenter3::computeAdjacencyInfoInRadius( const PCCPointSet3&                 pointCloud,
-                                                       const PCCKdTree&                    kdtree,
-                                                       std::vector<std::vector<uint32_t>>& adj,
-                                                       const size_t                        maxNNCount,
-                                                       const size_t                        radius ) {
-  const size_t pointCount = pointCloud.getPointCount();
-  adj.resize( pointCount );
-  tbb::task_arena limited( static_cast<int>( nbThread_ ) );
-  limited.execute( [&] {
-    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
-      PCCNNResult result;
-      kdtree.searchRadius( pointCloud[i], maxNNCount, radius, result );
-      std::vector<uint32_t>& neighbors = adj[i];
-      neighbors.resize( result.count() );
-      for ( size_t j = 0; j < result.count(); ++j ) { neighbors[j] = result.indices( j ); }
-    } );
-  } );
+void PCCPatchSegmenter3::computeAdjacencyInfoInRadius( const PCCPointSet3& pointCloud,
+                                                       const PCCKdTree&    kdtree,
+                                                       PCCAdjacency&       adj,
+                                                       const size_t        maxNNCount,
+                                                       const size_t        radius ) {
+  fillAdjacency(
+      *executionContext_, pointCloud, false,
+      [&]( const PCCPoint3D& point, PCCNNResult& result ) {
+        result = PCCNNResult();
+        kdtree.searchRadius( point, maxNNCount, radius, result );
+      },
+      adj );
 }
 
-void PCCPatchSegmenter3::computeAdjacencyInfoDist( const PCCPointSet3&               pointCloud,
-                                                   const PCCKdTree&                  kdtree,
-                                                   std::vector<std::vector<size_t>>& adj,
-                                                   std::vector<std::vector<double>>& adjDist,
-                                                   const size_t                      maxNNCount ) {
-  const size_t pointCount = pointCloud.getPointCount();
-  adj.resize( pointCount );
-  adjDist.resize( pointCount );
-  tbb::task_arena limited( static_cast<int>( nbThread_ ) );
-  limited.execute( [&] {
-    tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
-      PCCNNResult result;
-      kdtree.search( pointCloud[i], maxNNCount, result );
-      std::vector<size_t>& neighbors     = adj[i];
-      std::vector<double>& neighborsDist = adjDist[i];
-      neighbors.resize( result.count() );
-      neighborsDist.resize( result.count() );
-      for ( size_t j = 0; j < result.count(); ++j ) {
-        neighbors[j]     = result.indices( j );
-        neighborsDist[j] = result.dist( j );
-      }
-    } );
-  } );
+void PCCPatchSegmenter3::computeAdjacencyInfoDist( const PCCPointSet3& pointCloud,
+                                                   const PCCKdTree&    kdtree,
+                                                   PCCAdjacency&       adj,
+                                                   const size_t        maxNNCount ) {
+  fillAdjacency(
+      *executionContext_, pointCloud, true,
+      [&]( const PCCPoint3D& point, PCCNNResult& result ) { kdtree.search( point, maxNNCount, result ); }, adj );
 }
 
 void printChunk( const std::vector<std::pair<int, int>>& chunk ) {
@@ -564,8 +629,7 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
   size_t numD1Points      = 0;
   size_t numEOMOnlyPoints = 0;
   std::cout << "\n\t Computing adjacency info... ";
-  std::vector<std::vector<size_t>>              adj;
-  std::vector<std::vector<double>>              adjDist;
+  PCCAdjacency                                  adj;
   std::vector<bool>                             flagExp;
   int                                           numROIs;
   int                                           numChunks;
@@ -574,9 +638,9 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
   std::vector<size_t>                           pointCountChunks;
   std::vector<PCCKdTree>                        kdtreeChunks;
   std::vector<PCCBox3D>                         boundingBoxChunks;
-  std::vector<std::vector<std::vector<size_t>>> adjChunks;
+  std::vector<PCCAdjacency>                     adjChunks;
   if ( patchExpansionEnabled ) {
-    computeAdjacencyInfoDist( points, kdtree, adj, adjDist, maxNNCount );
+    computeAdjacencyInfoDist( points, kdtree, adj, maxNNCount );
     flagExp.resize( pointCount, false );
   } else {
     if ( !enablePointCloudPartitioning ) {
@@ -871,14 +935,18 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
       std::sort( connectedComponents.begin(), connectedComponents.end(),
                  []( const std::vector<size_t>& a, const std::vector<size_t>& b ) { return a.size() >= b.size(); } );
     }
-    for ( auto& connectedComponent : connectedComponents ) {
-      const size_t patchIndex = patches.size();
-      patches.resize( patchIndex + 1 );
-      if ( createSubPointCloud ) { subPointCloud.resize( patchIndex + 1 ); }
-      PCCPatch& patch            = patches[patchIndex];
-      size_t    d0CountPerPatch  = 0;
-      size_t    d1CountPerPatch  = 0;
-      size_t    eomCountPerPatch = 0;
+    // the patch of a connected component only depends on its points, so the patches are projected in parallel,
+    // unless patch expansion, which flags the points taken by the previous patches, makes them depend on the order;
+    // resampling appends to the shared point cloud and follows in component order, keeping the patch order
+    const size_t         patchBase = patches.size();
+    std::vector<uint8_t> projected( connectedComponents.size(), 0 );
+    std::vector<uint8_t> additionalPlane( connectedComponents.size(), 0 );
+    patches.resize( patchBase + connectedComponents.size() );
+    if ( createSubPointCloud ) { subPointCloud.resize( patches.size() ); }
+    auto projectPatch = [&]( const size_t indexCC ) {
+      auto&        connectedComponent = connectedComponents[indexCC];
+      const size_t patchIndex         = patchBase + indexCC;
+      PCCPatch&    patch              = patches[patchIndex];
       patch.setIndex( patchIndex );
       patch.setEOMCount( 0 );
       patch.setPatchType( static_cast<uint8_t>( P_INTRA ) );
@@ -886,6 +954,7 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
       bool   bIsAdditionalProjectionPlane = ( clusterIndex > 5 );  // false;
       if ( bIsAdditionalProjectionPlane && ( additionalProjectionAxis == 2 ) ) clusterIndex += 4;
       if ( bIsAdditionalProjectionPlane && ( additionalProjectionAxis == 3 ) ) clusterIndex += 8;
+      additionalPlane[indexCC] = bIsAdditionalProjectionPlane;
       patch.setViewId( clusterIndex );
       patch.setBestMatchIdx( g_invalidPatchIndex );
       patch.getPreGPAPatchData().initialize();
@@ -917,7 +986,7 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
           if ( u - minU < params.maxPatchSize_ && v - minV < params.maxPatchSize_ ) { tempCC.push_back( i ); }
         }
         connectedComponent = tempCC;
-        if ( connectedComponent.empty() ) { continue; }
+        if ( connectedComponent.empty() ) { return false; }
       }
 
       const int16_t projectionDirectionType = -2 * patch.getProjectionMode() + 1;
@@ -934,7 +1003,7 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
                  ( clusterIndex + 3 == partition[n] ) || ( clusterIndex == partition[n] + 3 ) ) {
               continue;
             }
-            const double dist2 = adjDist[i][ac];  // sum of square
+            const double dist2 = adj.getDistance( i, ac );  // sum of square
             if ( dist2 <= 2 ) {                   // <-- expansion distance
               fifoa.push_back( n );
               flagExp[n] = true;  // add point
@@ -1155,6 +1224,27 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
           }
         }
       }
+      return true;
+    };
+    if ( patchExpansionEnabled ) {
+      for ( size_t indexCC = 0; indexCC < connectedComponents.size(); ++indexCC ) {
+        projected[indexCC] = projectPatch( indexCC );
+      }
+    } else {
+      executionContext_->execute( [&] {
+        tbb::parallel_for( size_t( 0 ), connectedComponents.size(),
+                           [&]( const size_t indexCC ) { projected[indexCC] = projectPatch( indexCC ); } );
+      } );
+    }
+    for ( size_t indexCC = 0; indexCC < connectedComponents.size(); ++indexCC ) {
+      if ( projected[indexCC] == 0u ) { continue; }
+      auto&        connectedComponent           = connectedComponents[indexCC];
+      const size_t patchIndex                   = patchBase + indexCC;
+      PCCPatch&    patch                        = patches[patchIndex];
+      const bool   bIsAdditionalProjectionPlane = additionalPlane[indexCC] != 0u;
+      size_t       d0CountPerPatch              = 0;
+      size_t       d1CountPerPatch              = 0;
+      size_t       eomCountPerPatch             = 0;
       patch.setSizeD( 0 );
       PCCPointSet3 rec;
       rec.resize( 0 );
@@ -1218,7 +1308,7 @@ void PCCPatchSegmenter3::segmentPatches( const PCCPointSet3&                 poi
         testSrcNum += testSrc.getPointCount();
         testRecNum += testRec.getPointCount();
 
-        auto& sub = subPointCloud[subPointCloud.size() - 1];
+        auto& sub = subPointCloud[patchIndex];
         sub.resize( 0 );
         PCCKdTree kdtreeRec( rec );
         for ( const auto i : connectedComponent ) {
@@ -1293,22 +1383,21 @@ void PCCPatchSegmenter3::refineSegmentation( const PCCPointSet3&         pointCl
                                              const size_t                iterationCount,
                                              std::vector<size_t>&        partition ) {
   assert( orientations );
-  std::vector<std::vector<size_t>> adj;
+  PCCAdjacency adj;
   computeAdjacencyInfo( pointCloud, kdtree, adj, maxNNCount );
   const size_t                     pointCount = pointCloud.getPointCount();
   const double                     weight     = lambda / maxNNCount;
   std::vector<size_t>              tempPartition( pointCount );
   std::vector<std::vector<size_t>> scoresSmooth( pointCount, std::vector<size_t>( orientationCount ) );
   for ( size_t k = 0; k < iterationCount; ++k ) {
-    tbb::task_arena limited( static_cast<int>( nbThread_ ) );
-    limited.execute( [&] {
+    executionContext_->execute( [&] {
       tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
         auto& scoreSmooth = scoresSmooth[i];
         std::fill( scoreSmooth.begin(), scoreSmooth.end(), 0 );
         for ( auto& neighbor : adj[i] ) { ++scoreSmooth[partition[neighbor]]; }
       } );
     } );
-    limited.execute( [&] {
+    executionContext_->execute( [&] {
       tbb::parallel_for( size_t( 0 ), pointCount, [&]( const size_t i ) {
         const PCCVector3D normal       = normalsGen.getNormal( i );
         size_t            clusterIndex = partition[i];
@@ -1406,105 +1495,146 @@ void PCCPatchSegmenter3::refineSegmentationGridBased( const PCCPointSet3&
   }
 
   // a step for searching adjacents voxels of each voxel within the voxSearchRadius
-  PCCKdTree                          kdtree( gridCenters );
-  const size_t                       voxSearchRadius  = searchRadius >> voxDimShift;
-  const size_t                       maxNeighborCount = ( std::numeric_limits<int16_t>::max )();
-  std::vector<std::vector<uint32_t>> adj( gridCenters.getPointCount() );
-
-  computeAdjacencyInfoInRadius( gridCenters, kdtree, adj, maxNeighborCount, voxSearchRadius );
+  const size_t voxSearchRadius  = searchRadius >> voxDimShift;
+  const size_t maxNeighborCount = ( std::numeric_limits<int16_t>::max )();
+  PCCAdjacency adj;
+  if ( !useDevice_ || !radiusAdjacencyKernel( &gridCenters[0][0], uiTotalNumOfVoxs, double( voxSearchRadius ),
+                                              maxNeighborCount, adj.getOffsets(), adj.getIndices() ) ) {
+    PCCKdTree kdtree( gridCenters );
+    computeAdjacencyInfoInRadius( gridCenters, kdtree, adj, maxNeighborCount, voxSearchRadius );
+  }
 
   // candidates for the indirect edge voxels from [m56635]
   std::vector<std::vector<uint32_t>> adjDEV( uiTotalNumOfVoxs );
   const size_t                       idvSearchRange = ( voxDim >= 4 ) ? 1 : 2;
 
   // pre-processing steps from m55143
-  std::vector<double> weights;
-  weights.reserve( uiTotalNumOfVoxs );
+  std::vector<double> weights( uiTotalNumOfVoxs );
+  std::vector<size_t> adjCounts( uiTotalNumOfVoxs );
 
   // for each cell of the grid
-  for ( size_t i = 0; i < uiTotalNumOfVoxs; ++i ) {
-    auto& p = gridCenters[i];
-    adjDEV[i].reserve( 128 );
-
-    size_t nnPointCount  = 0;
-    auto&  currentAdjOfI = adj[i];
-    auto   iter          = currentAdjOfI.begin();
-    for ( ; iter != currentAdjOfI.end(); ++iter ) {
-      // for the 2nd voxel classification [m56635]
-      auto&  q    = gridCenters[*iter];
-      size_t xAbs = abs( p[0] - q[0] );
-      size_t yAbs = abs( p[1] - q[1] );
-      size_t zAbs = abs( p[2] - q[2] );
-      if ( xAbs <= idvSearchRange && yAbs <= idvSearchRange && zAbs <= idvSearchRange ) {
-        adjDEV[i].push_back( *iter );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), size_t( uiTotalNumOfVoxs ), [&]( const size_t i ) {
+      auto& p = gridCenters[i];
+      adjDEV[i].reserve( 128 );
+
+      size_t nnPointCount  = 0;
+      const auto currentAdjOfI = adj[i];
+      auto       iter          = currentAdjOfI.begin();
+      for ( ; iter != currentAdjOfI.end(); ++iter ) {
+        // for the 2nd voxel classification [m56635]
+        auto&  q    = gridCenters[*iter];
+        size_t xAbs = abs( p[0] - q[0] );
+        size_t yAbs = abs( p[1] - q[1] );
+        size_t zAbs = abs( p[2] - q[2] );
+        if ( xAbs <= idvSearchRange && yAbs <= idvSearchRange && zAbs <= idvSearchRange ) {
+          adjDEV[i].push_back( *iter );
+        }
+        nnPointCount += pointIndicesOfVox[*iter]->getPointCount();
+        if ( nnPointCount >= maxNNCount ) { break; }
       }
-      nnPointCount += pointIndicesOfVox[*iter]->getPointCount();
-      if ( nnPointCount >= maxNNCount ) { break; }
-    }
-
-    // pre-computing weights from lambda and the total number of nearest neighbors
-    weights.push_back( lambda / nnPointCount );
-
-    // removing points from the adjacent list if there is more than maxNNCount
-    if ( iter != currentAdjOfI.end() ) { currentAdjOfI.erase( iter + 1, currentAdjOfI.end() ); }
-  }
 
-  std::vector<double> scores;
-  scores.resize( orientationCount, 0.0 );
+      // pre-computing weights from lambda and the total number of nearest neighbors
+      weights[i] = lambda / nnPointCount;
 
-  ScoresVector_t scoreSmooth( orientationCount, 0 );
+      // removing points from the adjacent list if there is more than maxNNCount
+      adjCounts[i] = iter != currentAdjOfI.end() ? iter + 1 - currentAdjOfI.begin() : currentAdjOfI.size();
+    } );
+  } );
+  adj.truncate( adjCounts );
+
+  // A voxel only reads the scores and the ppi of its neighbours, which are updated at the end of the iteration, and
+  // only writes the partition of its own points. What depends on the order is the 2nd classification: taken in index
+  // order, a voxel made an indirect edge-voxel by a previous one is refined in the same iteration, by a next one in
+  // the next iteration. The voxels are therefore refined in waves, starting with the edge-voxels, and the no
+  // edge-voxels that a wave makes indirect edge-voxels, as they were at the start of the iteration, and that come
+  // after the voxel that did are the next wave: the same refinement as in index order, whatever the thread count.
+  std::vector<uint8_t>               edges( uiTotalNumOfVoxs );
+  std::vector<uint8_t>               refined( uiTotalNumOfVoxs );
+  std::vector<uint32_t>              wave;
+  std::vector<uint32_t>              nextWave;
+  std::vector<std::vector<uint32_t>> indirectEdges;
+  wave.reserve( uiTotalNumOfVoxs );
+  nextWave.reserve( uiTotalNumOfVoxs );
 
   size_t iter = 0;
   do {
+    wave.clear();
     for ( size_t i = 0; i < uiTotalNumOfVoxs; ++i ) {
       // if the current voxel belongs to N-EV(No edge-voxel), then refining steps are skipped. [m56635]
-      uint8_t edgeOfI = attributeOfVox[i]->getEdge();
-      if ( edgeOfI == NO_EDGE ) { continue; }
-
-      std::fill( scoreSmooth.begin(), scoreSmooth.end(), 0 );
+      edges[i]   = attributeOfVox[i]->getEdge();
+      refined[i] = edges[i] != NO_EDGE;
+      if ( refined[i] != 0u ) { wave.push_back( i ); }
+    }
+    while ( !wave.empty() ) {
+      indirectEdges.resize( wave.size() );
+      executionContext_->execute( [&] {
+        tbb::parallel_for( size_t( 0 ), wave.size(), [&]( const size_t w ) {
+          const size_t             i           = wave[w];
+          uint8_t                  edgeOfI     = attributeOfVox[i]->getEdge();
+          auto&                    threadArena = executionContext_->getThreadArena();
+          PCCArenaScope            voxelScope( threadArena );
+          PCCArenaVector<uint16_t> scoreSmooth( orientationCount, 0, PCCArenaAllocator<uint16_t>( threadArena ) );
+
+          const auto currentAdjOfI = adj[i];
+          for ( const auto& j : currentAdjOfI ) {
+            ScoresVector_t* scoreSmoothOfAdj = attributeOfVox[j]->getScoreSmooth();
+            for ( size_t k = 0; k < orientationCount; ++k ) { scoreSmooth[k] += ( *scoreSmoothOfAdj )[k]; }
+          }
 
-      auto& currentAdjOfI = adj[i];
-      for ( const auto& j : currentAdjOfI ) {
-        ScoresVector_t* scoreSmoothOfAdj = attributeOfVox[j]->getScoreSmooth();
-        for ( size_t k = 0; k < orientationCount; ++k ) { scoreSmooth[k] += ( *scoreSmoothOfAdj )[k]; }
-      }
+          // 2nd voxel classification (indirect edge-voxel)  [m56635]
+          const auto& maxEleOfScoreSmooth = std::max_element( scoreSmooth.begin(), scoreSmooth.end() );
+          size_t      ppiOfScoreSmooth    = std::distance( scoreSmooth.begin(), maxEleOfScoreSmooth );
 
-      // 2nd voxel classification (indirect edge-voxel)  [m56635]
-      const auto& maxEleOfScoreSmooth = std::max_element( scoreSmooth.begin(), scoreSmooth.end() );
-      size_t      ppiOfScoreSmooth    = std::distance( scoreSmooth.begin(), maxEleOfScoreSmooth );
+          indirectEdges[w].clear();
+          for ( auto& j : adjDEV[i] ) {
+            uint8_t edgeOfAdj = edges[j];
+            uint8_t ppi       = attributeOfVox[j]->getPPI();
+            if ( edgeOfAdj == NO_EDGE && ppi != ppiOfScoreSmooth ) { indirectEdges[w].push_back( j ); }
+          }  // for (auto& j : adjDEV[i])
 
-      for ( auto& j : adjDEV[i] ) {
-        uint8_t edgeOfAdj = attributeOfVox[j]->getEdge();
-        uint8_t ppi       = attributeOfVox[j]->getPPI();
-        if ( edgeOfAdj == NO_EDGE && ppi != ppiOfScoreSmooth ) { attributeOfVox[j]->updateEdge( INDIRECT_EDGE ); }
-      }  // for (auto& j : adjDEV[i])
+          if ( edgeOfI != M_DIRECT_EDGE ) {  // S_DIRECT_EDGE or INDIRECT_EDGE
+            size_t validNumOfScores = orientationCount - std::count( scoreSmooth.begin(), scoreSmooth.end(), 0 );
+            size_t voxPPI           = attributeOfVox[i]->getPPI();
 
-      if ( edgeOfI != M_DIRECT_EDGE ) {  // S_DIRECT_EDGE or INDIRECT_EDGE
-        size_t validNumOfScores = orientationCount - std::count( scoreSmooth.begin(), scoreSmooth.end(), 0 );
-        size_t voxPPI           = attributeOfVox[i]->getPPI();
+            if ( validNumOfScores == 1 && scoreSmooth[voxPPI] > 0 ) { return; }
+          }
 
-        if ( validNumOfScores == 1 && scoreSmooth[voxPPI] > 0 ) { continue; }
-      }
+          const auto&            pI = *( pointIndicesOfVox[i]->getPointIndices() );
+          PCCArenaVector<double> scores( orientationCount, 0.0, PCCArenaAllocator<double>( threadArena ) );
 
-      const auto& pI = *( pointIndicesOfVox[i]->getPointIndices() );
+          // for each point in a grid cell of i
+          for ( const auto& j : pI ) {
+            const auto& normal = normalsGen.getNormal( j );
+            for ( size_t k = 0; k < orientationCount; ++k ) {
+              scores[k] = normal * orientations[k] + weights[i] * scoreSmooth[k];
+            }
+            const auto& result = std::max_element( scores.begin(), scores.end() );
+            partition[j]       = std::distance( scores.begin(), result );
+          }
 
-      // for each point in a grid cell of i
-      for ( const auto& j : pI ) {
-        const auto& normal = normalsGen.getNormal( j );
-        for ( size_t k = 0; k < orientationCount; ++k ) {
-          scores[k] = normal * orientations[k] + weights[i] * scoreSmooth[k];
+          attributeOfVox[i]->setUpdatedFlag();
+        } );
+      } );
+      nextWave.clear();
+      for ( size_t w = 0; w < wave.size(); ++w ) {
+        for ( const auto j : indirectEdges[w] ) {
+          attributeOfVox[j]->updateEdge( INDIRECT_EDGE );
+          if ( j > wave[w] && refined[j] == 0u ) {
+            refined[j] = 1;
+            nextWave.push_back( j );
+          }
         }
-        const auto& result = std::max_element( scores.begin(), scores.end() );
-        partition[j]       = std::distance( scores.begin(), result );
       }
-
-      attributeOfVox[i]->setUpdatedFlag();
-    }  // for (size_t i = 0; i < uiTotalNumOfVoxs; ++i)
+      swap( wave, nextWave );
+    }
 
     // restarts the values of score smooth by checking to which partition points now is part of
-    for ( size_t i = 0; i < uiTotalNumOfVoxs; ++i ) {
-      attributeOfVox[i]->updateScores( *( pointIndicesOfVox[i]->getPointIndices() ), partition );
-    }
+    executionContext_->execute( [&] {
+      tbb::parallel_for( size_t( 0 ), size_t( uiTotalNumOfVoxs ), [&]( const size_t i ) {
+        attributeOfVox[i]->updateScores( *( pointIndicesOfVox[i]->getPointIndices() ), partition );
+      } );
+    } );
   } while ( ++iter < iterationCount );
 }
 
@@ -1528,31 +1658,38 @@ void PCCPatchSegmenter3::separateHighGradientPoints( const PCCPointSet3&
                                                      const double                      minGradient,
                                                      const size_t                      minNumHighGradientPoints,
                                                      std::vector<size_t>&              partition,
-                                                     std::vector<std::vector<size_t>>& adj,
+                                                     const PCCAdjacency&               adj,
                                                      std::vector<std::vector<size_t>>& connectedComponents ) {
-  // detect and remove high gradient points
+  // detect and remove high gradient points: each connected component only reads the shared partition and normals,
+  // so they are processed in parallel and their high gradient groups gathered in component order afterwards
+  std::vector<std::vector<std::vector<size_t>>> highGradientGroups( connectedComponents.size() );
+  executionContext_->execute( [&] {
+    tbb::parallel_for( size_t( 0 ), connectedComponents.size(), [&]( const size_t indexCC ) {
+      auto&    connectedComponent = connectedComponents[indexCC];
+      PCCPatch patch;
+      patch.setIndex( indexCC );
+      std::vector<bool> isComponentRemoved;
+      isComponentRemoved.resize( connectedComponent.size(), false );
+      bool bIsAdditionalProjectionPlane;
+      determinePatchOrientation( additionalProjectionAxis, absoluteD1, bIsAdditionalProjectionPlane, patch,
+                                 partition, connectedComponent );
+      generatePatchD0( points, geometryBitDepth3D, bIsAdditionalProjectionPlane, patch, connectedComponent );
+      calculateGradient( points, connectedComponent, normalsGen, orientations, orientationCount,
+                         partition[connectedComponent[0]], surfaceThickness, geometryBitDepth3D,
+                         bIsAdditionalProjectionPlane, minGradient, minNumHighGradientPoints, patch, adj,
+                         highGradientGroups[indexCC], isComponentRemoved );
+
+      // remove high gradient components from CC
+      std::vector<size_t> tmpConnectedComponent;
+      for ( size_t i = 0; i < connectedComponent.size(); ++i ) {
+        if ( !isComponentRemoved[i] ) { tmpConnectedComponent.push_back( connectedComponent[i] ); }
+      }
+      swap( connectedComponent, tmpConnectedComponent );
+    } );
+  } );
   std::vector<std::vector<size_t>> highGradientConnectedComponents;
-  size_t                           idx = 0;
-  for ( auto& connectedComponent : connectedComponents ) {
-    PCCPatch patch;
-    patch.setIndex( idx++ );
-    std::vector<bool> isComponentRemoved;
-    isComponentRemoved.resize( connectedComponent.size(), false );
-    bool bIsAdditionalProjectionPlane;
-    determinePatchOrientation( additionalProjectionAxis, absoluteD1, bIsAdditionalProjectionPlane, patch, partition,
-                               connectedComponent );
-    generatePatchD0( points, geometryBitDepth3D, bIsAdditionalProjectionPlane, patch, connectedComponent );
-    calculateGradient( points, connectedComponent, normalsGen, orientations, orientationCount,
-                       partition[connectedComponent[0]], surfaceThickness, geometryBitDepth3D,
-                       bIsAdditionalProjectionPlane, minGradient, minNumHighGradientPoints, patch, adj,
-                       highGradientConnectedComponents, isComponentRemoved );
-
-    // remove high gradient components from CC
-    std::vector<size_t> tmpConnectedComponent;
-    for ( size_t i = 0; i < connectedComponent.size(); ++i ) {
-      if ( !isComponentRemoved[i] ) { tmpConnectedComponent.push_back( connectedComponent[i] ); }
-    }
-    swap( connectedComponent, tmpConnectedComponent );
+  for ( auto& groups : highGradientGroups ) {
+    for ( auto& group : groups ) { highGradientConnectedComponents.push_back( std::move( group ) ); }
   }
 
   // try to join other CC
@@ -1715,7 +1852,7 @@ void PCCPatchSegmenter3::calculateGradient( const PCCPointSet3&               po
                                             const double                      minGradient,
                                             const size_t                      minNumHighGradientPoints,
                                             PCCPatch&                         patch,
-                                            std::vector<std::vector<size_t>>& adj,
+                                            const PCCAdjacency&               adj,
                                             std::vector<std::vector<size_t>>& highGradientConnectedComponents,
                                             std::vector<bool>&                isRemoved ) {
   /* for the case that the xyz components of a normal are the same:
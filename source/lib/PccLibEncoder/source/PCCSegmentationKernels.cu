@@ -0,0 +1,526 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCSegmentationKernels.h"
+
+#include <algorithm>
+#include <cuda_runtime.h>
+#include <thrust/device_vector.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/system/cuda/error.h>
+#include <thrust/system_error.h>
+#include <thrust/unique.h>
+
+// Built without contraction (--fmad=false, see CMakeLists.txt): a fused multiply-add rounds once where the CPU code
+// rounds twice, which would tip the ties of the segmentation scores.
+
+using namespace pcc;
+
+namespace {
+
+const unsigned int g_blockSize = 256;
+// cell coordinates are offset to be positive and packed on 17 bits each
+const int g_cellOffset = 32768;
+const int g_cellRange  = 1 << 17;
+
+inline unsigned int blockCount( const size_t count ) {
+  return static_cast<unsigned int>( ( count + g_blockSize - 1 ) / g_blockSize );
+}
+
+inline void check( const cudaError_t error ) {
+  if ( error != cudaSuccess ) { throw thrust::system_error( error, thrust::cuda_category() ); }
+}
+
+template <typename T>
+inline T* raw( thrust::device_vector<T>& vector ) {
+  return thrust::raw_pointer_cast( vector.data() );
+}
+
+template <typename T>
+inline const T* raw( const thrust::device_vector<T>& vector ) {
+  return thrust::raw_pointer_cast( vector.data() );
+}
+
+// The points sorted by cell, on a grid of 1 << shift wide cells: those of the occupied cell c, of key cellKeys[c],
+// are cellStarts[c] to cellStarts[c + 1], sortedPositions their positions and order their indices in the input.
+struct GridView {
+  const int16_t*  sortedPositions;
+  const uint32_t* order;
+  const uint64_t* cellKeys;
+  const uint32_t* cellStarts;
+  uint32_t        cellCount;
+  int             shift;
+};
+
+struct Grid {
+  thrust::device_vector<int16_t>  sortedPositions;
+  thrust::device_vector<uint32_t> order;
+  thrust::device_vector<uint64_t> cellKeys;
+  thrust::device_vector<uint32_t> cellStarts;
+  int                             shift;
+  GridView                        view() const {
+    GridView view = {raw( sortedPositions ), raw( order ), raw( cellKeys ), raw( cellStarts ),
+                     static_cast<uint32_t>( cellKeys.size() ), shift};
+    return view;
+  }
+};
+
+__device__ __forceinline__ int cellCoordinate( const int position, const int shift ) {
+  return ( position >> shift ) + g_cellOffset;
+}
+
+__device__ __forceinline__ uint64_t cellKey( const int x, const int y, const int z ) {
+  return ( uint64_t( x ) << 34 ) | ( uint64_t( y ) << 17 ) | uint64_t( z );
+}
+
+// index of the occupied cell of the key, -1 if it is empty
+__device__ int findCell( const GridView& grid, const uint64_t key ) {
+  uint32_t low  = 0;
+  uint32_t high = grid.cellCount;
+  while ( low < high ) {
+    const uint32_t middle = ( low + high ) >> 1;
+    if ( grid.cellKeys[middle] < key ) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low < grid.cellCount && grid.cellKeys[low] == key ? static_cast<int>( low ) : -1;
+}
+
+// visit( c ) for the occupied cells c at a Chebyshev distance of ring cells from the cell ( x, y, z )
+template <typename Visit>
+__device__ void visitRing( const GridView& grid, const int x, const int y, const int z, const int ring, Visit& visit ) {
+  for ( int dz = -ring; dz <= ring; ++dz ) {
+    for ( int dy = -ring; dy <= ring; ++dy ) {
+      // inside the faces of dz and dy, only the two cells of dx = -ring and ring are on the ring
+      const bool face = dz == -ring || dz == ring || dy == -ring || dy == ring;
+      const int  step = face ? 1 : 2 * ring;
+      for ( int dx = -ring; dx <= ring; dx += step ) {
+        const int cx = x + dx;
+        const int cy = y + dy;
+        const int cz = z + dz;
+        if ( cx < 0 || cy < 0 || cz < 0 || cx >= g_cellRange || cy >= g_cellRange || cz >= g_cellRange ) { continue; }
+        const int c = findCell( grid, cellKey( cx, cy, cz ) );
+        if ( c >= 0 ) { visit( c ); }
+      }
+    }
+  }
+}
+
+__global__ void cellKeysKernel( const int16_t* positions, const uint32_t count, const int shift, uint64_t* keys ) {
+  const uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if ( i >= count ) { return; }
+  keys[i] = cellKey( cellCoordinate( positions[3 * i], shift ), cellCoordinate( positions[3 * i + 1], shift ),
+                     cellCoordinate( positions[3 * i + 2], shift ) );
+}
+
+__global__ void gatherKernel( const int16_t* positions, const uint32_t* order, const uint32_t count, int16_t* sorted ) {
+  const uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if ( i >= count ) { return; }
+  for ( int k = 0; k < 3; ++k ) { sorted[3 * i + k] = positions[3 * order[i] + k]; }
+}
+
+void buildGrid( const thrust::device_vector<int16_t>& positions, const uint32_t count, const int shift, Grid& grid ) {
+  thrust::device_vector<uint64_t> keys( count );
+  cellKeysKernel<<<blockCount( count ), g_blockSize>>>( raw( positions ), count, shift, raw( keys ) );
+  check( cudaGetLastError() );
+  grid.order.resize( count );
+  thrust::sequence( grid.order.begin(), grid.order.end() );
+  thrust::sort_by_key( keys.begin(), keys.end(), grid.order.begin() );
+  grid.sortedPositions.resize( 3 * size_t( count ) );
+  gatherKernel<<<blockCount( count ), g_blockSize>>>( raw( positions ), raw( grid.order ), count,
+                                                     raw( grid.sortedPositions ) );
+  check( cudaGetLastError() );
+  grid.cellKeys.resize( count );
+  grid.cellStarts.resize( count + 1 );
+  const auto   ends      = thrust::unique_by_key_copy( keys.begin(), keys.end(),
+                                                  thrust::counting_iterator<uint32_t>( 0 ), grid.cellKeys.begin(),
+                                                  grid.cellStarts.begin() );
+  const size_t cellCount = ends.first - grid.cellKeys.begin();
+  grid.cellKeys.resize( cellCount );
+  grid.cellStarts.resize( cellCount + 1 );
+  grid.cellStarts[cellCount] = count;
+  grid.shift                 = shift;
+}
+
+// PCCDiagonalize(), step for step
+__device__ void diagonalize( const double A[3][3], double Q[3][3], double D[3][3] ) {
+  const int maxsteps = 24;
+  double    q[4]     = {0.0, 0.0, 0.0, 1.0};
+  double    AQ[3][3];
+  for ( int i = 0; i < maxsteps; ++i ) {
+    const double sqx = q[0] * q[0];
+    const double sqy = q[1] * q[1];
+    const double sqz = q[2] * q[2];
+    const double sqw = q[3] * q[3];
+    Q[0][0]          = ( sqx - sqy - sqz + sqw );
+    Q[1][1]          = ( -sqx + sqy - sqz + sqw );
+    Q[2][2]          = ( -sqx - sqy + sqz + sqw );
+    double tmp1      = q[0] * q[1];
+    double tmp2      = q[2] * q[3];
+    Q[1][0]          = 2.0 * ( tmp1 + tmp2 );
+    Q[0][1]          = 2.0 * ( tmp1 - tmp2 );
+    tmp1             = q[0] * q[2];
+    tmp2             = q[1] * q[3];
+    Q[2][0]          = 2.0 * ( tmp1 - tmp2 );
+    Q[0][2]          = 2.0 * ( tmp1 + tmp2 );
+    tmp1             = q[1] * q[2];
+    tmp2             = q[0] * q[3];
+    Q[2][1]          = 2.0 * ( tmp1 + tmp2 );
+    Q[1][2]          = 2.0 * ( tmp1 - tmp2 );
+
+    AQ[0][0] = Q[0][0] * A[0][0] + Q[1][0] * A[0][1] + Q[2][0] * A[0][2];
+    AQ[0][1] = Q[0][1] * A[0][0] + Q[1][1] * A[0][1] + Q[2][1] * A[0][2];
+    AQ[0][2] = Q[0][2] * A[0][0] + Q[1][2] * A[0][1] + Q[2][2] * A[0][2];
+    AQ[1][0] = Q[0][0] * A[0][1] + Q[1][0] * A[1][1] + Q[2][0] * A[1][2];
+    AQ[1][1] = Q[0][1] * A[0][1] + Q[1][1] * A[1][1] + Q[2][1] * A[1][2];
+    AQ[1][2] = Q[0][2] * A[0][1] + Q[1][2] * A[1][1] + Q[2][2] * A[1][2];
+    AQ[2][0] = Q[0][0] * A[0][2] + Q[1][0] * A[1][2] + Q[2][0] * A[2][2];
+    AQ[2][1] = Q[0][1] * A[0][2] + Q[1][1] * A[1][2] + Q[2][1] * A[2][2];
+    AQ[2][2] = Q[0][2] * A[0][2] + Q[1][2] * A[1][2] + Q[2][2] * A[2][2];
+
+    D[0][0] = AQ[0][0] * Q[0][0] + AQ[1][0] * Q[1][0] + AQ[2][0] * Q[2][0];
+    D[0][1] = AQ[0][0] * Q[0][1] + AQ[1][0] * Q[1][1] + AQ[2][0] * Q[2][1];
+    D[0][2] = AQ[0][0] * Q[0][2] + AQ[1][0] * Q[1][2] + AQ[2][0] * Q[2][2];
+    D[1][0] = AQ[0][1] * Q[0][0] + AQ[1][1] * Q[1][0] + AQ[2][1] * Q[2][0];
+    D[1][1] = AQ[0][1] * Q[0][1] + AQ[1][1] * Q[1][1] + AQ[2][1] * Q[2][1];
+    D[1][2] = AQ[0][1] * Q[0][2] + AQ[1][1] * Q[1][2] + AQ[2][1] * Q[2][2];
+    D[2][0] = AQ[0][2] * Q[0][0] + AQ[1][2] * Q[1][0] + AQ[2][2] * Q[2][0];
+    D[2][1] = AQ[0][2] * Q[0][1] + AQ[1][2] * Q[1][1] + AQ[2][2] * Q[2][1];
+    D[2][2] = AQ[0][2] * Q[0][2] + AQ[1][2] * Q[1][2] + AQ[2][2] * Q[2][2];
+
+    const double o[3] = {D[1][2], D[0][2], D[0][1]};
+    const double m[3] = {fabs( o[0] ), fabs( o[1] ), fabs( o[2] )};
+    const int    k0   = ( m[0] > m[1] && m[0] > m[2] ) ? 0 : ( m[1] > m[2] ) ? 1 : 2;
+    const int    k1   = ( k0 + 1 ) % 3;
+    const int    k2   = ( k0 + 2 ) % 3;
+    if ( o[k0] == 0.0 ) { break; }
+    double       thet = ( D[k2][k2] - D[k1][k1] ) / ( 2.0 * o[k0] );
+    const double sgn  = ( thet > 0.0 ) ? 1.0 : -1.0;
+    thet *= sgn;
+    const double t = sgn / ( thet + ( ( thet < 1.E6 ) ? sqrt( thet * thet + 1.0 ) : thet ) );
+    const double c = 1.0 / sqrt( t * t + 1.0 );
+    if ( c == 1.0 ) { break; }
+    double jr[4] = {0.0, 0.0, 0.0, 0.0};
+    jr[k0]       = sgn * sqrt( ( 1.0 - c ) / 2.0 );
+    jr[k0] *= -1.0;
+    jr[3] = sqrt( 1.0 - jr[k0] * jr[k0] );
+    if ( jr[3] == 1.0 ) { break; }
+    const double q0 = ( q[3] * jr[0] + q[0] * jr[3] + q[1] * jr[2] - q[2] * jr[1] );
+    const double q1 = ( q[3] * jr[1] - q[0] * jr[2] + q[1] * jr[3] + q[2] * jr[0] );
+    const double q2 = ( q[3] * jr[2] + q[0] * jr[1] - q[1] * jr[0] + q[2] * jr[3] );
+    const double q3 = ( q[3] * jr[3] - q[0] * jr[0] - q[1] * jr[1] - q[2] * jr[2] );
+    const double mq = sqrt( q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3 );
+    q[0]            = q0 / mq;
+    q[1]            = q1 / mq;
+    q[2]            = q2 / mq;
+    q[3]            = q3 / mq;
+  }
+}
+
+// One thread per point: the nearest neighbors are gathered ring of cells by ring of cells, until the points of the
+// cells not visited yet, more than ring cells away, cannot be nearer than the last one kept.
+__global__ void normalsKernel( const GridView grid,
+                               const int16_t* positions,
+                               const uint32_t count,
+                               const uint32_t neighborCount,
+                               const int      maxRing,
+                               const double3  viewPoint,
+                               double*        normals ) {
+  const uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if ( i >= count ) { return; }
+  const int px = positions[3 * i];
+  const int py = positions[3 * i + 1];
+  const int pz = positions[3 * i + 2];
+  const int x  = cellCoordinate( px, grid.shift );
+  const int y  = cellCoordinate( py, grid.shift );
+  const int z  = cellCoordinate( pz, grid.shift );
+
+  int64_t  dist[g_segmentationMaxNeighborCount];
+  uint32_t index[g_segmentationMaxNeighborCount];
+  uint32_t found = 0;
+  auto     visit = [&]( const int c ) {
+    for ( uint32_t j = grid.cellStarts[c]; j < grid.cellStarts[c + 1]; ++j ) {
+      const int64_t dx = grid.sortedPositions[3 * j] - px;
+      const int64_t dy = grid.sortedPositions[3 * j + 1] - py;
+      const int64_t dz = grid.sortedPositions[3 * j + 2] - pz;
+      const int64_t d  = dx * dx + dy * dy + dz * dz;
+      if ( found == neighborCount && d >= dist[found - 1] ) { continue; }
+      uint32_t k = found < neighborCount ? found++ : found - 1;
+      for ( ; k > 0 && dist[k - 1] > d; --k ) {
+        dist[k]  = dist[k - 1];
+        index[k] = index[k - 1];
+      }
+      dist[k]  = d;
+      index[k] = j;
+    }
+  };
+  for ( int ring = 0; ring <= maxRing; ++ring ) {
+    visitRing( grid, x, y, z, ring, visit );
+    const int64_t reach = int64_t( ring ) << grid.shift;
+    if ( found == neighborCount && dist[found - 1] <= reach * reach ) { break; }
+  }
+
+  // computeNormal()
+  double normal[3] = {0.0, 0.0, 0.0};
+  if ( found > 1 ) {
+    double bary[3] = {0.0, 0.0, 0.0};
+    for ( uint32_t k = 0; k < found; ++k ) {
+      for ( int a = 0; a < 3; ++a ) { bary[a] += grid.sortedPositions[3 * index[k] + a]; }
+    }
+    for ( int a = 0; a < 3; ++a ) { bary[a] /= double( found ); }
+    double covMat[3][3] = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+    for ( uint32_t k = 0; k < found; ++k ) {
+      double pt[3];
+      for ( int a = 0; a < 3; ++a ) { pt[a] = grid.sortedPositions[3 * index[k] + a] - bary[a]; }
+      covMat[0][0] += pt[0] * pt[0];
+      covMat[1][1] += pt[1] * pt[1];
+      covMat[2][2] += pt[2] * pt[2];
+      covMat[0][1] += pt[0] * pt[1];
+      covMat[0][2] += pt[0] * pt[2];
+      covMat[1][2] += pt[1] * pt[2];
+    }
+    covMat[1][0] = covMat[0][1];
+    covMat[2][0] = covMat[0][2];
+    covMat[2][1] = covMat[1][2];
+    for ( int a = 0; a < 3; ++a ) {
+      for ( int b = 0; b < 3; ++b ) { covMat[a][b] /= ( found - 1.0 ); }
+    }
+    double Q[3][3];
+    double D[3][3];
+    diagonalize( covMat, Q, D );
+    const double d0     = fabs( D[0][0] );
+    const double d1     = fabs( D[1][1] );
+    const double d2     = fabs( D[2][2] );
+    const int    column = ( d0 < d1 && d0 < d2 ) ? 0 : ( d1 < d2 ) ? 1 : 2;
+    for ( int a = 0; a < 3; ++a ) { normal[a] = Q[a][column]; }
+  }
+  const double facing =
+      normal[0] * ( viewPoint.x - px ) + normal[1] * ( viewPoint.y - py ) + normal[2] * ( viewPoint.z - pz );
+  for ( int a = 0; a < 3; ++a ) { normals[3 * size_t( i ) + a] = facing < 0.0 ? -normal[a] : normal[a]; }
+}
+
+struct Orientations {
+  double   axes_[18][3];
+  double   weights_[18];
+  uint32_t count_;
+};
+
+__global__ void scoresKernel( const double* normals, const uint32_t count, const Orientations o, size_t* partition ) {
+  const uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if ( i >= count ) { return; }
+  const double n[3]         = {normals[3 * size_t( i )], normals[3 * size_t( i ) + 1], normals[3 * size_t( i ) + 2]};
+  size_t       clusterIndex = 0;
+  double       bestScore    = n[0] * o.axes_[0][0] + n[1] * o.axes_[0][1] + n[2] * o.axes_[0][2];
+  for ( uint32_t j = 1; j < o.count_; ++j ) {
+    const double score = ( n[0] * o.axes_[j][0] + n[1] * o.axes_[j][1] + n[2] * o.axes_[j][2] ) * o.weights_[j];
+    if ( score > bestScore ) {
+      bestScore    = score;
+      clusterIndex = j;
+    }
+  }
+  partition[i] = clusterIndex;
+}
+
+// The cells are at least as wide as the radius: the neighbors of a point are in the cells of rings 0 and 1.
+template <bool fill>
+__global__ void radiusKernel( const GridView  grid,
+                              const int16_t*  positions,
+                              const uint32_t  count,
+                              const double    radius2,
+                              const uint64_t* offsets,
+                              uint32_t*       counts,
+                              uint32_t*       indices,
+                              int64_t*        dists ) {
+  const uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if ( i >= count ) { return; }
+  const int px    = positions[3 * i];
+  const int py    = positions[3 * i + 1];
+  const int pz    = positions[3 * i + 2];
+  uint64_t  found = fill ? offsets[i] : 0;
+  auto      visit = [&]( const int c ) {
+    for ( uint32_t j = grid.cellStarts[c]; j < grid.cellStarts[c + 1]; ++j ) {
+      const int64_t dx = grid.sortedPositions[3 * j] - px;
+      const int64_t dy = grid.sortedPositions[3 * j + 1] - py;
+      const int64_t dz = grid.sortedPositions[3 * j + 2] - pz;
+      const int64_t d  = dx * dx + dy * dy + dz * dz;
+      if ( double( d ) >= radius2 ) { continue; }
+      if ( fill ) {
+        indices[found] = grid.order[j];
+        dists[found]   = d;
+      }
+      ++found;
+    }
+  };
+  for ( int ring = 0; ring <= 1; ++ring ) {
+    visitRing( grid, cellCoordinate( px, grid.shift ), cellCoordinate( py, grid.shift ),
+               cellCoordinate( pz, grid.shift ), ring, visit );
+  }
+  if ( !fill ) {
+    counts[i] = static_cast<uint32_t>( found );
+    return;
+  }
+  // closest first, then by index; the rows are short enough for an insertion sort
+  for ( uint64_t k = offsets[i] + 1; k < found; ++k ) {
+    const uint32_t index = indices[k];
+    const int64_t  d     = dists[k];
+    uint64_t       l     = k;
+    for ( ; l > offsets[i] && ( dists[l - 1] > d || ( dists[l - 1] == d && indices[l - 1] > index ) ); --l ) {
+      indices[l] = indices[l - 1];
+      dists[l]   = dists[l - 1];
+    }
+    indices[l] = index;
+    dists[l]   = d;
+  }
+}
+
+}  // namespace
+
+bool pcc::segmentationDeviceAvailable() {
+  int deviceCount = 0;
+  return cudaGetDeviceCount( &deviceCount ) == cudaSuccess && deviceCount > 0;
+}
+
+bool pcc::computeNormalsKernel( const int16_t* positions,
+                                const size_t   pointCount,
+                                const size_t   neighborCount,
+                                const double   viewPoint[3],
+                                double*        normals ) {
+  if ( pointCount == 0 || pointCount > UINT32_MAX || neighborCount == 0 ||
+       neighborCount > g_segmentationMaxNeighborCount || !segmentationDeviceAvailable() ) {
+    return false;
+  }
+  // about neighborCount points to a cell of a surface; the extent bounds the rings an isolated point searches
+  int shift = 0;
+  while ( ( size_t( 1 ) << ( 2 * shift ) ) < neighborCount ) { ++shift; }
+  int extent = 0;
+  for ( int a = 0; a < 3; ++a ) {
+    int low  = positions[a];
+    int high = positions[a];
+    for ( size_t i = 1; i < pointCount; ++i ) {
+      low  = ( std::min )( low, int( positions[3 * i + a] ) );
+      high = ( std::max )( high, int( positions[3 * i + a] ) );
+    }
+    extent = ( std::max )( extent, ( ( high >> shift ) - ( low >> shift ) ) );
+  }
+  try {
+    const uint32_t                 count = static_cast<uint32_t>( pointCount );
+    thrust::device_vector<int16_t> devicePositions( positions, positions + 3 * pointCount );
+    thrust::device_vector<double>  deviceNormals( 3 * pointCount );
+    Grid                           grid;
+    buildGrid( devicePositions, count, shift, grid );
+    normalsKernel<<<blockCount( count ), g_blockSize>>>(
+        grid.view(), raw( devicePositions ), count, static_cast<uint32_t>( neighborCount ), extent,
+        make_double3( viewPoint[0], viewPoint[1], viewPoint[2] ), raw( deviceNormals ) );
+    check( cudaGetLastError() );
+    thrust::copy( deviceNormals.begin(), deviceNormals.end(), normals );
+  } catch ( const std::exception& ) { return false; }
+  return true;
+}
+
+bool pcc::initialSegmentationKernel( const double* normals,
+                                     const size_t  pointCount,
+                                     const double* orientations,
+                                     const double* weights,
+                                     const size_t  orientationCount,
+                                     size_t*       partition ) {
+  if ( pointCount == 0 || pointCount > UINT32_MAX || orientationCount == 0 || orientationCount > 18 ||
+       !segmentationDeviceAvailable() ) {
+    return false;
+  }
+  Orientations o;
+  o.count_ = static_cast<uint32_t>( orientationCount );
+  for ( size_t j = 0; j < orientationCount; ++j ) {
+    for ( size_t a = 0; a < 3; ++a ) { o.axes_[j][a] = orientations[3 * j + a]; }
+    o.weights_[j] = weights[j];
+  }
+  try {
+    const uint32_t                count = static_cast<uint32_t>( pointCount );
+    thrust::device_vector<double> deviceNormals( normals, normals + 3 * pointCount );
+    thrust::device_vector<size_t> devicePartition( pointCount );
+    scoresKernel<<<blockCount( count ), g_blockSize>>>( raw( deviceNormals ), count, o, raw( devicePartition ) );
+    check( cudaGetLastError() );
+    thrust::copy( devicePartition.begin(), devicePartition.end(), partition );
+  } catch ( const std::exception& ) { return false; }
+  return true;
+}
+
+bool pcc::radiusAdjacencyKernel( const int16_t*         positions,
+                                 const size_t           pointCount,
+                                 const double           radius2,
+                                 const size_t           maxNeighborCount,
+                                 std::vector<size_t>&   offsets,
+                                 std::vector<uint32_t>& indices ) {
+  if ( pointCount == 0 || pointCount > UINT32_MAX || radius2 <= 0.0 || !segmentationDeviceAvailable() ) {
+    return false;
+  }
+  int shift = 0;
+  while ( double( int64_t( 1 ) << ( 2 * shift ) ) < radius2 && shift < 15 ) { ++shift; }
+  try {
+    const uint32_t                  count = static_cast<uint32_t>( pointCount );
+    thrust::device_vector<int16_t>  devicePositions( positions, positions + 3 * pointCount );
+    thrust::device_vector<uint32_t> counts( count );
+    thrust::device_vector<uint64_t> rowOffsets( pointCount + 1, 0 );
+    Grid                            grid;
+    buildGrid( devicePositions, count, shift, grid );
+    radiusKernel<false><<<blockCount( count ), g_blockSize>>>( grid.view(), raw( devicePositions ), count, radius2,
+                                                               nullptr, raw( counts ), nullptr, nullptr );
+    check( cudaGetLastError() );
+    thrust::inclusive_scan( counts.begin(), counts.end(), rowOffsets.begin() + 1 );
+    const uint64_t                  total = rowOffsets[pointCount];
+    thrust::device_vector<uint32_t> deviceIndices( total );
+    thrust::device_vector<int64_t>  deviceDists( total );
+    radiusKernel<true><<<blockCount( count ), g_blockSize>>>( grid.view(), raw( devicePositions ), count, radius2,
+                                                              raw( rowOffsets ), nullptr, raw( deviceIndices ),
+                                                              raw( deviceDists ) );
+    check( cudaGetLastError() );
+    std::vector<uint64_t> hostOffsets( pointCount + 1 );
+    std::vector<uint32_t> hostIndices( total );
+    thrust::copy( rowOffsets.begin(), rowOffsets.end(), hostOffsets.begin() );
+    thrust::copy( deviceIndices.begin(), deviceIndices.end(), hostIndices.begin() );
+    offsets.assign( 1, 0 );
+    offsets.reserve( pointCount + 1 );
+    indices.clear();
+    indices.reserve( total );
+    for ( size_t i = 0; i < pointCount; ++i ) {
+      const size_t rowCount = ( std::min )( size_t( hostOffsets[i + 1] - hostOffsets[i] ), maxNeighborCount );
+      indices.insert( indices.end(), hostIndices.begin() + hostOffsets[i],
+                      hostIndices.begin() + hostOffsets[i] + rowCount );
+      offsets.push_back( indices.size() );
+    }
+  } catch ( const std::exception& ) { return false; }
+  return true;
+}
@@ -31,6 +31,7 @@
  * THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "PCCVideoEncoder.h"
+#include "PCCProfiler.h"
 
 #include "PCCVideoBitstream.h"
 #include "PCCVideo.h"
@@ -44,9 +45,32 @@
 #else
 #include "PCCHDRToolsAppColorConverter.h"
 #endif
+#include <mutex>
 
 using namespace pcc;
 
+// JM and VTM initialize and free their tables in globals with every encoder instance, so these library encoders
+// must not run concurrently. The HM library encoder serializes its own setup, the app encoders are separate
+// processes.
+static std::mutex g_libraryEncoderMutex;
+
+static bool isSerializedLibraryEncoder( PCCCodecId codecId ) {
+#ifdef USE_JMLIB_VIDEO_CODEC
+  if ( codecId == JMLIB ) { return true; }
+#endif
+#ifdef USE_VTMLIB_VIDEO_CODEC
+  if ( codecId == VTMLIB ) { return true; }
+#endif
+  return false;
+}
+
+bool PCCVideoEncoder::readsMotionEstimationFiles( PCCCodecId codecId ) {
+#ifdef USE_HMLIB_VIDEO_CODEC
+  if ( codecId == HMLIB ) { return false; }
+#endif
+  return true;
+}
+
 PCCVideoEncoder::PCCVideoEncoder() = default;
 
 PCCVideoEncoder::~PCCVideoEncoder() = default;
@@ -87,7 +111,7 @@ void PCCVideoEncoder::patchColorSubsmple( PCCVideo<T, 3>&    video,
     // iterate the patch information and perform chroma down-sampling on
     // each patch individually
     std::vector<PCCPatch>& patches      = context.getTitleFrameContext().getPatches();
-    std::vector<size_t>&   blockToPatch = context.getTitleFrameContext().getBlockToPatch();
+    const auto&            blockToPatch = context.getTitleFrameContext().getBlockToPatch();
     for ( int patchIdx = 0; patchIdx <= patches.size(); patchIdx++ ) {
       size_t occupancyResolution;
       size_t patch_left;
@@ -304,6 +328,7 @@ bool PCCVideoEncoder::compress( PCCVideo<T, 3>&    video,
                                 const size_t       downsamplingFilter,
                                 const size_t       upsamplingFilter,
                                 const bool         patchColorSubsampling ) {
+  PCC_PROFILE_ZONE( "video compress" );
   auto& frames = video.getFrames();
   if ( frames.empty() || frames[0].getChannelCount() != 3 ) { return false; }
   const size_t      width                = frames[0].getWidth();
@@ -372,6 +397,7 @@ bool PCCVideoEncoder::compress( PCCVideo<T, 3>&    video,
   params.blockToPatchFile_            = blockToPatchFileName;
   params.occupancyMapFile_            = occupancyMapFileName;
   params.patchInfoFile_               = patchInfoFileName;
+  params.sideInfo_                    = use3dmv || usePccRDO ? sideInfo_ : nullptr;
   params.cuTransquantBypassFlagForce_ = false;
   params.transquantBypassEnable_      = false;
   params.inputColourSpaceConvert_     = use444CodecIo;
@@ -379,12 +405,22 @@ bool PCCVideoEncoder::compress( PCCVideo<T, 3>&    video,
   params.shvcLayerIndex_              = shvcLayerIndex;
   params.shvcRateX_                   = shvcRateX;
   params.shvcRateY_                   = shvcRateY;
+  params.wavefront_                   = wavefront_;
+  params.hardwareDevice_              = hardwareDevice_;
+  params.chunkFrames_                 = chunkFrames_;
+  // HEVC tiles are at least 256 luma samples wide and 64 high
+  params.tileColumns_                 = ( std::min )( tileColumns_, ( std::max )( width / 256, size_t( 1 ) ) );
+  params.tileRows_                    = ( std::min )( tileRows_, ( std::max )( height / 64, size_t( 1 ) ) );
   printf( "Encode: video size = %zu x %zu num frames = %zu \n", video.getWidth(), video.getHeight(),
           video.getFrameCount() );
   fflush( stdout );
   PCCVideo<T, 3> videoRec;
   auto           encoder = PCCVirtualVideoEncoder<T>::create( codecId );
-  encoder->encode( video, params, bitstream, videoRec );
+  {
+    std::unique_lock<std::mutex> lock( g_libraryEncoderMutex, std::defer_lock );
+    if ( isSerializedLibraryEncoder( codecId ) ) { lock.lock(); }
+    encoder->encode( video, params, bitstream, videoRec );
+  }
 
   size_t frameIndex = 0;
   for ( auto& image : videoRec ) {
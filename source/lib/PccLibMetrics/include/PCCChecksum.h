@@ -61,6 +61,9 @@ class PCCChecksum {
 
  private:
   bool compare( std::vector<std::vector<uint8_t>>& checksumsA, std::vector<std::vector<uint8_t>>& checksumsB );
+  // Appends the checksums of the frames to checksums; returns the index of the first one.
+  size_t compute( PCCGroupOfFrames& groupOfFrames, bool reorderPoints, std::vector<std::vector<uint8_t>>& checksums );
+  void   print( const char* name, size_t first, const std::vector<std::vector<uint8_t>>& checksums );
 
   PCCMetricsParameters              params_;
   std::vector<std::vector<uint8_t>> checksumsSrc_;
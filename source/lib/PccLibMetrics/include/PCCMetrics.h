@@ -62,6 +62,15 @@ class QualityMetrics {
 
   void print( char code );
 
+  float getC2cMse() const { return c2cMse_; }
+  float getC2cPsnr() const { return c2cPsnr_; }
+  float getC2pMse() const { return c2pMse_; }
+  float getC2pPsnr() const { return c2pPsnr_; }
+  float getColorMse( size_t c ) const { return colorMse_[c]; }
+  float getColorPsnr( size_t c ) const { return colorPsnr_[c]; }
+  float getReflectanceMse() const { return reflectanceMse_; }
+  float getReflectancePsnr() const { return reflectancePsnr_; }
+
  private:
   // point-2-point ( cloud 2 cloud ), benchmark metric
   float c2cMse_;
@@ -100,6 +109,13 @@ class PCCMetrics {
   void compute( PCCPointSet3& source, PCCPointSet3& reconstruct, const PCCPointSet3& normalSource );
   void display();
 
+  // Appends the frames of another PCCMetrics, e.g. one that computed a single frame on its own.
+  void merge( const PCCMetrics& metrics );
+
+  // One CSV row per frame with the final (symmetric) metrics, the frames numbered from firstFrameIndex.
+  void writeCsvHeader( std::ostream& stream ) const;
+  void writeCsv( std::ostream& stream, size_t firstFrameIndex ) const;
+
  private:
   std::vector<size_t>         sourcePoints_;
   std::vector<size_t>         sourceDuplicates_;
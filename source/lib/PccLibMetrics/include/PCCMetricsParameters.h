@@ -48,6 +48,7 @@ class PCCMetricsParameters {
 
   bool computeMetrics_;
   bool computeChecksum_;
+  bool fastChecksum_;  // PCCDigest64 instead of MD5 for the frame checksums
 
   size_t startFrameNumber_;
   size_t frameCount_;
@@ -57,6 +58,7 @@ class PCCMetricsParameters {
   std::string uncompressedDataPath_;
   std::string reconstructedDataPath_;
   std::string normalDataPath_;
+  std::string csvPath_;  // per-frame metrics as CSV, written as the frames complete; none if empty
 
   size_t nbThread_;
 
@@ -35,6 +35,7 @@
 #include "PCCPointSet.h"
 
 #include "PCCChecksum.h"
+#include <tbb/tbb.h>
 
 using namespace std;
 using namespace pcc;
@@ -49,42 +50,45 @@ PCCChecksum::~PCCChecksum() {
 void PCCChecksum::setParameters( const PCCMetricsParameters& params ) { params_ = params; }
 
 void PCCChecksum::computeSource( PCCGroupOfFrames& groupOfFrames ) {
-  for ( auto& frame : groupOfFrames ) {
-    checksumsSrc_.push_back( frame.computeChecksum( true ) );
-    printf( "ChecksumSrc: " );
-    for ( auto& c : checksumsSrc_.back() ) { printf( "%02x", c ); }
-    printf( "\n" );
-    fflush( stdout );
-  }
+  print( "ChecksumSrc", compute( groupOfFrames, true, checksumsSrc_ ), checksumsSrc_ );
 }
 
 void PCCChecksum::computeReordered( PCCGroupOfFrames& groupOfFrames ) {
-  for ( auto& frame : groupOfFrames ) {
-    checksumsOrd_.push_back( frame.computeChecksum( true ) );
-    printf( "ChecksumOrd: " );
-    for ( auto& c : checksumsOrd_.back() ) { printf( "%02x", c ); }
-    printf( "\n" );
-    fflush( stdout );
-  }
+  print( "ChecksumOrd", compute( groupOfFrames, true, checksumsOrd_ ), checksumsOrd_ );
 }
 void PCCChecksum::computeReconstructed( PCCGroupOfFrames& groupOfFrames ) {
-  for ( auto& frame : groupOfFrames ) {
-    checksumsRec_.push_back( frame.computeChecksum() );
-    printf( "ChecksumRec: " );
-    for ( auto& c : checksumsRec_.back() ) { printf( "%02x", c ); }
-    printf( "\n" );
-    fflush( stdout );
-  }
+  print( "ChecksumRec", compute( groupOfFrames, false, checksumsRec_ ), checksumsRec_ );
 }
 
 void PCCChecksum::computeDecoded( PCCGroupOfFrames& groupOfFrames ) {
-  for ( auto& frame : groupOfFrames ) {
-    checksumsDec_.push_back( frame.computeChecksum() );
-    printf( "ChecksumDec: " );
-    for ( auto& c : checksumsDec_.back() ) { printf( "%02x", c ); }
+  print( "ChecksumDec", compute( groupOfFrames, false, checksumsDec_ ), checksumsDec_ );
+}
+
+size_t PCCChecksum::compute( PCCGroupOfFrames&                  groupOfFrames,
+                             bool                               reorderPoints,
+                             std::vector<std::vector<uint8_t>>& checksums ) {
+  // The frames are independent: their checksums are computed concurrently and appended in frame order.
+  const size_t first = checksums.size();
+  checksums.resize( first + groupOfFrames.getFrameCount() );
+  tbb::parallel_for( size_t( 0 ), groupOfFrames.getFrameCount(), [&]( const size_t i ) {
+    if ( groupOfFrames.isWindowed() ) {
+      PCCPointSet3 frame = groupOfFrames.acquire( i );
+      groupOfFrames.release( i );
+      checksums[first + i] = frame.computeChecksum( reorderPoints, params_.fastChecksum_ );
+    } else {
+      checksums[first + i] = groupOfFrames[i].computeChecksum( reorderPoints, params_.fastChecksum_ );
+    }
+  } );
+  return first;
+}
+
+void PCCChecksum::print( const char* name, const size_t first, const std::vector<std::vector<uint8_t>>& checksums ) {
+  for ( size_t i = first; i < checksums.size(); i++ ) {
+    printf( "%s: ", name );
+    for ( auto& c : checksums[i] ) { printf( "%02x", c ); }
     printf( "\n" );
-    fflush( stdout );
   }
+  fflush( stdout );
 }
 
 void PCCChecksum::read( const std::string& compressedStreamPath ) {
@@ -126,6 +130,10 @@ bool PCCChecksum::compare( std::vector<std::vector<uint8_t>>& checksumsA,
                            std::vector<std::vector<uint8_t>>& checksumsB ) {
   size_t num   = ( std::min )( checksumsA.size(), checksumsB.size() );
   bool   equal = checksumsA.size() == checksumsB.size();
+  if ( num > 0 && checksumsA[0].size() != checksumsB[0].size() ) {
+    printf( "Checksums of %zu and %zu bytes: one side used fastChecksum, the other MD5\n", checksumsA[0].size(),
+            checksumsB[0].size() );
+  }
   for ( size_t i = 0; equal && ( i < num ); i++ ) {
     if ( checksumsA[i] != checksumsB[i] ) { equal = false; }
     printf( "PLY %4zu: [MD5:", params_.startFrameNumber_ + i );
@@ -73,132 +73,180 @@ QualityMetrics::QualityMetrics() :
 void QualityMetrics::setParameters( const PCCMetricsParameters& params ) { params_ = params; }
 
 void QualityMetrics::compute( const PCCPointSet3& pointcloudA, const PCCPointSet3& pointcloudB ) {
-  double maxC2c         = ( std::numeric_limits<double>::min )();
-  double maxC2p         = ( std::numeric_limits<double>::min )();
-  double sseC2p         = 0;
-  double sseC2c         = 0;
-  double sseReflectance = 0;
-  size_t num            = 0;
-  double sseColor[3]    = {0.0, 0.0, 0.0};
+  // Sums of one chunk of the points of A. The chunks have a fixed size and are summed in order once all of them are
+  // done, so the metrics do not depend on the number of threads nor on the scheduling.
+  struct Accumulator {
+    double maxC2c         = ( std::numeric_limits<double>::min )();
+    double maxC2p         = ( std::numeric_limits<double>::min )();
+    double sseC2p         = 0;
+    double sseC2c         = 0;
+    double sseReflectance = 0;
+    size_t num            = 0;
+    double sseColor[3]    = {0.0, 0.0, 0.0};
+  };
 
   psnr_ = params_.resolution_;
 
   PCCKdTree    kdtree( pointcloudB );
-  PCCNNResult  result;
   const size_t num_results_max  = 30;
   const size_t num_results_incr = 5;
+  const size_t pointCount       = pointcloudA.getPointCount();
+  const size_t chunkSize        = 4096;
+  const bool   computeColor     = params_.computeColor_ && pointcloudA.hasColors() && pointcloudB.hasColors();
+  const bool   computeC2p       = params_.computeC2p_ && pointcloudB.hasNormals() && pointcloudA.hasNormals();
+  const bool   computeReflectance =
+      params_.computeReflectance_ && pointcloudA.hasReflectances() && pointcloudB.hasReflectances();
 
-  auto& normalsB = pointcloudB.getNormals();
-  for ( size_t indexA = 0; indexA < pointcloudA.getPointCount(); indexA++ ) {
-    // For point 'i' in A, find its nearest neighbor in B. store it in 'j'
-    size_t num_results = 0;
-    do {
-      num_results += num_results_incr;
-      kdtree.search( pointcloudA[indexA], num_results, result );
-    } while ( result.dist( 0 ) == result.dist( num_results - 1 ) && num_results + num_results_incr <= num_results_max );
+  // The first search of all the points of A runs as one parallel batch, the points whose neighbors are all at the
+  // same distance are searched again with more neighbors.
+  PCCNNBatchResult<double> batchResult;
+  kdtree.searchBatch( pointcloudA.getPositions(), num_results_incr, batchResult );
 
-    // Compute point-to-point, which should be equal to sqrt( dist[0] )
-    double distProjC2c = result.dist( 0 );
+  auto&                    normalsB = pointcloudB.getNormals();
+  std::vector<Accumulator> accumulators( ( pointCount + chunkSize - 1 ) / chunkSize );
+  tbb::parallel_for(
+      tbb::blocked_range<size_t>( 0, accumulators.size() ),
+      [&]( const tbb::blocked_range<size_t>& chunks ) {
+        PCCNNResult         result;
+        std::vector<size_t> sameDistList;
+        std::vector<float>  yuvA;
+        std::vector<float>  yuvB;
+        for ( size_t chunk = chunks.begin(); chunk != chunks.end(); ++chunk ) {
+          Accumulator& acc = accumulators[chunk];
+          for ( size_t indexA = chunk * chunkSize; indexA < ( std::min )( pointCount, ( chunk + 1 ) * chunkSize );
+                indexA++ ) {
+            // For point 'i' in A, find its nearest neighbor in B. store it in 'j'
+            size_t num_results = batchResult.neighborCount();
+            result.resize( num_results );
+            std::copy( batchResult.indices( indexA ), batchResult.indices( indexA ) + num_results, result.indices() );
+            std::copy( batchResult.dist( indexA ), batchResult.dist( indexA ) + num_results, result.dist() );
+            while ( result.dist( 0 ) == result.dist( num_results - 1 ) &&
+                    num_results + num_results_incr <= num_results_max ) {
+              num_results += num_results_incr;
+              kdtree.search( pointcloudA[indexA], num_results, result );
+            }
 
-    // Build the list of all the points of same distances.
-    std::vector<size_t> sameDistList;
-    if ( params_.computeColor_ || params_.computeC2p_ ) {
-      for ( size_t j = 0; j < num_results && ( fabs( result.dist( 0 ) - result.dist( j ) ) < 1e-8 ); j++ ) {
-        sameDistList.push_back( result.indices( j ) );
-      }
-    }
-    std::sort( sameDistList.begin(), sameDistList.end() );
+            // Compute point-to-point, which should be equal to sqrt( dist[0] )
+            double distProjC2c = result.dist( 0 );
 
-    // Compute point-to-plane, normals in B will be used for point-to-plane
-    double distProjC2p = 0.0;
-    if ( params_.computeC2p_ && pointcloudB.hasNormals() && pointcloudA.hasNormals() ) {
-      for ( auto& indexB : sameDistList ) {
-        std::vector<double> errVector( 3 );
-        for ( size_t j = 0; j < 3; j++ ) { errVector[j] = pointcloudA[indexA][j] - pointcloudB[indexB][j]; }
-        double dist = pow( errVector[0] * normalsB[indexB][0] + errVector[1] * normalsB[indexB][1] +
-                               errVector[2] * normalsB[indexB][2],
-                           2.F );
-        distProjC2p += dist;
-      }
-      distProjC2p /= sameDistList.size();
-    }
+            // Build the list of all the points of same distances.
+            sameDistList.clear();
+            if ( params_.computeColor_ || params_.computeC2p_ ) {
+              for ( size_t j = 0; j < num_results && ( fabs( result.dist( 0 ) - result.dist( j ) ) < 1e-8 ); j++ ) {
+                sameDistList.push_back( result.indices( j ) );
+              }
+            }
+            std::sort( sameDistList.begin(), sameDistList.end() );
 
-    size_t indexB = result.indices( 0 );
-    double distColor[3];
-    distColor[0] = distColor[1] = distColor[2] = 0.0;
-    if ( params_.computeColor_ && pointcloudA.hasColors() && pointcloudB.hasColors() ) {
-      std::vector<float> yuvA;
-      std::vector<float> yuvB;
-      PCCColor3B         rgb;
-      convertRGBtoYUVBT709( pointcloudA.getColor( indexA ), yuvA );
-      if ( params_.neighborsProc_ != 0 ) {
-        switch ( params_.neighborsProc_ ) {
-          case 0: break;
-          case 1:  // Average
-          case 2:  // Weighted average
-          {
-            int          nbdupcumul = 0;
-            unsigned int r          = 0;
-            unsigned int g          = 0;
-            unsigned int b          = 0;
-            for ( unsigned long long i : sameDistList ) {
-              int nbdup = 1;  // pointcloudB.xyz.nbdup[ indices_sameDst[n] ];
-              r += nbdup * pointcloudB.getColor( i )[0];
-              g += nbdup * pointcloudB.getColor( i )[1];
-              b += nbdup * pointcloudB.getColor( i )[2];
-              nbdupcumul += nbdup;
+            // Compute point-to-plane, normals in B will be used for point-to-plane
+            double distProjC2p = 0.0;
+            if ( computeC2p ) {
+              for ( auto& indexB : sameDistList ) {
+                double errVector[3];
+                for ( size_t j = 0; j < 3; j++ ) { errVector[j] = pointcloudA[indexA][j] - pointcloudB[indexB][j]; }
+                double dist = errVector[0] * normalsB[indexB][0] + errVector[1] * normalsB[indexB][1] +
+                              errVector[2] * normalsB[indexB][2];
+                distProjC2p += dist * dist;
+              }
+              distProjC2p /= sameDistList.size();
             }
-            rgb[0] = static_cast<unsigned char>( round( static_cast<double>( r ) / nbdupcumul ) );
-            rgb[1] = static_cast<unsigned char>( round( static_cast<double>( g ) / nbdupcumul ) );
-            rgb[2] = static_cast<unsigned char>( round( static_cast<double>( b ) / nbdupcumul ) );
-            convertRGBtoYUVBT709( rgb, yuvB );
-            for ( size_t i = 0; i < 3; i++ ) { distColor[i] = pow( yuvA[i] - yuvB[i], 2.F ); }
-          } break;
-          case 3:  // Min
-          case 4:  // Max
-          {
-            float  distBest  = 0;
-            size_t indexBest = 0;
-            for ( auto index : sameDistList ) {
-              convertRGBtoYUVBT709( pointcloudB.getColor( index ), yuvB );
-              float dist =
-                  pow( yuvA[0] - yuvB[0], 2.F ) + pow( yuvA[1] - yuvB[1], 2.F ) + pow( yuvA[2] - yuvB[2], 2.F );
-              if ( ( ( params_.neighborsProc_ == 3 ) && ( dist < distBest ) ) ||
-                   ( ( params_.neighborsProc_ == 4 ) && ( dist > distBest ) ) ) {
-                distBest  = dist;
-                indexBest = index;
+
+            size_t indexB = result.indices( 0 );
+            double distColor[3];
+            distColor[0] = distColor[1] = distColor[2] = 0.0;
+            if ( computeColor ) {
+              PCCColor3B rgb;
+              convertRGBtoYUVBT709( pointcloudA.getColor( indexA ), yuvA );
+              if ( params_.neighborsProc_ != 0 ) {
+                switch ( params_.neighborsProc_ ) {
+                  case 0: break;
+                  case 1:  // Average
+                  case 2:  // Weighted average
+                  {
+                    int          nbdupcumul = 0;
+                    unsigned int r          = 0;
+                    unsigned int g          = 0;
+                    unsigned int b          = 0;
+                    for ( unsigned long long i : sameDistList ) {
+                      int nbdup = 1;  // pointcloudB.xyz.nbdup[ indices_sameDst[n] ];
+                      r += nbdup * pointcloudB.getColor( i )[0];
+                      g += nbdup * pointcloudB.getColor( i )[1];
+                      b += nbdup * pointcloudB.getColor( i )[2];
+                      nbdupcumul += nbdup;
+                    }
+                    rgb[0] = static_cast<unsigned char>( round( static_cast<double>( r ) / nbdupcumul ) );
+                    rgb[1] = static_cast<unsigned char>( round( static_cast<double>( g ) / nbdupcumul ) );
+                    rgb[2] = static_cast<unsigned char>( round( static_cast<double>( b ) / nbdupcumul ) );
+                    convertRGBtoYUVBT709( rgb, yuvB );
+                  } break;
+                  case 3:  // Min
+                  case 4:  // Max
+                  {
+                    float  distBest  = 0;
+                    size_t indexBest = 0;
+                    for ( auto index : sameDistList ) {
+                      convertRGBtoYUVBT709( pointcloudB.getColor( index ), yuvB );
+                      float dist = ( yuvA[0] - yuvB[0] ) * ( yuvA[0] - yuvB[0] ) +
+                                   ( yuvA[1] - yuvB[1] ) * ( yuvA[1] - yuvB[1] ) +
+                                   ( yuvA[2] - yuvB[2] ) * ( yuvA[2] - yuvB[2] );
+                      if ( ( ( params_.neighborsProc_ == 3 ) && ( dist < distBest ) ) ||
+                           ( ( params_.neighborsProc_ == 4 ) && ( dist > distBest ) ) ) {
+                        distBest  = dist;
+                        indexBest = index;
+                      }
+                    }
+                    convertRGBtoYUVBT709( pointcloudB.getColor( indexBest ), yuvB );
+                  } break;
+                }
+              } else {
+                convertRGBtoYUVBT709( pointcloudB.getColor( indexB ), yuvB );
+              }
+              for ( size_t i = 0; i < 3; i++ ) {
+                float diff   = yuvA[i] - yuvB[i];
+                distColor[i] = diff * diff;
               }
             }
-            convertRGBtoYUVBT709( pointcloudB.getColor( indexBest ), yuvB );
-          } break;
-        }
-      } else {
-        convertRGBtoYUVBT709( pointcloudB.getColor( indexB ), yuvB );
-      }
-      for ( size_t i = 0; i < 3; i++ ) { distColor[i] = pow( yuvA[i] - yuvB[i], 2.F ); }
-    }
 
-    double distReflectance = 0.0;
-    if ( params_.computeReflectance_ && pointcloudA.hasReflectances() && pointcloudB.hasReflectances() ) {
-      distReflectance = pow( pointcloudA.getReflectance( indexA ) - pointcloudB.getReflectance( indexB ), 2.F );
-    }
-    num++;
+            double distReflectance = 0.0;
+            if ( computeReflectance ) {
+              double diff     = pointcloudA.getReflectance( indexA ) - pointcloudB.getReflectance( indexB );
+              distReflectance = diff * diff;
+            }
+            acc.num++;
 
-    // mean square distance
-    if ( params_.computeC2c_ ) {
-      sseC2c += distProjC2c;
-      if ( distProjC2c > maxC2c ) { maxC2c = distProjC2c; }
-    }
-    if ( params_.computeC2p_ ) {
-      sseC2p += distProjC2p;
-      if ( distProjC2p > maxC2p ) { maxC2p = distProjC2p; }
-    }
-    if ( params_.computeColor_ ) {
-      for ( size_t i = 0; i < 3; i++ ) { sseColor[i] += distColor[i]; }
-    }
-    if ( params_.computeReflectance_ && pointcloudA.hasReflectances() && pointcloudB.hasReflectances() ) {
-      sseReflectance += distReflectance;
-    }
+            // mean square distance
+            if ( params_.computeC2c_ ) {
+              acc.sseC2c += distProjC2c;
+              if ( distProjC2c > acc.maxC2c ) { acc.maxC2c = distProjC2c; }
+            }
+            if ( params_.computeC2p_ ) {
+              acc.sseC2p += distProjC2p;
+              if ( distProjC2p > acc.maxC2p ) { acc.maxC2p = distProjC2p; }
+            }
+            if ( params_.computeColor_ ) {
+              for ( size_t i = 0; i < 3; i++ ) { acc.sseColor[i] += distColor[i]; }
+            }
+            if ( computeReflectance ) { acc.sseReflectance += distReflectance; }
+          }
+        }
+      },
+      tbb::simple_partitioner() );
+
+  double maxC2c         = ( std::numeric_limits<double>::min )();
+  double maxC2p         = ( std::numeric_limits<double>::min )();
+  double sseC2p         = 0;
+  double sseC2c         = 0;
+  double sseReflectance = 0;
+  size_t num            = 0;
+  double sseColor[3]    = {0.0, 0.0, 0.0};
+  for ( auto& acc : accumulators ) {
+    maxC2c = ( std::max )( maxC2c, acc.maxC2c );
+    maxC2p = ( std::max )( maxC2p, acc.maxC2p );
+    sseC2p += acc.sseC2p;
+    sseC2c += acc.sseC2c;
+    sseReflectance += acc.sseReflectance;
+    num += acc.num;
+    for ( size_t i = 0; i < 3; i++ ) { sseColor[i] += acc.sseColor[i]; }
   }
 
   if ( params_.computeC2c_ ) {
@@ -338,7 +386,7 @@ void PCCMetrics::compute( const PCCGroupOfFrames& sources,
     exit( -1 );
   }
   for ( size_t i = 0; i < sources.getFrameCount(); i++ ) {
-    const PCCPointSet3& sourceOrg      = sources[i];
+    const PCCPointSet3& sourceOrg      = sources.acquire( i );
     const PCCPointSet3& reconstructOrg = reconstructs[i];
     sourcePoints_.push_back( sourceOrg.getPointCount() );
     reconstructPoints_.push_back( reconstructOrg.getPointCount() );
@@ -357,6 +405,7 @@ void PCCMetrics::compute( const PCCGroupOfFrames& sources,
       reconstructDuplicates_.push_back( 0 );
       compute( source, reconstruct, normals.getFrameCount() == 0 ? normalEmpty : normals[i] );
     }
+    sources.release( i );
   }
 }
 
@@ -390,3 +439,41 @@ void PCCMetrics::display() {
     qualityF_[i].print( 'F' );
   }
 }
+
+void PCCMetrics::merge( const PCCMetrics& metrics ) {
+  sourcePoints_.insert( sourcePoints_.end(), metrics.sourcePoints_.begin(), metrics.sourcePoints_.end() );
+  sourceDuplicates_.insert( sourceDuplicates_.end(), metrics.sourceDuplicates_.begin(),
+                            metrics.sourceDuplicates_.end() );
+  reconstructPoints_.insert( reconstructPoints_.end(), metrics.reconstructPoints_.begin(),
+                             metrics.reconstructPoints_.end() );
+  reconstructDuplicates_.insert( reconstructDuplicates_.end(), metrics.reconstructDuplicates_.begin(),
+                                 metrics.reconstructDuplicates_.end() );
+  quality1_.insert( quality1_.end(), metrics.quality1_.begin(), metrics.quality1_.end() );
+  quality2_.insert( quality2_.end(), metrics.quality2_.begin(), metrics.quality2_.end() );
+  qualityF_.insert( qualityF_.end(), metrics.qualityF_.begin(), metrics.qualityF_.end() );
+}
+
+void PCCMetrics::writeCsvHeader( std::ostream& stream ) const {
+  stream << "frame,sourcePoints,reconstructPoints";
+  if ( params_.computeC2c_ ) { stream << ",mseF_p2point,psnrF_p2point"; }
+  if ( params_.computeC2p_ ) { stream << ",mseF_p2plane,psnrF_p2plane"; }
+  if ( params_.computeColor_ ) {
+    for ( size_t c = 0; c < 3; c++ ) { stream << ",c" << c << "_mseF,c" << c << "_psnrF"; }
+  }
+  if ( params_.computeReflectance_ ) { stream << ",r_mseF,r_psnrF"; }
+  stream << "\n";
+}
+
+void PCCMetrics::writeCsv( std::ostream& stream, size_t firstFrameIndex ) const {
+  for ( size_t i = 0; i < qualityF_.size(); i++ ) {
+    const auto& q = qualityF_[i];
+    stream << firstFrameIndex + i << "," << sourcePoints_[i] << "," << reconstructPoints_[i];
+    if ( params_.computeC2c_ ) { stream << "," << q.getC2cMse() << "," << q.getC2cPsnr(); }
+    if ( params_.computeC2p_ ) { stream << "," << q.getC2pMse() << "," << q.getC2pPsnr(); }
+    if ( params_.computeColor_ ) {
+      for ( size_t c = 0; c < 3; c++ ) { stream << "," << q.getColorMse( c ) << "," << q.getColorPsnr( c ); }
+    }
+    if ( params_.computeReflectance_ ) { stream << "," << q.getReflectanceMse() << "," << q.getReflectancePsnr(); }
+    stream << "\n";
+  }
+}
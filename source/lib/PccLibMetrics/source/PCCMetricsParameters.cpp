@@ -38,6 +38,7 @@ using namespace pcc;
 PCCMetricsParameters::PCCMetricsParameters() {
   computeMetrics_         = true;
   computeChecksum_        = true;
+  fastChecksum_           = false;
   startFrameNumber_       = 0;
   frameCount_             = 0;
   groupOfFramesSize_      = 32;
@@ -45,6 +46,7 @@ PCCMetricsParameters::PCCMetricsParameters() {
   uncompressedDataPath_   = {};
   reconstructedDataPath_  = {};
   normalDataPath_         = {};
+  csvPath_                = {};
   nbThread_               = 0;
   resolution_             = 1023;
   dropDuplicates_         = 2;
@@ -68,12 +70,14 @@ void PCCMetricsParameters::completePath() {
 void PCCMetricsParameters::print() {
   std::cout << "+ Parameters" << std::endl;
   std::cout << "\t   computeChecksum                      " << computeChecksum_ << std::endl;
+  std::cout << "\t   fastChecksum                         " << fastChecksum_ << std::endl;
   std::cout << "\t   computeMetrics                       " << computeMetrics_ << std::endl;
   std::cout << "\t   startFrameNumber                     " << startFrameNumber_ << std::endl;
   std::cout << "\t   frameCount                           " << frameCount_ << std::endl;
   std::cout << "\t   uncompressedDataPath                 " << uncompressedDataPath_ << std::endl;
   std::cout << "\t   reconstructedDataPath                " << reconstructedDataPath_ << std::endl;
   std::cout << "\t   normalDataPath                       " << normalDataPath_ << std::endl;
+  std::cout << "\t   csvPath                              " << csvPath_ << std::endl;
   std::cout << "\t   nbThread                             " << nbThread_ << std::endl;
   std::cout << "\t   resolution                           " << resolution_ << std::endl;
   std::cout << "\t   dropDuplicates                       " << dropDuplicates_ << std::endl;
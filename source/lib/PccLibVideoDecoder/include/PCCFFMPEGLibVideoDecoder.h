@@ -0,0 +1,88 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PCCFFMPEGLibVideoDecoder_h
+#define PCCFFMPEGLibVideoDecoder_h
+
+#include "PCCCommon.h"
+
+#ifdef USE_FFMPEG_VIDEO_CODEC
+#include "PCCVideo.h"
+#include "PCCVirtualVideoDecoder.h"
+
+struct AVBufferRef;
+struct AVCodecContext;
+
+namespace pcc {
+
+// HEVC decoder of libavcodec on the hardware decoder of the device: VA-API, NVDEC, VideoToolbox, D3D11VA or DXVA2.
+// The streams the hardware does not support, e.g. 4:4:4 attributes on most devices, are decoded by the software
+// decoder of libavcodec. The device and the codec context are kept from one decode() to the next, so a decoder of a
+// PCCVideoDecoderPool opens them once.
+template <class T>
+class PCCFFMPEGLibVideoDecoder : public PCCVirtualVideoDecoder<T> {
+ public:
+  PCCFFMPEGLibVideoDecoder();
+  ~PCCFFMPEGLibVideoDecoder();
+
+  void decode( PCCVideoBitstream& bitstream,
+               PCCVideo<T, 3>&    video,
+               size_t             outputBitDepth = 8,
+               const std::string& decoderPath    = "",
+               const std::string& parameters     = "" );
+
+  void reset();
+
+  // "type[:device]" as av_hwdevice_ctx_create() takes them, e.g. "vaapi:/dev/dri/renderD128"; "auto" opens the
+  // first device type that works, "none" decodes in software
+  void setHardwareDevice( const std::string& hardwareDevice ) { hardwareDevice_ = hardwareDevice; }
+
+  // threads of the software decoder, 0 = all hardware threads
+  void setThreads( size_t threads ) { threads_ = threads; }
+
+ private:
+  PCCFFMPEGLibVideoDecoder( const PCCFFMPEGLibVideoDecoder& ) = delete;
+  PCCFFMPEGLibVideoDecoder& operator=( const PCCFFMPEGLibVideoDecoder& ) = delete;
+
+  std::string     hardwareDevice_ = "auto";
+  size_t          threads_        = 1;
+  std::string     openedDevice_;  // hardwareDevice_ and threads_ that device_ and context_ were opened with
+  size_t          openedThreads_ = 0;
+  AVBufferRef*    device_        = nullptr;
+  AVCodecContext* context_       = nullptr;
+};
+
+};  // namespace pcc
+
+#endif
+
+#endif /* PCCFFMPEGLibVideoDecoder_h */
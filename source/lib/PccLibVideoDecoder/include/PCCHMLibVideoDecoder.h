@@ -52,6 +52,24 @@ class PCCHMLibVideoDecoder : public PCCVirtualVideoDecoder<T> {
                size_t             outputBitDepth = 8,
                const std::string& decoderPath    = "",
                const std::string& parameters     = "" );
+
+  // tiles or wavefront rows decoded at the same time, 0 = all hardware threads. More than one thread also decodes
+  // the pictures of an all-intra bitstream at the same time, see decodeAllIntra().
+  void setSubstreamThreads( size_t substreamThreads ) { substreamThreads_ = substreamThreads; }
+
+  bool setOutputConversion( const PCCImageConversion& conversion ) {
+    conversion_ = conversion;
+    return true;
+  }
+
+ private:
+  // Splits a bitstream of IDR pictures only at its access units and decodes them on one decoder each in the current
+  // task arena, the parameter sets seen so far put in front of each. False, leaving video as it was, if a picture
+  // depends on another or the split did not give one picture per access unit.
+  bool decodeAllIntra( PCCVideoBitstream& bitstream, PCCVideo<T, 3>& video, size_t outputBitDepth );
+
+  size_t             substreamThreads_ = 1;
+  PCCImageConversion conversion_;
 };
 
 };  // namespace pcc
@@ -51,7 +51,9 @@ namespace pcc {
 template <class T>
 class PCCHMLibVideoDecoderImpl {
  public:
-  PCCHMLibVideoDecoderImpl();
+  // up to substreamThreads tiles or wavefront rows of a picture are decoded at the same time
+  // conversion is applied by xWritePicture() to each picture it writes
+  PCCHMLibVideoDecoderImpl( size_t substreamThreads = 1, const PCCImageConversion& conversion = PCCImageConversion() );
 
   ~PCCHMLibVideoDecoderImpl();
   void decode( PCCVideoBitstream& bitstream, size_t outputBitDepth, PCCVideo<T, 3>& video );
@@ -69,6 +71,8 @@ class PCCHMLibVideoDecoderImpl {
   int                m_outputWidth;
   int                m_outputHeight;
   bool               m_bRGB2GBR;
+  size_t             m_substreamThreads;
+  PCCImageConversion m_conversion;
 };
 
 };  // namespace pcc
@@ -53,6 +53,14 @@ class PCCVirtualVideoDecoder {
                        const std::string& decoderPath    = "",
                        const std::string& parameters     = "" ) = 0;
 
+  // Drops what the decoder keeps from one decode() to the next, e.g. for a bitstream of new parameter sets; see
+  // PCCVideoDecoderPool. The next decode() sets it up again.
+  virtual void reset() {}
+
+  // Conversion applied to the pictures as the next decode() writes them, in place of separate passes over the decoded
+  // video. False if the decoder writes its pictures as decoded, and the caller has to convert them itself.
+  virtual bool setOutputConversion( const PCCImageConversion& conversion ) { return false; }
+
  public:
 };
 
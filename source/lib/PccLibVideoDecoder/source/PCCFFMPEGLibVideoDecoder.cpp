@@ -0,0 +1,245 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+
+#ifdef USE_FFMPEG_VIDEO_CODEC
+
+#include "PCCFFMPEGLibVideoDecoder.h"
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
+}
+
+using namespace pcc;
+
+// pixel format of the opened device, the decoder context keeps it in opaque
+static AVPixelFormat getFormat( AVCodecContext* context, const AVPixelFormat* formats ) {
+  const auto hardwareFormat = static_cast<AVPixelFormat>( reinterpret_cast<intptr_t>( context->opaque ) );
+  for ( auto format = formats; *format != AV_PIX_FMT_NONE; format++ ) {
+    if ( *format == hardwareFormat ) { return *format; }
+  }
+  // the device does not decode this profile: the first format left is the one of the software decoder
+  for ( auto format = formats; *format != AV_PIX_FMT_NONE; format++ ) {
+    if ( !( av_pix_fmt_desc_get( *format )->flags & AV_PIX_FMT_FLAG_HWACCEL ) ) {
+      printf( "PCCFFMPEGLibVideoDecoder: the hardware device does not decode this stream, decoding in software \n" );
+      return *format;
+    }
+  }
+  return AV_PIX_FMT_NONE;
+}
+
+static AVBufferRef* openDevice( const AVCodec* codec, const std::string& hardwareDevice,
+                                AVPixelFormat& hardwareFormat ) {
+  hardwareFormat = AV_PIX_FMT_NONE;
+  if ( hardwareDevice.empty() || hardwareDevice == "none" ) { return nullptr; }
+  const size_t      colon    = hardwareDevice.find( ':' );
+  const std::string typeName = hardwareDevice.substr( 0, colon );
+  const std::string device   = colon == std::string::npos ? "" : hardwareDevice.substr( colon + 1 );
+  AVHWDeviceType    type     = AV_HWDEVICE_TYPE_NONE;
+  if ( typeName != "auto" && ( type = av_hwdevice_find_type_by_name( typeName.c_str() ) ) == AV_HWDEVICE_TYPE_NONE ) {
+    printf( "PCCFFMPEGLibVideoDecoder: unknown hardware device type %s, decoding in software \n", typeName.c_str() );
+    return nullptr;
+  }
+  const AVCodecHWConfig* config = nullptr;
+  for ( int i = 0; ( config = avcodec_get_hw_config( codec, i ) ) != nullptr; i++ ) {
+    if ( !( config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX ) ||
+         ( type != AV_HWDEVICE_TYPE_NONE && config->device_type != type ) ) {
+      continue;
+    }
+    AVBufferRef* deviceContext = nullptr;
+    if ( av_hwdevice_ctx_create( &deviceContext, config->device_type, device.empty() ? nullptr : device.c_str(),
+                                 nullptr, 0 ) == 0 ) {
+      printf( "PCCFFMPEGLibVideoDecoder: hardware device %s \n", av_hwdevice_get_type_name( config->device_type ) );
+      hardwareFormat = config->pix_fmt;
+      return deviceContext;
+    }
+  }
+  printf( "PCCFFMPEGLibVideoDecoder: no hardware device %s opened, decoding in software \n", hardwareDevice.c_str() );
+  return nullptr;
+}
+
+// Copies a host frame of any planar or semi-planar format to the next frame of video. 4:4:4 is coded in G, B, R
+// order, which frames in the RGB formats of libavcodec already list as R, G, B; the YUV ones are reordered as
+// PCCHMLibVideoDecoderImpl does.
+template <typename T>
+static void writePicture( const AVFrame* frame, size_t outputBitDepth, PCCVideo<T, 3>& video ) {
+  const auto* desc      = av_pix_fmt_desc_get( static_cast<AVPixelFormat>( frame->format ) );
+  const bool  is420     = desc->log2_chroma_w > 0;
+  const bool  reorder   = !is420 && !( desc->flags & AV_PIX_FMT_FLAG_RGB );
+  const int   order[3]  = {reorder ? 2 : 0, reorder ? 0 : 1, reorder ? 1 : 2};
+  const int   depth     = desc->comp[0].depth;
+  const int   shiftbits = depth - static_cast<int>( outputBitDepth );
+  const int   rounding  = shiftbits > 0 ? 1 << ( shiftbits - 1 ) : 0;
+  const int   maxval    = ( 1 << outputBitDepth ) - 1;
+  video.resize( video.getFrameCount() + 1 );
+  auto& image = video.getFrames().back();
+  image.resize( frame->width, frame->height, is420 ? PCCCOLORFORMAT::YUV420 : PCCCOLORFORMAT::RGB444 );
+  for ( size_t c = 0; c < 3; c++ ) {
+    const auto& comp  = desc->comp[order[c]];
+    auto        plane = image.getPlane( c );
+    for ( size_t v = 0; v < plane.getHeight(); v++ ) {
+      const uint8_t* src = frame->data[comp.plane] + v * frame->linesize[comp.plane] + comp.offset;
+      T*             dst = plane.getRow( v );
+      for ( size_t u = 0; u < plane.getWidth(); u++, src += comp.step ) {
+        int value = ( depth > 8 ? *reinterpret_cast<const uint16_t*>( src ) : *src ) >> comp.shift;
+        dst[u]    = static_cast<T>( shiftbits > 0 ? ( std::min )( ( value + rounding ) >> shiftbits, maxval ) : value );
+      }
+    }
+  }
+}
+
+template <typename T>
+PCCFFMPEGLibVideoDecoder<T>::PCCFFMPEGLibVideoDecoder() {}
+template <typename T>
+PCCFFMPEGLibVideoDecoder<T>::~PCCFFMPEGLibVideoDecoder() {
+  reset();
+}
+
+template <typename T>
+void PCCFFMPEGLibVideoDecoder<T>::reset() {
+  avcodec_free_context( &context_ );
+  av_buffer_unref( &device_ );
+}
+
+template <typename T>
+void PCCFFMPEGLibVideoDecoder<T>::decode( PCCVideoBitstream& bitstream,
+                                          PCCVideo<T, 3>&    video,
+                                          size_t             outputBitDepth,
+                                          const std::string& decoderPath,
+                                          const std::string& fileName ) {
+  const AVCodec* codec = avcodec_find_decoder( AV_CODEC_ID_HEVC );
+  if ( codec == nullptr ) {
+    printf( "Error: libavcodec has no HEVC decoder \n" );
+    exit( -1 );
+  }
+  if ( context_ != nullptr && ( openedDevice_ != hardwareDevice_ || openedThreads_ != threads_ ) ) { reset(); }
+  if ( context_ == nullptr ) {
+    AVPixelFormat hardwareFormat = AV_PIX_FMT_NONE;
+    device_                      = openDevice( codec, hardwareDevice_, hardwareFormat );
+    context_                     = avcodec_alloc_context3( codec );
+    context_->thread_count       = static_cast<int>( threads_ );
+    if ( device_ != nullptr ) {
+      context_->hw_device_ctx = av_buffer_ref( device_ );
+      context_->opaque        = reinterpret_cast<void*>( static_cast<intptr_t>( hardwareFormat ) );
+      context_->get_format    = getFormat;
+    }
+    if ( avcodec_open2( context_, codec, nullptr ) < 0 ) {
+      printf( "Error: can't open the libavcodec HEVC decoder \n" );
+      exit( -1 );
+    }
+    openedDevice_  = hardwareDevice_;
+    openedThreads_ = threads_;
+  }
+  AVCodecContext*       context = context_;
+  AVCodecParserContext* parser  = av_parser_init( AV_CODEC_ID_HEVC );
+  AVPacket*             packet  = av_packet_alloc();
+  AVFrame*              frame   = av_frame_alloc();
+  AVFrame*              host    = av_frame_alloc();
+  video.reset();
+
+  // the frames of the device are mapped to host memory where the driver shares it (VA-API, VideoToolbox, D3D11VA)
+  // and copied out otherwise (NVDEC): either way the planes are read once, into the frames of video
+  auto receiveFrames = [&]() {
+    int ret;
+    while ( ( ret = avcodec_receive_frame( context, frame ) ) == 0 ) {
+      if ( frame->hw_frames_ctx != nullptr ) {
+        const auto swFormat = reinterpret_cast<AVHWFramesContext*>( frame->hw_frames_ctx->data )->sw_format;
+        host->format        = swFormat;
+        if ( av_hwframe_map( host, frame, AV_HWFRAME_MAP_READ ) < 0 ) {
+          av_frame_unref( host );
+          host->format = swFormat;
+          if ( av_hwframe_transfer_data( host, frame, 0 ) < 0 ) {
+            printf( "Error: can't read the decoded frame back from the hardware device \n" );
+            exit( -1 );
+          }
+          host->width  = frame->width;
+          host->height = frame->height;
+        }
+        writePicture( host, outputBitDepth, video );
+        av_frame_unref( host );
+      } else {
+        writePicture( frame, outputBitDepth, video );
+      }
+      av_frame_unref( frame );
+    }
+    if ( ret != AVERROR( EAGAIN ) && ret != AVERROR_EOF ) {
+      printf( "Error: libavcodec HEVC decoding failed \n" );
+      exit( -1 );
+    }
+  };
+  auto sendPacket = [&]( const AVPacket* pkt ) {
+    if ( avcodec_send_packet( context, pkt ) < 0 ) {
+      printf( "Error: libavcodec HEVC decoding failed \n" );
+      exit( -1 );
+    }
+    receiveFrames();
+  };
+
+  // the byte stream is split in access units by the HEVC parser, which buffers across calls: a byte stream view is
+  // fed in place segment by segment, and a last call on no data flushes the last access unit
+  auto parse = [&]( const uint8_t* data, int size ) {
+    int used = av_parser_parse2( parser, context, &packet->data, &packet->size, data, size, AV_NOPTS_VALUE,
+                                 AV_NOPTS_VALUE, 0 );
+    if ( packet->size > 0 ) { sendPacket( packet ); }
+    return used;
+  };
+  std::vector<PCCVideoByteStreamSegment> segments;
+  bitstream.getByteStreamSegments( segments );
+  for ( auto& segment : segments ) {
+    const uint8_t* data = segment.data_;
+    int            size = static_cast<int>( segment.size_ );
+    while ( size > 0 ) {
+      int used = parse( data, size );
+      data += used;
+      size -= used;
+    }
+  }
+  parse( nullptr, 0 );
+  sendPacket( nullptr );
+  printf( "PCCFFMPEGLibVideoDecoder: %zu frames %zu x %zu decoded \n", video.getFrameCount(), video.getWidth(),
+          video.getHeight() );
+  fflush( stdout );
+
+  av_frame_free( &host );
+  av_frame_free( &frame );
+  av_packet_free( &packet );
+  av_parser_close( parser );
+  // drained: takes the next bitstream from its first access unit
+  avcodec_flush_buffers( context );
+}
+
+template class pcc::PCCFFMPEGLibVideoDecoder<uint8_t>;
+template class pcc::PCCFFMPEGLibVideoDecoder<uint16_t>;
+
+#endif
@@ -36,9 +36,58 @@
 
 #include "PCCHMLibVideoDecoder.h"
 #include "PCCHMLibVideoDecoderImpl.h"
+#include <tbb/tbb.h>
+#include <thread>
 
 using namespace pcc;
 
+namespace {
+
+// A NAL unit of a byte stream, without its start code.
+struct PCCNalUnit {
+  const uint8_t* data_;
+  size_t         size_;
+};
+
+void getNalUnits( PCCVideoBitstream& bitstream, std::vector<PCCNalUnit>& nalus ) {
+  std::vector<PCCVideoByteStreamSegment> segments;
+  bitstream.getByteStreamSegments( segments );
+  nalus.clear();
+  if ( bitstream.isByteStreamView() ) {
+    // start codes and NAL units alternate
+    for ( size_t i = 1; i < segments.size(); i += 2 ) { nalus.push_back( {segments[i].data_, segments[i].size_} ); }
+    return;
+  }
+  for ( auto& segment : segments ) {
+    const uint8_t* data  = segment.data_;
+    size_t         begin = 0;
+    auto           push  = [&]( size_t end ) {
+      // a NAL unit never ends with a zero byte: these lead the next start code
+      while ( end > begin && data[end - 1] == 0 ) { end--; }
+      if ( end > begin ) { nalus.push_back( {data + begin, end - begin} ); }
+    };
+    for ( size_t i = 0; i + 2 < segment.size_; i++ ) {
+      if ( data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1 ) {
+        if ( begin != 0 ) { push( i ); }
+        begin = i + 3;
+        i += 2;
+      }
+    }
+    if ( begin != 0 ) { push( segment.size_ ); }
+  }
+}
+
+// The NAL units that begin the next access unit when they follow a picture (7.4.2.4.4): parameter sets, access unit
+// delimiter, prefix SEI and the reserved and unspecified types among them.
+bool startsAccessUnit( int naluType ) {
+  return ( naluType >= pcc_hm::NAL_UNIT_VPS && naluType <= pcc_hm::NAL_UNIT_ACCESS_UNIT_DELIMITER ) ||
+         naluType == pcc_hm::NAL_UNIT_PREFIX_SEI ||
+         ( naluType >= pcc_hm::NAL_UNIT_RESERVED_NVCL41 && naluType <= pcc_hm::NAL_UNIT_RESERVED_NVCL44 ) ||
+         ( naluType >= pcc_hm::NAL_UNIT_UNSPECIFIED_48 && naluType <= pcc_hm::NAL_UNIT_UNSPECIFIED_55 );
+}
+
+}  // namespace
+
 template <typename T>
 PCCHMLibVideoDecoder<T>::PCCHMLibVideoDecoder() {}
 template <typename T>
@@ -50,10 +99,69 @@ void PCCHMLibVideoDecoder<T>::decode( PCCVideoBitstream& bitstream,
                                       size_t             outputBitDepth,
                                       const std::string& decoderPath,
                                       const std::string& fileName ) {
-  PCCHMLibVideoDecoderImpl<T> decoder;
+  size_t threads = substreamThreads_ != 0 ? substreamThreads_ : std::thread::hardware_concurrency();
+  if ( threads > 1 && decodeAllIntra( bitstream, video, outputBitDepth ) ) { return; }
+  PCCHMLibVideoDecoderImpl<T> decoder( ( std::max )( threads, size_t( 1 ) ), conversion_ );
   decoder.decode( bitstream, outputBitDepth, video );
 }
 
+template <typename T>
+bool PCCHMLibVideoDecoder<T>::decodeAllIntra( PCCVideoBitstream& bitstream,
+                                              PCCVideo<T, 3>&    video,
+                                              size_t             outputBitDepth ) {
+  std::vector<PCCNalUnit> nalus;
+  getNalUnits( bitstream, nalus );
+
+  // the access units, each led by the parameter sets in force when it starts
+  std::vector<std::vector<PCCNalUnit>> accessUnits;
+  std::vector<PCCNalUnit>              parameterSets;
+  bool                                 picture = false;
+  for ( auto& nalu : nalus ) {
+    if ( nalu.size_ < 2 ) { return false; }
+    const int naluType = ( nalu.data_[0] >> 1 ) & 0x3f;
+    bool      newUnit  = accessUnits.empty();
+    if ( naluType < pcc_hm::NAL_UNIT_VPS ) {
+      if ( naluType != pcc_hm::NAL_UNIT_CODED_SLICE_IDR_W_RADL && naluType != pcc_hm::NAL_UNIT_CODED_SLICE_IDR_N_LP ) {
+        return false;
+      }
+      if ( nalu.size_ < 3 ) { return false; }
+      const bool firstSliceSegmentInPic = ( nalu.data_[2] & 0x80 ) != 0;
+      newUnit                           = newUnit || ( firstSliceSegmentInPic && picture );
+      picture                           = true;
+    } else if ( startsAccessUnit( naluType ) && picture ) {
+      newUnit = true;
+      picture = false;
+    }
+    if ( naluType == pcc_hm::NAL_UNIT_VPS ) { parameterSets.clear(); }
+    if ( newUnit ) {
+      accessUnits.push_back( naluType == pcc_hm::NAL_UNIT_VPS ? std::vector<PCCNalUnit>() : parameterSets );
+    }
+    accessUnits.back().push_back( nalu );
+    if ( naluType >= pcc_hm::NAL_UNIT_VPS && naluType <= pcc_hm::NAL_UNIT_PPS ) { parameterSets.push_back( nalu ); }
+  }
+  if ( accessUnits.size() < 2 ) { return false; }
+
+  // IDR pictures all have POC 0: decoding order is output order
+  static const uint8_t        startCode[4] = {0x00, 0x00, 0x00, 0x01};
+  std::vector<PCCVideo<T, 3>> pictures( accessUnits.size() );
+  tbb::parallel_for( size_t( 0 ), accessUnits.size(), [&]( size_t index ) {
+    PCCVideoBitstream     accessUnit( bitstream.type() );
+    std::vector<uint8_t>& data = accessUnit.vector();
+    for ( auto& nalu : accessUnits[index] ) {
+      data.insert( data.end(), startCode, startCode + 4 );
+      data.insert( data.end(), nalu.data_, nalu.data_ + nalu.size_ );
+    }
+    PCCHMLibVideoDecoderImpl<T> decoder( 1, conversion_ );
+    decoder.decode( accessUnit, outputBitDepth, pictures[index] );
+  } );
+  for ( auto& frames : pictures ) {
+    if ( frames.getFrameCount() != 1 ) { return false; }
+  }
+  video.resize( pictures.size() );
+  for ( size_t i = 0; i < pictures.size(); i++ ) { std::swap( video.getFrame( i ), pictures[i].getFrame( 0 ) ); }
+  return true;
+}
+
 template class pcc::PCCHMLibVideoDecoder<uint8_t>;
 template class pcc::PCCHMLibVideoDecoder<uint16_t>;
 
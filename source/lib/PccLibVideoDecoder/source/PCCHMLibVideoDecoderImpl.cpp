@@ -47,7 +47,9 @@ using namespace pcc;
 using namespace pcc_hm;
 
 template <typename T>
-PCCHMLibVideoDecoderImpl<T>::PCCHMLibVideoDecoderImpl() : m_iPOCLastDisplay( -MAX_INT ) {
+PCCHMLibVideoDecoderImpl<T>::PCCHMLibVideoDecoderImpl( size_t                    substreamThreads,
+                                                      const PCCImageConversion& conversion ) :
+    m_iPOCLastDisplay( -MAX_INT ), m_substreamThreads( substreamThreads ), m_conversion( conversion ) {
   m_pTDecTop = new pcc_hm::TDecTop();
 }
 
@@ -58,9 +60,8 @@ PCCHMLibVideoDecoderImpl<T>::~PCCHMLibVideoDecoderImpl() {
 
 template <typename T>
 void PCCHMLibVideoDecoderImpl<T>::decode( PCCVideoBitstream& bitstream, size_t outputBitDepth, PCCVideo<T, 3>& video ) {
-  std::string                         s( reinterpret_cast<char*>( bitstream.buffer() ), bitstream.size() );
-  std::istringstream                  iss( s );
-  std::istream&                       bitstreamFile = iss;
+  PCCVideoByteStreamBuf               byteStreamBuf( bitstream );
+  std::istream                        bitstreamFile( &byteStreamBuf );
   Int                                 poc;
   pcc_hm::TComList<pcc_hm::TComPic*>* pcListPic = NULL;
   pcc_hm::InputByteStream             bytestream( bitstreamFile );
@@ -68,11 +69,12 @@ void PCCHMLibVideoDecoderImpl<T>::decode( PCCVideoBitstream& bitstream, size_t o
     m_outputBitDepth[CHANNEL_TYPE_LUMA]   = outputBitDepth;
     m_outputBitDepth[CHANNEL_TYPE_CHROMA] = outputBitDepth;
   }
-  video.clear();
+  video.reset();
   // create & initialize internal classes
   m_pTDecTop->create();
   m_pTDecTop->init();
   m_pTDecTop->setDecodedPictureHashSEIEnabled( 1 );
+  m_pTDecTop->setNumSubstreamThreads( static_cast<Int>( m_substreamThreads ) );
   m_iPOCLastDisplay += m_iSkipFrame;  // set the last displayed POC correctly for skip forward.
   // main decoder loop
   Bool openedReconFile = false;  // reconstruction file not yet opened. (must be
@@ -360,7 +362,7 @@ void PCCHMLibVideoDecoderImpl<T>::xWritePicture( const pcc_hm::TComPicYuv* pic,
   image.set( pic->getAddr( COMPONENT_Y ), pic->getAddr( COMPONENT_Cb ), pic->getAddr( COMPONENT_Cr ), m_outputWidth,
              m_outputHeight, pic->getStride( COMPONENT_Y ), m_outputWidth / chromaSubsample,
              m_outputHeight / chromaSubsample, pic->getStride( COMPONENT_Cb ),
-             m_internalBitDepths - m_outputBitDepth[0], format, m_bRGB2GBR );
+             m_internalBitDepths - m_outputBitDepth[0], format, m_bRGB2GBR, m_conversion );
 }
 
 template class pcc::PCCHMLibVideoDecoderImpl<uint8_t>;
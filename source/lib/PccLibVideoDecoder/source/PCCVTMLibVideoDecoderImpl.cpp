@@ -50,18 +50,17 @@ template <typename T>
 uint32_t PCCVTMLibVideoDecoderImpl<T>::decode( PCCVideoBitstream& bitstream,
                                                size_t             outputBitDepth,
                                                PCCVideo<T, 3>&    video ) {
-  std::string        s( reinterpret_cast<char*>( bitstream.buffer() ), bitstream.size() );
-  std::istringstream iss( s );
-  std::istream&      bitstreamFile = iss;
-  int                poc;
-  PicList*           pcListPic = NULL;
+  PCCVideoByteStreamBuf byteStreamBuf( bitstream );
+  std::istream          bitstreamFile( &byteStreamBuf );
+  int                   poc;
+  PicList*              pcListPic = NULL;
 
   InputByteStream bytestream( bitstreamFile );
   if ( outputBitDepth ) {
     m_outputBitDepth[CHANNEL_TYPE_LUMA]   = outputBitDepth;
     m_outputBitDepth[CHANNEL_TYPE_CHROMA] = outputBitDepth;
   }
-  video.clear();
+  video.reset();
 
   // create & initialize internal classes
   m_targetSubPicIdx = 0;
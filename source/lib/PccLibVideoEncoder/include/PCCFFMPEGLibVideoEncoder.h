@@ -0,0 +1,67 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ITU/ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ITU/ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCCFFMPEGLibVideoEncoder_h
+#define PCCFFMPEGLibVideoEncoder_h
+
+#include "PCCCommon.h"
+
+#ifdef USE_FFMPEG_VIDEO_CODEC
+#include "PCCVideo.h"
+#include "PCCVirtualVideoEncoder.h"
+
+namespace pcc {
+
+// HEVC encoder of libavcodec on the hardware encoder of the device, for live capture: NVENC or Quick Sync Video, as
+// PCCVideoEncoderParameters::hardwareDevice_ selects it, or libx265 in software. The encoder configuration of the HM
+// encoders is read for what the hardware encoders can follow: the intra period, and lossless coding when
+// transquant bypass or a lossless cost mode is set. There are no B frames. The frames are coded at the QP of params
+// with constant QP rate control, 8-bit or 10-bit, 4:2:0 or 4:4:4 as the source. The reconstructed video is the
+// bitstream decoded by PCCFFMPEGLibVideoDecoder.
+template <class T>
+class PCCFFMPEGLibVideoEncoder : public PCCVirtualVideoEncoder<T> {
+ public:
+  PCCFFMPEGLibVideoEncoder();
+  ~PCCFFMPEGLibVideoEncoder();
+
+  void encode( PCCVideo<T, 3>&            videoSrc,
+               PCCVideoEncoderParameters& params,
+               PCCVideoBitstream&         bitstream,
+               PCCVideo<T, 3>&            videoRec );
+};
+
+}  // namespace pcc
+
+#endif
+
+#endif /* PCCFFMPEGLibVideoEncoder_h */
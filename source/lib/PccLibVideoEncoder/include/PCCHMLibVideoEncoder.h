@@ -52,6 +52,13 @@ class PCCHMLibVideoEncoder : public PCCVirtualVideoEncoder<T> {
                PCCVideoEncoderParameters& params,
                PCCVideoBitstream&         bitstream,
                PCCVideo<T, 3>&            videoRec );
+
+ private:
+  // the command line of the HM encoder for frameCount frames of the video
+  static std::string getArguments( size_t                           width,
+                                   size_t                           height,
+                                   size_t                           frameCount,
+                                   const PCCVideoEncoderParameters& params );
 };
 
 }  // namespace pcc
@@ -39,6 +39,7 @@
 #ifdef USE_HMLIB_VIDEO_CODEC
 #include "PCCVideo.h"
 #include "PCCVideoBitstream.h"
+#include "PCCVirtualVideoEncoder.h"
 
 #include <list>
 #include <ostream>
@@ -74,11 +75,11 @@ class PCCHMLibVideoEncoderImpl : public PCCHMLibVideoEncoderCfg {
 
   ~PCCHMLibVideoEncoderImpl();
 
-  Void encode( PCCVideo<T, 3>&    videoSrc,
-               std::string        arguments,
-               PCCVideoBitstream& bitstream,
-
-               PCCVideo<T, 3>& videoRec );
+  Void encode( PCCVideo<T, 3>&                    videoSrc,
+               std::string                        arguments,
+               PCCVideoBitstream&                 bitstream,
+               PCCVideo<T, 3>&                    videoRec,
+               const PCCMotionEstimationSideInfo* sideInfo = nullptr );
   // #if PCC_CF_EXT
   // void setLogger( PCCLogger& logger ) { logger_ = &logger; }
   // #endif
@@ -101,6 +102,9 @@ class PCCHMLibVideoEncoderImpl : public PCCHMLibVideoEncoderCfg {
   Void printChromaFormat();
   void xWritePicture( const TComPicYuv* pic, PCCVideo<T, 3>& video );
   void xReadPicture( TComPicYuv* pic, PCCVideo<T, 3>& video, int frameIndex );
+#if ( defined( PCC_ME_EXT ) && PCC_ME_EXT ) || ( defined( PCC_RDO_EXT ) && PCC_RDO_EXT )
+  void xSetSideInfo( const PCCMotionEstimationSideInfo& sideInfo );
+#endif
 
   TEncTop               m_cTEncTop;
   TComList<TComPicYuv*> m_cListPicYuvRec;
@@ -109,6 +113,9 @@ class PCCHMLibVideoEncoderImpl : public PCCHMLibVideoEncoderCfg {
   UInt                  m_totalBytes;
   int                   m_outputWidth;
   int                   m_outputHeight;
+#if ( defined( PCC_ME_EXT ) && PCC_ME_EXT ) || ( defined( PCC_RDO_EXT ) && PCC_RDO_EXT )
+  PCCSideInfo           m_sideInfo;
+#endif
 };
 
 }  // namespace pcc
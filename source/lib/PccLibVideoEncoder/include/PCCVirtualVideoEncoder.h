@@ -39,28 +39,65 @@
 
 namespace pcc {
 
+// side information of the PCC motion estimation and RDO of the HM encoders, for each atlas frame: the patch of each
+// occupancy block, the occupancy map and the patches
+struct PCCMotionEstimationPatch {
+  size_t projectionIndex_ = 0;
+  size_t u0_              = 0;
+  size_t v0_              = 0;
+  size_t sizeU0_          = 0;
+  size_t sizeV0_          = 0;
+  size_t d1_              = 0;
+  size_t u1_              = 0;
+  size_t v1_              = 0;
+};
+
+struct PCCMotionEstimationFrame {
+  std::vector<size_t>                   blockToPatch_;  // patch index + 1 of each occupancy block, 0 if none
+  std::vector<uint8_t>                  occupancy_;     // of each occupancy precision block
+  std::vector<PCCMotionEstimationPatch> patches_;
+};
+
+struct PCCMotionEstimationSideInfo {
+  size_t                                width_               = 0;
+  size_t                                height_              = 0;
+  size_t                                occupancyResolution_ = 16;
+  size_t                                occupancyPrecision_  = 4;
+  std::vector<PCCMotionEstimationFrame> frames_;
+};
+
 struct PCCVideoEncoderParameters {
-  std::string encoderPath_                 = {};
-  std::string srcYuvFileName_              = {};
-  std::string binFileName_                 = {};
-  std::string recYuvFileName_              = {};
-  std::string encoderConfig_               = {};
-  int32_t     qp_                          = 30;
-  int32_t     inputBitDepth_               = 8;
-  int32_t     internalBitDepth_            = 8;
-  int32_t     outputBitDepth_              = 8;
-  bool        use444CodecIo_               = false;
-  bool        usePccMotionEstimation_      = false;
-  std::string blockToPatchFile_            = {};
-  std::string occupancyMapFile_            = {};
-  std::string patchInfoFile_               = {};
-  bool        transquantBypassEnable_      = false;
-  bool        cuTransquantBypassFlagForce_ = false;
-  bool        inputColourSpaceConvert_     = false;
-  bool        usePccRDO_                   = false;
-  int32_t     shvcLayerIndex_              = 8;
-  int32_t     shvcRateX_                   = 0;
-  int32_t     shvcRateY_                   = 0;
+  std::string                        encoderPath_                 = {};
+  std::string                        srcYuvFileName_              = {};
+  std::string                        binFileName_                 = {};
+  std::string                        recYuvFileName_              = {};
+  std::string                        encoderConfig_               = {};
+  int32_t                            qp_                          = 30;
+  int32_t                            inputBitDepth_               = 8;
+  int32_t                            internalBitDepth_            = 8;
+  int32_t                            outputBitDepth_              = 8;
+  bool                               use444CodecIo_               = false;
+  bool                               usePccMotionEstimation_      = false;
+  std::string                        blockToPatchFile_            = {};
+  std::string                        occupancyMapFile_            = {};
+  std::string                        patchInfoFile_               = {};
+  // the content of the three files above, in memory, for the library encoders
+  const PCCMotionEstimationSideInfo* sideInfo_                    = nullptr;
+  bool                               transquantBypassEnable_      = false;
+  bool                               cuTransquantBypassFlagForce_ = false;
+  bool                               inputColourSpaceConvert_     = false;
+  bool                               usePccRDO_                   = false;
+  int32_t                            shvcLayerIndex_              = 8;
+  int32_t                            shvcRateX_                   = 0;
+  int32_t                            shvcRateY_                   = 0;
+  bool                               wavefront_                   = false;
+  size_t                             tileColumns_                 = 1;
+  size_t                             tileRows_                    = 1;
+  // encoder of the FFMPEG codec: nvenc, qsv, none for libx265, auto for the first that opens
+  std::string                        hardwareDevice_              = "auto";
+  // frames of the closed chunks the HM encoders code the video in, in parallel, each as a sequence of its own that
+  // starts with an IDR picture; 0 for one chunk. Only exact with all-intra content or a multiple of its closed GOP.
+  size_t                             chunkFrames_                 = 0;
 };
 
 template <class T>
@@ -0,0 +1,247 @@
+/* The copyright in this software is being made available under the BSD
+ * License, included below. This software may be subject to other third party
+ * and contributor rights, including patent rights, and no such rights are
+ * granted under this license.
+ *
+ * Copyright (c) 2010-2017, ITU/ISO/IEC
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *  * Neither the name of the ITU/ISO/IEC nor the names of its contributors may
+ *    be used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "PCCCommon.h"
+
+#ifdef USE_FFMPEG_VIDEO_CODEC
+
+#include "PCCFFMPEGLibVideoEncoder.h"
+#include "PCCFFMPEGLibVideoDecoder.h"
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+}
+
+using namespace pcc;
+
+// what the hardware encoders follow of an HM encoder configuration file
+struct PCCFFMPEGEncoderConfig {
+  int  intraPeriod_ = -1;
+  bool lossless_    = false;
+};
+
+static PCCFFMPEGEncoderConfig readEncoderConfig( const std::string& fileName ) {
+  PCCFFMPEGEncoderConfig config;
+  std::ifstream          file( fileName );
+  std::string            line;
+  while ( std::getline( file, line ) ) {
+    line               = line.substr( 0, line.find( '#' ) );
+    const size_t colon = line.find( ':' );
+    if ( colon == std::string::npos ) { continue; }
+    std::string key;
+    std::string value;
+    std::istringstream( line.substr( 0, colon ) ) >> key;
+    std::istringstream( line.substr( colon + 1 ) ) >> value;
+    if ( key == "IntraPeriod" ) {
+      config.intraPeriod_ = std::atoi( value.c_str() );
+    } else if ( key == "CUTransquantBypassFlagForce" ) {
+      config.lossless_ |= std::atoi( value.c_str() ) != 0;
+    } else if ( key == "CostMode" ) {
+      config.lossless_ |= value.find( "lossless" ) != std::string::npos;
+    }
+  }
+  return config;
+}
+
+// libavcodec encoders of the hardware device, in the order they are tried
+static std::vector<std::string> getEncoderNames( const std::string& hardwareDevice ) {
+  if ( hardwareDevice == "nvenc" ) { return {"hevc_nvenc"}; }
+  if ( hardwareDevice == "qsv" ) { return {"hevc_qsv"}; }
+  if ( hardwareDevice == "none" ) { return {"libx265"}; }
+  return {"hevc_nvenc", "hevc_qsv", "libx265"};
+}
+
+// first pixel format of the encoder for the chroma format and bit depth, planar or semi-planar
+static AVPixelFormat getPixelFormat( const AVCodec* codec, const bool is444, const bool highBitDepth ) {
+  const std::vector<AVPixelFormat> candidates =
+      is444 ? ( highBitDepth ? std::vector<AVPixelFormat>{AV_PIX_FMT_YUV444P16LE, AV_PIX_FMT_YUV444P10LE}
+                             : std::vector<AVPixelFormat>{AV_PIX_FMT_YUV444P} )
+            : ( highBitDepth ? std::vector<AVPixelFormat>{AV_PIX_FMT_P010LE, AV_PIX_FMT_YUV420P10LE}
+                             : std::vector<AVPixelFormat>{AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12} );
+  for ( const auto candidate : candidates ) {
+    for ( auto format = codec->pix_fmts; format != nullptr && *format != AV_PIX_FMT_NONE; format++ ) {
+      if ( *format == candidate ) { return candidate; }
+    }
+  }
+  return AV_PIX_FMT_NONE;
+}
+
+// Copies an image to a host frame, the inverse of the writePicture() of PCCFFMPEGLibVideoDecoder: 4:4:4 images in
+// R, G, B order are coded in G, B, R order when reorder is set.
+template <typename T>
+static void readPicture( PCCImage<T, 3>& image, const size_t inputBitDepth, const bool reorder, AVFrame* frame ) {
+  const auto* desc      = av_pix_fmt_desc_get( static_cast<AVPixelFormat>( frame->format ) );
+  const int   order[3]  = {reorder ? 2 : 0, reorder ? 0 : 1, reorder ? 1 : 2};
+  const int   depth     = desc->comp[0].depth;
+  const int   shiftbits = depth - static_cast<int>( inputBitDepth );
+  for ( size_t c = 0; c < 3; c++ ) {
+    const auto& comp  = desc->comp[order[c]];
+    auto        plane = image.getPlane( c );
+    for ( size_t v = 0; v < plane.getHeight(); v++ ) {
+      uint8_t* dst = frame->data[comp.plane] + v * frame->linesize[comp.plane] + comp.offset;
+      const T* src = plane.getRow( v );
+      for ( size_t u = 0; u < plane.getWidth(); u++, dst += comp.step ) {
+        const int value = ( shiftbits >= 0 ? src[u] << shiftbits : src[u] >> -shiftbits ) << comp.shift;
+        if ( depth > 8 ) {
+          *reinterpret_cast<uint16_t*>( dst ) = static_cast<uint16_t>( value );
+        } else {
+          *dst = static_cast<uint8_t>( value );
+        }
+      }
+    }
+  }
+}
+
+// constant QP rate control at qp, or lossless coding, with the options of each encoder
+static void setRateControl( AVCodecContext* context, const std::string& name, const int qp, const bool lossless ) {
+  if ( name == "hevc_nvenc" ) {
+    av_opt_set( context->priv_data, "preset", "p4", 0 );
+    if ( lossless ) {
+      // the lossless tuning of the recent SDKs, or the lossless preset of the older ones
+      if ( av_opt_set( context->priv_data, "tune", "lossless", 0 ) < 0 ) {
+        av_opt_set( context->priv_data, "preset", "lossless", 0 );
+      }
+    } else {
+      av_opt_set( context->priv_data, "tune", "ll", 0 );
+      av_opt_set( context->priv_data, "rc", "constqp", 0 );
+      av_opt_set_int( context->priv_data, "qp", qp, 0 );
+    }
+  } else if ( name == "hevc_qsv" ) {
+    if ( lossless ) { printf( "PCCFFMPEGLibVideoEncoder: hevc_qsv does not code losslessly, coding at QP 0 \n" ); }
+    context->flags |= AV_CODEC_FLAG_QSCALE;
+    context->global_quality = ( lossless ? 0 : qp ) * FF_QP2LAMBDA;
+  } else {
+    const std::string x265Params = ( lossless ? "lossless=1" : "qp=" + std::to_string( qp ) ) + ":log-level=error";
+    av_opt_set( context->priv_data, "x265-params", x265Params.c_str(), 0 );
+  }
+}
+
+template <typename T>
+PCCFFMPEGLibVideoEncoder<T>::PCCFFMPEGLibVideoEncoder() {}
+template <typename T>
+PCCFFMPEGLibVideoEncoder<T>::~PCCFFMPEGLibVideoEncoder() {}
+
+template <typename T>
+void PCCFFMPEGLibVideoEncoder<T>::encode( PCCVideo<T, 3>&            videoSrc,
+                                          PCCVideoEncoderParameters& params,
+                                          PCCVideoBitstream&         bitstream,
+                                          PCCVideo<T, 3>&            videoRec ) {
+  const size_t width        = videoSrc.getWidth();
+  const size_t height       = videoSrc.getHeight();
+  const size_t frameCount   = videoSrc.getFrameCount();
+  const bool   is444        = !videoSrc.is420();
+  const bool   highBitDepth = ( std::max )( params.inputBitDepth_, params.internalBitDepth_ ) > 8;
+  const auto   config       = readEncoderConfig( params.encoderConfig_ );
+  const int    qp           = ( std::max )( params.qp_, 0 );
+
+  // the first encoder of the device that opens
+  AVCodecContext* context = nullptr;
+  for ( const auto& name : getEncoderNames( params.hardwareDevice_ ) ) {
+    const AVCodec*      codec  = avcodec_find_encoder_by_name( name.c_str() );
+    const AVPixelFormat format = codec != nullptr ? getPixelFormat( codec, is444, highBitDepth ) : AV_PIX_FMT_NONE;
+    if ( format == AV_PIX_FMT_NONE ) { continue; }
+    context               = avcodec_alloc_context3( codec );
+    context->width        = static_cast<int>( width );
+    context->height       = static_cast<int>( height );
+    context->pix_fmt      = format;
+    context->time_base    = {1, 30};
+    context->framerate    = {30, 1};
+    context->gop_size     = config.intraPeriod_ > 0 ? config.intraPeriod_ : static_cast<int>( frameCount );
+    context->max_b_frames = 0;
+    setRateControl( context, name, qp, config.lossless_ );
+    if ( avcodec_open2( context, codec, nullptr ) == 0 ) {
+      printf( "PCCFFMPEGLibVideoEncoder: %s %s %s QP %d \n", name.c_str(), av_get_pix_fmt_name( format ),
+              config.lossless_ ? "lossless" : "lossy", qp );
+      break;
+    }
+    avcodec_free_context( &context );
+  }
+  if ( context == nullptr ) {
+    printf( "Error: no libavcodec HEVC encoder opened for the hardware device %s \n", params.hardwareDevice_.c_str() );
+    exit( -1 );
+  }
+
+  AVFrame*  frame  = av_frame_alloc();
+  AVPacket* packet = av_packet_alloc();
+  frame->format    = context->pix_fmt;
+  frame->width     = context->width;
+  frame->height    = context->height;
+  if ( av_frame_get_buffer( frame, 0 ) < 0 ) {
+    printf( "Error: can't allocate the frames of the libavcodec HEVC encoder \n" );
+    exit( -1 );
+  }
+  auto& data = bitstream.vector();
+  data.clear();
+  auto sendFrame = [&]( const AVFrame* input ) {
+    if ( avcodec_send_frame( context, input ) < 0 ) {
+      printf( "Error: libavcodec HEVC encoding failed \n" );
+      exit( -1 );
+    }
+    int ret;
+    while ( ( ret = avcodec_receive_packet( context, packet ) ) == 0 ) {
+      data.insert( data.end(), packet->data, packet->data + packet->size );
+      av_packet_unref( packet );
+    }
+    if ( ret != AVERROR( EAGAIN ) && ret != AVERROR_EOF ) {
+      printf( "Error: libavcodec HEVC encoding failed \n" );
+      exit( -1 );
+    }
+  };
+  for ( size_t i = 0; i < frameCount; i++ ) {
+    if ( av_frame_make_writable( frame ) < 0 ) {
+      printf( "Error: can't allocate the frames of the libavcodec HEVC encoder \n" );
+      exit( -1 );
+    }
+    readPicture( videoSrc.getFrame( i ), params.inputBitDepth_, params.inputColourSpaceConvert_, frame );
+    frame->pts = static_cast<int64_t>( i );
+    sendFrame( frame );
+  }
+  sendFrame( nullptr );
+  printf( "PCCFFMPEGLibVideoEncoder: %zu frames %zu x %zu encoded in %zu bytes \n", frameCount, width, height,
+          data.size() );
+  fflush( stdout );
+  av_packet_free( &packet );
+  av_frame_free( &frame );
+  avcodec_free_context( &context );
+
+  // the hardware encoders give no reconstruction: the bitstream is decoded, in software
+  PCCFFMPEGLibVideoDecoder<T> decoder;
+  decoder.setHardwareDevice( "none" );
+  decoder.setThreads( 0 );
+  decoder.decode( bitstream, videoRec, params.outputBitDepth_ );
+}
+
+template class pcc::PCCFFMPEGLibVideoEncoder<uint8_t>;
+template class pcc::PCCFFMPEGLibVideoEncoder<uint16_t>;
+
+#endif
@@ -33,6 +33,7 @@
 
 #include "PCCHMAppVideoEncoder.h"
 #include "PCCSystem.h"
+#include <tbb/tbb.h>
 
 #ifdef USE_HMAPP_VIDEO_CODEC
 
@@ -48,60 +49,104 @@ void PCCHMAppVideoEncoder<T>::encode( PCCVideo<T, 3>&            videoSrc,
                                       PCCVideoEncoderParameters& params,
                                       PCCVideoBitstream&         bitstream,
                                       PCCVideo<T, 3>&            videoRec ) {
-  const size_t width          = videoSrc.getWidth();
-  const size_t height         = videoSrc.getHeight();
-  const size_t frameCount     = videoSrc.getFrameCount();
-  std::string  srcYuvFileName = params.srcYuvFileName_;
-  std::string  recYuvFileName = params.recYuvFileName_;
-  std::string  binFileName    = params.binFileName_;
-  srcYuvFileName.insert( srcYuvFileName.find_last_of( "." ), "_hmapp" );
-  recYuvFileName.insert( recYuvFileName.find_last_of( "." ), "_hmapp" );
-  binFileName.insert( binFileName.find_last_of( "." ), "_hmapp" );
-  std::stringstream cmd;
-  cmd << params.encoderPath_;
-  cmd << " -c " << params.encoderConfig_;
-  cmd << " --InputFile=" << srcYuvFileName;
-  cmd << " --InputBitDepth=" << params.inputBitDepth_;
-  cmd << " --InputChromaFormat=" << ( params.use444CodecIo_ ? "444" : "420" );
-  cmd << " --OutputBitDepth=" << params.outputBitDepth_;
-  cmd << " --OutputBitDepthC=" << params.outputBitDepth_;
-  cmd << " --FrameRate=30";
-  cmd << " --FrameSkip=0";
-  cmd << " --SourceWidth=" << width;
-  cmd << " --SourceHeight=" << height;
-  cmd << " --ConformanceWindowMode=1 ";
-  cmd << " --FramesToBeEncoded=" << frameCount;
-  cmd << " --BitstreamFile=" << binFileName;
-  cmd << " --ReconFile=" << recYuvFileName;
-  cmd << " --QP=" << params.qp_;
-  if ( params.transquantBypassEnable_ != 0 ) { cmd << " --TransquantBypassEnable=1"; }
-  if ( params.cuTransquantBypassFlagForce_ != 0 ) { cmd << " --CUTransquantBypassFlagForce=1"; }
-  if ( params.internalBitDepth_ != 0 ) {
-    cmd << " --InternalBitDepth=" << params.internalBitDepth_;
-    cmd << " --InternalBitDepthC=" << params.internalBitDepth_;
+  const size_t width      = videoSrc.getWidth();
+  const size_t height     = videoSrc.getHeight();
+  const size_t frameCount = videoSrc.getFrameCount();
+  // the motion estimation files the encoder reads cover the whole video
+  size_t chunkFrames = params.chunkFrames_ != 0 ? params.chunkFrames_ : ( std::max )( frameCount, size_t( 1 ) );
+  if ( chunkFrames < frameCount && params.usePccMotionEstimation_ ) {
+    std::cout << "PCCHMAppVideoEncoder: use3dmv, the video is encoded in one chunk" << std::endl;
+    chunkFrames = frameCount;
   }
-  if ( params.usePccMotionEstimation_ ) {
-    cmd << " --UsePccMotionEstimation=1";
-    cmd << " --BlockToPatchFile=" << params.blockToPatchFile_;
-    cmd << " --OccupancyMapFile=" << params.occupancyMapFile_;
-    cmd << " --PatchInfoFile=" << params.patchInfoFile_;
+
+  // Each chunk is coded by an encoder process of its own as a sequence that starts with an IDR picture, all at the
+  // same time. Their byte streams are concatenated: same configuration and size, so same parameter sets.
+  const size_t chunkCount = ( std::max )( ( frameCount + chunkFrames - 1 ) / chunkFrames, size_t( 1 ) );
+  std::vector<PCCVideo<T, 3>>    sources( chunkCount );
+  std::vector<PCCVideo<T, 3>>    recs( chunkCount );
+  std::vector<PCCVideoBitstream> bitstreams;
+  bitstreams.reserve( chunkCount );
+  for ( size_t chunk = 0; chunk < chunkCount; chunk++ ) {
+    // the source frames are moved to the chunks and back, not copied
+    const size_t first = chunk * chunkFrames;
+    const size_t count = ( std::min )( chunkFrames, frameCount - first );
+    sources[chunk].resize( count );
+    for ( size_t i = 0; i < count; i++ ) { std::swap( sources[chunk].getFrame( i ), videoSrc.getFrame( first + i ) ); }
+    bitstreams.emplace_back( bitstream.type() );
   }
-  if ( params.inputColourSpaceConvert_ ) { cmd << " --InputColourSpaceConvert=RGBtoGBR"; }
+  tbb::parallel_for( size_t( 0 ), chunkCount, [&]( size_t chunk ) {
+    const std::string suffix         = chunkCount > 1 ? "_hmapp_c" + std::to_string( chunk ) : "_hmapp";
+    std::string       srcYuvFileName = params.srcYuvFileName_;
+    std::string       recYuvFileName = params.recYuvFileName_;
+    std::string       binFileName    = params.binFileName_;
+    srcYuvFileName.insert( srcYuvFileName.find_last_of( "." ), suffix );
+    recYuvFileName.insert( recYuvFileName.find_last_of( "." ), suffix );
+    binFileName.insert( binFileName.find_last_of( "." ), suffix );
+    std::stringstream cmd;
+    cmd << params.encoderPath_;
+    cmd << " -c " << params.encoderConfig_;
+    cmd << " --InputFile=" << srcYuvFileName;
+    cmd << " --InputBitDepth=" << params.inputBitDepth_;
+    cmd << " --InputChromaFormat=" << ( params.use444CodecIo_ ? "444" : "420" );
+    cmd << " --OutputBitDepth=" << params.outputBitDepth_;
+    cmd << " --OutputBitDepthC=" << params.outputBitDepth_;
+    cmd << " --FrameRate=30";
+    cmd << " --FrameSkip=0";
+    cmd << " --SourceWidth=" << width;
+    cmd << " --SourceHeight=" << height;
+    cmd << " --ConformanceWindowMode=1 ";
+    cmd << " --FramesToBeEncoded=" << sources[chunk].getFrameCount();
+    cmd << " --BitstreamFile=" << binFileName;
+    cmd << " --ReconFile=" << recYuvFileName;
+    cmd << " --QP=" << params.qp_;
+    if ( params.transquantBypassEnable_ != 0 ) { cmd << " --TransquantBypassEnable=1"; }
+    if ( params.cuTransquantBypassFlagForce_ != 0 ) { cmd << " --CUTransquantBypassFlagForce=1"; }
+    if ( params.internalBitDepth_ != 0 ) {
+      cmd << " --InternalBitDepth=" << params.internalBitDepth_;
+      cmd << " --InternalBitDepthC=" << params.internalBitDepth_;
+    }
+    if ( params.usePccMotionEstimation_ ) {
+      cmd << " --UsePccMotionEstimation=1";
+      cmd << " --BlockToPatchFile=" << params.blockToPatchFile_;
+      cmd << " --OccupancyMapFile=" << params.occupancyMapFile_;
+      cmd << " --PatchInfoFile=" << params.patchInfoFile_;
+    }
+    if ( params.inputColourSpaceConvert_ ) { cmd << " --InputColourSpaceConvert=RGBtoGBR"; }
+    if ( params.wavefront_ ) { cmd << " --WaveFrontSynchro=1"; }
+    if ( params.tileColumns_ > 1 || params.tileRows_ > 1 ) {
+      cmd << " --TileUniformSpacing=1";
+      cmd << " --NumTileColumnsMinus1=" << params.tileColumns_ - 1;
+      cmd << " --NumTileRowsMinus1=" << params.tileRows_ - 1;
+    }
 
-  std::cout << cmd.str() << std::endl;
+    std::cout << cmd.str() << std::endl;
 
-  videoSrc.write( srcYuvFileName, params.inputBitDepth_ == 8 ? 1 : 2 );
-  if ( pcc::system( cmd.str().c_str() ) ) {
-    std::cout << "Error: can't run system command!" << std::endl;
-    exit( -1 );
-  }
-  PCCCOLORFORMAT format = getColorFormat( params.recYuvFileName_ );
+    sources[chunk].write( srcYuvFileName, params.inputBitDepth_ == 8 ? 1 : 2 );
+    if ( pcc::system( cmd.str().c_str() ) ) {
+      std::cout << "Error: can't run system command!" << std::endl;
+      exit( -1 );
+    }
+    PCCCOLORFORMAT format = getColorFormat( params.recYuvFileName_ );
+    recs[chunk].read( recYuvFileName, width, height, format, params.outputBitDepth_ == 8 ? 1 : 2 );
+    bitstreams[chunk].read( binFileName );
+    removeFile( srcYuvFileName );
+    removeFile( recYuvFileName );
+    removeFile( binFileName );
+  } );
+
+  std::vector<uint8_t>& data = bitstream.vector();
+  data.clear();
   videoRec.clear();
-  videoRec.read( recYuvFileName, width, height, format, params.outputBitDepth_ == 8 ? 1 : 2 );
-  bitstream.read( binFileName );
-  removeFile( srcYuvFileName );
-  removeFile( recYuvFileName );
-  removeFile( binFileName );
+  videoRec.resize( frameCount );
+  for ( size_t chunk = 0; chunk < chunkCount; chunk++ ) {
+    const size_t first = chunk * chunkFrames;
+    for ( size_t i = 0; i < sources[chunk].getFrameCount(); i++ ) {
+      std::swap( sources[chunk].getFrame( i ), videoSrc.getFrame( first + i ) );
+      std::swap( recs[chunk].getFrame( i ), videoRec.getFrame( first + i ) );
+    }
+    std::vector<uint8_t>& chunkData = bitstreams[chunk].vector();
+    data.insert( data.end(), chunkData.begin(), chunkData.end() );
+  }
 }
 
 template <typename T>
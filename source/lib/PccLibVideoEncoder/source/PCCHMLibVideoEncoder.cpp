@@ -36,6 +36,7 @@
 #include "PCCVideo.h"
 #include "PCCHMLibVideoEncoder.h"
 #include "PCCHMLibVideoEncoderImpl.h"
+#include <tbb/tbb.h>
 
 using namespace pcc;
 
@@ -45,13 +46,10 @@ template <typename T>
 PCCHMLibVideoEncoder<T>::~PCCHMLibVideoEncoder() {}
 
 template <typename T>
-void PCCHMLibVideoEncoder<T>::encode( PCCVideo<T, 3>&            videoSrc,
-                                      PCCVideoEncoderParameters& params,
-                                      PCCVideoBitstream&         bitstream,
-                                      PCCVideo<T, 3>&            videoRec ) {
-  const size_t      width      = videoSrc.getWidth();
-  const size_t      height     = videoSrc.getHeight();
-  const size_t      frameCount = videoSrc.getFrameCount();
+std::string PCCHMLibVideoEncoder<T>::getArguments( size_t                           width,
+                                                   size_t                           height,
+                                                   size_t                           frameCount,
+                                                   const PCCVideoEncoderParameters& params ) {
   std::stringstream cmd;
   cmd << "HMEncoder";
   cmd << " -c " << params.encoderConfig_;
@@ -75,26 +73,91 @@ void PCCHMLibVideoEncoder<T>::encode( PCCVideo<T, 3>&            videoSrc,
     cmd << " --InternalBitDepth=" << params.internalBitDepth_;
     cmd << " --InternalBitDepthC=" << params.internalBitDepth_;
   }
+  // the side information is given to the encoder in memory
 #if defined( PCC_ME_EXT ) && PCC_ME_EXT
-  if ( params.usePccMotionEstimation_ ) {
-    cmd << " --UsePccMotionEstimation=1";
-    cmd << " --BlockToPatchFile=" << params.blockToPatchFile_;
-    cmd << " --OccupancyMapFile=" << params.occupancyMapFile_;
-    cmd << " --PatchInfoFile=" << params.patchInfoFile_;
-  }
+  if ( params.usePccMotionEstimation_ && params.sideInfo_ != nullptr ) { cmd << " --UsePccMotionEstimation=1"; }
 #endif
 #if defined( PCC_RDO_EXT ) && PCC_RDO_EXT
-  if ( params.usePccRDO_ && !params.inputColourSpaceConvert_ ) {
+  if ( params.usePccRDO_ && !params.inputColourSpaceConvert_ && params.sideInfo_ != nullptr ) {
     cmd << " --UsePccRDO=1";
-    cmd << " --OccupancyMapFile=" << params.occupancyMapFile_;
   }
 #endif
 
   if ( params.inputColourSpaceConvert_ ) { cmd << " --InputColourSpaceConvert=RGBtoGBR"; }
-  std::cout << cmd.str() << std::endl;
+  if ( params.wavefront_ ) { cmd << " --WaveFrontSynchro=1"; }
+  if ( params.tileColumns_ > 1 || params.tileRows_ > 1 ) {
+    cmd << " --TileUniformSpacing=1";
+    cmd << " --NumTileColumnsMinus1=" << params.tileColumns_ - 1;
+    cmd << " --NumTileRowsMinus1=" << params.tileRows_ - 1;
+  }
+  return cmd.str();
+}
 
-  PCCHMLibVideoEncoderImpl<T> encoder;
-  encoder.encode( videoSrc, cmd.str(), bitstream, videoRec );
+template <typename T>
+void PCCHMLibVideoEncoder<T>::encode( PCCVideo<T, 3>&            videoSrc,
+                                      PCCVideoEncoderParameters& params,
+                                      PCCVideoBitstream&         bitstream,
+                                      PCCVideo<T, 3>&            videoRec ) {
+  const size_t width       = videoSrc.getWidth();
+  const size_t height      = videoSrc.getHeight();
+  const size_t frameCount  = videoSrc.getFrameCount();
+  const size_t chunkFrames = params.chunkFrames_ != 0 ? params.chunkFrames_ : frameCount;
+  if ( chunkFrames >= frameCount ) {
+    const std::string arguments = getArguments( width, height, frameCount, params );
+    std::cout << arguments << std::endl;
+    PCCHMLibVideoEncoderImpl<T> encoder;
+    encoder.encode( videoSrc, arguments, bitstream, videoRec, params.sideInfo_ );
+    return;
+  }
+
+  // The chunks are coded as sequences of their own, each starting with an IDR picture that resets the POC, by one HM
+  // encoder each. Their byte streams are concatenated: same configuration and size, so same parameter sets.
+  const size_t chunkCount = ( frameCount + chunkFrames - 1 ) / chunkFrames;
+  std::cout << getArguments( width, height, chunkFrames, params ) << " (" << chunkCount << " chunks)" << std::endl;
+  std::vector<PCCVideo<T, 3>>    sources( chunkCount );
+  std::vector<PCCVideo<T, 3>>    recs( chunkCount );
+  std::vector<PCCVideoBitstream> bitstreams;
+  bitstreams.reserve( chunkCount );
+  for ( size_t chunk = 0; chunk < chunkCount; chunk++ ) {
+    // the source frames are moved to the chunks and back, not copied
+    const size_t first = chunk * chunkFrames;
+    const size_t count = ( std::min )( chunkFrames, frameCount - first );
+    sources[chunk].resize( count );
+    for ( size_t i = 0; i < count; i++ ) { std::swap( sources[chunk].getFrame( i ), videoSrc.getFrame( first + i ) ); }
+    bitstreams.emplace_back( bitstream.type() );
+  }
+  tbb::parallel_for( size_t( 0 ), chunkCount, [&]( size_t chunk ) {
+    const size_t                first = chunk * chunkFrames;
+    const size_t                count = sources[chunk].getFrameCount();
+    PCCMotionEstimationSideInfo sideInfo;
+    if ( params.sideInfo_ != nullptr ) {
+      // the frames of the side information are indexed by POC, which starts over with each chunk
+      sideInfo.width_               = params.sideInfo_->width_;
+      sideInfo.height_              = params.sideInfo_->height_;
+      sideInfo.occupancyResolution_ = params.sideInfo_->occupancyResolution_;
+      sideInfo.occupancyPrecision_  = params.sideInfo_->occupancyPrecision_;
+      const auto& frames            = params.sideInfo_->frames_;
+      if ( first < frames.size() ) {
+        sideInfo.frames_.assign( frames.begin() + first, frames.begin() + ( std::min )( first + count, frames.size() ) );
+      }
+    }
+    PCCHMLibVideoEncoderImpl<T> encoder;
+    encoder.encode( sources[chunk], getArguments( width, height, count, params ), bitstreams[chunk], recs[chunk],
+                    params.sideInfo_ != nullptr ? &sideInfo : nullptr );
+  } );
+
+  std::vector<uint8_t>& data = bitstream.vector();
+  data.clear();
+  videoRec.resize( frameCount );
+  for ( size_t chunk = 0; chunk < chunkCount; chunk++ ) {
+    const size_t first = chunk * chunkFrames;
+    for ( size_t i = 0; i < sources[chunk].getFrameCount(); i++ ) {
+      std::swap( sources[chunk].getFrame( i ), videoSrc.getFrame( first + i ) );
+      std::swap( recs[chunk].getFrame( i ), videoRec.getFrame( first + i ) );
+    }
+    std::vector<uint8_t>& chunkData = bitstreams[chunk].vector();
+    data.insert( data.end(), chunkData.begin(), chunkData.end() );
+  }
 }
 
 template class pcc::PCCHMLibVideoEncoder<uint8_t>;
@@ -37,10 +37,40 @@
 #ifdef USE_HMLIB_VIDEO_CODEC
 
 #include "PCCHMLibVideoEncoderImpl.h"
+#include <condition_variable>
+#include <mutex>
 
 using namespace pcc;
 using namespace pcc_hm;
 
+// Encoders of several components or rates can run at the same time in one process. HM shares the ROM tables
+// between them (reference counted) and the z-scan tables, written when an encoder is created for its CTU size: the
+// encoders running together must have the same CTU size, and are created and destroyed one at a time. The side
+// information of the PCC motion estimation and RDO is kept by each encoder.
+static std::mutex              g_encoderMutex;
+static std::condition_variable g_encoderReleased;
+static size_t                  g_encoderCount  = 0;
+static UInt                    g_encoderCtu[3] = {0, 0, 0};
+
+static std::unique_lock<std::mutex> acquireEncoder( UInt ctuWidth, UInt ctuHeight, UInt ctuDepth ) {
+  std::unique_lock<std::mutex> lock( g_encoderMutex );
+  g_encoderReleased.wait( lock, [&] {
+    return g_encoderCount == 0 ||
+           ( g_encoderCtu[0] == ctuWidth && g_encoderCtu[1] == ctuHeight && g_encoderCtu[2] == ctuDepth );
+  } );
+  g_encoderCount++;
+  g_encoderCtu[0] = ctuWidth;
+  g_encoderCtu[1] = ctuHeight;
+  g_encoderCtu[2] = ctuDepth;
+  return lock;
+}
+
+static void releaseEncoder( std::unique_lock<std::mutex>& lock ) {
+  g_encoderCount--;
+  lock.unlock();
+  g_encoderReleased.notify_all();
+}
+
 /// encoder application class
 
 template <typename T>
@@ -54,10 +84,11 @@ template <typename T>
 PCCHMLibVideoEncoderImpl<T>::~PCCHMLibVideoEncoderImpl() {}
 
 template <typename T>
-Void PCCHMLibVideoEncoderImpl<T>::encode( PCCVideo<T, 3>&    videoSrc,
-                                          std::string        arguments,
-                                          PCCVideoBitstream& bitstream,
-                                          PCCVideo<T, 3>&    videoRec ) {
+Void PCCHMLibVideoEncoderImpl<T>::encode( PCCVideo<T, 3>&                    videoSrc,
+                                          std::string                        arguments,
+                                          PCCVideoBitstream&                 bitstream,
+                                          PCCVideo<T, 3>&                    videoRec,
+                                          const PCCMotionEstimationSideInfo* sideInfo ) {
   std::ostringstream oss( ostringstream::binary | ostringstream::out );
   std::ostream&      bitstreamFile = oss;
   std::istringstream iss( arguments );
@@ -87,33 +118,16 @@ Void PCCHMLibVideoEncoderImpl<T>::encode( PCCVideo<T, 3>&    videoSrc,
   m_framesToBeEncoded     = std::min( m_framesToBeEncoded, (int)videoSrc.getFrameCount() );
   TComPicYuv* pcPicYuvOrg = new TComPicYuv;
   TComPicYuv* pcPicYuvRec = NULL;
+#if ( defined( PCC_ME_EXT ) && PCC_ME_EXT ) || ( defined( PCC_RDO_EXT ) && PCC_RDO_EXT )
+  if ( sideInfo != nullptr ) { xSetSideInfo( *sideInfo ); }
+#endif
+  auto lock = acquireEncoder( m_uiMaxCUWidth, m_uiMaxCUHeight, m_uiMaxTotalCUDepth );
   // initialize internal class & member variables
   xInitLibCfg();
   m_cTEncTop.create();
   m_cTEncTop.init( m_isField );
   videoRec.clear();
-
-#if PCC_ME_EXT
-  if ( m_usePCCExt ) {
-    // Note JR: must be given from the function parameters
-    printf( "\nReading the aux info files\n" );
-    FILE* patchFile = NULL;
-    patchFile       = fopen( m_patchInfoFileName.c_str(), "rb" );
-    for ( Int i = 0; i < PCC_ME_EXT_MAX_NUM_FRAMES; i++ ) {
-      long long readSize = fread( &g_numPatches[i], sizeof( long long ), 1, patchFile );
-      if ( readSize != 1 && readSize != 0 ) { printf( "error: Wrong Patch data group file" ); }
-      for ( Int patchIdx = 0; patchIdx < g_numPatches[i]; patchIdx++ ) {
-        readSize = fread( &g_projectionIndex[i][patchIdx], sizeof( long long ), 1, patchFile );
-        if ( readSize != 1 ) { printf( "error: Wrong Auxiliary data format" ); }
-        readSize = fread( g_patch2DInfo[i][patchIdx], sizeof( long long ), 4, patchFile );
-        if ( readSize != 4 ) { printf( "error: Wrong Auxiliary data format" ); }
-        readSize = fread( g_patch3DInfo[i][patchIdx], sizeof( long long ), 3, patchFile );
-        if ( readSize != 3 ) { printf( "error: Wrong Auxiliary data format" ); }
-      }
-    }
-    fclose( patchFile );
-  }
-#endif
+  lock.unlock();
   printChromaFormat();
   // main encoder loop
   Int                              iNumEncoded = 0;
@@ -170,7 +184,9 @@ Void PCCHMLibVideoEncoderImpl<T>::encode( PCCVideo<T, 3>&    videoSrc,
   cPicYuvTrueOrg.destroy();
   // delete buffers & classes
   xDeleteBuffer();
+  lock.lock();
   m_cTEncTop.destroy();
+  releaseEncoder( lock );
   printRateSummary();
   auto buffer = oss.str();
   bitstream.resize( buffer.size() );
@@ -191,14 +207,12 @@ Void PCCHMLibVideoEncoderImpl<T>::xInitLibCfg() {
   m_cTEncTop.setVPS( &vps );
 #if defined( PCC_ME_EXT ) & PCC_ME_EXT
   m_cTEncTop.setUsePCCExt( m_usePCCExt );
-  if ( m_usePCCExt ) {
-    m_cTEncTop.setBlockToPatchFileName( m_blockToPatchFileName );
-    m_cTEncTop.setOccupancyMapFileName( m_occupancyMapFileName );
-  }
 #endif
 #if defined( PCC_ME_EXT ) & PCC_RDO_EXT
   m_cTEncTop.setUsePCCRDOExt( m_usePCCRDO );
-  if ( m_usePCCRDO ) { m_cTEncTop.setOccupancyMapFileName( m_occupancyMapFileName ); }
+#endif
+#if ( defined( PCC_ME_EXT ) && PCC_ME_EXT ) || ( defined( PCC_RDO_EXT ) && PCC_RDO_EXT )
+  m_cTEncTop.setPCCSideInfo( &m_sideInfo );
 #endif
 
   m_cTEncTop.setProfile( m_profile );
@@ -792,6 +806,39 @@ Void PCCHMLibVideoEncoderImpl<T>::xReadPicture( TComPicYuv* pic, PCCVideo<T, 3>&
              m_internalBitDepth[0] - m_outputBitDepth[0], m_inputColourSpaceConvert == IPCOLOURSPACE_RGBtoGBR );
 }
 
+#if ( defined( PCC_ME_EXT ) && PCC_ME_EXT ) || ( defined( PCC_RDO_EXT ) && PCC_RDO_EXT )
+template <typename T>
+Void PCCHMLibVideoEncoderImpl<T>::xSetSideInfo( const PCCMotionEstimationSideInfo& sideInfo ) {
+  // HM reads the block to patch indices on 16x16 blocks
+  if ( sideInfo.occupancyResolution_ != 16 ) {
+    printf( "Warning: the PCC motion estimation expects an occupancy resolution of 16 (%zu)\n",
+            sideInfo.occupancyResolution_ );
+  }
+  m_sideInfo.width              = static_cast<Int>( sideInfo.width_ );
+  m_sideInfo.height             = static_cast<Int>( sideInfo.height_ );
+  m_sideInfo.occupancyPrecision = static_cast<Int>( sideInfo.occupancyPrecision_ );
+  m_sideInfo.frames.resize( sideInfo.frames_.size() );
+  for ( size_t i = 0; i < sideInfo.frames_.size(); i++ ) {
+    const auto& src = sideInfo.frames_[i];
+    auto&       dst = m_sideInfo.frames[i];
+    dst.blockToPatch.assign( src.blockToPatch_.begin(), src.blockToPatch_.end() );
+    dst.occupancy.assign( src.occupancy_.begin(), src.occupancy_.end() );
+    dst.patches.resize( src.patches_.size() );
+    for ( size_t j = 0; j < src.patches_.size(); j++ ) {
+      const auto& patch              = src.patches_[j];
+      dst.patches[j].projectionIndex = patch.projectionIndex_;
+      dst.patches[j].u0              = patch.u0_;
+      dst.patches[j].v0              = patch.v0_;
+      dst.patches[j].sizeU0          = patch.sizeU0_;
+      dst.patches[j].sizeV0          = patch.sizeV0_;
+      dst.patches[j].d1              = patch.d1_;
+      dst.patches[j].u1              = patch.u1_;
+      dst.patches[j].v1              = patch.v1_;
+    }
+  }
+}
+#endif
+
 template class pcc::PCCHMLibVideoEncoderImpl<uint8_t>;
 template class pcc::PCCHMLibVideoEncoderImpl<uint16_t>;
 